@@ -36,6 +36,7 @@ target_compile_definitions(maidsafe_common
     $<$<BOOL:${PROFILING}>:USE_PROFILING>
     $<$<BOOL:${USE_LOGGING}>:USE_LOGGING=1>
     $<$<BOOL:${DONT_USE_LOGGING}>:USE_LOGGING=0>
+    $<$<BOOL:${LOG_MIN_LEVEL}>:MAIDSAFE_LOG_MIN_LEVEL=${LOG_MIN_LEVEL}>
     $<$<BOOL:${VLOGGING}>:USE_VLOGGING>
     ASIO_HAS_MOVE
     BOOST_ASIO_HAS_MOVE
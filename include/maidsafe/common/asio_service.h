@@ -19,11 +19,15 @@
 #ifndef MAIDSAFE_COMMON_ASIO_SERVICE_H_
 #define MAIDSAFE_COMMON_ASIO_SERVICE_H_
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -31,54 +35,171 @@
 #include "boost/asio/io_service.hpp"
 
 #include "maidsafe/common/error.h"
+#include "maidsafe/common/latency_histogram.h"
 #include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/numa.h"
+#include "maidsafe/common/on_scope_exit.h"
+#include "maidsafe/common/profiler.h"
+#include "maidsafe/common/trace.h"
 
 namespace maidsafe {
 
 template <typename IoServiceType>
 class IoService {
  public:
-  explicit IoService(size_t thread_count);
+  // Figures for handlers run via Post (handlers posted directly to 'service()' aren't counted).
+  struct Stats {
+    Stats()
+        : handlers_per_thread(),
+          queue_delay(),
+          run_time(),
+          longest_handler(),
+          longest_handler_tag(),
+          slow_handlers(0),
+          busy_time(),
+          thread_time(),
+          elapsed() {}
+    // Fraction of the pool's thread time not spent running handlers, in the range [0, 1].
+    double IdleRatio() const;
+    // Indexed in the order the threads were started, including any since retired by Resize.
+    std::vector<uint64_t> handlers_per_thread;
+    // Delay between each handler being posted and starting to run, and its running time.
+    LatencyHistogram queue_delay, run_time;
+    std::chrono::steady_clock::duration longest_handler;
+    std::string longest_handler_tag;
+    // Number of handlers which ran for longer than the slow-handler threshold.
+    uint64_t slow_handlers;
+    // Total handler running time, total lifetime of all threads, and time since construction.
+    std::chrono::steady_clock::duration busy_time, thread_time, elapsed;
+  };
+
+  // If 'numa_node' is given, every thread (including any started by Resize) is bound to that
+  // node's CPUs, so that memory first touched by handlers is allocated on it (see numa.h).  Throws
+  // if 'thread_count' is 0 or 'numa_node' isn't in numa::Topology().
+  explicit IoService(size_t thread_count, unsigned numa_node = numa::kAnyNode);
   ~IoService() { Stop(); }
   void Stop();
   IoServiceType& service() { return service_; }
   size_t ThreadCount() const { return thread_count_; }
+  unsigned NumaNode() const { return numa_node_; }
+
+  // Grows or shrinks the pool to 'thread_count' threads without stopping the service.  Surplus
+  // threads exit once they finish their current handler, so the pool may briefly exceed the new
+  // size.  Throws if 'thread_count' is 0 or if the service has been stopped.
+  void Resize(size_t thread_count);
+
+  // Posts 'handler', recording its queueing delay and running time.  If it runs for longer than
+  // the slow-handler threshold (10ms by default), a warning including 'tag' is logged.  The handler
+  // runs within the caller's trace context (see trace.h).
+  template <typename Handler>
+  void Post(Handler handler, std::string tag = std::string());
+  void SetSlowHandlerThreshold(std::chrono::steady_clock::duration threshold);
+  Stats stats() const;
 
  private:
+  struct ThreadRecord {
+    std::thread::id id;
+    std::chrono::steady_clock::time_point started, stopped;
+    bool running;
+  };
+
+  void StartThreadsLocked(size_t count);
+  void Run();
+  bool TryRetire();
+  void JoinRetiredLocked();
+  void RecordThreadStopped(std::thread::id id);
+  void RecordHandler(const std::string& tag, std::chrono::steady_clock::time_point posted,
+                     std::chrono::steady_clock::time_point started,
+                     std::chrono::steady_clock::time_point finished);
+
   std::atomic<size_t> thread_count_;
+  const unsigned numa_node_;
   IoServiceType service_;
   std::unique_ptr<typename IoServiceType::work> work_;
   std::vector<std::thread> threads_;
   mutable std::mutex mutex_;
+  // Number of threads still to exit following a call to Resize.
+  std::atomic<size_t> pending_retirements_;
+  std::mutex retired_mutex_;
+  std::vector<std::thread::id> retired_ids_;
+  const std::chrono::steady_clock::time_point start_time_;
+  mutable std::mutex stats_mutex_;
+  std::vector<ThreadRecord> thread_records_;
+  std::chrono::steady_clock::duration slow_handler_threshold_;
+  Stats stats_;
 };
 
 using AsioService = IoService<asio::io_service>;
 using BoostAsioService = IoService<boost::asio::io_service>;
 
+// Runs 'service_count' services, each with its own single thread, so that handlers posted to a
+// given service (e.g. all those of one tcp::Connection) always run on the same thread and don't
+// contend with other threads on a shared queue.  If 'pin_threads' is true, the thread of service i
+// is pinned to the i'th CPU (wrapping around) of numa::CpusByNode() where the platform supports
+// it, so that consecutive services share a NUMA node.
+template <typename IoServiceType>
+class IoServicePool {
+ public:
+  explicit IoServicePool(size_t service_count, bool pin_threads = false);
+  IoServicePool(const IoServicePool&) = delete;
+  IoServicePool(IoServicePool&&) = delete;
+  IoServicePool& operator=(IoServicePool) = delete;
+  ~IoServicePool() { Stop(); }
+  void Stop();
+  size_t size() const { return services_.size(); }
+  IoServiceType& service(size_t index) { return services_.at(index)->service(); }
+  // Returns the services in turn.
+  IoServiceType& next() { return service(next_index_++ % services_.size()); }
+  // Always returns the same service for a given 'hash', e.g. of a peer's ID.
+  IoServiceType& ServiceFor(size_t hash) { return service(hash % services_.size()); }
+  // The NUMA node on which the thread of service 'index' runs, or numa::kAnyNode if it isn't
+  // pinned.  Lets callers keep per-service data (e.g. caches) on the service's node.
+  unsigned NumaNode(size_t index) const { return nodes_.at(index); }
+
+ private:
+  std::vector<std::unique_ptr<IoService<IoServiceType>>> services_;
+  std::vector<unsigned> nodes_;
+  std::atomic<size_t> next_index_;
+};
+
+using AsioServicePool = IoServicePool<asio::io_service>;
+using BoostAsioServicePool = IoServicePool<boost::asio::io_service>;
+
+namespace detail {
+
+// Returns false if the calling thread couldn't be pinned to 'cpu' (e.g. if unsupported).
+bool PinCurrentThreadToCpu(unsigned cpu);
+
+}  // namespace detail
+
 
 
 template <typename IoServiceType>
-IoService<IoServiceType>::IoService(size_t thread_count)
+IoService<IoServiceType>::IoService(size_t thread_count, unsigned numa_node)
     : thread_count_(thread_count),
+      numa_node_(numa_node),
       service_(),
       work_(make_unique<typename IoServiceType::work>(service_)),
       threads_(),
-      mutex_() {
+      mutex_(),
+      pending_retirements_(0),
+      retired_mutex_(),
+      retired_ids_(),
+      start_time_(std::chrono::steady_clock::now()),
+      stats_mutex_(),
+      thread_records_(),
+      slow_handler_threshold_(std::chrono::milliseconds(10)),
+      stats_() {
   if (thread_count == 0)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
-  for (size_t i(0); i != thread_count; ++i)
-    threads_.emplace_back([&] {
-      try {
-        service_.run();
-      } catch (...) {
-        LOG(kError) << boost::current_exception_diagnostic_information();
-        // Rethrowing here will cause the application to terminate - so flush the log message first.
-        log::Logging::Instance().Flush();
-        assert(0);
-        throw;
-      }
-    });
+  if (numa_node != numa::kAnyNode &&
+      std::none_of(std::begin(numa::Topology()), std::end(numa::Topology()),
+                   [numa_node](const numa::Node& node) { return node.id == numa_node; })) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::lock_guard<std::mutex> lock{mutex_};
+  StartThreadsLocked(thread_count);
 }
 
 template <typename IoServiceType>
@@ -95,17 +216,223 @@ void IoService<IoServiceType>::Stop() {
   work_.reset();
 
   for (auto& asio_thread : threads_) {
+    const std::thread::id id{asio_thread.get_id()};
     try {
       asio_thread.join();
     } catch (const std::exception& e) {
       LOG(kError) << "Exception joining asio thread: " << boost::diagnostic_information(e);
       asio_thread.detach();
     }
+    RecordThreadStopped(id);
   }
 
   threads_.clear();
 }
 
+template <typename IoServiceType>
+void IoService<IoServiceType>::Resize(size_t thread_count) {
+  if (thread_count == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (!work_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  JoinRetiredLocked();
+  // Cancelling any retirements which are still pending leaves this many threads running.
+  const size_t running(thread_count_ + pending_retirements_.exchange(0));
+  if (thread_count > running) {
+    StartThreadsLocked(thread_count - running);
+  } else if (thread_count < running) {
+    pending_retirements_ += running - thread_count;
+    // Wake any idle threads so that they can retire.
+    for (size_t i(0); i != running - thread_count; ++i)
+      service_.post([] {});
+  }
+  thread_count_ = thread_count;
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::StartThreadsLocked(size_t count) {
+  // Held so that handlers don't look up 'thread_records_' while it's being extended.
+  std::lock_guard<std::mutex> stats_lock{stats_mutex_};
+  for (size_t i(0); i != count; ++i) {
+    threads_.emplace_back([this] { Run(); });
+    ThreadRecord record;
+    record.id = threads_.back().get_id();
+    record.started = std::chrono::steady_clock::now();
+    record.running = true;
+    thread_records_.push_back(record);
+    stats_.handlers_per_thread.push_back(0);
+  }
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::Run() {
+  profile::SampledThread sampled_thread;
+  if (numa_node_ != numa::kAnyNode && !numa::BindCurrentThreadToNode(numa_node_))
+    LOG(kWarning) << "Failed to bind asio thread to NUMA node " << numa_node_;
+  try {
+    // Equivalent to 'service_.run()', but checking after each handler whether to retire.
+    while (service_.run_one() != 0) {
+      if (TryRetire()) {
+        RecordThreadStopped(std::this_thread::get_id());
+        std::lock_guard<std::mutex> lock{retired_mutex_};
+        retired_ids_.push_back(std::this_thread::get_id());
+        return;
+      }
+    }
+  } catch (...) {
+    LOG(kError) << boost::current_exception_diagnostic_information();
+    // Rethrowing here will cause the application to terminate - so flush the log message first.
+    log::Logging::Instance().Flush();
+    assert(0);
+    throw;
+  }
+}
+
+template <typename IoServiceType>
+bool IoService<IoServiceType>::TryRetire() {
+  size_t pending(pending_retirements_.load());
+  while (pending != 0) {
+    if (pending_retirements_.compare_exchange_weak(pending, pending - 1))
+      return true;
+  }
+  return false;
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::JoinRetiredLocked() {
+  std::vector<std::thread::id> retired_ids;
+  {
+    std::lock_guard<std::mutex> lock{retired_mutex_};
+    retired_ids.swap(retired_ids_);
+  }
+  for (const auto& id : retired_ids) {
+    auto itr(std::find_if(std::begin(threads_), std::end(threads_), [&](const std::thread& t) {
+      return t.get_id() == id;
+    }));
+    if (itr == std::end(threads_))
+      continue;
+    itr->join();
+    threads_.erase(itr);
+  }
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::RecordThreadStopped(std::thread::id id) {
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  for (auto& record : thread_records_) {
+    if (record.running && record.id == id) {
+      record.stopped = std::chrono::steady_clock::now();
+      record.running = false;
+    }
+  }
+}
+
+template <typename IoServiceType>
+template <typename Handler>
+void IoService<IoServiceType>::Post(Handler handler, std::string tag) {
+  const auto posted(std::chrono::steady_clock::now());
+  const trace::SpanContext context(trace::CurrentContext());
+  service_.post([this, handler, tag, posted, context]() mutable {
+    trace::ScopedContext scoped_context(context);
+    const auto started(std::chrono::steady_clock::now());
+    on_scope_exit record([&] {
+      RecordHandler(tag, posted, started, std::chrono::steady_clock::now());
+    });
+    handler();
+  });
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::SetSlowHandlerThreshold(
+    std::chrono::steady_clock::duration threshold) {
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  slow_handler_threshold_ = threshold;
+}
+
+template <typename IoServiceType>
+typename IoService<IoServiceType>::Stats IoService<IoServiceType>::stats() const {
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  Stats stats(stats_);
+  const auto now(std::chrono::steady_clock::now());
+  stats.elapsed = now - start_time_;
+  for (const auto& record : thread_records_)
+    stats.thread_time += (record.running ? now : record.stopped) - record.started;
+  return stats;
+}
+
+template <typename IoServiceType>
+void IoService<IoServiceType>::RecordHandler(const std::string& tag,
+                                             std::chrono::steady_clock::time_point posted,
+                                             std::chrono::steady_clock::time_point started,
+                                             std::chrono::steady_clock::time_point finished) {
+  const auto run_time(finished - started);
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  // Records of retired threads are kept, and their IDs may since have been reused.
+  const std::thread::id id{std::this_thread::get_id()};
+  const auto itr(std::find_if(std::begin(thread_records_), std::end(thread_records_),
+                              [&](const ThreadRecord& record) {
+                                return record.running && record.id == id;
+                              }));
+  if (itr != std::end(thread_records_))
+    ++stats_.handlers_per_thread[itr - std::begin(thread_records_)];
+  stats_.queue_delay.Record(started - posted);
+  stats_.run_time.Record(run_time);
+  stats_.busy_time += run_time;
+  if (run_time > stats_.longest_handler) {
+    stats_.longest_handler = run_time;
+    stats_.longest_handler_tag = tag;
+  }
+  if (run_time > slow_handler_threshold_) {
+    ++stats_.slow_handlers;
+    LOG(kWarning) << "Handler " << (tag.empty() ? std::string("(untagged)") : tag) << " ran for "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(run_time).count()
+                  << "us, blocking its io thread.";
+  }
+}
+
+template <typename IoServiceType>
+double IoService<IoServiceType>::Stats::IdleRatio() const {
+  if (thread_time.count() == 0)
+    return 1.0;
+  const auto total(std::chrono::duration<double>(thread_time).count());
+  return std::max(0.0, 1.0 - std::chrono::duration<double>(busy_time).count() / total);
+}
+
+template <typename IoServiceType>
+IoServicePool<IoServiceType>::IoServicePool(size_t service_count, bool pin_threads)
+    : services_(), nodes_(), next_index_(0) {
+  if (service_count == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  const std::vector<unsigned> cpus(numa::CpusByNode());
+  std::vector<std::future<bool>> pinned;
+  for (size_t i(0); i != service_count; ++i) {
+    services_.emplace_back(make_unique<IoService<IoServiceType>>(1));
+    if (!pin_threads) {
+      nodes_.push_back(numa::kAnyNode);
+      continue;
+    }
+    const unsigned cpu(cpus[i % cpus.size()]);
+    nodes_.push_back(numa::NodeOfCpu(cpu));
+    auto pin(std::make_shared<std::packaged_task<bool()>>(
+        [cpu] { return detail::PinCurrentThreadToCpu(cpu); }));
+    pinned.emplace_back(pin->get_future());
+    services_.back()->service().post([pin] { (*pin)(); });
+  }
+  for (size_t i(0); i != pinned.size(); ++i) {
+    if (!pinned[i].get()) {
+      LOG(kWarning) << "Failed to pin thread of service " << i << " to a CPU.";
+      nodes_[i] = numa::kAnyNode;
+    }
+  }
+}
+
+template <typename IoServiceType>
+void IoServicePool<IoServiceType>::Stop() {
+  for (auto& service : services_)
+    service->Stop();
+}
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_ASIO_SERVICE_H_
@@ -33,6 +33,7 @@
 #include <climits>  // for PAGESIZE
 #endif
 
+#include <array>
 #include <string>
 #include <memory>
 #include <map>
@@ -166,6 +167,133 @@ class LockedPageManager : public LockedPageManagerBase<MemoryPageLocker> {
   LockedPageManager() : LockedPageManagerBase<MemoryPageLocker>(GetSystemPageSize()) {}
 };
 
+// Hands out small blocks from a single region which is locked once, on first use, so that most
+// safe_allocator allocations cost neither a lock syscall nor an update of LockedPageManager's map.
+// Block sizes are rounded up to a power of two of at least kMinBlockSize.  Freed blocks are zeroed
+// and kept on a free list per size for reuse; the region is never returned to the OS.  Allocate
+// returns nullptr for blocks larger than kMaxBlockSize, once the region is exhausted, or if the
+// region couldn't be locked, and callers then fall back to locking pages per allocation.
+// The constructor is constexpr so that the singleton below is constant-initialised, and hence
+// usable by safe_allocators in other translation units' static objects.
+template <typename Locker>
+class LockedArenaBase {
+ public:
+  // Kept well below the smallest common default RLIMIT_MEMLOCK (64 KiB) to leave room for the
+  // fallback path.
+  static const size_t kRegionSize = 32 * 1024;
+  static const size_t kMinBlockSize = 16;
+  static const size_t kMaxBlockSize = 1024;
+
+  constexpr LockedArenaBase()
+      : locker_(),
+        mutex_(),
+        state_(State::kUninitialised),
+        begin_(nullptr),
+        end_(nullptr),
+        next_(nullptr),
+        free_lists_() {}
+
+  void* Allocate(size_t size) {
+    if (size == 0 || size > kMaxBlockSize)
+      return nullptr;
+    const size_t index(SizeClass(size));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kUninitialised)
+      Initialise();
+    if (state_ == State::kUnavailable)
+      return nullptr;
+    if (FreeBlock* block = free_lists_[index]) {
+      free_lists_[index] = block->next;
+      block->next = nullptr;
+      return block;
+    }
+    const size_t block_size(kMinBlockSize << index);
+    if (static_cast<size_t>(end_ - next_) < block_size)
+      return nullptr;
+    void* const block(next_);
+    next_ += block_size;
+    return block;
+  }
+
+  // Zeroes and reclaims 'p' and returns true if it was returned by Allocate(size), otherwise
+  // returns false and leaves 'p' untouched.
+  bool Deallocate(void* p, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t address(reinterpret_cast<size_t>(p));
+    if (address < reinterpret_cast<size_t>(begin_) || address >= reinterpret_cast<size_t>(end_))
+      return false;
+    const size_t index(SizeClass(size));
+    volatile char* vptr = static_cast<volatile char*>(p);
+    for (size_t i(0); i != (kMinBlockSize << index); ++i)
+      vptr[i] = 0;
+    FreeBlock* const block(static_cast<FreeBlock*>(p));
+    block->next = free_lists_[index];
+    free_lists_[index] = block;
+    return true;
+  }
+
+ private:
+  enum class State { kUninitialised, kAvailable, kUnavailable };
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  static const size_t kSizeClassCount = 7;  // 16, 32, ... 1024
+  static_assert((kMinBlockSize << (kSizeClassCount - 1)) == kMaxBlockSize, "Bad size classes");
+
+  static size_t SizeClass(size_t size) {
+    size_t index(0);
+    while ((kMinBlockSize << index) < size)
+      ++index;
+    return index;
+  }
+
+  void Initialise() {
+    state_ = State::kUnavailable;
+#ifdef MAIDSAFE_WIN32
+    void* const region(
+        VirtualAlloc(nullptr, kRegionSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (!region)
+      return;
+#else
+    void* const region(
+        mmap(nullptr, kRegionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (region == MAP_FAILED)
+      return;
+#ifdef MADV_DONTDUMP
+    madvise(region, kRegionSize, MADV_DONTDUMP);  // keep the contents out of core dumps too
+#endif
+#endif
+    if (!locker_.Lock(region, kRegionSize)) {
+#ifdef MAIDSAFE_WIN32
+      VirtualFree(region, 0, MEM_RELEASE);
+#else
+      munmap(region, kRegionSize);
+#endif
+      return;
+    }
+    begin_ = next_ = static_cast<char*>(region);
+    end_ = begin_ + kRegionSize;
+    state_ = State::kAvailable;
+  }
+
+  Locker locker_;
+  std::mutex mutex_;
+  State state_;
+  char* begin_;
+  char* end_;
+  char* next_;
+  std::array<FreeBlock*, kSizeClassCount> free_lists_;
+};
+
+// Singleton arena used by safe_allocator for small allocations.
+class LockedArena : public LockedArenaBase<MemoryPageLocker> {
+ public:
+  static LockedArena instance;
+
+ private:
+  constexpr LockedArena() : LockedArenaBase<MemoryPageLocker>() {}
+};
+
 // Allocator that locks its contents from being paged out of memory and clears its contents before
 // deletion.
 template <typename T>
@@ -192,6 +320,8 @@ struct safe_allocator : public std::allocator<T> {
   };
 
   pointer allocate(size_type count, const void* hint = 0) {
+    if (void* block = LockedArena::instance.Allocate(sizeof(value_type) * count))
+      return static_cast<pointer>(block);
     pointer ptr;
     ptr = std::allocator<value_type>::allocate(count, hint);
     if (ptr)
@@ -200,6 +330,8 @@ struct safe_allocator : public std::allocator<T> {
   }
 
   void deallocate(pointer ptr, size_type count) {
+    if (ptr && LockedArena::instance.Deallocate(ptr, sizeof(value_type) * count))
+      return;
     if (ptr) {
       size_type size(sizeof(value_type) * count);
       volatile char* vptr = reinterpret_cast<volatile char*>(ptr);
@@ -22,6 +22,7 @@
 #include <string>
 #include <map>
 #include <functional>
+#include <utility>
 
 #include "boost/regex.hpp"
 
@@ -63,6 +64,9 @@ class SecureString {
   template <typename StringType>
   void Append(const StringType& decrypted_chars);
   void Append(char decrypted_char);
+  // Replaces the contents with 'decrypted_chars' and finalises, encrypting them in a single pass.
+  template <typename StringType>
+  void Assign(const StringType& decrypted_chars);
   void Finalise();
   void Clear();
 
@@ -74,6 +78,36 @@ class SecureString {
   std::unique_ptr<Encryptor> encryptor_;
 };
 
+// Decrypts a SecureString or finalised SecureInputString once and holds the plaintext for the
+// lifetime of this object, for callers which need to read it several times.  The plaintext is wiped
+// on destruction, so instances should be kept as short-lived as possible.
+class ScopedPlaintext {
+ public:
+  typedef SafeString::size_type size_type;
+
+  // 'SecureType' needs a string() member, returning e.g. a SafeString or (for NonEmptyString) a
+  // std::string.
+  template <typename SecureType>
+  explicit ScopedPlaintext(const SecureType& secure_string)
+      : plaintext_(ToSafeString(secure_string.string())) {}
+  ScopedPlaintext(const ScopedPlaintext&) = delete;
+  ScopedPlaintext& operator=(const ScopedPlaintext&) = delete;
+  ~ScopedPlaintext();
+
+  const SafeString& string() const { return plaintext_; }
+  const char* data() const { return plaintext_.data(); }
+  size_type size() const { return plaintext_.size(); }
+
+ private:
+  static SafeString ToSafeString(SafeString&& string) { return std::move(string); }
+  template <typename StringType>
+  static SafeString ToSafeString(const StringType& string) {
+    return SafeString(string.begin(), string.end());
+  }
+
+  SafeString plaintext_;
+};
+
 template <typename StringType>
 SecureString::SecureString(const StringType& string)
     : phrase_(GetRandomString<SafeString>(crypto::SHA512::DIGESTSIZE)),
@@ -88,6 +122,13 @@ void SecureString::Append(const StringType& decrypted_chars) {
   encryptor_->Put(reinterpret_cast<const byte*>(decrypted_chars.data()), decrypted_chars.size());
 }
 
+template <typename StringType>
+void SecureString::Assign(const StringType& decrypted_chars) {
+  Clear();
+  Append(decrypted_chars);
+  Finalise();
+}
+
 template <typename Predicate, SecureString::size_type Size, typename Tag>
 class SecureInputString {
  public:
@@ -105,6 +146,10 @@ class SecureInputString {
 
   template <typename StringType>
   void Insert(size_type position, const StringType& decrypted_chars);
+  // Replaces the contents with 'string' and finalises.  Unlike a sequence of Insert calls followed
+  // by Finalise, this encrypts the whole string at once rather than character by character.
+  template <typename StringType>
+  void Assign(const StringType& string);
   void Remove(size_type position, size_type length = 1);
   void Clear();
   void Finalise();
@@ -179,6 +224,18 @@ void SecureInputString<Predicate, Size, Tag>::Insert(size_type position,
   encrypted_chars_.insert(std::make_pair(position, encrypted_chars));
 }
 
+template <typename Predicate, SecureString::size_type Size, typename Tag>
+template <typename StringType>
+void SecureInputString<Predicate, Size, Tag>::Assign(const StringType& string) {
+  if (!Predicate()(string.size(), Size)) {
+    LOG(kError) << "SecureInputString::Assign() outside_of_bounds";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  }
+  encrypted_chars_.clear();
+  secure_string_.Assign(string);
+  finalised_ = true;
+}
+
 template <typename Predicate, SecureString::size_type Size, typename Tag>
 void SecureInputString<Predicate, Size, Tag>::Remove(size_type position, size_type length) {
   if (IsFinalised())
@@ -0,0 +1,116 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_AUTHENTICATION_SECURE_PASSWORD_CACHE_H_
+#define MAIDSAFE_COMMON_AUTHENTICATION_SECURE_PASSWORD_CACHE_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Include this first to avoid having to wrap the cryptopp includes in a pragma to disable warnings
+#include "maidsafe/common/crypto.h"  // NOLINT
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/authentication/detail/safe_allocators.h"
+#include "maidsafe/common/authentication/detail/secure_string.h"
+
+namespace maidsafe {
+
+namespace authentication {
+
+// An in-process cache of the results of crypto::CreateSecurePassword, so that repeated derivations
+// from the same inputs (e.g. during login and session flows) don't each cost 10,000 or more PBKDF2
+// iterations.  Derived passwords are held in locked memory which is zeroed when freed, and expire
+// 'time_to_live' after being derived.  Entries are keyed by an HMAC of the inputs under a random
+// per-cache key, so the inputs themselves are never stored.  Once 'max_size' entries are held, the
+// one expiring soonest is evicted.  Thread-safe.
+class SecurePasswordCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit SecurePasswordCache(Clock::duration time_to_live, std::size_t max_size = 16);
+  SecurePasswordCache(const SecurePasswordCache&) = delete;
+  SecurePasswordCache& operator=(const SecurePasswordCache&) = delete;
+
+  // As for crypto::CreateSecurePassword, but returns a cached result if available.
+  template <typename PasswordType>
+  crypto::SecurePassword Get(const PasswordType& password, const crypto::Salt& salt, uint32_t pin,
+                             const std::string& label = crypto::kMaidSafeVersionLabel);
+
+  // Removes and zeroes all entries.
+  void Wipe();
+
+  std::size_t size() const;
+  std::uint64_t hit_count() const;
+
+ private:
+  using SafeBytes = std::vector<byte, detail::safe_allocator<byte>>;
+  using Key = std::array<byte, crypto::SHA512::DIGESTSIZE>;
+  struct Entry {
+    SafeBytes secure_password;
+    Clock::time_point expiry;
+  };
+
+  Key MakeKey(const byte* password, std::size_t password_size, const crypto::Salt& salt,
+              uint32_t pin, const std::string& label) const;
+  // Returns true and sets 'secure_password' if there's an unexpired entry for 'key'.
+  bool Find(const Key& key, crypto::SecurePassword& secure_password);
+  void Insert(const Key& key, const crypto::SecurePassword& secure_password);
+  void RemoveExpired(Clock::time_point now);
+
+  const Clock::duration time_to_live_;
+  const std::size_t max_size_;
+  const SafeBytes hmac_key_;
+  mutable std::mutex mutex_;
+  std::map<Key, Entry> entries_;
+  std::uint64_t hit_count_;
+};
+
+template <typename PasswordType>
+crypto::SecurePassword SecurePasswordCache::Get(const PasswordType& password,
+                                                const crypto::Salt& salt, uint32_t pin,
+                                                const std::string& label) {
+  if (!password.IsInitialised() || !salt.IsInitialised()) {
+    LOG(kError) << "SecurePasswordCache::Get password or salt uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  const Key key([&] {
+    const detail::ScopedPlaintext plaintext(password);
+    return MakeKey(reinterpret_cast<const byte*>(plaintext.data()), plaintext.size(), salt, pin,
+                   label);
+  }());
+  crypto::SecurePassword secure_password;
+  if (Find(key, secure_password))
+    return secure_password;
+  secure_password = crypto::CreateSecurePassword(password, salt, pin, label);
+  Insert(key, secure_password);
+  return secure_password;
+}
+
+}  // namespace authentication
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_AUTHENTICATION_SECURE_PASSWORD_CACHE_H_
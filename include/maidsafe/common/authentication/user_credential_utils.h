@@ -21,6 +21,7 @@
 
 #include "maidsafe/common/crypto.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/authentication/secure_password_cache.h"
 #include "maidsafe/common/authentication/user_credentials.h"
 
 namespace maidsafe {
@@ -28,13 +29,16 @@ namespace maidsafe {
 namespace authentication {
 
 // Uses PBKDFv2 function to generate a secure password from the user's password and pin.  The user's
-// keyword is not used in this function.  Throws if the password or pin is null.
-crypto::SecurePassword CreateSecurePassword(const UserCredentials& user_credentials);
+// keyword is not used in this function.  If 'cache' is non-null, the derivation is looked up in and
+// added to it.  Throws if the password or pin is null.
+crypto::SecurePassword CreateSecurePassword(const UserCredentials& user_credentials,
+                                            SecurePasswordCache* cache = nullptr);
 
 // Uses PBKDFv2 function to generate a secure password from the user's keyword, password and pin,
-// then performs a bitwise XOR on the secure password and data.  Throws if any user credential is
-// null.
-NonEmptyString Obfuscate(const UserCredentials& user_credentials, const NonEmptyString& data);
+// then performs a bitwise XOR on the secure password and data.  If 'cache' is non-null, the
+// derivation is looked up in and added to it.  Throws if any user credential is null.
+NonEmptyString Obfuscate(const UserCredentials& user_credentials, const NonEmptyString& data,
+                         SecurePasswordCache* cache = nullptr);
 
 }  // namespace authentication
 
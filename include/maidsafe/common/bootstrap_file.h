@@ -0,0 +1,79 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_BOOTSTRAP_FILE_H_
+#define MAIDSAFE_COMMON_BOOTSTRAP_FILE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "asio/ip/udp.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+// A compact binary format for bootstrap endpoint lists, designed to be mapped and queried in place
+// rather than parsed.  It consists of a 16-byte header (the 8 bytes "MAIDBOOT", then a format
+// version and the record count, each as a little-endian uint32) followed by the records.  Each
+// record is 18 bytes: the address as 16 bytes in network order (IPv4 addresses as IPv4-mapped IPv6
+// addresses) followed by the port in network order.  Records are sorted bytewise and unique.
+//
+// bootstrap_file_tool converts between this and the cereal-serialised format.
+
+// Returns 'endpoints' in the compact format, sorted and without duplicates.
+std::vector<byte> SerialiseCompactBootstrap(const std::vector<asio::ip::udp::endpoint>& endpoints);
+
+// Returns true if 'data' starts with the compact format's header.  Doesn't validate the records.
+bool IsCompactBootstrap(const byte* data, std::size_t size);
+
+class CompactBootstrapFile {
+ public:
+  // Maps the file at 'path'.  Throws filesystem_io_error if it can't be mapped, or parsing_error
+  // if it isn't a valid compact bootstrap file.
+  explicit CompactBootstrapFile(const boost::filesystem::path& path);
+  // Views 'size' bytes at 'data', which must remain valid for the lifetime of this object.  Throws
+  // parsing_error if they aren't a valid compact bootstrap file.
+  CompactBootstrapFile(const byte* data, std::size_t size);
+
+  CompactBootstrapFile(CompactBootstrapFile&& other);
+  CompactBootstrapFile& operator=(CompactBootstrapFile&& other);
+  CompactBootstrapFile(const CompactBootstrapFile&) = delete;
+  CompactBootstrapFile& operator=(const CompactBootstrapFile&) = delete;
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // 'index' must be less than size().
+  asio::ip::udp::endpoint operator[](std::size_t index) const;
+  // Binary searches the records without decoding them.
+  bool Contains(const asio::ip::udp::endpoint& endpoint) const;
+  std::vector<asio::ip::udp::endpoint> Endpoints() const;
+
+ private:
+  void Validate(const byte* data, std::size_t size);
+
+  MappedFile file_;
+  const byte* records_;
+  std::size_t size_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_BOOTSTRAP_FILE_H_
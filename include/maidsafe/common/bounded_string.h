@@ -20,10 +20,16 @@
 #define MAIDSAFE_COMMON_BOUNDED_STRING_H_
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "boost/expected/expected.hpp"
 #include "cereal/types/string.hpp"
 #include "cereal/types/vector.hpp"
 
@@ -31,6 +37,7 @@
 #include "maidsafe/common/encode.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/serialisation/binary_archive_fwd.h"
 
 namespace maidsafe {
 
@@ -80,6 +87,270 @@ struct Char<
   using value_type = unsigned char;
 };
 
+// FixedString holds exactly 'size' bytes inline (in a std::array), so is usable as the String type
+// of a BoundedString whose lower and upper bounds are both 'size', avoiding the heap allocation and
+// pointer indirection of a std::vector.  It's empty after default construction; otherwise it
+// always holds 'size' bytes, and constructing it from a range of any other non-zero size throws.
+// It serialises identically to a std::vector<unsigned char> holding the same bytes.
+template <std::size_t size_in_bytes>
+class FixedString {
+ public:
+  using value_type = unsigned char;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+
+  FixedString() : bytes_(), empty_(true) {}
+
+  FixedString(size_type count, value_type value) : bytes_(), empty_(count == 0) {
+    CheckSize(count);
+    bytes_.fill(value);
+  }
+
+  template <typename Iterator,
+            typename std::enable_if<!std::is_integral<Iterator>::value>::type* = nullptr>
+  FixedString(Iterator first, Iterator last) : bytes_(), empty_(first == last) {
+    CheckSize(static_cast<size_type>(std::distance(first, last)));
+    std::copy(first, last, bytes_.begin());
+  }
+
+  // Implicit to allow e.g. the results of RandomBytes or hex::DecodeToBytes to be used directly.
+  FixedString(const std::vector<value_type>& bytes)  // NOLINT
+      : FixedString(bytes.begin(), bytes.end()) {}
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(cereal::make_size_tag(static_cast<cereal::size_type>(size())));
+    archive(cereal::binary_data(data(), size()));
+  }
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    cereal::size_type count(0);
+    archive(cereal::make_size_tag(count));
+    CheckSize(static_cast<size_type>(count));
+    empty_ = (count == 0);
+    archive(cereal::binary_data(bytes_.data(), size()));
+  }
+
+  size_type size() const { return empty_ ? 0 : size_in_bytes; }
+  bool empty() const { return empty_; }
+
+  value_type* data() { return bytes_.data(); }
+  const value_type* data() const { return bytes_.data(); }
+
+  iterator begin() { return data(); }
+  const_iterator begin() const { return data(); }
+  const_iterator cbegin() const { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator end() const { return data() + size(); }
+  const_iterator cend() const { return data() + size(); }
+
+  reference operator[](size_type pos) { return bytes_[pos]; }
+  const_reference operator[](size_type pos) const { return bytes_[pos]; }
+
+ private:
+  static void CheckSize(size_type count) {
+    if (count != 0 && count != size_in_bytes) {
+      LOG(kError) << "FixedString - invalid string size";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+    }
+  }
+
+  std::array<value_type, size_in_bytes> bytes_;
+  bool empty_;
+};
+
+template <std::size_t size>
+inline bool operator==(const FixedString<size>& lhs, const FixedString<size>& rhs) {
+  return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+template <std::size_t size>
+inline bool operator!=(const FixedString<size>& lhs, const FixedString<size>& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+template <std::size_t size>
+inline bool operator<(const FixedString<size>& lhs, const FixedString<size>& rhs) {
+  if (lhs.size() != rhs.size())
+    return lhs.size() < rhs.size();
+  return std::memcmp(lhs.data(), rhs.data(), lhs.size()) < 0;
+}
+
+template <std::size_t size>
+inline bool operator==(const FixedString<size>& lhs, const std::vector<unsigned char>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <std::size_t size>
+inline bool operator==(const std::vector<unsigned char>& lhs, const FixedString<size>& rhs) {
+  return operator==(rhs, lhs);
+}
+
+template <std::size_t size>
+inline bool operator!=(const FixedString<size>& lhs, const std::vector<unsigned char>& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+template <std::size_t size>
+inline bool operator!=(const std::vector<unsigned char>& lhs, const FixedString<size>& rhs) {
+  return !operator==(rhs, lhs);
+}
+
+// SmallString holds up to 'inline_capacity' bytes inline and only allocates (exactly) for larger
+// contents, so is usable as the String type of a BoundedString holding mostly short values (salts,
+// tags, small payloads) to avoid a heap allocation per instance.  Like the BoundedString using it,
+// its contents are only replaced as a whole, never grown in place.  It compares, hashes and
+// serialises identically to a std::vector<unsigned char> holding the same bytes.
+template <std::size_t inline_capacity>
+class SmallString {
+ public:
+  using value_type = unsigned char;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = value_type*;
+  using const_iterator = const value_type*;
+
+  SmallString() : inline_(), heap_(), size_(0) {}
+
+  SmallString(size_type count, value_type value) : SmallString() {
+    Allocate(count);
+    std::fill_n(data(), count, value);
+  }
+
+  template <typename Iterator,
+            typename std::enable_if<!std::is_integral<Iterator>::value>::type* = nullptr>
+  SmallString(Iterator first, Iterator last) : SmallString() {
+    Allocate(static_cast<size_type>(std::distance(first, last)));
+    std::copy(first, last, data());
+  }
+
+  // Implicit to allow e.g. the results of RandomBytes or hex::DecodeToBytes to be used directly.
+  SmallString(const std::vector<value_type>& bytes)  // NOLINT
+      : SmallString(bytes.begin(), bytes.end()) {}
+
+  SmallString(const SmallString& other) : SmallString(other.begin(), other.end()) {}
+
+  SmallString(SmallString&& other) MAIDSAFE_NOEXCEPT : inline_(),
+                                                       heap_(std::move(other.heap_)),
+                                                       size_(other.size_) {
+    if (!heap_)
+      std::memcpy(inline_.data(), other.inline_.data(), size_);
+    other.size_ = 0;
+  }
+
+  SmallString& operator=(const SmallString& other) {
+    if (this != &other) {
+      SmallString temp(other);
+      *this = std::move(temp);
+    }
+    return *this;
+  }
+
+  SmallString& operator=(SmallString&& other) MAIDSAFE_NOEXCEPT {
+    if (this != &other) {
+      heap_ = std::move(other.heap_);
+      size_ = other.size_;
+      if (!heap_)
+        std::memcpy(inline_.data(), other.inline_.data(), size_);
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(cereal::make_size_tag(static_cast<cereal::size_type>(size())));
+    archive(cereal::binary_data(data(), size()));
+  }
+
+  template <typename Archive>
+  void load(Archive& archive) {
+    cereal::size_type count(0);
+    archive(cereal::make_size_tag(count));
+    Allocate(static_cast<size_type>(count));
+    archive(cereal::binary_data(data(), size()));
+  }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // True if the contents are held inline, i.e. no heap allocation was needed.
+  bool is_inline() const { return !heap_; }
+
+  value_type* data() { return heap_ ? heap_.get() : inline_.data(); }
+  const value_type* data() const { return heap_ ? heap_.get() : inline_.data(); }
+
+  iterator begin() { return data(); }
+  const_iterator begin() const { return data(); }
+  const_iterator cbegin() const { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator end() const { return data() + size(); }
+  const_iterator cend() const { return data() + size(); }
+
+  reference operator[](size_type pos) { return data()[pos]; }
+  const_reference operator[](size_type pos) const { return data()[pos]; }
+
+ private:
+  // Discards the current contents and makes room for 'count' bytes.
+  void Allocate(size_type count) {
+    if (count > inline_capacity)
+      heap_.reset(new value_type[count]);
+    else
+      heap_.reset();
+    size_ = count;
+  }
+
+  std::array<value_type, inline_capacity> inline_;
+  std::unique_ptr<value_type[]> heap_;
+  size_type size_;
+};
+
+template <std::size_t capacity>
+inline void swap(SmallString<capacity>& lhs, SmallString<capacity>& rhs) MAIDSAFE_NOEXCEPT {
+  SmallString<capacity> temp(std::move(lhs));
+  lhs = std::move(rhs);
+  rhs = std::move(temp);
+}
+
+template <std::size_t capacity>
+inline bool operator==(const SmallString<capacity>& lhs, const SmallString<capacity>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <std::size_t capacity>
+inline bool operator!=(const SmallString<capacity>& lhs, const SmallString<capacity>& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+template <std::size_t capacity>
+inline bool operator<(const SmallString<capacity>& lhs, const SmallString<capacity>& rhs) {
+  return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <std::size_t capacity>
+inline bool operator==(const SmallString<capacity>& lhs, const std::vector<unsigned char>& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <std::size_t capacity>
+inline bool operator==(const std::vector<unsigned char>& lhs, const SmallString<capacity>& rhs) {
+  return operator==(rhs, lhs);
+}
+
+template <std::size_t capacity>
+inline bool operator!=(const SmallString<capacity>& lhs, const std::vector<unsigned char>& rhs) {
+  return !operator==(lhs, rhs);
+}
+
+template <std::size_t capacity>
+inline bool operator!=(const std::vector<unsigned char>& lhs, const SmallString<capacity>& rhs) {
+  return !operator==(rhs, lhs);
+}
+
 // BoundedString
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -118,6 +389,22 @@ class BoundedString {
     }
   }
 
+  // Non-throwing alternatives to the constructors above: return CommonErrors::outside_of_bounds if
+  // 'string' is too short or too long.
+  static boost::expected<BoundedString, common_error> TryMake(String string) {
+    if (string.size() < min || string.size() > max)
+      return boost::make_unexpected(MakeError(CommonErrors::outside_of_bounds));
+    return BoundedString(std::move(string));
+  }
+
+  template <typename T = String,
+            typename std::enable_if<!std::is_same<T, std::string>::value>::type* = nullptr>
+  static boost::expected<BoundedString, common_error> TryMake(const std::string& string) {
+    if (string.size() < min || string.size() > max)
+      return boost::make_unexpected(MakeError(CommonErrors::outside_of_bounds));
+    return BoundedString(string);
+  }
+
   template <std::size_t other_min, std::size_t other_max, typename OtherStringType>
   explicit BoundedString(BoundedString<other_min, other_max, OtherStringType> other)
       : string_(other.string_.begin(), other.string_.end()), valid_(std::move(other.valid_)) {
@@ -153,22 +440,17 @@ class BoundedString {
     return *this;
   }
 
+  // With maidsafe's binary archives, a fixed-size instance (min == max) is written as exactly 'max'
+  // characters with no size prefix, and a variable-size one has its size checked against the
+  // bounds before anything is allocated.  Other archives use the String's own serialisation.
   template <typename Archive>
   Archive& save(Archive& archive) const {
-    return archive(string());
+    return Save(archive, FormatFor<Archive>());
   }
 
   template <typename Archive>
   Archive& load(Archive& archive) {
-    try {
-      String temp_str_type;
-      archive(temp_str_type);
-      *this = BoundedString{std::move(temp_str_type)};
-    } catch (const std::exception& e) {
-      LOG(kWarning) << boost::diagnostic_information(e);
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-    }
-    return archive;
+    return Load(archive, FormatFor<Archive>());
   }
 
   const String& string() const {
@@ -221,6 +503,87 @@ class BoundedString {
                   "Lower bound of BoundedString must be less than or equal to upper bound");
     return (string_.size() < min) || (string_.size() > max);
   }
+
+  struct CerealFormat {};
+  struct FixedSizeFormat {};
+  struct CheckedSizeFormat {};
+
+  template <typename Archive>
+  using FormatFor = typename std::conditional<
+      !IsBinaryArchive<Archive>::value, CerealFormat,
+      typename std::conditional<min == max, FixedSizeFormat, CheckedSizeFormat>::type>::type;
+
+  template <typename Archive, typename Format>
+  Archive& Save(Archive& archive, Format) const {
+    return archive(string());
+  }
+
+  template <typename Archive>
+  Archive& Save(Archive& archive, FixedSizeFormat) const {
+    archive.saveBinary(string().data(), max * sizeof(value_type));
+    return archive;
+  }
+
+  template <typename Archive>
+  Archive& Load(Archive& archive, CerealFormat) {
+    try {
+      String temp_str_type;
+      archive(temp_str_type);
+      *this = BoundedString{std::move(temp_str_type)};
+    } catch (const std::exception& e) {
+      LOG(kWarning) << boost::diagnostic_information(e);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    return archive;
+  }
+
+  // The size is fixed by the type, so no bounds check is needed after reading.
+  template <typename Archive>
+  Archive& Load(Archive& archive, FixedSizeFormat) {
+    static_assert(max != 0, "A fixed-size BoundedString must hold at least one character");
+    String temp_str_type(max, value_type());
+    try {
+      archive.loadBinary(&temp_str_type[0], max * sizeof(value_type));
+    } catch (const std::exception& e) {
+      LOG(kWarning) << boost::diagnostic_information(e);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    SetLoaded(std::move(temp_str_type));
+    return archive;
+  }
+
+  // Reads the same size-prefixed format as the String's own serialisation, but rejects a size
+  // outwith the bounds (or larger than the remaining input) before allocating for it.
+  template <typename Archive>
+  Archive& Load(Archive& archive, CheckedSizeFormat) {
+    String temp_str_type;
+    try {
+      cereal::size_type size(0);
+      archive.loadBinary(&size, sizeof(size));
+      if (size < min || size > max || size > archive.remaining() / sizeof(value_type)) {
+        LOG(kWarning) << "Serialised BoundedString size of " << size << " is invalid";
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      }
+      temp_str_type = String(static_cast<std::size_t>(size), value_type());
+      if (size != 0)
+        archive.loadBinary(&temp_str_type[0], temp_str_type.size() * sizeof(value_type));
+    } catch (const common_error&) {
+      throw;
+    } catch (const std::exception& e) {
+      LOG(kWarning) << boost::diagnostic_information(e);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    SetLoaded(std::move(temp_str_type));
+    return archive;
+  }
+
+  void SetLoaded(String string) {
+    string_ = std::move(string);
+    valid_ = true;
+#ifndef NDEBUG
+    debug_string_ = hex::Substr(string_);
+#endif
+  }
 };
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -228,6 +591,16 @@ class BoundedString {
 
 
 
+// Found by argument-dependent lookup for all String types, including those (e.g. SmallString)
+// which don't bring std::swap into consideration themselves.
+template <std::size_t min, std::size_t max, typename String>
+inline void swap(BoundedString<min, max, String>& lhs,
+                 BoundedString<min, max, String>& rhs) MAIDSAFE_NOEXCEPT {
+  BoundedString<min, max, String> temp(std::move(lhs));
+  lhs = std::move(rhs);
+  rhs = std::move(temp);
+}
+
 template <std::size_t min, std::size_t max, typename String>
 inline bool operator==(const BoundedString<min, max, String>& lhs,
                        const BoundedString<min, max, String>& rhs) {
@@ -0,0 +1,96 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_COMPLETION_HANDLER_H_
+#define MAIDSAFE_COMMON_COMPLETION_HANDLER_H_
+
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#include "asio/associated_executor.hpp"
+#include "asio/async_result.hpp"
+#include "asio/post.hpp"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Holds an asio completion handler (which may be move-only, e.g. one resuming a coroutine) in a
+// copyable functor, so that it can be passed around as a std::function.  Must be invoked at most
+// once.
+template <typename Handler>
+class SharedHandler {
+ public:
+  explicit SharedHandler(Handler handler)
+      : handler_(std::make_shared<Handler>(std::move(handler))) {}
+
+  template <typename... Args>
+  void operator()(Args&&... args) const {
+    (*handler_)(std::forward<Args>(args)...);
+  }
+
+  const Handler& handler() const { return *handler_; }
+
+ private:
+  std::shared_ptr<Handler> handler_;
+};
+
+// As above, but each invocation is posted to the handler's associated executor ('fallback' if it
+// has none), as asio requires of the final completion of an asynchronous operation.  The result is
+// moved rather than copied into the handler.
+template <typename Handler, typename Executor>
+class PostingHandler {
+ public:
+  PostingHandler(Handler handler, const Executor& fallback)
+      : handler_(std::move(handler)),
+        executor_(asio::get_associated_executor(handler_.handler(), fallback)) {}
+
+  void operator()(std::error_code ec) const {
+    SharedHandler<Handler> handler(handler_);
+    asio::post(executor_, [handler, ec] { handler(ec); });
+  }
+
+  template <typename Result>
+  void operator()(std::error_code ec, Result result) const {
+    asio::post(executor_, Completion<Result>{handler_, ec, std::move(result)});
+  }
+
+ private:
+  template <typename Result>
+  struct Completion {
+    void operator()() { handler(ec, std::move(result)); }
+    SharedHandler<Handler> handler;
+    std::error_code ec;
+    Result result;
+  };
+
+  SharedHandler<Handler> handler_;
+  asio::associated_executor_t<Handler, Executor> executor_;
+};
+
+template <typename Handler, typename Executor>
+PostingHandler<Handler, Executor> MakePostingHandler(Handler handler, const Executor& fallback) {
+  return PostingHandler<Handler, Executor>(std::move(handler), fallback);
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_COMPLETION_HANDLER_H_
@@ -0,0 +1,234 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Memory resources, and an allocator drawing on them, for the node-based containers used by the
+  library (LruCache, SafeQueue, ...), which otherwise make a separate heap allocation for every
+  element.
+
+  MonotonicArena - carves allocations from a chain of blocks and never reuses freed memory; all
+  of it is returned at once by Release or the arena's destructor.  Suited to short-lived
+  containers, e.g. ones built for the duration of a single request or batch.
+
+  PooledArena - keeps freed blocks on free lists (one per size class) for reuse, carving new ones
+  from a MonotonicArena.  Suited to long-lived containers with steady churn, such as caches, whose
+  footprint then stays bounded by their peak size.
+
+  Neither arena is thread-safe.  An arena must outlive every container (and every allocator) using
+  it, and containers sharing an arena must not be modified concurrently.
+
+  Research links
+  http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2014/n3916.pdf (Polymorphic Memory Resources)
+  http://www.boost.org/doc/libs/release/doc/html/container/extended_functionality.html
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_ARENA_H_
+#define MAIDSAFE_COMMON_CONTAINERS_ARENA_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace maidsafe {
+
+class MonotonicArena {
+ public:
+  explicit MonotonicArena(size_t initial_block_size = 4096)
+      : next_block_size_(initial_block_size < kMinBlockSize ? kMinBlockSize : initial_block_size) {}
+
+  ~MonotonicArena() { Release(); }
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena(MonotonicArena&&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(MonotonicArena&&) = delete;
+
+  // 'alignment' must be a power of two.
+  void* Allocate(size_t bytes, size_t alignment) {
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    char* aligned(Align(current_, alignment));
+    if (!current_ || aligned > end_ || static_cast<size_t>(end_ - aligned) < bytes) {
+      AddBlock(bytes + alignment);
+      aligned = Align(current_, alignment);
+    }
+    current_ = aligned + bytes;
+    return aligned;
+  }
+
+  // Memory is only reclaimed by Release.
+  void Deallocate(void* /*ptr*/, size_t /*bytes*/, size_t /*alignment*/) {}
+
+  // Frees all blocks.  Every allocation made so far must no longer be in use.
+  void Release() {
+    while (blocks_) {
+      Block* const next(blocks_->next);
+      ::operator delete(blocks_);
+      blocks_ = next;
+    }
+    current_ = end_ = nullptr;
+    bytes_reserved_ = 0;
+  }
+
+  // Total size of the blocks obtained from the global heap.
+  size_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  static const size_t kMinBlockSize = 256;
+  static const size_t kMaxBlockSize = 1 << 20;
+
+  static char* Align(char* ptr, size_t alignment) {
+    const auto address(reinterpret_cast<std::uintptr_t>(ptr));
+    return ptr + (((address + alignment - 1) & ~(alignment - 1)) - address);
+  }
+
+  // Block sizes double, up to kMaxBlockSize, so that the number of blocks stays logarithmic.
+  void AddBlock(size_t min_bytes) {
+    const size_t size(sizeof(Block) + std::max(next_block_size_, min_bytes));
+    char* const memory(static_cast<char*>(::operator new(size)));
+    blocks_ = new (memory) Block{blocks_};
+    current_ = memory + sizeof(Block);
+    end_ = memory + size;
+    bytes_reserved_ += size;
+    if (next_block_size_ < kMaxBlockSize)
+      next_block_size_ *= 2;
+  }
+
+  size_t next_block_size_;
+  Block* blocks_{nullptr};
+  char* current_{nullptr};
+  char* end_{nullptr};
+  size_t bytes_reserved_{0};
+};
+
+class PooledArena {
+ public:
+  // Requests for more than 'max_pooled_size' bytes, or with an alignment stricter than
+  // kGranularity, bypass the pool and go straight to the global heap.
+  explicit PooledArena(size_t max_pooled_size = 512, size_t initial_block_size = 4096)
+      : free_lists_((std::max<size_t>(max_pooled_size, 1) + kGranularity - 1) / kGranularity,
+                    nullptr),
+        blocks_(initial_block_size) {}
+
+  PooledArena(const PooledArena&) = delete;
+  PooledArena(PooledArena&&) = delete;
+  PooledArena& operator=(const PooledArena&) = delete;
+  PooledArena& operator=(PooledArena&&) = delete;
+
+  void* Allocate(size_t bytes, size_t alignment) {
+    if (!IsPooled(bytes, alignment))
+      return ::operator new(bytes);
+    FreeBlock*& free_list(free_lists_[SizeClass(bytes)]);
+    if (!free_list)
+      return blocks_.Allocate((SizeClass(bytes) + 1) * kGranularity, kGranularity);
+    FreeBlock* const block(free_list);
+    free_list = block->next;
+    return block;
+  }
+
+  // 'bytes' and 'alignment' must match those passed to Allocate.
+  void Deallocate(void* ptr, size_t bytes, size_t alignment) {
+    if (!IsPooled(bytes, alignment))
+      return ::operator delete(ptr);
+    FreeBlock*& free_list(free_lists_[SizeClass(bytes)]);
+    free_list = new (ptr) FreeBlock{free_list};
+  }
+
+  // Total size of the blocks obtained from the global heap for pooled allocations.
+  size_t bytes_reserved() const { return blocks_.bytes_reserved(); }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static const size_t kGranularity = 16;
+  static_assert(sizeof(FreeBlock) <= kGranularity, "Size classes must be able to hold a link.");
+
+  bool IsPooled(size_t bytes, size_t alignment) const {
+    return bytes != 0 && alignment <= kGranularity && SizeClass(bytes) < free_lists_.size();
+  }
+
+  static size_t SizeClass(size_t bytes) { return (bytes - 1) / kGranularity; }
+
+  std::vector<FreeBlock*> free_lists_;
+  MonotonicArena blocks_;
+};
+
+// Standard allocator drawing on an Arena (MonotonicArena, PooledArena, or any class providing the
+// same Allocate and Deallocate functions).  Allocators compare equal if they use the same arena.
+// A default-constructed allocator has no arena and must not be used to allocate.
+template <typename T, typename Arena = PooledArena>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <typename Other>
+  struct rebind {
+    typedef ArenaAllocator<Other, Arena> other;
+  };
+
+  ArenaAllocator() : arena_(nullptr) {}
+  explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U, Arena>& other)  // NOLINT (implicit conversion required)
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    assert(arena_);
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t count) { arena_->Deallocate(ptr, count * sizeof(T), alignof(T)); }
+
+  size_t max_size() const { return std::numeric_limits<size_t>::max() / sizeof(T); }
+
+  Arena* arena() const { return arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template <typename T, typename U, typename Arena>
+bool operator==(const ArenaAllocator<T, Arena>& lhs, const ArenaAllocator<U, Arena>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U, typename Arena>
+bool operator!=(const ArenaAllocator<T, Arena>& lhs, const ArenaAllocator<U, Arena>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_ARENA_H_
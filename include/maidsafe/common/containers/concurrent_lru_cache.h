@@ -0,0 +1,252 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A thread-safe wrapper around LruCache which splits the key space across a number of shards, each
+  of which is an independent LruCache protected by its own mutex.  A key is always mapped to the
+  same shard (using a seeded hash of the key), so callers on different threads only contend when
+  their keys happen to fall in the same shard.
+
+  The capacity and time_to_live settings apply to each shard individually, i.e. the overall
+  capacity of the cache is shard_count * capacity.  Since eviction is per shard, the cache as a
+  whole only approximates LRU ordering.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/expected/expected.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename KeyType, typename ValueType, typename Hash, typename EvictionPolicy>
+class ConcurrentLruCacheBase {
+ public:
+  ConcurrentLruCacheBase(size_t shard_count, size_t capacity)
+      : hash_(), shards_(), hits_(0), misses_(0) {
+    Init(shard_count, capacity);
+  }
+
+  ConcurrentLruCacheBase(size_t shard_count, std::chrono::steady_clock::duration time_to_live)
+      : hash_(), shards_(), hits_(0), misses_(0) {
+    Init(shard_count, time_to_live);
+  }
+
+  ConcurrentLruCacheBase(size_t shard_count, size_t capacity,
+                         std::chrono::steady_clock::duration time_to_live)
+      : hash_(), shards_(), hits_(0), misses_(0) {
+    Init(shard_count, capacity, time_to_live);
+  }
+
+  virtual ~ConcurrentLruCacheBase() = default;
+  ConcurrentLruCacheBase(const ConcurrentLruCacheBase&) = delete;
+  ConcurrentLruCacheBase(ConcurrentLruCacheBase&&) = delete;
+  ConcurrentLruCacheBase& operator=(const ConcurrentLruCacheBase&) = delete;
+  ConcurrentLruCacheBase& operator=(ConcurrentLruCacheBase&&) = delete;
+
+  // Sum of the sizes of all shards.  Since each shard is locked in turn, the result is only a
+  // snapshot if other threads are concurrently modifying the cache.
+  size_t size() const {
+    size_t total(0);
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.size();
+    }
+    return total;
+  }
+
+  size_t shard_count() const { return shards_.size(); }
+
+  // Evicts up to 'max_items' expired entries in total across all shards; see LruCache::Purge.
+  size_t Purge(size_t max_items = std::numeric_limits<size_t>::max()) {
+    size_t purged(0);
+    for (auto& shard : shards_) {
+      if (purged == max_items)
+        break;
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      purged += shard->cache.Purge(max_items - purged);
+    }
+    return purged;
+  }
+
+  std::uint64_t hits() const { return hits_.load(); }
+  std::uint64_t misses() const { return misses_.load(); }
+
+  // Returns the ratio of hits to total lookups, or 0.0 if there have been no lookups yet.
+  double HitRate() const {
+    const std::uint64_t hit_count(hits_.load()), miss_count(misses_.load());
+    if (hit_count + miss_count == 0)
+      return 0.0;
+    return static_cast<double>(hit_count) / static_cast<double>(hit_count + miss_count);
+  }
+
+ protected:
+  struct Shard {
+    template <typename... Args>
+    explicit Shard(Args&&... args)
+        : mutex(), cache(std::forward<Args>(args)...) {}
+    mutable std::mutex mutex;
+    LruCache<KeyType, ValueType, EvictionPolicy> cache;
+  };
+
+  Shard& GetShard(const KeyType& key) const {
+    return *shards_[static_cast<size_t>(hash_(key) % shards_.size())];
+  }
+
+  void RecordLookup(bool hit) const {
+    if (hit)
+      ++hits_;
+    else
+      ++misses_;
+  }
+
+ private:
+  template <typename... Args>
+  void Init(size_t shard_count, Args&&... args) {
+    if (shard_count == 0)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    shards_.reserve(shard_count);
+    for (size_t i(0); i < shard_count; ++i)
+      shards_.emplace_back(new Shard(args...));
+  }
+
+  const Hash hash_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  mutable std::atomic<std::uint64_t> hits_, misses_;
+};
+
+}  // namespace detail
+
+// Thread-safe, sharded equivalent of LruCache<KeyType, ValueType, EvictionPolicy>
+template <typename KeyType, typename ValueType, typename Hash = SeededHash<SipHash13>,
+          typename EvictionPolicy = LruPolicy>
+class ConcurrentLruCache
+    : public detail::ConcurrentLruCacheBase<KeyType, ValueType, Hash, EvictionPolicy> {
+  using Base = detail::ConcurrentLruCacheBase<KeyType, ValueType, Hash, EvictionPolicy>;
+
+ public:
+  ConcurrentLruCache(size_t shard_count, size_t capacity) : Base(shard_count, capacity) {}
+
+  ConcurrentLruCache(size_t shard_count, std::chrono::steady_clock::duration time_to_live)
+      : Base(shard_count, time_to_live) {}
+
+  ConcurrentLruCache(size_t shard_count, size_t capacity,
+                     std::chrono::steady_clock::duration time_to_live)
+      : Base(shard_count, capacity, time_to_live) {}
+
+  virtual ~ConcurrentLruCache() = default;
+  ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache(ConcurrentLruCache&&) = delete;
+  ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache& operator=(ConcurrentLruCache&&) = delete;
+
+  boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto result(shard.cache.Get(key));
+    this->RecordLookup(result.valid());
+    return result;
+  }
+
+  // See LruCache::Visit.  'functor' is invoked while the shard's mutex is held, so must not call
+  // back into this cache.
+  template <typename Functor>
+  bool Visit(const KeyType& key, Functor functor) {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const bool found(shard.cache.Visit(key, functor));
+    this->RecordLookup(found);
+    return found;
+  }
+
+  bool Check(const KeyType& key) const {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.Check(key);
+  }
+
+  void Add(KeyType key, ValueType value) {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Add(std::move(key), std::move(value));
+  }
+
+  void Delete(const KeyType& key) {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Delete(key);
+  }
+};
+
+// Thread-safe, sharded equivalent of LruCache<KeyType, void, EvictionPolicy>.  Each call to Check
+// counts as a lookup for the purposes of the hit / miss counters.
+template <typename KeyType, typename Hash, typename EvictionPolicy>
+class ConcurrentLruCache<KeyType, void, Hash, EvictionPolicy>
+    : public detail::ConcurrentLruCacheBase<KeyType, void, Hash, EvictionPolicy> {
+  using Base = detail::ConcurrentLruCacheBase<KeyType, void, Hash, EvictionPolicy>;
+
+ public:
+  ConcurrentLruCache(size_t shard_count, size_t capacity) : Base(shard_count, capacity) {}
+
+  ConcurrentLruCache(size_t shard_count, std::chrono::steady_clock::duration time_to_live)
+      : Base(shard_count, time_to_live) {}
+
+  ConcurrentLruCache(size_t shard_count, size_t capacity,
+                     std::chrono::steady_clock::duration time_to_live)
+      : Base(shard_count, capacity, time_to_live) {}
+
+  virtual ~ConcurrentLruCache() = default;
+  ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache(ConcurrentLruCache&&) = delete;
+  ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache& operator=(ConcurrentLruCache&&) = delete;
+
+  bool Check(const KeyType& key) const {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const bool found(shard.cache.Check(key));
+    this->RecordLookup(found);
+    return found;
+  }
+
+  void Add(KeyType key) {
+    auto& shard(this->GetShard(key));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.Add(std::move(key));
+  }
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_CONCURRENT_LRU_CACHE_H_
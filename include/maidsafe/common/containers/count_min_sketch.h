@@ -0,0 +1,215 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A compact, approximate frequency counter.  Each key maps to one 8-bit saturating counter in each
+  of kDepth rows; the estimate for a key is the minimum of its counters, so it can over-estimate
+  (due to collisions) but never under-estimate the number of increments since the last ageing.
+  Increments use the conservative-update rule (only the smallest counters are incremented), which
+  reduces the over-estimation.
+
+  Once the number of increments reaches the sample size, all counters are halved so that the sketch
+  reflects recent rather than all-time popularity.
+
+  ConcurrentCountMinSketch is a thread-safe variant with 32-bit atomic counters.  It increments
+  every row (so over-estimates a little more than with the conservative update rule) and is only
+  aged explicitly.
+
+  Research links
+  http://en.wikipedia.org/wiki/Count%E2%80%93min_sketch
+  http://arxiv.org/abs/1512.00727 (TinyLFU: A Highly Efficient Cache Admission Policy)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_COUNT_MIN_SKETCH_H_
+#define MAIDSAFE_COMMON_CONTAINERS_COUNT_MIN_SKETCH_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/hash.h"
+
+namespace maidsafe {
+
+template <typename KeyType, typename Hash = SeededHash<SipHash13>>
+class CountMinSketch {
+ public:
+  static const size_t kDepth = 4;
+
+  // 'width' is rounded up to a power of two.  A 'sample_size' of 0 selects 10 * width.
+  explicit CountMinSketch(size_t width, size_t sample_size = 0)
+      : hash_(),
+        width_(RoundUpToPowerOfTwo(width)),
+        sample_size_(sample_size == 0 ? 10 * width_ : sample_size),
+        increments_(0),
+        counters_(kDepth * width_, 0) {}
+
+  CountMinSketch(const CountMinSketch&) = delete;
+  CountMinSketch(CountMinSketch&&) = delete;
+  CountMinSketch& operator=(const CountMinSketch&) = delete;
+  CountMinSketch& operator=(CountMinSketch&&) = delete;
+
+  void Increment(const KeyType& key) {
+    const auto indices(Indices(key));
+    std::uint8_t minimum(std::numeric_limits<std::uint8_t>::max());
+    for (size_t row(0); row < kDepth; ++row)
+      minimum = std::min(minimum, counters_[indices[row]]);
+    if (minimum != std::numeric_limits<std::uint8_t>::max()) {
+      for (size_t row(0); row < kDepth; ++row) {
+        if (counters_[indices[row]] == minimum)
+          ++counters_[indices[row]];
+      }
+    }
+    if (++increments_ >= sample_size_)
+      Age();
+  }
+
+  unsigned Estimate(const KeyType& key) const {
+    const auto indices(Indices(key));
+    std::uint8_t minimum(std::numeric_limits<std::uint8_t>::max());
+    for (size_t row(0); row < kDepth; ++row)
+      minimum = std::min(minimum, counters_[indices[row]]);
+    return minimum;
+  }
+
+  // Halves all counters
+  void Age() {
+    for (auto& counter : counters_)
+      counter >>= 1;
+    increments_ /= 2;
+  }
+
+  void Clear() {
+    std::fill(std::begin(counters_), std::end(counters_), 0);
+    increments_ = 0;
+  }
+
+  size_t width() const { return width_; }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result(1);
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  // Derives one index per row from a single 64-bit hash (Kirsch-Mitzenmacher double hashing)
+  std::array<size_t, kDepth> Indices(const KeyType& key) const {
+    const std::uint64_t hash(hash_(key));
+    const std::uint64_t low(hash & 0xffffffff), high((hash >> 32) | 1);
+    std::array<size_t, kDepth> indices;
+    for (size_t row(0); row < kDepth; ++row)
+      indices[row] = (row * width_) + static_cast<size_t>((low + row * high) & (width_ - 1));
+    return indices;
+  }
+
+  const Hash hash_;
+  const size_t width_;
+  const size_t sample_size_;
+  size_t increments_;
+  std::vector<std::uint8_t> counters_;
+};
+
+template <typename KeyType, typename Hash = SeededHash<SipHash13>>
+class ConcurrentCountMinSketch {
+ public:
+  static const size_t kDepth = 4;
+
+  // 'width' is rounded up to a power of two.
+  explicit ConcurrentCountMinSketch(size_t width)
+      : hash_(), width_(RoundUpToPowerOfTwo(width)), counters_(new Counter[kDepth * width_]) {
+    Clear();
+  }
+
+  ConcurrentCountMinSketch(const ConcurrentCountMinSketch&) = delete;
+  ConcurrentCountMinSketch(ConcurrentCountMinSketch&&) = delete;
+  ConcurrentCountMinSketch& operator=(const ConcurrentCountMinSketch&) = delete;
+  ConcurrentCountMinSketch& operator=(ConcurrentCountMinSketch&&) = delete;
+
+  // Returns the estimate including this increment.
+  std::uint32_t Increment(const KeyType& key) {
+    const auto indices(Indices(key));
+    std::uint32_t minimum(std::numeric_limits<std::uint32_t>::max());
+    for (size_t row(0); row < kDepth; ++row) {
+      Counter& counter(counters_[indices[row]]);
+      std::uint32_t value(counter.load(std::memory_order_relaxed));
+      // Saturates rather than wrapping.
+      while (value != std::numeric_limits<std::uint32_t>::max() &&
+             !counter.compare_exchange_weak(value, value + 1, std::memory_order_relaxed)) {
+      }
+      if (value != std::numeric_limits<std::uint32_t>::max())
+        ++value;
+      minimum = std::min(minimum, value);
+    }
+    return minimum;
+  }
+
+  std::uint32_t Estimate(const KeyType& key) const {
+    const auto indices(Indices(key));
+    std::uint32_t minimum(std::numeric_limits<std::uint32_t>::max());
+    for (size_t row(0); row < kDepth; ++row)
+      minimum = std::min(minimum, counters_[indices[row]].load(std::memory_order_relaxed));
+    return minimum;
+  }
+
+  // Halves all counters.  Increments made concurrently may be lost.
+  void Age() {
+    for (size_t i(0); i < kDepth * width_; ++i)
+      counters_[i].store(counters_[i].load(std::memory_order_relaxed) >> 1,
+                         std::memory_order_relaxed);
+  }
+
+  void Clear() {
+    for (size_t i(0); i < kDepth * width_; ++i)
+      counters_[i].store(0, std::memory_order_relaxed);
+  }
+
+  size_t width() const { return width_; }
+
+ private:
+  using Counter = std::atomic<std::uint32_t>;
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result(1);
+    while (result < value)
+      result <<= 1;
+    return result;
+  }
+
+  std::array<size_t, kDepth> Indices(const KeyType& key) const {
+    const std::uint64_t hash(hash_(key));
+    const std::uint64_t low(hash & 0xffffffff), high((hash >> 32) | 1);
+    std::array<size_t, kDepth> indices;
+    for (size_t row(0); row < kDepth; ++row)
+      indices[row] = (row * width_) + static_cast<size_t>((low + row * high) & (width_ - 1));
+    return indices;
+  }
+
+  const Hash hash_;
+  const size_t width_;
+  const std::unique_ptr<Counter[]> counters_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_COUNT_MIN_SKETCH_H_
@@ -0,0 +1,133 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A cache-friendly replacement for std::unordered_map, intended for large tables (e.g. keyed by
+  Identity).  Elements are held inline in a single open-addressing table rather than in one node
+  each; see flat_hash_table.h for details of the layout and probing.
+
+  The interface is a subset of std::unordered_map's, with these differences:
+    - any insertion may invalidate iterators, pointers and references to elements
+    - there's no bucket interface and no max_load_factor (which is fixed at 7/8)
+    - emplace constructs the element before checking for its key; prefer try_emplace
+
+  KeyType must be equality comparable and hashable by the Hash functor (by default
+  SeededHash<SipHash13>).
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_MAP_H_
+#define MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_MAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/containers/flat_hash_table.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename KeyType, typename MappedType>
+struct FlatHashMapPolicy {
+  using key_type = KeyType;
+  using value_type = std::pair<const KeyType, MappedType>;
+  static const key_type& Key(const value_type& value) { return value.first; }
+};
+
+}  // namespace detail
+
+template <typename KeyType, typename MappedType, typename Hash = SeededHash<SipHash13>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class FlatHashMap
+    : public detail::FlatHashTable<detail::FlatHashMapPolicy<KeyType, MappedType>, Hash, KeyEqual> {
+  using Base =
+      detail::FlatHashTable<detail::FlatHashMapPolicy<KeyType, MappedType>, Hash, KeyEqual>;
+
+ public:
+  using mapped_type = MappedType;
+  using typename Base::key_type;
+  using typename Base::value_type;
+  using typename Base::size_type;
+  using typename Base::iterator;
+  using typename Base::const_iterator;
+
+  FlatHashMap() = default;
+
+  explicit FlatHashMap(size_type bucket_count, const Hash& hash = Hash(),
+                       const KeyEqual& equal = KeyEqual())
+      : Base(bucket_count, hash, equal) {}
+
+  FlatHashMap(std::initializer_list<value_type> values) : Base(0) {
+    this->reserve(values.size());
+    this->insert(values.begin(), values.end());
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return this->EmplaceWithKey(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return this->EmplaceWithKey(key, std::piecewise_construct,
+                                std::forward_as_tuple(std::move(key)),
+                                std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <typename Mapped>
+  std::pair<iterator, bool> insert_or_assign(const key_type& key, Mapped&& mapped) {
+    const auto result(try_emplace(key, std::forward<Mapped>(mapped)));
+    if (!result.second)
+      result.first->second = std::forward<Mapped>(mapped);
+    return result;
+  }
+
+  mapped_type& operator[](const key_type& key) { return try_emplace(key).first->second; }
+  mapped_type& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+
+  // Throws CommonErrors::no_such_element if 'key' is not present.
+  mapped_type& at(const key_type& key) {
+    const auto itr(this->find(key));
+    if (itr == this->end())
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    return itr->second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    const auto itr(this->find(key));
+    if (itr == this->end())
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    return itr->second;
+  }
+};
+
+template <typename KeyType, typename MappedType, typename Hash, typename KeyEqual>
+void swap(FlatHashMap<KeyType, MappedType, Hash, KeyEqual>& lhs,
+          FlatHashMap<KeyType, MappedType, Hash, KeyEqual>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_MAP_H_
@@ -0,0 +1,80 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A cache-friendly replacement for std::unordered_set, holding its elements inline in a single
+  open-addressing table; see flat_hash_table.h for details.  As with FlatHashMap, any insertion may
+  invalidate iterators and references, and there is no bucket interface.
+
+  KeyType must be equality comparable and hashable by the Hash functor (by default
+  SeededHash<SipHash13>).
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_SET_H_
+#define MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_SET_H_
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/containers/flat_hash_table.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename KeyType>
+struct FlatHashSetPolicy {
+  using key_type = KeyType;
+  using value_type = KeyType;
+  static const key_type& Key(const value_type& value) { return value; }
+};
+
+}  // namespace detail
+
+template <typename KeyType, typename Hash = SeededHash<SipHash13>,
+          typename KeyEqual = std::equal_to<KeyType>>
+class FlatHashSet
+    : public detail::FlatHashTable<detail::FlatHashSetPolicy<KeyType>, Hash, KeyEqual> {
+  using Base = detail::FlatHashTable<detail::FlatHashSetPolicy<KeyType>, Hash, KeyEqual>;
+
+ public:
+  using typename Base::value_type;
+  using typename Base::size_type;
+
+  FlatHashSet() = default;
+
+  explicit FlatHashSet(size_type bucket_count, const Hash& hash = Hash(),
+                       const KeyEqual& equal = KeyEqual())
+      : Base(bucket_count, hash, equal) {}
+
+  FlatHashSet(std::initializer_list<value_type> values) : Base(0) {
+    this->reserve(values.size());
+    this->insert(values.begin(), values.end());
+  }
+};
+
+template <typename KeyType, typename Hash, typename KeyEqual>
+void swap(FlatHashSet<KeyType, Hash, KeyEqual>& lhs, FlatHashSet<KeyType, Hash, KeyEqual>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_SET_H_
@@ -0,0 +1,595 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Implementation shared by FlatHashMap and FlatHashSet: an open-addressing ("Swiss table") hash
+  table holding its elements inline in a single array of slots.
+
+  Each slot has a one-byte control entry, either kEmpty, kDeleted or (for a full slot) the low
+  seven bits of the element's hash.  A lookup starts at the slot selected by the remaining hash
+  bits and probes a group of kGroupWidth consecutive control bytes at a time (using SSE2 where
+  available), comparing only those elements whose control byte matches.  The probe stops at the
+  first group containing an empty slot, so most lookups touch one cache line of control bytes and
+  a single element.
+
+  The capacity is always 2^n - 1.  The control array has a sentinel byte at [capacity] followed by
+  copies of the first kGroupWidth - 1 bytes, so that a group can be loaded starting at any slot.
+  Erasing leaves a kDeleted tombstone; tombstones are purged whenever the table is rehashed.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_TABLE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_TABLE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#define MAIDSAFE_FLAT_HASH_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace maidsafe {
+
+namespace detail {
+
+using FlatHashControl = std::int8_t;
+
+const FlatHashControl kFlatHashEmpty = -128;  // 0b10000000
+const FlatHashControl kFlatHashDeleted = -2;  // 0b11111110
+const FlatHashControl kFlatHashSentinel = -1;  // 0b11111111
+// Full slots hold 0b0xxxxxxx, i.e. are non-negative.
+
+const std::size_t kFlatHashGroupWidth = 16;
+
+// Bit i is set if the control byte at position i of a group satisfies the query.
+class FlatHashMatch {
+ public:
+  explicit FlatHashMatch(std::uint32_t mask) : mask_(mask) {}
+
+  explicit operator bool() const { return mask_ != 0; }
+
+  // Must not be called if the mask is empty.
+  std::size_t Lowest() const {
+    assert(mask_ != 0);
+#if defined(_MSC_VER)
+    unsigned long index;  // NOLINT
+    _BitScanForward(&index, mask_);
+    return index;
+#else
+    return static_cast<std::size_t>(__builtin_ctz(mask_));
+#endif
+  }
+
+  void ClearLowest() { mask_ &= mask_ - 1; }
+
+ private:
+  std::uint32_t mask_;
+};
+
+class FlatHashGroup {
+ public:
+#ifdef MAIDSAFE_FLAT_HASH_TABLE_SSE2
+  explicit FlatHashGroup(const FlatHashControl* control)
+      : control_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control))) {}
+
+  FlatHashMatch Match(FlatHashControl h2) const {
+    return FlatHashMatch(static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), control_))));
+  }
+
+  FlatHashMatch MatchEmpty() const { return Match(kFlatHashEmpty); }
+
+  // kEmpty and kDeleted are the only values less than kSentinel.
+  FlatHashMatch MatchEmptyOrDeleted() const {
+    return FlatHashMatch(static_cast<std::uint32_t>(
+        _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kFlatHashSentinel), control_))));
+  }
+
+ private:
+  __m128i control_;
+#else
+  explicit FlatHashGroup(const FlatHashControl* control) {
+    std::memcpy(control_, control, kFlatHashGroupWidth);
+  }
+
+  FlatHashMatch Match(FlatHashControl h2) const {
+    std::uint32_t mask(0);
+    for (std::size_t i(0); i != kFlatHashGroupWidth; ++i)
+      mask |= static_cast<std::uint32_t>(control_[i] == h2) << i;
+    return FlatHashMatch(mask);
+  }
+
+  FlatHashMatch MatchEmpty() const { return Match(kFlatHashEmpty); }
+
+  FlatHashMatch MatchEmptyOrDeleted() const {
+    std::uint32_t mask(0);
+    for (std::size_t i(0); i != kFlatHashGroupWidth; ++i)
+      mask |= static_cast<std::uint32_t>(control_[i] < kFlatHashSentinel) << i;
+    return FlatHashMatch(mask);
+  }
+
+ private:
+  FlatHashControl control_[kFlatHashGroupWidth];
+#endif
+};
+
+// Control bytes of a table with no allocation: a sentinel (so that begin() == end()) followed by a
+// group's worth of empty slots (so that every lookup terminates immediately).
+inline FlatHashControl* FlatHashEmptyControl() {
+  alignas(16) static const FlatHashControl kEmptyControl[kFlatHashGroupWidth] = {
+      kFlatHashSentinel, kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+      kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+      kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+      kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty};
+  // Never written to, since a table with zero capacity grows before inserting.
+  return const_cast<FlatHashControl*>(kEmptyControl);
+}
+
+// Policy is a struct providing 'key_type', 'value_type' and
+// 'static const key_type& Key(const value_type&)'.
+template <typename Policy, typename Hash, typename KeyEqual>
+class FlatHashTable {
+  template <typename Value>
+  class Iterator;
+
+ public:
+  using key_type = typename Policy::key_type;
+  using value_type = typename Policy::value_type;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = Iterator<value_type>;
+  using const_iterator = Iterator<const value_type>;
+
+  FlatHashTable() : FlatHashTable(0) {}
+
+  explicit FlatHashTable(size_type bucket_count, const Hash& hash = Hash(),
+                         const KeyEqual& equal = KeyEqual())
+      : hash_(hash),
+        equal_(equal),
+        control_(FlatHashEmptyControl()),
+        slots_(),
+        capacity_(0),
+        size_(0),
+        growth_left_(0) {
+    if (bucket_count != 0)
+      Resize(NormaliseCapacity(bucket_count));
+  }
+
+  FlatHashTable(const FlatHashTable& other)
+      : FlatHashTable(0, other.hash_, other.equal_) {
+    reserve(other.size_);
+    for (const auto& value : other)
+      InsertUnique(value);
+  }
+
+  FlatHashTable(FlatHashTable&& other)
+      : hash_(std::move(other.hash_)),
+        equal_(std::move(other.equal_)),
+        control_(other.control_),
+        slots_(std::move(other.slots_)),
+        capacity_(other.capacity_),
+        size_(other.size_),
+        growth_left_(other.growth_left_) {
+    other.Disown();
+  }
+
+  FlatHashTable& operator=(FlatHashTable other) {
+    swap(other);
+    return *this;
+  }
+
+  ~FlatHashTable() {
+    DestroyElements();
+    ReleaseStorage();
+  }
+
+  void swap(FlatHashTable& other) {
+    using std::swap;
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+    swap(control_, other.control_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+  }
+
+  iterator begin() { return iterator(control_, Slot(0)).SkipEmpty(); }
+  const_iterator begin() const { return const_iterator(control_, Slot(0)).SkipEmpty(); }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator(control_ + capacity_, Slot(capacity_)); }
+  const_iterator end() const { return const_iterator(control_ + capacity_, Slot(capacity_)); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type bucket_count() const { return capacity_; }
+  float load_factor() const {
+    return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / static_cast<float>(capacity_);
+  }
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return equal_; }
+
+  void clear() {
+    DestroyElements();
+    ReleaseStorage();
+  }
+
+  // Ensures 'count' elements can be held without rehashing.
+  void reserve(size_type count) {
+    if (count > size_ + growth_left_)
+      Resize(NormaliseCapacity(GrowthToCapacity(count)));
+  }
+
+  iterator find(const key_type& key) {
+    const size_type index(Find(key));
+    return index == kNotFound ? end() : IteratorAt(index);
+  }
+
+  const_iterator find(const key_type& key) const {
+    const size_type index(Find(key));
+    return index == kNotFound ? end() : const_iterator(control_ + index, Slot(index));
+  }
+
+  size_type count(const key_type& key) const { return Find(key) == kNotFound ? 0 : 1; }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return EmplaceWithKey(Policy::Key(value), value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return EmplaceWithKey(Policy::Key(value), std::move(value));
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  // Constructs the element before looking up its key, so prefer insert or (for FlatHashMap)
+  // try_emplace where the key is already available.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return insert(std::move(value));
+  }
+
+  iterator erase(const_iterator position) {
+    const size_type index(static_cast<size_type>(position.control_ - control_));
+    EraseAt(index);
+    return IteratorAt(index).SkipEmpty();
+  }
+
+  iterator erase(iterator position) { return erase(const_iterator(position)); }
+
+  size_type erase(const key_type& key) {
+    const size_type index(Find(key));
+    if (index == kNotFound)
+      return 0;
+    EraseAt(index);
+    return 1;
+  }
+
+ protected:
+  // Returns the element for 'key', constructing it from 'args' if it's not already present.
+  template <typename... Args>
+  std::pair<iterator, bool> EmplaceWithKey(const key_type& key, Args&&... args) {
+    const std::uint64_t hash(hash_(key));
+    const size_type index(Find(key, hash));
+    if (index != kNotFound)
+      return std::make_pair(IteratorAt(index), false);
+    return std::make_pair(IteratorAt(InsertNew(hash, std::forward<Args>(args)...)), true);
+  }
+
+ private:
+  template <typename Value>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::remove_const<Value>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+
+    Iterator() : control_(nullptr), slot_(nullptr) {}
+
+    // Allow conversion from iterator to const_iterator.
+    template <typename Other, typename = typename std::enable_if<
+                                  std::is_convertible<Other*, Value*>::value>::type>
+    Iterator(const Iterator<Other>& other)  // NOLINT
+        : control_(other.control_), slot_(other.slot_) {}
+
+    reference operator*() const { return *slot_; }
+    pointer operator->() const { return slot_; }
+
+    Iterator& operator++() {
+      ++control_;
+      ++slot_;
+      return SkipEmpty();
+    }
+
+    Iterator operator++(int) {
+      Iterator previous(*this);
+      ++*this;
+      return previous;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+      return lhs.control_ == rhs.control_;
+    }
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) { return !(lhs == rhs); }
+
+   private:
+    friend class FlatHashTable;
+    template <typename>
+    friend class Iterator;
+
+    Iterator(const FlatHashControl* control, Value* slot) : control_(control), slot_(slot) {}
+
+    // Advances to the next full slot, or to the sentinel which marks end().
+    Iterator& SkipEmpty() {
+      while (*control_ < kFlatHashSentinel) {
+        ++control_;
+        ++slot_;
+      }
+      return *this;
+    }
+
+    const FlatHashControl* control_;
+    Value* slot_;
+  };
+
+  using SlotStorage =
+      typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+  static const size_type kNotFound = static_cast<size_type>(-1);
+
+  // Upper 57 bits select the first group to probe; the lower 7 are stored in the control byte.
+  static size_type H1(std::uint64_t hash) { return static_cast<size_type>(hash >> 7); }
+  static FlatHashControl H2(std::uint64_t hash) {
+    return static_cast<FlatHashControl>(hash & 0x7f);
+  }
+
+  // The smallest valid capacity (2^n - 1, and at least kFlatHashGroupWidth - 1) >= 'count'.
+  static size_type NormaliseCapacity(size_type count) {
+    size_type capacity(kFlatHashGroupWidth - 1);
+    while (capacity < count)
+      capacity = capacity * 2 + 1;
+    return capacity;
+  }
+
+  // Maximum load factor is 7/8.  'growth' must be non-zero.
+  static size_type CapacityToGrowth(size_type capacity) { return capacity - capacity / 8; }
+  static size_type GrowthToCapacity(size_type growth) { return growth + (growth - 1) / 7; }
+
+  value_type* Slot(size_type index) const {
+    return slots_ ? reinterpret_cast<value_type*>(slots_.get() + index) : nullptr;
+  }
+
+  iterator IteratorAt(size_type index) { return iterator(control_ + index, Slot(index)); }
+
+  // Sets the control byte at 'index' and its copy past the sentinel, if it has one.
+  void SetControl(size_type index, FlatHashControl value) {
+    control_[index] = value;
+    control_[((index - (kFlatHashGroupWidth - 1)) & capacity_) + (kFlatHashGroupWidth - 1)] =
+        value;
+  }
+
+  // Calls 'functor(offset)' for the start of each group in the probe sequence for 'hash' until it
+  // returns true.  Triangular probing visits every group exactly once since capacity_ + 1 is a
+  // power of two.
+  template <typename Functor>
+  void Probe(std::uint64_t hash, Functor functor) const {
+    size_type offset(H1(hash) & capacity_);
+    for (size_type step(kFlatHashGroupWidth);; step += kFlatHashGroupWidth) {
+      if (functor(offset))
+        return;
+      offset = (offset + step) & capacity_;
+      assert(step <= capacity_ + kFlatHashGroupWidth && "full table");
+    }
+  }
+
+  size_type Find(const key_type& key) const { return Find(key, hash_(key)); }
+
+  size_type Find(const key_type& key, std::uint64_t hash) const {
+    const FlatHashControl h2(H2(hash));
+    size_type result(kNotFound);
+    Probe(hash, [&](size_type offset) {
+      const FlatHashGroup group(control_ + offset);
+      for (FlatHashMatch match(group.Match(h2)); match; match.ClearLowest()) {
+        const size_type index((offset + match.Lowest()) & capacity_);
+        if (equal_(Policy::Key(*Slot(index)), key)) {
+          result = index;
+          return true;
+        }
+      }
+      return static_cast<bool>(group.MatchEmpty());
+    });
+    return result;
+  }
+
+  // The first empty or deleted slot in the probe sequence for 'hash'.
+  size_type FindFirstNonFull(std::uint64_t hash) const {
+    size_type result(kNotFound);
+    Probe(hash, [&](size_type offset) {
+      const FlatHashMatch match(FlatHashGroup(control_ + offset).MatchEmptyOrDeleted());
+      if (match)
+        result = (offset + match.Lowest()) & capacity_;
+      return static_cast<bool>(match);
+    });
+    return result;
+  }
+
+  // Constructs a new element (whose key must not already be present) and returns its index.
+  template <typename... Args>
+  size_type InsertNew(std::uint64_t hash, Args&&... args) {
+    size_type index(FindFirstNonFull(hash));
+    if (growth_left_ == 0 && control_[index] != kFlatHashDeleted) {
+      // Purge tombstones in place if they account for at least half the load, otherwise grow.
+      Resize(size_ * 2 < CapacityToGrowth(capacity_) ? capacity_
+                                                     : NormaliseCapacity(capacity_ * 2 + 1));
+      index = FindFirstNonFull(hash);
+    }
+    ::new (static_cast<void*>(Slot(index))) value_type(std::forward<Args>(args)...);
+    if (control_[index] == kFlatHashEmpty)
+      --growth_left_;
+    SetControl(index, H2(hash));
+    ++size_;
+    return index;
+  }
+
+  template <typename Value>
+  void InsertUnique(Value&& value) {
+    InsertNew(hash_(Policy::Key(value)), std::forward<Value>(value));
+  }
+
+  void EraseAt(size_type index) {
+    assert(control_[index] >= 0 && "erasing an empty slot");
+    Slot(index)->~value_type();
+    --size_;
+    // If the neighbouring empty slots mean no probe could ever have passed over a full group
+    // containing this slot, it can be marked empty rather than deleted.
+    const size_type before_index((index - kFlatHashGroupWidth) & capacity_);
+    const FlatHashMatch empty_after(FlatHashGroup(control_ + index).MatchEmpty());
+    const FlatHashMatch empty_before(FlatHashGroup(control_ + before_index).MatchEmpty());
+    const bool was_never_full(empty_before && empty_after &&
+                              empty_after.Lowest() + NonEmptyAtEnd(empty_before) <
+                                  kFlatHashGroupWidth);
+    SetControl(index, was_never_full ? kFlatHashEmpty : kFlatHashDeleted);
+    if (was_never_full)
+      ++growth_left_;
+  }
+
+  // Number of non-empty slots at the end of the group from which 'empty' was taken.
+  static size_type NonEmptyAtEnd(FlatHashMatch empty) {
+    size_type highest(0);
+    for (; empty; empty.ClearLowest())
+      highest = empty.Lowest();
+    return kFlatHashGroupWidth - 1 - highest;
+  }
+
+  void Resize(size_type new_capacity) {
+    assert(new_capacity >= kFlatHashGroupWidth - 1 && ((new_capacity + 1) & new_capacity) == 0);
+    std::unique_ptr<FlatHashControl[]> new_control(
+        new FlatHashControl[new_capacity + kFlatHashGroupWidth]);
+    std::unique_ptr<SlotStorage[]> new_slots(new SlotStorage[new_capacity]);
+    std::memset(new_control.get(), kFlatHashEmpty, new_capacity + kFlatHashGroupWidth);
+    new_control[new_capacity] = kFlatHashSentinel;
+
+    FlatHashTable old(0, hash_, equal_);
+    old.control_ = control_;
+    old.slots_ = std::move(slots_);
+    old.capacity_ = capacity_;
+    old.size_ = size_;
+    control_ = new_control.release();
+    slots_ = std::move(new_slots);
+    capacity_ = new_capacity;
+    size_ = 0;
+    growth_left_ = CapacityToGrowth(new_capacity);
+
+    // Elements are moved one at a time, destroying each source as soon as it has been moved so
+    // that 'old' still owns exactly the elements not yet transferred if a move throws.
+    for (size_type i(0); i != old.capacity_; ++i) {
+      if (old.control_[i] < 0)
+        continue;
+      value_type* source(old.Slot(i));
+      InsertUnique(std::move(*source));
+      source->~value_type();
+      old.control_[i] = kFlatHashEmpty;
+      --old.size_;
+    }
+  }
+
+  void DestroyElements() {
+    if (!std::is_trivially_destructible<value_type>::value) {
+      for (size_type i(0); i != capacity_ && size_ != 0; ++i) {
+        if (control_[i] >= 0) {
+          Slot(i)->~value_type();
+          --size_;
+        }
+      }
+    }
+    size_ = 0;
+  }
+
+  // Frees the arrays (which must hold no live elements) and resets to the unallocated state.
+  void ReleaseStorage() {
+    if (capacity_ != 0)
+      delete[] control_;
+    slots_.reset();
+    Disown();
+  }
+
+  // Resets to the unallocated state without freeing the arrays, which have been taken over.
+  void Disown() {
+    control_ = FlatHashEmptyControl();
+    slots_.reset();
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  Hash hash_;
+  KeyEqual equal_;
+  FlatHashControl* control_;
+  std::unique_ptr<SlotStorage[]> slots_;
+  size_type capacity_, size_, growth_left_;
+};
+
+template <typename Policy, typename Hash, typename KeyEqual>
+bool operator==(const FlatHashTable<Policy, Hash, KeyEqual>& lhs,
+                const FlatHashTable<Policy, Hash, KeyEqual>& rhs) {
+  if (lhs.size() != rhs.size())
+    return false;
+  for (const auto& value : lhs) {
+    const auto found(rhs.find(Policy::Key(value)));
+    if (found == rhs.end() || !(*found == value))
+      return false;
+  }
+  return true;
+}
+
+template <typename Policy, typename Hash, typename KeyEqual>
+bool operator!=(const FlatHashTable<Policy, Hash, KeyEqual>& lhs,
+                const FlatHashTable<Policy, Hash, KeyEqual>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_FLAT_HASH_TABLE_H_
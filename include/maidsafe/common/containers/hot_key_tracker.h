@@ -0,0 +1,202 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  SpaceSaving tracks the most frequent keys of a stream using a fixed number (M) of counters.  A key
+  already tracked has its count incremented; otherwise it replaces the key with the smallest count,
+  inheriting that count (recorded as its 'error') plus one.  So each reported count is an
+  over-estimate by at most its error, and any key occurring more than N/M times in a stream of N
+  keys is guaranteed to be tracked.  Since the most recently admitted keys carry inflated counts,
+  M should be a few times the number of keys to be reported.
+
+  HotKeyTracker combines a ConcurrentCountMinSketch (for an estimate of any key's frequency, e.g. to
+  feed a cache admission policy) with a SpaceSaving summary (for a snapshot of the hottest keys,
+  e.g. for dashboards or to size or pre-warm a cache).  It is thread-safe, and can be attached to
+  DataBuffer (Options::lookup_observer) or LruCache (SetLookupObserver) via Observer().  Once
+  'sample_size' keys have been recorded, all counts are halved so that they reflect recent rather
+  than all-time popularity.
+
+  References
+  Metwally, Agrawal and El Abbadi: Efficient Computation of Frequent and Top-k Elements in Data
+  Streams (ICDT 2005)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_HOT_KEY_TRACKER_H_
+#define MAIDSAFE_COMMON_CONTAINERS_HOT_KEY_TRACKER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/multi_index_container.hpp"
+#include "boost/multi_index/member.hpp"
+#include "boost/multi_index/ordered_index.hpp"
+
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/containers/count_min_sketch.h"
+
+namespace maidsafe {
+
+template <typename KeyType>
+struct HotKey {
+  KeyType key;
+  std::uint64_t count;
+  std::uint64_t error;  // 'count' may exceed the true count by up to this much
+};
+
+// Not thread-safe.  KeyType must be less-than comparable.
+template <typename KeyType>
+class SpaceSaving {
+ public:
+  explicit SpaceSaving(size_t capacity) : capacity_(std::max(capacity, size_t(1))), entries_() {}
+
+  SpaceSaving(const SpaceSaving&) = delete;
+  SpaceSaving(SpaceSaving&&) = delete;
+  SpaceSaving& operator=(const SpaceSaving&) = delete;
+  SpaceSaving& operator=(SpaceSaving&&) = delete;
+
+  void Add(const KeyType& key) {
+    auto& by_key(entries_.template get<ByKey>());
+    const auto itr(by_key.find(key));
+    if (itr != by_key.end()) {
+      by_key.modify(itr, [](HotKey<KeyType>& entry) { ++entry.count; });
+    } else if (entries_.size() < capacity_) {
+      entries_.insert(HotKey<KeyType>{key, 1, 0});
+    } else {
+      auto& by_count(entries_.template get<ByCount>());
+      by_count.modify(by_count.begin(), [&key](HotKey<KeyType>& entry) {
+        entry.key = key;
+        entry.error = entry.count;
+        ++entry.count;
+      });
+    }
+  }
+
+  // Returns up to 'count' entries, hottest first.
+  std::vector<HotKey<KeyType>> Top(size_t count) const {
+    const auto& by_count(entries_.template get<ByCount>());
+    std::vector<HotKey<KeyType>> top;
+    top.reserve(std::min(count, entries_.size()));
+    for (auto itr(by_count.rbegin()); itr != by_count.rend() && top.size() < count; ++itr)
+      top.push_back(*itr);
+    return top;
+  }
+
+  // Halves all counts and errors.  Halving preserves the order of the counts.
+  void Age() {
+    auto& by_key(entries_.template get<ByKey>());
+    for (auto itr(by_key.begin()); itr != by_key.end(); ++itr) {
+      by_key.modify(itr, [](HotKey<KeyType>& entry) {
+        entry.count >>= 1;
+        entry.error >>= 1;
+      });
+    }
+  }
+
+  void Clear() { entries_.clear(); }
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct ByKey {};
+  struct ByCount {};
+  using Entries = boost::multi_index_container<
+      HotKey<KeyType>,
+      boost::multi_index::indexed_by<
+          boost::multi_index::ordered_unique<
+              boost::multi_index::tag<ByKey>,
+              boost::multi_index::member<HotKey<KeyType>, KeyType, &HotKey<KeyType>::key>>,
+          boost::multi_index::ordered_non_unique<
+              boost::multi_index::tag<ByCount>,
+              boost::multi_index::member<HotKey<KeyType>, std::uint64_t,
+                                         &HotKey<KeyType>::count>>>>;
+
+  const size_t capacity_;
+  Entries entries_;
+};
+
+template <typename KeyType, typename Hash = SeededHash<SipHash13>>
+class HotKeyTracker {
+ public:
+  // Reports the 'top_k' hottest keys, using kCountersPerKey * top_k counters to find them.  A
+  // 'sketch_width' of 0 selects max(1024, 16 * top_k), and a 'sample_size' of 0 selects 10 * the
+  // sketch width.
+  explicit HotKeyTracker(size_t top_k, size_t sketch_width = 0, size_t sample_size = 0)
+      : sketch_(sketch_width == 0 ? std::max(size_t(1024), 16 * top_k) : sketch_width),
+        top_k_(top_k),
+        sample_size_(sample_size == 0 ? 10 * sketch_.width() : sample_size),
+        recorded_(0),
+        mutex_(),
+        top_(kCountersPerKey * top_k) {}
+
+  HotKeyTracker(const HotKeyTracker&) = delete;
+  HotKeyTracker(HotKeyTracker&&) = delete;
+  HotKeyTracker& operator=(const HotKeyTracker&) = delete;
+  HotKeyTracker& operator=(HotKeyTracker&&) = delete;
+
+  void Record(const KeyType& key) {
+    sketch_.Increment(key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    top_.Add(key);
+    if (++recorded_ >= sample_size_) {
+      sketch_.Age();
+      top_.Age();
+      recorded_ /= 2;
+    }
+  }
+
+  // Estimated number of recent occurrences of 'key', whether or not it's among the hottest.
+  std::uint32_t Estimate(const KeyType& key) const { return sketch_.Estimate(key); }
+
+  // Up to 'top_k' (as passed to the constructor) of the hottest keys, hottest first.
+  std::vector<HotKey<KeyType>> Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return top_.Top(top_k_);
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sketch_.Clear();
+    top_.Clear();
+    recorded_ = 0;
+  }
+
+  // Returns a functor which calls Record, suitable for DataBuffer::Options::lookup_observer or
+  // LruCache::SetLookupObserver.  This tracker must outlive any use of it.
+  std::function<void(const KeyType&)> Observer() {
+    return [this](const KeyType& key) { Record(key); };
+  }
+
+ private:
+  static const size_t kCountersPerKey = 4;
+
+  ConcurrentCountMinSketch<KeyType, Hash> sketch_;
+  const size_t top_k_, sample_size_;
+  size_t recorded_;
+  mutable std::mutex mutex_;
+  SpaceSaving<KeyType> top_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_HOT_KEY_TRACKER_H_
@@ -0,0 +1,300 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Interning of immutable values, in the spirit of boost::flyweight: each distinct value is held
+  once in a process-wide InternTable, and Interned<T> handles refer to it by a 32-bit ID.  Copying,
+  comparing or hashing a handle never touches the value, so a key such as Data::NameAndTypeId
+  (72 bytes) shared by several containers costs four bytes per container plus a single copy.
+
+  A value is destroyed, and its ID recycled, once the last handle referring to it is destroyed.
+  Handles may be created, copied and destroyed concurrently from any thread.  Accessing the value
+  through a handle doesn't lock.
+
+  Equality of handles is equality of the values, but operator< orders by ID rather than by value.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_INTERNED_H_
+#define MAIDSAFE_COMMON_CONTAINERS_INTERNED_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/containers/flat_hash_set.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename T, typename Hash, typename KeyEqual>
+class InternTable {
+ public:
+  using Id = std::uint32_t;
+  static const Id kNullId = 0;
+
+  InternTable() : chunks_(), mutex_(), free_ids_(), next_id_(1), hash_(), equal_(),
+                  index_(0, SlotHash(this), SlotEqual(this)) {
+    for (auto& chunk : chunks_)
+      chunk.store(nullptr, std::memory_order_relaxed);
+  }
+
+  InternTable(const InternTable&) = delete;
+  InternTable(InternTable&&) = delete;
+  InternTable& operator=(const InternTable&) = delete;
+  InternTable& operator=(InternTable&&) = delete;
+
+  ~InternTable() {
+    for (int chunk(0); chunk != kChunkCount; ++chunk) {
+      Slot* const slots(chunks_[chunk].load(std::memory_order_relaxed));
+      if (!slots)
+        break;
+      for (std::size_t i(0); i != ChunkSize(chunk); ++i) {
+        if (slots[i].in_use)
+          reinterpret_cast<T*>(&slots[i].storage)->~T();
+      }
+      delete[] slots;
+    }
+  }
+
+  // The table used by all Interned<T, Hash, KeyEqual> handles.  It is never destroyed, so handles
+  // held in other static objects remain valid during static destruction.
+  static InternTable& Shared() {
+    static InternTable* const table(new InternTable);
+    return *table;
+  }
+
+  // Returns the ID of the value equal to 'value', adding a copy of 'value' if there is none.  The
+  // caller owns one reference to the returned ID.
+  Id Acquire(const T& value) {
+    const std::uint64_t hash(hash_(value));
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The candidate is constructed first so that the index, which holds IDs only, can compare it.
+    const Id id(AllocateSlot());
+    Slot& slot(SlotAt(id));
+    new (&slot.storage) T(value);
+    slot.hash = hash;
+    slot.references.store(1, std::memory_order_relaxed);
+    std::pair<typename FlatHashSet<Id, SlotHash, SlotEqual>::iterator, bool> result;
+    try {
+      result = index_.insert(id);
+    } catch (...) {
+      FreeSlot(id);
+      throw;
+    }
+    if (result.second)
+      return id;
+    FreeSlot(id);
+    SlotAt(*result.first).references.fetch_add(1, std::memory_order_relaxed);
+    return *result.first;
+  }
+
+  void AddReference(Id id) {
+    SlotAt(id).references.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Release(Id id) {
+    Slot& slot(SlotAt(id));
+    if (slot.references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Another thread may have re-acquired the value since, or already freed it.
+    if (slot.references.load(std::memory_order_relaxed) != 0 || !slot.in_use)
+      return;
+    index_.erase(id);
+    FreeSlot(id);
+  }
+
+  const T& Get(Id id) const { return *reinterpret_cast<const T*>(&SlotAt(id).storage); }
+
+  // Number of distinct values currently held.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+  }
+
+ private:
+  struct Slot {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    std::uint64_t hash;
+    std::atomic<std::uint32_t> references;
+    bool in_use;
+  };
+
+  struct SlotHash {
+    explicit SlotHash(const InternTable* table_in) : table(table_in) {}
+    std::uint64_t operator()(Id id) const { return table->SlotAt(id).hash; }
+    const InternTable* table;
+  };
+
+  struct SlotEqual {
+    explicit SlotEqual(const InternTable* table_in) : table(table_in) {}
+    bool operator()(Id lhs, Id rhs) const {
+      return lhs == rhs || (table->SlotAt(lhs).hash == table->SlotAt(rhs).hash &&
+                            table->equal_(table->Get(lhs), table->Get(rhs)));
+    }
+    const InternTable* table;
+  };
+
+  // Slots live in chunks which never move, so that Get needn't lock.  Chunk i holds
+  // 2^(kFirstChunkBits + i) slots, and the chunks together cover every 32-bit ID.
+  static const int kFirstChunkBits = 10;
+  static const int kChunkCount = 32 - kFirstChunkBits;
+  static const Id kMaxId = ~Id(0) - ((1U << kFirstChunkBits) - 1);
+
+  static std::size_t ChunkSize(int chunk) { return std::size_t(1) << (kFirstChunkBits + chunk); }
+
+  static int HighestBit(std::uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;  // NOLINT
+    _BitScanReverse(&index, static_cast<unsigned long>(value));  // NOLINT
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(value);
+#endif
+  }
+
+  // IDs start at 1, so ID + (2^kFirstChunkBits - 1) has its highest bit set at kFirstChunkBits +
+  // the chunk index.
+  Slot& SlotAt(Id id) const {
+    assert(id != kNullId);
+    const std::uint32_t biased(id + ((1U << kFirstChunkBits) - 1));
+    const int chunk(HighestBit(biased) - kFirstChunkBits);
+    return chunks_[chunk].load(std::memory_order_acquire)[biased - (1U << HighestBit(biased))];
+  }
+
+  // Must be called with 'mutex_' held.
+  Id AllocateSlot() {
+    Id id(kNullId);
+    if (free_ids_.empty()) {
+      if (next_id_ > kMaxId)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+      const std::uint32_t biased(next_id_ + ((1U << kFirstChunkBits) - 1));
+      if (biased == (1U << HighestBit(biased))) {  // first ID of a new chunk
+        const int chunk(HighestBit(biased) - kFirstChunkBits);
+        chunks_[chunk].store(new Slot[ChunkSize(chunk)](), std::memory_order_release);
+      }
+      id = next_id_++;
+    } else {
+      id = free_ids_.back();
+      free_ids_.pop_back();
+    }
+    SlotAt(id).in_use = true;
+    return id;
+  }
+
+  // Must be called with 'mutex_' held.
+  void FreeSlot(Id id) {
+    Slot& slot(SlotAt(id));
+    reinterpret_cast<T*>(&slot.storage)->~T();
+    slot.in_use = false;
+    free_ids_.push_back(id);
+  }
+
+  mutable std::atomic<Slot*> chunks_[kChunkCount];
+  mutable std::mutex mutex_;
+  std::vector<Id> free_ids_;
+  Id next_id_;
+  Hash hash_;
+  KeyEqual equal_;
+  FlatHashSet<Id, SlotHash, SlotEqual> index_;
+};
+
+}  // namespace detail
+
+template <typename T, typename Hash = SeededHash<SipHash13>, typename KeyEqual = std::equal_to<T>>
+class Interned {
+  using Table = detail::InternTable<T, Hash, KeyEqual>;
+
+ public:
+  // A null handle, which must not be dereferenced.
+  Interned() : id_(Table::kNullId) {}
+
+  explicit Interned(const T& value) : id_(Table::Shared().Acquire(value)) {}
+
+  Interned(const Interned& other) : id_(other.id_) {
+    if (id_ != Table::kNullId)
+      Table::Shared().AddReference(id_);
+  }
+
+  Interned(Interned&& other) MAIDSAFE_NOEXCEPT : id_(other.id_) { other.id_ = Table::kNullId; }
+
+  Interned& operator=(Interned other) MAIDSAFE_NOEXCEPT {
+    std::swap(id_, other.id_);
+    return *this;
+  }
+
+  ~Interned() {
+    if (id_ != Table::kNullId)
+      Table::Shared().Release(id_);
+  }
+
+  const T& get() const { return Table::Shared().Get(id_); }
+  const T& operator*() const { return get(); }
+  const T* operator->() const { return &get(); }
+
+  bool IsNull() const { return id_ == Table::kNullId; }
+
+  // Unique among the handles' values currently held, but may be reused once a value is released.
+  std::uint32_t Id() const { return id_; }
+
+  template <typename HashAlgorithm>
+  void HashAppend(HashAlgorithm& hash) const {
+    hash(id_);
+  }
+
+  friend bool operator==(const Interned& lhs, const Interned& rhs) { return lhs.id_ == rhs.id_; }
+  friend bool operator!=(const Interned& lhs, const Interned& rhs) { return lhs.id_ != rhs.id_; }
+  friend bool operator<(const Interned& lhs, const Interned& rhs) { return lhs.id_ < rhs.id_; }
+
+  // Number of distinct values held for this type of handle.
+  static std::size_t InternedCount() { return Table::Shared().size(); }
+
+ private:
+  std::uint32_t id_;
+};
+
+}  // namespace maidsafe
+
+namespace std {
+
+template <typename T, typename Hash, typename KeyEqual>
+struct hash<maidsafe::Interned<T, Hash, KeyEqual>> {
+  std::size_t operator()(const maidsafe::Interned<T, Hash, KeyEqual>& interned) const {
+    return std::hash<std::uint32_t>()(interned.Id());
+  }
+};
+
+}  // namespace std
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_INTERNED_H_
@@ -22,7 +22,25 @@
   for keys already seen. Users can set the capacity, time_to_live or both allowing a cache that will
   not hold data too long or stay full if it's not being accessed frequently. This should allow the
   cache to not hold stale information at the cost of a check every time we add that looks
-  at the timestamp of the last entry in the list and compares this to the maps timestamp.
+  at the timestamp of the oldest entry in the list and compares this to the current time. Where
+  even that is too costly, a coarse clock can be enabled via SetClockRefreshInterval or
+  UseSharedCoarseClock, and expired entries can be evicted in batches via Purge.  Where a filter
+  has to hold very many keys and occasional false positives are acceptable, RotatingBloomFilter
+  (rotating_bloom_filter.h) needs only a couple of bytes per key.
+
+  The order in which entries are evicted is determined by the EvictionPolicy template parameter.
+  LruPolicy (the default) is defined here.  Scan-resistant alternatives (TwoQPolicy and
+  TinyLfuPolicy) are available in lru_cache_policies.h.
+
+  Get, Check and Delete also accept any "probe" type which can be compared with KeyType using
+  operator< in both directions (e.g. a const char* for a std::string key, or a
+  Data::NameAndTypeIdView for a Data::NameAndTypeId key), avoiding the construction of a temporary
+  KeyType for each lookup.  ConcurrentLruCache and PooledLruCache hash their keys, so don't support
+  this.
+
+  The Allocator template parameter (rebound as required) is used for the cache's entries and for
+  the eviction policy's usage records, e.g. an ArenaAllocator drawing on a PooledArena
+  (arena.h) so that a cache with steady churn recycles its nodes rather than going to the heap.
 
   Research links
   http://en.wikipedia.org/wiki/Cache_algorithms
@@ -34,54 +52,178 @@
 #ifndef MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_H_
 #define MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_H_
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <limits>
 #include <list>
-#include <map>
+#include <memory>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "boost/expected/expected.hpp"
+#include "boost/multi_index_container.hpp"
+#include "boost/multi_index/member.hpp"
+#include "boost/multi_index/ordered_index.hpp"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/types.h"
 
 namespace maidsafe {
 
+struct LruCacheStats {
+  std::uint64_t hits;
+  std::uint64_t misses;
+  std::uint64_t evictions;    // removed to keep within capacity (or rejected by admission policy)
+  std::uint64_t expirations;  // removed because time_to_live had elapsed
+};
+
 namespace detail {
 
 // Helper classes
 template <typename KeyType>
-using KeyOrder = std::list<KeyType>;
+struct KeyRecord {
+  KeyRecord(KeyType key_in, std::chrono::steady_clock::time_point timestamp_in)
+      : key(std::move(key_in)), timestamp(timestamp_in), segment(0) {}
+  KeyType key;
+  std::chrono::steady_clock::time_point timestamp;
+  unsigned segment;  // Used by eviction policies which split the cache into several lists
+};
+
+template <typename Allocator, typename T>
+using ReboundAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+template <typename KeyType, typename Allocator = std::allocator<KeyType>>
+using KeyOrder = std::list<KeyRecord<KeyType>, ReboundAllocator<Allocator, KeyRecord<KeyType>>>;
+
+// An eviction policy provides an 'Order' class template, taking the KeyType and an Allocator,
+// which tracks the usage of keys.  It has to provide the following interface, where all iterators
+// are into lists of type KeyOrder<KeyType, Allocator> (multiple lists may be used; iterators
+// remain valid when spliced between them):
+//   Order(size_t capacity, const Allocator& allocator);
+//   bool empty() const;
+//   Iterator Insert(const KeyType& key, std::chrono::steady_clock::time_point now);
+//   void Touch(Iterator it);   // Called for every successful Get
+//   void Erase(Iterator it);
+//   Iterator Oldest();         // Candidate for expiry checks, only called if !empty()
+//   Iterator Victim();         // Entry to evict when over capacity, only called if !empty()
+template <typename KeyType, typename Allocator>
+class LruOrder {
+ public:
+  using Iterator = typename KeyOrder<KeyType, Allocator>::iterator;
+
+  LruOrder(size_t /*capacity*/, const Allocator& allocator) : key_order_(allocator) {}
+
+  bool empty() const { return key_order_.empty(); }
+
+  Iterator Insert(const KeyType& key, std::chrono::steady_clock::time_point now) {
+    return key_order_.emplace(std::end(key_order_), key, now);
+  }
+
+  // Update access record by moving accessed key to back of list
+  void Touch(Iterator it) { key_order_.splice(std::end(key_order_), key_order_, it); }
+
+  void Erase(Iterator it) { key_order_.erase(it); }
+
+  Iterator Oldest() { return std::begin(key_order_); }
+
+  Iterator Victim() { return std::begin(key_order_); }
+
+ private:
+  KeyOrder<KeyType, Allocator> key_order_;
+};
 
 template <typename T>
 struct TypeHelper {
   using type = T;
 };
 
-template <typename KeyType, typename T>
+// Map-like entry.  'second' is mutable since multi_index_container elements are const, but only
+// 'first' participates in the ordering.
+template <typename KeyType, typename Data>
+struct StorageEntry {
+  StorageEntry(KeyType key, Data data) : first(std::move(key)), second(std::move(data)) {}
+  KeyType first;
+  mutable Data second;
+};
+
+// An ordered index is used rather than a std::map since it allows lookups by types other than
+// KeyType (std::map only supports this from C++14).
+template <typename KeyType, typename Data, typename Allocator>
+using StorageMap = boost::multi_index_container<
+    StorageEntry<KeyType, Data>,
+    boost::multi_index::indexed_by<boost::multi_index::ordered_unique<
+        boost::multi_index::member<StorageEntry<KeyType, Data>, KeyType,
+                                   &StorageEntry<KeyType, Data>::first>>>,
+    ReboundAllocator<Allocator, StorageEntry<KeyType, Data>>>;
+
+template <typename KeyType, typename T, typename Allocator>
 struct StorageType
-    : TypeHelper<std::map<KeyType, std::tuple<typename KeyOrder<KeyType>::iterator,
-                                              std::chrono::steady_clock::time_point, T>>> {};
+    : TypeHelper<StorageMap<KeyType, std::tuple<typename KeyOrder<KeyType, Allocator>::iterator, T>,
+                            Allocator>> {};
+
+template <typename KeyType, typename Allocator>
+struct StorageType<KeyType, void, Allocator>
+    : TypeHelper<StorageMap<KeyType, std::tuple<typename KeyOrder<KeyType, Allocator>::iterator>,
+                            Allocator>> {};
+
+// Comparator for lookups by a type other than KeyType
+struct TransparentLess {
+  template <typename Lhs, typename Rhs>
+  bool operator()(const Lhs& lhs, const Rhs& rhs) const {
+    return lhs < rhs;
+  }
+};
 
-template <typename KeyType>
-struct StorageType<KeyType, void>
-    : TypeHelper<std::map<KeyType, std::tuple<typename KeyOrder<KeyType>::iterator,
-                                              std::chrono::steady_clock::time_point>>> {};
+// True if Probe is a distinct type from KeyType, and values of the two types can be compared
+// using operator< in both directions.
+template <typename Probe, typename KeyType>
+struct IsTransparentProbe {
+  template <typename L, typename R>
+  static auto Check(int)  // NOLINT  - Cpplint incorrectly thinks this is a cast
+      -> decltype(std::declval<const L&>() < std::declval<const R&>(),
+                  std::declval<const R&>() < std::declval<const L&>(), std::true_type());
+
+  template <typename, typename>
+  static std::false_type Check(...);
+
+  static const bool value =
+      !std::is_same<Probe, KeyType>::value &&
+      std::is_same<decltype(Check<Probe, KeyType>(0)), std::true_type>::value;
+};
 
-// Base class providing fixed-size (by number of records) and / or time_to_live LRU-replacement
-// cache
-template <typename KeyType, typename ValueType>
+template <typename Probe, typename KeyType>
+using EnableIfTransparentProbe =
+    typename std::enable_if<IsTransparentProbe<Probe, KeyType>::value>::type;
+
+// Base class providing fixed-size (by number of records) and / or time_to_live cache, with
+// replacement determined by EvictionPolicy
+template <typename KeyType, typename ValueType, typename EvictionPolicy, typename Allocator>
 class LruCacheBase {
  public:
-  explicit LruCacheBase(size_t capacity)
-      : capacity_(capacity), time_to_live_(std::chrono::steady_clock::duration::zero()) {}
-
-  explicit LruCacheBase(std::chrono::steady_clock::duration time_to_live)
-      : capacity_(std::numeric_limits<size_t>::max()), time_to_live_(time_to_live) {}
-
-  LruCacheBase(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : capacity_(capacity), time_to_live_(time_to_live) {}
+  LruCacheBase(size_t capacity, const Allocator& allocator)
+      : LruCacheBase(capacity, std::chrono::steady_clock::duration::zero(), allocator) {}
+
+  LruCacheBase(std::chrono::steady_clock::duration time_to_live, const Allocator& allocator)
+      : LruCacheBase(std::numeric_limits<size_t>::max(), time_to_live, allocator) {}
+
+  LruCacheBase(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+               const Allocator& allocator)
+      : capacity_(capacity),
+        time_to_live_(time_to_live),
+        clock_refresh_interval_(0),
+        operations_since_refresh_(0),
+        use_shared_coarse_clock_(false),
+        cached_now_(),
+        hits_(0),
+        misses_(0),
+        evictions_(0),
+        expirations_(0),
+        key_order_(capacity, allocator),
+        storage_(typename Storage<ValueType>::ctor_args_list(), allocator) {}
 
   virtual ~LruCacheBase() = default;
   LruCacheBase(const LruCacheBase&) = delete;
@@ -89,65 +231,179 @@ class LruCacheBase {
   LruCacheBase& operator=(const LruCacheBase&) = delete;
   LruCacheBase& operator=(LruCacheBase&&) = delete;
 
-  bool Check(const KeyType& key) const { return storage_.find(key) != storage_.end(); }
+  // Counts as a lookup for the purposes of stats().hits and stats().misses
+  bool Check(const KeyType& key) const { return CheckImpl(key); }
+
+  // Lookup by any type which can be compared with KeyType via operator<, e.g. a non-owning view of
+  // the key, without having to construct a KeyType.
+  template <typename Probe, typename = EnableIfTransparentProbe<Probe, KeyType>>
+  bool Check(const Probe& key) const {
+    return CheckImpl(key);
+  }
 
   size_t size() const { return storage_.size(); }
 
+  LruCacheStats stats() const {
+    return LruCacheStats{hits_.load(std::memory_order_relaxed),
+                         misses_.load(std::memory_order_relaxed), evictions_, expirations_};
+  }
+
+  // Switches to a coarse clock: rather than reading the steady_clock on every Add, a cached time
+  // is used and only refreshed once every 'operations' calls to Add or Purge, or whenever
+  // RefreshClock is called (e.g. from a timer).  Pass std::numeric_limits<size_t>::max() to rely
+  // solely on RefreshClock, or 0 to revert to reading the clock on every operation (the default).
+  // Entry timestamps, and hence expiry, are only as accurate as the cached time.
+  void SetClockRefreshInterval(size_t operations) {
+    clock_refresh_interval_ = operations;
+    use_shared_coarse_clock_ = false;
+    RefreshClock();
+  }
+
+  // Alternatively, reads CoarseSteadyClock on every operation.  Entry timestamps are then within
+  // about kCoarseClockResolution of the real time without needing any explicit refreshing.
+  // Reverted by SetClockRefreshInterval.
+  void UseSharedCoarseClock() { use_shared_coarse_clock_ = true; }
+
+  void RefreshClock() {
+    cached_now_ = std::chrono::steady_clock::now();
+    operations_since_refresh_ = 0;
+  }
+
+  // Evicts up to 'max_items' entries whose time_to_live has expired, returning the number evicted.
+  // Expired entries are otherwise only evicted lazily by Add.
+  size_t Purge(size_t max_items = std::numeric_limits<size_t>::max()) {
+    const auto now(Now());
+    size_t purged(0);
+    while (purged < max_items && CheckTimeExpired(now)) {
+      RemoveElement(key_order_.Oldest());
+      ++expirations_;
+      ++purged;
+    }
+    return purged;
+  }
+
+  // Evicts up to 'max_items' entries chosen by the eviction policy, as if over capacity, returning
+  // the number evicted.  Used to shed memory on demand, e.g. from a MemoryBudget shrink functor.
+  size_t Evict(size_t max_items) {
+    size_t evicted(0);
+    while (evicted < max_items && !key_order_.empty()) {
+      RemoveElement(key_order_.Victim());
+      ++evictions_;
+      ++evicted;
+    }
+    return evicted;
+  }
+
  protected:
   template <typename T>
-  using Storage = typename StorageType<KeyType, T>::type;
+  using Storage = typename StorageType<KeyType, T, Allocator>::type;
+  using Order = typename EvictionPolicy::template Order<KeyType, Allocator>;
 
-  typename KeyOrder<KeyType>::iterator PrepareToAdd(const KeyType& key) {
-    if (storage_.find(key) != storage_.end())
-      return std::end(key_order_);
-    // Check if we should evict any entries because of size
-    if (storage_.size() == capacity_)
-      RemoveOldestElement();
+  template <typename Probe>
+  typename Storage<ValueType>::iterator Find(const Probe& key) const {
+    return storage_.find(key, TransparentLess());
+  }
+
+  template <typename Probe>
+  bool CheckImpl(const Probe& key) const {
+    const bool found(Find(key) != storage_.end());
+    RecordLookup(found);
+    return found;
+  }
+
+  // Adds a new entry constructed from 'key' and 'value' (which is empty for filters).  Does nothing
+  // if the key is already held.
+  template <typename... Value>
+  void AddEntry(KeyType key, Value&&... value) {
+    if (capacity_ == 0 || storage_.find(key) != storage_.end())
+      return;
     // Check if we have entries with time expired
-    while (CheckTimeExpired())  // Any old entries at beginning of the list
-      RemoveOldestElement();
+    const auto now(Now());
+    while (CheckTimeExpired(now)) {  // Any old entries at beginning of the list
+      RemoveElement(key_order_.Oldest());
+      ++expirations_;
+    }
+
+    // Record key as most-recently-used key and create the entry, linked to the usage record.
+    const auto it(key_order_.Insert(key, now));
+    storage_.emplace(std::move(key), std::make_tuple(it, std::forward<Value>(value)...));
 
-    // Record key as most-recently-used key
-    return key_order_.insert(std::end(key_order_), key);
+    // Check if we should evict any entries because of size
+    while (storage_.size() > capacity_) {
+      RemoveElement(key_order_.Victim());
+      ++evictions_;
+    }
   }
 
-  void RemoveOldestElement() {
-    assert(!key_order_.empty());
-    // Identify least recently used key
-    const auto it = storage_.find(key_order_.front());
+  void RemoveElement(typename KeyOrder<KeyType, Allocator>::iterator key_record) {
+    const auto it = storage_.find(key_record->key);
     assert(it != storage_.end());
     // Erase both elements in both containers
     storage_.erase(it);
-    key_order_.pop_front();
+    key_order_.Erase(key_record);
   }
 
-  bool CheckTimeExpired() const {
-    if (time_to_live_ == std::chrono::steady_clock::duration::zero() || storage_.empty())
+  // The timestamp is held alongside the key in 'key_order_', so no lookup in 'storage_' is needed.
+  bool CheckTimeExpired(std::chrono::steady_clock::time_point now) {
+    if (time_to_live_ == std::chrono::steady_clock::duration::zero() || key_order_.empty())
       return false;
-    auto key = storage_.find(key_order_.front());
-    assert(key != std::end(storage_) && "cannot find element");
-    return (std::get<1>(key->second) + time_to_live_) < std::chrono::steady_clock::now();
+    return (key_order_.Oldest()->timestamp + time_to_live_) < now;
+  }
+
+  std::chrono::steady_clock::time_point Now() {
+    if (use_shared_coarse_clock_)
+      return CoarseSteadyClock::now();
+    if (clock_refresh_interval_ == 0)
+      return std::chrono::steady_clock::now();
+    if (operations_since_refresh_++ >= clock_refresh_interval_)
+      RefreshClock();
+    return cached_now_;
+  }
+
+  // Check is const, so may be called concurrently; hence the lookup counters are atomic.
+  void RecordLookup(bool hit) const {
+    if (hit)
+      hits_.fetch_add(1, std::memory_order_relaxed);
+    else
+      misses_.fetch_add(1, std::memory_order_relaxed);
   }
 
   const size_t capacity_;
   const std::chrono::steady_clock::duration time_to_live_;
-  KeyOrder<KeyType> key_order_;
+  size_t clock_refresh_interval_, operations_since_refresh_;
+  bool use_shared_coarse_clock_;
+  std::chrono::steady_clock::time_point cached_now_;
+  mutable std::atomic<std::uint64_t> hits_, misses_;
+  std::uint64_t evictions_, expirations_;
+  Order key_order_;
   Storage<ValueType> storage_;
 };
 
 }  // namespace detail
 
+// Evicts the least recently used entry
+struct LruPolicy {
+  template <typename KeyType, typename Allocator>
+  using Order = detail::LruOrder<KeyType, Allocator>;
+};
+
 // Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement cache
-template <typename KeyType, typename ValueType>
-class LruCache : public detail::LruCacheBase<KeyType, ValueType> {
+template <typename KeyType, typename ValueType, typename EvictionPolicy = LruPolicy,
+          typename Allocator = std::allocator<KeyType>>
+class LruCache : public detail::LruCacheBase<KeyType, ValueType, EvictionPolicy, Allocator> {
+  using Base = detail::LruCacheBase<KeyType, ValueType, EvictionPolicy, Allocator>;
+
  public:
-  explicit LruCache(size_t capacity) : detail::LruCacheBase<KeyType, ValueType>(capacity) {}
+  explicit LruCache(size_t capacity, const Allocator& allocator = Allocator())
+      : Base(capacity, allocator) {}
 
-  explicit LruCache(std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, ValueType>(time_to_live) {}
+  explicit LruCache(std::chrono::steady_clock::duration time_to_live,
+                    const Allocator& allocator = Allocator())
+      : Base(time_to_live, allocator) {}
 
-  LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, ValueType>(capacity, time_to_live) {}
+  LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+           const Allocator& allocator = Allocator())
+      : Base(capacity, time_to_live, allocator) {}
 
   virtual ~LruCache() = default;
   LruCache(const LruCache&) = delete;
@@ -157,47 +413,116 @@ class LruCache : public detail::LruCacheBase<KeyType, ValueType> {
 
   // We do not return an iterator here and use a pair instead as we are keeping two containers in
   // sync and cannot allow access to these containers from the public interface
-  boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) {
-    const auto it = this->storage_.find(key);
+  boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) { return GetImpl(key); }
+
+  void Add(KeyType key, ValueType value) { this->AddEntry(std::move(key), std::move(value)); }
+
+  void Delete(const KeyType& key) { DeleteImpl(key); }
+
+  // Lookups by any type which can be compared with KeyType via operator< (see Check)
+  template <typename Probe, typename = detail::EnableIfTransparentProbe<Probe, KeyType>>
+  boost::expected<ValueType, maidsafe_error> Get(const Probe& key) {
+    return GetImpl(key);
+  }
+
+  template <typename Probe, typename = detail::EnableIfTransparentProbe<Probe, KeyType>>
+  void Delete(const Probe& key) {
+    DeleteImpl(key);
+  }
+
+  // Equivalent to Get, but rather than copying the value, invokes 'functor' with a const reference
+  // to it if found.  Returns true if found.  The reference must not be retained beyond the call.
+  // Alternatively, for large values, using a std::shared_ptr<const T> as the ValueType makes Get a
+  // reference count increment rather than a copy.
+  template <typename Functor>
+  bool Visit(const KeyType& key, Functor functor) {
+    return VisitImpl(key, functor);
+  }
+
+  template <typename Probe, typename Functor,
+            typename = detail::EnableIfTransparentProbe<Probe, KeyType>>
+  bool Visit(const Probe& key, Functor functor) {
+    return VisitImpl(key, functor);
+  }
+
+  // If set, 'observer' is called with the key of every Get and Visit, e.g. to track the hottest
+  // keys via HotKeyTracker::Observer().  Misses looked up by a probe type rather than KeyType are
+  // not reported.
+  void SetLookupObserver(std::function<void(const KeyType&)> observer) {
+    lookup_observer_ = std::move(observer);
+  }
+
+ private:
+  // Returns a pointer to the value (marking it as most recently used), or nullptr if not found
+  template <typename Probe>
+  const ValueType* FindValue(const Probe& key) {
+    const auto it = this->Find(key);
+    this->RecordLookup(it != this->storage_.end());
+
+    if (lookup_observer_) {
+      if (it != this->storage_.end())
+        lookup_observer_(it->first);
+      else
+        ObserveMiss(key);
+    }
 
     if (it == this->storage_.end())
-      return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+      return nullptr;
 
-    // Update access record by moving accessed key to back of list
-    this->key_order_.splice(this->key_order_.end(), this->key_order_, std::get<0>(it->second));
-    return std::get<2>(it->second);
+    this->key_order_.Touch(std::get<0>(it->second));
+    return &std::get<1>(it->second);
   }
 
-  void Add(KeyType key, ValueType value) {
-    auto it = this->PrepareToAdd(key);
-    if (it == std::end(this->key_order_))
-      return;
-    // Create the key-value entry, linked to the usage record.
-    this->storage_.insert(std::make_pair(
-        std::move(key), std::make_tuple(it, std::chrono::steady_clock::now(), std::move(value))));
+  template <typename Probe>
+  boost::expected<ValueType, maidsafe_error> GetImpl(const Probe& key) {
+    const auto value(FindValue(key));
+    if (!value)
+      return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+    return *value;
+  }
+
+  template <typename Probe, typename Functor>
+  bool VisitImpl(const Probe& key, Functor& functor) {
+    const auto value(FindValue(key));
+    if (value)
+      functor(*value);
+    return value != nullptr;
   }
 
-  void Delete(const KeyType& key) {
-    const auto it = this->storage_.find(key);
+  template <typename Probe>
+  void DeleteImpl(const Probe& key) {
+    const auto it = this->Find(key);
     if (it != this->storage_.end()) {
-      std::get<1>(it->second) = std::chrono::steady_clock::now() - this->time_to_live_;
-      this->key_order_.splice(this->key_order_.begin(), this->key_order_, std::get<0>(it->second));
-      this->RemoveOldestElement();
+      this->key_order_.Erase(std::get<0>(it->second));
+      this->storage_.erase(it);
     }
   }
+
+  void ObserveMiss(const KeyType& key) { lookup_observer_(key); }
+
+  template <typename Probe>
+  void ObserveMiss(const Probe& /*key*/) {}
+
+  std::function<void(const KeyType&)> lookup_observer_{};
 };
 
 // Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement filter
-template <typename KeyType>
-class LruCache<KeyType, void> : public detail::LruCacheBase<KeyType, void> {
+template <typename KeyType, typename EvictionPolicy, typename Allocator>
+class LruCache<KeyType, void, EvictionPolicy, Allocator>
+    : public detail::LruCacheBase<KeyType, void, EvictionPolicy, Allocator> {
+  using Base = detail::LruCacheBase<KeyType, void, EvictionPolicy, Allocator>;
+
  public:
-  explicit LruCache(size_t capacity) : detail::LruCacheBase<KeyType, void>(capacity) {}
+  explicit LruCache(size_t capacity, const Allocator& allocator = Allocator())
+      : Base(capacity, allocator) {}
 
-  explicit LruCache(std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, void>(time_to_live) {}
+  explicit LruCache(std::chrono::steady_clock::duration time_to_live,
+                    const Allocator& allocator = Allocator())
+      : Base(time_to_live, allocator) {}
 
-  LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
-      : detail::LruCacheBase<KeyType, void>(capacity, time_to_live) {}
+  LruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+           const Allocator& allocator = Allocator())
+      : Base(capacity, time_to_live, allocator) {}
 
   virtual ~LruCache() = default;
   LruCache(const LruCache&) = delete;
@@ -205,14 +530,7 @@ class LruCache<KeyType, void> : public detail::LruCacheBase<KeyType, void> {
   LruCache& operator=(const LruCache&) = delete;
   LruCache& operator=(LruCache&&) = delete;
 
-  void Add(KeyType key) {
-    auto it = this->PrepareToAdd(key);
-    if (it == std::end(this->key_order_))
-      return;
-    // Create the key entry, linked to the usage record.
-    this->storage_.insert(
-        std::make_pair(std::move(key), std::make_tuple(it, std::chrono::steady_clock::now())));
-  }
+  void Add(KeyType key) { this->AddEntry(std::move(key)); }
 };
 
 }  // namespace maidsafe
@@ -0,0 +1,242 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  Scan-resistant eviction policies for LruCache.  Pure LRU lets a single pass over a large number
+  of keys (e.g. a re-sync after churn) flush the frequently used entries from the cache.  These
+  policies instead require an entry to prove itself before it can displace established entries.
+
+  TwoQPolicy - new entries enter a FIFO probationary queue holding up to a quarter of the capacity,
+  and are only moved to the main LRU queue when hit again.  Entries evicted from the probationary
+  queue are remembered (keys only) in a "ghost" queue; a key which is re-added while remembered
+  goes straight into the main queue.  A scan therefore only ever displaces probationary entries.
+
+  TinyLfuPolicy - W-TinyLFU.  New entries enter a small LRU window (1% of capacity).  Entries
+  leaving the window join the probationary segment of a segmented LRU main area and must have a
+  higher estimated access frequency than the probationary segment's LRU entry to stay in the cache.
+  A hit in the probationary segment promotes the entry to the protected segment (80% of the main
+  area).  Access frequencies are estimated by a CountMinSketch.  Only meaningful for caches with a
+  capacity.
+
+  Research links
+  http://www.vldb.org/conf/1994/P439.PDF (2Q: A Low Overhead High Performance Buffer Management
+                                          Replacement Algorithm)
+  http://arxiv.org/abs/1512.00727 (TinyLFU: A Highly Efficient Cache Admission Policy)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_POLICIES_H_
+#define MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_POLICIES_H_
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <utility>
+
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/containers/count_min_sketch.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+template <typename Iterator>
+Iterator OldestOf(Iterator lhs, Iterator rhs) {
+  return rhs->timestamp < lhs->timestamp ? rhs : lhs;
+}
+
+template <typename KeyType, typename Allocator>
+class TwoQOrder {
+ public:
+  using Iterator = typename KeyOrder<KeyType, Allocator>::iterator;
+
+  TwoQOrder(size_t capacity, const Allocator& allocator)
+      : in_capacity_(std::max<size_t>(1, capacity / 4)),
+        ghost_capacity_(std::max<size_t>(1, capacity / 2)),
+        in_(allocator),
+        main_(allocator),
+        ghosts_(allocator),
+        ghost_index_(std::less<KeyType>(), allocator) {}
+
+  bool empty() const { return in_.empty() && main_.empty(); }
+
+  Iterator Insert(const KeyType& key, std::chrono::steady_clock::time_point now) {
+    const auto ghost(ghost_index_.find(key));
+    if (ghost == std::end(ghost_index_))
+      return in_.emplace(std::end(in_), key, now);
+    ghosts_.erase(ghost->second);
+    ghost_index_.erase(ghost);
+    const auto it(main_.emplace(std::end(main_), key, now));
+    it->segment = kMain;
+    return it;
+  }
+
+  void Touch(Iterator it) {
+    main_.splice(std::end(main_), List(it), it);
+    it->segment = kMain;
+  }
+
+  void Erase(Iterator it) { List(it).erase(it); }
+
+  Iterator Oldest() {
+    if (in_.empty())
+      return std::begin(main_);
+    return main_.empty() ? std::begin(in_) : OldestOf(std::begin(in_), std::begin(main_));
+  }
+
+  Iterator Victim() {
+    if (in_.empty() || (in_.size() <= in_capacity_ && !main_.empty()))
+      return std::begin(main_);
+    const auto victim(std::begin(in_));
+    RememberGhost(victim->key);
+    return victim;
+  }
+
+ private:
+  enum Segment : unsigned { kIn = 0, kMain = 1 };
+
+  KeyOrder<KeyType, Allocator>& List(Iterator it) { return it->segment == kMain ? main_ : in_; }
+
+  void RememberGhost(const KeyType& key) {
+    if (ghost_index_.count(key))
+      return;
+    ghost_index_.insert(std::make_pair(key, ghosts_.insert(std::end(ghosts_), key)));
+    if (ghosts_.size() > ghost_capacity_) {
+      ghost_index_.erase(ghosts_.front());
+      ghosts_.pop_front();
+    }
+  }
+
+  const size_t in_capacity_, ghost_capacity_;
+  using Ghosts = std::list<KeyType, ReboundAllocator<Allocator, KeyType>>;
+  using GhostIndexEntry = std::pair<const KeyType, typename Ghosts::iterator>;
+
+  KeyOrder<KeyType, Allocator> in_, main_;
+  Ghosts ghosts_;
+  std::map<KeyType, typename Ghosts::iterator, std::less<KeyType>,
+           ReboundAllocator<Allocator, GhostIndexEntry>> ghost_index_;
+};
+
+template <typename KeyType, typename Hash, typename Allocator>
+class TinyLfuOrder {
+ public:
+  using Iterator = typename KeyOrder<KeyType, Allocator>::iterator;
+
+  TinyLfuOrder(size_t capacity, const Allocator& allocator)
+      : window_capacity_(std::max<size_t>(1, capacity / 100)),
+        protected_capacity_(((capacity > window_capacity_) ? capacity - window_capacity_ : 0) / 5 *
+                            4),
+        sketch_(std::min<size_t>(std::max<size_t>(16, capacity), 1 << 20)),
+        window_(allocator),
+        probation_(allocator),
+        protected_(allocator) {}
+
+  bool empty() const { return window_.empty() && probation_.empty() && protected_.empty(); }
+
+  Iterator Insert(const KeyType& key, std::chrono::steady_clock::time_point now) {
+    sketch_.Increment(key);
+    const auto it(window_.emplace(std::end(window_), key, now));
+    if (window_.size() > window_capacity_) {
+      // Move the window's LRU entry to the back of the probationary segment, where it will be the
+      // admission candidate if the cache is over capacity.
+      const auto candidate(std::begin(window_));
+      candidate->segment = kProbation;
+      probation_.splice(std::end(probation_), window_, candidate);
+    }
+    return it;
+  }
+
+  void Touch(Iterator it) {
+    sketch_.Increment(it->key);
+    switch (it->segment) {
+      case kWindow:
+        window_.splice(std::end(window_), window_, it);
+        break;
+      case kProbation:
+        it->segment = kProtected;
+        protected_.splice(std::end(protected_), probation_, it);
+        if (protected_.size() > protected_capacity_) {
+          const auto demoted(std::begin(protected_));
+          demoted->segment = kProbation;
+          probation_.splice(std::end(probation_), protected_, demoted);
+        }
+        break;
+      default:
+        protected_.splice(std::end(protected_), protected_, it);
+        break;
+    }
+  }
+
+  void Erase(Iterator it) { List(it).erase(it); }
+
+  Iterator Oldest() {
+    Iterator oldest;
+    bool found(false);
+    for (auto list : {&window_, &probation_, &protected_}) {
+      if (list->empty())
+        continue;
+      oldest = found ? OldestOf(oldest, std::begin(*list)) : std::begin(*list);
+      found = true;
+    }
+    return oldest;
+  }
+
+  Iterator Victim() {
+    if (probation_.size() > 1) {
+      // The newest probationary entry is only admitted if it is more popular than the oldest.
+      const auto candidate(std::prev(std::end(probation_)));
+      const auto victim(std::begin(probation_));
+      return sketch_.Estimate(candidate->key) > sketch_.Estimate(victim->key) ? victim : candidate;
+    }
+    if (!probation_.empty())
+      return std::begin(probation_);
+    return protected_.empty() ? std::begin(window_) : std::begin(protected_);
+  }
+
+ private:
+  enum Segment : unsigned { kWindow = 0, kProbation = 1, kProtected = 2 };
+
+  KeyOrder<KeyType, Allocator>& List(Iterator it) {
+    return it->segment == kWindow ? window_ : (it->segment == kProbation ? probation_ : protected_);
+  }
+
+  const size_t window_capacity_, protected_capacity_;
+  CountMinSketch<KeyType, Hash> sketch_;
+  KeyOrder<KeyType, Allocator> window_, probation_, protected_;
+};
+
+}  // namespace detail
+
+// 2Q replacement (see above)
+struct TwoQPolicy {
+  template <typename KeyType, typename Allocator>
+  using Order = detail::TwoQOrder<KeyType, Allocator>;
+};
+
+// W-TinyLFU replacement (see above).  KeyType must be hashable by Hash.
+template <typename Hash = SeededHash<SipHash13>>
+struct TinyLfuPolicy {
+  template <typename KeyType, typename Allocator>
+  using Order = detail::TinyLfuOrder<KeyType, Hash, Allocator>;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_LRU_CACHE_POLICIES_H_
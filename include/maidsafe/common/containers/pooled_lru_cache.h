@@ -0,0 +1,331 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  An alternative to LruCache with the same interface and the same capacity / time_to_live
+  semantics, but with a more compact storage layout.  Each entry is a single intrusive node holding
+  the key, timestamp, value and the LRU list links.  Nodes are allocated from a slab pool and
+  indexed by an open-addressing (linear probing) hash table, so an entry costs one allocation
+  amortised over a whole slab and stores its key only once.  Lookups are O(1).
+
+  Unlike LruCache, KeyType must be equality comparable and hashable by the Hash functor (by default
+  SeededHash<SipHash13>), rather than less-than comparable.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_POOLED_LRU_CACHE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_POOLED_LRU_CACHE_H_
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "boost/expected/expected.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/slab_pool.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+struct PooledLruLinks {
+  PooledLruLinks* prev;
+  PooledLruLinks* next;
+};
+
+template <typename KeyType, typename ValueType>
+struct PooledLruNode : PooledLruLinks {
+  template <typename Value>
+  PooledLruNode(KeyType key_in, std::uint64_t hash_in,
+                std::chrono::steady_clock::time_point timestamp_in, Value&& value_in)
+      : PooledLruLinks(),
+        key(std::move(key_in)),
+        hash(hash_in),
+        timestamp(timestamp_in),
+        value(std::forward<Value>(value_in)) {}
+  KeyType key;
+  std::uint64_t hash;
+  std::chrono::steady_clock::time_point timestamp;
+  ValueType value;
+};
+
+template <typename KeyType>
+struct PooledLruNode<KeyType, void> : PooledLruLinks {
+  PooledLruNode(KeyType key_in, std::uint64_t hash_in,
+                std::chrono::steady_clock::time_point timestamp_in)
+      : PooledLruLinks(), key(std::move(key_in)), hash(hash_in), timestamp(timestamp_in) {}
+  KeyType key;
+  std::uint64_t hash;
+  std::chrono::steady_clock::time_point timestamp;
+};
+
+// Base class providing the pooled storage, the hash index and the intrusive LRU list
+template <typename KeyType, typename ValueType, typename Hash>
+class PooledLruCacheBase {
+ public:
+  explicit PooledLruCacheBase(size_t capacity)
+      : PooledLruCacheBase(capacity, std::chrono::steady_clock::duration::zero()) {}
+
+  explicit PooledLruCacheBase(std::chrono::steady_clock::duration time_to_live)
+      : PooledLruCacheBase(std::numeric_limits<size_t>::max(), time_to_live) {}
+
+  PooledLruCacheBase(size_t capacity, std::chrono::steady_clock::duration time_to_live)
+      : capacity_(capacity),
+        time_to_live_(time_to_live),
+        hash_(),
+        pool_(SlabSize(capacity)),
+        slots_(kInitialSlotCount),
+        list_(),
+        size_(0) {
+    list_.prev = list_.next = &list_;
+  }
+
+  virtual ~PooledLruCacheBase() {
+    while (size_ != 0)
+      Remove(Oldest());
+  }
+
+  PooledLruCacheBase(const PooledLruCacheBase&) = delete;
+  PooledLruCacheBase(PooledLruCacheBase&&) = delete;
+  PooledLruCacheBase& operator=(const PooledLruCacheBase&) = delete;
+  PooledLruCacheBase& operator=(PooledLruCacheBase&&) = delete;
+
+  bool Check(const KeyType& key) const { return Find(key) != nullptr; }
+
+  size_t size() const { return size_; }
+
+ protected:
+  using Node = PooledLruNode<KeyType, ValueType>;
+
+  Node* Find(const KeyType& key) const {
+    const size_t index(FindSlot(key, hash_(key)));
+    return index == kNotFound ? nullptr : slots_[index].node;
+  }
+
+  // Equivalent of LruCacheBase::PrepareToAdd followed by the insertion.  Does nothing if the key
+  // is already present.
+  template <typename... Value>
+  void Insert(KeyType key, Value&&... value) {
+    const std::uint64_t hash(hash_(key));
+    if (capacity_ == 0 || FindSlot(key, hash) != kNotFound)
+      return;
+    // Check if we should evict any entries because of size
+    if (size_ == capacity_)
+      Remove(Oldest());
+    // Check if we have entries with time expired
+    while (CheckTimeExpired())  // Any old entries at beginning of the list
+      Remove(Oldest());
+
+    if ((size_ + 1) * 4 > slots_.size() * 3)
+      Rehash(slots_.size() * 2);
+    Node* node(pool_.Construct(std::move(key), hash, std::chrono::steady_clock::now(),
+                               std::forward<Value>(value)...));
+    LinkAtBack(node);
+    const size_t mask(slots_.size() - 1);
+    size_t i(static_cast<size_t>(hash) & mask);
+    while (slots_[i].node)
+      i = (i + 1) & mask;
+    slots_[i].hash = hash;
+    slots_[i].node = node;
+    ++size_;
+  }
+
+  // Records 'node' as the most-recently-used entry
+  void MoveToBack(Node* node) {
+    Unlink(node);
+    LinkAtBack(node);
+  }
+
+  void Remove(Node* node) {
+    assert(node);
+    EraseSlot(FindSlot(node));
+    Unlink(node);
+    pool_.Destroy(node);
+    --size_;
+  }
+
+  Node* Oldest() const {
+    assert(size_ != 0);
+    return static_cast<Node*>(list_.next);
+  }
+
+  bool CheckTimeExpired() const {
+    if (time_to_live_ == std::chrono::steady_clock::duration::zero() || size_ == 0)
+      return false;
+    return (Oldest()->timestamp + time_to_live_) < std::chrono::steady_clock::now();
+  }
+
+ private:
+  struct Slot {
+    Slot() : hash(0), node(nullptr) {}
+    std::uint64_t hash;
+    Node* node;
+  };
+
+  static const size_t kInitialSlotCount = 16;
+  static const size_t kNotFound = std::numeric_limits<size_t>::max();
+
+  // Small caches get a single slab sized to their capacity; larger ones grow 1024 nodes at a time.
+  static size_t SlabSize(size_t capacity) {
+    return capacity == 0 ? 1 : (capacity < 1024 ? capacity : 1024);
+  }
+
+  size_t FindSlot(const KeyType& key, std::uint64_t hash) const {
+    const size_t mask(slots_.size() - 1);
+    for (size_t i(static_cast<size_t>(hash) & mask); slots_[i].node; i = (i + 1) & mask) {
+      if (slots_[i].hash == hash && slots_[i].node->key == key)
+        return i;
+    }
+    return kNotFound;
+  }
+
+  size_t FindSlot(const Node* node) const {
+    const size_t mask(slots_.size() - 1);
+    size_t i(static_cast<size_t>(node->hash) & mask);
+    while (slots_[i].node != node) {
+      assert(slots_[i].node && "cannot find element");
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  // Backward-shift deletion: closes the gap left at 'index' so that no tombstones are required.
+  void EraseSlot(size_t index) {
+    const size_t mask(slots_.size() - 1);
+    size_t next(index);
+    for (;;) {
+      next = (next + 1) & mask;
+      if (!slots_[next].node)
+        break;
+      const size_t ideal(static_cast<size_t>(slots_[next].hash) & mask);
+      // Leave the entry in place if its ideal slot lies cyclically in (index, next]
+      const bool in_place(index <= next ? (index < ideal && ideal <= next)
+                                        : (index < ideal || ideal <= next));
+      if (in_place)
+        continue;
+      slots_[index] = slots_[next];
+      index = next;
+    }
+    slots_[index] = Slot();
+  }
+
+  void Rehash(size_t slot_count) {
+    std::vector<Slot> old_slots(slot_count);
+    old_slots.swap(slots_);
+    const size_t mask(slots_.size() - 1);
+    for (const auto& slot : old_slots) {
+      if (!slot.node)
+        continue;
+      size_t i(static_cast<size_t>(slot.hash) & mask);
+      while (slots_[i].node)
+        i = (i + 1) & mask;
+      slots_[i] = slot;
+    }
+  }
+
+  void LinkAtBack(PooledLruLinks* node) {
+    node->prev = list_.prev;
+    node->next = &list_;
+    list_.prev->next = node;
+    list_.prev = node;
+  }
+
+  static void Unlink(PooledLruLinks* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+  }
+
+  const size_t capacity_;
+  const std::chrono::steady_clock::duration time_to_live_;
+  const Hash hash_;
+  SlabPool<Node> pool_;
+  std::vector<Slot> slots_;
+  PooledLruLinks list_;  // sentinel: list_.next is least recently used, list_.prev most recently
+  size_t size_;
+};
+
+}  // namespace detail
+
+// Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement cache
+template <typename KeyType, typename ValueType, typename Hash = SeededHash<SipHash13>>
+class PooledLruCache : public detail::PooledLruCacheBase<KeyType, ValueType, Hash> {
+  using Base = detail::PooledLruCacheBase<KeyType, ValueType, Hash>;
+
+ public:
+  explicit PooledLruCache(size_t capacity) : Base(capacity) {}
+
+  explicit PooledLruCache(std::chrono::steady_clock::duration time_to_live) : Base(time_to_live) {}
+
+  PooledLruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
+      : Base(capacity, time_to_live) {}
+
+  virtual ~PooledLruCache() = default;
+  PooledLruCache(const PooledLruCache&) = delete;
+  PooledLruCache(PooledLruCache&&) = delete;
+  PooledLruCache& operator=(const PooledLruCache&) = delete;
+  PooledLruCache& operator=(PooledLruCache&&) = delete;
+
+  boost::expected<ValueType, maidsafe_error> Get(const KeyType& key) {
+    const auto node(this->Find(key));
+    if (!node)
+      return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+    this->MoveToBack(node);
+    return node->value;
+  }
+
+  void Add(KeyType key, ValueType value) { this->Insert(std::move(key), std::move(value)); }
+
+  void Delete(const KeyType& key) {
+    const auto node(this->Find(key));
+    if (node)
+      this->Remove(node);
+  }
+};
+
+// Class providing fixed-size (by number of records) and / or time_to_live LRU-replacement filter
+template <typename KeyType, typename Hash>
+class PooledLruCache<KeyType, void, Hash> : public detail::PooledLruCacheBase<KeyType, void, Hash> {
+  using Base = detail::PooledLruCacheBase<KeyType, void, Hash>;
+
+ public:
+  explicit PooledLruCache(size_t capacity) : Base(capacity) {}
+
+  explicit PooledLruCache(std::chrono::steady_clock::duration time_to_live) : Base(time_to_live) {}
+
+  PooledLruCache(size_t capacity, std::chrono::steady_clock::duration time_to_live)
+      : Base(capacity, time_to_live) {}
+
+  virtual ~PooledLruCache() = default;
+  PooledLruCache(const PooledLruCache&) = delete;
+  PooledLruCache(PooledLruCache&&) = delete;
+  PooledLruCache& operator=(const PooledLruCache&) = delete;
+  PooledLruCache& operator=(PooledLruCache&&) = delete;
+
+  void Add(KeyType key) { this->Insert(std::move(key)); }
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_POOLED_LRU_CACHE_H_
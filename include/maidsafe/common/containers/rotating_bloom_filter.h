@@ -0,0 +1,183 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A compact, approximate alternative to LruCache<KeyType, void> for use as a duplicate filter over a
+  time window.  Keys are held in two generations of blocked Bloom filter: Add inserts into the
+  current generation, and Check looks in both.  When the current generation is older than
+  time_to_live (or has had 'capacity' keys added), it becomes the previous generation and a fresh
+  one is started.  So a key is reported as present for at least time_to_live after being added (as
+  long as no more than 'capacity' keys are added per time_to_live), and at most twice that.
+
+  Check never gives a false negative within that window, but can give a false positive with about
+  the probability passed to the constructor.  Each generation uses about 1.3 bytes per key of
+  capacity at the default rate of 1%, and all of a key's bits lie in a single 64-byte block, so Add
+  and Check each cost one hash and a block access per generation.  Unlike LruCache it doesn't
+  support enumeration or deletion of keys.
+
+  This class is not thread-safe.
+
+  Research links
+  http://en.wikipedia.org/wiki/Bloom_filter
+  http://algo2.iti.kit.edu/documents/cacheefficientbloomfilters-jea.pdf (blocked Bloom filters)
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
+#define MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "maidsafe/common/hash.h"
+
+namespace maidsafe {
+
+template <typename KeyType, typename Hash = SeededHash<SipHash13>>
+class RotatingBloomFilter {
+ public:
+  // 'capacity' is the number of keys expected to be added per 'time_to_live'.
+  RotatingBloomFilter(size_t capacity, std::chrono::steady_clock::duration time_to_live,
+                      double false_positive_rate = 0.01)
+      : hash_(),
+        capacity_(std::max(capacity, size_t(1))),
+        time_to_live_(time_to_live),
+        bits_per_key_(BitsPerKey(false_positive_rate)),
+        block_count_(BlockCount(capacity_, false_positive_rate)),
+        current_(block_count_ * kWordsPerBlock, 0),
+        previous_(block_count_ * kWordsPerBlock, 0),
+        current_start_(std::chrono::steady_clock::now()),
+        current_count_(0) {}
+
+  RotatingBloomFilter(const RotatingBloomFilter&) = delete;
+  RotatingBloomFilter(RotatingBloomFilter&&) = delete;
+  RotatingBloomFilter& operator=(const RotatingBloomFilter&) = delete;
+  RotatingBloomFilter& operator=(RotatingBloomFilter&&) = delete;
+
+  void Add(const KeyType& key) {
+    const auto now(std::chrono::steady_clock::now());
+    const auto age(now - current_start_);
+    if (age >= 2 * time_to_live_) {
+      Clear(now);
+    } else if (age >= time_to_live_ || current_count_ >= capacity_) {
+      Rotate(now);
+    }
+    const Probe probe(MakeProbe(key));
+    std::uint64_t* const block(&current_[probe.block * kWordsPerBlock]);
+    for (unsigned i(0); i < bits_per_key_; ++i) {
+      const unsigned bit(probe.Bit(i));
+      block[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+    ++current_count_;
+  }
+
+  // Returns true if 'key' has probably been added within the time window.
+  bool Check(const KeyType& key) const {
+    const auto age(std::chrono::steady_clock::now() - current_start_);
+    if (age >= 2 * time_to_live_)
+      return false;
+    const Probe probe(MakeProbe(key));
+    if (Contains(current_, probe))
+      return true;
+    // Once the current generation has expired the previous one has too, although they are only
+    // rotated by the next Add.
+    return age < time_to_live_ && Contains(previous_, probe);
+  }
+
+  void Clear() { Clear(std::chrono::steady_clock::now()); }
+
+  size_t capacity() const { return capacity_; }
+  std::chrono::steady_clock::duration time_to_live() const { return time_to_live_; }
+  // Total memory used by both generations' bit arrays.
+  size_t size_in_bytes() const { return 2 * block_count_ * kWordsPerBlock * sizeof(std::uint64_t); }
+
+ private:
+  static const size_t kWordsPerBlock = 8;  // 512 bits, i.e. one 64-byte cache line
+  static const unsigned kBitsPerBlock = 512;
+
+  // Selects a block from the upper 32 bits of the hash, then derives each bit within the block
+  // from the lower 32 bits (Kirsch-Mitzenmacher double hashing).
+  struct Probe {
+    unsigned Bit(unsigned i) const { return (first + i * step) % kBitsPerBlock; }
+    size_t block;
+    unsigned first, step;
+  };
+
+  static unsigned BitsPerKey(double false_positive_rate) {
+    const double rate(std::min(std::max(false_positive_rate, 1e-6), 0.5));
+    return static_cast<unsigned>(std::max(1.0, std::round(-std::log2(rate))));
+  }
+
+  // Uses the optimal number of bits for a standard Bloom filter (-n.ln(p)/ln(2)^2), plus 10% to
+  // offset the slightly higher false positive rate caused by confining each key to one block.
+  static size_t BlockCount(size_t capacity, double false_positive_rate) {
+    const double rate(std::min(std::max(false_positive_rate, 1e-6), 0.5));
+    const double bits(1.1 * static_cast<double>(capacity) * -std::log(rate) /
+                      (std::log(2.0) * std::log(2.0)));
+    return std::max(size_t(1), static_cast<size_t>(std::ceil(bits / kBitsPerBlock)));
+  }
+
+  Probe MakeProbe(const KeyType& key) const {
+    const std::uint64_t hash(hash_(key));
+    Probe probe;
+    // Maps the upper 32 bits onto [0, block_count_) without a division.
+    probe.block = static_cast<size_t>(((hash >> 32) * block_count_) >> 32);
+    probe.first = static_cast<unsigned>(hash & 0xffff);
+    probe.step = static_cast<unsigned>((hash >> 16) & 0xffff) | 1;
+    return probe;
+  }
+
+  bool Contains(const std::vector<std::uint64_t>& generation, const Probe& probe) const {
+    const std::uint64_t* const block(&generation[probe.block * kWordsPerBlock]);
+    for (unsigned i(0); i < bits_per_key_; ++i) {
+      const unsigned bit(probe.Bit(i));
+      if ((block[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  void Rotate(std::chrono::steady_clock::time_point now) {
+    previous_.swap(current_);
+    std::fill(std::begin(current_), std::end(current_), 0);
+    current_start_ = now;
+    current_count_ = 0;
+  }
+
+  void Clear(std::chrono::steady_clock::time_point now) {
+    std::fill(std::begin(previous_), std::end(previous_), 0);
+    std::fill(std::begin(current_), std::end(current_), 0);
+    current_start_ = now;
+    current_count_ = 0;
+  }
+
+  const Hash hash_;
+  const size_t capacity_;
+  const std::chrono::steady_clock::duration time_to_live_;
+  const unsigned bits_per_key_;
+  const size_t block_count_;
+  std::vector<std::uint64_t> current_, previous_;
+  std::chrono::steady_clock::time_point current_start_;
+  size_t current_count_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_ROTATING_BLOOM_FILTER_H_
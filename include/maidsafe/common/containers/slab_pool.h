@@ -0,0 +1,95 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_SLAB_POOL_H_
+#define MAIDSAFE_COMMON_CONTAINERS_SLAB_POOL_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace maidsafe {
+
+namespace detail {
+
+// Allocates objects of type T from fixed-size slabs, recycling destroyed objects' slots through a
+// free list.  Slabs are only released when the pool is destroyed.  All objects constructed via the
+// pool must have been destroyed via the pool before the pool itself is destroyed.
+template <typename T>
+class SlabPool {
+ public:
+  explicit SlabPool(size_t slab_size = 256) : slab_size_(slab_size), slabs_(), free_list_(nullptr) {
+    assert(slab_size_ != 0);
+  }
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool(SlabPool&&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+  SlabPool& operator=(SlabPool&&) = delete;
+
+  template <typename... Args>
+  T* Construct(Args&&... args) {
+    if (!free_list_)
+      Grow();
+    Slot* slot(free_list_);
+    free_list_ = slot->next;
+    try {
+      return new (&slot->storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+      slot->next = free_list_;
+      free_list_ = slot;
+      throw;
+    }
+  }
+
+  void Destroy(T* object) {
+    object->~T();
+    Slot* slot(reinterpret_cast<Slot*>(object));
+    slot->next = free_list_;
+    free_list_ = slot;
+  }
+
+ private:
+  union Slot {
+    Slot* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  void Grow() {
+    std::unique_ptr<Slot[]> slab(new Slot[slab_size_]);
+    for (size_t i(slab_size_); i > 0; --i) {
+      slab[i - 1].next = free_list_;
+      free_list_ = &slab[i - 1];
+    }
+    slabs_.push_back(std::move(slab));
+  }
+
+  const size_t slab_size_;
+  std::vector<std::unique_ptr<Slot[]>> slabs_;
+  Slot* free_list_;
+};
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_SLAB_POOL_H_
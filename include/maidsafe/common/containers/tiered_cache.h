@@ -0,0 +1,289 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A two-tier cache: an in-memory LruCache (L1) in front of a persistent store (L2), e.g. a
+  DataBuffer (see DataBufferStore) or a table accessed via the sqlite wrapper, replacing ad hoc
+  "check the cache, then the disk, then the network" lookups.
+
+  Get looks in L1, then reads through to L2, then (if given) calls a loader such as a network
+  fetch.  Values found in L2 are promoted to L1; values loaded are added to L1 and written back to
+  L2.  Concurrent Gets for a key missing from L1 are coalesced, so L2 and the loader are only asked
+  once and every caller receives that single result.  Add puts a value in L1 and writes it back.
+  Write-backs run via the executor given at construction (or on the calling thread if it's null),
+  so callers don't wait on disk; their failures are counted rather than reported.  A serial
+  executor should be used if the order of writes to the same key matters.
+
+  All functions are thread-safe.  L1 is guarded by a single mutex, which isn't held while L2 or the
+  loader is accessed.  The store's functors must remain valid until every pending write-back has
+  run.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_TIERED_CACHE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_TIERED_CACHE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "boost/expected/expected.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/containers/lru_cache.h"
+
+namespace maidsafe {
+
+struct TieredCacheStats {
+  std::uint64_t l1_hits;
+  std::uint64_t l2_hits;     // read from L2 and promoted to L1
+  std::uint64_t loads;       // calls to a loader
+  std::uint64_t misses;      // found nowhere
+  std::uint64_t coalesced;   // Gets which waited for another caller's lookup of the same key
+  std::uint64_t write_backs;
+  std::uint64_t failed_write_backs;
+};
+
+template <typename KeyType, typename ValueType>
+class TieredCache {
+ public:
+  using Result = boost::expected<ValueType, maidsafe_error>;
+  using Loader = std::function<Result(const KeyType&)>;
+  using Executor = std::function<void(std::function<void()>)>;
+
+  // The persistent tier.  'get' should return CommonErrors::no_such_element for a key it doesn't
+  // hold; any error or exception from it is treated as a miss.  'put' and 'erase' may throw.
+  struct Store {
+    std::function<Result(const KeyType&)> get;
+    std::function<void(const KeyType&, const ValueType&)> put;
+    std::function<void(const KeyType&)> erase;
+  };
+
+  // 'capacity' and 'time_to_live' apply to L1, as for LruCache.
+  TieredCache(size_t capacity, std::chrono::steady_clock::duration time_to_live, Store store,
+              Executor executor = nullptr)
+      : mutex_(),
+        l1_(capacity, time_to_live),
+        store_(std::move(store)),
+        executor_(std::move(executor)),
+        in_flight_(),
+        counters_(std::make_shared<Counters>()) {}
+
+  TieredCache(const TieredCache&) = delete;
+  TieredCache(TieredCache&&) = delete;
+  TieredCache& operator=(const TieredCache&) = delete;
+  TieredCache& operator=(TieredCache&&) = delete;
+
+  // Returns CommonErrors::no_such_element if 'key' is in neither tier and 'loader' is null or
+  // fails.  Exceptions thrown by 'loader' propagate to every caller waiting on it.
+  Result Get(const KeyType& key, const Loader& loader = nullptr);
+
+  void Add(KeyType key, ValueType value);
+  // Removes 'key' from both tiers.  The L2 erasure is done on the calling thread, so that a
+  // subsequent Get can't read the old value back.  A lookup of 'key' which is in progress still
+  // completes with whatever it finds, but doesn't add that to L1 or write it back.
+  void Delete(const KeyType& key);
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return l1_.size();
+  }
+
+  TieredCacheStats stats() const;
+
+ private:
+  struct Counters {
+    Counters()
+        : l1_hits(0), l2_hits(0), loads(0), misses(0), coalesced(0), write_backs(0),
+          failed_write_backs(0) {}
+    std::atomic<std::uint64_t> l1_hits, l2_hits, loads, misses, coalesced, write_backs,
+        failed_write_backs;
+  };
+
+  struct Lookup {
+    explicit Lookup(std::shared_future<Result> result_in)
+        : result(std::move(result_in)), invalidated(false) {}
+    std::shared_future<Result> result;
+    // Set if the key is added or deleted while being looked up, so the result is stale.
+    bool invalidated;
+  };
+
+  // Sets 'loaded' if the result came from 'loader' rather than L2.
+  Result Load(const KeyType& key, const Loader& loader, bool& loaded);
+  void WriteBack(const KeyType& key, const ValueType& value);
+
+  mutable std::mutex mutex_;
+  LruCache<KeyType, ValueType> l1_;
+  const Store store_;
+  const Executor executor_;
+  std::map<KeyType, Lookup> in_flight_;
+  // Shared with pending write-backs.
+  std::shared_ptr<Counters> counters_;
+};
+
+// Adapts a DataBuffer (or anything with the same Get, Store and TryDelete functions) as the store
+// of a TieredCache, e.g. DataBufferStore<DataBuffer::KeyType, NonEmptyString>(buffer).  'buffer'
+// must outlive the cache and its pending write-backs.
+template <typename KeyType, typename ValueType, typename Buffer>
+typename TieredCache<KeyType, ValueType>::Store DataBufferStore(Buffer& buffer) {
+  typename TieredCache<KeyType, ValueType>::Store store;
+  store.get = [&buffer](const KeyType& key) -> boost::expected<ValueType, maidsafe_error> {
+    try {
+      return buffer.Get(key);
+    } catch (const maidsafe_error& error) {
+      return boost::make_unexpected(error);
+    }
+  };
+  store.put = [&buffer](const KeyType& key, const ValueType& value) { buffer.Store(key, value); };
+  store.erase = [&buffer](const KeyType& key) { buffer.TryDelete(key); };
+  return store;
+}
+
+template <typename KeyType, typename ValueType>
+typename TieredCache<KeyType, ValueType>::Result TieredCache<KeyType, ValueType>::Get(
+    const KeyType& key, const Loader& loader) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto value(l1_.Get(key));
+  if (value) {
+    ++counters_->l1_hits;
+    return value;
+  }
+  auto itr(in_flight_.find(key));
+  if (itr != in_flight_.end()) {
+    ++counters_->coalesced;
+    std::shared_future<Result> result(itr->second.result);
+    lock.unlock();
+    return result.get();
+  }
+  std::promise<Result> promise;
+  in_flight_.emplace(key, Lookup(promise.get_future().share()));
+  lock.unlock();
+
+  // Whatever the outcome, the lookup must be removed and its waiters released.
+  bool loaded(false);
+  Result result(boost::make_unexpected(MakeError(CommonErrors::no_such_element)));
+  try {
+    result = Load(key, loader, loaded);
+  } catch (...) {
+    lock.lock();
+    in_flight_.erase(key);
+    lock.unlock();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  lock.lock();
+  itr = in_flight_.find(key);
+  const bool stale(itr->second.invalidated);
+  if (result && !stale)
+    l1_.Add(key, *result);
+  in_flight_.erase(itr);
+  lock.unlock();
+  if (loaded && result && !stale)
+    WriteBack(key, *result);
+  promise.set_value(result);
+  return result;
+}
+
+template <typename KeyType, typename ValueType>
+typename TieredCache<KeyType, ValueType>::Result TieredCache<KeyType, ValueType>::Load(
+    const KeyType& key, const Loader& loader, bool& loaded) {
+  try {
+    Result result(store_.get(key));
+    if (result) {
+      ++counters_->l2_hits;
+      return result;
+    }
+  } catch (const std::exception&) {
+    // An unreadable L2 entry is no worse than a missing one, as long as there's a loader.
+  }
+  if (!loader) {
+    ++counters_->misses;
+    return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+  }
+  ++counters_->loads;
+  loaded = true;
+  Result result(loader(key));
+  if (!result)
+    ++counters_->misses;
+  return result;
+}
+
+template <typename KeyType, typename ValueType>
+void TieredCache<KeyType, ValueType>::Add(KeyType key, ValueType value) {
+  WriteBack(key, value);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // LruCache::Add keeps an existing entry, so replace it.
+  l1_.Delete(key);
+  auto itr(in_flight_.find(key));
+  if (itr != in_flight_.end())
+    itr->second.invalidated = true;
+  l1_.Add(std::move(key), std::move(value));
+}
+
+template <typename KeyType, typename ValueType>
+void TieredCache<KeyType, ValueType>::Delete(const KeyType& key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    l1_.Delete(key);
+    auto itr(in_flight_.find(key));
+    if (itr != in_flight_.end())
+      itr->second.invalidated = true;
+  }
+  store_.erase(key);
+}
+
+template <typename KeyType, typename ValueType>
+void TieredCache<KeyType, ValueType>::WriteBack(const KeyType& key, const ValueType& value) {
+  auto put(store_.put);
+  auto counters(counters_);
+  std::function<void()> write([put, counters, key, value] {
+    try {
+      put(key, value);
+      ++counters->write_backs;
+    } catch (const std::exception&) {
+      ++counters->failed_write_backs;
+    }
+  });
+  if (executor_)
+    executor_(std::move(write));
+  else
+    write();
+}
+
+template <typename KeyType, typename ValueType>
+TieredCacheStats TieredCache<KeyType, ValueType>::stats() const {
+  TieredCacheStats stats;
+  stats.l1_hits = counters_->l1_hits;
+  stats.l2_hits = counters_->l2_hits;
+  stats.loads = counters_->loads;
+  stats.misses = counters_->misses;
+  stats.coalesced = counters_->coalesced;
+  stats.write_backs = counters_->write_backs;
+  stats.failed_write_backs = counters_->failed_write_backs;
+  return stats;
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_TIERED_CACHE_H_
@@ -0,0 +1,268 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A map keyed by Identity, supporting lookups by XOR distance, e.g. finding the close group of a
+  random target in a simulated network.  It's a crit-bit tree (a compressed binary trie): each
+  internal node records the index of the most significant bit at which the keys below it differ
+  and has one child per value of that bit, while the entries are held in the leaves.
+
+  Since every key below a node shares the same bits above its critical bit, visiting first the
+  child whose bit matches the target's and then the other enumerates the keys in order of
+  increasing XOR distance from the target.  Hence Insert, Erase and Find are O(depth), and
+  Closest is O(depth + count), where the depth is around log2(size) for uniformly distributed IDs
+  and never more than 8 * identity_size.
+
+  Nodes are allocated from slab pools, so the trie can hold tens of millions of entries without an
+  allocation per operation.  It isn't thread-safe.
+*/
+
+#ifndef MAIDSAFE_COMMON_CONTAINERS_XOR_TRIE_H_
+#define MAIDSAFE_COMMON_CONTAINERS_XOR_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/slab_pool.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+struct XorTrieNode {
+  explicit XorTrieNode(bool is_leaf_in) : is_leaf(is_leaf_in) {}
+  const bool is_leaf;
+};
+
+struct XorTrieBranch : XorTrieNode {
+  XorTrieBranch(std::uint16_t bit_in, XorTrieNode* zero, XorTrieNode* one)
+      : XorTrieNode(false), bit(bit_in), children{{zero, one}} {}
+  const std::uint16_t bit;
+  std::array<XorTrieNode*, 2> children;
+};
+
+template <typename ValueType>
+struct XorTrieLeaf : XorTrieNode {
+  template <typename Value>
+  XorTrieLeaf(const Identity& key, Value&& value)
+      : XorTrieNode(true), entry(key, std::forward<Value>(value)) {}
+  std::pair<const Identity, ValueType> entry;
+};
+
+// Returns bit 'index' of 'id', counting from the most significant bit of its first byte.
+inline unsigned GetBit(const byte* id, std::size_t index) {
+  return (id[index / 8] >> (7 - (index % 8))) & 1U;
+}
+
+}  // namespace detail
+
+template <typename ValueType>
+class XorTrie {
+ public:
+  using value_type = std::pair<const Identity, ValueType>;
+
+  XorTrie() : root_(nullptr), size_(0), branches_(), leaves_() {}
+  ~XorTrie() { clear(); }
+
+  XorTrie(const XorTrie&) = delete;
+  XorTrie(XorTrie&&) = delete;
+  XorTrie& operator=(const XorTrie&) = delete;
+  XorTrie& operator=(XorTrie&&) = delete;
+
+  // Returns false (leaving the existing value unchanged) if 'key' is already held.  Throws if
+  // 'key' is uninitialised.
+  template <typename Value>
+  bool Insert(const Identity& key, Value&& value) {
+    CheckInitialised(key);
+    if (!root_) {
+      root_ = leaves_.Construct(key, std::forward<Value>(value));
+      ++size_;
+      return true;
+    }
+
+    // Find the leaf with the longest common prefix, and hence the new branch's critical bit.
+    const int bit(CommonLeadingBits(key, ClosestLeaf(key)->entry.first));
+    if (bit == static_cast<int>(8 * identity_size))
+      return false;
+
+    // Insert the branch above the first node whose critical bit is lower.
+    const byte* const key_data(key.data());
+    Node** link(&root_);
+    while (!(*link)->is_leaf) {
+      Branch* branch(static_cast<Branch*>(*link));
+      if (branch->bit > bit)
+        break;
+      link = &branch->children[detail::GetBit(key_data, branch->bit)];
+    }
+    Leaf* const leaf(leaves_.Construct(key, std::forward<Value>(value)));
+    try {
+      const bool one(detail::GetBit(key_data, bit) == 1);
+      *link = branches_.Construct(static_cast<std::uint16_t>(bit), one ? *link : leaf,
+                                  one ? leaf : *link);
+    } catch (...) {
+      leaves_.Destroy(leaf);
+      throw;
+    }
+    ++size_;
+    return true;
+  }
+
+  // Returns false if 'key' isn't held.  Throws if 'key' is uninitialised.
+  bool Erase(const Identity& key) {
+    CheckInitialised(key);
+    if (!root_)
+      return false;
+    const byte* const key_data(key.data());
+    Node** link(&root_);
+    Node** parent_link(nullptr);
+    while (!(*link)->is_leaf) {
+      Branch* const branch(static_cast<Branch*>(*link));
+      parent_link = link;
+      link = &branch->children[detail::GetBit(key_data, branch->bit)];
+    }
+    Leaf* const leaf(static_cast<Leaf*>(*link));
+    if (leaf->entry.first != key)
+      return false;
+
+    if (parent_link) {
+      // Replace the parent branch with the leaf's sibling.
+      Branch* const parent(static_cast<Branch*>(*parent_link));
+      *parent_link = parent->children[&parent->children[0] == link ? 1 : 0];
+      branches_.Destroy(parent);
+    } else {
+      root_ = nullptr;
+    }
+    leaves_.Destroy(leaf);
+    --size_;
+    return true;
+  }
+
+  // Returns nullptr if 'key' isn't held.  Throws if 'key' is uninitialised.
+  value_type* Find(const Identity& key) {
+    CheckInitialised(key);
+    if (!root_)
+      return nullptr;
+    Leaf* const leaf(ClosestLeaf(key));
+    return leaf->entry.first == key ? &leaf->entry : nullptr;
+  }
+
+  const value_type* Find(const Identity& key) const {
+    return const_cast<XorTrie*>(this)->Find(key);
+  }
+
+  // Returns the (at most) 'count' entries closest in XOR distance to 'target_id', ordered from
+  // closest.  Throws if 'target_id' is uninitialised.
+  std::vector<value_type*> Closest(const Identity& target_id, std::size_t count) {
+    CheckInitialised(target_id);
+    std::vector<value_type*> closest;
+    if (!root_ || count == 0)
+      return closest;
+    closest.reserve(std::min(count, size_));
+    const byte* const target_data(target_id.data());
+    std::vector<Node*> pending(1, root_);
+    while (!pending.empty()) {
+      Node* const node(pending.back());
+      pending.pop_back();
+      if (node->is_leaf) {
+        closest.push_back(&static_cast<Leaf*>(node)->entry);
+        if (closest.size() == count)
+          break;
+      } else {
+        // Push the far child first so that the near one is visited first.
+        Branch* const branch(static_cast<Branch*>(node));
+        const unsigned near(detail::GetBit(target_data, branch->bit));
+        pending.push_back(branch->children[near ^ 1U]);
+        pending.push_back(branch->children[near]);
+      }
+    }
+    return closest;
+  }
+
+  std::vector<const value_type*> Closest(const Identity& target_id, std::size_t count) const {
+    const auto closest(const_cast<XorTrie*>(this)->Closest(target_id, count));
+    return std::vector<const value_type*>(std::begin(closest), std::end(closest));
+  }
+
+  void clear() {
+    if (root_)
+      DestroySubtree(root_);
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  using Node = detail::XorTrieNode;
+  using Branch = detail::XorTrieBranch;
+  using Leaf = detail::XorTrieLeaf<ValueType>;
+
+  static void CheckInitialised(const Identity& id) {
+    if (!id.IsInitialised()) {
+      LOG(kError) << "XorTrie key is uninitialised.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+    }
+  }
+
+  // Requires a non-empty trie.  Follows the bits of 'key' to a leaf, which holds 'key' if it's
+  // present, and otherwise holds a key sharing the longest possible prefix with it.
+  Leaf* ClosestLeaf(const Identity& key) const {
+    const byte* const key_data(key.data());
+    Node* node(root_);
+    while (!node->is_leaf) {
+      Branch* const branch(static_cast<Branch*>(node));
+      node = branch->children[detail::GetBit(key_data, branch->bit)];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  void DestroySubtree(Node* root) {
+    std::vector<Node*> pending(1, root);
+    while (!pending.empty()) {
+      Node* const node(pending.back());
+      pending.pop_back();
+      if (node->is_leaf) {
+        leaves_.Destroy(static_cast<Leaf*>(node));
+      } else {
+        Branch* const branch(static_cast<Branch*>(node));
+        pending.push_back(branch->children[0]);
+        pending.push_back(branch->children[1]);
+        branches_.Destroy(branch);
+      }
+    }
+  }
+
+  Node* root_;
+  std::size_t size_;
+  detail::SlabPool<Branch> branches_;
+  detail::SlabPool<Leaf> leaves_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CONTAINERS_XOR_TRIE_H_
@@ -20,7 +20,10 @@
 #define MAIDSAFE_COMMON_CRYPTO_H_
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <future>
 #include <limits>
 #include <string>
 #include <vector>
@@ -97,6 +100,8 @@ const int AES256_KeySize = 32;  // size in bytes.
 // Since the block size for AES is 128 bits, only the first 128 bits of the IV are used.  We force
 // the IV to be exactly 128 bits.
 const int AES256_IVSize = 16;  // size in bytes.
+// SymmEncrypt appends a GCM authentication tag of this size to the ciphertext.
+const int AES256_TagSize = 16;  // size in bytes.
 const std::uint16_t kMaxCompressionLevel = 9;
 const std::string kMaidSafeVersionLabel1 = "MaidSafe Version 1 Key Derivation";
 const std::string kMaidSafeVersionLabel = kMaidSafeVersionLabel1;
@@ -115,6 +120,13 @@ using DataParts = std::vector<NonEmptyString>;
 // thread-specific pointer (i.e. it's thread-safe).
 CryptoPP::RandomNumberGenerator& random_number_generator();
 
+// Returns a reference to a thread-specific ChaCha20-based generator, intended for cheap bulk
+// generation of IVs, salts, nonces and hash seeds.  It generates 4 KiB of keystream at a time into
+// a per-thread buffer, rekeying from the start of each refill so that bytes already handed out
+// can't be recovered from its state, and reseeds from random_number_generator() after every 1 MiB.
+// Prefer random_number_generator() for long-term key generation.
+CryptoPP::RandomNumberGenerator& fast_random_number_generator();
+
 // Creates a secure password of size AES256_KeySize + AES256_IVSize using the Password-Based Key
 // Derivation Function (PBKDF) version 2 algorithm.  The number of iterations is derived from "pin".
 // "label" is additional data to provide distinct input data to PBKDF.  The function will throw a
@@ -142,43 +154,211 @@ SecurePassword CreateSecurePassword(const PasswordType& password, const Salt& sa
   return SecurePassword(SecurePassword::value_type(derived_password));
 }
 
+// The String type of the digest returned by Hash<HashType> for an input of type 'String'.  This is
+// generally the input's type, but a FixedString (which can't change size) gives a std::vector, and
+// the SHA512 digest of a byte string is held in a FixedString so that it's an Identity.
+template <typename HashType, typename String>
+struct HashResultString {
+  using type = String;
+};
+
+template <typename HashType, std::size_t size>
+struct HashResultString<HashType, detail::FixedString<size>> {
+  using type = std::vector<byte>;
+};
+
+template <>
+struct HashResultString<SHA512, std::vector<byte>> {
+  using type = detail::FixedString<identity_size>;
+};
+
+template <std::size_t size>
+struct HashResultString<SHA512, detail::FixedString<size>> {
+  using type = detail::FixedString<identity_size>;
+};
+
+template <std::size_t capacity>
+struct HashResultString<SHA512, detail::SmallString<capacity>> {
+  using type = detail::FixedString<identity_size>;
+};
+
+// The type returned by Hash<HashType> for an input of type 'String'.
+template <typename HashType, typename String>
+using HashResult = detail::BoundedString<HashType::DIGESTSIZE, HashType::DIGESTSIZE,
+                                         typename HashResultString<HashType, String>::type>;
+
 // Hash function designed to operate on an arbitrary string type, e.g. std::string or
-// std::vector<byte>.
+// std::vector<byte>.  The SHA512 hash of a byte string is an Identity, and computing it doesn't
+// allocate.
 template <typename HashType, typename String>
-detail::BoundedString<HashType::DIGESTSIZE, HashType::DIGESTSIZE, String> Hash(
-    const String& input) {
-  std::string result;
-  HashType hash;
+HashResult<HashType, String> Hash(const String& input) {
+  std::array<byte, HashType::DIGESTSIZE> digest;
   try {
-    CryptoPP::ArraySource(reinterpret_cast<const byte*>(input.data()), input.size(), true,
-                          new CryptoPP::HashFilter(hash, new CryptoPP::StringSink(result)));
+    HashType().CalculateDigest(digest.data(), reinterpret_cast<const byte*>(input.data()),
+                               input.size());
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Error hashing string: " << e.what();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::hashing_error));
   }
-  return detail::BoundedString<HashType::DIGESTSIZE, HashType::DIGESTSIZE, String>(result);
+  using ResultString = typename HashResultString<HashType, String>::type;
+  return HashResult<HashType, String>(ResultString(digest.begin(), digest.end()));
 }
 
 // Hash function operating on a BoundedString.
 template <typename HashType, size_t min, size_t max, typename String>
-detail::BoundedString<HashType::DIGESTSIZE, HashType::DIGESTSIZE, String> Hash(
-    const detail::BoundedString<min, max, String>& input) {
+HashResult<HashType, String> Hash(const detail::BoundedString<min, max, String>& input) {
   return Hash<HashType>(input.string());
 }
 
+// Used by HashMany.  Returns the number of threads to use when hashing 'count' inputs totalling
+// 'total_size' bytes.
+std::size_t HashManyThreadCount(std::size_t count, std::size_t total_size);
+
+// Returns the hashes of each of 'inputs', in order.  Large batches are split across several
+// threads.  'String' can be any type accepted by Hash.
+template <typename HashType, typename String>
+std::vector<HashResult<HashType, String>> HashMany(const std::vector<String>& inputs) {
+  std::size_t total_size(0);
+  for (const auto& input : inputs)
+    total_size += input.size();
+  const std::size_t size(inputs.size());
+  const std::size_t thread_count(HashManyThreadCount(size, total_size));
+  const std::size_t chunk_size((size + thread_count - 1) / thread_count);
+
+  std::vector<HashResult<HashType, String>> results(size);
+  auto hash_range([&](std::size_t begin, std::size_t end) {
+    for (std::size_t i(begin); i != end; ++i)
+      results[i] = Hash<HashType>(inputs[i]);
+  });
+  std::vector<std::future<void>> chunks;
+  for (std::size_t begin(chunk_size); begin < size; begin += chunk_size)
+    chunks.push_back(std::async(std::launch::async, hash_range, begin,
+                                std::min(size, begin + chunk_size)));
+  hash_range(0, std::min(size, chunk_size));
+  for (auto& chunk : chunks)
+    chunk.get();
+  return results;
+}
+
+// Hashes input passed in arbitrary chunks, e.g. a file or network payload as it streams in,
+// without first building a contiguous copy.  Final gives the same digest as Hash would for the
+// concatenation of all input passed to Update since construction or the previous call to Final,
+// and resets the hasher for reuse.
+template <typename HashType>
+class Hasher {
+ public:
+  enum { kDigestSize = HashType::DIGESTSIZE };
+
+  Hasher() : hash_() {}
+
+  void Update(const byte* input, size_t size) { hash_.Update(input, size); }
+
+  template <typename String>
+  void Update(const String& input) {
+    Update(reinterpret_cast<const byte*>(input.data()), input.size());
+  }
+
+  // Writes kDigestSize bytes to 'output'.
+  void Final(byte* output) { hash_.Final(output); }
+
+  // Returns the digest as the same type which Hash returns for a std::vector<byte> input.
+  HashResult<HashType, std::vector<byte>> Final() {
+    std::array<byte, kDigestSize> digest;
+    Final(digest.data());
+    using ResultString = typename HashResultString<HashType, std::vector<byte>>::type;
+    return HashResult<HashType, std::vector<byte>>(ResultString(digest.begin(), digest.end()));
+  }
+
+ private:
+  HashType hash_;
+};
+
 // Performs symmetric encryption using AES256.
 CipherText SymmEncrypt(const PlainText& input, const AES256KeyAndIV& key_and_iv);
 
 // Performs symmetric decryption using AES256.
 PlainText SymmDecrypt(const CipherText& input, const AES256KeyAndIV& key_and_iv);
 
+// As for SymmEncrypt above, but writes the ciphertext followed by the tag to 'output', which must
+// have space for 'size' + AES256_TagSize bytes.  'output' may equal 'input' to encrypt in place.
+// Each thread keeps its most recently used key set up, so repeated calls with the same key avoid
+// redoing the key schedule.  Throws if 'key_and_iv' is uninitialised.
+void SymmEncrypt(const byte* input, size_t size, const AES256KeyAndIV& key_and_iv, byte* output);
+
+// As for SymmDecrypt above, but reads 'size' bytes of ciphertext and tag from 'input' and writes
+// 'size' - AES256_TagSize bytes of plaintext to 'output'.  'output' may equal 'input' to decrypt
+// in place.  Throws if 'key_and_iv' is uninitialised, if 'size' is less than AES256_TagSize, or if
+// authentication fails, in which case the contents of 'output' are unspecified.
+void SymmDecrypt(const byte* input, size_t size, const AES256KeyAndIV& key_and_iv, byte* output);
+
+// Size of the nonce taken by the versions of SymmEncrypt and SymmDecrypt below.
+const int AES256_NonceSize = 12;  // size in bytes.
+
+// As for the buffer versions above, but with the AES256_KeySize-byte 'key' and AES256_NonceSize-
+// byte 'nonce' given separately, so that each message can use a fresh nonce (e.g. a counter)
+// without building an AES256KeyAndIV, and with 'associated_data_size' bytes of 'associated_data'
+// (e.g. a framing header) which are authenticated but not encrypted.  A nonce must never be used
+// twice with the same key.
+void SymmEncrypt(const byte* input, size_t size, const byte* key, const byte* nonce,
+                 const byte* associated_data, size_t associated_data_size, byte* output);
+void SymmDecrypt(const byte* input, size_t size, const byte* key, const byte* nonce,
+                 const byte* associated_data, size_t associated_data_size, byte* output);
+
 // Compress a string using gzip.  Compression level must be between 0 and 9
 // inclusive or function throws a std::exception.
 CompressedText Compress(const UncompressedText& input, uint16_t compression_level);
 
-// Uncompress a string using gzip.  Will throw a std::exception if uncompression fails.
+// Uncompress a string compressed by either version of Compress; the codec is detected from the
+// data.  Will throw a std::exception if uncompression fails.
 UncompressedText Uncompress(const CompressedText& input);
 
+// Codecs for the version of Compress below.  Each writes its own self-describing format (a gzip
+// member, an LZ4 frame or a zstd frame), which is how Uncompress detects it.  kLz4 and kZstd are
+// only available if the library was built with LZ4 or zstd respectively.
+enum class CompressionCodec { kGzip, kLz4, kZstd };
+
+using CompressionDictionary = TaggedValue<NonEmptyString, struct CompressionDictionaryTag>;
+
+bool CompressionCodecAvailable(CompressionCodec codec);
+
+// Compress using 'codec'.  Valid levels are 0 to 9 for gzip (as for the version above), 0 to 12
+// for LZ4 (levels below 3 use the fast compressor and the rest LZ4HC) and 1 to 19 for zstd.
+// Throws if 'codec' is unavailable or 'compression_level' is invalid for it.
+CompressedText Compress(const UncompressedText& input, CompressionCodec codec,
+                        int compression_level);
+
+// Compress using zstd primed with 'dictionary', which can be raw sample content or a trained zstd
+// dictionary.  This greatly improves the ratio for small inputs resembling the dictionary.  The
+// same dictionary must be passed to Uncompress.
+CompressedText Compress(const UncompressedText& input, const CompressionDictionary& dictionary,
+                        int compression_level);
+
+// Uncompress data produced by the dictionary version of Compress.
+UncompressedText Uncompress(const CompressedText& input, const CompressionDictionary& dictionary);
+
+// Trains a zstd dictionary of at most 'max_size' bytes from 'samples', which should be a few
+// hundred or more representative small records (e.g. serialised StructuredDataVersions).  Throws
+// if zstd is unavailable or there are too few samples.  The dictionary carries a random id which
+// zstd records in every frame compressed with it.
+CompressionDictionary TrainCompressionDictionary(const std::vector<NonEmptyString>& samples,
+                                                 size_t max_size = 16 * 1024);
+
+// Returns the id carried by a trained dictionary, or 0 for one made from raw content.
+uint32_t GetCompressionDictionaryId(const CompressionDictionary& dictionary);
+
+// Makes a trained dictionary available to Compress by id and returns that id.  Uncompress(input)
+// then uses it automatically for any frame which names it, so data compressed with older
+// dictionaries stays readable for as long as they remain registered: to version dictionaries,
+// ship each one (e.g. as a file written by compression_dictionary_tool), register them all at
+// startup and compress with the newest.  Registering the same dictionary again is harmless; throws
+// if a different dictionary is already registered with the same id.
+uint32_t RegisterCompressionDictionary(const CompressionDictionary& dictionary);
+
+// Compress using zstd with the registered dictionary 'dictionary_id'.  Throws if it's not
+// registered.
+CompressedText Compress(const UncompressedText& input, uint32_t dictionary_id,
+                        int compression_level);
+
 DataParts SecretShareData(int32_t threshold, int32_t number_of_shares, const PlainText& data);
 
 PlainText SecretRecoverData(const DataParts& parts);
@@ -187,6 +367,60 @@ DataParts InfoDisperse(int32_t threshold, int32_t number_of_shares, const PlainT
 
 PlainText InfoRetrieve(const DataParts& parts);
 
+// Recovers the output of SecretShareData or InfoDisperse, as SecretRecoverData or InfoRetrieve
+// would, from shares with one particular set of indices (their positions in the DataParts returned
+// when splitting).  The interpolation coefficients for that set are computed once by the
+// constructor rather than on every call, and the shares are decoded directly rather than through
+// CryptoPP's channel filters, so bulk retrieval of many values from the same holders is several
+// times faster.  Contexts are immutable, so may be shared between threads; ShareIndices gives a
+// suitable key for caching them.
+class ShareRecoveryContext {
+ public:
+  enum class Scheme { kSecretSharing, kInformationDispersal };
+
+  // The number of 'share_indices' must equal the threshold used when splitting (for
+  // kSecretSharing, it may exceed it).  Throws if there are fewer than two, or any duplicates.
+  ShareRecoveryContext(Scheme scheme, std::vector<uint32_t> share_indices);
+
+  // Returns the sorted indices of 'parts'.  Throws if any part is too short to hold an index.
+  static std::vector<uint32_t> ShareIndices(const DataParts& parts);
+
+  // 'parts' may be in any order.  Throws if their indices differ from the context's, or if they
+  // are not all the same size.
+  PlainText Recover(const DataParts& parts) const;
+
+  Scheme scheme() const { return scheme_; }
+  const std::vector<uint32_t>& share_indices() const { return share_indices_; }
+
+ private:
+  Scheme scheme_;
+  std::vector<uint32_t> share_indices_;  // sorted
+  // One entry per recovered stream of words: the position in 'share_indices_' of the share which
+  // holds the stream unchanged if there is one, otherwise share_indices_.size().
+  std::vector<size_t> direct_sources_;
+  // One entry per recovered stream of words, empty if it has a direct source, otherwise holding
+  // for each share in turn its coefficient expanded into eight 16-entry tables (one per nibble).
+  std::vector<std::vector<uint32_t>> coefficient_tables_;
+};
+
+// Reed-Solomon erasure coding over GF(2^8): a faster alternative to InfoDisperse for large data,
+// whose shares are not interchangeable with InfoDisperse's.  'data' is split into 'threshold'
+// zero-padded data shares holding the plaintext itself, and 'number_of_shares' - 'threshold'
+// parity shares are computed from a Cauchy matrix, so that any 'threshold' shares suffice to
+// retrieve 'data'.  Each share starts with a kErasureShareHeaderSize-byte header giving its index,
+// the threshold and the size of 'data'.  Large inputs are split into stripes coded concurrently,
+// using SIMD table lookups where the CPU supports them.
+//
+// ErasureDisperse throws as for InfoDisperse, or if 'number_of_shares' exceeds kMaxErasureShares.
+// ErasureRetrieve accepts shares in any order and ignores duplicates and any beyond the threshold.
+// It throws if there are too few distinct shares or if they are inconsistent with one another.
+const size_t kErasureShareHeaderSize = 10;
+const int32_t kMaxErasureShares = 256;
+
+DataParts ErasureDisperse(int32_t threshold, int32_t number_of_shares, const PlainText& data);
+
+PlainText ErasureRetrieve(const DataParts& parts);
+
 }  // namespace crypto
 
 }  // namespace maidsafe
@@ -19,19 +19,38 @@
 #ifndef MAIDSAFE_COMMON_DATA_BUFFER_H_
 #define MAIDSAFE_COMMON_DATA_BUFFER_H_
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <functional>
 #include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "boost/expected/expected.hpp"
 #include "boost/filesystem/path.hpp"
-
+#include "boost/multi_index_container.hpp"
+#include "boost/multi_index/composite_key.hpp"
+#include "boost/multi_index/hashed_index.hpp"
+#include "boost/multi_index/member.hpp"
+#include "boost/multi_index/ordered_index.hpp"
+#include "boost/multi_index/sequenced_index.hpp"
+
+#include "maidsafe/common/completion_handler.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/latency_histogram.h"
+#include "maidsafe/common/shared_buffer.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/arena.h"
 #include "maidsafe/common/data_types/data.h"
 
 namespace maidsafe {
@@ -42,10 +61,155 @@ class DataBufferTest;
 
 }  // namespace test
 
+namespace detail {
+
+class SegmentedLog;
+
+}  // namespace detail
+
 class DataBuffer {
  public:
   using KeyType = Data::NameAndTypeId;
   using PopFunctor = std::function<void(const KeyType&, const NonEmptyString&)>;
+  // Used by AsyncStore and AsyncGet to run their handlers, e.g.
+  // [&io_service](std::function<void()> functor) { io_service.post(functor); }
+  using Executor = std::function<void(std::function<void()>)>;
+  // Passed the error (if any) which the corresponding blocking call would have thrown.
+  using StoreHandler = std::function<void(std::error_code)>;
+  using GetHandler = std::function<void(std::error_code, NonEmptyString)>;
+
+  // How values are laid out in the disk buffer directory.  kFilePerKey writes each value to its own
+  // file.  kSegmentedLog appends values to a series of large segment files (see Options) indexed in
+  // memory, which avoids exhausting inodes and slow directory lookups when holding millions of
+  // small values.  Deleted values stop counting towards the disk usage immediately, but the space
+  // they leave in a segment is only reclaimed when the segment is compacted, so the segment files
+  // can take up more space than the disk usage.
+  enum class DiskLayout { kFilePerKey, kSegmentedLog };
+
+  // Eviction classes (see SetPriority).
+  enum class Priority { kLow, kNormal, kHigh };
+
+  // How values are chosen for eviction from memory within a priority.  kFifo evicts the oldest.
+  // kClock gives values read from memory since they were last passed over a second chance (moving
+  // them behind the others of their priority), and promotes a value held only on disk back into
+  // memory when it's read a second time while there is space for it.  Values read via GetView
+  // aren't promoted.
+  enum class EvictionPolicy { kFifo, kClock };
+
+  // Tuning for the disk store and the background workers which copy values from memory to disk.
+  struct Options {
+    Options()
+        : flush_worker_count(1),
+          flush_batch_size(1),
+          sync_on_flush(false),
+          disk_layout(DiskLayout::kFilePerKey),
+          segment_size(64 * 1024 * 1024),
+          compaction_threshold(0.5),
+          recover_disk_buffer(false),
+          compress_on_disk(false),
+          compression_level(1),
+          lookup_observer(),
+          eviction_policy(EvictionPolicy::kFifo) {}
+    // Number of background worker threads per disk directory.  Must be at least 1.
+    size_t flush_worker_count;
+    // Maximum number of values a worker claims from memory and writes to disk per cycle.  The disk
+    // index is only locked once per cycle (rather than once per value) to record the results, and
+    // the written files are synced as a group.  Must be at least 1.
+    size_t flush_batch_size;
+    // If true, each cycle's files (and the disk buffer directory's entries) are synced to the
+    // storage device before being marked as stored.
+    bool sync_on_flush;
+    DiskLayout disk_layout;
+    // For kSegmentedLog only: the size in bytes at which a new segment is started (must be
+    // non-zero), and the fraction of a full segment which must still hold live values to avoid it
+    // being compacted (must be in the range [0, 1)).
+    uint64_t segment_size;
+    double compaction_threshold;
+    // If true, values left in the disk buffer by a previous DataBuffer (constructed with
+    // should_remove_root false, or which didn't shut down cleanly) are indexed on construction,
+    // oldest first, and count towards the disk usage.  Otherwise they're ignored (kFilePerKey) or
+    // removed (kSegmentedLog).  For kFilePerKey, the age of a value is its file's last write time,
+    // so values written within the file system's timestamp resolution of each other may be
+    // reordered, and a file torn by a crash can't be detected unless sync_on_flush was set.  For
+    // kSegmentedLog, the order is exact and torn records are discarded, but deletions may be lost
+    // if not followed by a synced flush.
+    bool recover_disk_buffer;
+    // If true, values are compressed (using crypto::Compress at 'compression_level', which must
+    // not exceed crypto::kMaxCompressionLevel) as they're written to disk, and the disk usage
+    // counts the compressed sizes.  Values which look incompressible (e.g. ciphertext) judging by
+    // the entropy of their first few KB, or which don't shrink, are written uncompressed.  Values
+    // held in memory are never compressed.  Must match the setting used to write any recovered
+    // values.
+    bool compress_on_disk;
+    uint16_t compression_level;
+    // If set, called with the key of every lookup via Get, TryGet, GetView or AsyncGet, whether or
+    // not the value is held, e.g. to track the hottest keys via HotKeyTracker::Observer().  Called
+    // concurrently from the threads making the lookups (or AsyncGet's executor), without any of
+    // the buffer's locks held.
+    std::function<void(const KeyType&)> lookup_observer;
+    EvictionPolicy eviction_policy;
+  };
+
+  // Totals for all background workers since construction.
+  struct FlushStats {
+    FlushStats() : values_flushed(0), bytes_flushed(0), batches_flushed(0), write_time() {}
+    // Average write throughput of a single worker while writing (i.e. excluding idle time).
+    double BytesPerSecond() const;
+    uint64_t values_flushed, bytes_flushed, batches_flushed;
+    // Time spent writing (and syncing) values, summed across all workers.
+    std::chrono::steady_clock::duration write_time;
+  };
+
+  // One of the directories across which the disk store is spread, with its share of the disk
+  // usage.
+  struct DiskDirectory {
+    DiskDirectory(boost::filesystem::path path_in, DiskUsage max_usage_in)
+        : path(std::move(path_in)), max_usage(std::move(max_usage_in)) {}  // NOLINT
+    boost::filesystem::path path;
+    DiskUsage max_usage;
+  };
+
+  using LatencyHistogram = maidsafe::LatencyHistogram;
+
+  struct Stats {
+    Stats()
+        : memory_hits(0),
+          disk_hits(0),
+          misses(0),
+          memory_wait(),
+          disk_wait(),
+          pops(0),
+          promotions(0),
+          pop_latency(),
+          flush(),
+          memory_usage(0),
+          disk_usage(0),
+          memory_values(0),
+          disk_values(0) {}
+    // Ratio of hits to all lookups, or 0.0 if there have been none.
+    double HitRate() const;
+    // Outcomes of lookups via Get, GetView and AsyncGet.
+    uint64_t memory_hits, disk_hits, misses;
+    // Time spent making space in memory (by Store) and on disk (by Store if the value is too large
+    // for memory, otherwise by the background workers), whether by blocking or by evicting, for
+    // each store which found insufficient space.  The disk wait includes time spent popping.
+    LatencyHistogram memory_wait, disk_wait;
+    // Values popped from the disk store, and the time taken to read each and run the pop functor.
+    uint64_t pops;
+    // Values copied back into memory from disk (see EvictionPolicy::kClock).
+    uint64_t promotions;
+    LatencyHistogram pop_latency;
+    FlushStats flush;
+    // Current usage, in bytes and values.
+    uint64_t memory_usage, disk_usage;
+    size_t memory_values, disk_values;
+  };
+
+  // Read-only view of a value, returned by GetView.  A value held on disk is memory-mapped rather
+  // than copied, and one held in memory is shared with the memory store.  Either way, the view (and
+  // any copy of it) keeps the value's storage alive, so it remains valid after the value has been
+  // deleted from, or replaced in, the buffer.
+  using ValueView = SharedBuffer;
 
   DataBuffer() = delete;
   DataBuffer(const DataBuffer&) = delete;
@@ -54,16 +218,29 @@ class DataBuffer {
   DataBuffer& operator=(DataBuffer&&) = delete;
 
   // Throws if max_memory_usage >= max_disk_usage.  Throws if a writable folder can't be created in
-  // temp_directory_path().  Starts a background worker thread which copies values from memory to
-  // disk.  If pop_functor is valid, the disk cache will pop excess items when it is full,
-  // otherwise Store will block until there is space made via Delete calls.
-  DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor);
+  // temp_directory_path().  Starts background worker threads (see Options) which copy values from
+  // memory to disk.  If pop_functor is valid, the disk cache will pop excess items when it is full,
+  // otherwise Store will block until there is space made via Delete calls.  Throws if 'options' is
+  // invalid.
+  DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
+             Options options = Options());
   // Throws if max_memory_usage >= max_disk_usage.  Throws if a writable folder can't be created in
-  // "disk_buffer".  Starts a background worker thread which copies values from memory to disk.  If
-  // pop_functor is valid, the disk cache will pop excess items when it is full, otherwise Store
-  // will block until there is space made via Delete calls.
+  // "disk_buffer".  Starts background worker threads (see Options) which copy values from memory
+  // to disk.  If pop_functor is valid, the disk cache will pop excess items when it is full,
+  // otherwise Store will block until there is space made via Delete calls.  Throws if 'options' is
+  // invalid.
   DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage, PopFunctor pop_functor,
-             const boost::filesystem::path& disk_buffer, bool should_remove_root = false);
+             const boost::filesystem::path& disk_buffer, bool should_remove_root = false,
+             Options options = Options());
+  // As above, but spreads the disk store across 'disk_directories' (e.g. one per device), each
+  // with its own usage limit and flush workers.  Keys are assigned to directories by consistent
+  // hashing of their names, weighted by the limits, so recovering values requires the same list
+  // of directories (values found in a directory other than their key's are ignored).  Popping
+  // and waiting for space happen per directory.  Throws if 'disk_directories' is empty, if
+  // max_memory_usage exceeds any directory's limit, or if there's more than one directory and
+  // the disk layout is kSegmentedLog.
+  DataBuffer(MemoryUsage max_memory_usage, std::vector<DiskDirectory> disk_directories,
+             PopFunctor pop_functor, bool should_remove_root = false, Options options = Options());
   ~DataBuffer();
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the size of value is greater than the current specified maximum disk usage, or if the value
@@ -71,73 +248,247 @@ class DataBuffer {
   // store to memory, blocks until there is enough space to store to disk.  Space will be made
   // available via external calls to Delete, and also automatically if pop_functor_ is not NULL.
   void Store(const KeyType& key, const NonEmptyString& value);
+  // As above, but if 'value' covers a whole NonEmptyString (see SharedBuffer::SharedString), that
+  // string is held in the memory store without being copied.
+  void Store(const KeyType& key, SharedBuffer value);
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the value can't be read from disk.  If the value isn't in memory and has started to be stored
   // to disk, blocks briefly while waiting for the storing to complete.
   NonEmptyString Get(const KeyType& key);
+  // As for Get, but a value which isn't held is reported as CommonErrors::no_such_element and a
+  // failed disk read by the corresponding error, rather than by throwing.  Still throws if the
+  // background worker has thrown.
+  boost::expected<NonEmptyString, common_error> TryGet(const KeyType& key);
+  // Non-blocking equivalent of Store.  If the value can be stored in memory without waiting for
+  // space, it is stored before returning.  Otherwise the request is queued and handled by a single
+  // background thread in the order received, with any subsequent AsyncStore requests queued behind
+  // it so that they can't overtake it.  Requests still queued when the buffer is destroyed are
+  // failed with CommonErrors::unable_to_handle_request.
+  void AsyncStore(const KeyType& key, NonEmptyString value, Executor executor,
+                  StoreHandler handler);
+  // Non-blocking equivalent of Get.  A value held in memory is retrieved before returning;
+  // otherwise the (briefly blocking) disk read is run via 'executor', so the buffer must outlive
+  // any such pending call.
+  void AsyncGet(const KeyType& key, Executor executor, GetHandler handler);
+  // As above, but completes via an asio completion token, e.g. 'asio::use_future', a
+  // 'yield_context' or (in C++20 builds) 'asio::use_awaitable'.  Any disk read and the handler are
+  // run via the handler's associated executor (asio's system executor if it has none).
+  template <typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, NonEmptyString))
+  AsyncGet(const KeyType& key, CompletionToken&& token);
+  // As for Get, but avoids copying the value.  On platforms where a mapped file can't be removed
+  // (i.e. Windows), values held one per file on disk are read rather than mapped.
+  ValueView GetView(const KeyType& key);
   // Throws if the background worker has thrown (e.g. the disk has become inaccessible).  Throws if
   // the value was written to disk and can't be removed.
   void Delete(const KeyType& key);
+  // As for Delete, but returns false rather than throwing if 'key' isn't held.
+  bool TryDelete(const KeyType& key);
   // Delete based on a predicate, allows pairs etc. to be used as key
   void Delete(std::function<bool(const KeyType&)> predicate);
+  // Sets the eviction class of the value held under 'key' and of any stored under it later.  When
+  // space is needed, values are evicted from memory (and popped from, or waited for on, disk)
+  // lowest priority first, and oldest first within a priority.  A value whose priority changes is
+  // ordered as the newest of its new priority.  Keys default to kNormal.
+  void SetPriority(const KeyType& key, Priority priority);
+  // Keeps the value held under 'key', and any stored under it later, from being evicted from memory
+  // or popped from disk until Unpin is called, whatever its priority.  It is still copied to disk.
+  // A value already evicted from memory isn't reloaded.  Stores wait for space while pinned values
+  // fill memory, so their total size should be kept well below the maximum memory usage.
+  void Pin(const KeyType& key);
+  void Unpin(const KeyType& key);
+  // Evicts values which have already been copied to disk from memory, in eviction order, until at
+  // least 'bytes' have been released or no more can be without waiting for disk writes.  Pinned
+  // values aren't evicted.  Returns the number of bytes released.  Lets memory be reclaimed under
+  // pressure (see MemoryBudget) without lowering the maximum memory usage.
+  uint64_t EvictFromMemory(uint64_t bytes);
   // Throws if max_memory_usage > max_disk_usage_.
   void SetMaxMemoryUsage(MemoryUsage max_memory_usage);
-  // Throws if max_memory_usage_ > max_disk_usage.
+  // Throws if max_memory_usage_ > max_disk_usage.  With several disk directories, their limits are
+  // scaled in proportion, and it throws if max_memory_usage_ would exceed any of them.
   void SetMaxDiskUsage(DiskUsage max_disk_usage);
 
+  FlushStats flush_stats() const;
+  // Snapshot of the counters since construction and the current usage.  The memory and disk stores
+  // are read in turn, so the usage figures may not be mutually consistent if the buffer is in use.
+  Stats stats() const;
+
   friend class test::DataBufferTest;
 
  private:
+  // The index's nodes are recycled through 'arena', which (like the index) is only used while
+  // holding 'mutex'.
   template <typename UsageType, typename IndexType>
   struct Storage {
     using index_type = IndexType;
     explicit Storage(UsageType max_in)
         : max(std::move(max_in)),  // NOLINT
           current(0),
-          index(),
+          next_stamp(0),
+          arena(),
+          index(typename IndexType::ctor_args_list(),
+                typename IndexType::allocator_type(arena)),
           mutex(),
           cond_var() {}
     UsageType max, current;
+    // Orders elements within a rank in the eviction order.
+    uint64_t next_stamp;
+    PooledArena arena;
     IndexType index;
-    std::mutex mutex;
+    mutable std::mutex mutex;
     std::condition_variable cond_var;
   };
 
   enum class StoringState { kNotStarted, kStarted, kCancelled, kCompleted };
 
+  // Position of a value in the eviction order: its priority, or kPinnedRank if pinned.  Only keys
+  // with a non-default priority or which are pinned have a KeyPolicy.
+  using Rank = unsigned;
+  static const Rank kPinnedRank = 3;
+  struct KeyPolicy {
+    KeyPolicy() : priority(Priority::kNormal), pinned(false) {}
+    Rank rank() const { return pinned ? kPinnedRank : static_cast<Rank>(priority); }
+    Priority priority;
+    bool pinned;
+  };
+
+  // Elements of the indices are immutable other than their state, which is therefore mutable, and
+  // their rank and stamp, which are changed via the index's 'modify'.  The values held in memory
+  // are shared with the workers copying them to disk and with any views.  'referenced' is set by
+  // reads (for EvictionPolicy::kClock), and 'promoted' marks both copies of a value promoted back
+  // into memory, whose disk copy isn't popped while the memory copy is held.
   struct MemoryElement {
-    MemoryElement(KeyType key_in, NonEmptyString value_in)
+    MemoryElement(KeyType key_in, NonEmptyString value_in, Rank rank_in, uint64_t stamp_in)
+        : key(std::move(key_in)),
+          value(std::make_shared<const NonEmptyString>(std::move(value_in))),
+          rank(rank_in),
+          stamp(stamp_in),
+          also_on_disk(StoringState::kNotStarted),
+          referenced(false),
+          promoted(false) {}
+    MemoryElement(KeyType key_in, std::shared_ptr<const NonEmptyString> value_in, Rank rank_in,
+                  uint64_t stamp_in)
         : key(std::move(key_in)),
           value(std::move(value_in)),
-          also_on_disk(StoringState::kNotStarted) {}
+          rank(rank_in),
+          stamp(stamp_in),
+          also_on_disk(StoringState::kNotStarted),
+          referenced(false),
+          promoted(false) {}
     KeyType key;
-    NonEmptyString value;
-    StoringState also_on_disk;
+    std::shared_ptr<const NonEmptyString> value;
+    Rank rank;
+    uint64_t stamp;
+    mutable StoringState also_on_disk;
+    mutable bool referenced, promoted;
   };
 
-  using MemoryIndex = std::deque<MemoryElement>;
-
   struct DiskElement {
-    explicit DiskElement(KeyType key_in) : key(std::move(key_in)), state(StoringState::kStarted) {}
+    DiskElement(KeyType key_in, Rank rank_in, uint64_t stamp_in)
+        : key(std::move(key_in)),
+          rank(rank_in),
+          stamp(stamp_in),
+          state(StoringState::kStarted),
+          writing(false),
+          referenced(false),
+          promoted(false) {}
     KeyType key;
-    StoringState state;
+    Rank rank;
+    uint64_t stamp;
+    mutable StoringState state;
+    mutable bool writing, referenced, promoted;
   };
-  using DiskIndex = std::deque<DiskElement>;
 
-  void Init();
+  struct KeyHash {
+    size_t operator()(const KeyType& key) const;
+  };
+
+  // The memory and disk indices hold their elements oldest-first (the sequenced index, which is
+  // the default one used by the multi_index_container's own member functions), with a hashed
+  // index for constant-time lookups by key, and an ordered index giving the eviction order (by
+  // rank, then by stamp, which is oldest-first unless restamped).
+  template <typename Element>
+  using Index = boost::multi_index_container<
+      Element,
+      boost::multi_index::indexed_by<
+          boost::multi_index::sequenced<>,
+          boost::multi_index::hashed_non_unique<
+              boost::multi_index::member<Element, KeyType, &Element::key>, KeyHash>,
+          boost::multi_index::ordered_unique<boost::multi_index::composite_key<
+              Element, boost::multi_index::member<Element, Rank, &Element::rank>,
+              boost::multi_index::member<Element, uint64_t, &Element::stamp>>>>,
+      ArenaAllocator<Element>>;
+  using MemoryIndex = Index<MemoryElement>;
+  using DiskIndex = Index<DiskElement>;
+  using MemoryEvictionOrder = MemoryIndex::nth_index<2>::type;
+  // Values to be written to disk in a single cycle.  The values are owned by the caller.
+  using DiskWriteBatch = std::vector<std::pair<KeyType, const NonEmptyString*>>;
+
+  // The disk usage of one of the disk directories.  Only used while holding the disk store's lock.
+  struct DiskStripe {
+    DiskStripe(boost::filesystem::path path_in, DiskUsage max_in)
+        : path(std::move(path_in)), max(std::move(max_in)), current(0) {}  // NOLINT
+    boost::filesystem::path path;
+    DiskUsage max, current;
+  };
+
+  struct AsyncStoreRequest {
+    KeyType key;
+    NonEmptyString value;
+    Executor executor;
+    StoreHandler handler;
+  };
 
-  std::unique_lock<std::mutex> StoreInMemory(const KeyType& key, const NonEmptyString& value);
+  static std::vector<DiskStripe> MakeStripes(std::vector<DiskDirectory> disk_directories);
+  void Init();
+  // Index into 'stripes_' of the directory holding 'key'.
+  size_t StripeOf(const KeyType& key) const;
+  // Must be called holding the disk store's lock.  Adjust the usage of the directory holding 'key'
+  // and the total.
+  void ReserveDiskSpace(const KeyType& key, uint64_t size);
+  void ReleaseDiskSpace(const KeyType& key, uint64_t size);
+  bool HasDiskSpace(const KeyType& key, uint64_t required_space) const;
+  void RecoverDiskIndex();
+
+  // 'shared_value', if non-null, holds the same value as 'value' and is stored instead of a copy.
+  void DoStore(const KeyType& key, const NonEmptyString& value,
+               std::shared_ptr<const NonEmptyString> shared_value);
+  std::unique_lock<std::mutex> StoreInMemory(const KeyType& key, const NonEmptyString& value,
+                                             std::shared_ptr<const NonEmptyString> shared_value);
+  // Returns false (without storing) if storing would have to wait for space.
+  bool TryStoreInMemory(const KeyType& key, const NonEmptyString& value);
+  void ServiceAsyncStores();
   void WaitForSpaceInMemory(uint64_t required_space,
                             std::unique_lock<std::mutex>& memory_store_lock);
-  void StoreOnDisk(const KeyType& key, const NonEmptyString& value,
-                   std::unique_lock<std::mutex>&& disk_store_lock);
+  // The elements of 'batch' must already have been added to the disk index.
+  void StoreOnDisk(const DiskWriteBatch& batch);
+  void CompleteStoreOnDisk(const KeyType& key, uint64_t size, bool failed);
+  // Returns the value if it's held in memory.  Otherwise, returns null with 'disk_store_lock' held
+  // once the value has been stored on disk.  Returns no_such_element if the value isn't held.
+  boost::expected<std::shared_ptr<const NonEmptyString>, common_error> FindValueOrWaitForDisk(
+      const KeyType& key, std::unique_lock<std::mutex>& disk_store_lock);
   void WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* const value,
-                          std::unique_lock<std::mutex>& disk_store_lock, bool& cancelled);
+                          uint64_t required_space, std::unique_lock<std::mutex>& disk_store_lock,
+                          bool& cancelled);
   void DeleteFromMemory(const KeyType& key, StoringState& also_on_disk);
-  void DeleteFromDisk(const KeyType& key);
+  // Must be called holding the memory store's lock but not the disk store's.  Returns the next
+  // element.
+  MemoryIndex::iterator EraseFromMemory(MemoryIndex::iterator itr);
+  // Returns false if 'key' isn't in the disk index.
+  bool DeleteFromDisk(const KeyType& key);
   void RemoveFile(const KeyType& key, NonEmptyString* value);
-
-  void CopyQueueToDisk();
+  // Wrappers for the disk layout in use.  Don't throw.
+  bool WriteToDisk(const KeyType& key, const NonEmptyString& value,
+                   std::vector<boost::filesystem::path>& written);
+  bool SyncToDisk(const std::vector<boost::filesystem::path>& written);
+  boost::expected<NonEmptyString, common_error> ReadFromDisk(const KeyType& key);
+  boost::expected<ValueView, common_error> MapFromDisk(const KeyType& key);
+  void EraseFromDisk(const KeyType& key);
+
+  static ValueView MakeView(std::shared_ptr<const NonEmptyString> value);
+
+  // Copies values for the directory 'stripe' to disk.
+  void CopyQueueToDisk(size_t stripe);
   void CheckWorkerIsStillRunning();
   void StopRunning();
   boost::filesystem::path GetFilename(const KeyType& key) const;
@@ -148,28 +499,77 @@ class DataBuffer {
   template <typename T>
   typename T::index_type::iterator Find(T& store, const KeyType& key);
 
-  MemoryIndex::iterator FindOldestInMemoryOnly();
+  // Must be called holding the lock of either store, since 'policies_' is only modified holding
+  // both.
+  Rank RankOf(const KeyType& key) const;
+  void UpdatePolicy(const KeyType& key, const std::function<void(KeyPolicy&)>& update);
+  template <typename T>
+  void Rerank(T& store, const KeyType& key, Rank rank);
+  // Must be called holding the disk store's lock.  Marks the disk copy of 'key' as referenced, and
+  // returns true if it already was.
+  bool ReferenceOnDisk(const KeyType& key);
+  void PromoteToMemory(const KeyType& key, const NonEmptyString& value);
+
+  // These follow the eviction order.  Pinned values are still copied to disk, but last.
+  MemoryEvictionOrder::iterator FindFirstInMemoryOnly(size_t stripe);
+  MemoryIndex::iterator FindFirstAlsoOnDisk();
   MemoryIndex::iterator FindMemoryRemovalCandidate(
       uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock);
 
-  DiskIndex::iterator FindStartedToStoreOnDisk(const KeyType& key);
-  DiskIndex::iterator FindOldestOnDisk();
+  // Finds the entry for 'key' which is being written to disk (i.e. is kStarted or kCancelled).
+  DiskIndex::iterator FindInFlightOnDisk(const KeyType& key);
+  DiskIndex::iterator FindFirstOnDisk(size_t stripe);
 
-  DiskIndex::iterator FindAndThrowIfCancelled(const KeyType& key);
+  // Used only by lookups, so counts a miss if it returns the end of the index (i.e. 'key' isn't
+  // held or its storing has been cancelled).
+  DiskIndex::iterator FindIfNotCancelled(const KeyType& key);
+
+  void ObserveLookup(const KeyType& key) const;
+  void RecordLookup(uint64_t Stats::*counter);
 
   std::string DebugKeyName(const KeyType& key);
 
   Storage<MemoryUsage, MemoryIndex> memory_store_;
   Storage<DiskUsage, DiskIndex> disk_store_;
   const PopFunctor kPopFunctor_;
+  // The first (or only) disk directory.
   const boost::filesystem::path kDiskBuffer_;
   const bool kShouldRemoveRoot_;
+  const Options kOptions_;
+  std::unique_ptr<detail::SegmentedLog> segmented_log_{};
+  // The disk directories, and with more than one, the consistent hashing ring of (position, index
+  // into 'stripes_') sorted by position.  The sum of the limits is the disk store's 'max'.
+  std::vector<DiskStripe> stripes_;
+  std::vector<std::pair<uint64_t, size_t>> stripe_ring_{};
   std::map<KeyType, const NonEmptyString*> elements_being_moved_to_disk_{};
+  std::unordered_map<KeyType, KeyPolicy, KeyHash> policies_{};
   std::atomic<bool> running_{true};
+  mutable std::mutex stats_mutex_{};
+  // The usage fields are only filled in by stats().
+  Stats stats_{};
   std::mutex worker_mutex_{};
-  std::future<void> worker_{};
+  std::vector<std::future<void>> workers_{};
+  std::mutex async_store_mutex_{};
+  std::condition_variable async_store_cond_var_{};
+  std::deque<AsyncStoreRequest> async_stores_{};
+  bool async_store_busy_{false};
+  // Only started once a request has to be queued.
+  std::future<void> async_store_worker_{};
 };
 
+template <typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, NonEmptyString))
+DataBuffer::AsyncGet(const KeyType& key, CompletionToken&& token) {
+  using Completion = asio::async_completion<CompletionToken, void(std::error_code, NonEmptyString)>;
+  Completion init(token);
+  detail::SharedHandler<typename Completion::completion_handler_type> handler(
+      std::move(init.completion_handler));
+  auto executor(asio::get_associated_executor(handler.handler()));
+  AsyncGet(key, [executor](std::function<void()> functor) { asio::post(executor, functor); },
+           handler);
+  return init.result.get();
+}
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_DATA_BUFFER_H_
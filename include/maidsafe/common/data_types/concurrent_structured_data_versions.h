@@ -0,0 +1,101 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_DATA_TYPES_CONCURRENT_STRUCTURED_DATA_VERSIONS_H_
+#define MAIDSAFE_COMMON_DATA_TYPES_CONCURRENT_STRUCTURED_DATA_VERSIONS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/data_types/structured_data_versions.h"
+
+namespace maidsafe {
+
+// A thread-safe StructuredDataVersions (SDV) which publishes each state as an immutable snapshot.
+//
+// Readers take the current snapshot (a shared_ptr to a const SDV) without locking, so they never
+// wait for writers or for each other, and may keep using a snapshot for as long as they like; it
+// won't change under them.
+//
+// Writers are serialised by a mutex.  Each write copies the current SDV, modifies the copy and then
+// publishes it as the new snapshot, so the cost of a write is proportional to the size of the SDV.
+// Several modifications can be combined into a single copy via Modify.  All writers provide the
+// strong exception guarantee.
+class ConcurrentStructuredDataVersions {
+ public:
+  using VersionName = StructuredDataVersions::VersionName;
+  using Snapshot = std::shared_ptr<const StructuredDataVersions>;
+
+  ConcurrentStructuredDataVersions(uint32_t max_versions, uint32_t max_branches);
+  explicit ConcurrentStructuredDataVersions(
+      const StructuredDataVersions::serialised_type& serialised_data_versions);
+  ConcurrentStructuredDataVersions(const ConcurrentStructuredDataVersions&) = delete;
+  ConcurrentStructuredDataVersions(ConcurrentStructuredDataVersions&&) = delete;
+  ConcurrentStructuredDataVersions& operator=(const ConcurrentStructuredDataVersions&) = delete;
+  ConcurrentStructuredDataVersions& operator=(ConcurrentStructuredDataVersions&&) = delete;
+
+  // Readers.  Each of the convenience functions below reads from a single snapshot; use
+  // GetSnapshot directly to make several consistent reads.
+  Snapshot GetSnapshot() const;
+  std::vector<VersionName> Get() const { return GetSnapshot()->Get(); }
+  std::vector<VersionName> GetBranch(const VersionName& branch_tip) const {
+    return GetSnapshot()->GetBranch(branch_tip);
+  }
+  std::vector<VersionName> GetBranch(const VersionName& branch_tip, std::size_t max_count,
+                                     std::size_t start) const {
+    return GetSnapshot()->GetBranch(branch_tip, max_count, start);
+  }
+  StructuredDataVersions::serialised_type Serialise() const { return GetSnapshot()->Serialise(); }
+
+  // Writers.  These behave as the StructuredDataVersions functions of the same names.
+  boost::optional<VersionName> Put(const VersionName& old_version, const VersionName& new_version);
+  void DeleteBranchUntilFork(const VersionName& branch_tip);
+  void ApplySerialised(const StructuredDataVersions::serialised_type& serialised_data_versions);
+  void ApplyDelta(const StructuredDataVersions::serialised_delta_type& serialised_delta);
+  StructuredDataVersions::MergeResult Merge(
+      const StructuredDataVersions::serialised_type& serialised_data_versions);
+  void clear();
+
+  // Calls 'modifier' with a copy of the current SDV, then publishes the copy as the new snapshot.
+  // If 'modifier' throws, the exception is propagated and the current snapshot is left unchanged.
+  template <typename Modifier>
+  void Modify(Modifier modifier);
+
+ private:
+  std::mutex write_mutex_;
+  // Only accessed via std::atomic_load and std::atomic_store.
+  Snapshot current_;
+};
+
+template <typename Modifier>
+void ConcurrentStructuredDataVersions::Modify(Modifier modifier) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  std::shared_ptr<StructuredDataVersions> copy(
+      new StructuredDataVersions(*std::atomic_load(&current_)));
+  modifier(*copy);
+  std::atomic_store(&current_, Snapshot(std::move(copy)));
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_DATA_TYPES_CONCURRENT_STRUCTURED_DATA_VERSIONS_H_
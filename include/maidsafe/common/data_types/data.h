@@ -43,10 +43,30 @@ class Data {
       return archive(name, type_id);
     }
 
+    // Feeds the name's bytes to the hash algorithm in a single Update call (requires hash.h).
+    template <typename HashAlgorithm>
+    void HashAppend(HashAlgorithm& hash) const {
+      hash(name, type_id);
+    }
+
     Identity name;
     DataTypeId type_id;
   };
 
+  // Non-owning counterpart of NameAndTypeId which can be compared with it via operator<.  This
+  // allows lookups in containers keyed by NameAndTypeId (e.g. LruCache) without copying the name.
+  // The name's bytes must outlive the view.
+  struct NameAndTypeIdView {
+    NameAndTypeIdView(const Identity& name_in, DataTypeId type_id_in)
+        : name(name_in.IsInitialised() ? name_in.string().data() : nullptr),
+          type_id(type_id_in) {}
+    // 'name_in' must point to identity_size bytes, e.g. a name within a received message.
+    NameAndTypeIdView(const byte* name_in, DataTypeId type_id_in)
+        : name(name_in), type_id(type_id_in) {}
+    const byte* name;  // nullptr for an uninitialised name
+    DataTypeId type_id;
+  };
+
   Data();
   Data(const Data&);
   Data(Data&& other);
@@ -99,6 +119,9 @@ bool operator>(const Data::NameAndTypeId& lhs, const Data::NameAndTypeId& rhs);
 bool operator<=(const Data::NameAndTypeId& lhs, const Data::NameAndTypeId& rhs);
 bool operator>=(const Data::NameAndTypeId& lhs, const Data::NameAndTypeId& rhs);
 
+bool operator<(const Data::NameAndTypeId& lhs, const Data::NameAndTypeIdView& rhs);
+bool operator<(const Data::NameAndTypeIdView& lhs, const Data::NameAndTypeId& rhs);
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_DATA_TYPES_DATA_H_
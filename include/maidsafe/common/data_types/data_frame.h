@@ -0,0 +1,135 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+/*
+  A framed encoding of a single Data object which allows routing code to read its name and type ID
+  from a fixed header without parsing (or even having the type information for) the payload.  The
+  payload is only parsed when requested via FramedData::Get.
+
+  Header layout (multi-byte fields little-endian):
+     offset  size
+       0       1   format version (currently kDataFrameVersion)
+       1       1   header size in bytes, including these two (kDataFrameHeaderSize for version 1)
+       2       4   type ID
+       6      64   name
+      70       4   payload size in bytes
+      74     ...   payload: the object as serialised by Serialise (BinaryOutputArchive)
+
+  Readers use the header size field to locate the payload, so later versions may append fields to
+  the header while remaining readable by older code.
+*/
+
+#ifndef MAIDSAFE_COMMON_DATA_TYPES_DATA_FRAME_H_
+#define MAIDSAFE_COMMON_DATA_TYPES_DATA_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data.h"
+#include "maidsafe/common/serialisation/binary_archive.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+
+namespace maidsafe {
+
+const std::uint8_t kDataFrameVersion = 1;
+const std::size_t kDataFrameHeaderSize = 74;
+
+namespace detail {
+
+// Writes a header for 'name_and_type' to the (empty) 'framed', with a zero payload size.
+void WriteDataFrameHeader(const Data::NameAndTypeId& name_and_type, SerialisedData& framed);
+
+// Sets the header's payload size field to account for everything after the header.
+void SetDataFramePayloadSize(SerialisedData& framed);
+
+}  // namespace detail
+
+// Serialises 'data' (a concrete type derived from Data) into a frame.  Throws if 'data' is
+// uninitialised.
+template <typename DataType>
+SerialisedData SerialiseFramed(const DataType& data) {
+  SerialisedData framed;
+  detail::WriteDataFrameHeader(data.NameAndType(), framed);
+  {
+    BinaryOutputArchive binary_output_archive(framed);
+    binary_output_archive(data);
+  }
+  detail::SetDataFramePayloadSize(framed);
+  return framed;
+}
+
+// Reads the name and type ID from the header of a frame without touching the payload.  Throws
+// CommonErrors::parsing_error if the header is invalid or the frame is truncated.
+Data::NameAndTypeId PeekNameAndType(const byte* framed, std::size_t size);
+
+// Holds a frame whose header has been validated, and parses the payload on the first call to Get.
+// Get is not thread-safe.
+class FramedData {
+ public:
+  // Throws CommonErrors::parsing_error if the header is invalid or the frame is truncated.
+  explicit FramedData(SerialisedData framed);
+
+  FramedData(FramedData&& other);
+  FramedData& operator=(FramedData&& other);
+  FramedData(const FramedData&) = delete;
+  FramedData& operator=(const FramedData&) = delete;
+
+  const Data::NameAndTypeId& NameAndType() const { return name_and_type_; }
+  const SerialisedData& Framed() const { return framed_; }
+
+  // Parses the payload as 'DataType' on the first call, or returns the previously-parsed object.
+  // Throws CommonErrors::parsing_error if the payload isn't a valid 'DataType' or doesn't match the
+  // header.
+  template <typename DataType>
+  const DataType& Get() const;
+
+ private:
+  const byte* Payload() const { return framed_.data() + payload_offset_; }
+  std::size_t PayloadSize() const { return framed_.size() - payload_offset_; }
+
+  SerialisedData framed_;
+  Data::NameAndTypeId name_and_type_;
+  std::size_t payload_offset_;
+  mutable std::unique_ptr<Data> parsed_;
+};
+
+template <typename DataType>
+const DataType& FramedData::Get() const {
+  if (!parsed_) {
+    std::unique_ptr<DataType> parsed(new DataType(Parse<DataType>(Payload(), PayloadSize())));
+    if (parsed->NameAndType() != name_and_type_) {
+      LOG(kError) << "Framed data's payload doesn't match its header.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    parsed_ = std::move(parsed);
+  }
+  const DataType* const result(dynamic_cast<const DataType*>(parsed_.get()));
+  if (!result) {
+    LOG(kError) << "Framed data has already been parsed as a different type.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  return *result;
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_DATA_TYPES_DATA_FRAME_H_
@@ -19,12 +19,15 @@
 #ifndef MAIDSAFE_COMMON_DATA_TYPES_IMMUTABLE_DATA_H_
 #define MAIDSAFE_COMMON_DATA_TYPES_IMMUTABLE_DATA_H_
 
+#include <memory>
+
 #include "cereal/types/base_class.hpp"
 #include "cereal/types/polymorphic.hpp"
 
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/crypto.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/shared_buffer.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data.h"
 // We must include all archives which this polymorphic type will be used with *before* the
@@ -36,6 +39,13 @@ namespace maidsafe {
 class ImmutableData : public Data {
  public:
   explicit ImmutableData(NonEmptyString value);
+  // Shares the payload of 'value' without copying it if possible (see SharedBuffer::SharedString).
+  explicit ImmutableData(SharedBuffer value);
+  // Adopt 'name' rather than computing it, for values whose hash is already known.  Unless
+  // 'verify_name' is false the value is still hashed, and a mismatch throws hashing_error.  Only
+  // skip verification where the pairing is already assured (as for ParseTrusted).
+  ImmutableData(Identity name, NonEmptyString value, bool verify_name = true);
+  ImmutableData(Identity name, SharedBuffer value, bool verify_name = true);
 
   ImmutableData();
   ImmutableData(const ImmutableData&);
@@ -45,18 +55,30 @@ class ImmutableData : public Data {
   virtual ~ImmutableData() final;
 
   const NonEmptyString& Value() const;
+  // Returns a handle sharing the value, e.g. for passing to DataBuffer::Store or
+  // tcp::Connection::Send without copying it.
+  SharedBuffer SharedValue() const;
+  // Moves the value out, leaving this uninitialised.  The value is only copied if it's still shared
+  // with a copy of this object or was adopted from a SharedBuffer.
+  NonEmptyString ReleaseValue();
 
   template <typename Archive>
   Archive& save(Archive& archive) const {
-    return archive(cereal::base_class<Data>(this), value_);
+    if (!value_)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+    return archive(cereal::base_class<Data>(this), *value_);
   }
 
   template <typename Archive>
   Archive& load(Archive& archive) {
     try {
-      archive(cereal::base_class<Data>(this), value_);
-      if (name_ != crypto::Hash<crypto::SHA512>(value_))
+      NonEmptyString value;
+      archive(cereal::base_class<Data>(this), value);
+      // Rehashing the value dominates the cost of parsing, so is skipped for trusted sources.
+      if (!IsTrustedSource(archive) && name_ != crypto::Hash<crypto::SHA512>(value))
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      value_ = std::make_shared<NonEmptyString>(std::move(value));
+      owns_value_ = true;
     } catch (const std::exception& e) {
       LOG(kWarning) << "Error parsing ImmutableData: " << boost::diagnostic_information(e);
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
@@ -65,9 +87,17 @@ class ImmutableData : public Data {
   }
 
  private:
+  ImmutableData(std::shared_ptr<const NonEmptyString> value, bool owns_value);
+  ImmutableData(Identity name, std::shared_ptr<const NonEmptyString> value, bool owns_value,
+                bool verify_name);
+
   virtual std::uint32_t ThisTypeId() const final { return 0; }
 
-  NonEmptyString value_;
+  // Immutable, so copies of an ImmutableData share the value rather than copying it.
+  std::shared_ptr<const NonEmptyString> value_;
+  // Whether 'value_' was allocated (non-const) by this class, so may be moved from by ReleaseValue
+  // once nothing else shares it.
+  bool owns_value_{false};
 };
 
 template <>
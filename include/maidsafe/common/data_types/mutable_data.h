@@ -22,6 +22,7 @@
 #include "cereal/types/base_class.hpp"
 #include "cereal/types/polymorphic.hpp"
 
+#include "maidsafe/common/config.h"
 #include "maidsafe/common/identity.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/types.h"
@@ -38,12 +39,14 @@ class MutableData : public Data {
 
   MutableData();
   MutableData(const MutableData&);
-  MutableData(MutableData&& other);
+  MutableData(MutableData&& other) MAIDSAFE_NOEXCEPT;
   MutableData& operator=(const MutableData&);
-  MutableData& operator=(MutableData&& other);
+  MutableData& operator=(MutableData&& other) MAIDSAFE_NOEXCEPT;
   virtual ~MutableData() final;
 
   const NonEmptyString& Value() const;
+  // Moves the value out, leaving this uninitialised.
+  NonEmptyString ReleaseValue();
 
   template <typename Archive>
   Archive& save(Archive& archive) const {
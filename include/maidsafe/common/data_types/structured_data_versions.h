@@ -72,20 +72,21 @@ For the purposes of deleting versions (see 'DeleteBranchUntilFork' below), the b
 #ifndef MAIDSAFE_COMMON_DATA_TYPES_STRUCTURED_DATA_VERSIONS_H_
 #define MAIDSAFE_COMMON_DATA_TYPES_STRUCTURED_DATA_VERSIONS_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <future>
-#include <map>
-#include <memory>
-#include <set>
+#include <system_error>
 #include <utility>
 #include <vector>
 
 #include "boost/optional/optional.hpp"
 
 #include "maidsafe/common/config.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/hash.h"
 #include "maidsafe/common/identity.h"
 #include "maidsafe/common/tagged_value.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/flat_hash_map.h"
 #include "maidsafe/common/data_types/immutable_data.h"
 
 namespace maidsafe {
@@ -94,13 +95,17 @@ namespace detail {
 
 struct StructuredDataVersionsCereal;
 struct StructuredDataVersionsBranchCereal;
+struct StructuredDataVersionsDeltaCereal;
 
 }  // namespace detail
 
+class ConcurrentStructuredDataVersions;
+
 // All public functions in this class provide the strong exception guarantee.
 class StructuredDataVersions {
  private:
   struct StructuredDataVersionsTag;
+  struct StructuredDataVersionsDeltaTag;
 
  public:
   struct VersionName {
@@ -125,13 +130,28 @@ class StructuredDataVersions {
   };
 
   using serialised_type = TaggedValue<NonEmptyString, StructuredDataVersionsTag>;
+  using serialised_delta_type = TaggedValue<NonEmptyString, StructuredDataVersionsDeltaTag>;
+
+  // A branch which Merge couldn't add: 'new_version' (with parent 'old_version') was rejected with
+  // 'error', and so were all its descendants.  'rejected_count' includes 'new_version'.
+  struct MergeConflict {
+    VersionName old_version, new_version;
+    std::error_code error;
+    std::size_t rejected_count;
+  };
+
+  struct MergeResult {
+    std::size_t added_count;
+    // As returned by Put, in order of removal.
+    std::vector<VersionName> removed_versions;
+    std::vector<MergeConflict> conflicts;
+  };
 
   StructuredDataVersions() = delete;
   // Construct with a limit of 'max_versions' different versions and 'max_branches' different
   // branches (or "tips of trees").  Both must be >= 1 otherwise CommonErrors::invalid_argument is
   // thrown.
   StructuredDataVersions(uint32_t max_versions, uint32_t max_branches);
-  StructuredDataVersions(const StructuredDataVersions&) = delete;
   StructuredDataVersions(StructuredDataVersions&&) = delete;
   StructuredDataVersions& operator=(StructuredDataVersions other);
   friend void swap(StructuredDataVersions& lhs, StructuredDataVersions& rhs) MAIDSAFE_NOEXCEPT;
@@ -144,6 +164,28 @@ class StructuredDataVersions {
   // maidsafe_error will be thrown.  The values for 'max_versions' and 'max_branches' will be
   // overwritten with those in 'serialised_data_versions'.
   void ApplySerialised(const serialised_type& serialised_data_versions);
+  // Merges the versions in 'serialised_data_versions' which are missing here, leaving
+  // 'max_versions' and 'max_branches' unchanged.  Unlike ApplySerialised, existing versions are
+  // only looked up rather than re-Put, and a conflict rejects only the affected branch rather than
+  // the whole merge.  Each branch is walked from its front, so parents are Put before children.
+  // * A version which exists here with a different parent is a conflict, as is any Put which
+  //   throws a maidsafe_error.  In both cases the version and its descendants are skipped.
+  // * If 'serialised_data_versions' can't be parsed, CommonErrors::parsing_error is thrown and
+  //   nothing is merged.
+  // Since the merge is applied in place, any other exception (e.g. std::bad_alloc) leaves the
+  // versions merged up to that point.
+  MergeResult Merge(const serialised_type& serialised_data_versions);
+  // Serialises only what a peer is missing, given the peer's Get() as 'since_tips' and its
+  // GetBranchFronts() as 'since_fronts'.  The delta holds each version here which isn't on one of
+  // the peer's branches (along with its parent), plus any of 'since_tips' which no longer exist
+  // here.  The result should be passed to the peer's ApplyDelta.
+  serialised_delta_type SerialiseDelta(const std::vector<VersionName>& since_tips,
+                                       const std::vector<VersionName>& since_fronts) const;
+  // Applies a delta produced by SerialiseDelta.  Any of the delta's removed versions which are
+  // "tips of trees" here are deleted via DeleteBranchUntilFork, then each new version is Put.
+  // Unlike ApplySerialised, 'max_versions' and 'max_branches' are left unchanged.  If any of the
+  // Puts throws, this SDV is left unmodified.
+  void ApplyDelta(const serialised_delta_type& serialised_delta);
 
   // Inserts the 'new_version' into the map with 'old_version' as the parent.  Returns the version
   // which was removed if any.
@@ -167,8 +209,16 @@ class StructuredDataVersions {
   // * If inserting the new version causes a circular chain parent->child->parent,
   //   CommonErrors::invalid_argument is thrown.
   boost::optional<VersionName> Put(const VersionName& old_version, const VersionName& new_version);
+  // Puts each pair of <old_version, new_version> in order, as per Put, and returns the versions
+  // which were removed (in order of removal).  If any Put throws, none of the batch is applied.
+  // The batch should be sorted so that each version's parent precedes it, otherwise versions are
+  // needlessly added as orphans and later un-orphaned.
+  std::vector<VersionName> PutMany(
+      const std::vector<std::pair<VersionName, VersionName>>& old_and_new_versions);
   // Returns all the "tips of trees" ordered from highest to lowest.
   std::vector<VersionName> Get() const;
+  // As above, but returns at most the 'max_count' highest "tips of trees".
+  std::vector<VersionName> Get(std::size_t max_count) const;
   // Returns all the versions comprising a branch, starting at the tip, through to (including) the
   // root or the orphan at the start of that branch.  e.g., in the diagram above, GetBranch(4-jjj)
   // would return <4-jjj, 3-ggg, 2-ddd, 1-bbb, 0-aaa>.  GetBranch(5-nnn) would return
@@ -177,6 +227,18 @@ class StructuredDataVersions {
   //   thrown.
   // * If 'branch_tip' doesn't exist, CommonErrors::no_such_element is thrown.
   std::vector<VersionName> GetBranch(const VersionName& branch_tip) const;
+  // A paged version of GetBranch.  Skips the first 'start' versions of the branch, then returns at
+  // most 'max_count' versions.  e.g. in the diagram, GetBranch(5-nnn, 2, 1) would return
+  // <4-kkk, 3-ggg>.  Throws as per GetBranch above.
+  std::vector<VersionName> GetBranch(const VersionName& branch_tip, std::size_t max_count,
+                                     std::size_t start) const;
+  // Calls 'visitor' with each version from 'version' through to (including) the root or the orphan
+  // at the start of that branch, without copying any of them.  'visitor' must take a
+  // const VersionName& and return a bool; iteration stops once it returns false.  Unlike GetBranch,
+  // 'version' needn't be a "tip of tree".
+  // * If 'version' doesn't exist, CommonErrors::no_such_element is thrown.
+  template <typename Visitor>
+  void VisitBranch(const VersionName& version, Visitor visitor) const;
   // Similar to GetBranch except Versions are erased through to (excluding) the first version which
   // has > 1 child, or through to (including) the first version which has 0 children.  e.g. in the
   // diagram, DeleteBranchUntilFork(4-jjj) would erase 4-jjj only.  DeleteBranchUntilFork(5-nnn)
@@ -185,95 +247,148 @@ class StructuredDataVersions {
   //   thrown.
   // * If 'branch_tip' doesn't exist, CommonErrors::no_such_element is thrown.
   void DeleteBranchUntilFork(const VersionName& branch_tip);
+  // Returns the first version of each branch, i.e. the root followed by the orphans.
+  std::vector<VersionName> GetBranchFronts() const;
   // Removes all versions from the container.
   void clear();
 
   uint32_t max_versions() const { return max_versions_; }
   uint32_t max_branches() const { return max_branches_; }
+  // The number of orphans held, i.e. of branches whose front's parent hasn't been Put.  Each is
+  // a branch in its own right, so this can't exceed 'max_branches_'.
+  std::size_t orphan_count() const { return absent_parents_.size(); }
+  // An estimate of the heap memory used to index the orphans (not including their nodes).
+  std::size_t orphan_bytes() const;
 
-  // TODO(Fraser#5#): 2013-05-14 - Do we need another GetBranch function which allows start point
-  //                  other than TOT, and/or a max_count number of versions to return?  Similarly
-  //                  DeleteBranch or Delete x from root upwards.  Maybe also LockBranch function to
-  //                  disallow further versions being added while a client is attempting to resolve
-  //                  conflicts?
+  // TODO(Fraser#5#): 2013-05-14 - Do we need DeleteBranch or Delete x from root upwards?  Maybe
+  //                  also LockBranch function to disallow further versions being added while a
+  //                  client is attempting to resolve conflicts?
 
  private:
-  struct Details;
-  using Versions = std::map<VersionName, std::shared_ptr<Details>>;
-  using Version = Versions::value_type;
-  using VersionsItr = Versions::iterator;
-  using SortedVersionsItrs = std::set<VersionsItr, std::function<bool(VersionsItr, VersionsItr)>>;
-  // The first value of the pair is the "old version" or parent ID which the orphan was added under.
-  // The expectation is that the missing parent will soon be added, allowing the second value(s) of
-  // the pair to become "un-orphaned".
-  using Orphans = std::map<VersionName, SortedVersionsItrs>;
-  using OrphanItr = std::pair<Orphans::iterator, SortedVersionsItrs::iterator>;
-  using OrphanConstItr = std::pair<Orphans::const_iterator, SortedVersionsItrs::const_iterator>;
-
-  struct Details {
-    Details();
-    explicit Details(VersionsItr parent_in);
-    Details(const Details& other);
-    Details(Details&& other);
-    Details& operator=(Details other);
-
-    VersionsItr parent;
-    SortedVersionsItrs children;
+  // Versions are held as nodes in a single contiguous vector and refer to one another by index.
+  // Each node's children form a singly-linked list (via 'first_child' and 'next_sibling') kept
+  // sorted by VersionName, and 'index_' maps each VersionName to its node.  Erasing a node moves
+  // the last node into the vacated slot, so indices are only stable between erasures.
+  using NodeIndex = uint32_t;
+  using NodeIndices = std::vector<NodeIndex>;  // Always kept sorted by VersionName.
+
+  struct VersionNameHash {
+    std::uint64_t operator()(const VersionName& name) const { return hash(name.index, name.id); }
+    SeededHash<SipHash13> hash;
+  };
+
+  // The key is the "old version" or parent ID which the orphans were added under.  The expectation
+  // is that the missing parent will soon be added, allowing the mapped orphans to become
+  // "un-orphaned".  Hashed (rather than ordered) so that the check made on every Put is O(1)
+  // however many orphans a peer has sent us; anything needing a stable order uses SortedOrphans.
+  using Orphans = FlatHashMap<VersionName, NodeIndices, VersionNameHash>;
+  // Maps each orphan to the absent parent it's held under in 'orphans_'.
+  using AbsentParents = FlatHashMap<VersionName, VersionName, VersionNameHash>;
+  using OrphanItr = std::pair<Orphans::iterator, NodeIndices::iterator>;
+  using OrphanConstItr = std::pair<Orphans::const_iterator, NodeIndices::const_iterator>;
+
+  static const NodeIndex kNoNode;
+
+  struct Node {
+    explicit Node(VersionName name_in);
+
+    VersionName name;
+    NodeIndex parent, first_child, next_sibling;
   };
-  friend void swap(Details& lhs, Details& rhs) MAIDSAFE_NOEXCEPT;
+
+  friend class ConcurrentStructuredDataVersions;
+
+  // Only used to modify a copy, giving ApplyDelta and ConcurrentStructuredDataVersions the strong
+  // exception guarantee.
+  StructuredDataVersions(const StructuredDataVersions&) = default;
 
   void ValidateLimits() const;
 
-  void BranchFromCereal(VersionsItr parent_itr,
-                        detail::StructuredDataVersionsCereal& serialised_versions,
+  void BranchFromCereal(NodeIndex parent, detail::StructuredDataVersionsCereal& serialised_versions,
                         std::size_t& serialised_branch_index);
-  VersionsItr HandleFirstVersionInBranchFromCereal(
-      VersionsItr parent_itr, detail::StructuredDataVersionsBranchCereal& serialised_branch);
+  NodeIndex HandleFirstVersionInBranchFromCereal(
+      NodeIndex parent, detail::StructuredDataVersionsBranchCereal& serialised_branch);
 
-  VersionsItr CheckedInsert(VersionName&& version);
-  void BranchToCereal(VersionsItr itr, detail::StructuredDataVersionsCereal& serialised_versions,
+  NodeIndex CheckedInsert(VersionName&& version);
+  void BranchToCereal(NodeIndex node, detail::StructuredDataVersionsCereal& serialised_versions,
                       const VersionName& absent_parent) const;
-  void BranchToCereal(VersionsItr itr, detail::StructuredDataVersionsCereal& serialised_versions,
+  void BranchToCereal(NodeIndex node, detail::StructuredDataVersionsCereal& serialised_versions,
                       detail::StructuredDataVersionsBranchCereal* serialised_branch) const;
 
-  void ApplyBranch(VersionName parent, VersionsItr itr, StructuredDataVersions& new_versions) const;
-  VersionName ParentName(VersionsItr itr) const;
-  VersionName ParentName(Versions::const_iterator itr) const;
-  VersionName RootParentName() const;
+  void ApplyBranch(VersionName parent, NodeIndex node, StructuredDataVersions& new_versions) const;
+  // Appends the versions of 'other' which are missing here to 'missing' (each along with its
+  // parent), parents before children, and records a conflict for each version of 'other' which
+  // exists here under a different parent.
+  void DiffBranch(const StructuredDataVersions& other, NodeIndex front_of_branch,
+                  const VersionName& absent_parent,
+                  std::vector<std::pair<const VersionName*, NodeIndex>>& missing,
+                  std::vector<std::size_t>& conflict_indices, MergeResult& result) const;
+  void BranchToDelta(NodeIndex front_of_branch, const VersionName& absent_parent,
+                     const std::vector<bool>& known,
+                     detail::StructuredDataVersionsDeltaCereal& delta) const;
+  NodeIndex Find(const VersionName& name) const;
   bool NewVersionPreExists(const VersionName& old_version, const VersionName& new_version) const;
-  void CheckForUnorphaning(Version& version, bool& unorphans_existing_root,
-                           size_t& unorphan_count) const;
-  std::future<void> CheckVersionNotInBranch(VersionsItr itr, const VersionName& version) const;
-  void CheckBranchCount(const Version& version, bool is_orphan, size_t unorphaned_count,
-                        bool& erase_existing_root) const;
-  boost::optional<VersionName> Insert(const Version& version, bool is_root, bool is_orphan,
-                                      const VersionName& old_version, bool unorphans_existing_root,
-                                      size_t unorphan_count, bool erase_existing_root);
-  void SetVersionAsChildOfItsParent(VersionsItr versions_itr);
-  void UnorphanRoot(VersionsItr parent, bool is_root_or_orphan, const VersionName& old_version);
-  void Unorphan(VersionsItr parent);
+  void CheckForUnorphaning(const VersionName& new_version, NodeIndex parent,
+                           bool& unorphans_existing_root, size_t& unorphan_count) const;
+  // Throws if 'candidate' is 'node' or one of its ancestors.
+  void CheckNotAncestor(NodeIndex candidate, NodeIndex node) const;
+  void CheckBranchCount(NodeIndex parent, bool is_root, bool is_orphan, size_t unorphaned_count,
+                        bool unorphans_existing_root, bool& erase_existing_root) const;
+  void ReserveForInsert();
+  boost::optional<VersionName> Insert(const VersionName& new_version, NodeIndex parent,
+                                      bool is_root, bool is_orphan, const VersionName& old_version,
+                                      bool unorphans_existing_root, size_t unorphan_count,
+                                      bool erase_existing_root);
+  void UnorphanRoot(NodeIndex parent, bool is_root_or_orphan, const VersionName& old_version);
+  void Unorphan(NodeIndex parent);
   void ReplaceRoot();
   void ReplaceRootFromOrphans();
   void ReplaceRootFromChildren();
-  SortedVersionsItrs::const_iterator FindBranchTip(const VersionName& name) const;
+  NodeIndices::iterator FindBranchTip(const VersionName& name);
+  NodeIndices::const_iterator FindBranchTip(const VersionName& name) const;
   OrphanItr FindOrphan(const VersionName& name);
   OrphanConstItr FindOrphan(const VersionName& name) const;
-  void InsertOrphan(const VersionName& absent_parent_name, VersionsItr orphan);
+  // Returns the entries of 'orphans_' ordered by absent parent.
+  std::vector<const Orphans::value_type*> SortedOrphans() const;
+  void InsertOrphan(const VersionName& absent_parent_name, NodeIndex orphan);
   void EraseOrphan(OrphanItr orphan_itr);
   void CheckBranchTipIterator(const VersionName& name,
-                              SortedVersionsItrs::const_iterator branch_tip_itr) const;
-  void EraseFrontOfBranch(VersionsItr front_of_branch);
+                              NodeIndices::const_iterator branch_tip_itr) const;
+  void EraseFrontOfBranch(NodeIndex front_of_branch);
   bool AtVersionsLimit() const;
   bool AtBranchesLimit() const;
-  void CheckedInsert(SortedVersionsItrs& container, VersionsItr element) const;
+  void AddChild(NodeIndex parent, NodeIndex child);
+  void RemoveChild(NodeIndex parent, NodeIndex child);
+  // Replaces the "tip of tree" at 'tip_of_tree_itr' with 'new_tip', keeping 'tips_of_trees_'
+  // sorted.
+  void ReplaceBranchTip(NodeIndices::iterator tip_of_tree_itr, NodeIndex new_tip);
+  void InsertSorted(NodeIndices& container, NodeIndex element) const;
+  // Erases 'node', which must already have been unlinked from its parent, children, 'root_',
+  // 'tips_of_trees_' and 'orphans_'.  Returns the former index of the node moved into its slot, or
+  // kNoNode if none was moved.
+  NodeIndex EraseNode(NodeIndex node);
 
   uint32_t max_versions_, max_branches_;
-  Versions versions_;
-  std::pair<VersionName, VersionsItr> root_;
-  SortedVersionsItrs tips_of_trees_;
+  std::vector<Node> nodes_;
+  FlatHashMap<VersionName, NodeIndex, VersionNameHash> index_;
+  VersionName root_parent_;
+  NodeIndex root_;
+  NodeIndices tips_of_trees_;
   Orphans orphans_;
+  AbsentParents absent_parents_;
 };
 
+template <typename Visitor>
+void StructuredDataVersions::VisitBranch(const VersionName& version, Visitor visitor) const {
+  auto node(Find(version));
+  if (node == kNoNode)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  for (; node != kNoNode; node = nodes_[node].parent) {
+    if (!visitor(nodes_[node].name))
+      return;
+  }
+}
+
 void swap(StructuredDataVersions::VersionName& lhs,
           StructuredDataVersions::VersionName& rhs) MAIDSAFE_NOEXCEPT;
 
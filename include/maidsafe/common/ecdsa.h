@@ -0,0 +1,129 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_ECDSA_H_
+#define MAIDSAFE_COMMON_ECDSA_H_
+
+// Elliptic-curve signing using ECDSA over NIST P-256 with SHA-256.  The API mirrors the signing
+// parts of rsa.h.  Signing is much cheaper than with 2048-bit RSA and signatures are 64 bytes
+// rather than 256, but verification is slower than RSA's, so this suits new data types where
+// signatures are stored or sent in bulk.
+
+#include <string>
+
+// Include this first to avoid having to wrap the cryptopp includes in a pragma to disable warnings
+#include "maidsafe/common/crypto.h"  // NOLINT
+
+#include "cryptopp/eccrypto.h"
+
+#include "maidsafe/common/bounded_string.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace ecdsa {
+
+using PrivateKey = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey;
+using PublicKey = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PublicKey;
+
+struct Keys {
+  // Signatures are the concatenation of the two 256-bit integers r and s.
+  enum { kKeyBitSize = 256, kSignatureByteSize = 2 * kKeyBitSize / 8 };
+
+  Keys() = default;
+  Keys(const Keys&) = default;
+  Keys(Keys&& other)
+      : private_key(std::move(other.private_key)), public_key(std::move(other.public_key)) {}
+  ~Keys() = default;
+  Keys& operator=(const Keys&) = default;
+  Keys& operator=(Keys&& other) {
+    private_key = std::move(other.private_key);
+    public_key = std::move(other.public_key);
+    return *this;
+  }
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(private_key, public_key);
+  }
+
+  PrivateKey private_key;
+  PublicKey public_key;
+};
+
+using EncodedPublicKey = detail::BoundedString<2>;
+using EncodedPrivateKey = detail::BoundedString<3>;
+
+using PlainText = NonEmptyString;
+using Signature =
+    maidsafe::detail::BoundedString<Keys::kSignatureByteSize, Keys::kSignatureByteSize>;
+
+Keys GenerateKeyPair();
+
+Signature Sign(const PlainText& data, const PrivateKey& private_key);
+
+bool CheckSignature(const PlainText& data, const Signature& signature, const PublicKey& public_key);
+
+EncodedPrivateKey EncodeKey(const PrivateKey& private_key);
+
+EncodedPublicKey EncodeKey(const PublicKey& public_key);
+
+PrivateKey DecodeKey(const EncodedPrivateKey& private_key);
+
+PublicKey DecodeKey(const EncodedPublicKey& public_key);
+
+bool MatchingKeys(const PrivateKey& private_key1, const PrivateKey& private_key2);
+
+bool MatchingKeys(const PublicKey& public_key1, const PublicKey& public_key2);
+
+}  // namespace ecdsa
+
+}  // namespace maidsafe
+
+namespace cereal {
+
+template <typename Archive>
+void save(Archive& archive, const maidsafe::ecdsa::PrivateKey& private_key) {
+  auto encoded_key = maidsafe::ecdsa::EncodeKey(private_key);
+  archive(encoded_key);
+}
+
+template <typename Archive>
+void save(Archive& archive, const maidsafe::ecdsa::PublicKey& public_key) {
+  auto encoded_key = maidsafe::ecdsa::EncodeKey(public_key);
+  archive(encoded_key);
+}
+
+template <typename Archive>
+void load(Archive& archive, maidsafe::ecdsa::PrivateKey& private_key) {
+  auto encoded_key = maidsafe::ecdsa::EncodedPrivateKey{};
+  archive(encoded_key);
+  private_key = maidsafe::ecdsa::DecodeKey(encoded_key);
+}
+
+template <typename Archive>
+void load(Archive& archive, maidsafe::ecdsa::PublicKey& public_key) {
+  auto encoded_key = maidsafe::ecdsa::EncodedPublicKey{};
+  archive(encoded_key);
+  public_key = maidsafe::ecdsa::DecodeKey(encoded_key);
+}
+
+}  // namespace cereal
+
+#endif  // MAIDSAFE_COMMON_ECDSA_H_
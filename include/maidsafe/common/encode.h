@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_COMMON_ENCODE_H_
 #define MAIDSAFE_COMMON_ENCODE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -36,25 +37,26 @@ class BoundedString;
 
 namespace hex {
 
-namespace detail {
-
-const unsigned char alphabet[] = "0123456789abcdef";
+// Returns the number of chars in the hex encoding of 'size' bytes.
+inline std::size_t EncodedSize(std::size_t size) { return size * 2; }
 
-const unsigned char lookup[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0,
-                                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0,
-                                0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7,  8,  9,  0,  0,  0, 0, 0,
-                                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0, 0, 0,
-                                0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 10, 11, 12, 13, 14, 15};
+// Writes the hex encoding of the 'size' bytes at 'input' to 'output', which must have space for
+// EncodedSize(size) chars.  Returns a pointer to the char following the last one written.  Doesn't
+// throw.
+char* EncodeTo(const unsigned char* input, std::size_t size, char* output);
 
-}  // namespace detail
+// Writes the 'size / 2' bytes hex-encoded by the 'size' chars at 'input' to 'output'.  Upper and
+// lower case digits are accepted.  Returns false if 'size' is odd or if 'input' contains any
+// non-hex chars, in which case 'output' may be partially written.  Doesn't throw.
+bool DecodeTo(const char* input, std::size_t size, unsigned char* output);
 
 template <typename T>
 std::string Encode(const T& non_hex_input) {
-  auto size(non_hex_input.size());
-  std::string hex_output(size * 2, 0);
-  for (std::size_t i(0), j(0); i != size; ++i) {
-    hex_output[j++] = detail::alphabet[static_cast<unsigned char>(non_hex_input[i]) / 16];
-    hex_output[j++] = detail::alphabet[static_cast<unsigned char>(non_hex_input[i]) % 16];
+  const auto size(non_hex_input.size());
+  std::string hex_output(EncodedSize(size), 0);
+  if (size != 0) {
+    EncodeTo(reinterpret_cast<const unsigned char*>(non_hex_input.data()), size,
+             &hex_output[0]);
   }
   return hex_output;
 }
@@ -67,10 +69,19 @@ std::string DecodeToString(const std::string& hex_input);
 
 std::vector<unsigned char> DecodeToBytes(const std::string& hex_input);
 
-// Returns an abbreviated hex representation of 'non_hex_input'.
+// Returns an abbreviated hex representation of 'non_hex_input'.  Only the bytes which appear in the
+// result are encoded.
 template <typename T>
 std::string Substr(const T& non_hex_input) {
-  return maidsafe::detail::GetSubstr(Encode(non_hex_input));
+  const std::size_t kEndSize(3);
+  const auto size(non_hex_input.size());
+  if (size <= 2 * kEndSize + 1)
+    return Encode(non_hex_input);
+  const auto data(reinterpret_cast<const unsigned char*>(non_hex_input.data()));
+  std::string hex_output(EncodedSize(2 * kEndSize) + 2, '.');
+  EncodeTo(data, kEndSize, &hex_output[0]);
+  EncodeTo(data + size - kEndSize, kEndSize, &hex_output[EncodedSize(kEndSize) + 2]);
+  return hex_output;
 }
 
 }  // namespace hex
@@ -79,48 +90,31 @@ std::string Substr(const T& non_hex_input) {
 
 namespace base64 {
 
-namespace detail {
+// Returns the number of chars in the base-64 encoding of 'size' bytes.
+inline std::size_t EncodedSize(std::size_t size) { return ((size + 2) / 3) * 4; }
 
-const unsigned char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+// Returns the maximum number of bytes which 'size' base-64 chars can encode.
+inline std::size_t MaxDecodedSize(std::size_t size) { return (size / 4) * 3; }
 
-const unsigned char pad_character('=');
+// Writes the base-64 encoding of the 'size' bytes at 'input' to 'output', which must have space
+// for EncodedSize(size) chars.  Returns a pointer to the char following the last one written.
+// Doesn't throw.
+char* EncodeTo(const unsigned char* input, std::size_t size, char* output);
 
-}  // namespace detail
+// Writes the bytes base-64 encoded by the 'size' chars at 'input' to 'output', which must have
+// space for MaxDecodedSize(size) bytes, and sets 'decoded_size' to the number written.  Returns
+// false if 'size' isn't a multiple of 4 or if 'input' is otherwise invalid, in which case 'output'
+// may be partially written.  Doesn't throw.
+bool DecodeTo(const char* input, std::size_t size, unsigned char* output,
+              std::size_t& decoded_size);
 
-// hacked from https://en.wikibooks.org/wiki/Algorithm_Implementation/Miscellaneous/Base64
 template <typename T>
 std::string Encode(const T& non_base64_input) {
-  std::string encoded_string(
-      ((non_base64_input.size() / 3) + (non_base64_input.size() % 3 > 0)) * 4, 0);
-  std::int32_t temp;
-  auto cursor = non_base64_input.begin();
-  std::size_t i = 0;
-  std::size_t common_output_size((non_base64_input.size() / 3) * 4);
-  while (i < common_output_size) {
-    temp = static_cast<std::uint8_t>(*cursor++) << 16;  // Convert to big endian
-    temp += static_cast<std::uint8_t>(*cursor++) << 8;
-    temp += static_cast<std::uint8_t>(*cursor++);
-    encoded_string[i++] = detail::alphabet[(temp & 0x00FC0000) >> 18];
-    encoded_string[i++] = detail::alphabet[(temp & 0x0003F000) >> 12];
-    encoded_string[i++] = detail::alphabet[(temp & 0x00000FC0) >> 6];
-    encoded_string[i++] = detail::alphabet[(temp & 0x0000003F)];
-  }
-  switch (non_base64_input.size() % 3) {
-    case 1:
-      temp = static_cast<std::uint8_t>(*cursor++) << 16;  // Convert to big endian
-      encoded_string[i++] = detail::alphabet[(temp & 0x00FC0000) >> 18];
-      encoded_string[i++] = detail::alphabet[(temp & 0x0003F000) >> 12];
-      encoded_string[i++] = detail::pad_character;
-      encoded_string[i++] = detail::pad_character;
-      break;
-    case 2:
-      temp = static_cast<std::uint8_t>(*cursor++) << 16;  // Convert to big endian
-      temp += static_cast<std::uint8_t>(*cursor++) << 8;
-      encoded_string[i++] = detail::alphabet[(temp & 0x00FC0000) >> 18];
-      encoded_string[i++] = detail::alphabet[(temp & 0x0003F000) >> 12];
-      encoded_string[i++] = detail::alphabet[(temp & 0x00000FC0) >> 6];
-      encoded_string[i++] = detail::pad_character;
-      break;
+  const auto size(non_base64_input.size());
+  std::string encoded_string(EncodedSize(size), 0);
+  if (size != 0) {
+    EncodeTo(reinterpret_cast<const unsigned char*>(non_base64_input.data()), size,
+             &encoded_string[0]);
   }
   return encoded_string;
 }
@@ -133,6 +127,38 @@ std::string DecodeToString(const std::string& base64_input);
 
 std::vector<unsigned char> DecodeToBytes(const std::string& base64_input);
 
+// Encodes a stream of bytes passed in arbitrary chunks.  Each call to Update appends the encoding
+// of all complete 3-byte groups received so far to 'output'; Finalise appends the encoding of any
+// remaining bytes, with padding, and resets the encoder for reuse.
+class Encoder {
+ public:
+  Encoder() : pending_(), pending_size_(0) {}
+  void Update(const unsigned char* input, std::size_t size, std::string& output);
+  void Finalise(std::string& output);
+
+ private:
+  unsigned char pending_[2];
+  std::size_t pending_size_;
+};
+
+// Decodes a stream of base-64 chars passed in arbitrary chunks.  Each call to Update appends the
+// bytes decoded from all complete 4-char groups received so far to 'output', and returns false if
+// the input is invalid (including if any follows a padded group).  Finalise returns false if the
+// stream ended part-way through a group, and resets the decoder for reuse.  Neither throws.
+class Decoder {
+ public:
+  Decoder() : pending_(), pending_size_(0), finished_(false) {}
+  bool Update(const char* input, std::size_t size, std::string& output);
+  bool Finalise();
+
+ private:
+  bool DecodeChunk(const char* input, std::size_t size, std::string& output);
+
+  char pending_[4];
+  std::size_t pending_size_;
+  bool finished_;
+};
+
 // Returns an abbreviated base-64 representation of 'non_base64_input'.
 template <typename T>
 std::string Substr(const T& non_base64_input) {
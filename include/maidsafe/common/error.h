@@ -20,6 +20,8 @@
 #define MAIDSAFE_COMMON_ERROR_H_
 
 #include <cstdint>
+#include <exception>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -34,18 +36,27 @@ class maidsafe_error;
 int32_t ErrorToInt(maidsafe_error error);
 maidsafe_error IntToError(int32_t);
 
-class maidsafe_error : public std::system_error {
+// Has the same interface as std::system_error (code() and what()), but only formats the message
+// returned by what() when that is first called, rather than on construction.  So making, copying
+// and throwing an error constructed from just a code doesn't allocate, which matters where errors
+// such as CommonErrors::no_such_element are an expected outcome.  The message is the same as
+// std::system_error's: the code's message, preceded by 'what_arg' and ": " if that's given.
+class maidsafe_error : public std::exception {
  public:
-  maidsafe_error() : std::system_error(std::error_code()) {}
-  maidsafe_error(std::error_code ec, const std::string& what_arg)
-      : std::system_error(ec, what_arg) {}
-  maidsafe_error(std::error_code ec, const char* what_arg) : std::system_error(ec, what_arg) {}
-  explicit maidsafe_error(std::error_code ec) : std::system_error(ec) {}
-  maidsafe_error(int ev, const std::error_category& ecat, const std::string& what_arg)
-      : std::system_error(ev, ecat, what_arg) {}
-  maidsafe_error(int ev, const std::error_category& ecat, const char* what_arg)
-      : std::system_error(ev, ecat, what_arg) {}
-  maidsafe_error(int ev, const std::error_category& ecat) : std::system_error(ev, ecat) {}
+  maidsafe_error() MAIDSAFE_NOEXCEPT : code_(), what_() {}
+  maidsafe_error(std::error_code ec, const std::string& what_arg);
+  maidsafe_error(std::error_code ec, const char* what_arg);
+  explicit maidsafe_error(std::error_code ec) MAIDSAFE_NOEXCEPT : code_(ec), what_() {}
+  maidsafe_error(int ev, const std::error_category& ecat, const std::string& what_arg);
+  maidsafe_error(int ev, const std::error_category& ecat, const char* what_arg);
+  maidsafe_error(int ev, const std::error_category& ecat) MAIDSAFE_NOEXCEPT
+      : code_(ev, ecat), what_() {}
+  maidsafe_error(const maidsafe_error& other) MAIDSAFE_NOEXCEPT;
+  maidsafe_error& operator=(const maidsafe_error& other) MAIDSAFE_NOEXCEPT;
+  ~maidsafe_error() MAIDSAFE_NOEXCEPT override {}
+
+  const std::error_code& code() const MAIDSAFE_NOEXCEPT { return code_; }
+  const char* what() const MAIDSAFE_NOEXCEPT override;
 
   template <typename Archive>
   void save(Archive& archive) const {
@@ -58,6 +69,13 @@ class maidsafe_error : public std::system_error {
     archive(error_as_int);
     *this = IntToError(error_as_int);
   }
+
+ private:
+  std::error_code code_;
+  // Null until what() is first called, unless a 'what_arg' was given.  Only accessed via the atomic
+  // shared_ptr functions, since an error held in an exception_ptr or future can be inspected from
+  // several threads at once.
+  mutable std::shared_ptr<const std::string> what_;
 };
 
 enum class CommonErrors {
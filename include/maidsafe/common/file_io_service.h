@@ -0,0 +1,79 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_FILE_IO_SERVICE_H_
+#define MAIDSAFE_COMMON_FILE_IO_SERVICE_H_
+
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace detail {
+class FileIoBackend;
+}  // namespace detail
+
+// Reads, writes and removes whole files without blocking the caller, with completion handlers
+// posted to an AsioService.  On Linux, reads and writes are submitted to the kernel via io_uring,
+// so up to 'queue_depth' of them are in flight at once without a thread each; opening, closing and
+// removing files are done by the single thread which drives the ring.  Elsewhere, or where io_uring
+// isn't available (kernels older than 5.1, or where it's disabled), each operation runs as a
+// blocking call on a pool of up to 'queue_depth' threads.
+//
+// Operations beyond 'queue_depth' are queued.  There is no ordering between operations, even on the
+// same file.
+class FileIoService {
+ public:
+  enum class Backend { kIoUring, kThreadPool };
+  using ReadHandler = std::function<void(std::error_code, std::vector<byte>)>;
+  using Handler = std::function<void(std::error_code)>;
+
+  // Throws CommonErrors::invalid_argument if 'queue_depth' is 0.  If 'preferred' is kIoUring and
+  // io_uring isn't available, kThreadPool is used instead.
+  FileIoService(AsioService& asio_service, unsigned queue_depth = 64,
+                Backend preferred = Backend::kIoUring);
+  // Waits for all outstanding operations to complete and their handlers to be posted.
+  ~FileIoService();
+  FileIoService(const FileIoService&) = delete;
+  FileIoService(FileIoService&&) = delete;
+  FileIoService& operator=(FileIoService) = delete;
+
+  void ReadFile(boost::filesystem::path file_path, ReadHandler handler);
+  // Creates or replaces the file.  With Durability::kData, the handler isn't invoked until the
+  // contents have been flushed to the device.
+  void WriteFile(boost::filesystem::path file_path, std::vector<byte> content, Handler handler,
+                 WriteFileOptions::Durability durability = WriteFileOptions::Durability::kNone);
+  void RemoveFile(boost::filesystem::path file_path, Handler handler);
+
+  Backend backend() const;
+
+ private:
+  std::unique_ptr<detail::FileIoBackend> backend_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_FILE_IO_SERVICE_H_
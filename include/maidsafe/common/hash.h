@@ -20,8 +20,10 @@
 
 #include "maidsafe/common/hash/hash_algorithms.h"
 #include "maidsafe/common/hash/hash_array.h"
+#include "maidsafe/common/hash/hash_bounded_string.h"
 #include "maidsafe/common/hash/hash_contiguous.h"
 #include "maidsafe/common/hash/hash_data_range.h"
+#include "maidsafe/common/hash/hash_fixed_string.h"
 #include "maidsafe/common/hash/hash_forward_list.h"
 #include "maidsafe/common/hash/hash_initializer_list.h"
 #include "maidsafe/common/hash/hash_iterator_range.h"
@@ -31,8 +33,10 @@
 #include "maidsafe/common/hash/hash_pair.h"
 #include "maidsafe/common/hash/hash_range.h"
 #include "maidsafe/common/hash/hash_set.h"
+#include "maidsafe/common/hash/hash_small_string.h"
 #include "maidsafe/common/hash/hash_string.h"
 #include "maidsafe/common/hash/hash_string_ref.h"
+#include "maidsafe/common/hash/hash_tagged_value.h"
 #include "maidsafe/common/hash/hash_tuple.h"
 #include "maidsafe/common/hash/hash_vector.h"
 #include "maidsafe/common/hash/hash_wrappers.h"
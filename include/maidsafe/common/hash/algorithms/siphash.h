@@ -20,6 +20,7 @@
 #define MAIDSAFE_COMMON_HASH_ALGORITHMS_SIPHASH_H_
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 #include "maidsafe/common/config.h"
@@ -28,12 +29,16 @@
 
 namespace maidsafe {
 
-class SipHash : public detail::HashAlgorithmBase<SipHash> {
+// SipHash-c-d, where 'CompressionRounds' and 'FinalizationRounds' are c and d.  Use the SipHash
+// (SipHash-2-4) or SipHash13 (SipHash-1-3) aliases below.
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+class BasicSipHash : public detail::HashAlgorithmBase<BasicSipHash<CompressionRounds,
+                                                                  FinalizationRounds>> {
  private:
   static const std::size_t kKeySize = 16;
 
  public:
-  explicit SipHash(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT;
+  explicit BasicSipHash(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT;
 
   void Update(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT;
 
@@ -41,8 +46,15 @@ class SipHash : public detail::HashAlgorithmBase<SipHash> {
      added and then properly finalized later. */
   std::uint64_t Finalize() const MAIDSAFE_NOEXCEPT;
 
+  // Writes the hash of each of the 'count' keys 'keys[i]' of 'sizes[i]' bytes to 'hashes[i]'.  The
+  // results match hashing each key separately.  On CPUs supporting AVX2, runs of 8 or 4 keys with
+  // the same number of whole 8-byte words (e.g. all fixed-size keys) are hashed in SIMD lanes.
+  static void HashMany(const std::array<byte, kKeySize>& seed, const byte* const* keys,
+                       const std::size_t* sizes, std::size_t count,
+                       std::uint64_t* hashes) MAIDSAFE_NOEXCEPT;
+
  private:
-  unsigned Compress(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT;
+  void Compress(std::uint64_t word) MAIDSAFE_NOEXCEPT;
 
   std::uint64_t v0;
   std::uint64_t v1;
@@ -53,6 +65,14 @@ class SipHash : public detail::HashAlgorithmBase<SipHash> {
   std::uint8_t b;
 };
 
+// The standard variant, as recommended for keyed hashing of untrusted input.
+using SipHash = BasicSipHash<2, 4>;
+// A faster variant with fewer rounds, as used by several languages' hash tables.
+using SipHash13 = BasicSipHash<1, 3>;
+
+extern template class BasicSipHash<2, 4>;
+extern template class BasicSipHash<1, 3>;
+
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_COMMON_HASH_ALGORITHMS_SIPHASH_H_
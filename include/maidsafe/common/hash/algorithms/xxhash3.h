@@ -0,0 +1,66 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_HASH_ALGORITHMS_XXHASH3_H_
+#define MAIDSAFE_COMMON_HASH_ALGORITHMS_XXHASH3_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/hash/algorithms/hash_algorithm_base.h"
+
+namespace maidsafe {
+
+// The 64-bit variant of XXH3 (xxHash 0.8), with incremental input; results match the reference
+// XXH3_64bits_withSeed().  Much faster than SipHash, but with no resistance to hash flooding, so
+// only use it for tables whose keys aren't attacker-controlled.  The 128-bit seed is folded to
+// XXH3's 64-bit seed by XORing its halves.
+class XxHash3 : public detail::HashAlgorithmBase<XxHash3> {
+ private:
+  static const std::size_t kKeySize = 16;
+
+ public:
+  explicit XxHash3(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT;
+
+  void Update(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT;
+
+  // Finalizes the hash, but does not modify internal state.  More data can be added and then
+  // properly finalized later.
+  std::uint64_t Finalize() const MAIDSAFE_NOEXCEPT;
+
+ private:
+  static const std::size_t kSecretSize = 192;
+  static const std::size_t kBufferSize = 256;
+
+  std::uint64_t seed_;
+  std::uint64_t total_length_;
+  std::size_t buffered_length_;
+  std::size_t stripes_so_far_;
+  std::array<std::uint64_t, 8> accumulators_;
+  // Inputs of up to 240 bytes are hashed from the buffer without using the accumulators, so the
+  // seed-derived secret used for longer inputs is only generated once the buffer first fills.
+  std::array<byte, kSecretSize> secret_;
+  std::array<byte, kBufferSize> buffer_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_HASH_ALGORITHMS_XXHASH3_H_
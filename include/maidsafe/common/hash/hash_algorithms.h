@@ -21,5 +21,7 @@
 
 #include "maidsafe/common/hash/algorithms/hash_algorithm_base.h"
 #include "maidsafe/common/hash/algorithms/siphash.h"
+#include "maidsafe/common/hash/algorithms/wyhash.h"
+#include "maidsafe/common/hash/algorithms/xxhash3.h"
 
 #endif  // MAIDSAFE_COMMON_HASH_HASH_ALGORITHMS_H_
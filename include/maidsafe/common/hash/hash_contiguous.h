@@ -25,7 +25,10 @@
 
 namespace maidsafe {
 
-// Integral types are hashed directly.
+// Types whose object representation can be fed straight to the hash algorithm.  Integral types
+// qualify by default; others opt in by specialising this trait (see hash_pair.h and
+// hash_tagged_value.h).  Ranges of such types exposing .data() are then hashed with a single Update
+// call (see hash_data_range.h) rather than element by element.
 template <typename Integral, typename Enable = void>
 struct IsContiguousHashable : std::is_integral<Integral> {};
 
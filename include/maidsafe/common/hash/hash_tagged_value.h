@@ -0,0 +1,44 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_HASH_HASH_TAGGED_VALUE_H_
+#define MAIDSAFE_COMMON_HASH_HASH_TAGGED_VALUE_H_
+
+#include <type_traits>
+
+#include "maidsafe/common/hash/hash_contiguous.h"
+#include "maidsafe/common/tagged_value.h"
+
+namespace maidsafe {
+
+// A tag adds no state, so a TaggedValue can be "hashed over" whenever its wrapped value can.  This
+// lets ranges of e.g. DataTypeId be fed to the algorithm in a single Update call.
+template <typename T, typename Tag>
+struct IsContiguousHashable<TaggedValue<T, Tag>>
+    : std::integral_constant<bool, IsContiguousHashable<T>::value &&
+                                       sizeof(TaggedValue<T, Tag>) == sizeof(T)> {};
+
+template <typename HashAlgorithm, typename T, typename Tag>
+typename std::enable_if<!IsContiguousHashable<TaggedValue<T, Tag>>::value>::type HashAppend(
+    HashAlgorithm& hash, const TaggedValue<T, Tag>& value) {
+  hash(value.data);
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_HASH_HASH_TAGGED_VALUE_H_
@@ -30,7 +30,7 @@ template <typename HashAlgorithm>
 class SeededHash {
  public:
   SeededHash() : seed_128bit_() {
-    CryptoPP::RandomNumberGenerator& random = maidsafe::crypto::random_number_generator();
+    CryptoPP::RandomNumberGenerator& random = maidsafe::crypto::fast_random_number_generator();
     random.GenerateBlock(seed_128bit_.data(), seed_128bit_.size());
   }
 
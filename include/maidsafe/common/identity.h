@@ -19,11 +19,18 @@
 #ifndef MAIDSAFE_COMMON_IDENTITY_H_
 #define MAIDSAFE_COMMON_IDENTITY_H_
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <future>
+#include <iterator>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "boost/expected/expected.hpp"
+
 #include "maidsafe/common/bounded_string.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/tagged_value.h"
@@ -32,16 +39,105 @@ namespace maidsafe {
 
 const std::size_t identity_size = 64;
 
-using Identity = detail::BoundedString<identity_size, identity_size>;
+// The ID is held inline rather than in a std::vector, so copying or comparing IDs doesn't allocate
+// or chase a pointer.
+using Identity =
+    detail::BoundedString<identity_size, identity_size, detail::FixedString<identity_size>>;
 
 // Checks if 'id1' is closer in XOR distance to 'target_id' than 'id2'.  Will throw if
 // IsInitialised() is false for any of the args.
 bool CloserToTarget(const Identity& id1, const Identity& id2, const Identity& target_id);
 
+// As for CloserToTarget, but returns CommonErrors::invalid_identity rather than throwing.  Note
+// that the result must be dereferenced to get the comparison; the expected itself only converts to
+// true or false depending on whether there was an error.
+boost::expected<bool, common_error> TryCloserToTarget(const Identity& id1, const Identity& id2,
+                                                      const Identity& target_id);
+
 // Number of most significant bits which are common to 'id1' and 'id2'.  Will throw if
 // IsInitialised() is false for either of the args.
 int CommonLeadingBits(const Identity& id1, const Identity& id2);
 
+namespace detail {
+
+// The XOR distance between two IDs as a series of big-endian words, so that comparing two such
+// distances lexicographically (e.g. using operator<) is equivalent to comparing them bytewise.
+using XorDistance = std::array<uint64_t, identity_size / 8>;
+
+// Keeps the 'count' closest to 'target_id' of the IDs offered to it.  Most IDs are rejected after
+// comparing just their leading eight bytes.  Ties are broken in favour of the lower position.
+class ClosestSelector {
+ public:
+  // Throws if 'target_id' is uninitialised.
+  ClosestSelector(const Identity& target_id, std::size_t count);
+
+  // Throws if 'id' is uninitialised.
+  void Offer(const Identity& id, std::size_t position);
+  void Merge(const ClosestSelector& other);
+  // Returns the positions of the selected IDs, ordered from closest.
+  std::vector<std::size_t> Positions() const;
+
+ private:
+  using Entry = std::pair<XorDistance, std::size_t>;
+  Identity target_id_;
+  std::size_t count_;
+  // Max-heap, i.e. the furthest selected entry is at the front.
+  std::vector<Entry> heap_;
+};
+
+// Returns the number of threads to use when selecting from 'size' IDs.
+std::size_t ClosestSelectorThreadCount(std::size_t size, bool parallel);
+
+struct IdentityOf {
+  const Identity& operator()(const Identity& id) const { return id; }
+};
+
+}  // namespace detail
+
+// Returns iterators to the (at most) 'count' elements of [first, last) closest in XOR distance to
+// 'target_id', ordered from closest, where 'get_id' returns a const reference to the Identity of
+// an element.  This gives the same order as a partial_sort using CloserToTarget, but compares each
+// element against the target only once, and usually only by its leading eight bytes.  If
+// 'parallel' is true, large ranges are split across several threads.  Will throw if
+// IsInitialised() is false for 'target_id' or any element's ID.
+template <typename RandomAccessIterator, typename GetId>
+std::vector<RandomAccessIterator> ClosestIdentities(RandomAccessIterator first,
+                                                    RandomAccessIterator last,
+                                                    const Identity& target_id, std::size_t count,
+                                                    GetId get_id, bool parallel = false) {
+  auto select([&](std::size_t begin, std::size_t end) -> detail::ClosestSelector {
+    detail::ClosestSelector selector(target_id, count);
+    for (std::size_t position(begin); position != end; ++position)
+      selector.Offer(get_id(first[position]), position);
+    return selector;
+  });
+
+  const std::size_t size(static_cast<std::size_t>(std::distance(first, last)));
+  const std::size_t thread_count(detail::ClosestSelectorThreadCount(size, parallel));
+  const std::size_t chunk_size((size + thread_count - 1) / thread_count);
+  std::vector<std::future<detail::ClosestSelector>> chunks;
+  for (std::size_t begin(chunk_size); begin < size; begin += chunk_size) {
+    chunks.push_back(
+        std::async(std::launch::async, select, begin, std::min(size, begin + chunk_size)));
+  }
+  detail::ClosestSelector closest(select(0, chunk_size));
+  for (auto& chunk : chunks)
+    closest.Merge(chunk.get());
+
+  std::vector<RandomAccessIterator> result;
+  for (std::size_t position : closest.Positions())
+    result.push_back(first + position);
+  return result;
+}
+
+template <typename RandomAccessIterator>
+std::vector<RandomAccessIterator> ClosestIdentities(RandomAccessIterator first,
+                                                    RandomAccessIterator last,
+                                                    const Identity& target_id, std::size_t count,
+                                                    bool parallel = false) {
+  return ClosestIdentities(first, last, target_id, count, detail::IdentityOf(), parallel);
+}
+
 
 
 namespace binary {
@@ -51,6 +147,16 @@ using String = TaggedValue<std::string, struct BinaryTag>;
 // Encoded representation of the ID.  Will throw if id.IsInitialised() is false.
 std::string Encode(const Identity& id);
 
+const std::size_t kEncodedIdentitySize = 8 * identity_size;
+
+// Writes the kEncodedIdentitySize chars of the encoded ID to 'output'.  Returns false, without
+// writing anything, if id.IsInitialised() is false.  Doesn't throw.
+bool EncodeTo(const Identity& id, char* output);
+
+// Decodes the 'size' chars at 'input' into 'id'.  Returns false, leaving 'id' unchanged, if the
+// input isn't a valid encoding of an ID.  Doesn't throw.
+bool DecodeTo(const char* input, std::size_t size, Identity& id);
+
 }  // namespace binary
 
 
@@ -62,6 +168,16 @@ using String = TaggedValue<std::string, struct HexTag>;
 // Encoded representation of the ID.  Will throw if id.IsInitialised() is false.
 std::string Encode(const Identity& id);
 
+const std::size_t kEncodedIdentitySize = 2 * identity_size;
+
+// Writes the kEncodedIdentitySize chars of the encoded ID to 'output'.  Returns false, without
+// writing anything, if id.IsInitialised() is false.  Doesn't throw.
+bool EncodeTo(const Identity& id, char* output);
+
+// Decodes the 'size' chars at 'input' into 'id'.  Returns false, leaving 'id' unchanged, if the
+// input isn't a valid encoding of an ID.  Doesn't throw.
+bool DecodeTo(const char* input, std::size_t size, Identity& id);
+
 }  // namespace hex
 
 
@@ -73,6 +189,16 @@ using String = TaggedValue<std::string, struct Base64Tag>;
 // Encoded representation of the ID.  Will throw if id.IsInitialised() is false.
 std::string Encode(const Identity& id);
 
+const std::size_t kEncodedIdentitySize = ((identity_size + 2) / 3) * 4;
+
+// Writes the kEncodedIdentitySize chars of the encoded ID to 'output'.  Returns false, without
+// writing anything, if id.IsInitialised() is false.  Doesn't throw.
+bool EncodeTo(const Identity& id, char* output);
+
+// Decodes the 'size' chars at 'input' into 'id'.  Returns false, leaving 'id' unchanged, if the
+// input isn't a valid encoding of an ID.  Doesn't throw.
+bool DecodeTo(const char* input, std::size_t size, Identity& id);
+
 }  // namespace base64
 
 
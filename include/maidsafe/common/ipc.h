@@ -19,12 +19,19 @@
 #ifndef MAIDSAFE_COMMON_IPC_H_
 #define MAIDSAFE_COMMON_IPC_H_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
 
 #include "boost/interprocess/managed_shared_memory.hpp"
 #include "boost/interprocess/containers/string.hpp"
+#include "boost/utility/string_ref.hpp"
+
+#include "maidsafe/common/types.h"
 
 namespace maidsafe {
 
@@ -37,11 +44,8 @@ namespace ipc {
 // http://www.boost.org/doc/libs/release/doc/html/interprocess.html
 
 // This is an extreme simplification of boost::ipc to allow simple types to be passed.
-// there is no mem trimming at all, we always use the full 65536 bytes
-// there is also only the ability to have one item in the SHM
-// increasing number of items is trivial if required and is done by naming
-// each instance (where now we have "a" declared) and adding several
-// items to the SHM. "a" is used here to make mem surfing a little harder
+// Each item is stored with its length, so may hold arbitrary binary data, under the name of its
+// index ("0", "1", ...).  The segment is sized to fit the items, then trimmed.
 namespace bi = boost::interprocess;
 typedef bi::allocator<char, bi::managed_shared_memory::segment_manager> CharAllocator;
 typedef bi::basic_string<char, std::char_traits<char>, CharAllocator> bi_string;
@@ -49,8 +53,96 @@ typedef bi::basic_string<char, std::char_traits<char>, CharAllocator> bi_string;
 
 void RemoveSharedMemory(std::string name);
 void CreateSharedMemory(std::string name, std::vector<std::string> items);
+void CreateSharedMemory(std::string name, const std::vector<std::vector<byte>>& items);
+// Throws CommonErrors::no_such_element if the segment holds fewer than 'number' items.
 std::vector<std::string> ReadSharedMemory(std::string name, int number);
 
+// Maps a segment written by CreateSharedMemory and gives access to its items in place, without
+// copying them.  The views are valid for the lifetime of this object.
+class SharedMemoryView {
+ public:
+  explicit SharedMemoryView(std::string name);
+  SharedMemoryView(const SharedMemoryView&) = delete;
+  SharedMemoryView(SharedMemoryView&&) = delete;
+  SharedMemoryView& operator=(SharedMemoryView) = delete;
+
+  std::size_t size() const { return items_.size(); }
+  // Throws CommonErrors::no_such_element if 'index' >= size().
+  boost::string_ref Item(std::size_t index) const;
+
+ private:
+  bi::managed_shared_memory segment_;
+  std::vector<boost::string_ref> items_;
+};
+
+// A one-way channel for variable-length messages between processes, via a ring buffer in shared
+// memory.  Messages are copied in and out unencoded, and in the steady state (the receiver keeping
+// up, and the buffer not full) sending and receiving make no system calls.  A blocked receiver or
+// sender is woken via a futex on Linux; elsewhere it polls with a backoff of up to a millisecond.
+//
+// The ChannelReceiver creates the channel (replacing any existing one of the same name) and removes
+// it on destruction; ChannelSenders open an existing channel.  A channel created for
+// ChannelProducers::kSingle may only have one ChannelSender at a time.
+enum class ChannelProducers { kSingle, kMultiple };
+
+namespace detail {
+struct ChannelMapping;
+}  // namespace detail
+
+class ChannelReceiver {
+ public:
+  typedef std::function<void(const byte* data, std::size_t size)> Handler;
+
+  // 'capacity' is rounded up to a power of two of at least 4096 bytes.  Each message occupies its
+  // size plus 8 bytes, rounded up to a multiple of 8.
+  ChannelReceiver(const std::string& name, std::size_t capacity, ChannelProducers producers);
+  ~ChannelReceiver();
+  ChannelReceiver(const ChannelReceiver&) = delete;
+  ChannelReceiver(ChannelReceiver&&) = delete;
+  ChannelReceiver& operator=(ChannelReceiver) = delete;
+
+  // If a message is available, passes it in place to 'handler' (the data is only valid during the
+  // call) and returns true.  The message is consumed even if 'handler' throws.
+  bool TryReceive(const Handler& handler);
+  bool TryReceive(std::vector<byte>& message);
+  // As above, but waits up to 'timeout' for a message.
+  bool Receive(const Handler& handler, std::chrono::milliseconds timeout);
+  bool Receive(std::vector<byte>& message, std::chrono::milliseconds timeout);
+
+  std::size_t capacity() const;
+
+ private:
+  const std::string name_;
+  std::unique_ptr<detail::ChannelMapping> mapping_;
+};
+
+class ChannelSender {
+ public:
+  // Throws CommonErrors::uninitialised if the channel doesn't exist, or
+  // CommonErrors::cannot_exceed_limit if it was created for a single producer which is already
+  // connected.
+  explicit ChannelSender(const std::string& name);
+  ~ChannelSender();
+  ChannelSender(const ChannelSender&) = delete;
+  ChannelSender(ChannelSender&&) = delete;
+  ChannelSender& operator=(ChannelSender) = delete;
+
+  // Returns false if there isn't currently room for the message.  Messages longer than
+  // max_message_size() throw CommonErrors::invalid_argument.
+  bool TrySend(const byte* data, std::size_t size);
+  bool TrySend(const std::vector<byte>& message) { return TrySend(message.data(), message.size()); }
+  // As above, but waits up to 'timeout' for room.
+  bool Send(const byte* data, std::size_t size, std::chrono::milliseconds timeout);
+  bool Send(const std::vector<byte>& message, std::chrono::milliseconds timeout) {
+    return Send(message.data(), message.size(), timeout);
+  }
+
+  std::size_t max_message_size() const;
+
+ private:
+  std::unique_ptr<detail::ChannelMapping> mapping_;
+};
+
 
 
 }  // namespace ipc
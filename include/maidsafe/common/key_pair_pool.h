@@ -0,0 +1,79 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_KEY_PAIR_POOL_H_
+#define MAIDSAFE_COMMON_KEY_PAIR_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "boost/thread/thread.hpp"
+
+#include "maidsafe/common/rsa.h"
+
+namespace maidsafe {
+
+namespace rsa {
+
+// Generates RSA key pairs on background threads, keeping up to 'reserve' of them ready so that Get
+// can usually hand one out without waiting for GenerateKeyPair.  Each call to Get wakes a worker
+// to replace the pair taken.  A worker which is part-way through generating a pair when the pool
+// is destroyed finishes it before the destructor returns.
+class KeyPairPool {
+ public:
+  // Throws if 'reserve' or 'thread_count' is 0.
+  explicit KeyPairPool(size_t reserve, size_t thread_count = 1);
+  ~KeyPairPool();
+  KeyPairPool(const KeyPairPool&) = delete;
+  KeyPairPool(KeyPairPool&&) = delete;
+  KeyPairPool& operator=(const KeyPairPool&) = delete;
+  KeyPairPool& operator=(KeyPairPool&&) = delete;
+
+  // Returns a pre-generated pair if one is available, otherwise generates one on the calling
+  // thread.
+  Keys Get();
+
+  size_t reserve() const { return reserve_; }
+  // Number of pairs currently ready to be handed out.
+  size_t size() const;
+  // Number of calls to Get which were served from the pool, and which had to generate a pair.
+  uint64_t hit_count() const { return hit_count_; }
+  uint64_t miss_count() const { return miss_count_; }
+
+ private:
+  void Run();
+
+  const size_t reserve_;
+  std::atomic<uint64_t> hit_count_, miss_count_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Keys> keys_;
+  size_t generating_;
+  bool running_;
+  std::vector<boost::thread> threads_;
+};
+
+}  // namespace rsa
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_KEY_PAIR_POOL_H_
@@ -0,0 +1,46 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
+#define MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace maidsafe {
+
+// Distribution of durations in power-of-two buckets: bucket 0 counts durations under 1us and
+// bucket i (i > 0) those in [2^(i-1), 2^i) us, with the last bucket also counting any longer.
+struct LatencyHistogram {
+  static const size_t kBucketCount = 32;
+  LatencyHistogram() : buckets(), count(0), total(), max() {}
+  void Record(std::chrono::steady_clock::duration duration);
+  // Adds the durations recorded by 'other' to this histogram.
+  void Merge(const LatencyHistogram& other);
+  std::chrono::steady_clock::duration Mean() const;
+  // Upper bound of the bucket holding the given quantile (in the range [0, 1]), or zero if empty.
+  std::chrono::microseconds Quantile(double quantile) const;
+  std::array<uint64_t, kBucketCount> buckets;
+  uint64_t count;
+  std::chrono::steady_clock::duration total, max;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_LATENCY_HISTOGRAM_H_
@@ -20,9 +20,12 @@
 #define MAIDSAFE_COMMON_LOG_H_
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdint>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -32,6 +35,7 @@
 #include <sstream>
 #include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "asio/ip/tcp.hpp"
@@ -42,6 +46,7 @@
 #include "boost/program_options/variables_map.hpp"
 
 #include "maidsafe/common/active.h"
+#include "maidsafe/common/clock.h"
 
 #ifndef USE_LOGGING
 #ifdef NDEBUG
@@ -51,9 +56,16 @@
 #endif
 #endif
 
+// LOG statements below this level (given as one of the level names below, e.g. kInfo) are removed
+// at compile time.
+#ifndef MAIDSAFE_LOG_MIN_LEVEL
+#define MAIDSAFE_LOG_MIN_LEVEL kVerbose
+#endif
+
 namespace maidsafe {
 
 namespace test {
+class LogOutputTest;
 class VisualiserLogTest;
 }
 
@@ -61,6 +73,107 @@ namespace log {
 
 namespace detail {
 
+template <typename Left, typename Right>
+class OstreamBinder;
+
+// Functions used to encode LOG arguments when binary logging is enabled.  Each argument is written
+// as a one-byte type tag followed by its value; types without a specific encoding are formatted
+// using their operator<< and written as strings.  Stream manipulators have no effect on output.
+void EncodeString(std::string& out, const char* data, size_t size);
+void EncodeSigned(std::string& out, int64_t value);
+void EncodeUnsigned(std::string& out, uint64_t value);
+void EncodeFloat(std::string& out, double value);
+void EncodeBool(std::string& out, bool value);
+void EncodeChar(std::string& out, char value);
+// Returns the text represented by a sequence of encoded arguments.  Throws if it's malformed.
+std::string DecodeArguments(const std::string& encoded);
+
+template <typename T, typename Enable = void>
+struct ArgumentEncoder {
+  static void Encode(std::string& out, const T& value) {
+    std::ostringstream stream;
+    stream << value;
+    const std::string formatted(stream.str());
+    EncodeString(out, formatted.data(), formatted.size());
+  }
+};
+
+template <typename T>
+struct ArgumentEncoder<T, typename std::enable_if<std::is_integral<T>::value &&
+                                                  std::is_signed<T>::value>::type> {
+  static void Encode(std::string& out, T value) { EncodeSigned(out, value); }
+};
+
+template <typename T>
+struct ArgumentEncoder<T, typename std::enable_if<std::is_integral<T>::value &&
+                                                  std::is_unsigned<T>::value>::type> {
+  static void Encode(std::string& out, T value) { EncodeUnsigned(out, value); }
+};
+
+template <typename T>
+struct ArgumentEncoder<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static void Encode(std::string& out, T value) { EncodeFloat(out, value); }
+};
+
+template <>
+struct ArgumentEncoder<bool> {
+  static void Encode(std::string& out, bool value) { EncodeBool(out, value); }
+};
+
+template <>
+struct ArgumentEncoder<char> {
+  static void Encode(std::string& out, char value) { EncodeChar(out, value); }
+};
+
+template <>
+struct ArgumentEncoder<signed char> {
+  static void Encode(std::string& out, signed char value) {
+    EncodeChar(out, static_cast<char>(value));
+  }
+};
+
+template <>
+struct ArgumentEncoder<unsigned char> {
+  static void Encode(std::string& out, unsigned char value) {
+    EncodeChar(out, static_cast<char>(value));
+  }
+};
+
+template <size_t N>
+struct ArgumentEncoder<char[N]> {
+  static void Encode(std::string& out, const char(&value)[N]) {
+    EncodeString(out, value, std::char_traits<char>::length(value));
+  }
+};
+
+template <>
+struct ArgumentEncoder<const char*> {
+  static void Encode(std::string& out, const char* value) {
+    EncodeString(out, value, std::char_traits<char>::length(value));
+  }
+};
+
+template <>
+struct ArgumentEncoder<char*> {
+  static void Encode(std::string& out, const char* value) {
+    EncodeString(out, value, std::char_traits<char>::length(value));
+  }
+};
+
+template <>
+struct ArgumentEncoder<std::string> {
+  static void Encode(std::string& out, const std::string& value) {
+    EncodeString(out, value.data(), value.size());
+  }
+};
+
+template <typename Left, typename Right>
+struct ArgumentEncoder<OstreamBinder<Left, Right>> {
+  static void Encode(std::string& out, const OstreamBinder<Left, Right>& binder) {
+    binder.Encode(out);
+  }
+};
+
 template <typename Left, typename Right>
 class OstreamBinder {
   typedef typename std::add_const<Left>::type BoundLeft;
@@ -70,6 +183,10 @@ class OstreamBinder {
   OstreamBinder(BoundLeft& left, BoundRight& right) : left_(left), right_(right) {}
 
   void Serialise(std::ostream& out) const { out << left_ << right_; }
+  void Encode(std::string& out) const {
+    ArgumentEncoder<typename std::remove_const<Left>::type>::Encode(out, left_);
+    ArgumentEncoder<typename std::remove_const<Right>::type>::Encode(out, right_);
+  }
 
  private:
   BoundLeft& left_;
@@ -80,6 +197,7 @@ template <>
 class OstreamBinder<void, void> {
  public:
   void Serialise(std::ostream&) const {}
+  void Encode(std::string&) const {}
 };
 
 template <typename BoundLeft, typename BoundRight, typename Right>
@@ -94,6 +212,130 @@ std::ostream& operator<<(std::ostream& out, const OstreamBinder<BoundLeft, Bound
   return out;
 }
 
+// Provides the stream into which a LOG statement's arguments are formatted.  Each thread reuses a
+// single stream, rather than constructing one per message; a nested LOG statement (e.g. one made
+// from within an argument's operator<<) gets a stream of its own.
+class LogStream {
+ public:
+  LogStream();
+  ~LogStream();
+  LogStream(const LogStream&) = delete;
+  LogStream(LogStream&&) = delete;
+  LogStream& operator=(const LogStream&) = delete;
+  LogStream& operator=(LogStream&&) = delete;
+
+  std::ostream& stream() { return *stream_; }
+  std::string str() const { return stream_->str(); }
+
+ private:
+  std::ostringstream* stream_;
+  std::unique_ptr<std::ostringstream> nested_stream_;
+};
+
+// Caches, for a single LOG statement, the filter level which applies to its project, so that a
+// disabled statement costs a comparison rather than a filter lookup.  The cache is refreshed
+// whenever the filter changes.  Instances are constant-initialised function-local statics.
+class CallSite {
+ public:
+  constexpr CallSite(const char* const file, const int level)
+      : file_(file), level_(level), state_(0) {}
+  CallSite(const CallSite&) = delete;
+  CallSite(CallSite&&) = delete;
+  CallSite& operator=(const CallSite&) = delete;
+  CallSite& operator=(CallSite&&) = delete;
+
+  bool Enabled() {
+    // The upper half holds the filter generation which the lower half (the level) was cached for.
+    const uint64_t state(state_.load(std::memory_order_relaxed));
+    if (static_cast<uint32_t>(state >> 32) != g_filter_generation.load(std::memory_order_relaxed))
+      return Refresh();
+    return level_ >= static_cast<int32_t>(static_cast<uint32_t>(state));
+  }
+
+  // Incremented whenever the filter changes.  Starts at 1 so that every call site is refreshed on
+  // first use.
+  static std::atomic<uint32_t> g_filter_generation;
+
+ private:
+  bool Refresh();
+
+  const char* const file_;
+  const int level_;
+  std::atomic<uint64_t> state_;
+};
+
+// Whether a LOG_RATE_LIMITED or LOG_EVERY_N statement should write its message, and if so how many
+// of its messages were suppressed since the last one written.
+struct Admission {
+  bool admitted;
+  uint64_t suppressed;
+};
+
+// Admits at most 'max_per_second' messages from a single LOG_RATE_LIMITED statement in each second
+// (as counted by CoarseSteadyClock).  Suppressing a message costs one atomic increment; the count
+// is reported by the first message admitted in a later second.  Instances are function-local
+// statics.
+class RateLimiter {
+ public:
+  explicit RateLimiter(uint32_t max_per_second) : max_per_second_(max_per_second), state_(0) {}
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter(RateLimiter&&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+  RateLimiter& operator=(RateLimiter&&) = delete;
+
+  Admission Admit() {
+    return Admit(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                     CoarseSteadyClock::now().time_since_epoch()).count()));
+  }
+
+  Admission Admit(uint32_t second) {
+    uint64_t state(state_.load(std::memory_order_relaxed));
+    for (;;) {
+      const uint32_t count(static_cast<uint32_t>(state));
+      // A thread which read the clock just before another started a new second counts towards
+      // that new second.
+      if (second <= static_cast<uint32_t>(state >> 32)) {
+        if (count >= max_per_second_) {
+          state_.fetch_add(1, std::memory_order_relaxed);
+          return Admission{false, 0};
+        }
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_relaxed))
+          return Admission{true, 0};
+      } else if (state_.compare_exchange_weak(state, (static_cast<uint64_t>(second) << 32) | 1,
+                                              std::memory_order_relaxed)) {
+        return Admission{true, count > max_per_second_ ? count - max_per_second_ : 0};
+      }
+    }
+  }
+
+ private:
+  const uint32_t max_per_second_;
+  // The upper half holds the current second, the lower half the messages seen during it.
+  std::atomic<uint64_t> state_;
+};
+
+// Admits the first of every 'n' messages from a single LOG_EVERY_N statement.  Instances are
+// function-local statics.
+class Sampler {
+ public:
+  explicit Sampler(uint64_t n) : n_(n == 0 ? 1 : n), count_(0) {}
+  Sampler(const Sampler&) = delete;
+  Sampler(Sampler&&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+  Sampler& operator=(Sampler&&) = delete;
+
+  Admission Admit() {
+    const uint64_t count(count_.fetch_add(1, std::memory_order_relaxed));
+    if (count % n_ != 0)
+      return Admission{false, 0};
+    return Admission{true, count == 0 ? 0 : n_ - 1};
+  }
+
+ private:
+  const uint64_t n_;
+  std::atomic<uint64_t> count_;
+};
+
 struct NullStream {
   template <typename Left, typename Right>
   void operator=(const OstreamBinder<Left, Right>&) const {}
@@ -109,25 +351,41 @@ class LogMessage {
   };
 
  public:
-  LogMessage(const char* const file, const int level) : file_(file), level_(level) {}
+  LogMessage(const char* const file, const int line, const int level,
+             const uint64_t suppressed = 0)
+      : file_(file), line_(line), level_(level), suppressed_(suppressed) {}
 
+  // Only invoked once the call site has been found to be enabled.
   template <typename BoundLeft, typename BoundRight>
   void operator=(const OstreamBinder<BoundLeft, BoundRight>& binder) const {
-    const boost::optional<FileInfo> should_log(ShouldLog());
-    if (should_log) {
-      std::ostringstream out;
-      out << " " << should_log->contract_file_ << binder << "\n";
-      Log(should_log->project_, out.str());
+    if (Binary()) {
+      std::string arguments;
+      binder.Encode(arguments);
+      if (suppressed_ != 0)
+        EncodeSuppressedCount(arguments);
+      LogBinary(std::move(arguments));
+      return;
     }
+    const FileInfo file_info(GetFileInfo());
+    LogStream out;
+    out.stream() << " " << file_info.contract_file_ << ":" << line_ << "] " << binder;
+    if (suppressed_ != 0)
+      out.stream() << " [" << suppressed_ << " similar messages suppressed]";
+    out.stream() << "\n";
+    Log(file_info.project_, out.str());
   }
 
  private:
-  boost::optional<FileInfo> ShouldLog() const;
+  static bool Binary();
+  FileInfo GetFileInfo() const;
   void Log(const std::string& project, std::string message) const;
+  void LogBinary(std::string arguments) const;
+  void EncodeSuppressedCount(std::string& arguments) const;
 
  private:
   const char* const file_;
-  const int level_;
+  const int line_, level_;
+  const uint64_t suppressed_;
 };
 }  // namespace detail
 
@@ -141,12 +399,46 @@ enum class ColourMode { kNone, kPartialLine, kFullLine };
 const int kVerbose = -1, kInfo = 0, kSuccess = 1, kWarning = 2, kError = 3, kAlways = 4;
 
 #if USE_LOGGING
-#define LOG(level)                                                    \
-  maidsafe::log::detail::LogMessage(__FILE__, maidsafe::log::level) = \
-      maidsafe::log::detail::OstreamBinder<void, void>() << ":" << __LINE__ << "] "
+#define MAIDSAFE_LOG_ENABLED_(level)                                                      \
+  (maidsafe::log::level >= maidsafe::log::MAIDSAFE_LOG_MIN_LEVEL &&                       \
+   []() -> maidsafe::log::detail::CallSite& {                                             \
+     static maidsafe::log::detail::CallSite call_site(__FILE__, maidsafe::log::level);    \
+     return call_site;                                                                    \
+   }().Enabled())
+
+// The arguments of a disabled LOG statement are not evaluated.
+#define LOG(level)                                                                        \
+  !MAIDSAFE_LOG_ENABLED_(level)                                                           \
+      ? static_cast<void>(0)                                                              \
+      : maidsafe::log::detail::LogMessage(__FILE__, __LINE__, maidsafe::log::level) =     \
+            maidsafe::log::detail::OstreamBinder<void, void>()
+
+#define MAIDSAFE_LOG_LIMITED_(level, Limiter, limit)                                      \
+  for (maidsafe::log::detail::Admission maidsafe_log_admission(                           \
+           MAIDSAFE_LOG_ENABLED_(level)                                                   \
+               ? [&]() -> maidsafe::log::detail::Limiter& {                               \
+                   static maidsafe::log::detail::Limiter limiter(limit);                  \
+                   return limiter;                                                        \
+                 }().Admit()                                                              \
+               : maidsafe::log::detail::Admission{false, 0});                             \
+       maidsafe_log_admission.admitted; maidsafe_log_admission.admitted = false)          \
+  maidsafe::log::detail::LogMessage(__FILE__, __LINE__, maidsafe::log::level,             \
+                                    maidsafe_log_admission.suppressed) =                  \
+      maidsafe::log::detail::OstreamBinder<void, void>()
+
+// As LOG, but for statements which may fire repeatedly (e.g. once per failed send during an
+// outage).  LOG_RATE_LIMITED writes at most 'max_per_second' messages per second from the
+// statement, and LOG_EVERY_N writes the first of every 'n'.  The arguments of suppressed messages
+// are not evaluated, and the next message written notes how many were suppressed.  The limit is
+// read once, on the statement's first enabled execution.
+#define LOG_RATE_LIMITED(level, max_per_second) \
+  MAIDSAFE_LOG_LIMITED_(level, RateLimiter, max_per_second)
+#define LOG_EVERY_N(level, n) MAIDSAFE_LOG_LIMITED_(level, Sampler, n)
 #else
 #define LOG(_) \
   maidsafe::log::detail::NullStream() = maidsafe::log::detail::OstreamBinder<void, void>()
+#define LOG_RATE_LIMITED(_, __) LOG(_)
+#define LOG_EVERY_N(_, __) LOG(_)
 #endif
 #define TLOG(colour) maidsafe::log::TestLogMessage(maidsafe::log::Colour::colour).MessageStream()
 
@@ -173,66 +465,154 @@ class Logging {
   void Send(std::function<void()> message_functor);
   void WriteToCombinedLogfile(const std::string& message);
   void WriteToVisualiserLogfile(const std::string& message);
+  // Queues 'message' to be posted to the VLOG server by a dedicated thread, which ships the queued
+  // messages together once enough have accumulated or at least every second.  Never waits for the
+  // server; if it isn't keeping up and too many messages are already queued, 'message' is dropped.
   void WriteToVisualiserServer(const std::string& message);
   void WriteToProjectLogfile(const std::string& project, const std::string& message);
+  // Writes a binary message record for the LOG statement at 'file' and 'line' to the combined
+  // logfile, preceded by the statement's definition if this is its first record in the file.
+  void WriteToBinaryLogfile(const char* file, int line, int level, const std::string& record);
   FilterMap Filter() const { return filter_; }
-  bool Async() const { return !no_async_ && background_; }
+  bool Async() const { return async_; }
+  // If true, LOG statements are written only to the combined logfile, in the binary form read by
+  // DecodeBinaryLog, and not to the console or project logfiles.
+  bool Binary() const { return binary_; }
   bool LogToConsole() const { return !no_log_to_console_; }
   ColourMode Colour() const { return colour_mode_; }
   std::string VlogPrefix() const;
   std::string VlogSessionId() const;
+  // As above, but sharing the strings set by InitialiseVlog rather than copying them.
+  std::shared_ptr<const std::string> SharedVlogPrefix() const;
+  std::shared_ptr<const std::string> SharedVlogSessionId() const;
+  // Number of messages dropped by WriteToVisualiserServer, or lost due to the server being
+  // unreachable.
+  uint64_t VlogDroppedCount() const { return visualiser_.dropped_count; }
   void Flush();
 
+  friend class test::LogOutputTest;
   friend class test::VisualiserLogTest;
 
  private:
   struct LogFile {
-    LogFile() : stream(), mutex() {}
+    LogFile()
+        : stream(),
+          mutex(),
+          path(),
+          binary(false),
+          bytes_written(0),
+          opened(),
+          rotation_count(0),
+          call_site_ids() {}
     std::ofstream stream;
     std::mutex mutex;
+    boost::filesystem::path path;
+    bool binary;
+    uint64_t bytes_written;
+    std::chrono::steady_clock::time_point opened;
+    unsigned rotation_count;
+    // IDs of the LOG statements (keyed by file and line) defined so far in a binary logfile.
+    std::map<std::pair<const char*, int>, uint32_t> call_site_ids;
   };
   struct Visualiser {
     Visualiser()
-        : prefix("Vault ID uninitialised"),
-          session_id(),
+        : prefix(std::make_shared<const std::string>("Vault ID uninitialised")),
+          session_id(std::make_shared<const std::string>()),
           logfile(),
           server_stream(),
           server_name(),
           server_dir(),
           server_port(0),
+          server_connected(false),
           initialised(false),
-          initialised_once_flag() {}
-    std::string prefix, session_id;
+          initialised_once_flag(),
+          batch(),
+          batch_mutex(),
+          batch_cond_var(),
+          stop_shipping(false),
+          dropped_count(0),
+          next_connect_attempt(),
+          shipper() {}
+    std::shared_ptr<const std::string> prefix, session_id;
     LogFile logfile;
+    // Only accessed by 'shipper'.
     asio::ip::tcp::iostream server_stream;
     std::string server_name, server_dir;
     uint16_t server_port;
+    bool server_connected;
     std::atomic<bool> initialised;
     std::once_flag initialised_once_flag;
+    // Messages awaiting shipment to the server.
+    std::vector<std::string> batch;
+    std::mutex batch_mutex;
+    std::condition_variable batch_cond_var;
+    // Also read by 'shipper' without 'batch_mutex' to stop it logging during the destructor.
+    std::atomic<bool> stop_shipping;
+    std::atomic<uint64_t> dropped_count;
+    std::chrono::steady_clock::time_point next_connect_attempt;
+    std::thread shipper;
   };
   Logging();
+  ~Logging();
   bool IsHelpOption(const boost::program_options::options_description& log_config) const;
   void HandleFilterOptions();
+  void HandleRotationOptions();
   boost::filesystem::path GetLogfileName(const std::string& project) const;
   void SetStreams();
   void WriteToLogfile(const std::string& message, LogFile& log_file);
+  // Runs on 'visualiser_.shipper' until StopVisualiserShipper is called.
+  void ShipVisualiserBatches();
+  void PostToVisualiserServer(const std::vector<std::string>& messages);
+  bool ConnectToVisualiserServer();
+  void StopVisualiserShipper();
+  void OpenLogfileLocked(LogFile& log_file);
+  // Logfiles are only created once something is written to them.  Returns true if 'log_file' is
+  // open and writable.
+  bool EnsureOpenLocked(LogFile& log_file);
+  // Once 'log_file' reaches the size or age limit, renames it and reopens it, then passes the
+  // renamed file to 'compressor_'.  If the rename fails, carries on appending to 'log_file'.
+  void RotateIfDueLocked(LogFile& log_file);
+  // Runs on 'compressor_'.
+  void CompressRotatedLogfile(const boost::filesystem::path& original,
+                              const boost::filesystem::path& rotated);
 
   boost::program_options::variables_map log_variables_;
   FilterMap filter_;
-  bool no_async_, no_log_to_console_;
+  bool no_async_, no_log_to_console_, binary_;
   std::time_t start_time_;
   boost::filesystem::path log_folder_;
   ColourMode colour_mode_;
   LogFile combined_logfile_stream_;
   std::map<std::string, std::unique_ptr<LogFile>> project_logfile_streams_;
   Visualiser visualiser_;
+  uint64_t max_file_size_;
+  std::chrono::minutes max_file_age_;
+  unsigned max_rotated_files_;
+  // Compressed rotated logfiles, oldest first, keyed by original logfile.  Only accessed by
+  // 'compressor_'.
+  std::map<boost::filesystem::path, std::deque<boost::filesystem::path>> compressed_logfiles_;
+  // Set by Initialise unless asynchronous logging is disabled.  'background_' itself isn't started
+  // until the first message is sent to it.
+  std::atomic<bool> async_;
+  bool rotation_enabled_;
+  // Compression of rotated logfiles has its own thread (started on the first rotation) so as not to
+  // hold up 'background_'.  Must outlive 'background_', which can pass it work.
+  std::unique_ptr<Active> compressor_;
+  std::once_flag compressor_started_;
   std::unique_ptr<Active> background_;
+  std::once_flag background_started_;
 };
 
+// Decodes a combined logfile written with binary logging enabled to the form used by ordinary
+// logfiles.  Throws if 'input' isn't a binary logfile or is malformed (other than a truncated final
+// record, as left by a crash, which is ignored).
+void DecodeBinaryLog(std::istream& input, std::ostream& output);
+
 namespace detail {
 
 std::string GetLocalTime();
 std::string GetUTCTime();
+std::string GetUTCTime(std::chrono::system_clock::time_point time);
 
 }  // namespace detail
 
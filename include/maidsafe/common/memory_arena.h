@@ -0,0 +1,102 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_MEMORY_ARENA_H_
+#define MAIDSAFE_COMMON_MEMORY_ARENA_H_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace maidsafe {
+
+// A fixed-capacity region of memory, mapped and pre-faulted at construction (optionally on huge
+// pages) so that allocations from it incur no page faults on first touch and fewer TLB misses than
+// scattered heap allocations.  Blocks are allocated in power-of-two size classes from 64 bytes,
+// each aligned to 64 bytes.  Freed blocks are kept for reuse by their own class only; memory is
+// never returned to the operating system before the arena is destroyed.  When the arena is
+// exhausted, Allocate returns null and callers are expected to fall back to the heap, so the
+// arena's capacity bounds the memory it holds rather than the memory its users can obtain.  All
+// functions are thread-safe.
+class MemoryArena {
+ public:
+  enum class PageSize {
+    kDefault,
+    // Asks the kernel to back the arena with transparent huge pages where supported.
+    kTransparentHuge,
+    // Uses pages from the pre-reserved huge page pool (e.g. /proc/sys/vm/nr_hugepages on Linux, or
+    // large pages on Windows, which need the "Lock pages in memory" privilege), falling back to
+    // kTransparentHuge if none are available.
+    kExplicitHuge
+  };
+
+  struct Stats {
+    // Bytes mapped, after rounding up to the page size.
+    size_t capacity;
+    // Bytes in allocated blocks (i.e. rounded up to their size classes), and the maximum of that.
+    size_t in_use, peak_in_use;
+    // Bytes never yet allocated, plus those in freed blocks of any class.
+    size_t available;
+    // Successful allocations, and those which failed for want of space (not for an invalid size).
+    size_t allocations, failed_allocations;
+    PageSize page_size;
+  };
+
+  // Throws if 'capacity' is 0 or the memory can't be mapped.  'page_size' is what was requested;
+  // stats().page_size reports what was obtained.
+  explicit MemoryArena(size_t capacity, PageSize page_size = PageSize::kTransparentHuge);
+  ~MemoryArena();
+  MemoryArena(const MemoryArena&) = delete;
+  MemoryArena(MemoryArena&&) = delete;
+  MemoryArena& operator=(MemoryArena) = delete;
+
+  // Returns null if 'size' is 0 or no block of the required class is free or can be carved from
+  // the unallocated remainder.
+  void* Allocate(size_t size);
+  // 'block' must have been returned by Allocate for the same 'size', or be null.
+  void Deallocate(void* block, size_t size);
+  bool Owns(const void* block) const;
+  // The size of the block Allocate uses for 'size'.
+  static size_t BlockSize(size_t size);
+
+  Stats stats() const;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  void Map(PageSize page_size);
+  void Unmap();
+  void Prefault();
+  static size_t ClassOf(size_t size);
+
+  mutable std::mutex mutex_;
+  char* base_;
+  size_t capacity_;
+  // Offset of the unallocated remainder.
+  size_t next_;
+  std::vector<FreeBlock*> free_lists_;
+  Stats stats_;
+  // As returned by the platform's allocator, which may be below 'base_'.
+  void* allocation_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_MEMORY_ARENA_H_
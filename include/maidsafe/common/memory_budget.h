@@ -0,0 +1,172 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_MEMORY_BUDGET_H_
+#define MAIDSAFE_COMMON_MEMORY_BUDGET_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace maidsafe {
+
+// A limit on the memory used by several components together (e.g. DataBuffer's memory store,
+// caches and tcp::Connection send queues), so that each needn't be provisioned for the worst case
+// on its own.  Components register an Account and keep its usage up to date, either by charging and
+// releasing bytes as they go (which costs an atomic addition) or by providing a functor which
+// reports their usage when polled.
+//
+// As the total approaches the limit, the budget reports rising Pressure.  Once it reaches
+// kHigh, a background thread asks accounts to shrink (lowest priority first) until the total is
+// back below the kModerate threshold, e.g. by evicting cache entries (LruCache::Evict) or spilling
+// DataBuffer values to disk (DataBuffer::EvictFromMemory).  Components which can't shrink can
+// instead refuse new work while the pressure is kCritical, as tcp::Connection does with sends
+// (see Connection::SetMemoryBudget).  The budget is advisory: nothing stops usage exceeding it.
+//
+// Instance() is the process-wide budget, which is unlimited until SetLimit is called.  All
+// functions are thread-safe.
+class MemoryBudget {
+ public:
+  enum class Pressure { kNone, kModerate, kHigh, kCritical };
+
+  struct Options {
+    Options()
+        : moderate(0.7),
+          high(0.85),
+          critical(0.95),
+          poll_interval(std::chrono::milliseconds(100)) {}
+    // Fractions of the limit at which each pressure level starts.  Must be increasing, and each in
+    // the range (0, 1].
+    double moderate, high, critical;
+    // How often the background thread polls usage functors and checks the pressure.  It also wakes
+    // as soon as a charge raises the pressure to kHigh.  If zero, there's no background thread and
+    // polling and shrinking only happen via Rebalance.
+    std::chrono::steady_clock::duration poll_interval;
+  };
+
+  // Asked to release about 'bytes' (which may be more than the account holds) at the given
+  // pressure, and returns the number actually released.  The account's usage must be updated
+  // separately (by Release, or as its usage functor reports).  Runs on the budget's background
+  // thread, or on that calling Rebalance.
+  using ShrinkFunctor = std::function<uint64_t(uint64_t bytes, Pressure pressure)>;
+  using UsageFunctor = std::function<uint64_t()>;
+
+  // One component's share of the budget.  Its usage is removed from the budget when it's
+  // destroyed, which must happen before the budget is.
+  class Account {
+   public:
+    ~Account();
+    Account(const Account&) = delete;
+    Account(Account&&) = delete;
+    Account& operator=(const Account&) = delete;
+    Account& operator=(Account&&) = delete;
+
+    // Neither is needed if the account has a usage functor.
+    void Charge(uint64_t bytes);
+    void Release(uint64_t bytes);
+    uint64_t usage() const { return usage_.load(std::memory_order_relaxed); }
+    const std::string& name() const { return name_; }
+    // The budget's current pressure, for components which apply backpressure.
+    Pressure pressure() const;
+
+    friend class MemoryBudget;
+
+   private:
+    Account(MemoryBudget& budget, std::string name, int priority, ShrinkFunctor shrink,
+            UsageFunctor usage);
+    // Sets the usage to that reported by 'usage_functor_', if any.
+    void Poll();
+
+    MemoryBudget& budget_;
+    const std::string name_;
+    const int priority_;
+    const ShrinkFunctor shrink_;
+    const UsageFunctor usage_functor_;
+    std::atomic<uint64_t> usage_;
+  };
+
+  struct Stats {
+    Stats() : limit(0), usage(0), pressure(Pressure::kNone), shrinks(0), released(0), accounts() {}
+    uint64_t limit, usage;
+    Pressure pressure;
+    // Calls to shrink functors, and the bytes they reported releasing.
+    uint64_t shrinks, released;
+    // Each live account's name and usage.
+    std::vector<std::pair<std::string, uint64_t>> accounts;
+  };
+
+  // A 'limit' of 0 means unlimited.  Throws if 'options' is invalid.
+  explicit MemoryBudget(uint64_t limit, Options options = Options());
+  ~MemoryBudget();
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget(MemoryBudget&&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+  // The process-wide budget.  It's never destroyed, so accounts can be held by static objects.
+  static MemoryBudget& Instance();
+
+  // Accounts are shrunk in ascending order of 'priority' (so that e.g. caches which are cheap to
+  // refill go first), and in order of registration within a priority.  'shrink' and 'usage' may
+  // be null.  The account may be shared, e.g. by all of a component's connections.
+  std::shared_ptr<Account> Register(std::string name, int priority, ShrinkFunctor shrink,
+                                    UsageFunctor usage = nullptr);
+
+  void SetLimit(uint64_t limit);
+  uint64_t limit() const { return limit_.load(std::memory_order_relaxed); }
+  // The total usage of all accounts, as last charged or polled.
+  uint64_t usage() const { return usage_.load(std::memory_order_relaxed); }
+  Pressure pressure() const { return PressureAt(usage()); }
+
+  // Polls the usage functors and, if the pressure is kHigh or above, shrinks accounts until the
+  // usage is no more than the kModerate threshold or every account has been asked.  Returns the
+  // bytes released.
+  uint64_t Rebalance();
+
+  Stats stats() const;
+
+ private:
+  Pressure PressureAt(uint64_t usage) const;
+  // Called whenever the total rises by 'bytes' to 'usage'.
+  void Charged(uint64_t usage, uint64_t bytes);
+  void Run();
+
+  const Options kOptions_;
+  std::atomic<uint64_t> limit_, usage_;
+  // Serialises Rebalance, which doesn't hold 'mutex_' while calling shrink functors.
+  std::mutex rebalance_mutex_;
+  // Guards 'accounts_' and the totals.
+  mutable std::mutex mutex_;
+  std::vector<std::weak_ptr<Account>> accounts_;
+  uint64_t shrinks_, released_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool wake_requested_, stopping_;
+  std::thread rebalancer_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_MEMORY_BUDGET_H_
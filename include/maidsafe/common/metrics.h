@@ -0,0 +1,221 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_METRICS_H_
+#define MAIDSAFE_COMMON_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace maidsafe {
+
+namespace metrics {
+
+// A set of name-value pairs distinguishing instances of a metric, e.g. {{"store", "memory"}}.
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+namespace detail {
+
+const size_t kCacheLineSize = 64;
+// Number of shards per counter or histogram.  Threads are spread across the shards so that
+// concurrent updates rarely contend on one cache line.  Must be a power of two.
+const size_t kShardCount = 16;
+
+// The calling thread's shard index, in the range [0, kShardCount).
+size_t ThisThreadShard();
+
+// Padded so that each shard occupies its own cache line.
+struct CounterShard {
+  CounterShard() : value(0), pad() {}
+  std::atomic<uint64_t> value;
+  char pad[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+};
+
+}  // namespace detail
+
+// A monotonically increasing count.  Increments are sharded per thread, so Value() sums the
+// shards and may miss increments made concurrently with it.
+class Counter {
+ public:
+  Counter() : shards_() {}
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+  void Increment(uint64_t amount = 1) {
+    shards_[detail::ThisThreadShard()].value.fetch_add(amount, std::memory_order_relaxed);
+  }
+  uint64_t Value() const;
+
+ private:
+  detail::CounterShard shards_[detail::kShardCount];
+};
+
+// A value which can go up and down, e.g. current memory usage.
+class Gauge {
+ public:
+  Gauge() : value_(0) {}
+  Gauge(const Gauge&) = delete;
+  Gauge& operator=(const Gauge&) = delete;
+
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t amount) { value_.fetch_add(amount, std::memory_order_relaxed); }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_;
+};
+
+// Point-in-time copy of a Histogram.  'buckets' holds (inclusive upper bound, count) for each
+// non-empty bucket, in increasing order of bound.
+struct HistogramSnapshot {
+  HistogramSnapshot() : count(0), sum(0), max(0), buckets() {}
+  // Upper bound of the bucket holding the given quantile (in the range [0, 1]), capped at 'max',
+  // or 0 if empty.
+  uint64_t Quantile(double quantile) const;
+  double Mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+
+  uint64_t count, sum, max;
+  std::vector<std::pair<uint64_t, uint64_t>> buckets;
+};
+
+// Distribution of non-negative integer values (e.g. latencies in microseconds, or sizes in bytes)
+// in log-linear buckets after the fashion of HdrHistogram: values below 8 have a bucket each, and
+// each power-of-two range above that is split into 8 equal buckets, so a value's bucket bounds are
+// within 12.5% of it.  Recording is sharded per thread as for Counter.
+class Histogram {
+ public:
+  static const size_t kSubBucketBits = 3;
+  static const size_t kSubBucketCount = 1 << kSubBucketBits;
+  static const size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  Histogram();
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  void Record(uint64_t value);
+  // Records 'duration' in microseconds.
+  void Record(std::chrono::steady_clock::duration duration);
+  HistogramSnapshot Snapshot() const;
+
+  static size_t BucketIndex(uint64_t value);
+  // Inclusive bounds of the values held in bucket 'index'.
+  static uint64_t BucketLowerBound(size_t index);
+  static uint64_t BucketUpperBound(size_t index);
+
+ private:
+  struct Shard {
+    Shard();
+    std::atomic<uint64_t> buckets[kBucketCount];
+    std::atomic<uint64_t> count, sum, max;
+    char pad[detail::kCacheLineSize];
+  };
+
+  std::unique_ptr<Shard[]> shards_;
+};
+
+enum class MetricType { kCounter, kGauge, kHistogram };
+
+struct MetricSnapshot {
+  MetricSnapshot() : name(), help(), labels(), type(MetricType::kCounter), value(0), histogram() {}
+
+  std::string name, help;
+  Labels labels;
+  MetricType type;
+  // For counters and gauges.
+  int64_t value;
+  HistogramSnapshot histogram;
+};
+
+// All registered metrics, sorted by name and then labels.
+using Snapshot = std::vector<MetricSnapshot>;
+
+// Owns metrics, each identified by its name and labels.  Names must be valid Prometheus metric
+// names (i.e. match "[a-zA-Z_:][a-zA-Z0-9_:]*") and label names valid Prometheus label names.
+// Getting a metric which is already registered returns the existing one; the references returned
+// remain valid for the registry's lifetime, so subsystems should get their metrics once (e.g. on
+// construction) and update them directly.  Throws if a name or label is invalid, or if the name is
+// already registered as a different type.  Thread-safe.
+class Registry {
+ public:
+  Registry();
+  Registry(const Registry&) = delete;
+  Registry& operator=(const Registry&) = delete;
+  ~Registry();
+
+  // The process-wide registry, shared by all subsystems.  Never destroyed.
+  static Registry& Global();
+
+  Counter& GetCounter(const std::string& name, const std::string& help,
+                      const Labels& labels = Labels());
+  Gauge& GetGauge(const std::string& name, const std::string& help,
+                  const Labels& labels = Labels());
+  Histogram& GetHistogram(const std::string& name, const std::string& help,
+                          const Labels& labels = Labels());
+
+  Snapshot TakeSnapshot() const;
+
+ private:
+  struct Metric;
+  Metric& GetMetric(const std::string& name, const std::string& help, const Labels& labels,
+                    MetricType type);
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Metric>> metrics_;
+};
+
+// Renders 'snapshot' in the Prometheus text exposition format (version 0.0.4).  Each histogram is
+// given a bucket for each of its non-empty buckets' upper bounds, plus "+Inf".
+std::string ToPrometheusText(const Snapshot& snapshot);
+
+// Renders 'snapshot' with one line per metric, e.g. 'requests{type="get"} 42' or, for histograms,
+// 'latency_us count=10 mean=3.2 p50=3 p90=5 p99=7 max=7'.
+std::string ToText(const Snapshot& snapshot);
+
+// Logs the registry's metrics (as rendered by ToText) at kInfo on a background thread every
+// 'interval', and once more on destruction.
+class LogExporter {
+ public:
+  LogExporter(const Registry& registry, std::chrono::milliseconds interval);
+  LogExporter(const LogExporter&) = delete;
+  LogExporter& operator=(const LogExporter&) = delete;
+  ~LogExporter();
+
+ private:
+  void Run();
+
+  const Registry& registry_;
+  const std::chrono::milliseconds interval_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopped_;
+  std::thread thread_;
+};
+
+}  // namespace metrics
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_METRICS_H_
@@ -0,0 +1,328 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_MPMC_QUEUE_H_
+#define MAIDSAFE_COMMON_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+
+namespace maidsafe {
+
+// A bounded, lock-free, multi-producer multi-consumer queue offering the same interface as
+// SafeQueue.  This is Dmitry Vyukov's array-based queue: each cell holds a sequence number which
+// tells producers and consumers whether it is ready for them, so pushing or popping costs a single
+// compare-and-swap on an uncontended queue.  The batch functions claim a run of cells with a single
+// compare-and-swap too.
+//
+// Push and WaitAndPop spin briefly before blocking, and only take the internal mutex when a thread
+// is actually blocked, so the common case never enters the kernel.  Size and Empty are only
+// approximate while other threads are using the queue.
+template <typename T>
+class MpmcQueue {
+ public:
+  // 'capacity' is rounded up to the next power of two.  Throws if it's 0.
+  explicit MpmcQueue(size_t capacity);
+  ~MpmcQueue();
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue(MpmcQueue&&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(MpmcQueue&&) = delete;
+
+  bool Empty() const { return Size() == 0; }
+  size_t Size() const;
+  size_t Capacity() const { return mask_ + 1; }
+
+  // Blocks while the queue is full.
+  void Push(T element);
+  // Returns false if the queue is full, in which case 'element' is left unchanged.
+  bool TryPush(T& element);
+  // Moves as many elements as will fit from the range [first, last), returning the number moved.
+  template <typename ForwardIterator>
+  size_t PushN(ForwardIterator first, ForwardIterator last);
+
+  bool TryPop(T& element);
+  // Pops up to 'max_count' elements to 'output', returning the number popped.
+  template <typename OutputIterator>
+  size_t TryPopN(OutputIterator output, size_t max_count);
+  void WaitAndPop(T& element);
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+    T* get() { return reinterpret_cast<T*>(&storage); }
+  };
+  // Keeps the producer and consumer positions on separate cache lines.
+  static const size_t kCacheLineSize = 64;
+  // Number of failed attempts before a thread blocks.
+  static const int kSpinCount = 64;
+
+  static size_t RoundUp(size_t capacity);
+  // As for TryPush and TryPop, but without waking blocked threads.
+  bool DoTryPush(T& element);
+  bool DoTryPop(T& element);
+  // Returns the number of consecutive cells from 'position' (up to 'max_count') whose sequence
+  // number is 'position + offset' - i.e. which are free for a producer (offset 0) or ready for a
+  // consumer (offset 1).
+  size_t ReadyCount(size_t position, size_t offset, size_t max_count) const;
+  // Claims up to 'max_count' cells, returning the first position claimed and the number of cells.
+  std::pair<size_t, size_t> Claim(std::atomic<size_t>& position, size_t offset, size_t max_count);
+  void NotifyConsumers(size_t count);
+  void NotifyProducers(size_t count);
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  char pad0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_position_;
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> dequeue_position_;
+  char pad2_[kCacheLineSize];
+  std::atomic<size_t> waiting_producers_, waiting_consumers_;
+  std::mutex mutex_;
+  std::condition_variable not_full_, not_empty_;
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+    : mask_(RoundUp(capacity) - 1),
+      cells_(new Cell[mask_ + 1]),
+      pad0_(),
+      enqueue_position_(0),
+      pad1_(),
+      dequeue_position_(0),
+      pad2_(),
+      waiting_producers_(0),
+      waiting_consumers_(0),
+      mutex_(),
+      not_full_(),
+      not_empty_() {
+  for (size_t i(0); i != Capacity(); ++i)
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+  const size_t end(enqueue_position_.load(std::memory_order_relaxed));
+  for (size_t position(dequeue_position_.load(std::memory_order_relaxed)); position != end;
+       ++position) {
+    cells_[position & mask_].get()->~T();
+  }
+}
+
+template <typename T>
+size_t MpmcQueue<T>::RoundUp(size_t capacity) {
+  if (capacity == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  size_t result(1);
+  while (result < capacity)
+    result <<= 1;
+  return result;
+}
+
+template <typename T>
+size_t MpmcQueue<T>::Size() const {
+  const size_t dequeue_position(dequeue_position_.load(std::memory_order_relaxed));
+  const size_t enqueue_position(enqueue_position_.load(std::memory_order_relaxed));
+  // The positions are read separately, so the consumer may appear to be ahead.
+  return enqueue_position > dequeue_position ? enqueue_position - dequeue_position : 0;
+}
+
+template <typename T>
+size_t MpmcQueue<T>::ReadyCount(size_t position, size_t offset, size_t max_count) const {
+  size_t count(0);
+  while (count != max_count && count != Capacity() &&
+         cells_[(position + count) & mask_].sequence.load(std::memory_order_acquire) ==
+             position + count + offset) {
+    ++count;
+  }
+  return count;
+}
+
+template <typename T>
+std::pair<size_t, size_t> MpmcQueue<T>::Claim(std::atomic<size_t>& position, size_t offset,
+                                              size_t max_count) {
+  size_t claimed(position.load(std::memory_order_relaxed));
+  for (;;) {
+    const size_t count(ReadyCount(claimed, offset, max_count));
+    if (count == 0) {
+      // Either the queue is full (or empty), or another thread has claimed this position, in which
+      // case its sequence number is ahead of what we expected.
+      const size_t sequence(cells_[claimed & mask_].sequence.load(std::memory_order_acquire));
+      if (static_cast<std::ptrdiff_t>(sequence - (claimed + offset)) < 0)
+        return std::make_pair(claimed, 0);
+      claimed = position.load(std::memory_order_relaxed);
+      continue;
+    }
+    // Cells found ready can't be disturbed until their position has been claimed, so if the
+    // position is unchanged all 'count' of them are now ours.
+    if (position.compare_exchange_weak(claimed, claimed + count, std::memory_order_relaxed))
+      return std::make_pair(claimed, count);
+  }
+}
+
+template <typename T>
+void MpmcQueue<T>::Push(T element) {
+  for (int attempt(0); attempt != kSpinCount; ++attempt) {
+    if (TryPush(element))
+      return;
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++waiting_producers_;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  not_full_.wait(lock, [&] { return DoTryPush(element); });
+  --waiting_producers_;
+  lock.unlock();
+  NotifyConsumers(1);
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPush(T& element) {
+  if (!DoTryPush(element))
+    return false;
+  NotifyConsumers(1);
+  return true;
+}
+
+template <typename T>
+bool MpmcQueue<T>::DoTryPush(T& element) {
+  const auto claimed(Claim(enqueue_position_, 0, 1));
+  if (claimed.second == 0)
+    return false;
+  Cell& cell(cells_[claimed.first & mask_]);
+  ::new (&cell.storage) T(std::move(element));
+  cell.sequence.store(claimed.first + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+template <typename ForwardIterator>
+size_t MpmcQueue<T>::PushN(ForwardIterator first, ForwardIterator last) {
+  size_t pushed(0);
+  while (first != last) {
+    const auto claimed(
+        Claim(enqueue_position_, 0, static_cast<size_t>(std::distance(first, last))));
+    if (claimed.second == 0)
+      break;
+    for (size_t i(0); i != claimed.second; ++i, ++first) {
+      Cell& cell(cells_[(claimed.first + i) & mask_]);
+      ::new (&cell.storage) T(std::move(*first));
+      cell.sequence.store(claimed.first + i + 1, std::memory_order_release);
+    }
+    pushed += claimed.second;
+  }
+  NotifyConsumers(pushed);
+  return pushed;
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPop(T& element) {
+  if (!DoTryPop(element))
+    return false;
+  NotifyProducers(1);
+  return true;
+}
+
+template <typename T>
+bool MpmcQueue<T>::DoTryPop(T& element) {
+  const auto claimed(Claim(dequeue_position_, 1, 1));
+  if (claimed.second == 0)
+    return false;
+  Cell& cell(cells_[claimed.first & mask_]);
+  element = std::move(*cell.get());
+  cell.get()->~T();
+  cell.sequence.store(claimed.first + Capacity(), std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+template <typename OutputIterator>
+size_t MpmcQueue<T>::TryPopN(OutputIterator output, size_t max_count) {
+  size_t popped(0);
+  while (popped != max_count) {
+    const auto claimed(Claim(dequeue_position_, 1, max_count - popped));
+    if (claimed.second == 0)
+      break;
+    for (size_t i(0); i != claimed.second; ++i) {
+      Cell& cell(cells_[(claimed.first + i) & mask_]);
+      *output++ = std::move(*cell.get());
+      cell.get()->~T();
+      cell.sequence.store(claimed.first + i + Capacity(), std::memory_order_release);
+    }
+    popped += claimed.second;
+  }
+  NotifyProducers(popped);
+  return popped;
+}
+
+template <typename T>
+void MpmcQueue<T>::WaitAndPop(T& element) {
+  for (int attempt(0); attempt != kSpinCount; ++attempt) {
+    if (TryPop(element))
+      return;
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  ++waiting_consumers_;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  not_empty_.wait(lock, [&] { return DoTryPop(element); });
+  --waiting_consumers_;
+  lock.unlock();
+  NotifyProducers(1);
+}
+
+template <typename T>
+void MpmcQueue<T>::NotifyConsumers(size_t count) {
+  // Pairs with the fence in WaitAndPop: either the waiter sees the new element, or we see the
+  // waiter.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (count == 0 || waiting_consumers_.load(std::memory_order_relaxed) == 0)
+    return;
+  { std::lock_guard<std::mutex> lock(mutex_); }
+  if (count == 1)
+    not_empty_.notify_one();
+  else
+    not_empty_.notify_all();
+}
+
+template <typename T>
+void MpmcQueue<T>::NotifyProducers(size_t count) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (count == 0 || waiting_producers_.load(std::memory_order_relaxed) == 0)
+    return;
+  { std::lock_guard<std::mutex> lock(mutex_); }
+  if (count == 1)
+    not_full_.notify_one();
+  else
+    not_full_.notify_all();
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_MPMC_QUEUE_H_
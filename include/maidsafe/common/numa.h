@@ -0,0 +1,60 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_NUMA_H_
+#define MAIDSAFE_COMMON_NUMA_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace maidsafe {
+
+namespace numa {
+
+// Used where a node is optional, to mean that no particular node is wanted.
+const unsigned kAnyNode = static_cast<unsigned>(-1);
+
+struct Node {
+  unsigned id;
+  // The node's online CPUs, in ascending order.
+  std::vector<unsigned> cpus;
+};
+
+// The NUMA nodes which have CPUs, in ascending order of id (ids needn't be contiguous).  Where the
+// topology can't be determined (e.g. the platform isn't supported), this is a single node 0 holding
+// every CPU.  Read on first use and cached.
+const std::vector<Node>& Topology();
+size_t NodeCount();
+// Returns 0 if 'cpu' isn't in any node.
+unsigned NodeOfCpu(unsigned cpu);
+// Every CPU, grouped by node, e.g. so that consecutive threads pinned in this order share a node.
+std::vector<unsigned> CpusByNode();
+
+// The node of the CPU on which the calling thread is running, or 0 if unknown.  Unless the thread
+// has been bound to a node, this may change at any time.
+unsigned CurrentNode();
+// Restricts the calling thread to the CPUs of 'node'.  Under the operating system's default
+// first-touch policy, memory which the thread then allocates and writes is placed on that node.
+// Returns false if 'node' isn't in the topology or the thread couldn't be bound.
+bool BindCurrentThreadToNode(unsigned node);
+
+}  // namespace numa
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_NUMA_H_
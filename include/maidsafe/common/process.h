@@ -26,10 +26,15 @@
 #include <unistd.h>
 #endif
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <system_error>
 #include <vector>
 
+#include "asio/io_service.hpp"
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/config.h"
@@ -66,6 +71,33 @@ ProcessId GetProcessId();
 
 bool IsRunning(const ProcessInfo& process_info);
 
+// Notifies of a process's exit without polling where the platform allows: via a pidfd on Linux
+// 5.3 and later, kqueue on macOS and BSD, and a registered wait on Windows.  Elsewhere (or if the
+// kernel lacks pidfd support) IsRunning is polled every 'PollInterval()'.  The process needn't be
+// a child of this one, and isn't reaped.
+class ExitWatcher {
+ public:
+  // Passed asio::error::operation_aborted if the watch is cancelled, or any error with which it
+  // failed; otherwise the process has exited.
+  using ExitHandler = std::function<void(std::error_code)>;
+
+  // Invokes 'on_exit' once, via 'service', when the process exits (straight away if it already
+  // has).  Throws if the process can't be watched, e.g. because of insufficient permissions.
+  ExitWatcher(asio::io_service& service, const ProcessInfo& process_info, ExitHandler on_exit);
+  // Cancels the watch.
+  ~ExitWatcher();
+  ExitWatcher(const ExitWatcher&) = delete;
+  ExitWatcher& operator=(const ExitWatcher&) = delete;
+
+  // 'on_exit' is invoked with asio::error::operation_aborted unless it has already been invoked.
+  void Cancel();
+  static std::chrono::milliseconds PollInterval() { return std::chrono::milliseconds(100); }
+
+ private:
+  struct Watch;
+  std::shared_ptr<Watch> watch_;
+};
+
 // Returns the full path to an exe which is in the same dir as the currently-running exe.
 boost::filesystem::path GetOtherExecutablePath(
     const boost::filesystem::path& name_without_extension);
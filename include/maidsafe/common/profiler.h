@@ -19,18 +19,21 @@
 #ifndef MAIDSAFE_COMMON_PROFILER_H_
 #define MAIDSAFE_COMMON_PROFILER_H_
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <iosfwd>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <tuple>
-#include <utility>
-#include <algorithm>
+#include <vector>
 
 #include "boost/current_function.hpp"
 
-#include "maidsafe/common/active.h"
+#include "maidsafe/common/clock.h"
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/latency_histogram.h"
 
 namespace maidsafe {
 
@@ -38,54 +41,190 @@ namespace profile {
 
 #ifdef USE_PROFILING
 #ifdef _MSC_VER
-#define SCOPED_PROFILE \
-  maidsafe::profile::ProfileEntry scoped_profile_entry(__FILE__, __LINE__, __FUNCTION__);
+#define MAIDSAFE_PROFILE_FUNCTION __FUNCTION__
 #else
-#define SCOPED_PROFILE \
-  maidsafe::profile::ProfileEntry scoped_profile_entry(__FILE__, __LINE__, BOOST_CURRENT_FUNCTION);
+#define MAIDSAFE_PROFILE_FUNCTION BOOST_CURRENT_FUNCTION
 #endif
+#define SCOPED_PROFILE                                                          \
+  static const maidsafe::profile::CallSite scoped_profile_call_site(            \
+      __FILE__, __LINE__, MAIDSAFE_PROFILE_FUNCTION);                           \
+  maidsafe::profile::ProfileEntry scoped_profile_entry(scoped_profile_call_site);
 #else
 #define SCOPED_PROFILE
 #endif
 
-struct ProfileEntry {
-  struct Location {
-    Location(std::string file_in, int line_in, std::string function_in);
-    Location(const Location& other);
-    Location(Location&& other);
-    Location& operator=(Location other);
+// Describes a single SCOPED_PROFILE statement.  Each is a function-local static, so results are
+// keyed by its address rather than by its contents.
+struct CallSite {
+  MAIDSAFE_CONSTEXPR CallSite(const char* file_in, int line_in, const char* function_in)
+      : file(file_in), line(line_in), function(function_in) {}
+  const char* file;
+  int line;
+  const char* function;
+};
+
+// Hardware performance counter values (or differences between them).  See
+// Profiler::EnableHardwareCounters.
+struct HardwareCounters {
+  HardwareCounters() : cycles(0), instructions(0), cache_misses(0), branch_misses(0) {}
+  HardwareCounters& operator+=(const HardwareCounters& other);
+  uint64_t cycles, instructions, cache_misses, branch_misses;
+};
 
-    std::string file;
-    int line;
-    std::string function;
-  };
+// Durations recorded for one node of the call tree (or for one call site overall).
+struct ProfileStats {
+  ProfileStats()
+      : histogram(),
+        min(),
+        counters(),
+        counted_calls(0),
+        allocations(0),
+        allocated_bytes(0),
+        tracked_calls(0) {}
+  void Record(std::chrono::steady_clock::duration duration);
+  void Merge(const ProfileStats& other);
+  // 'histogram' also holds the call count, total and maximum durations.
+  LatencyHistogram histogram;
+  std::chrono::steady_clock::duration min;
+  // Totals for the 'counted_calls' calls made while hardware counters were enabled.
+  HardwareCounters counters;
+  uint64_t counted_calls;
+  // Totals for the 'tracked_calls' calls made while allocation tracking was enabled.
+  uint64_t allocations, allocated_bytes, tracked_calls;
+};
+
+// A call site as reached via a given chain of callers.  The root of a tree has a null 'call_site'.
+struct CallTreeNode {
+  CallTreeNode() : call_site(nullptr), stats(), children() {}
+  const CallSite* call_site;
+  ProfileStats stats;
+  std::vector<CallTreeNode> children;
+};
 
-  ProfileEntry(const std::string& file, int line, const std::string& function)
-      : location(file, line, function), start(std::chrono::high_resolution_clock::now()) {}
+namespace detail {
+struct ThreadProfile;
+struct SampleBuffer;
+}  // namespace detail
 
+// Times the enclosing scope, attributing it to the innermost enclosing ProfileEntry on the same
+// thread (if any) as its parent.
+class ProfileEntry {
+ public:
+  explicit ProfileEntry(const CallSite& call_site);
   ~ProfileEntry();
+  ProfileEntry(const ProfileEntry&) = delete;
+  ProfileEntry(ProfileEntry&&) = delete;
+  ProfileEntry& operator=(const ProfileEntry&) = delete;
+  ProfileEntry& operator=(ProfileEntry&&) = delete;
 
-  Location location;  // location
-  std::chrono::high_resolution_clock::time_point start;
+ private:
+  detail::ThreadProfile& thread_profile_;
+  const uint32_t node_;
+  bool counting_, tracking_;
+  HardwareCounters start_counters_;
+  uint64_t start_allocations_, start_allocated_bytes_;
+  TscClock::time_point start_;
 };
 
-void swap(ProfileEntry::Location& lhs, ProfileEntry::Location& rhs);
+// Registers the constructing thread to be sampled (see Profiler::StartSampling) until destroyed,
+// which must happen on the same thread.  IoService and Active threads register themselves.  A
+// thread should only be registered once at a time.
+class SampledThread {
+ public:
+  SampledThread();
+  ~SampledThread();
+  SampledThread(const SampledThread&) = delete;
+  SampledThread(SampledThread&&) = delete;
+  SampledThread& operator=(const SampledThread&) = delete;
+  SampledThread& operator=(SampledThread&&) = delete;
 
-bool operator<(const ProfileEntry::Location& lhs, const ProfileEntry::Location& rhs);
+ private:
+  std::shared_ptr<detail::SampleBuffer> buffer_;
+};
 
+// Each thread accumulates its own results without synchronising with other threads; these are
+// only merged when results are requested.  The full results are written to std::cout when the
+// Profiler is destroyed.
 class Profiler {
  public:
   static Profiler& Instance();
   ~Profiler();
-  void AddEntry(ProfileEntry::Location&& location,
-                const std::chrono::high_resolution_clock::duration& duration);
+  Profiler(const Profiler&) = delete;
+  Profiler(Profiler&&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+  Profiler& operator=(Profiler&&) = delete;
+
+  // Merges the results of all threads so far into a single call tree.  Can be called at any time.
+  CallTreeNode CallTree() const;
+  // The same results, but merged per call site regardless of caller.
+  std::map<const CallSite*, ProfileStats> Totals() const;
+  // Human-readable form of Totals() and CallTree().
+  std::string Report() const;
+
+  // Starts recording individual events, in addition to the aggregated results, for export via
+  // WriteChromeTrace.  Only every 'sample_interval'th event on each thread is kept, and each thread
+  // keeps at most 'max_events_per_thread' events (later ones are dropped) until they're cleared.
+  // Throws if 'sample_interval' is 0.
+  void StartRecording(uint32_t sample_interval = 1, size_t max_events_per_thread = 1 << 20);
+  void StopRecording();
+  bool Recording() const { return sample_interval_ != 0; }
+  // Writes the events recorded so far in the Chrome trace_event JSON format (as read by
+  // chrome://tracing), discarding them afterwards if 'clear' is true.  Can be called at any time.
+  void WriteChromeTrace(std::ostream& output, bool clear = false) const;
+  // Writes CallTree() in the folded-stack format used by flamegraph.pl: one line per call chain,
+  // holding the semicolon-separated call sites followed by the chain's self time in microseconds.
+  void WriteFoldedStacks(std::ostream& output) const;
+
+  // Linux only: counts CPU cycles, instructions, last-level cache misses and branch misses (in user
+  // space) for each profiled scope via perf_event counters, which are opened on each thread when it
+  // first enters a scope afterwards.  Returns false if the counters are unavailable (e.g. on other
+  // platforms, or if disallowed by /proc/sys/kernel/perf_event_paranoid), in which case no counts
+  // are made.  Counting adds a system call to the entry and exit of each scope.
+  bool EnableHardwareCounters(bool enable);
+  bool HardwareCountersEnabled() const { return hardware_counters_; }
+
+  // Counts the calls to (and bytes requested from) the global operator new made by the current
+  // thread within each profiled scope, including within nested scopes.  Only available when
+  // USE_PROFILING is defined, as that's when the library replaces operator new; returns false
+  // otherwise.
+  bool EnableAllocationTracking(bool enable);
+  bool AllocationTrackingEnabled() const;
+
+  // Linux (glibc) only: samples the call stacks of threads registered via SampledThread
+  // 'frequency' times per second of CPU time used by each (so idle threads aren't sampled).  Unlike
+  // SCOPED_PROFILE, this needs neither instrumentation nor USE_PROFILING, and costs nothing between
+  // samples.  Each sample is taken by a SIGPROF handler, which writes the stack to a lock-free
+  // buffer belonging to its thread; a background thread drains the buffers every 100ms.  Installs
+  // a handler for SIGPROF, so can't be used alongside anything else relying on it (e.g. gprof).
+  // Returns false if sampling is unavailable.  Throws if 'frequency' is 0 or greater than 1000.
+  bool StartSampling(unsigned frequency = 99);
+  void StopSampling();
+  bool Sampling() const;
+  // The stacks sampled so far, each given as its frames' function names (outermost first, separated
+  // by semicolons) and mapped to its number of samples.  Functions in the executable are only named
+  // if it's linked with -rdynamic.  Can be called at any time.
+  std::map<std::string, uint64_t> SampledStacks() const;
+  // Writes SampledStacks() in the folded-stack format used by flamegraph.pl, discarding the samples
+  // afterwards if 'clear' is true.
+  void WriteSampledStacks(std::ostream& output, bool clear = false) const;
+  // Number of samples lost due to a thread's buffer being full.
+  uint64_t DroppedSamples() const;
+
+  friend class ProfileEntry;
+  friend struct detail::ThreadProfile;
 
  private:
-  typedef std::pair<uint64_t, std::chrono::high_resolution_clock::duration> EntryDetails;
-  Profiler() : entries_(), background_(new Active) {}
+  Profiler();
+  void Register(std::shared_ptr<detail::ThreadProfile> thread_profile);
+
+  std::vector<std::shared_ptr<detail::ThreadProfile>> ThreadProfiles() const;
 
-  std::map<std::string, EntryDetails> entries_;
-  std::shared_ptr<Active> background_;
+  const TscClock::time_point kEpoch_;
+  std::atomic<uint32_t> sample_interval_;
+  std::atomic<size_t> max_events_per_thread_;
+  std::atomic<bool> hardware_counters_;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<detail::ThreadProfile>> thread_profiles_;
 };
 
 }  // namespace profile
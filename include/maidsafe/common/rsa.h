@@ -19,6 +19,12 @@
 #ifndef MAIDSAFE_COMMON_RSA_H_
 #define MAIDSAFE_COMMON_RSA_H_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -34,6 +40,7 @@
 #include "maidsafe/common/bounded_string.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/containers/lru_cache.h"
 
 namespace maidsafe {
 
@@ -84,15 +91,116 @@ CipherText Encrypt(const PlainText& data, const PublicKey& public_key);
 
 PlainText Decrypt(const CipherText& data, const PrivateKey& private_key);
 
+// Hybrid encryption for sending many messages to the same recipients.  Rather than a public-key
+// operation per message as for Encrypt, a random AES-256 session key is RSA-encrypted once per
+// recipient and reused until it expires, with each message encrypted under it using AES-GCM and a
+// fresh nonce.  The encrypted session key is sent with every message, so messages can be decrypted
+// in any order and despite losses; SessionDecryptor caches the keys it has decrypted, so it too
+// only performs an RSA operation per session.  The output can only be decrypted by
+// SessionDecryptor, not by Decrypt.  Both classes are thread-safe.
+class SessionEncryptor {
+ public:
+  struct Options {
+    Options()
+        : capacity(64),
+          key_lifetime(std::chrono::minutes(10)),
+          max_messages_per_key(std::numeric_limits<uint32_t>::max()) {}
+    // The number of recipients whose session keys are cached.
+    size_t capacity;
+    // A new session key is used once the current one is this old, or has encrypted this many
+    // messages.
+    std::chrono::steady_clock::duration key_lifetime;
+    uint64_t max_messages_per_key;
+  };
+
+  // Throws if any option is zero.
+  explicit SessionEncryptor(Options options = Options());
+  SessionEncryptor(const SessionEncryptor&) = delete;
+  SessionEncryptor(SessionEncryptor&&) = delete;
+  SessionEncryptor& operator=(const SessionEncryptor&) = delete;
+  SessionEncryptor& operator=(SessionEncryptor&&) = delete;
+  ~SessionEncryptor();
+
+  // Throws as Encrypt does.  'public_key' is only validated when a new session key is created.
+  CipherText Encrypt(const PlainText& data, const PublicKey& public_key);
+
+ private:
+  struct Session;
+  std::shared_ptr<Session> NewSession(const PublicKey& public_key) const;
+
+  const Options kOptions_;
+  std::mutex mutex_;
+  // Keyed by the DER encoding of the recipient's public key.
+  LruCache<std::string, std::shared_ptr<Session>> sessions_;
+};
+
+class SessionDecryptor {
+ public:
+  // 'capacity' is the number of session keys cached.  Throws if 'private_key' is invalid or
+  // 'capacity' is zero.
+  explicit SessionDecryptor(PrivateKey private_key, size_t capacity = 64);
+  SessionDecryptor(const SessionDecryptor&) = delete;
+  SessionDecryptor(SessionDecryptor&&) = delete;
+  SessionDecryptor& operator=(const SessionDecryptor&) = delete;
+  SessionDecryptor& operator=(SessionDecryptor&&) = delete;
+
+  // Throws if 'data' wasn't produced by SessionEncryptor for this decryptor's public key, or has
+  // been altered.
+  PlainText Decrypt(const CipherText& data);
+
+ private:
+  const PrivateKey kPrivateKey_;
+  std::mutex mutex_;
+  // Keyed by the RSA-encrypted session key.
+  LruCache<std::string, std::vector<byte>> session_keys_;
+};
+
 Signature Sign(const PlainText& data, const PrivateKey& private_key);
 
 Signature SignFile(const boost::filesystem::path& filename, const PrivateKey& private_key);
 
 bool CheckSignature(const PlainText& data, const Signature& signature, const PublicKey& public_key);
 
+// One item of a batch passed to CheckSignatures.  The referenced objects must outlive the call.
+struct SignatureCheck {
+  SignatureCheck(const PlainText& data_in, const Signature& signature_in,
+                 const PublicKey& public_key_in)
+      : data(&data_in), signature(&signature_in), public_key(&public_key_in) {}
+  const PlainText* data;
+  const Signature* signature;
+  const PublicKey* public_key;
+};
+
+// Returns one result per item of 'checks', true where the signature is valid.  Unlike
+// CheckSignature, this doesn't throw for an item with uninitialised data or signature or an
+// invalid key; that item's result is simply false.  A verifier is built once per distinct key
+// (per thread) rather than once per item, and large batches are split across several threads.
+std::vector<bool> CheckSignatures(const std::vector<SignatureCheck>& checks);
+
 bool CheckFileSignature(const boost::filesystem::path& filename, const Signature& signature,
                         const PublicKey& public_key);
 
+// Checks a signature over data which is supplied a piece at a time, e.g. as it arrives from the
+// network, so that the whole of it needn't be held in memory.  The constructor throws as
+// CheckSignature does for an uninitialised signature or invalid key.  Not thread-safe, and should
+// only be used on the thread which constructed it.
+class SignatureVerifier {
+ public:
+  SignatureVerifier(const Signature& signature, const PublicKey& public_key);
+  SignatureVerifier(const SignatureVerifier&) = delete;
+  SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+  ~SignatureVerifier();
+
+  void Update(const byte* data, std::size_t size);
+  // Returns true if the signature is valid for the data passed to Update.  Throws if called more
+  // than once.
+  bool Verify();
+
+ private:
+  std::shared_ptr<const CryptoPP::PK_Verifier> verifier_;
+  std::unique_ptr<CryptoPP::PK_MessageAccumulator> accumulator_;
+};
+
 EncodedPrivateKey EncodeKey(const PrivateKey& private_key);
 
 EncodedPublicKey EncodeKey(const PublicKey& public_key);
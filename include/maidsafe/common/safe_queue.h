@@ -19,15 +19,25 @@
 #ifndef MAIDSAFE_COMMON_SAFE_QUEUE_H_
 #define MAIDSAFE_COMMON_SAFE_QUEUE_H_
 
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <queue>
 
-template <typename T>
+// Both queues accept an Allocator for their underlying std::deque, e.g. a
+// maidsafe::ArenaAllocator (containers/arena.h).  All allocations are made while holding the
+// queue's mutex.
+template <typename T, typename Allocator = std::allocator<T>>
 class SafeQueue {
  public:
   SafeQueue() : queue_(), mutex_(), condition_() {}
 
+  explicit SafeQueue(const Allocator& allocator)
+      : queue_(std::deque<T, Allocator>(allocator)), mutex_(), condition_() {}
+
   bool Empty() const {
     std::lock_guard<std::mutex> lock(mutex_);
     return queue_.empty();
@@ -66,9 +76,123 @@ class SafeQueue {
  private:
   SafeQueue& operator=(const SafeQueue&);
   SafeQueue(const SafeQueue& other);
-  std::queue<T> queue_;
+  std::queue<T, std::deque<T, Allocator>> queue_;
   mutable std::mutex mutex_;
   std::condition_variable condition_;
 };
 
+// A capacity-bounded variant of SafeQueue providing backpressure: producers block (or fail, for
+// the Try/For functions) while the queue is full.  Once Close has been called, further pushes fail
+// and consumers can drain any remaining elements, after which the pop functions return false
+// rather than blocking.
+template <typename T, typename Allocator = std::allocator<T>>
+class BoundedSafeQueue {
+ public:
+  // A capacity of 0 is treated as 1.
+  explicit BoundedSafeQueue(size_t capacity, const Allocator& allocator = Allocator())
+      : capacity_(capacity == 0 ? 1 : capacity),
+        queue_(std::deque<T, Allocator>(allocator)),
+        closed_(false),
+        mutex_(),
+        not_empty_(),
+        not_full_() {}
+
+  bool Empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.empty();
+  }
+
+  size_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+  bool Closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+  }
+
+  // Wakes all blocked threads.  Pushes fail from now on but queued elements can still be popped.
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  // Blocks while the queue is full.  Returns false if the queue is closed.
+  bool Push(T element) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+    return DoPush(element, lock);
+  }
+
+  // Returns false if the queue is full or closed, in which case 'element' is left unchanged.
+  bool TryPush(T& element) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return DoPush(element, lock);
+  }
+
+  // As for Push, but gives up after 'timeout', in which case 'element' is left unchanged.
+  template <typename Rep, typename Period>
+  bool PushFor(T& element, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait_for(lock, timeout, [this] { return closed_ || queue_.size() < capacity_; });
+    return DoPush(element, lock);
+  }
+
+  bool TryPop(T& element) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return DoPop(element, lock);
+  }
+
+  // Blocks while the queue is empty and open.  Returns false once the queue is closed and empty.
+  bool WaitAndPop(T& element) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+    return DoPop(element, lock);
+  }
+
+  // As for WaitAndPop, but also returns false if the queue is still empty after 'timeout'.
+  template <typename Rep, typename Period>
+  bool WaitAndPopFor(T& element, const std::chrono::duration<Rep, Period>& timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait_for(lock, timeout, [this] { return closed_ || !queue_.empty(); });
+    return DoPop(element, lock);
+  }
+
+ private:
+  BoundedSafeQueue& operator=(const BoundedSafeQueue&);
+  BoundedSafeQueue(const BoundedSafeQueue& other);
+
+  bool DoPush(T& element, std::unique_lock<std::mutex>& lock) {
+    if (closed_ || queue_.size() >= capacity_)
+      return false;
+    queue_.push(std::move(element));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  bool DoPop(T& element, std::unique_lock<std::mutex>& lock) {
+    if (queue_.empty())
+      return false;
+    element = std::move(queue_.front());
+    queue_.pop();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  const size_t capacity_;
+  std::queue<T, std::deque<T, Allocator>> queue_;
+  bool closed_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+};
+
 #endif  // MAIDSAFE_COMMON_SAFE_QUEUE_H_
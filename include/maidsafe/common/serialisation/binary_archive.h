@@ -19,12 +19,19 @@
 #ifndef MAIDSAFE_COMMON_SERIALISATION_BINARY_ARCHIVE_H_
 #define MAIDSAFE_COMMON_SERIALISATION_BINARY_ARCHIVE_H_
 
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <ios>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "cereal/cereal.hpp"
 #include "boost/interprocess/streams/vectorstream.hpp"
 
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/serialisation/binary_archive_fwd.h"
 
 namespace maidsafe {
 
@@ -33,16 +40,49 @@ using OutputVectorStream = boost::interprocess::basic_ovectorstream<SerialisedDa
 using InputVectorStream = boost::interprocess::basic_ivectorstream<SerialisedData>;
 
 // These are largely copied from Cereal's own BinaryOutputArchive and BinaryInputArchive, so are not
-// endian-safe.
+// endian-safe.  Some of our own types use a more compact format with these archives than with other
+// Cereal archives: a fixed-size BoundedString (e.g. Identity) is written as its raw bytes with no
+// size prefix.
 
 class BinaryOutputArchive : public cereal::OutputArchive<BinaryOutputArchive> {
  public:
+  // Appends directly to 'output', which must outlive the archive.  Its existing capacity is used,
+  // so a caller can avoid reallocations by reusing the same buffer or reserving it beforehand.
+  explicit BinaryOutputArchive(SerialisedData& output)
+      : OutputArchive<BinaryOutputArchive>(this),
+        output_(&output),
+        string_output_(nullptr),
+        itsStream(nullptr) {}
+
+  // As above, but appends to a std::string (used by ConvertToString).
+  explicit BinaryOutputArchive(std::string& output)
+      : OutputArchive<BinaryOutputArchive>(this),
+        output_(nullptr),
+        string_output_(&output),
+        itsStream(nullptr) {}
+
   explicit BinaryOutputArchive(OutputVectorStream& stream)
-      : OutputArchive<BinaryOutputArchive>(this), itsStream(stream) {}
+      : OutputArchive<BinaryOutputArchive>(this),
+        output_(nullptr),
+        string_output_(nullptr),
+        itsStream(&stream) {}
+
+  BinaryOutputArchive(const BinaryOutputArchive&) = delete;
+  BinaryOutputArchive& operator=(const BinaryOutputArchive&) = delete;
 
   void saveBinary(const void* data, std::size_t size) {
+    if (output_) {
+      const byte* const bytes(static_cast<const byte*>(data));
+      output_->insert(output_->end(), bytes, bytes + size);
+      return;
+    }
+    if (string_output_) {
+      string_output_->append(static_cast<const char*>(data), size);
+      return;
+    }
+
     auto const writtenSize = static_cast<std::size_t>(
-        itsStream.rdbuf()->sputn(reinterpret_cast<const unsigned char*>(data), size));
+        itsStream->rdbuf()->sputn(reinterpret_cast<const unsigned char*>(data), size));
 
     if (writtenSize != size)
       throw cereal::Exception("Failed to write " + std::to_string(size) +
@@ -50,28 +90,102 @@ class BinaryOutputArchive : public cereal::OutputArchive<BinaryOutputArchive> {
   }
 
  private:
-  OutputVectorStream& itsStream;
+  SerialisedData* const output_;
+  std::string* const string_output_;
+  OutputVectorStream* const itsStream;
+};
+
+// Writes nothing, but counts the bytes a BinaryOutputArchive would write for the same objects.
+// This allows an output buffer to be reserved exactly before serialising into it.
+class BinarySizeArchive : public cereal::OutputArchive<BinarySizeArchive> {
+ public:
+  BinarySizeArchive() : OutputArchive<BinarySizeArchive>(this), size_(0) {}
+
+  BinarySizeArchive(const BinarySizeArchive&) = delete;
+  BinarySizeArchive& operator=(const BinarySizeArchive&) = delete;
+
+  void saveBinary(const void* /*data*/, std::size_t size) { size_ += size; }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  std::size_t size_;
 };
 
+// Reads directly from a contiguous buffer via a raw cursor, so that loading doesn't involve any
+// stream buffer calls, and data held outside a std::vector (e.g. a received message or a mapped
+// file) can be parsed in place.  The buffer must outlive the archive.
 class BinaryInputArchive : public cereal::InputArchive<BinaryInputArchive> {
  public:
-  explicit BinaryInputArchive(InputVectorStream& stream)
-      : cereal::InputArchive<BinaryInputArchive>(this), itsStream(stream) {}
+  // If 'trusted_source' is true, types which validate their content while loading (e.g.
+  // ImmutableData checking its name is the hash of its value) may skip that validation.  It should
+  // only be set for data whose integrity is already assured, e.g. data this process serialised
+  // itself and read back from a checksummed local store.
+  BinaryInputArchive(const byte* data, std::size_t size, bool trusted_source = false)
+      : cereal::InputArchive<BinaryInputArchive>(this),
+        itsStream(nullptr),
+        begin_(data),
+        cursor_(data),
+        end_(data + size),
+        trusted_source_(trusted_source) {}
 
-  void loadBinary(void* const data, std::size_t size) {
-    auto const readSize = static_cast<std::size_t>(
-        itsStream.rdbuf()->sgetn(reinterpret_cast<unsigned char*>(data), size));
+  // Reads from the stream's current position onwards.  The stream is advanced past the bytes
+  // consumed when the archive is destroyed.
+  explicit BinaryInputArchive(InputVectorStream& stream, bool trusted_source = false)
+      : cereal::InputArchive<BinaryInputArchive>(this),
+        itsStream(&stream),
+        begin_(StreamPosition(stream)),
+        cursor_(begin_),
+        end_(stream.vector().data() + stream.vector().size()),
+        trusted_source_(trusted_source) {}
 
-    if (readSize != size)
+  ~BinaryInputArchive() {
+    if (itsStream && cursor_ != begin_)
+      itsStream->seekg(cursor_ - begin_, std::ios_base::cur);
+  }
+
+  BinaryInputArchive(const BinaryInputArchive&) = delete;
+  BinaryInputArchive& operator=(const BinaryInputArchive&) = delete;
+
+  bool trusted_source() const { return trusted_source_; }
+
+  // Number of bytes not yet read.
+  std::size_t remaining() const { return static_cast<std::size_t>(end_ - cursor_); }
+
+  void loadBinary(void* const data, std::size_t size) {
+    if (size > remaining())
       throw cereal::Exception("Failed to read " + std::to_string(size) +
-                              " bytes from input stream! Read " + std::to_string(readSize));
+                              " bytes from input buffer! Only " + std::to_string(remaining()) +
+                              " available");
+    if (size != 0)
+      std::memcpy(data, cursor_, size);
+    cursor_ += size;
   }
 
  private:
-  InputVectorStream& itsStream;
+  static const byte* StreamPosition(InputVectorStream& stream) {
+    const SerialisedData& buffer(stream.vector());
+    const std::streamoff position(stream.tellg());
+    if (position < 0 || static_cast<std::size_t>(position) > buffer.size())
+      return buffer.data() + buffer.size();
+    return buffer.data() + static_cast<std::size_t>(position);
+  }
+
+  InputVectorStream* const itsStream;
+  const byte* const begin_;
+  const byte* cursor_;
+  const byte* const end_;
+  const bool trusted_source_;
 };
 
+// Returns true if 'archive' is reading from a trusted source (see BinaryInputArchive).  Only
+// BinaryInputArchive can be trusted.
+template <typename Archive>
+bool IsTrustedSource(const Archive& /*archive*/) {
+  return false;
+}
 
+inline bool IsTrustedSource(const BinaryInputArchive& archive) { return archive.trusted_source(); }
 
 // Saving for POD types to binary
 template <class T>
@@ -80,6 +194,12 @@ inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type CEREAL_
   ar.saveBinary(std::addressof(t), sizeof(t));
 }
 
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    BinarySizeArchive& ar, T const& t) {
+  ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
 // Loading for POD types from binary
 template <class T>
 inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type CEREAL_LOAD_FUNCTION_NAME(
@@ -94,6 +214,11 @@ inline CEREAL_ARCHIVE_RESTRICT(BinaryInputArchive, BinaryOutputArchive)
   ar(t.value);
 }
 
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(BinarySizeArchive& ar, cereal::NameValuePair<T>& t) {
+  ar(t.value);
+}
+
 // Serializing SizeTags to binary
 template <class Archive, class T>
 inline CEREAL_ARCHIVE_RESTRICT(BinaryInputArchive, BinaryOutputArchive)
@@ -101,23 +226,85 @@ inline CEREAL_ARCHIVE_RESTRICT(BinaryInputArchive, BinaryOutputArchive)
   ar(t.size);
 }
 
+template <class T>
+inline void CEREAL_SERIALIZE_FUNCTION_NAME(BinarySizeArchive& ar, cereal::SizeTag<T>& t) {
+  ar(t.size);
+}
+
 // Saving binary data
 template <class T>
 inline void CEREAL_SAVE_FUNCTION_NAME(BinaryOutputArchive& ar, cereal::BinaryData<T> const& bd) {
   ar.saveBinary(bd.data, static_cast<std::size_t>(bd.size));
 }
 
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(BinarySizeArchive& ar, cereal::BinaryData<T> const& bd) {
+  ar.saveBinary(bd.data, static_cast<std::size_t>(bd.size));
+}
+
 // Loading binary data
 template <class T>
 inline void CEREAL_LOAD_FUNCTION_NAME(BinaryInputArchive& ar, cereal::BinaryData<T>& bd) {
   ar.loadBinary(bd.data, static_cast<std::size_t>(bd.size));
 }
 
+// Saving and loading contiguous arithmetic containers in bulk.  These produce the same format as
+// Cereal's own overloads (a size tag, for vectors, followed by the raw elements) but write or read
+// each container with at most two direct calls rather than via Cereal's per-call dispatch.
+template <class T>
+using IsBulkSerialisable = std::integral_constant<bool, std::is_arithmetic<T>::value &&
+                                                            !std::is_same<T, bool>::value>;
+
+template <class T, class A>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    BinaryOutputArchive& ar, std::vector<T, A> const& vector) {
+  const cereal::size_type size(vector.size());
+  ar.saveBinary(&size, sizeof(size));
+  ar.saveBinary(vector.data(), vector.size() * sizeof(T));
+}
+
+template <class T, class A>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    BinarySizeArchive& ar, std::vector<T, A> const& vector) {
+  ar.saveBinary(nullptr, sizeof(cereal::size_type) + vector.size() * sizeof(T));
+}
+
+// Throws before allocating if the input is too short to hold the number of elements claimed.
+template <class T, class A>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_LOAD_FUNCTION_NAME(
+    BinaryInputArchive& ar, std::vector<T, A>& vector) {
+  cereal::size_type size;
+  ar.loadBinary(&size, sizeof(size));
+  if (size > ar.remaining() / sizeof(T))
+    throw cereal::Exception("Vector of " + std::to_string(size) + " elements exceeds input size");
+  vector.resize(static_cast<std::size_t>(size));
+  ar.loadBinary(vector.data(), vector.size() * sizeof(T));
+}
+
+template <class T, std::size_t N>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    BinaryOutputArchive& ar, std::array<T, N> const& array) {
+  ar.saveBinary(array.data(), N * sizeof(T));
+}
+
+template <class T, std::size_t N>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    BinarySizeArchive& ar, std::array<T, N> const& array) {
+  ar.saveBinary(nullptr, N * sizeof(T));
+}
+
+template <class T, std::size_t N>
+inline typename std::enable_if<IsBulkSerialisable<T>::value, void>::type CEREAL_LOAD_FUNCTION_NAME(
+    BinaryInputArchive& ar, std::array<T, N>& array) {
+  ar.loadBinary(array.data(), N * sizeof(T));
+}
+
 }  // namespace maidsafe
 
 // Register archives for polymorphic support
 CEREAL_REGISTER_ARCHIVE(maidsafe::BinaryOutputArchive)
 CEREAL_REGISTER_ARCHIVE(maidsafe::BinaryInputArchive)
+CEREAL_REGISTER_ARCHIVE(maidsafe::BinarySizeArchive)
 
 // tie input and output archives together
 CEREAL_SETUP_ARCHIVE_TRAITS(maidsafe::BinaryInputArchive, maidsafe::BinaryOutputArchive)
@@ -0,0 +1,246 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SERIALISATION_PORTABLE_BINARY_ARCHIVE_H_
+#define MAIDSAFE_COMMON_SERIALISATION_PORTABLE_BINARY_ARCHIVE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "cereal/cereal.hpp"
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+using SerialisedData = std::vector<byte>;
+
+/*
+  An endian-safe counterpart to BinaryOutputArchive / BinaryInputArchive, so that data can be
+  exchanged between hosts of differing byte order.  Arithmetic values are written as fixed-width
+  little-endian (floating point types must be IEEE 754), while size tags (e.g. the length of a
+  string or vector) are written as unsigned LEB128 varints, so lengths below 128 take one byte
+  rather than eight.  On little-endian hosts values are copied without conversion.
+
+  The format is not compatible with that of BinaryOutputArchive.
+*/
+
+namespace detail {
+
+#if defined(_MSC_VER) || \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+const bool kLittleEndianHost = true;
+#else
+const bool kLittleEndianHost = false;
+#endif
+
+// The maximum encoded size of a 64-bit LEB128 varint.
+const std::size_t kMaxVarintSize = 10;
+
+// Copies 'size' bytes, being a whole number of 'DataSize'-byte values, converting each between
+// host and little-endian byte order (the conversion is its own inverse).
+template <std::size_t DataSize>
+void CopyLittleEndian(byte* destination, const byte* source, std::size_t size) {
+  if (kLittleEndianHost || DataSize == 1) {
+    if (size != 0)
+      std::memcpy(destination, source, size);
+    return;
+  }
+  for (std::size_t i(0); i < size; i += DataSize)
+    std::reverse_copy(source + i, source + i + DataSize, destination + i);
+}
+
+}  // namespace detail
+
+class PortableBinaryOutputArchive : public cereal::OutputArchive<PortableBinaryOutputArchive> {
+ public:
+  // Appends to 'output', which must outlive the archive.
+  explicit PortableBinaryOutputArchive(SerialisedData& output)
+      : OutputArchive<PortableBinaryOutputArchive>(this), output_(output) {}
+
+  PortableBinaryOutputArchive(const PortableBinaryOutputArchive&) = delete;
+  PortableBinaryOutputArchive& operator=(const PortableBinaryOutputArchive&) = delete;
+
+  // Writes 'size' bytes of 'DataSize'-byte values in little-endian order.
+  template <std::size_t DataSize>
+  void saveBinary(const void* data, std::size_t size) {
+    const byte* const bytes(static_cast<const byte*>(data));
+    if (detail::kLittleEndianHost || DataSize == 1) {
+      output_.insert(output_.end(), bytes, bytes + size);
+      return;
+    }
+    const std::size_t offset(output_.size());
+    output_.resize(offset + size);
+    detail::CopyLittleEndian<DataSize>(output_.data() + offset, bytes, size);
+  }
+
+  void saveVarint(std::uint64_t value) {
+    byte encoded[detail::kMaxVarintSize];
+    std::size_t size(0);
+    while (value >= 0x80) {
+      encoded[size++] = static_cast<byte>(value | 0x80);
+      value >>= 7;
+    }
+    encoded[size++] = static_cast<byte>(value);
+    output_.insert(output_.end(), encoded, encoded + size);
+  }
+
+ private:
+  SerialisedData& output_;
+};
+
+class PortableBinaryInputArchive : public cereal::InputArchive<PortableBinaryInputArchive> {
+ public:
+  // Reads from 'size' bytes at 'data', which must outlive the archive.
+  PortableBinaryInputArchive(const byte* data, std::size_t size)
+      : cereal::InputArchive<PortableBinaryInputArchive>(this), cursor_(data), end_(data + size) {}
+
+  PortableBinaryInputArchive(const PortableBinaryInputArchive&) = delete;
+  PortableBinaryInputArchive& operator=(const PortableBinaryInputArchive&) = delete;
+
+  // Number of bytes not yet read.
+  std::size_t remaining() const { return static_cast<std::size_t>(end_ - cursor_); }
+
+  // Reads 'size' bytes of 'DataSize'-byte little-endian values into host order.
+  template <std::size_t DataSize>
+  void loadBinary(void* const data, std::size_t size) {
+    if (size > remaining())
+      throw cereal::Exception("Failed to read " + std::to_string(size) +
+                              " bytes from input buffer! Only " + std::to_string(remaining()) +
+                              " available");
+    detail::CopyLittleEndian<DataSize>(static_cast<byte*>(data), cursor_, size);
+    cursor_ += size;
+  }
+
+  // Throws if the input ends mid-varint or the encoded value doesn't fit in 64 bits.
+  std::uint64_t loadVarint() {
+    std::uint64_t value(0);
+    for (unsigned shift(0); shift < 64; shift += 7) {
+      if (cursor_ == end_)
+        throw cereal::Exception("Truncated varint in input buffer");
+      const byte next(*cursor_++);
+      if (shift == 63 && next > 1)
+        break;
+      value |= static_cast<std::uint64_t>(next & 0x7f) << shift;
+      if ((next & 0x80) == 0)
+        return value;
+    }
+    throw cereal::Exception("Varint in input buffer exceeds 64 bits");
+  }
+
+ private:
+  const byte* cursor_;
+  const byte* const end_;
+};
+
+// Saving for arithmetic types to portable binary
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type CEREAL_SAVE_FUNCTION_NAME(
+    PortableBinaryOutputArchive& ar, T const& t) {
+  static_assert(!std::is_floating_point<T>::value || std::numeric_limits<T>::is_iec559,
+                "Portable binary only supports IEEE 754 floating point");
+  ar.template saveBinary<sizeof(T)>(std::addressof(t), sizeof(t));
+}
+
+// Loading for arithmetic types from portable binary
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type CEREAL_LOAD_FUNCTION_NAME(
+    PortableBinaryInputArchive& ar, T& t) {
+  static_assert(!std::is_floating_point<T>::value || std::numeric_limits<T>::is_iec559,
+                "Portable binary only supports IEEE 754 floating point");
+  ar.template loadBinary<sizeof(T)>(std::addressof(t), sizeof(t));
+}
+
+// Serializing NVP types to portable binary
+template <class Archive, class T>
+inline CEREAL_ARCHIVE_RESTRICT(PortableBinaryInputArchive, PortableBinaryOutputArchive)
+    CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, cereal::NameValuePair<T>& t) {
+  ar(t.value);
+}
+
+// Saving SizeTags as varints
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(PortableBinaryOutputArchive& ar,
+                                      cereal::SizeTag<T> const& tag) {
+  ar.saveVarint(static_cast<std::uint64_t>(tag.size));
+}
+
+// Loading SizeTags from varints
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(PortableBinaryInputArchive& ar, cereal::SizeTag<T>& tag) {
+  using SizeType = typename std::remove_reference<T>::type;
+  const std::uint64_t size(ar.loadVarint());
+  if (size > static_cast<std::uint64_t>(std::numeric_limits<SizeType>::max()))
+    throw cereal::Exception("Size tag " + std::to_string(size) + " is out of range");
+  tag.size = static_cast<SizeType>(size);
+}
+
+// Saving binary data, converting each element to little-endian
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(PortableBinaryOutputArchive& ar,
+                                      cereal::BinaryData<T> const& bd) {
+  using ElementType = typename std::remove_pointer<T>::type;
+  ar.template saveBinary<sizeof(ElementType)>(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+// Loading binary data, converting each element from little-endian
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(PortableBinaryInputArchive& ar, cereal::BinaryData<T>& bd) {
+  using ElementType = typename std::remove_pointer<T>::type;
+  ar.template loadBinary<sizeof(ElementType)>(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+// Loading vectors of arithmetic types, rejecting a size tag which claims more elements than the
+// input holds before allocating
+template <class T, class A>
+inline typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                               void>::type
+    CEREAL_LOAD_FUNCTION_NAME(PortableBinaryInputArchive& ar, std::vector<T, A>& vector) {
+  const std::uint64_t size(ar.loadVarint());
+  if (size > ar.remaining() / sizeof(T))
+    throw cereal::Exception("Vector of " + std::to_string(size) + " elements exceeds input size");
+  vector.resize(static_cast<std::size_t>(size));
+  ar.template loadBinary<sizeof(T)>(vector.data(), vector.size() * sizeof(T));
+}
+
+template <class T, class A>
+inline typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                               void>::type
+    CEREAL_SAVE_FUNCTION_NAME(PortableBinaryOutputArchive& ar, std::vector<T, A> const& vector) {
+  ar.saveVarint(vector.size());
+  ar.template saveBinary<sizeof(T)>(vector.data(), vector.size() * sizeof(T));
+}
+
+}  // namespace maidsafe
+
+// Register archives for polymorphic support
+CEREAL_REGISTER_ARCHIVE(maidsafe::PortableBinaryOutputArchive)
+CEREAL_REGISTER_ARCHIVE(maidsafe::PortableBinaryInputArchive)
+
+// tie input and output archives together
+CEREAL_SETUP_ARCHIVE_TRAITS(maidsafe::PortableBinaryInputArchive,
+                            maidsafe::PortableBinaryOutputArchive)
+
+#endif  // MAIDSAFE_COMMON_SERIALISATION_PORTABLE_BINARY_ARCHIVE_H_
@@ -18,27 +18,31 @@
 
 
 /*
- * There two flavours of serialization and de-serialization functions here. One that works on
- * strings and the other that works on streams. This is because the string ones create
- * stringstreams as local variables and stringstreams being locale aware have poor contruction
- * speed. Thus if the client code wants to provide streams himself so that he can cache and reuse
- * the streams, the functions which directly operate on streams can be used.
+ * There are two flavours of the ConvertTo/ConvertFrom functions here: one that works on strings and
+ * the other that works on streams.  The string ones write to and read from the string directly via
+ * maidsafe's binary archives, so don't construct any (locale-aware, hence slow to construct)
+ * stringstreams.  The stream ones are for callers which need to work with an existing stream.  Both
+ * produce the same format, which is also that of Serialise.
  */
 
 #ifndef MAIDSAFE_COMMON_SERIALISATION_SERIALISATION_H_
 #define MAIDSAFE_COMMON_SERIALISATION_SERIALISATION_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "boost/expected/expected.hpp"
 #include "cereal/archives/binary.hpp"
 #include "cereal/types/map.hpp"
 #include "cereal/types/vector.hpp"
 #include "cereal/types/string.hpp"
 #include "cereal/types/boost_optional.hpp"
 
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/serialisation/binary_archive.h"
+#include "maidsafe/common/serialisation/portable_binary_archive.h"
 
 namespace maidsafe {
 
@@ -61,8 +65,42 @@ SerialisedData Serialise(OutputVectorStream& binary_output_stream,
 
 template <typename... TypesToSerialise>
 SerialisedData Serialise(TypesToSerialise&&... objects_to_serialise) {
-  OutputVectorStream binary_output_stream;
-  return Serialise(binary_output_stream, std::forward<TypesToSerialise>(objects_to_serialise)...);
+  SerialisedData serialised;
+  {
+    BinaryOutputArchive binary_output_archive(serialised);
+    binary_output_archive(std::forward<TypesToSerialise>(objects_to_serialise)...);
+  }
+  return serialised;
+}
+
+// Replaces the contents of 'buffer' with the serialised objects.  The buffer's capacity is
+// retained, so reusing one buffer for many calls avoids reallocating it each time.
+template <typename... TypesToSerialise>
+void SerialiseInto(SerialisedData& buffer, TypesToSerialise&&... objects_to_serialise) {
+  buffer.clear();
+  BinaryOutputArchive binary_output_archive(buffer);
+  binary_output_archive(std::forward<TypesToSerialise>(objects_to_serialise)...);
+}
+
+// The number of bytes which Serialise would produce for the objects, found without copying any
+// data.  Worthwhile ahead of serialising large or deeply nested objects, to reserve exactly.
+template <typename... TypesToSerialise>
+std::size_t SerialisedSize(TypesToSerialise&&... objects_to_serialise) {
+  BinarySizeArchive binary_size_archive;
+  binary_size_archive(std::forward<TypesToSerialise>(objects_to_serialise)...);
+  return binary_size_archive.size();
+}
+
+// As for Serialise, but allocates the result exactly once by first running SerialisedSize.
+template <typename... TypesToSerialise>
+SerialisedData SerialiseExact(const TypesToSerialise&... objects_to_serialise) {
+  SerialisedData serialised;
+  serialised.reserve(SerialisedSize(objects_to_serialise...));
+  {
+    BinaryOutputArchive binary_output_archive(serialised);
+    binary_output_archive(objects_to_serialise...);
+  }
+  return serialised;
 }
 
 template <typename ParsedType>
@@ -75,10 +113,38 @@ ParsedType Parse(InputVectorStream& binary_input_stream) {
   return parsed;
 }
 
+// Parses in place from 'size' bytes at 'data', e.g. a received message or a mapped file, without
+// first copying them into a SerialisedData.
+template <typename ParsedType>
+ParsedType Parse(const byte* data, std::size_t size) {
+  ParsedType parsed;
+  {
+    BinaryInputArchive binary_input_archive(data, size);
+    binary_input_archive(parsed);
+  }
+  return parsed;
+}
+
 template <typename ParsedType>
 ParsedType Parse(const SerialisedData& serialised_data) {
-  InputVectorStream binary_input_stream{serialised_data};
-  return Parse<ParsedType>(binary_input_stream);
+  return Parse<ParsedType>(serialised_data.data(), serialised_data.size());
+}
+
+// As for Parse, but returns CommonErrors::parsing_error rather than throwing.  The archives and the
+// types' load functions report errors by throwing, so this catches internally: it saves callers a
+// try block, but an invalid input still costs an unwind.
+template <typename ParsedType>
+boost::expected<ParsedType, common_error> TryParse(const byte* data, std::size_t size) {
+  try {
+    return Parse<ParsedType>(data, size);
+  } catch (const std::exception&) {
+    return boost::make_unexpected(MakeError(CommonErrors::parsing_error));
+  }
+}
+
+template <typename ParsedType>
+boost::expected<ParsedType, common_error> TryParse(const SerialisedData& serialised_data) {
+  return TryParse<ParsedType>(serialised_data.data(), serialised_data.size());
 }
 
 template <typename... TypesToParse>
@@ -87,10 +153,75 @@ void Parse(InputVectorStream& binary_input_stream, TypesToParse&... objects_to_p
   binary_input_archive(objects_to_parse...);
 }
 
+template <typename... TypesToParse>
+void Parse(const byte* data, std::size_t size, TypesToParse&... objects_to_parse) {
+  BinaryInputArchive binary_input_archive(data, size);
+  binary_input_archive(objects_to_parse...);
+}
+
 template <typename... TypesToParse>
 void Parse(const SerialisedData& serialised_data, TypesToParse&... objects_to_parse) {
-  InputVectorStream binary_input_stream{serialised_data};
-  Parse(binary_input_stream, objects_to_parse...);
+  Parse(serialised_data.data(), serialised_data.size(), objects_to_parse...);
+}
+
+// As for Parse, but marks the archive as reading from a trusted source, so that types which
+// validate their content while loading may skip that (e.g. ImmutableData doesn't rehash its
+// value).  Only use this for data whose integrity is already assured, e.g. data this process
+// serialised itself and read back from a checksummed local store; never for network input.
+template <typename ParsedType>
+ParsedType ParseTrusted(const byte* data, std::size_t size) {
+  ParsedType parsed;
+  {
+    BinaryInputArchive binary_input_archive(data, size, true);
+    binary_input_archive(parsed);
+  }
+  return parsed;
+}
+
+template <typename ParsedType>
+ParsedType ParseTrusted(const SerialisedData& serialised_data) {
+  return ParseTrusted<ParsedType>(serialised_data.data(), serialised_data.size());
+}
+
+
+
+// Endian-safe equivalents of Serialise and Parse using the portable binary archives, for data
+// exchanged between hosts which may differ in byte order.  The format is not interchangeable with
+// that of Serialise.
+template <typename... TypesToSerialise>
+SerialisedData SerialisePortable(TypesToSerialise&&... objects_to_serialise) {
+  SerialisedData serialised;
+  {
+    PortableBinaryOutputArchive portable_output_archive(serialised);
+    portable_output_archive(std::forward<TypesToSerialise>(objects_to_serialise)...);
+  }
+  return serialised;
+}
+
+template <typename ParsedType>
+ParsedType ParsePortable(const byte* data, std::size_t size) {
+  ParsedType parsed;
+  {
+    PortableBinaryInputArchive portable_input_archive(data, size);
+    portable_input_archive(parsed);
+  }
+  return parsed;
+}
+
+template <typename ParsedType>
+ParsedType ParsePortable(const SerialisedData& serialised_data) {
+  return ParsePortable<ParsedType>(serialised_data.data(), serialised_data.size());
+}
+
+template <typename... TypesToParse>
+void ParsePortable(const byte* data, std::size_t size, TypesToParse&... objects_to_parse) {
+  PortableBinaryInputArchive portable_input_archive(data, size);
+  portable_input_archive(objects_to_parse...);
+}
+
+template <typename... TypesToParse>
+void ParsePortable(const SerialisedData& serialised_data, TypesToParse&... objects_to_parse) {
+  ParsePortable(serialised_data.data(), serialised_data.size(), objects_to_parse...);
 }
 
 
@@ -113,8 +244,12 @@ inline std::string ConvertToString(std::stringstream& ref_dest_stream,
 
 template <typename... TypesToSerialise>
 inline std::string ConvertToString(TypesToSerialise&&... ref_source_objs) {
-  std::stringstream str_stream;
-  return ConvertToString(str_stream, std::forward<TypesToSerialise>(ref_source_objs)...);
+  std::string result;
+  {
+    BinaryOutputArchive output_archive(result);
+    output_archive(std::forward<TypesToSerialise>(ref_source_objs)...);
+  }
+  return result;
 }
 
 template <typename... DeSerialiseToTypes>
@@ -143,21 +278,22 @@ inline DeSerialiseToType ConvertFromStream(std::istream& ref_source_stream) {
 template <typename... DeSerialiseToTypes>
 inline void ConvertFromString(const std::string& ref_source_string,
                               DeSerialiseToTypes&... ref_dest_objs) {
-  std::stringstream str_stream{ref_source_string};
-  ConvertFromStream(str_stream, ref_dest_objs...);
+  Parse(reinterpret_cast<const byte*>(ref_source_string.data()), ref_source_string.size(),
+        ref_dest_objs...);
 }
 
 template <typename DeSerialiseToType>
 inline DeSerialiseToType& ConvertFromString(const std::string& ref_source_string,
                                             DeSerialiseToType& ref_dest_obj) {
-  std::stringstream str_stream{ref_source_string};
-  return ConvertFromStream(str_stream, ref_dest_obj);
+  Parse(reinterpret_cast<const byte*>(ref_source_string.data()), ref_source_string.size(),
+        ref_dest_obj);
+  return ref_dest_obj;
 }
 
 template <typename DeSerialiseToType>
 inline DeSerialiseToType ConvertFromString(const std::string& ref_source_string) {
-  std::stringstream str_stream{ref_source_string};
-  return ConvertFromStream<DeSerialiseToType>(str_stream);
+  return Parse<DeSerialiseToType>(reinterpret_cast<const byte*>(ref_source_string.data()),
+                                  ref_source_string.size());
 }
 
 }  // namespace maidsafe
@@ -0,0 +1,112 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SET_RECONCILIATION_H_
+#define MAIDSAFE_COMMON_SET_RECONCILIATION_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boost/expected/expected.hpp"
+#include "cereal/types/array.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+// An invertible Bloom lookup table over a set of Identities, letting two peers find the keys each
+// holds which the other doesn't (e.g. during churn) by exchanging data proportional to the size of
+// that difference rather than of the sets.
+//
+// The sketch is maintained incrementally via Add and Remove alongside the set it summarises (e.g.
+// a DataBuffer's keys or an index), at the largest size likely to be needed.  To reconcile, a peer
+// sends its sketch folded down to a size suited to the expected difference: about 1.5 cells per
+// differing key, plus a few dozen, decodes with high probability.  The receiver folds its own
+// sketch to the same size, subtracts the received one and decodes the result.  If decoding fails,
+// the difference was too large for that size, and the exchange can be repeated at twice the size
+// until it succeeds (or falls back to exchanging whole key lists).  The difference in KeyCount
+// gives a lower bound for the first attempt.
+//
+// Keys are assumed to be uniformly distributed (as hashes are); cells are chosen from the key's
+// own bytes rather than by hashing it.  Each cell costs 76 bytes when serialised.
+class KeySetSketch {
+ public:
+  struct Difference {
+    // Keys in the set summarised by the minuend but not the subtrahend, and vice versa.
+    std::vector<Identity> local_only, remote_only;
+  };
+
+  static const std::size_t kPartitionCount = 3;
+
+  // An empty sketch with no cells, e.g. for parsing into.
+  KeySetSketch();
+  // 'cells_per_partition' must be a non-zero power of two (the sketch has three partitions).
+  explicit KeySetSketch(std::size_t cells_per_partition);
+
+  // Throws if 'key' is uninitialised.  Adding a key which is already present, or removing one
+  // which isn't, corrupts the sketch (as would any mismatch between it and the set).
+  void Add(const Identity& key);
+  void Remove(const Identity& key);
+
+  std::size_t CellsPerPartition() const { return counts_.size() / kPartitionCount; }
+  std::int64_t KeyCount() const { return key_count_; }
+
+  // Returns a sketch of the same keys with 'cells_per_partition' cells per partition, which must
+  // be a non-zero power of two no larger than this sketch's.
+  KeySetSketch Fold(std::size_t cells_per_partition) const;
+  // Cellwise difference, leaving a sketch of the keys held by only one of the sets.  Throws unless
+  // both sketches have the same size.
+  KeySetSketch& operator-=(const KeySetSketch& other);
+  // Decodes a difference produced by operator-=.  Returns CommonErrors::cannot_exceed_limit if the
+  // difference is too large to be decoded at this sketch's size.
+  boost::expected<Difference, common_error> Decode() const;
+
+  // Parsing (see serialisation.h) throws CommonErrors::parsing_error if the cell counts are
+  // invalid.
+  template <typename Archive>
+  void save(Archive& archive) const {
+    archive(key_count_, counts_, key_sums_, checksums_);
+  }
+  template <typename Archive>
+  void load(Archive& archive) {
+    archive(key_count_, counts_, key_sums_, checksums_);
+    Validate();
+  }
+
+ private:
+  using KeySum = std::array<byte, identity_size>;
+
+  void Toggle(const KeySum& key, std::int32_t count);
+  std::size_t CellIndex(const KeySum& key, std::size_t partition) const;
+  bool IsPure(std::size_t index) const;
+  void Validate() const;
+
+  std::int64_t key_count_;
+  std::vector<std::int32_t> counts_;
+  std::vector<KeySum> key_sums_;
+  std::vector<std::uint64_t> checksums_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_SET_RECONCILIATION_H_
@@ -0,0 +1,94 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SHARD_H_
+#define MAIDSAFE_COMMON_SHARD_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace maidsafe {
+
+namespace shard {
+
+// Stable mappings of keys to shards, e.g. for striping a container or partitioning work across
+// threads.  An Identity is already a uniformly distributed hash, so its leading 64 bits are used
+// directly rather than being hashed again.  The mappings depend only on the key and the shards, so
+// are the same across processes and platforms.
+
+// The leading 64 bits of 'id' as a big-endian integer.  Throws if 'id' is uninitialised.
+std::uint64_t KeyBits(const Identity& id);
+// As above, with the type id mixed in so that a name's different types may map to different shards.
+std::uint64_t KeyBits(const Data::NameAndTypeId& key);
+
+// Jump consistent hashing (Lamping and Veach): returns a shard in [0, shard_count).  When
+// 'shard_count' grows by one, only the keys which then map to the new shard move (about
+// 1 / shard_count of them).  Suitable where shards are numbered consecutively and only ever added
+// or removed at the end.  Throws CommonErrors::invalid_argument if 'shard_count' is 0.
+std::uint32_t JumpShard(std::uint64_t key_bits, std::uint32_t shard_count);
+std::uint32_t JumpShard(const Identity& id, std::uint32_t shard_count);
+std::uint32_t JumpShard(const Data::NameAndTypeId& key, std::uint32_t shard_count);
+
+// Weighted rendezvous (highest random weight) hashing over an arbitrary set of shards, each
+// identified by a caller-chosen id.  Each key maps to the shard with the highest score, so adding
+// or removing a shard only moves the keys which map to or from it, and each shard receives a share
+// of the keys proportional to its weight.  Selection costs O(number of shards).  Not thread-safe if
+// modified concurrently with Select.
+class RendezvousShards {
+ public:
+  RendezvousShards() : shards_() {}
+
+  // Throws CommonErrors::invalid_argument if 'id' is already present or 'weight' is not positive.
+  void Add(std::uint64_t id, double weight = 1.0);
+  // Returns false if 'id' isn't present.
+  bool Remove(std::uint64_t id);
+
+  // Returns the id of the shard for the key.  Throws CommonErrors::no_such_element if there are no
+  // shards.
+  std::uint64_t Select(std::uint64_t key_bits) const;
+  std::uint64_t Select(const Identity& id) const { return Select(KeyBits(id)); }
+  std::uint64_t Select(const Data::NameAndTypeId& key) const { return Select(KeyBits(key)); }
+
+  // Returns up to 'count' distinct shard ids, best first, e.g. to choose replicas for a key.  The
+  // first is always the one returned by Select.
+  std::vector<std::uint64_t> SelectN(std::uint64_t key_bits, size_t count) const;
+  std::vector<std::uint64_t> SelectN(const Identity& id, size_t count) const {
+    return SelectN(KeyBits(id), count);
+  }
+
+  size_t size() const { return shards_.size(); }
+
+ private:
+  struct Shard {
+    std::uint64_t id, id_bits;
+    double weight;
+  };
+
+  double Score(const Shard& shard, std::uint64_t key_bits) const;
+
+  std::vector<Shard> shards_;
+};
+
+}  // namespace shard
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_SHARD_H_
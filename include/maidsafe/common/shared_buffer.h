@@ -0,0 +1,81 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_SHARED_BUFFER_H_
+#define MAIDSAFE_COMMON_SHARED_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+// An immutable, reference-counted byte range.  Copies and slices share the underlying storage
+// rather than copying it, and each keeps that storage alive, so a single payload (e.g. a chunk) can
+// be handed between subsystems without being copied at every hop.  Copies may be used concurrently
+// from different threads, since the bytes are never modified.
+class SharedBuffer {
+ public:
+  SharedBuffer() : owner_(), data_(nullptr), size_(0), string_(nullptr) {}
+  // Takes ownership of 'bytes' without copying them.
+  explicit SharedBuffer(std::vector<byte> bytes);
+  // Takes ownership of 'value' without copying it.  Throws if 'value' is uninitialised.
+  explicit SharedBuffer(NonEmptyString value);
+  // Shares ownership of 'value'.  Throws if 'value' is null or uninitialised.
+  explicit SharedBuffer(std::shared_ptr<const NonEmptyString> value);
+  // Shares ownership of 'owner', which must keep the 'size' bytes at 'data' alive and unchanged.
+  explicit SharedBuffer(std::shared_ptr<const void> owner, const byte* data, std::size_t size);
+
+  const byte* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  const byte* begin() const { return data_; }
+  const byte* end() const { return data_ + size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns a buffer sharing this one's storage which covers 'size' bytes from 'offset', or
+  // everything from 'offset' onwards.  Throws CommonErrors::outside_of_bounds if the range isn't
+  // within this buffer.
+  SharedBuffer Slice(std::size_t offset, std::size_t size) const;
+  SharedBuffer Slice(std::size_t offset) const;
+
+  // If this buffer covers the whole of a NonEmptyString which it shares (i.e. it was constructed
+  // from one and not sliced), returns that string (sharing ownership), otherwise returns null.
+  // This allows APIs which hold values as NonEmptyStrings to accept a SharedBuffer without copying.
+  std::shared_ptr<const NonEmptyString> SharedString() const;
+  // Returns the shared string if available, otherwise a new one holding a copy of the bytes.
+  // Throws if empty.
+  std::shared_ptr<const NonEmptyString> ToSharedString() const;
+  // Returns a copy of the bytes.  Throws if empty.
+  NonEmptyString ToNonEmptyString() const;
+
+ private:
+  std::shared_ptr<const void> owner_;
+  const byte* data_;
+  std::size_t size_;
+  const NonEmptyString* string_;
+};
+
+// Compares contents.
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs);
+bool operator!=(const SharedBuffer& lhs, const SharedBuffer& rhs);
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_SHARED_BUFFER_H_
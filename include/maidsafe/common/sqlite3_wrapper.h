@@ -19,11 +19,32 @@
 #ifndef MAIDSAFE_COMMON_SQLITE3_WRAPPER_H_
 #define MAIDSAFE_COMMON_SQLITE3_WRAPPER_H_
 
-#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "asio/associated_executor.hpp"
+#include "asio/async_result.hpp"
+#include "asio/post.hpp"
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/completion_handler.h"
 #include "maidsafe/common/serialisation/serialisation.h"
 
 
@@ -34,7 +55,10 @@ namespace maidsafe {
 
 namespace sqlite {
 
+struct SharedFileState;
 struct Statement;
+template <typename... Columns>
+struct RowRange;
 
 // Modes for file open operations
 enum class Mode {
@@ -43,25 +67,115 @@ enum class Mode {
   kReadWriteCreate = 0x00000002 | 0x00000004  // SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE
 };
 
+// Values for PRAGMA synchronous.
+enum class Synchronous { kOff = 0, kNormal = 1, kFull = 2, kExtra = 3 };
+
+// Values for PRAGMA temp_store.
+enum class TempStore { kDefault = 0, kFile = 1, kMemory = 2 };
+
+// Per-connection settings applied when a Database is opened.  The journal mode is always WAL.  A
+// default-constructed Options gives the settings every Database used before these were
+// configurable; the named profiles trade durability for speed to different degrees:
+//   Throughput - no syncing at all, so a power failure can corrupt the database; large page cache
+//                and memory-mapped I/O.
+//   Balanced   - synced at checkpoints only, so a power failure can lose the latest commits but
+//                not corrupt the database; moderate page cache and memory-mapped I/O.
+//   Durable    - synced at every commit; SQLite's default cache and no memory-mapped I/O.
+struct Options {
+  Options();
+
+  static Options Throughput();
+  static Options Balanced();
+  static Options Durable();
+
+  Synchronous synchronous;
+  // As PRAGMA cache_size: a number of pages if positive, or of KiB if negative.
+  std::int64_t cache_size;
+  // Bytes of the database file to access via memory-mapping.  0 disables memory-mapped I/O.
+  std::int64_t mmap_size;
+  // Only has an effect when a database is created.  0 means SQLite's default.
+  int page_size;
+  TempStore temp_store;
+  std::chrono::milliseconds busy_timeout;
+};
+
+// The state of a database's write-ahead log, as last reported to this process by a commit or a
+// checkpoint.  Commits made by other processes aren't seen until the next checkpoint.
+struct WalMetrics {
+  // Frames in the WAL, and how many of those have already been copied back into the database.
+  int wal_frames;
+  int checkpointed_frames;
+  // Checkpoints run by Checkpointers in this process, and attempts abandoned as the database was
+  // busy.
+  std::uint64_t passive_checkpoints;
+  std::uint64_t truncate_checkpoints;
+  std::uint64_t busy_checkpoints;
+};
+
+// Prepared statements released by Statement are kept by their Database, keyed by query text, for
+// reuse by later Statements with the same query.  At most 'statement_cache_capacity' idle
+// statements are kept; beyond that, the least recently released is finalised.  A capacity of 0
+// disables the cache.
 struct Database {
-  Database(const boost::filesystem::path& filename, Mode mode);
+  static const std::size_t kDefaultStatementCacheCapacity = 32;
+
+  Database(const boost::filesystem::path& filename, Mode mode,
+           std::size_t statement_cache_capacity = kDefaultStatementCacheCapacity);
+  Database(const boost::filesystem::path& filename, Mode mode, const Options& options,
+           std::size_t statement_cache_capacity = kDefaultStatementCacheCapacity);
   ~Database();
   Database(const Database&) = delete;
   Database(Database&&) = delete;
   Database& operator=(Database) = delete;
 
+  // Runs a passive checkpoint on the caller's thread.  Prefer a Checkpointer, which does the same
+  // in the background.
   void CheckPoint();
   int InsertLimit() const { return insertlimit; }
+  WalMetrics GetWalMetrics() const;
+
+  // Counts of Statements constructed with and without a cached statement respectively.
+  std::uint64_t StatementCacheHits() const;
+  std::uint64_t StatementCacheMisses() const;
+  // The number of idle statements currently cached.
+  std::size_t StatementCacheSize() const;
 
+  friend struct Checkpointer;
   friend struct Transaction;
   friend struct Statement;
 
  private:
+  typedef std::list<std::pair<std::string, sqlite3_stmt*>> IdleStatements;
+
+  // Returns a cached statement for 'query' if there is one, otherwise prepares a new one.
+  sqlite3_stmt* AcquireStatement(const std::string& query);
+  // Resets 'statement' and clears its bindings, then caches it (or finalises it if the cache is
+  // disabled).
+  void ReleaseStatement(const std::string& query, sqlite3_stmt* statement);
+  void Finalise(sqlite3_stmt* statement);
+  // Failures are logged but otherwise ignored, as all are optimisations.
+  void SetPragma(const std::string& pragma);
+
   sqlite3* database;
   int insertlimit;
+  // Shared by all Databases in this process opened on the same file.
+  std::shared_ptr<SharedFileState> file_state;
+  const std::size_t statement_cache_capacity;
+  mutable std::mutex statement_cache_mutex;
+  // Most recently released at the front.
+  IdleStatements idle_statements;
+  std::unordered_multimap<std::string, IdleStatements::iterator> idle_statements_by_query;
+  std::uint64_t statement_cache_hits, statement_cache_misses;
 };
 
+// Begins a write ("BEGIN IMMEDIATE") transaction, which is rolled back on destruction unless
+// committed.  Transactions on the same file from within this process are queued on a mutex rather
+// than contending for SQLite's lock, so only other processes can make SQLite report the database
+// busy; in that case SQLite's busy handler waits for the lock.  If a transaction can't begin or
+// commit within kTimeout, CommonErrors::unable_to_handle_request is thrown.
 struct Transaction {
+  static const std::chrono::seconds kTimeout;
+
   explicit Transaction(Database& database_in);
   ~Transaction();
   Transaction(const Transaction&) = delete;
@@ -72,12 +186,212 @@ struct Transaction {
 
  private:
   void Execute(const std::string& query);
+  // Retries 'query' while SQLite reports the database busy, until 'deadline'.
+  void ExecuteBefore(const std::string& query, std::chrono::steady_clock::time_point deadline);
 
-  const int kAttempts;
   bool committed;
   Database& database;
+  std::unique_lock<std::timed_mutex> writer_lock;
+};
+
+// Owns a Database and a thread which applies enqueued mutations to it in batches, one Transaction
+// per batch.  A batch is committed once 'max_batch_size' mutations are queued or 'max_delay' after
+// the thread picks up the first mutation of the batch, whichever comes first.  Each mutation runs
+// in its own savepoint: if it throws, only its own changes are rolled back and only its future
+// receives the exception.  If the batch fails to commit, every future in it receives the error.
+// On destruction, all mutations already enqueued are applied before the thread is joined.
+struct GroupCommitWriter {
+  typedef std::function<void(Database&)> Mutation;
+
+  static const std::chrono::milliseconds kDefaultMaxDelay;
+  static const std::size_t kDefaultMaxBatchSize = 256;
+
+  GroupCommitWriter(const boost::filesystem::path& filename, Mode mode,
+                    std::chrono::milliseconds max_delay_in = kDefaultMaxDelay,
+                    std::size_t max_batch_size_in = kDefaultMaxBatchSize,
+                    const Options& options = Options());
+  ~GroupCommitWriter();
+  GroupCommitWriter(const GroupCommitWriter&) = delete;
+  GroupCommitWriter(GroupCommitWriter&&) = delete;
+  GroupCommitWriter& operator=(GroupCommitWriter) = delete;
+
+  // 'mutation' is invoked on the writer's thread, so mustn't touch the Database from elsewhere.
+  std::future<void> Enqueue(Mutation mutation);
+
+ private:
+  struct PendingMutation {
+    Mutation mutation;
+    std::promise<void> promise;
+  };
+
+  void Run();
+  void CommitBatch(std::vector<PendingMutation>& batch);
+
+  Database database;
+  const std::chrono::milliseconds max_delay;
+  const std::size_t max_batch_size;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<PendingMutation> queue;
+  bool stopping;
+  std::thread thread;
+};
+
+
+// Checkpoints the WAL of a database on a background thread using a connection of its own, since
+// the constructor of Database disables SQLite's automatic checkpoints.  Every 'poll_interval', a
+// PASSIVE checkpoint is run if at least 'passive_threshold' frames are waiting to be checkpointed;
+// this never blocks readers or writers.  Once no commit has been seen for 'idle_period', a TRUNCATE
+// checkpoint is run instead, which also empties the WAL file.  That doesn't wait for the database
+// to be free, but is abandoned and retried later if any other connection is using it.
+struct Checkpointer {
+  // SQLite's own default for automatic checkpoints.
+  static const int kDefaultPassiveThreshold = 1000;
+  static const std::chrono::milliseconds kDefaultPollInterval;
+  static const std::chrono::milliseconds kDefaultIdlePeriod;
+
+  Checkpointer(const boost::filesystem::path& filename,
+               int passive_threshold_in = kDefaultPassiveThreshold,
+               std::chrono::milliseconds poll_interval_in = kDefaultPollInterval,
+               std::chrono::milliseconds idle_period_in = kDefaultIdlePeriod);
+  ~Checkpointer();
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer(Checkpointer&&) = delete;
+  Checkpointer& operator=(Checkpointer) = delete;
+
+  WalMetrics Metrics() const { return database.GetWalMetrics(); }
+
+ private:
+  void Run();
+  void CheckpointIfDue();
+
+  Database database;
+  const int passive_threshold;
+  const std::chrono::milliseconds poll_interval, idle_period;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping;
+  std::thread thread;
+};
+
+// A writer connection plus a pool of read-only connections on the same file.  Since the database is
+// in WAL mode, reads on the pooled connections proceed concurrently with each other and with any
+// transaction on the writer, each seeing the last committed state as of when its statement began.
+// If all readers are in use, Read blocks until one is returned.
+struct ConnectionPool {
+  // 'reader_count' of 0 means one reader per hardware thread.
+  ConnectionPool(const boost::filesystem::path& filename, std::size_t reader_count = 0,
+                 Mode writer_mode = Mode::kReadWriteCreate, const Options& options = Options());
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool(ConnectionPool&&) = delete;
+  ConnectionPool& operator=(ConnectionPool) = delete;
+
+  Database& Writer() { return writer; }
+
+  // Invokes 'functor' with an otherwise idle read-only Database and returns its result.
+  template <typename Functor>
+  auto Read(Functor functor) -> decltype(functor(std::declval<Database&>()));
+
+  std::size_t ReaderCount() const { return readers.size(); }
+
+ private:
+  struct ReaderLease {
+    explicit ReaderLease(ConnectionPool& pool_in) : pool(pool_in), reader(pool.AcquireReader()) {}
+    ~ReaderLease() { pool.ReleaseReader(reader); }
+    ReaderLease(const ReaderLease&) = delete;
+    ReaderLease(ReaderLease&&) = delete;
+    ReaderLease& operator=(ReaderLease) = delete;
+    ConnectionPool& pool;
+    Database& reader;
+  };
+
+  Database& AcquireReader();
+  void ReleaseReader(Database& reader);
+
+  Database writer;
+  std::vector<std::unique_ptr<Database>> readers;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Database*> idle_readers;
+};
+
+namespace detail {
+
+template <typename Result>
+struct QueryCompletion;
+
+// The completion signature for a query returning 'Result': void(std::error_code, Result), or
+// void(std::error_code) if 'Result' is void.
+template <typename Query>
+using QuerySignature = typename QueryCompletion<
+    typename std::result_of<Query(Database&)>::type>::Signature;
+
+}  // namespace detail
+
+// Runs queries on dedicated threads which own the connections of a ConnectionPool, so that callers
+// such as asio handlers never block on the database, including while SQLite waits out another
+// process's lock.  Reads run concurrently, one per reader connection.  Writes run one at a time in
+// the order they were queued, each in its own Transaction, which is committed if the query returns
+// and rolled back if it throws.
+//
+// A query is a functor taking a Database& and returning a result (which must be default
+// constructible and movable) or void.  Its completion receives the error it threw (or that thrown
+// beginning or committing the Transaction) and, unless void, its result, which is default
+// constructed on error.  On destruction, all queued queries are run and completed before the
+// threads are joined.
+struct QueryExecutor {
+  typedef std::function<void(std::function<void()>)> Executor;
+
+  // 'reader_count' of 0 means one reader per hardware thread.
+  QueryExecutor(const boost::filesystem::path& filename, std::size_t reader_count = 0,
+                Mode writer_mode = Mode::kReadWriteCreate, const Options& options = Options());
+  ~QueryExecutor();
+  QueryExecutor(const QueryExecutor&) = delete;
+  QueryExecutor(QueryExecutor&&) = delete;
+  QueryExecutor& operator=(QueryExecutor) = delete;
+
+  // Runs 'query' with a read-only Database, then invokes 'handler' via 'executor'.
+  template <typename Query, typename Handler>
+  void Read(Query query, Executor executor, Handler handler);
+  // Runs 'query' with the writer Database, then invokes 'handler' via 'executor'.
+  template <typename Query, typename Handler>
+  void Write(Query query, Executor executor, Handler handler);
+
+  // As above, but complete via an asio completion token, e.g. 'asio::use_future', a
+  // 'yield_context' or (in C++20 builds) 'asio::use_awaitable'.  The handler is run via its
+  // associated executor (asio's system executor if it has none).
+  template <typename Query, typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, detail::QuerySignature<Query>)
+  AsyncRead(Query query, CompletionToken&& token);
+  template <typename Query, typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, detail::QuerySignature<Query>)
+  AsyncWrite(Query query, CompletionToken&& token);
+
+  // Queries queued but not yet started.
+  std::size_t QueuedReads() const;
+  std::size_t QueuedWrites() const;
+
+ private:
+  typedef std::function<void()> Task;
+
+  void Enqueue(std::deque<Task>& queue, Task task);
+  void Run(std::deque<Task>& queue);
+  template <typename Handler>
+  static Executor PostingExecutor(const Handler& handler);
+
+  ConnectionPool pool;
+  mutable std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<Task> reads, writes;
+  bool stopping;
+  std::vector<std::thread> threads;
 };
 
+// A non-owning view of a blob.
+struct BlobView {
+  const byte* data;
+  std::size_t size;
+};
 
 enum class StepResult {
   kSqliteRow = 100,  // SQLITE_ROW
@@ -85,25 +399,263 @@ enum class StepResult {
 };
 
 struct Statement {
-  Statement(Database& database_in, const std::string& query);
+  // Uses a cached statement for 'query_in' if 'database_in' has one, otherwise prepares a new one.
+  // On destruction, the statement is returned to 'database_in''s cache.
+  Statement(Database& database_in, const std::string& query_in);
   ~Statement();
   Statement(const Statement&) = delete;
   Statement(Statement&&) = delete;
   Statement& operator=(Statement) = delete;
 
   void BindText(int index, const std::string& text);
+  void BindInt64(int row_index, std::int64_t value);
+  void BindDouble(int row_index, double value);
+  // SQLite takes a copy of 'blob'.
   void BindBlob(int row_index, const SerialisedData& blob);
+  // SQLite doesn't copy the blob, so it must remain valid and unmodified until the parameter is
+  // rebound or this Statement is destroyed.
+  void BindBlobStatic(int row_index, const SerialisedData& blob);
+  void BindBlobView(int row_index, BlobView blob);
   StepResult Step();
   void Reset();
 
   std::string ColumnText(int col_index);
+  std::int64_t ColumnInt64(int col_index);
+  double ColumnDouble(int col_index);
   SerialisedData ColumnBlob(int col_index);
+  // Returns the blob in place, without copying.  The view is only valid until the next call to
+  // Step or Reset, or until this Statement is destroyed.
+  BlobView ColumnBlobView(int col_index);
+  // Calls the Column function above for type 'T', which must be one of std::int64_t, double,
+  // std::string, SerialisedData or BlobView.
+  template <typename T>
+  T Column(int col_index);
+
+  // Steps through the remaining results, yielding each row as a tuple of its leading columns
+  // converted to 'Columns', e.g.
+  //   for (const auto& row : statement.Rows<std::int64_t, std::string>()) ...
+  template <typename... Columns>
+  RowRange<Columns...> Rows() {
+    return RowRange<Columns...>(*this);
+  }
 
  private:
+  void BindBlobData(int row_index, BlobView blob, bool copy);
+
   Database& database;
+  const std::string query;
   sqlite3_stmt* statement;
 };
 
+// Binds the values of row 'row' to 'statement', starting at parameter index 'first_index'.
+typedef std::function<void(Statement& statement, std::size_t row, int first_index)> RowBinder;
+
+// The most rows inserted by a single statement in BulkInsert.  This is SQLite's default
+// SQLITE_MAX_COMPOUND_SELECT, which limited multi-row VALUES clauses before SQLite 3.8.8.
+const std::size_t kMaxBulkInsertRows = 500;
+
+// Inserts 'row_count' rows of 'column_count' values each, using multi-row INSERT statements as
+// large as Database::InsertLimit() and kMaxBulkInsertRows allow.  'insert_into' is the statement up
+// to its VALUES clause, e.g. "INSERT OR REPLACE INTO KeyValue (KEY, VALUE)".  All but the last
+// statement are the same size, so reuse a single cached prepared statement.  No transaction is
+// begun, so the caller will normally want to hold one.
+void BulkInsert(Database& database, const std::string& insert_into, int column_count,
+                std::size_t row_count, const RowBinder& bind_row);
+
+template <typename Functor>
+auto ConnectionPool::Read(Functor functor) -> decltype(functor(std::declval<Database&>())) {
+  ReaderLease lease(*this);
+  return functor(lease.reader);
+}
+
+namespace detail {
+
+// Returns the error code of the exception currently being handled.
+std::error_code CurrentErrorCode();
+
+// Runs a query, optionally within a Transaction, and returns the invocation of 'handler' with its
+// outcome.
+template <typename Result>
+struct QueryCompletion {
+  typedef void Signature(std::error_code, Result);
+
+  template <typename Query, typename Handler>
+  static std::function<void()> Run(Query& query, Database& database, bool in_transaction,
+                                   const Handler& handler) {
+    try {
+      std::unique_ptr<Transaction> transaction(in_transaction ? new Transaction(database)
+                                                              : nullptr);
+      auto result(std::make_shared<Result>(query(database)));
+      if (transaction)
+        transaction->Commit();
+      return [handler, result] { handler(std::error_code(), std::move(*result)); };
+    } catch (...) {
+      const std::error_code error(CurrentErrorCode());
+      return [handler, error] { handler(error, Result()); };
+    }
+  }
+};
+
+template <>
+struct QueryCompletion<void> {
+  typedef void Signature(std::error_code);
+
+  template <typename Query, typename Handler>
+  static std::function<void()> Run(Query& query, Database& database, bool in_transaction,
+                                   const Handler& handler) {
+    try {
+      std::unique_ptr<Transaction> transaction(in_transaction ? new Transaction(database)
+                                                              : nullptr);
+      query(database);
+      if (transaction)
+        transaction->Commit();
+      return [handler] { handler(std::error_code()); };
+    } catch (...) {
+      const std::error_code error(CurrentErrorCode());
+      return [handler, error] { handler(error); };
+    }
+  }
+};
+
+}  // namespace detail
+
+template <typename Query, typename Handler>
+void QueryExecutor::Read(Query query, Executor executor, Handler handler) {
+  typedef typename std::result_of<Query(Database&)>::type Result;
+  Enqueue(reads, [this, query, executor, handler]() mutable {
+    executor(pool.Read([&](Database& reader) {
+      return detail::QueryCompletion<Result>::Run(query, reader, false, handler);
+    }));
+  });
+}
+
+template <typename Query, typename Handler>
+void QueryExecutor::Write(Query query, Executor executor, Handler handler) {
+  typedef typename std::result_of<Query(Database&)>::type Result;
+  Enqueue(writes, [this, query, executor, handler]() mutable {
+    executor(detail::QueryCompletion<Result>::Run(query, pool.Writer(), true, handler));
+  });
+}
+
+template <typename Handler>
+QueryExecutor::Executor QueryExecutor::PostingExecutor(const Handler& handler) {
+  auto executor(asio::get_associated_executor(handler));
+  return [executor](std::function<void()> functor) { asio::post(executor, std::move(functor)); };
+}
+
+template <typename Query, typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, detail::QuerySignature<Query>)
+QueryExecutor::AsyncRead(Query query, CompletionToken&& token) {
+  using Completion = asio::async_completion<CompletionToken, detail::QuerySignature<Query>>;
+  Completion init(token);
+  ::maidsafe::detail::SharedHandler<typename Completion::completion_handler_type> handler(
+      std::move(init.completion_handler));
+  Read(std::move(query), PostingExecutor(handler.handler()), handler);
+  return init.result.get();
+}
+
+template <typename Query, typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, detail::QuerySignature<Query>)
+QueryExecutor::AsyncWrite(Query query, CompletionToken&& token) {
+  using Completion = asio::async_completion<CompletionToken, detail::QuerySignature<Query>>;
+  Completion init(token);
+  ::maidsafe::detail::SharedHandler<typename Completion::completion_handler_type> handler(
+      std::move(init.completion_handler));
+  Write(std::move(query), PostingExecutor(handler.handler()), handler);
+  return init.result.get();
+}
+
+template <>
+inline std::int64_t Statement::Column<std::int64_t>(int col_index) {
+  return ColumnInt64(col_index);
+}
+
+template <>
+inline double Statement::Column<double>(int col_index) {
+  return ColumnDouble(col_index);
+}
+
+template <>
+inline std::string Statement::Column<std::string>(int col_index) {
+  return ColumnText(col_index);
+}
+
+template <>
+inline SerialisedData Statement::Column<SerialisedData>(int col_index) {
+  return ColumnBlob(col_index);
+}
+
+template <>
+inline BlobView Statement::Column<BlobView>(int col_index) {
+  return ColumnBlobView(col_index);
+}
+
+namespace detail {
+
+template <std::size_t Count, typename Row>
+struct ReadColumns {
+  static void Read(Statement& statement, Row& row) {
+    ReadColumns<Count - 1, Row>::Read(statement, row);
+    std::get<Count - 1>(row) =
+        statement.Column<typename std::tuple_element<Count - 1, Row>::type>(Count - 1);
+  }
+};
+
+template <typename Row>
+struct ReadColumns<0, Row> {
+  static void Read(Statement&, Row&) {}
+};
+
+}  // namespace detail
+
+// An input range over the rows of a Statement; see Statement::Rows.  Each row is read when the
+// iterator is dereferenced, so is only valid until the iterator is incremented (at least for any
+// BlobView columns).
+template <typename... Columns>
+struct RowRange {
+  typedef std::tuple<Columns...> Row;
+
+  struct Iterator {
+    typedef std::input_iterator_tag iterator_category;
+    typedef Row value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Row* pointer;
+    typedef const Row& reference;
+
+    Iterator() : statement(nullptr), row() {}
+    explicit Iterator(Statement& statement_in) : statement(&statement_in), row() { Advance(); }
+
+    reference operator*() const { return row; }
+    pointer operator->() const { return &row; }
+    Iterator& operator++() {
+      Advance();
+      return *this;
+    }
+    // Only equal when both are at the end, as for std::istream_iterator.
+    bool operator==(const Iterator& other) const { return statement == other.statement; }
+    bool operator!=(const Iterator& other) const { return statement != other.statement; }
+
+   private:
+    void Advance() {
+      if (statement->Step() == StepResult::kSqliteRow)
+        detail::ReadColumns<sizeof...(Columns), Row>::Read(*statement, row);
+      else
+        statement = nullptr;
+    }
+
+    Statement* statement;
+    Row row;
+  };
+
+  explicit RowRange(Statement& statement_in) : statement(statement_in) {}
+
+  Iterator begin() { return Iterator(statement); }
+  Iterator end() { return Iterator(); }
+
+ private:
+  Statement& statement;
+};
+
 }  // namespace sqlite
 
 }  // namespace maidsafe
@@ -0,0 +1,57 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_STARTUP_TIMER_H_
+#define MAIDSAFE_COMMON_STARTUP_TIMER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace maidsafe {
+
+// Measures how long a subsystem takes to initialise, for diagnosing slow process startup.  Timing
+// is only done if the environment variable MAIDSAFE_STARTUP_TIMES is set; the durations recorded
+// are then written to stderr, in the order they were recorded, when the process exits.  Otherwise a
+// StartupTimer costs a single check of a cached flag.
+//
+// Subsystems which aren't needed by every process (e.g. logging threads and logfiles) are set up
+// lazily on first use, so these timings show the cost of the ones a given process actually uses.
+class StartupTimer {
+ public:
+  using Timings = std::vector<std::pair<std::string, std::chrono::microseconds>>;
+
+  // 'subsystem' must outlive the timer, e.g. be a string literal.
+  explicit StartupTimer(const char* subsystem);
+  StartupTimer(const StartupTimer&) = delete;
+  StartupTimer& operator=(const StartupTimer&) = delete;
+  ~StartupTimer();
+
+  static bool Enabled();
+  // Returns the durations recorded so far.
+  static Timings Recorded();
+
+ private:
+  const char* const subsystem_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_STARTUP_TIMER_H_
@@ -0,0 +1,76 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_STREAM_ENCRYPTION_H_
+#define MAIDSAFE_COMMON_STREAM_ENCRYPTION_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+// Encryption of arbitrarily large data with bounded memory.  The plaintext is split into segments
+// of kStreamSegmentSize bytes (the last may be shorter, and empty input is a single empty
+// segment), and each is encrypted as for the buffer version of SymmEncrypt, so that the
+// ciphertext is the concatenation of kStreamCiphertextSegmentSize-byte encrypted segments.
+//
+// Following the STREAM construction, each segment's IV is the first 11 bytes of the IV in
+// 'key_and_iv', then the segment's index as a big-endian uint32, then a byte which is 1 for the
+// last segment and 0 otherwise.  Reordering, dropping, duplicating or truncating segments is
+// therefore detected when decrypting.
+//
+// Segments are processed on several threads, kStreamSegmentsPerThread at a time per thread.  All
+// functions throw on invalid 'key_and_iv', on I/O failure, or on authentication failure.  When
+// decrypting, segments are only written to 'output' once authenticated, but if a later segment
+// fails 'output' will have received an incomplete plaintext.
+const std::size_t kStreamSegmentSize = 64 * 1024;
+const std::size_t kStreamCiphertextSegmentSize = kStreamSegmentSize + AES256_TagSize;
+const std::size_t kStreamSegmentsPerThread = 4;
+
+void StreamEncrypt(std::istream& input, std::ostream& output, const AES256KeyAndIV& key_and_iv);
+void StreamDecrypt(std::istream& input, std::ostream& output, const AES256KeyAndIV& key_and_iv);
+
+void StreamEncryptFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+                       const AES256KeyAndIV& key_and_iv);
+void StreamDecryptFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+                       const AES256KeyAndIV& key_and_iv);
+
+// Returns the number of segments in ciphertext of 'ciphertext_size' bytes.  Throws if that isn't
+// a valid ciphertext size.
+std::uint64_t StreamSegmentCount(std::uint64_t ciphertext_size);
+
+// Decrypts only segment 'index' of the ciphertext in 'input', which must be seekable, giving the
+// (up to kStreamSegmentSize) bytes of plaintext starting at offset 'index' * kStreamSegmentSize.
+// Throws if 'index' is beyond the last segment.
+std::vector<byte> StreamDecryptSegment(std::istream& input, std::uint64_t index,
+                                       const AES256KeyAndIV& key_and_iv);
+
+}  // namespace crypto
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_STREAM_ENCRYPTION_H_
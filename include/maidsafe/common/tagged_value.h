@@ -19,9 +19,11 @@
 #ifndef MAIDSAFE_COMMON_TAGGED_VALUE_H_
 #define MAIDSAFE_COMMON_TAGGED_VALUE_H_
 
+#include <type_traits>
 #include <utility>
 
 #include "maidsafe/common/config.h"
+#include "maidsafe/common/serialisation/binary_archive_fwd.h"
 
 namespace maidsafe {
 
@@ -45,12 +47,44 @@ struct TaggedValue {
   T const* operator->() const { return &data; }
   T* operator->() { return &data; }
 
+  // With maidsafe's binary archives, an arithmetic value is copied directly to or from the archive
+  // rather than via Cereal's dispatch.  The format is the same either way.
   template <typename Archive>
   Archive& serialize(Archive& archive) {
-    return archive(data);
+    return Serialise(archive, FormatFor<Archive>());
   }
 
   T data;
+
+ private:
+  struct CerealFormat {};
+  struct RawOutputFormat {};
+  struct RawInputFormat {};
+
+  template <typename Archive>
+  using FormatFor = typename std::conditional<
+      !std::is_arithmetic<T>::value, CerealFormat,
+      typename std::conditional<
+          IsBinaryOutputArchive<Archive>::value, RawOutputFormat,
+          typename std::conditional<IsBinaryInputArchive<Archive>::value, RawInputFormat,
+                                    CerealFormat>::type>::type>::type;
+
+  template <typename Archive>
+  Archive& Serialise(Archive& archive, CerealFormat) {
+    return archive(data);
+  }
+
+  template <typename Archive>
+  Archive& Serialise(Archive& archive, RawOutputFormat) {
+    archive.saveBinary(&data, sizeof(data));
+    return archive;
+  }
+
+  template <typename Archive>
+  Archive& Serialise(Archive& archive, RawInputFormat) {
+    archive.loadBinary(&data, sizeof(data));
+    return archive;
+  }
 };
 
 template <typename T, typename Tag>
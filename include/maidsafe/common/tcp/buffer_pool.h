@@ -0,0 +1,120 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TCP_BUFFER_POOL_H_
+#define MAIDSAFE_COMMON_TCP_BUFFER_POOL_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+class MemoryArena;
+
+namespace tcp {
+
+namespace detail {
+
+// Frees a buffer's storage to the arena it came from, or to the heap if none.
+struct BufferDeleter {
+  BufferDeleter() : arena(), capacity(0) {}
+  BufferDeleter(std::shared_ptr<MemoryArena> arena_in, size_t capacity_in)
+      : arena(std::move(arena_in)), capacity(capacity_in) {}
+  void operator()(byte* storage) const;
+  std::shared_ptr<MemoryArena> arena;
+  size_t capacity;
+};
+
+using BufferStorage = std::unique_ptr<byte[], BufferDeleter>;
+
+}  // namespace detail
+
+// A fixed-size byte buffer obtained from BufferPool, to which its storage is returned on
+// destruction.  The contents of a newly-obtained buffer are unspecified.
+class PooledBuffer {
+ public:
+  PooledBuffer() : storage_(), capacity_(0), size_(0), node_(0) {}
+  ~PooledBuffer();
+  PooledBuffer(PooledBuffer&& other);
+  PooledBuffer& operator=(PooledBuffer&& other);
+  PooledBuffer(const PooledBuffer&) = delete;
+  PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+  byte* data() { return storage_.get(); }
+  const byte* data() const { return storage_.get(); }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  byte* begin() { return data(); }
+  byte* end() { return data() + size_; }
+  const byte* begin() const { return data(); }
+  const byte* end() const { return data() + size_; }
+  // Reduces the size to 'size'.  Has no effect if 'size' exceeds the current size.
+  void Truncate(size_t size) { size_ = size < size_ ? size : size_; }
+
+ private:
+  friend class BufferPool;
+  PooledBuffer(detail::BufferStorage storage, size_t capacity, size_t size, unsigned node)
+      : storage_(std::move(storage)), capacity_(capacity), size_(size), node_(node) {}
+
+  detail::BufferStorage storage_;
+  size_t capacity_, size_;
+  // The NUMA node of the thread cache from which the storage came.
+  unsigned node_;
+};
+
+// Allocates buffers in power-of-two size classes, caching released buffers per thread so that
+// steady-state traffic needs no calls to the allocator.  A buffer is cached by whichever thread
+// destroys it, unless that thread is on a different NUMA node from the one which obtained it (see
+// numa.h), in which case it's freed so that each node's caches only hold memory local to it.
+// Buffers larger than 'MaxPooledSize()' are allocated and freed as normal.  All functions are
+// thread-safe.
+//
+// If an arena has been set, storage for pooled sizes which isn't in the calling thread's cache is
+// taken from it while it has space, and from the heap otherwise.  Cached storage is kept in the
+// cache as usual, and is only returned to its arena when dropped from the cache.
+class BufferPool {
+ public:
+  static PooledBuffer Get(size_t size);
+  // Sets the arena for subsequent allocations, or stops using one if 'arena' is null.  Buffers
+  // keep their arena alive.
+  static void SetArena(std::shared_ptr<MemoryArena> arena);
+  static std::shared_ptr<MemoryArena> Arena();
+  // Returns a pooled copy of 'message'.
+  static PooledBuffer Copy(const Message& message);
+
+  static size_t MinPooledSize() { return 64; }           // bytes
+  static size_t MaxPooledSize() { return 1024 * 1024; }  // bytes
+  // Limit on the memory held in each size class of each thread's cache (at least one buffer is
+  // always held).
+  static size_t MaxCachedBytesPerClass() { return 256 * 1024; }
+
+  // Number of buffers held in the calling thread's cache.
+  static size_t CachedCount();
+
+ private:
+  friend class PooledBuffer;
+  static void Release(detail::BufferStorage storage, size_t capacity, unsigned node);
+};
+
+}  // namespace tcp
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TCP_BUFFER_POOL_H_
@@ -20,23 +20,46 @@
 #define MAIDSAFE_COMMON_TCP_CONNECTION_H_
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "asio/buffer.hpp"
 #include "asio/io_service.hpp"
+#include "asio/steady_timer.hpp"
 #include "asio/strand.hpp"
 #include "asio/ip/tcp.hpp"
+#include "asio/local/stream_protocol.hpp"
 
+#include "maidsafe/common/completion_handler.h"
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/error.h"
+#include "maidsafe/common/memory_budget.h"
+#include "maidsafe/common/shared_buffer.h"
+#include "maidsafe/common/timer_wheel.h"
+#include "maidsafe/common/trace.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/tcp/buffer_pool.h"
+#include "maidsafe/common/tcp/rate_limiter.h"
+#include "maidsafe/common/tcp/stats.h"
 
 namespace maidsafe {
 
+namespace detail {
+
+class StreamCompressor;
+class StreamDecompressor;
+
+}  // namespace detail
+
 namespace tcp {
 
 class Connection : public std::enable_shared_from_this<Connection> {
@@ -46,54 +69,336 @@ class Connection : public std::enable_shared_from_this<Connection> {
   Connection(const Connection&) = delete;
   Connection(Connection&&) = delete;
   Connection& operator=(Connection) = delete;
+  ~Connection();
 
   // Used when accepting an incoming connection.
   static ConnectionPtr MakeShared(asio::io_service::strand& strand);
   // Used to attempt to connect to 'remote_port' on loopback address.
   static ConnectionPtr MakeShared(asio::io_service::strand& strand, Port remote_port);
 
+  // How the bytes of a connection are carried.  Both transports use the same framing, and behave
+  // identically from Start onwards.
+  enum class Transport { kTcp, kLocal };
+  // As above, but if 'preferred' is kLocal, first tries the Unix domain socket which a Listener on
+  // 'remote_port' also accepts on, falling back to TCP if there is none (e.g. the listener is in
+  // an older process, or the platform has no Unix domain sockets).
+  static ConnectionPtr MakeShared(asio::io_service::strand& strand, Port remote_port,
+                                  Transport preferred);
+  // The transport of an open connection.
+  Transport transport() const;
+  // The address of the Unix domain socket on which a Listener on 'port' accepts connections from
+  // this host.  On Linux this is in the abstract namespace, so no file is created.
+  static std::string LocalEndpointPath(Port port);
+
+  // Invoked once with either a connected (but not yet started) connection, or an error.
+  using ConnectHandler = std::function<void(std::error_code, ConnectionPtr)>;
+  // Asynchronously connects to the first of 'endpoints' to accept.  Attempts are staggered by
+  // 'AttemptDelay()' and alternate between IPv6 and IPv4 addresses ("happy eyeballs"), so a slow or
+  // unreachable address doesn't hold up the others.  Fails with 'timed_out' if no attempt has
+  // succeeded within 'timeout', or 'failed_to_connect' once every attempt has failed.  The handler
+  // is invoked via 'strand'.
+  static void AsyncConnect(asio::io_service::strand& strand,
+                           std::vector<asio::ip::tcp::endpoint> endpoints,
+                           std::chrono::steady_clock::duration timeout, ConnectHandler handler);
+  static std::chrono::milliseconds AttemptDelay() { return std::chrono::milliseconds(250); }
+
+  // Runs a message-delivery task, e.g. by posting it to a thread pool.
+  using Executor = std::function<void(std::function<void()>)>;
+
+  // By default, each received message is delivered via a separate task posted to the connection's
+  // strand.  If 'executor' is provided, delivery tasks are passed to it instead, and the next read
+  // starts without waiting for them to run; an executor which simply invokes the task delivers
+  // messages directly (on the strand) with no extra posting.
   void Start(MessageReceivedFunctor on_message_received,
-             ConnectionClosedFunctor on_connection_closed);
+             ConnectionClosedFunctor on_connection_closed, Executor executor = nullptr);
 
   void Close();
 
-  void Send(Message data);
+  // Queues 'data' for sending.  Returns false without queuing it if the send queue is at or above
+  // a high-water mark (see SetSendQueueLimits).  If called within a trace context, the time until
+  // the message has been written is recorded as a "tcp::Connection::Send" span (see trace.h).
+  bool Send(Message data);
+  // As above, but 'data' is returned to its pool once sent.
+  bool Send(PooledBuffer data);
+  // As above, but 'data' is shared rather than copied, and released once sent.
+  bool Send(SharedBuffer data);
+
+  // Payloads too large to send as a single message can be streamed as a sequence of fragments: one
+  // 'kBegin', any number of 'kContinue' and one 'kEnd'.  Fragments of a given payload must not be
+  // interleaved with other sends on the same connection.  Only fragments may be empty.
+  enum class Fragment : unsigned char { kBegin = 1, kContinue = 2, kEnd = 3 };
+  using FragmentReceivedFunctor = std::function<void(Message, Fragment)>;
+  bool SendFragment(Message data, Fragment fragment);
+
+  // Versions of Send and of receiving which complete via an asio completion token, e.g. a callback,
+  // 'asio::use_future', a 'yield_context' or (in C++20 builds) 'asio::use_awaitable':
+  //   Message request(co_await connection->AsyncReceive(asio::use_awaitable));
+  //   co_await connection->AsyncSend(std::move(reply), asio::use_awaitable);
+  // The handler is invoked via its associated executor, or via the connection's strand if it has
+  // none.
+
+  // Completes once 'data' has been written, with asio::error::no_buffer_space if the send queue is
+  // full, or with the error which failed the write.  Throws as for Send if 'data' is invalid.
+  template <typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code))
+  AsyncSend(Message data, CompletionToken&& token);
+  // Completes with the next received message, or with asio::error::eof once the connection has
+  // closed and every message received before then has been taken.  The first call starts the
+  // connection, which must not also be started via Start; messages arriving while no receive is
+  // outstanding are queued.  A receive made while another is outstanding completes with
+  // asio::error::already_started.
+  template <typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, Message))
+  AsyncReceive(CompletionToken&& token);
+
+  // Limits on the messages queued for sending.  A value of 0 means unlimited.  Once a send has been
+  // refused, the 'on_drained' functor passed to SetSendQueueLimits is invoked (via the strand) when
+  // the queue falls to or below both low-water marks.  The limits are approximate, since a send
+  // isn't refused unless the queue is already full.
+  struct SendQueueLimits {
+    SendQueueLimits()
+        : high_water_bytes(0), high_water_messages(0), low_water_bytes(0), low_water_messages(0) {}
+    size_t high_water_bytes, high_water_messages, low_water_bytes, low_water_messages;
+  };
+  using SendQueueDrainedFunctor = std::function<void()>;
+  // Throws if a low-water mark exceeds the corresponding non-zero high-water mark.  Must be called
+  // before sending.
+  void SetSendQueueLimits(SendQueueLimits limits, SendQueueDrainedFunctor on_drained);
+  size_t queued_bytes() const;
+  size_t queued_messages() const;
+
+  // Charges the bytes queued for sending to 'account', and refuses sends (as for a full queue)
+  // while its budget is under kCritical pressure.  Unlike a full queue, the 'on_drained' functor
+  // isn't invoked when the pressure eases.  Must be called before sending.
+  void SetMemoryBudget(std::shared_ptr<MemoryBudget::Account> account);
+
+  // Sets the functor to which received fragments are delivered (in the same way as whole
+  // messages).  If none is set, receiving a fragment closes the connection.  Must be called before
+  // Start.
+  void SetFragmentHandler(FragmentReceivedFunctor on_fragment_received);
+
+  // Sets a functor to which whole messages are delivered in buffers from BufferPool, instead of to
+  // the MessageReceivedFunctor passed to Start.  Must be called before Start.
+  using PooledMessageReceivedFunctor = std::function<void(PooledBuffer)>;
+  void SetPooledMessageHandler(PooledMessageReceivedFunctor on_message_received);
+
+  // Sets the largest message or fragment which this connection will send or accept.  Throws if
+  // 'max_message_size' is 0 or exceeds 'MaxFrameSize()'.  Must be called before Start.
+  void SetMaxMessageSize(size_t max_message_size);
+  size_t max_message_size() const { return max_message_size_; }
+
+  // Switches to AES-256-GCM framing: each message or fragment is encrypted and authenticated
+  // straight into a pooled buffer as it joins the send queue, and each one received is decrypted
+  // and verified in place before delivery.  A frame which fails verification closes the
+  // connection.  Each direction has its own key, with a count of the frames sent in that direction
+  // as the nonce, so the peer must be given the same keys swapped, and keys must never be reused
+  // across connections (e.g. derive them from a key exchange).  The size header stays in the clear
+  // but is authenticated, and every frame grows by 'EncryptionOverhead()' bytes on the wire.
+  // Throws if the keys are equal.  Must be called before Start and before sending.
+  using EncryptionKey = std::array<byte, 32>;
+  void SetEncryption(const EncryptionKey& send_key, const EncryptionKey& receive_key);
+  bool encrypted() const { return encrypted_; }
+  static size_t EncryptionOverhead() { return 16; }  // bytes
+
+  // Compresses frames with LZ4 or zstd.  All frames sent in one direction form a single compression
+  // stream, so a message which resembles earlier ones compresses well even if it's small.  Both
+  // ends must enable compression.  At Start each tells the other which codecs it can decompress,
+  // and each then compresses with the first of its own 'codecs' which the other supports, if any.
+  // Frames sent before the peer's choice is known, those smaller than 'min_frame_size' and those
+  // which don't shrink are sent as they are, at a cost of one byte each.  After a frame proves
+  // incompressible, the next few aren't tried.  A frame which fails to decompress closes the
+  // connection.  The sizes before and after compression are counted in Stats.  Throws if 'codecs'
+  // contains kGzip, which can't compress a stream, or if a level is out of range (1 to 19 for zstd,
+  // 0 to 12 for LZ4).  Must be called before Start and before sending.
+  struct CompressionOptions {
+    CompressionOptions()
+        : codecs{crypto::CompressionCodec::kZstd, crypto::CompressionCodec::kLz4},
+          zstd_level(1),
+          lz4_level(0),
+          min_frame_size(256) {}
+    // In order of preference.  Codecs which the library was built without are ignored.
+    std::vector<crypto::CompressionCodec> codecs;
+    int zstd_level, lz4_level;
+    size_t min_frame_size;
+  };
+  void SetCompression(CompressionOptions options);
+  bool compression_enabled() const { return compressing_; }
+
+  // Closes the connection once nothing has been sent or received for 'timeout', timing it on
+  // 'wheel' (which may be shared by many connections).  Activity only records the time; the timer
+  // is moved on when it fires.  Throws if 'wheel' is null or 'timeout' isn't positive.  Must be
+  // called before Start.
+  void SetIdleTimeout(std::shared_ptr<TimerWheel> wheel,
+                      std::chrono::steady_clock::duration timeout);
+
+  // Adds a (possibly shared) limit on the rate at which this connection reads.  Once any of its
+  // limiters is in debt, no further read is issued until it has recovered, rather than received
+  // frames being buffered.  Throws if 'limiter' is null.  Must be called before Start.
+  void AddRateLimiter(std::shared_ptr<RateLimiter> limiter);
+
+  // Sets the (possibly shared) object in which this connection's traffic is counted.  Must be
+  // called before Start.
+  void SetStats(std::shared_ptr<Stats> stats) { stats_ = std::move(stats); }
 
   asio::ip::tcp::socket& Socket() { return socket_; }
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  // Used in place of 'Socket()' for connections with Transport::kLocal.
+  asio::local::stream_protocol::socket& LocalSocket() { return local_socket_; }
+#endif
 
+  // Default limit on the size of a message or fragment.
   static size_t MaxMessageSize() { return 1024 * 1024; }  // bytes
+  // The top two bits of each 4-byte size header hold the fragment flag.
+  static size_t MaxFrameSize() { return (1U << 30) - 1; }  // bytes
+  // Limits on a single coalesced write of queued messages.  A message larger than
+  // 'MaxSendBytes()' is always sent on its own.
+  static size_t MaxSendBytes() { return 256 * 1024; }
+  static size_t MaxSendMessages() { return 64; }
 
  private:
   explicit Connection(asio::io_service::strand& strand);
-  Connection(asio::io_service::strand& strand, Port remote_port);
+  Connection(asio::io_service::strand& strand, Port remote_port, Transport preferred);
 
   struct ReceivingMessage {
     std::array<unsigned char, 4> size_buffer;
+    unsigned char frame_type;
+    // The body is read into 'pooled_buffer' if set, otherwise into 'data_buffer'.
+    bool pooled;
     Message data_buffer;
+    PooledBuffer pooled_buffer;
   };
 
+  // The payload is held in whichever of 'data', 'pooled_data' and 'shared_data' is non-empty, and
+  // is followed on the wire by 'trailer_size' bytes (0 or 1) of 'trailer'.
   struct SendingMessage {
+    asio::const_buffer Payload() const;
     std::array<unsigned char, 4> size_buffer;
     Message data;
+    PooledBuffer pooled_data;
+    SharedBuffer shared_data;
+    unsigned char trailer = 0;
+    size_t trailer_size = 0;
+    // The sender's trace context (if any), and when the message was queued.
+    trace::SpanContext trace_context;
+    std::chrono::steady_clock::time_point queued;
+    // Set for messages sent via AsyncSend.
+    std::function<void(std::error_code)> on_sent;
   };
+  using ReceiveHandler = std::function<void(std::error_code, Message)>;
 
-  void DoClose();
+  bool ConnectLocal(Port remote_port);
+  void DoClose(Stats::CloseReason reason);
+
+  // Read from or write to whichever socket is in use.
+  template <typename Buffers, typename Handler>
+  void AsyncRead(const Buffers& buffers, Handler handler);
+  template <typename Buffers, typename Handler>
+  void AsyncWrite(const Buffers& buffers, Handler handler);
 
   void ReadSize();
   void ReadData();
+  void DeliverMessage(Message data, unsigned char frame_type);
+  void DeliverPooledMessage(PooledBuffer data);
 
   void DoSend();
-  SendingMessage EncodeData(Message data) const;
+  bool DoQueue(SendingMessage message);
+  void QueueWithHandler(Message data, std::function<void(std::error_code)> on_sent);
+  void Receive(ReceiveHandler handler);
+  void DoReceive(ReceiveHandler handler);
+  void HandleReceived(Message data);
+  void HandleReceiveClosed();
+  void Dequeued(size_t bytes, size_t messages);
+  SendingMessage EncodeHeader(size_t data_size, unsigned char frame_type) const;
+  // The bytes which 'message', which mustn't have been encrypted yet, will occupy on the wire.
+  size_t WireSize(const SendingMessage& message) const;
+  void EncryptMessage(SendingMessage& message);
+  // Returns false if the received message fails verification.
+  bool DecryptReceivedMessage();
+  // Bytes added to each frame by encryption and compression.
+  size_t FrameOverhead() const;
+  void SendCompressionHello();
+  void CompressMessage(SendingMessage& message);
+  // Returns false if the received frame is invalid.  Sets 'is_hello' if it was the peer's list of
+  // codecs, which isn't delivered.
+  bool DecompressReceivedMessage(bool& is_hello);
+  void ArmIdleTimer(std::chrono::steady_clock::duration delay);
+  void CheckIdle();
+  // Reads the next frame once the rate limiters have been charged for the 'frame_bytes' just read
+  // and any resulting debt has been repaid.
+  void ReadNext(size_t frame_bytes);
 
   asio::io_service::strand& strand_;
   std::once_flag start_flag_, socket_close_flag_;
   asio::ip::tcp::socket socket_;
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  asio::local::stream_protocol::socket local_socket_;
+#endif
   MessageReceivedFunctor on_message_received_;
   ConnectionClosedFunctor on_connection_closed_;
+  FragmentReceivedFunctor on_fragment_received_;
+  PooledMessageReceivedFunctor on_pooled_message_received_;
+  Executor executor_;
+  size_t max_message_size_;
+  std::shared_ptr<Stats> stats_;
   ReceivingMessage receiving_message_;
   std::deque<SendingMessage> send_queue_;
+  // Buffers for the write in progress, which covers the first 'in_flight_count_' entries of
+  // 'send_queue_'.
+  std::vector<asio::const_buffer> send_buffers_;
+  size_t in_flight_count_;
+  // Guards the send queue accounting, which is done outside the strand so Send can refuse messages.
+  mutable std::mutex send_limits_mutex_;
+  SendQueueLimits send_limits_;
+  SendQueueDrainedFunctor on_send_queue_drained_;
+  size_t queued_bytes_, queued_messages_;
+  bool send_refused_;
+  // Set by SetMemoryBudget, and charged with 'queued_bytes_'.
+  std::shared_ptr<MemoryBudget::Account> memory_account_;
+  // Set once a write has failed, after which queued messages are dropped.
+  std::error_code send_error_;
+  // Used only by AsyncReceive.  Received messages not yet taken, and the outstanding receive.
+  std::deque<Message> received_;
+  ReceiveHandler pending_receive_;
+  bool receive_closed_;
+  // Set by SetEncryption.  The counters are only used on the strand.
+  bool encrypted_;
+  EncryptionKey send_key_, receive_key_;
+  uint64_t send_counter_, receive_counter_;
+  // Set by SetCompression.  The rest are only used on the strand.  'compressor_' is set once the
+  // peer's codecs are known, and 'compression_backoff_' counts the frames still to be sent as they
+  // are after one proved incompressible.
+  bool compressing_;
+  CompressionOptions compression_options_;
+  std::unique_ptr<detail::StreamCompressor> compressor_;
+  std::unique_ptr<detail::StreamDecompressor> decompressor_;
+  size_t compression_backoff_;
+  // Set by SetIdleTimeout.  'last_activity_' is only used on the strand.
+  std::shared_ptr<TimerWheel> idle_wheel_;
+  std::chrono::steady_clock::duration idle_timeout_;
+  std::atomic<TimerWheel::TimerId> idle_timer_;
+  std::chrono::steady_clock::time_point last_activity_;
+  // Set by AddRateLimiter.  'read_timer_' is only used on the strand, to resume reading.
+  std::vector<std::shared_ptr<RateLimiter>> rate_limiters_;
+  asio::steady_timer read_timer_;
 };
 
+template <typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code))
+Connection::AsyncSend(Message data, CompletionToken&& token) {
+  asio::async_completion<CompletionToken, void(std::error_code)> init(token);
+  QueueWithHandler(std::move(data),
+                   detail::MakePostingHandler(std::move(init.completion_handler), strand_));
+  return init.result.get();
+}
+
+template <typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, Message))
+Connection::AsyncReceive(CompletionToken&& token) {
+  asio::async_completion<CompletionToken, void(std::error_code, Message)> init(token);
+  Receive(detail::MakePostingHandler(std::move(init.completion_handler), strand_));
+  return init.result.get();
+}
+
 }  // namespace tcp
 
 }  // namespace maidsafe
@@ -19,15 +19,22 @@
 #ifndef MAIDSAFE_COMMON_TCP_LISTENER_H_
 #define MAIDSAFE_COMMON_TCP_LISTENER_H_
 
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include "asio/ip/tcp.hpp"
 #include "asio/io_service.hpp"
+#include "asio/local/stream_protocol.hpp"
 #include "asio/strand.hpp"
 
+#include "maidsafe/common/completion_handler.h"
 #include "maidsafe/common/types.h"
+#include "maidsafe/common/tcp/rate_limiter.h"
+#include "maidsafe/common/tcp/stats.h"
 
 namespace maidsafe {
 
@@ -39,25 +46,98 @@ class Listener : public std::enable_shared_from_this<Listener> {
   Listener(Listener&&) = delete;
   Listener& operator=(Listener) = delete;
 
+  // If 'on_new_connection' is empty, accepted connections are instead queued to be taken via
+  // AsyncAccept.  If 'stats' is set, accepts are counted in it, and it's passed to each accepted
+  // connection.  Where the platform supports it, connections are also accepted on a Unix domain
+  // socket named after the listening port (see Connection::LocalEndpointPath), via the first
+  // strand.
   static ListenerPtr MakeShared(asio::io_service::strand& strand,
-                                NewConnectionFunctor on_new_connection, Port desired_port);
+                                NewConnectionFunctor on_new_connection, Port desired_port,
+                                std::shared_ptr<Stats> stats = nullptr);
+  // Opens one acceptor per strand, all on the same port using SO_REUSEPORT, so that the kernel
+  // spreads incoming connections across them.  Each accepted connection uses the strand of the
+  // acceptor which accepted it, and 'on_new_connection' is invoked via that strand.  Where
+  // SO_REUSEPORT isn't supported only the first strand is used.  Throws if 'strands' is empty.
+  static ListenerPtr MakeShared(const std::vector<asio::io_service::strand*>& strands,
+                                NewConnectionFunctor on_new_connection, Port desired_port,
+                                std::shared_ptr<Stats> stats = nullptr);
   Port ListeningPort() const;
+  size_t AcceptorCount() const { return acceptors_.size(); }
+  // Whether connections with Connection::Transport::kLocal are being accepted.
+  bool AcceptsLocalConnections() const;
+  // Adds 'limiter' (see Connection::AddRateLimiter) to every connection accepted from now on, so
+  // that they share its budget.  A null 'limiter' stops it being added.
+  void SetRateLimiter(std::shared_ptr<RateLimiter> limiter);
   void StopListening();
 
+  // Completes via an asio completion token (see Connection::AsyncReceive) with the next accepted
+  // connection, which hasn't been started.  Only usable if the listener was made without a
+  // NewConnectionFunctor; otherwise completes with asio::error::operation_not_supported.  Completes
+  // with asio::error::operation_aborted once StopListening has been called and every connection
+  // accepted before then has been taken, and with asio::error::already_started if another accept
+  // is outstanding.  The handler is invoked via its associated executor, or via the first strand
+  // if it has none.
+  template <typename CompletionToken>
+  ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, ConnectionPtr))
+  AsyncAccept(CompletionToken&& token);
+
  private:
-  Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection);
+  using AcceptHandler = std::function<void(std::error_code, ConnectionPtr)>;
+
+  struct Acceptor {
+    explicit Acceptor(asio::io_service::strand& strand_in)
+        : strand(strand_in), acceptor(strand_in.context()) {}
+    asio::io_service::strand& strand;
+    asio::ip::tcp::acceptor acceptor;
+  };
+
+  Listener(const std::vector<asio::io_service::strand*>& strands,
+           NewConnectionFunctor on_new_connection, std::shared_ptr<Stats> stats);
 
   void StartListening(Port desired_port);
-  void DoStartListening(Port port);
-  void HandleAccept(ConnectionPtr accepted_connection, const std::error_code& ec);
-  void DoStopListening();
+  void DoStartListening(Acceptor& acceptor, Port port);
+  void Open(Acceptor& acceptor, const asio::ip::tcp::endpoint& endpoint);
+  void StartAccepting(Acceptor& acceptor);
+  void HandleAccept(Acceptor& acceptor, ConnectionPtr accepted_connection,
+                    const std::error_code& ec);
+  void DoStopListening(Acceptor& acceptor);
+  // Passes the stats and rate limiter on to a newly-accepted connection.
+  void Configure(Connection& accepted_connection);
+  void Accept(AcceptHandler handler);
+  void DeliverConnection(ConnectionPtr connection);
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  void StartLocalListening(Port port);
+  void StartLocalAccepting();
+  void HandleLocalAccept(ConnectionPtr accepted_connection, const std::error_code& ec);
+  void DoStopLocalListening();
+#endif
 
-  asio::io_service::strand& strand_;
   std::once_flag stop_listening_flag_;
   NewConnectionFunctor on_new_connection_;
-  asio::ip::tcp::acceptor acceptor_;
+  std::vector<std::unique_ptr<Acceptor>> acceptors_;
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  std::unique_ptr<asio::local::stream_protocol::acceptor> local_acceptor_;
+  std::string local_path_;
+#endif
+  std::shared_ptr<Stats> stats_;
+  // Accessed atomically, since accepts may complete on several strands.
+  std::shared_ptr<RateLimiter> rate_limiter_;
+  // Used only by AsyncAccept.  Accepted connections not yet taken, and the outstanding accept.
+  std::mutex accept_mutex_;
+  std::deque<ConnectionPtr> accepted_;
+  AcceptHandler pending_accept_;
+  bool accept_stopped_;
 };
 
+template <typename CompletionToken>
+ASIO_INITFN_RESULT_TYPE(CompletionToken, void(std::error_code, ConnectionPtr))
+Listener::AsyncAccept(CompletionToken&& token) {
+  asio::async_completion<CompletionToken, void(std::error_code, ConnectionPtr)> init(token);
+  Accept(detail::MakePostingHandler(std::move(init.completion_handler),
+                                    acceptors_.front()->strand));
+  return init.result.get();
+}
+
 }  // namespace tcp
 
 }  // namespace maidsafe
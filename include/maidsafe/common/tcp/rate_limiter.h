@@ -0,0 +1,81 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TCP_RATE_LIMITER_H_
+#define MAIDSAFE_COMMON_TCP_RATE_LIMITER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace maidsafe {
+
+namespace tcp {
+
+// Token buckets limiting the rate at which connections read, in bytes and in messages per second.
+// A single instance can be shared by any number of connections (e.g. all those accepted by one
+// Listener) to limit their combined rate.  Buckets are allowed to go into debt, since a frame's
+// size is only known once it has been read; a connection then stops reading until the debt has
+// been repaid, leaving the peer to be held back by TCP flow control.  All functions are
+// thread-safe.
+class RateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Limits {
+    Limits() : bytes_per_second(0), messages_per_second(0), burst_bytes(0), burst_messages(0) {}
+    // A rate of 0 is unlimited.  A burst of 0 defaults to one second's worth of the rate.
+    uint64_t bytes_per_second, messages_per_second;
+    uint64_t burst_bytes, burst_messages;
+  };
+
+  // Buckets start full.  Throws if both rates are 0.
+  explicit RateLimiter(Limits limits);
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter(RateLimiter&&) = delete;
+  RateLimiter& operator=(RateLimiter) = delete;
+
+  // Takes 'bytes' and 'messages' from the buckets, and returns how long to wait until neither is
+  // in debt (zero if neither is).
+  Clock::duration Consume(uint64_t bytes, uint64_t messages) {
+    return Consume(bytes, messages, Clock::now());
+  }
+  Clock::duration Consume(uint64_t bytes, uint64_t messages, Clock::time_point now);
+
+  const Limits& limits() const { return limits_; }
+
+ private:
+  struct Bucket {
+    Bucket(uint64_t rate_in, uint64_t burst_in);
+    // Refills for 'elapsed' seconds, takes 'amount', and returns the seconds until not in debt.
+    double Take(uint64_t amount, double elapsed);
+    const double rate, burst;
+    double tokens;
+  };
+
+  const Limits limits_;
+  std::mutex mutex_;
+  Clock::time_point last_refill_;
+  Bucket bytes_, messages_;
+};
+
+}  // namespace tcp
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TCP_RATE_LIMITER_H_
@@ -0,0 +1,105 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TCP_STATS_H_
+#define MAIDSAFE_COMMON_TCP_STATS_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+
+#include "maidsafe/common/latency_histogram.h"
+
+namespace maidsafe {
+
+namespace tcp {
+
+// Counters for connections and listeners.  A single instance can be shared by any number of
+// connections and listeners to aggregate their figures.  All functions are thread-safe.
+class Stats {
+ public:
+  enum class CloseReason : size_t {
+    kLocal,          // Close() was called.
+    kPeer,           // The peer closed the connection.
+    kReadError,
+    kWriteError,
+    kProtocolError,  // The peer sent an invalid size header.
+    kIdleTimeout,    // Nothing was sent or received for the idle timeout.
+    kCount
+  };
+
+  struct Snapshot {
+    Snapshot()
+        : bytes_in(0),
+          bytes_out(0),
+          messages_in(0),
+          messages_out(0),
+          send_queue_bytes_high_water(0),
+          send_queue_messages_high_water(0),
+          write_latency(),
+          closes(),
+          accepts(0),
+          accept_errors(0),
+          compression_bytes_in(0),
+          compression_bytes_out(0),
+          throttles(0) {}
+    // Totals including the 4-byte size headers.  Fragments count as messages.
+    uint64_t bytes_in, bytes_out, messages_in, messages_out;
+    // Largest depth reached by any one connection's send queue.
+    uint64_t send_queue_bytes_high_water, send_queue_messages_high_water;
+    // Time taken by each (possibly coalesced) write.
+    LatencyHistogram write_latency;
+    // Number of connections closed, indexed by CloseReason.
+    std::array<uint64_t, static_cast<size_t>(CloseReason::kCount)> closes;
+    // Outcomes of Listener accepts.
+    uint64_t accepts, accept_errors;
+    // Payload bytes of frames sent by connections with compression enabled, before and after
+    // compressing (counting frames sent as they are), so 'compression_bytes_out' divided by
+    // 'compression_bytes_in' is the achieved ratio.
+    uint64_t compression_bytes_in, compression_bytes_out;
+    // Number of times a connection stopped reading because a RateLimiter was in debt.
+    uint64_t throttles;
+  };
+
+  Stats() : mutex_(), snapshot_() {}
+  Stats(const Stats&) = delete;
+  Stats(Stats&&) = delete;
+  Stats& operator=(Stats) = delete;
+
+  void RecordReceived(uint64_t bytes);
+  void RecordWrite(uint64_t bytes, uint64_t messages, std::chrono::steady_clock::duration latency);
+  void RecordSendQueueDepth(uint64_t bytes, uint64_t messages);
+  void RecordClose(CloseReason reason);
+  void RecordAccept(const std::error_code& ec);
+  void RecordCompression(uint64_t original_bytes, uint64_t compressed_bytes);
+  void RecordThrottle();
+
+  Snapshot snapshot() const;
+
+ private:
+  mutable std::mutex mutex_;
+  Snapshot snapshot_;
+};
+
+}  // namespace tcp
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TCP_STATS_H_
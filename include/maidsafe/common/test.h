@@ -22,9 +22,12 @@
 #if !defined(MAIDSAFE_WIN32) && !defined(__ANDROID__)
 #include <ulimit.h>
 #endif
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "boost/filesystem/path.hpp"
 #include "boost/optional.hpp"
@@ -49,6 +52,34 @@ TestPath CreateTestPath(std::string test_prefix = "");
 // Executes "functor" asynchronously "thread_count" times.
 void RunInParallel(int thread_count, std::function<void()> functor);
 
+// The outcome of RunInParallelTimed.  'wall_time' runs from the threads' simultaneous start until
+// the last of them finished.
+struct ParallelRunResult {
+  struct ThreadResult {
+    std::chrono::steady_clock::duration duration;
+    std::uint64_t operations;
+    bool pinned;
+  };
+
+  std::uint64_t TotalOperations() const;
+  // Total operations of all threads per second of wall time.
+  double OperationsPerSecond() const;
+  // Logs each thread's results and the aggregate throughput, labelled with 'name'.
+  void Report(const std::string& name) const;
+
+  std::vector<ThreadResult> threads;
+  std::chrono::steady_clock::duration wall_time;
+};
+
+// Executes "functor" on "thread_count" threads which are held at a barrier until all have started,
+// so that they contend from the outset.  Each call is passed its thread's index in the range
+// [0, thread_count) and returns the number of operations it performed.  If "pin_threads" is true,
+// thread i is pinned to CPU (i % hardware_concurrency) where the platform supports it.  Any
+// exception thrown by "functor" is rethrown once all threads have finished.
+ParallelRunResult RunInParallelTimed(int thread_count,
+                                     std::function<std::uint64_t(int)> functor,
+                                     bool pin_threads = false);
+
 // Returns a random port in the range [1025, 65535].
 uint16_t GetRandomPort();
 
@@ -0,0 +1,127 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TIMER_WHEEL_H_
+#define MAIDSAFE_COMMON_TIMER_WHEEL_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "asio/io_service.hpp"
+#include "asio/steady_timer.hpp"
+
+namespace maidsafe {
+
+// A hashed hierarchical timer wheel (Varghese and Lauck) for very large numbers of coarse timeouts,
+// e.g. connection idle timeouts, request deadlines or cache expiry.  Scheduling, rescheduling and
+// cancelling a timer are O(1), and the whole wheel is driven by a single asio timer which ticks
+// only while any timer is pending.  All callbacks due at a tick run together in one handler on
+// 'service', so create one wheel per IoServicePool service to keep each wheel's timers on its
+// thread.
+//
+// Timers fire no earlier than requested, and up to one tick later.  Delays beyond about 2^24 ticks
+// are supported, but are re-sorted through the wheel once each span of that length.  All functions
+// are thread-safe; callbacks run without any lock held, so may schedule or cancel timers.
+class TimerWheel : public std::enable_shared_from_this<TimerWheel> {
+ public:
+  using Callback = std::function<void()>;
+  // Identifies a scheduled timer.  Never 0, and not reused once the timer has fired or been
+  // cancelled (until 2^32 more timers have used the same slot).
+  using TimerId = uint64_t;
+
+  // Throws if 'tick' isn't positive.
+  static std::shared_ptr<TimerWheel> MakeShared(
+      asio::io_service& service,
+      std::chrono::steady_clock::duration tick = std::chrono::milliseconds(10));
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel(TimerWheel&&) = delete;
+  TimerWheel& operator=(TimerWheel) = delete;
+  ~TimerWheel();
+
+  // Schedules 'callback' to run via 'service' once 'delay' has elapsed.  Throws if 'callback' is
+  // empty.
+  TimerId Schedule(std::chrono::steady_clock::duration delay, Callback callback);
+  // Moves a pending timer to fire once 'delay' has elapsed from now.  Returns false if it has
+  // already fired or been cancelled.
+  bool Reschedule(TimerId id, std::chrono::steady_clock::duration delay);
+  // Returns false if the timer has already fired (or is about to, its callback having been taken
+  // for running) or been cancelled.
+  bool Cancel(TimerId id);
+  // Number of pending timers.
+  size_t size() const;
+
+  // Runs, on the calling thread, the callbacks of all timers due by 'now', and returns how many
+  // ran.  The wheel's own timer does this, but it can also be called directly, e.g. to drive a
+  // wheel from a thread's own loop rather than via 'service'.
+  size_t Advance(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+  std::chrono::steady_clock::duration tick() const { return tick_; }
+  static size_t SlotsPerLevel() { return 64; }
+  static size_t LevelCount() { return 4; }
+
+ private:
+  static const uint32_t kNone = 0xFFFFFFFF;
+
+  struct Node {
+    Node() : callback(), expiry(0), previous(kNone), next(kNone), slot(kNone), generation(1) {}
+    Callback callback;
+    // The tick at which the timer is due.
+    uint64_t expiry;
+    // Links within 'slots_[slot]', or to the next free node.
+    uint32_t previous, next, slot;
+    uint32_t generation;
+  };
+
+  TimerWheel(asio::io_service& service, std::chrono::steady_clock::duration tick);
+
+  uint64_t TickAt(std::chrono::steady_clock::time_point time) const;
+  uint64_t ExpiryTick(std::chrono::steady_clock::duration delay) const;
+  // Returns the index of the pending timer 'id', or kNone.
+  uint32_t FindLocked(TimerId id) const;
+  void InsertLocked(uint32_t index);
+  void UnlinkLocked(uint32_t index);
+  void ReleaseLocked(uint32_t index);
+  // Re-sorts the timers of 'slot' into lower levels.
+  void CascadeLocked(uint32_t slot);
+  void StartTimerLocked();
+  void OnTimer();
+
+  const std::chrono::steady_clock::duration tick_;
+  const std::chrono::steady_clock::time_point origin_;
+  mutable std::mutex mutex_;
+  std::vector<Node> nodes_;
+  uint32_t free_list_;
+  // Heads of the lists of each level's slots, level by level.
+  std::array<uint32_t, 64 * 4> slots_;
+  // Every tick before this has been processed.
+  uint64_t current_tick_;
+  size_t size_;
+  asio::steady_timer timer_;
+  // Whether a wait is outstanding, and the tick at which it ends.
+  bool timer_running_;
+  uint64_t armed_tick_;
+};
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TIMER_WHEEL_H_
@@ -0,0 +1,106 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TOOLS_HOT_PATH_BENCHMARK_H_
+#define MAIDSAFE_COMMON_TOOLS_HOT_PATH_BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+namespace maidsafe {
+
+namespace benchmark {
+
+// Times the library's hot paths (LruCache, DataBuffer, tcp::Connection loopback, crypto and RSA,
+// Serialise/Parse and the sqlite wrapper) and reports per-operation times.  Each benchmark is
+// repeated several times and the median repetition is reported, so that results from successive
+// runs on the same machine can be compared, e.g. to gate dependency upgrades on performance.
+class HotPathBenchmark {
+ public:
+  struct Parameters {
+    Parameters();
+
+    // Each repetition of a benchmark runs for at least this long.
+    std::chrono::milliseconds minimum_duration;
+    // Number of timed repetitions of each benchmark, of which the median is reported.
+    int repetitions;
+    // Size of the values cached, buffered, hashed, encrypted, sent and serialised.
+    std::size_t value_size;
+    // Whether to also run (a reduced form of) the sqlite wrapper benchmark.
+    bool include_sqlite;
+  };
+
+  // Times are mean nanoseconds per operation within the median repetition.
+  struct Result {
+    std::string name;
+    std::uint64_t iterations;
+    double real_time, cpu_time;
+  };
+
+  // 'change' is the fractional change of the current real time relative to the baseline's, so
+  // positive values are slowdowns.
+  struct Comparison {
+    std::string name;
+    double baseline_time, current_time, change;
+    bool regression;
+  };
+
+  HotPathBenchmark();
+  explicit HotPathBenchmark(Parameters parameters_in);
+  void Run();
+
+  const std::vector<Result>& GetResults() const { return results; }
+  // Writes the results in Google Benchmark's JSON layout.
+  void WriteJson(std::ostream& output) const;
+  // Compares the results with those in 'baseline', a file previously written by WriteJson (or by
+  // any Google Benchmark tool).  Benchmarks missing from either set are skipped.  A benchmark is a
+  // regression if its real time has grown by more than 'threshold' (e.g. 0.1 for 10%).  Throws if
+  // 'baseline' can't be read or parsed.
+  std::vector<Comparison> CompareWith(const boost::filesystem::path& baseline,
+                                      double threshold) const;
+
+ private:
+  template <typename Functor>
+  void Measure(const std::string& name, std::size_t batch_size, Functor functor);
+
+  void LruCacheAddAndGet();
+  void DataBufferStoreAndGet();
+  void TcpLoopback();
+  void CryptoHashAndSymmEncrypt();
+  void RsaSignAndCheck();
+  void SerialiseAndParse();
+  void Sqlite();
+
+  const Parameters parameters;
+  std::vector<Result> results;
+};
+
+// Reports 'comparisons' as text, flagging regressions, and returns the number of regressions.
+std::size_t ReportComparisons(const std::vector<HotPathBenchmark::Comparison>& comparisons);
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TOOLS_HOT_PATH_BENCHMARK_H_
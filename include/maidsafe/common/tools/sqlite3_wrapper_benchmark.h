@@ -19,12 +19,15 @@
 #ifndef MAIDSAFE_COMMON_TOOLS_SQLITE3_WRAPPER_BENCHMARK_H_
 #define MAIDSAFE_COMMON_TOOLS_SQLITE3_WRAPPER_BENCHMARK_H_
 
+#include <chrono>
+#include <cstddef>
+#include <ostream>
 #include <string>
 #include<utility>
 #include <vector>
 #include <map>
 
-#include "boost/progress.hpp"
+#include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/sqlite3_wrapper.h"
@@ -36,13 +39,47 @@ namespace benchmark {
 
 class Sqlite3WrapperBenchmark {
  public:
+  struct Parameters {
+    Parameters();
+
+    // Rows inserted by each scenario (except LargeBlobs, which inserts one per 100 of these).
+    std::size_t row_count;
+    // Size of each key-value scenario value, and of each LargeBlobs blob.
+    std::size_t value_size, blob_size;
+    // Threads used by the concurrent scenarios.  A writer thread count of 0 keeps each scenario's
+    // own default (20 for endpoint strings, 4 for key-value pairs).
+    int reader_threads, writer_threads;
+    // One of "default", "throughput", "balanced" or "durable"; see sqlite::Options.
+    std::string profile;
+  };
+
+  // Latencies are in microseconds, and are per sample: one transaction, enqueued mutation or read,
+  // as appropriate to the scenario.  A sample may cover several of the scenario's 'operations'.
+  struct Result {
+    std::string name;
+    std::size_t operations, samples;
+    double seconds, p50, p90, p99, max;
+  };
+
   Sqlite3WrapperBenchmark();
+  explicit Sqlite3WrapperBenchmark(Parameters parameters_in);
   void Run();
 
+  const std::vector<Result>& GetResults() const { return results; }
+  // Writes the parameters and results in Google Benchmark's JSON layout.
+  void WriteJson(std::ostream& output) const;
+
  private:
+  typedef std::vector<std::chrono::steady_clock::duration> Latencies;
+
   void PrepareTable(sqlite::Database& database, std::string query);
+  int WriterThreads(int scenario_default) const;
+  // Records a result and reports it as text.
+  void Report(const std::string& name, std::size_t operations,
+              std::chrono::steady_clock::duration elapsed, Latencies latencies);
 
   void EndpointStringsSingleTransaction();
+  void EndpointStringsBulkInsert();
   void EndpointStringsIndividualTransaction();
   void EndpointStringsConcurrentInsertions();
   void EndpointStringsConcurrentDeletes();
@@ -50,6 +87,9 @@ class Sqlite3WrapperBenchmark {
   void AddRemoveEndpointStrings(sqlite::Database& database,
                                 const std::vector<std::string>& endpoint_strings,
                                 std::string query);
+  void BulkInsertEndpointStrings(sqlite::Database& database,
+                                 const std::vector<std::string>& endpoint_strings,
+                                 std::string insert_into);
   void ReadEndpointStrings(std::vector<std::string>& result, std::string query);
   void CheckEndpointStringsTestResult(const std::vector<std::string>& expected_result,
                                       std::string query,
@@ -58,12 +98,17 @@ class Sqlite3WrapperBenchmark {
                                       bool check_size = true);
 
   void KeyValueIndividualTransaction();
+  void KeyValueBulkInsert();
   void KeyValueConcurrentInsertions();
+  void KeyValueGroupCommitInsertions();
   void KeyValueConcurrentUpdates();
+  void KeyValueMixedReadWrite();
+  void LargeBlobs();
 
   void InsertKeyValuePair(sqlite::Database& database,
                           std::pair<std::string, std::string> key_value_pair,
                           std::string query);
+  void BulkInsertKeyValuePairs(sqlite::Database& database, std::string insert_into);
   void ReadKeyValuePairs(std::map<std::string, std::string>& result,
                          std::string query);
   void UpdateKeyValuePair(sqlite::Database& database,
@@ -72,10 +117,12 @@ class Sqlite3WrapperBenchmark {
   void CheckKeyValueTestResult(const std::map<std::string, std::string>& expected_result,
                                std::string query);
 
+  const Parameters parameters;
+  const sqlite::Options options;
   boost::filesystem::path database_path;
-  boost::progress_timer ticking_clock;
-  std::vector<std::string> ten_thousand_strings;
+  std::vector<std::string> all_endpoint_strings;
   std::map<std::string, std::string> key_value_pairs;
+  std::vector<Result> results;
 };
 
 }  // namespace benchmark
@@ -0,0 +1,143 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TRACE_H_
+#define MAIDSAFE_COMMON_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace maidsafe {
+
+// Lightweight request tracing.  Each thread has a current span context; a Span started on a thread
+// becomes a child of that context and is current until it ends.  Work handed to another thread via
+// Active::Send, IoService::Post or BindContext carries the sender's context with it, and messages
+// queued by tcp::Connection::Send are recorded as spans (from queueing until written) within it, so
+// that a request's latency can be broken down across the threads which handled it.
+//
+// Ended spans are recorded into a fixed-size, process-wide ring buffer which can be written out in
+// the Chrome trace event format (load it via chrome://tracing or https://ui.perfetto.dev).
+// Tracing is disabled by default, in which case starting a span costs a single relaxed load.
+namespace trace {
+
+struct SpanContext {
+  SpanContext() : trace_id(0), span_id(0) {}
+  SpanContext(uint64_t trace_id_in, uint64_t span_id_in)
+      : trace_id(trace_id_in), span_id(span_id_in) {}
+  bool IsValid() const { return trace_id != 0; }
+
+  uint64_t trace_id, span_id;
+};
+
+// An ended span.  Times are steady_clock nanoseconds since an arbitrary process-wide epoch.
+struct SpanRecord {
+  const char* name;
+  uint64_t trace_id, span_id, parent_span_id;
+  int64_t start, duration;
+  // Small integer identifying the recording thread, assigned in order of first use.
+  uint32_t thread;
+};
+
+// Enabling starts recording spans (and allocates the ring buffer on first use); disabling stops
+// new spans from starting, and spans already started from being recorded.
+void Enable(bool enable = true);
+bool IsEnabled();
+// Sets the number of spans held by the ring buffer (65536 by default), discarding any held.  Not
+// safe to call while spans are being recorded.
+void SetCapacity(size_t capacity);
+
+SpanContext CurrentContext();
+
+// Makes 'context' current for the lifetime of this object.
+class ScopedContext {
+ public:
+  explicit ScopedContext(SpanContext context);
+  ~ScopedContext();
+  ScopedContext(const ScopedContext&) = delete;
+  ScopedContext& operator=(const ScopedContext&) = delete;
+
+ private:
+  const SpanContext previous_;
+};
+
+// Times the enclosing scope as a child of the current span, or as the root of a new trace if there
+// is none.  'name' must have static storage duration (e.g. a string literal).  Does nothing if
+// tracing is disabled.
+class Span {
+ public:
+  explicit Span(const char* name);
+  ~Span();
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  SpanContext Context() const { return context_; }
+
+ private:
+  const char* const name_;
+  SpanContext context_, previous_;
+  uint64_t parent_span_id_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Records a span named 'name' (which must have static storage duration) as a child of 'parent',
+// for work which didn't run as a single scope on one thread.  Does nothing if tracing is disabled
+// or 'parent' is invalid.
+void RecordSpan(const char* name, SpanContext parent, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+// The spans held by the ring buffer, oldest first.  Spans being recorded concurrently may be
+// omitted.
+std::vector<SpanRecord> RecordedSpans();
+
+// Writes 'spans' as a Chrome trace event JSON object.  Each span is a complete ("X") event, with
+// its trace, span and parent span IDs as arguments.
+void WriteChromeTrace(const std::vector<SpanRecord>& spans, std::ostream& output);
+
+// Wraps a handler so that it runs with the context current when it was wrapped.
+template <typename Handler>
+class ContextHandler {
+ public:
+  ContextHandler(SpanContext context, Handler handler)
+      : context_(context), handler_(std::move(handler)) {}
+
+  template <typename... Args>
+  auto operator()(Args&&... args)
+      -> decltype(std::declval<Handler&>()(std::forward<Args>(args)...)) {
+    ScopedContext scoped_context(context_);
+    return handler_(std::forward<Args>(args)...);
+  }
+
+ private:
+  SpanContext context_;
+  Handler handler_;
+};
+
+// E.g. asio::post(strand, trace::BindContext([] { ... }));
+template <typename Handler>
+ContextHandler<Handler> BindContext(Handler handler) {
+  return ContextHandler<Handler>(CurrentContext(), std::move(handler));
+}
+
+}  // namespace trace
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TRACE_H_
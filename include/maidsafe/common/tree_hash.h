@@ -0,0 +1,81 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TREE_HASH_H_
+#define MAIDSAFE_COMMON_TREE_HASH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Include this first to avoid having to wrap the cryptopp includes in a pragma to disable warnings
+#include "maidsafe/common/crypto.h"  // NOLINT
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+// A Merkle tree hash built from SHA-512, for values large enough that hashing them on one core is
+// a bottleneck.  The input is split into kLeafSize-byte leaves (the last may be shorter, and empty
+// input is a single empty leaf).  Each leaf is hashed as SHA512(0x00 || leaf) and each parent as
+// SHA512(0x01 || left || right).  The tree is left-balanced: a node's left subtree holds the
+// largest power-of-two number of leaves less than its total.  An input of at most one leaf
+// therefore hashes to SHA512(0x00 || input), which differs from its plain SHA512 hash, so names
+// derived with this type can't collide with existing ones.
+//
+// Can be used wherever a Crypto++ hash type is accepted, e.g. Hash<TreeSHA512>(value) or
+// Hasher<TreeSHA512>.  One-shot hashing via CalculateDigest (as used by Hash) hashes the leaves on
+// several threads when the input is large enough; incremental hashing via Update hashes each leaf
+// as soon as it's complete, so holds at most one leaf's state plus one node per tree level.
+class TreeSHA512 : public CryptoPP::HashTransformation {
+ public:
+  enum { DIGESTSIZE = 64, kLeafSize = 64 * 1024 };
+
+  TreeSHA512();
+
+  virtual std::string AlgorithmName() const { return "TreeSHA512"; }
+  virtual unsigned int DigestSize() const { return DIGESTSIZE; }
+  virtual void Update(const byte* input, size_t length);
+  virtual void TruncatedFinal(byte* digest, size_t digest_size);
+  virtual void CalculateDigest(byte* digest, const byte* input, size_t length);
+
+ private:
+  using Node = std::array<byte, DIGESTSIZE>;
+
+  void StartLeaf();
+  // Adds the hash of a leaf which isn't the last, merging any subtrees which are now complete.
+  void AddLeaf(Node leaf_hash);
+  // Merges the open subtrees with the hash of the last leaf to give the root.
+  Node Root(Node last_leaf_hash);
+  void Reset();
+
+  CryptoPP::SHA512 leaf_;
+  size_t leaf_size_;
+  std::uint64_t leaf_count_;
+  std::vector<Node> subtrees_;
+};
+
+}  // namespace crypto
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TREE_HASH_H_
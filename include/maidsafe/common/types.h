@@ -33,6 +33,10 @@
 namespace maidsafe {
 
 using NonEmptyString = detail::BoundedString<1>;
+// As NonEmptyString, but holds values of up to 40 bytes inline (see detail::SmallString), so is
+// preferable where most values are short.  Either converts to the other via its constructor.
+using SmallNonEmptyString =
+    detail::BoundedString<1, static_cast<std::size_t>(-1), detail::SmallString<40>>;
 using byte = unsigned char;
 
 using MemoryUsage = TaggedValue<std::uint64_t, struct MemoryUsageTag>;
@@ -46,6 +46,8 @@
 
 namespace maidsafe {
 
+namespace small_prng { struct RandomContext; }
+
 namespace detail {
 
 class Spinlock {
@@ -66,6 +68,10 @@ class Spinlock {
 
 std::mt19937& random_number_generator();
 std::mutex& random_number_generator_mutex();
+// Returns the calling thread's generator, used by the Random* functions below.  Each is seeded
+// from random_number_generator() on first use, and again after every call to
+// set_random_number_generator_seed, so seeded runs remain reproducible.
+small_prng::RandomContext& thread_random_context();
 #ifdef TESTING
 uint32_t random_number_generator_seed();
 void set_random_number_generator_seed(uint32_t seed);
@@ -146,16 +152,18 @@ std::vector<byte> RandomBytes(size_t size);
 // 'max' inclusive.
 std::vector<byte> RandomBytes(uint32_t min, uint32_t max);
 
+// Fills 'size' bytes at 'output' with non-cryptographically-secure random bytes.  Doesn't lock.
+void FillRandomBytes(byte* output, size_t size);
+
+// As for FillRandomBytes, but each byte is an alphanumeric character.
+void FillRandomAlphaNumericBytes(byte* output, size_t size);
+
 // Generates a non-cryptographically-secure random string of exact size.
 template <typename String>
 String GetRandomString(size_t size) {
-  std::uniform_int_distribution<> distribution(0, 255);
   String random_string(size, 0);
-  {
-    std::lock_guard<std::mutex> lock(detail::random_number_generator_mutex());
-    std::generate(random_string.begin(), random_string.end(),
-                  [&] { return distribution(detail::random_number_generator()); });
-  }
+  if (size != 0)
+    FillRandomBytes(reinterpret_cast<byte*>(&random_string[0]), size);
   return random_string;
 }
 
@@ -177,15 +185,9 @@ std::vector<byte> RandomAlphaNumericBytes(uint32_t min, uint32_t max);
 
 template <typename String>
 String GetRandomAlphaNumericString(size_t size) {
-  static const char alpha_numerics[] =
-      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-  static std::uniform_int_distribution<> distribution(0, 61);
   String random_string(size, 0);
-  {
-    std::lock_guard<std::mutex> lock(detail::random_number_generator_mutex());
-    for (auto it = random_string.begin(); it != random_string.end(); ++it)
-      *it = alpha_numerics[distribution(detail::random_number_generator())];
-  }
+  if (size != 0)
+    FillRandomAlphaNumericBytes(reinterpret_cast<byte*>(&random_string[0]), size);
   return random_string;
 }
 
@@ -200,14 +202,72 @@ std::wstring StringToWstring(const std::string& input);
 // Returns the number of milliseconds since kMaidsafeEpoch (1st January 2000).
 uint64_t GetTimeStamp();
 
+// As GetTimeStamp, but read from CoarseSystemClock, so may lag the real time by up to
+// kCoarseClockResolution.  Much cheaper than GetTimeStamp where timestamps are taken frequently.
+uint64_t GetCoarseTimeStamp();
+
 // Converts 'timestamp' to ptime where 'timestamp' is the result of a call to 'GetTimeStamp()'.
 boost::posix_time::ptime TimeStampToPtime(uint64_t timestamp);
 
 // Reads the given file and returns the contents as a byte vector.  Doesn't throw.
 boost::expected<std::vector<byte>, common_error> ReadFile(const boost::filesystem::path& file_path);
 
+// A read-only view of a file's contents, mapped into memory rather than copied.  The contents are
+// only valid while the MappedFile exists, and while the file isn't modified or truncated.
+class MappedFile {
+ public:
+  MappedFile();
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  const byte* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const byte* begin() const { return data_; }
+  const byte* end() const { return data_ + size_; }
+
+ private:
+  friend boost::expected<MappedFile, common_error> MapFile(
+      const boost::filesystem::path& file_path);
+  struct Mapping;
+
+  std::unique_ptr<Mapping> mapping_;
+  const byte* data_;
+  size_t size_;
+};
+
+// Maps the given file read-only.  An empty file gives an empty MappedFile.  Doesn't throw.
+boost::expected<MappedFile, common_error> MapFile(const boost::filesystem::path& file_path);
+
+struct WriteFileOptions {
+  enum class Durability {
+    kNone,  // leaves flushing to the OS
+    kData   // flushes the contents to the device before returning (fdatasync)
+  };
+
+  WriteFileOptions()
+      : durability(Durability::kNone), atomic_replace(false), preallocate(false),
+        direct_io(false) {}
+
+  Durability durability;
+  // Writes to a temporary file in the same directory, then renames it over the target, so that the
+  // target holds either the old or the new contents, never a partial write.
+  bool atomic_replace;
+  // Reserves the file's full size before writing (POSIX only), so a full disk is detected up front
+  // and the file is less fragmented.
+  bool preallocate;
+  // Bypasses the page cache (O_DIRECT, Linux only), so writing a large file doesn't evict other
+  // cached data.  Falls back to normal writes where the filesystem doesn't support it.
+  bool direct_io;
+};
+
 // Writes the given content string to a file, overwriting if applicable.  Doesn't throw.
 bool WriteFile(const boost::filesystem::path& file_path, const std::vector<byte>& content);
+bool WriteFile(const boost::filesystem::path& file_path, const std::vector<byte>& content,
+               const WriteFileOptions& options);
 
 // For use with std::chrono durations - provides a non-interruptible sleep.
 template <typename Rep, typename Period>
@@ -222,19 +282,33 @@ boost::filesystem::path GetPathFromProgramOptions(
 // Returns max of (2, hardware_concurrency)
 unsigned int Concurrency();
 
+// XORs each of the 'size' bytes at 'source' into the corresponding byte at 'destination', 16 bytes
+// at a time where SSE2 is available, otherwise 8.  If 'parallel' is true, inputs of several
+// megabytes are split across threads.  The ranges must not partially overlap.
+void XorInto(byte* destination, const byte* source, std::size_t size, bool parallel = false);
+
+// As above, for contiguous string types of char or byte (e.g. std::string or std::vector<byte>).
+// Throws if 'destination' and 'source' are not of equal size.
+template <typename String, typename SourceString>
+void XorInto(String& destination, const SourceString& source, bool parallel = false) {
+  const std::size_t size(destination.size());
+  if (size != source.size()) {
+    LOG(kError) << "Cannot XOR two strings of different sizes (destination.size() is " << size
+                << " and source.size() is " << source.size() << ")";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (size != 0) {
+    XorInto(reinterpret_cast<byte*>(&destination[0]),
+            reinterpret_cast<const byte*>(source.data()), size, parallel);
+  }
+}
+
 // Performs a bitwise XOR on each char of 'lhs' with the corresponding char of 'rhs'.  Throws if
 // 'lhs' and 'rhs' are not of equal size.
 template <typename String>
 String operator^(const String& lhs, const String& rhs) {
-  const std::size_t size(lhs.size());
-  if (size != rhs.size()) {
-    LOG(kError) << "Cannot XOR two strings of different sizes (lhs.size() is " << size
-                << " and rhs.size() is " << rhs.size() << ")";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
-  }
-  String result(size, 0);
-  for (std::size_t i(0); i < size; ++i)
-    result[i] = lhs[i] ^ rhs[i];
+  String result(lhs);
+  XorInto(result, rhs);
   return result;
 }
 
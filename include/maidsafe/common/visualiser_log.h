@@ -19,11 +19,14 @@
 #ifndef MAIDSAFE_COMMON_VISUALISER_LOG_H_
 #define MAIDSAFE_COMMON_VISUALISER_LOG_H_
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <utility>
 
-#include "maidsafe/common/convert.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/types.h"
@@ -55,67 +58,38 @@ class VisualiserLogMessage {
   template <typename PersonaEnum, typename ActionEnum>
   VisualiserLogMessage(PersonaEnum persona, ActionEnum action, Identity value1,
                        Identity value2 = Identity{})
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(convert::ToString(value1.string())),
-        kValue2_(value2.IsInitialised() ? convert::ToString(value2.string()) : std::string()),
-        kPersonaId_(persona),
-        kActionId_(action) {}
+      : record_(Enum(persona), Enum(action), Value(std::move(value1)),
+                value2.IsInitialised() ? Value(std::move(value2)) : Value()) {}
 
   template <typename PersonaEnum, typename ActionEnum, typename T,
             typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
   VisualiserLogMessage(PersonaEnum persona, ActionEnum action, T value)
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(std::to_string(value)),
-        kValue2_(),
-        kPersonaId_(persona),
-        kActionId_(action) {}
+      : record_(Enum(persona), Enum(action), Value(value), Value()) {}
 
   template <typename ActionEnum>
   VisualiserLogMessage(ActionEnum action, Identity value1, Identity value2 = Identity{})
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(convert::ToString(value1.string())),
-        kValue2_(value2.IsInitialised() ? convert::ToString(value2.string()) : std::string()),
-        kPersonaId_(),
-        kActionId_(action) {}
+      : record_(Enum(), Enum(action), Value(std::move(value1)),
+                value2.IsInitialised() ? Value(std::move(value2)) : Value()) {}
 
   template <typename ActionEnum, typename T,
             typename std::enable_if<is_string<T>::value>::type* = nullptr>
   VisualiserLogMessage(ActionEnum action, Identity value1, T value2)
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(convert::ToString(value1.string())),
-        kValue2_(value2),
-        kPersonaId_(),
-        kActionId_(action) {}
+      : record_(Enum(), Enum(action), Value(std::move(value1)), Value(std::string(value2))) {}
 
   template <typename ActionEnum, typename T,
             typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
   VisualiserLogMessage(ActionEnum action, T value)
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(std::to_string(value)),
-        kValue2_(),
-        kPersonaId_(),
-        kActionId_(action) {}
+      : record_(Enum(), Enum(action), Value(value), Value()) {}
 
   template <typename ActionEnum, typename T,
             typename std::enable_if<is_string<T>::value>::type* = nullptr>
   VisualiserLogMessage(ActionEnum action, T value)
-      : kTimestamp_(detail::GetUTCTime()),
-        kVaultId_(Logging::Instance().VlogPrefix()),
-        kSessionId_(Logging::Instance().VlogSessionId()),
-        kValue1_(value),
-        kValue2_(),
-        kPersonaId_(),
-        kActionId_(action) {}
+      : record_(Enum(), Enum(action), Value(std::string(value)), Value()) {}
+
+  VisualiserLogMessage(VisualiserLogMessage&& other)
+      : record_(std::move(other.record_)) {
+    other.record_.session_id.reset();
+  }
 
   ~VisualiserLogMessage();
 
@@ -127,32 +101,84 @@ class VisualiserLogMessage {
   friend class test::VisualiserLogTest;
 
  private:
+  // Holds the raw value of the enum, along with a function able to print it.
   struct Enum {
     template <typename EnumType>
     explicit Enum(EnumType e)
-        : value(std::to_string(static_cast<typename std::underlying_type<EnumType>::type>(e))),
-          name([e]()->std::string {
-            std::ostringstream stream;
-            stream << e;
-            return stream.str();
-          }()) {
+        : value(static_cast<uint64_t>(
+              static_cast<typename std::underlying_type<EnumType>::type>(e))),
+          format(&Format<EnumType>) {
       if (!IsValid(e))
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
     }
-    Enum() = default;
-    Enum(const Enum&) = default;
-    Enum(Enum&& other) : value(std::move(other.value)), name(std::move(other.name)) {}
-    Enum& operator=(const Enum&) = default;
+    Enum() : value(0), format(nullptr) {}
+
+    bool IsInitialised() const { return format != nullptr; }
+    std::string Value() const { return format(value, false); }
+    std::string Name() const { return format(value, true); }
+
+    template <typename EnumType>
+    static std::string Format(uint64_t value, bool name) {
+      using Underlying = typename std::underlying_type<EnumType>::type;
+      if (!name)
+        return std::to_string(static_cast<Underlying>(value));
+      std::ostringstream stream;
+      stream << static_cast<EnumType>(static_cast<Underlying>(value));
+      return stream.str();
+    }
+
+    uint64_t value;
+    std::string (*format)(uint64_t, bool);
+  };
+
+  // One of the values being logged, held unformatted.
+  struct Value {
+    enum class Type { kNone, kIdentity, kSigned, kUnsigned, kString };
+    Value() : type(Type::kNone), identity(), integer(0), text() {}
+    explicit Value(Identity identity_in)
+        : type(Type::kIdentity), identity(std::move(identity_in)), integer(0), text() {
+      if (!identity.IsInitialised())
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+    explicit Value(T value)
+        : type(std::is_signed<T>::value ? Type::kSigned : Type::kUnsigned),
+          identity(),
+          integer(static_cast<uint64_t>(value)),
+          text() {}
+    explicit Value(std::string text_in)
+        : type(Type::kString), identity(), integer(0), text(std::move(text_in)) {}
+    Value(Value&&) = default;
+
+    bool Empty() const { return type == Type::kNone; }
+    // Identities are hex-encoded, in full or abbreviated if 'debug_format' is true.
+    std::string ToString(bool debug_format) const;
+
+    Type type;
+    Identity identity;
+    uint64_t integer;
+    std::string text;
+  };
+
+  // Everything the message is made of, captured without formatting so that construction is cheap;
+  // the strings for the logfile and server are built on the logging background thread.
+  struct Record {
+    Record(Enum persona_id_in, Enum action_id_in, Value value1_in, Value value2_in);
+    Record(Record&&) = default;
+
+    std::string GetPostRequestBody() const;
+    std::string GetLogfileEntry() const;
 
-    std::string value, name;
+    std::chrono::system_clock::time_point timestamp;
+    // Shared with Logging, which sets these once in InitialiseVlog.
+    std::shared_ptr<const std::string> vault_id, session_id;
+    Enum persona_id, action_id;
+    Value value1, value2;
   };
 
-  std::string GetPostRequestBody() const;
-  void SendToServer() const;
-  void WriteToFile() const;
+  std::string GetPostRequestBody() const { return record_.GetPostRequestBody(); }
 
-  const std::string kTimestamp_, kVaultId_, kSessionId_, kValue1_, kValue2_;
-  const Enum kPersonaId_, kActionId_;
+  Record record_;
 };
 
 }  // namespace log
@@ -0,0 +1,96 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_WORK_STEALING_POOL_H_
+#define MAIDSAFE_COMMON_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "boost/thread/thread.hpp"
+
+namespace maidsafe {
+
+// A multi-threaded alternative to Active.  Each worker thread owns a deque of functors: functors
+// sent from a worker are pushed onto its own deque, and those sent from other threads are spread
+// across the workers' deques in turn.  A worker runs the most recently added functor from its own
+// deque, and when that is empty steals the oldest functor from another worker's deque.
+//
+// Functors may run concurrently and in any order.  Any functors still queued when the pool is
+// destroyed are run before the destructor returns.
+class WorkStealingPool {
+ public:
+  typedef std::function<void()> Functor;
+  // Uses one thread per hardware thread.
+  WorkStealingPool();
+  // Throws if 'thread_count' is 0.
+  explicit WorkStealingPool(size_t thread_count);
+  ~WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool(WorkStealingPool&&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+  void Send(Functor functor);
+
+  // As for Send, but returns a future holding the result of 'functor' (or the exception it threw).
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> Submit(F functor);
+
+  size_t ThreadCount() const { return workers_.size(); }
+  // Number of functors run by a worker other than the one whose deque they were added to.
+  uint64_t steal_count() const { return steal_count_; }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Functor> functors;
+  };
+
+  void Run(size_t index);
+  bool TryPop(size_t index, Functor& functor);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_worker_, pending_, sleeping_;
+  std::atomic<uint64_t> steal_count_;
+  std::atomic<bool> running_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<boost::thread> threads_;
+};
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> WorkStealingPool::Submit(F functor) {
+  using Result = typename std::result_of<F()>::type;
+  auto task(std::make_shared<std::packaged_task<Result()>>(std::move(functor)));
+  auto result(task->get_future());
+  Send([task] { (*task)(); });
+  return result;
+}
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_WORK_STEALING_POOL_H_
@@ -18,6 +18,11 @@
 
 #include "maidsafe/common/active.h"
 
+#include <utility>
+
+#include "maidsafe/common/profiler.h"
+#include "maidsafe/common/trace.h"
+
 namespace maidsafe {
 
 Active::Active()
@@ -40,29 +45,45 @@ void Active::Send(Functor functor) {
   std::lock_guard<std::mutex> flags_lock(flags_mutex_);
   if (!running_)
     return;
+  // Run the functor within the sender's trace context, if it has one.
+  if (trace::CurrentContext().IsValid())
+    functor = trace::BindContext(std::move(functor));
+  bool was_empty(false);
   {
     std::lock_guard<std::mutex> lock(mutex_);
+    was_empty = functors_.empty();
     functors_.push(std::move(functor));
   }
-  condition_.notify_one();
+  // Run only waits while the queue is empty, so only the first functor of a batch needs to wake it.
+  if (was_empty)
+    condition_.notify_one();
 }
 
 void Active::Run() {
+  profile::SampledThread sampled_thread;
   auto running = [this]() -> bool {
     std::lock_guard<std::mutex> flags_lock(flags_mutex_);
     return running_;
   };
 
+  std::queue<Functor> batch;
   while (running()) {
-    Functor functor;
     {
+      // Take everything queued so far in a single lock acquisition.
       std::unique_lock<std::mutex> lock(mutex_);
       while (functors_.empty())
         condition_.wait(lock);
-      functor = std::move(functors_.front());
-      functors_.pop();
+      std::swap(batch, functors_);
+    }
+    while (!batch.empty()) {
+      Functor functor(std::move(batch.front()));
+      batch.pop();
+      functor();
+      // Anything still in the batch after the destructor's functor is dropped, as it would have
+      // been had it been left in 'functors_'.
+      if (!running())
+        return;
     }
-    functor();
   }
 }
 
@@ -48,6 +48,13 @@ SafeString SecureString::string() const {
   return decrypted_string;
 }
 
+ScopedPlaintext::~ScopedPlaintext() {
+  // Short strings are held inline rather than by safe_allocator, so wipe them explicitly.
+  volatile char* vptr = &plaintext_[0];
+  for (size_type i(0); i != plaintext_.size(); ++i)
+    vptr[i] = 0;
+}
+
 SafeString operator+(const SafeString& first, const SafeString& second) {
   return SafeString(first.begin(), first.end()) + SafeString(second.begin(), second.end());
 }
@@ -62,6 +69,7 @@ SafeString operator+(const SafeString& first, const SecureString::Hash& second)
 
 // see safe_allocators.h
 LockedPageManager LockedPageManager::instance;
+LockedArena LockedArena::instance;
 
 }  // namespace detail
 
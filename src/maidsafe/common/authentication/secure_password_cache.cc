@@ -0,0 +1,131 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/authentication/secure_password_cache.h"
+
+#include <algorithm>
+
+#include "cryptopp/hmac.h"
+
+
+namespace maidsafe {
+
+namespace authentication {
+
+namespace {
+
+template <typename Hmac>
+void AddField(Hmac& hmac, const byte* data, std::size_t size) {
+  // Length-prefix each field so that different inputs can't produce the same HMAC input.
+  byte length[8];
+  for (int i(0); i != 8; ++i)
+    length[i] = static_cast<byte>(static_cast<std::uint64_t>(size) >> (8 * (7 - i)));
+  hmac.Update(length, sizeof(length));
+  hmac.Update(data, size);
+}
+
+}  // unnamed namespace
+
+SecurePasswordCache::SecurePasswordCache(Clock::duration time_to_live, std::size_t max_size)
+    : time_to_live_(time_to_live),
+      max_size_(max_size),
+      hmac_key_([] {
+        SafeBytes key(crypto::SHA512::DIGESTSIZE);
+        crypto::random_number_generator().GenerateBlock(key.data(), key.size());
+        return key;
+      }()),
+      mutex_(),
+      entries_(),
+      hit_count_(0) {
+  if (max_size_ == 0) {
+    LOG(kError) << "SecurePasswordCache max_size must be at least 1.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+}
+
+void SecurePasswordCache::Wipe() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+std::size_t SecurePasswordCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+std::uint64_t SecurePasswordCache::hit_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hit_count_;
+}
+
+SecurePasswordCache::Key SecurePasswordCache::MakeKey(const byte* password,
+                                                      std::size_t password_size,
+                                                      const crypto::Salt& salt, uint32_t pin,
+                                                      const std::string& label) const {
+  CryptoPP::HMAC<crypto::SHA512> hmac(hmac_key_.data(), hmac_key_.size());
+  AddField(hmac, password, password_size);
+  AddField(hmac, salt.data(), salt.size());
+  const byte pin_bytes[4] = {static_cast<byte>(pin >> 24), static_cast<byte>(pin >> 16),
+                             static_cast<byte>(pin >> 8), static_cast<byte>(pin)};
+  AddField(hmac, pin_bytes, sizeof(pin_bytes));
+  AddField(hmac, reinterpret_cast<const byte*>(label.data()), label.size());
+  Key key;
+  hmac.Final(key.data());
+  return key;
+}
+
+bool SecurePasswordCache::Find(const Key& key, crypto::SecurePassword& secure_password) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RemoveExpired(Clock::now());
+  const auto itr(entries_.find(key));
+  if (itr == entries_.end())
+    return false;
+  ++hit_count_;
+  secure_password = crypto::SecurePassword(crypto::AES256KeyAndIV(std::vector<byte>(
+      itr->second.secure_password.begin(), itr->second.secure_password.end())));
+  return true;
+}
+
+void SecurePasswordCache::Insert(const Key& key, const crypto::SecurePassword& secure_password) {
+  const Clock::time_point now(Clock::now());
+  std::lock_guard<std::mutex> lock(mutex_);
+  RemoveExpired(now);
+  if (entries_.size() >= max_size_ && entries_.count(key) == 0) {
+    entries_.erase(std::min_element(entries_.begin(), entries_.end(),
+                                    [](const std::pair<const Key, Entry>& lhs,
+                                       const std::pair<const Key, Entry>& rhs) {
+                                      return lhs.second.expiry < rhs.second.expiry;
+                                    }));
+  }
+  Entry& entry(entries_[key]);
+  entry.secure_password.assign(secure_password->begin(), secure_password->end());
+  entry.expiry = now + time_to_live_;
+}
+
+void SecurePasswordCache::RemoveExpired(Clock::time_point now) {
+  for (auto itr(entries_.begin()); itr != entries_.end();) {
+    if (itr->second.expiry <= now)
+      itr = entries_.erase(itr);
+    else
+      ++itr;
+  }
+}
+
+}  // namespace authentication
+
+}  // namespace maidsafe
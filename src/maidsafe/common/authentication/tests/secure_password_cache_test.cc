@@ -0,0 +1,94 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/authentication/secure_password_cache.h"
+
+#include <chrono>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace authentication {
+
+namespace test {
+
+TEST(SecurePasswordCacheTest, BEH_Get) {
+  SecurePasswordCache cache(std::chrono::minutes(1));
+  const NonEmptyString password(RandomAlphaNumericString(20));
+  const crypto::Salt salt(RandomString(64));
+  const uint32_t pin(RandomUint32());
+  const crypto::SecurePassword expected(crypto::CreateSecurePassword(password, salt, pin));
+
+  EXPECT_EQ(expected, cache.Get(password, salt, pin));
+  EXPECT_EQ(0U, cache.hit_count());
+  EXPECT_EQ(expected, cache.Get(password, salt, pin));
+  EXPECT_EQ(1U, cache.hit_count());
+  EXPECT_EQ(1U, cache.size());
+
+  // Each input is part of the key
+  EXPECT_NE(expected, cache.Get(NonEmptyString(RandomAlphaNumericString(20)), salt, pin));
+  EXPECT_NE(expected, cache.Get(password, crypto::Salt(RandomString(64)), pin));
+  EXPECT_NE(expected, cache.Get(password, salt, pin + 1));
+  EXPECT_NE(expected, cache.Get(password, salt, pin, "Other label"));
+  EXPECT_EQ(1U, cache.hit_count());
+  EXPECT_EQ(5U, cache.size());
+
+  cache.Wipe();
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_EQ(expected, cache.Get(password, salt, pin));
+  EXPECT_EQ(1U, cache.hit_count());
+
+  EXPECT_THROW(cache.Get(NonEmptyString(), salt, pin), common_error);
+  EXPECT_THROW(cache.Get(password, crypto::Salt(), pin), common_error);
+  EXPECT_THROW(SecurePasswordCache(std::chrono::minutes(1), 0), common_error);
+}
+
+TEST(SecurePasswordCacheTest, BEH_ExpiryAndEviction) {
+  const NonEmptyString password(RandomAlphaNumericString(20));
+  const crypto::Salt salt(RandomString(64));
+  {
+    SecurePasswordCache cache(std::chrono::milliseconds(100));
+    cache.Get(password, salt, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    cache.Get(password, salt, 1);
+    EXPECT_EQ(0U, cache.hit_count());
+    EXPECT_EQ(1U, cache.size());
+  }
+  {
+    SecurePasswordCache cache(std::chrono::minutes(1), 2);
+    cache.Get(password, salt, 1);
+    cache.Get(password, salt, 2);
+    cache.Get(password, salt, 3);
+    EXPECT_EQ(2U, cache.size());
+    // The oldest entry was evicted
+    cache.Get(password, salt, 3);
+    cache.Get(password, salt, 2);
+    EXPECT_EQ(2U, cache.hit_count());
+    cache.Get(password, salt, 1);
+    EXPECT_EQ(2U, cache.hit_count());
+  }
+}
+
+}  // namespace test
+
+}  // namespace authentication
+
+}  // namespace maidsafe
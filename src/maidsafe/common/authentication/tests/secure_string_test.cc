@@ -18,6 +18,10 @@
 
 #include "maidsafe/common/authentication/detail/secure_string.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "boost/regex.hpp"
 
 #include "maidsafe/common/error.h"
@@ -351,6 +355,92 @@ TEST(SecureStringTest, BEH_InsertInvalidPinValue) {
   ASSERT_EQ(123, pin.Value());
 }
 
+TEST(SecureStringTest, BEH_AssignAndScopedPlaintext) {
+  SecureString secure_string;
+  secure_string.Append(std::string("discarded"));
+  secure_string.Assign(std::string("password"));
+  EXPECT_EQ(SafeString("password"), secure_string.string());
+  secure_string.Assign(SafeString("other"));
+  EXPECT_EQ(SafeString("other"), secure_string.string());
+
+  Password password;
+  password.Insert(0, 'a');
+  EXPECT_THROW(password.Assign(std::string()), maidsafe_error);
+  password.Assign(std::string("password"));
+  EXPECT_TRUE(password.IsFinalised());
+  EXPECT_EQ(SafeString("password"), password.string());
+  EXPECT_TRUE(password.IsValid(boost::regex(".")));
+  // Editing after a bulk assignment behaves as after Finalise.
+  password.Remove(0);
+  password.Finalise();
+  EXPECT_EQ(SafeString("assword"), password.string());
+
+  const ScopedPlaintext secure_plaintext(secure_string);
+  EXPECT_EQ(SafeString("other"), secure_plaintext.string());
+  const ScopedPlaintext password_plaintext(password);
+  EXPECT_EQ(7U, password_plaintext.size());
+  EXPECT_EQ(std::string("assword"),
+            std::string(password_plaintext.data(), password_plaintext.size()));
+}
+
+struct StubLocker {
+  StubLocker() : succeed(true) {}
+  bool Lock(const void*, size_t) { return succeed; }
+  bool Unlock(const void*, size_t) { return true; }
+  bool succeed;
+};
+
+struct FailingLocker : StubLocker {
+  FailingLocker() { succeed = false; }
+};
+
+TEST(SafeAllocatorTest, BEH_LockedArena) {
+  typedef LockedArenaBase<StubLocker> Arena;
+  int outside(0);
+  {
+    LockedArenaBase<FailingLocker> unlocked_arena;
+    EXPECT_EQ(nullptr, unlocked_arena.Allocate(16));
+    EXPECT_FALSE(unlocked_arena.Deallocate(&outside, sizeof(outside)));
+  }
+
+  Arena arena;
+  EXPECT_EQ(nullptr, arena.Allocate(0));
+  EXPECT_EQ(nullptr, arena.Allocate(Arena::kMaxBlockSize + 1));
+  EXPECT_FALSE(arena.Deallocate(&outside, sizeof(outside)));
+
+  // Freed blocks are zeroed and reused.
+  char* const block(static_cast<char*>(arena.Allocate(10)));
+  ASSERT_NE(nullptr, block);
+  std::fill(block, block + Arena::kMinBlockSize, 'a');
+  EXPECT_TRUE(arena.Deallocate(block, 10));
+  for (size_t i(sizeof(void*)); i != Arena::kMinBlockSize; ++i)
+    EXPECT_EQ(0, block[i]);
+  EXPECT_EQ(block, arena.Allocate(Arena::kMinBlockSize));
+
+  // Once exhausted, the arena declines further allocations.
+  std::vector<void*> blocks;
+  while (void* large_block = arena.Allocate(Arena::kMaxBlockSize))
+    blocks.push_back(large_block);
+  EXPECT_EQ(Arena::kRegionSize / Arena::kMaxBlockSize - 1, blocks.size());
+  EXPECT_EQ(nullptr, arena.Allocate(Arena::kMaxBlockSize));
+  EXPECT_TRUE(arena.Deallocate(blocks.back(), Arena::kMaxBlockSize));
+  EXPECT_EQ(blocks.back(), arena.Allocate(Arena::kMaxBlockSize));
+}
+
+TEST(SafeAllocatorTest, BEH_SmallAndLargeAllocations) {
+  // Small allocations come from the arena, large ones are locked individually.
+  const std::string small_contents(RandomString(100)), large_contents(RandomString(100000));
+  std::vector<SafeString> strings;
+  for (int i(0); i != 100; ++i) {
+    strings.emplace_back(small_contents.begin(), small_contents.end());
+    strings.emplace_back(large_contents.begin(), large_contents.end());
+  }
+  for (size_t i(0); i != strings.size(); i += 2) {
+    EXPECT_EQ(small_contents, std::string(strings[i].begin(), strings[i].end()));
+    EXPECT_EQ(large_contents, std::string(strings[i + 1].begin(), strings[i + 1].end()));
+  }
+}
+
 }  // namespace test
 
 }  // namespace detail
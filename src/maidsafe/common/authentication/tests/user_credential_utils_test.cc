@@ -86,6 +86,21 @@ TEST_F(UserCredentialsTest, BEH_CreateSecurePassword) {
   EXPECT_THROW(CreateSecurePassword(user_credentials), common_error);
 }
 
+TEST_F(UserCredentialsTest, BEH_CachedDerivations) {
+  SecurePasswordCache cache(std::chrono::minutes(1));
+  const crypto::SecurePassword kSecurePassword{CreateSecurePassword(user_credentials)};
+  EXPECT_EQ(kSecurePassword, CreateSecurePassword(user_credentials, &cache));
+  EXPECT_EQ(kSecurePassword, CreateSecurePassword(user_credentials, &cache));
+  EXPECT_EQ(1U, cache.hit_count());
+
+  const NonEmptyString kData{RandomString(100)};
+  const NonEmptyString kObfuscated{Obfuscate(user_credentials, kData)};
+  EXPECT_EQ(kObfuscated, Obfuscate(user_credentials, kData, &cache));
+  EXPECT_EQ(kData, Obfuscate(user_credentials, kObfuscated, &cache));
+  EXPECT_EQ(2U, cache.hit_count());
+  EXPECT_EQ(2U, cache.size());
+}
+
 TEST_F(UserCredentialsTest, FUNC_ObfuscateData) {
   const NonEmptyString kData{RandomString(1024 * 1024)};
   const NonEmptyString kObfuscated{Obfuscate(user_credentials, kData)};
@@ -18,55 +18,58 @@
 
 #include "maidsafe/common/authentication/user_credential_utils.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <utility>
 
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
 #include "maidsafe/common/authentication/user_credentials.h"
 
 namespace maidsafe {
 
 namespace authentication {
 
-crypto::SecurePassword CreateSecurePassword(const UserCredentials& user_credentials) {
+crypto::SecurePassword CreateSecurePassword(const UserCredentials& user_credentials,
+                                            SecurePasswordCache* cache) {
   if (!user_credentials.pin || !user_credentials.password) {
     LOG(kError) << "UserCredentials is not initialised.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
   crypto::Salt salt{crypto::Hash<crypto::SHA512>(user_credentials.pin->Hash<crypto::SHA512>() +
                                                  user_credentials.password->string())};
-  return crypto::CreateSecurePassword(*user_credentials.password, salt,
-                                      static_cast<uint32_t>(user_credentials.pin->Value()));
+  const uint32_t pin(static_cast<uint32_t>(user_credentials.pin->Value()));
+  return cache ? cache->Get(*user_credentials.password, salt, pin)
+               : crypto::CreateSecurePassword(*user_credentials.password, salt, pin);
 }
 
-NonEmptyString Obfuscate(const UserCredentials& user_credentials, const NonEmptyString& data) {
+NonEmptyString Obfuscate(const UserCredentials& user_credentials, const NonEmptyString& data,
+                         SecurePasswordCache* cache) {
   if (!user_credentials.keyword || !user_credentials.pin || !user_credentials.password) {
     LOG(kError) << "UserCredentials is not initialised.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
   crypto::Salt salt(crypto::Hash<crypto::SHA512>(user_credentials.password->string() +
                                                  user_credentials.pin->Hash<crypto::SHA512>()));
-  auto obfuscation_str(crypto::CreateSecurePassword(
-                           *user_credentials.keyword, salt,
-                           static_cast<uint32_t>(user_credentials.pin->Value() * 2))->string());
+  const uint32_t pin(static_cast<uint32_t>(user_credentials.pin->Value() * 2));
+  auto obfuscation_str((cache ? cache->Get(*user_credentials.keyword, salt, pin)
+                              : crypto::CreateSecurePassword(*user_credentials.keyword, salt, pin))
+                           ->string());
 
-  // make the obfuscation_str of same size for XOR
+  // Make the obfuscation_str the same size as the data for XOR, by repeating it as necessary.  The
+  // filled part is doubled on each pass, so large data needs few (non-overlapping) copies.
   const std::size_t data_size(data.string().size());
-  if (data_size < obfuscation_str.size()) {
-    obfuscation_str.resize(data_size);
-  } else if (data_size > obfuscation_str.size()) {
-    obfuscation_str.reserve(data_size);
-    while (data_size > obfuscation_str.size())
-      obfuscation_str.insert(obfuscation_str.end(), obfuscation_str.begin(), obfuscation_str.end());
-    obfuscation_str.resize(data_size);
-  }
-
-  // XOR the data and the obfuscation string
-  std::vector<byte> result(data_size, 0);
-  for (std::size_t i(0); i < data_size; ++i)
-    result[i] = data.string()[i] ^ obfuscation_str[i];
-
-  return NonEmptyString(result);
+  std::size_t filled(obfuscation_str.size());
+  obfuscation_str.resize(data_size);
+  for (; filled < data_size; filled *= 2)
+    std::memcpy(&obfuscation_str[filled], &obfuscation_str[0],
+                std::min(filled, data_size - filled));
+
+  // XOR the data into the obfuscation string in place
+  XorInto(obfuscation_str, data.string(), true);
+  return NonEmptyString(std::move(obfuscation_str));
 }
 
 }  // namespace authentication
@@ -0,0 +1,194 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/bootstrap_file.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "asio/ip/address_v4.hpp"
+#include "asio/ip/address_v6.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace {
+
+const byte kMagic[8] = {'M', 'A', 'I', 'D', 'B', 'O', 'O', 'T'};
+const std::uint32_t kVersion(1);
+const std::size_t kHeaderSize(16);
+const std::size_t kAddressSize(16);
+const std::size_t kRecordSize(kAddressSize + 2);
+const byte kV4MappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+using Record = std::array<byte, kRecordSize>;
+
+void WriteUint32(std::uint32_t value, byte* output) {
+  for (int i(0); i != 4; ++i)
+    output[i] = static_cast<byte>(value >> (8 * i));
+}
+
+std::uint32_t ReadUint32(const byte* input) {
+  std::uint32_t value(0);
+  for (int i(0); i != 4; ++i)
+    value |= static_cast<std::uint32_t>(input[i]) << (8 * i);
+  return value;
+}
+
+Record ToRecord(const asio::ip::udp::endpoint& endpoint) {
+  Record record;
+  if (endpoint.address().is_v4()) {
+    const asio::ip::address_v4::bytes_type bytes(endpoint.address().to_v4().to_bytes());
+    std::memcpy(record.data(), kV4MappedPrefix, sizeof(kV4MappedPrefix));
+    std::copy(bytes.begin(), bytes.end(), record.begin() + sizeof(kV4MappedPrefix));
+  } else {
+    const asio::ip::address_v6::bytes_type bytes(endpoint.address().to_v6().to_bytes());
+    std::copy(bytes.begin(), bytes.end(), record.begin());
+  }
+  record[kAddressSize] = static_cast<byte>(endpoint.port() >> 8);
+  record[kAddressSize + 1] = static_cast<byte>(endpoint.port());
+  return record;
+}
+
+asio::ip::udp::endpoint FromRecord(const byte* record) {
+  const std::uint16_t port(
+      static_cast<std::uint16_t>((record[kAddressSize] << 8) | record[kAddressSize + 1]));
+  if (std::memcmp(record, kV4MappedPrefix, sizeof(kV4MappedPrefix)) == 0) {
+    asio::ip::address_v4::bytes_type bytes;
+    std::copy(record + sizeof(kV4MappedPrefix), record + kAddressSize, bytes.begin());
+    return asio::ip::udp::endpoint(asio::ip::address_v4(bytes), port);
+  }
+  asio::ip::address_v6::bytes_type bytes;
+  std::copy(record, record + kAddressSize, bytes.begin());
+  return asio::ip::udp::endpoint(asio::ip::address_v6(bytes), port);
+}
+
+}  // unnamed namespace
+
+std::vector<byte> SerialiseCompactBootstrap(
+    const std::vector<asio::ip::udp::endpoint>& endpoints) {
+  std::vector<Record> records;
+  records.reserve(endpoints.size());
+  for (const auto& endpoint : endpoints)
+    records.push_back(ToRecord(endpoint));
+  std::sort(records.begin(), records.end());
+  records.erase(std::unique(records.begin(), records.end()), records.end());
+  if (records.size() > std::numeric_limits<std::uint32_t>::max())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+
+  std::vector<byte> output(kHeaderSize + records.size() * kRecordSize);
+  std::memcpy(output.data(), kMagic, sizeof(kMagic));
+  WriteUint32(kVersion, &output[sizeof(kMagic)]);
+  WriteUint32(static_cast<std::uint32_t>(records.size()), &output[sizeof(kMagic) + 4]);
+  byte* position(output.data() + kHeaderSize);
+  for (const Record& record : records) {
+    std::memcpy(position, record.data(), kRecordSize);
+    position += kRecordSize;
+  }
+  return output;
+}
+
+bool IsCompactBootstrap(const byte* data, std::size_t size) {
+  return size >= kHeaderSize && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+CompactBootstrapFile::CompactBootstrapFile(const boost::filesystem::path& path)
+    : file_(), records_(nullptr), size_(0) {
+  auto mapped(MapFile(path));
+  if (!mapped) {
+    LOG(kWarning) << "Failed to map bootstrap file " << path;
+    BOOST_THROW_EXCEPTION(mapped.error());
+  }
+  file_ = std::move(*mapped);
+  Validate(file_.data(), file_.size());
+}
+
+CompactBootstrapFile::CompactBootstrapFile(const byte* data, std::size_t size)
+    : file_(), records_(nullptr), size_(0) {
+  Validate(data, size);
+}
+
+CompactBootstrapFile::CompactBootstrapFile(CompactBootstrapFile&& other)
+    : file_(std::move(other.file_)), records_(other.records_), size_(other.size_) {
+  other.records_ = nullptr;
+  other.size_ = 0;
+}
+
+CompactBootstrapFile& CompactBootstrapFile::operator=(CompactBootstrapFile&& other) {
+  file_ = std::move(other.file_);
+  records_ = other.records_;
+  size_ = other.size_;
+  other.records_ = nullptr;
+  other.size_ = 0;
+  return *this;
+}
+
+void CompactBootstrapFile::Validate(const byte* data, std::size_t size) {
+  if (!IsCompactBootstrap(data, size)) {
+    LOG(kWarning) << "Not a compact bootstrap file.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  const std::uint32_t version(ReadUint32(data + sizeof(kMagic)));
+  if (version != kVersion) {
+    LOG(kWarning) << "Unsupported compact bootstrap file version " << version;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  const std::size_t count(ReadUint32(data + sizeof(kMagic) + 4));
+  if ((size - kHeaderSize) / kRecordSize != count || (size - kHeaderSize) % kRecordSize != 0) {
+    LOG(kWarning) << "Compact bootstrap file size doesn't match its record count.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  records_ = data + kHeaderSize;
+  size_ = count;
+}
+
+asio::ip::udp::endpoint CompactBootstrapFile::operator[](std::size_t index) const {
+  return FromRecord(records_ + index * kRecordSize);
+}
+
+bool CompactBootstrapFile::Contains(const asio::ip::udp::endpoint& endpoint) const {
+  const Record target(ToRecord(endpoint));
+  std::size_t first(0), last(size_);
+  while (first != last) {
+    const std::size_t middle(first + (last - first) / 2);
+    const int comparison(std::memcmp(records_ + middle * kRecordSize, target.data(), kRecordSize));
+    if (comparison == 0)
+      return true;
+    if (comparison < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  return false;
+}
+
+std::vector<asio::ip::udp::endpoint> CompactBootstrapFile::Endpoints() const {
+  std::vector<asio::ip::udp::endpoint> endpoints;
+  endpoints.reserve(size_);
+  for (std::size_t i(0); i != size_; ++i)
+    endpoints.push_back((*this)[i]);
+  return endpoints;
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,91 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/chacha20.h"
+
+#include <array>
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+std::uint32_t Load32(const byte* input) {
+  return static_cast<std::uint32_t>(input[0]) | (static_cast<std::uint32_t>(input[1]) << 8) |
+         (static_cast<std::uint32_t>(input[2]) << 16) |
+         (static_cast<std::uint32_t>(input[3]) << 24);
+}
+
+void Store32(std::uint32_t value, byte* output) {
+  output[0] = static_cast<byte>(value);
+  output[1] = static_cast<byte>(value >> 8);
+  output[2] = static_cast<byte>(value >> 16);
+  output[3] = static_cast<byte>(value >> 24);
+}
+
+std::uint32_t RotateLeft(std::uint32_t value, int count) {
+  return (value << count) | (value >> (32 - count));
+}
+
+void QuarterRound(std::array<std::uint32_t, 16>& x, int a, int b, int c, int d) {
+  x[a] += x[b];
+  x[d] = RotateLeft(x[d] ^ x[a], 16);
+  x[c] += x[d];
+  x[b] = RotateLeft(x[b] ^ x[c], 12);
+  x[a] += x[b];
+  x[d] = RotateLeft(x[d] ^ x[a], 8);
+  x[c] += x[d];
+  x[b] = RotateLeft(x[b] ^ x[c], 7);
+}
+
+}  // unnamed namespace
+
+void ChaCha20Keystream(const byte* key, const byte* nonce, std::uint32_t counter,
+                       std::size_t block_count, byte* output) {
+  // "expand 32-byte k"
+  std::array<std::uint32_t, 16> state{{0x61707865, 0x3320646e, 0x79622d32, 0x6b206574}};
+  for (int i(0); i != 8; ++i)
+    state[4 + i] = Load32(key + 4 * i);
+  for (int i(0); i != 3; ++i)
+    state[13 + i] = Load32(nonce + 4 * i);
+
+  std::array<std::uint32_t, 16> working;
+  for (std::size_t block(0); block != block_count; ++block, output += kChaCha20BlockSize) {
+    state[12] = counter++;
+    working = state;
+    for (int round(0); round != 10; ++round) {
+      QuarterRound(working, 0, 4, 8, 12);
+      QuarterRound(working, 1, 5, 9, 13);
+      QuarterRound(working, 2, 6, 10, 14);
+      QuarterRound(working, 3, 7, 11, 15);
+      QuarterRound(working, 0, 5, 10, 15);
+      QuarterRound(working, 1, 6, 11, 12);
+      QuarterRound(working, 2, 7, 8, 13);
+      QuarterRound(working, 3, 4, 9, 14);
+    }
+    for (int i(0); i != 16; ++i)
+      Store32(working[i] + state[i], output + 4 * i);
+  }
+  working.fill(0);
+  state.fill(0);
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
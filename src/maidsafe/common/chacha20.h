@@ -0,0 +1,44 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_CHACHA20_H_
+#define MAIDSAFE_COMMON_CHACHA20_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+const std::size_t kChaCha20KeySize = 32;
+const std::size_t kChaCha20NonceSize = 12;
+const std::size_t kChaCha20BlockSize = 64;
+
+// Writes 'block_count' consecutive 64-byte blocks of the ChaCha20 keystream (RFC 7539 variant: a
+// 32-bit block counter and a 96-bit nonce) to 'output', starting at block 'counter'.
+void ChaCha20Keystream(const byte* key, const byte* nonce, std::uint32_t counter,
+                       std::size_t block_count, byte* output);
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_CHACHA20_H_
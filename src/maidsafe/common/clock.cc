@@ -18,8 +18,160 @@
 
 #include "maidsafe/common/clock.h"
 
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
 namespace maidsafe {
 
+namespace detail {
+
+namespace {
+
+// Long enough that the error from reading the counter and steady_clock at slightly different
+// moments is a few parts per million.
+const std::chrono::milliseconds kTscCalibrationPeriod(10);
+
+bool TimestampCounterIsInvariant() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  // CPUID leaf 0x80000007 reports an invariant TSC in bit 8 of EDX.
+  unsigned int edx(0);
+#ifdef _MSC_VER
+  int registers[4];
+  __cpuid(registers, 0x80000000);
+  if (static_cast<unsigned int>(registers[0]) < 0x80000007)
+    return false;
+  __cpuid(registers, 0x80000007);
+  edx = static_cast<unsigned int>(registers[3]);
+#else
+  unsigned int eax(0), ebx(0), ecx(0);
+  if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007 ||
+      !__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+#endif
+  if ((edx & (1U << 8)) == 0)
+    return false;
+#ifdef MAIDSAFE_LINUX
+  // The kernel stops using the TSC as its clocksource if it finds it unreliable despite the CPUID
+  // flag, e.g. unsynchronised across sockets, or under some hypervisors.
+  std::ifstream clocksource("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+  std::string name;
+  if (clocksource >> name && name != "tsc")
+    return false;
+#endif
+  return true;
+#elif defined(__aarch64__)
+  // The generic timer's virtual count always runs at a constant rate.
+  return true;
+#else
+  return false;
+#endif
+}
+
+TscCalibration Calibrate() {
+  TscCalibration calibration{false, 0, 0.0};
+  if (!TimestampCounterIsInvariant())
+    return calibration;
+
+#ifdef __aarch64__
+  std::uint64_t frequency;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+  if (frequency != 0) {
+    calibration.usable = true;
+    calibration.base_ticks = ReadTimestampCounter();
+    calibration.nanoseconds_per_tick = 1e9 / static_cast<double>(frequency);
+    return calibration;
+  }
+#endif
+
+  const auto start_time(std::chrono::steady_clock::now());
+  const std::uint64_t start_ticks(ReadTimestampCounter());
+  std::this_thread::sleep_for(kTscCalibrationPeriod);
+  const auto end_time(std::chrono::steady_clock::now());
+  const std::uint64_t end_ticks(ReadTimestampCounter());
+  const auto elapsed(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+  if (end_ticks <= start_ticks || elapsed <= 0)
+    return calibration;
+
+  calibration.usable = true;
+  calibration.base_ticks = start_ticks;
+  calibration.nanoseconds_per_tick =
+      static_cast<double>(elapsed) / static_cast<double>(end_ticks - start_ticks);
+  return calibration;
+}
+
+}  // unnamed namespace
+
+const TscCalibration& GetTscCalibration() {
+  static const TscCalibration calibration(Calibrate());
+  return calibration;
+}
+
+}  // namespace detail
+
+namespace {
+
+class CoarseTime {
+ public:
+  CoarseTime()
+      : system_now_(std::chrono::system_clock::now().time_since_epoch().count()),
+        steady_now_(std::chrono::steady_clock::now().time_since_epoch().count()),
+        refreshing_(false) {
+    try {
+      std::thread([this] { Refresh(); }).detach();
+      refreshing_ = true;
+    } catch (const std::system_error&) {
+      // Without the refreshing thread, the coarse clocks fall back to reading the real ones.
+    }
+  }
+
+  CoarseSystemClock::time_point SystemNow() const {
+    if (!refreshing_)
+      return std::chrono::system_clock::now();
+    return CoarseSystemClock::time_point(
+        CoarseSystemClock::duration(system_now_.load(std::memory_order_relaxed)));
+  }
+
+  CoarseSteadyClock::time_point SteadyNow() const {
+    if (!refreshing_)
+      return std::chrono::steady_clock::now();
+    return CoarseSteadyClock::time_point(
+        CoarseSteadyClock::duration(steady_now_.load(std::memory_order_relaxed)));
+  }
+
+ private:
+  void Refresh() {
+    for (;;) {
+      std::this_thread::sleep_for(kCoarseClockResolution);
+      system_now_.store(std::chrono::system_clock::now().time_since_epoch().count(),
+                        std::memory_order_relaxed);
+      steady_now_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                        std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<CoarseSystemClock::rep> system_now_;
+  std::atomic<CoarseSteadyClock::rep> steady_now_;
+  bool refreshing_;
+};
+
+// Deliberately leaked along with its detached thread, so that the coarse clocks remain usable
+// during static destruction (e.g. by logging).
+const CoarseTime& GetCoarseTime() {
+  static const CoarseTime* const coarse_time(new CoarseTime);
+  return *coarse_time;
+}
+
+}  // unnamed namespace
+
 Clock::time_point Clock::now() MAIDSAFE_NOEXCEPT {
   auto time_now = std::chrono::system_clock::now();
 // Assumes that system_clock uses 1970-01-01 as epoch
@@ -35,4 +187,12 @@ std::time_t Clock::to_time_t(const time_point& t) {
 
 Clock::time_point Clock::from_time_t(std::time_t t) { return time_point(std::chrono::seconds(t)); }
 
+CoarseSystemClock::time_point CoarseSystemClock::now() MAIDSAFE_NOEXCEPT {
+  return GetCoarseTime().SystemNow();
+}
+
+CoarseSteadyClock::time_point CoarseSteadyClock::now() MAIDSAFE_NOEXCEPT {
+  return GetCoarseTime().SteadyNow();
+}
+
 }  // namespace maidsafe
@@ -0,0 +1,100 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/arena.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ArenaTest, BEH_MonotonicArena) {
+  MonotonicArena arena(256);
+  EXPECT_EQ(0, arena.bytes_reserved());
+  for (size_t alignment(1); alignment <= 64; alignment *= 2) {
+    void* const ptr(arena.Allocate(3, alignment));
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(ptr) % alignment);
+  }
+  // Larger than the current block size
+  char* const big(static_cast<char*>(arena.Allocate(10000, 8)));
+  big[0] = big[9999] = 'x';
+  const size_t reserved(arena.bytes_reserved());
+  EXPECT_GT(reserved, 10000U);
+  arena.Deallocate(big, 10000, 8);
+  EXPECT_EQ(reserved, arena.bytes_reserved());
+  arena.Release();
+  EXPECT_EQ(0, arena.bytes_reserved());
+  EXPECT_NE(nullptr, arena.Allocate(16, 16));
+}
+
+TEST(ArenaTest, BEH_PooledArena) {
+  PooledArena arena(64);
+  void* const small(arena.Allocate(24, 8));
+  arena.Deallocate(small, 24, 8);
+  // Same size class
+  EXPECT_EQ(small, arena.Allocate(32, 16));
+  EXPECT_NE(small, arena.Allocate(24, 8));
+  const size_t reserved(arena.bytes_reserved());
+  // Too large to be pooled
+  void* const large(arena.Allocate(65, 8));
+  EXPECT_EQ(reserved, arena.bytes_reserved());
+  arena.Deallocate(large, 65, 8);
+}
+
+TEST(ArenaTest, BEH_ArenaAllocator) {
+  PooledArena arena;
+  using Allocator = ArenaAllocator<std::pair<const int, int>>;
+  std::map<int, int, std::less<int>, Allocator> map{std::less<int>(), Allocator(arena)};
+  std::list<int, ArenaAllocator<int>> list{ArenaAllocator<int>(arena)};
+  EXPECT_TRUE(map.get_allocator() == list.get_allocator());
+  EXPECT_FALSE(map.get_allocator() == ArenaAllocator<int>());
+
+  for (int i(0); i < 1000; ++i) {
+    map.emplace(i, i);
+    list.push_back(i);
+  }
+  const size_t reserved(arena.bytes_reserved());
+  for (int round(0); round < 10; ++round) {
+    for (int i(0); i < 1000; ++i) {
+      map.erase(i);
+      map.emplace(i, i);
+      list.pop_front();
+      list.push_back(i);
+    }
+  }
+  EXPECT_EQ(1000U, map.size());
+  EXPECT_EQ(1000U, list.size());
+  EXPECT_EQ(reserved, arena.bytes_reserved());
+
+  MonotonicArena monotonic_arena;
+  std::vector<int, ArenaAllocator<int, MonotonicArena>> vector{
+      ArenaAllocator<int, MonotonicArena>(monotonic_arena)};
+  for (int i(0); i < 1000; ++i)
+    vector.push_back(i);
+  EXPECT_EQ(999, vector.back());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
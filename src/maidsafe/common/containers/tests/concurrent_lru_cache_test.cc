@@ -0,0 +1,199 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/concurrent_lru_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ConcurrentLruCacheTest, BEH_InvalidShardCount) {
+  using Cache = ConcurrentLruCache<int, int>;
+  EXPECT_THROW(Cache(0, 10), common_error);
+  EXPECT_THROW(Cache(0, std::chrono::milliseconds(100)), common_error);
+  EXPECT_THROW(Cache(0, 10, std::chrono::milliseconds(100)), common_error);
+}
+
+TEST(ConcurrentLruCacheTest, BEH_SizeOnly) {
+  const size_t shard_count(4), capacity(10);
+  ConcurrentLruCache<int, int> cache(shard_count, capacity);
+  EXPECT_EQ(shard_count, cache.shard_count());
+
+  for (int i(0); i < 1000; ++i)
+    cache.Add(i, i);
+
+  // Each shard is individually bounded, so the total can never exceed shard_count * capacity.
+  EXPECT_LE(cache.size(), shard_count * capacity);
+  EXPECT_GT(cache.size(), 0U);
+  EXPECT_TRUE(cache.Check(999));
+  ASSERT_TRUE(cache.Get(999).valid());
+  EXPECT_EQ(999, cache.Get(999).value());
+  EXPECT_FALSE(cache.Get(-1).valid());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Delete) {
+  ConcurrentLruCache<int, int> cache(8, 100);
+  for (int i(0); i < 50; ++i)
+    cache.Add(i, i);
+  EXPECT_EQ(50U, cache.size());
+
+  for (int i(0); i < 50; ++i) {
+    cache.Delete(i);
+    EXPECT_FALSE(cache.Check(i));
+  }
+  EXPECT_EQ(0U, cache.size());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_TimeOnly) {
+  std::chrono::milliseconds time(100);
+  ConcurrentLruCache<int, int> cache(1, time);
+
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, i);
+  EXPECT_EQ(10U, cache.size());
+  std::this_thread::sleep_for(time);
+  cache.Add(11, 11);
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Purge) {
+  std::chrono::milliseconds time(100);
+  ConcurrentLruCache<int, int> cache(4, time);
+
+  for (int i(0); i < 20; ++i)
+    cache.Add(i, i);
+  EXPECT_EQ(0U, cache.Purge());
+  std::this_thread::sleep_for(time);
+  EXPECT_EQ(5U, cache.Purge(5));
+  EXPECT_EQ(15U, cache.size());
+  EXPECT_EQ(15U, cache.Purge());
+  EXPECT_EQ(0U, cache.size());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_HitRate) {
+  ConcurrentLruCache<int, int> cache(4, 100);
+  EXPECT_EQ(0.0, cache.HitRate());
+
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, i);
+  for (int i(0); i < 20; ++i)
+    cache.Get(i);
+
+  EXPECT_EQ(10U, cache.hits());
+  EXPECT_EQ(10U, cache.misses());
+  EXPECT_DOUBLE_EQ(0.5, cache.HitRate());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Visit) {
+  ConcurrentLruCache<int, std::string> cache(4, 10);
+  cache.Add(0, "zero");
+
+  std::string copy;
+  EXPECT_TRUE(cache.Visit(0, [&](const std::string& value) { copy = value; }));
+  EXPECT_EQ("zero", copy);
+  EXPECT_FALSE(cache.Visit(1, [](const std::string&) { FAIL(); }));
+  EXPECT_EQ(1U, cache.hits());
+  EXPECT_EQ(1U, cache.misses());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_FilterTimeAndSize) {
+  std::chrono::milliseconds time(100);
+  const size_t shard_count(4), capacity(10);
+  ConcurrentLruCache<int, void> filter(shard_count, capacity, time);
+
+  for (int i(0); i < 1000; ++i)
+    filter.Add(i);
+  EXPECT_LE(filter.size(), shard_count * capacity);
+  EXPECT_TRUE(filter.Check(999));
+  EXPECT_EQ(1U, filter.hits());
+
+  std::this_thread::sleep_for(time);
+  for (int i(0); i < 1000; ++i)
+    filter.Add(i + 1000);
+  EXPECT_FALSE(filter.Check(999));
+  EXPECT_EQ(1U, filter.misses());
+}
+
+TEST(ConcurrentLruCacheTest, BEH_Parallel) {
+  const int thread_count(8), ops_per_thread(1000);
+  ConcurrentLruCache<int, int> cache(16, 1000);
+  std::atomic<int> thread_index(0);
+
+  RunInParallel(thread_count, [&] {
+    const int offset(thread_index++ * ops_per_thread);
+    for (int i(0); i < ops_per_thread; ++i) {
+      const int key(offset + i);
+      cache.Add(key, key);
+      auto result(cache.Get(key));
+      if (result.valid()) {
+        EXPECT_EQ(key, result.value());
+      }
+      if ((i % 3) == 0)
+        cache.Delete(key);
+    }
+  });
+
+  EXPECT_EQ(static_cast<std::uint64_t>(thread_count * ops_per_thread),
+            cache.hits() + cache.misses());
+  EXPECT_LE(cache.size(), 16U * 1000U);
+}
+
+TEST(ConcurrentLruCacheTest, BEH_ParallelTimed) {
+  const int thread_count(4), ops_per_thread(1000);
+  ConcurrentLruCache<int, int> cache(16, 1000);
+
+  const ParallelRunResult result(RunInParallelTimed(thread_count, [&](int thread_index) {
+    const int offset(thread_index * ops_per_thread);
+    std::uint64_t operations(0);
+    for (int i(0); i < ops_per_thread; ++i) {
+      const int key(offset + i);
+      cache.Add(key, key);
+      auto value(cache.Get(key));
+      if (value.valid()) {
+        EXPECT_EQ(key, value.value());
+      }
+      operations += 2;
+    }
+    return operations;
+  }, true));
+  result.Report("ConcurrentLruCache Add+Get");
+
+  ASSERT_EQ(static_cast<std::size_t>(thread_count), result.threads.size());
+  for (const auto& thread : result.threads) {
+    EXPECT_EQ(static_cast<std::uint64_t>(ops_per_thread * 2), thread.operations);
+    EXPECT_LE(thread.duration, result.wall_time);
+  }
+  EXPECT_EQ(static_cast<std::uint64_t>(thread_count * ops_per_thread * 2),
+            result.TotalOperations());
+  EXPECT_EQ(static_cast<std::uint64_t>(thread_count * ops_per_thread),
+            cache.hits() + cache.misses());
+  EXPECT_GT(result.OperationsPerSecond(), 0.0);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,104 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/count_min_sketch.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(CountMinSketchTest, BEH_Estimates) {
+  CountMinSketch<std::string> sketch(1000, 1000000);
+  EXPECT_EQ(sketch.width(), 1024);
+  EXPECT_EQ(sketch.Estimate("absent"), 0);
+
+  for (int i(0); i < 100; ++i)
+    sketch.Increment("hot");
+  for (int i(0); i < 1000; ++i)
+    sketch.Increment(std::to_string(i));
+
+  // Never under-estimates
+  EXPECT_GE(sketch.Estimate("hot"), 100);
+  EXPECT_LT(sketch.Estimate("hot"), 110);
+  int over_estimates(0);
+  for (int i(0); i < 1000; ++i) {
+    const unsigned estimate(sketch.Estimate(std::to_string(i)));
+    EXPECT_GE(estimate, 1);
+    if (estimate > 1)
+      ++over_estimates;
+  }
+  EXPECT_LT(over_estimates, 50);
+}
+
+TEST(CountMinSketchTest, BEH_SaturatesAndAges) {
+  CountMinSketch<int> sketch(16, 1000);
+  for (int i(0); i < 300; ++i)
+    sketch.Increment(1);
+  EXPECT_EQ(sketch.Estimate(1), 255);
+
+  sketch.Age();
+  EXPECT_EQ(sketch.Estimate(1), 127);
+
+  // Reaching the sample size triggers ageing automatically
+  sketch.Clear();
+  EXPECT_EQ(sketch.Estimate(1), 0);
+  for (int i(0); i < 999; ++i)
+    sketch.Increment(2);
+  EXPECT_EQ(sketch.Estimate(2), 255);
+  sketch.Increment(2);
+  EXPECT_EQ(sketch.Estimate(2), 127);
+}
+
+TEST(CountMinSketchTest, BEH_Concurrent) {
+  ConcurrentCountMinSketch<int> sketch(1000);
+  EXPECT_EQ(sketch.width(), 1024);
+  EXPECT_EQ(sketch.Estimate(1), 0);
+  EXPECT_EQ(sketch.Increment(1), 1);
+
+  std::vector<std::thread> threads;
+  for (int i(0); i < 4; ++i) {
+    threads.emplace_back([&sketch] {
+      for (int j(0); j < 1000; ++j) {
+        sketch.Increment(1);
+        sketch.Increment(j + 2);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  // Never under-estimates
+  EXPECT_GE(sketch.Estimate(1), 4001);
+  EXPECT_LT(sketch.Estimate(1), 4100);
+  EXPECT_GE(sketch.Estimate(2), 4);
+
+  sketch.Age();
+  EXPECT_GE(sketch.Estimate(1), 2000);
+  EXPECT_LT(sketch.Estimate(1), 2050);
+  sketch.Clear();
+  EXPECT_EQ(sketch.Estimate(1), 0);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,222 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/flat_hash_map.h"
+#include "maidsafe/common/containers/flat_hash_set.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+// Sends every key to one of three home slots, so that long probe sequences are exercised.
+struct CollidingHash {
+  std::uint64_t operator()(int key) const { return static_cast<std::uint64_t>(key % 3); }
+};
+
+}  // unnamed namespace
+
+TEST(FlatHashMapTest, BEH_InsertFindErase) {
+  FlatHashMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0, map.bucket_count());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(1) == map.end());
+
+  EXPECT_TRUE(map.insert(std::make_pair(1, std::string("one"))).second);
+  EXPECT_FALSE(map.insert(std::make_pair(1, std::string("uno"))).second);
+  EXPECT_TRUE(map.try_emplace(2, "two").second);
+  EXPECT_FALSE(map.try_emplace(2, "dos").second);
+  map[3] = "three";
+  EXPECT_FALSE(map.insert_or_assign(3, "tres").second);
+  EXPECT_TRUE(map.emplace(4, "four").second);
+
+  EXPECT_EQ(4, map.size());
+  EXPECT_EQ("one", map.at(1));
+  EXPECT_EQ("two", map.at(2));
+  EXPECT_EQ("tres", map.at(3));
+  EXPECT_EQ("four", map.find(4)->second);
+  EXPECT_THROW(map.at(5), maidsafe_error);
+  EXPECT_EQ(1, map.count(1));
+  EXPECT_EQ(0, map.count(5));
+
+  EXPECT_EQ(1, map.erase(1));
+  EXPECT_EQ(0, map.erase(1));
+  EXPECT_EQ(3, map.size());
+  EXPECT_TRUE(map.find(1) == map.end());
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  map[1] = "one";
+  EXPECT_EQ(1, map.size());
+}
+
+TEST(FlatHashMapTest, BEH_MatchesUnorderedMap) {
+  FlatHashMap<int, int> map;
+  std::unordered_map<int, int> expected;
+  for (int i(0); i != 100000; ++i) {
+    const int key(static_cast<int>(RandomUint32() % 2000));
+    switch (RandomUint32() % 3) {
+      case 0:
+        map[key] = i;
+        expected[key] = i;
+        break;
+      case 1:
+        ASSERT_EQ(expected.erase(key), map.erase(key));
+        break;
+      default: {
+        const auto found(map.find(key));
+        const auto expected_found(expected.find(key));
+        ASSERT_EQ(expected_found == expected.end(), found == map.end());
+        if (found != map.end()) {
+          ASSERT_EQ(expected_found->second, found->second);
+        }
+      }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+
+  std::size_t count(0);
+  for (const auto& element : map) {
+    EXPECT_EQ(expected.at(element.first), element.second);
+    ++count;
+  }
+  EXPECT_EQ(expected.size(), count);
+}
+
+TEST(FlatHashMapTest, BEH_CollidingKeys) {
+  FlatHashMap<int, int, CollidingHash> map;
+  for (int i(0); i != 1000; ++i)
+    map[i] = i;
+  for (int i(0); i != 1000; i += 2)
+    EXPECT_EQ(1, map.erase(i));
+  for (int i(0); i != 1000; ++i)
+    EXPECT_EQ(i % 2, map.count(i));
+  for (int i(0); i != 1000; i += 2)
+    map[i] = i;
+  EXPECT_EQ(1000, map.size());
+}
+
+TEST(FlatHashMapTest, BEH_EraseWhileIterating) {
+  FlatHashMap<int, int> map;
+  for (int i(0); i != 1000; ++i)
+    map[i] = i;
+  for (auto itr(map.begin()); itr != map.end();) {
+    if (itr->first % 3 == 0)
+      itr = map.erase(itr);
+    else
+      ++itr;
+  }
+  EXPECT_EQ(666, map.size());
+  for (const auto& element : map)
+    EXPECT_NE(0, element.first % 3);
+}
+
+TEST(FlatHashMapTest, BEH_ReserveAndChurn) {
+  FlatHashMap<int, int> map;
+  map.reserve(1000);
+  const auto bucket_count(map.bucket_count());
+  for (int i(0); i != 1000; ++i)
+    map[i] = i;
+  EXPECT_EQ(bucket_count, map.bucket_count());
+
+  // Repeatedly inserting and erasing shouldn't grow the table without bound.
+  FlatHashMap<int, int> churned;
+  for (int i(0); i != 100000; ++i) {
+    churned[i] = i;
+    if (i >= 50)
+      churned.erase(i - 50);
+  }
+  EXPECT_EQ(50, churned.size());
+  EXPECT_GE(255, churned.bucket_count());
+}
+
+TEST(FlatHashMapTest, BEH_CopyMoveAndSwap) {
+  FlatHashMap<int, std::string> map;
+  for (int i(0); i != 100; ++i)
+    map[i] = std::to_string(i);
+
+  FlatHashMap<int, std::string> copy(map);
+  EXPECT_TRUE(copy == map);
+  copy[0] = "changed";
+  EXPECT_TRUE(copy != map);
+
+  FlatHashMap<int, std::string> moved(std::move(copy));
+  EXPECT_TRUE(copy.empty());  // NOLINT
+  EXPECT_EQ("changed", moved.at(0));
+
+  FlatHashMap<int, std::string> other;
+  other = map;
+  EXPECT_TRUE(other == map);
+  swap(other, moved);
+  EXPECT_EQ("changed", other.at(0));
+  EXPECT_EQ("0", moved.at(0));
+}
+
+TEST(FlatHashMapTest, BEH_MoveOnlyValues) {
+  FlatHashMap<int, std::unique_ptr<int>> map;
+  for (int i(0); i != 100; ++i)
+    map.try_emplace(i, new int(i));
+  for (int i(0); i != 100; ++i)
+    EXPECT_EQ(i, *map.at(i));
+}
+
+TEST(FlatHashMapTest, BEH_IdentityKeys) {
+  std::vector<Identity> ids;
+  FlatHashMap<Identity, std::size_t> map;
+  for (std::size_t i(0); i != 1000; ++i) {
+    ids.push_back(MakeIdentity());
+    EXPECT_TRUE(map.try_emplace(ids.back(), i).second);
+  }
+  for (std::size_t i(0); i != ids.size(); ++i)
+    EXPECT_EQ(i, map.at(ids[i]));
+  EXPECT_TRUE(map.find(MakeIdentity()) == map.end());
+}
+
+TEST(FlatHashSetTest, BEH_InsertFindErase) {
+  FlatHashSet<std::string> set{"one", "two", "three", "two"};
+  EXPECT_EQ(3, set.size());
+  EXPECT_EQ(1, set.count("one"));
+  EXPECT_FALSE(set.insert("one").second);
+  EXPECT_TRUE(set.insert("four").second);
+  EXPECT_EQ(1, set.erase("two"));
+  EXPECT_TRUE(set.find("two") == set.end());
+  EXPECT_EQ(3, set.size());
+
+  FlatHashSet<Identity> ids;
+  const Identity id(MakeIdentity());
+  EXPECT_TRUE(ids.insert(id).second);
+  EXPECT_EQ(1, ids.count(id));
+  EXPECT_EQ(0, ids.count(MakeIdentity()));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,102 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/hot_key_tracker.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(HotKeyTrackerTest, BEH_SpaceSaving) {
+  SpaceSaving<std::string> summary(8);
+  EXPECT_TRUE(summary.Top(4).empty());
+  // Heavy hitters interleaved with many keys seen only once.
+  for (int i(0); i < 100; ++i) {
+    summary.Add("hot");
+    if (i % 2 == 0)
+      summary.Add("warm");
+    summary.Add(std::to_string(i));
+  }
+  EXPECT_EQ(8U, summary.size());
+  const auto top(summary.Top(2));
+  ASSERT_EQ(2U, top.size());
+  EXPECT_EQ("hot", top[0].key);
+  EXPECT_EQ("warm", top[1].key);
+  // Counts never under-estimate, and over-estimate by at most the error.
+  EXPECT_GE(top[0].count, 100U);
+  EXPECT_LE(top[0].count - top[0].error, 100U);
+  EXPECT_GE(top[1].count, 50U);
+  EXPECT_LE(top[1].count - top[1].error, 50U);
+  EXPECT_EQ(8U, summary.Top(10).size());
+
+  summary.Age();
+  EXPECT_EQ(top[0].count / 2, summary.Top(1)[0].count);
+  summary.Clear();
+  EXPECT_EQ(0U, summary.size());
+}
+
+TEST(HotKeyTrackerTest, BEH_ConcurrentRecording) {
+  HotKeyTracker<int> tracker(2);
+  std::vector<std::thread> threads;
+  for (int i(0); i < 4; ++i) {
+    threads.emplace_back([&tracker, i] {
+      for (int j(0); j < 1000; ++j) {
+        tracker.Record(0);
+        if (j % 4 == 0)
+          tracker.Record(1);
+        tracker.Record(1000 * (i + 1) + j);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  const auto hot_keys(tracker.Snapshot());
+  ASSERT_EQ(2U, hot_keys.size());
+  EXPECT_EQ(0, hot_keys[0].key);
+  EXPECT_GE(hot_keys[0].count, 4000U);
+  EXPECT_EQ(1, hot_keys[1].key);
+  EXPECT_GE(hot_keys[1].count, 1000U);
+  EXPECT_GE(tracker.Estimate(0), 4000U);
+  EXPECT_LT(tracker.Estimate(1500), 10U);
+
+  tracker.Clear();
+  EXPECT_TRUE(tracker.Snapshot().empty());
+  EXPECT_EQ(0U, tracker.Estimate(0));
+}
+
+TEST(HotKeyTrackerTest, BEH_Ageing) {
+  HotKeyTracker<int> tracker(2, 16, 100);
+  auto observer(tracker.Observer());
+  for (int i(0); i < 99; ++i)
+    observer(7);
+  EXPECT_EQ(99U, tracker.Snapshot()[0].count);
+  observer(7);
+  EXPECT_EQ(50U, tracker.Snapshot()[0].count);
+  EXPECT_EQ(50U, tracker.Estimate(7));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,151 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/interned.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/flat_hash_map.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+// Gives each test its own table, since the table is shared by all handles of the same type.
+template <int Tag>
+struct TaggedStringHash {
+  std::uint64_t operator()(const std::string& value) const {
+    return std::hash<std::string>()(value);
+  }
+};
+
+}  // unnamed namespace
+
+TEST(InternedTest, BEH_EqualValuesShareAnId) {
+  using InternedString = Interned<std::string, TaggedStringHash<0>>;
+  EXPECT_EQ(0, InternedString::InternedCount());
+  const InternedString null;
+  EXPECT_TRUE(null.IsNull());
+
+  const InternedString first(std::string("first"));
+  const InternedString first_again(std::string("first"));
+  const InternedString second(std::string("second"));
+  EXPECT_FALSE(first.IsNull());
+  EXPECT_EQ(first, first_again);
+  EXPECT_EQ(first.Id(), first_again.Id());
+  EXPECT_NE(first, second);
+  EXPECT_NE(first, null);
+  EXPECT_EQ("first", first.get());
+  EXPECT_EQ("second", *second);
+  EXPECT_EQ(6U, second->size());
+  EXPECT_EQ(&first.get(), &first_again.get());
+  EXPECT_EQ(2, InternedString::InternedCount());
+
+  std::unordered_set<InternedString> set{first, first_again, second};
+  EXPECT_EQ(2, set.size());
+}
+
+TEST(InternedTest, BEH_ValueReleasedWithLastHandle) {
+  using InternedString = Interned<std::string, TaggedStringHash<1>>;
+  std::uint32_t id(0);
+  {
+    InternedString original(std::string("value"));
+    id = original.Id();
+    InternedString copy(original);
+    InternedString moved(std::move(original));
+    EXPECT_TRUE(original.IsNull());
+    EXPECT_EQ(copy, moved);
+    InternedString assigned;
+    assigned = copy;
+    EXPECT_EQ(copy, assigned);
+    copy = InternedString();
+    EXPECT_EQ(1, InternedString::InternedCount());
+  }
+  EXPECT_EQ(0, InternedString::InternedCount());
+
+  // The freed ID is reused for the next new value.
+  const InternedString other(std::string("other"));
+  EXPECT_EQ(id, other.Id());
+  EXPECT_EQ("other", other.get());
+  EXPECT_EQ(1, InternedString::InternedCount());
+}
+
+TEST(InternedTest, BEH_ManyValues) {
+  using InternedString = Interned<std::string, TaggedStringHash<2>>;
+  // Enough values to span several of the table's chunks.
+  const std::size_t kCount(10000);
+  std::vector<InternedString> handles;
+  for (std::size_t i(0); i != kCount; ++i)
+    handles.emplace_back(std::to_string(i));
+  EXPECT_EQ(kCount, InternedString::InternedCount());
+  for (std::size_t i(0); i != kCount; ++i) {
+    EXPECT_EQ(std::to_string(i), handles[i].get());
+    EXPECT_EQ(handles[i], InternedString(std::to_string(i)));
+  }
+  handles.erase(handles.begin(), handles.begin() + kCount / 2);
+  EXPECT_EQ(kCount / 2, InternedString::InternedCount());
+  handles.clear();
+  EXPECT_EQ(0, InternedString::InternedCount());
+}
+
+TEST(InternedTest, FUNC_ConcurrentAcquireAndRelease) {
+  using InternedString = Interned<std::string, TaggedStringHash<3>>;
+  std::vector<std::thread> threads;
+  for (int i(0); i != 8; ++i) {
+    threads.emplace_back([] {
+      std::vector<InternedString> handles;
+      for (int j(0); j != 20000; ++j) {
+        handles.emplace_back(std::to_string(j % 100));
+        ASSERT_EQ(std::to_string(j % 100), handles.back().get());
+        if (handles.size() == 50)
+          handles.clear();
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(0, InternedString::InternedCount());
+}
+
+TEST(InternedTest, BEH_NameAndTypeIdKeys) {
+  using InternedKey = Interned<Data::NameAndTypeId>;
+  const Data::NameAndTypeId key(MakeIdentity(), DataTypeId(1));
+  FlatHashMap<InternedKey, int> map;
+  map[InternedKey(key)] = 1;
+  map[InternedKey(Data::NameAndTypeId(MakeIdentity(), DataTypeId(2)))] = 2;
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(1, map.at(InternedKey(key)));
+  EXPECT_EQ(key, map.find(InternedKey(key))->first.get());
+  EXPECT_EQ(4U, sizeof(InternedKey));
+  map.clear();
+  EXPECT_EQ(0, InternedKey::InternedCount());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -19,7 +19,11 @@
 #include "maidsafe/common/containers/lru_cache.h"
 
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/identity.h"
@@ -180,6 +184,195 @@ TEST(LruCacheTest, BEH_TimeAndSizeStructValueTest) {
   }
 }
 
+TEST(LruCacheTest, BEH_Purge) {
+  std::chrono::milliseconds time(100);
+  LruCache<int, int> cache(time);
+
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, i);
+  EXPECT_EQ(cache.Purge(), 0);
+  std::this_thread::sleep_for(time);
+
+  EXPECT_EQ(cache.Purge(4), 4);
+  EXPECT_EQ(cache.size(), 6);
+  EXPECT_FALSE(cache.Check(3));
+  EXPECT_TRUE(cache.Check(4));
+  EXPECT_EQ(cache.Purge(), 6);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(LruCacheTest, BEH_Evict) {
+  LruCache<int, int> cache(10);
+
+  for (int i(0); i < 5; ++i)
+    cache.Add(i, i);
+  EXPECT_TRUE(cache.Get(0).valid());
+
+  EXPECT_EQ(cache.Evict(2), 2);
+  EXPECT_EQ(cache.size(), 3);
+  EXPECT_EQ(cache.stats().evictions, 2);
+  EXPECT_TRUE(cache.Check(0));
+  EXPECT_FALSE(cache.Check(1));
+  EXPECT_FALSE(cache.Check(2));
+  EXPECT_TRUE(cache.Check(3));
+  EXPECT_EQ(cache.Evict(10), 3);
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.Evict(1), 0);
+}
+
+TEST(LruCacheTest, BEH_CoarseClock) {
+  std::chrono::milliseconds time(100);
+  LruCache<int, void> filter(time);
+  // Only rely on explicit refreshes of the clock
+  filter.SetClockRefreshInterval(std::numeric_limits<size_t>::max());
+
+  for (int i(0); i < 10; ++i)
+    filter.Add(i);
+  std::this_thread::sleep_for(time);
+
+  // The cached time hasn't moved on, so nothing has expired yet
+  filter.Add(10);
+  EXPECT_EQ(filter.size(), 11);
+  EXPECT_EQ(filter.Purge(), 0);
+
+  filter.RefreshClock();
+  EXPECT_EQ(filter.Purge(), 11);
+  EXPECT_EQ(filter.size(), 0);
+
+  // Refresh every 5 operations
+  filter.SetClockRefreshInterval(5);
+  for (int i(0); i < 10; ++i)
+    filter.Add(i);
+  std::this_thread::sleep_for(time);
+  for (int i(10); i < 16; ++i)
+    filter.Add(i);
+  EXPECT_LT(filter.size(), 16);
+
+  // The shared coarse clock needs no explicit refreshing
+  filter.UseSharedCoarseClock();
+  filter.Purge();
+  for (int i(0); i < 10; ++i)
+    filter.Add(i);
+  EXPECT_EQ(filter.size(), 10);
+  std::this_thread::sleep_for(2 * time);
+  EXPECT_EQ(filter.Purge(), 10);
+}
+
+TEST(LruCacheTest, BEH_Stats) {
+  std::chrono::milliseconds time(100);
+  LruCache<int, int> cache(5, time);
+
+  for (int i(0); i < 10; ++i)
+    cache.Add(i, i);
+  for (int i(0); i < 10; ++i)
+    cache.Get(i);
+  EXPECT_TRUE(cache.Check(9));
+
+  auto stats(cache.stats());
+  EXPECT_EQ(stats.hits, 6);
+  EXPECT_EQ(stats.misses, 5);
+  EXPECT_EQ(stats.evictions, 5);
+  EXPECT_EQ(stats.expirations, 0);
+
+  std::this_thread::sleep_for(time);
+  cache.Purge();
+  stats = cache.stats();
+  EXPECT_EQ(stats.evictions, 5);
+  EXPECT_EQ(stats.expirations, 5);
+}
+
+namespace {
+
+struct Span {
+  const char* data;
+  size_t size;
+};
+
+bool operator<(const Span& lhs, const std::string& rhs) {
+  return rhs.compare(0, std::string::npos, lhs.data, lhs.size) > 0;
+}
+
+bool operator<(const std::string& lhs, const Span& rhs) {
+  return lhs.compare(0, std::string::npos, rhs.data, rhs.size) < 0;
+}
+
+}  // unnamed namespace
+
+TEST(LruCacheTest, BEH_HeterogeneousLookup) {
+  LruCache<std::string, int> cache(10);
+  cache.Add("one", 1);
+  cache.Add("two", 2);
+  cache.Add("three", 3);
+
+  EXPECT_TRUE(cache.Check("one"));
+  EXPECT_FALSE(cache.Check("four"));
+  ASSERT_TRUE(cache.Get("two").valid());
+  EXPECT_EQ(2, cache.Get("two").value());
+
+  const char buffer[] = "three-and-more";
+  const Span span = {buffer, 5};
+  EXPECT_TRUE(cache.Check(span));
+  ASSERT_TRUE(cache.Get(span).valid());
+  EXPECT_EQ(3, cache.Get(span).value());
+  cache.Delete(span);
+  EXPECT_FALSE(cache.Check(std::string("three")));
+  EXPECT_EQ(2U, cache.size());
+
+  cache.Delete("one");
+  EXPECT_FALSE(cache.Get(std::string("one")).valid());
+  EXPECT_EQ(1U, cache.size());
+
+  LruCache<std::string, void> filter(10);
+  filter.Add("one");
+  EXPECT_TRUE(filter.Check("one"));
+  EXPECT_FALSE(filter.Check(Span{buffer, 0}));
+}
+
+TEST(LruCacheTest, BEH_Visit) {
+  LruCache<int, std::string> cache(2);
+  cache.Add(0, "zero");
+  cache.Add(1, "one");
+
+  const std::string* visited(nullptr);
+  EXPECT_TRUE(cache.Visit(0, [&](const std::string& value) { visited = &value; }));
+  ASSERT_NE(nullptr, visited);
+  EXPECT_EQ("zero", *visited);
+  EXPECT_FALSE(cache.Visit(2, [](const std::string&) { FAIL(); }));
+
+  // The visit counts as a use, so 1 rather than 0 is evicted here.
+  cache.Add(2, "two");
+  EXPECT_TRUE(cache.Check(0));
+  EXPECT_FALSE(cache.Check(1));
+  EXPECT_EQ(2, cache.stats().hits);
+  EXPECT_EQ(2, cache.stats().misses);
+
+  // Shared values are not copied by Get.
+  LruCache<int, std::shared_ptr<const std::string>> shared_cache(2);
+  const auto value(std::make_shared<const std::string>(1024, 'a'));
+  shared_cache.Add(0, value);
+  auto result(shared_cache.Get(0));
+  ASSERT_TRUE(result.valid());
+  EXPECT_EQ(value.get(), result.value().get());
+}
+
+TEST(LruCacheTest, BEH_LookupObserver) {
+  LruCache<std::string, int> cache(10);
+  std::vector<std::string> observed;
+  cache.SetLookupObserver([&](const std::string& key) { observed.push_back(key); });
+  cache.Add("one", 1);
+  EXPECT_TRUE(cache.Get("one").valid());
+  EXPECT_FALSE(cache.Get(std::string("two")).valid());
+  EXPECT_TRUE(cache.Visit(std::string("one"), [](int) {}));
+  // A miss by probe type can't be reported, and Check isn't observed.
+  EXPECT_FALSE(cache.Get("three").valid());
+  EXPECT_TRUE(cache.Check("one"));
+  EXPECT_EQ((std::vector<std::string>{"one", "two", "one"}), observed);
+
+  cache.SetLookupObserver(nullptr);
+  EXPECT_TRUE(cache.Get("one").valid());
+  EXPECT_EQ(3U, observed.size());
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
@@ -0,0 +1,149 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/pooled_lru_cache.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(PooledLruCacheTest, BEH_SizeOnly) {
+  const int size(10);
+  PooledLruCache<int, int> cache(size);
+
+  for (int i(0); i < size; ++i) {
+    EXPECT_EQ(i, cache.size());
+    cache.Add(i, i);
+    EXPECT_EQ(i + 1, cache.size());
+  }
+
+  for (int i(size); i < 1000; ++i) {
+    cache.Add(i, i);
+    EXPECT_EQ(size, cache.size());
+    // Only the most recent 'size' keys should remain
+    EXPECT_FALSE(cache.Check(i - size));
+    EXPECT_TRUE(cache.Check(i - size + 1));
+  }
+
+  for (int i(1000 - size); i < 1000; ++i) {
+    ASSERT_TRUE(cache.Get(i).valid());
+    EXPECT_EQ(i, cache.Get(i).value());
+  }
+}
+
+TEST(PooledLruCacheTest, BEH_GetRefreshesEntry) {
+  PooledLruCache<int, int> cache(3);
+  cache.Add(0, 0);
+  cache.Add(1, 1);
+  cache.Add(2, 2);
+  // Touch the oldest entry so that key 1 becomes the eviction candidate
+  EXPECT_TRUE(cache.Get(0).valid());
+  cache.Add(3, 3);
+  EXPECT_TRUE(cache.Check(0));
+  EXPECT_FALSE(cache.Check(1));
+  EXPECT_TRUE(cache.Check(2));
+  EXPECT_TRUE(cache.Check(3));
+}
+
+TEST(PooledLruCacheTest, BEH_DuplicateAddIgnored) {
+  PooledLruCache<int, int> cache(10);
+  cache.Add(1, 1);
+  cache.Add(1, 2);
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(1, cache.Get(1).value());
+}
+
+TEST(PooledLruCacheTest, BEH_Delete) {
+  const int size(100);
+  PooledLruCache<int, int> cache(size);
+  for (int i(0); i < size; ++i)
+    cache.Add(i, i);
+
+  // Delete every other key so that the hash index has to close gaps between colliding entries
+  for (int i(0); i < size; i += 2) {
+    cache.Delete(i);
+    EXPECT_FALSE(cache.Get(i).valid());
+  }
+  EXPECT_EQ(size / 2, cache.size());
+  for (int i(1); i < size; i += 2) {
+    ASSERT_TRUE(cache.Get(i).valid());
+    EXPECT_EQ(i, cache.Get(i).value());
+  }
+
+  for (int i(1); i < size; i += 2)
+    cache.Delete(i);
+  EXPECT_EQ(0, cache.size());
+
+  // Slots and pooled nodes should be reusable after deletion
+  for (int i(0); i < size * 2; ++i)
+    cache.Add(i, i);
+  EXPECT_EQ(size, cache.size());
+}
+
+TEST(PooledLruCacheTest, BEH_TimeOnly) {
+  std::chrono::milliseconds time(100);
+  PooledLruCache<int, int> cache(time);
+
+  for (int i(0); i < 10; ++i) {
+    EXPECT_EQ(i, cache.size());
+    cache.Add(i, i);
+    EXPECT_EQ(i + 1, cache.size());
+  }
+  std::this_thread::sleep_for(time);
+  cache.Add(11, 11);
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(PooledLruCacheTest, BEH_FilterTimeAndSize) {
+  std::chrono::milliseconds time(100);
+  const int size(10);
+  PooledLruCache<int, void> filter(size, time);
+
+  for (int i(0); i < 1000; ++i) {
+    filter.Add(i);
+    EXPECT_EQ(i < size ? i + 1 : size, filter.size());
+  }
+  std::this_thread::sleep_for(time);
+  filter.Add(1);
+  EXPECT_EQ(1, filter.size());
+}
+
+TEST(PooledLruCacheTest, BEH_NonTrivialValues) {
+  // Ensure values are destroyed when evicted, deleted and when the cache itself is destroyed
+  auto tracker(std::make_shared<int>(0));
+  {
+    PooledLruCache<std::string, std::shared_ptr<int>> cache(50);
+    for (int i(0); i < 200; ++i)
+      cache.Add(std::to_string(i), tracker);
+    EXPECT_EQ(51, tracker.use_count());
+    cache.Delete("199");
+    EXPECT_EQ(50, tracker.use_count());
+  }
+  EXPECT_EQ(1, tracker.use_count());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,92 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/rotating_bloom_filter.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(RotatingBloomFilterTest, BEH_NoFalseNegativesAndFewFalsePositives) {
+  const int count(10000);
+  RotatingBloomFilter<std::string> filter(count, std::chrono::hours(1), 0.01);
+  EXPECT_LT(filter.size_in_bytes(), 2 * count * 2);
+  for (int i(0); i < count; ++i)
+    filter.Add(std::to_string(i));
+  for (int i(0); i < count; ++i)
+    EXPECT_TRUE(filter.Check(std::to_string(i)));
+
+  int false_positives(0);
+  for (int i(count); i < 2 * count; ++i) {
+    if (filter.Check(std::to_string(i)))
+      ++false_positives;
+  }
+  EXPECT_LT(false_positives, count / 50);
+
+  filter.Clear();
+  EXPECT_FALSE(filter.Check("0"));
+}
+
+TEST(RotatingBloomFilterTest, BEH_TimeWindow) {
+  const std::chrono::milliseconds time(100);
+  RotatingBloomFilter<int> filter(100, time);
+  filter.Add(1);
+  EXPECT_TRUE(filter.Check(1));
+
+  // After one window 1 is in the previous generation, so is still present.
+  std::this_thread::sleep_for(time);
+  filter.Add(2);
+  EXPECT_TRUE(filter.Check(1));
+  EXPECT_TRUE(filter.Check(2));
+
+  // After another window 1 has expired, even without a rotation.
+  std::this_thread::sleep_for(time);
+  EXPECT_FALSE(filter.Check(1));
+  EXPECT_TRUE(filter.Check(2));
+  std::this_thread::sleep_for(time);
+  EXPECT_FALSE(filter.Check(2));
+}
+
+TEST(RotatingBloomFilterTest, BEH_RotatesAtCapacity) {
+  RotatingBloomFilter<int> filter(100, std::chrono::hours(1));
+  for (int i(0); i < 200; ++i)
+    filter.Add(i);
+  for (int i(0); i < 200; ++i)
+    EXPECT_TRUE(filter.Check(i));
+
+  // The generation holding 0 to 99 is discarded once the next one is full.
+  filter.Add(200);
+  for (int i(100); i < 201; ++i)
+    EXPECT_TRUE(filter.Check(i));
+  int still_present(0);
+  for (int i(0); i < 100; ++i) {
+    if (filter.Check(i))
+      ++still_present;
+  }
+  EXPECT_LT(still_present, 10);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
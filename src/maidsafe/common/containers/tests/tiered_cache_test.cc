@@ -0,0 +1,239 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/tiered_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+using Cache = TieredCache<int, std::string>;
+
+// A map standing in for the persistent tier.
+struct MapStore {
+  MapStore() : mutex(), values(), fail_puts(false) {}
+
+  Cache::Store store() {
+    Cache::Store result;
+    result.get = [this](const int& key) -> Cache::Result {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto itr(values.find(key));
+      if (itr == values.end())
+        return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+      return itr->second;
+    };
+    result.put = [this](const int& key, const std::string& value) {
+      if (fail_puts)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+      std::lock_guard<std::mutex> lock(mutex);
+      values[key] = value;
+    };
+    result.erase = [this](const int& key) {
+      std::lock_guard<std::mutex> lock(mutex);
+      values.erase(key);
+    };
+    return result;
+  }
+
+  bool Holds(int key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return values.count(key) == 1;
+  }
+
+  std::mutex mutex;
+  std::map<int, std::string> values;
+  std::atomic<bool> fail_puts;
+};
+
+}  // unnamed namespace
+
+TEST(TieredCacheTest, BEH_ReadThrough) {
+  MapStore l2;
+  l2.values[1] = "one";
+  Cache cache(10, std::chrono::seconds(0), l2.store());
+
+  // L2 hits are promoted to L1.
+  ASSERT_TRUE(cache.Get(1).valid());
+  EXPECT_EQ("one", *cache.Get(1));
+  auto stats(cache.stats());
+  EXPECT_EQ(1U, stats.l2_hits);
+  EXPECT_EQ(1U, stats.l1_hits);
+  EXPECT_EQ(1U, cache.size());
+
+  // Without a loader, a key in neither tier is a miss.
+  const auto missing(cache.Get(2));
+  ASSERT_FALSE(missing.valid());
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), missing.error().code());
+  EXPECT_EQ(1U, cache.stats().misses);
+
+  // Loaded values are added to L1 and written back to L2.
+  int load_count(0);
+  auto loader([&load_count](const int& key) -> Cache::Result {
+    ++load_count;
+    return std::to_string(key);
+  });
+  EXPECT_EQ("2", *cache.Get(2, loader));
+  EXPECT_EQ("2", *cache.Get(2, loader));
+  EXPECT_EQ(1, load_count);
+  EXPECT_TRUE(l2.Holds(2));
+  stats = cache.stats();
+  EXPECT_EQ(1U, stats.loads);
+  EXPECT_EQ(1U, stats.write_backs);
+
+  // A failed load is a miss, and isn't cached.
+  auto failing_loader([](const int&) -> Cache::Result {
+    return boost::make_unexpected(MakeError(CommonErrors::unable_to_handle_request));
+  });
+  EXPECT_FALSE(cache.Get(3, failing_loader).valid());
+  EXPECT_EQ(2U, cache.stats().misses);
+  EXPECT_FALSE(l2.Holds(3));
+}
+
+TEST(TieredCacheTest, BEH_AsyncWriteBack) {
+  MapStore l2;
+  std::vector<std::function<void()>> queued;
+  Cache cache(10, std::chrono::seconds(0), l2.store(),
+              [&queued](std::function<void()> functor) { queued.push_back(std::move(functor)); });
+
+  cache.Add(1, "one");
+  EXPECT_EQ("one", *cache.Get(1));
+  EXPECT_FALSE(l2.Holds(1));
+  ASSERT_EQ(1U, queued.size());
+  queued.front()();
+  EXPECT_TRUE(l2.Holds(1));
+
+  // Adding replaces the value held in L1.
+  cache.Add(1, "uno");
+  EXPECT_EQ("uno", *cache.Get(1));
+  ASSERT_EQ(2U, queued.size());
+  queued.back()();
+  EXPECT_EQ("uno", l2.values[1]);
+
+  // Failed write-backs are only counted; the value is still held in L1.
+  l2.fail_puts = true;
+  cache.Add(2, "two");
+  ASSERT_EQ(3U, queued.size());
+  queued.back()();
+  const auto stats(cache.stats());
+  EXPECT_EQ(2U, stats.write_backs);
+  EXPECT_EQ(1U, stats.failed_write_backs);
+  EXPECT_FALSE(l2.Holds(2));
+  EXPECT_EQ("two", *cache.Get(2));
+}
+
+TEST(TieredCacheTest, BEH_SingleFlight) {
+  MapStore l2;
+  Cache cache(10, std::chrono::seconds(0), l2.store());
+  std::promise<void> release;
+  std::shared_future<void> released(release.get_future().share());
+  std::atomic<int> load_count(0);
+  auto loader([&](const int&) -> Cache::Result {
+    ++load_count;
+    released.wait();
+    return std::string("loaded");
+  });
+
+  const int kCallers(8);
+  std::vector<std::future<Cache::Result>> results;
+  for (int i(0); i != kCallers; ++i)
+    results.push_back(std::async(std::launch::async, [&] { return cache.Get(1, loader); }));
+  // Wait until the first caller is loading and the rest are waiting for it.
+  while (load_count == 0 || cache.stats().coalesced != kCallers - 1)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  release.set_value();
+  for (auto& result : results) {
+    auto value(result.get());
+    ASSERT_TRUE(value.valid());
+    EXPECT_EQ("loaded", *value);
+  }
+  EXPECT_EQ(1, load_count);
+  EXPECT_EQ(1U, cache.stats().loads);
+
+  // Exceptions from the loader reach every waiter.
+  auto throwing_loader([](const int&) -> Cache::Result {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  });
+  EXPECT_THROW(cache.Get(2, throwing_loader), maidsafe_error);
+  EXPECT_EQ("3", *cache.Get(3, [](const int&) -> Cache::Result { return std::string("3"); }));
+}
+
+TEST(TieredCacheTest, BEH_Delete) {
+  MapStore l2;
+  Cache cache(10, std::chrono::seconds(0), l2.store());
+  cache.Add(1, "one");
+  cache.Delete(1);
+  EXPECT_FALSE(cache.Get(1).valid());
+  EXPECT_FALSE(l2.Holds(1));
+
+  // A value loaded while its key is deleted is returned, but neither cached nor written back.
+  std::promise<void> loading, release;
+  auto loader([&](const int&) -> Cache::Result {
+    loading.set_value();
+    release.get_future().wait();
+    return std::string("stale");
+  });
+  auto result(std::async(std::launch::async, [&] { return cache.Get(2, loader); }));
+  loading.get_future().wait();
+  cache.Delete(2);
+  release.set_value();
+  EXPECT_EQ("stale", *result.get());
+  EXPECT_EQ(0U, cache.size());
+  EXPECT_FALSE(l2.Holds(2));
+}
+
+TEST(TieredCacheTest, BEH_DataBufferStore) {
+  // Has the parts of DataBuffer's interface used by DataBufferStore.
+  struct Buffer {
+    std::string Get(const int& key) {
+      auto itr(values.find(key));
+      if (itr == values.end())
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+      return itr->second;
+    }
+    void Store(const int& key, const std::string& value) { values[key] = value; }
+    bool TryDelete(const int& key) { return values.erase(key) == 1; }
+    std::map<int, std::string> values;
+  } buffer;
+  buffer.values[1] = "one";
+
+  Cache cache(10, std::chrono::seconds(0), DataBufferStore<int, std::string>(buffer));
+  EXPECT_EQ("one", *cache.Get(1));
+  EXPECT_FALSE(cache.Get(2).valid());
+  cache.Add(2, "two");
+  EXPECT_EQ("two", buffer.values[2]);
+  cache.Delete(1);
+  EXPECT_EQ(0U, buffer.values.count(1));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
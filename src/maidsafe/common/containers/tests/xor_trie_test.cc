@@ -0,0 +1,123 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/containers/xor_trie.h"
+
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(XorTrieTest, BEH_InsertFindErase) {
+  XorTrie<int> trie;
+  EXPECT_TRUE(trie.empty());
+  const Identity id1(MakeIdentity()), id2(MakeIdentity());
+  EXPECT_EQ(nullptr, trie.Find(id1));
+  EXPECT_FALSE(trie.Erase(id1));
+
+  EXPECT_TRUE(trie.Insert(id1, 1));
+  EXPECT_FALSE(trie.Insert(id1, 2));
+  EXPECT_TRUE(trie.Insert(id2, 2));
+  EXPECT_EQ(2U, trie.size());
+  ASSERT_NE(nullptr, trie.Find(id1));
+  EXPECT_EQ(id1, trie.Find(id1)->first);
+  EXPECT_EQ(1, trie.Find(id1)->second);
+  trie.Find(id2)->second = 3;
+  EXPECT_EQ(3, trie.Find(id2)->second);
+  EXPECT_EQ(nullptr, trie.Find(MakeIdentity()));
+
+  EXPECT_TRUE(trie.Erase(id1));
+  EXPECT_FALSE(trie.Erase(id1));
+  EXPECT_EQ(nullptr, trie.Find(id1));
+  EXPECT_EQ(1U, trie.size());
+  trie.clear();
+  EXPECT_TRUE(trie.empty());
+  EXPECT_EQ(nullptr, trie.Find(id2));
+
+  // Move-only values
+  XorTrie<std::unique_ptr<int>> pointers;
+  EXPECT_TRUE(pointers.Insert(id1, std::unique_ptr<int>(new int(1))));
+  EXPECT_EQ(1, *pointers.Find(id1)->second);
+
+  const Identity invalid;
+  EXPECT_THROW(trie.Insert(invalid, 0), common_error);
+  EXPECT_THROW(trie.Find(invalid), common_error);
+  EXPECT_THROW(trie.Erase(invalid), common_error);
+  EXPECT_THROW(trie.Closest(invalid, 1), common_error);
+}
+
+TEST(XorTrieTest, BEH_Closest) {
+  XorTrie<std::size_t> trie;
+  std::vector<Identity> ids;
+  for (std::size_t i(0); i != 2000; ++i) {
+    ids.push_back(MakeIdentity());
+    ASSERT_TRUE(trie.Insert(ids.back(), i));
+  }
+  // Include IDs sharing a long prefix.
+  for (std::size_t i(0); i != 8; ++i) {
+    std::vector<byte> bytes(ids.front().string().begin(), ids.front().string().end());
+    bytes.back() ^= static_cast<byte>(1 << i);
+    ids.emplace_back(bytes);
+    ASSERT_TRUE(trie.Insert(ids.back(), ids.size() - 1));
+  }
+
+  auto check([&](const Identity& target, std::size_t count) {
+    const auto expected(ClosestIdentities(std::begin(ids), std::end(ids), target, count));
+    const auto closest(trie.Closest(target, count));
+    ASSERT_EQ(expected.size(), closest.size());
+    for (std::size_t i(0); i != expected.size(); ++i) {
+      EXPECT_EQ(*expected[i], closest[i]->first);
+      EXPECT_EQ(static_cast<std::size_t>(expected[i] - std::begin(ids)), closest[i]->second);
+    }
+  });
+
+  for (int i(0); i != 20; ++i)
+    check(MakeIdentity(), 16);
+  check(ids.front(), 10);
+  check(ids.back(), ids.size() + 1);
+  EXPECT_TRUE(trie.Closest(ids.front(), 0).empty());
+
+  // Erase every other ID and check again.
+  std::vector<Identity> remaining;
+  for (std::size_t i(0); i != ids.size(); ++i) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(trie.Erase(ids[i]));
+    } else {
+      remaining.push_back(ids[i]);
+    }
+  }
+  EXPECT_EQ(remaining.size(), trie.size());
+  for (int i(0); i != 20; ++i) {
+    const Identity target(MakeIdentity());
+    const auto expected(
+        ClosestIdentities(std::begin(remaining), std::end(remaining), target, 16));
+    const auto closest(trie.Closest(target, 16));
+    ASSERT_EQ(expected.size(), closest.size());
+    for (std::size_t j(0); j != expected.size(); ++j)
+      EXPECT_EQ(*expected[j], closest[j]->first);
+  }
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
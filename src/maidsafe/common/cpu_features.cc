@@ -0,0 +1,75 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/cpu_features.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MAIDSAFE_CPU_FEATURES_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace maidsafe {
+
+namespace detail {
+
+#ifdef MAIDSAFE_CPU_FEATURES_X86
+
+bool CpuSupportsSsse3() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 9)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") != 0;
+#endif
+}
+
+bool CpuSupportsAvx2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  // Check the OS saves the AVX registers (OSXSAVE and AVX bits, then XCR0), then check for AVX2.
+  __cpuid(info, 1);
+  const int osxsave_and_avx((1 << 27) | (1 << 28));
+  if ((info[2] & osxsave_and_avx) != osxsave_and_avx || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#else
+
+bool CpuSupportsSsse3() { return false; }
+
+bool CpuSupportsAvx2() { return false; }
+
+#endif
+
+}  // namespace detail
+
+}  // namespace maidsafe
@@ -20,10 +20,28 @@
 
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <vector>
 
 #include "boost/thread/tss.hpp"
 
+#include "cryptopp/gf2_32.h"
+
+#ifdef MAIDSAFE_COMMON_LZ4
+#include "lz4frame.h"
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+#include "zdict.h"
+#include "zstd.h"
+#endif
+
+#include "maidsafe/common/chacha20.h"
+#include "maidsafe/common/gf256_kernels.h"
+#include "maidsafe/common/startup_timer.h"
 #include "maidsafe/common/utils.h"
 
 namespace maidsafe {
@@ -53,53 +71,573 @@ void ValidateDispersalArgs(int32_t threshold, int32_t number_of_shares) {
   }
 }
 
+// The leading bytes of the LZ4 and zstd formats.  Anything else is treated as gzip.
+const byte kLz4Magic[] = {0x04, 0x22, 0x4d, 0x18};
+const byte kZstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+template <size_t N>
+bool StartsWith(const NonEmptyString& input, const byte (&magic)[N]) {
+  return input.size() >= N && std::equal(magic, magic + N, input.data());
+}
+
+void ValidateCodec(CompressionCodec codec, int compression_level) {
+  if (!CompressionCodecAvailable(codec)) {
+    LOG(kError) << "Compression codec " << static_cast<int>(codec) << " is not available.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const int max_level(codec == CompressionCodec::kGzip
+                          ? kMaxCompressionLevel
+                          : (codec == CompressionCodec::kLz4 ? 12 : 19));
+  const int min_level(codec == CompressionCodec::kZstd ? 1 : 0);
+  if (compression_level < min_level || compression_level > max_level) {
+    LOG(kError) << "Requested compression level of " << compression_level << " is outside the "
+                << "range " << min_level << " to " << max_level;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+}
+
+#ifdef MAIDSAFE_COMMON_LZ4
+std::vector<byte> Lz4Compress(const NonEmptyString& input, int compression_level) {
+  LZ4F_preferences_t preferences;
+  std::memset(&preferences, 0, sizeof(preferences));
+  preferences.compressionLevel = compression_level;
+  preferences.frameInfo.contentSize = input.size();
+  std::vector<byte> result(LZ4F_compressFrameBound(input.size(), &preferences));
+  const size_t size(LZ4F_compressFrame(result.data(), result.size(), input.data(), input.size(),
+                                       &preferences));
+  if (LZ4F_isError(size)) {
+    LOG(kError) << "Failed compressing: " << LZ4F_getErrorName(size);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+  }
+  result.resize(size);
+  return result;
+}
+
+std::vector<byte> Lz4Uncompress(const NonEmptyString& input) {
+  auto throw_error = [](size_t code) {
+    LOG(kError) << "Failed uncompressing: " << LZ4F_getErrorName(code);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+  };
+  LZ4F_dctx* context(nullptr);
+  size_t code(LZ4F_createDecompressionContext(&context, LZ4F_VERSION));
+  if (LZ4F_isError(code))
+    throw_error(code);
+  std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)> context_guard(
+      context, &LZ4F_freeDecompressionContext);
+
+  LZ4F_frameInfo_t frame_info;
+  size_t position(input.size());
+  code = LZ4F_getFrameInfo(context, &frame_info, input.data(), &position);
+  if (LZ4F_isError(code))
+    throw_error(code);
+  std::vector<byte> result(frame_info.contentSize != 0 ? static_cast<size_t>(frame_info.contentSize)
+                                                       : 4 * input.size());
+  size_t written(0);
+  // 'code' is now a hint of the input still needed, and is 0 once the frame is complete.
+  while (code != 0) {
+    if (position == input.size()) {
+      LOG(kError) << "Failed uncompressing: truncated LZ4 frame";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+    }
+    if (written == result.size())
+      result.resize(2 * result.size());
+    size_t output_size(result.size() - written), input_size(input.size() - position);
+    code = LZ4F_decompress(context, result.data() + written, &output_size,
+                           input.data() + position, &input_size, nullptr);
+    if (LZ4F_isError(code))
+      throw_error(code);
+    written += output_size;
+    position += input_size;
+  }
+  result.resize(written);
+  return result;
+}
+#endif
+
+#ifdef MAIDSAFE_COMMON_ZSTD
+// Contexts hold sizeable working buffers, so are reused by each thread.
+struct ZstdContexts {
+  ZstdContexts() : compression(ZSTD_createCCtx()), decompression(ZSTD_createDCtx()) {}
+  ~ZstdContexts() {
+    ZSTD_freeCCtx(compression);
+    ZSTD_freeDCtx(decompression);
+  }
+  ZstdContexts(const ZstdContexts&) = delete;
+  ZstdContexts& operator=(const ZstdContexts&) = delete;
+  ZSTD_CCtx* compression;
+  ZSTD_DCtx* decompression;
+};
+
+// Keep outside the function to avoid lazy static init races on MSVC
+static boost::thread_specific_ptr<ZstdContexts> g_zstd_contexts;
+
+ZstdContexts& GetZstdContexts() {
+  if (!g_zstd_contexts.get())
+    g_zstd_contexts.reset(new ZstdContexts);
+  return *g_zstd_contexts;
+}
+
+// A dictionary added by RegisterCompressionDictionary.  Digesting a dictionary costs far more than
+// compressing a small record with it, so each is digested once for decompression and once per
+// compression level used.
+class RegisteredDictionary {
+ public:
+  explicit RegisteredDictionary(CompressionDictionary dictionary)
+      : dictionary_(std::move(dictionary)),
+        decompression_(ZSTD_createDDict(dictionary_->data(), dictionary_->size())),
+        mutex_(),
+        compression_() {
+    if (!decompression_) {
+      LOG(kError) << "Failed to digest compression dictionary.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+  }
+
+  ~RegisteredDictionary() {
+    ZSTD_freeDDict(decompression_);
+    for (const auto& digested : compression_)
+      ZSTD_freeCDict(digested.second);
+  }
+
+  RegisteredDictionary(const RegisteredDictionary&) = delete;
+  RegisteredDictionary& operator=(const RegisteredDictionary&) = delete;
+
+  const CompressionDictionary& dictionary() const { return dictionary_; }
+
+  const ZSTD_DDict* decompression() const { return decompression_; }
+
+  const ZSTD_CDict* compression(int compression_level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ZSTD_CDict*& digested(compression_[compression_level]);
+    if (!digested)
+      digested = ZSTD_createCDict(dictionary_->data(), dictionary_->size(), compression_level);
+    if (!digested) {
+      compression_.erase(compression_level);
+      LOG(kError) << "Failed to digest compression dictionary.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+    }
+    return digested;
+  }
+
+ private:
+  const CompressionDictionary dictionary_;
+  ZSTD_DDict* const decompression_;
+  std::mutex mutex_;
+  std::map<int, ZSTD_CDict*> compression_;
+};
+
+std::mutex g_dictionaries_mutex;
+std::map<uint32_t, std::shared_ptr<RegisteredDictionary>> g_dictionaries;
+
+std::shared_ptr<RegisteredDictionary> FindDictionary(uint32_t dictionary_id) {
+  std::lock_guard<std::mutex> lock(g_dictionaries_mutex);
+  const auto itr(g_dictionaries.find(dictionary_id));
+  if (itr == g_dictionaries.end()) {
+    LOG(kError) << "Compression dictionary " << dictionary_id << " is not registered.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  }
+  return itr->second;
+}
+
+// Uses 'digested' if non-null, otherwise 'dictionary' if non-null.
+std::vector<byte> ZstdCompress(const NonEmptyString& input, int compression_level,
+                               const CompressionDictionary* dictionary,
+                               const ZSTD_CDict* digested = nullptr) {
+  std::vector<byte> result(ZSTD_compressBound(input.size()));
+  ZSTD_CCtx* context(GetZstdContexts().compression);
+  size_t size(0);
+  if (digested) {
+    size = ZSTD_compress_usingCDict(context, result.data(), result.size(), input.data(),
+                                    input.size(), digested);
+  } else if (dictionary) {
+    size = ZSTD_compress_usingDict(context, result.data(), result.size(), input.data(),
+                                   input.size(), (*dictionary)->data(), (*dictionary)->size(),
+                                   compression_level);
+  } else {
+    size = ZSTD_compressCCtx(context, result.data(), result.size(), input.data(), input.size(),
+                             compression_level);
+  }
+  if (ZSTD_isError(size)) {
+    LOG(kError) << "Failed compressing: " << ZSTD_getErrorName(size);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+  }
+  result.resize(size);
+  return result;
+}
+
+// If 'dictionary' is null and the frame names a dictionary, uses the registered one.
+std::vector<byte> ZstdUncompress(const NonEmptyString& input,
+                                 const CompressionDictionary* dictionary) {
+  // ZSTD_compress always records the content size in the frame header.
+  const unsigned long long content_size(  // NOLINT
+      ZSTD_getFrameContentSize(input.data(), input.size()));
+  if (content_size == ZSTD_CONTENTSIZE_ERROR || content_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+      content_size > std::numeric_limits<size_t>::max()) {
+    LOG(kError) << "Failed uncompressing: invalid zstd frame header";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+  }
+  std::vector<byte> result(static_cast<size_t>(content_size));
+  ZSTD_DCtx* context(GetZstdContexts().decompression);
+  const unsigned dictionary_id(ZSTD_getDictID_fromFrame(input.data(), input.size()));
+  size_t size(0);
+  if (dictionary) {
+    size = ZSTD_decompress_usingDict(context, result.data(), result.size(), input.data(),
+                                     input.size(), (*dictionary)->data(), (*dictionary)->size());
+  } else if (dictionary_id != 0) {
+    const std::shared_ptr<RegisteredDictionary> registered(FindDictionary(dictionary_id));
+    size = ZSTD_decompress_usingDDict(context, result.data(), result.size(), input.data(),
+                                      input.size(), registered->decompression());
+  } else {
+    size = ZSTD_decompressDCtx(context, result.data(), result.size(), input.data(),
+                               input.size());
+  }
+  if (ZSTD_isError(size) || size != result.size()) {
+    LOG(kError) << "Failed uncompressing: "
+                << (ZSTD_isError(size) ? ZSTD_getErrorName(size) : "size mismatch");
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+  }
+  return result;
+}
+#endif
+
+// Erasure coding stripes are at least this many bytes of each share, and each is processed in
+// blocks of this size so that the data being combined stays in cache.
+const size_t kMinErasureStripeSize = 16 * 1024;
+const size_t kErasureBlockSize = 8 * 1024;
+
+// Share 'index' (for index >= threshold) is the sum over data shares j of 1 / (index ^ j) times
+// share j.  Any square submatrix of a Cauchy matrix is invertible, so any 'threshold' rows of this
+// matrix stacked under the identity are too.
+byte ParityCoefficient(size_t index, size_t column) {
+  return detail::Gf256Inverse(static_cast<byte>(index ^ column));
+}
+
+// Returns row 'index' of the encoding matrix for 'threshold' data shares.
+std::vector<byte> EncodingRow(size_t index, size_t threshold) {
+  std::vector<byte> row(threshold, 0);
+  if (index < threshold) {
+    row[index] = 1;
+  } else {
+    for (size_t column(0); column != threshold; ++column)
+      row[column] = ParityCoefficient(index, column);
+  }
+  return row;
+}
+
+// Inverts the 'size' x 'size' row-major 'matrix' by Gauss-Jordan elimination.
+std::vector<byte> Invert(std::vector<byte> matrix, size_t size) {
+  std::vector<byte> inverse(size * size, 0);
+  for (size_t i(0); i != size; ++i)
+    inverse[i * size + i] = 1;
+  for (size_t column(0); column != size; ++column) {
+    size_t pivot(column);
+    while (pivot != size && matrix[pivot * size + column] == 0)
+      ++pivot;
+    if (pivot == size) {
+      LOG(kError) << "Erasure coding matrix is singular.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    if (pivot != column) {
+      std::swap_ranges(&matrix[pivot * size], &matrix[pivot * size] + size, &matrix[column * size]);
+      std::swap_ranges(&inverse[pivot * size], &inverse[pivot * size] + size,
+                       &inverse[column * size]);
+    }
+    const byte scale(detail::Gf256Inverse(matrix[column * size + column]));
+    for (size_t i(0); i != size; ++i) {
+      matrix[column * size + i] = detail::Gf256Multiply(matrix[column * size + i], scale);
+      inverse[column * size + i] = detail::Gf256Multiply(inverse[column * size + i], scale);
+    }
+    for (size_t row(0); row != size; ++row) {
+      const byte factor(matrix[row * size + column]);
+      if (row == column || factor == 0)
+        continue;
+      for (size_t i(0); i != size; ++i) {
+        matrix[row * size + i] ^= detail::Gf256Multiply(factor, matrix[column * size + i]);
+        inverse[row * size + i] ^= detail::Gf256Multiply(factor, inverse[column * size + i]);
+      }
+    }
+  }
+  return inverse;
+}
+
+// Sets each of 'outputs' to the sum over i of coefficients[output][i] times inputs[i], splitting
+// the 'size' bytes of each into stripes which are processed concurrently.  The outputs must
+// already be zeroed.
+void CombineShares(const std::vector<const byte*>& inputs, const std::vector<byte*>& outputs,
+                   const std::vector<std::vector<byte>>& coefficients, size_t size) {
+  const detail::Gf256Kernels& kernels(detail::SelectedGf256Kernels());
+  auto combine_stripe = [&](size_t begin, size_t end) {
+    for (size_t block(begin); block < end; block += kErasureBlockSize) {
+      const size_t block_size(std::min(kErasureBlockSize, end - block));
+      for (size_t output(0); output != outputs.size(); ++output) {
+        for (size_t input(0); input != inputs.size(); ++input) {
+          kernels.multiply_add(coefficients[output][input], inputs[input] + block, block_size,
+                               outputs[output] + block);
+        }
+      }
+    }
+  };
+  const size_t thread_count(std::max<size_t>(
+      1, std::min<size_t>(Concurrency(), size / kMinErasureStripeSize)));
+  const size_t stripe_size((size + thread_count - 1) / thread_count);
+  std::vector<std::future<void>> futures;
+  for (size_t begin(stripe_size); begin < size; begin += stripe_size) {
+    futures.emplace_back(std::async(std::launch::async, combine_stripe, begin,
+                                    std::min(begin + stripe_size, size)));
+  }
+  combine_stripe(0, std::min(stripe_size, size));
+  for (auto& future : futures)
+    future.get();
+}
+
+// Shares made by SecretShareData and InfoDisperse start with their index, as a big-endian word32.
+const size_t kShareIndexSize = 4;
+// CryptoPP's SecretSharing puts the secret on this channel of its RawIDA, and interpolates it from
+// the random channels 0 to threshold - 2.  InformationDispersal splits the data a byte at a time
+// between channels 0 to threshold - 1, which are also the indices of the first 'threshold' shares.
+const uint32_t kSecretChannel = 0xffffffff;
+const size_t kCoefficientTableSize = 8 * 16;
+
+uint32_t ReadShareIndex(const NonEmptyString& part) {
+  if (part.size() < kShareIndexSize) {
+    LOG(kError) << "Share is too short to hold an index.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const byte* const data(part.data());
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+// RawIDA reads each share's payload as big-endian words, the last one zero-padded.
+uint32_t ReadShareWord(const byte* payload, size_t payload_size, size_t word_index) {
+  uint32_t word(0);
+  for (size_t i(word_index * 4); i != word_index * 4 + 4; ++i)
+    word = (word << 8) | (i < payload_size ? payload[i] : 0);
+  return word;
+}
+
+// Both schemes pad their input with a 1 followed by zeros.
+void RemoveSharePadding(std::vector<byte>& data) {
+  const auto last(std::find_if(data.rbegin(), data.rend(), [](byte value) { return value != 0; }));
+  if (last != data.rend() && *last == 1)
+    data.resize(static_cast<size_t>(data.rend() - last) - 1);
+}
+
+// A GCM cipher which remembers the key it was last set up with.  Setting the key is the costly
+// part of using GCM_64K_Tables (it builds a 64KB multiplication table); changing the IV is cheap.
+template <typename Cipher>
+class KeyedCipher {
+ public:
+  KeyedCipher() : cipher_(), key_(), keyed_(false) {}
+
+  Cipher& Get(const byte* key) {
+    if (!keyed_ || !std::equal(key_.begin(), key_.end(), key)) {
+      keyed_ = false;
+      cipher_.SetKey(key, AES256_KeySize);
+      std::copy_n(key, AES256_KeySize, key_.begin());
+      keyed_ = true;
+    }
+    return cipher_;
+  }
+
+ private:
+  Cipher cipher_;
+  std::array<byte, AES256_KeySize> key_;
+  bool keyed_;
+};
+
+struct GcmContext {
+  KeyedCipher<CryptoPP::GCM<CryptoPP::AES, CryptoPP::GCM_64K_Tables>::Encryption> encryptor;
+  KeyedCipher<CryptoPP::GCM<CryptoPP::AES, CryptoPP::GCM_64K_Tables>::Decryption> decryptor;
+};
+
+// Keep outside the function to avoid lazy static init races on MSVC
+static boost::thread_specific_ptr<GcmContext> g_gcm_context;
+
+GcmContext& GetGcmContext() {
+  if (!g_gcm_context.get())
+    g_gcm_context.reset(new GcmContext);
+  return *g_gcm_context;
+}
+
+// Generates a ChaCha20 keystream into a buffer, handing out (and erasing) buffered bytes until
+// the buffer is exhausted.  Each refill is generated under the key taken from the first 32 bytes
+// of the previous refill ("fast key erasure"), and fresh entropy from the OS-seeded generator is
+// mixed into the key every kReseedInterval refills.
+class BufferedChaCha20Generator : public CryptoPP::RandomNumberGenerator {
+ public:
+  BufferedChaCha20Generator() : key_(), buffer_(), position_(kBufferSize), refill_count_(0) {
+    std::memset(key_, 0, key_.size());
+  }
+
+  virtual byte GenerateByte() {
+    if (position_ == kBufferSize)
+      Refill();
+    const byte result(buffer_[position_]);
+    buffer_[position_++] = 0;
+    return result;
+  }
+
+  virtual void GenerateBlock(byte* output, size_t size) {
+    while (size != 0) {
+      if (position_ == kBufferSize)
+        Refill();
+      const size_t count(std::min(size, kBufferSize - position_));
+      std::memcpy(output, buffer_ + position_, count);
+      std::memset(buffer_ + position_, 0, count);
+      position_ += count;
+      output += count;
+      size -= count;
+    }
+  }
+
+ private:
+  static const size_t kBufferSize = 4096;
+  static const unsigned kReseedInterval = 256;
+
+  void Refill() {
+    if (refill_count_++ % kReseedInterval == 0) {
+      CryptoPP::FixedSizeSecBlock<byte, detail::kChaCha20KeySize> seed;
+      random_number_generator().GenerateBlock(seed, seed.size());
+      CryptoPP::xorbuf(key_, seed, key_.size());
+    }
+    const byte nonce[detail::kChaCha20NonceSize] = {};
+    detail::ChaCha20Keystream(key_, nonce, 0, kBufferSize / detail::kChaCha20BlockSize, buffer_);
+    std::memcpy(key_, buffer_, key_.size());
+    std::memset(buffer_, 0, key_.size());
+    position_ = key_.size();
+  }
+
+  CryptoPP::FixedSizeSecBlock<byte, detail::kChaCha20KeySize> key_;
+  CryptoPP::FixedSizeSecBlock<byte, kBufferSize> buffer_;
+  size_t position_;
+  unsigned refill_count_;
+};
+
+// Keep outside the function to avoid lazy static init races on MSVC
+static boost::thread_specific_ptr<BufferedChaCha20Generator> g_fast_random_number_generator;
+
 }  // unnamed namespace
 
 CryptoPP::RandomNumberGenerator& random_number_generator() {
-  if (!g_random_number_generator.get())
+  if (!g_random_number_generator.get()) {
+    StartupTimer startup_timer("random number generator");
     g_random_number_generator.reset(new CryptoPP::AutoSeededX917RNG<CryptoPP::AES>);
+  }
   return *g_random_number_generator;
 }
 
+CryptoPP::RandomNumberGenerator& fast_random_number_generator() {
+  if (!g_fast_random_number_generator.get())
+    g_fast_random_number_generator.reset(new BufferedChaCha20Generator);
+  return *g_fast_random_number_generator;
+}
+
+std::size_t HashManyThreadCount(std::size_t count, std::size_t total_size) {
+  // Batches with less input than this aren't worth splitting across threads.
+  const std::size_t kMinSizePerThread(1 << 18);
+  return std::max<std::size_t>(
+      1, std::min<std::size_t>({Concurrency(), count, total_size / kMinSizePerThread}));
+}
+
 CipherText SymmEncrypt(const PlainText& input, const AES256KeyAndIV& key_and_iv) {
   if (!input.IsInitialised() || !key_and_iv.IsInitialised()) {
     LOG(kError) << "SymmEncrypt one member of class uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
-  std::string result;
+  std::vector<byte> result(input.size() + AES256_TagSize, 0);
+  SymmEncrypt(input.data(), input.size(), key_and_iv, result.data());
+  return CipherText(NonEmptyString(std::move(result)));
+}
+
+PlainText SymmDecrypt(const CipherText& input, const AES256KeyAndIV& key_and_iv) {
+  if (!input->IsInitialised() || !key_and_iv.IsInitialised()) {
+    LOG(kError) << "SymmEncrypt one of class uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  if (input->size() <= static_cast<size_t>(AES256_TagSize)) {
+    LOG(kError) << "Failed symmetric decryption: input too small";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  std::vector<byte> result(input->size() - AES256_TagSize, 0);
+  SymmDecrypt(input->data(), input->size(), key_and_iv, result.data());
+  return PlainText(std::move(result));
+}
+
+void SymmEncrypt(const byte* input, size_t size, const AES256KeyAndIV& key_and_iv, byte* output) {
+  if (!key_and_iv.IsInitialised()) {
+    LOG(kError) << "SymmEncrypt key_and_iv uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  const byte* key(key_and_iv.data());
   try {
-    CryptoPP::GCM<CryptoPP::AES, CryptoPP::GCM_64K_Tables>::Encryption encryptor;
-    encryptor.SetKeyWithIV(key_and_iv.data(), AES256_KeySize, key_and_iv.data() + AES256_KeySize,
-                           AES256_IVSize);
-    CryptoPP::ArraySource(
-        input.data(), input.size(), true,
-        new CryptoPP::AuthenticatedEncryptionFilter(encryptor, new CryptoPP::StringSink(result)));
+    GetGcmContext().encryptor.Get(key).EncryptAndAuthenticate(
+        output, output + size, AES256_TagSize, key + AES256_KeySize, AES256_IVSize, nullptr, 0,
+        input, size);
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Failed symmetric encryption: " << e.what();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_encryption_error));
   }
-  return CipherText(NonEmptyString(result));
 }
 
-PlainText SymmDecrypt(const CipherText& input, const AES256KeyAndIV& key_and_iv) {
-  if (!input->IsInitialised() || !key_and_iv.IsInitialised()) {
-    LOG(kError) << "SymmEncrypt one of class uninitialised";
+void SymmDecrypt(const byte* input, size_t size, const AES256KeyAndIV& key_and_iv, byte* output) {
+  if (!key_and_iv.IsInitialised()) {
+    LOG(kError) << "SymmDecrypt key_and_iv uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
-  std::string result;
+  if (size < static_cast<size_t>(AES256_TagSize)) {
+    LOG(kError) << "Failed symmetric decryption: input too small";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  const size_t ciphertext_size(size - AES256_TagSize);
+  const byte* key(key_and_iv.data());
+  bool verified(false);
   try {
-    CryptoPP::GCM<CryptoPP::AES, CryptoPP::GCM_64K_Tables>::Decryption decryptor;
-    decryptor.SetKeyWithIV(key_and_iv.data(), AES256_KeySize, key_and_iv.data() + AES256_KeySize,
-                           AES256_IVSize);
-    CryptoPP::ArraySource(
-        input->data(), input->size(), true,
-        new CryptoPP::AuthenticatedDecryptionFilter(decryptor, new CryptoPP::StringSink(result)));
-  } catch (const CryptoPP::Exception&) {
-    LOG(kError) << "Failed symmetric decryption: "
-                << boost::current_exception_diagnostic_information(true);
+    verified = GetGcmContext().decryptor.Get(key).DecryptAndVerify(
+        output, input + ciphertext_size, AES256_TagSize, key + AES256_KeySize, AES256_IVSize,
+        nullptr, 0, input, ciphertext_size);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed symmetric decryption: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  if (!verified) {
+    LOG(kError) << "Failed symmetric decryption: authentication failed";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+}
+
+void SymmEncrypt(const byte* input, size_t size, const byte* key, const byte* nonce,
+                 const byte* associated_data, size_t associated_data_size, byte* output) {
+  try {
+    GetGcmContext().encryptor.Get(key).EncryptAndAuthenticate(
+        output, output + size, AES256_TagSize, nonce, AES256_NonceSize, associated_data,
+        associated_data_size, input, size);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed symmetric encryption: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_encryption_error));
+  }
+}
+
+void SymmDecrypt(const byte* input, size_t size, const byte* key, const byte* nonce,
+                 const byte* associated_data, size_t associated_data_size, byte* output) {
+  if (size < static_cast<size_t>(AES256_TagSize)) {
+    LOG(kError) << "Failed symmetric decryption: input too small";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  const size_t ciphertext_size(size - AES256_TagSize);
+  bool verified(false);
+  try {
+    verified = GetGcmContext().decryptor.Get(key).DecryptAndVerify(
+        output, input + ciphertext_size, AES256_TagSize, nonce, AES256_NonceSize, associated_data,
+        associated_data_size, input, ciphertext_size);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed symmetric decryption: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  if (!verified) {
+    LOG(kError) << "Failed symmetric decryption: authentication failed";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
   }
-  return PlainText(result);
 }
 
 CompressedText Compress(const UncompressedText& input, uint16_t compression_level) {
@@ -129,6 +667,22 @@ UncompressedText Uncompress(const CompressedText& input) {
     LOG(kError) << "Uncompress input uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
+  if (StartsWith(*input, kLz4Magic)) {
+#ifdef MAIDSAFE_COMMON_LZ4
+    return UncompressedText(Lz4Uncompress(*input));
+#else
+    LOG(kError) << "Failed uncompressing: LZ4 is not available";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+#endif
+  }
+  if (StartsWith(*input, kZstdMagic)) {
+#ifdef MAIDSAFE_COMMON_ZSTD
+    return UncompressedText(ZstdUncompress(*input, nullptr));
+#else
+    LOG(kError) << "Failed uncompressing: zstd is not available";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+#endif
+  }
   std::string result;
   try {
     CryptoPP::ArraySource(input->data(), input->size(), true,
@@ -140,6 +694,155 @@ UncompressedText Uncompress(const CompressedText& input) {
   return UncompressedText(result);
 }
 
+bool CompressionCodecAvailable(CompressionCodec codec) {
+  switch (codec) {
+    case CompressionCodec::kGzip:
+      return true;
+    case CompressionCodec::kLz4:
+#ifdef MAIDSAFE_COMMON_LZ4
+      return true;
+#else
+      return false;
+#endif
+    case CompressionCodec::kZstd:
+#ifdef MAIDSAFE_COMMON_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+CompressedText Compress(const UncompressedText& input, CompressionCodec codec,
+                        int compression_level) {
+  ValidateCodec(codec, compression_level);
+  if (!input.IsInitialised()) {
+    LOG(kError) << "Compress input uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec == CompressionCodec::kLz4)
+    return CompressedText(NonEmptyString(Lz4Compress(input, compression_level)));
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec == CompressionCodec::kZstd)
+    return CompressedText(NonEmptyString(ZstdCompress(input, compression_level, nullptr)));
+#endif
+  return Compress(input, static_cast<uint16_t>(compression_level));
+}
+
+#ifdef MAIDSAFE_COMMON_ZSTD
+CompressedText Compress(const UncompressedText& input, const CompressionDictionary& dictionary,
+                        int compression_level) {
+  ValidateCodec(CompressionCodec::kZstd, compression_level);
+  if (!input.IsInitialised() || !dictionary->IsInitialised()) {
+    LOG(kError) << "Compress input or dictionary uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  return CompressedText(NonEmptyString(ZstdCompress(input, compression_level, &dictionary)));
+}
+
+UncompressedText Uncompress(const CompressedText& input, const CompressionDictionary& dictionary) {
+  if (!input->IsInitialised() || !dictionary->IsInitialised()) {
+    LOG(kError) << "Uncompress input or dictionary uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  if (!StartsWith(*input, kZstdMagic)) {
+    LOG(kError) << "Failed uncompressing: not a zstd frame";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+  }
+  return UncompressedText(ZstdUncompress(*input, &dictionary));
+}
+
+CompressionDictionary TrainCompressionDictionary(const std::vector<NonEmptyString>& samples,
+                                                 size_t max_size) {
+  std::vector<byte> concatenated;
+  std::vector<size_t> sample_sizes;
+  for (const auto& sample : samples) {
+    concatenated.insert(concatenated.end(), sample.begin(), sample.end());
+    sample_sizes.push_back(sample.size());
+  }
+  std::vector<byte> dictionary(max_size);
+  const size_t size(ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+                                          concatenated.data(), sample_sizes.data(),
+                                          static_cast<unsigned>(sample_sizes.size())));
+  if (ZDICT_isError(size)) {
+    LOG(kError) << "Failed training compression dictionary: " << ZDICT_getErrorName(size);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  dictionary.resize(size);
+  return CompressionDictionary(NonEmptyString(std::move(dictionary)));
+}
+
+uint32_t GetCompressionDictionaryId(const CompressionDictionary& dictionary) {
+  return dictionary->IsInitialised()
+             ? ZSTD_getDictID_fromDict(dictionary->data(), dictionary->size())
+             : 0;
+}
+
+uint32_t RegisterCompressionDictionary(const CompressionDictionary& dictionary) {
+  const uint32_t dictionary_id(GetCompressionDictionaryId(dictionary));
+  if (dictionary_id == 0) {
+    LOG(kError) << "Only trained dictionaries, which carry an id, can be registered.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  auto registered(std::make_shared<RegisteredDictionary>(dictionary));
+  std::lock_guard<std::mutex> lock(g_dictionaries_mutex);
+  const auto result(g_dictionaries.emplace(dictionary_id, std::move(registered)));
+  if (!result.second && result.first->second->dictionary() != dictionary) {
+    LOG(kError) << "A different compression dictionary is already registered with id "
+                << dictionary_id;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
+  }
+  return dictionary_id;
+}
+
+CompressedText Compress(const UncompressedText& input, uint32_t dictionary_id,
+                        int compression_level) {
+  ValidateCodec(CompressionCodec::kZstd, compression_level);
+  if (!input.IsInitialised()) {
+    LOG(kError) << "Compress input uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  const std::shared_ptr<RegisteredDictionary> registered(FindDictionary(dictionary_id));
+  return CompressedText(NonEmptyString(ZstdCompress(input, compression_level, nullptr,
+                                                    registered->compression(compression_level))));
+}
+#else
+CompressedText Compress(const UncompressedText& /*input*/,
+                        const CompressionDictionary& /*dictionary*/, int compression_level) {
+  ValidateCodec(CompressionCodec::kZstd, compression_level);
+  return CompressedText();
+}
+
+UncompressedText Uncompress(const CompressedText& /*input*/,
+                            const CompressionDictionary& /*dictionary*/) {
+  LOG(kError) << "Dictionary compression requires zstd, which is not available.";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+CompressionDictionary TrainCompressionDictionary(const std::vector<NonEmptyString>& /*samples*/,
+                                                 size_t /*max_size*/) {
+  LOG(kError) << "Dictionary training requires zstd, which is not available.";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+uint32_t GetCompressionDictionaryId(const CompressionDictionary& /*dictionary*/) { return 0; }
+
+uint32_t RegisterCompressionDictionary(const CompressionDictionary& /*dictionary*/) {
+  LOG(kError) << "Dictionary compression requires zstd, which is not available.";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+CompressedText Compress(const UncompressedText& /*input*/, uint32_t /*dictionary_id*/,
+                        int compression_level) {
+  ValidateCodec(CompressionCodec::kZstd, compression_level);
+  return CompressedText();
+}
+#endif
+
 std::vector<std::string> SecretShareData(int32_t threshold, int32_t number_of_shares,
                                          const std::string& data) {
   ValidateDispersalArgs(threshold, number_of_shares);
@@ -247,6 +950,119 @@ DataParts InfoDisperse(int32_t threshold, int32_t number_of_shares, const PlainT
   return result;
 }
 
+DataParts ErasureDisperse(int32_t threshold, int32_t number_of_shares, const PlainText& data) {
+  ValidateDispersalArgs(threshold, number_of_shares);
+  if (number_of_shares > kMaxErasureShares) {
+    LOG(kError) << "The number of shares (" << number_of_shares << ") must be at most "
+                << kMaxErasureShares << ".";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const size_t data_share_count(static_cast<size_t>(threshold));
+  const size_t share_count(static_cast<size_t>(number_of_shares));
+  const uint64_t data_size(data.size());
+  const size_t share_size((data.size() + data_share_count - 1) / data_share_count);
+
+  std::vector<std::vector<byte>> shares(share_count,
+                                        std::vector<byte>(kErasureShareHeaderSize + share_size, 0));
+  for (size_t index(0); index != share_count; ++index) {
+    byte* header(shares[index].data());
+    header[0] = static_cast<byte>(index);
+    header[1] = static_cast<byte>(threshold);
+    for (int i(0); i != 8; ++i)
+      header[2 + i] = static_cast<byte>(data_size >> (8 * (7 - i)));
+  }
+
+  std::vector<const byte*> inputs;
+  for (size_t index(0); index != data_share_count; ++index) {
+    const size_t offset(std::min(index * share_size, data.size()));
+    const size_t size(std::min(share_size, data.size() - offset));
+    std::copy_n(data.data() + offset, size, &shares[index][kErasureShareHeaderSize]);
+    inputs.push_back(&shares[index][kErasureShareHeaderSize]);
+  }
+  std::vector<byte*> outputs;
+  std::vector<std::vector<byte>> coefficients;
+  for (size_t index(data_share_count); index != share_count; ++index) {
+    outputs.push_back(&shares[index][kErasureShareHeaderSize]);
+    coefficients.push_back(EncodingRow(index, data_share_count));
+  }
+  if (!outputs.empty())
+    CombineShares(inputs, outputs, coefficients, share_size);
+
+  DataParts result;
+  for (auto& share : shares)
+    result.emplace_back(std::move(share));
+  return result;
+}
+
+PlainText ErasureRetrieve(const DataParts& parts) {
+  if (parts.empty() || parts.front().size() < kErasureShareHeaderSize) {
+    LOG(kError) << "Too few shares, or invalid share.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const NonEmptyString& first(parts.front());
+  const size_t threshold(first.data()[1]);
+  uint64_t data_size(0);
+  for (int i(0); i != 8; ++i)
+    data_size = (data_size << 8) | first.data()[2 + i];
+  if (threshold < 2 || data_size == 0 ||
+      first.size() != kErasureShareHeaderSize + (data_size + threshold - 1) / threshold) {
+    LOG(kError) << "Invalid share header.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const size_t share_size(first.size() - kErasureShareHeaderSize);
+
+  std::vector<const NonEmptyString*> shares_by_index(kMaxErasureShares, nullptr);
+  for (const auto& part : parts) {
+    if (part.size() != first.size() || !std::equal(first.data() + 1,
+                                                   first.data() + kErasureShareHeaderSize,
+                                                   part.data() + 1)) {
+      LOG(kError) << "Shares are inconsistent.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    shares_by_index[part.data()[0]] = &part;
+  }
+
+  // Prefer data shares, since they need no decoding.
+  std::vector<size_t> chosen;
+  for (size_t index(0); index != shares_by_index.size() && chosen.size() != threshold; ++index) {
+    if (shares_by_index[index])
+      chosen.push_back(index);
+  }
+  if (chosen.size() != threshold) {
+    LOG(kError) << "Need " << threshold << " distinct shares, but only have " << chosen.size();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+
+  std::vector<byte> data(threshold * share_size, 0);
+  std::vector<const byte*> inputs;
+  std::vector<byte> matrix;
+  for (const size_t index : chosen) {
+    inputs.push_back(shares_by_index[index]->data() + kErasureShareHeaderSize);
+    if (index < threshold)
+      std::copy_n(inputs.back(), share_size, &data[index * share_size]);
+    const std::vector<byte> row(EncodingRow(index, threshold));
+    matrix.insert(matrix.end(), row.begin(), row.end());
+  }
+
+  if (chosen.back() >= threshold) {
+    // Each missing data share is the corresponding row of the inverse applied to the chosen shares.
+    std::vector<byte*> outputs;
+    std::vector<std::vector<byte>> coefficients;
+    const std::vector<byte> inverse(Invert(std::move(matrix), threshold));
+    for (size_t index(0); index != threshold; ++index) {
+      if (shares_by_index[index])
+        continue;
+      outputs.push_back(&data[index * share_size]);
+      coefficients.emplace_back(&inverse[index * threshold],
+                                &inverse[index * threshold] + threshold);
+    }
+    CombineShares(inputs, outputs, coefficients, share_size);
+  }
+
+  data.resize(static_cast<size_t>(data_size));
+  return PlainText(std::move(data));
+}
+
 PlainText InfoRetrieve(const DataParts& parts) {
   size_t num_to_check = parts.size();
   // Safe to subtract 4 since each piece is prefixed with a byte piece number
@@ -273,6 +1089,129 @@ PlainText InfoRetrieve(const DataParts& parts) {
   return PlainText(std::move(data));
 }
 
+ShareRecoveryContext::ShareRecoveryContext(Scheme scheme, std::vector<uint32_t> share_indices)
+    : scheme_(scheme),
+      share_indices_(std::move(share_indices)),
+      direct_sources_(),
+      coefficient_tables_() {
+  std::sort(share_indices_.begin(), share_indices_.end());
+  if (share_indices_.size() < 2 ||
+      std::adjacent_find(share_indices_.begin(), share_indices_.end()) != share_indices_.end()) {
+    LOG(kError) << "Need at least two distinct share indices.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const size_t share_count(share_indices_.size());
+  std::vector<uint32_t> streams;
+  if (scheme_ == Scheme::kSecretSharing) {
+    streams.push_back(kSecretChannel);
+  } else {
+    for (size_t i(0); i != share_count; ++i)
+      streams.push_back(static_cast<uint32_t>(i));
+  }
+
+  // Lagrange interpolation in the same field as RawIDA: the coefficient of share j at x is
+  // weight[j] * product over m != j of (x - x[m]), where weight[j] is the inverse of the product
+  // over m != j of (x[j] - x[m]).  Subtraction is XOR.
+  const CryptoPP::GF2_32 field;
+  std::vector<uint32_t> weights(share_count);
+  for (size_t j(0); j != share_count; ++j) {
+    uint32_t product(1);
+    for (size_t m(0); m != share_count; ++m) {
+      if (m != j)
+        product = field.Multiply(product, share_indices_[j] ^ share_indices_[m]);
+    }
+    weights[j] = field.MultiplicativeInverse(product);
+  }
+
+  for (const uint32_t x : streams) {
+    const auto found(std::lower_bound(share_indices_.begin(), share_indices_.end(), x));
+    if (found != share_indices_.end() && *found == x) {
+      direct_sources_.push_back(static_cast<size_t>(found - share_indices_.begin()));
+      coefficient_tables_.emplace_back();
+      continue;
+    }
+    direct_sources_.push_back(share_count);
+    std::vector<uint32_t> tables(share_count * kCoefficientTableSize);
+    for (size_t j(0); j != share_count; ++j) {
+      uint32_t coefficient(weights[j]);
+      for (size_t m(0); m != share_count; ++m) {
+        if (m != j)
+          coefficient = field.Multiply(coefficient, x ^ share_indices_[m]);
+      }
+      for (uint32_t nibble(0); nibble != 8; ++nibble) {
+        for (uint32_t value(0); value != 16; ++value) {
+          tables[j * kCoefficientTableSize + nibble * 16 + value] =
+              field.Multiply(coefficient, value << (4 * nibble));
+        }
+      }
+    }
+    coefficient_tables_.push_back(std::move(tables));
+  }
+}
+
+std::vector<uint32_t> ShareRecoveryContext::ShareIndices(const DataParts& parts) {
+  std::vector<uint32_t> indices;
+  indices.reserve(parts.size());
+  for (const auto& part : parts)
+    indices.push_back(ReadShareIndex(part));
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
+PlainText ShareRecoveryContext::Recover(const DataParts& parts) const {
+  const size_t share_count(share_indices_.size());
+  if (parts.size() != share_count) {
+    LOG(kError) << "Expected " << share_count << " shares, but have " << parts.size();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::vector<const byte*> payloads(share_count, nullptr);
+  for (const auto& part : parts) {
+    const uint32_t index(ReadShareIndex(part));
+    const auto found(std::lower_bound(share_indices_.begin(), share_indices_.end(), index));
+    const size_t position(static_cast<size_t>(found - share_indices_.begin()));
+    if (found == share_indices_.end() || *found != index || payloads[position] ||
+        part.size() != parts.front().size()) {
+      LOG(kError) << "Shares don't match the recovery context.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    payloads[position] = part.data() + kShareIndexSize;
+  }
+
+  const size_t payload_size(parts.front().size() - kShareIndexSize);
+  const size_t word_count((payload_size + 3) / 4);
+  const size_t stream_count(direct_sources_.size());
+  std::vector<byte> data(word_count * 4 * stream_count);
+  std::vector<uint32_t> words(share_count);
+  for (size_t word_index(0); word_index != word_count; ++word_index) {
+    for (size_t j(0); j != share_count; ++j)
+      words[j] = ReadShareWord(payloads[j], payload_size, word_index);
+    for (size_t stream(0); stream != stream_count; ++stream) {
+      uint32_t value(0);
+      if (direct_sources_[stream] != share_count) {
+        value = words[direct_sources_[stream]];
+      } else {
+        const uint32_t* table(coefficient_tables_[stream].data());
+        for (size_t j(0); j != share_count; ++j, table += kCoefficientTableSize) {
+          for (uint32_t nibble(0); nibble != 8; ++nibble)
+            value ^= table[nibble * 16 + ((words[j] >> (4 * nibble)) & 0xf)];
+        }
+      }
+      // InformationRecovery interleaves its streams a byte at a time.
+      for (size_t i(0); i != 4; ++i) {
+        data[(word_index * 4 + i) * stream_count + stream] =
+            static_cast<byte>(value >> (8 * (3 - i)));
+      }
+    }
+  }
+
+  RemoveSharePadding(data);
+  if (data.empty()) {
+    LOG(kError) << "Shares hold no data.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  return PlainText(std::move(data));
+}
+
 }  // namespace crypto
 
 }  // namespace maidsafe
@@ -18,62 +18,338 @@
 
 #include "maidsafe/common/data_buffer.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <ctime>
+#include <tuple>
 
 #include "boost/filesystem/convenience.hpp"
+#include "boost/tuple/tuple.hpp"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/convert.h"
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/encode.h"
+#include "maidsafe/common/hash.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/make_unique.h"
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/tagged_value.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_buffer_storage.h"
 
 namespace fs = boost::filesystem;
 
 namespace maidsafe {
 
+namespace {
+
+template <typename Functor>
+std::error_code ErrorOf(Functor functor) {
+  try {
+    functor();
+  } catch (const maidsafe_error& error) {
+    return error.code();
+  } catch (const std::system_error& error) {
+    return error.code();
+  } catch (const std::exception& e) {
+    LOG(kError) << boost::diagnostic_information(e);
+    return make_error_code(CommonErrors::unknown);
+  }
+  return std::error_code();
+}
+
+// The SplitMix64 finaliser.  Used to place the disk directories on the consistent hashing ring.
+uint64_t SplitMix64(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+// With Options::compress_on_disk set, each value written to disk is prefixed with one of these.
+const byte kStoredRaw(0), kStoredCompressed(1);
+
+// Judges whether 'value' is worth compressing from the Shannon entropy of its first few KB, so that
+// ciphertext and already-compressed data aren't needlessly passed through the compressor.
+bool LooksCompressible(const NonEmptyString& value) {
+  const size_t kMinSize(64), kSampleSize(4096);
+  const double kMaxBitsPerByte(7.0);
+  const auto& data(value.string());
+  if (data.size() < kMinSize)
+    return false;
+  const auto sample_size(std::min(data.size(), kSampleSize));
+  std::array<uint32_t, 256> counts;
+  counts.fill(0);
+  for (size_t i(0); i != sample_size; ++i)
+    ++counts[data[i]];
+  double bits_per_byte(0.0);
+  for (const auto count : counts) {
+    if (count == 0)
+      continue;
+    const auto probability(static_cast<double>(count) / sample_size);
+    bits_per_byte -= probability * std::log2(probability);
+  }
+  return bits_per_byte < kMaxBitsPerByte;
+}
+
+NonEmptyString EncodeForDisk(const NonEmptyString& value, uint16_t compression_level) {
+  std::vector<byte> encoded;
+  if (LooksCompressible(value)) {
+    try {
+      const auto compressed(crypto::Compress(value, compression_level));
+      if (compressed->string().size() < value.string().size()) {
+        encoded.reserve(compressed->string().size() + 1);
+        encoded.push_back(kStoredCompressed);
+        encoded.insert(std::end(encoded), std::begin(compressed->string()),
+                       std::end(compressed->string()));
+        return NonEmptyString(std::move(encoded));
+      }
+    } catch (const std::exception& e) {
+      LOG(kWarning) << "Storing uncompressed: " << boost::diagnostic_information(e);
+    }
+  }
+  encoded.reserve(value.string().size() + 1);
+  encoded.push_back(kStoredRaw);
+  encoded.insert(std::end(encoded), std::begin(value.string()), std::end(value.string()));
+  return NonEmptyString(std::move(encoded));
+}
+
+boost::expected<NonEmptyString, common_error> DecodeFromDisk(const byte* data, size_t size) {
+  try {
+    if (size > 1 && data[0] == kStoredRaw)
+      return NonEmptyString(std::vector<byte>(data + 1, data + size));
+    if (size > 1 && data[0] == kStoredCompressed)
+      return crypto::Uncompress(crypto::CompressedText(
+          NonEmptyString(std::vector<byte>(data + 1, data + size))));
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to decode value: " << boost::diagnostic_information(e);
+    return boost::make_unexpected(MakeError(CommonErrors::uncompression_error));
+  }
+  LOG(kError) << "Invalid encoding of value on disk.";
+  return boost::make_unexpected(MakeError(CommonErrors::parsing_error));
+}
+
+}  // unnamed namespace
+
+const DataBuffer::Rank DataBuffer::kPinnedRank;
+
+size_t DataBuffer::KeyHash::operator()(const KeyType& key) const {
+  static const SeededHash<SipHash> hash;
+  return static_cast<size_t>(hash(key.name.string(), key.type_id.data));
+}
+
+double DataBuffer::FlushStats::BytesPerSecond() const {
+  if (write_time.count() == 0)
+    return 0.0;
+  return static_cast<double>(bytes_flushed) / std::chrono::duration<double>(write_time).count();
+}
+
+double DataBuffer::Stats::HitRate() const {
+  const uint64_t hits(memory_hits + disk_hits);
+  if (hits + misses == 0)
+    return 0.0;
+  return static_cast<double>(hits) / static_cast<double>(hits + misses);
+}
+
 DataBuffer::DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
-                       PopFunctor pop_functor)
+                       PopFunctor pop_functor, Options options)
     : memory_store_(max_memory_usage),
       disk_store_(max_disk_usage),
       kPopFunctor_(std::move(pop_functor)),
       kDiskBuffer_(fs::unique_path(fs::temp_directory_path() / "DB-%%%%-%%%%-%%%%-%%%%")),
-      kShouldRemoveRoot_(true) {
+      kShouldRemoveRoot_(true),
+      kOptions_(std::move(options)),
+      stripes_(1, DiskStripe(kDiskBuffer_, max_disk_usage)) {
   Init();
 }
 
 DataBuffer::DataBuffer(MemoryUsage max_memory_usage, DiskUsage max_disk_usage,
-                       PopFunctor pop_functor, const fs::path& disk_buffer, bool should_remove_root)
+                       PopFunctor pop_functor, const fs::path& disk_buffer, bool should_remove_root,
+                       Options options)
     : memory_store_(max_memory_usage),
       disk_store_(max_disk_usage),
       kPopFunctor_(std::move(pop_functor)),
       kDiskBuffer_(disk_buffer),
-      kShouldRemoveRoot_(should_remove_root) {
+      kShouldRemoveRoot_(should_remove_root),
+      kOptions_(std::move(options)),
+      stripes_(1, DiskStripe(disk_buffer, max_disk_usage)) {
+  Init();
+}
+
+DataBuffer::DataBuffer(MemoryUsage max_memory_usage, std::vector<DiskDirectory> disk_directories,
+                       PopFunctor pop_functor, bool should_remove_root, Options options)
+    : memory_store_(max_memory_usage),
+      disk_store_(DiskUsage(0)),
+      kPopFunctor_(std::move(pop_functor)),
+      kDiskBuffer_(disk_directories.empty() ? fs::path() : disk_directories.front().path),
+      kShouldRemoveRoot_(should_remove_root),
+      kOptions_(std::move(options)),
+      stripes_(MakeStripes(std::move(disk_directories))) {
   Init();
 }
 
+std::vector<DataBuffer::DiskStripe> DataBuffer::MakeStripes(
+    std::vector<DiskDirectory> disk_directories) {
+  if (disk_directories.empty()) {
+    LOG(kError) << "At least one disk directory is required.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::vector<DiskStripe> stripes;
+  for (auto& directory : disk_directories)
+    stripes.emplace_back(std::move(directory.path), directory.max_usage);
+  return stripes;
+}
+
 void DataBuffer::Init() {
-  if (memory_store_.max > disk_store_.max) {
-    LOG(kError) << "Max memory usage must be < max disk usage.";
+  uint64_t total_disk_usage(0);
+  for (const auto& stripe : stripes_) {
+    if (memory_store_.max > stripe.max) {
+      LOG(kError) << "Max memory usage must be < max disk usage of " << stripe.path;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    total_disk_usage += stripe.max.data;
+  }
+  disk_store_.max = DiskUsage(total_disk_usage);
+  if (stripes_.size() > 1 && kOptions_.disk_layout == DiskLayout::kSegmentedLog) {
+    LOG(kError) << "The segmented log layout only supports a single disk directory.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
   }
-  boost::system::error_code error_code;
-  if (!fs::exists(kDiskBuffer_, error_code)) {
-    if (!fs::create_directories(kDiskBuffer_, error_code)) {
-      LOG(kError) << "Can't create disk root at " << kDiskBuffer_ << ": " << error_code.message();
+  if (kOptions_.compression_level > crypto::kMaxCompressionLevel) {
+    LOG(kError) << "Compression level must not exceed " << crypto::kMaxCompressionLevel;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (kOptions_.flush_worker_count == 0 || kOptions_.flush_batch_size == 0) {
+    LOG(kError) << "Flush worker count and batch size must be at least 1.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (kOptions_.disk_layout != DiskLayout::kFilePerKey &&
+      kOptions_.disk_layout != DiskLayout::kSegmentedLog) {
+    LOG(kError) << "Invalid disk layout.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  for (const auto& stripe : stripes_) {
+    boost::system::error_code error_code;
+    if (!fs::exists(stripe.path, error_code)) {
+      if (!fs::create_directories(stripe.path, error_code)) {
+        LOG(kError) << "Can't create disk root at " << stripe.path << ": "
+                    << error_code.message();
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+        return;
+      }
+    }
+    // Check the directory is writable
+    auto test_file(stripe.path / "TestFile");
+    if (!WriteFile(test_file, convert::ToByteVector("Test"))) {
+      LOG(kError) << "Can't write file " << test_file;
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
       return;
     }
+    fs::remove(test_file);
   }
-  // Check kDiskBuffer_ is writable
-  auto test_file(kDiskBuffer_ / "TestFile");
-  if (!WriteFile(test_file, convert::ToByteVector("Test"))) {
-    LOG(kError) << "Can't write file " << test_file;
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
-    return;
+  if (stripes_.size() > 1) {
+    // Each directory gets ring positions in proportion to its limit, derived from its index
+    // rather than its path so that moving a directory doesn't reassign its keys.
+    const uint64_t kAveragePositions(64);
+    for (size_t i(0); i != stripes_.size(); ++i) {
+      const uint64_t positions(std::max<uint64_t>(
+          1, static_cast<uint64_t>(static_cast<double>(kAveragePositions * stripes_.size()) *
+                                   static_cast<double>(stripes_[i].max.data) /
+                                   static_cast<double>(total_disk_usage))));
+      for (uint64_t j(0); j != positions; ++j)
+        stripe_ring_.emplace_back(SplitMix64((static_cast<uint64_t>(i) << 32) | j), i);
+    }
+    std::sort(std::begin(stripe_ring_), std::end(stripe_ring_));
+  }
+  if (kOptions_.disk_layout == DiskLayout::kSegmentedLog) {
+    segmented_log_.reset(new detail::SegmentedLog(kDiskBuffer_, kOptions_.segment_size,
+                                                  kOptions_.compaction_threshold,
+                                                  kOptions_.recover_disk_buffer));
+  }
+  if (kOptions_.recover_disk_buffer)
+    RecoverDiskIndex();
+  for (size_t stripe(0); stripe != stripes_.size(); ++stripe) {
+    for (size_t i(0); i < kOptions_.flush_worker_count; ++i) {
+      workers_.emplace_back(
+          std::async(std::launch::async, &DataBuffer::CopyQueueToDisk, this, stripe));
+    }
+  }
+}
+
+size_t DataBuffer::StripeOf(const KeyType& key) const {
+  if (stripe_ring_.empty())
+    return 0;
+  // Names are hashes, so their leading bytes are already uniformly distributed.
+  const std::string& name(key.name.string());
+  uint64_t position(0);
+  for (size_t i(0); i != std::min<size_t>(8, name.size()); ++i)
+    position = (position << 8) | static_cast<byte>(name[i]);
+  auto itr(std::lower_bound(std::begin(stripe_ring_), std::end(stripe_ring_),
+                            std::make_pair(position, size_t(0))));
+  return itr == std::end(stripe_ring_) ? stripe_ring_.front().second : itr->second;
+}
+
+void DataBuffer::ReserveDiskSpace(const KeyType& key, uint64_t size) {
+  stripes_[StripeOf(key)].current.data += size;
+  disk_store_.current.data += size;
+}
+
+void DataBuffer::ReleaseDiskSpace(const KeyType& key, uint64_t size) {
+  stripes_[StripeOf(key)].current.data -= size;
+  disk_store_.current.data -= size;
+}
+
+bool DataBuffer::HasDiskSpace(const KeyType& key, uint64_t required_space) const {
+  return HasSpace(stripes_[StripeOf(key)], required_space);
+}
+
+void DataBuffer::RecoverDiskIndex() {
+  std::vector<std::pair<KeyType, uint64_t>> values;
+  if (segmented_log_) {
+    values = segmented_log_->Values();
+  } else {
+    // Order by last write time, breaking ties by name so that the order is at least deterministic.
+    std::vector<std::tuple<std::time_t, fs::path, KeyType, uint64_t>> files;
+    boost::system::error_code error_code;
+    for (size_t stripe(0); stripe != stripes_.size(); ++stripe) {
+      for (fs::directory_iterator itr(stripes_[stripe].path), end; itr != end; ++itr) {
+        if (!fs::is_regular_file(itr->status()))
+          continue;
+        KeyType key;
+        try {
+          key = detail::GetDataNameAndTypeId(itr->path().filename());
+        } catch (const std::exception&) {
+          continue;
+        }
+        if (detail::GetFileName(key) != itr->path().filename())
+          continue;
+        const auto size(fs::file_size(itr->path(), error_code));
+        const auto write_time(fs::last_write_time(itr->path(), error_code));
+        if (error_code || size == 0 || StripeOf(key) != stripe) {
+          LOG(kWarning) << "Ignoring " << itr->path() << " in disk buffer.";
+          continue;
+        }
+        files.emplace_back(write_time, itr->path().filename(), std::move(key), size);
+      }
+    }
+    std::sort(std::begin(files), std::end(files),
+              [](const std::tuple<std::time_t, fs::path, KeyType, uint64_t>& lhs,
+                 const std::tuple<std::time_t, fs::path, KeyType, uint64_t>& rhs) {
+      return std::tie(std::get<0>(lhs), std::get<1>(lhs)) <
+             std::tie(std::get<0>(rhs), std::get<1>(rhs));
+    });
+    for (auto& file : files)
+      values.emplace_back(std::move(std::get<2>(file)), std::get<3>(file));
   }
-  fs::remove(test_file);
-  worker_ = std::async(std::launch::async, &DataBuffer::CopyQueueToDisk, this);
+
+  for (const auto& value : values) {
+    disk_store_.index.emplace_back(value.first, RankOf(value.first), disk_store_.next_stamp++);
+    disk_store_.index.back().state = StoringState::kCompleted;
+    ReserveDiskSpace(value.first, value.second);
+  }
+  LOG(kVerbose) << "Recovered " << values.size() << " values totalling "
+                << disk_store_.current.data << " bytes from " << kDiskBuffer_;
 }
 
 DataBuffer::~DataBuffer() {
@@ -87,46 +363,76 @@ DataBuffer::~DataBuffer() {
   }
   {
     std::unique_lock<std::mutex> worker_lock(worker_mutex_);
-    while (worker_.valid() &&
-           worker_.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
-      worker_lock.unlock();
-      memory_store_.cond_var.notify_all();
-      disk_store_.cond_var.notify_all();
-      std::this_thread::yield();
-      worker_lock.lock();
-    }
-    if (worker_.valid()) {
-      try {
-        worker_.get();
-      } catch (const std::exception& e) {
-        LOG(kError) << boost::diagnostic_information(e);
+    for (auto& worker : workers_) {
+      while (worker.valid() &&
+             worker.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
+        worker_lock.unlock();
+        memory_store_.cond_var.notify_all();
+        disk_store_.cond_var.notify_all();
+        std::this_thread::yield();
+        worker_lock.lock();
+      }
+      if (worker.valid()) {
+        try {
+          worker.get();
+        } catch (const std::exception& e) {
+          LOG(kError) << boost::diagnostic_information(e);
+        }
       }
     }
   }
 
+  {
+    std::lock_guard<std::mutex> async_store_lock(async_store_mutex_);
+  }
+  async_store_cond_var_.notify_all();
+  if (async_store_worker_.valid())
+    async_store_worker_.wait();
+
+  segmented_log_.reset();
   if (kShouldRemoveRoot_) {
-    boost::system::error_code error_code;
-    fs::remove_all(kDiskBuffer_, error_code);
-    if (error_code)
-      LOG(kWarning) << "Failed to remove " << kDiskBuffer_ << ": " << error_code.message();
+    for (const auto& stripe : stripes_) {
+      boost::system::error_code error_code;
+      fs::remove_all(stripe.path, error_code);
+      if (error_code)
+        LOG(kWarning) << "Failed to remove " << stripe.path << ": " << error_code.message();
+    }
   }
 }
 
 void DataBuffer::Store(const KeyType& key, const NonEmptyString& value) {
-  try {
-    Delete(key);
-  } catch (const std::exception&) {
+  DoStore(key, value, nullptr);
+}
+
+void DataBuffer::Store(const KeyType& key, SharedBuffer value) {
+  auto shared_value(value.ToSharedString());
+  const NonEmptyString& contents(*shared_value);
+  DoStore(key, contents, std::move(shared_value));
+}
+
+void DataBuffer::DoStore(const KeyType& key, const NonEmptyString& value,
+                         std::shared_ptr<const NonEmptyString> shared_value) {
+  if (!TryDelete(key))
     LOG(kVerbose) << "Storing " << DebugKeyName(key) << " with value " << value;
-  }
 
   CheckWorkerIsStillRunning();
-  auto disk_store_lock(StoreInMemory(key, value));
-  if (disk_store_lock)
-    StoreOnDisk(key, value, std::move(disk_store_lock));
+  auto disk_store_lock(StoreInMemory(key, value, shared_value));
+  if (disk_store_lock) {
+    // Values with the same key share a file, so only one of them may be written at a time.
+    disk_store_.cond_var.wait(disk_store_lock, [this, &key]() -> bool {
+      return FindInFlightOnDisk(key) == disk_store_.index.end() || !running_;
+    });
+    if (!running_)
+      return;
+    disk_store_.index.emplace_back(key, RankOf(key), disk_store_.next_stamp++);
+    disk_store_lock.unlock();
+    StoreOnDisk(DiskWriteBatch(1, std::make_pair(key, &value)));
+  }
 }
 
-std::unique_lock<std::mutex> DataBuffer::StoreInMemory(const KeyType& key,
-                                                       const NonEmptyString& value) {
+std::unique_lock<std::mutex> DataBuffer::StoreInMemory(
+    const KeyType& key, const NonEmptyString& value,
+    std::shared_ptr<const NonEmptyString> shared_value) {
   {
     uint64_t required_space(value.string().size());
     std::unique_lock<std::mutex> memory_store_lock(memory_store_.mutex);
@@ -138,70 +444,220 @@ std::unique_lock<std::mutex> DataBuffer::StoreInMemory(const KeyType& key,
     if (!running_) {
       {
         std::lock_guard<std::mutex> worker_lock(worker_mutex_);
-        if (worker_.valid())
-          worker_.get();
+        for (auto& worker : workers_) {
+          if (worker.valid())
+            worker.get();
+        }
       }
       return std::move(std::unique_lock<std::mutex>());
     }
 
     memory_store_.current.data += required_space;
-    memory_store_.index.emplace_back(key, value);
+    if (shared_value)
+      memory_store_.index.emplace_back(key, std::move(shared_value), RankOf(key),
+                                       memory_store_.next_stamp++);
+    else
+      memory_store_.index.emplace_back(key, value, RankOf(key), memory_store_.next_stamp++);
   }
   memory_store_.cond_var.notify_all();
   return std::move(std::unique_lock<std::mutex>());
 }
 
+bool DataBuffer::TryStoreInMemory(const KeyType& key, const NonEmptyString& value) {
+  {
+    const uint64_t required_space(value.string().size());
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    if (!running_ || required_space > memory_store_.max)
+      return false;
+    while (!HasSpace(memory_store_, required_space)) {
+      auto itr(FindFirstAlsoOnDisk());
+      if (itr == memory_store_.index.end())
+        return false;
+      EraseFromMemory(itr);
+    }
+    memory_store_.current.data += required_space;
+    memory_store_.index.emplace_back(key, value, RankOf(key), memory_store_.next_stamp++);
+  }
+  memory_store_.cond_var.notify_all();
+  return true;
+}
+
+void DataBuffer::AsyncStore(const KeyType& key, NonEmptyString value, Executor executor,
+                            StoreHandler handler) {
+  {
+    // Held until the request is either stored or queued, so that a concurrent call can't store
+    // its value ahead of requests already queued.
+    std::unique_lock<std::mutex> async_store_lock(async_store_mutex_);
+    if (async_stores_.empty() && !async_store_busy_) {
+      try {
+        Delete(key);
+      } catch (const std::exception&) {
+        LOG(kVerbose) << "Storing " << DebugKeyName(key) << " with value " << value;
+      }
+      if (TryStoreInMemory(key, value)) {
+        async_store_lock.unlock();
+        executor([handler] { handler(std::error_code()); });
+        return;
+      }
+    }
+    async_stores_.push_back(
+        AsyncStoreRequest{key, std::move(value), std::move(executor), std::move(handler)});
+    if (!async_store_worker_.valid()) {
+      async_store_worker_ =
+          std::async(std::launch::async, &DataBuffer::ServiceAsyncStores, this);
+    }
+  }
+  async_store_cond_var_.notify_one();
+}
+
+void DataBuffer::ServiceAsyncStores() {
+  for (;;) {
+    std::unique_ptr<AsyncStoreRequest> request;
+    {
+      std::unique_lock<std::mutex> async_store_lock(async_store_mutex_);
+      async_store_busy_ = false;
+      async_store_cond_var_.wait(async_store_lock,
+                                 [this] { return !async_stores_.empty() || !running_; });
+      if (async_stores_.empty())
+        return;
+      request = make_unique<AsyncStoreRequest>(std::move(async_stores_.front()));
+      async_stores_.pop_front();
+      async_store_busy_ = true;
+    }
+    std::error_code error(make_error_code(CommonErrors::unable_to_handle_request));
+    if (running_)
+      error = ErrorOf([&] { Store(request->key, request->value); });
+    // Store returns without storing if the buffer is destroyed while it's waiting for space.
+    if (!error && !running_)
+      error = make_error_code(CommonErrors::unable_to_handle_request);
+    auto handler(std::move(request->handler));
+    request->executor([handler, error] { handler(error); });
+  }
+}
+
 void DataBuffer::WaitForSpaceInMemory(uint64_t required_space,
                                       std::unique_lock<std::mutex>& memory_store_lock) {
+  if (HasSpace(memory_store_, required_space))
+    return;
+  const auto wait_start(TscClock::now());
+  on_scope_exit record_wait([&] {
+    std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+    stats_.memory_wait.Record(TscClock::now() - wait_start);
+  });
   while (!HasSpace(memory_store_, required_space)) {
     auto itr(FindMemoryRemovalCandidate(required_space, memory_store_lock));
     if (!running_)
       return;
 
-    if (itr != memory_store_.index.end()) {
-      memory_store_.current.data -= (*itr).value.string().size();
-      memory_store_.index.erase(itr);
-    }
+    if (itr != memory_store_.index.end())
+      EraseFromMemory(itr);
   }
 }
 
-void DataBuffer::StoreOnDisk(const KeyType& key, const NonEmptyString& value,
-                             std::unique_lock<std::mutex>&& disk_store_lock) {
-  assert(disk_store_lock);
-  if (value.string().size() > disk_store_.max) {
-    LOG(kError) << "Cannot store " << DebugKeyName(key) << " since its " << value.string().size()
-                << " bytes exceeds max of " << disk_store_.max << " bytes.";
-    StopRunning();
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+void DataBuffer::StoreOnDisk(const DiskWriteBatch& batch) {
+  // Compress the batch first, since the space to reserve depends on the compressed sizes.
+  std::vector<NonEmptyString> encoded;
+  if (kOptions_.compress_on_disk) {
+    encoded.reserve(batch.size());
+    for (const auto& element : batch)
+      encoded.push_back(EncodeForDisk(*element.second, kOptions_.compression_level));
   }
-  disk_store_.index.emplace_back(key);
+  auto stored_value([&](size_t index) -> const NonEmptyString & {
+    return kOptions_.compress_on_disk ? encoded[index] : *batch[index].second;
+  });
 
-  bool cancelled(false);
-  WaitForSpaceOnDisk(key, &value, disk_store_lock, cancelled);
-  if (!running_)
-    return;
+  // Reserve space for the whole batch, then write it without holding the lock so that other
+  // workers and callers of Get and Delete can proceed concurrently.
+  std::vector<size_t> reserved;
+  {
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+    for (size_t i(0); i != batch.size(); ++i) {
+      const auto& key(batch[i].first);
+      const auto size(stored_value(i).string().size());
+      const auto& max(stripes_[StripeOf(key)].max);
+      if (size > max) {
+        LOG(kError) << "Cannot store " << DebugKeyName(key) << " since its " << size
+                    << " bytes exceeds max of " << max << " bytes.";
+        StopRunning();
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+      }
+      bool cancelled(false);
+      WaitForSpaceOnDisk(key, batch[i].second, size, disk_store_lock, cancelled);
+      if (!running_)
+        break;
+      if (!cancelled) {
+        ReserveDiskSpace(key, size);
+        FindInFlightOnDisk(key)->writing = true;
+        reserved.push_back(i);
+      }
+    }
+  }
+
+  const auto write_start(TscClock::now());
+  std::vector<fs::path> written;
+  uint64_t bytes_written(0);
+  bool failed(!running_);
+  for (auto itr(std::begin(reserved)); !failed && itr != std::end(reserved); ++itr) {
+    if (!WriteToDisk(batch[*itr].first, stored_value(*itr), written)) {
+      LOG(kError) << "Failed to move " << DebugKeyName(batch[*itr].first) << " to disk.";
+      failed = true;
+    }
+    bytes_written += stored_value(*itr).string().size();
+  }
+  if (!failed && kOptions_.sync_on_flush && !SyncToDisk(written)) {
+    LOG(kError) << "Failed to sync " << reserved.size() << " values to disk.";
+    failed = true;
+  }
+  const auto write_time(TscClock::now() - write_start);
+
+  {
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    for (const auto index : reserved)
+      CompleteStoreOnDisk(batch[index].first, stored_value(index).string().size(), failed);
+  }
+  disk_store_.cond_var.notify_all();
 
-  if (!cancelled) {
-    if (!WriteFile(GetFilename(key), value.string())) {
-      LOG(kError) << "Failed to move " << DebugKeyName(key) << " to disk.";
+  if (failed) {
+    if (running_) {
       StopRunning();
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
     }
-    auto itr(FindStartedToStoreOnDisk(key));
-    if (itr != disk_store_.index.end())
-      (*itr).state = StoringState::kCompleted;
+    return;
+  }
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+  stats_.flush.values_flushed += reserved.size();
+  stats_.flush.bytes_flushed += bytes_written;
+  ++stats_.flush.batches_flushed;
+  stats_.flush.write_time += write_time;
+}
 
-    disk_store_.current.data += value.string().size();
+void DataBuffer::CompleteStoreOnDisk(const KeyType& key, uint64_t size, bool failed) {
+  auto itr(FindInFlightOnDisk(key));
+  if (itr == disk_store_.index.end())
+    return;
+  if (failed || (*itr).state == StoringState::kCancelled) {
+    // Deleted while being written, or the write failed - either way release the reserved space.
+    EraseFromDisk(key);
+    ReleaseDiskSpace(key, size);
+    disk_store_.index.erase(itr);
+  } else {
+    (*itr).state = StoringState::kCompleted;
   }
-  disk_store_lock.unlock();
-  disk_store_.cond_var.notify_all();
 }
 
 void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* const value,
+                                    uint64_t required_space,
                                     std::unique_lock<std::mutex>& disk_store_lock,
                                     bool& cancelled) {
-  while (!HasSpace(disk_store_, value->string().size()) && running_) {
-    auto itr(Find(disk_store_, key));
+  if (HasDiskSpace(key, required_space) || !running_)
+    return;
+  const auto wait_start(TscClock::now());
+  on_scope_exit record_wait([&] {
+    std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+    stats_.disk_wait.Record(TscClock::now() - wait_start);
+  });
+  while (!HasDiskSpace(key, required_space) && running_) {
+    auto itr(FindInFlightOnDisk(key));
     if (itr == disk_store_.index.end()) {
       cancelled = true;
       return;
@@ -214,14 +670,21 @@ void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* co
     }
 
     if (kPopFunctor_) {
-      itr = FindOldestOnDisk();
-      assert((*itr).state != StoringState::kStarted);
-      if ((*itr).state == StoringState::kCompleted) {
+      itr = FindFirstOnDisk(StripeOf(key));
+      if (itr != disk_store_.index.end()) {
+        const auto pop_start(TscClock::now());
         KeyType oldest_key(itr->key);
         NonEmptyString oldest_value;
         RemoveFile(oldest_key, &oldest_value);
         disk_store_.index.erase(itr);
         kPopFunctor_(oldest_key, oldest_value);
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        ++stats_.pops;
+        stats_.pop_latency.Record(TscClock::now() - pop_start);
+      } else if (running_) {
+        // All the disk space is reserved by pinned values or values which other workers are still
+        // writing.
+        disk_store_.cond_var.wait(disk_store_lock);
       }
     } else {
       // Rely on client of this class to call Delete until enough space becomes available.  Make the
@@ -237,69 +700,138 @@ void DataBuffer::WaitForSpaceOnDisk(const KeyType& key, const NonEmptyString* co
 }
 
 NonEmptyString DataBuffer::Get(const KeyType& key) {
+  auto result(TryGet(key));
+  if (!result)
+    BOOST_THROW_EXCEPTION(result.error());
+  return std::move(*result);
+}
+
+boost::expected<NonEmptyString, common_error> DataBuffer::TryGet(const KeyType& key) {
+  CheckWorkerIsStillRunning();
+  ObserveLookup(key);
+  std::unique_lock<std::mutex> disk_store_lock;
+  auto value(FindValueOrWaitForDisk(key, disk_store_lock));
+  if (!value)
+    return boost::make_unexpected(value.error());
+  if (*value)
+    return **value;
+  auto result(ReadFromDisk(key));
+  if (result) {
+    RecordLookup(&Stats::disk_hits);
+    if (kOptions_.eviction_policy == EvictionPolicy::kClock && ReferenceOnDisk(key)) {
+      disk_store_lock.unlock();
+      PromoteToMemory(key, *result);
+    }
+  }
+  return result;
+}
+
+DataBuffer::ValueView DataBuffer::GetView(const KeyType& key) {
   CheckWorkerIsStillRunning();
+  ObserveLookup(key);
+  std::unique_lock<std::mutex> disk_store_lock;
+  auto value(FindValueOrWaitForDisk(key, disk_store_lock));
+  if (!value)
+    BOOST_THROW_EXCEPTION(value.error());
+  if (*value)
+    return MakeView(std::move(*value));
+  auto result(MapFromDisk(key));
+  if (!result)
+    BOOST_THROW_EXCEPTION(result.error());
+  RecordLookup(&Stats::disk_hits);
+  return std::move(*result);
+}
+
+boost::expected<std::shared_ptr<const NonEmptyString>, common_error>
+DataBuffer::FindValueOrWaitForDisk(const KeyType& key,
+                                   std::unique_lock<std::mutex>& disk_store_lock) {
   {
     std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
     auto itr(Find(memory_store_, key));
-    if (itr != memory_store_.index.end())
+    if (itr != memory_store_.index.end()) {
+      (*itr).referenced = true;
+      RecordLookup(&Stats::memory_hits);
       return (*itr).value;
+    }
   }
-  std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
-  auto itr(FindAndThrowIfCancelled(key));
+  disk_store_lock = std::unique_lock<std::mutex>(disk_store_.mutex);
+  auto itr(FindIfNotCancelled(key));
+  if (itr == disk_store_.index.end())
+    return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
   if ((*itr).state == StoringState::kStarted) {
     auto temp_itr(elements_being_moved_to_disk_.find(key));
-    if (temp_itr != std::end(elements_being_moved_to_disk_))
-      return *temp_itr->second;
+    if (temp_itr != std::end(elements_being_moved_to_disk_)) {
+      RecordLookup(&Stats::memory_hits);
+      return std::make_shared<const NonEmptyString>(*temp_itr->second);
+    }
     disk_store_.cond_var.wait(disk_store_lock, [this, &key]() -> bool {
       auto itr(Find(disk_store_, key));
       return (itr == disk_store_.index.end() || (*itr).state != StoringState::kStarted);
     });
-    itr = FindAndThrowIfCancelled(key);
+    if (FindIfNotCancelled(key) == disk_store_.index.end())
+      return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
   }
-  auto result(ReadFile(GetFilename(key)));
-  if (result)
-    return NonEmptyString(*result);
-  else
-    BOOST_THROW_EXCEPTION(result.error());
-  // TODO(Fraser#5#): 2012-11-23 - There should maybe be another background task moving the item
-  //                               from wherever it's found to the back of the memory index.
+  return std::shared_ptr<const NonEmptyString>();
+}
+
+void DataBuffer::AsyncGet(const KeyType& key, Executor executor, GetHandler handler) {
+  std::shared_ptr<const NonEmptyString> value;
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    auto itr(Find(memory_store_, key));
+    if (itr != memory_store_.index.end()) {
+      (*itr).referenced = true;
+      value = (*itr).value;
+    }
+  }
+  if (value) {
+    ObserveLookup(key);
+    RecordLookup(&Stats::memory_hits);
+    executor([handler, value] { handler(std::error_code(), *value); });
+    return;
+  }
+  // Otherwise the lookup is observed by TryGet.
+  executor([this, key, handler] {
+    boost::expected<NonEmptyString, common_error> result(
+        boost::make_unexpected(MakeError(CommonErrors::unknown)));
+    std::error_code error(ErrorOf([&] { result = TryGet(key); }));
+    if (!error && !result)
+      error = result.error().code();
+    handler(error, result ? std::move(*result) : NonEmptyString());
+  });
 }
 
 void DataBuffer::Delete(const KeyType& key) {
+  if (!TryDelete(key)) {
+    LOG(kWarning) << DebugKeyName(key) << " is not in the disk index.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  }
+}
+
+bool DataBuffer::TryDelete(const KeyType& key) {
   CheckWorkerIsStillRunning();
   StoringState also_on_disk(StoringState::kNotStarted);
   DeleteFromMemory(key, also_on_disk);
-  if (also_on_disk != StoringState::kNotStarted)
-    DeleteFromDisk(key);
+  return also_on_disk == StoringState::kNotStarted || DeleteFromDisk(key);
 }
 
 void DataBuffer::Delete(std::function<bool(const KeyType&)> predicate) {
   CheckWorkerIsStillRunning();
+  // The disk store goes first, so that a value can't be promoted back into memory in between.
   {
-    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
-    auto before_size(memory_store_.index.size());
-    memory_store_.index.erase(std::remove_if(std::begin(memory_store_.index),
-                                             std::end(memory_store_.index),
-                                             [&](const MemoryElement& item) {
-                                if (predicate(item.key)) {
-                                  memory_store_.current.data -= item.value.string().size();
-                                  return true;
-                                } else {
-                                  return false;
-                                }
-                              }),
-                              std::end(memory_store_.index));
-    if (memory_store_.index.size() != before_size)
-      memory_store_.cond_var.notify_all();
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    auto before_size(disk_store_.index.size());
+    for (auto itr(disk_store_.index.begin()); itr != disk_store_.index.end();)
+      itr = predicate((*itr).key) ? disk_store_.index.erase(itr) : std::next(itr);
+    if (disk_store_.index.size() != before_size)
+      disk_store_.cond_var.notify_all();
   }
-  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
-  auto before_size(disk_store_.index.size());
-  disk_store_.index.erase(
-      std::remove_if(std::begin(disk_store_.index), std::end(disk_store_.index),
-                     [&](const DiskElement& item) { return predicate(item.key); }),
-      std::end(disk_store_.index));
-  if (disk_store_.index.size() != before_size)
-    disk_store_.cond_var.notify_all();
+  std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+  auto before_size(memory_store_.index.size());
+  for (auto itr(memory_store_.index.begin()); itr != memory_store_.index.end();)
+    itr = predicate((*itr).key) ? EraseFromMemory(itr) : std::next(itr);
+  if (memory_store_.index.size() != before_size)
+    memory_store_.cond_var.notify_all();
 }
 
 void DataBuffer::DeleteFromMemory(const KeyType& key, StoringState& also_on_disk) {
@@ -309,8 +841,7 @@ void DataBuffer::DeleteFromMemory(const KeyType& key, StoringState& also_on_disk
     auto itr(Find(memory_store_, key));
     if (itr != memory_store_.index.end()) {
       also_on_disk = (*itr).also_on_disk;
-      memory_store_.current.data -= (*itr).value.string().size();
-      memory_store_.index.erase(itr);
+      EraseFromMemory(itr);
       changed = true;
     } else {
       // Assume it's on disk so as to invoke a DeleteFromDisk
@@ -321,74 +852,219 @@ void DataBuffer::DeleteFromMemory(const KeyType& key, StoringState& also_on_disk
     memory_store_.cond_var.notify_all();
 }
 
-void DataBuffer::DeleteFromDisk(const KeyType& key) {
+DataBuffer::MemoryIndex::iterator DataBuffer::EraseFromMemory(MemoryIndex::iterator itr) {
+  memory_store_.current.data -= (*itr).value->string().size();
+  if ((*itr).promoted) {
+    // The disk copy may be popped again.
+    {
+      std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+      auto disk_itr(Find(disk_store_, (*itr).key));
+      if (disk_itr != disk_store_.index.end())
+        (*disk_itr).promoted = false;
+    }
+    disk_store_.cond_var.notify_all();
+  }
+  return memory_store_.index.erase(itr);
+}
+
+bool DataBuffer::DeleteFromDisk(const KeyType& key) {
+  bool promoted(false);
   {
-    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
     auto itr(Find(disk_store_, key));
-    if (itr == disk_store_.index.end()) {
-      LOG(kWarning) << DebugKeyName(key) << " is not in the disk index.";
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
-    }
+    if (itr == disk_store_.index.end())
+      return false;
 
     if ((*itr).state == StoringState::kStarted) {
       (*itr).state = StoringState::kCancelled;
+      // If the value is currently being written, wait for the worker to remove the file again.
+      disk_store_.cond_var.wait(disk_store_lock, [this, &key]() -> bool {
+        auto itr(FindInFlightOnDisk(key));
+        return itr == disk_store_.index.end() || !(*itr).writing || !running_;
+      });
     } else if ((*itr).state == StoringState::kCompleted) {
+      promoted = (*itr).promoted;
       RemoveFile(itr->key, nullptr);
       disk_store_.index.erase(itr);
     }
   }
   disk_store_.cond_var.notify_all();
+  if (promoted) {
+    // The value was promoted into memory after DeleteFromMemory had run.
+    {
+      std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+      auto itr(Find(memory_store_, key));
+      if (itr != memory_store_.index.end() && (*itr).promoted)
+        EraseFromMemory(itr);
+    }
+    memory_store_.cond_var.notify_all();
+  }
+  return true;
 }
 
 void DataBuffer::RemoveFile(const KeyType& key, NonEmptyString* value) {
-  auto path(GetFilename(key));
-  boost::system::error_code error_code;
-  uint64_t size(fs::file_size(path, error_code));
-  if (error_code) {
-    LOG(kError) << "Error getting file size of " << path << ": " << error_code.message();
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-  }
   if (value) {
-    auto contents(ReadFile(path));
+    auto contents(ReadFromDisk(key));
     if (contents)
-      *value = NonEmptyString(std::move(*contents));
+      *value = std::move(*contents);
     else
       BOOST_THROW_EXCEPTION(contents.error());
   }
-  if (!fs::remove(path, error_code) || error_code) {
-    LOG(kError) << "Error removing " << path << ": " << error_code.message();
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  uint64_t size(0);
+  if (segmented_log_) {
+    auto removed(segmented_log_->Delete(key));
+    if (!removed) {
+      LOG(kError) << "Error removing " << DebugKeyName(key) << " from segmented log.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+    size = *removed;
+  } else {
+    auto path(GetFilename(key));
+    boost::system::error_code error_code;
+    size = fs::file_size(path, error_code);
+    if (error_code) {
+      LOG(kError) << "Error getting file size of " << path << ": " << error_code.message();
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+    if (!fs::remove(path, error_code) || error_code) {
+      LOG(kError) << "Error removing " << path << ": " << error_code.message();
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+  }
+  ReleaseDiskSpace(key, size);
+}
+
+bool DataBuffer::WriteToDisk(const KeyType& key, const NonEmptyString& value,
+                             std::vector<fs::path>& written) {
+  if (segmented_log_)
+    return segmented_log_->Put(key, value);
+  written.emplace_back(GetFilename(key));
+  return WriteFile(written.back(), value.string());
+}
+
+bool DataBuffer::SyncToDisk(const std::vector<fs::path>& written) {
+  if (segmented_log_)
+    return segmented_log_->Sync();
+  // Each batch is written by a single directory's worker.
+  return detail::SyncToDisk(written,
+                           written.empty() ? kDiskBuffer_ : written.front().parent_path());
+}
+
+boost::expected<NonEmptyString, common_error> DataBuffer::ReadFromDisk(const KeyType& key) {
+  auto contents(segmented_log_ ? segmented_log_->Get(key) : ReadFile(GetFilename(key)));
+  if (!contents)
+    return boost::make_unexpected(contents.error());
+  if (kOptions_.compress_on_disk)
+    return DecodeFromDisk(contents->data(), contents->size());
+  return NonEmptyString(std::move(*contents));
+}
+
+boost::expected<DataBuffer::ValueView, common_error> DataBuffer::MapFromDisk(const KeyType& key) {
+  boost::expected<detail::MappedValue, common_error> mapped(
+      boost::make_unexpected(MakeError(CommonErrors::no_such_element)));
+  if (segmented_log_) {
+    mapped = segmented_log_->Map(key);
+  } else {
+#ifdef MAIDSAFE_WIN32
+    // A mapped file can't be removed on Windows, which would cause Delete to fail while the view is
+    // alive, so read the file instead.
+    auto value(ReadFromDisk(key));
+    if (!value)
+      return boost::make_unexpected(value.error());
+    return MakeView(std::make_shared<const NonEmptyString>(std::move(*value)));
+#else
+    // The mapping remains valid even if the file is subsequently removed.
+    auto path(GetFilename(key));
+    boost::system::error_code error_code;
+    const auto size(fs::file_size(path, error_code));
+    if (error_code) {
+      LOG(kError) << "Error getting file size of " << path << ": " << error_code.message();
+      return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
+    }
+    mapped = detail::MapFile(path, 0, size);
+#endif
+  }
+  if (!mapped)
+    return boost::make_unexpected(mapped.error());
+  auto data(mapped->data.get());
+  auto size(mapped->size);
+  if (kOptions_.compress_on_disk) {
+    if (size < 2 || data[0] != kStoredRaw) {
+      // Compressed values have to be decoded into a buffer of their own.
+      auto value(DecodeFromDisk(data, size));
+      if (!value)
+        return boost::make_unexpected(value.error());
+      return MakeView(std::make_shared<const NonEmptyString>(std::move(*value)));
+    }
+    ++data;
+    --size;
+  }
+  return ValueView(std::move(mapped->data), data, size);
+}
+
+void DataBuffer::EraseFromDisk(const KeyType& key) {
+  if (segmented_log_) {
+    segmented_log_->Delete(key);
+  } else {
+    boost::system::error_code error_code;
+    fs::remove(GetFilename(key), error_code);
   }
-  disk_store_.current.data -= size;
 }
 
-void DataBuffer::CopyQueueToDisk() {
-  KeyType key;
-  NonEmptyString value;
+void DataBuffer::CopyQueueToDisk(size_t stripe) {
+  // Holds the claimed values alive even if they're evicted from memory while being written.
+  std::vector<std::shared_ptr<const NonEmptyString>> values;
+  DiskWriteBatch batch;
+  values.reserve(kOptions_.flush_batch_size);
+  batch.reserve(kOptions_.flush_batch_size);
   for (;;) {
+    values.clear();
+    batch.clear();
     {
-      // Get oldest value not yet stored to disk
+      // Claim the first values in eviction order not yet stored to disk.  They're added to the disk
+      // index before the memory index is unlocked so that they can't be missed by a concurrent
+      // Delete.
       std::unique_lock<std::mutex> memory_store_lock(memory_store_.mutex);
-      auto itr(memory_store_.index.end());
+      auto& eviction_order(memory_store_.index.get<2>());
+      auto itr(eviction_order.end());
 
-      memory_store_.cond_var.wait(memory_store_lock, [this, &itr]() -> bool {
-        itr = FindOldestInMemoryOnly();
-        return itr != memory_store_.index.end() || !running_;
+      memory_store_.cond_var.wait(memory_store_lock,
+                                  [this, &itr, &eviction_order, stripe]() -> bool {
+        itr = FindFirstInMemoryOnly(stripe);
+        return itr != eviction_order.end() || !running_;
       });
       if (!running_)
         return;
 
-      assert(itr != memory_store_.index.end());
-      key = (*itr).key;
-      value = (*itr).value;
-      (*itr).also_on_disk = StoringState::kStarted;
       std::unique_lock<std::mutex> disk_store_lock(disk_store_.mutex);
+      for (; itr != eviction_order.end() && batch.size() < kOptions_.flush_batch_size; ++itr) {
+        // Values with the same key share a file, so only one of them may be written at a time.
+        if ((*itr).also_on_disk != StoringState::kNotStarted || StripeOf((*itr).key) != stripe ||
+            FindInFlightOnDisk((*itr).key) != disk_store_.index.end()) {
+          continue;
+        }
+        (*itr).also_on_disk = StoringState::kStarted;
+        disk_store_.index.emplace_back((*itr).key, (*itr).rank, disk_store_.next_stamp++);
+        values.push_back((*itr).value);
+        batch.emplace_back((*itr).key, values.back().get());
+      }
       memory_store_lock.unlock();
-      StoreOnDisk(key, value, std::move(disk_store_lock));
-      memory_store_lock.lock();
-      itr = Find(memory_store_, key);
-      if (itr != memory_store_.index.end())
-        (*itr).also_on_disk = StoringState::kCompleted;
+      if (batch.empty()) {
+        // Everything unclaimed is waiting for an earlier value with the same key to be written.
+        disk_store_.cond_var.wait(disk_store_lock);
+        continue;
+      }
+    }
+
+    StoreOnDisk(batch);
+
+    {
+      std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+      for (const auto& element : batch) {
+        auto itr(Find(memory_store_, element.first));
+        if (itr != memory_store_.index.end() && (*itr).also_on_disk == StoringState::kStarted)
+          (*itr).also_on_disk = StoringState::kCompleted;
+      }
     }
     memory_store_.cond_var.notify_all();
   }
@@ -398,8 +1074,10 @@ void DataBuffer::CheckWorkerIsStillRunning() {
   // if this goes ready then we have an exception so get that (throw basically)
   {
     std::lock_guard<std::mutex> worker_lock(worker_mutex_);
-    if (worker_.valid() && worker_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-      worker_.get();
+    for (auto& worker : workers_) {
+      if (worker.valid() && worker.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        worker.get();
+    }
   }
   if (!running_) {
     LOG(kError) << "Worker is no longer running.";
@@ -413,16 +1091,99 @@ void DataBuffer::StopRunning() {
   disk_store_.cond_var.notify_all();
 }
 
+DataBuffer::ValueView DataBuffer::MakeView(std::shared_ptr<const NonEmptyString> value) {
+  return ValueView(std::move(value));
+}
+
 fs::path DataBuffer::GetFilename(const KeyType& key) const {
-  return kDiskBuffer_ / detail::GetFileName(key);
+  return stripes_[StripeOf(key)].path / detail::GetFileName(key);
 }
 
-void DataBuffer::SetMaxMemoryUsage(MemoryUsage max_memory_usage) {
+DataBuffer::FlushStats DataBuffer::flush_stats() const {
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+  return stats_.flush;
+}
+
+DataBuffer::Stats DataBuffer::stats() const {
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+    stats = stats_;
+  }
   {
     std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
-    if (max_memory_usage > disk_store_.max) {
-      LOG(kError) << "Max memory usage must be <= max disk usage.";
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    stats.memory_usage = memory_store_.current.data;
+    stats.memory_values = memory_store_.index.size();
+  }
+  std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+  stats.disk_usage = disk_store_.current.data;
+  stats.disk_values = disk_store_.index.size();
+  return stats;
+}
+
+void DataBuffer::SetPriority(const KeyType& key, Priority priority) {
+  UpdatePolicy(key, [priority](KeyPolicy& policy) { policy.priority = priority; });
+}
+
+void DataBuffer::Pin(const KeyType& key) {
+  UpdatePolicy(key, [](KeyPolicy& policy) { policy.pinned = true; });
+}
+
+void DataBuffer::Unpin(const KeyType& key) {
+  UpdatePolicy(key, [](KeyPolicy& policy) { policy.pinned = false; });
+}
+
+void DataBuffer::UpdatePolicy(const KeyType& key,
+                              const std::function<void(KeyPolicy&)>& update) {
+  {
+    std::lock(memory_store_.mutex, disk_store_.mutex);
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex, std::adopt_lock);
+    auto itr(policies_.find(key));
+    KeyPolicy policy(itr == policies_.end() ? KeyPolicy() : itr->second);
+    update(policy);
+    const Rank rank(policy.rank());
+    if (rank == KeyPolicy().rank()) {
+      if (itr != policies_.end())
+        policies_.erase(itr);
+    } else {
+      policies_[key] = policy;
+    }
+    Rerank(memory_store_, key, rank);
+    Rerank(disk_store_, key, rank);
+  }
+  // Unpinning or lowering the priority may have provided a candidate for eviction.
+  memory_store_.cond_var.notify_all();
+  disk_store_.cond_var.notify_all();
+}
+
+uint64_t DataBuffer::EvictFromMemory(uint64_t bytes) {
+  uint64_t released(0);
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    while (released < bytes) {
+      const auto itr(FindFirstAlsoOnDisk());
+      if (itr == memory_store_.index.end())
+        break;
+      released += (*itr).value->string().size();
+      EraseFromMemory(itr);
+    }
+  }
+  if (released != 0)
+    memory_store_.cond_var.notify_all();
+  return released;
+}
+
+void DataBuffer::SetMaxMemoryUsage(MemoryUsage max_memory_usage) {
+  {
+    std::lock(memory_store_.mutex, disk_store_.mutex);
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex, std::adopt_lock);
+    for (const auto& stripe : stripes_) {
+      if (max_memory_usage > stripe.max) {
+        LOG(kError) << "Max memory usage must be <= max disk usage of " << stripe.path;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+      }
     }
     memory_store_.max = max_memory_usage;
   }
@@ -433,12 +1194,25 @@ void DataBuffer::SetMaxDiskUsage(DiskUsage max_disk_usage) {
   bool increased(false);
   {
     std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
-    if (memory_store_.max > max_disk_usage) {
-      LOG(kError) << "Max memory usage must be <= max disk usage.";
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    // Each directory keeps its share of the total, with the last taking any rounding remainder.
+    std::vector<DiskUsage> limits;
+    uint64_t allotted(0);
+    for (size_t i(0); i != stripes_.size(); ++i) {
+      const double share(disk_store_.max.data == 0 ? 1.0 / stripes_.size() :
+          static_cast<double>(stripes_[i].max.data) / static_cast<double>(disk_store_.max.data));
+      const uint64_t limit(i + 1 == stripes_.size() ? max_disk_usage.data - allotted :
+          static_cast<uint64_t>(static_cast<double>(max_disk_usage.data) * share));
+      allotted += limit;
+      limits.emplace_back(limit);
+      if (memory_store_.max > limits.back()) {
+        LOG(kError) << "Max memory usage must be <= max disk usage of " << stripes_[i].path;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+      }
     }
     increased = (max_disk_usage > disk_store_.max);
     disk_store_.max = max_disk_usage;
+    for (size_t i(0); i != stripes_.size(); ++i)
+      stripes_[i].max = limits[i];
   }
   if (increased)
     disk_store_.cond_var.notify_all();
@@ -452,49 +1226,148 @@ bool DataBuffer::HasSpace(const T& store, uint64_t required_space) const {
 
 template <typename T>
 typename T::index_type::iterator DataBuffer::Find(T& store, const KeyType& key) {
-  return std::find_if(
-      store.index.begin(), store.index.end(),
-      [&key](const typename T::index_type::value_type& key_value) { return key_value.key == key; });
+  const auto& by_key(store.index.template get<1>());
+  auto itr(by_key.find(key));
+  return itr == by_key.end() ? store.index.end() : store.index.template project<0>(itr);
+}
+
+DataBuffer::Rank DataBuffer::RankOf(const KeyType& key) const {
+  auto itr(policies_.find(key));
+  return itr == policies_.end() ? KeyPolicy().rank() : itr->second.rank();
+}
+
+template <typename T>
+void DataBuffer::Rerank(T& store, const KeyType& key, Rank rank) {
+  // Modifying the rank doesn't move elements within the hashed index, but collect them first anyway
+  // rather than rely on that.  They're restamped as the newest of their new rank.
+  std::vector<typename T::index_type::iterator> held;
+  auto range(store.index.template get<1>().equal_range(key));
+  for (; range.first != range.second; ++range.first)
+    held.push_back(store.index.template project<0>(range.first));
+  for (const auto& itr : held) {
+    if ((*itr).rank != rank) {
+      const uint64_t stamp(store.next_stamp++);
+      store.index.modify(itr, [rank, stamp](typename T::index_type::value_type& element) {
+        element.rank = rank;
+        element.stamp = stamp;
+      });
+    }
+  }
+}
+
+bool DataBuffer::ReferenceOnDisk(const KeyType& key) {
+  auto itr(Find(disk_store_, key));
+  if (itr == disk_store_.index.end() || (*itr).state != StoringState::kCompleted)
+    return false;
+  const bool referenced((*itr).referenced);
+  (*itr).referenced = true;
+  return referenced;
+}
+
+void DataBuffer::PromoteToMemory(const KeyType& key, const NonEmptyString& value) {
+  const uint64_t required_space(value.string().size());
+  {
+    std::lock_guard<std::mutex> memory_store_lock(memory_store_.mutex);
+    if (!running_ || required_space > memory_store_.max ||
+        !HasSpace(memory_store_, required_space) ||
+        Find(memory_store_, key) != memory_store_.index.end()) {
+      return;
+    }
+    // Check that the value hasn't been deleted or replaced since it was read.
+    std::lock_guard<std::mutex> disk_store_lock(disk_store_.mutex);
+    auto itr(Find(disk_store_, key));
+    if (itr == disk_store_.index.end() || (*itr).state != StoringState::kCompleted)
+      return;
+    (*itr).referenced = false;
+    (*itr).promoted = true;
+    memory_store_.current.data += required_space;
+    memory_store_.index.emplace_back(key, value, (*itr).rank, memory_store_.next_stamp++);
+    memory_store_.index.back().also_on_disk = StoringState::kCompleted;
+    memory_store_.index.back().promoted = true;
+  }
+  memory_store_.cond_var.notify_all();
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+  ++stats_.promotions;
 }
 
-DataBuffer::MemoryIndex::iterator DataBuffer::FindOldestInMemoryOnly() {
-  return std::find_if(memory_store_.index.begin(), memory_store_.index.end(),
-                      [](const MemoryElement& key_value) {
-    return key_value.also_on_disk == StoringState::kNotStarted;
+DataBuffer::MemoryEvictionOrder::iterator DataBuffer::FindFirstInMemoryOnly(size_t stripe) {
+  auto& eviction_order(memory_store_.index.get<2>());
+  return std::find_if(eviction_order.begin(), eviction_order.end(),
+                      [this, stripe](const MemoryElement& key_value) {
+    return key_value.also_on_disk == StoringState::kNotStarted &&
+           StripeOf(key_value.key) == stripe;
   });
 }
 
+DataBuffer::MemoryIndex::iterator DataBuffer::FindFirstAlsoOnDisk() {
+  auto& eviction_order(memory_store_.index.get<2>());
+  const auto pinned(eviction_order.lower_bound(boost::make_tuple(kPinnedRank)));
+  const bool clock(kOptions_.eviction_policy == EvictionPolicy::kClock);
+  for (auto itr(eviction_order.begin()); itr != pinned;) {
+    if ((*itr).also_on_disk != StoringState::kCompleted) {
+      ++itr;
+    } else if (!clock || !(*itr).referenced) {
+      return memory_store_.index.project<0>(itr);
+    } else {
+      // Second chance: move it behind the others of its rank, where it'll be reached again if
+      // nothing else is evicted first.
+      auto next(std::next(itr));
+      (*itr).referenced = false;
+      const uint64_t stamp(memory_store_.next_stamp++);
+      eviction_order.modify(itr, [stamp](MemoryElement& element) { element.stamp = stamp; });
+      itr = next;
+    }
+  }
+  return memory_store_.index.end();
+}
+
 DataBuffer::MemoryIndex::iterator DataBuffer::FindMemoryRemovalCandidate(
     uint64_t required_space, std::unique_lock<std::mutex>& memory_store_lock) {
   auto itr(memory_store_.index.end());
   memory_store_.cond_var.wait(memory_store_lock, [this, &itr, &required_space]() -> bool {
-    itr = std::find_if(memory_store_.index.begin(), memory_store_.index.end(),
-                       [](const MemoryElement& key_value) {
-      return key_value.also_on_disk == StoringState::kCompleted;
-    });
+    itr = FindFirstAlsoOnDisk();
     return itr != memory_store_.index.end() || HasSpace(memory_store_, required_space) || !running_;
   });
   return itr;
 }
 
-DataBuffer::DiskIndex::iterator DataBuffer::FindStartedToStoreOnDisk(const KeyType& key) {
-  return std::find_if(disk_store_.index.begin(), disk_store_.index.end(),
-                      [&key](const DiskElement& entry) {
-    return entry.state == StoringState::kStarted && entry.key == key;
-  });
+DataBuffer::DiskIndex::iterator DataBuffer::FindInFlightOnDisk(const KeyType& key) {
+  auto range(disk_store_.index.get<1>().equal_range(key));
+  auto itr(std::find_if(range.first, range.second, [](const DiskElement& entry) {
+    return entry.state != StoringState::kCompleted;
+  }));
+  return itr == range.second ? disk_store_.index.end() : disk_store_.index.project<0>(itr);
 }
 
-DataBuffer::DiskIndex::iterator DataBuffer::FindOldestOnDisk() { return disk_store_.index.begin(); }
+DataBuffer::DiskIndex::iterator DataBuffer::FindFirstOnDisk(size_t stripe) {
+  auto& eviction_order(disk_store_.index.get<2>());
+  const auto pinned(eviction_order.lower_bound(boost::make_tuple(kPinnedRank)));
+  auto itr(std::find_if(eviction_order.begin(), pinned, [this, stripe](const DiskElement& entry) {
+    return entry.state == StoringState::kCompleted && !entry.promoted &&
+           StripeOf(entry.key) == stripe;
+  }));
+  return itr == pinned ? disk_store_.index.end() : disk_store_.index.project<0>(itr);
+}
 
-DataBuffer::DiskIndex::iterator DataBuffer::FindAndThrowIfCancelled(const KeyType& key) {
+DataBuffer::DiskIndex::iterator DataBuffer::FindIfNotCancelled(const KeyType& key) {
   auto itr(Find(disk_store_, key));
   if (itr == disk_store_.index.end() || (*itr).state == StoringState::kCancelled) {
-    LOG(kWarning) << DebugKeyName(key) << " is not in the disk index or is cancelled.";
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    RecordLookup(&Stats::misses);
+    return disk_store_.index.end();
   }
   return itr;
 }
 
+void DataBuffer::ObserveLookup(const KeyType& key) const {
+  if (kOptions_.lookup_observer)
+    kOptions_.lookup_observer(key);
+}
+
+void DataBuffer::RecordLookup(uint64_t Stats::*counter) {
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+  ++(stats_.*counter);
+}
+
 std::string DataBuffer::DebugKeyName(const KeyType& key) { return hex::Encode(key.name); }
 
 }  // namespace maidsafe
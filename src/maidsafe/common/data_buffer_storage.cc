@@ -0,0 +1,576 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/data_buffer_storage.h"
+
+#ifdef MAIDSAFE_WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/hash/algorithms/siphash.h"
+
+namespace fs = boost::filesystem;
+namespace bi = boost::interprocess;
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+// Each record is the key's name, the key's type ID (4 bytes), the record's sequence number (8
+// bytes), the value's length (8 bytes) and a checksum of all of these and the value (8 bytes),
+// followed by the value.  Integers are little-endian.  A tombstone has no value, and its length is
+// set to kTombstoneLength.
+const size_t kChecksumOffset(identity_size + 4 + 8 + 8);
+const size_t kRecordHeaderSize(kChecksumOffset + 8);
+const uint64_t kTombstoneLength(std::numeric_limits<uint64_t>::max());
+
+using RecordHeader = std::array<byte, kRecordHeaderSize>;
+
+template <typename Iterator>
+Iterator PutLittleEndian(uint64_t value, int byte_count, Iterator itr) {
+  for (int i(0); i != byte_count; ++i)
+    *itr++ = static_cast<byte>(value >> (8 * i));
+  return itr;
+}
+
+template <typename Iterator>
+uint64_t GetLittleEndian(int byte_count, Iterator itr) {
+  uint64_t value(0);
+  for (int i(0); i != byte_count; ++i)
+    value |= static_cast<uint64_t>(*itr++) << (8 * i);
+  return value;
+}
+
+uint64_t Checksum(const RecordHeader& header, const byte* data, uint64_t length) {
+  // A fixed seed, since the checksum must be reproducible after a restart.
+  SipHash hash(std::array<byte, 16>{{}});
+  hash.Update(header.data(), kChecksumOffset);
+  if (data)
+    hash.Update(data, length);
+  return hash.Finalize();
+}
+
+RecordHeader MakeRecordHeader(const SegmentedLog::KeyType& key, uint64_t sequence,
+                              const byte* data, uint64_t length) {
+  RecordHeader header;
+  const auto& name(key.name.string());
+  auto itr(std::copy(std::begin(name), std::end(name), std::begin(header)));
+  itr = PutLittleEndian(key.type_id.data, 4, itr);
+  itr = PutLittleEndian(sequence, 8, itr);
+  itr = PutLittleEndian(data ? length : kTombstoneLength, 8, itr);
+  PutLittleEndian(Checksum(header, data, length), 8, itr);
+  return header;
+}
+
+// Invokes 'functor(key, sequence, value_offset, length)' for each valid record in order, with
+// 'length' set to kTombstoneLength for tombstones, and returns the size of the valid prefix of the
+// segment.  Reading stops at the first invalid record.
+template <typename Functor>
+uint64_t ReadRecords(const fs::path& path, Functor functor) {
+  std::ifstream segment_in(path.c_str(), std::ios::in | std::ios::binary);
+  uint64_t offset(0);
+  RecordHeader header;
+  std::vector<byte> value;
+  while (segment_in.read(reinterpret_cast<char*>(header.data()), header.size())) {
+    SegmentedLog::KeyType key(
+        Identity(std::vector<byte>(std::begin(header), std::begin(header) + identity_size)),
+        DataTypeId(static_cast<uint32_t>(GetLittleEndian(4, std::begin(header) + identity_size))));
+    const auto sequence(GetLittleEndian(8, std::begin(header) + identity_size + 4));
+    const auto length(GetLittleEndian(8, std::begin(header) + identity_size + 12));
+    const bool tombstone(length == kTombstoneLength);
+    if (!tombstone) {
+      if (length == 0 || length > std::numeric_limits<uint32_t>::max())
+        break;
+      value.resize(static_cast<size_t>(length));
+      if (!segment_in.read(reinterpret_cast<char*>(&value[0]), value.size()))
+        break;
+    }
+    if (Checksum(header, tombstone ? nullptr : value.data(), length) !=
+        GetLittleEndian(8, std::begin(header) + kChecksumOffset)) {
+      break;
+    }
+    functor(key, sequence, offset + kRecordHeaderSize, length);
+    offset += kRecordHeaderSize + (tombstone ? 0 : length);
+  }
+  return offset;
+}
+
+bool ParseSegmentId(const fs::path& path, uint32_t& id) {
+  const std::string prefix("segment_"), filename(path.filename().string());
+  if (filename.compare(0, prefix.size(), prefix) != 0 || filename.size() == prefix.size() ||
+      filename.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+    return false;
+  }
+  try {
+    id = static_cast<uint32_t>(std::stoul(filename.substr(prefix.size())));
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+struct Mapping {
+  Mapping(const fs::path& path, uint64_t offset, uint64_t length,
+          std::shared_ptr<const void> owner_in)
+      : file(path.string().c_str(), bi::read_only),
+        region(file, bi::read_only, static_cast<bi::offset_t>(offset), static_cast<size_t>(length)),
+        owner(std::move(owner_in)) {}
+  bi::file_mapping file;
+  bi::mapped_region region;
+  std::shared_ptr<const void> owner;
+};
+
+fs::path SegmentPath(const fs::path& root, uint32_t id) {
+  return root / ("segment_" + std::to_string(id));
+}
+
+}  // unnamed namespace
+
+bool SyncToDisk(const std::vector<fs::path>& files, const fs::path& directory) {
+#ifdef MAIDSAFE_WIN32
+  // Windows provides no means of syncing a directory.
+  static_cast<void>(directory);
+  for (const auto& file : files) {
+    int descriptor(_wopen(file.c_str(), _O_RDWR | _O_BINARY));
+    if (descriptor == -1)
+      return false;
+    const bool synced(_commit(descriptor) == 0);
+    _close(descriptor);
+    if (!synced)
+      return false;
+  }
+  return true;
+#else
+  auto sync([](const fs::path& path) -> bool {
+    int descriptor(open(path.c_str(), O_RDONLY));
+    if (descriptor == -1)
+      return false;
+    const bool synced(fsync(descriptor) == 0);
+    close(descriptor);
+    return synced;
+  });
+  for (const auto& file : files) {
+    if (!sync(file))
+      return false;
+  }
+  return sync(directory);
+#endif
+}
+
+boost::expected<MappedValue, common_error> MapFile(const fs::path& path, uint64_t offset,
+                                                   uint64_t length,
+                                                   std::shared_ptr<const void> owner) {
+  try {
+    auto mapping(std::make_shared<Mapping>(path, offset, length, std::move(owner)));
+    const auto data(static_cast<const byte*>(mapping->region.get_address()));
+    // The aliasing constructor shares ownership of the mapping while pointing at its contents.
+    return MappedValue{std::shared_ptr<const byte>(mapping, data), static_cast<size_t>(length)};
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to map " << length << " bytes at " << offset << " in " << path << ": "
+                << e.what();
+  }
+  return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
+}
+
+SegmentedLog::Segment::Segment(uint32_t id_in, fs::path path_in)
+    : id(id_in),
+      path(std::move(path_in)),
+      size(0),
+      live_bytes(0),
+      queued_for_compaction(false),
+      obsolete(false),
+      tombstones() {}
+
+SegmentedLog::Segment::~Segment() {
+  if (!obsolete)
+    return;
+  boost::system::error_code error_code;
+  fs::remove(path, error_code);
+  if (error_code)
+    LOG(kWarning) << "Failed to remove " << path << ": " << error_code.message();
+}
+
+SegmentedLog::SegmentedLog(fs::path root, uint64_t segment_size, double compaction_threshold,
+                           bool recover)
+    : kRoot_(std::move(root)),
+      kSegmentSize_(segment_size),
+      kCompactionThreshold_(compaction_threshold),
+      mutex_(),
+      cond_var_(),
+      index_(),
+      segments_(),
+      unsynced_segments_(),
+      compaction_queue_(),
+      active_segment_(),
+      active_stream_(),
+      next_segment_id_(0),
+      next_sequence_(0),
+      running_(true),
+      compactor_() {
+  if (kSegmentSize_ == 0 || kCompactionThreshold_ < 0.0 || kCompactionThreshold_ >= 1.0) {
+    LOG(kError) << "Invalid segment size or compaction threshold.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (recover)
+    RecoverSegments();
+  else
+    RemoveSegments();
+  if (!OpenSegmentLocked())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  compactor_ = std::async(std::launch::async, &SegmentedLog::CompactSegments, this);
+}
+
+SegmentedLog::~SegmentedLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cond_var_.notify_all();
+  compactor_.wait();
+}
+
+bool SegmentedLog::Put(const KeyType& key, const NonEmptyString& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return AppendLocked(key, next_sequence_++, value.string().data(), value.string().size());
+}
+
+boost::expected<std::vector<byte>, common_error> SegmentedLog::Get(const KeyType& key) const {
+  // The segment can't be removed while 'location' holds a reference to it, so it's safe to read
+  // without the lock.
+  auto location(FindLocation(key));
+  if (!location)
+    return boost::make_unexpected(location.error());
+  return Read(*location);
+}
+
+boost::expected<MappedValue, common_error> SegmentedLog::Map(const KeyType& key) const {
+  auto location(FindLocation(key));
+  if (!location)
+    return boost::make_unexpected(location.error());
+  return MapFile(location->segment->path, location->offset, location->length, location->segment);
+}
+
+boost::expected<uint64_t, common_error> SegmentedLog::Delete(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == std::end(index_))
+    return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+  if (!AppendTombstoneLocked(key, next_sequence_++))
+    return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
+  const auto length(itr->second.length);
+  ReleaseLocked(itr->second);
+  index_.erase(itr);
+  return length;
+}
+
+bool SegmentedLog::Sync() {
+  std::vector<fs::path> paths;
+  std::vector<std::shared_ptr<Segment>> segments;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& segment : unsynced_segments_) {
+      paths.push_back(segment.second->path);
+      segments.push_back(segment.second);
+    }
+    unsynced_segments_.clear();
+  }
+  return SyncToDisk(paths, kRoot_);
+}
+
+std::vector<std::pair<SegmentedLog::KeyType, uint64_t>> SegmentedLog::Values() const {
+  std::vector<std::pair<uint64_t, const KeyType*>> by_sequence;
+  std::vector<std::pair<KeyType, uint64_t>> values;
+  std::lock_guard<std::mutex> lock(mutex_);
+  by_sequence.reserve(index_.size());
+  for (const auto& entry : index_)
+    by_sequence.emplace_back(entry.second.sequence, &entry.first);
+  std::sort(std::begin(by_sequence), std::end(by_sequence));
+  values.reserve(by_sequence.size());
+  for (const auto& entry : by_sequence)
+    values.emplace_back(*entry.second, index_.find(*entry.second)->second.length);
+  return values;
+}
+
+size_t SegmentedLog::segment_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_.size();
+}
+
+boost::expected<std::vector<byte>, common_error> SegmentedLog::Read(const Location& location) {
+  try {
+    std::vector<byte> value(static_cast<size_t>(location.length));
+    std::ifstream segment_in(location.segment->path.c_str(), std::ios::in | std::ios::binary);
+    segment_in.seekg(static_cast<std::streamoff>(location.offset));
+    segment_in.read(reinterpret_cast<char*>(&value[0]), value.size());
+    if (segment_in.good())
+      return value;
+    LOG(kError) << "Failed to read " << location.length << " bytes at " << location.offset
+                << " in " << location.segment->path;
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to read " << location.segment->path << ": " << e.what();
+  }
+  return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
+}
+
+boost::expected<SegmentedLog::Location, common_error> SegmentedLog::FindLocation(
+    const KeyType& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == std::end(index_))
+    return boost::make_unexpected(MakeError(CommonErrors::no_such_element));
+  return itr->second;
+}
+
+void SegmentedLog::RecoverSegments() {
+  std::map<uint32_t, fs::path> paths;
+  uint32_t id(0);
+  for (fs::directory_iterator itr(kRoot_), end; itr != end; ++itr) {
+    if (ParseSegmentId(itr->path(), id))
+      paths.emplace(id, itr->path());
+  }
+
+  // The latest record for each key, which is a tombstone if 'location.length' is kTombstoneLength.
+  std::map<KeyType, Location> latest;
+  for (const auto& path : paths) {
+    auto segment(std::make_shared<Segment>(path.first, path.second));
+    segment->size = ReadRecords(path.second, [&](const KeyType& key, uint64_t sequence,
+                                                 uint64_t offset, uint64_t length) {
+      auto itr(latest.find(key));
+      if (itr == std::end(latest))
+        latest.emplace(key, Location(segment, offset, length, sequence));
+      else if (itr->second.sequence < sequence)
+        itr->second = Location(segment, offset, length, sequence);
+      next_sequence_ = std::max(next_sequence_, sequence + 1);
+    });
+    boost::system::error_code error_code;
+    if (segment->size < fs::file_size(path.second, error_code))
+      LOG(kWarning) << "Discarding invalid records at the end of " << path.second;
+    next_segment_id_ = path.first + 1;
+    if (segment->size == 0)
+      segment->obsolete = true;
+    else
+      segments_.emplace(segment->id, segment);
+  }
+
+  for (auto& entry : latest) {
+    const auto& segment(entry.second.segment);
+    if (entry.second.length == kTombstoneLength) {
+      // Only needed while an older segment might still hold a value for the key.
+      segment->tombstones.emplace_back(entry.first, entry.second.sequence);
+    } else {
+      segment->live_bytes += kRecordHeaderSize + entry.second.length;
+      index_.emplace(entry.first, std::move(entry.second));
+    }
+  }
+  for (const auto& segment : segments_) {
+    if (segment.second->live_bytes < kCompactionThreshold_ * segment.second->size)
+      QueueForCompactionLocked(segment.second);
+  }
+}
+
+void SegmentedLog::RemoveSegments() {
+  uint32_t id(0);
+  for (fs::directory_iterator itr(kRoot_), end; itr != end; ++itr) {
+    if (!ParseSegmentId(itr->path(), id))
+      continue;
+    boost::system::error_code error_code;
+    fs::remove(itr->path(), error_code);
+    if (error_code)
+      LOG(kWarning) << "Failed to remove " << itr->path() << ": " << error_code.message();
+  }
+}
+
+bool SegmentedLog::OpenSegmentLocked() {
+  if (active_stream_.is_open()) {
+    active_stream_.close();
+    // Any values deleted while the segment was active may have made it worth compacting already.
+    auto sealed(active_segment_);
+    active_segment_.reset();
+    if (sealed->live_bytes < kCompactionThreshold_ * sealed->size)
+      QueueForCompactionLocked(sealed);
+  }
+  auto segment(std::make_shared<Segment>(next_segment_id_, SegmentPath(kRoot_, next_segment_id_)));
+  ++next_segment_id_;
+  active_stream_.clear();
+  active_stream_.open(segment->path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!active_stream_.good()) {
+    LOG(kError) << "Can't create segment " << segment->path;
+    return false;
+  }
+  segments_.emplace(segment->id, segment);
+  active_segment_ = segment;
+  return true;
+}
+
+bool SegmentedLog::WriteRecordLocked(const KeyType& key, uint64_t sequence, const byte* data,
+                                     uint64_t length) {
+  if (!active_segment_ && !OpenSegmentLocked())
+    return false;
+  const auto header(MakeRecordHeader(key, sequence, data, length));
+  try {
+    active_stream_.write(reinterpret_cast<const char*>(header.data()), header.size());
+    if (data) {
+      active_stream_.write(reinterpret_cast<const char*>(data),
+                           static_cast<std::streamsize>(length));
+    }
+    // Readers use their own streams, so the value must be handed to the OS before it's indexed.
+    active_stream_.flush();
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to append to " << active_segment_->path << ": " << e.what();
+    return false;
+  }
+  if (!active_stream_.good()) {
+    LOG(kError) << "Failed to append to " << active_segment_->path;
+    return false;
+  }
+  unsynced_segments_[active_segment_->id] = active_segment_;
+  return true;
+}
+
+bool SegmentedLog::AppendLocked(const KeyType& key, uint64_t sequence, const byte* data,
+                                uint64_t length) {
+  if (!WriteRecordLocked(key, sequence, data, length))
+    return false;
+  Location location(active_segment_, active_segment_->size + kRecordHeaderSize, length, sequence);
+  active_segment_->size += kRecordHeaderSize + length;
+  active_segment_->live_bytes += kRecordHeaderSize + length;
+  auto itr(index_.find(key));
+  if (itr == std::end(index_)) {
+    index_.emplace(key, std::move(location));
+  } else {
+    ReleaseLocked(itr->second);
+    itr->second = std::move(location);
+  }
+  return RollIfFullLocked();
+}
+
+bool SegmentedLog::AppendTombstoneLocked(const KeyType& key, uint64_t sequence) {
+  if (!WriteRecordLocked(key, sequence, nullptr, 0))
+    return false;
+  active_segment_->size += kRecordHeaderSize;
+  active_segment_->tombstones.emplace_back(key, sequence);
+  return RollIfFullLocked();
+}
+
+bool SegmentedLog::RollIfFullLocked() {
+  return active_segment_->size < kSegmentSize_ || OpenSegmentLocked();
+}
+
+void SegmentedLog::ReleaseLocked(const Location& location) {
+  const auto& segment(location.segment);
+  segment->live_bytes -= kRecordHeaderSize + location.length;
+  if (segment != active_segment_ && segment->live_bytes < kCompactionThreshold_ * segment->size)
+    QueueForCompactionLocked(segment);
+}
+
+void SegmentedLog::QueueForCompactionLocked(const std::shared_ptr<Segment>& segment) {
+  if (segment->queued_for_compaction)
+    return;
+  segment->queued_for_compaction = true;
+  compaction_queue_.push_back(segment);
+  cond_var_.notify_all();
+}
+
+void SegmentedLog::CompactSegments() {
+  for (;;) {
+    std::shared_ptr<Segment> segment;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_var_.wait(lock, [this] { return !compaction_queue_.empty() || !running_; });
+      if (!running_)
+        return;
+      segment = compaction_queue_.front();
+      compaction_queue_.pop_front();
+    }
+    if (!Compact(segment))
+      LOG(kError) << "Failed to compact " << segment->path;
+  }
+}
+
+bool SegmentedLog::Compact(const std::shared_ptr<Segment>& segment) {
+  std::vector<std::pair<KeyType, Location>> live_values;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : index_) {
+      if (entry.second.segment == segment)
+        live_values.push_back(entry);
+    }
+  }
+
+  // The segment is immutable, so its values can be read without the lock.  Each is only moved if
+  // it hasn't been deleted or replaced in the meantime, and keeps its sequence number.
+  for (const auto& entry : live_values) {
+    auto value(Read(entry.second));
+    if (!value)
+      return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+      return true;
+    auto itr(index_.find(entry.first));
+    if (itr == std::end(index_) || itr->second.segment != segment ||
+        itr->second.offset != entry.second.offset) {
+      continue;
+    }
+    if (!AppendLocked(entry.first, entry.second.sequence, value->data(), value->size()))
+      return false;
+  }
+
+  {
+    // A tombstone is still needed if the key hasn't been put again since, and an older segment
+    // (which might hold a value for the key) still exists.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+      return true;
+    for (const auto& tombstone : segment->tombstones) {
+      if (index_.count(tombstone.first) == 0 && segments_.begin()->first < segment->id &&
+          !AppendTombstoneLocked(tombstone.first, tombstone.second)) {
+        return false;
+      }
+    }
+  }
+
+  // Make the moved records durable before removing their old copies.
+  if (!Sync())
+    return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  segments_.erase(segment->id);
+  unsynced_segments_.erase(segment->id);
+  segment->obsolete = true;
+  return true;
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
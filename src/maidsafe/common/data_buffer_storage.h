@@ -0,0 +1,165 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_DATA_BUFFER_STORAGE_H_
+#define MAIDSAFE_COMMON_DATA_BUFFER_STORAGE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "boost/expected/expected.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Flushes the given files, and then 'directory' (so that the files' directory entries are durable
+// too), to the storage device.  Doesn't throw.
+bool SyncToDisk(const std::vector<boost::filesystem::path>& files,
+                const boost::filesystem::path& directory);
+
+// A read-only memory mapping of a value.  'data' keeps the mapping alive.
+struct MappedValue {
+  std::shared_ptr<const byte> data;
+  size_t size;
+};
+
+// Maps 'length' (which must be non-zero) bytes at 'offset' in 'path'.  'owner' is kept alive until
+// the mapping is released.  Doesn't throw.
+boost::expected<MappedValue, common_error> MapFile(const boost::filesystem::path& path,
+                                                   uint64_t offset, uint64_t length,
+                                                   std::shared_ptr<const void> owner = nullptr);
+
+// Disk storage engine for DataBuffer which appends values to a series of large segment files rather
+// than writing one file per value, with the location of each value held in an in-memory index.
+// Once a full segment's live values make up less than 'compaction_threshold' of its size (due to
+// values being deleted or replaced), a background thread copies them to the current segment and
+// removes the old one.  All public functions are thread-safe.
+//
+// Each record holds its key, a sequence number and a checksum, and Delete appends a "tombstone"
+// record, so the index can be rebuilt from the segments alone after a restart (or crash).  The
+// record with the highest sequence number for a key wins, and records which are incomplete or fail
+// their checksum are discarded.
+class SegmentedLog {
+ public:
+  using KeyType = Data::NameAndTypeId;
+
+  // Throws if 'segment_size' is 0, if 'compaction_threshold' is not in the range [0, 1), or if the
+  // first segment can't be created in 'root' (which must already exist).  If 'recover' is true,
+  // the values held in any segments already in 'root' are indexed, otherwise such segments are
+  // removed.
+  SegmentedLog(boost::filesystem::path root, uint64_t segment_size, double compaction_threshold,
+               bool recover = false);
+  ~SegmentedLog();
+  SegmentedLog(const SegmentedLog&) = delete;
+  SegmentedLog(SegmentedLog&&) = delete;
+  SegmentedLog& operator=(const SegmentedLog&) = delete;
+  SegmentedLog& operator=(SegmentedLog&&) = delete;
+
+  // Appends 'value', replacing any value already held for 'key'.  Returns false if the value can't
+  // be written.  Doesn't throw.
+  bool Put(const KeyType& key, const NonEmptyString& value);
+  // Doesn't throw.
+  boost::expected<std::vector<byte>, common_error> Get(const KeyType& key) const;
+  // As for Get, but maps the value rather than reading it.  The mapping keeps the segment alive, so
+  // remains valid even if the value is subsequently deleted or compacted.  Doesn't throw.
+  boost::expected<MappedValue, common_error> Map(const KeyType& key) const;
+  // Removes the value held for 'key', returning its size.  Doesn't throw.
+  boost::expected<uint64_t, common_error> Delete(const KeyType& key);
+  // Syncs every segment appended to since the previous call.  Doesn't throw.
+  bool Sync();
+  // Returns the key and size of every value held, in the order they were put.
+  std::vector<std::pair<KeyType, uint64_t>> Values() const;
+
+  size_t segment_count() const;
+
+ private:
+  struct Segment {
+    Segment(uint32_t id_in, boost::filesystem::path path_in);
+    // Removes the file if 'obsolete' is set, i.e. once the last reader has finished with it.
+    ~Segment();
+    const uint32_t id;
+    const boost::filesystem::path path;
+    uint64_t size, live_bytes;
+    bool queued_for_compaction, obsolete;
+    // Keys and sequence numbers of the tombstones in this segment.
+    std::vector<std::pair<KeyType, uint64_t>> tombstones;
+  };
+
+  struct Location {
+    Location() : segment(), offset(0), length(0), sequence(0) {}
+    Location(std::shared_ptr<Segment> segment_in, uint64_t offset_in, uint64_t length_in,
+             uint64_t sequence_in)
+        : segment(std::move(segment_in)),
+          offset(offset_in),
+          length(length_in),
+          sequence(sequence_in) {}
+    std::shared_ptr<Segment> segment;
+    uint64_t offset, length, sequence;
+  };
+
+  static boost::expected<std::vector<byte>, common_error> Read(const Location& location);
+  boost::expected<Location, common_error> FindLocation(const KeyType& key) const;
+
+  void RecoverSegments();
+  void RemoveSegments();
+  bool OpenSegmentLocked();
+  bool WriteRecordLocked(const KeyType& key, uint64_t sequence, const byte* data,
+                         uint64_t length);
+  bool AppendLocked(const KeyType& key, uint64_t sequence, const byte* data, uint64_t length);
+  bool AppendTombstoneLocked(const KeyType& key, uint64_t sequence);
+  bool RollIfFullLocked();
+  void ReleaseLocked(const Location& location);
+  void QueueForCompactionLocked(const std::shared_ptr<Segment>& segment);
+  void CompactSegments();
+  bool Compact(const std::shared_ptr<Segment>& segment);
+
+  const boost::filesystem::path kRoot_;
+  const uint64_t kSegmentSize_;
+  const double kCompactionThreshold_;
+  mutable std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::map<KeyType, Location> index_;
+  std::map<uint32_t, std::shared_ptr<Segment>> segments_, unsynced_segments_;
+  std::deque<std::shared_ptr<Segment>> compaction_queue_;
+  std::shared_ptr<Segment> active_segment_;
+  std::ofstream active_stream_;
+  uint32_t next_segment_id_;
+  uint64_t next_sequence_;
+  bool running_;
+  std::future<void> compactor_;
+};
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_DATA_BUFFER_STORAGE_H_
@@ -0,0 +1,78 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/data_types/concurrent_structured_data_versions.h"
+
+#include <utility>
+
+namespace maidsafe {
+
+ConcurrentStructuredDataVersions::ConcurrentStructuredDataVersions(uint32_t max_versions,
+                                                                   uint32_t max_branches)
+    : write_mutex_(),
+      current_(std::make_shared<const StructuredDataVersions>(max_versions, max_branches)) {}
+
+ConcurrentStructuredDataVersions::ConcurrentStructuredDataVersions(
+    const StructuredDataVersions::serialised_type& serialised_data_versions)
+    : write_mutex_(),
+      current_(std::make_shared<const StructuredDataVersions>(serialised_data_versions)) {}
+
+ConcurrentStructuredDataVersions::Snapshot ConcurrentStructuredDataVersions::GetSnapshot() const {
+  return std::atomic_load(&current_);
+}
+
+boost::optional<ConcurrentStructuredDataVersions::VersionName>
+    ConcurrentStructuredDataVersions::Put(const VersionName& old_version,
+                                          const VersionName& new_version) {
+  boost::optional<VersionName> removed_version;
+  Modify([&](StructuredDataVersions& versions) {
+    removed_version = versions.Put(old_version, new_version);
+  });
+  return removed_version;
+}
+
+void ConcurrentStructuredDataVersions::DeleteBranchUntilFork(const VersionName& branch_tip) {
+  Modify([&](StructuredDataVersions& versions) { versions.DeleteBranchUntilFork(branch_tip); });
+}
+
+void ConcurrentStructuredDataVersions::ApplySerialised(
+    const StructuredDataVersions::serialised_type& serialised_data_versions) {
+  Modify([&](StructuredDataVersions& versions) {
+    versions.ApplySerialised(serialised_data_versions);
+  });
+}
+
+void ConcurrentStructuredDataVersions::ApplyDelta(
+    const StructuredDataVersions::serialised_delta_type& serialised_delta) {
+  Modify([&](StructuredDataVersions& versions) { versions.ApplyDelta(serialised_delta); });
+}
+
+StructuredDataVersions::MergeResult ConcurrentStructuredDataVersions::Merge(
+    const StructuredDataVersions::serialised_type& serialised_data_versions) {
+  StructuredDataVersions::MergeResult result;
+  Modify([&](StructuredDataVersions& versions) {
+    result = versions.Merge(serialised_data_versions);
+  });
+  return result;
+}
+
+void ConcurrentStructuredDataVersions::clear() {
+  Modify([](StructuredDataVersions& versions) { versions.clear(); });
+}
+
+}  // namespace maidsafe
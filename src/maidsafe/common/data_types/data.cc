@@ -18,11 +18,27 @@
 
 #include "maidsafe/common/data_types/data.h"
 
+#include <cstring>
 #include <limits>
 #include <utility>
 
 namespace maidsafe {
 
+namespace {
+
+// Returns a negative, zero or positive value as 'lhs' orders before, equal to or after the
+// identity_size bytes at 'rhs', with an uninitialised name (nullptr for 'rhs') ordered first as
+// for Identity.
+int CompareNames(const Identity& lhs, const byte* rhs) {
+  if (!lhs.IsInitialised())
+    return rhs ? -1 : 0;
+  if (!rhs)
+    return 1;
+  return std::memcmp(lhs.string().data(), rhs, identity_size);
+}
+
+}  // unnamed namespace
+
 Data::NameAndTypeId::NameAndTypeId(Identity name_in, DataTypeId type_id_in)
     : name(std::move(name_in)), type_id(type_id_in) {}
 
@@ -108,4 +124,14 @@ bool operator>=(const Data::NameAndTypeId& lhs, const Data::NameAndTypeId& rhs)
   return !operator<(lhs, rhs);
 }
 
+bool operator<(const Data::NameAndTypeId& lhs, const Data::NameAndTypeIdView& rhs) {
+  const int names(CompareNames(lhs.name, rhs.name));
+  return names < 0 || (names == 0 && lhs.type_id < rhs.type_id);
+}
+
+bool operator<(const Data::NameAndTypeIdView& lhs, const Data::NameAndTypeId& rhs) {
+  const int names(CompareNames(rhs.name, lhs.name));
+  return names > 0 || (names == 0 && lhs.type_id < rhs.type_id);
+}
+
 }  // namespace maidsafe
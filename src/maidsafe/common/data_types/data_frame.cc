@@ -0,0 +1,120 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/data_types/data_frame.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace maidsafe {
+
+namespace {
+
+const std::size_t kVersionOffset(0);
+const std::size_t kHeaderSizeOffset(1);
+const std::size_t kTypeIdOffset(2);
+const std::size_t kNameOffset(6);
+const std::size_t kPayloadSizeOffset(kNameOffset + identity_size);
+
+static_assert(kPayloadSizeOffset + 4 == kDataFrameHeaderSize, "Frame header layout mismatch.");
+
+void PutUint32(std::uint32_t value, byte* destination) {
+  for (int i(0); i != 4; ++i)
+    destination[i] = static_cast<byte>(value >> (8 * i));
+}
+
+std::uint32_t GetUint32(const byte* source) {
+  std::uint32_t value(0);
+  for (int i(0); i != 4; ++i)
+    value |= static_cast<std::uint32_t>(source[i]) << (8 * i);
+  return value;
+}
+
+// Returns the offset of the payload after validating the header against 'size'.
+std::size_t CheckHeader(const byte* framed, std::size_t size) {
+  if (!framed || size < kDataFrameHeaderSize) {
+    LOG(kError) << "Framed data is too small to contain a header.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  const std::size_t header_size(framed[kHeaderSizeOffset]);
+  if (framed[kVersionOffset] < kDataFrameVersion || header_size < kDataFrameHeaderSize ||
+      header_size > size) {
+    LOG(kError) << "Framed data has an invalid header.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  if (GetUint32(framed + kPayloadSizeOffset) != size - header_size) {
+    LOG(kError) << "Framed data's payload size doesn't match its header.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  return header_size;
+}
+
+}  // unnamed namespace
+
+namespace detail {
+
+void WriteDataFrameHeader(const Data::NameAndTypeId& name_and_type, SerialisedData& framed) {
+  framed.assign(kDataFrameHeaderSize, 0);
+  framed[kVersionOffset] = kDataFrameVersion;
+  framed[kHeaderSizeOffset] = static_cast<byte>(kDataFrameHeaderSize);
+  PutUint32(name_and_type.type_id.data, &framed[kTypeIdOffset]);
+  const auto& name(name_and_type.name.string());
+  std::copy(std::begin(name), std::end(name), framed.begin() + kNameOffset);
+}
+
+void SetDataFramePayloadSize(SerialisedData& framed) {
+  const std::size_t payload_size(framed.size() - kDataFrameHeaderSize);
+  if (payload_size > std::numeric_limits<std::uint32_t>::max()) {
+    LOG(kError) << "Payload is too large to be framed.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::serialisation_error));
+  }
+  PutUint32(static_cast<std::uint32_t>(payload_size), &framed[kPayloadSizeOffset]);
+}
+
+}  // namespace detail
+
+Data::NameAndTypeId PeekNameAndType(const byte* framed, std::size_t size) {
+  CheckHeader(framed, size);
+  const byte* const name(framed + kNameOffset);
+  return Data::NameAndTypeId(
+      Identity(detail::FixedString<identity_size>(name, name + identity_size)),
+      DataTypeId(GetUint32(framed + kTypeIdOffset)));
+}
+
+FramedData::FramedData(SerialisedData framed)
+    : framed_(std::move(framed)),
+      name_and_type_(PeekNameAndType(framed_.data(), framed_.size())),
+      payload_offset_(CheckHeader(framed_.data(), framed_.size())),
+      parsed_() {}
+
+FramedData::FramedData(FramedData&& other)
+    : framed_(std::move(other.framed_)),
+      name_and_type_(std::move(other.name_and_type_)),
+      payload_offset_(other.payload_offset_),
+      parsed_(std::move(other.parsed_)) {}
+
+FramedData& FramedData::operator=(FramedData&& other) {
+  framed_ = std::move(other.framed_);
+  name_and_type_ = std::move(other.name_and_type_);
+  payload_offset_ = other.payload_offset_;
+  parsed_ = std::move(other.parsed_);
+  return *this;
+}
+
+}  // namespace maidsafe
@@ -18,6 +18,7 @@
 
 #include "maidsafe/common/data_types/immutable_data.h"
 
+#include <memory>
 #include <utility>
 
 #include "maidsafe/common/error.h"
@@ -25,29 +26,69 @@
 namespace maidsafe {
 
 ImmutableData::ImmutableData(NonEmptyString value)
-    : Data(crypto::Hash<crypto::SHA512>(value)), value_(std::move(value)) {}
+    : ImmutableData(std::make_shared<NonEmptyString>(std::move(value)), true) {}
+
+ImmutableData::ImmutableData(SharedBuffer value) : ImmutableData(value.ToSharedString(), false) {}
+
+ImmutableData::ImmutableData(Identity name, NonEmptyString value, bool verify_name)
+    : ImmutableData(std::move(name), std::make_shared<NonEmptyString>(std::move(value)), true,
+                    verify_name) {}
+
+ImmutableData::ImmutableData(Identity name, SharedBuffer value, bool verify_name)
+    : ImmutableData(std::move(name), value.ToSharedString(), false, verify_name) {}
+
+ImmutableData::ImmutableData(std::shared_ptr<const NonEmptyString> value, bool owns_value)
+    : Data(crypto::Hash<crypto::SHA512>(*value)),
+      value_(std::move(value)),
+      owns_value_(owns_value) {}
+
+ImmutableData::ImmutableData(Identity name, std::shared_ptr<const NonEmptyString> value,
+                             bool owns_value, bool verify_name)
+    : Data(std::move(name)), value_(std::move(value)), owns_value_(owns_value) {
+  if (verify_name && name_ != crypto::Hash<crypto::SHA512>(*value_)) {
+    LOG(kWarning) << "Name isn't the hash of the value.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::hashing_error));
+  }
+}
 
 ImmutableData::ImmutableData() = default;
 
 ImmutableData::ImmutableData(const ImmutableData&) = default;
 
 ImmutableData::ImmutableData(ImmutableData&& other) MAIDSAFE_NOEXCEPT
-    : Data(std::move(other)), value_(std::move(other.value_)) {}
+    : Data(std::move(other)), value_(std::move(other.value_)), owns_value_(other.owns_value_) {}
 
 ImmutableData& ImmutableData::operator=(const ImmutableData&) = default;
 
 ImmutableData& ImmutableData::operator=(ImmutableData&& other) MAIDSAFE_NOEXCEPT{
   Data::operator=(std::move(other));
   value_ = std::move(other.value_);
+  owns_value_ = other.owns_value_;
   return *this;
 }
 
 ImmutableData::~ImmutableData() = default;
 
 const NonEmptyString& ImmutableData::Value() const {
-  if (!IsInitialised())
+  if (!IsInitialised() || !value_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  return *value_;
+}
+
+SharedBuffer ImmutableData::SharedValue() const {
+  if (!IsInitialised() || !value_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  return SharedBuffer(value_);
+}
+
+NonEmptyString ImmutableData::ReleaseValue() {
+  if (!IsInitialised() || !value_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
-  return value_;
+  const std::shared_ptr<const NonEmptyString> value(std::move(value_));
+  name_ = Identity();
+  if (owns_value_ && value.use_count() == 1)
+    return std::move(*std::const_pointer_cast<NonEmptyString>(value));
+  return *value;
 }
 
 }  // namespace maidsafe
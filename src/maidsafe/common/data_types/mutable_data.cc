@@ -43,12 +43,12 @@ MutableData::MutableData() = default;
 
 MutableData::MutableData(const MutableData&) = default;
 
-MutableData::MutableData(MutableData&& other)
+MutableData::MutableData(MutableData&& other) MAIDSAFE_NOEXCEPT
     : Data(std::move(other)), value_(std::move(other.value_)) {}
 
 MutableData& MutableData::operator=(const MutableData&) = default;
 
-MutableData& MutableData::operator=(MutableData&& other) {
+MutableData& MutableData::operator=(MutableData&& other) MAIDSAFE_NOEXCEPT {
   Data::operator=(std::move(other));
   value_ = std::move(other.value_);
   return *this;
@@ -62,4 +62,11 @@ const NonEmptyString& MutableData::Value() const {
   return value_;
 }
 
+NonEmptyString MutableData::ReleaseValue() {
+  if (!IsInitialised())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  name_ = Identity();
+  return std::move(value_);
+}
+
 }  // namespace maidsafe
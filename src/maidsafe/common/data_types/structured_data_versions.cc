@@ -19,6 +19,7 @@
 #include "maidsafe/common/data_types/structured_data_versions.h"
 
 #include <algorithm>
+#include <iterator>
 #include <limits>
 #include <tuple>
 
@@ -30,6 +31,13 @@
 
 namespace maidsafe {
 
+namespace {
+
+// Marks a version which Merge hasn't rejected.
+const std::size_t kNoConflict(std::numeric_limits<std::size_t>::max());
+
+}  // unnamed namespace
+
 StructuredDataVersions::VersionName::VersionName()
     : index(std::numeric_limits<Index>::max()), id(), forking_child_count() {}
 
@@ -87,38 +95,22 @@ bool operator>=(const StructuredDataVersions::VersionName& lhs,
   return !operator<(lhs, rhs);
 }
 
-StructuredDataVersions::Details::Details()
-    : parent(), children([](VersionsItr lhs, VersionsItr rhs) { return *lhs < *rhs; }) {}
-
-StructuredDataVersions::Details::Details(VersionsItr parent_in)
-    : parent(std::move(parent_in)),
-      children([](VersionsItr lhs, VersionsItr rhs) { return *lhs < *rhs; }) {}
-
-StructuredDataVersions::Details::Details(const Details& other)
-    : parent(other.parent), children(other.children) {}
+const StructuredDataVersions::NodeIndex StructuredDataVersions::kNoNode(
+    std::numeric_limits<NodeIndex>::max());
 
-StructuredDataVersions::Details::Details(Details&& other)
-    : parent(std::move(other.parent)), children(std::move(other.children)) {}
-
-StructuredDataVersions::Details& StructuredDataVersions::Details::operator=(Details other) {
-  swap(*this, other);
-  return *this;
-}
-
-void swap(StructuredDataVersions::Details& lhs,
-          StructuredDataVersions::Details& rhs) MAIDSAFE_NOEXCEPT {
-  using std::swap;
-  swap(lhs.parent, rhs.parent);
-  swap(lhs.children, rhs.children);
-}
+StructuredDataVersions::Node::Node(VersionName name_in)
+    : name(std::move(name_in)), parent(kNoNode), first_child(kNoNode), next_sibling(kNoNode) {}
 
 StructuredDataVersions::StructuredDataVersions(uint32_t max_versions, uint32_t max_branches)
     : max_versions_(max_versions),
       max_branches_(max_branches),
-      versions_(),
-      root_(std::make_pair(VersionName(), std::end(versions_))),
-      tips_of_trees_([](VersionsItr lhs, VersionsItr rhs) { return *lhs < *rhs; }),
-      orphans_() {
+      nodes_(),
+      index_(),
+      root_parent_(),
+      root_(kNoNode),
+      tips_of_trees_(),
+      orphans_(),
+      absent_parents_() {
   ValidateLimits();
 }
 
@@ -130,10 +122,13 @@ StructuredDataVersions& StructuredDataVersions::operator=(StructuredDataVersions
 StructuredDataVersions::StructuredDataVersions(const serialised_type& serialised_data_versions)
     : max_versions_(),
       max_branches_(),
-      versions_(),
-      root_(std::make_pair(VersionName(), std::end(versions_))),
-      tips_of_trees_([](VersionsItr lhs, VersionsItr rhs) { return *lhs < *rhs; }),
-      orphans_() {
+      nodes_(),
+      index_(),
+      root_parent_(),
+      root_(kNoNode),
+      tips_of_trees_(),
+      orphans_(),
+      absent_parents_() {
   detail::StructuredDataVersionsCereal serialised_versions;
   try {
     Parse(serialised_data_versions->string(), serialised_versions);
@@ -147,9 +142,11 @@ StructuredDataVersions::StructuredDataVersions(const serialised_type& serialised
 
   std::size_t serialised_branch_index(0);
   while (serialised_branch_index < serialised_versions.branches.size())
-    BranchFromCereal(std::end(versions_), serialised_versions, serialised_branch_index);
+    BranchFromCereal(kNoNode, serialised_versions, serialised_branch_index);
+  std::sort(std::begin(tips_of_trees_), std::end(tips_of_trees_),
+            [this](NodeIndex lhs, NodeIndex rhs) { return nodes_[lhs].name < nodes_[rhs].name; });
 
-  if (versions_.size() > max_versions_ || tips_of_trees_.size() > max_branches_)
+  if (nodes_.size() > max_versions_ || tips_of_trees_.size() > max_branches_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
 }
 
@@ -158,10 +155,10 @@ StructuredDataVersions::serialised_type StructuredDataVersions::Serialise() cons
   serialised_versions.max_versions = max_versions_;
   serialised_versions.max_branches = max_branches_;
 
-  BranchToCereal(root_.second, serialised_versions, root_.first);
-  for (const auto& orphan_set : orphans_) {
-    for (const auto& orphan : orphan_set.second)
-      BranchToCereal(orphan, serialised_versions, orphan_set.first);
+  BranchToCereal(root_, serialised_versions, root_parent_);
+  for (const auto orphan_set : SortedOrphans()) {
+    for (const auto& orphan : orphan_set->second)
+      BranchToCereal(orphan, serialised_versions, orphan_set->first);
   }
 
   return serialised_type(NonEmptyString(maidsafe::Serialise(std::move(serialised_versions))));
@@ -173,7 +170,7 @@ void StructuredDataVersions::ValidateLimits() const {
 }
 
 void StructuredDataVersions::BranchFromCereal(
-    VersionsItr parent_itr, detail::StructuredDataVersionsCereal& serialised_versions,
+    NodeIndex parent, detail::StructuredDataVersionsCereal& serialised_versions,
     std::size_t& serialised_branch_index) {
   if (serialised_branch_index >= serialised_versions.branches.size())
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
@@ -181,16 +178,15 @@ void StructuredDataVersions::BranchFromCereal(
   // Handle first version in branch
   auto& serialised_branch(serialised_versions.branches[serialised_branch_index]);
   auto forking_child_count(serialised_branch.names.front().forking_child_count);
-  auto itr(HandleFirstVersionInBranchFromCereal(parent_itr, serialised_branch));
+  auto node(HandleFirstVersionInBranchFromCereal(parent, serialised_branch));
 
   // Handle other versions in branch
   std::size_t serialised_version_index(1);
   for (; serialised_version_index < serialised_branch.names.size(); ++serialised_version_index) {
-    auto previous_itr(itr);
+    auto previous(node);
     forking_child_count = serialised_branch.names[serialised_version_index].forking_child_count;
-    itr = CheckedInsert(std::move(serialised_branch.names[serialised_version_index]));
-    CheckedInsert(previous_itr->second->children, itr);
-    itr->second->parent = previous_itr;
+    node = CheckedInsert(std::move(serialised_branch.names[serialised_version_index]));
+    AddChild(previous, node);
   }
   ++serialised_branch_index;
 
@@ -199,78 +195,79 @@ void StructuredDataVersions::BranchFromCereal(
     if (*forking_child_count < 2U)
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
     for (uint32_t i(0); i != *forking_child_count; ++i)
-      BranchFromCereal(itr, serialised_versions, serialised_branch_index);
+      BranchFromCereal(node, serialised_versions, serialised_branch_index);
   } else {
-    CheckedInsert(tips_of_trees_, itr);
+    tips_of_trees_.push_back(node);  // Sorted once parsing completes.
   }
 }
 
-StructuredDataVersions::VersionsItr StructuredDataVersions::HandleFirstVersionInBranchFromCereal(
-    VersionsItr parent_itr, detail::StructuredDataVersionsBranchCereal& serialised_branch) {
-  auto itr(CheckedInsert(std::move(serialised_branch.names[0])));
-  if (parent_itr == std::end(versions_)) {
+StructuredDataVersions::NodeIndex StructuredDataVersions::HandleFirstVersionInBranchFromCereal(
+    NodeIndex parent, detail::StructuredDataVersionsBranchCereal& serialised_branch) {
+  auto node(CheckedInsert(std::move(serialised_branch.names[0])));
+  if (parent == kNoNode) {
     // This is a new branch, so the first element is either root_ or an orphan.
-    itr->second->parent = std::end(versions_);
     VersionName absent_parent;
     if (serialised_branch.absent_parent) {
       absent_parent.index = serialised_branch.absent_parent->index;
       absent_parent.id = serialised_branch.absent_parent->id;
     }
-    if (root_.second == std::end(versions_)) {
+    if (root_ == kNoNode) {
       // Mark as root
-      root_.first = absent_parent;
-      root_.second = itr;
+      root_parent_ = absent_parent;
+      root_ = node;
     } else {
       // Mark as orphan
       if (!absent_parent.id.IsInitialised())
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-      InsertOrphan(absent_parent, itr);
+      InsertOrphan(absent_parent, node);
     }
   } else {
     // This is a continuation fork of an existing branch.
-    CheckedInsert(parent_itr->second->children, itr);
-    itr->second->parent = parent_itr;
+    AddChild(parent, node);
   }
-  return itr;
+  return node;
 }
 
-StructuredDataVersions::VersionsItr StructuredDataVersions::CheckedInsert(VersionName&& version) {
-  auto result(versions_.insert(std::make_pair(std::move(version), std::make_shared<Details>())));
-  if (!result.second)
+StructuredDataVersions::NodeIndex StructuredDataVersions::CheckedInsert(VersionName&& version) {
+  const NodeIndex node(static_cast<NodeIndex>(nodes_.size()));
+  if (!index_.try_emplace(version, node).second)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
-  return result.first;
+  nodes_.emplace_back(VersionName(version.index, std::move(version.id)));
+  return node;
 }
 
 void StructuredDataVersions::BranchToCereal(
-    VersionsItr itr, detail::StructuredDataVersionsCereal& serialised_versions,
+    NodeIndex node, detail::StructuredDataVersionsCereal& serialised_versions,
     const VersionName& absent_parent) const {
-  if (itr == std::end(versions_))
+  if (node == kNoNode)
     return;
   serialised_versions.branches.emplace_back();
   auto serialised_branch(&serialised_versions.branches.back());
   if (absent_parent.id.IsInitialised())
     serialised_branch->absent_parent = absent_parent;
 
-  BranchToCereal(itr, serialised_versions, serialised_branch);
+  BranchToCereal(node, serialised_versions, serialised_branch);
 }
 
 void StructuredDataVersions::BranchToCereal(
-    VersionsItr itr, detail::StructuredDataVersionsCereal& serialised_versions,
+    NodeIndex node, detail::StructuredDataVersionsCereal& serialised_versions,
     detail::StructuredDataVersionsBranchCereal* serialised_branch) const {
   for (;;) {
-    if (itr == std::end(versions_))
+    if (node == kNoNode)
       return;
-    serialised_branch->names.emplace_back(itr->first.index, itr->first.id);
-    if (itr->second->children.empty())
+    serialised_branch->names.emplace_back(nodes_[node].name.index, nodes_[node].name.id);
+    const NodeIndex first_child(nodes_[node].first_child);
+    if (first_child == kNoNode)
       return;
 
-
-    if (itr->second->children.size() == 1U) {
-      itr = *std::begin(itr->second->children);
+    if (nodes_[first_child].next_sibling == kNoNode) {
+      node = first_child;
     } else {
-      auto added_version(&serialised_branch->names.back());
-      added_version->forking_child_count = static_cast<uint32_t>(itr->second->children.size());
-      for (auto child : itr->second->children) {
+      uint32_t child_count(0);
+      for (auto child(first_child); child != kNoNode; child = nodes_[child].next_sibling)
+        ++child_count;
+      serialised_branch->names.back().forking_child_count = child_count;
+      for (auto child(first_child); child != kNoNode; child = nodes_[child].next_sibling) {
         serialised_versions.branches.emplace_back();
         BranchToCereal(child, serialised_versions, &serialised_versions.branches.back());
       }
@@ -281,31 +278,173 @@ void StructuredDataVersions::BranchToCereal(
 
 void StructuredDataVersions::ApplySerialised(const serialised_type& serialised_data_versions) {
   StructuredDataVersions new_info(serialised_data_versions);
-  ApplyBranch(root_.first, root_.second, new_info);
-  for (const auto& orphan_set : orphans_) {
-    for (const auto& orphan : orphan_set.second)
-      ApplyBranch(orphan_set.first, orphan, new_info);
+  if (root_ != kNoNode)
+    ApplyBranch(root_parent_, root_, new_info);
+  for (const auto orphan_set : SortedOrphans()) {
+    for (const auto& orphan : orphan_set->second)
+      ApplyBranch(orphan_set->first, orphan, new_info);
   }
   swap(*this, new_info);
 }
 
-void StructuredDataVersions::ApplyBranch(VersionName parent, VersionsItr itr,
+void StructuredDataVersions::ApplyBranch(VersionName parent, NodeIndex node,
                                          StructuredDataVersions& new_versions) const {
   for (;;) {
-    new_versions.Put(parent, itr->first);
-    if (itr->second->children.empty())
+    new_versions.Put(parent, nodes_[node].name);
+    const NodeIndex first_child(nodes_[node].first_child);
+    if (first_child == kNoNode)
       return;
-    parent = itr->first;
-    if (itr->second->children.size() == 1U) {
-      itr = *std::begin(itr->second->children);
+    parent = nodes_[node].name;
+    if (nodes_[first_child].next_sibling == kNoNode) {
+      node = first_child;
     } else {
-      for (auto child : itr->second->children)
+      for (auto child(first_child); child != kNoNode; child = nodes_[child].next_sibling)
         ApplyBranch(parent, child, new_versions);
       return;
     }
   }
 }
 
+StructuredDataVersions::MergeResult StructuredDataVersions::Merge(
+    const serialised_type& serialised_data_versions) {
+  const StructuredDataVersions other(serialised_data_versions);
+  MergeResult result{0, std::vector<VersionName>(), std::vector<MergeConflict>()};
+  // For each version of 'other', the index into 'result.conflicts' of the conflict rejecting it.
+  std::vector<std::size_t> conflict_indices(other.nodes_.size(), kNoConflict);
+
+  // Find the difference first, without modifying anything.
+  std::vector<std::pair<const VersionName*, NodeIndex>> missing;
+  if (other.root_ != kNoNode)
+    DiffBranch(other, other.root_, other.root_parent_, missing, conflict_indices, result);
+  for (const auto orphan_set : other.SortedOrphans()) {
+    for (const auto& orphan : orphan_set->second)
+      DiffBranch(other, orphan, orphan_set->first, missing, conflict_indices, result);
+  }
+
+  for (const auto& old_version_and_node : missing) {
+    const VersionName& old_version(*old_version_and_node.first);
+    const NodeIndex node(old_version_and_node.second);
+    const NodeIndex parent(other.nodes_[node].parent);
+    if (parent != kNoNode && conflict_indices[parent] != kNoConflict) {
+      conflict_indices[node] = conflict_indices[parent];
+      ++result.conflicts[conflict_indices[node]].rejected_count;
+      continue;
+    }
+    try {
+      auto removed_version(Put(old_version, other.nodes_[node].name));
+      ++result.added_count;
+      if (removed_version)
+        result.removed_versions.push_back(std::move(*removed_version));
+    } catch (const maidsafe_error& error) {
+      conflict_indices[node] = result.conflicts.size();
+      result.conflicts.push_back(
+          MergeConflict{old_version, other.nodes_[node].name, error.code(), 1});
+    }
+  }
+  return result;
+}
+
+void StructuredDataVersions::DiffBranch(
+    const StructuredDataVersions& other, NodeIndex front_of_branch,
+    const VersionName& absent_parent,
+    std::vector<std::pair<const VersionName*, NodeIndex>>& missing,
+    std::vector<std::size_t>& conflict_indices, MergeResult& result) const {
+  // Depth-first, so that each version is listed after its parent.
+  std::vector<NodeIndex> pending(1, front_of_branch);
+  while (!pending.empty()) {
+    const NodeIndex node(pending.back());
+    pending.pop_back();
+    const NodeIndex parent(other.nodes_[node].parent);
+    const VersionName& old_version(parent == kNoNode ? absent_parent : other.nodes_[parent].name);
+    if (parent != kNoNode && conflict_indices[parent] != kNoConflict) {
+      conflict_indices[node] = conflict_indices[parent];
+      ++result.conflicts[conflict_indices[node]].rejected_count;
+    } else {
+      try {
+        if (!NewVersionPreExists(old_version, other.nodes_[node].name))
+          missing.emplace_back(&old_version, node);
+      } catch (const maidsafe_error& error) {
+        conflict_indices[node] = result.conflicts.size();
+        result.conflicts.push_back(
+            MergeConflict{old_version, other.nodes_[node].name, error.code(), 1});
+      }
+    }
+    for (auto child(other.nodes_[node].first_child); child != kNoNode;
+         child = other.nodes_[child].next_sibling) {
+      pending.push_back(child);
+    }
+  }
+}
+
+StructuredDataVersions::serialised_delta_type StructuredDataVersions::SerialiseDelta(
+    const std::vector<VersionName>& since_tips,
+    const std::vector<VersionName>& since_fronts) const {
+  detail::StructuredDataVersionsDeltaCereal delta;
+  // Mark everything the peer already holds, i.e. each of its branches from tip up to front.  The
+  // walk must stop at the peer's fronts since we may hold the versions missing above its orphans.
+  std::vector<bool> known(nodes_.size(), false), is_front(nodes_.size(), false);
+  for (const auto& front : since_fronts) {
+    const auto node(Find(front));
+    if (node != kNoNode)
+      is_front[node] = true;
+  }
+  for (const auto& tip : since_tips) {
+    auto node(Find(tip));
+    if (node == kNoNode)
+      delta.removed_versions.push_back(tip);
+    for (; node != kNoNode && !known[node]; node = nodes_[node].parent) {
+      known[node] = true;
+      if (is_front[node])
+        break;
+    }
+  }
+
+  if (root_ != kNoNode)
+    BranchToDelta(root_, root_parent_, known, delta);
+  for (const auto orphan_set : SortedOrphans()) {
+    for (const auto& orphan : orphan_set->second)
+      BranchToDelta(orphan, orphan_set->first, known, delta);
+  }
+
+  return serialised_delta_type(NonEmptyString(maidsafe::Serialise(std::move(delta))));
+}
+
+void StructuredDataVersions::BranchToDelta(
+    NodeIndex front_of_branch, const VersionName& absent_parent, const std::vector<bool>& known,
+    detail::StructuredDataVersionsDeltaCereal& delta) const {
+  // Depth-first, so that each version is listed after its parent.
+  std::vector<NodeIndex> pending(1, front_of_branch);
+  while (!pending.empty()) {
+    const NodeIndex node(pending.back());
+    pending.pop_back();
+    if (!known[node]) {
+      const NodeIndex parent(nodes_[node].parent);
+      delta.puts.emplace_back(parent == kNoNode ? absent_parent : nodes_[parent].name,
+                              nodes_[node].name);
+    }
+    for (auto child(nodes_[node].first_child); child != kNoNode; child = nodes_[child].next_sibling)
+      pending.push_back(child);
+  }
+}
+
+void StructuredDataVersions::ApplyDelta(const serialised_delta_type& serialised_delta) {
+  detail::StructuredDataVersionsDeltaCereal delta;
+  try {
+    Parse(serialised_delta->string(), delta);
+  } catch (...) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+  StructuredDataVersions new_info(*this);
+  for (const auto& removed_version : delta.removed_versions) {
+    if (new_info.FindBranchTip(removed_version) != std::end(new_info.tips_of_trees_))
+      new_info.DeleteBranchUntilFork(removed_version);
+  }
+  for (const auto& put : delta.puts)
+    new_info.Put(put.old_version, put.new_version);
+  swap(*this, new_info);
+}
+
 boost::optional<StructuredDataVersions::VersionName> StructuredDataVersions::Put(
     const VersionName& old_version, const VersionName& new_version) {
   if (!new_version.id.IsInitialised())
@@ -315,23 +454,21 @@ boost::optional<StructuredDataVersions::VersionName> StructuredDataVersions::Put
     return boost::none;
 
   // Check we've not been asked to store two roots.
-  bool is_root(!old_version.id.IsInitialised() || versions_.empty() || new_version.index == 0);
-  if (is_root && root_.second != std::end(versions_) && !RootParentName().id.IsInitialised())
+  bool is_root(!old_version.id.IsInitialised() || nodes_.empty() || new_version.index == 0);
+  if (is_root && root_ != kNoNode && !root_parent_.id.IsInitialised())
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
 
-  // Construct temp objects before modifying members in case exception is thrown.
-  Version version(std::make_pair(
-      new_version,
-      std::make_shared<Details>(is_root ? std::end(versions_) : versions_.find(old_version))));
-  bool is_orphan(version.second->parent == std::end(versions_) && !is_root);
+  // Gather everything needed before modifying members in case exception is thrown.
+  const NodeIndex parent(is_root ? kNoNode : Find(old_version));
+  bool is_orphan(parent == kNoNode && !is_root);
   bool unorphans_existing_root(false);
   size_t unorphan_count;
-  CheckForUnorphaning(version, unorphans_existing_root, unorphan_count);
+  CheckForUnorphaning(new_version, parent, unorphans_existing_root, unorphan_count);
 
   // If there's a root version with index of 0 and this has passed 'old_version' with index of 0,
   // check this call isn't implying two different roots
-  if (is_orphan && root_.second->first.index == 0 && old_version.index == 0 &&
-      root_.second->first.id != old_version.id) {
+  if (is_orphan && nodes_[root_].name.index == 0 && old_version.index == 0 &&
+      nodes_[root_].name.id != old_version.id) {
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
   }
 
@@ -346,110 +483,101 @@ boost::optional<StructuredDataVersions::VersionName> StructuredDataVersions::Put
   }
 
   // Handle case where we're about to exceed 'max_branches_'.
-  CheckBranchCount(version, is_orphan, unorphan_count, erase_existing_root);
+  CheckBranchCount(parent, is_root, is_orphan, unorphan_count, unorphans_existing_root,
+                   erase_existing_root);
 
   // Finally, safe to now add details
-  return Insert(version, is_root, is_orphan, old_version, unorphans_existing_root, unorphan_count,
-                erase_existing_root);
+  ReserveForInsert();
+  return Insert(new_version, parent, is_root, is_orphan, old_version, unorphans_existing_root,
+                unorphan_count, erase_existing_root);
 }
 
-StructuredDataVersions::VersionName StructuredDataVersions::ParentName(VersionsItr itr) const {
-  return itr->second->parent->first;
-}
-
-StructuredDataVersions::VersionName StructuredDataVersions::ParentName(
-    Versions::const_iterator itr) const {
-  return itr->second->parent->first;
+std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::PutMany(
+    const std::vector<std::pair<VersionName, VersionName>>& old_and_new_versions) {
+  StructuredDataVersions new_info(*this);
+  const std::size_t expected_size(std::min<std::size_t>(
+      nodes_.size() + old_and_new_versions.size(), max_versions_ + std::size_t(1)));
+  new_info.nodes_.reserve(expected_size);
+  new_info.index_.reserve(expected_size);
+
+  std::vector<VersionName> removed_versions;
+  for (const auto& old_and_new_version : old_and_new_versions) {
+    auto removed_version(new_info.Put(old_and_new_version.first, old_and_new_version.second));
+    if (removed_version)
+      removed_versions.push_back(std::move(*removed_version));
+  }
+  swap(*this, new_info);
+  return removed_versions;
 }
 
-StructuredDataVersions::VersionName StructuredDataVersions::RootParentName() const {
-  return root_.first;
+StructuredDataVersions::NodeIndex StructuredDataVersions::Find(const VersionName& name) const {
+  auto itr(index_.find(name));
+  return itr == std::end(index_) ? kNoNode : itr->second;
 }
 
 bool StructuredDataVersions::NewVersionPreExists(const VersionName& old_version,
                                                  const VersionName& new_version) const {
-  auto existing_itr(versions_.find(new_version));
-  if (existing_itr != std::end(versions_)) {
-    if (existing_itr->second->parent == std::end(versions_)) {
-      // This is root or an orphan
-      if (new_version == root_.second->first) {
-        if (root_.first == old_version)
-          return true;
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
-      }
-
-      auto orphan_itr(FindOrphan(new_version));
-      assert(orphan_itr.first != std::end(orphans_) &&
-             orphan_itr.second != std::end(orphan_itr.first->second));
-      if (orphan_itr.first != std::end(orphans_) && orphan_itr.first->first == old_version)
+  const NodeIndex existing(Find(new_version));
+  if (existing == kNoNode)
+    return false;
+
+  const NodeIndex parent(nodes_[existing].parent);
+  if (parent == kNoNode) {
+    // This is root or an orphan
+    if (existing == root_) {
+      if (root_parent_ == old_version)
         return true;
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
-    } else {
-      if (ParentName(existing_itr) == old_version)
-        return true;
-      else
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
     }
+
+    auto orphan_itr(FindOrphan(new_version));
+    assert(orphan_itr.first != std::end(orphans_) &&
+           orphan_itr.second != std::end(orphan_itr.first->second));
+    if (orphan_itr.first != std::end(orphans_) && orphan_itr.first->first == old_version)
+      return true;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
   }
-  return false;
+
+  if (nodes_[parent].name == old_version)
+    return true;
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
 }
 
-void StructuredDataVersions::CheckForUnorphaning(Version& version, bool& unorphans_existing_root,
+void StructuredDataVersions::CheckForUnorphaning(const VersionName& new_version, NodeIndex parent,
+                                                 bool& unorphans_existing_root,
                                                  size_t& unorphan_count) const {
-  auto orphans_itr(orphans_.find(version.first));
+  auto orphans_itr(orphans_.find(new_version));
   unorphan_count = (orphans_itr == std::end(orphans_) ? 0 : orphans_itr->second.size());
-  std::vector<std::future<void>> check_futures;
-  const VersionName* const version_parent(version.second->parent != std::end(versions_) &&
-                                                  version.second->parent->first.id.IsInitialised()
-                                              ? &version.second->parent->first
-                                              : nullptr);
   if (unorphan_count) {
-    for (auto orphan_itr(std::begin(orphans_itr->second));
-         orphan_itr != std::end(orphans_itr->second); ++orphan_itr) {
-      // Check we can't iterate back to ourself (avoid circular parent-child chain)
-      if (version_parent)
-        check_futures.push_back(CheckVersionNotInBranch(*orphan_itr, *version_parent));
-      CheckedInsert(version.second->children, *orphan_itr);
-    }
+    // Check we can't iterate back to ourself (avoid circular parent-child chain)
+    for (auto orphan : orphans_itr->second)
+      CheckNotAncestor(orphan, parent);
+  }
+  unorphans_existing_root = (root_parent_.id.IsInitialised() && root_parent_ == new_version);
+  if (unorphans_existing_root)
+    CheckNotAncestor(root_, parent);
+}
+
+void StructuredDataVersions::CheckNotAncestor(NodeIndex candidate, NodeIndex node) const {
+  // Walks up the parent links, so costs O(depth of 'node') with no allocations.
+  for (; node != kNoNode; node = nodes_[node].parent) {
+    if (node == candidate)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
   }
-  unorphans_existing_root = (root_.first.id.IsInitialised() && RootParentName() == version.first);
-  if (unorphans_existing_root) {
-    if (version_parent)
-      check_futures.push_back(CheckVersionNotInBranch(root_.second, *version_parent));
-    CheckedInsert(version.second->children, root_.second);
-  }
-  for (auto& check_future : check_futures)
-    check_future.get();
-}
-
-std::future<void> StructuredDataVersions::CheckVersionNotInBranch(
-    VersionsItr itr, const VersionName& version) const {
-  return std::async([this, itr, &version]() {
-    VersionsItr versions_itr(itr);
-    while (versions_itr != std::end(versions_)) {
-      auto child_itr(std::begin(versions_itr->second->children));
-      if (child_itr == std::end(versions_itr->second->children))
-        return;
-      if ((*child_itr)->first == version)
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
-      std::vector<std::future<void>> check_futures;
-      while (++child_itr != std::end(versions_itr->second->children))
-        check_futures.emplace_back(CheckVersionNotInBranch(*child_itr, version));
-      versions_itr = *std::begin(versions_itr->second->children);
-      for (auto& check_future : check_futures)
-        check_future.get();
-    }
-  });
 }
 
-void StructuredDataVersions::CheckBranchCount(const Version& version, bool is_orphan,
+void StructuredDataVersions::CheckBranchCount(NodeIndex parent, bool is_root, bool is_orphan,
                                               size_t unorphaned_count,
+                                              bool unorphans_existing_root,
                                               bool& erase_existing_root) const {
-  if (AtBranchesLimit() && unorphaned_count == 0) {
-    if (is_orphan || !version.second->parent->second->children.empty()) {
+  if (AtBranchesLimit() && unorphaned_count == 0 && !unorphans_existing_root) {
+    // A new root moves the current one into 'orphans_', so erasing 'root_' can't make room.
+    if (is_root)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+    // An orphan always starts a new branch, as does a new child of a non-tip version.
+    if (is_orphan || nodes_[parent].first_child != kNoNode) {
       // We're going to exceed limit - see if deleting 'root_' helps
-      bool root_is_tip_of_tree(root_.second != std::end(versions_) &&
-                               root_.second->second->children.empty());
+      bool root_is_tip_of_tree(root_ != kNoNode && nodes_[root_].first_child == kNoNode);
       if (root_is_tip_of_tree)
         erase_existing_root = true;
       else
@@ -458,99 +586,124 @@ void StructuredDataVersions::CheckBranchCount(const Version& version, bool is_or
   }
 }
 
+void StructuredDataVersions::ReserveForInsert() {
+  // Reserves space up front so that the only allocations left in Insert are those for 'orphans_'.
+  if (nodes_.size() == nodes_.capacity())
+    nodes_.reserve(std::min<std::size_t>(2 * nodes_.size() + 1, max_versions_ + std::size_t(1)));
+  index_.reserve(nodes_.size() + 1);
+  if (tips_of_trees_.size() == tips_of_trees_.capacity())
+    tips_of_trees_.reserve(tips_of_trees_.size() + 1);
+}
+
 boost::optional<StructuredDataVersions::VersionName> StructuredDataVersions::Insert(
-    const Version& version, bool is_root, bool is_orphan, const VersionName& old_version,
-    bool unorphans_existing_root, size_t unorphan_count, bool erase_existing_root) {
+    const VersionName& new_version, NodeIndex parent, bool is_root, bool is_orphan,
+    const VersionName& old_version, bool unorphans_existing_root, size_t unorphan_count,
+    bool erase_existing_root) {
   assert(!((is_root || unorphans_existing_root) && erase_existing_root));
 
-  auto inserted_itr(versions_.insert(version).first);
-  if (unorphan_count)
-    Unorphan(inserted_itr);
+  const NodeIndex inserted(static_cast<NodeIndex>(nodes_.size()));
+  nodes_.emplace_back(VersionName(new_version.index, new_version.id));
+  index_.try_emplace(nodes_.back().name, inserted);
 
-  if (!is_root && !is_orphan)
-    SetVersionAsChildOfItsParent(inserted_itr);
+  if (unorphan_count)
+    Unorphan(inserted);
+
+  // If 'parent' is a "tip of tree", its slot in 'tips_of_trees_' is reused below.
+  NodeIndices::size_type parent_tip_position(tips_of_trees_.size());
+  if (!is_root && !is_orphan) {
+    if (nodes_[parent].first_child == kNoNode) {
+      auto tip_of_tree_itr(FindBranchTip(nodes_[parent].name));
+      assert(tip_of_tree_itr != std::end(tips_of_trees_));
+      parent_tip_position =
+          static_cast<NodeIndices::size_type>(tip_of_tree_itr - std::begin(tips_of_trees_));
+    }
+    AddChild(parent, inserted);
+  }
 
   if (is_orphan && !unorphans_existing_root)
-    InsertOrphan(old_version, inserted_itr);
+    InsertOrphan(old_version, inserted);
 
-  if (is_root && root_.first.id.IsInitialised() && !unorphans_existing_root) {
+  if (is_root && root_parent_.id.IsInitialised() && !unorphans_existing_root) {
     // The new root is replacing a temporary old root which would have been an orphan had the real
     // root existed at that time.  Move the old root to 'orphans_'.
-    InsertOrphan(root_.first, root_.second);
+    InsertOrphan(root_parent_, root_);
   }
 
-  boost::optional<VersionName> removed_version;
   if (is_root) {
-    if (unorphans_existing_root)
-      UnorphanRoot(inserted_itr, true, old_version);
-    else
-      root_ = std::make_pair(old_version, inserted_itr);
+    if (unorphans_existing_root) {
+      UnorphanRoot(inserted, true, old_version);
+    } else {
+      root_parent_ = old_version;
+      root_ = inserted;
+    }
   } else if (unorphans_existing_root) {
-    UnorphanRoot(inserted_itr, is_orphan, old_version);
-  } else if (erase_existing_root) {
-    removed_version = root_.second->first;
-    ReplaceRoot();
+    UnorphanRoot(inserted, is_orphan, old_version);
   }
 
-  if (version.second->children.empty())
-    CheckedInsert(tips_of_trees_, inserted_itr);
-
-  assert(versions_.size() <= max_versions_ && tips_of_trees_.size() <= max_branches_);
-  return removed_version;
-}
+  if (parent_tip_position != tips_of_trees_.size()) {
+    auto parent_tip_itr(std::begin(tips_of_trees_) + parent_tip_position);
+    if (nodes_[inserted].first_child == kNoNode)
+      ReplaceBranchTip(parent_tip_itr, inserted);
+    else
+      tips_of_trees_.erase(parent_tip_itr);
+  } else if (nodes_[inserted].first_child == kNoNode) {
+    InsertSorted(tips_of_trees_, inserted);
+  }
 
-void StructuredDataVersions::SetVersionAsChildOfItsParent(VersionsItr versions_itr) {
-  auto& parents_children(versions_itr->second->parent->second->children);
-  if (parents_children.empty()) {
-    auto tip_of_tree_itr(std::find_if(
-        std::begin(tips_of_trees_), std::end(tips_of_trees_),
-        [this, versions_itr](VersionsItr tot) { return tot->first == ParentName(versions_itr); }));
-    assert(tip_of_tree_itr != std::end(tips_of_trees_));
-    tips_of_trees_.erase(tip_of_tree_itr);
+  // This must come last since erasing the root may move 'inserted' to a different index.
+  boost::optional<VersionName> removed_version;
+  if (erase_existing_root) {
+    removed_version = nodes_[root_].name;
+    ReplaceRoot();
   }
-  CheckedInsert(parents_children, versions_itr);
+
+  assert(nodes_.size() <= max_versions_ && tips_of_trees_.size() <= max_branches_);
+  return removed_version;
 }
 
-void StructuredDataVersions::UnorphanRoot(VersionsItr parent, bool is_root_or_orphan,
+void StructuredDataVersions::UnorphanRoot(NodeIndex parent, bool is_root_or_orphan,
                                           const VersionName& old_version) {
-  root_.second->second->parent = parent;
+  AddChild(parent, root_);
   if (is_root_or_orphan) {
-    root_ = std::make_pair(old_version, parent);
+    root_parent_ = old_version;
+    root_ = parent;
   } else {
     // Find the start of the current branch - must be an orphan.
     auto new_root(parent);
-    while (new_root->second->parent != std::end(versions_))
-      new_root = new_root->second->parent;
-    auto orphan_itr(FindOrphan(new_root->first));
+    while (nodes_[new_root].parent != kNoNode)
+      new_root = nodes_[new_root].parent;
+    auto orphan_itr(FindOrphan(nodes_[new_root].name));
     assert(orphan_itr.first != std::end(orphans_));
     if (orphan_itr.first == std::end(orphans_))
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
     // Move from orphans to root_
-    root_.first = orphan_itr.first->first;
-    root_.second = *orphan_itr.second;
+    root_parent_ = orphan_itr.first->first;
+    root_ = *orphan_itr.second;
     EraseOrphan(orphan_itr);
   }
 }
 
-void StructuredDataVersions::Unorphan(VersionsItr parent) {
-  auto orphans_itr(orphans_.find(parent->first));
+void StructuredDataVersions::Unorphan(NodeIndex parent) {
+  auto orphans_itr(orphans_.find(nodes_[parent].name));
   assert(orphans_itr != std::end(orphans_));
   if (orphans_itr == std::end(orphans_))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
 
-  for (auto orphan : orphans_itr->second)
-    orphan->second->parent = parent;
+  for (auto orphan : orphans_itr->second) {
+    absent_parents_.erase(nodes_[orphan].name);
+    AddChild(parent, orphan);
+  }
 
   orphans_.erase(orphans_itr);
 }
 
 void StructuredDataVersions::ReplaceRoot() {
   // Remove current root from 'tips_of_trees_'.
-  auto tip_of_tree_itr(FindBranchTip(root_.second->first));
+  auto tip_of_tree_itr(FindBranchTip(nodes_[root_].name));
   if (tip_of_tree_itr != std::end(tips_of_trees_))
     tips_of_trees_.erase(tip_of_tree_itr);
 
-  if (root_.second->second->children.empty())
+  if (nodes_[root_].first_child == kNoNode)
     ReplaceRootFromOrphans();
   else
     ReplaceRootFromChildren();
@@ -558,111 +711,187 @@ void StructuredDataVersions::ReplaceRoot() {
 
 void StructuredDataVersions::ReplaceRootFromOrphans() {
   assert(!orphans_.empty());
-  OrphanItr orphan_itr(
-      std::make_pair(std::begin(orphans_), std::begin(std::begin(orphans_)->second)));
-  versions_.erase(root_.second);
-  root_.first = orphan_itr.first->first;
-  root_.second = *orphan_itr.second;
+  // Choose the first orphan held under the lowest absent parent.
+  auto orphan_set_itr(std::min_element(
+      std::begin(orphans_), std::end(orphans_),
+      [](const Orphans::value_type& lhs, const Orphans::value_type& rhs) {
+        return lhs.first < rhs.first;
+      }));
+  OrphanItr orphan_itr(std::make_pair(orphan_set_itr, std::begin(orphan_set_itr->second)));
+  const NodeIndex old_root(root_);
+  root_parent_ = orphan_itr.first->first;
+  root_ = *orphan_itr.second;
   EraseOrphan(orphan_itr);
+  EraseNode(old_root);
 }
 
 void StructuredDataVersions::ReplaceRootFromChildren() {
-  // Create orphans and find replacement from current root's children.
-  auto child_itr(std::begin(root_.second->second->children));
-  auto current_root_name(root_.second->first);
-  auto replacement_root(std::make_pair(current_root_name, *child_itr));
-  replacement_root.second->second->parent = std::end(versions_);
-
-  while (++child_itr != std::end(root_.second->second->children)) {
-    (*child_itr)->second->parent = std::end(versions_);
-    InsertOrphan(current_root_name, *child_itr);
+  // Create orphans and find replacement from current root's children.  The first child has the
+  // lowest VersionName, so becomes the new root.
+  const NodeIndex old_root(root_);
+  const VersionName current_root_name(nodes_[old_root].name);
+  auto child(nodes_[old_root].first_child);
+  nodes_[old_root].first_child = kNoNode;
+  root_parent_ = current_root_name;
+  root_ = child;
+
+  while (child != kNoNode) {
+    const auto next_sibling(nodes_[child].next_sibling);
+    nodes_[child].parent = kNoNode;
+    nodes_[child].next_sibling = kNoNode;
+    if (child != root_)
+      InsertOrphan(current_root_name, child);
+    child = next_sibling;
   }
 
-  versions_.erase(root_.second);
-  root_ = replacement_root;
+  EraseNode(old_root);
 }
 
-StructuredDataVersions::SortedVersionsItrs::const_iterator StructuredDataVersions::FindBranchTip(
+StructuredDataVersions::NodeIndices::iterator StructuredDataVersions::FindBranchTip(
+    const VersionName& name) {
+  const auto& const_this(*this);
+  auto itr(const_this.FindBranchTip(name));
+  return std::begin(tips_of_trees_) + (itr - std::begin(const_this.tips_of_trees_));
+}
+
+StructuredDataVersions::NodeIndices::const_iterator StructuredDataVersions::FindBranchTip(
     const VersionName& name) const {
-  return std::find_if(std::begin(tips_of_trees_), std::end(tips_of_trees_),
-                      [&name](VersionsItr branch_tip) { return branch_tip->first == name; });
+  auto itr(std::lower_bound(std::begin(tips_of_trees_), std::end(tips_of_trees_), name,
+                            [this](NodeIndex branch_tip, const VersionName& rhs) {
+                              return nodes_[branch_tip].name < rhs;
+                            }));
+  return (itr != std::end(tips_of_trees_) && nodes_[*itr].name == name) ? itr
+                                                                         : std::end(tips_of_trees_);
 }
 
 StructuredDataVersions::OrphanItr StructuredDataVersions::FindOrphan(const VersionName& name) {
+  // Look up the absent parent which the orphan is held under, then binary search that set.
   OrphanItr orphan_itr;
-  orphan_itr.first = std::begin(orphans_);
-  while (orphan_itr.first != std::end(orphans_)) {
-    orphan_itr.second = std::find_if(
-        std::begin(orphan_itr.first->second), std::end(orphan_itr.first->second),
-        [&name](SortedVersionsItrs::value_type version) { return version->first == name; });
-    if (orphan_itr.second != std::end(orphan_itr.first->second))
-      break;
-    ++orphan_itr.first;
+  auto absent_parent_itr(absent_parents_.find(name));
+  if (absent_parent_itr == std::end(absent_parents_)) {
+    orphan_itr.first = std::end(orphans_);
+    return orphan_itr;
   }
+  orphan_itr.first = orphans_.find(absent_parent_itr->second);
+  assert(orphan_itr.first != std::end(orphans_));
+  orphan_itr.second = std::lower_bound(std::begin(orphan_itr.first->second),
+                                       std::end(orphan_itr.first->second), name,
+                                       [this](NodeIndex orphan, const VersionName& rhs) {
+                                         return nodes_[orphan].name < rhs;
+                                       });
+  assert(orphan_itr.second != std::end(orphan_itr.first->second) &&
+         nodes_[*orphan_itr.second].name == name);
   return orphan_itr;
 }
 
 StructuredDataVersions::OrphanConstItr StructuredDataVersions::FindOrphan(
     const VersionName& name) const {
+  // Look up the absent parent which the orphan is held under, then binary search that set.
   OrphanConstItr orphan_itr;
-  orphan_itr.first = std::begin(orphans_);
-  while (orphan_itr.first != std::end(orphans_)) {
-    orphan_itr.second = std::find_if(
-        std::begin(orphan_itr.first->second), std::end(orphan_itr.first->second),
-        [&name](SortedVersionsItrs::value_type version) { return version->first == name; });
-    if (orphan_itr.second != std::end(orphan_itr.first->second))
-      break;
-    ++orphan_itr.first;
+  auto absent_parent_itr(absent_parents_.find(name));
+  if (absent_parent_itr == std::end(absent_parents_)) {
+    orphan_itr.first = std::end(orphans_);
+    return orphan_itr;
   }
+  orphan_itr.first = orphans_.find(absent_parent_itr->second);
+  assert(orphan_itr.first != std::end(orphans_));
+  orphan_itr.second = std::lower_bound(std::begin(orphan_itr.first->second),
+                                       std::end(orphan_itr.first->second), name,
+                                       [this](NodeIndex orphan, const VersionName& rhs) {
+                                         return nodes_[orphan].name < rhs;
+                                       });
+  assert(orphan_itr.second != std::end(orphan_itr.first->second) &&
+         nodes_[*orphan_itr.second].name == name);
   return orphan_itr;
 }
 
+std::vector<const StructuredDataVersions::Orphans::value_type*>
+    StructuredDataVersions::SortedOrphans() const {
+  std::vector<const Orphans::value_type*> sorted;
+  sorted.reserve(orphans_.size());
+  for (const auto& orphan_set : orphans_)
+    sorted.push_back(&orphan_set);
+  std::sort(std::begin(sorted), std::end(sorted),
+            [](const Orphans::value_type* lhs, const Orphans::value_type* rhs) {
+              return lhs->first < rhs->first;
+            });
+  return sorted;
+}
+
 void StructuredDataVersions::InsertOrphan(const VersionName& absent_parent_name,
-                                          VersionsItr orphan) {
+                                          NodeIndex orphan) {
   // This either creates a new entry in the orphans map, or gives the existing one for parent.
-  auto orphans_itr(
-      orphans_.insert(std::make_pair(absent_parent_name,
-                                     SortedVersionsItrs([](VersionsItr lhs, VersionsItr rhs) {
-                                       return *lhs < *rhs;
-                                     }))).first);
-  orphans_itr->second.insert(orphan);
+  InsertSorted(orphans_[absent_parent_name], orphan);
+  absent_parents_.try_emplace(nodes_[orphan].name, absent_parent_name);
 }
 
 void StructuredDataVersions::EraseOrphan(OrphanItr orphan_itr) {
   assert(orphan_itr.first != std::end(orphans_) &&
          orphan_itr.second != std::end(orphan_itr.first->second));
+  absent_parents_.erase(nodes_[*orphan_itr.second].name);
   orphan_itr.first->second.erase(orphan_itr.second);
   if (orphan_itr.first->second.empty())
     orphans_.erase(orphan_itr.first);
 }
 
+std::size_t StructuredDataVersions::orphan_bytes() const {
+  // Each table allocates one control byte per slot alongside the slot itself.
+  std::size_t bytes(orphans_.bucket_count() * (sizeof(Orphans::value_type) + 1) +
+                    absent_parents_.bucket_count() * (sizeof(AbsentParents::value_type) + 1));
+  for (const auto& orphan_set : orphans_)
+    bytes += orphan_set.second.capacity() * sizeof(NodeIndex);
+  return bytes;
+}
+
 std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::Get() const {
+  return Get(tips_of_trees_.size());
+}
+
+std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::Get(
+    std::size_t max_count) const {
   std::vector<StructuredDataVersions::VersionName> result;
-  for (const auto& tot : tips_of_trees_) {
-    assert(tot->second->children.empty());
-    result.push_back(tot->first);
+  result.reserve(std::min(max_count, tips_of_trees_.size()));
+  for (auto itr(tips_of_trees_.rbegin()); itr != tips_of_trees_.rend() && max_count != 0;
+       ++itr, --max_count) {
+    assert(nodes_[*itr].first_child == kNoNode);
+    result.push_back(nodes_[*itr].name);
   }
-  std::reverse(std::begin(result), std::end(result));
   return result;
 }
 
 std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::GetBranch(
     const VersionName& branch_tip) const {
+  return GetBranch(branch_tip, std::numeric_limits<std::size_t>::max(), 0);
+}
+
+std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::GetBranch(
+    const VersionName& branch_tip, std::size_t max_count, std::size_t start) const {
   auto branch_tip_itr(FindBranchTip(branch_tip));
   CheckBranchTipIterator(branch_tip, branch_tip_itr);
-  auto itr(*branch_tip_itr);
+  auto node(*branch_tip_itr);
+  for (; node != kNoNode && start != 0; --start)
+    node = nodes_[node].parent;
   std::vector<StructuredDataVersions::VersionName> result;
-  while (itr != std::end(versions_)) {
-    result.push_back(itr->first);
-    itr = itr->second->parent;
+  for (; node != kNoNode && result.size() != max_count; node = nodes_[node].parent)
+    result.push_back(nodes_[node].name);
+  return result;
+}
+
+std::vector<StructuredDataVersions::VersionName> StructuredDataVersions::GetBranchFronts() const {
+  std::vector<StructuredDataVersions::VersionName> result;
+  if (root_ != kNoNode)
+    result.push_back(nodes_[root_].name);
+  for (const auto orphan_set : SortedOrphans()) {
+    for (const auto& orphan : orphan_set->second)
+      result.push_back(nodes_[orphan].name);
   }
   return result;
 }
 
 void StructuredDataVersions::CheckBranchTipIterator(
-    const VersionName& name, SortedVersionsItrs::const_iterator branch_tip_itr) const {
+    const VersionName& name, NodeIndices::const_iterator branch_tip_itr) const {
   if (branch_tip_itr == std::end(tips_of_trees_)) {
-    if (versions_.find(name) == std::end(versions_))
+    if (Find(name) == kNoNode)
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
     else
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
@@ -672,51 +901,52 @@ void StructuredDataVersions::CheckBranchTipIterator(
 void StructuredDataVersions::DeleteBranchUntilFork(const VersionName& branch_tip) {
   auto branch_tip_itr(FindBranchTip(branch_tip));
   CheckBranchTipIterator(branch_tip, branch_tip_itr);
-  auto itr(*branch_tip_itr);
+  auto node(*branch_tip_itr);
   tips_of_trees_.erase(branch_tip_itr);
 
   for (;;) {
-    auto parent_itr = itr->second->parent;
-    if (parent_itr == std::end(versions_))  // Found root or orphan.
-      return EraseFrontOfBranch(itr);
-    auto parents_child_itr(std::find_if(
-        std::begin(parent_itr->second->children), std::end(parent_itr->second->children),
-        [itr](VersionsItr child_itr) { return itr->first == child_itr->first; }));
-    assert(parents_child_itr != std::end(parent_itr->second->children));
-    parent_itr->second->children.erase(parents_child_itr);
-    versions_.erase(itr);
-    if (!parent_itr->second->children.empty())  // Found fork.
+    auto parent(nodes_[node].parent);
+    if (parent == kNoNode)  // Found root or orphan.
+      return EraseFrontOfBranch(node);
+    RemoveChild(parent, node);
+    if (EraseNode(node) == parent)
+      parent = node;
+    if (nodes_[parent].first_child != kNoNode)  // Found fork.
       return;
 
-    itr = parent_itr;
+    node = parent;
   }
 }
 
-void StructuredDataVersions::EraseFrontOfBranch(VersionsItr front_of_branch) {
-  if (root_.second == front_of_branch) {  // Front of branch is 'root_'.
+void StructuredDataVersions::EraseFrontOfBranch(NodeIndex front_of_branch) {
+  if (root_ == front_of_branch) {  // Front of branch is 'root_'.
     if (orphans_.empty()) {
-      versions_.erase(front_of_branch);
-      root_ = std::make_pair(VersionName(), std::end(versions_));
-      assert(versions_.empty() && tips_of_trees_.empty());
+      root_parent_ = VersionName();
+      root_ = kNoNode;
+      EraseNode(front_of_branch);
+      assert(nodes_.empty() && tips_of_trees_.empty());
     } else {
       ReplaceRootFromOrphans();
     }
   } else {  // Front of branch is an orphan.
-    EraseOrphan(FindOrphan(front_of_branch->first));
-    versions_.erase(front_of_branch);
+    EraseOrphan(FindOrphan(nodes_[front_of_branch].name));
+    EraseNode(front_of_branch);
   }
 }
 
 void StructuredDataVersions::clear() {
-  versions_.clear();
-  root_ = std::make_pair(VersionName(), std::end(versions_));
+  nodes_.clear();
+  index_.clear();
+  root_parent_ = VersionName();
+  root_ = kNoNode;
   tips_of_trees_.clear();
   orphans_.clear();
+  absent_parents_.clear();
 }
 
 bool StructuredDataVersions::AtVersionsLimit() const {
-  assert(versions_.size() <= max_versions_);
-  return versions_.size() == max_versions_;
+  assert(nodes_.size() <= max_versions_);
+  return nodes_.size() == max_versions_;
 }
 
 bool StructuredDataVersions::AtBranchesLimit() const {
@@ -724,45 +954,105 @@ bool StructuredDataVersions::AtBranchesLimit() const {
   return tips_of_trees_.size() == max_branches_;
 }
 
-void StructuredDataVersions::CheckedInsert(SortedVersionsItrs& container,
-                                           VersionsItr element) const {
-  auto result(container.insert(element));
-  assert(result.second);
-  static_cast<void>(result);
+void StructuredDataVersions::AddChild(NodeIndex parent, NodeIndex child) {
+  // Keep the children sorted by VersionName.
+  auto link(&nodes_[parent].first_child);
+  while (*link != kNoNode && nodes_[*link].name < nodes_[child].name)
+    link = &nodes_[*link].next_sibling;
+  assert(*link == kNoNode || nodes_[*link].name != nodes_[child].name);
+  nodes_[child].parent = parent;
+  nodes_[child].next_sibling = *link;
+  *link = child;
+}
+
+void StructuredDataVersions::RemoveChild(NodeIndex parent, NodeIndex child) {
+  auto link(&nodes_[parent].first_child);
+  while (*link != child) {
+    assert(*link != kNoNode);
+    link = &nodes_[*link].next_sibling;
+  }
+  *link = nodes_[child].next_sibling;
+  nodes_[child].parent = kNoNode;
+  nodes_[child].next_sibling = kNoNode;
+}
+
+void StructuredDataVersions::ReplaceBranchTip(NodeIndices::iterator tip_of_tree_itr,
+                                              NodeIndex new_tip) {
+  // Rather than erasing the old tip and inserting the new one (each shifting the tail of
+  // 'tips_of_trees_'), only the tips between the two positions are shifted.
+  const auto less([this](NodeIndex lhs, NodeIndex rhs) {
+    return nodes_[lhs].name < nodes_[rhs].name;
+  });
+  *tip_of_tree_itr = new_tip;
+  const auto next(std::next(tip_of_tree_itr));
+  if (next != std::end(tips_of_trees_) && less(*next, new_tip)) {
+    std::rotate(tip_of_tree_itr, next,
+                std::lower_bound(next, std::end(tips_of_trees_), new_tip, less));
+  } else if (tip_of_tree_itr != std::begin(tips_of_trees_) &&
+             less(new_tip, *std::prev(tip_of_tree_itr))) {
+    std::rotate(std::upper_bound(std::begin(tips_of_trees_), tip_of_tree_itr, new_tip, less),
+                tip_of_tree_itr, next);
+  }
+}
+
+void StructuredDataVersions::InsertSorted(NodeIndices& container, NodeIndex element) const {
+  auto itr(std::lower_bound(std::begin(container), std::end(container), element,
+                            [this](NodeIndex lhs, NodeIndex rhs) {
+                              return nodes_[lhs].name < nodes_[rhs].name;
+                            }));
+  assert(itr == std::end(container) || nodes_[*itr].name != nodes_[element].name);
+  container.insert(itr, element);
+}
+
+StructuredDataVersions::NodeIndex StructuredDataVersions::EraseNode(NodeIndex node) {
+  assert(nodes_[node].first_child == kNoNode);
+  index_.erase(nodes_[node].name);
+  const NodeIndex last(static_cast<NodeIndex>(nodes_.size() - 1));
+  if (node == last) {
+    nodes_.pop_back();
+    return kNoNode;
+  }
+
+  // Repoint everything which refers to 'last' to 'node', then move it there.
+  Node& moved(nodes_[last]);
+  if (moved.parent != kNoNode) {
+    auto link(&nodes_[moved.parent].first_child);
+    while (*link != last)
+      link = &nodes_[*link].next_sibling;
+    *link = node;
+  } else if (root_ == last) {
+    root_ = node;
+  } else {
+    auto orphan_itr(FindOrphan(moved.name));
+    assert(orphan_itr.first != std::end(orphans_));
+    *orphan_itr.second = node;
+  }
+
+  if (moved.first_child == kNoNode) {
+    auto tip_of_tree_itr(FindBranchTip(moved.name));
+    if (tip_of_tree_itr != std::end(tips_of_trees_))
+      *tip_of_tree_itr = node;
+  }
+  for (auto child(moved.first_child); child != kNoNode; child = nodes_[child].next_sibling)
+    nodes_[child].parent = node;
+
+  index_.find(moved.name)->second = node;
+  nodes_[node] = std::move(moved);
+  nodes_.pop_back();
+  return last;
 }
 
 void swap(StructuredDataVersions& lhs, StructuredDataVersions& rhs) MAIDSAFE_NOEXCEPT {
   using std::swap;
   swap(lhs.max_versions_, rhs.max_versions_);
   swap(lhs.max_branches_, rhs.max_branches_);
-  // std::map::swap invalidates end iterators.  root_ and orphans_ have parents which are
-  // end iterators - these need reset after the call to swap(lhs.versions_, rhs.versions_).  Also,
-  // root_ may not yet have been set, in which case root_.second is an end iterator.
-  bool lhs_root_previously_not_set(lhs.root_.second == std::end(lhs.versions_));
-  bool rhs_root_previously_not_set(rhs.root_.second == std::end(rhs.versions_));
-  swap(lhs.versions_, rhs.versions_);
+  swap(lhs.nodes_, rhs.nodes_);
+  swap(lhs.index_, rhs.index_);
+  swap(lhs.root_parent_, rhs.root_parent_);
   swap(lhs.root_, rhs.root_);
-
-  if (lhs_root_previously_not_set)
-    rhs.root_.second = std::end(rhs.versions_);
-  else
-    rhs.root_.second->second->parent = std::end(rhs.versions_);
-  if (rhs_root_previously_not_set)
-    lhs.root_.second = std::end(lhs.versions_);
-  else
-    lhs.root_.second->second->parent = std::end(lhs.versions_);
-
   swap(lhs.tips_of_trees_, rhs.tips_of_trees_);
-
   swap(lhs.orphans_, rhs.orphans_);
-  for (const auto& lhs_orphans : lhs.orphans_) {
-    for (auto lhs_orphan : lhs_orphans.second)
-      lhs_orphan->second->parent == std::end(lhs.versions_);
-  }
-  for (const auto& rhs_orphans : rhs.orphans_) {
-    for (auto rhs_orphan : rhs_orphans.second)
-      rhs_orphan->second->parent == std::end(rhs.versions_);
-  }
+  swap(lhs.absent_parents_, rhs.absent_parents_);
 }
 
 }  // namespace maidsafe
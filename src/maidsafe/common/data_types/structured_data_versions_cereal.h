@@ -20,6 +20,7 @@
 #define MAIDSAFE_COMMON_DATA_TYPES_STRUCTURED_DATA_VERSIONS_CEREAL_H_
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "boost/optional/optional.hpp"
@@ -56,6 +57,34 @@ struct StructuredDataVersionsCereal {
   std::vector<Branch> branches;
 };
 
+struct StructuredDataVersionsDeltaCereal {
+  struct Put {
+    Put() : old_version{}, new_version{} {}
+    Put(StructuredDataVersions::VersionName old_version_in,
+        StructuredDataVersions::VersionName new_version_in)
+        : old_version{std::move(old_version_in)}, new_version{std::move(new_version_in)} {}
+
+    template <typename Archive>
+    Archive& serialize(Archive& archive) {
+      return archive(old_version, new_version);
+    }
+
+    StructuredDataVersions::VersionName old_version;
+    StructuredDataVersions::VersionName new_version;
+  };
+
+  StructuredDataVersionsDeltaCereal() : puts{}, removed_versions{} {}
+
+  template <typename Archive>
+  Archive& serialize(Archive& archive) {
+    return archive(puts, removed_versions);
+  }
+
+  // Ordered so that each version's parent is Put before it.
+  std::vector<Put> puts;
+  std::vector<StructuredDataVersions::VersionName> removed_versions;
+};
+
 }  // namespace detail
 
 }  // namespace maidsafe
@@ -0,0 +1,114 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/data_types/concurrent_structured_data_versions.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+using VersionName = StructuredDataVersions::VersionName;
+
+}  // unnamed namespace
+
+TEST(ConcurrentStructuredDataVersionsTest, BEH_Snapshots) {
+  ConcurrentStructuredDataVersions versions(10, 2);
+  const VersionName v0(0, MakeIdentity()), v1(1, MakeIdentity()), v2(2, MakeIdentity());
+  const auto empty_snapshot(versions.GetSnapshot());
+  EXPECT_NO_THROW(versions.Put(VersionName(), v0));
+  EXPECT_NO_THROW(versions.Put(v0, v1));
+
+  // Earlier snapshots are unaffected by later writes.
+  EXPECT_TRUE(empty_snapshot->Get().empty());
+  const auto snapshot(versions.GetSnapshot());
+  EXPECT_EQ(std::vector<VersionName>(1, v1), snapshot->Get());
+  EXPECT_EQ((std::vector<VersionName>{v1, v0}), versions.GetBranch(v1));
+
+  // Check several modifications can be published as a single snapshot.
+  versions.Modify([&](StructuredDataVersions& modified) {
+    modified.Put(v0, v2);
+    modified.DeleteBranchUntilFork(v1);
+  });
+  EXPECT_EQ(std::vector<VersionName>(1, v2), versions.Get());
+  EXPECT_EQ(std::vector<VersionName>(1, v1), snapshot->Get());
+
+  // Check a failed write leaves the current snapshot in place.
+  const auto before_failure(versions.GetSnapshot());
+  EXPECT_THROW(versions.Put(v1, v2), common_error);
+  EXPECT_THROW(versions.Modify([&](StructuredDataVersions& modified) {
+    modified.clear();
+    modified.DeleteBranchUntilFork(v2);
+  }),
+               common_error);
+  EXPECT_EQ(before_failure, versions.GetSnapshot());
+
+  ConcurrentStructuredDataVersions parsed(versions.Serialise());
+  EXPECT_EQ(versions.Get(), parsed.Get());
+  versions.clear();
+  EXPECT_TRUE(versions.Get().empty());
+}
+
+TEST(ConcurrentStructuredDataVersionsTest, FUNC_ConcurrentReadersAndWriter) {
+  const uint32_t kVersionCount(200);
+  ConcurrentStructuredDataVersions versions(kVersionCount + 1, 1);
+  std::vector<VersionName> chain(1, VersionName(0, MakeIdentity()));
+  versions.Put(VersionName(), chain.front());
+  for (uint32_t i(1); i != kVersionCount; ++i)
+    chain.emplace_back(i, MakeIdentity());
+
+  std::atomic<bool> done(false);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> readers;
+  for (int i(0); i != 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done) {
+        // Every snapshot must be a consistent single branch from the root.
+        const auto snapshot(versions.GetSnapshot());
+        const auto tips(snapshot->Get());
+        if (tips.size() != 1U ||
+            snapshot->GetBranch(tips.front()).size() != tips.front().index + 1) {
+          ++failures;
+        }
+      }
+    });
+  }
+
+  for (uint32_t i(1); i != kVersionCount; ++i)
+    EXPECT_NO_THROW(versions.Put(chain[i - 1], chain[i]));
+  done = true;
+  for (auto& reader : readers)
+    reader.join();
+
+  EXPECT_EQ(0, failures);
+  EXPECT_EQ(std::vector<VersionName>(1, chain.back()), versions.Get());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
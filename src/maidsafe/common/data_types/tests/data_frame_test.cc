@@ -0,0 +1,93 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/data_types/data_frame.h"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+#include "maidsafe/common/data_types/mutable_data.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(DataFrameTest, BEH_RoundTrip) {
+  const ImmutableData immutable(NonEmptyString(RandomBytes(1, 1000)));
+  SerialisedData framed(SerialiseFramed(immutable));
+  EXPECT_EQ(immutable.NameAndType(), PeekNameAndType(framed.data(), framed.size()));
+  FramedData framed_immutable(std::move(framed));
+  EXPECT_EQ(immutable.NameAndType(), framed_immutable.NameAndType());
+  EXPECT_EQ(immutable.Value(), framed_immutable.Get<ImmutableData>().Value());
+  // Subsequent calls return the cached object.
+  EXPECT_EQ(&framed_immutable.Get<ImmutableData>(), &framed_immutable.Get<ImmutableData>());
+
+  const MutableData mutable_data(MakeIdentity(), NonEmptyString(RandomBytes(1, 1000)));
+  FramedData framed_mutable(SerialiseFramed(mutable_data));
+  EXPECT_EQ(mutable_data.NameAndType(), framed_mutable.NameAndType());
+  EXPECT_EQ(mutable_data.Value(), framed_mutable.Get<MutableData>().Value());
+
+  // Parsing as the wrong type should fail.
+  FramedData wrong_type(SerialiseFramed(mutable_data));
+  EXPECT_THROW(wrong_type.Get<ImmutableData>(), common_error);
+  EXPECT_THROW(framed_mutable.Get<ImmutableData>(), common_error);
+}
+
+TEST(DataFrameTest, BEH_InvalidFrames) {
+  const MutableData data(MakeIdentity(), NonEmptyString(RandomBytes(1, 1000)));
+  const SerialisedData framed(SerialiseFramed(data));
+
+  EXPECT_THROW(PeekNameAndType(nullptr, 0), common_error);
+  EXPECT_THROW(PeekNameAndType(framed.data(), kDataFrameHeaderSize - 1), common_error);
+  EXPECT_THROW(PeekNameAndType(framed.data(), framed.size() - 1), common_error);
+  EXPECT_THROW(FramedData(SerialisedData(framed.begin(), framed.end() - 1)), common_error);
+
+  SerialisedData bad_version(framed);
+  bad_version[0] = 0;
+  EXPECT_THROW(FramedData{bad_version}, common_error);
+
+  SerialisedData bad_header_size(framed);
+  bad_header_size[1] = kDataFrameHeaderSize - 1;
+  EXPECT_THROW(FramedData{bad_header_size}, common_error);
+
+  // A payload which doesn't match the name in the header.
+  SerialisedData bad_name(framed);
+  bad_name[6] ^= 1;
+  FramedData mismatched(bad_name);
+  EXPECT_THROW(mismatched.Get<MutableData>(), common_error);
+}
+
+TEST(DataFrameTest, BEH_LongerHeaderFromLaterVersion) {
+  // Simulate a later format version which has appended four bytes to the header.
+  const ImmutableData data(NonEmptyString(RandomBytes(1, 1000)));
+  const SerialisedData framed(SerialiseFramed(data));
+  SerialisedData extended(framed.begin(), framed.begin() + kDataFrameHeaderSize);
+  extended[0] = kDataFrameVersion + 1;
+  extended[1] = kDataFrameHeaderSize + 4;
+  extended.insert(extended.end(), 4, 0xff);
+  extended.insert(extended.end(), framed.begin() + kDataFrameHeaderSize, framed.end());
+
+  FramedData framed_data(std::move(extended));
+  EXPECT_EQ(data.NameAndType(), framed_data.NameAndType());
+  EXPECT_EQ(data.Value(), framed_data.Get<ImmutableData>().Value());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
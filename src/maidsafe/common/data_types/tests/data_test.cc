@@ -19,6 +19,7 @@
 #include "maidsafe/common/data_types/data.h"
 
 #include <limits>
+#include <vector>
 
 #include "cereal/types/base_class.hpp"
 #include "cereal/types/polymorphic.hpp"
@@ -125,6 +126,40 @@ TEST(DataTest, BEH_NameAndTypeIdComparisonOperators) {
   EXPECT_FALSE(name_and_type_id != name_and_type_id);
 }
 
+TEST(DataTest, BEH_NameAndTypeIdViewComparisonOperators) {
+  Identity name1(MakeIdentity());
+  Identity name2(MakeIdentity());
+  ASSERT_NE(name1, name2);
+  const Identity name(name1 < name2 ? name2 : name1);
+  const Identity lower_name(name1 < name2 ? name1 : name2);
+  const DataTypeId type_id(RandomUint32());
+
+  const Data::NameAndTypeId name_and_type_id(name, type_id);
+  const Data::NameAndTypeIdView view(name, type_id);
+  const Data::NameAndTypeIdView lower_view(lower_name, type_id);
+
+  EXPECT_FALSE(name_and_type_id < view);
+  EXPECT_FALSE(view < name_and_type_id);
+  EXPECT_TRUE(lower_view < name_and_type_id);
+  EXPECT_FALSE(name_and_type_id < lower_view);
+
+  // A view of a name's bytes held elsewhere, e.g. in a received message.
+  const std::vector<byte> name_bytes(name.string().begin(), name.string().end());
+  const std::vector<byte> lower_name_bytes(lower_name.string().begin(), lower_name.string().end());
+  const Data::NameAndTypeIdView byte_view(name_bytes.data(), type_id);
+  const Data::NameAndTypeIdView lower_byte_view(lower_name_bytes.data(), type_id);
+  EXPECT_FALSE(name_and_type_id < byte_view);
+  EXPECT_FALSE(byte_view < name_and_type_id);
+  EXPECT_TRUE(lower_byte_view < name_and_type_id);
+  EXPECT_FALSE(name_and_type_id < lower_byte_view);
+
+  // As for Identity, an uninitialised name orders first.
+  const Identity uninitialised_name;
+  const Data::NameAndTypeIdView uninitialised_view(uninitialised_name, type_id);
+  EXPECT_TRUE(uninitialised_view < name_and_type_id);
+  EXPECT_FALSE(name_and_type_id < uninitialised_view);
+}
+
 TEST(DataTest, BEH_SerialiseAndParseNameAndTypeId) {
   const Identity name(MakeIdentity());
   const DataTypeId type_id(RandomUint32());
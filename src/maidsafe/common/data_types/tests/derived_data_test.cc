@@ -137,6 +137,72 @@ TYPED_TEST(DerivedDataTest, BEH_SerialiseParse) {
   EXPECT_TRUE(Equal(&this->data_, dynamic_cast<TypeParam*>(parsed_ptr.get())));
 }
 
+TEST(ImmutableDataTest, BEH_ParseTrusted) {
+  const ImmutableData data(NonEmptyString(RandomBytes(1, 1000)));
+  SerialisedData serialised(Serialise(data));
+  EXPECT_EQ(data.Value(), ParseTrusted<ImmutableData>(serialised).Value());
+
+  // The value is serialised last, so corrupting the final byte leaves a parsable object whose name
+  // doesn't match its value.  Only a trusted parse skips that check.
+  ++serialised.back();
+  EXPECT_THROW(Parse<ImmutableData>(serialised), common_error);
+  const ImmutableData parsed(ParseTrusted<ImmutableData>(serialised));
+  EXPECT_EQ(data.Name(), parsed.Name());
+  EXPECT_NE(data.Value(), parsed.Value());
+}
+
+TEST(ImmutableDataTest, BEH_SharedValue) {
+  const SharedBuffer value(NonEmptyString(RandomBytes(1, 1000)));
+  const ImmutableData data(value);
+  EXPECT_EQ(value.ToNonEmptyString(), data.Value());
+  // The value isn't copied on construction from a SharedBuffer, nor by copying the data.
+  EXPECT_EQ(value.data(), data.SharedValue().data());
+  const ImmutableData copied(data);
+  EXPECT_EQ(value.data(), copied.Value().data());
+  EXPECT_EQ(data.Name(), ImmutableData(value.ToNonEmptyString()).Name());
+  EXPECT_THROW(ImmutableData().SharedValue(), common_error);
+}
+
+TEST(ImmutableDataTest, BEH_AdoptNameAndReleaseValue) {
+  const NonEmptyString value(RandomBytes(1, 1000));
+  const Identity name(crypto::Hash<crypto::SHA512>(value));
+  EXPECT_EQ(name, ImmutableData(name, value).Name());
+  EXPECT_EQ(name, ImmutableData(name, SharedBuffer(value)).Name());
+  const Identity wrong_name(MakeIdentity());
+  EXPECT_THROW(ImmutableData(wrong_name, value).Name(), common_error);
+  EXPECT_EQ(wrong_name, ImmutableData(wrong_name, value, false).Name());
+
+  // A value held only by this object is moved out rather than copied.
+  ImmutableData data(name, value, false);
+  const byte* const bytes(data.Value().data());
+  NonEmptyString released(data.ReleaseValue());
+  EXPECT_EQ(value, released);
+  EXPECT_EQ(bytes, released.data());
+  EXPECT_FALSE(data.IsInitialised());
+  EXPECT_THROW(data.Value(), common_error);
+  EXPECT_THROW(data.ReleaseValue(), common_error);
+
+  // A shared value is copied, leaving the other holder's value intact.
+  data = ImmutableData(value);
+  const ImmutableData copied(data);
+  released = data.ReleaseValue();
+  EXPECT_EQ(value, released);
+  EXPECT_NE(copied.Value().data(), released.data());
+  EXPECT_EQ(value, copied.Value());
+}
+
+TEST(MutableDataTest, BEH_ReleaseValue) {
+  const NonEmptyString value(RandomBytes(1, 1000));
+  MutableData data(MakeIdentity(), value);
+  const byte* const bytes(data.Value().data());
+  const NonEmptyString released(data.ReleaseValue());
+  EXPECT_EQ(value, released);
+  EXPECT_EQ(bytes, released.data());
+  EXPECT_FALSE(data.IsInitialised());
+  EXPECT_THROW(data.Value(), common_error);
+  EXPECT_THROW(MutableData().ReleaseValue(), common_error);
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
@@ -62,7 +62,8 @@ VersionName::Id RandomId() { return Identity{RandomAlphaNumericBytes(identity_si
 std::string DisplayVersion(const VersionName& version, bool to_hex) {
   return std::to_string(version.index) + "-" +
          (version.id.IsInitialised()
-              ? (to_hex ? hex::Encode(version.id) : convert::ToString(version.id.string()))
+              ? (to_hex ? hex::Encode(version.id)
+                        : std::string(version.id.string().begin(), version.id.string().end()))
                     .substr(0, 3)
               : ("Uninitialised"));
 }
@@ -352,6 +353,42 @@ TEST(StructuredDataVersionsTest, BEH_GetBranch) {
   }
 }
 
+TEST(StructuredDataVersionsTest, BEH_GetPaged) {
+  StructuredDataVersions versions{100, 20};
+  EXPECT_TRUE(versions.Get(3).empty());
+  EXPECT_THROW(versions.GetBranch(v5_nnn, 2, 0), common_error);
+  EXPECT_THROW(versions.VisitBranch(v5_nnn, [](const VersionName&) { return true; }),
+               common_error);
+
+  ConstructAsDiagram(versions);
+  EXPECT_TRUE(versions.Get(0).empty());
+  EXPECT_TRUE(CheckVersions(versions.Get(2), v8_zzz, v5_nnn));
+  EXPECT_EQ(versions.Get(), versions.Get(100));
+
+  EXPECT_TRUE(CheckVersions(versions.GetBranch(v5_nnn, 2, 0), v5_nnn, v4_kkk));
+  EXPECT_TRUE(CheckVersions(versions.GetBranch(v5_nnn, 2, 1), v4_kkk, v3_ggg));
+  EXPECT_TRUE(CheckVersions(versions.GetBranch(v5_nnn, 10, 4), v1_bbb, v0_aaa));
+  EXPECT_TRUE(versions.GetBranch(v5_nnn, 10, 6).empty());
+  EXPECT_TRUE(versions.GetBranch(v5_nnn, 0, 0).empty());
+  EXPECT_THROW(versions.GetBranch(v4_kkk, 2, 0), common_error);
+
+  // Check visiting from a version which isn't a tip-of-tree, and stopping early.
+  std::vector<VersionName> visited;
+  versions.VisitBranch(v3_ggg, [&visited](const VersionName& version) {
+    visited.push_back(version);
+    return true;
+  });
+  EXPECT_TRUE(CheckVersions(visited, v3_ggg, v2_ddd, v1_bbb, v0_aaa));
+  visited.clear();
+  versions.VisitBranch(v8_zzz, [&visited](const VersionName& version) {
+    visited.push_back(version);
+    return false;
+  });
+  EXPECT_TRUE(CheckVersions(visited, v8_zzz));
+  EXPECT_THROW(versions.VisitBranch(absent, [](const VersionName&) { return true; }),
+               common_error);
+}
+
 TEST(StructuredDataVersionsTest, BEH_Put) {
   // Keep a clone of 'versions' used to check that bad operations performed on 'versions' don't
   // modify its state (i.e. that it sticks to the strong exception guarantee).
@@ -503,6 +540,80 @@ TEST(StructuredDataVersionsTest, BEH_Put) {
   EXPECT_TRUE(CheckBranch(versions, v6_rrr, v5_qqq, v4_mmm, v3_hhh, v2_eee));
 }
 
+TEST(StructuredDataVersionsTest, BEH_PutMany) {
+  StructuredDataVersions expected(100, 20);
+  ConstructAsDiagram(expected, false);
+
+  // Parents before children, with the orphan 7-yyy's branch first.
+  const std::vector<std::pair<VersionName, VersionName>> puts{
+      {absent, v7_yyy}, {v7_yyy, v8_zzz}, {VersionName(), v0_aaa}, {v0_aaa, v1_bbb},
+      {v1_bbb, v2_ccc}, {v1_bbb, v2_ddd}, {v1_bbb, v2_eee}, {v2_ccc, v3_fff},
+      {v2_ddd, v3_ggg}, {v2_eee, v3_hhh}, {v3_fff, v4_iii}, {v3_ggg, v4_jjj},
+      {v3_ggg, v4_kkk}, {v3_hhh, v4_lll}, {v3_hhh, v4_mmm}, {v4_kkk, v5_nnn}};
+  StructuredDataVersions versions(100, 20);
+  std::vector<VersionName> removed_versions;
+  ASSERT_NO_THROW(removed_versions = versions.PutMany(puts));
+  EXPECT_TRUE(removed_versions.empty());
+  EXPECT_TRUE(Equivalent(expected, versions));
+  // Re-putting existing versions is a no-op.
+  ASSERT_NO_THROW(removed_versions = versions.PutMany(puts));
+  EXPECT_TRUE(removed_versions.empty());
+  EXPECT_TRUE(Equivalent(expected, versions));
+
+  // Check that a failure part way through leaves the SDV unmodified.
+  const auto before(versions.Serialise());
+  const VersionName v5_ooo{5, Identity{std::string(64, 'o')}};
+  EXPECT_THROW(versions.PutMany({{v4_mmm, v5_ooo}, {v0_aaa, v2_ccc}}), common_error);
+  EXPECT_EQ(before, versions.Serialise());
+
+  // Check removed versions are reported in order.
+  StructuredDataVersions limited(3, 1);
+  ASSERT_NO_THROW(removed_versions = limited.PutMany(
+                      {{VersionName(), v0_aaa}, {v0_aaa, v1_bbb}, {v1_bbb, v2_ccc},
+                       {v2_ccc, v3_fff}, {v3_fff, v4_iii}}));
+  EXPECT_TRUE(CheckVersions(removed_versions, v0_aaa, v1_bbb));
+  EXPECT_TRUE(CheckBranch(limited, v4_iii, v3_fff, v2_ccc));
+}
+
+TEST(StructuredDataVersionsTest, BEH_OrphanAccounting) {
+  StructuredDataVersions versions(1000, 200), reversed(1000, 200);
+  EXPECT_EQ(0U, versions.orphan_count());
+  EXPECT_EQ(0U, versions.orphan_bytes());
+
+  // Flood with orphans, each under a different absent parent.
+  const std::size_t kOrphanCount(100);
+  std::vector<std::pair<VersionName, VersionName>> puts;
+  for (std::size_t i(1); i <= kOrphanCount; ++i) {
+    const auto index(static_cast<VersionName::Index>(i));
+    puts.emplace_back(VersionName(index, MakeIdentity()), VersionName(index + 1, MakeIdentity()));
+  }
+  ASSERT_NO_THROW(versions.Put(VersionName(), v0_aaa));
+  for (const auto& put : puts)
+    ASSERT_NO_THROW(versions.Put(put.first, put.second));
+  EXPECT_EQ(kOrphanCount, versions.orphan_count());
+  const auto flooded_bytes(versions.orphan_bytes());
+  EXPECT_GE(flooded_bytes, kOrphanCount * 2 * sizeof(VersionName));
+
+  // Serialisation doesn't depend on the order the orphans arrived in.
+  for (auto itr(puts.rbegin()); itr != puts.rend(); ++itr)
+    ASSERT_NO_THROW(reversed.Put(itr->first, itr->second));
+  ASSERT_NO_THROW(reversed.Put(VersionName(), v0_aaa));
+  EXPECT_EQ(versions.Serialise(), reversed.Serialise());
+  EXPECT_EQ(versions.GetBranchFronts(), reversed.GetBranchFronts());
+
+  // Supplying the absent parents un-orphans each in turn.
+  for (std::size_t i(0); i != kOrphanCount; ++i) {
+    ASSERT_NO_THROW(versions.Put(v0_aaa, puts[i].first));
+    EXPECT_EQ(kOrphanCount - i - 1, versions.orphan_count());
+    EXPECT_TRUE(CheckBranch(versions, puts[i].second, puts[i].first, v0_aaa));
+  }
+  EXPECT_EQ(kOrphanCount, versions.Get().size());
+  EXPECT_LE(versions.orphan_bytes(), flooded_bytes);
+
+  versions.clear();
+  EXPECT_EQ(0U, versions.orphan_count());
+}
+
 TEST(StructuredDataVersionsTest, BEH_DeleteBranchUntilFork) {
   // Check with empty SDV
   StructuredDataVersions versions{100, 20};
@@ -594,6 +705,40 @@ TEST(StructuredDataVersionsTest, BEH_Clear) {
   EXPECT_TRUE(versions.Get().empty());
 }
 
+TEST(StructuredDataVersionsTest, BEH_CircularChainInWideTree) {
+  StructuredDataVersions versions{1000, 1000};
+  // An orphan whose absent parent is then put as the orphan's own child.
+  const VersionName absent{1, RandomId()};
+  const VersionName orphan{2, RandomId()};
+  EXPECT_NO_THROW(versions.Put(absent, orphan));
+  EXPECT_THROW(versions.Put(orphan, absent), common_error);
+
+  // Fan the orphan out widely and extend one branch, then try to put the absent parent anywhere in
+  // the resulting tree.
+  std::vector<VersionName> children;
+  for (int i(0); i != 100; ++i) {
+    children.emplace_back(3, RandomId());
+    EXPECT_NO_THROW(versions.Put(orphan, children.back()));
+  }
+  VersionName deepest(children.back());
+  for (VersionName::Index index(4); index != 50; ++index) {
+    const VersionName next{index, RandomId()};
+    EXPECT_NO_THROW(versions.Put(deepest, next));
+    deepest = next;
+  }
+  const auto tips(versions.Get());
+  EXPECT_THROW(versions.Put(children.front(), absent), common_error);
+  EXPECT_THROW(versions.Put(deepest, absent), common_error);
+  EXPECT_EQ(tips, versions.Get());
+
+  // Putting it under a version outside the tree is fine.
+  const VersionName other{2, RandomId()};
+  EXPECT_NO_THROW(versions.Put(VersionName{1, RandomId()}, other));
+  EXPECT_NO_THROW(versions.Put(other, absent));
+  const std::vector<VersionName> expected_branch{children.front(), orphan, absent, other};
+  EXPECT_EQ(expected_branch, versions.GetBranch(children.front()));
+}
+
 TEST(StructuredDataVersionsTest, BEH_Serialise) {
   StructuredDataVersions versions1(100, 20), versions2(100, 20), versions3(1, 1);
   ConstructAsDiagram(versions1);
@@ -650,6 +795,109 @@ TEST(StructuredDataVersionsTest, BEH_ApplySerialised) {
   EXPECT_TRUE(Equivalent(versions1, versions2));
 }
 
+TEST(StructuredDataVersionsTest, BEH_ApplyDelta) {
+  using StructuredDataVersionsDeltaCereal = maidsafe::detail::StructuredDataVersionsDeltaCereal;
+  StructuredDataVersions sender(100, 20);
+  ASSERT_NO_THROW(ConstructAsDiagram(sender));
+  StructuredDataVersions receiver(sender.Serialise());
+  const std::vector<VersionName> since_tips(receiver.Get());
+  const std::vector<VersionName> since_fronts(receiver.GetBranchFronts());
+  EXPECT_TRUE(CheckVersions(since_fronts, v0_aaa, v7_yyy));
+
+  // Check an unchanged SDV yields an empty delta.
+  StructuredDataVersionsDeltaCereal delta;
+  ASSERT_NO_THROW(Parse(sender.SerialiseDelta(since_tips, since_fronts)->string(), delta));
+  EXPECT_TRUE(delta.puts.empty());
+  EXPECT_TRUE(delta.removed_versions.empty());
+
+  // Extend one branch, fork another, delete a third and fill the gap above the orphan 7-yyy.
+  const VersionName v5_ooo{5, Identity{std::string(64, 'o')}};
+  const VersionName v6_ppp{6, Identity{std::string(64, 'p')}};
+  const VersionName v4_qqq{4, Identity{std::string(64, 'q')}};
+  ASSERT_NO_THROW(sender.Put(v4_iii, v5_ooo));
+  ASSERT_NO_THROW(sender.Put(v5_ooo, v6_ppp));
+  ASSERT_NO_THROW(sender.Put(v3_hhh, v4_qqq));
+  ASSERT_NO_THROW(sender.DeleteBranchUntilFork(v4_jjj));
+  ASSERT_NO_THROW(sender.Put(v5_nnn, absent));
+
+  const auto serialised_delta(sender.SerialiseDelta(since_tips, since_fronts));
+  ASSERT_NO_THROW(Parse(serialised_delta->string(), delta));
+  EXPECT_EQ(4U, delta.puts.size());
+  ASSERT_EQ(1U, delta.removed_versions.size());
+  EXPECT_EQ(v4_jjj, delta.removed_versions.front());
+  EXPECT_LT(serialised_delta->string().size(), sender.Serialise()->string().size());
+
+  ASSERT_NO_THROW(receiver.ApplyDelta(serialised_delta));
+  EXPECT_TRUE(Equivalent(sender, receiver));
+  EXPECT_EQ(sender.Serialise(), receiver.Serialise());
+
+  // Check a delta which can't be fully applied leaves the SDV unmodified.
+  StructuredDataVersionsDeltaCereal bad_delta;
+  bad_delta.puts.emplace_back(v4_mmm, VersionName{5, RandomId()});
+  bad_delta.puts.emplace_back(v0_aaa, v2_ccc);
+  const auto before(receiver.Serialise());
+  EXPECT_THROW(receiver.ApplyDelta(StructuredDataVersions::serialised_delta_type(
+                   NonEmptyString(Serialise(bad_delta)))),
+               common_error);
+  EXPECT_EQ(before, receiver.Serialise());
+}
+
+TEST(StructuredDataVersionsTest, BEH_Merge) {
+  StructuredDataVersions sender(100, 20);
+  ASSERT_NO_THROW(ConstructAsDiagram(sender));
+  StructuredDataVersions receiver(sender.Serialise());
+
+  // Extend one branch, fork another and fill the gap above the orphan 7-yyy.
+  const VersionName v5_ooo{5, Identity{std::string(64, 'o')}};
+  const VersionName v6_ppp{6, Identity{std::string(64, 'p')}};
+  const VersionName v4_qqq{4, Identity{std::string(64, 'q')}};
+  ASSERT_NO_THROW(sender.Put(v4_iii, v5_ooo));
+  ASSERT_NO_THROW(sender.Put(v5_ooo, v6_ppp));
+  ASSERT_NO_THROW(sender.Put(v3_hhh, v4_qqq));
+  ASSERT_NO_THROW(sender.Put(v5_nnn, absent));
+
+  StructuredDataVersions::MergeResult result;
+  ASSERT_NO_THROW(result = receiver.Merge(sender.Serialise()));
+  EXPECT_EQ(4U, result.added_count);
+  EXPECT_TRUE(result.removed_versions.empty());
+  EXPECT_TRUE(result.conflicts.empty());
+  EXPECT_TRUE(Equivalent(sender, receiver));
+
+  // Merging again adds nothing.
+  ASSERT_NO_THROW(result = receiver.Merge(sender.Serialise()));
+  EXPECT_EQ(0U, result.added_count);
+  EXPECT_TRUE(result.conflicts.empty());
+
+  // Check a conflicting branch is rejected while the rest is merged.
+  const VersionName v3_rrr{3, Identity{std::string(64, 'r')}};
+  const VersionName v4_sss{4, Identity{std::string(64, 's')}};
+  const VersionName v3_ttt{3, Identity{std::string(64, 't')}};
+  ASSERT_NO_THROW(receiver.Put(v2_ddd, v3_rrr));
+  StructuredDataVersions conflicting(100, 20);
+  ASSERT_NO_THROW(conflicting.Put(VersionName(), v0_aaa));
+  ASSERT_NO_THROW(conflicting.Put(v0_aaa, v1_bbb));
+  ASSERT_NO_THROW(conflicting.Put(v1_bbb, v2_ccc));
+  ASSERT_NO_THROW(conflicting.Put(v2_ccc, v3_rrr));
+  ASSERT_NO_THROW(conflicting.Put(v3_rrr, v4_sss));
+  ASSERT_NO_THROW(conflicting.Put(v2_ccc, v3_ttt));
+  ASSERT_NO_THROW(result = receiver.Merge(conflicting.Serialise()));
+  EXPECT_EQ(1U, result.added_count);
+  ASSERT_EQ(1U, result.conflicts.size());
+  EXPECT_EQ(v2_ccc, result.conflicts.front().old_version);
+  EXPECT_EQ(v3_rrr, result.conflicts.front().new_version);
+  EXPECT_EQ(make_error_code(CommonErrors::invalid_argument), result.conflicts.front().error);
+  EXPECT_EQ(2U, result.conflicts.front().rejected_count);
+  EXPECT_TRUE(CheckBranch(receiver, v3_ttt, v2_ccc, v1_bbb, v0_aaa));
+  EXPECT_TRUE(CheckBranch(receiver, v3_rrr, v2_ddd, v1_bbb, v0_aaa));
+  EXPECT_THROW(receiver.GetBranch(v4_sss), common_error);
+
+  // Check unparseable data merges nothing.
+  const auto before(receiver.Serialise());
+  EXPECT_THROW(receiver.Merge(StructuredDataVersions::serialised_type(NonEmptyString("bad"))),
+               common_error);
+  EXPECT_EQ(before, receiver.Serialise());
+}
+
 TEST(StructuredDataVersionsTest, BEH_SerialisationOptionalFieldTest) {
   using StructuredDataVersionsCereal = maidsafe::detail::StructuredDataVersionsCereal;
 
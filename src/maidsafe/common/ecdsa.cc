@@ -0,0 +1,181 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/ecdsa.h"
+
+#include "cryptopp/oids.h"
+#include "cryptopp/queue.h"
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace ecdsa {
+
+namespace {
+
+using Signer = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer;
+using Verifier = CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Verifier;
+
+std::string ToString(const CryptoPP::ByteQueue& queue) {
+  std::string result;
+  CryptoPP::StringSink sink(result);
+  queue.CopyTo(sink);
+  sink.MessageEnd();
+  return result;
+}
+
+}  // unnamed namespace
+
+Keys GenerateKeyPair() {
+  Keys keypair;
+  try {
+    keypair.private_key.Initialize(crypto::random_number_generator(),
+                                   CryptoPP::ASN1::secp256r1());
+    // Encode the curve by its OID rather than in full, to keep encoded keys small.
+    keypair.private_key.AccessGroupParameters().SetEncodeAsOID(true);
+    keypair.private_key.MakePublicKey(keypair.public_key);
+    keypair.public_key.AccessGroupParameters().SetEncodeAsOID(true);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed generating key pair: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::keys_generation_error));
+  }
+  if (!(keypair.private_key.Validate(crypto::random_number_generator(), 2) &&
+        keypair.public_key.Validate(crypto::random_number_generator(), 2)))
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::keys_generation_error));
+  return keypair;
+}
+
+Signature Sign(const PlainText& data, const PrivateKey& private_key) {
+  if (!data.IsInitialised()) {
+    LOG(kError) << "Sign data uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  if (!private_key.Validate(crypto::random_number_generator(), 0)) {
+    LOG(kError) << "Sign invalid private_key";
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
+  }
+
+  std::string signature(Keys::kSignatureByteSize, 0);
+  try {
+    Signer signer(private_key);
+    const size_t size(signer.SignMessage(crypto::random_number_generator(), data.data(),
+                                         data.size(), reinterpret_cast<byte*>(&signature[0])));
+    signature.resize(size);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed asymmetric signing: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::signing_error));
+  }
+  return Signature(signature);
+}
+
+bool CheckSignature(const PlainText& data, const Signature& signature,
+                    const PublicKey& public_key) {
+  if (!data.IsInitialised() || !signature.IsInitialised()) {
+    LOG(kError) << "CheckSignature data or signature uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  if (!public_key.Validate(crypto::random_number_generator(), 0)) {
+    LOG(kError) << "CheckSignature invalid public_key";
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+  }
+
+  try {
+    Verifier verifier(public_key);
+    return verifier.VerifyMessage(data.data(), data.size(), signature.data(), signature.size());
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed asymmetric signature checking: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::signing_error));
+  }
+}
+
+EncodedPrivateKey EncodeKey(const PrivateKey& private_key) {
+  if (!private_key.Validate(crypto::random_number_generator(), 0))
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
+
+  try {
+    CryptoPP::ByteQueue queue;
+    private_key.Save(queue);
+    return EncodedPrivateKey(ToString(queue));
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed encoding private key: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
+  }
+}
+
+EncodedPublicKey EncodeKey(const PublicKey& public_key) {
+  if (!public_key.Validate(crypto::random_number_generator(), 0))
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+
+  try {
+    CryptoPP::ByteQueue queue;
+    public_key.Save(queue);
+    return EncodedPublicKey(ToString(queue));
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed encoding public key: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+  }
+}
+
+PrivateKey DecodeKey(const EncodedPrivateKey& private_key) {
+  if (!private_key.IsInitialised()) {
+    LOG(kError) << "DecodeKey private_key uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+
+  PrivateKey key;
+  try {
+    CryptoPP::StringSource source(private_key.string(), true);
+    key.Load(source);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed decoding private key: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
+  }
+  return key;
+}
+
+PublicKey DecodeKey(const EncodedPublicKey& public_key) {
+  if (!public_key.IsInitialised()) {
+    LOG(kError) << "DecodeKey public_key uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+
+  PublicKey key;
+  try {
+    CryptoPP::StringSource source(public_key.string(), true);
+    key.Load(source);
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed decoding public key: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+  }
+  return key;
+}
+
+bool MatchingKeys(const PrivateKey& private_key1, const PrivateKey& private_key2) {
+  return private_key1.GetPrivateExponent() == private_key2.GetPrivateExponent() &&
+         private_key1.GetGroupParameters() == private_key2.GetGroupParameters();
+}
+
+bool MatchingKeys(const PublicKey& public_key1, const PublicKey& public_key2) {
+  return public_key1.GetPublicElement() == public_key2.GetPublicElement() &&
+         public_key1.GetGroupParameters() == public_key2.GetGroupParameters();
+}
+
+}  // namespace ecdsa
+
+}  // namespace maidsafe
@@ -18,6 +18,9 @@
 
 #include "maidsafe/common/encode.h"
 
+#include <cstring>
+
+#include "maidsafe/common/encode_kernels.h"
 #include "maidsafe/common/error.h"
 
 namespace maidsafe {
@@ -41,20 +44,26 @@ namespace {
 
 template <typename T>
 T Decode(const std::string& hex_input) {
-  auto size(hex_input.size());
-  if (size % 2)  // Sanity check
+  T non_hex_output(hex_input.size() / 2, 0);
+  if (hex_input.size() % 2 ||
+      (!hex_input.empty() &&
+       !DecodeTo(hex_input.data(), hex_input.size(),
+                 reinterpret_cast<unsigned char*>(&non_hex_output[0])))) {
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_conversion));
-
-  T non_hex_output(size / 2, 0);
-  for (size_t i(0), j(0); i != size / 2; ++i) {
-    non_hex_output[i] = (detail::lookup[static_cast<int>(hex_input[j++])] << 4);
-    non_hex_output[i] |= detail::lookup[static_cast<int>(hex_input[j++])];
   }
   return non_hex_output;
 }
 
 }  // unnamed namespace
 
+char* EncodeTo(const unsigned char* input, std::size_t size, char* output) {
+  return detail::SelectedEncodeKernels().hex_encode(input, size, output);
+}
+
+bool DecodeTo(const char* input, std::size_t size, unsigned char* output) {
+  return size % 2 == 0 && detail::SelectedEncodeKernels().hex_decode(input, size, output);
+}
+
 std::string DecodeToString(const std::string& hex_input) { return Decode<std::string>(hex_input); }
 
 std::vector<unsigned char> DecodeToBytes(const std::string& hex_input) {
@@ -71,62 +80,30 @@ namespace {
 
 template <typename T>
 T Decode(const std::string& base64_input) {
-  if (base64_input.size() % 4)  // Sanity check
+  T decoded_bytes(MaxDecodedSize(base64_input.size()), 0);
+  std::size_t decoded_size(0);
+  if (base64_input.size() % 4 ||
+      (!base64_input.empty() &&
+       !DecodeTo(base64_input.data(), base64_input.size(),
+                 reinterpret_cast<unsigned char*>(&decoded_bytes[0]), decoded_size))) {
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_conversion));
-
-  std::size_t padding = 0;
-  if (base64_input.size()) {
-    if (base64_input[base64_input.size() - 1] == detail::pad_character)
-      ++padding;
-    if (base64_input[base64_input.size() - 2] == detail::pad_character)
-      ++padding;
-  }
-
-  // Setup a vector to hold the result
-  T decoded_bytes;
-  decoded_bytes.reserve(((base64_input.size() / 4) * 3) - padding);
-  std::uint32_t temp = 0;  // Holds decoded quanta
-  auto cursor = base64_input.begin();
-  while (cursor < base64_input.end()) {
-    for (std::size_t quantum_position = 0; quantum_position < 4; ++quantum_position) {
-      temp <<= 6;
-      if (*cursor >= 0x41 && *cursor <= 0x5A)
-        temp |= *cursor - 0x41;
-      else if (*cursor >= 0x61 && *cursor <= 0x7A)
-        temp |= *cursor - 0x47;
-      else if (*cursor >= 0x30 && *cursor <= 0x39)
-        temp |= *cursor + 0x04;
-      else if (*cursor == 0x2B)
-        temp |= 0x3E;  // change to 0x2D for URL alphabet
-      else if (*cursor == 0x2F)
-        temp |= 0x3F;  // change to 0x5F for URL alphabet
-      else if (*cursor == detail::pad_character) {
-        // pad
-        switch (base64_input.end() - cursor) {
-          case 1:  // One pad character
-            decoded_bytes.push_back((temp >> 16) & 0x000000FF);
-            decoded_bytes.push_back((temp >> 8) & 0x000000FF);
-            return decoded_bytes;
-          case 2:  // Two pad characters
-            decoded_bytes.push_back((temp >> 10) & 0x000000FF);
-            return decoded_bytes;
-          default:
-            BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_conversion));
-        }
-      } else {
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_conversion));
-      }
-      ++cursor;
-    }
-    decoded_bytes.push_back((temp >> 16) & 0x000000FF);
-    decoded_bytes.push_back((temp >> 8) & 0x000000FF);
-    decoded_bytes.push_back(temp & 0x000000FF);
   }
+  decoded_bytes.resize(decoded_size);
   return decoded_bytes;
 }
 
 }  // unnamed namespace
 
+char* EncodeTo(const unsigned char* input, std::size_t size, char* output) {
+  return detail::SelectedEncodeKernels().base64_encode(input, size, output);
+}
+
+bool DecodeTo(const char* input, std::size_t size, unsigned char* output,
+              std::size_t& decoded_size) {
+  return size % 4 == 0 &&
+         detail::SelectedEncodeKernels().base64_decode(input, size, output, decoded_size);
+}
+
 std::string DecodeToString(const std::string& base64_input) {
   return Decode<std::string>(base64_input);
 }
@@ -135,6 +112,90 @@ std::vector<unsigned char> DecodeToBytes(const std::string& base64_input) {
   return Decode<std::vector<unsigned char>>(base64_input);
 }
 
+void Encoder::Update(const unsigned char* input, std::size_t size, std::string& output) {
+  if (pending_size_ != 0) {
+    while (pending_size_ != 3 && size != 0) {
+      pending_[pending_size_++] = *input++;
+      --size;
+    }
+    if (pending_size_ != 3)
+      return;
+    const std::size_t offset(output.size());
+    output.resize(offset + EncodedSize(3));
+    EncodeTo(pending_, 3, &output[offset]);
+    pending_size_ = 0;
+  }
+
+  const std::size_t whole_size(size - size % 3);
+  if (whole_size != 0) {
+    const std::size_t offset(output.size());
+    output.resize(offset + EncodedSize(whole_size));
+    EncodeTo(input, whole_size, &output[offset]);
+  }
+  pending_size_ = size - whole_size;
+  std::memcpy(pending_, input + whole_size, pending_size_);
+}
+
+void Encoder::Finalise(std::string& output) {
+  if (pending_size_ != 0) {
+    const std::size_t offset(output.size());
+    output.resize(offset + EncodedSize(pending_size_));
+    EncodeTo(pending_, pending_size_, &output[offset]);
+  }
+  pending_size_ = 0;
+}
+
+bool Decoder::Update(const char* input, std::size_t size, std::string& output) {
+  if (size == 0)
+    return true;
+  if (finished_)
+    return false;
+
+  if (pending_size_ != 0) {
+    while (pending_size_ != 4 && size != 0) {
+      pending_[pending_size_++] = *input++;
+      --size;
+    }
+    if (pending_size_ != 4)
+      return true;
+    pending_size_ = 0;
+    if (!DecodeChunk(pending_, 4, output))
+      return false;
+    if (finished_ && size != 0)
+      return false;
+  }
+
+  const std::size_t whole_size(size - size % 4);
+  if (whole_size != 0 && !DecodeChunk(input, whole_size, output))
+    return false;
+  pending_size_ = size - whole_size;
+  if (pending_size_ != 0 && finished_)
+    return false;
+  std::memcpy(pending_, input + whole_size, pending_size_);
+  return true;
+}
+
+bool Decoder::Finalise() {
+  const bool complete(pending_size_ == 0);
+  pending_size_ = 0;
+  finished_ = false;
+  return complete;
+}
+
+bool Decoder::DecodeChunk(const char* input, std::size_t size, std::string& output) {
+  const std::size_t offset(output.size());
+  output.resize(offset + MaxDecodedSize(size));
+  std::size_t decoded_size(0);
+  if (!DecodeTo(input, size, reinterpret_cast<unsigned char*>(&output[offset]), decoded_size)) {
+    output.resize(offset);
+    return false;
+  }
+  output.resize(offset + decoded_size);
+  // Padding can only appear in the final group of the stream.
+  finished_ = input[size - 1] == '=';
+  return true;
+}
+
 }  // namespace base64
 
 }  // namespace maidsafe
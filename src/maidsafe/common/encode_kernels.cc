@@ -0,0 +1,653 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/encode_kernels.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#define MAIDSAFE_ENCODE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define MAIDSAFE_ENCODE_SSSE3
+#define MAIDSAFE_ENCODE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MAIDSAFE_ENCODE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(MAIDSAFE_ENCODE_AVX2) && !defined(_MSC_VER)
+#define MAIDSAFE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define MAIDSAFE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MAIDSAFE_TARGET_SSSE3
+#define MAIDSAFE_TARGET_AVX2
+#endif
+
+#include "maidsafe/common/cpu_features.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+// ========================================== Scalar ============================================ //
+
+const char kHexAlphabet[] = "0123456789abcdef";
+
+// Maps each char to the value of the hex digit it represents, or to 0xff if it isn't a hex digit.
+const unsigned char kHexValues[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+const char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+const char kBase64PadCharacter('=');
+
+// Maps each char to the 6-bit value it represents, or to 0xff if it isn't in the alphabet.
+const unsigned char kBase64Values[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+char* HexEncodeScalar(const unsigned char* input, std::size_t size, char* output) {
+  for (std::size_t i(0); i != size; ++i) {
+    *output++ = kHexAlphabet[input[i] >> 4];
+    *output++ = kHexAlphabet[input[i] & 0x0f];
+  }
+  return output;
+}
+
+bool HexDecodeScalar(const char* input, std::size_t size, unsigned char* output) {
+  if (size % 2)
+    return false;
+  for (std::size_t i(0); i != size; i += 2) {
+    const unsigned char high(kHexValues[static_cast<unsigned char>(input[i])]);
+    const unsigned char low(kHexValues[static_cast<unsigned char>(input[i + 1])]);
+    if ((high | low) & 0xf0)
+      return false;
+    *output++ = static_cast<unsigned char>((high << 4) | low);
+  }
+  return true;
+}
+
+char* Base64EncodeScalar(const unsigned char* input, std::size_t size, char* output) {
+  std::size_t i(0);
+  for (; i + 3 <= size; i += 3) {
+    const std::uint32_t quantum((input[i] << 16) | (input[i + 1] << 8) | input[i + 2]);
+    *output++ = kBase64Alphabet[(quantum >> 18) & 0x3f];
+    *output++ = kBase64Alphabet[(quantum >> 12) & 0x3f];
+    *output++ = kBase64Alphabet[(quantum >> 6) & 0x3f];
+    *output++ = kBase64Alphabet[quantum & 0x3f];
+  }
+  if (i != size) {
+    std::uint32_t quantum(input[i] << 16);
+    if (i + 1 != size)
+      quantum |= input[i + 1] << 8;
+    *output++ = kBase64Alphabet[(quantum >> 18) & 0x3f];
+    *output++ = kBase64Alphabet[(quantum >> 12) & 0x3f];
+    *output++ = (i + 1 != size) ? kBase64Alphabet[(quantum >> 6) & 0x3f] : kBase64PadCharacter;
+    *output++ = kBase64PadCharacter;
+  }
+  return output;
+}
+
+// Decodes 'count' chars at 'input' into the high bits of the 24-bit 'quantum'.
+bool DecodeQuantum(const char* input, std::size_t count, std::uint32_t& quantum) {
+  quantum = 0;
+  unsigned char invalid(0);
+  for (std::size_t i(0); i != 4; ++i) {
+    const unsigned char value(i < count ? kBase64Values[static_cast<unsigned char>(input[i])] : 0);
+    invalid |= value;
+    quantum = (quantum << 6) | (value & 0x3f);
+  }
+  return (invalid & 0xc0) == 0;
+}
+
+bool Base64DecodeScalar(const char* input, std::size_t size, unsigned char* output,
+                        std::size_t& decoded_size) {
+  if (size % 4)
+    return false;
+  std::size_t padding(0);
+  if (size != 0 && input[size - 1] == kBase64PadCharacter)
+    padding = (input[size - 2] == kBase64PadCharacter) ? 2 : 1;
+
+  unsigned char* const begin(output);
+  const std::size_t unpadded_size(padding ? size - 4 : size);
+  std::uint32_t quantum(0);
+  for (std::size_t i(0); i != unpadded_size; i += 4) {
+    if (!DecodeQuantum(input + i, 4, quantum))
+      return false;
+    *output++ = static_cast<unsigned char>(quantum >> 16);
+    *output++ = static_cast<unsigned char>(quantum >> 8);
+    *output++ = static_cast<unsigned char>(quantum);
+  }
+  if (padding) {
+    if (!DecodeQuantum(input + unpadded_size, 4 - padding, quantum))
+      return false;
+    *output++ = static_cast<unsigned char>(quantum >> 16);
+    if (padding == 1)
+      *output++ = static_cast<unsigned char>(quantum >> 8);
+  }
+  decoded_size = static_cast<std::size_t>(output - begin);
+  return true;
+}
+
+// Each vectorised kernel below handles whole blocks, stopping early at any block containing a
+// pad or invalid char, and passes what remains to the scalar kernel.  The scalar kernel then
+// deals with the final partial block, the padding and any error.
+
+bool Base64DecodeTail(const char* input, std::size_t size, std::size_t consumed,
+                      unsigned char* output, std::size_t written, std::size_t& decoded_size) {
+  std::size_t tail_size(0);
+  if (!Base64DecodeScalar(input + consumed, size - consumed, output + written, tail_size))
+    return false;
+  decoded_size = written + tail_size;
+  return true;
+}
+
+// =========================================== SSE2 ============================================= //
+
+#ifdef MAIDSAFE_ENCODE_SSE2
+char* HexEncodeSse2(const unsigned char* input, std::size_t size, char* output) {
+  // Each nibble n becomes n + '0', plus a further 'a' - '0' - 10 if n > 9, and the high and low
+  // nibbles are then interleaved.
+  const __m128i kLowNibbles(_mm_set1_epi8(0x0f)), kNine(_mm_set1_epi8(9)),
+      kDigitOffset(_mm_set1_epi8('0')), kLetterOffset(_mm_set1_epi8('a' - '0' - 10));
+  std::size_t i(0);
+  for (; i + 16 <= size; i += 16, output += 32) {
+    const __m128i bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+    __m128i high(_mm_and_si128(_mm_srli_epi16(bytes, 4), kLowNibbles));
+    __m128i low(_mm_and_si128(bytes, kLowNibbles));
+    high = _mm_add_epi8(_mm_add_epi8(high, kDigitOffset),
+                        _mm_and_si128(_mm_cmpgt_epi8(high, kNine), kLetterOffset));
+    low = _mm_add_epi8(_mm_add_epi8(low, kDigitOffset),
+                       _mm_and_si128(_mm_cmpgt_epi8(low, kNine), kLetterOffset));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 16), _mm_unpackhi_epi8(high, low));
+  }
+  return HexEncodeScalar(input + i, size - i, output);
+}
+
+// Sets 'values' to the values of the 16 hex digits in 'chars'.  Returns false if any are invalid.
+bool HexValuesSse2(__m128i chars, __m128i& values) {
+  const __m128i digits(_mm_sub_epi8(chars, _mm_set1_epi8('0')));
+  const __m128i letters(
+      _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a')));
+  const __m128i is_digit(_mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits));
+  const __m128i is_letter(_mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters));
+  values = _mm_or_si128(_mm_and_si128(is_digit, digits),
+                        _mm_and_si128(is_letter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+  return _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) == 0xffff;
+}
+
+// Combines each pair of nibble values into a byte, leaving the results in the low byte of each
+// 16-bit lane.
+__m128i CombineNibblesSse2(__m128i values) {
+  return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0xff)), 4),
+                      _mm_srli_epi16(values, 8));
+}
+
+bool HexDecodeSse2(const char* input, std::size_t size, unsigned char* output) {
+  std::size_t i(0);
+  for (; i + 32 <= size; i += 32, output += 16) {
+    __m128i first, second;
+    if (!HexValuesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), first) ||
+        !HexValuesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 16)),
+                       second)) {
+      return false;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output),
+                     _mm_packus_epi16(CombineNibblesSse2(first), CombineNibblesSse2(second)));
+  }
+  return HexDecodeScalar(input + i, size - i, output);
+}
+#endif
+
+// =========================================== SSSE3 ============================================ //
+
+#ifdef MAIDSAFE_ENCODE_SSSE3
+// These follow Wojciech Muła's and Alfred Klomp's base-64 algorithms.  Each 12-byte group is
+// spread over 16 bytes so that every output sextet sits in its own byte, then each sextet is mapped
+// to its char by adding an offset chosen via pshufb.
+MAIDSAFE_TARGET_SSSE3 __m128i Base64SextetsSsse3(__m128i bytes) {
+  bytes = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i high(_mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+                                     _mm_set1_epi32(0x04000040)));
+  const __m128i low(_mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+                                    _mm_set1_epi32(0x01000010)));
+  return _mm_or_si128(high, low);
+}
+
+MAIDSAFE_TARGET_SSSE3 __m128i Base64CharsSsse3(__m128i sextets) {
+  const __m128i kOffsets(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                       '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                       '/' - 63, 'A', 0, 0));
+  // Index 0 for 26-51, 1-10 for 52-61, 11 for 62, 12 for 63 and 13 for 0-25.
+  __m128i index(_mm_subs_epu8(sextets, _mm_set1_epi8(51)));
+  const __m128i upper_case(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets));
+  index = _mm_or_si128(index, _mm_and_si128(upper_case, _mm_set1_epi8(13)));
+  return _mm_add_epi8(sextets, _mm_shuffle_epi8(kOffsets, index));
+}
+
+// Sets 'sextets' to the values of the 16 base-64 chars in 'chars'.  Returns false if any are
+// invalid (including pad chars).
+MAIDSAFE_TARGET_SSSE3 bool Base64ValuesSsse3(__m128i chars, __m128i& sextets) {
+  // A char is invalid if the bits looked up for its low and high nibbles intersect.
+  const __m128i kLowNibbleBits(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                             0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a));
+  const __m128i kHighNibbleBits(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                                              0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+  const __m128i kOffsets(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+  const __m128i kLowNibbles(_mm_set1_epi8(0x0f));
+  const __m128i high_nibbles(_mm_and_si128(_mm_srli_epi32(chars, 4), kLowNibbles));
+  const __m128i low_nibbles(_mm_and_si128(chars, kLowNibbles));
+  const __m128i invalid(_mm_and_si128(_mm_shuffle_epi8(kLowNibbleBits, low_nibbles),
+                                      _mm_shuffle_epi8(kHighNibbleBits, high_nibbles)));
+  if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0)
+    return false;
+  // '/' shares its high nibble with '+', so is given its own offset.
+  const __m128i is_slash(_mm_cmpeq_epi8(chars, _mm_set1_epi8('/')));
+  sextets = _mm_add_epi8(chars, _mm_shuffle_epi8(kOffsets, _mm_add_epi8(is_slash, high_nibbles)));
+  return true;
+}
+
+// Packs the sextets in each 4-byte lane into 3 bytes, leaving the 12 result bytes at the start.
+MAIDSAFE_TARGET_SSSE3 __m128i Base64BytesSsse3(__m128i sextets) {
+  const __m128i pairs(_mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140)));
+  const __m128i quads(_mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000)));
+  return _mm_shuffle_epi8(quads,
+                          _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Writes the first 12 bytes of 'bytes' to 'output'.
+void Store12(__m128i bytes, unsigned char* output) {
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(output), bytes);
+  const std::int32_t last(_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+  std::memcpy(output + 8, &last, sizeof(last));
+}
+
+MAIDSAFE_TARGET_SSSE3 char* Base64EncodeSsse3(const unsigned char* input, std::size_t size,
+                                              char* output) {
+  std::size_t i(0);
+  // Each step reads 16 bytes but consumes only 12.
+  for (; i + 16 <= size; i += 12, output += 16) {
+    const __m128i bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output),
+                     Base64CharsSsse3(Base64SextetsSsse3(bytes)));
+  }
+  return Base64EncodeScalar(input + i, size - i, output);
+}
+
+MAIDSAFE_TARGET_SSSE3 bool Base64DecodeSsse3(const char* input, std::size_t size,
+                                             unsigned char* output, std::size_t& decoded_size) {
+  std::size_t i(0), written(0);
+  for (; i + 16 <= size; i += 16, written += 12) {
+    __m128i sextets;
+    if (!Base64ValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)), sextets))
+      break;
+    Store12(Base64BytesSsse3(sextets), output + written);
+  }
+  return Base64DecodeTail(input, size, i, output, written, decoded_size);
+}
+#endif
+
+// =========================================== AVX2 ============================================= //
+
+#ifdef MAIDSAFE_ENCODE_AVX2
+MAIDSAFE_TARGET_AVX2 char* HexEncodeAvx2(const unsigned char* input, std::size_t size,
+                                         char* output) {
+  const __m256i kLowNibbles(_mm256_set1_epi8(0x0f)), kNine(_mm256_set1_epi8(9)),
+      kDigitOffset(_mm256_set1_epi8('0')), kLetterOffset(_mm256_set1_epi8('a' - '0' - 10));
+  std::size_t i(0);
+  for (; i + 32 <= size; i += 32, output += 64) {
+    const __m256i bytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)));
+    __m256i high(_mm256_and_si256(_mm256_srli_epi16(bytes, 4), kLowNibbles));
+    __m256i low(_mm256_and_si256(bytes, kLowNibbles));
+    high = _mm256_add_epi8(_mm256_add_epi8(high, kDigitOffset),
+                           _mm256_and_si256(_mm256_cmpgt_epi8(high, kNine), kLetterOffset));
+    low = _mm256_add_epi8(_mm256_add_epi8(low, kDigitOffset),
+                          _mm256_and_si256(_mm256_cmpgt_epi8(low, kNine), kLetterOffset));
+    // The unpacks work within each 128-bit lane, so the lanes need to be reordered.
+    const __m256i first(_mm256_unpacklo_epi8(high, low)), second(_mm256_unpackhi_epi8(high, low));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output),
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  return HexEncodeSse2(input + i, size - i, output);
+}
+
+MAIDSAFE_TARGET_AVX2 bool HexValuesAvx2(__m256i chars, __m256i& values) {
+  const __m256i digits(_mm256_sub_epi8(chars, _mm256_set1_epi8('0')));
+  const __m256i letters(
+      _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a')));
+  const __m256i is_digit(_mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits));
+  const __m256i is_letter(
+      _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters));
+  values = _mm256_or_si256(
+      _mm256_and_si256(is_digit, digits),
+      _mm256_and_si256(is_letter, _mm256_add_epi8(letters, _mm256_set1_epi8(10))));
+  return _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) == -1;
+}
+
+MAIDSAFE_TARGET_AVX2 __m256i CombineNibblesAvx2(__m256i values) {
+  return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(values, _mm256_set1_epi16(0xff)), 4),
+                         _mm256_srli_epi16(values, 8));
+}
+
+MAIDSAFE_TARGET_AVX2 bool HexDecodeAvx2(const char* input, std::size_t size,
+                                        unsigned char* output) {
+  std::size_t i(0);
+  for (; i + 64 <= size; i += 64, output += 32) {
+    __m256i first, second;
+    if (!HexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)), first) ||
+        !HexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 32)),
+                       second)) {
+      return false;
+    }
+    // The pack works within each 128-bit lane, leaving the 64-bit quarters in the order 0, 2, 1, 3.
+    const __m256i packed(
+        _mm256_packus_epi16(CombineNibblesAvx2(first), CombineNibblesAvx2(second)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output),
+                        _mm256_permute4x64_epi64(packed, 0xd8));
+  }
+  return HexDecodeSse2(input + i, size - i, output);
+}
+
+MAIDSAFE_TARGET_AVX2 __m256i Base64SextetsAvx2(__m256i bytes) {
+  bytes = _mm256_shuffle_epi8(
+      bytes, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8,
+                             6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m256i high(_mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)),
+                                        _mm256_set1_epi32(0x04000040)));
+  const __m256i low(_mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)),
+                                       _mm256_set1_epi32(0x01000010)));
+  return _mm256_or_si256(high, low);
+}
+
+MAIDSAFE_TARGET_AVX2 __m256i Base64CharsAvx2(__m256i sextets) {
+  const __m256i kOffsets(_mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A',
+      0, 0));
+  __m256i index(_mm256_subs_epu8(sextets, _mm256_set1_epi8(51)));
+  const __m256i upper_case(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets));
+  index = _mm256_or_si256(index, _mm256_and_si256(upper_case, _mm256_set1_epi8(13)));
+  return _mm256_add_epi8(sextets, _mm256_shuffle_epi8(kOffsets, index));
+}
+
+MAIDSAFE_TARGET_AVX2 bool Base64ValuesAvx2(__m256i chars, __m256i& sextets) {
+  const __m256i kLowNibbleBits(_mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b,
+      0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b,
+      0x1b, 0x1a));
+  const __m256i kHighNibbleBits(_mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10));
+  const __m256i kOffsets(_mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0,
+                                          0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0,
+                                          0, 0));
+  const __m256i kLowNibbles(_mm256_set1_epi8(0x0f));
+  const __m256i high_nibbles(_mm256_and_si256(_mm256_srli_epi32(chars, 4), kLowNibbles));
+  const __m256i low_nibbles(_mm256_and_si256(chars, kLowNibbles));
+  const __m256i invalid(_mm256_and_si256(_mm256_shuffle_epi8(kLowNibbleBits, low_nibbles),
+                                         _mm256_shuffle_epi8(kHighNibbleBits, high_nibbles)));
+  if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(invalid, _mm256_setzero_si256())) != 0)
+    return false;
+  const __m256i is_slash(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/')));
+  sextets = _mm256_add_epi8(chars,
+                            _mm256_shuffle_epi8(kOffsets, _mm256_add_epi8(is_slash, high_nibbles)));
+  return true;
+}
+
+MAIDSAFE_TARGET_AVX2 __m256i Base64BytesAvx2(__m256i sextets) {
+  const __m256i pairs(_mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140)));
+  const __m256i quads(_mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000)));
+  return _mm256_shuffle_epi8(
+      quads, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5,
+                              4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+MAIDSAFE_TARGET_AVX2 char* Base64EncodeAvx2(const unsigned char* input, std::size_t size,
+                                            char* output) {
+  std::size_t i(0);
+  // Each step consumes 24 bytes: 12 per 128-bit lane, loaded from overlapping 16-byte reads.
+  for (; i + 28 <= size; i += 24, output += 32) {
+    const __m256i bytes(_mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 12)), 1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output),
+                        Base64CharsAvx2(Base64SextetsAvx2(bytes)));
+  }
+  return Base64EncodeSsse3(input + i, size - i, output);
+}
+
+MAIDSAFE_TARGET_AVX2 bool Base64DecodeAvx2(const char* input, std::size_t size,
+                                           unsigned char* output, std::size_t& decoded_size) {
+  std::size_t i(0), written(0);
+  for (; i + 32 <= size; i += 32, written += 24) {
+    __m256i sextets;
+    if (!Base64ValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)),
+                          sextets)) {
+      break;
+    }
+    const __m256i bytes(Base64BytesAvx2(sextets));
+    Store12(_mm256_castsi256_si128(bytes), output + written);
+    Store12(_mm256_extracti128_si256(bytes, 1), output + written + 12);
+  }
+  std::size_t tail_size(0);
+  if (!Base64DecodeSsse3(input + i, size - i, output + written, tail_size))
+    return false;
+  decoded_size = written + tail_size;
+  return true;
+}
+#endif
+
+// =========================================== NEON ============================================= //
+
+#ifdef MAIDSAFE_ENCODE_NEON
+bool AllSetNeon(uint8x16_t mask) {
+  const uint64x2_t words(vreinterpretq_u64_u8(mask));
+  return (vgetq_lane_u64(words, 0) & vgetq_lane_u64(words, 1)) == ~uint64_t(0);
+}
+
+uint8x16_t HexCharsNeon(uint8x16_t nibbles) {
+  return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')),
+                  vandq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)), vdupq_n_u8('a' - '0' - 10)));
+}
+
+char* HexEncodeNeon(const unsigned char* input, std::size_t size, char* output) {
+  std::size_t i(0);
+  for (; i + 16 <= size; i += 16, output += 32) {
+    const uint8x16_t bytes(vld1q_u8(input + i));
+    uint8x16x2_t chars;
+    chars.val[0] = HexCharsNeon(vshrq_n_u8(bytes, 4));
+    chars.val[1] = HexCharsNeon(vandq_u8(bytes, vdupq_n_u8(0x0f)));
+    vst2q_u8(reinterpret_cast<uint8_t*>(output), chars);  // Interleaves the high and low chars.
+  }
+  return HexEncodeScalar(input + i, size - i, output);
+}
+
+bool HexValuesNeon(uint8x16_t chars, uint8x16_t& values) {
+  const uint8x16_t digits(vsubq_u8(chars, vdupq_n_u8('0')));
+  const uint8x16_t letters(vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a')));
+  const uint8x16_t is_digit(vcleq_u8(digits, vdupq_n_u8(9)));
+  const uint8x16_t is_letter(vcleq_u8(letters, vdupq_n_u8(5)));
+  values = vbslq_u8(is_digit, digits, vaddq_u8(letters, vdupq_n_u8(10)));
+  return AllSetNeon(vorrq_u8(is_digit, is_letter));
+}
+
+bool HexDecodeNeon(const char* input, std::size_t size, unsigned char* output) {
+  std::size_t i(0);
+  for (; i + 32 <= size; i += 32, output += 16) {
+    // Deinterleaves the chars encoding the high and low nibbles.
+    const uint8x16x2_t chars(vld2q_u8(reinterpret_cast<const uint8_t*>(input + i)));
+    uint8x16_t high, low;
+    if (!HexValuesNeon(chars.val[0], high) || !HexValuesNeon(chars.val[1], low))
+      return false;
+    vst1q_u8(output, vorrq_u8(vshlq_n_u8(high, 4), low));
+  }
+  return HexDecodeScalar(input + i, size - i, output);
+}
+
+uint8x16_t Base64CharsNeon(uint8x16_t sextets) {
+  // Start from 'A' + sextet, then correct for each later range of the alphabet.
+  uint8x16_t chars(vaddq_u8(sextets, vdupq_n_u8('A')));
+  chars = vaddq_u8(chars, vandq_u8(vcgeq_u8(sextets, vdupq_n_u8(26)), vdupq_n_u8(6)));
+  chars = vsubq_u8(chars, vandq_u8(vcgeq_u8(sextets, vdupq_n_u8(52)), vdupq_n_u8(75)));
+  chars = vsubq_u8(chars, vandq_u8(vceqq_u8(sextets, vdupq_n_u8(62)), vdupq_n_u8(15)));
+  return vsubq_u8(chars, vandq_u8(vceqq_u8(sextets, vdupq_n_u8(63)), vdupq_n_u8(12)));
+}
+
+char* Base64EncodeNeon(const unsigned char* input, std::size_t size, char* output) {
+  std::size_t i(0);
+  for (; i + 48 <= size; i += 48, output += 64) {
+    // Deinterleaves the first, second and third bytes of each 3-byte group.
+    const uint8x16x3_t bytes(vld3q_u8(input + i));
+    const uint8x16_t mask(vdupq_n_u8(0x3f));
+    uint8x16x4_t chars;
+    chars.val[0] = Base64CharsNeon(vshrq_n_u8(bytes.val[0], 2));
+    chars.val[1] = Base64CharsNeon(
+        vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[0], 4), vshrq_n_u8(bytes.val[1], 4)), mask));
+    chars.val[2] = Base64CharsNeon(
+        vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[1], 2), vshrq_n_u8(bytes.val[2], 6)), mask));
+    chars.val[3] = Base64CharsNeon(vandq_u8(bytes.val[2], mask));
+    vst4q_u8(reinterpret_cast<uint8_t*>(output), chars);
+  }
+  return Base64EncodeScalar(input + i, size - i, output);
+}
+
+bool Base64ValuesNeon(uint8x16_t chars, uint8x16_t& sextets) {
+  const uint8x16_t upper(vsubq_u8(chars, vdupq_n_u8('A')));
+  const uint8x16_t lower(vsubq_u8(chars, vdupq_n_u8('a')));
+  const uint8x16_t digit(vsubq_u8(chars, vdupq_n_u8('0')));
+  const uint8x16_t is_upper(vcleq_u8(upper, vdupq_n_u8(25)));
+  const uint8x16_t is_lower(vcleq_u8(lower, vdupq_n_u8(25)));
+  const uint8x16_t is_digit(vcleq_u8(digit, vdupq_n_u8(9)));
+  const uint8x16_t is_plus(vceqq_u8(chars, vdupq_n_u8('+')));
+  const uint8x16_t is_slash(vceqq_u8(chars, vdupq_n_u8('/')));
+  sextets = vandq_u8(is_upper, upper);
+  sextets = vbslq_u8(is_lower, vaddq_u8(lower, vdupq_n_u8(26)), sextets);
+  sextets = vbslq_u8(is_digit, vaddq_u8(digit, vdupq_n_u8(52)), sextets);
+  sextets = vbslq_u8(is_plus, vdupq_n_u8(62), sextets);
+  sextets = vbslq_u8(is_slash, vdupq_n_u8(63), sextets);
+  return AllSetNeon(vorrq_u8(vorrq_u8(vorrq_u8(is_upper, is_lower), vorrq_u8(is_digit, is_plus)),
+                             is_slash));
+}
+
+bool Base64DecodeNeon(const char* input, std::size_t size, unsigned char* output,
+                      std::size_t& decoded_size) {
+  std::size_t i(0), written(0);
+  for (; i + 64 <= size; i += 64, written += 48) {
+    const uint8x16x4_t chars(vld4q_u8(reinterpret_cast<const uint8_t*>(input + i)));
+    uint8x16x4_t sextets;
+    if (!Base64ValuesNeon(chars.val[0], sextets.val[0]) ||
+        !Base64ValuesNeon(chars.val[1], sextets.val[1]) ||
+        !Base64ValuesNeon(chars.val[2], sextets.val[2]) ||
+        !Base64ValuesNeon(chars.val[3], sextets.val[3])) {
+      break;
+    }
+    uint8x16x3_t bytes;
+    bytes.val[0] = vorrq_u8(vshlq_n_u8(sextets.val[0], 2), vshrq_n_u8(sextets.val[1], 4));
+    bytes.val[1] = vorrq_u8(vshlq_n_u8(sextets.val[1], 4), vshrq_n_u8(sextets.val[2], 2));
+    bytes.val[2] = vorrq_u8(vshlq_n_u8(sextets.val[2], 6), sextets.val[3]);
+    vst3q_u8(output + written, bytes);
+  }
+  return Base64DecodeTail(input, size, i, output, written, decoded_size);
+}
+#endif
+
+}  // unnamed namespace
+
+std::vector<EncodeKernels> SupportedEncodeKernels() {
+  std::vector<EncodeKernels> kernels;
+  kernels.push_back(
+      {"scalar", &HexEncodeScalar, &HexDecodeScalar, &Base64EncodeScalar, &Base64DecodeScalar});
+#ifdef MAIDSAFE_ENCODE_SSE2
+  kernels.push_back(
+      {"SSE2", &HexEncodeSse2, &HexDecodeSse2, &Base64EncodeScalar, &Base64DecodeScalar});
+#endif
+#ifdef MAIDSAFE_ENCODE_SSSE3
+  if (CpuSupportsSsse3()) {
+    kernels.push_back(
+        {"SSSE3", &HexEncodeSse2, &HexDecodeSse2, &Base64EncodeSsse3, &Base64DecodeSsse3});
+  }
+#endif
+#ifdef MAIDSAFE_ENCODE_AVX2
+  if (CpuSupportsAvx2()) {
+    kernels.push_back(
+        {"AVX2", &HexEncodeAvx2, &HexDecodeAvx2, &Base64EncodeAvx2, &Base64DecodeAvx2});
+  }
+#endif
+#ifdef MAIDSAFE_ENCODE_NEON
+  kernels.push_back(
+      {"NEON", &HexEncodeNeon, &HexDecodeNeon, &Base64EncodeNeon, &Base64DecodeNeon});
+#endif
+  return kernels;
+}
+
+const EncodeKernels& SelectedEncodeKernels() {
+  // Unlike the XOR-distance kernels, these can be needed during the static initialisation of other
+  // translation units (e.g. for BoundedString debug strings), so are chosen lazily.
+  static const EncodeKernels selected_kernels(SupportedEncodeKernels().back());
+  return selected_kernels;
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
@@ -0,0 +1,51 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_ENCODE_KERNELS_H_
+#define MAIDSAFE_COMMON_ENCODE_KERNELS_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace maidsafe {
+
+namespace detail {
+
+// A set of implementations of hex::EncodeTo, hex::DecodeTo, base64::EncodeTo and
+// base64::DecodeTo.  The decoders expect 'size' to have already been checked (i.e. to be even for
+// hex and a multiple of 4 for base-64).
+struct EncodeKernels {
+  const char* name;
+  char* (*hex_encode)(const unsigned char* input, std::size_t size, char* output);
+  bool (*hex_decode)(const char* input, std::size_t size, unsigned char* output);
+  char* (*base64_encode)(const unsigned char* input, std::size_t size, char* output);
+  bool (*base64_decode)(const char* input, std::size_t size, unsigned char* output,
+                        std::size_t& decoded_size);
+};
+
+// Returns every set of kernels which is supported by the CPU, ordered from slowest to fastest.
+std::vector<EncodeKernels> SupportedEncodeKernels();
+
+// Returns the fastest supported set, chosen once on first use.
+const EncodeKernels& SelectedEncodeKernels();
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_ENCODE_KERNELS_H_
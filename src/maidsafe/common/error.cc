@@ -18,6 +18,10 @@
 
 #include "maidsafe/common/error.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+
 #include "boost/throw_exception.hpp"
 
 #include "maidsafe/common/error_categories.h"
@@ -43,8 +47,54 @@ enum class ErrorCategories : int {
   kApi = 10 * kMultiple
 };
 
+std::shared_ptr<const std::string> FormatWhat(const std::error_code& ec, std::string what_arg) {
+  what_arg += ": ";
+  what_arg += ec.message();
+  return std::make_shared<const std::string>(std::move(what_arg));
+}
+
 }  // unnamed namespace
 
+maidsafe_error::maidsafe_error(std::error_code ec, const std::string& what_arg)
+    : code_(ec), what_(FormatWhat(ec, what_arg)) {}
+
+maidsafe_error::maidsafe_error(std::error_code ec, const char* what_arg)
+    : code_(ec), what_(FormatWhat(ec, what_arg)) {}
+
+maidsafe_error::maidsafe_error(int ev, const std::error_category& ecat, const std::string& what_arg)
+    : code_(ev, ecat), what_(FormatWhat(code_, what_arg)) {}
+
+maidsafe_error::maidsafe_error(int ev, const std::error_category& ecat, const char* what_arg)
+    : code_(ev, ecat), what_(FormatWhat(code_, what_arg)) {}
+
+maidsafe_error::maidsafe_error(const maidsafe_error& other) MAIDSAFE_NOEXCEPT
+    : std::exception(other),
+      code_(other.code_),
+      what_(std::atomic_load(&other.what_)) {}
+
+maidsafe_error& maidsafe_error::operator=(const maidsafe_error& other) MAIDSAFE_NOEXCEPT {
+  std::exception::operator=(other);
+  code_ = other.code_;
+  std::atomic_store(&what_, std::atomic_load(&other.what_));
+  return *this;
+}
+
+const char* maidsafe_error::what() const MAIDSAFE_NOEXCEPT {
+  auto what(std::atomic_load(&what_));
+  if (what)
+    return what->c_str();
+  try {
+    auto formatted(std::make_shared<const std::string>(code_.message()));
+    // If another thread formatted the message first, use its copy so the pointer returned to it
+    // remains valid.
+    if (std::atomic_compare_exchange_strong(&what_, &what, formatted))
+      return formatted->c_str();
+    return what->c_str();
+  } catch (const std::exception&) {
+    return "maidsafe_error";
+  }
+}
+
 int ErrorToInt(maidsafe_error error) {
   if (error.code().category() == GetCommonCategory())
     return -static_cast<int>(ErrorCategories::kCommon) - error.code().value();
@@ -0,0 +1,564 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/file_io_service.h"
+
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define MAIDSAFE_HAS_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef MAIDSAFE_HAS_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/make_unique.h"
+#include "maidsafe/common/on_scope_exit.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace detail {
+
+class FileIoBackend {
+ public:
+  explicit FileIoBackend(AsioService& asio_service) : asio_service_(asio_service) {}
+  virtual ~FileIoBackend() {}
+  virtual void Read(fs::path file_path, FileIoService::ReadHandler handler) = 0;
+  virtual void Write(fs::path file_path, std::vector<byte> content, FileIoService::Handler handler,
+                     WriteFileOptions::Durability durability) = 0;
+  virtual void Remove(fs::path file_path, FileIoService::Handler handler) = 0;
+  virtual FileIoService::Backend type() const = 0;
+
+ protected:
+  void PostReadHandler(FileIoService::ReadHandler handler, std::error_code ec,
+                       std::vector<byte> content) {
+    // The task must be copyable, so the contents are held by pointer rather than copied.
+    std::shared_ptr<std::vector<byte>> shared_content{
+        std::make_shared<std::vector<byte>>(std::move(content))};
+    asio_service_.service().post([handler, ec, shared_content] {
+      handler(ec, std::move(*shared_content));
+    });
+  }
+
+  void PostHandler(FileIoService::Handler handler, std::error_code ec) {
+    asio_service_.service().post([handler, ec] { handler(ec); });
+  }
+
+ private:
+  AsioService& asio_service_;
+};
+
+}  // namespace detail
+
+namespace {
+
+const unsigned kMaxPoolThreads(16);
+
+class ThreadPoolBackend : public detail::FileIoBackend {
+ public:
+  ThreadPoolBackend(AsioService& asio_service, unsigned queue_depth)
+      : FileIoBackend(asio_service), workers_(std::min(queue_depth, kMaxPoolThreads)) {}
+  ~ThreadPoolBackend() override { workers_.Stop(); }
+
+  void Read(fs::path file_path, FileIoService::ReadHandler handler) override {
+    workers_.service().post([this, file_path, handler] {
+      boost::expected<std::vector<byte>, common_error> content(maidsafe::ReadFile(file_path));
+      if (content)
+        PostReadHandler(handler, std::error_code(), std::move(*content));
+      else
+        PostReadHandler(handler, content.error().code(), std::vector<byte>());
+    });
+  }
+
+  void Write(fs::path file_path, std::vector<byte> content, FileIoService::Handler handler,
+             WriteFileOptions::Durability durability) override {
+    std::shared_ptr<std::vector<byte>> shared_content{
+        std::make_shared<std::vector<byte>>(std::move(content))};
+    workers_.service().post([this, file_path, shared_content, handler, durability] {
+      WriteFileOptions options;
+      options.durability = durability;
+      PostHandler(handler, maidsafe::WriteFile(file_path, *shared_content, options)
+                               ? std::error_code()
+                               : make_error_code(CommonErrors::filesystem_io_error));
+    });
+  }
+
+  void Remove(fs::path file_path, FileIoService::Handler handler) override {
+    workers_.service().post([this, file_path, handler] {
+      // As with the io_uring backend, removing a file which doesn't exist is an error.
+      boost::system::error_code ec;
+      if (fs::remove(file_path, ec))
+        PostHandler(handler, std::error_code());
+      else if (ec)
+        PostHandler(handler, std::error_code(ec.value(), std::system_category()));
+      else
+        PostHandler(handler, std::make_error_code(std::errc::no_such_file_or_directory));
+    });
+  }
+
+  FileIoService::Backend type() const override { return FileIoService::Backend::kThreadPool; }
+
+ private:
+  AsioService workers_;
+};
+
+#ifdef MAIDSAFE_HAS_IO_URING
+
+// The kernel's limit on ring entries before Linux 5.4.
+const unsigned kMaxRingDepth(4095);
+// The largest read or write submitted at once.  Longer transfers, and any short ones, are continued
+// by further submissions.
+const size_t kMaxTransferSize(1U << 30);
+const __u64 kWakeupTag(0);
+
+std::system_error LastSystemError(const char* what) {
+  return std::system_error(errno, std::system_category(), what);
+}
+
+// Drives an io_uring from a single thread.  Callers queue operations and wake the thread via an
+// eventfd, which the ring itself is always waiting to read, so the thread only ever blocks in
+// io_uring_enter.
+class IoUringBackend : public detail::FileIoBackend {
+ public:
+  IoUringBackend(AsioService& asio_service, unsigned queue_depth);
+  ~IoUringBackend() override;
+
+  void Read(fs::path file_path, FileIoService::ReadHandler handler) override {
+    std::unique_ptr<Operation> operation{maidsafe::make_unique<Operation>(Type::kRead)};
+    operation->file_path = std::move(file_path);
+    operation->read_handler = std::move(handler);
+    Enqueue(std::move(operation));
+  }
+
+  void Write(fs::path file_path, std::vector<byte> content, FileIoService::Handler handler,
+             WriteFileOptions::Durability durability) override {
+    std::unique_ptr<Operation> operation{maidsafe::make_unique<Operation>(Type::kWrite)};
+    operation->file_path = std::move(file_path);
+    operation->data = std::move(content);
+    operation->handler = std::move(handler);
+    operation->sync = durability == WriteFileOptions::Durability::kData;
+    Enqueue(std::move(operation));
+  }
+
+  void Remove(fs::path file_path, FileIoService::Handler handler) override {
+    std::unique_ptr<Operation> operation{maidsafe::make_unique<Operation>(Type::kRemove)};
+    operation->file_path = std::move(file_path);
+    operation->handler = std::move(handler);
+    Enqueue(std::move(operation));
+  }
+
+  FileIoService::Backend type() const override { return FileIoService::Backend::kIoUring; }
+
+ private:
+  enum class Type { kRead, kWrite, kRemove };
+
+  struct Operation {
+    explicit Operation(Type type_in)
+        : type(type_in), file_path(), data(), transferred(0), file_descriptor(-1), sync(false),
+          syncing(false), in_flight(false), iov(), read_handler(), handler() {}
+    const Type type;
+    fs::path file_path;
+    std::vector<byte> data;
+    size_t transferred;
+    int file_descriptor;
+    bool sync, syncing, in_flight;
+    iovec iov;
+    FileIoService::ReadHandler read_handler;
+    FileIoService::Handler handler;
+  };
+
+  void Enqueue(std::unique_ptr<Operation> operation);
+  void Run();
+  void Start(std::unique_ptr<Operation> operation);
+  void HandleCompletion(std::unique_ptr<Operation> operation, int result);
+  void Complete(std::unique_ptr<Operation> operation, std::error_code ec);
+  void SubmitTransfer(std::unique_ptr<Operation> operation);
+  void SubmitSync(std::unique_ptr<Operation> operation);
+  void SubmitWakeupRead();
+  void Submit(const io_uring_sqe& sqe);
+
+  const unsigned queue_depth_;
+  int ring_fd_, event_fd_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+  unsigned *sq_tail_, *sq_mask_, *sq_array_, *cq_head_, *cq_tail_, *cq_mask_;
+  io_uring_cqe* cqes_;
+  // The following are only accessed by 'thread_'.
+  unsigned to_submit_, in_flight_;
+  std::deque<std::unique_ptr<Operation>> backlog_;
+  uint64_t wakeup_value_;
+  iovec wakeup_iov_;
+  // Operations queued by callers, not yet taken by 'thread_'.
+  std::mutex mutex_;
+  std::deque<std::unique_ptr<Operation>> incoming_;
+  bool stopping_;
+  std::thread thread_;
+};
+
+IoUringBackend::IoUringBackend(AsioService& asio_service, unsigned queue_depth)
+    : FileIoBackend(asio_service),
+      queue_depth_(std::min(queue_depth, kMaxRingDepth)),
+      ring_fd_(-1),
+      event_fd_(-1),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_tail_(nullptr),
+      sq_mask_(nullptr),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_mask_(nullptr),
+      cqes_(nullptr),
+      to_submit_(0),
+      in_flight_(0),
+      backlog_(),
+      wakeup_value_(0),
+      wakeup_iov_(),
+      mutex_(),
+      incoming_(),
+      stopping_(false),
+      thread_() {
+  on_scope_exit cleanup_on_error([this] {
+    if (sqes_)
+      munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+      munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != MAP_FAILED)
+      munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0)
+      close(ring_fd_);
+    if (event_fd_ >= 0)
+      close(event_fd_);
+  });
+
+  // One entry more than the queue depth, for the read of 'event_fd_'.
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_ + 1, &params));
+  if (ring_fd_ < 0)
+    throw LastSystemError("io_uring_setup");
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap(false);
+#ifdef IORING_FEAT_SINGLE_MMAP
+  single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+#endif
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED)
+    throw LastSystemError("mmap of io_uring submission queue");
+  cq_ring_ = single_mmap ? sq_ring_ : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+  if (cq_ring_ == MAP_FAILED)
+    throw LastSystemError("mmap of io_uring completion queue");
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes(mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQES));
+  if (sqes == MAP_FAILED)
+    throw LastSystemError("mmap of io_uring submission entries");
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  char* const sq(static_cast<char*>(sq_ring_));
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* const cq(static_cast<char*>(cq_ring_));
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  event_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (event_fd_ < 0)
+    throw LastSystemError("eventfd");
+
+  thread_ = std::thread([this] { Run(); });
+  cleanup_on_error.Release();
+}
+
+IoUringBackend::~IoUringBackend() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  const uint64_t one(1);
+  if (write(event_fd_, &one, sizeof(one)) != sizeof(one))
+    LOG(kError) << "Failed to wake io_uring thread: " << std::strerror(errno);
+  thread_.join();
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+  close(event_fd_);
+}
+
+void IoUringBackend::Enqueue(std::unique_ptr<Operation> operation) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    incoming_.emplace_back(std::move(operation));
+  }
+  const uint64_t one(1);
+  if (write(event_fd_, &one, sizeof(one)) != sizeof(one))
+    LOG(kError) << "Failed to wake io_uring thread: " << std::strerror(errno);
+}
+
+void IoUringBackend::Run() {
+  bool stopping(false);
+  SubmitWakeupRead();
+  for (;;) {
+    const long submitted(syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 1,  // NOLINT
+                                 IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (submitted >= 0)
+      to_submit_ -= static_cast<unsigned>(submitted);
+    else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      LOG(kError) << "io_uring_enter failed: " << std::strerror(errno);
+
+    bool woken(false);
+    unsigned head(*cq_head_);
+    const unsigned tail(__atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE));
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe(cqes_[head & *cq_mask_]);
+      if (cqe.user_data == kWakeupTag) {
+        woken = true;
+      } else {
+        std::unique_ptr<Operation> operation{reinterpret_cast<Operation*>(cqe.user_data)};
+        HandleCompletion(std::move(operation), cqe.res);
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    if (woken) {
+      std::lock_guard<std::mutex> lock{mutex_};
+      for (auto& operation : incoming_)
+        backlog_.emplace_back(std::move(operation));
+      incoming_.clear();
+      stopping = stopping_;
+      SubmitWakeupRead();
+    }
+    while (in_flight_ < queue_depth_ && !backlog_.empty()) {
+      std::unique_ptr<Operation> operation{std::move(backlog_.front())};
+      backlog_.pop_front();
+      Start(std::move(operation));
+    }
+    // The outstanding read of 'event_fd_' is cancelled when the ring is closed.
+    if (stopping && in_flight_ == 0 && backlog_.empty())
+      return;
+  }
+}
+
+void IoUringBackend::Start(std::unique_ptr<Operation> operation) {
+  const char* const path(operation->file_path.c_str());
+  if (operation->type == Type::kRemove) {
+    const std::error_code ec(unlink(path) == 0 ? std::error_code()
+                                                : std::error_code(errno, std::system_category()));
+    return Complete(std::move(operation), ec);
+  }
+
+  if (operation->type == Type::kRead) {
+    operation->file_descriptor = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (operation->file_descriptor < 0 || fstat(operation->file_descriptor, &status) != 0)
+      return Complete(std::move(operation), std::error_code(errno, std::system_category()));
+    operation->data.resize(static_cast<size_t>(status.st_size));
+  } else {
+    operation->file_descriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (operation->file_descriptor < 0)
+      return Complete(std::move(operation), std::error_code(errno, std::system_category()));
+  }
+
+  if (!operation->data.empty())
+    SubmitTransfer(std::move(operation));
+  else if (operation->sync)
+    SubmitSync(std::move(operation));
+  else
+    Complete(std::move(operation), std::error_code());
+}
+
+void IoUringBackend::HandleCompletion(std::unique_ptr<Operation> operation, int result) {
+  if (result == -EINTR || result == -EAGAIN) {
+    if (operation->syncing)
+      return SubmitSync(std::move(operation));
+    return SubmitTransfer(std::move(operation));
+  }
+  if (result < 0)
+    return Complete(std::move(operation), std::error_code(-result, std::system_category()));
+  if (operation->syncing)
+    return Complete(std::move(operation), std::error_code());
+  // A read or write which makes no progress means the file was truncated or the device is full.
+  if (result == 0)
+    return Complete(std::move(operation), std::make_error_code(std::errc::io_error));
+
+  operation->transferred += static_cast<size_t>(result);
+  if (operation->transferred < operation->data.size())
+    SubmitTransfer(std::move(operation));
+  else if (operation->sync)
+    SubmitSync(std::move(operation));
+  else
+    Complete(std::move(operation), std::error_code());
+}
+
+void IoUringBackend::Complete(std::unique_ptr<Operation> operation, std::error_code ec) {
+  if (operation->in_flight)
+    --in_flight_;
+  if (operation->file_descriptor >= 0 && close(operation->file_descriptor) != 0 && !ec)
+    ec = std::error_code(errno, std::system_category());
+  if (operation->type == Type::kRead) {
+    if (ec)
+      operation->data.clear();
+    PostReadHandler(std::move(operation->read_handler), ec, std::move(operation->data));
+  } else {
+    PostHandler(std::move(operation->handler), ec);
+  }
+}
+
+void IoUringBackend::SubmitTransfer(std::unique_ptr<Operation> operation) {
+  operation->iov.iov_base = operation->data.data() + operation->transferred;
+  operation->iov.iov_len = std::min(operation->data.size() - operation->transferred,
+                                    kMaxTransferSize);
+  io_uring_sqe sqe;
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = operation->type == Type::kRead ? IORING_OP_READV : IORING_OP_WRITEV;
+  sqe.fd = operation->file_descriptor;
+  sqe.off = operation->transferred;
+  sqe.addr = reinterpret_cast<__u64>(&operation->iov);
+  sqe.len = 1;
+  if (!operation->in_flight) {
+    operation->in_flight = true;
+    ++in_flight_;
+  }
+  sqe.user_data = reinterpret_cast<__u64>(operation.release());
+  Submit(sqe);
+}
+
+void IoUringBackend::SubmitSync(std::unique_ptr<Operation> operation) {
+  io_uring_sqe sqe;
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_FSYNC;
+  sqe.fd = operation->file_descriptor;
+  sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+  operation->syncing = true;
+  if (!operation->in_flight) {
+    operation->in_flight = true;
+    ++in_flight_;
+  }
+  sqe.user_data = reinterpret_cast<__u64>(operation.release());
+  Submit(sqe);
+}
+
+void IoUringBackend::SubmitWakeupRead() {
+  wakeup_iov_.iov_base = &wakeup_value_;
+  wakeup_iov_.iov_len = sizeof(wakeup_value_);
+  io_uring_sqe sqe;
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_READV;
+  sqe.fd = event_fd_;
+  sqe.addr = reinterpret_cast<__u64>(&wakeup_iov_);
+  sqe.len = 1;
+  sqe.user_data = kWakeupTag;
+  Submit(sqe);
+}
+
+void IoUringBackend::Submit(const io_uring_sqe& sqe) {
+  // At most one entry per in-flight operation plus the wakeup read is ever outstanding, so the ring
+  // (sized for that) can't be full.
+  const unsigned tail(*sq_tail_);
+  const unsigned index(tail & *sq_mask_);
+  sqes_[index] = sqe;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++to_submit_;
+}
+
+#endif  // MAIDSAFE_HAS_IO_URING
+
+}  // unnamed namespace
+
+FileIoService::FileIoService(AsioService& asio_service, unsigned queue_depth, Backend preferred)
+    : backend_() {
+  if (queue_depth == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+#ifdef MAIDSAFE_HAS_IO_URING
+  if (preferred == Backend::kIoUring) {
+    try {
+      backend_ = maidsafe::make_unique<IoUringBackend>(asio_service, queue_depth);
+      return;
+    } catch (const std::system_error& e) {
+      LOG(kInfo) << "io_uring unavailable (" << e.what() << "); using a thread pool instead.";
+    }
+  }
+#else
+  static_cast<void>(preferred);
+#endif
+  backend_ = maidsafe::make_unique<ThreadPoolBackend>(asio_service, queue_depth);
+}
+
+FileIoService::~FileIoService() {}
+
+void FileIoService::ReadFile(fs::path file_path, ReadHandler handler) {
+  backend_->Read(std::move(file_path), std::move(handler));
+}
+
+void FileIoService::WriteFile(fs::path file_path, std::vector<byte> content, Handler handler,
+                              WriteFileOptions::Durability durability) {
+  backend_->Write(std::move(file_path), std::move(content), std::move(handler), durability);
+}
+
+void FileIoService::RemoveFile(fs::path file_path, Handler handler) {
+  backend_->Remove(std::move(file_path), std::move(handler));
+}
+
+FileIoService::Backend FileIoService::backend() const { return backend_->type(); }
+
+}  // namespace maidsafe
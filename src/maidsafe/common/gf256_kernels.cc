@@ -0,0 +1,216 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/gf256_kernels.h"
+
+#include <array>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#if defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define MAIDSAFE_GF256_SSSE3
+#define MAIDSAFE_GF256_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// vqtbl1q_u8 is only available on AArch64.
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#define MAIDSAFE_GF256_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(MAIDSAFE_GF256_AVX2) && !defined(_MSC_VER)
+#define MAIDSAFE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define MAIDSAFE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MAIDSAFE_TARGET_SSSE3
+#define MAIDSAFE_TARGET_AVX2
+#endif
+
+#include "maidsafe/common/cpu_features.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+struct Tables {
+  Tables() : exp(), log() {
+    unsigned int value(1);
+    for (int i(0); i != 255; ++i) {
+      exp[i] = exp[i + 255] = static_cast<byte>(value);
+      log[value] = static_cast<byte>(i);
+      value <<= 1;
+      if (value & 0x100)
+        value ^= 0x11d;
+    }
+  }
+  // Doubled so that the sum of two logs needs no reduction.
+  std::array<byte, 510> exp;
+  std::array<byte, 256> log;
+};
+
+const Tables kTables;
+
+// The products of 'coefficient' with each possible low nibble and each possible high nibble.
+struct NibbleTables {
+  explicit NibbleTables(byte coefficient) {
+    for (int i(0); i != 16; ++i) {
+      low[i] = Gf256Multiply(coefficient, static_cast<byte>(i));
+      high[i] = Gf256Multiply(coefficient, static_cast<byte>(i << 4));
+    }
+  }
+  byte low[16];
+  byte high[16];
+};
+
+void MultiplyAddTail(const NibbleTables& tables, const byte* input, std::size_t size,
+                     byte* output) {
+  for (std::size_t i(0); i != size; ++i)
+    output[i] ^= tables.low[input[i] & 0x0f] ^ tables.high[input[i] >> 4];
+}
+
+// ========================================== Scalar ============================================ //
+
+void MultiplyAddScalar(byte coefficient, const byte* input, std::size_t size, byte* output) {
+  if (coefficient == 0)
+    return;
+  std::array<byte, 256> products;
+  for (int i(0); i != 256; ++i)
+    products[i] = Gf256Multiply(coefficient, static_cast<byte>(i));
+  for (std::size_t i(0); i != size; ++i)
+    output[i] ^= products[input[i]];
+}
+
+// ========================================== SSSE3 ============================================= //
+
+#ifdef MAIDSAFE_GF256_SSSE3
+MAIDSAFE_TARGET_SSSE3 void MultiplyAddSsse3(byte coefficient, const byte* input, std::size_t size,
+                                            byte* output) {
+  if (coefficient == 0)
+    return;
+  const NibbleTables tables(coefficient);
+  const __m128i low(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.low)));
+  const __m128i high(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.high)));
+  const __m128i kLowNibbles(_mm_set1_epi8(0x0f));
+  std::size_t i(0);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i bytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+    const __m128i high_nibbles(_mm_and_si128(_mm_srli_epi64(bytes, 4), kLowNibbles));
+    const __m128i product(_mm_xor_si128(_mm_shuffle_epi8(low, _mm_and_si128(bytes, kLowNibbles)),
+                                        _mm_shuffle_epi8(high, high_nibbles)));
+    __m128i* const destination(reinterpret_cast<__m128i*>(output + i));
+    _mm_storeu_si128(destination, _mm_xor_si128(_mm_loadu_si128(destination), product));
+  }
+  MultiplyAddTail(tables, input + i, size - i, output + i);
+}
+#endif
+
+// =========================================== AVX2 ============================================= //
+
+#ifdef MAIDSAFE_GF256_AVX2
+MAIDSAFE_TARGET_AVX2 void MultiplyAddAvx2(byte coefficient, const byte* input, std::size_t size,
+                                          byte* output) {
+  if (coefficient == 0)
+    return;
+  const NibbleTables tables(coefficient);
+  const __m256i low(_mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.low))));
+  const __m256i high(_mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.high))));
+  const __m256i kLowNibbles(_mm256_set1_epi8(0x0f));
+  std::size_t i(0);
+  for (; i + 32 <= size; i += 32) {
+    const __m256i bytes(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)));
+    const __m256i product(_mm256_xor_si256(
+        _mm256_shuffle_epi8(low, _mm256_and_si256(bytes, kLowNibbles)),
+        _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi64(bytes, 4), kLowNibbles))));
+    __m256i* const destination(reinterpret_cast<__m256i*>(output + i));
+    _mm256_storeu_si256(destination, _mm256_xor_si256(_mm256_loadu_si256(destination), product));
+  }
+  MultiplyAddTail(tables, input + i, size - i, output + i);
+}
+#endif
+
+// =========================================== NEON ============================================= //
+
+#ifdef MAIDSAFE_GF256_NEON
+void MultiplyAddNeon(byte coefficient, const byte* input, std::size_t size, byte* output) {
+  if (coefficient == 0)
+    return;
+  const NibbleTables tables(coefficient);
+  const uint8x16_t low(vld1q_u8(tables.low));
+  const uint8x16_t high(vld1q_u8(tables.high));
+  const uint8x16_t kLowNibbles(vdupq_n_u8(0x0f));
+  std::size_t i(0);
+  for (; i + 16 <= size; i += 16) {
+    const uint8x16_t bytes(vld1q_u8(input + i));
+    const uint8x16_t product(veorq_u8(vqtbl1q_u8(low, vandq_u8(bytes, kLowNibbles)),
+                                      vqtbl1q_u8(high, vshrq_n_u8(bytes, 4))));
+    vst1q_u8(output + i, veorq_u8(vld1q_u8(output + i), product));
+  }
+  MultiplyAddTail(tables, input + i, size - i, output + i);
+}
+#endif
+
+}  // unnamed namespace
+
+byte Gf256Multiply(byte lhs, byte rhs) {
+  if (lhs == 0 || rhs == 0)
+    return 0;
+  return kTables.exp[kTables.log[lhs] + kTables.log[rhs]];
+}
+
+byte Gf256Inverse(byte value) {
+  if (value == 0) {
+    LOG(kError) << "Zero has no inverse in GF(2^8).";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  return kTables.exp[255 - kTables.log[value]];
+}
+
+std::vector<Gf256Kernels> SupportedGf256Kernels() {
+  std::vector<Gf256Kernels> kernels;
+  kernels.push_back({"scalar", &MultiplyAddScalar});
+#ifdef MAIDSAFE_GF256_SSSE3
+  if (CpuSupportsSsse3())
+    kernels.push_back({"SSSE3", &MultiplyAddSsse3});
+#endif
+#ifdef MAIDSAFE_GF256_AVX2
+  if (CpuSupportsAvx2())
+    kernels.push_back({"AVX2", &MultiplyAddAvx2});
+#endif
+#ifdef MAIDSAFE_GF256_NEON
+  kernels.push_back({"NEON", &MultiplyAddNeon});
+#endif
+  return kernels;
+}
+
+const Gf256Kernels& SelectedGf256Kernels() {
+  static const Gf256Kernels selected_kernels(SupportedGf256Kernels().back());
+  return selected_kernels;
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
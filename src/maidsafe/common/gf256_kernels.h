@@ -0,0 +1,55 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_GF256_KERNELS_H_
+#define MAIDSAFE_COMMON_GF256_KERNELS_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Arithmetic in GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d), as used by most
+// Reed-Solomon codes.  Addition is XOR.
+byte Gf256Multiply(byte lhs, byte rhs);
+// Throws if 'value' is 0.
+byte Gf256Inverse(byte value);
+
+// An implementation of the inner loop of Reed-Solomon coding: XORs the product of 'coefficient'
+// and each of the 'size' bytes of 'input' into 'output'.  The SIMD versions look up the products
+// of each input byte's two nibbles with a 16-entry table shuffle.
+struct Gf256Kernels {
+  const char* name;
+  void (*multiply_add)(byte coefficient, const byte* input, std::size_t size, byte* output);
+};
+
+// Returns every set of kernels which is supported by the CPU, ordered from slowest to fastest.
+std::vector<Gf256Kernels> SupportedGf256Kernels();
+
+// Returns the fastest supported set, chosen once on first use.
+const Gf256Kernels& SelectedGf256Kernels();
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_GF256_KERNELS_H_
@@ -0,0 +1,81 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_HASH_ALGORITHMS_HASH_PRIMITIVES_H_
+#define MAIDSAFE_COMMON_HASH_ALGORITHMS_HASH_PRIMITIVES_H_
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Little-endian loads, independent of the host's byte order.
+inline std::uint32_t Load32Le(const byte* in) {
+  return static_cast<std::uint32_t>(in[0]) | (static_cast<std::uint32_t>(in[1]) << 8) |
+         (static_cast<std::uint32_t>(in[2]) << 16) | (static_cast<std::uint32_t>(in[3]) << 24);
+}
+
+inline std::uint64_t Load64Le(const byte* in) {
+  return static_cast<std::uint64_t>(Load32Le(in)) |
+         (static_cast<std::uint64_t>(Load32Le(in + 4)) << 32);
+}
+
+inline std::uint64_t RotateLeft64(std::uint64_t value, int count) {
+  return (value << count) | (value >> (64 - count));
+}
+
+// Sets 'low' and 'high' to the halves of the full 128-bit product of 'lhs' and 'rhs'.
+inline void Multiply128(std::uint64_t lhs, std::uint64_t rhs, std::uint64_t& low,
+                        std::uint64_t& high) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 Uint128;
+  const Uint128 product(static_cast<Uint128>(lhs) * rhs);
+  low = static_cast<std::uint64_t>(product);
+  high = static_cast<std::uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  low = _umul128(lhs, rhs, &high);
+#else
+  const std::uint64_t lo_lo((lhs & 0xffffffff) * (rhs & 0xffffffff));
+  const std::uint64_t hi_lo((lhs >> 32) * (rhs & 0xffffffff));
+  const std::uint64_t lo_hi((lhs & 0xffffffff) * (rhs >> 32));
+  const std::uint64_t hi_hi((lhs >> 32) * (rhs >> 32));
+  const std::uint64_t cross((lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi);
+  high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+  low = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
+
+// The XOR of the two halves of the 128-bit product.
+inline std::uint64_t MultiplyFold64(std::uint64_t lhs, std::uint64_t rhs) {
+  std::uint64_t low, high;
+  Multiply128(lhs, rhs, low, high);
+  return low ^ high;
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_HASH_ALGORITHMS_HASH_PRIMITIVES_H_
@@ -36,8 +36,25 @@
 #include "maidsafe/common/hash/algorithms/siphash.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define MAIDSAFE_SIPHASH_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(MAIDSAFE_SIPHASH_AVX2) && !defined(_MSC_VER)
+#define MAIDSAFE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MAIDSAFE_TARGET_AVX2
+#endif
+
+#include "maidsafe/common/cpu_features.h"
+
 // Visual studio warns about the do {} while (0) loop in the macro from SipHash.
 // Only change if you are confident in your abilities ...
 #ifdef _MSC_VER
@@ -92,19 +109,17 @@ namespace maidsafe {
 
 namespace {
 
-/* default: SipHash-2-4 */
-const unsigned cRounds = 2;
-const unsigned dRounds = 4;
+/* "somepseudorandomlygeneratedbytes" */
+const std::uint64_t kInitialV0 = 0x736f6d6570736575ULL;
+const std::uint64_t kInitialV1 = 0x646f72616e646f6dULL;
+const std::uint64_t kInitialV2 = 0x6c7967656e657261ULL;
+const std::uint64_t kInitialV3 = 0x7465646279746573ULL;
 
-std::uint64_t FinalizeInternal(std::uint64_t v0, std::uint64_t v1, std::uint64_t v2,
-                               std::uint64_t v3, std::uint8_t b_in, const byte* in,
-                               unsigned inlen) MAIDSAFE_NOEXCEPT {
+// The final message word: the low byte of the total length in the top byte, then the (fewer than
+// 8) trailing bytes.
+inline std::uint64_t LastWord(std::uint8_t total_length, const byte* in, unsigned inlen) {
   assert(inlen < 8);
-
-  //
-  // Compress remainder bytes
-  //
-  std::uint64_t b = (static_cast<std::uint64_t>(b_in + inlen)) << 56;
+  std::uint64_t b = static_cast<std::uint64_t>(total_length) << 56;
 
   switch (inlen & 7) {
     case 7:
@@ -125,10 +140,18 @@ std::uint64_t FinalizeInternal(std::uint64_t v0, std::uint64_t v1, std::uint64_t
     case 0:
       break;
   }
+  return b;
+}
 
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+std::uint64_t FinalizeInternal(std::uint64_t v0, std::uint64_t v1, std::uint64_t v2,
+                               std::uint64_t v3, std::uint64_t b) MAIDSAFE_NOEXCEPT {
+  //
+  // Compress remainder bytes
+  //
   v3 ^= b;
 
-  for (unsigned i = 0; i < cRounds; ++i)
+  for (unsigned i = 0; i < CompressionRounds; ++i)
     SIPROUND;
 
   v0 ^= b;
@@ -138,20 +161,124 @@ std::uint64_t FinalizeInternal(std::uint64_t v0, std::uint64_t v1, std::uint64_t
   //
   v2 ^= 0xff;
 
-  for (unsigned i = 0; i < dRounds; ++i)
+  for (unsigned i = 0; i < FinalizationRounds; ++i)
     SIPROUND;
 
   return std::uint64_t(v0 ^ v1 ^ v2 ^ v3);
 }
 
+#ifdef MAIDSAFE_SIPHASH_AVX2
+
+template <int Bits>
+MAIDSAFE_TARGET_AVX2 inline __m256i RotateLeft(__m256i x) {
+  return _mm256_or_si256(_mm256_slli_epi64(x, Bits), _mm256_srli_epi64(x, 64 - Bits));
+}
+
+// Rotations by 16 bits are a byte shuffle.
+template <>
+MAIDSAFE_TARGET_AVX2 inline __m256i RotateLeft<16>(__m256i x) {
+  return _mm256_shuffle_epi8(x, _mm256_setr_epi8(6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11,
+                                                 12, 13, 6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9,
+                                                 10, 11, 12, 13));
+}
+
+// Rotations by 32 bits are a dword shuffle.
+#define SIPROUND_AVX2(g)                                              \
+  do {                                                                \
+    v0[g] = _mm256_add_epi64(v0[g], v1[g]);                           \
+    v1[g] = _mm256_xor_si256(RotateLeft<13>(v1[g]), v0[g]);           \
+    v0[g] = _mm256_shuffle_epi32(v0[g], _MM_SHUFFLE(2, 3, 0, 1));     \
+    v2[g] = _mm256_add_epi64(v2[g], v3[g]);                           \
+    v3[g] = _mm256_xor_si256(RotateLeft<16>(v3[g]), v2[g]);           \
+    v0[g] = _mm256_add_epi64(v0[g], v3[g]);                           \
+    v3[g] = _mm256_xor_si256(RotateLeft<21>(v3[g]), v0[g]);           \
+    v2[g] = _mm256_add_epi64(v2[g], v1[g]);                           \
+    v1[g] = _mm256_xor_si256(RotateLeft<17>(v1[g]), v2[g]);           \
+    v2[g] = _mm256_shuffle_epi32(v2[g], _MM_SHUFFLE(2, 3, 0, 1));     \
+  } while (0)
+
+MAIDSAFE_TARGET_AVX2 inline __m256i LoadLanes(std::uint64_t w0, std::uint64_t w1, std::uint64_t w2,
+                                              std::uint64_t w3) {
+  return _mm256_set_epi64x(static_cast<long long>(w3), static_cast<long long>(w2),  // NOLINT
+                           static_cast<long long>(w1), static_cast<long long>(w0));   // NOLINT
+}
+
+// Hashes the 4 * 'Groups' keys, each of which has 'word_count' whole 8-byte words.  Each group is
+// one 256-bit vector per state word, holding the state of 4 lanes (keys).  Two groups are usually
+// processed together, since a single group's rounds are one long dependency chain.
+template <unsigned CompressionRounds, unsigned FinalizationRounds, int Groups>
+MAIDSAFE_TARGET_AVX2 void HashLanesAvx2(std::uint64_t k0, std::uint64_t k1,
+                                        const byte* const* keys, const std::size_t* sizes,
+                                        std::size_t word_count, std::uint64_t* hashes) {
+  __m256i v0[Groups], v1[Groups], v2[Groups], v3[Groups], m[Groups];
+  for (int g = 0; g < Groups; ++g) {
+    v0[g] = _mm256_set1_epi64x(static_cast<long long>(kInitialV0 ^ k0));  // NOLINT
+    v1[g] = _mm256_set1_epi64x(static_cast<long long>(kInitialV1 ^ k1));  // NOLINT
+    v2[g] = _mm256_set1_epi64x(static_cast<long long>(kInitialV2 ^ k0));  // NOLINT
+    v3[g] = _mm256_set1_epi64x(static_cast<long long>(kInitialV3 ^ k1));  // NOLINT
+  }
+
+  for (std::size_t offset = 0; offset != word_count * 8; offset += 8) {
+    for (int g = 0; g < Groups; ++g) {
+      const byte* const* group_keys = keys + 4 * g;
+      m[g] = LoadLanes(U8TO64_LE(group_keys[0] + offset), U8TO64_LE(group_keys[1] + offset),
+                       U8TO64_LE(group_keys[2] + offset), U8TO64_LE(group_keys[3] + offset));
+      v3[g] = _mm256_xor_si256(v3[g], m[g]);
+    }
+    for (unsigned i = 0; i < CompressionRounds; ++i) {
+      for (int g = 0; g < Groups; ++g)
+        SIPROUND_AVX2(g);
+    }
+    for (int g = 0; g < Groups; ++g)
+      v0[g] = _mm256_xor_si256(v0[g], m[g]);
+  }
+
+  const unsigned tail_offset = static_cast<unsigned>(word_count * 8);
+  for (int g = 0; g < Groups; ++g) {
+    std::uint64_t last[4];
+    for (int lane = 0; lane < 4; ++lane) {
+      const std::size_t size = sizes[4 * g + lane];
+      last[lane] = LastWord(std::uint8_t(size), keys[4 * g + lane] + tail_offset,
+                            static_cast<unsigned>(size - tail_offset));
+    }
+    m[g] = LoadLanes(last[0], last[1], last[2], last[3]);
+    v3[g] = _mm256_xor_si256(v3[g], m[g]);
+  }
+  for (unsigned i = 0; i < CompressionRounds; ++i) {
+    for (int g = 0; g < Groups; ++g)
+      SIPROUND_AVX2(g);
+  }
+  for (int g = 0; g < Groups; ++g) {
+    v0[g] = _mm256_xor_si256(v0[g], m[g]);
+    v2[g] = _mm256_xor_si256(v2[g], _mm256_set1_epi64x(0xff));
+  }
+  for (unsigned i = 0; i < FinalizationRounds; ++i) {
+    for (int g = 0; g < Groups; ++g)
+      SIPROUND_AVX2(g);
+  }
+  for (int g = 0; g < Groups; ++g) {
+    const __m256i result =
+        _mm256_xor_si256(_mm256_xor_si256(v0[g], v1[g]), _mm256_xor_si256(v2[g], v3[g]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + 4 * g), result);
+  }
+}
+
+bool UseAvx2() {
+  static const bool use_avx2(detail::CpuSupportsAvx2());
+  return use_avx2;
+}
+
+#endif
+
 }  // namespace
 
-SipHash::SipHash(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT
-    : /* "somepseudorandomlygeneratedbytes" */
-      v0(0x736f6d6570736575ULL),
-      v1(0x646f72616e646f6dULL),
-      v2(0x6c7967656e657261ULL),
-      v3(0x7465646279746573ULL),
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+BasicSipHash<CompressionRounds, FinalizationRounds>::BasicSipHash(
+    const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT
+    : v0(kInitialV0),
+      v1(kInitialV1),
+      v2(kInitialV2),
+      v3(kInitialV3),
       remainder_length_(0),
       remainder_(),
       b(0) {
@@ -164,55 +291,96 @@ SipHash::SipHash(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT
   v0 ^= k0;
 }
 
-unsigned SipHash::Compress(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT {
-  const uint8_t* const end = in + inlen - (inlen % sizeof(uint64_t));
-  const unsigned left = inlen & 7;
-
-  for (; in != end; in += 8) {
-    const std::uint64_t m = U8TO64_LE(in);
-    v3 ^= m;
-
-    for (unsigned i = 0; i < cRounds; ++i)
-      SIPROUND;
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+inline void BasicSipHash<CompressionRounds, FinalizationRounds>::Compress(std::uint64_t m)
+    MAIDSAFE_NOEXCEPT {
+  v3 ^= m;
 
-    v0 ^= m;
-  }
+  for (unsigned i = 0; i < CompressionRounds; ++i)
+    SIPROUND;
 
-  return left;
+  v0 ^= m;
 }
 
-void SipHash::Update(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT {
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+void BasicSipHash<CompressionRounds, FinalizationRounds>::Update(const byte* in,
+                                                                 std::uint64_t inlen)
+    MAIDSAFE_NOEXCEPT {
   assert(remainder_length_ < remainder_.size());
+  b = std::uint8_t(b + inlen);
 
-  if (remainder_length_ > 0) {
-    const std::uint64_t copy_length =
-        std::min<std::uint64_t>(inlen, remainder_.size() - remainder_length_);
+  // Input which doesn't complete a word (most small numeric and string fields) is just buffered.
+  if (remainder_length_ + inlen < remainder_.size()) {
+    std::copy(in, in + inlen, remainder_.data() + remainder_length_);
+    remainder_length_ = unsigned(remainder_length_ + inlen);
+    return;
+  }
 
+  if (remainder_length_ > 0) {
+    const unsigned copy_length = unsigned(remainder_.size() - remainder_length_);
     std::copy(in, in + copy_length, remainder_.data() + remainder_length_);
-
+    Compress(U8TO64_LE(remainder_.data()));
     in += copy_length;
     inlen -= copy_length;
-
-    remainder_length_ = unsigned(remainder_length_ + copy_length);
-    b = std::uint8_t(b + copy_length);
-
-    remainder_length_ = Compress(remainder_.data(), remainder_length_);
   }
 
-  const unsigned left = Compress(in, inlen);
-
-  assert(left <= inlen);
-  assert(remainder_length_ + left < remainder_.size());
-  std::copy(in + (inlen - left), in + inlen, remainder_.data() + remainder_length_);
+  // Whole words are compressed straight from the input.
+  const byte* const end = in + (inlen - (inlen % sizeof(std::uint64_t)));
+  for (; in != end; in += 8)
+    Compress(U8TO64_LE(in));
 
-  remainder_length_ += left;
-  b = std::uint8_t(b + inlen);
+  remainder_length_ = unsigned(inlen & 7);
+  std::copy(in, in + remainder_length_, remainder_.data());
 }
 
-std::uint64_t SipHash::Finalize() const MAIDSAFE_NOEXCEPT {
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+std::uint64_t BasicSipHash<CompressionRounds, FinalizationRounds>::Finalize() const
+    MAIDSAFE_NOEXCEPT {
   // Copy state, so this object isn't actually finalized
   assert(remainder_length_ < remainder_.size());
-  return FinalizeInternal(v0, v1, v2, v3, b, remainder_.data(), remainder_length_);
+  return FinalizeInternal<CompressionRounds, FinalizationRounds>(
+      v0, v1, v2, v3, LastWord(b, remainder_.data(), remainder_length_));
 }
 
+template <unsigned CompressionRounds, unsigned FinalizationRounds>
+void BasicSipHash<CompressionRounds, FinalizationRounds>::HashMany(
+    const std::array<byte, kKeySize>& seed, const byte* const* keys, const std::size_t* sizes,
+    std::size_t count, std::uint64_t* hashes) MAIDSAFE_NOEXCEPT {
+  std::size_t i = 0;
+#ifdef MAIDSAFE_SIPHASH_AVX2
+  if (UseAvx2()) {
+    const std::uint64_t k0 = U8TO64_LE(seed.data());
+    const std::uint64_t k1 = U8TO64_LE(seed.data() + sizeof(k0));
+    while (i + 4 <= count) {
+      const std::size_t word_count = sizes[i] / 8;
+      std::size_t run = 1;
+      while (run != 8 && i + run != count && sizes[i + run] / 8 == word_count)
+        ++run;
+      if (run == 8) {
+        HashLanesAvx2<CompressionRounds, FinalizationRounds, 2>(k0, k1, keys + i, sizes + i,
+                                                               word_count, hashes + i);
+      } else if (run >= 4) {
+        run = 4;
+        HashLanesAvx2<CompressionRounds, FinalizationRounds, 1>(k0, k1, keys + i, sizes + i,
+                                                               word_count, hashes + i);
+      } else {
+        run = 1;
+        BasicSipHash hash(seed);
+        hash.Update(keys[i], sizes[i]);
+        hashes[i] = hash.Finalize();
+      }
+      i += run;
+    }
+  }
+#endif
+  for (; i != count; ++i) {
+    BasicSipHash hash(seed);
+    hash.Update(keys[i], sizes[i]);
+    hashes[i] = hash.Finalize();
+  }
+}
+
+template class BasicSipHash<2, 4>;
+template class BasicSipHash<1, 3>;
+
 }  // namespace maidsafe
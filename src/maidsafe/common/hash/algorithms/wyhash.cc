@@ -0,0 +1,118 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Based on the public domain reference implementation of wyhash "final3" by Wang Yi
+// (https://github.com/wangyi-fudan/wyhash), restructured to accept input incrementally.
+
+#include "maidsafe/common/hash/algorithms/wyhash.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/hash/algorithms/hash_primitives.h"
+
+namespace maidsafe {
+
+namespace {
+
+const std::uint64_t kSecret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                  0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+std::uint64_t Mix(std::uint64_t lhs, std::uint64_t rhs) {
+  return detail::MultiplyFold64(lhs, rhs);
+}
+
+void ProcessBlock(const byte* p, std::uint64_t& seed, std::uint64_t& see1, std::uint64_t& see2) {
+  seed = Mix(detail::Load64Le(p) ^ kSecret[1], detail::Load64Le(p + 8) ^ seed);
+  see1 = Mix(detail::Load64Le(p + 16) ^ kSecret[2], detail::Load64Le(p + 24) ^ see1);
+  see2 = Mix(detail::Load64Le(p + 32) ^ kSecret[3], detail::Load64Le(p + 40) ^ see2);
+}
+
+std::uint64_t Load3(const byte* p, std::size_t length) {
+  return (static_cast<std::uint64_t>(p[0]) << 16) |
+         (static_cast<std::uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+}
+
+}  // unnamed namespace
+
+WyHash::WyHash(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT
+    : seed_((detail::Load64Le(seed.data()) ^ detail::Load64Le(seed.data() + 8)) ^ kSecret[0]),
+      see1_(seed_),
+      see2_(seed_),
+      total_length_(0),
+      pending_length_(0) {}
+
+void WyHash::Update(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT {
+  total_length_ += inlen;
+  byte* const pending(buffer_.data() + kHistorySize);
+  if (pending_length_ != 0) {
+    const std::size_t copy_length(
+        static_cast<std::size_t>(std::min<std::uint64_t>(inlen, kBlockSize - pending_length_)));
+    std::copy(in, in + copy_length, pending + pending_length_);
+    pending_length_ += copy_length;
+    in += copy_length;
+    inlen -= copy_length;
+    if (inlen == 0)
+      return;
+    ProcessBlock(pending, seed_, see1_, see2_);
+    std::copy(pending + kBlockSize - kHistorySize, pending + kBlockSize, buffer_.data());
+    pending_length_ = 0;
+  }
+
+  // Whole blocks are processed straight from the input.
+  if (inlen > kBlockSize) {
+    do {
+      ProcessBlock(in, seed_, see1_, see2_);
+      in += kBlockSize;
+      inlen -= kBlockSize;
+    } while (inlen > kBlockSize);
+    std::copy(in - kHistorySize, in, buffer_.data());
+  }
+
+  std::copy(in, in + inlen, pending);
+  pending_length_ = static_cast<std::size_t>(inlen);
+}
+
+std::uint64_t WyHash::Finalize() const MAIDSAFE_NOEXCEPT {
+  const byte* p(buffer_.data() + kHistorySize);
+  std::size_t i(pending_length_);
+  std::uint64_t seed(seed_), a, b;
+  if (total_length_ <= 16) {
+    if (i >= 4) {
+      a = (static_cast<std::uint64_t>(detail::Load32Le(p)) << 32) |
+          detail::Load32Le(p + ((i >> 3) << 2));
+      b = (static_cast<std::uint64_t>(detail::Load32Le(p + i - 4)) << 32) |
+          detail::Load32Le(p + i - 4 - ((i >> 3) << 2));
+    } else if (i > 0) {
+      a = Load3(p, i);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    if (total_length_ > kBlockSize)
+      seed ^= see1_ ^ see2_;
+    for (; i > 16; i -= 16, p += 16)
+      seed = Mix(detail::Load64Le(p) ^ kSecret[1], detail::Load64Le(p + 8) ^ seed);
+    // May read back into the history.
+    a = detail::Load64Le(p + i - 16);
+    b = detail::Load64Le(p + i - 8);
+  }
+  return Mix(kSecret[1] ^ total_length_, Mix(a ^ kSecret[1], b ^ seed));
+}
+
+}  // namespace maidsafe
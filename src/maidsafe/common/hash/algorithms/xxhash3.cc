@@ -0,0 +1,297 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Based on the BSD-licensed reference implementation of XXH3 in xxHash 0.8 by Yann Collet
+// (https://github.com/Cyan4973/xxHash), using only its portable scalar code paths.
+
+#include "maidsafe/common/hash/algorithms/xxhash3.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/hash/algorithms/hash_primitives.h"
+
+namespace maidsafe {
+
+namespace {
+
+const std::uint32_t kPrime32_1 = 0x9e3779b1U;
+const std::uint32_t kPrime32_2 = 0x85ebca77U;
+const std::uint32_t kPrime32_3 = 0xc2b2ae3dU;
+const std::uint64_t kPrime64_1 = 0x9e3779b185ebca87ULL;
+const std::uint64_t kPrime64_2 = 0xc2b2ae3d27d4eb4fULL;
+const std::uint64_t kPrime64_3 = 0x165667b19e3779f9ULL;
+const std::uint64_t kPrime64_4 = 0x85ebca77c2b2ae63ULL;
+const std::uint64_t kPrime64_5 = 0x27d4eb2f165667c5ULL;
+const std::uint64_t kPrimeMx1 = 0x165667919e3779f9ULL;
+const std::uint64_t kPrimeMx2 = 0x9fb21c651e98df25ULL;
+
+const std::size_t kStripeSize = 64;
+const std::size_t kSecretLimit = 192 - kStripeSize;
+const std::size_t kStripesPerBlock = kSecretLimit / 8;
+const std::size_t kMidSizeMax = 240;
+
+const byte kDefaultSecret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e};
+
+std::uint64_t XorShift(std::uint64_t value, int shift) { return value ^ (value >> shift); }
+
+std::uint64_t Swap32(std::uint32_t value) {
+  return ((value << 24) & 0xff000000U) | ((value << 8) & 0x00ff0000U) |
+         ((value >> 8) & 0x0000ff00U) | ((value >> 24) & 0x000000ffU);
+}
+
+std::uint64_t Swap64(std::uint64_t value) {
+  return (Swap32(static_cast<std::uint32_t>(value)) << 32) |
+         Swap32(static_cast<std::uint32_t>(value >> 32));
+}
+
+std::uint64_t Xxh64Avalanche(std::uint64_t hash) {
+  hash = XorShift(hash, 33) * kPrime64_2;
+  hash = XorShift(hash, 29) * kPrime64_3;
+  return XorShift(hash, 32);
+}
+
+std::uint64_t Avalanche(std::uint64_t hash) {
+  hash = XorShift(hash, 37) * kPrimeMx1;
+  return XorShift(hash, 32);
+}
+
+std::uint64_t RrmxmxAvalanche(std::uint64_t hash, std::uint64_t length) {
+  hash ^= detail::RotateLeft64(hash, 49) ^ detail::RotateLeft64(hash, 24);
+  hash *= kPrimeMx2;
+  hash ^= (hash >> 35) + length;
+  hash *= kPrimeMx2;
+  return XorShift(hash, 28);
+}
+
+std::uint64_t Mix16(const byte* in, const byte* secret, std::uint64_t seed) {
+  return detail::MultiplyFold64(detail::Load64Le(in) ^ (detail::Load64Le(secret) + seed),
+                                detail::Load64Le(in + 8) ^ (detail::Load64Le(secret + 8) - seed));
+}
+
+// ================================ Inputs of up to 240 bytes ================================== //
+
+std::uint64_t Hash0To16(const byte* in, std::size_t length, const byte* secret,
+                        std::uint64_t seed) {
+  if (length > 8) {
+    const std::uint64_t bitflip1((detail::Load64Le(secret + 24) ^ detail::Load64Le(secret + 32)) +
+                                 seed);
+    const std::uint64_t bitflip2((detail::Load64Le(secret + 40) ^ detail::Load64Le(secret + 48)) -
+                                 seed);
+    const std::uint64_t low(detail::Load64Le(in) ^ bitflip1);
+    const std::uint64_t high(detail::Load64Le(in + length - 8) ^ bitflip2);
+    return Avalanche(length + Swap64(low) + high + detail::MultiplyFold64(low, high));
+  }
+  if (length >= 4) {
+    seed ^= Swap32(static_cast<std::uint32_t>(seed)) << 32;
+    const std::uint64_t bitflip((detail::Load64Le(secret + 8) ^ detail::Load64Le(secret + 16)) -
+                                seed);
+    const std::uint64_t input(detail::Load32Le(in + length - 4) +
+                              (static_cast<std::uint64_t>(detail::Load32Le(in)) << 32));
+    return RrmxmxAvalanche(input ^ bitflip, length);
+  }
+  if (length > 0) {
+    const std::uint32_t combined((static_cast<std::uint32_t>(in[0]) << 16) |
+                                 (static_cast<std::uint32_t>(in[length >> 1]) << 24) |
+                                 static_cast<std::uint32_t>(in[length - 1]) |
+                                 (static_cast<std::uint32_t>(length) << 8));
+    const std::uint64_t bitflip((detail::Load32Le(secret) ^ detail::Load32Le(secret + 4)) + seed);
+    return Xxh64Avalanche(combined ^ bitflip);
+  }
+  return Xxh64Avalanche(seed ^ detail::Load64Le(secret + 56) ^ detail::Load64Le(secret + 64));
+}
+
+std::uint64_t Hash17To128(const byte* in, std::size_t length, const byte* secret,
+                          std::uint64_t seed) {
+  std::uint64_t accumulator(length * kPrime64_1);
+  if (length > 32) {
+    if (length > 64) {
+      if (length > 96) {
+        accumulator += Mix16(in + 48, secret + 96, seed);
+        accumulator += Mix16(in + length - 64, secret + 112, seed);
+      }
+      accumulator += Mix16(in + 32, secret + 64, seed);
+      accumulator += Mix16(in + length - 48, secret + 80, seed);
+    }
+    accumulator += Mix16(in + 16, secret + 32, seed);
+    accumulator += Mix16(in + length - 32, secret + 48, seed);
+  }
+  accumulator += Mix16(in, secret, seed);
+  accumulator += Mix16(in + length - 16, secret + 16, seed);
+  return Avalanche(accumulator);
+}
+
+std::uint64_t Hash129To240(const byte* in, std::size_t length, const byte* secret,
+                           std::uint64_t seed) {
+  std::uint64_t accumulator(length * kPrime64_1);
+  for (std::size_t i(0); i != 8; ++i)
+    accumulator += Mix16(in + 16 * i, secret + 16 * i, seed);
+  accumulator = Avalanche(accumulator);
+  for (std::size_t i(8); i != length / 16; ++i)
+    accumulator += Mix16(in + 16 * i, secret + 16 * (i - 8) + 3, seed);
+  accumulator += Mix16(in + length - 16, secret + 136 - 17, seed);
+  return Avalanche(accumulator);
+}
+
+// ================================== Longer inputs (stripes) ================================== //
+
+void Accumulate512(std::array<std::uint64_t, 8>& accumulators, const byte* in,
+                   const byte* secret) {
+  for (std::size_t i(0); i != 8; ++i) {
+    const std::uint64_t value(detail::Load64Le(in + 8 * i));
+    const std::uint64_t key(value ^ detail::Load64Le(secret + 8 * i));
+    accumulators[i ^ 1] += value;
+    accumulators[i] += (key & 0xffffffff) * (key >> 32);
+  }
+}
+
+void Scramble(std::array<std::uint64_t, 8>& accumulators, const byte* secret) {
+  for (std::size_t i(0); i != 8; ++i) {
+    accumulators[i] =
+        (XorShift(accumulators[i], 47) ^ detail::Load64Le(secret + 8 * i)) * kPrime32_1;
+  }
+}
+
+// Accumulates 'stripe_count' stripes, scrambling the accumulators after each complete block.
+const byte* ConsumeStripes(std::array<std::uint64_t, 8>& accumulators,
+                           std::size_t& stripes_so_far, const byte* in, std::size_t stripe_count,
+                           const byte* secret) {
+  while (stripe_count != 0) {
+    const std::size_t count(std::min(stripe_count, kStripesPerBlock - stripes_so_far));
+    for (std::size_t i(0); i != count; ++i, in += kStripeSize)
+      Accumulate512(accumulators, in, secret + (stripes_so_far + i) * 8);
+    stripes_so_far += count;
+    stripe_count -= count;
+    if (stripes_so_far == kStripesPerBlock) {
+      Scramble(accumulators, secret + kSecretLimit);
+      stripes_so_far = 0;
+    }
+  }
+  return in;
+}
+
+std::uint64_t MergeAccumulators(const std::array<std::uint64_t, 8>& accumulators,
+                                const byte* secret, std::uint64_t start) {
+  std::uint64_t result(start);
+  for (std::size_t i(0); i != 4; ++i) {
+    const byte* const key(secret + 16 * i);
+    result += detail::MultiplyFold64(accumulators[2 * i] ^ detail::Load64Le(key),
+                                     accumulators[2 * i + 1] ^ detail::Load64Le(key + 8));
+  }
+  return Avalanche(result);
+}
+
+void DeriveSecret(std::uint64_t seed, byte* secret) {
+  for (std::size_t i(0); i != sizeof(kDefaultSecret); i += 16) {
+    const std::uint64_t low(detail::Load64Le(kDefaultSecret + i) + seed);
+    const std::uint64_t high(detail::Load64Le(kDefaultSecret + i + 8) - seed);
+    for (std::size_t j(0); j != 8; ++j) {
+      secret[i + j] = static_cast<byte>(low >> (8 * j));
+      secret[i + 8 + j] = static_cast<byte>(high >> (8 * j));
+    }
+  }
+}
+
+}  // unnamed namespace
+
+XxHash3::XxHash3(const std::array<byte, kKeySize>& seed) MAIDSAFE_NOEXCEPT
+    : seed_(detail::Load64Le(seed.data()) ^ detail::Load64Le(seed.data() + 8)),
+      total_length_(0),
+      buffered_length_(0),
+      stripes_so_far_(0),
+      accumulators_{{kPrime32_3, kPrime64_1, kPrime64_2, kPrime64_3, kPrime64_4, kPrime32_2,
+                     kPrime64_5, kPrime32_1}} {}
+
+void XxHash3::Update(const byte* in, std::uint64_t inlen) MAIDSAFE_NOEXCEPT {
+  const bool secret_derived(total_length_ > kBufferSize);
+  total_length_ += inlen;
+  if (inlen <= kBufferSize - buffered_length_) {
+    std::copy(in, in + inlen, buffer_.data() + buffered_length_);
+    buffered_length_ += static_cast<std::size_t>(inlen);
+    return;
+  }
+
+  if (!secret_derived)
+    DeriveSecret(seed_, secret_.data());
+  const byte* const end(in + inlen);
+  // Complete and consume the buffer.  Input is only consumed once more is known to follow it, as
+  // the final stripe is processed differently.
+  if (buffered_length_ != 0) {
+    const std::size_t load_length(kBufferSize - buffered_length_);
+    std::copy(in, in + load_length, buffer_.data() + buffered_length_);
+    in += load_length;
+    ConsumeStripes(accumulators_, stripes_so_far_, buffer_.data(), kBufferSize / kStripeSize,
+                   secret_.data());
+    buffered_length_ = 0;
+  }
+  if (static_cast<std::size_t>(end - in) > kBufferSize) {
+    in = ConsumeStripes(accumulators_, stripes_so_far_, in,
+                        static_cast<std::size_t>(end - 1 - in) / kStripeSize, secret_.data());
+    // Keep the last consumed stripe, which the final stripe may overlap.
+    std::copy(in - kStripeSize, in, buffer_.data() + kBufferSize - kStripeSize);
+  }
+  std::copy(in, end, buffer_.data());
+  buffered_length_ = static_cast<std::size_t>(end - in);
+}
+
+std::uint64_t XxHash3::Finalize() const MAIDSAFE_NOEXCEPT {
+  const std::size_t length(static_cast<std::size_t>(total_length_));
+  if (total_length_ <= 16)
+    return Hash0To16(buffer_.data(), length, kDefaultSecret, seed_);
+  if (total_length_ <= 128)
+    return Hash17To128(buffer_.data(), length, kDefaultSecret, seed_);
+  if (total_length_ <= kMidSizeMax)
+    return Hash129To240(buffer_.data(), length, kDefaultSecret, seed_);
+
+  std::array<byte, kSecretSize> local_secret;
+  const byte* secret(secret_.data());
+  if (total_length_ <= kBufferSize) {
+    DeriveSecret(seed_, local_secret.data());
+    secret = local_secret.data();
+  }
+
+  std::array<std::uint64_t, 8> accumulators(accumulators_);
+  const byte* last_stripe(buffer_.data() + buffered_length_ - kStripeSize);
+  byte catchup[kStripeSize];
+  if (buffered_length_ >= kStripeSize) {
+    std::size_t stripes_so_far(stripes_so_far_);
+    ConsumeStripes(accumulators, stripes_so_far, buffer_.data(),
+                   (buffered_length_ - 1) / kStripeSize, secret);
+  } else {
+    // The final stripe includes the end of the last consumed stripe.
+    const std::size_t catchup_length(kStripeSize - buffered_length_);
+    std::copy(buffer_.end() - catchup_length, buffer_.end(), catchup);
+    std::copy(buffer_.begin(), buffer_.begin() + buffered_length_, catchup + catchup_length);
+    last_stripe = catchup;
+  }
+  Accumulate512(accumulators, last_stripe, secret + kSecretLimit - 7);
+  return MergeAccumulators(accumulators, secret + 11, total_length_ * kPrime64_1);
+}
+
+}  // namespace maidsafe
@@ -34,7 +34,9 @@
 #include "cereal/archives/binary.hpp"
 
 #include "maidsafe/common/hash.h"
+#include "maidsafe/common/identity.h"
 #include "maidsafe/common/test.h"
+#include "maidsafe/common/data_types/data.h"
 #include "maidsafe/common/serialisation/serialisation.h"
 
 namespace {
@@ -629,6 +631,27 @@ TEST(HashTest, BEH_StringRange) {
   EXPECT_EQ(reference, hash(ref_data));
 }
 
+TEST(HashTest, BEH_ContiguousBytes) {
+  static_assert(IsContiguousHashable<DataTypeId>::value, "DataTypeId should be hashed over");
+  static_assert(detail::IsContiguousHashableDataRange<Identity>::value,
+                "Identity should be hashed in one call");
+  static_assert(detail::IsContiguousHashableDataRange<std::vector<byte>>::value,
+                "std::vector<byte> should be hashed in one call");
+  static_assert(detail::IsContiguousHashableDataRange<std::array<DataTypeId, 2>>::value,
+                "std::array<DataTypeId> should be hashed in one call");
+
+  const maidsafe::SeededHash<maidsafe::SipHash> hash{};
+  const Identity id{MakeIdentity()};
+  const std::vector<byte> bytes(id.string().begin(), id.string().end());
+  EXPECT_EQ(hash(bytes), hash(id));
+  EXPECT_EQ(hash(bytes, std::uint32_t{7}), hash(Data::NameAndTypeId{id, DataTypeId{7}}));
+  EXPECT_NE(hash(Data::NameAndTypeId{id, DataTypeId{7}}),
+            hash(Data::NameAndTypeId{id, DataTypeId{8}}));
+  EXPECT_EQ(hash(std::vector<std::uint32_t>{1, 2}),
+            hash(std::vector<DataTypeId>{DataTypeId{1}, DataTypeId{2}}));
+  EXPECT_THROW(hash(Identity{}), std::exception);
+}
+
 template <typename T>
 class TypedHashTest : public testing::Test {};
 
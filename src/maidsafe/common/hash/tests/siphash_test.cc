@@ -19,6 +19,8 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "maidsafe/common/crypto.h"
 #include "maidsafe/common/hash/algorithms/siphash.h"
@@ -117,7 +119,8 @@ namespace {
 #define TRACE
 #endif
 
-int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k) {
+int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k,
+            int c_rounds = cROUNDS, int d_rounds = dROUNDS) {
   /* "somepseudorandomlygeneratedbytes" */
   uint64_t v0 = 0x736f6d6570736575ULL;
   uint64_t v1 = 0x646f72616e646f6dULL;
@@ -145,7 +148,7 @@ int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k) {
     v3 ^= m;
 
     TRACE;
-    for (i = 0; i < cROUNDS; ++i)
+    for (i = 0; i < c_rounds; ++i)
       SIPROUND;
 
     v0 ^= m;
@@ -175,7 +178,7 @@ int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k) {
   v3 ^= b;
 
   TRACE;
-  for (i = 0; i < cROUNDS; ++i)
+  for (i = 0; i < c_rounds; ++i)
     SIPROUND;
 
   v0 ^= b;
@@ -187,7 +190,7 @@ int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k) {
 #endif
 
   TRACE;
-  for (i = 0; i < dROUNDS; ++i)
+  for (i = 0; i < d_rounds; ++i)
     SIPROUND;
 
   b = v0 ^ v1 ^ v2 ^ v3;
@@ -197,7 +200,7 @@ int siphash(uint8_t* out, const uint8_t* in, uint64_t inlen, const uint8_t* k) {
   v1 ^= 0xdd;
 
   TRACE;
-  for (i = 0; i < dROUNDS; ++i)
+  for (i = 0; i < d_rounds; ++i)
     SIPROUND;
 
   b = v0 ^ v1 ^ v2 ^ v3;
@@ -219,9 +222,10 @@ std::array<byte, 16> GetRandomSeed() {
 }
 
 std::uint64_t SiphashReference(const std::array<byte, 16>& seed, const char* in,
-                               const std::uint64_t inlen) {
+                               const std::uint64_t inlen, int c_rounds = 2, int d_rounds = 4) {
   std::uint64_t out{};
-  siphash(reinterpret_cast<byte*>(&out), reinterpret_cast<const byte*>(in), inlen, seed.data());
+  siphash(reinterpret_cast<byte*>(&out), reinterpret_cast<const byte*>(in), inlen, seed.data(),
+          c_rounds, d_rounds);
   return out;
 }
 
@@ -275,6 +279,50 @@ TEST(SipHash, BEH_RandomString) {
   }
 }
 
+TEST(SipHash, BEH_SipHash13) {
+  const std::string test_string(RandomString(100));
+  const auto random_seed(GetRandomSeed());
+  const auto reference_hash(
+      SiphashReference(random_seed, test_string.data(), test_string.size(), 1, 3));
+  EXPECT_NE(SiphashReference(random_seed, test_string.data(), test_string.size()),
+            reference_hash);
+
+  for (unsigned count = 0; count <= test_string.size(); ++count) {
+    maidsafe::SipHash13 hash(random_seed);
+    hash.Update(reinterpret_cast<const byte*>(test_string.data()), count);
+    hash.Update(reinterpret_cast<const byte*>(test_string.data()) + count,
+                test_string.size() - count);
+    EXPECT_EQ(reference_hash, hash.Finalize()) << "Failed on count " << count;
+  }
+}
+
+TEST(SipHash, BEH_HashMany) {
+  // Runs of equal and mixed sizes, so that both SIMD and scalar paths are used where available.
+  std::vector<std::string> keys;
+  for (int i = 0; i != 50; ++i)
+    keys.push_back(RandomString(16));
+  for (int i = 0; i != 50; ++i)
+    keys.push_back(RandomString(RandomUint32() % 40));
+  keys.push_back(std::string());
+
+  std::vector<const byte*> key_pointers;
+  std::vector<std::size_t> sizes;
+  for (const auto& key : keys) {
+    key_pointers.push_back(reinterpret_cast<const byte*>(key.data()));
+    sizes.push_back(key.size());
+  }
+  const auto random_seed(GetRandomSeed());
+  std::vector<std::uint64_t> hashes(keys.size()), hashes13(keys.size());
+  maidsafe::SipHash::HashMany(random_seed, key_pointers.data(), sizes.data(), keys.size(),
+                              hashes.data());
+  maidsafe::SipHash13::HashMany(random_seed, key_pointers.data(), sizes.data(), keys.size(),
+                                hashes13.data());
+  for (std::size_t i = 0; i != keys.size(); ++i) {
+    EXPECT_EQ(SiphashReference(random_seed, keys[i].data(), keys[i].size()), hashes[i]);
+    EXPECT_EQ(SiphashReference(random_seed, keys[i].data(), keys[i].size(), 1, 3), hashes13[i]);
+  }
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
@@ -0,0 +1,91 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/hash/algorithms/wyhash.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(WyHashTest, BEH_ReferenceValues) {
+  // The test vectors published with wyhash final3, where the seed is the index of the message.
+  const char* const messages[] = {
+      "", "a", "abc", "message digest", "abcdefghijklmnopqrstuvwxyz",
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+      "12345678901234567890123456789012345678901234567890123456789012345678901234567890"};
+  const std::uint64_t expected[] = {0x42bc986dc5eec4d3ULL, 0x84508dc903c31551ULL,
+                                    0x0bc54887cfc9ecb1ULL, 0x6e2ff3298208a67cULL,
+                                    0x9a64e42e897195b9ULL, 0x9199383239c32554ULL,
+                                    0x7c1ccf6bba30f5a5ULL};
+  for (int i = 0; i != 7; ++i) {
+    std::array<byte, 16> seed{{}};
+    seed[0] = static_cast<byte>(i);
+    WyHash hash(seed);
+    hash.Update(reinterpret_cast<const byte*>(messages[i]), std::strlen(messages[i]));
+    EXPECT_EQ(expected[i], hash.Finalize()) << "Failed on message " << i;
+  }
+}
+
+TEST(WyHashTest, BEH_Incremental) {
+  const std::vector<byte> data(RandomBytes(500));
+  std::array<byte, 16> seed;
+  const std::vector<byte> random_seed(RandomBytes(seed.size()));
+  std::copy(random_seed.begin(), random_seed.end(), seed.begin());
+  WyHash whole(seed);
+  whole.Update(data.data(), data.size());
+  const std::uint64_t reference(whole.Finalize());
+
+  // Split the data at every possible point
+  for (std::size_t count = 0; count <= data.size(); ++count) {
+    WyHash hash(seed);
+    hash.Update(data.data(), count);
+    hash.Update(data.data() + count, data.size() - count);
+    EXPECT_EQ(reference, hash.Finalize()) << "Failed on count " << count;
+  }
+
+  // Try byte at a time, finalizing part way through
+  WyHash hash(seed);
+  for (std::size_t count = 0; count != data.size(); ++count) {
+    hash.Update(data.data() + count, 1);
+    if (count == 100)
+      hash.Finalize();
+  }
+  EXPECT_EQ(reference, hash.Finalize());
+}
+
+TEST(WyHashTest, BEH_SeededHash) {
+  const SeededHash<WyHash> hash{};
+  const std::uint64_t reference(hash(std::vector<int>({10, 20, 30})));
+  EXPECT_EQ(reference, hash(10, 20, 30, std::size_t(3)));
+  EXPECT_NE(reference, hash(std::vector<int>({10, 20, 31})));
+  EXPECT_NE(reference, SeededHash<WyHash>{}(std::vector<int>({10, 20, 30})));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
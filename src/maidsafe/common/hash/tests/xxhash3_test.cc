@@ -0,0 +1,114 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/hash/algorithms/xxhash3.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+std::array<byte, 16> MakeSeed(std::uint64_t value) {
+  std::array<byte, 16> seed{{}};
+  for (int i = 0; i != 8; ++i)
+    seed[i] = static_cast<byte>(value >> (8 * i));
+  return seed;
+}
+
+std::vector<byte> PatternData(std::size_t size) {
+  std::vector<byte> data(size);
+  for (std::size_t i = 0; i != size; ++i)
+    data[i] = static_cast<byte>(i * 13 + 7);
+  return data;
+}
+
+}  // namespace
+
+TEST(XxHash3Test, BEH_ReferenceValues) {
+  // Generated with XXH3_64bits_withSeed() from xxHash 0.8, covering each length class.
+  const std::vector<std::pair<std::size_t, std::uint64_t>> unseeded{
+      {0, 0x2d06800538d394c2ULL},    {1, 0x4c5cca45d0f4811fULL},    {3, 0x4db84cde75d05c7dULL},
+      {4, 0x6463b635ef5d0cc4ULL},    {8, 0xdfb79fcb63835895ULL},    {9, 0xa2535ff36fcf5851ULL},
+      {16, 0xec6bdc9b2f13aad3ULL},   {17, 0x15caf8ebb21d1562ULL},   {128, 0x9e05455fa1160f7cULL},
+      {129, 0xda54f1b29f59de42ULL},  {240, 0x550ffa8941c3677eULL},  {241, 0xf15e917afa846fcaULL},
+      {1024, 0xebe3895920eba858ULL}, {4096, 0x56ff25cda611e4b4ULL}};
+  const std::vector<std::pair<std::size_t, std::uint64_t>> seeded{
+      {0, 0xcc1ca35a1b089c5cULL},    {1, 0x6dcb95d31de5966bULL},    {3, 0xe34444ac1eae8566ULL},
+      {4, 0xdddd998852bc95ccULL},    {8, 0xa29817e5be2dd63fULL},    {9, 0x71080113e811fd9eULL},
+      {16, 0x049d46d9a2bfcc9fULL},   {17, 0x9b4a6d3baf65ace4ULL},   {128, 0xbdd163eff1bbc319ULL},
+      {129, 0xd52f019c144f6070ULL},  {240, 0xc45caec7761b0131ULL},  {241, 0xed4d75d6f02195d8ULL},
+      {1024, 0x8f612270175ee51dULL}, {4096, 0x64a88bf251bdf08aULL}};
+  const std::vector<byte> data(PatternData(4096));
+  for (const auto& expected : unseeded) {
+    XxHash3 hash(MakeSeed(0));
+    hash.Update(data.data(), expected.first);
+    EXPECT_EQ(expected.second, hash.Finalize()) << "Failed on size " << expected.first;
+  }
+  for (const auto& expected : seeded) {
+    XxHash3 hash(MakeSeed(0x0123456789abcdefULL));
+    hash.Update(data.data(), expected.first);
+    EXPECT_EQ(expected.second, hash.Finalize()) << "Failed on size " << expected.first;
+  }
+}
+
+TEST(XxHash3Test, BEH_Incremental) {
+  const std::vector<byte> data(RandomBytes(1200));
+  const auto seed(MakeSeed(RandomUint32()));
+  XxHash3 whole(seed);
+  whole.Update(data.data(), data.size());
+  const std::uint64_t reference(whole.Finalize());
+
+  // Split the data at every possible point
+  for (std::size_t count = 0; count <= data.size(); ++count) {
+    XxHash3 hash(seed);
+    hash.Update(data.data(), count);
+    hash.Update(data.data() + count, data.size() - count);
+    EXPECT_EQ(reference, hash.Finalize()) << "Failed on count " << count;
+  }
+
+  // Try byte at a time, finalizing part way through
+  XxHash3 hash(seed);
+  for (std::size_t count = 0; count != data.size(); ++count) {
+    hash.Update(data.data() + count, 1);
+    if (count == 300)
+      hash.Finalize();
+  }
+  EXPECT_EQ(reference, hash.Finalize());
+}
+
+TEST(XxHash3Test, BEH_SeededHash) {
+  const SeededHash<XxHash3> hash{};
+  const std::uint64_t reference(hash(std::vector<int>({10, 20, 30})));
+  EXPECT_EQ(reference, hash(10, 20, 30, std::size_t(3)));
+  EXPECT_NE(reference, hash(std::vector<int>({10, 20, 31})));
+  EXPECT_NE(reference, SeededHash<XxHash3>{}(std::vector<int>({10, 20, 30})));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
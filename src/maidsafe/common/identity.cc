@@ -19,58 +19,153 @@
 #include "maidsafe/common/identity.h"
 
 #include <algorithm>
-#include <bitset>
+#include <array>
+#include <utility>
 
 #include "maidsafe/common/convert.h"
+#include "maidsafe/common/encode.h"
 #include "maidsafe/common/error_categories.h"
 #include "maidsafe/common/log.h"
-#include "maidsafe/common/identity_common_bits_matrix.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/xor_distance.h"
 
 namespace maidsafe {
 
 bool CloserToTarget(const Identity& id1, const Identity& id2, const Identity& target_id) {
   if (!id1.IsInitialised() || !id2.IsInitialised() || !target_id.IsInitialised())
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
-  for (uint16_t i = 0; i < identity_size; ++i) {
-    unsigned char result1 = id1.string()[i] ^ target_id.string()[i];
-    unsigned char result2 = id2.string()[i] ^ target_id.string()[i];
-    if (result1 != result2)
-      return result1 < result2;
-  }
-  return false;
+  return detail::SelectedXorDistanceKernels().closer_to_target(id1.data(), id2.data(),
+                                                               target_id.data());
+}
+
+boost::expected<bool, common_error> TryCloserToTarget(const Identity& id1, const Identity& id2,
+                                                      const Identity& target_id) {
+  if (!id1.IsInitialised() || !id2.IsInitialised() || !target_id.IsInitialised())
+    return boost::make_unexpected(MakeError(CommonErrors::invalid_identity));
+  return detail::SelectedXorDistanceKernels().closer_to_target(id1.data(), id2.data(),
+                                                               target_id.data());
 }
 
 int CommonLeadingBits(const Identity& id1, const Identity& id2) {
   if (!id1.IsInitialised() || !id2.IsInitialised())
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  return detail::SelectedXorDistanceKernels().common_leading_bits(id1.data(), id2.data());
+}
+
+namespace detail {
+
+ClosestSelector::ClosestSelector(const Identity& target_id, std::size_t count)
+    : target_id_(target_id), count_(count), heap_() {
+  if (!target_id_.IsInitialised())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  heap_.reserve(count_);
+}
+
+void ClosestSelector::Offer(const Identity& id, std::size_t position) {
+  if (!id.IsInitialised())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  if (heap_.size() == count_) {
+    if (count_ == 0 ||
+        GetLeadingXorDistance(id.data(), target_id_.data()) > heap_.front().first.front()) {
+      return;
+    }
+    Entry entry(GetXorDistance(id.data(), target_id_.data()), position);
+    if (!(entry < heap_.front()))
+      return;
+    std::pop_heap(std::begin(heap_), std::end(heap_));
+    heap_.back() = std::move(entry);
+  } else {
+    heap_.emplace_back(GetXorDistance(id.data(), target_id_.data()), position);
+  }
+  std::push_heap(std::begin(heap_), std::end(heap_));
+}
+
+void ClosestSelector::Merge(const ClosestSelector& other) {
+  for (const auto& entry : other.heap_) {
+    if (heap_.size() < count_) {
+      heap_.push_back(entry);
+    } else if (entry < heap_.front()) {
+      std::pop_heap(std::begin(heap_), std::end(heap_));
+      heap_.back() = entry;
+    } else {
+      continue;
+    }
+    std::push_heap(std::begin(heap_), std::end(heap_));
+  }
+}
+
+std::vector<std::size_t> ClosestSelector::Positions() const {
+  std::vector<Entry> sorted(heap_);
+  std::sort_heap(std::begin(sorted), std::end(sorted));
+  std::vector<std::size_t> positions;
+  positions.reserve(sorted.size());
+  for (const auto& entry : sorted)
+    positions.push_back(entry.second);
+  return positions;
+}
+
+std::size_t ClosestSelectorThreadCount(std::size_t size, bool parallel) {
+  // Ranges smaller than this aren't worth splitting across threads.
+  const std::size_t kMinSizePerThread(1 << 16);
+  if (!parallel)
+    return 1;
+  return std::max<std::size_t>(1, std::min<std::size_t>(Concurrency(), size / kMinSizePerThread));
+}
+
+}  // namespace detail
 
-  // Find first mismatching char between the two IDs
-  const std::vector<unsigned char>& raw_id1(id1.string());
-  const std::vector<unsigned char>& raw_id2(id2.string());
-  auto mismatch(std::mismatch(raw_id1.begin(), raw_id1.end(), raw_id2.begin()));
 
-  // If there's no mismatch, the IDs are equal
-  if (mismatch.first == raw_id1.end())
-    return 8 * identity_size;
 
-  int common_bits(detail::kCommonBits[*mismatch.first][*mismatch.second]);
-  return static_cast<int>(8 * std::distance(raw_id1.begin(), mismatch.first)) + common_bits;
+namespace {
+
+using IdentityBytes = std::array<byte, identity_size>;
+
+Identity ToIdentity(const IdentityBytes& bytes) {
+  return Identity(detail::FixedString<identity_size>(bytes.begin(), bytes.end()));
+}
+
+void ThrowInvalidEncoding() {
+  LOG(kError) << "Identity factory: invalid encoding";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
 }
 
+}  // unnamed namespace
+
 
 
 namespace binary {
 
-std::string Encode(const Identity& id) {
+bool EncodeTo(const Identity& id, char* output) {
   if (!id.IsInitialised())
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
-  std::string binary;
-  binary.reserve(identity_size);
-  for (size_t i = 0; i < identity_size; ++i) {
-    std::bitset<8> temp(static_cast<int>(id.string()[i]));
-    binary += temp.to_string();
+    return false;
+  for (byte value : id.string()) {
+    for (int bit(7); bit >= 0; --bit)
+      *output++ = static_cast<char>('0' + ((value >> bit) & 1));
+  }
+  return true;
+}
+
+bool DecodeTo(const char* input, std::size_t size, Identity& id) {
+  if (size != kEncodedIdentitySize)
+    return false;
+  IdentityBytes bytes;
+  for (auto& value : bytes) {
+    unsigned value_bits(0);
+    for (int i(0); i != 8; ++i, ++input) {
+      if (*input != '0' && *input != '1')
+        return false;
+      value_bits = (value_bits << 1) | static_cast<unsigned>(*input - '0');
+    }
+    value = static_cast<byte>(value_bits);
   }
+  id = ToIdentity(bytes);
+  return true;
+}
+
+std::string Encode(const Identity& id) {
+  std::string binary(kEncodedIdentitySize, 0);
+  if (!EncodeTo(id, &binary[0]))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
   return binary;
 }
 
@@ -80,7 +175,27 @@ std::string Encode(const Identity& id) {
 
 namespace hex {
 
-std::string Encode(const Identity& id) { return Encode(id.string()); }
+bool EncodeTo(const Identity& id, char* output) {
+  if (!id.IsInitialised())
+    return false;
+  EncodeTo(id.data(), identity_size, output);
+  return true;
+}
+
+bool DecodeTo(const char* input, std::size_t size, Identity& id) {
+  IdentityBytes bytes;
+  if (size != kEncodedIdentitySize || !DecodeTo(input, size, bytes.data()))
+    return false;
+  id = ToIdentity(bytes);
+  return true;
+}
+
+std::string Encode(const Identity& id) {
+  std::string hex(kEncodedIdentitySize, 0);
+  if (!EncodeTo(id, &hex[0]))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  return hex;
+}
 
 }  // namespace hex
 
@@ -88,44 +203,61 @@ std::string Encode(const Identity& id) { return Encode(id.string()); }
 
 namespace base64 {
 
-std::string Encode(const Identity& id) { return Encode(id.string()); }
+bool EncodeTo(const Identity& id, char* output) {
+  if (!id.IsInitialised())
+    return false;
+  EncodeTo(id.data(), identity_size, output);
+  return true;
+}
+
+bool DecodeTo(const char* input, std::size_t size, Identity& id) {
+  // MaxDecodedSize counts the padded final quantum as three bytes.
+  std::array<byte, identity_size + 2> bytes;
+  std::size_t decoded_size(0);
+  if (size != kEncodedIdentitySize || !DecodeTo(input, size, bytes.data(), decoded_size) ||
+      decoded_size != identity_size) {
+    return false;
+  }
+  id = Identity(detail::FixedString<identity_size>(bytes.begin(), bytes.begin() + identity_size));
+  return true;
+}
+
+std::string Encode(const Identity& id) {
+  std::string base64(kEncodedIdentitySize, 0);
+  if (!EncodeTo(id, &base64[0]))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  return base64;
+}
 
 }  // namespace base64
 
 
 
 Identity MakeIdentity(const binary::String& id) {
-  try {
-    std::vector<byte> raw_id(identity_size, 0);
-    for (size_t i = 0; i < identity_size; ++i) {
-      std::bitset<8> temp(id->substr(i * 8, 8));
-      raw_id[i] = static_cast<unsigned char>(temp.to_ulong());
-    }
-    return Identity(raw_id);
-  } catch (const std::exception& e) {
-    LOG(kError) << "Identity factory: " << boost::diagnostic_information(e);
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
-  }
+  Identity identity;
+  if (!binary::DecodeTo(id->data(), id->size(), identity))
+    ThrowInvalidEncoding();
+  return identity;
 }
 
 Identity MakeIdentity(const hex::String& id) {
-  try {
-    return Identity(hex::DecodeToBytes(id.data));
-  } catch (const std::exception& e) {
-    LOG(kError) << "Identity factory: " << boost::diagnostic_information(e);
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
-  }
+  Identity identity;
+  if (!hex::DecodeTo(id->data(), id->size(), identity))
+    ThrowInvalidEncoding();
+  return identity;
 }
 
 Identity MakeIdentity(const base64::String& id) {
-  try {
-    return Identity(base64::DecodeToBytes(id.data));
-  } catch (const std::exception& e) {
-    LOG(kError) << "Identity factory: " << boost::diagnostic_information(e);
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
-  }
+  Identity identity;
+  if (!base64::DecodeTo(id->data(), id->size(), identity))
+    ThrowInvalidEncoding();
+  return identity;
 }
 
-Identity MakeIdentity() { return Identity(RandomBytes(identity_size)); }
+Identity MakeIdentity() {
+  detail::FixedString<identity_size> bytes(identity_size, 0);
+  FillRandomBytes(bytes.data(), identity_size);
+  return Identity(std::move(bytes));
+}
 
 }  // namespace maidsafe
@@ -18,46 +18,418 @@
 
 #include "maidsafe/common/ipc.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MAIDSAFE_IPC_USE_FUTEX
+#endif
+
 #include "maidsafe/common/encode.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/utils.h"
 
 namespace maidsafe {
 
 namespace ipc {
 
+namespace {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Channels need lock-free atomics to be usable across processes.");
+
+const std::uint32_t kChannelMagic(0x4d534348);  // "MSCH"
+const std::uint32_t kChannelVersion(1);
+const std::size_t kCacheLineSize(64);
+const std::size_t kMinimumCapacity(4096);
+const std::size_t kMaximumCapacity(std::size_t(1) << 31);
+const int kSpinCount(64);
+
+enum FrameState : std::uint32_t { kFrameEmpty = 0, kFrameMessage = 1, kFramePadding = 2 };
+
+// Every frame starts on an 8-byte boundary with this header, followed by 'size' bytes of message
+// (or, for a padding frame, 'size' is the distance to the end of the buffer).  Bytes in the buffer
+// which aren't reserved by a producer are always zero, so a reserved but not yet published frame
+// reads as kFrameEmpty.
+struct FrameHeader {
+  std::atomic<std::uint32_t> state;
+  std::uint32_t size;
+};
+static_assert(sizeof(FrameHeader) == 8, "FrameHeader must be 8 bytes.");
+
+// Positions are monotonic byte counts; the offset into the buffer is 'position & (capacity - 1)'.
+// The waiting flags and sequence numbers implement the wakeups: a waiter reads the sequence number,
+// sets its flag, then re-checks before blocking on the sequence number, while the other side bumps
+// the sequence number and wakes the waiter only if it sees the flag set.
+struct ChannelHeader {
+  std::atomic<std::uint32_t> magic;
+  std::uint32_t version;
+  std::uint32_t producers;
+  std::uint64_t capacity;
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> write_position;
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> read_position;
+  alignas(kCacheLineSize) std::atomic<std::uint32_t> data_sequence;
+  std::atomic<std::uint32_t> receiver_waiting;
+  alignas(kCacheLineSize) std::atomic<std::uint32_t> space_sequence;
+  std::atomic<std::uint32_t> senders_waiting;
+  alignas(kCacheLineSize) std::atomic<std::uint32_t> sender_count;
+};
+
+std::size_t FrameSize(std::size_t message_size) {
+  return (sizeof(FrameHeader) + message_size + 7) & ~std::size_t(7);
+}
+
+std::size_t RoundUpCapacity(std::size_t capacity) {
+  if (capacity > kMaximumCapacity)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  std::size_t rounded(kMinimumCapacity);
+  while (rounded < capacity)
+    rounded <<= 1;
+  return rounded;
+}
+
+std::chrono::steady_clock::time_point Deadline(std::chrono::milliseconds timeout) {
+  const auto now(std::chrono::steady_clock::now());
+  if (timeout > std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::time_point::max() - now))
+    return std::chrono::steady_clock::time_point::max();
+  return now + timeout;
+}
+
+// Blocks until 'word' no longer holds 'expected', 'timeout' elapses, or a spurious wakeup occurs.
+void WaitForChange(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                   std::chrono::nanoseconds timeout) {
+#ifdef MAIDSAFE_IPC_USE_FUTEX
+  timespec relative_timeout;
+  relative_timeout.tv_sec = static_cast<std::time_t>(timeout.count() / 1000000000);
+  relative_timeout.tv_nsec = static_cast<long>(timeout.count() % 1000000000);  // NOLINT
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected,
+          &relative_timeout, nullptr, 0);
+#else
+  const auto deadline(std::chrono::steady_clock::now() + timeout);
+  std::chrono::microseconds backoff(10);
+  while (word.load(std::memory_order_acquire) == expected) {
+    const auto now(std::chrono::steady_clock::now());
+    if (now >= deadline)
+      return;
+    std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(backoff, deadline - now));
+    backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+  }
+#endif
+}
+
+void Wake(std::atomic<std::uint32_t>& sequence, bool wake_all) {
+  sequence.fetch_add(1, std::memory_order_release);
+#ifdef MAIDSAFE_IPC_USE_FUTEX
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&sequence), FUTEX_WAKE,
+          wake_all ? std::numeric_limits<int>::max() : 1, nullptr, nullptr, 0);
+#else
+  static_cast<void>(wake_all);
+#endif
+}
+
+}  // unnamed namespace
+
+namespace detail {
+
+struct ChannelMapping {
+  ChannelMapping(bi::shared_memory_object object_in, bi::mapped_region region_in)
+      : object(std::move(object_in)),
+        region(std::move(region_in)),
+        header(static_cast<ChannelHeader*>(region.get_address())),
+        buffer(static_cast<byte*>(region.get_address()) + sizeof(ChannelHeader)),
+        capacity(0),
+        mask(0) {}
+
+  FrameHeader* Frame(std::uint64_t position) const {
+    return reinterpret_cast<FrameHeader*>(buffer + (position & mask));
+  }
+
+  bi::shared_memory_object object;
+  bi::mapped_region region;
+  ChannelHeader* const header;
+  byte* const buffer;
+  std::size_t capacity;
+  std::uint64_t mask;
+};
+
+}  // namespace detail
+
+ChannelReceiver::ChannelReceiver(const std::string& name, std::size_t capacity,
+                                 ChannelProducers producers)
+    : name_(hex::Encode(name)), mapping_() {
+  const std::size_t rounded_capacity(RoundUpCapacity(capacity));
+  bi::shared_memory_object::remove(name_.c_str());
+  bi::shared_memory_object object(bi::create_only, name_.c_str(), bi::read_write);
+  object.truncate(static_cast<bi::offset_t>(sizeof(ChannelHeader) + rounded_capacity));
+  bi::mapped_region region(object, bi::read_write);
+  mapping_.reset(new detail::ChannelMapping(std::move(object), std::move(region)));
+  mapping_->capacity = rounded_capacity;
+  mapping_->mask = rounded_capacity - 1;
+
+  // The newly-truncated segment is zero-filled, so only the non-zero fields need set.  The magic
+  // number is written last to mark the channel as ready for senders.
+  ChannelHeader* const header(mapping_->header);
+  header->version = kChannelVersion;
+  header->producers = static_cast<std::uint32_t>(producers);
+  header->capacity = rounded_capacity;
+  header->magic.store(kChannelMagic, std::memory_order_release);
+}
+
+ChannelReceiver::~ChannelReceiver() {
+  mapping_.reset();
+  bi::shared_memory_object::remove(name_.c_str());
+}
+
+bool ChannelReceiver::TryReceive(const Handler& handler) {
+  ChannelHeader* const header(mapping_->header);
+  std::uint64_t read_position(header->read_position.load(std::memory_order_relaxed));
+  for (;;) {
+    FrameHeader* const frame(mapping_->Frame(read_position));
+    const std::uint32_t state(frame->state.load(std::memory_order_acquire));
+    if (state == kFrameEmpty)
+      return false;
+    const std::uint32_t size(frame->size);
+    const std::size_t frame_size(state == kFramePadding ? size : FrameSize(size));
+    // Restores the frame's bytes to zero before releasing them back to the producers.
+    on_scope_exit release_frame([&] {
+      std::memset(reinterpret_cast<byte*>(frame) + sizeof(FrameHeader), 0,
+                  state == kFramePadding ? 0 : frame_size - sizeof(FrameHeader));
+      frame->size = 0;
+      frame->state.store(kFrameEmpty, std::memory_order_relaxed);
+      read_position += frame_size;
+      header->read_position.store(read_position, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (header->senders_waiting.load(std::memory_order_relaxed) != 0)
+        Wake(header->space_sequence, true);
+    });
+    if (state == kFramePadding)
+      continue;
+    handler(reinterpret_cast<const byte*>(frame) + sizeof(FrameHeader), size);
+    return true;
+  }
+}
+
+bool ChannelReceiver::TryReceive(std::vector<byte>& message) {
+  return TryReceive([&](const byte* data, std::size_t size) { message.assign(data, data + size); });
+}
+
+bool ChannelReceiver::Receive(const Handler& handler, std::chrono::milliseconds timeout) {
+  ChannelHeader* const header(mapping_->header);
+  const auto deadline(Deadline(timeout));
+  for (int attempt(0);; ++attempt) {
+    if (TryReceive(handler))
+      return true;
+    if (attempt < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    const std::uint32_t sequence(header->data_sequence.load(std::memory_order_acquire));
+    header->receiver_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint64_t read_position(header->read_position.load(std::memory_order_relaxed));
+    if (mapping_->Frame(read_position)->state.load(std::memory_order_acquire) == kFrameEmpty) {
+      const auto now(std::chrono::steady_clock::now());
+      if (now >= deadline) {
+        header->receiver_waiting.store(0, std::memory_order_relaxed);
+        return false;
+      }
+      WaitForChange(header->data_sequence, sequence, deadline - now);
+    }
+    header->receiver_waiting.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool ChannelReceiver::Receive(std::vector<byte>& message, std::chrono::milliseconds timeout) {
+  return Receive([&](const byte* data, std::size_t size) { message.assign(data, data + size); },
+                 timeout);
+}
+
+std::size_t ChannelReceiver::capacity() const { return mapping_->capacity; }
+
+ChannelSender::ChannelSender(const std::string& name) : mapping_() {
+  const std::string encoded_name(hex::Encode(name));
+  try {
+    bi::shared_memory_object object(bi::open_only, encoded_name.c_str(), bi::read_write);
+    bi::mapped_region region(object, bi::read_write);
+    if (region.get_size() < sizeof(ChannelHeader))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+    mapping_.reset(new detail::ChannelMapping(std::move(object), std::move(region)));
+  } catch (const bi::interprocess_exception&) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  ChannelHeader* const header(mapping_->header);
+  if (header->magic.load(std::memory_order_acquire) != kChannelMagic ||
+      header->version != kChannelVersion ||
+      mapping_->region.get_size() < sizeof(ChannelHeader) + header->capacity) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  mapping_->capacity = static_cast<std::size_t>(header->capacity);
+  mapping_->mask = header->capacity - 1;
+
+  if (header->producers == static_cast<std::uint32_t>(ChannelProducers::kSingle)) {
+    std::uint32_t expected(0);
+    if (!header->sender_count.compare_exchange_strong(expected, 1))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+  } else {
+    header->sender_count.fetch_add(1);
+  }
+}
+
+ChannelSender::~ChannelSender() { mapping_->header->sender_count.fetch_sub(1); }
+
+bool ChannelSender::TrySend(const byte* data, std::size_t size) {
+  if (size > max_message_size())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  ChannelHeader* const header(mapping_->header);
+  const bool single_producer(header->producers ==
+                             static_cast<std::uint32_t>(ChannelProducers::kSingle));
+  const std::size_t frame_size(FrameSize(size));
+  std::uint64_t write_position(header->write_position.load(std::memory_order_relaxed));
+  std::size_t to_end(0), reserved(0);
+  for (;;) {
+    to_end = mapping_->capacity - static_cast<std::size_t>(write_position & mapping_->mask);
+    // A frame never straddles the end of the buffer; the remainder is filled with a padding frame.
+    reserved = frame_size <= to_end ? frame_size : to_end + frame_size;
+    const std::uint64_t read_position(header->read_position.load(std::memory_order_acquire));
+    if (write_position + reserved - read_position > mapping_->capacity)
+      return false;
+    if (single_producer) {
+      header->write_position.store(write_position + reserved, std::memory_order_relaxed);
+      break;
+    }
+    if (header->write_position.compare_exchange_weak(write_position, write_position + reserved,
+                                                     std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  if (reserved != frame_size) {
+    FrameHeader* const padding(mapping_->Frame(write_position));
+    padding->size = static_cast<std::uint32_t>(to_end);
+    padding->state.store(kFramePadding, std::memory_order_release);
+    write_position += to_end;
+  }
+  FrameHeader* const frame(mapping_->Frame(write_position));
+  frame->size = static_cast<std::uint32_t>(size);
+  if (size != 0)
+    std::memcpy(reinterpret_cast<byte*>(frame) + sizeof(FrameHeader), data, size);
+  frame->state.store(kFrameMessage, std::memory_order_release);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header->receiver_waiting.load(std::memory_order_relaxed) != 0)
+    Wake(header->data_sequence, false);
+  return true;
+}
+
+bool ChannelSender::Send(const byte* data, std::size_t size, std::chrono::milliseconds timeout) {
+  ChannelHeader* const header(mapping_->header);
+  const auto deadline(Deadline(timeout));
+  for (int attempt(0);; ++attempt) {
+    if (TrySend(data, size))
+      return true;
+    if (attempt < kSpinCount) {
+      std::this_thread::yield();
+      continue;
+    }
+    const std::uint32_t sequence(header->space_sequence.load(std::memory_order_acquire));
+    header->senders_waiting.fetch_add(1, std::memory_order_relaxed);
+    on_scope_exit stop_waiting(
+        [header] { header->senders_waiting.fetch_sub(1, std::memory_order_relaxed); });
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (TrySend(data, size))
+      return true;
+    const auto now(std::chrono::steady_clock::now());
+    if (now >= deadline)
+      return false;
+    WaitForChange(header->space_sequence, sequence, deadline - now);
+  }
+}
+
+std::size_t ChannelSender::max_message_size() const {
+  return mapping_->capacity / 2 - sizeof(FrameHeader);
+}
+
 void RemoveSharedMemory(std::string name_in) {
   std::string name(hex::Encode(name_in));
   boost::interprocess::shared_memory_object::remove(name.c_str());
 }
 
-void CreateSharedMemory(std::string name_in, std::vector<std::string> items) {
-  RemoveSharedMemory(name_in);
-  std::string name(hex::Encode(name_in));
-  // Create a managed shared memory segment of large arbitrary size!
-  bi::managed_shared_memory segment(bi::create_only, name.c_str(), 65536);
-  // Create an object of Type initialised to type
-  CharAllocator charallocator(segment.get_segment_manager());
-  for (size_t i(0); i < items.size(); ++i) {
-    bi_string str(charallocator);
-    str = hex::Encode(items.at(i)).c_str();
-    segment.construct<bi_string>(std::to_string(i).c_str())(str);
+namespace {
+
+// Generous enough for the segment manager's bookkeeping and each item's index entry, name and
+// string header; CreateSegment retries with a larger segment if it isn't.
+std::size_t EstimatedSegmentSize(std::size_t item_count, std::size_t payload_size) {
+  return 4096 + item_count * 256 + payload_size + payload_size / 8;
+}
+
+template <typename Items>
+void CreateSegment(const std::string& name_in, const Items& items) {
+  const std::string name(hex::Encode(name_in));
+  std::size_t payload_size(0);
+  for (const auto& item : items)
+    payload_size += item.size();
+  std::size_t segment_size(EstimatedSegmentSize(items.size(), payload_size));
+  for (;;) {
+    bi::shared_memory_object::remove(name.c_str());
+    try {
+      bi::managed_shared_memory segment(bi::create_only, name.c_str(), segment_size);
+      CharAllocator allocator(segment.get_segment_manager());
+      for (std::size_t i(0); i < items.size(); ++i) {
+        segment.construct<bi_string>(std::to_string(i).c_str())(
+            reinterpret_cast<const char*>(items[i].data()), items[i].size(), allocator);
+      }
+      break;
+    } catch (const bi::bad_alloc&) {
+      segment_size *= 2;
+    }
   }
+  bi::managed_shared_memory::shrink_to_fit(name.c_str());
+}
+
+}  // unnamed namespace
+
+void CreateSharedMemory(std::string name_in, std::vector<std::string> items) {
+  CreateSegment(name_in, items);
+}
+
+void CreateSharedMemory(std::string name_in, const std::vector<std::vector<byte>>& items) {
+  CreateSegment(name_in, items);
 }
 
 std::vector<std::string> ReadSharedMemory(std::string name_in, int number) {
-  std::string name(hex::Encode(name_in));
-  // Open managed segment
-  boost::interprocess::managed_shared_memory segment(boost::interprocess::open_only, name.c_str());
-  CharAllocator charallocator(segment.get_segment_manager());
-  bi_string str(charallocator);
+  const SharedMemoryView view(name_in);
   std::vector<std::string> ret_vec;
   for (int i(0); i < number; ++i) {
-    auto res = segment.find<bi_string>(std::to_string(i).c_str());
-    ret_vec.push_back(hex::DecodeToString(std::string(res.first->c_str(), res.first->size())));
+    const boost::string_ref item(view.Item(static_cast<std::size_t>(i)));
+    ret_vec.emplace_back(item.data(), item.size());
   }
   return ret_vec;
 }
 
+SharedMemoryView::SharedMemoryView(std::string name_in)
+    : segment_(bi::open_only, hex::Encode(name_in).c_str()), items_() {
+  for (;;) {
+    const auto item(segment_.find<bi_string>(std::to_string(items_.size()).c_str()));
+    if (!item.first)
+      break;
+    items_.emplace_back(item.first->data(), item.first->size());
+  }
+}
+
+boost::string_ref SharedMemoryView::Item(std::size_t index) const {
+  if (index >= items_.size())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  return items_[index];
+}
 
 }  // namespace ipc
 
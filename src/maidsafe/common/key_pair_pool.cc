@@ -0,0 +1,105 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/key_pair_pool.h"
+
+#include <utility>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace rsa {
+
+KeyPairPool::KeyPairPool(size_t reserve, size_t thread_count)
+    : reserve_(reserve),
+      hit_count_(0),
+      miss_count_(0),
+      mutex_(),
+      condition_(),
+      keys_(),
+      generating_(0),
+      running_(true),
+      threads_() {
+  if (reserve == 0 || thread_count == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  for (size_t i(0); i != thread_count; ++i)
+    threads_.emplace_back([this] { Run(); });
+}
+
+KeyPairPool::~KeyPairPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+Keys KeyPairPool::Get() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!keys_.empty()) {
+      Keys keys(std::move(keys_.front()));
+      keys_.pop_front();
+      lock.unlock();
+      condition_.notify_one();
+      ++hit_count_;
+      return keys;
+    }
+  }
+  ++miss_count_;
+  return GenerateKeyPair();
+}
+
+size_t KeyPairPool::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return keys_.size();
+}
+
+void KeyPairPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    condition_.wait(lock, [this] { return !running_ || keys_.size() + generating_ < reserve_; });
+    if (!running_)
+      return;
+    ++generating_;
+    lock.unlock();
+    Keys keys;
+    bool generated(false);
+    try {
+      keys = GenerateKeyPair();
+      generated = true;
+    } catch (const std::exception& e) {
+      LOG(kError) << "KeyPairPool failed to generate a key pair: "
+                  << boost::diagnostic_information(e);
+    }
+    lock.lock();
+    --generating_;
+    if (generated)
+      keys_.push_back(std::move(keys));
+  }
+}
+
+}  // namespace rsa
+
+}  // namespace maidsafe
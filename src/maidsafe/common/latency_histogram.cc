@@ -0,0 +1,66 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace maidsafe {
+
+const size_t LatencyHistogram::kBucketCount;
+
+void LatencyHistogram::Record(std::chrono::steady_clock::duration duration) {
+  auto micros(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  size_t bucket(0);
+  while (micros > 0 && bucket < kBucketCount - 1) {
+    micros >>= 1;
+    ++bucket;
+  }
+  ++buckets[bucket];
+  ++count;
+  total += duration;
+  max = std::max(max, duration);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t i(0); i != kBucketCount; ++i)
+    buckets[i] += other.buckets[i];
+  count += other.count;
+  total += other.total;
+  max = std::max(max, other.max);
+}
+
+std::chrono::steady_clock::duration LatencyHistogram::Mean() const {
+  if (count == 0)
+    return std::chrono::steady_clock::duration();
+  return total / static_cast<std::chrono::steady_clock::rep>(count);
+}
+
+std::chrono::microseconds LatencyHistogram::Quantile(double quantile) const {
+  const auto rank(static_cast<uint64_t>(std::ceil(quantile * count)));
+  uint64_t seen(0);
+  for (size_t i(0); i != kBucketCount && count != 0; ++i) {
+    seen += buckets[i];
+    if (seen >= std::max<uint64_t>(rank, 1))
+      return std::chrono::microseconds(1LL << i);
+  }
+  return std::chrono::microseconds(0);
+}
+
+}  // namespace maidsafe
@@ -27,6 +27,8 @@
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iterator>
 #include <mutex>
 #include <vector>
@@ -44,10 +46,15 @@
 #include "boost/program_options/value_semantic.hpp"
 #include "boost/range/adaptor/replaced.hpp"
 #include "boost/range/algorithm/find_first_of.hpp"
+#include "boost/thread/tss.hpp"
 #include "boost/utility/string_ref.hpp"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/config.h"
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/make_unique.h"
+#include "maidsafe/common/mpmc_queue.h"
+#include "maidsafe/common/startup_timer.h"
 #include "maidsafe/common/utils.h"
 
 namespace fs = boost::filesystem;
@@ -80,6 +87,12 @@ const std::array<std::string, 11> kProjects = {{"api", "common", "crux", "drive"
                                                 "launcher", "nfs", "passport", "routing", "vault",
                                                 "vault_manager"}};
 
+// Messages for the VLOG server are shipped once 'kVisualiserBatchSize' are queued, or after
+// 'kVisualiserShipInterval' at the latest.  While 'kVisualiserMaxQueued' are queued, any more are
+// dropped.
+const std::size_t kVisualiserBatchSize(100), kVisualiserMaxQueued(10000);
+const std::chrono::seconds kVisualiserShipInterval(1), kVisualiserReconnectInterval(5);
+
 #ifdef MAIDSAFE_WIN32
 
 WORD GetColourAttribute(Colour colour) {
@@ -216,15 +229,21 @@ void GetColourAndLevel(char& log_level, Colour& colour, int level) {
   }
 }
 
-std::string GetColouredLogEntry(char log_level) {
+enum class TimeType { kLocal, kUTC };
+
+template <TimeType time_type>
+std::string GetTime(std::chrono::system_clock::time_point now);
+
+std::string GetColouredLogEntry(char log_level, std::thread::id thread_id,
+                                std::chrono::system_clock::time_point time) {
   std::ostringstream oss;
-  oss << log_level << " " << std::this_thread::get_id();
+  oss << log_level << " " << thread_id;
 #ifdef MAIDSAFE_WIN32
   oss << '\t';
 #else
   oss << ' ';
 #endif
-  oss << detail::GetUTCTime();
+  oss << GetTime<TimeType::kUTC>(time);
   return oss.str();
 }
 
@@ -276,7 +295,7 @@ void SendToConsole(ColourMode colour_mode, Colour colour, int level,
 }
 
 po::options_description SetProgramOptions(std::string& config_file, bool& no_log_to_console,
-                                          std::string& log_folder, bool& no_async,
+                                          std::string& log_folder, bool& no_async, bool& binary,
                                           int& colour_mode) {
 #ifdef __ANDROID__
   fs::path inipath;
@@ -288,6 +307,8 @@ po::options_description SetProgramOptions(std::string& config_file, bool& no_log
   po::options_description log_config("Logging Configuration");
   log_config.add_options()("log_no_async", po::bool_switch(&no_async),
                            "Disable asynchronous logging.")(
+      "log_binary", po::bool_switch(&binary),
+      "Write only the combined logfile, in binary form (decode with log_decoder).")(
       "log_colour_mode", po::value<int>(&colour_mode)->default_value(1),
       "0 for no colour, 1 for partial, 2 for full.")(
       "log_config", po::value<std::string>(&config_file)->default_value(inipath.string().c_str()),
@@ -295,7 +316,14 @@ po::options_description SetProgramOptions(std::string& config_file, bool& no_log
       "log_folder", po::value<std::string>(&log_folder)->default_value(logpath.string().c_str()),
       "Path to folder where log files will be written. If empty, no files will be written.")(
       "log_no_console", po::bool_switch(&no_log_to_console),
-      "Disable logging to console.")("help,h", "Show help message.");
+      "Disable logging to console.")(
+      "log_max_file_size", po::value<uint64_t>()->default_value(0),
+      "Rotate each logfile once it reaches this many MB.  0 for no limit.")(
+      "log_max_file_age", po::value<unsigned>()->default_value(0),
+      "Rotate each logfile after this many minutes.  0 for no limit.")(
+      "log_max_rotated_files", po::value<unsigned>()->default_value(0),
+      "Keep at most this many compressed rotated files per logfile.  0 for no limit.")(
+      "help,h", "Show help message.");
   for (auto project : kProjects) {
     std::string description("Set log level for ");
     description += std::string(project) + " project.";
@@ -391,8 +419,6 @@ bool SetupLogFolder(const fs::path& log_folder) {
   return true;
 }
 
-enum class TimeType { kLocal, kUTC };
-
 template <TimeType time_type>
 std::string Strftime(const std::time_t* now_t);
 
@@ -415,71 +441,365 @@ std::string Strftime<TimeType::kUTC>(const std::time_t* now_t) {
   return std::string{temp};
 }
 
+// Formatting the date and time is comparatively slow (and serialised by g_console_mutex), so each
+// thread caches the formatted prefix for the last second it saw, which is valid for every message
+// timestamped within that second.
+struct FormattedSecond {
+  FormattedSecond() : second(-1), prefix() {}
+  std::time_t second;
+  std::string prefix;
+};
+
 template <TimeType time_type>
-std::string GetTime() {
-  auto now(std::chrono::system_clock::now());
+std::string GetTime(std::chrono::system_clock::time_point now) {
+  static boost::thread_specific_ptr<FormattedSecond> formatted_second;
   auto seconds_since_epoch(
       std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()));
 
   std::time_t now_t(std::chrono::system_clock::to_time_t(
       std::chrono::system_clock::time_point(seconds_since_epoch)));
 
-  return Strftime<time_type>(&now_t) +
+  if (!formatted_second.get())
+    formatted_second.reset(new FormattedSecond);
+  if (formatted_second->second != now_t) {
+    formatted_second->prefix = Strftime<time_type>(&now_t);
+    formatted_second->second = now_t;
+  }
+  return formatted_second->prefix +
          std::to_string((now.time_since_epoch() - seconds_since_epoch).count());
 }
 
+// Binary logfiles start with 'kBinaryLogMagic' followed by a series of records, each starting with
+// a type byte.  Call site definitions (kCallSiteRecord) hold the call site's ID, level, line and
+// file, and precede the first message from that call site.  Messages (kMessageRecord) hold the call
+// site ID, the time in nanoseconds since the epoch, a hash of the thread ID and the encoded
+// arguments.  Integers are little-endian and strings are prefixed by a 32-bit size.
+const char kBinaryLogMagic[] = "MSBLOG1\n";
+const char kCallSiteRecord = 'S', kMessageRecord = 'M';
+
+enum class ArgumentType : unsigned char {
+  kString = 1,
+  kSigned = 2,
+  kUnsigned = 3,
+  kFloat = 4,
+  kBool = 5,
+  kChar = 6
+};
+
+void AppendInteger(std::string& out, uint64_t value, size_t size) {
+  for (size_t i(0); i != size; ++i)
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void AppendSizedString(std::string& out, const char* data, size_t size) {
+  AppendInteger(out, size, 4);
+  out.append(data, size);
+}
+
+std::string EncodeCallSite(uint32_t id, const char* file, int line, int level) {
+  std::string encoded(1, kCallSiteRecord);
+  AppendInteger(encoded, id, 4);
+  AppendInteger(encoded, static_cast<uint32_t>(level), 4);
+  AppendInteger(encoded, static_cast<uint32_t>(line), 4);
+  AppendSizedString(encoded, file, std::char_traits<char>::length(file));
+  return encoded;
+}
+
+// Reads from a binary logfile or encoded arguments.  Throws if there's not enough data.
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::istream& input) : input_(input) {}
+  uint64_t ReadInteger(size_t size) {
+    unsigned char bytes[8];
+    Read(reinterpret_cast<char*>(bytes), size);
+    uint64_t value(0);
+    for (size_t i(0); i != size; ++i)
+      value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    return value;
+  }
+  std::string ReadSizedString() {
+    std::string value(static_cast<size_t>(ReadInteger(4)), 0);
+    if (!value.empty())
+      Read(&value[0], value.size());
+    return value;
+  }
+  void Read(char* data, size_t size) {
+    if (!input_.read(data, size))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+ private:
+  std::istream& input_;
+};
+
+struct LogRecord {
+  LogRecord()
+      : level(0), time(), thread_id(), project(), message(), binary(false), file(nullptr),
+        line(0) {}
+  int level;
+  std::chrono::system_clock::time_point time;
+  std::thread::id thread_id;
+  // In binary mode, 'message' holds the encoded arguments, and 'file' and 'line' identify the LOG
+  // statement.
+  std::string project, message;
+  bool binary;
+  const char* file;
+  int line;
+};
+
+void WriteBinaryLogRecord(const LogRecord& record) {
+  std::string encoded;
+  const auto since_epoch(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(record.time.time_since_epoch()));
+  AppendInteger(encoded, static_cast<uint64_t>(since_epoch.count()), 8);
+  AppendInteger(encoded, std::hash<std::thread::id>()(record.thread_id), 8);
+  AppendSizedString(encoded, record.message.data(), record.message.size());
+  Logging::Instance().WriteToBinaryLogfile(record.file, record.line, record.level, encoded);
+}
+
+void WriteLogRecord(const LogRecord& record, ColourMode colour_mode) {
+  if (record.binary)
+    return WriteBinaryLogRecord(record);
+  char log_level(' ');
+  Colour colour(Colour::kDefaultColour);
+  GetColourAndLevel(log_level, colour, record.level);
+  const std::string coloured_log_entry(
+      GetColouredLogEntry(log_level, record.thread_id, record.time));
+  SendToConsole(colour_mode, colour, record.level, coloured_log_entry, record.message);
+  Logging::Instance().WriteToCombinedLogfile(coloured_log_entry + record.message);
+  Logging::Instance().WriteToProjectLogfile(record.project, coloured_log_entry + record.message);
+}
+
+// Records logged by a single thread, awaiting the background thread.  Only the first record pushed
+// after a drain causes a drain functor to be sent to the background thread, so a burst of LOG
+// statements costs a single Active::Send.  'drain_mutex' keeps the records in order if the logging
+// thread has to drain the buffer itself.
+struct ThreadLogBuffer {
+  static const size_t kCapacity = 1024;
+  ThreadLogBuffer() : records(kCapacity), drain_scheduled(false), drain_mutex() {}
+  MpmcQueue<LogRecord> records;
+  std::atomic<bool> drain_scheduled;
+  std::mutex drain_mutex;
+};
+
+// Keep outside the function to avoid lazy static init races on MSVC
+boost::thread_specific_ptr<std::shared_ptr<ThreadLogBuffer>> g_thread_log_buffer;
+// The stream reused by each thread's outermost LogStream, and whether it's currently in use.
+boost::thread_specific_ptr<std::ostringstream> g_thread_log_stream;
+boost::thread_specific_ptr<bool> g_thread_log_stream_in_use;
+
+void DrainThreadLogBuffer(const std::shared_ptr<ThreadLogBuffer>& buffer, ColourMode colour_mode) {
+  std::lock_guard<std::mutex> lock(buffer->drain_mutex);
+  // Cleared before popping so that a record pushed after the final pop schedules another drain.
+  buffer->drain_scheduled = false;
+  LogRecord record;
+  while (buffer->records.TryPop(record))
+    WriteLogRecord(record, colour_mode);
+}
+
+void QueueLogRecord(LogRecord record) {
+  if (!g_thread_log_buffer.get())
+    g_thread_log_buffer.reset(new std::shared_ptr<ThreadLogBuffer>(new ThreadLogBuffer));
+  const std::shared_ptr<ThreadLogBuffer> buffer(*g_thread_log_buffer);
+  const ColourMode colour_mode(Logging::Instance().Colour());
+  if (!buffer->records.TryPush(record)) {
+    // The background thread has fallen behind (or this is the background thread and its own
+    // buffer is full), so write out the backlog and this record from here.
+    DrainThreadLogBuffer(buffer, colour_mode);
+    WriteLogRecord(record, colour_mode);
+    return;
+  }
+  if (!buffer->drain_scheduled.exchange(true))
+    Logging::Instance().Send([buffer, colour_mode] { DrainThreadLogBuffer(buffer, colour_mode); });
+}
+
+// Reads a complete HTTP response from 'stream', returning its status code and reason phrase.
+// Throws if the response can't be read.
+std::pair<unsigned, std::string> ReadHttpResponse(std::istream& stream) {
+  std::string line;
+  if (!std::getline(stream, line))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  std::istringstream status_line(line);
+  std::string version, reason;
+  unsigned http_code{0};
+  if (!(status_line >> version >> http_code))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  std::getline(status_line >> std::ws, reason, '\r');
+
+  const std::string kContentLength("content-length:");
+  std::streamsize content_length{0};
+  while (std::getline(stream, line) && !line.empty() && line != "\r") {
+    if (boost::algorithm::to_lower_copy(line.substr(0, kContentLength.size())) == kContentLength)
+      content_length = std::stoll(line.substr(kContentLength.size()));
+  }
+  // Not 'ignore', which peeks past the body and so would block until the next response arrives.
+  std::string body(static_cast<std::size_t>(content_length), 0);
+  if (!stream || (content_length != 0 && !stream.read(&body[0], content_length)))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  return std::make_pair(http_code, reason);
+}
+
 }  // unnamed namespace
 
 namespace detail {
 
-// ======================================= LogMessage ==============================================
-boost::optional<LogMessage::FileInfo> LogMessage::ShouldLog() const {
-  auto file_info(GetProjectAndContractFile(file_));
-
-  const FilterMap filter(Logging::Instance().Filter());
-  if (file_info.first.empty()) {
-    file_info.first = "common";
+// ======================================== LogStream ==============================================
+LogStream::LogStream() : stream_(nullptr), nested_stream_() {
+  if (!g_thread_log_stream.get()) {
+    g_thread_log_stream.reset(new std::ostringstream);
+    g_thread_log_stream_in_use.reset(new bool(false));
+  }
+  if (*g_thread_log_stream_in_use) {
+    nested_stream_ = maidsafe::make_unique<std::ostringstream>();
+    stream_ = nested_stream_.get();
+    return;
   }
+  *g_thread_log_stream_in_use = true;
+  stream_ = g_thread_log_stream.get();
+  // Reset anything left over from the previous message.
+  stream_->str(std::string());
+  stream_->clear();
+  stream_->flags(std::ios_base::skipws | std::ios_base::dec);
+  stream_->precision(6);
+  stream_->width(0);
+  stream_->fill(' ');
+}
+
+LogStream::~LogStream() {
+  if (!nested_stream_)
+    *g_thread_log_stream_in_use = false;
+}
+
+// ======================================== CallSite ===============================================
+std::atomic<uint32_t> CallSite::g_filter_generation(1);
 
+bool CallSite::Refresh() {
+  const uint32_t generation(g_filter_generation.load());
+  auto project(GetProjectAndContractFile(file_).first);
+  if (project.empty())
+    project = "common";
+  const FilterMap filter(Logging::Instance().Filter());
   // With C++14, the map can be searched without a temp string
-  const std::string project(file_info.first.begin(), file_info.first.end());
+  const auto filter_itr(filter.find(std::string(project.begin(), project.end())));
+  // Projects missing from the filter aren't logged at all.
+  const int32_t min_level(filter_itr == filter.end() ? kAlways + 1 : filter_itr->second);
+  state_.store((static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(min_level),
+               std::memory_order_relaxed);
+  return level_ >= min_level;
+}
+
+// ================================= Binary argument encoding ======================================
+void EncodeString(std::string& out, const char* data, size_t size) {
+  out.push_back(static_cast<char>(ArgumentType::kString));
+  AppendSizedString(out, data, size);
+}
+
+void EncodeSigned(std::string& out, int64_t value) {
+  out.push_back(static_cast<char>(ArgumentType::kSigned));
+  AppendInteger(out, static_cast<uint64_t>(value), 8);
+}
+
+void EncodeUnsigned(std::string& out, uint64_t value) {
+  out.push_back(static_cast<char>(ArgumentType::kUnsigned));
+  AppendInteger(out, value, 8);
+}
 
-  const auto filter_itr = filter.find(project);
+void EncodeFloat(std::string& out, double value) {
+  static_assert(sizeof(double) == sizeof(uint64_t), "double must be 64 bits.");
+  uint64_t bits(0);
+  std::memcpy(&bits, &value, sizeof(bits));
+  out.push_back(static_cast<char>(ArgumentType::kFloat));
+  AppendInteger(out, bits, 8);
+}
+
+void EncodeBool(std::string& out, bool value) {
+  out.push_back(static_cast<char>(ArgumentType::kBool));
+  out.push_back(value ? 1 : 0);
+}
+
+void EncodeChar(std::string& out, char value) {
+  out.push_back(static_cast<char>(ArgumentType::kChar));
+  out.push_back(value);
+}
 
-  if (filter_itr != filter.end()) {
-    if ((*filter_itr).second <= level_) {
-      const auto fix_slashes(file_info.second | boost::adaptors::replaced('\\', '/'));
-      return FileInfo{std::move(project), std::string(fix_slashes.begin(), fix_slashes.end())};
+std::string DecodeArguments(const std::string& encoded) {
+  std::istringstream input(encoded);
+  BinaryReader reader(input);
+  std::ostringstream output;
+  while (input.peek() != std::char_traits<char>::eof()) {
+    switch (static_cast<ArgumentType>(reader.ReadInteger(1))) {
+      case ArgumentType::kString:
+        output << reader.ReadSizedString();
+        break;
+      case ArgumentType::kSigned:
+        output << static_cast<int64_t>(reader.ReadInteger(8));
+        break;
+      case ArgumentType::kUnsigned:
+        output << reader.ReadInteger(8);
+        break;
+      case ArgumentType::kFloat: {
+        const uint64_t bits(reader.ReadInteger(8));
+        double value(0);
+        std::memcpy(&value, &bits, sizeof(value));
+        output << value;
+        break;
+      }
+      case ArgumentType::kBool:
+        output << (reader.ReadInteger(1) != 0);
+        break;
+      case ArgumentType::kChar:
+        output << static_cast<char>(reader.ReadInteger(1));
+        break;
+      default:
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
     }
   }
-  return boost::none;
+  return output.str();
+}
+
+// ======================================= LogMessage ==============================================
+bool LogMessage::Binary() { return Logging::Instance().Binary(); }
+
+LogMessage::FileInfo LogMessage::GetFileInfo() const {
+  auto file_info(GetProjectAndContractFile(file_));
+  if (file_info.first.empty())
+    file_info.first = "common";
+  const auto fix_slashes(file_info.second | boost::adaptors::replaced('\\', '/'));
+  return FileInfo{std::string(file_info.first.begin(), file_info.first.end()),
+                  std::string(fix_slashes.begin(), fix_slashes.end())};
 }
 
 void LogMessage::Log(const std::string& project, std::string message) const {
-  char log_level(' ');
-  Colour colour(Colour::kDefaultColour);
-  const int level(level_);
-  GetColourAndLevel(log_level, colour, level);
-  std::string coloured_log_entry(GetColouredLogEntry(log_level));
-  ColourMode colour_mode(Logging::Instance().Colour());
-#if defined(__GLIBCXX__)
-  //  && __GLIBCXX__ < date (date in format of 20141218 as the date of fix of COW string)
-  auto message_ptr(std::make_shared<std::string>(message.data(), message.size()));
-  auto coloured_log_entry_ptr(
-      std::make_shared<std::string>(coloured_log_entry.data(), coloured_log_entry.size()));
-  auto print_functor([level, colour, coloured_log_entry_ptr, message_ptr, colour_mode, project] {
-    SendToConsole(colour_mode, colour, level, *coloured_log_entry_ptr, *message_ptr);
-    Logging::Instance().WriteToCombinedLogfile(*coloured_log_entry_ptr + *message_ptr);
-    Logging::Instance().WriteToProjectLogfile(project, *coloured_log_entry_ptr + *message_ptr);
-  });
-#else
-  auto print_functor([level, colour, coloured_log_entry, message, colour_mode, project] {
-    SendToConsole(colour_mode, colour, level, coloured_log_entry, message);
-    Logging::Instance().WriteToCombinedLogfile(coloured_log_entry + message);
-    Logging::Instance().WriteToProjectLogfile(project, coloured_log_entry + message);
-  });
-#endif
-  Logging::Instance().Async() ? Logging::Instance().Send(print_functor) : print_functor();
+  LogRecord record;
+  record.level = level_;
+  record.time = CoarseSystemClock::now();
+  record.thread_id = std::this_thread::get_id();
+  record.project = project;
+  record.message = std::move(message);
+  if (Logging::Instance().Async())
+    QueueLogRecord(std::move(record));
+  else
+    WriteLogRecord(record, Logging::Instance().Colour());
+}
+
+void LogMessage::LogBinary(std::string arguments) const {
+  LogRecord record;
+  record.level = level_;
+  record.time = CoarseSystemClock::now();
+  record.thread_id = std::this_thread::get_id();
+  record.message = std::move(arguments);
+  record.binary = true;
+  record.file = file_;
+  record.line = line_;
+  if (Logging::Instance().Async())
+    QueueLogRecord(std::move(record));
+  else
+    WriteLogRecord(record, Logging::Instance().Colour());
+}
+
+void LogMessage::EncodeSuppressedCount(std::string& arguments) const {
+  const std::string note(" [" + std::to_string(suppressed_) + " similar messages suppressed]");
+  EncodeString(arguments, note.data(), note.size());
 }
 
 }  // namespace detail
@@ -522,18 +842,30 @@ Logging::Logging()
       filter_(),
       no_async_(false),
       no_log_to_console_(false),
+      binary_(false),
       start_time_(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())),
       log_folder_(),
       colour_mode_(ColourMode::kPartialLine),
       combined_logfile_stream_(),
       project_logfile_streams_(),
       visualiser_(),
-      background_() {
+      max_file_size_(0),
+      max_file_age_(0),
+      max_rotated_files_(0),
+      compressed_logfiles_(),
+      async_(false),
+      rotation_enabled_(false),
+      compressor_(),
+      compressor_started_(),
+      background_(),
+      background_started_() {
   // Force intialisation order to ensure g_console_mutex is available in Logging's destuctor.
   std::lock_guard<maidsafe::detail::Spinlock> lock(g_console_mutex());
   static_cast<void>(lock);
 }
 
+Logging::~Logging() { StopVisualiserShipper(); }
+
 Logging& Logging::Instance() {
   static Logging logging;
   return logging;
@@ -544,18 +876,21 @@ std::vector<std::vector<char>> Logging::Initialise(int argc, char** argv) {
   SetThisExecutablePath(argv);
   std::vector<std::vector<char>> unused_options;
   std::call_once(logging_initialised, [this, argc, argv, &unused_options]() {
+    StartupTimer startup_timer("logging");
     try {
       std::string config_file, log_folder;
       int colour_mode(-1);
       po::options_description log_config(
-          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, colour_mode));
+          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, binary_,
+                            colour_mode));
       ParseProgramOptions(log_config, config_file, argc, argv, log_variables_, unused_options);
       if (IsHelpOption(log_config))
         return;
 #if USE_LOGGING
-      background_ = maidsafe::make_unique<Active>();
+      async_ = !no_async_;
       DoCasts(colour_mode, log_folder, colour_mode_, log_folder_);
       HandleFilterOptions();
+      HandleRotationOptions();
       SetStreams();
 #endif
     } catch (const std::exception& e) {
@@ -570,18 +905,21 @@ std::vector<std::vector<wchar_t>> Logging::Initialise(int argc, wchar_t** argv)
   SetThisExecutablePath(argv);
   std::vector<std::vector<wchar_t>> unused_options;
   std::call_once(logging_initialised, [this, argc, argv, &unused_options]() {
+    StartupTimer startup_timer("logging");
     try {
       std::string config_file, log_folder;
       int colour_mode(-1);
       po::options_description log_config(
-          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, colour_mode));
+          SetProgramOptions(config_file, no_log_to_console_, log_folder, no_async_, binary_,
+                            colour_mode));
       ParseProgramOptions(log_config, config_file, argc, argv, log_variables_, unused_options);
       if (IsHelpOption(log_config))
         return;
 #if USE_LOGGING
-      background_ = maidsafe::make_unique<Active>();
+      async_ = !no_async_;
       DoCasts(colour_mode, log_folder, colour_mode_, log_folder_);
       HandleFilterOptions();
+      HandleRotationOptions();
       SetStreams();
 #endif
     } catch (const std::exception& e) {
@@ -598,20 +936,18 @@ void Logging::InitialiseVlog(const std::string& prefix, const std::string& sessi
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::already_initialised));
   std::call_once(visualiser_.initialised_once_flag, [&] {
     visualiser_.initialised = true;
-    visualiser_.prefix = prefix;
-    visualiser_.session_id = session_id;
-    if (visualiser_.session_id.empty())
+    visualiser_.prefix = std::make_shared<const std::string>(prefix);
+    visualiser_.session_id = std::make_shared<const std::string>(session_id);
+    if (session_id.empty())
       LOG(kWarning) << "VLOG messages disabled since Vlog Session ID is empty.";
-    visualiser_.logfile.stream.open(GetLogfileName("visualiser").c_str(), std::ios_base::trunc);
+    {
+      std::lock_guard<std::mutex> lock(visualiser_.logfile.mutex);
+      visualiser_.logfile.path = GetLogfileName("visualiser");
+    }
     visualiser_.server_name = server_name;
     visualiser_.server_port = server_port;
     visualiser_.server_dir = server_dir;
-    visualiser_.server_stream.connect(server_name,
-                                      std::to_string(static_cast<unsigned>(server_port)));
-    if (!visualiser_.server_stream) {
-      LOG(kError) << "Failed to connect to VLOG server: "
-                  << visualiser_.server_stream.error().message();
-    }
+    visualiser_.shipper = std::thread([this] { ShipVisualiserBatches(); });
   });
 }
 
@@ -642,6 +978,14 @@ void Logging::HandleFilterOptions() {
     if (itr != log_variables_.end())
       filter_[project] = GetLogLevel((*itr).second.as<std::string>());
   }
+  ++detail::CallSite::g_filter_generation;
+}
+
+void Logging::HandleRotationOptions() {
+  max_file_size_ = log_variables_["log_max_file_size"].as<uint64_t>() * 1024 * 1024;
+  max_file_age_ = std::chrono::minutes(log_variables_["log_max_file_age"].as<unsigned>());
+  max_rotated_files_ = log_variables_["log_max_rotated_files"].as<unsigned>();
+  rotation_enabled_ = max_file_size_ != 0 || max_file_age_.count() != 0;
 }
 
 fs::path Logging::GetLogfileName(const std::string& project) const {
@@ -656,20 +1000,119 @@ void Logging::SetStreams() {
   if (log_folder_.empty() || !SetupLogFolder(log_folder_))
     return;
 
+  if (binary_) {
+    std::lock_guard<std::mutex> lock(combined_logfile_stream_.mutex);
+    combined_logfile_stream_.path = GetLogfileName("combined");
+    combined_logfile_stream_.path.replace_extension(".bin");
+    combined_logfile_stream_.binary = true;
+    return;
+  }
+
   for (auto& entry : filter_) {
     auto log_file(make_unique<LogFile>());
-    log_file->stream.open(GetLogfileName(entry.first).c_str(), std::ios_base::trunc);
+    log_file->path = GetLogfileName(entry.first);
     project_logfile_streams_.insert(std::make_pair(entry.first, std::move(log_file)));
   }
 
   if (filter_.size() != 1) {
     std::lock_guard<std::mutex> lock(combined_logfile_stream_.mutex);
-    combined_logfile_stream_.stream.open(GetLogfileName("combined").c_str(), std::ios_base::trunc);
+    combined_logfile_stream_.path = GetLogfileName("combined");
+  }
+}
+
+void Logging::OpenLogfileLocked(LogFile& log_file) {
+  log_file.stream.open(log_file.path.c_str(), log_file.binary
+                                                  ? std::ios_base::trunc | std::ios_base::binary
+                                                  : std::ios_base::trunc);
+  log_file.bytes_written = 0;
+  log_file.opened = std::chrono::steady_clock::now();
+  log_file.call_site_ids.clear();
+  if (log_file.binary) {
+    log_file.stream.write(kBinaryLogMagic, sizeof(kBinaryLogMagic) - 1);
+    log_file.bytes_written = sizeof(kBinaryLogMagic) - 1;
+  }
+}
+
+bool Logging::EnsureOpenLocked(LogFile& log_file) {
+  if (!log_file.stream.is_open() && !log_file.path.empty() && log_file.stream.good())
+    OpenLogfileLocked(log_file);
+  return log_file.stream.is_open() && log_file.stream.good();
+}
+
+void Logging::RotateIfDueLocked(LogFile& log_file) {
+  if (!rotation_enabled_ || log_file.path.empty())
+    return;
+  const bool too_big(max_file_size_ != 0 && log_file.bytes_written >= max_file_size_);
+  const bool too_old(max_file_age_.count() != 0 &&
+                     std::chrono::steady_clock::now() - log_file.opened >= max_file_age_);
+  if (!too_big && !too_old)
+    return;
+
+  log_file.stream.close();
+  fs::path rotated(log_file.path);
+  rotated += "." + std::to_string(++log_file.rotation_count);
+  boost::system::error_code ec;
+  fs::rename(log_file.path, rotated, ec);
+  log_file.stream.clear();
+  if (ec) {
+    std::cout << "Failed to rotate logfile " << log_file.path << ": " << ec.message() << '\n';
+    // Carry on appending to the existing file (and, for a binary one, with its existing call site
+    // definitions), and don't retry until it's next due.
+    --log_file.rotation_count;
+    log_file.stream.open(log_file.path.c_str(), log_file.binary
+                                                    ? std::ios_base::app | std::ios_base::binary
+                                                    : std::ios_base::app);
+    log_file.bytes_written = 0;
+    log_file.opened = std::chrono::steady_clock::now();
+    return;
+  }
+  OpenLogfileLocked(log_file);
+  const fs::path original(log_file.path);
+  std::call_once(compressor_started_, [this] { compressor_ = maidsafe::make_unique<Active>(); });
+  compressor_->Send([this, original, rotated] { CompressRotatedLogfile(original, rotated); });
+}
+
+void Logging::CompressRotatedLogfile(const fs::path& original, const fs::path& rotated) {
+  std::vector<byte> contents;
+  {
+    std::ifstream input(rotated.c_str(), std::ios_base::binary);
+    contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+  }
+  boost::system::error_code ec;
+  if (!contents.empty()) {
+    fs::path compressed(rotated);
+    compressed += ".gz";
+    try {
+      const crypto::CompressedText compressed_text(
+          crypto::Compress(crypto::UncompressedText(std::move(contents)), 6));
+      std::ofstream output(compressed.c_str(), std::ios_base::trunc | std::ios_base::binary);
+      output.write(reinterpret_cast<const char*>(compressed_text->data()),
+                   compressed_text->size());
+      if (!output) {
+        std::cout << "Failed to write compressed logfile " << compressed << '\n';
+        return;
+      }
+    } catch (const std::exception& e) {
+      std::cout << "Failed to compress logfile " << rotated << ": "
+                << boost::diagnostic_information(e) << '\n';
+      return;
+    }
+    auto& compressed_files(compressed_logfiles_[original]);
+    compressed_files.push_back(compressed);
+    while (max_rotated_files_ != 0 && compressed_files.size() > max_rotated_files_) {
+      fs::remove(compressed_files.front(), ec);
+      compressed_files.pop_front();
+    }
   }
+  fs::remove(rotated, ec);
 }
 
 void Logging::Send(std::function<void()> message_functor) {
 #if USE_LOGGING
+  std::call_once(background_started_, [this] {
+    StartupTimer startup_timer("logging thread");
+    background_ = maidsafe::make_unique<Active>();
+  });
   background_->Send(message_functor);
 #else
   message_functor();
@@ -678,9 +1121,11 @@ void Logging::Send(std::function<void()> message_functor) {
 
 void Logging::WriteToLogfile(const std::string& message, LogFile& log_file) {
   std::lock_guard<std::mutex> lock(log_file.mutex);
-  if (log_file.stream.good()) {
+  if (EnsureOpenLocked(log_file)) {
     log_file.stream.write(message.c_str(), message.size());
     log_file.stream.flush();
+    log_file.bytes_written += message.size();
+    RotateIfDueLocked(log_file);
   }
 }
 
@@ -693,45 +1138,144 @@ void Logging::WriteToVisualiserLogfile(const std::string& message) {
 }
 
 void Logging::WriteToVisualiserServer(const std::string& message) {
+  std::size_t queued{0};
+  {
+    std::lock_guard<std::mutex> lock(visualiser_.batch_mutex);
+    if (visualiser_.stop_shipping || visualiser_.batch.size() >= kVisualiserMaxQueued) {
+      ++visualiser_.dropped_count;
+      return;
+    }
+    visualiser_.batch.push_back(message);
+    queued = visualiser_.batch.size();
+  }
+  if (queued == kVisualiserBatchSize)
+    visualiser_.batch_cond_var.notify_one();
+}
+
+void Logging::ShipVisualiserBatches() {
+  std::vector<std::string> messages;
+  uint64_t reported_dropped_count{0};
+  std::unique_lock<std::mutex> lock(visualiser_.batch_mutex);
+  for (;;) {
+    visualiser_.batch_cond_var.wait_for(lock, kVisualiserShipInterval, [&] {
+      return visualiser_.stop_shipping || visualiser_.batch.size() >= kVisualiserBatchSize;
+    });
+    const bool stopping(visualiser_.stop_shipping);
+    messages.swap(visualiser_.batch);
+    lock.unlock();
+
+    if (!messages.empty())
+      PostToVisualiserServer(messages);
+    messages.clear();
+    const uint64_t dropped_count(visualiser_.dropped_count);
+    // Once stopping, 'this' may be the Logging instance being destroyed, so don't LOG.
+    if (!stopping && dropped_count != reported_dropped_count) {
+      LOG(kWarning) << "Dropped " << dropped_count - reported_dropped_count << " VLOG messages.";
+      reported_dropped_count = dropped_count;
+    }
+    if (stopping)
+      return;
+    lock.lock();
+  }
+}
+
+bool Logging::ConnectToVisualiserServer() {
+  if (visualiser_.server_connected)
+    return true;
+  // Don't hammer an unreachable server; messages shipped before the next attempt are dropped.
+  const auto now(std::chrono::steady_clock::now());
+  if (now < visualiser_.next_connect_attempt)
+    return false;
+  visualiser_.server_stream.clear();
+  visualiser_.server_stream.connect(
+      visualiser_.server_name, std::to_string(static_cast<unsigned>(visualiser_.server_port)));
   if (!visualiser_.server_stream) {
-    visualiser_.server_stream.clear();
-    visualiser_.server_stream.connect(
-        visualiser_.server_name, std::to_string(static_cast<unsigned>(visualiser_.server_port)));
-    if (!visualiser_.server_stream) {
-      LOG(kError) << "Failed to re-connect to VLOG server: "
+    if (!visualiser_.stop_shipping) {
+      LOG(kError) << "Failed to connect to VLOG server: "
                   << visualiser_.server_stream.error().message();
-      return;
     }
+    visualiser_.next_connect_attempt = now + kVisualiserReconnectInterval;
+    return false;
+  }
+  visualiser_.server_connected = true;
+  return true;
+}
+
+void Logging::PostToVisualiserServer(const std::vector<std::string>& messages) {
+  if (!ConnectToVisualiserServer()) {
+    visualiser_.dropped_count += messages.size();
+    return;
   }
 
-  visualiser_.server_stream << "POST " << visualiser_.server_dir << " HTTP/1.1\r\n"
-                            << "Host: " << visualiser_.server_name << ':' << visualiser_.server_port
-                            << "\r\n"
-                            << "Content-Type: application/json\r\n"
-                            << "Content-Length: " << std::to_string(message.size()) << "\r\n"
-                            << "\r\n" << message << "\r\n" << std::flush;
-  auto read_response([&](char delimiter) -> std::string {
-    std::string response;
-    if (!std::getline(visualiser_.server_stream, response, delimiter)) {
-      LOG(kWarning) << "Failed to read VLOG server response.";
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+  // Pipeline the whole batch, then read the responses.
+  for (const auto& message : messages) {
+    visualiser_.server_stream << "POST " << visualiser_.server_dir << " HTTP/1.1\r\n"
+                              << "Host: " << visualiser_.server_name << ':'
+                              << visualiser_.server_port << "\r\n"
+                              << "Content-Type: application/json\r\n"
+                              << "Content-Length: " << std::to_string(message.size()) << "\r\n"
+                              << "\r\n" << message << "\r\n";
+  }
+  visualiser_.server_stream << std::flush;
+  if (!visualiser_.server_stream) {
+    if (!visualiser_.stop_shipping) {
+      LOG(kWarning) << "Failed to send VLOG messages: "
+                    << visualiser_.server_stream.error().message();
     }
-    return response;
-  });
-  try {
-    read_response(' ');  // "HTTP/1.1"
-    unsigned http_code{static_cast<unsigned>(std::stoul(read_response(' ')))};
-    if (http_code != 200) {
-      std::string http_code_message{read_response('\r')};
-      LOG(kWarning) << "VLOG server responded with \"" << http_code << ": " << http_code_message
-                    << "\" to request \"" << message << "\"";
+    visualiser_.dropped_count += messages.size();
+    visualiser_.server_stream.close();
+    visualiser_.server_connected = false;
+    return;
+  }
+
+  for (const auto& message : messages) {
+    try {
+      const auto response(ReadHttpResponse(visualiser_.server_stream));
+      if (response.first != 200 && !visualiser_.stop_shipping) {
+        LOG(kWarning) << "VLOG server responded with \"" << response.first << ": "
+                      << response.second << "\" to request \"" << message << "\"";
+      }
+    } catch (const std::exception&) {
+      if (!visualiser_.stop_shipping)
+        LOG(kWarning) << "Failed to read VLOG server response.";
+      // The connection is unusable now, so the next batch will reconnect.
+      visualiser_.server_stream.close();
+      visualiser_.server_connected = false;
+      return;
     }
-  } catch (const std::exception& e) {
-    LOG(kWarning) << e.what();
   }
-  std::array<char, 100> discarded;
-  while (visualiser_.server_stream.readsome(&discarded[0], discarded.size())) {
+}
+
+void Logging::StopVisualiserShipper() {
+  {
+    std::lock_guard<std::mutex> lock(visualiser_.batch_mutex);
+    visualiser_.stop_shipping = true;
+  }
+  visualiser_.batch_cond_var.notify_one();
+  if (visualiser_.shipper.joinable())
+    visualiser_.shipper.join();
+}
+
+void Logging::WriteToBinaryLogfile(const char* file, int line, int level,
+                                   const std::string& record) {
+  std::lock_guard<std::mutex> lock(combined_logfile_stream_.mutex);
+  LogFile& log_file(combined_logfile_stream_);
+  if (!EnsureOpenLocked(log_file))
+    return;
+  const auto inserted(log_file.call_site_ids.insert(
+      std::make_pair(std::make_pair(file, line), static_cast<uint32_t>(0))));
+  if (inserted.second) {
+    inserted.first->second = static_cast<uint32_t>(log_file.call_site_ids.size());
+    const std::string definition(EncodeCallSite(inserted.first->second, file, line, level));
+    log_file.stream.write(definition.data(), definition.size());
   }
+  std::string header(1, kMessageRecord);
+  AppendInteger(header, inserted.first->second, 4);
+  log_file.stream.write(header.data(), header.size());
+  log_file.stream.write(record.data(), record.size());
+  log_file.stream.flush();
+  log_file.bytes_written += header.size() + record.size();
+  RotateIfDueLocked(log_file);
 }
 
 void Logging::WriteToProjectLogfile(const std::string& project, const std::string& message) {
@@ -749,23 +1293,84 @@ void Logging::Flush() {
   combined_logfile_stream_.stream.flush();
 }
 
-std::string Logging::VlogPrefix() const {
+std::string Logging::VlogPrefix() const { return *SharedVlogPrefix(); }
+
+std::string Logging::VlogSessionId() const { return *SharedVlogSessionId(); }
+
+std::shared_ptr<const std::string> Logging::SharedVlogPrefix() const {
   if (!visualiser_.initialised)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
   return visualiser_.prefix;
 }
 
-std::string Logging::VlogSessionId() const {
+std::shared_ptr<const std::string> Logging::SharedVlogSessionId() const {
   if (!visualiser_.initialised)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
   return visualiser_.session_id;
 }
 
+void DecodeBinaryLog(std::istream& input, std::ostream& output) {
+  std::string magic(sizeof(kBinaryLogMagic) - 1, 0);
+  if (!input.read(&magic[0], magic.size()) || magic != kBinaryLogMagic)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+
+  struct CallSiteInfo {
+    int level, line;
+    std::string contract_file;
+  };
+  std::map<uint32_t, CallSiteInfo> call_sites;
+  BinaryReader reader(input);
+  for (;;) {
+    const int type(input.get());
+    if (type == std::char_traits<char>::eof())
+      return;
+    try {
+      if (type == kCallSiteRecord) {
+        const uint32_t id(static_cast<uint32_t>(reader.ReadInteger(4)));
+        CallSiteInfo info;
+        info.level = static_cast<int32_t>(static_cast<uint32_t>(reader.ReadInteger(4)));
+        info.line = static_cast<int>(reader.ReadInteger(4));
+        const std::string file(reader.ReadSizedString());
+        const auto contract_file(GetProjectAndContractFile(file).second |
+                                 boost::adaptors::replaced('\\', '/'));
+        info.contract_file.assign(contract_file.begin(), contract_file.end());
+        call_sites[id] = info;
+      } else if (type == kMessageRecord) {
+        const auto itr(call_sites.find(static_cast<uint32_t>(reader.ReadInteger(4))));
+        const std::chrono::nanoseconds since_epoch(static_cast<int64_t>(reader.ReadInteger(8)));
+        const uint64_t thread_hash(reader.ReadInteger(8));
+        const std::string arguments(reader.ReadSizedString());
+        if (itr == call_sites.end())
+          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+        char log_level(' ');
+        Colour colour(Colour::kDefaultColour);
+        GetColourAndLevel(log_level, colour, itr->second.level);
+        const std::chrono::system_clock::time_point time(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+        output << log_level << ' ' << thread_hash << ' ' << GetTime<TimeType::kUTC>(time) << ' '
+               << itr->second.contract_file << ':' << itr->second.line << "] "
+               << detail::DecodeArguments(arguments) << '\n';
+      } else {
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+      }
+    } catch (const maidsafe_error&) {
+      // A truncated final record is expected if the process didn't exit cleanly.
+      if (input.eof())
+        return;
+      throw;
+    }
+  }
+}
+
 namespace detail {
 
-std::string GetLocalTime() { return GetTime<TimeType::kLocal>(); }
+std::string GetLocalTime() { return GetTime<TimeType::kLocal>(std::chrono::system_clock::now()); }
 
-std::string GetUTCTime() { return GetTime<TimeType::kUTC>(); }
+std::string GetUTCTime() { return GetUTCTime(CoarseSystemClock::now()); }
+
+std::string GetUTCTime(std::chrono::system_clock::time_point time) {
+  return GetTime<TimeType::kUTC>(time);
+}
 
 }  // namespace detail
 
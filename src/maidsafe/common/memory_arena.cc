@@ -0,0 +1,250 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/memory_arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#ifdef MAIDSAFE_WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace {
+
+const size_t kMinBlockSize(64);
+const size_t kPageSize(4096);
+#ifdef __linux__
+// The default huge page size on x86-64 and most arm64 kernels.
+const size_t kHugePageSize(2 * 1024 * 1024);
+#endif
+
+size_t RoundUp(size_t size, size_t multiple) { return (size + multiple - 1) / multiple * multiple; }
+
+}  // unnamed namespace
+
+MemoryArena::MemoryArena(size_t capacity, PageSize page_size)
+    : mutex_(),
+      base_(nullptr),
+      capacity_(capacity),
+      next_(0),
+      free_lists_(),
+      stats_(),
+      allocation_(nullptr) {
+  if (capacity == 0) {
+    LOG(kError) << "Memory arena capacity must be non-zero.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  Map(page_size);
+  free_lists_.resize(ClassOf(capacity_) + 1, nullptr);
+  stats_.capacity = stats_.available = capacity_;
+}
+
+MemoryArena::~MemoryArena() { Unmap(); }
+
+#ifdef __linux__
+void MemoryArena::Map(PageSize page_size) {
+  const int kProtection(PROT_READ | PROT_WRITE), kFlags(MAP_PRIVATE | MAP_ANONYMOUS);
+  if (page_size == PageSize::kExplicitHuge) {
+    const size_t size(RoundUp(capacity_, kHugePageSize));
+    void* const mapped(
+        mmap(nullptr, size, kProtection, kFlags | MAP_HUGETLB | MAP_POPULATE, -1, 0));
+    if (mapped != MAP_FAILED) {
+      allocation_ = mapped;
+      base_ = static_cast<char*>(mapped);
+      capacity_ = size;
+      stats_.page_size = PageSize::kExplicitHuge;
+      return;
+    }
+    LOG(kInfo) << "No huge pages available for " << size << " byte memory arena ("
+               << std::strerror(errno) << "); using transparent huge pages.";
+    page_size = PageSize::kTransparentHuge;
+  }
+
+  if (page_size == PageSize::kDefault) {
+    const size_t size(RoundUp(capacity_, kPageSize));
+    void* const mapped(mmap(nullptr, size, kProtection, kFlags | MAP_POPULATE, -1, 0));
+    if (mapped == MAP_FAILED) {
+      LOG(kError) << "Failed to map " << size << " byte memory arena: " << std::strerror(errno);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+    }
+    allocation_ = mapped;
+    base_ = static_cast<char*>(mapped);
+    capacity_ = size;
+    stats_.page_size = PageSize::kDefault;
+    return;
+  }
+
+  // Transparent huge pages are only used for aligned 2 MiB ranges, so over-map to find an aligned
+  // start and unmap the excess either side.  The advice must be given before the pages are
+  // touched, so they're pre-faulted afterwards rather than via MAP_POPULATE.
+  const size_t size(RoundUp(capacity_, kHugePageSize));
+  void* const mapped(mmap(nullptr, size + kHugePageSize, kProtection, kFlags, -1, 0));
+  if (mapped == MAP_FAILED) {
+    LOG(kError) << "Failed to map " << size << " byte memory arena: " << std::strerror(errno);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  char* const start(static_cast<char*>(mapped));
+  char* const aligned(reinterpret_cast<char*>(
+      RoundUp(reinterpret_cast<std::uintptr_t>(start), kHugePageSize)));
+  if (aligned != start)
+    munmap(start, static_cast<size_t>(aligned - start));
+  const size_t tail(static_cast<size_t>(start + size + kHugePageSize - (aligned + size)));
+  if (tail != 0)
+    munmap(aligned + size, tail);
+  allocation_ = base_ = aligned;
+  capacity_ = size;
+  stats_.page_size = PageSize::kDefault;
+#ifdef MADV_HUGEPAGE
+  if (madvise(base_, capacity_, MADV_HUGEPAGE) == 0)
+    stats_.page_size = PageSize::kTransparentHuge;
+  else
+    LOG(kInfo) << "Transparent huge pages unavailable: " << std::strerror(errno);
+#endif
+  Prefault();
+}
+
+void MemoryArena::Unmap() { munmap(allocation_, capacity_); }
+
+#elif defined(MAIDSAFE_WIN32)
+void MemoryArena::Map(PageSize page_size) {
+  const SIZE_T large_page_size(GetLargePageMinimum());
+  if (page_size == PageSize::kExplicitHuge && large_page_size != 0) {
+    // Large pages are always resident, so need no pre-faulting.
+    const size_t size(RoundUp(capacity_, large_page_size));
+    allocation_ = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                               PAGE_READWRITE);
+    if (allocation_) {
+      base_ = static_cast<char*>(allocation_);
+      capacity_ = size;
+      stats_.page_size = PageSize::kExplicitHuge;
+      return;
+    }
+    LOG(kInfo) << "No large pages available for " << size << " byte memory arena (error "
+               << GetLastError() << ").";
+  }
+  capacity_ = RoundUp(capacity_, kPageSize);
+  allocation_ = VirtualAlloc(nullptr, capacity_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (!allocation_) {
+    LOG(kError) << "Failed to allocate " << capacity_ << " byte memory arena (error "
+                << GetLastError() << ").";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  base_ = static_cast<char*>(allocation_);
+  stats_.page_size = PageSize::kDefault;
+  Prefault();
+}
+
+void MemoryArena::Unmap() { VirtualFree(allocation_, 0, MEM_RELEASE); }
+
+#else
+void MemoryArena::Map(PageSize /*page_size*/) {
+  capacity_ = RoundUp(capacity_, kPageSize);
+  allocation_ = ::operator new(capacity_ + kMinBlockSize);
+  base_ = reinterpret_cast<char*>(
+      RoundUp(reinterpret_cast<std::uintptr_t>(allocation_), kMinBlockSize));
+  stats_.page_size = PageSize::kDefault;
+  Prefault();
+}
+
+void MemoryArena::Unmap() { ::operator delete(allocation_); }
+#endif
+
+void MemoryArena::Prefault() {
+  volatile char* const base(base_);
+  for (size_t offset(0); offset < capacity_; offset += kPageSize)
+    base[offset] = 0;
+}
+
+size_t MemoryArena::BlockSize(size_t size) {
+  size_t block_size(kMinBlockSize);
+  while (block_size < size)
+    block_size <<= 1;
+  return block_size;
+}
+
+size_t MemoryArena::ClassOf(size_t size) {
+  size_t index(0), block_size(kMinBlockSize);
+  while (block_size < size) {
+    block_size <<= 1;
+    ++index;
+  }
+  return index;
+}
+
+void* MemoryArena::Allocate(size_t size) {
+  if (size == 0 || size > capacity_)
+    return nullptr;
+  const size_t size_class(ClassOf(size)), block_size(BlockSize(size));
+  std::lock_guard<std::mutex> lock(mutex_);
+  void* block(nullptr);
+  if (size_class < free_lists_.size() && free_lists_[size_class]) {
+    FreeBlock* const free_block(free_lists_[size_class]);
+    free_lists_[size_class] = free_block->next;
+    block = free_block;
+  } else if (capacity_ - next_ >= block_size) {
+    block = base_ + next_;
+    next_ += block_size;
+  }
+  if (!block) {
+    ++stats_.failed_allocations;
+    return nullptr;
+  }
+  ++stats_.allocations;
+  stats_.in_use += block_size;
+  stats_.available -= block_size;
+  stats_.peak_in_use = std::max(stats_.peak_in_use, stats_.in_use);
+  return block;
+}
+
+void MemoryArena::Deallocate(void* block, size_t size) {
+  if (!block)
+    return;
+  assert(Owns(block));
+  const size_t size_class(ClassOf(size));
+  std::lock_guard<std::mutex> lock(mutex_);
+  FreeBlock* const free_block(static_cast<FreeBlock*>(block));
+  free_block->next = free_lists_[size_class];
+  free_lists_[size_class] = free_block;
+  stats_.in_use -= BlockSize(size);
+  stats_.available += BlockSize(size);
+}
+
+bool MemoryArena::Owns(const void* block) const {
+  const char* const address(static_cast<const char*>(block));
+  return address >= base_ && address < base_ + capacity_;
+}
+
+MemoryArena::Stats MemoryArena::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,236 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/memory_budget.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+MemoryBudget::Account::Account(MemoryBudget& budget, std::string name, int priority,
+                               ShrinkFunctor shrink, UsageFunctor usage)
+    : budget_(budget),
+      name_(std::move(name)),
+      priority_(priority),
+      shrink_(std::move(shrink)),
+      usage_functor_(std::move(usage)),
+      usage_(0) {}
+
+MemoryBudget::Account::~Account() {
+  budget_.usage_.fetch_sub(usage_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryBudget::Account::Charge(uint64_t bytes) {
+  usage_.fetch_add(bytes, std::memory_order_relaxed);
+  budget_.Charged(budget_.usage_.fetch_add(bytes, std::memory_order_relaxed) + bytes, bytes);
+}
+
+void MemoryBudget::Account::Release(uint64_t bytes) {
+  usage_.fetch_sub(bytes, std::memory_order_relaxed);
+  budget_.usage_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryBudget::Pressure MemoryBudget::Account::pressure() const { return budget_.pressure(); }
+
+void MemoryBudget::Account::Poll() {
+  if (!usage_functor_)
+    return;
+  const uint64_t current(usage_functor_());
+  const uint64_t previous(usage_.exchange(current, std::memory_order_relaxed));
+  if (current > previous)
+    budget_.usage_.fetch_add(current - previous, std::memory_order_relaxed);
+  else
+    budget_.usage_.fetch_sub(previous - current, std::memory_order_relaxed);
+}
+
+MemoryBudget::MemoryBudget(uint64_t limit, Options options)
+    : kOptions_(std::move(options)),
+      limit_(limit),
+      usage_(0),
+      rebalance_mutex_(),
+      mutex_(),
+      accounts_(),
+      shrinks_(0),
+      released_(0),
+      wake_mutex_(),
+      wake_(),
+      wake_requested_(false),
+      stopping_(false),
+      rebalancer_() {
+  if (!(kOptions_.moderate > 0.0 && kOptions_.moderate < kOptions_.high &&
+        kOptions_.high < kOptions_.critical && kOptions_.critical <= 1.0) ||
+      kOptions_.poll_interval < std::chrono::steady_clock::duration::zero()) {
+    LOG(kError) << "Invalid MemoryBudget options.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (kOptions_.poll_interval != std::chrono::steady_clock::duration::zero())
+    rebalancer_ = std::thread([this] { Run(); });
+}
+
+MemoryBudget::~MemoryBudget() {
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  if (rebalancer_.joinable())
+    rebalancer_.join();
+}
+
+MemoryBudget& MemoryBudget::Instance() {
+  static MemoryBudget* const budget(new MemoryBudget(0));
+  return *budget;
+}
+
+std::shared_ptr<MemoryBudget::Account> MemoryBudget::Register(std::string name, int priority,
+                                                              ShrinkFunctor shrink,
+                                                              UsageFunctor usage) {
+  std::shared_ptr<Account> account(
+      new Account(*this, std::move(name), priority, std::move(shrink), std::move(usage)));
+  account->Poll();
+  std::lock_guard<std::mutex> lock(mutex_);
+  accounts_.push_back(account);
+  return account;
+}
+
+void MemoryBudget::SetLimit(uint64_t limit) {
+  limit_.store(limit, std::memory_order_relaxed);
+  if (pressure() < Pressure::kHigh)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_requested_ = true;
+  }
+  wake_.notify_one();
+}
+
+MemoryBudget::Pressure MemoryBudget::PressureAt(uint64_t usage) const {
+  const uint64_t limit(limit_.load(std::memory_order_relaxed));
+  if (limit == 0)
+    return Pressure::kNone;
+  const double fraction(static_cast<double>(usage) / static_cast<double>(limit));
+  if (fraction >= kOptions_.critical)
+    return Pressure::kCritical;
+  if (fraction >= kOptions_.high)
+    return Pressure::kHigh;
+  if (fraction >= kOptions_.moderate)
+    return Pressure::kModerate;
+  return Pressure::kNone;
+}
+
+void MemoryBudget::Charged(uint64_t usage, uint64_t bytes) {
+  // Only a charge which crosses into kHigh wakes the background thread; its polling catches any
+  // pressure which persists.
+  if (!rebalancer_.joinable() || PressureAt(usage) < Pressure::kHigh ||
+      PressureAt(usage - bytes) >= Pressure::kHigh) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_requested_ = true;
+  }
+  wake_.notify_one();
+}
+
+uint64_t MemoryBudget::Rebalance() {
+  std::lock_guard<std::mutex> rebalance_lock(rebalance_mutex_);
+  std::vector<std::shared_ptr<Account>> accounts;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accounts_.erase(std::remove_if(std::begin(accounts_), std::end(accounts_),
+                                   [](const std::weak_ptr<Account>& account) {
+                                     return account.expired();
+                                   }),
+                    std::end(accounts_));
+    for (const auto& weak_account : accounts_) {
+      if (auto account = weak_account.lock())
+        accounts.push_back(std::move(account));
+    }
+  }
+  for (const auto& account : accounts)
+    account->Poll();
+  if (pressure() < Pressure::kHigh)
+    return 0;
+
+  std::stable_sort(std::begin(accounts), std::end(accounts),
+                   [](const std::shared_ptr<Account>& lhs, const std::shared_ptr<Account>& rhs) {
+                     return lhs->priority_ < rhs->priority_;
+                   });
+  const auto target(static_cast<uint64_t>(static_cast<double>(limit()) * kOptions_.moderate));
+  uint64_t released(0), shrinks(0);
+  for (const auto& account : accounts) {
+    const uint64_t current(usage());
+    if (current <= target)
+      break;
+    if (!account->shrink_)
+      continue;
+    try {
+      released += account->shrink_(current - target, PressureAt(current));
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to shrink " << account->name_ << ": "
+                  << boost::diagnostic_information(e);
+    }
+    ++shrinks;
+    account->Poll();
+  }
+  if (pressure() >= Pressure::kHigh) {
+    LOG_RATE_LIMITED(kWarning, 1) << "Memory usage of " << usage() << " bytes remains above "
+                                  << kOptions_.high << " of the " << limit() << " byte budget.";
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shrinks_ += shrinks;
+  released_ += released;
+  return released;
+}
+
+MemoryBudget::Stats MemoryBudget::stats() const {
+  Stats result;
+  result.limit = limit();
+  result.usage = usage();
+  result.pressure = PressureAt(result.usage);
+  std::lock_guard<std::mutex> lock(mutex_);
+  result.shrinks = shrinks_;
+  result.released = released_;
+  for (const auto& weak_account : accounts_) {
+    if (auto account = weak_account.lock())
+      result.accounts.emplace_back(account->name_, account->usage());
+  }
+  return result;
+}
+
+void MemoryBudget::Run() {
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, kOptions_.poll_interval, [this] { return wake_requested_ || stopping_; });
+    if (stopping_)
+      return;
+    wake_requested_ = false;
+    lock.unlock();
+    Rebalance();
+    lock.lock();
+  }
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,404 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <tuple>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/make_unique.h"
+
+#ifdef _MSC_VER
+#define MAIDSAFE_METRICS_THREAD_LOCAL __declspec(thread)
+#else
+#define MAIDSAFE_METRICS_THREAD_LOCAL __thread
+#endif
+
+namespace maidsafe {
+
+namespace metrics {
+
+namespace detail {
+
+namespace {
+
+// One more than the calling thread's shard, or 0 if it hasn't been assigned yet.
+MAIDSAFE_METRICS_THREAD_LOCAL size_t g_thread_shard(0);
+
+}  // unnamed namespace
+
+size_t ThisThreadShard() {
+  if (g_thread_shard == 0) {
+    // Successive threads are given successive shards, so up to kShardCount threads never share.
+    static std::atomic<size_t> next_shard(0);
+    g_thread_shard = (next_shard++ & (kShardCount - 1)) + 1;
+  }
+  return g_thread_shard - 1;
+}
+
+}  // namespace detail
+
+namespace {
+
+bool IsValidName(const std::string& name, bool allow_colon) {
+  if (name.empty())
+    return false;
+  for (size_t i(0); i != name.size(); ++i) {
+    const char c(name[i]);
+    const bool valid((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+                     (allow_colon && c == ':') || (i != 0 && c >= '0' && c <= '9'));
+    if (!valid)
+      return false;
+  }
+  return true;
+}
+
+void UpdateMax(std::atomic<uint64_t>& max, uint64_t value) {
+  uint64_t current(max.load(std::memory_order_relaxed));
+  while (value > current &&
+         !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+// Escapes a label value or (if 'is_help') a HELP string for the Prometheus text format.
+std::string Escape(const std::string& text, bool is_help) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char c : text) {
+    if (c == '\\')
+      escaped += "\\\\";
+    else if (c == '\n')
+      escaped += "\\n";
+    else if (c == '"' && !is_help)
+      escaped += "\\\"";
+    else
+      escaped += c;
+  }
+  return escaped;
+}
+
+// Renders '{name="value",...}', with 'extra' (if not empty) appended as a further label.
+std::string LabelText(const Labels& labels, const std::string& extra = std::string()) {
+  if (labels.empty() && extra.empty())
+    return std::string();
+  std::string text("{");
+  for (const auto& label : labels)
+    text += label.first + "=\"" + Escape(label.second, false) + "\",";
+  if (extra.empty())
+    text.back() = '}';
+  else
+    text += extra + '}';
+  return text;
+}
+
+const char* TypeName(MetricType type) {
+  switch (type) {
+    case MetricType::kCounter:
+      return "counter";
+    case MetricType::kGauge:
+      return "gauge";
+    default:
+      return "histogram";
+  }
+}
+
+}  // unnamed namespace
+
+uint64_t Counter::Value() const {
+  uint64_t total(0);
+  for (const auto& shard : shards_)
+    total += shard.value.load(std::memory_order_relaxed);
+  return total;
+}
+
+const size_t Histogram::kSubBucketBits;
+const size_t Histogram::kSubBucketCount;
+const size_t Histogram::kBucketCount;
+
+Histogram::Shard::Shard() : count(0), sum(0), max(0), pad() {
+  for (auto& bucket : buckets)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+Histogram::Histogram() : shards_(new Shard[detail::kShardCount]) {}
+
+void Histogram::Record(uint64_t value) {
+  Shard& shard(shards_[detail::ThisThreadShard()]);
+  shard.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  shard.count.fetch_add(1, std::memory_order_relaxed);
+  shard.sum.fetch_add(value, std::memory_order_relaxed);
+  UpdateMax(shard.max, value);
+}
+
+void Histogram::Record(std::chrono::steady_clock::duration duration) {
+  const auto micros(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  Record(static_cast<uint64_t>(std::max<decltype(micros)>(micros, 0)));
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  std::vector<uint64_t> counts(kBucketCount, 0);
+  for (size_t i(0); i != detail::kShardCount; ++i) {
+    const Shard& shard(shards_[i]);
+    for (size_t j(0); j != kBucketCount; ++j)
+      counts[j] += shard.buckets[j].load(std::memory_order_relaxed);
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    snapshot.max = std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+  }
+  // The count is taken from the buckets so that it's consistent with them.
+  for (size_t j(0); j != kBucketCount; ++j) {
+    if (counts[j] != 0) {
+      snapshot.buckets.emplace_back(BucketUpperBound(j), counts[j]);
+      snapshot.count += counts[j];
+    }
+  }
+  return snapshot;
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketCount)
+    return static_cast<size_t>(value);
+  // Position of the highest set bit, found by binary search.
+  size_t exponent(0);
+  for (size_t step(32); step != 0; step >>= 1) {
+    if ((value >> (exponent + step)) != 0)
+      exponent += step;
+  }
+  const size_t sub_bucket((value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1));
+  return (exponent - kSubBucketBits + 1) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t Histogram::BucketLowerBound(size_t index) {
+  if (index < kSubBucketCount)
+    return index;
+  const size_t exponent(index / kSubBucketCount + kSubBucketBits - 1);
+  const uint64_t sub_bucket(index % kSubBucketCount);
+  return (kSubBucketCount + sub_bucket) << (exponent - kSubBucketBits);
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+  return index + 1 == kBucketCount ? std::numeric_limits<uint64_t>::max()
+                                   : BucketLowerBound(index + 1) - 1;
+}
+
+uint64_t HistogramSnapshot::Quantile(double quantile) const {
+  if (count == 0)
+    return 0;
+  const auto rank(std::max<uint64_t>(static_cast<uint64_t>(std::ceil(quantile * count)), 1));
+  uint64_t seen(0);
+  for (const auto& bucket : buckets) {
+    seen += bucket.second;
+    if (seen >= rank)
+      return std::min(bucket.first, max);
+  }
+  return max;
+}
+
+struct Registry::Metric {
+  Metric(std::string name_in, std::string help_in, Labels labels_in, MetricType type_in)
+      : name(std::move(name_in)),
+        help(std::move(help_in)),
+        labels(std::move(labels_in)),
+        type(type_in),
+        counter(),
+        gauge(),
+        histogram() {
+    if (type == MetricType::kCounter)
+      counter = maidsafe::make_unique<Counter>();
+    else if (type == MetricType::kGauge)
+      gauge = maidsafe::make_unique<Gauge>();
+    else
+      histogram = maidsafe::make_unique<Histogram>();
+  }
+
+  const std::string name, help;
+  const Labels labels;
+  const MetricType type;
+  std::unique_ptr<Counter> counter;
+  std::unique_ptr<Gauge> gauge;
+  std::unique_ptr<Histogram> histogram;
+};
+
+Registry::Registry() : mutex_(), metrics_() {}
+
+Registry::~Registry() {}
+
+Registry& Registry::Global() {
+  // Deliberately leaked, so that metrics can still be updated during static destruction.
+  static Registry* const registry(new Registry);
+  return *registry;
+}
+
+Counter& Registry::GetCounter(const std::string& name, const std::string& help,
+                              const Labels& labels) {
+  return *GetMetric(name, help, labels, MetricType::kCounter).counter;
+}
+
+Gauge& Registry::GetGauge(const std::string& name, const std::string& help,
+                          const Labels& labels) {
+  return *GetMetric(name, help, labels, MetricType::kGauge).gauge;
+}
+
+Histogram& Registry::GetHistogram(const std::string& name, const std::string& help,
+                                  const Labels& labels) {
+  return *GetMetric(name, help, labels, MetricType::kHistogram).histogram;
+}
+
+Registry::Metric& Registry::GetMetric(const std::string& name, const std::string& help,
+                                      const Labels& labels, MetricType type) {
+  if (!IsValidName(name, true)) {
+    LOG(kError) << "Invalid metric name \"" << name << '"';
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  for (const auto& label : labels) {
+    if (!IsValidName(label.first, false) || label.first.compare(0, 2, "__") == 0 ||
+        (type == MetricType::kHistogram && label.first == "le")) {
+      LOG(kError) << "Invalid label name \"" << label.first << "\" for metric " << name;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& metric : metrics_) {
+    if (metric->name != name)
+      continue;
+    if (metric->type != type) {
+      LOG(kError) << "Metric " << name << " is already registered as a " << TypeName(metric->type);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    if (metric->labels == labels)
+      return *metric;
+  }
+  metrics_.push_back(maidsafe::make_unique<Metric>(name, help, labels, type));
+  return *metrics_.back();
+}
+
+Snapshot Registry::TakeSnapshot() const {
+  Snapshot snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot.reserve(metrics_.size());
+    for (const auto& metric : metrics_) {
+      MetricSnapshot metric_snapshot;
+      metric_snapshot.name = metric->name;
+      metric_snapshot.help = metric->help;
+      metric_snapshot.labels = metric->labels;
+      metric_snapshot.type = metric->type;
+      if (metric->type == MetricType::kCounter)
+        metric_snapshot.value = static_cast<int64_t>(metric->counter->Value());
+      else if (metric->type == MetricType::kGauge)
+        metric_snapshot.value = metric->gauge->Value();
+      else
+        metric_snapshot.histogram = metric->histogram->Snapshot();
+      snapshot.push_back(std::move(metric_snapshot));
+    }
+  }
+  std::stable_sort(snapshot.begin(), snapshot.end(),
+                   [](const MetricSnapshot& lhs, const MetricSnapshot& rhs) {
+                     return std::tie(lhs.name, lhs.labels) < std::tie(rhs.name, rhs.labels);
+                   });
+  return snapshot;
+}
+
+std::string ToPrometheusText(const Snapshot& snapshot) {
+  std::ostringstream text;
+  for (size_t i(0); i != snapshot.size(); ++i) {
+    const MetricSnapshot& metric(snapshot[i]);
+    // The HELP and TYPE lines are written once per name, ahead of all its label sets.
+    if (i == 0 || snapshot[i - 1].name != metric.name) {
+      text << "# HELP " << metric.name << ' ' << Escape(metric.help, true) << '\n'
+           << "# TYPE " << metric.name << ' ' << TypeName(metric.type) << '\n';
+    }
+    if (metric.type != MetricType::kHistogram) {
+      text << metric.name << LabelText(metric.labels) << ' ' << metric.value << '\n';
+      continue;
+    }
+    uint64_t cumulative(0);
+    for (const auto& bucket : metric.histogram.buckets) {
+      cumulative += bucket.second;
+      if (bucket.first == std::numeric_limits<uint64_t>::max())
+        break;  // covered by "+Inf"
+      text << metric.name << "_bucket"
+           << LabelText(metric.labels, "le=\"" + std::to_string(bucket.first) + '"') << ' '
+           << cumulative << '\n';
+    }
+    text << metric.name << "_bucket" << LabelText(metric.labels, "le=\"+Inf\"") << ' '
+         << metric.histogram.count << '\n'
+         << metric.name << "_sum" << LabelText(metric.labels) << ' ' << metric.histogram.sum
+         << '\n'
+         << metric.name << "_count" << LabelText(metric.labels) << ' ' << metric.histogram.count
+         << '\n';
+  }
+  return text.str();
+}
+
+std::string ToText(const Snapshot& snapshot) {
+  std::ostringstream text;
+  for (const auto& metric : snapshot) {
+    text << metric.name << LabelText(metric.labels);
+    if (metric.type != MetricType::kHistogram) {
+      text << ' ' << metric.value << '\n';
+      continue;
+    }
+    const HistogramSnapshot& histogram(metric.histogram);
+    text << " count=" << histogram.count << " mean=" << histogram.Mean()
+         << " p50=" << histogram.Quantile(0.5) << " p90=" << histogram.Quantile(0.9)
+         << " p99=" << histogram.Quantile(0.99) << " max=" << histogram.max << '\n';
+  }
+  return text.str();
+}
+
+LogExporter::LogExporter(const Registry& registry, std::chrono::milliseconds interval)
+    : registry_(registry),
+      interval_(interval),
+      mutex_(),
+      condition_(),
+      stopped_(false),
+      thread_() {
+  if (interval_ <= std::chrono::milliseconds(0))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  thread_ = std::thread([this] { Run(); });
+}
+
+LogExporter::~LogExporter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  condition_.notify_one();
+  thread_.join();
+}
+
+void LogExporter::Run() {
+  bool stopped(false);
+  while (!stopped) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stopped = condition_.wait_for(lock, interval_, [this] { return stopped_; });
+    }
+    LOG(kInfo) << "Metrics:\n" << ToText(registry_.TakeSnapshot());
+  }
+}
+
+}  // namespace metrics
+
+}  // namespace maidsafe
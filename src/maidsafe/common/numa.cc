@@ -0,0 +1,200 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/numa.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifdef MAIDSAFE_WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#endif
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace numa {
+
+namespace {
+
+#ifdef __linux__
+// Parses a sysfs CPU list such as "0-3,8-11".
+std::vector<unsigned> ParseCpuList(const std::string& list) {
+  std::vector<unsigned> cpus;
+  size_t position(0);
+  while (position < list.size()) {
+    size_t end(list.find(',', position));
+    if (end == std::string::npos)
+      end = list.size();
+    const std::string range(list.substr(position, end - position));
+    const size_t dash(range.find('-'));
+    if (!range.empty()) {
+      const unsigned first(static_cast<unsigned>(std::strtoul(range.c_str(), nullptr, 10)));
+      const unsigned last(dash == std::string::npos
+                              ? first
+                              : static_cast<unsigned>(
+                                    std::strtoul(range.c_str() + dash + 1, nullptr, 10)));
+      for (unsigned cpu(first); cpu <= last; ++cpu)
+        cpus.push_back(cpu);
+    }
+    position = end + 1;
+  }
+  return cpus;
+}
+
+std::vector<Node> ReadTopology() {
+  namespace fs = boost::filesystem;
+  std::vector<Node> nodes;
+  boost::system::error_code ec;
+  for (fs::directory_iterator itr(fs::path("/sys/devices/system/node"), ec), end;
+       !ec && itr != end; itr.increment(ec)) {
+    const std::string name(itr->path().filename().string());
+    if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+        name.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    std::ifstream cpu_list((itr->path() / "cpulist").string());
+    std::string list;
+    if (!std::getline(cpu_list, list))
+      continue;
+    Node node{static_cast<unsigned>(std::stoul(name.substr(4))), ParseCpuList(list)};
+    if (!node.cpus.empty())
+      nodes.push_back(std::move(node));
+  }
+  return nodes;
+}
+#elif defined(MAIDSAFE_WIN32)
+std::vector<Node> ReadTopology() {
+  std::vector<Node> nodes;
+  ULONG highest_node(0);
+  if (!GetNumaHighestNodeNumber(&highest_node))
+    return nodes;
+  for (ULONG id(0); id <= highest_node; ++id) {
+    ULONGLONG mask(0);
+    if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(id), &mask) || mask == 0)
+      continue;
+    Node node{static_cast<unsigned>(id), std::vector<unsigned>()};
+    for (unsigned cpu(0); cpu != 64; ++cpu) {
+      if (mask & (1ULL << cpu))
+        node.cpus.push_back(cpu);
+    }
+    nodes.push_back(std::move(node));
+  }
+  return nodes;
+}
+#else
+std::vector<Node> ReadTopology() { return std::vector<Node>(); }
+#endif
+
+std::vector<Node> LoadTopology() {
+  std::vector<Node> nodes(ReadTopology());
+  if (nodes.empty()) {
+    Node node{0, std::vector<unsigned>()};
+    for (unsigned cpu(0); cpu != std::max(std::thread::hardware_concurrency(), 1U); ++cpu)
+      node.cpus.push_back(cpu);
+    nodes.push_back(std::move(node));
+  }
+  std::sort(std::begin(nodes), std::end(nodes),
+            [](const Node& lhs, const Node& rhs) { return lhs.id < rhs.id; });
+  return nodes;
+}
+
+const Node* FindNode(unsigned id) {
+  for (const auto& node : Topology()) {
+    if (node.id == id)
+      return &node;
+  }
+  return nullptr;
+}
+
+}  // unnamed namespace
+
+const std::vector<Node>& Topology() {
+  static const std::vector<Node> nodes(LoadTopology());
+  return nodes;
+}
+
+size_t NodeCount() { return Topology().size(); }
+
+unsigned NodeOfCpu(unsigned cpu) {
+  for (const auto& node : Topology()) {
+    if (std::binary_search(std::begin(node.cpus), std::end(node.cpus), cpu))
+      return node.id;
+  }
+  return 0;
+}
+
+std::vector<unsigned> CpusByNode() {
+  std::vector<unsigned> cpus;
+  for (const auto& node : Topology())
+    cpus.insert(std::end(cpus), std::begin(node.cpus), std::end(node.cpus));
+  return cpus;
+}
+
+unsigned CurrentNode() {
+  if (NodeCount() == 1)
+    return Topology().front().id;
+#ifdef MAIDSAFE_WIN32
+  return NodeOfCpu(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+  const int cpu(sched_getcpu());
+  return cpu < 0 ? 0 : NodeOfCpu(static_cast<unsigned>(cpu));
+#else
+  return 0;
+#endif
+}
+
+bool BindCurrentThreadToNode(unsigned node) {
+  const Node* const found(FindNode(node));
+  if (!found)
+    return false;
+#ifdef MAIDSAFE_WIN32
+  DWORD_PTR mask(0);
+  for (const auto cpu : found->cpus) {
+    if (cpu < sizeof(DWORD_PTR) * 8)
+      mask |= static_cast<DWORD_PTR>(1) << cpu;
+  }
+  return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const auto cpu : found->cpus) {
+    if (cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &cpu_set);
+  }
+  const int result(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set));
+  if (result != 0)
+    LOG(kWarning) << "Failed to bind thread to NUMA node " << node << ": error " << result;
+  return result == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace numa
+
+}  // namespace maidsafe
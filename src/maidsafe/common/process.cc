@@ -18,11 +18,28 @@
 
 #include "maidsafe/common/process.h"
 
+#include <cerrno>
 #include <csignal>
 #include <iterator>
 #include <numeric>
 #include <type_traits>
+#include <utility>
 
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+#include <sys/syscall.h>
+#elif defined(MAIDSAFE_APPLE) || defined(MAIDSAFE_BSD)
+#include <sys/event.h>
+#endif
+
+#include "asio/error.hpp"
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
+#include "asio/strand.hpp"
+#ifdef MAIDSAFE_WIN32
+#include "asio/windows/object_handle.hpp"
+#else
+#include "asio/posix/stream_descriptor.hpp"
+#endif
 #include "boost/filesystem/operations.hpp"
 
 #include "maidsafe/common/config.h"
@@ -112,6 +129,148 @@ bool IsRunning(const ProcessInfo& process_info) {
 
 #endif
 
+// Once constructed, a watch is only used via its strand.
+struct ExitWatcher::Watch : std::enable_shared_from_this<Watch> {
+  Watch(asio::io_service& service_in, ExitHandler on_exit_in)
+      : strand(service_in),
+        on_exit(std::move(on_exit_in)),
+#ifdef MAIDSAFE_WIN32
+        handle(service_in),
+#else
+        descriptor(service_in),
+        pid(0),
+#endif
+        poll_timer(service_in) {}
+
+  void Finish(std::error_code ec) {
+    ExitHandler handler;
+    handler.swap(on_exit);
+    if (handler)
+      handler(ec);
+  }
+
+  void Wait() {
+    std::shared_ptr<Watch> this_ptr(shared_from_this());
+#ifdef MAIDSAFE_WIN32
+    handle.async_wait(
+        strand.wrap([this_ptr](const std::error_code& ec) { this_ptr->Finish(ec); }));
+#else
+    descriptor.async_wait(
+        asio::posix::stream_descriptor::wait_read,
+        strand.wrap([this_ptr](const std::error_code& ec) { this_ptr->Finish(ec); }));
+#endif
+  }
+
+  void Poll() {
+#ifndef MAIDSAFE_WIN32
+    try {
+      if (!IsRunning(pid))
+        return Finish(std::error_code());
+    } catch (const std::exception&) {
+      return Finish(make_error_code(CommonErrors::invalid_argument));
+    }
+    std::shared_ptr<Watch> this_ptr(shared_from_this());
+    poll_timer.expires_after(PollInterval());
+    poll_timer.async_wait(strand.wrap([this_ptr](const std::error_code& ec) {
+      if (ec)
+        return this_ptr->Finish(ec);
+      this_ptr->Poll();
+    }));
+#endif
+  }
+
+  void Close() {
+    std::error_code ignored_ec;
+#ifdef MAIDSAFE_WIN32
+    handle.close(ignored_ec);
+#else
+    descriptor.close(ignored_ec);
+#endif
+    poll_timer.cancel(ignored_ec);
+  }
+
+  asio::io_service::strand strand;
+  ExitHandler on_exit;
+#ifdef MAIDSAFE_WIN32
+  asio::windows::object_handle handle;
+#else
+  asio::posix::stream_descriptor descriptor;
+  pid_t pid;
+#endif
+  asio::steady_timer poll_timer;
+};
+
+ExitWatcher::ExitWatcher(asio::io_service& service, const ProcessInfo& process_info,
+                         ExitHandler on_exit)
+    : watch_(std::make_shared<Watch>(service, std::move(on_exit))) {
+#ifdef MAIDSAFE_WIN32
+  // The object handle closes its handle, so is given a duplicate.
+  HANDLE duplicate(nullptr);
+  if (!DuplicateHandle(GetCurrentProcess(), process_info.handle, GetCurrentProcess(), &duplicate,
+                       SYNCHRONIZE, FALSE, 0)) {
+    LOG(kError) << "Failed to duplicate process handle.  Windows error: " << GetLastError();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  watch_->handle.assign(duplicate);
+  watch_->Wait();
+#else
+  watch_->pid = process_info;
+  int fd(-1);
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+  fd = static_cast<int>(syscall(SYS_pidfd_open, process_info, 0));
+  // ENOSYS means the kernel predates pidfds, so polling is used instead.
+  if (fd < 0 && errno != ENOSYS) {
+    if (errno != ESRCH) {
+      LOG(kError) << "Failed to open pidfd for process " << process_info << ".  errno: " << errno;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+    std::shared_ptr<Watch> watch(watch_);
+    asio::post(watch->strand, [watch] { watch->Finish(std::error_code()); });
+    return;
+  }
+#elif defined(MAIDSAFE_APPLE) || defined(MAIDSAFE_BSD)
+  // The kqueue becomes readable once it holds the exit event.
+  fd = kqueue();
+  if (fd >= 0) {
+    struct kevent change;
+    EV_SET(&change, process_info, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+    if (kevent(fd, &change, 1, nullptr, 0, nullptr) != 0) {
+      const int error(errno);
+      close(fd);
+      if (error != ESRCH) {
+        LOG(kError) << "Failed to watch process " << process_info << ".  errno: " << error;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+      }
+      std::shared_ptr<Watch> watch(watch_);
+      asio::post(watch->strand, [watch] { watch->Finish(std::error_code()); });
+      return;
+    }
+  }
+#endif
+  if (fd >= 0) {
+    watch_->descriptor.assign(fd);
+    watch_->Wait();
+  } else {
+    std::shared_ptr<Watch> watch(watch_);
+    asio::post(watch->strand, [watch] { watch->Poll(); });
+  }
+#endif
+}
+
+ExitWatcher::~ExitWatcher() { Cancel(); }
+
+void ExitWatcher::Cancel() {
+  // Closing the handle or descriptor completes the wait with operation_aborted.
+  std::shared_ptr<Watch> watch(watch_);
+  asio::post(watch->strand, [watch] {
+    watch->Close();
+    watch->Finish(asio::error::operation_aborted);
+  });
+}
+
 boost::filesystem::path GetOtherExecutablePath(
     const boost::filesystem::path& name_without_extension) {
   return (ThisExecutableDir() / name_without_extension)
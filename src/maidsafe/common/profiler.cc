@@ -18,32 +18,221 @@
 
 #include "maidsafe/common/profiler.h"
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__GLIBC__)
+#define MAIDSAFE_PROFILER_SAMPLING
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <cstdio>
-#include <future>
 #include <iostream>
 #include <iterator>
+#include <new>
+#include <ostream>
+#include <thread>
+#include <utility>
 
 #include "boost/algorithm/string/replace.hpp"
+#include "boost/thread/tss.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/process.h"
 
-#include "maidsafe/common/log.h"
+#ifdef _MSC_VER
+#define MAIDSAFE_PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define MAIDSAFE_PROFILER_THREAD_LOCAL __thread
+#endif
 
 namespace maidsafe {
 
 namespace profile {
 
+namespace detail {
+
+// Updated by the replacement operator new below.  These are plain thread-local integers rather
+// than thread_specific_ptrs, since accessing the latter can itself allocate.
+std::atomic<bool> g_track_allocations(false);
+MAIDSAFE_PROFILER_THREAD_LOCAL uint64_t g_allocation_count(0);
+MAIDSAFE_PROFILER_THREAD_LOCAL uint64_t g_allocated_bytes(0);
+
+void* Allocate(std::size_t size, bool nothrow) {
+  if (g_track_allocations.load(std::memory_order_relaxed)) {
+    ++g_allocation_count;
+    g_allocated_bytes += size;
+  }
+  if (size == 0)
+    size = 1;
+  for (;;) {
+    void* const memory(std::malloc(size));
+    if (memory)
+      return memory;
+    std::new_handler handler(std::get_new_handler());
+    if (!handler) {
+      if (nothrow)
+        return nullptr;
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+// The call tree of a single thread.  Only that thread modifies it; 'mutex' is only contended while
+// the Profiler is merging results.
+struct ThreadProfile {
+  struct Node {
+    Node(const CallSite* call_site_in, uint32_t parent_in)
+        : call_site(call_site_in), parent(parent_in), children(), stats() {}
+    const CallSite* call_site;
+    uint32_t parent;
+    std::vector<uint32_t> children;
+    ProfileStats stats;
+  };
+
+  // A single timed scope, recorded while Profiler::Recording() is true.
+  struct Event {
+    Event(const CallSite* call_site_in, TscClock::time_point start_in,
+          std::chrono::steady_clock::duration duration_in)
+        : call_site(call_site_in), start(start_in), duration(duration_in) {}
+    const CallSite* call_site;
+    TscClock::time_point start;
+    std::chrono::steady_clock::duration duration;
+  };
+
+  explicit ThreadProfile(uint32_t index_in)
+      : mutex(),
+        nodes(1, Node(nullptr, 0)),
+        current(0),
+        index(index_in),
+        events(),
+        events_until_sample(1),
+        counter_fds(),
+        counters_opened(false) {
+    counter_fds.fill(-1);
+  }
+  ~ThreadProfile() { CloseCounters(); }
+
+  static ThreadProfile& Get();
+  // Returns the index of the child of 'current' for 'call_site', adding it if required.
+  uint32_t Child(const CallSite& call_site);
+  // Opens this thread's counters if not already attempted, returning true if they're open.
+  bool OpenCounters();
+  void CloseCounters();
+  bool ReadCounters(HardwareCounters& counters) const;
+
+  std::mutex mutex;
+  std::vector<Node> nodes;  // nodes[0] is the root.
+  uint32_t current;
+  const uint32_t index;  // Used as the thread ID in Chrome traces.
+  std::vector<Event> events;
+  uint32_t events_until_sample;
+  // perf_event file descriptors for cycles, instructions, cache misses and branch misses, with the
+  // first being the group leader.
+  std::array<int, 4> counter_fds;
+  bool counters_opened;
+};
+
+// Stacks sampled on a single registered thread.  The thread's SIGPROF handler is the only writer
+// and the sampling state's holder of 'mutex' the only reader, so the ring needs no lock.
+struct SampleBuffer {
+  static const size_t kMaxFrames = 32, kCapacity = 256;
+  struct Sample {
+    uint32_t depth;
+    std::array<void*, kMaxFrames> frames;
+  };
+
+  SampleBuffer() : samples(kCapacity), head(0), tail(0), dropped(0), timer_created(false) {}
+
+  std::vector<Sample> samples;
+  std::atomic<uint64_t> head, tail, dropped;
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+  pthread_t thread;
+  pid_t thread_id;
+  timer_t timer;
+#endif
+  bool timer_created;
+};
+
+const size_t SampleBuffer::kMaxFrames;
+const size_t SampleBuffer::kCapacity;
+
+// Only the SIGPROF handler reads this, so it needs no synchronisation beyond a signal fence.
+MAIDSAFE_PROFILER_THREAD_LOCAL SampleBuffer* g_sample_buffer(nullptr);
+
+struct SamplingState {
+  SamplingState()
+      : mutex(),
+        buffers(),
+        frequency(0),
+        handler_installed(false),
+        stacks(),
+        dropped(0),
+        names(),
+        collector_condition(),
+        stop_collector(false),
+        collector() {}
+  std::mutex mutex;
+  std::vector<std::shared_ptr<SampleBuffer>> buffers;
+  unsigned frequency;  // 0 while not sampling.
+  bool handler_installed;
+  // Drained samples, innermost frame first, and their counts.
+  std::map<std::vector<void*>, uint64_t> stacks;
+  // Dropped counts of buffers since unregistered.
+  uint64_t dropped;
+  std::map<void*, std::string> names;
+  std::condition_variable collector_condition;
+  bool stop_collector;
+  std::thread collector;
+};
+
+// Never destroyed, since registered threads (e.g. the logger's) can outlive the Profiler.
+SamplingState& Sampling() {
+  static SamplingState* const state(new SamplingState);
+  return *state;
+}
+
+}  // namespace detail
+
 namespace {
 
-std::string LocationToString(const ProfileEntry::Location& location) {
-  auto result(location.file);
+// The profile outlives its thread (until the Profiler is destroyed) but the counters needn't.
+void ReleaseThreadProfile(std::shared_ptr<detail::ThreadProfile>* thread_profile) {
+  (*thread_profile)->CloseCounters();
+  delete thread_profile;
+}
+
+// Keep outside the function to avoid lazy static init races on MSVC
+boost::thread_specific_ptr<std::shared_ptr<detail::ThreadProfile>> g_thread_profile(
+    ReleaseThreadProfile);
+
+std::string LocationToString(const CallSite& call_site) {
+  std::string result(call_site.file);
   boost::replace_all(result, "\\", "/");
   size_t position(result.rfind("maidsafe"));
   if (position != std::string::npos && position != 0)
     result = result.substr(position + 9);
-  result += ":" + std::to_string(location.line) + "] " + location.function;
+  result += ":" + std::to_string(call_site.line) + "] " + call_site.function;
   return result;
 }
 
-std::string DurationToString(const std::chrono::high_resolution_clock::duration& duration) {
+std::string DurationToString(const std::chrono::steady_clock::duration& duration) {
   long long nanos(  // NOLINT
       std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
   std::vector<char> buffer(21, 0);
@@ -51,118 +240,709 @@ std::string DurationToString(const std::chrono::high_resolution_clock::duration&
   return std::string(&buffer[0]);
 }
 
-void AppendInfo(
-    const std::pair<std::string, std::pair<uint64_t, std::chrono::high_resolution_clock::duration>>&
-        entry,
-    std::string& output) {
-  const auto& count(entry.second.first);
-  const auto& total_duration(entry.second.second);
-  output += entry.first + "\n  Called:                   " + std::to_string(count) + " times\n";
-  output += "  Average duration:  " + DurationToString(total_duration / count) + "\n";
-  output += "  Total duration:    " + DurationToString(total_duration) + "\n\n";
+void AppendInfo(const std::pair<const CallSite*, ProfileStats>& entry, std::string& output) {
+  const auto& histogram(entry.second.histogram);
+  output += LocationToString(*entry.first) + "\n  Called:                   " +
+            std::to_string(histogram.count) + " times\n";
+  output += "  Average duration:  " + DurationToString(histogram.Mean()) + "\n";
+  output += "  Minimum duration:  " + DurationToString(entry.second.min) + "\n";
+  output += "  Maximum duration:  " + DurationToString(histogram.max) + "\n";
+  output += "  50th percentile:  <" + DurationToString(histogram.Quantile(0.5)) + "\n";
+  output += "  99th percentile:  <" + DurationToString(histogram.Quantile(0.99)) + "\n";
+  output += "  Total duration:    " + DurationToString(histogram.total) + "\n";
+  const auto& counted_calls(entry.second.counted_calls);
+  if (counted_calls != 0) {
+    const auto& counters(entry.second.counters);
+    output += "  Per call (over " + std::to_string(counted_calls) + " counted calls):\n";
+    output += "    Cycles:                 " + std::to_string(counters.cycles / counted_calls) +
+              "\n";
+    output += "    Instructions:           " +
+              std::to_string(counters.instructions / counted_calls) + "\n";
+    output += "    Cache misses:           " +
+              std::to_string(counters.cache_misses / counted_calls) + "\n";
+    output += "    Branch misses:          " +
+              std::to_string(counters.branch_misses / counted_calls) + "\n";
+    if (counters.cycles != 0) {
+      output += "    Instructions per cycle: " +
+                std::to_string(static_cast<double>(counters.instructions) / counters.cycles) +
+                "\n";
+    }
+  }
+  const auto& tracked_calls(entry.second.tracked_calls);
+  if (tracked_calls != 0) {
+    output += "  Allocations per call:     " +
+              std::to_string(static_cast<double>(entry.second.allocations) / tracked_calls) +
+              " (" + std::to_string(entry.second.allocated_bytes / tracked_calls) + " bytes)\n";
+  }
+  output += "\n";
 }
 
-}  // unnamed namespace
+void AppendCallTree(const CallTreeNode& node, size_t depth, std::string& output) {
+  if (node.call_site) {
+    output += std::string(2 * depth, ' ') + LocationToString(*node.call_site) + "  (" +
+              std::to_string(node.stats.histogram.count) + " calls, total" +
+              DurationToString(node.stats.histogram.total) + ", average" +
+              DurationToString(node.stats.histogram.Mean()) + ")\n";
+    ++depth;
+  }
+  for (const auto& child : node.children)
+    AppendCallTree(child, depth, output);
+}
+
+void AddToCallTree(const std::vector<detail::ThreadProfile::Node>& nodes, uint32_t index,
+                   CallTreeNode& tree_node) {
+  tree_node.stats.Merge(nodes[index].stats);
+  for (const auto child_index : nodes[index].children) {
+    const CallSite* call_site(nodes[child_index].call_site);
+    auto itr(std::find_if(std::begin(tree_node.children), std::end(tree_node.children),
+                          [call_site](const CallTreeNode& child) {
+      return child.call_site == call_site;
+    }));
+    if (itr == std::end(tree_node.children)) {
+      tree_node.children.emplace_back();
+      itr = std::prev(std::end(tree_node.children));
+      itr->call_site = call_site;
+    }
+    AddToCallTree(nodes, child_index, *itr);
+  }
+}
+
+std::string JsonEscape(const std::string& input) {
+  std::string escaped;
+  escaped.reserve(input.size());
+  for (const char c : input) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+// Microseconds, as used for Chrome trace timestamps and durations.
+std::string ToMicroseconds(std::chrono::steady_clock::duration duration) {
+  const auto nanos(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  std::vector<char> buffer(32, 0);
+  std::sprintf(&buffer[0], "%lli.%03lli", static_cast<long long>(nanos / 1000),  // NOLINT
+               static_cast<long long>(nanos % 1000));                            // NOLINT
+  return std::string(&buffer[0]);
+}
+
+void AppendFoldedStacks(const CallTreeNode& node, const std::string& stack,
+                        std::ostream& output) {
+  std::string this_stack(stack);
+  if (node.call_site) {
+    std::string frame(LocationToString(*node.call_site));
+    std::replace(std::begin(frame), std::end(frame), ';', ':');
+    if (!this_stack.empty())
+      this_stack += ';';
+    this_stack += frame;
+    auto self_time(node.stats.histogram.total);
+    for (const auto& child : node.children)
+      self_time -= child.stats.histogram.total;
+    const auto micros(std::chrono::duration_cast<std::chrono::microseconds>(self_time).count());
+    if (micros > 0)
+      output << this_stack << ' ' << micros << '\n';
+  }
+  for (const auto& child : node.children)
+    AppendFoldedStacks(child, this_stack, output);
+}
+
+void AddToTotals(const CallTreeNode& node, std::map<const CallSite*, ProfileStats>& totals) {
+  if (node.call_site)
+    totals[node.call_site].Merge(node.stats);
+  for (const auto& child : node.children)
+    AddToTotals(child, totals);
+}
+
+// Moves the samples in 'buffer' into 'state.stacks'.  Must be called with 'state.mutex' held.
+void DrainSamples(detail::SampleBuffer& buffer, detail::SamplingState& state) {
+  // The handler's own frame and the signal trampoline are skipped.
+  const uint32_t kSkippedFrames(2);
+  const uint64_t head(buffer.head.load(std::memory_order_acquire));
+  uint64_t tail(buffer.tail.load(std::memory_order_relaxed));
+  for (; tail != head; ++tail) {
+    const auto& sample(buffer.samples[tail % detail::SampleBuffer::kCapacity]);
+    if (sample.depth <= kSkippedFrames)
+      continue;
+    std::vector<void*> stack(std::begin(sample.frames) + kSkippedFrames,
+                             std::begin(sample.frames) + sample.depth);
+    // Other than the interrupted one, frames hold return addresses, which can belong to the
+    // following function if the call was the last instruction.
+    for (size_t i(1); i < stack.size(); ++i)
+      stack[i] = static_cast<char*>(stack[i]) - 1;
+    ++state.stacks[std::move(stack)];
+  }
+  buffer.tail.store(tail, std::memory_order_release);
+}
+
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+
+void HandleSigprof(int, siginfo_t*, void*) {
+  const int saved_errno(errno);
+  detail::SampleBuffer* const buffer(detail::g_sample_buffer);
+  if (buffer) {
+    const uint64_t head(buffer->head.load(std::memory_order_relaxed));
+    if (head - buffer->tail.load(std::memory_order_acquire) == detail::SampleBuffer::kCapacity) {
+      buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      auto& sample(buffer->samples[head % detail::SampleBuffer::kCapacity]);
+      sample.depth = static_cast<uint32_t>(
+          backtrace(sample.frames.data(), static_cast<int>(detail::SampleBuffer::kMaxFrames)));
+      buffer->head.store(head + 1, std::memory_order_release);
+    }
+  }
+  errno = saved_errno;
+}
+
+bool InstallSigprofHandler() {
+  // backtrace loads libgcc on first use, which mustn't first happen within the handler.
+  void* frame(nullptr);
+  backtrace(&frame, 1);
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_sigaction = HandleSigprof;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  return sigaction(SIGPROF, &action, nullptr) == 0;
+}
+
+// Starts a timer delivering SIGPROF to the buffer's thread after each 1/'frequency' second of the
+// thread's CPU time.
+void StartTimer(detail::SampleBuffer& buffer, unsigned frequency) {
+  clockid_t clock;
+  if (pthread_getcpuclockid(buffer.thread, &clock) != 0)
+    return;
+  sigevent event;
+  std::memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event._sigev_un._tid = buffer.thread_id;
+  if (timer_create(clock, &event, &buffer.timer) != 0)
+    return;
+  const long interval(1000000000L / frequency);  // NOLINT
+  itimerspec spec;
+  spec.it_interval.tv_sec = interval / 1000000000L;
+  spec.it_interval.tv_nsec = interval % 1000000000L;
+  spec.it_value = spec.it_interval;
+  if (timer_settime(buffer.timer, 0, &spec, nullptr) != 0) {
+    timer_delete(buffer.timer);
+    return;
+  }
+  buffer.timer_created = true;
+}
 
-ProfileEntry::Location::Location(std::string file_in, int line_in, std::string function_in)
-    : file(std::move(file_in)), line(line_in), function(std::move(function_in)) {}
+void StopTimer(detail::SampleBuffer& buffer) {
+  if (buffer.timer_created)
+    timer_delete(buffer.timer);
+  buffer.timer_created = false;
+}
 
-ProfileEntry::Location::Location(const Location& other)
-    : file(other.file), line(other.line), function(other.function) {}
+std::string FrameName(void* address) {
+  Dl_info info;
+  if (dladdr(address, &info) != 0) {
+    if (info.dli_sname) {
+      int status(-1);
+      std::unique_ptr<char, void (*)(void*)> demangled(
+          abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), std::free);
+      return status == 0 && demangled ? demangled.get() : info.dli_sname;
+    }
+    if (info.dli_fname) {
+      std::string object(info.dli_fname);
+      std::vector<char> offset(32, 0);
+      std::sprintf(&offset[0], "+0x%llx",  // NOLINT
+                   static_cast<unsigned long long>(static_cast<char*>(address) -  // NOLINT
+                                                   static_cast<char*>(info.dli_fbase)));
+      return object.substr(object.rfind('/') + 1) + &offset[0];
+    }
+  }
+  std::vector<char> buffer(32, 0);
+  std::sprintf(&buffer[0], "0x%llx",  // NOLINT
+               static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));  // NOLINT
+  return std::string(&buffer[0]);
+}
 
-ProfileEntry::Location::Location(Location&& other)
-    : file(std::move(other.file)),
-      line(std::move(other.line)),
-      function(std::move(other.function)) {}
+#else
 
-ProfileEntry::Location& ProfileEntry::Location::operator=(Location other) {
-  swap(*this, other);
+std::string FrameName(void*) { return std::string(); }
+
+#endif
+
+// Drains all buffers and returns the sampled stacks in folded form.  Must be called with
+// 'state.mutex' held.
+std::map<std::string, uint64_t> FoldSampledStacks(detail::SamplingState& state) {
+  for (const auto& buffer : state.buffers)
+    DrainSamples(*buffer, state);
+  std::map<std::string, uint64_t> folded;
+  for (const auto& stack : state.stacks) {
+    std::string line;
+    for (auto itr(stack.first.rbegin()); itr != stack.first.rend(); ++itr) {
+      auto& name(state.names[*itr]);
+      if (name.empty()) {
+        name = FrameName(*itr);
+        std::replace(std::begin(name), std::end(name), ';', ':');
+      }
+      if (!line.empty())
+        line += ';';
+      line += name;
+    }
+    folded[line] += stack.second;
+  }
+  return folded;
+}
+
+}  // unnamed namespace
+
+HardwareCounters& HardwareCounters::operator+=(const HardwareCounters& other) {
+  cycles += other.cycles;
+  instructions += other.instructions;
+  cache_misses += other.cache_misses;
+  branch_misses += other.branch_misses;
   return *this;
 }
 
-void swap(ProfileEntry::Location& lhs, ProfileEntry::Location& rhs) {
-  using std::swap;
-  swap(lhs.file, rhs.file);
-  swap(lhs.line, rhs.line);
-  swap(lhs.function, rhs.function);
+void ProfileStats::Record(std::chrono::steady_clock::duration duration) {
+  if (histogram.count == 0 || duration < min)
+    min = duration;
+  histogram.Record(duration);
+}
+
+void ProfileStats::Merge(const ProfileStats& other) {
+  if (other.histogram.count == 0)
+    return;
+  if (histogram.count == 0 || other.min < min)
+    min = other.min;
+  histogram.Merge(other.histogram);
+  counters += other.counters;
+  counted_calls += other.counted_calls;
+  allocations += other.allocations;
+  allocated_bytes += other.allocated_bytes;
+  tracked_calls += other.tracked_calls;
 }
 
-bool operator<(const ProfileEntry::Location& lhs, const ProfileEntry::Location& rhs) {
-  return std::tie(lhs.file, lhs.line, lhs.function) < std::tie(rhs.file, rhs.line, rhs.function);
+namespace detail {
+
+ThreadProfile& ThreadProfile::Get() {
+  if (!g_thread_profile.get()) {
+    static std::atomic<uint32_t> next_index(0);
+    auto thread_profile(std::make_shared<ThreadProfile>(next_index++));
+    Profiler::Instance().Register(thread_profile);
+    g_thread_profile.reset(new std::shared_ptr<ThreadProfile>(std::move(thread_profile)));
+  }
+  return **g_thread_profile;
+}
+
+bool ThreadProfile::OpenCounters() {
+  if (counters_opened)
+    return counter_fds[0] != -1;
+  counters_opened = true;
+#ifdef __linux__
+  const std::array<uint64_t, 4> kConfigs{{PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                          PERF_COUNT_HW_CACHE_MISSES,
+                                          PERF_COUNT_HW_BRANCH_MISSES}};
+  for (size_t i(0); i != kConfigs.size(); ++i) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = kConfigs[i];
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP;
+    counter_fds[i] = static_cast<int>(
+        syscall(__NR_perf_event_open, &attributes, 0, -1, i == 0 ? -1 : counter_fds[0], 0));
+    if (counter_fds[i] == -1) {
+      CloseCounters();
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ThreadProfile::CloseCounters() {
+#ifdef __linux__
+  for (auto& fd : counter_fds) {
+    if (fd != -1)
+      close(fd);
+    fd = -1;
+  }
+#endif
+}
+
+bool ThreadProfile::ReadCounters(HardwareCounters& counters) const {
+#ifdef __linux__
+  // Layout given by PERF_FORMAT_GROUP: the number of counters, followed by their values.
+  std::array<uint64_t, 5> values;
+  if (read(counter_fds[0], &values[0], sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+    return false;
+  counters.cycles = values[1];
+  counters.instructions = values[2];
+  counters.cache_misses = values[3];
+  counters.branch_misses = values[4];
+  return true;
+#else
+  static_cast<void>(counters);
+  return false;
+#endif
+}
+
+uint32_t ThreadProfile::Child(const CallSite& call_site) {
+  for (const auto child : nodes[current].children) {
+    if (nodes[child].call_site == &call_site)
+      return child;
+  }
+  const auto child(static_cast<uint32_t>(nodes.size()));
+  nodes.emplace_back(&call_site, current);
+  nodes[current].children.push_back(child);
+  return child;
+}
+
+}  // namespace detail
+
+SampledThread::SampledThread() : buffer_(std::make_shared<detail::SampleBuffer>()) {
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+  buffer_->thread = pthread_self();
+  buffer_->thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+  detail::g_sample_buffer = buffer_.get();
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.buffers.push_back(buffer_);
+  if (state.frequency != 0)
+    StartTimer(*buffer_, state.frequency);
+#endif
+}
+
+SampledThread::~SampledThread() {
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  StopTimer(*buffer_);
+  // A signal already pending finds no buffer.
+  detail::g_sample_buffer = nullptr;
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  DrainSamples(*buffer_, state);
+  state.dropped += buffer_->dropped;
+  state.buffers.erase(std::remove(std::begin(state.buffers), std::end(state.buffers), buffer_),
+                      std::end(state.buffers));
+#endif
+}
+
+ProfileEntry::ProfileEntry(const CallSite& call_site)
+    : thread_profile_(detail::ThreadProfile::Get()),
+      node_([&]() -> uint32_t {
+        std::lock_guard<std::mutex> lock(thread_profile_.mutex);
+        return thread_profile_.current = thread_profile_.Child(call_site);
+      }()),
+      counting_(Profiler::Instance().hardware_counters_.load(std::memory_order_relaxed) &&
+                thread_profile_.OpenCounters()),
+      tracking_(detail::g_track_allocations.load(std::memory_order_relaxed)),
+      start_counters_(),
+      start_allocations_(detail::g_allocation_count),
+      start_allocated_bytes_(detail::g_allocated_bytes),
+      start_() {
+  if (counting_)
+    counting_ = thread_profile_.ReadCounters(start_counters_);
+  start_ = TscClock::now();
 }
 
 ProfileEntry::~ProfileEntry() {
-  Profiler::Instance().AddEntry(std::move(location),
-                                std::chrono::high_resolution_clock::now() - start);
+  const auto duration(TscClock::now() - start_);
+  const uint64_t allocations(detail::g_allocation_count - start_allocations_);
+  const uint64_t allocated_bytes(detail::g_allocated_bytes - start_allocated_bytes_);
+  HardwareCounters end_counters;
+  if (counting_)
+    counting_ = thread_profile_.ReadCounters(end_counters);
+  std::lock_guard<std::mutex> lock(thread_profile_.mutex);
+  auto& node(thread_profile_.nodes[node_]);
+  node.stats.Record(duration);
+  if (tracking_) {
+    node.stats.allocations += allocations;
+    node.stats.allocated_bytes += allocated_bytes;
+    ++node.stats.tracked_calls;
+  }
+  if (counting_) {
+    node.stats.counters.cycles += end_counters.cycles - start_counters_.cycles;
+    node.stats.counters.instructions += end_counters.instructions - start_counters_.instructions;
+    node.stats.counters.cache_misses += end_counters.cache_misses - start_counters_.cache_misses;
+    node.stats.counters.branch_misses +=
+        end_counters.branch_misses - start_counters_.branch_misses;
+    ++node.stats.counted_calls;
+  }
+  thread_profile_.current = node.parent;
+
+  Profiler& profiler(Profiler::Instance());
+  const uint32_t sample_interval(profiler.sample_interval_.load(std::memory_order_relaxed));
+  if (sample_interval != 0 && --thread_profile_.events_until_sample == 0) {
+    thread_profile_.events_until_sample = sample_interval;
+    if (thread_profile_.events.size() <
+        profiler.max_events_per_thread_.load(std::memory_order_relaxed)) {
+      thread_profile_.events.emplace_back(node.call_site, start_, duration);
+    }
+  }
 }
 
+Profiler::Profiler()
+    : kEpoch_(TscClock::now()),
+      sample_interval_(0),
+      max_events_per_thread_(0),
+      hardware_counters_(false),
+      mutex_(),
+      thread_profiles_() {}
+
 Profiler& Profiler::Instance() {
   static Profiler profiler;
   return profiler;
 }
 
-Profiler::~Profiler() {
-  std::cout << "Preparing profiler output";
-  auto output_future(std::async(
-      std::launch::async,
-      std::bind(static_cast<void (std::shared_ptr<Active>::*)()>(&std::shared_ptr<Active>::reset),
-                background_)));
-  background_.reset();
-  while (output_future.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
-    std::cout << '.';
+Profiler::~Profiler() { std::cout << Report() << "\n\n"; }
+
+void Profiler::Register(std::shared_ptr<detail::ThreadProfile> thread_profile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  thread_profiles_.push_back(std::move(thread_profile));
+}
+
+std::vector<std::shared_ptr<detail::ThreadProfile>> Profiler::ThreadProfiles() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return thread_profiles_;
+}
+
+CallTreeNode Profiler::CallTree() const {
+  CallTreeNode root;
+  for (const auto& thread_profile : ThreadProfiles()) {
+    std::vector<detail::ThreadProfile::Node> nodes;
+    {
+      std::lock_guard<std::mutex> lock(thread_profile->mutex);
+      nodes = thread_profile->nodes;
+    }
+    AddToCallTree(nodes, 0, root);
   }
+  return root;
+}
+
+std::map<const CallSite*, ProfileStats> Profiler::Totals() const {
+  std::map<const CallSite*, ProfileStats> totals;
+  AddToTotals(CallTree(), totals);
+  return totals;
+}
+
+std::string Profiler::Report() const {
+  const CallTreeNode call_tree(CallTree());
+  std::map<const CallSite*, ProfileStats> totals;
+  AddToTotals(call_tree, totals);
+
+  typedef std::vector<std::pair<const CallSite*, ProfileStats>> Entries;
+  Entries entries(std::begin(totals), std::end(totals));
   std::string output("\nSorted by name\n==============\n\n");
-  for (const auto& entry : entries_)
+  std::sort(std::begin(entries), std::end(entries),
+            [](const Entries::value_type& lhs, const Entries::value_type& rhs) {
+    return LocationToString(*lhs.first) < LocationToString(*rhs.first);
+  });
+  for (const auto& entry : entries)
     AppendInfo(entry, output);
-  std::cout << output << "\n\n";
 
-  typedef std::vector<std::pair<std::string, EntryDetails>> Entries;
-  Entries entries(std::begin(entries_), std::end(entries_));
-  entries_.clear();
-
-  output.assign("\nSorted by call count\n====================\n\n");
+  output += "\n\nSorted by call count\n====================\n\n";
   std::sort(std::begin(entries), std::end(entries),
             [](const Entries::value_type& lhs, const Entries::value_type& rhs) {
-    return lhs.second.first > rhs.second.first;
+    return lhs.second.histogram.count > rhs.second.histogram.count;
   });
   for (const auto& entry : entries)
     AppendInfo(entry, output);
-  std::cout << output << "\n\n";
 
-  output.assign("\nSorted by average duration\n==========================\n\n");
+  output += "\n\nSorted by average duration\n==========================\n\n";
   std::sort(std::begin(entries), std::end(entries),
             [](const Entries::value_type& lhs, const Entries::value_type& rhs) {
-    return lhs.second.second / lhs.second.first > rhs.second.second / rhs.second.first;
+    return lhs.second.histogram.Mean() > rhs.second.histogram.Mean();
   });
   for (const auto& entry : entries)
     AppendInfo(entry, output);
-  std::cout << output << "\n\n";
 
-  output.assign("\nSorted by total duration\n========================\n\n");
+  output += "\n\nSorted by total duration\n========================\n\n";
   std::sort(std::begin(entries), std::end(entries),
             [](const Entries::value_type& lhs, const Entries::value_type& rhs) {
-    return lhs.second.second > rhs.second.second;
+    return lhs.second.histogram.total > rhs.second.histogram.total;
   });
   for (const auto& entry : entries)
     AppendInfo(entry, output);
-  std::cout << output << "\n\n";
+
+  output += "\n\nCall tree\n=========\n\n";
+  AppendCallTree(call_tree, 0, output);
+  return output;
 }
 
-void Profiler::AddEntry(ProfileEntry::Location&& location,
-                        const std::chrono::high_resolution_clock::duration& duration) {
-  background_->Send([this, location, duration] {
-    auto location_as_string(LocationToString(location));
-    auto itr(entries_.find(location_as_string));
-    if (itr == std::end(entries_)) {
-      entries_.insert(itr,
-                      std::make_pair(std::move(location_as_string), std::make_pair(1, duration)));
-    } else {
-      ++itr->second.first;
-      itr->second.second += duration;
+void Profiler::StartRecording(uint32_t sample_interval, size_t max_events_per_thread) {
+  if (sample_interval == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  max_events_per_thread_ = max_events_per_thread;
+  sample_interval_ = sample_interval;
+}
+
+void Profiler::StopRecording() { sample_interval_ = 0; }
+
+bool Profiler::EnableAllocationTracking(bool enable) {
+#ifdef USE_PROFILING
+  detail::g_track_allocations = enable;
+  return true;
+#else
+  return !enable;
+#endif
+}
+
+bool Profiler::AllocationTrackingEnabled() const { return detail::g_track_allocations; }
+
+bool Profiler::EnableHardwareCounters(bool enable) {
+  if (enable && !detail::ThreadProfile::Get().OpenCounters())
+    return false;
+  hardware_counters_ = enable;
+  return true;
+}
+
+void Profiler::WriteChromeTrace(std::ostream& output, bool clear) const {
+  const std::string kPid(std::to_string(process::GetProcessId()));
+  std::map<const CallSite*, std::string> names;
+  output << "{\"traceEvents\":[";
+  bool first(true);
+  for (const auto& thread_profile : ThreadProfiles()) {
+    std::vector<detail::ThreadProfile::Event> events;
+    {
+      std::lock_guard<std::mutex> lock(thread_profile->mutex);
+      if (clear)
+        events.swap(thread_profile->events);
+      else
+        events = thread_profile->events;
     }
-  });
+    const std::string kTid(std::to_string(thread_profile->index));
+    for (const auto& event : events) {
+      auto& name(names[event.call_site]);
+      if (name.empty())
+        name = JsonEscape(LocationToString(*event.call_site));
+      output << (first ? "\n" : ",\n") << "{\"name\":\"" << name
+             << "\",\"cat\":\"profile\",\"ph\":\"X\",\"ts\":"
+             << ToMicroseconds(event.start - kEpoch_) << ",\"dur\":"
+             << ToMicroseconds(event.duration) << ",\"pid\":" << kPid << ",\"tid\":" << kTid
+             << '}';
+      first = false;
+    }
+  }
+  output << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void Profiler::WriteFoldedStacks(std::ostream& output) const {
+  AppendFoldedStacks(CallTree(), std::string(), output);
+}
+
+bool Profiler::StartSampling(unsigned frequency) {
+  if (frequency == 0 || frequency > 1000)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.handler_installed && !(state.handler_installed = InstallSigprofHandler()))
+    return false;
+  state.frequency = frequency;
+  for (const auto& buffer : state.buffers) {
+    StopTimer(*buffer);
+    StartTimer(*buffer, frequency);
+  }
+  if (!state.collector.joinable()) {
+    state.stop_collector = false;
+    state.collector = std::thread([&state] {
+      std::unique_lock<std::mutex> collector_lock(state.mutex);
+      while (!state.stop_collector) {
+        state.collector_condition.wait_for(collector_lock, std::chrono::milliseconds(100));
+        for (const auto& buffer : state.buffers)
+          DrainSamples(*buffer, state);
+      }
+    });
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Profiler::StopSampling() {
+  detail::SamplingState& state(detail::Sampling());
+  std::thread collector;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.frequency = 0;
+    for (const auto& buffer : state.buffers) {
+#ifdef MAIDSAFE_PROFILER_SAMPLING
+      StopTimer(*buffer);
+#endif
+      DrainSamples(*buffer, state);
+    }
+    state.stop_collector = true;
+    collector.swap(state.collector);
+  }
+  state.collector_condition.notify_one();
+  if (collector.joinable())
+    collector.join();
+}
+
+bool Profiler::Sampling() const {
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.frequency != 0;
+}
+
+std::map<std::string, uint64_t> Profiler::SampledStacks() const {
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return FoldSampledStacks(state);
+}
+
+void Profiler::WriteSampledStacks(std::ostream& output, bool clear) const {
+  std::map<std::string, uint64_t> folded;
+  {
+    detail::SamplingState& state(detail::Sampling());
+    std::lock_guard<std::mutex> lock(state.mutex);
+    folded = FoldSampledStacks(state);
+    if (clear)
+      state.stacks.clear();
+  }
+  for (const auto& stack : folded)
+    output << stack.first << ' ' << stack.second << '\n';
+}
+
+uint64_t Profiler::DroppedSamples() const {
+  detail::SamplingState& state(detail::Sampling());
+  std::lock_guard<std::mutex> lock(state.mutex);
+  uint64_t dropped(state.dropped);
+  for (const auto& buffer : state.buffers)
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  return dropped;
 }
 
 }  // namespace profile
 
 }  // namespace maidsafe
+
+#ifdef USE_PROFILING
+
+void* operator new(std::size_t size) { return maidsafe::profile::detail::Allocate(size, false); }
+
+void* operator new[](std::size_t size) { return maidsafe::profile::detail::Allocate(size, false); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) MAIDSAFE_NOEXCEPT {
+  return maidsafe::profile::detail::Allocate(size, true);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) MAIDSAFE_NOEXCEPT {
+  return maidsafe::profile::detail::Allocate(size, true);
+}
+
+void operator delete(void* memory) MAIDSAFE_NOEXCEPT { std::free(memory); }
+
+void operator delete[](void* memory) MAIDSAFE_NOEXCEPT { std::free(memory); }
+
+void operator delete(void* memory, const std::nothrow_t&) MAIDSAFE_NOEXCEPT { std::free(memory); }
+
+void operator delete[](void* memory, const std::nothrow_t&) MAIDSAFE_NOEXCEPT {
+  std::free(memory);
+}
+
+#endif
@@ -18,24 +18,46 @@
 
 #include "maidsafe/common/rsa.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "cryptopp/modes.h"
 #include "cryptopp/osrng.h"
 #include "cryptopp/pssr.h"
 #include "cryptopp/cryptlib.h"
 
+#include "boost/filesystem/operations.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/thread/tss.hpp"
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/lru_cache.h"
 
 #include "maidsafe/common/serialisation/serialisation.h"
 
+namespace bi = boost::interprocess;
+namespace fs = boost::filesystem;
+
 namespace maidsafe {
 
 namespace rsa {
 
 namespace {
 
+// Files are mapped a window at a time to bound the address space used for very large files.  This
+// must be a multiple of the mapping granularity (64KB on Windows).
+const std::uint64_t kFileWindowSize(64 << 20);
+
 void EncodeKey(const CryptoPP::BufferedTransformation& bt, std::string& key) {
   CryptoPP::StringSink name(key);
   bt.CopyTo(name);
@@ -48,13 +70,122 @@ void DecodeKey(const std::vector<byte>& key, CryptoPP::BufferedTransformation& b
   bt.MessageEnd();
 }
 
-}  // Unnamed namespace
+using Signer = CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Signer;
+using Verifier = CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Verifier;
+
+// Prepared signers and verifiers are cached, keyed by the DER encoding of their key, so that the
+// few keys which sign most messages are only validated and loaded once.  Crypto++ objects can't
+// be shared between threads without locking, so each thread has its own caches.
+template <typename Context>
+using ContextCache = LruCache<std::string, std::shared_ptr<const Context>>;
+
+const size_t kContextCacheCapacity(16);
+
+boost::thread_specific_ptr<ContextCache<Signer>> g_signers;
+boost::thread_specific_ptr<ContextCache<Verifier>> g_verifiers;
+
+std::string DerEncoded(const PrivateKey& private_key) {
+  std::string encoded_key;
+  CryptoPP::ByteQueue queue;
+  private_key.DEREncodePrivateKey(queue);
+  EncodeKey(queue, encoded_key);
+  return encoded_key;
+}
+
+std::string DerEncoded(const PublicKey& public_key) {
+  std::string encoded_key;
+  CryptoPP::ByteQueue queue;
+  public_key.DEREncodePublicKey(queue);
+  EncodeKey(queue, encoded_key);
+  return encoded_key;
+}
 
-detail::Spinlock& g_rsa_mutex() {
-  static detail::Spinlock mutex;
-  return mutex;
+// Returns the calling thread's cached context for 'key', constructing and caching it if required.
+// Returns nullptr if 'key' is invalid.
+template <typename Context, typename Key>
+std::shared_ptr<const Context> GetContext(
+    const Key& key, boost::thread_specific_ptr<ContextCache<Context>>& caches) {
+  if (!caches.get())
+    caches.reset(new ContextCache<Context>(kContextCacheCapacity));
+  std::string encoded_key;
+  try {
+    encoded_key = DerEncoded(key);
+  } catch (const CryptoPP::Exception&) {
+    return nullptr;
+  }
+  auto cached(caches->Get(encoded_key));
+  if (cached.valid())
+    return *cached;
+  if (!key.Validate(crypto::random_number_generator(), 0))
+    return nullptr;
+  std::shared_ptr<const Context> context(std::make_shared<Context>(key));
+  caches->Add(std::move(encoded_key), context);
+  return context;
+}
+
+// Memory-maps 'filename' and calls 'functor(data, size)' for each window of it in turn.  While a
+// window is being processed, the next one is already mapped and the OS is asked to start reading
+// it, so that hashing overlaps with disk I/O.  Throws if the file can't be opened or mapped.
+template <typename Functor>
+void ForEachFileWindow(const fs::path& filename, Functor functor) {
+  const std::uint64_t file_size(fs::file_size(filename));
+  if (file_size == 0)
+    return;
+  const bi::file_mapping file(filename.string().c_str(), bi::read_only);
+  auto map_window = [&](std::uint64_t offset) {
+    std::unique_ptr<bi::mapped_region> region(new bi::mapped_region(
+        file, bi::read_only, static_cast<bi::offset_t>(offset),
+        static_cast<std::size_t>(std::min(kFileWindowSize, file_size - offset))));
+    region->advise(bi::mapped_region::advice_sequential);
+    return region;
+  };
+
+  std::unique_ptr<bi::mapped_region> current(map_window(0));
+  for (std::uint64_t offset(kFileWindowSize); current; offset += kFileWindowSize) {
+    std::unique_ptr<bi::mapped_region> next;
+    if (offset < file_size) {
+      next = map_window(offset);
+      next->advise(bi::mapped_region::advice_willneed);
+    }
+    functor(static_cast<const byte*>(current->get_address()), current->get_size());
+    current = std::move(next);
+  }
 }
 
+// Checks 'checks[begin]' to 'checks[end - 1]', writing each result to 'results'.  Verifiers are
+// cached by key value, since a batch of incoming messages typically has few distinct senders.
+void CheckSignatureRange(const std::vector<SignatureCheck>& checks, std::size_t begin,
+                         std::size_t end, std::vector<char>& results) {
+  std::map<std::pair<CryptoPP::Integer, CryptoPP::Integer>, std::unique_ptr<Verifier>> verifiers;
+  for (std::size_t i(begin); i != end; ++i) {
+    const SignatureCheck& check(checks[i]);
+    if (!check.data->IsInitialised() || !check.signature->IsInitialised()) {
+      LOG(kWarning) << "CheckSignatures data or signature uninitialised";
+      continue;
+    }
+    auto key(std::make_pair(check.public_key->GetModulus(), check.public_key->GetPublicExponent()));
+    auto itr(verifiers.find(key));
+    if (itr == verifiers.end()) {
+      std::unique_ptr<Verifier> verifier;
+      if (check.public_key->Validate(crypto::random_number_generator(), 0))
+        verifier.reset(new Verifier(*check.public_key));
+      else
+        LOG(kWarning) << "CheckSignatures invalid public_key";
+      itr = verifiers.emplace(std::move(key), std::move(verifier)).first;
+    }
+    if (!itr->second)
+      continue;
+    try {
+      results[i] = itr->second->VerifyMessage(check.data->data(), check.data->size(),
+                                              check.signature->data(), check.signature->size());
+    } catch (const CryptoPP::Exception& e) {
+      LOG(kWarning) << "Failed asymmetric signature checking: " << e.what();
+    }
+  }
+}
+
+}  // Unnamed namespace
+
 Keys GenerateKeyPair() {
   Keys keypair;
   CryptoPP::InvertibleRSAFunction parameters;
@@ -84,8 +215,8 @@ CipherText Encrypt(const PlainText& data, const PublicKey& public_key) {
         RandomBytes(crypto::AES256_KeySize + crypto::AES256_IVSize));
     crypto::CipherText symm_encrypted_data(crypto::SymmEncrypt(data, local_key_and_iv));
 
+    // Nothing here is shared between threads: the encryptor is local and the RNG is per-thread.
     std::string encryption_key_encrypted;
-    std::lock_guard<detail::Spinlock> lock(g_rsa_mutex());
     CryptoPP::ArraySource(
         local_key_and_iv.data(), local_key_and_iv.size(), true,
         new CryptoPP::PK_EncryptorFilter(crypto::random_number_generator(), encryptor,
@@ -124,21 +255,169 @@ PlainText Decrypt(const CipherText& data, const PrivateKey& private_key) {
   }
 }
 
+struct SessionEncryptor::Session {
+  Session(std::vector<byte> key_in, std::string encrypted_key_in,
+          std::chrono::steady_clock::time_point expiry_in)
+      : key(std::move(key_in)),
+        encrypted_key(std::move(encrypted_key_in)),
+        expiry(expiry_in),
+        messages(0) {}
+  const std::vector<byte> key;
+  const std::string encrypted_key;
+  const std::chrono::steady_clock::time_point expiry;
+  // Used as the nonce for the next message.  Guarded by the encryptor's mutex once cached.
+  uint64_t messages;
+};
+
+SessionEncryptor::SessionEncryptor(Options options)
+    : kOptions_(std::move(options)), mutex_(), sessions_(kOptions_.capacity) {
+  if (kOptions_.capacity == 0 ||
+      kOptions_.key_lifetime <= std::chrono::steady_clock::duration::zero() ||
+      kOptions_.max_messages_per_key == 0) {
+    LOG(kError) << "Invalid SessionEncryptor options.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+}
+
+SessionEncryptor::~SessionEncryptor() {}
+
+std::shared_ptr<SessionEncryptor::Session> SessionEncryptor::NewSession(
+    const PublicKey& public_key) const {
+  if (!public_key.Validate(crypto::random_number_generator(), 0))
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+
+  CryptoPP::RSAES_OAEP_SHA_Encryptor encryptor(public_key);
+  std::vector<byte> key(crypto::AES256_KeySize);
+  crypto::random_number_generator().GenerateBlock(key.data(), key.size());
+  std::string encrypted_key;
+  try {
+    CryptoPP::ArraySource(
+        key.data(), key.size(), true,
+        new CryptoPP::PK_EncryptorFilter(crypto::random_number_generator(), encryptor,
+                                         new CryptoPP::StringSink(encrypted_key)));
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed encrypting session key: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::encryption_error));
+  }
+  return std::make_shared<Session>(std::move(key), std::move(encrypted_key),
+                                   std::chrono::steady_clock::now() + kOptions_.key_lifetime);
+}
+
+CipherText SessionEncryptor::Encrypt(const PlainText& data, const PublicKey& public_key) {
+  std::string encoded_key;
+  try {
+    encoded_key = DerEncoded(public_key);
+  } catch (const CryptoPP::Exception&) {
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
+  }
+
+  std::shared_ptr<Session> session;
+  uint64_t counter(0);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cached(sessions_.Get(encoded_key));
+    if (cached.valid() && (*cached)->messages < kOptions_.max_messages_per_key &&
+        std::chrono::steady_clock::now() < (*cached)->expiry) {
+      session = *cached;
+      counter = session->messages++;
+    }
+  }
+  if (!session) {
+    // The RSA operation is done without holding the lock.  If several threads race to replace the
+    // same session, each encrypts under its own and the last one cached is used thereafter.
+    session = NewSession(public_key);
+    counter = session->messages++;
+    std::lock_guard<std::mutex> lock(mutex_);
+    sessions_.Delete(encoded_key);
+    sessions_.Add(encoded_key, session);
+  }
+
+  // The nonce is the big-endian message counter, which is unique for the session's key.
+  std::string nonce(crypto::AES256_NonceSize, 0);
+  for (int i(0); i != 8; ++i)
+    nonce[crypto::AES256_NonceSize - 1 - i] = static_cast<char>((counter >> (8 * i)) & 0xff);
+  const std::string& plain(data.string());
+  std::string encrypted(plain.size() + crypto::AES256_TagSize, 0);
+  crypto::SymmEncrypt(reinterpret_cast<const byte*>(plain.data()), plain.size(),
+                      session->key.data(), reinterpret_cast<const byte*>(nonce.data()), nullptr,
+                      0, reinterpret_cast<byte*>(&encrypted[0]));
+  return CipherText(Serialise(session->encrypted_key, nonce, encrypted));
+}
+
+SessionDecryptor::SessionDecryptor(PrivateKey private_key, size_t capacity)
+    : kPrivateKey_(std::move(private_key)), mutex_(), session_keys_(capacity) {
+  if (capacity == 0) {
+    LOG(kError) << "SessionDecryptor capacity must be non-zero.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (!kPrivateKey_.Validate(crypto::random_number_generator(), 0))
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
+}
+
+PlainText SessionDecryptor::Decrypt(const CipherText& data) {
+  std::string encrypted_key, nonce, encrypted;
+  try {
+    Parse(data.string(), encrypted_key, nonce, encrypted);
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to parse encrypted session key and data: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::decryption_error));
+  }
+  if (nonce.size() != static_cast<size_t>(crypto::AES256_NonceSize) ||
+      encrypted.size() <= static_cast<size_t>(crypto::AES256_TagSize)) {
+    LOG(kError) << "Invalid session-encrypted data.";
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::decryption_error));
+  }
+
+  std::vector<byte> key;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cached(session_keys_.Get(encrypted_key));
+    if (cached.valid())
+      key = std::move(*cached);
+  }
+  if (key.empty()) {
+    std::string decrypted_key;
+    try {
+      CryptoPP::RSAES_OAEP_SHA_Decryptor decryptor(kPrivateKey_);
+      CryptoPP::StringSource(
+          encrypted_key, true,
+          new CryptoPP::PK_DecryptorFilter(crypto::random_number_generator(), decryptor,
+                                           new CryptoPP::StringSink(decrypted_key)));
+    } catch (const CryptoPP::Exception& e) {
+      LOG(kError) << "Failed decrypting session key: " << e.what();
+      BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::decryption_error));
+    }
+    if (decrypted_key.size() != static_cast<size_t>(crypto::AES256_KeySize)) {
+      LOG(kError) << "Decrypted session key has the wrong size.";
+      BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::decryption_error));
+    }
+    key.assign(std::begin(decrypted_key), std::end(decrypted_key));
+    std::lock_guard<std::mutex> lock(mutex_);
+    session_keys_.Add(encrypted_key, key);
+  }
+
+  std::string plain(encrypted.size() - crypto::AES256_TagSize, 0);
+  crypto::SymmDecrypt(reinterpret_cast<const byte*>(encrypted.data()), encrypted.size(),
+                      key.data(), reinterpret_cast<const byte*>(nonce.data()), nullptr, 0,
+                      reinterpret_cast<byte*>(&plain[0]));
+  return PlainText(std::move(plain));
+}
+
 Signature Sign(const PlainText& data, const PrivateKey& private_key) {
   if (!data.IsInitialised()) {
     LOG(kError) << "Sign data uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
-  if (!private_key.Validate(crypto::random_number_generator(), 0)) {
+  const auto signer(GetContext(private_key, g_signers));
+  if (!signer) {
     LOG(kError) << "Sign invalid private_key";
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_private_key));
   }
 
   std::string signature;
-  CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Signer signer(private_key);
   try {
     CryptoPP::ArraySource(data.data(), data.size(), true,
-                          new CryptoPP::SignerFilter(crypto::random_number_generator(), signer,
+                          new CryptoPP::SignerFilter(crypto::random_number_generator(), *signer,
                                                      new CryptoPP::StringSink(signature)));
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Failed asymmetric signing: " << e.what();
@@ -148,22 +427,27 @@ Signature Sign(const PlainText& data, const PrivateKey& private_key) {
 }
 
 Signature SignFile(const boost::filesystem::path& filename, const PrivateKey& private_key) {
-  if (!private_key.Validate(crypto::random_number_generator(), 0))
+  const auto signer(GetContext(private_key, g_signers));
+  if (!signer)
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::signing_error));
 
-  std::string signature;
-  CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Signer signer(private_key);
+  std::vector<byte> signature(signer->SignatureLength());
   try {
-    CryptoPP::FileSource(filename.c_str(), true,
-                         new CryptoPP::SignerFilter(crypto::random_number_generator(), signer,
-                                                    new CryptoPP::StringSink(signature)));
+    std::unique_ptr<CryptoPP::PK_MessageAccumulator> accumulator(
+        signer->NewSignatureAccumulator(crypto::random_number_generator()));
+    ForEachFileWindow(filename, [&](const byte* data, std::size_t size) {
+      accumulator->Update(data, size);
+    });
+    signature.resize(signer->Sign(crypto::random_number_generator(), accumulator.release(),
+                                  signature.data()));
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Failed asymmetric signing: " << e.what();
-    if (e.GetErrorType() == CryptoPP::Exception::IO_ERROR)
-      BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_file));
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::signing_error));
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to read " << filename << " for signing: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_file));
   }
-  return Signature(signature);
+  return Signature(std::move(signature));
 }
 
 bool CheckSignature(const PlainText& data, const Signature& signature,
@@ -172,41 +456,93 @@ bool CheckSignature(const PlainText& data, const Signature& signature,
     LOG(kError) << "CheckSignature data or signature uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
-  if (!public_key.Validate(crypto::random_number_generator(), 0)) {
+  const auto verifier(GetContext(public_key, g_verifiers));
+  if (!verifier) {
     LOG(kError) << "CheckSignature invalid public_key";
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
   }
 
-  CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Verifier verifier(public_key);
   try {
-    return verifier.VerifyMessage(data.data(), data.size(), signature.data(), signature.size());
+    return verifier->VerifyMessage(data.data(), data.size(), signature.data(), signature.size());
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Failed asymmetric signature checking: " << e.what();
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::signing_error));
   }
 }
 
+std::vector<bool> CheckSignatures(const std::vector<SignatureCheck>& checks) {
+  // Batches smaller than this aren't worth splitting across threads.
+  const std::size_t kMinSizePerThread(32);
+  const std::size_t size(checks.size());
+  const std::size_t thread_count(
+      std::max<std::size_t>(1, std::min<std::size_t>(Concurrency(), size / kMinSizePerThread)));
+  const std::size_t chunk_size((size + thread_count - 1) / thread_count);
+
+  // Results are written as chars since concurrent writes to separate elements of a vector<bool>
+  // aren't safe.
+  std::vector<char> results(size, 0);
+  std::vector<std::future<void>> chunks;
+  for (std::size_t begin(chunk_size); begin < size; begin += chunk_size) {
+    chunks.push_back(std::async(std::launch::async, CheckSignatureRange, std::cref(checks), begin,
+                                std::min(size, begin + chunk_size), std::ref(results)));
+  }
+  CheckSignatureRange(checks, 0, std::min(size, chunk_size), results);
+  for (auto& chunk : chunks)
+    chunk.get();
+  return std::vector<bool>(std::begin(results), std::end(results));
+}
+
 bool CheckFileSignature(const boost::filesystem::path& filename, const Signature& signature,
                         const PublicKey& public_key) {
+  SignatureVerifier verifier(signature, public_key);
+  try {
+    ForEachFileWindow(filename, [&](const byte* data, std::size_t size) {
+      verifier.Update(data, size);
+    });
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to read " << filename << " for signature checking: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_file));
+  }
+  return verifier.Verify();
+}
+
+SignatureVerifier::SignatureVerifier(const Signature& signature, const PublicKey& public_key)
+    : verifier_(), accumulator_() {
   if (!signature.IsInitialised()) {
-    LOG(kError) << "CheckFileSignature signature uninitialised";
+    LOG(kError) << "SignatureVerifier signature uninitialised";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
   }
-  if (!public_key.Validate(crypto::random_number_generator(), 0)) {
-    LOG(kError) << "CheckFileSignature invalid public_key";
+  const auto verifier(GetContext(public_key, g_verifiers));
+  if (!verifier) {
+    LOG(kError) << "SignatureVerifier invalid public_key";
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_public_key));
   }
 
-  CryptoPP::RSASS<CryptoPP::PSS, CryptoPP::SHA512>::Verifier verifier(public_key);
   try {
-    auto verifier_filter = new CryptoPP::VerifierFilter(verifier);
-    verifier_filter->Put(signature.data(), verifier.SignatureLength());
-    CryptoPP::FileSource file_source(filename.c_str(), true, verifier_filter);
-    return verifier_filter->GetLastResult();
+    accumulator_.reset(verifier->NewVerificationAccumulator());
+    verifier->InputSignature(*accumulator_, signature.data(), signature.size());
+  } catch (const CryptoPP::Exception& e) {
+    LOG(kError) << "Failed asymmetric signature checking: " << e.what();
+    BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_signature));
+  }
+  verifier_ = verifier;
+}
+
+SignatureVerifier::~SignatureVerifier() {}
+
+void SignatureVerifier::Update(const byte* data, std::size_t size) {
+  if (!accumulator_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  accumulator_->Update(data, size);
+}
+
+bool SignatureVerifier::Verify() {
+  if (!accumulator_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  try {
+    return verifier_->Verify(accumulator_.release());
   } catch (const CryptoPP::Exception& e) {
     LOG(kError) << "Failed asymmetric signature checking: " << e.what();
-    if (e.GetErrorType() == CryptoPP::Exception::IO_ERROR)
-      BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_file));
     BOOST_THROW_EXCEPTION(MakeError(AsymmErrors::invalid_signature));
   }
 }
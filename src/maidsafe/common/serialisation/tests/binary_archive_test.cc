@@ -0,0 +1,162 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/serialisation/binary_archive.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(BinaryArchiveTest, BEH_ParseFromBuffer) {
+  const std::map<std::string, std::uint64_t> original{{"one", 1}, {"two", 2}, {"three", 3}};
+  const std::string text(RandomString(1000));
+  const SerialisedData serialised(Serialise(original, text));
+
+  // Copy into a buffer which isn't a SerialisedData to check parsing in place.
+  std::unique_ptr<byte[]> buffer(new byte[serialised.size()]);
+  std::copy(serialised.begin(), serialised.end(), buffer.get());
+
+  std::map<std::string, std::uint64_t> parsed_map;
+  std::string parsed_text;
+  Parse(buffer.get(), serialised.size(), parsed_map, parsed_text);
+  EXPECT_EQ(original, parsed_map);
+  EXPECT_EQ(text, parsed_text);
+
+  const SerialisedData serialised_map(Serialise(original));
+  EXPECT_EQ(original, (Parse<std::map<std::string, std::uint64_t>>(serialised_map.data(),
+                                                                     serialised_map.size())));
+  EXPECT_EQ(original, (ParseTrusted<std::map<std::string, std::uint64_t>>(
+                          serialised_map.data(), serialised_map.size())));
+}
+
+TEST(BinaryArchiveTest, BEH_TruncatedInput) {
+  const SerialisedData serialised(Serialise(RandomString(100)));
+  for (std::size_t size : {std::size_t(0), std::size_t(1), serialised.size() - 1})
+    EXPECT_THROW(Parse<std::string>(serialised.data(), size), cereal::Exception);
+
+  BinaryInputArchive archive(serialised.data(), serialised.size());
+  std::string parsed;
+  archive(parsed);
+  EXPECT_EQ(0, archive.remaining());
+}
+
+TEST(BinaryArchiveTest, BEH_StreamAdvancesPastParsedData) {
+  const std::vector<std::uint32_t> first{1, 2, 3};
+  const std::string second("second");
+  const SerialisedData serialised(Serialise(first, second));
+
+  InputVectorStream stream{serialised};
+  EXPECT_EQ(first, Parse<std::vector<std::uint32_t>>(stream));
+  EXPECT_EQ(second, Parse<std::string>(stream));
+  EXPECT_EQ(static_cast<std::streamoff>(serialised.size()),
+            static_cast<std::streamoff>(stream.tellg()));
+}
+
+TEST(BinaryArchiveTest, BEH_SerialiseIntoAndSize) {
+  const std::map<std::string, std::vector<std::uint32_t>> original{{"one", {1}}, {"two", {2, 2}}};
+  const std::string text(RandomString(1000));
+  const SerialisedData expected(Serialise(original, text));
+
+  const auto stream_serialised([&] {
+    OutputVectorStream stream;
+    return Serialise(stream, original, text);
+  }());
+  EXPECT_EQ(expected, stream_serialised);
+
+  EXPECT_EQ(expected.size(), SerialisedSize(original, text));
+  const SerialisedData exact(SerialiseExact(original, text));
+  EXPECT_EQ(expected, exact);
+  EXPECT_EQ(exact.size(), exact.capacity());
+
+  SerialisedData buffer;
+  SerialiseInto(buffer, original, text);
+  EXPECT_EQ(expected, buffer);
+  const auto capacity(buffer.capacity());
+  const auto data(buffer.data());
+  SerialiseInto(buffer, text);
+  EXPECT_EQ(Serialise(text), buffer);
+  EXPECT_EQ(capacity, buffer.capacity());
+  EXPECT_EQ(data, buffer.data());
+}
+
+TEST(BinaryArchiveTest, BEH_ArithmeticContainers) {
+  const std::vector<std::uint64_t> numbers{0, 1, 0xffffffffffffffffULL};
+  const std::vector<byte> bytes(RandomBytes(1000));
+  const std::array<std::int16_t, 3> array{{-1, 0, 1}};
+  const SerialisedData serialised(Serialise(numbers, bytes, array));
+  EXPECT_EQ(SerialisedSize(numbers, bytes, array), serialised.size());
+  EXPECT_EQ(2 * sizeof(cereal::size_type) + sizeof(numbers[0]) * numbers.size() + bytes.size() +
+                sizeof(array),
+            serialised.size());
+
+  std::vector<std::uint64_t> parsed_numbers;
+  std::vector<byte> parsed_bytes;
+  std::array<std::int16_t, 3> parsed_array;
+  Parse(serialised, parsed_numbers, parsed_bytes, parsed_array);
+  EXPECT_EQ(numbers, parsed_numbers);
+  EXPECT_EQ(bytes, parsed_bytes);
+  EXPECT_EQ(array, parsed_array);
+
+  // A size tag claiming more elements than the input holds must be rejected before allocating.
+  const cereal::size_type huge_size(1ULL << 60);
+  SerialisedData malicious(sizeof(huge_size));
+  std::memcpy(malicious.data(), &huge_size, sizeof(huge_size));
+  EXPECT_THROW(Parse<std::vector<std::uint64_t>>(malicious), cereal::Exception);
+}
+
+TEST(BinaryArchiveTest, BEH_ConvertString) {
+  const std::map<std::string, std::uint64_t> original{{"one", 1}, {"two", 2}, {"three", 3}};
+  const std::string text(RandomString(1000));
+
+  // The string functions must produce the same format as the stream ones and as Serialise.
+  const std::string converted(ConvertToString(original, text));
+  std::stringstream stream;
+  EXPECT_EQ(ConvertToString(stream, original, text), converted);
+  const SerialisedData serialised(Serialise(original, text));
+  EXPECT_EQ(std::string(serialised.begin(), serialised.end()), converted);
+
+  std::map<std::string, std::uint64_t> parsed_map;
+  std::string parsed_text;
+  ConvertFromString(converted, parsed_map, parsed_text);
+  EXPECT_EQ(original, parsed_map);
+  EXPECT_EQ(text, parsed_text);
+
+  const std::string converted_text(ConvertToString(text));
+  EXPECT_EQ(text, ConvertFromString<std::string>(converted_text));
+  std::istringstream input_stream(converted_text);
+  EXPECT_EQ(text, ConvertFromStream<std::string>(input_stream));
+  EXPECT_THROW(ConvertFromString<std::string>(converted_text.substr(0, 100)), cereal::Exception);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
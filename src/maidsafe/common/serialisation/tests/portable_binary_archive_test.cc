@@ -0,0 +1,89 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/serialisation/portable_binary_archive.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(PortableBinaryArchiveTest, BEH_LittleEndianAndVarints) {
+  const std::uint32_t value(0x01020304);
+  const std::string text(300, 'a');
+  const SerialisedData serialised(SerialisePortable(value, text));
+  ASSERT_EQ(4 + 2 + text.size(), serialised.size());
+  EXPECT_EQ(SerialisedData({0x04, 0x03, 0x02, 0x01, 0xac, 0x02}),
+            SerialisedData(serialised.begin(), serialised.begin() + 6));
+
+  std::uint32_t parsed_value(0);
+  std::string parsed_text;
+  ParsePortable(serialised, parsed_value, parsed_text);
+  EXPECT_EQ(value, parsed_value);
+  EXPECT_EQ(text, parsed_text);
+}
+
+TEST(PortableBinaryArchiveTest, BEH_RoundTrip) {
+  const std::map<std::string, std::vector<std::uint64_t>> map{{"one", {1}}, {"two", {2, 0}}};
+  const std::vector<double> doubles{-1.5, 0.0, 1e300};
+  const Identity id(MakeIdentity());
+  const std::int64_t negative(-2);
+  const SerialisedData serialised(SerialisePortable(map, doubles, id, negative));
+  // Each of the seven size tags (the map, its two keys and two values, 'doubles' and 'id') shrinks
+  // from eight bytes to one.
+  EXPECT_EQ(Serialise(map, doubles, id, negative).size(), serialised.size() + 7 * 7);
+
+  std::map<std::string, std::vector<std::uint64_t>> parsed_map;
+  std::vector<double> parsed_doubles;
+  Identity parsed_id;
+  std::int64_t parsed_negative(0);
+  ParsePortable(serialised.data(), serialised.size(), parsed_map, parsed_doubles, parsed_id,
+                parsed_negative);
+  EXPECT_EQ(map, parsed_map);
+  EXPECT_EQ(doubles, parsed_doubles);
+  EXPECT_EQ(id, parsed_id);
+  EXPECT_EQ(negative, parsed_negative);
+  EXPECT_EQ(id, ParsePortable<Identity>(SerialisePortable(id)));
+}
+
+TEST(PortableBinaryArchiveTest, BEH_InvalidInput) {
+  // Truncated varint
+  EXPECT_THROW(ParsePortable<std::string>(SerialisedData(1, 0x80)), cereal::Exception);
+  // Varint exceeding 64 bits
+  SerialisedData overlong(10, 0xff);
+  overlong.push_back(0x01);
+  EXPECT_THROW(ParsePortable<std::string>(overlong), cereal::Exception);
+  // Vector size exceeding the input
+  EXPECT_THROW(ParsePortable<std::vector<std::uint32_t>>(SerialisedData({0x10, 0x01, 0x02})),
+               cereal::Exception);
+  // Truncated value
+  EXPECT_THROW(ParsePortable<std::uint64_t>(SerialisedData(7, 0)), cereal::Exception);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,188 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/set_reconciliation.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace {
+
+// The SplitMix64 finaliser.
+std::uint64_t Mix(std::uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+std::uint64_t Word(const byte* bytes, std::size_t index) {
+  std::uint64_t word(0);
+  for (std::size_t i(index * 8); i != index * 8 + 8; ++i)
+    word = (word << 8) | bytes[i];
+  return word;
+}
+
+// Distinguishes cells holding exactly one key from those holding several whose counts cancel out.
+template <typename Key>
+std::uint64_t Checksum(const Key& key) {
+  std::uint64_t checksum(0x5ec4e7c0ffee5eedULL);
+  for (std::size_t i(0); i != identity_size / 8; ++i)
+    checksum = Mix(checksum ^ Word(key.data(), i));
+  return checksum;
+}
+
+bool IsPowerOfTwo(std::size_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+}  // unnamed namespace
+
+const std::size_t KeySetSketch::kPartitionCount;
+
+KeySetSketch::KeySetSketch() : key_count_(0), counts_(), key_sums_(), checksums_() {}
+
+KeySetSketch::KeySetSketch(std::size_t cells_per_partition)
+    : key_count_(0),
+      counts_(cells_per_partition * kPartitionCount, 0),
+      key_sums_(cells_per_partition * kPartitionCount, KeySum()),
+      checksums_(cells_per_partition * kPartitionCount, 0) {
+  if (!IsPowerOfTwo(cells_per_partition)) {
+    LOG(kError) << "Cells per partition must be a non-zero power of two.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+}
+
+void KeySetSketch::Add(const Identity& key) {
+  KeySum key_sum;
+  std::copy(key.data(), key.data() + identity_size, std::begin(key_sum));
+  Toggle(key_sum, 1);
+  ++key_count_;
+}
+
+void KeySetSketch::Remove(const Identity& key) {
+  KeySum key_sum;
+  std::copy(key.data(), key.data() + identity_size, std::begin(key_sum));
+  Toggle(key_sum, -1);
+  --key_count_;
+}
+
+KeySetSketch KeySetSketch::Fold(std::size_t cells_per_partition) const {
+  if (!IsPowerOfTwo(cells_per_partition) || cells_per_partition > CellsPerPartition()) {
+    LOG(kError) << "Can't fold a sketch of " << CellsPerPartition() << " cells per partition to "
+                << cells_per_partition;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  // A key's cell in a partition of size n is its cell in the larger partition modulo n.
+  KeySetSketch folded(cells_per_partition);
+  folded.key_count_ = key_count_;
+  const std::size_t current(CellsPerPartition());
+  for (std::size_t index(0); index != counts_.size(); ++index) {
+    const std::size_t partition(index / current), cell(index % current);
+    const std::size_t target(partition * cells_per_partition + (cell & (cells_per_partition - 1)));
+    folded.counts_[target] += counts_[index];
+    for (std::size_t i(0); i != identity_size; ++i)
+      folded.key_sums_[target][i] ^= key_sums_[index][i];
+    folded.checksums_[target] ^= checksums_[index];
+  }
+  return folded;
+}
+
+KeySetSketch& KeySetSketch::operator-=(const KeySetSketch& other) {
+  if (counts_.size() != other.counts_.size()) {
+    LOG(kError) << "Can't subtract sketches of different sizes.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  for (std::size_t index(0); index != counts_.size(); ++index) {
+    counts_[index] -= other.counts_[index];
+    for (std::size_t i(0); i != identity_size; ++i)
+      key_sums_[index][i] ^= other.key_sums_[index][i];
+    checksums_[index] ^= other.checksums_[index];
+  }
+  key_count_ -= other.key_count_;
+  return *this;
+}
+
+boost::expected<KeySetSketch::Difference, common_error> KeySetSketch::Decode() const {
+  // Repeatedly "peels" cells holding a single key, removing that key from its other cells, which
+  // may leave them holding a single key in turn.
+  KeySetSketch remaining(*this);
+  Difference difference;
+  std::vector<std::size_t> candidates(counts_.size());
+  for (std::size_t index(0); index != candidates.size(); ++index)
+    candidates[index] = index;
+  while (!candidates.empty()) {
+    const std::size_t index(candidates.back());
+    candidates.pop_back();
+    if (!remaining.IsPure(index))
+      continue;
+    const KeySum key(remaining.key_sums_[index]);
+    const std::int32_t count(remaining.counts_[index]);
+    // A corrupt sketch could otherwise keep yielding spurious keys.
+    if (difference.local_only.size() + difference.remote_only.size() == counts_.size())
+      return boost::make_unexpected(MakeError(CommonErrors::cannot_exceed_limit));
+    (count == 1 ? difference.local_only : difference.remote_only)
+        .emplace_back(std::vector<byte>(std::begin(key), std::end(key)));
+    remaining.Toggle(key, -count);
+    for (std::size_t partition(0); partition != kPartitionCount; ++partition)
+      candidates.push_back(remaining.CellIndex(key, partition));
+  }
+
+  const KeySum empty{};
+  for (std::size_t index(0); index != counts_.size(); ++index) {
+    if (remaining.counts_[index] != 0 || remaining.checksums_[index] != 0 ||
+        remaining.key_sums_[index] != empty) {
+      return boost::make_unexpected(MakeError(CommonErrors::cannot_exceed_limit));
+    }
+  }
+  return difference;
+}
+
+void KeySetSketch::Toggle(const KeySum& key, std::int32_t count) {
+  const std::uint64_t checksum(Checksum(key));
+  for (std::size_t partition(0); partition != kPartitionCount; ++partition) {
+    const std::size_t index(CellIndex(key, partition));
+    counts_[index] += count;
+    for (std::size_t i(0); i != identity_size; ++i)
+      key_sums_[index][i] ^= key[i];
+    checksums_[index] ^= checksum;
+  }
+}
+
+std::size_t KeySetSketch::CellIndex(const KeySum& key, std::size_t partition) const {
+  const std::size_t cells(CellsPerPartition());
+  return partition * cells +
+         static_cast<std::size_t>(Mix(Word(key.data(), partition)) & (cells - 1));
+}
+
+bool KeySetSketch::IsPure(std::size_t index) const {
+  return (counts_[index] == 1 || counts_[index] == -1) &&
+         checksums_[index] == Checksum(key_sums_[index]);
+}
+
+void KeySetSketch::Validate() const {
+  if (!IsPowerOfTwo(counts_.size() / kPartitionCount) ||
+      counts_.size() % kPartitionCount != 0 || key_sums_.size() != counts_.size() ||
+      checksums_.size() != counts_.size()) {
+    LOG(kError) << "Invalid serialised KeySetSketch.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+}
+
+}  // namespace maidsafe
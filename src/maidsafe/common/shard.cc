@@ -0,0 +1,149 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace shard {
+
+namespace {
+
+// The SplitMix64 finaliser.  Used to derive independent values from a key and a shard id; the key
+// bits themselves are already uniformly distributed.
+std::uint64_t Mix(std::uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+}  // unnamed namespace
+
+std::uint64_t KeyBits(const Identity& id) {
+  const byte* const bytes(id.data());
+  std::uint64_t bits(0);
+  for (int i(0); i < 8; ++i)
+    bits = (bits << 8) | bytes[i];
+  return bits;
+}
+
+std::uint64_t KeyBits(const Data::NameAndTypeId& key) {
+  return KeyBits(key.name) ^ Mix(static_cast<std::uint64_t>(key.type_id.data));
+}
+
+std::uint32_t JumpShard(std::uint64_t key_bits, std::uint32_t shard_count) {
+  if (shard_count == 0) {
+    LOG(kError) << "Shard count must be at least 1.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::int64_t shard(-1), next(0);
+  while (next < static_cast<std::int64_t>(shard_count)) {
+    shard = next;
+    key_bits = key_bits * 2862933555777941757ULL + 1;
+    next = static_cast<std::int64_t>(static_cast<double>(shard + 1) *
+                                     (static_cast<double>(1LL << 31) /
+                                      static_cast<double>((key_bits >> 33) + 1)));
+  }
+  return static_cast<std::uint32_t>(shard);
+}
+
+std::uint32_t JumpShard(const Identity& id, std::uint32_t shard_count) {
+  return JumpShard(KeyBits(id), shard_count);
+}
+
+std::uint32_t JumpShard(const Data::NameAndTypeId& key, std::uint32_t shard_count) {
+  return JumpShard(KeyBits(key), shard_count);
+}
+
+void RendezvousShards::Add(std::uint64_t id, double weight) {
+  if (!(weight > 0.0) || std::isinf(weight)) {
+    LOG(kError) << "Shard weight must be positive and finite.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (std::any_of(shards_.begin(), shards_.end(),
+                  [id](const Shard& shard) { return shard.id == id; })) {
+    LOG(kError) << "Shard " << id << " has already been added.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  shards_.push_back(Shard{id, Mix(id), weight});
+}
+
+bool RendezvousShards::Remove(std::uint64_t id) {
+  const auto itr(std::find_if(shards_.begin(), shards_.end(),
+                              [id](const Shard& shard) { return shard.id == id; }));
+  if (itr == shards_.end())
+    return false;
+  shards_.erase(itr);
+  return true;
+}
+
+// Uses the logarithmic method (Schindelhauer and Schomaker) so that shares are proportional to the
+// weights: score = -weight / ln(u), for u uniform in (0, 1) derived from the key and the shard.
+double RendezvousShards::Score(const Shard& shard, std::uint64_t key_bits) const {
+  const double unit((static_cast<double>(Mix(key_bits ^ shard.id_bits) >> 11) + 0.5) /
+                    9007199254740992.0);  // 2^53
+  return -shard.weight / std::log(unit);
+}
+
+std::uint64_t RendezvousShards::Select(std::uint64_t key_bits) const {
+  if (shards_.empty()) {
+    LOG(kError) << "No shards to select from.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  }
+  const Shard* best(&shards_.front());
+  double best_score(Score(*best, key_bits));
+  for (size_t i(1); i < shards_.size(); ++i) {
+    const double score(Score(shards_[i], key_bits));
+    // Ties (vanishingly unlikely) are broken by id so that the result doesn't depend on the order
+    // in which shards were added.
+    if (score > best_score || (score == best_score && shards_[i].id < best->id)) {
+      best = &shards_[i];
+      best_score = score;
+    }
+  }
+  return best->id;
+}
+
+std::vector<std::uint64_t> RendezvousShards::SelectN(std::uint64_t key_bits, size_t count) const {
+  std::vector<std::pair<double, std::uint64_t>> scored;
+  scored.reserve(shards_.size());
+  for (const auto& shard : shards_)
+    scored.emplace_back(Score(shard, key_bits), shard.id);
+  count = std::min(count, scored.size());
+  std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+                    [](const std::pair<double, std::uint64_t>& lhs,
+                       const std::pair<double, std::uint64_t>& rhs) {
+    return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+  });
+  std::vector<std::uint64_t> ids;
+  ids.reserve(count);
+  for (size_t i(0); i < count; ++i)
+    ids.push_back(scored[i].second);
+  return ids;
+}
+
+}  // namespace shard
+
+}  // namespace maidsafe
@@ -0,0 +1,90 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/shared_buffer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+SharedBuffer::SharedBuffer(std::vector<byte> bytes) : SharedBuffer() {
+  auto owned(std::make_shared<const std::vector<byte>>(std::move(bytes)));
+  data_ = owned->data();
+  size_ = owned->size();
+  owner_ = std::move(owned);
+}
+
+SharedBuffer::SharedBuffer(NonEmptyString value)
+    : SharedBuffer(std::make_shared<const NonEmptyString>(std::move(value))) {}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<const NonEmptyString> value) : SharedBuffer() {
+  if (!value) {
+    LOG(kError) << "Null value.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
+  }
+  const auto& contents(value->string());
+  data_ = contents.data();
+  size_ = contents.size();
+  string_ = value.get();
+  owner_ = std::move(value);
+}
+
+SharedBuffer::SharedBuffer(std::shared_ptr<const void> owner, const byte* data, std::size_t size)
+    : owner_(std::move(owner)), data_(data), size_(size), string_(nullptr) {}
+
+SharedBuffer SharedBuffer::Slice(std::size_t offset, std::size_t size) const {
+  if (offset > size_ || size > size_ - offset) {
+    LOG(kError) << "Slice [" << offset << ", +" << size << ") is outside buffer of size " << size_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  }
+  SharedBuffer slice(owner_, data_ + offset, size);
+  if (offset == 0 && size == size_)
+    slice.string_ = string_;
+  return slice;
+}
+
+SharedBuffer SharedBuffer::Slice(std::size_t offset) const {
+  return Slice(offset, offset > size_ ? 0 : size_ - offset);
+}
+
+std::shared_ptr<const NonEmptyString> SharedBuffer::SharedString() const {
+  if (!string_)
+    return nullptr;
+  return std::shared_ptr<const NonEmptyString>(owner_, string_);
+}
+
+std::shared_ptr<const NonEmptyString> SharedBuffer::ToSharedString() const {
+  auto shared(SharedString());
+  return shared ? shared : std::make_shared<const NonEmptyString>(ToNonEmptyString());
+}
+
+NonEmptyString SharedBuffer::ToNonEmptyString() const {
+  return NonEmptyString(std::vector<byte>(begin(), end()));
+}
+
+bool operator==(const SharedBuffer& lhs, const SharedBuffer& rhs) {
+  return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+bool operator!=(const SharedBuffer& lhs, const SharedBuffer& rhs) { return !operator==(lhs, rhs); }
+
+}  // namespace maidsafe
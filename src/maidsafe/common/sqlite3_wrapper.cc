@@ -22,9 +22,16 @@ extern "C" {
 #include <sqlite3.h>
 }
 
+#include <algorithm>
+#include <exception>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <string>
 
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/filesystem/operations.hpp"
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
@@ -32,53 +39,281 @@ namespace maidsafe {
 
 namespace sqlite {
 
-Database::Database(const boost::filesystem::path& filename, Mode mode)
-  : database(nullptr), insertlimit(-1) {
+struct SharedFileState {
+  SharedFileState()
+      : writer_mutex(), wal_mutex(), wal_metrics(), last_commit(std::chrono::steady_clock::now()) {}
+
+  std::timed_mutex writer_mutex;
+  std::mutex wal_mutex;
+  WalMetrics wal_metrics;
+  std::chrono::steady_clock::time_point last_commit;
+};
+
+namespace {
+
+// Returns the state for 'filename' shared by all Databases in this process which are open on that
+// file.
+std::shared_ptr<SharedFileState> GetSharedFileState(const boost::filesystem::path& filename) {
+  static std::mutex registry_mutex;
+  static std::map<boost::filesystem::path, std::weak_ptr<SharedFileState>> registry;
+  boost::system::error_code error_code;
+  boost::filesystem::path key(boost::filesystem::canonical(filename, error_code));
+  if (error_code)
+    key = boost::filesystem::absolute(filename);
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::shared_ptr<SharedFileState> file_state(registry[key].lock());
+  if (!file_state) {
+    for (auto itr(std::begin(registry)); itr != std::end(registry);) {
+      if (itr->second.expired())
+        itr = registry.erase(itr);
+      else
+        ++itr;
+    }
+    file_state = std::make_shared<SharedFileState>();
+    registry[key] = file_state;
+  }
+  return file_state;
+}
+
+// Called by SQLite after each commit on a connection, with the number of frames now in the WAL.
+int RecordCommit(void* context, sqlite3*, const char*, int wal_frames) {
+  SharedFileState& file_state(*static_cast<SharedFileState*>(context));
+  std::lock_guard<std::mutex> lock(file_state.wal_mutex);
+  // Fewer frames than before means the WAL has been restarted since we last looked.
+  if (wal_frames < file_state.wal_metrics.wal_frames)
+    file_state.wal_metrics.checkpointed_frames = 0;
+  file_state.wal_metrics.wal_frames = wal_frames;
+  file_state.last_commit = std::chrono::steady_clock::now();
+  return SQLITE_OK;
+}
+
+// Runs a checkpoint of the given SQLITE_CHECKPOINT_xxx 'mode' and records the outcome in
+// 'file_state'.  Returns SQLite's result code.
+int RunCheckpoint(sqlite3* database, int mode, SharedFileState& file_state) {
+  int wal_frames(-1), checkpointed_frames(-1);
+  const int result(
+      sqlite3_wal_checkpoint_v2(database, NULL, mode, &wal_frames, &checkpointed_frames));
+  std::lock_guard<std::mutex> lock(file_state.wal_mutex);
+  WalMetrics& metrics(file_state.wal_metrics);
+  if (result == SQLITE_BUSY)
+    ++metrics.busy_checkpoints;
+  if (wal_frames >= 0 && checkpointed_frames >= 0) {
+    metrics.wal_frames = wal_frames;
+    metrics.checkpointed_frames = checkpointed_frames;
+  }
+  if (result == SQLITE_OK && mode == SQLITE_CHECKPOINT_TRUNCATE)
+    ++metrics.truncate_checkpoints;
+  else if (result == SQLITE_OK && mode == SQLITE_CHECKPOINT_PASSIVE)
+    ++metrics.passive_checkpoints;
+  return result;
+}
+
+}  // unnamed namespace
+
+Options::Options()
+    : synchronous(Synchronous::kOff),
+      cache_size(-2000),
+      mmap_size(0),
+      page_size(0),
+      temp_store(TempStore::kDefault),
+      busy_timeout(250) {}
+
+Options Options::Throughput() {
+  Options options;
+  options.cache_size = -64 * 1024;
+  options.mmap_size = 1024LL * 1024 * 1024;
+  options.temp_store = TempStore::kMemory;
+  return options;
+}
+
+Options Options::Balanced() {
+  Options options;
+  options.synchronous = Synchronous::kNormal;
+  options.cache_size = -16 * 1024;
+  options.mmap_size = 256LL * 1024 * 1024;
+  options.busy_timeout = std::chrono::milliseconds(1000);
+  return options;
+}
+
+Options Options::Durable() {
+  Options options;
+  options.synchronous = Synchronous::kFull;
+  options.busy_timeout = std::chrono::milliseconds(5000);
+  return options;
+}
+
+const std::size_t Database::kDefaultStatementCacheCapacity;
+
+Database::Database(const boost::filesystem::path& filename, Mode mode,
+                   std::size_t statement_cache_capacity_in)
+    : Database(filename, mode, Options(), statement_cache_capacity_in) {}
+
+Database::Database(const boost::filesystem::path& filename, Mode mode, const Options& options,
+                   std::size_t statement_cache_capacity_in)
+  : database(nullptr),
+    insertlimit(-1),
+    file_state(),
+    statement_cache_capacity(statement_cache_capacity_in),
+    statement_cache_mutex(),
+    idle_statements(),
+    idle_statements_by_query(),
+    statement_cache_hits(0),
+    statement_cache_misses(0) {
   auto flags = static_cast<int>(mode);
   if (sqlite3_open_v2(filename.string().c_str(), &database, flags, NULL) != SQLITE_OK) {
     LOG(kError) << "Could not open DB at: " << filename << ".  Error: " << sqlite3_errmsg(database);
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_present));
   }
   assert(sqlite3_threadsafe());
-  char* error_message = 0;
-  sqlite3_exec(database, "PRAGMA synchronous = OFF", NULL, 0, &error_message);
-  sqlite3_exec(database, "PRAGMA journal_mode = WAL", NULL, 0, &error_message);
-  sqlite3_exec(database, "PRAGMA wal_autocheckpoint = 0", NULL, 0, &error_message);
-  sqlite3_busy_timeout(database, 250);
+  // The page size of a database in WAL mode can't be changed, so must be set first.
+  if (options.page_size != 0)
+    SetPragma("page_size = " + std::to_string(options.page_size));
+  SetPragma("journal_mode = WAL");
+  SetPragma("synchronous = " + std::to_string(static_cast<int>(options.synchronous)));
+  SetPragma("cache_size = " + std::to_string(options.cache_size));
+  SetPragma("mmap_size = " + std::to_string(options.mmap_size));
+  SetPragma("temp_store = " + std::to_string(static_cast<int>(options.temp_store)));
+  SetPragma("wal_autocheckpoint = 0");
+  assert(options.busy_timeout.count() <= std::numeric_limits<int>::max());
+  sqlite3_busy_timeout(database, static_cast<int>(options.busy_timeout.count()));
   insertlimit = sqlite3_limit(database, SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+  file_state = GetSharedFileState(filename);
+  // Must follow the wal_autocheckpoint pragma, which would replace this hook.
+  sqlite3_wal_hook(database, &RecordCommit, file_state.get());
 }
 
 Database::~Database() {
+  // All cached statements must be finalised before the connection can be closed.
+  for (const auto& idle_statement : idle_statements)
+    Finalise(idle_statement.second);
   int result = sqlite3_close(database);
   if (result != SQLITE_OK)
     LOG(kError) << "Failed to close DB.  Error: " << result << " - " << sqlite3_errmsg(database);
 }
 
+void Database::SetPragma(const std::string& pragma) {
+  char* error_message = 0;
+  if (sqlite3_exec(database, ("PRAGMA " + pragma).c_str(), NULL, 0, &error_message) != SQLITE_OK)
+    LOG(kWarning) << "Failed to set PRAGMA " << pragma << ": " << error_message;
+  sqlite3_free(error_message);
+}
+
 void Database::CheckPoint() {
-  if (sqlite3_wal_checkpoint(database, NULL) != SQLITE_OK)
+  if (RunCheckpoint(database, SQLITE_CHECKPOINT_PASSIVE, *file_state) != SQLITE_OK)
     LOG(kError) << "CheckPoint error: " << sqlite3_errmsg(database);
   //    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_error));
 }
 
+WalMetrics Database::GetWalMetrics() const {
+  std::lock_guard<std::mutex> lock(file_state->wal_mutex);
+  return file_state->wal_metrics;
+}
+
+std::uint64_t Database::StatementCacheHits() const {
+  std::lock_guard<std::mutex> lock(statement_cache_mutex);
+  return statement_cache_hits;
+}
+
+std::uint64_t Database::StatementCacheMisses() const {
+  std::lock_guard<std::mutex> lock(statement_cache_mutex);
+  return statement_cache_misses;
+}
+
+std::size_t Database::StatementCacheSize() const {
+  std::lock_guard<std::mutex> lock(statement_cache_mutex);
+  return idle_statements.size();
+}
+
+sqlite3_stmt* Database::AcquireStatement(const std::string& query) {
+  {
+    std::lock_guard<std::mutex> lock(statement_cache_mutex);
+    auto itr(idle_statements_by_query.find(query));
+    if (itr != std::end(idle_statements_by_query)) {
+      sqlite3_stmt* statement(itr->second->second);
+      idle_statements.erase(itr->second);
+      idle_statements_by_query.erase(itr);
+      ++statement_cache_hits;
+      return statement;
+    }
+    ++statement_cache_misses;
+  }
+
+  assert(query.size() < std::numeric_limits<int>::max() - 1);
+  sqlite3_stmt* statement(nullptr);
+  auto return_value = sqlite3_prepare_v2(database, query.c_str(),
+                                         static_cast<int>(query.size() + 1), &statement, 0);
+  if (return_value != SQLITE_OK) {
+    LOG(kError) << "sqlite3_prepare_v2 returned: " << return_value << " - "
+                << sqlite3_errmsg(database);
+    if (return_value == SQLITE_NOTADB)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_present));
+    else
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_error));
+  }
+  return statement;
+}
+
+void Database::ReleaseStatement(const std::string& query, sqlite3_stmt* statement) {
+  // The return value of sqlite3_reset only repeats any error from the last sqlite3_step, and the
+  // statement is reusable either way.
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+  if (statement_cache_capacity == 0)
+    return Finalise(statement);
 
-Transaction::Transaction(Database& database_in) : kAttempts(200), database(database_in) {
-  std::string query("BEGIN IMMEDIATE TRANSACTION");  // immediate or exclusive transaction
-  for (int i(0); i != kAttempts; ++i) {
+  sqlite3_stmt* evicted(nullptr);
+  try {
+    std::lock_guard<std::mutex> lock(statement_cache_mutex);
+    if (idle_statements.size() == statement_cache_capacity) {
+      auto least_recent(std::prev(std::end(idle_statements)));
+      auto range(idle_statements_by_query.equal_range(least_recent->first));
+      for (auto itr(range.first); itr != range.second; ++itr) {
+        if (itr->second == least_recent) {
+          idle_statements_by_query.erase(itr);
+          break;
+        }
+      }
+      evicted = least_recent->second;
+      idle_statements.erase(least_recent);
+    }
+    idle_statements.emplace_front(query, statement);
     try {
-      Execute(query);
-      return;
-    } catch (const maidsafe_error& error) {
-      LOG(kWarning) << "Transaction constructor failed in attempt " << i << " with error "
-                    << boost::diagnostic_information(error);
-      if (error.code() == make_error_code(CommonErrors::db_not_present))
-        throw;
-      else
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(RandomUint32() % 200 + RandomUint32() % ((i + 1) * 10) + 10));
+      idle_statements_by_query.emplace(query, std::begin(idle_statements));
+    } catch (const std::exception&) {
+      idle_statements.pop_front();
+      throw;
     }
+  } catch (const std::exception& error) {
+    // Called from Statement's destructor, so mustn't throw.
+    LOG(kWarning) << "Failed to cache statement: " << error.what();
+    Finalise(statement);
   }
-  LOG(kError) << "Failed to acquire DB lock in " << kAttempts << " attempts";
-  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  if (evicted)
+    Finalise(evicted);
+}
+
+void Database::Finalise(sqlite3_stmt* statement) {
+  auto return_value = sqlite3_finalize(statement);
+  if (return_value != SQLITE_OK) {
+    LOG(kError) << "sqlite3_finalize returned: " << return_value << " - "
+                << sqlite3_errmsg(database);
+  }
+}
+
+
+const std::chrono::seconds Transaction::kTimeout(30);
+
+Transaction::Transaction(Database& database_in)
+    : committed(false),
+      database(database_in),
+      writer_lock(database.file_state->writer_mutex, std::defer_lock) {
+  const auto deadline(std::chrono::steady_clock::now() + kTimeout);
+  if (!writer_lock.try_lock_until(deadline)) {
+    LOG(kError) << "Timed out waiting for another transaction in this process to finish";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  ExecuteBefore("BEGIN IMMEDIATE TRANSACTION", deadline);
 }
 
 Transaction::~Transaction() {
@@ -92,20 +327,29 @@ Transaction::~Transaction() {
 }
 
 void Transaction::Commit() {
-  for (int i(0); i != kAttempts; ++i) {
+  // The commit gets a timeout of its own.
+  ExecuteBefore("COMMIT TRANSACTION", std::chrono::steady_clock::now() + kTimeout);
+  committed = true;
+  writer_lock.unlock();
+}
+
+void Transaction::ExecuteBefore(const std::string& query,
+                                std::chrono::steady_clock::time_point deadline) {
+  // Each attempt waits in SQLite's busy handler (see sqlite3_busy_timeout), so there's no need to
+  // sleep between attempts.
+  for (;;) {
     try {
-      Execute("COMMIT TRANSACTION");
-      committed = true;
-      return;
-    } catch (const std::exception& e) {
-      LOG(kWarning) << "Transaction::Commit failed in attempt " << i << " with error "
-                    << boost::diagnostic_information(e);
-      std::this_thread::sleep_for(
-          std::chrono::milliseconds(RandomUint32() % 200 + RandomUint32() % ((i + 1) * 10) + 10));
+      return Execute(query);
+    } catch (const maidsafe_error& error) {
+      if (error.code() != make_error_code(CommonErrors::db_busy))
+        throw;
+      if (std::chrono::steady_clock::now() >= deadline) {
+        LOG(kError) << "Failed to acquire DB lock within " << kTimeout.count() << "s for "
+                    << query;
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+      }
     }
   }
-  LOG(kError) << "Failed to acquire DB lock in " << kAttempts << " attempts";
-  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
 }
 
 void Transaction::Execute(const std::string& query) {
@@ -130,29 +374,311 @@ void Transaction::Execute(const std::string& query) {
   }
 }
 
-Statement::Statement(Database& database_in, const std::string& query)
-    : database(database_in), statement() {
-  assert(query.size() < std::numeric_limits<int>::max() - 1);
-  auto return_value = sqlite3_prepare_v2(database.database, query.c_str(),
-                                         static_cast<int>(query.size() + 1), &statement, 0);
-  if (return_value != SQLITE_OK) {
-    LOG(kError) << "sqlite3_prepare_v2 returned: " << return_value << " - "
-                << sqlite3_errmsg(database.database);
-    if (return_value == SQLITE_NOTADB)
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_present));
+const std::chrono::milliseconds GroupCommitWriter::kDefaultMaxDelay(5);
+const std::size_t GroupCommitWriter::kDefaultMaxBatchSize;
+
+GroupCommitWriter::GroupCommitWriter(const boost::filesystem::path& filename, Mode mode,
+                                     std::chrono::milliseconds max_delay_in,
+                                     std::size_t max_batch_size_in, const Options& options)
+    : database(filename, mode, options),
+      max_delay(max_delay_in),
+      max_batch_size(max_batch_size_in == 0 ? 1 : max_batch_size_in),
+      mutex(),
+      condition(),
+      queue(),
+      stopping(false),
+      thread() {
+  thread = std::thread([this] { Run(); });
+}
+
+GroupCommitWriter::~GroupCommitWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_one();
+  thread.join();
+}
+
+std::future<void> GroupCommitWriter::Enqueue(Mutation mutation) {
+  PendingMutation pending{std::move(mutation), std::promise<void>()};
+  std::future<void> result(pending.promise.get_future());
+  bool notify(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(pending));
+    // The thread only needs waking to start a batch or to cut one short.
+    notify = (queue.size() == 1 || queue.size() == max_batch_size);
+  }
+  if (notify)
+    condition.notify_one();
+  return result;
+}
+
+void GroupCommitWriter::Run() {
+  std::vector<PendingMutation> batch;
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    condition.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (queue.empty())
+      return;
+    // Give other callers until 'max_delay' has elapsed to join this batch.  When stopping, the
+    // remaining queue is drained without waiting.
+    condition.wait_for(lock, max_delay,
+                       [this] { return stopping || queue.size() >= max_batch_size; });
+    const auto batch_end(std::begin(queue) +
+                         static_cast<std::ptrdiff_t>(std::min(queue.size(), max_batch_size)));
+    batch.assign(std::make_move_iterator(std::begin(queue)), std::make_move_iterator(batch_end));
+    queue.erase(std::begin(queue), batch_end);
+    lock.unlock();
+    CommitBatch(batch);
+    batch.clear();
+    lock.lock();
+  }
+}
+
+void GroupCommitWriter::CommitBatch(std::vector<PendingMutation>& batch) {
+  std::vector<std::exception_ptr> errors(batch.size());
+  try {
+    Transaction transaction(database);
+    for (std::size_t i(0); i != batch.size(); ++i) {
+      Statement(database, "SAVEPOINT group_commit").Step();
+      try {
+        batch[i].mutation(database);
+      } catch (...) {
+        errors[i] = std::current_exception();
+        Statement(database, "ROLLBACK TO group_commit").Step();
+      }
+      Statement(database, "RELEASE group_commit").Step();
+    }
+    transaction.Commit();
+  } catch (...) {
+    LOG(kError) << "Failed to commit batch of " << batch.size() << " mutations: "
+                << boost::current_exception_diagnostic_information();
+    const std::exception_ptr error(std::current_exception());
+    for (auto& pending : batch)
+      pending.promise.set_exception(error);
+    return;
+  }
+  for (std::size_t i(0); i != batch.size(); ++i) {
+    if (errors[i])
+      batch[i].promise.set_exception(errors[i]);
     else
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_error));
+      batch[i].promise.set_value();
   }
 }
 
-Statement::~Statement() {
-  auto return_value = sqlite3_finalize(statement);
-  if (return_value != SQLITE_OK) {
-    LOG(kError) << "sqlite3_finalize returned: " << return_value << " - "
-                << sqlite3_errmsg(database.database);
+void BulkInsert(Database& database, const std::string& insert_into, int column_count,
+                std::size_t row_count, const RowBinder& bind_row) {
+  if (column_count <= 0 || column_count > database.InsertLimit()) {
+    LOG(kError) << "Can't insert " << column_count << " columns per row; limit is "
+                << database.InsertLimit();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  const std::size_t max_rows(std::min(
+      kMaxBulkInsertRows, static_cast<std::size_t>(database.InsertLimit() / column_count)));
+  std::string row_parameters("(?");
+  for (int i(1); i < column_count; ++i)
+    row_parameters += ",?";
+  row_parameters += ')';
+
+  std::size_t row(0);
+  while (row != row_count) {
+    const std::size_t statement_rows(std::min(max_rows, row_count - row));
+    std::string query(insert_into);
+    query.reserve(query.size() + 8 + statement_rows * (row_parameters.size() + 1));
+    query += " VALUES ";
+    for (std::size_t i(0); i != statement_rows; ++i) {
+      if (i != 0)
+        query += ',';
+      query += row_parameters;
+    }
+    Statement statement(database, query);
+    // Once one full-size statement has been built, the remaining full-size batches reuse it.
+    do {
+      for (std::size_t i(0); i != statement_rows; ++i, ++row)
+        bind_row(statement, row, static_cast<int>(i) * column_count + 1);
+      statement.Step();
+      statement.Reset();
+    } while (row_count - row >= statement_rows);
   }
 }
 
+const std::chrono::milliseconds Checkpointer::kDefaultPollInterval(100);
+const std::chrono::milliseconds Checkpointer::kDefaultIdlePeriod(1000);
+const int Checkpointer::kDefaultPassiveThreshold;
+
+Checkpointer::Checkpointer(const boost::filesystem::path& filename, int passive_threshold_in,
+                           std::chrono::milliseconds poll_interval_in,
+                           std::chrono::milliseconds idle_period_in)
+    : database(filename, Mode::kReadWrite),
+      passive_threshold(passive_threshold_in),
+      poll_interval(poll_interval_in),
+      idle_period(idle_period_in),
+      mutex(),
+      condition(),
+      stopping(false),
+      thread() {
+  // Checkpoints are abandoned rather than waiting on (and so delaying) other connections.
+  sqlite3_busy_timeout(database.database, 0);
+  thread = std::thread([this] { Run(); });
+}
+
+Checkpointer::~Checkpointer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_one();
+  thread.join();
+}
+
+void Checkpointer::Run() {
+  // Learn the size of any WAL left by earlier connections.
+  RunCheckpoint(database.database, SQLITE_CHECKPOINT_PASSIVE, *database.file_state);
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!condition.wait_for(lock, poll_interval, [this] { return stopping; })) {
+    lock.unlock();
+    CheckpointIfDue();
+    lock.lock();
+  }
+}
+
+void Checkpointer::CheckpointIfDue() {
+  WalMetrics metrics;
+  std::chrono::steady_clock::time_point last_commit;
+  {
+    std::lock_guard<std::mutex> lock(database.file_state->wal_mutex);
+    metrics = database.file_state->wal_metrics;
+    last_commit = database.file_state->last_commit;
+  }
+  int mode(-1);
+  if (metrics.wal_frames > 0 && std::chrono::steady_clock::now() - last_commit >= idle_period)
+    mode = SQLITE_CHECKPOINT_TRUNCATE;
+  else if (metrics.wal_frames - metrics.checkpointed_frames >= passive_threshold)
+    mode = SQLITE_CHECKPOINT_PASSIVE;
+  else
+    return;
+
+  const int result(RunCheckpoint(database.database, mode, *database.file_state));
+  if (result != SQLITE_OK && result != SQLITE_BUSY)
+    LOG(kError) << "Checkpoint error: " << sqlite3_errmsg(database.database);
+}
+
+ConnectionPool::ConnectionPool(const boost::filesystem::path& filename, std::size_t reader_count,
+                               Mode writer_mode, const Options& options)
+    : writer(filename, writer_mode, options), readers(), mutex(), condition(), idle_readers() {
+  if (reader_count == 0)
+    reader_count = std::max(1U, std::thread::hardware_concurrency());
+  // The writer has already created the file if required and switched it to WAL mode, which
+  // read-only connections can't do themselves.
+  readers.reserve(reader_count);
+  idle_readers.reserve(reader_count);
+  for (std::size_t i(0); i != reader_count; ++i) {
+    readers.emplace_back(new Database(filename, Mode::kReadOnly, options));
+    idle_readers.push_back(readers.back().get());
+  }
+}
+
+Database& ConnectionPool::AcquireReader() {
+  std::unique_lock<std::mutex> lock(mutex);
+  condition.wait(lock, [this] { return !idle_readers.empty(); });
+  Database* reader(idle_readers.back());
+  idle_readers.pop_back();
+  return *reader;
+}
+
+void ConnectionPool::ReleaseReader(Database& reader) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle_readers.push_back(&reader);
+  }
+  condition.notify_one();
+}
+
+namespace detail {
+
+std::error_code CurrentErrorCode() {
+  try {
+    throw;
+  } catch (const maidsafe_error& error) {
+    return error.code();
+  } catch (const std::system_error& error) {
+    return error.code();
+  } catch (const std::exception& e) {
+    LOG(kError) << boost::diagnostic_information(e);
+  } catch (...) {
+    LOG(kError) << "Query threw an unknown exception.";
+  }
+  return make_error_code(CommonErrors::unknown);
+}
+
+}  // namespace detail
+
+QueryExecutor::QueryExecutor(const boost::filesystem::path& filename, std::size_t reader_count,
+                             Mode writer_mode, const Options& options)
+    : pool(filename, reader_count, writer_mode, options),
+      mutex(),
+      condition(),
+      reads(),
+      writes(),
+      stopping(false),
+      threads() {
+  // One thread per reader connection, so reads never wait for a connection, plus the writer.
+  for (std::size_t i(0); i != pool.ReaderCount(); ++i)
+    threads.emplace_back([this] { Run(reads); });
+  threads.emplace_back([this] { Run(writes); });
+}
+
+QueryExecutor::~QueryExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  for (auto& thread : threads)
+    thread.join();
+}
+
+std::size_t QueryExecutor::QueuedReads() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return reads.size();
+}
+
+std::size_t QueryExecutor::QueuedWrites() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return writes.size();
+}
+
+void QueryExecutor::Enqueue(std::deque<Task>& queue, Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(task));
+  }
+  // Readers and the writer share the condition, so wake them all to be sure of reaching one
+  // serving 'queue'.
+  condition.notify_all();
+}
+
+void QueryExecutor::Run(std::deque<Task>& queue) {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    condition.wait(lock, [this, &queue] { return stopping || !queue.empty(); });
+    if (queue.empty())
+      return;
+    Task task(std::move(queue.front()));
+    queue.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+Statement::Statement(Database& database_in, const std::string& query_in)
+    : database(database_in), query(query_in), statement(database.AcquireStatement(query)) {}
+
+Statement::~Statement() { database.ReleaseStatement(query, statement); }
+
 void Statement::BindText(int row_index, const std::string& text) {
   assert(text.size() < std::numeric_limits<int>::max());
   auto return_value = sqlite3_bind_text(statement, row_index, text.c_str(),
@@ -166,12 +692,45 @@ void Statement::BindText(int row_index, const std::string& text) {
   }
 }
 
+void Statement::BindInt64(int row_index, std::int64_t value) {
+  auto return_value = sqlite3_bind_int64(statement, row_index, value);
+  if (return_value != SQLITE_OK) {
+    LOG(kError) << "sqlite3_bind_int64 returned: " << return_value << " - "
+                << sqlite3_errmsg(database.database);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_error));
+  }
+}
+
+void Statement::BindDouble(int row_index, double value) {
+  auto return_value = sqlite3_bind_double(statement, row_index, value);
+  if (return_value != SQLITE_OK) {
+    LOG(kError) << "sqlite3_bind_double returned: " << return_value << " - "
+                << sqlite3_errmsg(database.database);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_error));
+  }
+}
+
 void Statement::BindBlob(int row_index, const SerialisedData& blob) {
-  assert(blob.size() < std::numeric_limits<int>::max());
-  auto return_value = sqlite3_bind_blob(statement, row_index, &blob[0],
-                                        static_cast<int>(blob.size()),
-                                        reinterpret_cast<sqlite3_destructor_type>(-1));
-                                        // SQLITE_TRANSIENT macro replaced with C++ cast
+  BindBlobData(row_index, BlobView{blob.data(), blob.size()}, true);
+}
+
+void Statement::BindBlobStatic(int row_index, const SerialisedData& blob) {
+  BindBlobData(row_index, BlobView{blob.data(), blob.size()}, false);
+}
+
+void Statement::BindBlobView(int row_index, BlobView blob) {
+  BindBlobData(row_index, blob, false);
+}
+
+void Statement::BindBlobData(int row_index, BlobView blob, bool copy) {
+  assert(blob.size < static_cast<std::size_t>(std::numeric_limits<int>::max()));
+  // A null pointer would bind NULL rather than an empty blob.
+  auto return_value =
+      blob.size == 0
+          ? sqlite3_bind_zeroblob(statement, row_index, 0)
+          : sqlite3_bind_blob(statement, row_index, blob.data, static_cast<int>(blob.size),
+                              copy ? reinterpret_cast<sqlite3_destructor_type>(-1) : nullptr);
+                              // SQLITE_TRANSIENT / SQLITE_STATIC macros replaced with C++
   if (return_value != SQLITE_OK) {
     LOG(kError) << "sqlite3_bind_blob returned: " << return_value << " - "
                 << sqlite3_errmsg(database.database);
@@ -196,6 +755,14 @@ std::string Statement::ColumnText(int col_index) {
   return std::string(column_text, bytes);
 }
 
+std::int64_t Statement::ColumnInt64(int col_index) {
+  return sqlite3_column_int64(statement, col_index);
+}
+
+double Statement::ColumnDouble(int col_index) {
+  return sqlite3_column_double(statement, col_index);
+}
+
 SerialisedData Statement::ColumnBlob(int col_index) {
   auto column_blob =
       reinterpret_cast<const unsigned char*>(sqlite3_column_blob(statement, col_index));
@@ -203,6 +770,14 @@ SerialisedData Statement::ColumnBlob(int col_index) {
   return SerialisedData(column_blob, column_blob + bytes);
 }
 
+BlobView Statement::ColumnBlobView(int col_index) {
+  // sqlite3_column_blob must be called before sqlite3_column_bytes, as the former may convert the
+  // value, invalidating any size already read.
+  auto column_blob = static_cast<const byte*>(sqlite3_column_blob(statement, col_index));
+  int bytes = sqlite3_column_bytes(statement, col_index);
+  return BlobView{column_blob, static_cast<std::size_t>(bytes)};
+}
+
 void Statement::Reset() {
   auto return_value = sqlite3_reset(statement);
   if (return_value != SQLITE_OK) {
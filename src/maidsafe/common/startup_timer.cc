@@ -0,0 +1,85 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/startup_timer.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace maidsafe {
+
+namespace {
+
+struct Recorder {
+  Recorder() : mutex(), timings(), report_registered(false) {}
+  std::mutex mutex;
+  StartupTimer::Timings timings;
+  bool report_registered;
+};
+
+// Deliberately leaked, so that it is still available to the report written at exit.
+Recorder& GetRecorder() {
+  static Recorder* const recorder(new Recorder);
+  return *recorder;
+}
+
+void WriteReport() {
+  const StartupTimer::Timings timings(StartupTimer::Recorded());
+  std::cerr << "Startup times:\n";
+  for (const auto& timing : timings) {
+    std::cerr << "  " << std::left << std::setw(32) << timing.first << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3)
+              << timing.second.count() / 1000.0 << " ms\n";
+  }
+}
+
+}  // unnamed namespace
+
+StartupTimer::StartupTimer(const char* subsystem)
+    : subsystem_(subsystem),
+      start_(Enabled() ? std::chrono::steady_clock::now()
+                       : std::chrono::steady_clock::time_point()) {}
+
+StartupTimer::~StartupTimer() {
+  if (!Enabled())
+    return;
+  const auto elapsed(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_));
+  Recorder& recorder(GetRecorder());
+  std::lock_guard<std::mutex> lock(recorder.mutex);
+  recorder.timings.emplace_back(subsystem_, elapsed);
+  if (!recorder.report_registered) {
+    recorder.report_registered = true;
+    std::atexit(WriteReport);
+  }
+}
+
+bool StartupTimer::Enabled() {
+  static const bool enabled(std::getenv("MAIDSAFE_STARTUP_TIMES") != nullptr);
+  return enabled;
+}
+
+StartupTimer::Timings StartupTimer::Recorded() {
+  Recorder& recorder(GetRecorder());
+  std::lock_guard<std::mutex> lock(recorder.mutex);
+  return recorder.timings;
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,217 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/stream_encryption.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <string>
+
+#include "boost/filesystem/fstream.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+namespace {
+
+// The segment index and last-segment flag occupy the final five bytes of each segment's IV.
+const std::size_t kNoncePrefixSize = AES256_IVSize - 5;
+
+struct Segment {
+  byte* data;
+  std::size_t size;
+  std::uint64_t index;
+  bool last;
+};
+
+AES256KeyAndIV SegmentKeyAndIV(const AES256KeyAndIV& key_and_iv, std::uint64_t index, bool last) {
+  if (index > std::numeric_limits<std::uint32_t>::max()) {
+    LOG(kError) << "Too many segments for stream encryption.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::file_too_large));
+  }
+  std::vector<byte> segment_key_and_iv(key_and_iv.begin(), key_and_iv.end());
+  byte* suffix(&segment_key_and_iv[AES256_KeySize + kNoncePrefixSize]);
+  for (int i(3); i >= 0; --i, index >>= 8)
+    suffix[i] = static_cast<byte>(index & 0xff);
+  suffix[4] = last ? 1 : 0;
+  return AES256KeyAndIV(std::move(segment_key_and_iv));
+}
+
+void EncryptSegment(Segment& segment, const AES256KeyAndIV& key_and_iv) {
+  SymmEncrypt(segment.data, segment.size,
+              SegmentKeyAndIV(key_and_iv, segment.index, segment.last), segment.data);
+  segment.size += AES256_TagSize;
+}
+
+void DecryptSegment(Segment& segment, const AES256KeyAndIV& key_and_iv) {
+  if (segment.size < static_cast<std::size_t>(AES256_TagSize)) {
+    LOG(kError) << "Failed stream decryption: truncated segment " << segment.index;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::symmetric_decryption_error));
+  }
+  SymmDecrypt(segment.data, segment.size,
+              SegmentKeyAndIV(key_and_iv, segment.index, segment.last), segment.data);
+  segment.size -= AES256_TagSize;
+}
+
+// Reads up to 'size' bytes into 'buffer' and returns the number read.
+std::size_t Read(std::istream& input, byte* buffer, std::size_t size) {
+  input.read(reinterpret_cast<char*>(buffer), size);
+  if (input.bad()) {
+    LOG(kError) << "Failed reading from stream.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  return static_cast<std::size_t>(input.gcount());
+}
+
+bool AtEnd(std::istream& input) {
+  return input.peek() == std::istream::traits_type::eof();
+}
+
+// Applies 'transform' to each of 'segments', kStreamSegmentsPerThread at a time per thread.
+template <typename Transform>
+void TransformSegments(std::vector<Segment>& segments, const AES256KeyAndIV& key_and_iv,
+                       Transform transform) {
+  auto transform_range = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i(begin); i != end; ++i)
+      transform(segments[i], key_and_iv);
+  };
+  std::vector<std::future<void>> futures;
+  for (std::size_t begin(kStreamSegmentsPerThread); begin < segments.size();
+       begin += kStreamSegmentsPerThread) {
+    futures.emplace_back(std::async(std::launch::async, transform_range, begin,
+                                    std::min(begin + kStreamSegmentsPerThread, segments.size())));
+  }
+  transform_range(0, std::min(kStreamSegmentsPerThread, segments.size()));
+  for (auto& future : futures)
+    future.get();
+}
+
+// Reads 'input' in segments of 'read_size' bytes, transforms a batch of segments at a time, and
+// writes the results to 'output'.  Each slot in the buffer has room for a ciphertext segment.
+template <typename Transform>
+void TransformStream(std::istream& input, std::ostream& output, const AES256KeyAndIV& key_and_iv,
+                     std::size_t read_size, Transform transform) {
+  if (!key_and_iv.IsInitialised()) {
+    LOG(kError) << "Stream encryption key_and_iv uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  const std::size_t batch_size(Concurrency() * kStreamSegmentsPerThread);
+  std::vector<byte> buffer(batch_size * kStreamCiphertextSegmentSize);
+  std::vector<Segment> segments;
+  segments.reserve(batch_size);
+  std::uint64_t index(0);
+  bool last(false);
+  while (!last) {
+    segments.clear();
+    while (!last && segments.size() != batch_size) {
+      byte* slot(&buffer[segments.size() * kStreamCiphertextSegmentSize]);
+      const std::size_t size(Read(input, slot, read_size));
+      last = size < read_size || AtEnd(input);
+      segments.push_back(Segment{slot, size, index++, last});
+    }
+    TransformSegments(segments, key_and_iv, transform);
+    for (const auto& segment : segments)
+      output.write(reinterpret_cast<const char*>(segment.data), segment.size);
+    if (!output) {
+      LOG(kError) << "Failed writing to stream.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+  }
+}
+
+template <typename Transform>
+void TransformFile(const boost::filesystem::path& input_path,
+                   const boost::filesystem::path& output_path, const AES256KeyAndIV& key_and_iv,
+                   std::size_t read_size, Transform transform) {
+  boost::filesystem::ifstream input(input_path, std::ios::in | std::ios::binary);
+  if (!input) {
+    LOG(kError) << "Failed to open " << input_path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  boost::filesystem::ofstream output(output_path,
+                                     std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!output) {
+    LOG(kError) << "Failed to open " << output_path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  TransformStream(input, output, key_and_iv, read_size, transform);
+}
+
+}  // unnamed namespace
+
+void StreamEncrypt(std::istream& input, std::ostream& output, const AES256KeyAndIV& key_and_iv) {
+  TransformStream(input, output, key_and_iv, kStreamSegmentSize, EncryptSegment);
+}
+
+void StreamDecrypt(std::istream& input, std::ostream& output, const AES256KeyAndIV& key_and_iv) {
+  TransformStream(input, output, key_and_iv, kStreamCiphertextSegmentSize, DecryptSegment);
+}
+
+void StreamEncryptFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+                       const AES256KeyAndIV& key_and_iv) {
+  TransformFile(input, output, key_and_iv, kStreamSegmentSize, EncryptSegment);
+}
+
+void StreamDecryptFile(const boost::filesystem::path& input, const boost::filesystem::path& output,
+                       const AES256KeyAndIV& key_and_iv) {
+  TransformFile(input, output, key_and_iv, kStreamCiphertextSegmentSize, DecryptSegment);
+}
+
+std::uint64_t StreamSegmentCount(std::uint64_t ciphertext_size) {
+  const std::uint64_t remainder(ciphertext_size % kStreamCiphertextSegmentSize);
+  if (ciphertext_size == 0 ||
+      (remainder != 0 && remainder < static_cast<std::uint64_t>(AES256_TagSize))) {
+    LOG(kError) << ciphertext_size << " is not a valid stream ciphertext size.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  return ciphertext_size / kStreamCiphertextSegmentSize + (remainder == 0 ? 0 : 1);
+}
+
+std::vector<byte> StreamDecryptSegment(std::istream& input, std::uint64_t index,
+                                       const AES256KeyAndIV& key_and_iv) {
+  if (!key_and_iv.IsInitialised()) {
+    LOG(kError) << "StreamDecryptSegment key_and_iv uninitialised";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  input.clear();
+  input.seekg(static_cast<std::streamoff>(index * kStreamCiphertextSegmentSize));
+  if (!input) {
+    LOG(kError) << "Failed to seek to segment " << index;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  std::vector<byte> buffer(kStreamCiphertextSegmentSize);
+  const std::size_t size(Read(input, buffer.data(), buffer.size()));
+  if (size == 0) {
+    LOG(kError) << "Segment " << index << " is beyond the end of the stream.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  }
+  Segment segment{buffer.data(), size, index, size < buffer.size() || AtEnd(input)};
+  DecryptSegment(segment, key_and_iv);
+  buffer.resize(segment.size);
+  return buffer;
+}
+
+}  // namespace crypto
+
+}  // namespace maidsafe
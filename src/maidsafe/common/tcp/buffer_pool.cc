@@ -0,0 +1,170 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/buffer_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "boost/thread/tss.hpp"
+
+#include "maidsafe/common/memory_arena.h"
+#include "maidsafe/common/numa.h"
+
+namespace maidsafe {
+
+namespace tcp {
+
+namespace {
+
+const size_t kSizeClassCount = 15;  // 64 bytes to 1 MiB
+
+struct ThreadCache {
+  ThreadCache() : node(numa::CurrentNode()), buffers() {}
+  // The node on which the thread was running when the cache was made.  Threads which may migrate
+  // between nodes should be bound to one (e.g. via IoService) before using the pool.
+  const unsigned node;
+  std::array<std::vector<detail::BufferStorage>, kSizeClassCount> buffers;
+};
+
+// Keep outside the function to avoid lazy static init races on MSVC
+boost::thread_specific_ptr<ThreadCache> g_thread_cache;
+// Only accessed via std::atomic_load and std::atomic_store.
+std::shared_ptr<MemoryArena> g_arena;
+
+ThreadCache& GetThreadCache() {
+  if (!g_thread_cache.get())
+    g_thread_cache.reset(new ThreadCache);
+  return *g_thread_cache;
+}
+
+// Returns the index of the smallest class able to hold 'size' bytes, and that class's capacity.
+std::pair<size_t, size_t> SizeClass(size_t size) {
+  size_t index(0), capacity(BufferPool::MinPooledSize());
+  while (capacity < size) {
+    capacity <<= 1;
+    ++index;
+  }
+  return std::make_pair(index, capacity);
+}
+
+detail::BufferStorage Allocate(size_t capacity) {
+  std::shared_ptr<MemoryArena> arena(std::atomic_load(&g_arena));
+  if (arena) {
+    if (void* const block = arena->Allocate(capacity))
+      return detail::BufferStorage(static_cast<byte*>(block),
+                                   detail::BufferDeleter(std::move(arena), capacity));
+  }
+  return detail::BufferStorage(new byte[capacity]);
+}
+
+}  // unnamed namespace
+
+namespace detail {
+
+void BufferDeleter::operator()(byte* storage) const {
+  if (arena)
+    arena->Deallocate(storage, capacity);
+  else
+    delete[] storage;
+}
+
+}  // namespace detail
+
+PooledBuffer::~PooledBuffer() {
+  if (storage_)
+    BufferPool::Release(std::move(storage_), capacity_, node_);
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other)
+    : storage_(std::move(other.storage_)),
+      capacity_(other.capacity_),
+      size_(other.size_),
+      node_(other.node_) {
+  other.capacity_ = 0;
+  other.size_ = 0;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) {
+  if (this != &other) {
+    if (storage_)
+      BufferPool::Release(std::move(storage_), capacity_, node_);
+    storage_ = std::move(other.storage_);
+    capacity_ = other.capacity_;
+    size_ = other.size_;
+    node_ = other.node_;
+    other.capacity_ = 0;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+PooledBuffer BufferPool::Get(size_t size) {
+  if (size > MaxPooledSize())
+    return PooledBuffer(detail::BufferStorage(new byte[size]), size, size, 0);
+
+  const auto size_class(SizeClass(size));
+  ThreadCache& cache(GetThreadCache());
+  auto& cached(cache.buffers[size_class.first]);
+  if (cached.empty())
+    return PooledBuffer(Allocate(size_class.second), size_class.second, size, cache.node);
+  detail::BufferStorage storage(std::move(cached.back()));
+  cached.pop_back();
+  return PooledBuffer(std::move(storage), size_class.second, size, cache.node);
+}
+
+PooledBuffer BufferPool::Copy(const Message& message) {
+  PooledBuffer buffer(Get(message.size()));
+  if (!message.empty())
+    std::memcpy(buffer.data(), message.data(), message.size());
+  return buffer;
+}
+
+void BufferPool::SetArena(std::shared_ptr<MemoryArena> arena) {
+  std::atomic_store(&g_arena, std::move(arena));
+}
+
+std::shared_ptr<MemoryArena> BufferPool::Arena() { return std::atomic_load(&g_arena); }
+
+size_t BufferPool::CachedCount() {
+  size_t count(0);
+  for (const auto& cached : GetThreadCache().buffers)
+    count += cached.size();
+  return count;
+}
+
+void BufferPool::Release(detail::BufferStorage storage, size_t capacity, unsigned node) {
+  if (capacity > MaxPooledSize())
+    return;
+  const auto size_class(SizeClass(capacity));
+  if (size_class.second != capacity)  // Not from the pool.
+    return;
+  ThreadCache& cache(GetThreadCache());
+  if (cache.node != node)
+    return;
+  auto& cached(cache.buffers[size_class.first]);
+  if (cached.size() < std::max<size_t>(1, MaxCachedBytesPerClass() / capacity))
+    cached.push_back(std::move(storage));
+}
+
+}  // namespace tcp
+
+}  // namespace maidsafe
@@ -18,17 +18,25 @@
 
 #include "maidsafe/common/tcp/connection.h"
 
+#include <algorithm>
 #include <condition_variable>
+#include <memory>
+#include <utility>
 
 #include "asio/dispatch.hpp"
 #include "asio/error.hpp"
 #include "asio/post.hpp"
 #include "asio/read.hpp"
+#include "asio/steady_timer.hpp"
 #include "asio/write.hpp"
+#include "boost/filesystem/operations.hpp"
 
+#include "maidsafe/common/clock.h"
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/tcp/stream_compression.h"
 
 namespace ip = asio::ip;
 
@@ -36,28 +44,258 @@ namespace maidsafe {
 
 namespace tcp {
 
+namespace {
+
+// Frame type (the top two bits of the size header) of a whole message.  Other values are those of
+// Connection::Fragment.
+const unsigned char kWholeMessage = 0;
+const Connection::DataSize kFrameSizeMask = 0x3FFFFFFF;
+
+using Nonce = std::array<byte, crypto::AES256_NonceSize>;
+
+// The GCM nonce for the frame numbered 'counter' in one direction of a connection.
+Nonce MakeNonce(uint64_t counter) {
+  Nonce nonce{};
+  for (int i(0); i != 8; ++i)
+    nonce[nonce.size() - 1 - i] = static_cast<byte>(counter >> (8 * i));
+  return nonce;
+}
+
+// With compression, the last byte of each frame says how the rest is encoded.  A compressed frame's
+// marker is 'kFrameCompressed' plus the codec, with 'kFrameNewStream' set if the decompressor must
+// first be reset, and is preceded by the uncompressed size as 4 bytes big-endian.  The payload of
+// the hello which each end sends at Start lists the codecs it can decompress.
+const byte kFrameUncompressed = 0;
+const byte kFrameCompressionHello = 1;
+const byte kFrameCompressed = 0x10;
+const byte kFrameNewStream = 0x80;
+const size_t kCompressedTrailerSize = 5;
+// Frames sent as they are after one proves incompressible, before compression is tried again.
+const size_t kIncompressibleBackoff = 8;
+
+bool StreamCodecAvailable(crypto::CompressionCodec codec) {
+  return (codec == crypto::CompressionCodec::kLz4 || codec == crypto::CompressionCodec::kZstd) &&
+         crypto::CompressionCodecAvailable(codec);
+}
+
+void WriteHeader(size_t data_size, unsigned char frame_type,
+                 std::array<unsigned char, 4>& size_buffer) {
+  const Connection::DataSize header{static_cast<Connection::DataSize>(data_size) |
+                                    (static_cast<Connection::DataSize>(frame_type) << 30)};
+  for (int i = 0; i != 4; ++i)
+    size_buffer[i] = static_cast<char>(header >> (8 * (3 - i)));
+}
+
+// Runs the attempts of a single AsyncConnect call.  All handlers run via the strand.
+class Connector : public std::enable_shared_from_this<Connector> {
+ public:
+  Connector(asio::io_service::strand& strand, std::vector<ip::tcp::endpoint> endpoints,
+            Connection::ConnectHandler handler)
+      : strand_(strand),
+        endpoints_(std::move(endpoints)),
+        handler_(std::move(handler)),
+        timeout_timer_(strand_.context()),
+        attempt_timer_(strand_.context()),
+        attempts_(),
+        next_endpoint_(0),
+        failed_count_(0),
+        finished_(false) {}
+
+  void Start(std::chrono::steady_clock::duration timeout) {
+    std::shared_ptr<Connector> this_ptr{shared_from_this()};
+    timeout_timer_.expires_after(timeout);
+    timeout_timer_.async_wait(strand_.wrap([this_ptr](const std::error_code& ec) {
+      if (ec != asio::error::operation_aborted)
+        this_ptr->Finish(make_error_code(VaultManagerErrors::timed_out), nullptr);
+    }));
+    StartNextAttempt();
+  }
+
+ private:
+  void StartNextAttempt() {
+    if (finished_ || next_endpoint_ == endpoints_.size())
+      return;
+    ConnectionPtr connection{Connection::MakeShared(strand_)};
+    attempts_.push_back(connection);
+    std::shared_ptr<Connector> this_ptr{shared_from_this()};
+    connection->Socket().async_connect(
+        endpoints_[next_endpoint_++],
+        strand_.wrap([this_ptr, connection](const std::error_code& ec) {
+          this_ptr->HandleConnect(connection, ec);
+        }));
+
+    // Start the next attempt early if this one is slow.
+    attempt_timer_.expires_after(Connection::AttemptDelay());
+    attempt_timer_.async_wait(strand_.wrap([this_ptr](const std::error_code& ec) {
+      if (ec != asio::error::operation_aborted)
+        this_ptr->StartNextAttempt();
+    }));
+  }
+
+  void HandleConnect(ConnectionPtr connection, const std::error_code& ec) {
+    if (finished_)
+      return;
+    if (!ec)
+      return Finish(std::error_code{}, std::move(connection));
+
+    LOG(kVerbose) << "Connection attempt failed: " << ec.message();
+    attempts_.erase(std::remove(std::begin(attempts_), std::end(attempts_), connection),
+                    std::end(attempts_));
+    if (++failed_count_ == endpoints_.size())
+      return Finish(make_error_code(VaultManagerErrors::failed_to_connect), nullptr);
+    // No attempt is in progress, so don't wait for the attempt timer.
+    if (attempts_.empty()) {
+      std::error_code ignored_ec;
+      attempt_timer_.cancel(ignored_ec);
+      StartNextAttempt();
+    }
+  }
+
+  void Finish(std::error_code ec, ConnectionPtr connection) {
+    if (finished_)
+      return;
+    finished_ = true;
+    std::error_code ignored_ec;
+    timeout_timer_.cancel(ignored_ec);
+    attempt_timer_.cancel(ignored_ec);
+    for (const auto& attempt : attempts_) {
+      if (attempt != connection)
+        attempt->Socket().close(ignored_ec);
+    }
+    attempts_.clear();
+    Connection::ConnectHandler handler{std::move(handler_)};
+    asio::post(strand_, [handler, ec, connection] { handler(ec, connection); });
+  }
+
+  asio::io_service::strand& strand_;
+  const std::vector<ip::tcp::endpoint> endpoints_;
+  Connection::ConnectHandler handler_;
+  asio::steady_timer timeout_timer_, attempt_timer_;
+  std::vector<ConnectionPtr> attempts_;
+  size_t next_endpoint_, failed_count_;
+  bool finished_;
+};
+
+// Reorders 'endpoints' so that the address families alternate, starting with the first one's.
+std::vector<ip::tcp::endpoint> InterleaveFamilies(const std::vector<ip::tcp::endpoint>& endpoints) {
+  std::vector<ip::tcp::endpoint> first_family, other_family, interleaved;
+  for (const auto& endpoint : endpoints) {
+    if (endpoint.protocol() == endpoints.front().protocol())
+      first_family.push_back(endpoint);
+    else
+      other_family.push_back(endpoint);
+  }
+  for (size_t i(0); i < std::max(first_family.size(), other_family.size()); ++i) {
+    if (i < first_family.size())
+      interleaved.push_back(first_family[i]);
+    if (i < other_family.size())
+      interleaved.push_back(other_family[i]);
+  }
+  return interleaved;
+}
+
+}  // unnamed namespace
+
 Connection::Connection(asio::io_service::strand& strand)
     : strand_(strand),
       start_flag_(),
       socket_close_flag_(),
       socket_(strand_.context()),
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+      local_socket_(strand_.context()),
+#endif
       on_message_received_(),
       on_connection_closed_(),
+      on_fragment_received_(),
+      on_pooled_message_received_(),
+      executor_(),
+      max_message_size_(MaxMessageSize()),
+      stats_(),
       receiving_message_(),
-      send_queue_() {
+      send_queue_(),
+      send_buffers_(),
+      in_flight_count_(0),
+      send_limits_mutex_(),
+      send_limits_(),
+      on_send_queue_drained_(),
+      queued_bytes_(0),
+      queued_messages_(0),
+      send_refused_(false),
+      memory_account_(),
+      send_error_(),
+      received_(),
+      pending_receive_(),
+      receive_closed_(false),
+      encrypted_(false),
+      send_key_(),
+      receive_key_(),
+      send_counter_(0),
+      receive_counter_(0),
+      compressing_(false),
+      compression_options_(),
+      compressor_(),
+      decompressor_(),
+      compression_backoff_(0),
+      idle_wheel_(),
+      idle_timeout_(),
+      idle_timer_(0),
+      last_activity_(),
+      rate_limiters_(),
+      read_timer_(strand_.context()) {
   static_assert((sizeof(DataSize)) == 4, "DataSize must be 4 bytes.");
+  static_assert(std::tuple_size<EncryptionKey>::value == crypto::AES256_KeySize,
+                "EncryptionKey must hold an AES-256 key.");
   assert(!socket_.is_open());
 }
 
-Connection::Connection(asio::io_service::strand& strand, Port remote_port)
+Connection::Connection(asio::io_service::strand& strand, Port remote_port, Transport preferred)
     : strand_(strand),
       start_flag_(),
       socket_close_flag_(),
       socket_(strand_.context()),
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+      local_socket_(strand_.context()),
+#endif
       on_message_received_(),
       on_connection_closed_(),
+      on_fragment_received_(),
+      on_pooled_message_received_(),
+      executor_(),
+      max_message_size_(MaxMessageSize()),
+      stats_(),
       receiving_message_(),
-      send_queue_() {
+      send_queue_(),
+      send_buffers_(),
+      in_flight_count_(0),
+      send_limits_mutex_(),
+      send_limits_(),
+      on_send_queue_drained_(),
+      queued_bytes_(0),
+      queued_messages_(0),
+      send_refused_(false),
+      memory_account_(),
+      send_error_(),
+      received_(),
+      pending_receive_(),
+      receive_closed_(false),
+      encrypted_(false),
+      send_key_(),
+      receive_key_(),
+      send_counter_(0),
+      receive_counter_(0),
+      compressing_(false),
+      compression_options_(),
+      compressor_(),
+      decompressor_(),
+      compression_backoff_(0),
+      idle_wheel_(),
+      idle_timeout_(),
+      idle_timer_(0),
+      last_activity_(),
+      rate_limiters_(),
+      read_timer_(strand_.context()) {
+  if (preferred == Transport::kLocal && ConnectLocal(remote_port))
+    return;
   std::error_code connect_error;
   // Try IPv6 first.
   socket_.connect(ip::tcp::endpoint{ip::address_v6::loopback(), remote_port}, connect_error);
@@ -74,46 +312,138 @@ Connection::Connection(asio::io_service::strand& strand, Port remote_port)
   }
 }
 
+Connection::~Connection() {
+  if (memory_account_)
+    memory_account_->Release(queued_bytes_);
+}
+
 ConnectionPtr Connection::MakeShared(asio::io_service::strand& strand) {
   return ConnectionPtr{new Connection{strand}};
 }
 
 ConnectionPtr Connection::MakeShared(asio::io_service::strand& strand, Port remote_port) {
-  return ConnectionPtr{new Connection{strand, remote_port}};
+  return ConnectionPtr{new Connection{strand, remote_port, Transport::kTcp}};
+}
+
+ConnectionPtr Connection::MakeShared(asio::io_service::strand& strand, Port remote_port,
+                                     Transport preferred) {
+  return ConnectionPtr{new Connection{strand, remote_port, preferred}};
+}
+
+Connection::Transport Connection::transport() const {
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  if (local_socket_.is_open())
+    return Transport::kLocal;
+#endif
+  return Transport::kTcp;
+}
+
+std::string Connection::LocalEndpointPath(Port port) {
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+  return std::string(1, '\0') + "maidsafe_tcp_" + std::to_string(port);
+#else
+  return (boost::filesystem::temp_directory_path() /
+          ("maidsafe_tcp_" + std::to_string(port) + ".sock")).string();
+#endif
+}
+
+bool Connection::ConnectLocal(Port remote_port) {
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  std::error_code connect_error;
+  local_socket_.connect(asio::local::stream_protocol::endpoint{LocalEndpointPath(remote_port)},
+                        connect_error);
+  if (!connect_error)
+    return true;
+  LOG(kVerbose) << "No local endpoint for port " << remote_port << ": "
+                << connect_error.message();
+  std::error_code ignored_ec;
+  local_socket_.close(ignored_ec);
+#else
+  static_cast<void>(remote_port);
+#endif
+  return false;
+}
+
+void Connection::AsyncConnect(asio::io_service::strand& strand,
+                              std::vector<ip::tcp::endpoint> endpoints,
+                              std::chrono::steady_clock::duration timeout,
+                              ConnectHandler handler) {
+  if (endpoints.empty() || !handler)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  std::make_shared<Connector>(strand, InterleaveFamilies(endpoints), std::move(handler))
+      ->Start(timeout);
 }
 
 void Connection::Start(MessageReceivedFunctor on_message_received,
-                       ConnectionClosedFunctor on_connection_closed) {
+                       ConnectionClosedFunctor on_connection_closed, Executor executor) {
   std::call_once(start_flag_, [=] {
     on_message_received_ = on_message_received;
     on_connection_closed_ = on_connection_closed;
+    executor_ = executor;
+    if (compressing_)
+      SendCompressionHello();
     ConnectionPtr this_ptr{shared_from_this()};
-    asio::dispatch(strand_, [this_ptr] { this_ptr->ReadSize(); });
+    asio::dispatch(strand_, [this_ptr] {
+      this_ptr->ArmIdleTimer(this_ptr->idle_timeout_);
+      this_ptr->ReadSize();
+    });
   });
 }
 
 void Connection::Close() {
   ConnectionPtr this_ptr{shared_from_this()};
-  asio::post(strand_, [this_ptr] { this_ptr->DoClose(); });
+  asio::post(strand_, [this_ptr] { this_ptr->DoClose(Stats::CloseReason::kLocal); });
 }
 
-void Connection::DoClose() {
-  std::call_once(socket_close_flag_, [this] {
+void Connection::DoClose(Stats::CloseReason reason) {
+  std::call_once(socket_close_flag_, [this, reason] {
+    if (stats_)
+      stats_->RecordClose(reason);
+    if (idle_wheel_)
+      idle_wheel_->Cancel(idle_timer_.exchange(0));
     std::error_code ignored_ec;
+    read_timer_.cancel(ignored_ec);
     socket_.shutdown(asio::ip::tcp::socket::shutdown_send, ignored_ec);
     socket_.close(ignored_ec);
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+    local_socket_.shutdown(asio::local::stream_protocol::socket::shutdown_send, ignored_ec);
+    local_socket_.close(ignored_ec);
+#endif
     if (on_connection_closed_)
       on_connection_closed_();
   });
 }
 
+template <typename Buffers, typename Handler>
+void Connection::AsyncRead(const Buffers& buffers, Handler handler) {
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  if (local_socket_.is_open()) {
+    asio::async_read(local_socket_, buffers, std::move(handler));
+    return;
+  }
+#endif
+  asio::async_read(socket_, buffers, std::move(handler));
+}
+
+template <typename Buffers, typename Handler>
+void Connection::AsyncWrite(const Buffers& buffers, Handler handler) {
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  if (local_socket_.is_open()) {
+    asio::async_write(local_socket_, buffers, std::move(handler));
+    return;
+  }
+#endif
+  asio::async_write(socket_, buffers, std::move(handler));
+}
+
 void Connection::ReadSize() {
   ConnectionPtr this_ptr{shared_from_this()};
-  asio::async_read(socket_, asio::buffer(receiving_message_.size_buffer),
-                   [this_ptr](const std::error_code& ec, size_t bytes_transferred) {
+  AsyncRead(asio::buffer(receiving_message_.size_buffer),
+            [this_ptr](const std::error_code& ec, size_t bytes_transferred) {
     if (ec) {
       LOG(kInfo) << ec.message();
-      return this_ptr->DoClose();
+      return this_ptr->DoClose(ec == asio::error::eof ? Stats::CloseReason::kPeer
+                                                      : Stats::CloseReason::kReadError);
     }
     assert(bytes_transferred == 4U);
     static_cast<void>(bytes_transferred);
@@ -125,85 +455,679 @@ void Connection::ReadSize() {
                   this_ptr->receiving_message_.size_buffer[2])
                  << 8) |
                 this_ptr->receiving_message_.size_buffer[3];
-    if (data_size > MaxMessageSize()) {
-      LOG(kError) << "Incoming message size of " << data_size
-                  << " bytes exceeds maximum allowed of " << MaxMessageSize() << " bytes.";
+    this_ptr->receiving_message_.frame_type = static_cast<unsigned char>(data_size >> 30);
+    data_size &= kFrameSizeMask;
+    const size_t overhead(this_ptr->FrameOverhead());
+    if (data_size > this_ptr->max_message_size_ + overhead) {
+      LOG(kError) << "Incoming message size of " << data_size - overhead
+                  << " bytes exceeds maximum allowed of " << this_ptr->max_message_size_
+                  << " bytes.";
+      this_ptr->receiving_message_.data_buffer.clear();
+      return this_ptr->DoClose(Stats::CloseReason::kProtocolError);
+    }
+    if (data_size < overhead) {
+      LOG(kError) << "Incoming frame of " << data_size << " bytes is too small.";
+      this_ptr->receiving_message_.data_buffer.clear();
+      return this_ptr->DoClose(Stats::CloseReason::kProtocolError);
+    }
+    if (this_ptr->receiving_message_.frame_type != kWholeMessage &&
+        !this_ptr->on_fragment_received_) {
+      LOG(kError) << "Received a message fragment, but no fragment handler is set.";
       this_ptr->receiving_message_.data_buffer.clear();
-      return this_ptr->DoClose();
+      return this_ptr->DoClose(Stats::CloseReason::kProtocolError);
     }
 
-    this_ptr->receiving_message_.data_buffer.resize(data_size);
+    this_ptr->receiving_message_.pooled =
+        this_ptr->receiving_message_.frame_type == kWholeMessage &&
+        this_ptr->on_pooled_message_received_;
+    if (this_ptr->receiving_message_.pooled)
+      this_ptr->receiving_message_.pooled_buffer = BufferPool::Get(data_size);
+    else
+      this_ptr->receiving_message_.data_buffer.resize(data_size);
     this_ptr->ReadData();
   });
 }
 
 void Connection::ReadData() {
   ConnectionPtr this_ptr{shared_from_this()};
-  asio::async_read(socket_, asio::buffer(receiving_message_.data_buffer),
-                   strand_.wrap([this_ptr](const std::error_code& ec, size_t bytes_transferred) {
-                     if (ec) {
-                       LOG(kError) << "Failed to read message body: " << ec.message();
-                       return this_ptr->DoClose();
-                     }
-                     assert(bytes_transferred == this_ptr->receiving_message_.data_buffer.size());
-                     static_cast<void>(bytes_transferred);
-
-                     // Dispatch the message outside the strand.
-                     Message data{std::begin(this_ptr->receiving_message_.data_buffer),
-                                      std::end(this_ptr->receiving_message_.data_buffer)};
-                     asio::post(this_ptr->strand_,
-                                [=] { this_ptr->on_message_received_(std::move(data)); });
-                     asio::dispatch(this_ptr->strand_, [this_ptr] { this_ptr->ReadSize(); });
-                   }));
-}
-
-void Connection::Send(Message data) {
-  SendingMessage message(EncodeData(std::move(data)));
+  const asio::mutable_buffer body{
+      receiving_message_.pooled
+          ? asio::buffer(receiving_message_.pooled_buffer.data(),
+                         receiving_message_.pooled_buffer.size())
+          : asio::buffer(receiving_message_.data_buffer)};
+  AsyncRead(body,
+            strand_.wrap([this_ptr](const std::error_code& ec, size_t bytes_transferred) {
+              if (ec) {
+                LOG(kError) << "Failed to read message body: " << ec.message();
+                return this_ptr->DoClose(Stats::CloseReason::kReadError);
+              }
+              const size_t frame_bytes(this_ptr->receiving_message_.size_buffer.size() +
+                                       bytes_transferred);
+              if (this_ptr->stats_)
+                this_ptr->stats_->RecordReceived(frame_bytes);
+              if (this_ptr->idle_wheel_)
+                this_ptr->last_activity_ = std::chrono::steady_clock::now();
+              if (this_ptr->encrypted_) {
+                if (!this_ptr->DecryptReceivedMessage())
+                  return this_ptr->DoClose(Stats::CloseReason::kProtocolError);
+                bytes_transferred -= EncryptionOverhead();
+              }
+              if (this_ptr->compressing_) {
+                bool is_hello(false);
+                if (!this_ptr->DecompressReceivedMessage(is_hello))
+                  return this_ptr->DoClose(Stats::CloseReason::kProtocolError);
+                if (is_hello)
+                  return this_ptr->ReadNext(frame_bytes);
+                bytes_transferred = this_ptr->receiving_message_.pooled
+                                        ? this_ptr->receiving_message_.pooled_buffer.size()
+                                        : this_ptr->receiving_message_.data_buffer.size();
+              }
+
+              // Start reading the next message before delivering this one, so that
+              // reading isn't held up by the handler.  The buffer is moved rather than
+              // copied to the handler; ReadSize allocates a fresh one.
+              if (this_ptr->receiving_message_.pooled) {
+                PooledBuffer data{std::move(this_ptr->receiving_message_.pooled_buffer)};
+                assert(bytes_transferred == data.size());
+                this_ptr->ReadNext(frame_bytes);
+                return this_ptr->DeliverPooledMessage(std::move(data));
+              }
+              Message data{std::move(this_ptr->receiving_message_.data_buffer)};
+              assert(bytes_transferred == data.size());
+              const unsigned char frame_type{this_ptr->receiving_message_.frame_type};
+              this_ptr->receiving_message_.data_buffer.clear();
+              this_ptr->ReadNext(frame_bytes);
+              this_ptr->DeliverMessage(std::move(data), frame_type);
+            }));
+}
+
+void Connection::DeliverMessage(Message data, unsigned char frame_type) {
+  std::shared_ptr<Message> message{std::make_shared<Message>(std::move(data))};
+  ConnectionPtr this_ptr{shared_from_this()};
+  std::function<void()> task;
+  if (frame_type == kWholeMessage) {
+    task = [this_ptr, message] { this_ptr->on_message_received_(std::move(*message)); };
+  } else {
+    Fragment fragment{static_cast<Fragment>(frame_type)};
+    task = [this_ptr, message, fragment] {
+      this_ptr->on_fragment_received_(std::move(*message), fragment);
+    };
+  }
+  if (executor_)
+    executor_(std::move(task));
+  else
+    asio::post(strand_, std::move(task));
+}
+
+void Connection::DeliverPooledMessage(PooledBuffer data) {
+  std::shared_ptr<PooledBuffer> message{std::make_shared<PooledBuffer>(std::move(data))};
   ConnectionPtr this_ptr{shared_from_this()};
-  asio::post(strand_, [this_ptr, message] {
+  std::function<void()> task{
+      [this_ptr, message] { this_ptr->on_pooled_message_received_(std::move(*message)); }};
+  if (executor_)
+    executor_(std::move(task));
+  else
+    asio::post(strand_, std::move(task));
+}
+
+bool Connection::Send(Message data) {
+  if (data.empty())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  SendingMessage message(EncodeHeader(data.size(), kWholeMessage));
+  message.data = std::move(data);
+  return DoQueue(std::move(message));
+}
+
+bool Connection::Send(PooledBuffer data) {
+  if (data.empty())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  SendingMessage message(EncodeHeader(data.size(), kWholeMessage));
+  message.pooled_data = std::move(data);
+  return DoQueue(std::move(message));
+}
+
+bool Connection::Send(SharedBuffer data) {
+  if (data.empty())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  SendingMessage message(EncodeHeader(data.size(), kWholeMessage));
+  message.shared_data = std::move(data);
+  return DoQueue(std::move(message));
+}
+
+bool Connection::SendFragment(Message data, Fragment fragment) {
+  SendingMessage message(EncodeHeader(data.size(), static_cast<unsigned char>(fragment)));
+  message.data = std::move(data);
+  return DoQueue(std::move(message));
+}
+
+void Connection::QueueWithHandler(Message data, std::function<void(std::error_code)> on_sent) {
+  if (data.empty())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
+  SendingMessage message(EncodeHeader(data.size(), kWholeMessage));
+  message.data = std::move(data);
+  message.on_sent = on_sent;
+  if (!DoQueue(std::move(message)))
+    on_sent(asio::error::no_buffer_space);
+}
+
+void Connection::Receive(ReceiveHandler handler) {
+  std::call_once(start_flag_, [this] {
+    // These are only invoked by this connection, so needn't keep it alive.
+    on_message_received_ = [this](Message data) { HandleReceived(std::move(data)); };
+    on_connection_closed_ = [this] {
+      ConnectionPtr this_ptr{shared_from_this()};
+      asio::post(strand_, [this_ptr] { this_ptr->HandleReceiveClosed(); });
+    };
+    if (compressing_)
+      SendCompressionHello();
+    ConnectionPtr this_ptr{shared_from_this()};
+    asio::dispatch(strand_, [this_ptr] {
+      this_ptr->ArmIdleTimer(this_ptr->idle_timeout_);
+      this_ptr->ReadSize();
+    });
+  });
+  ConnectionPtr this_ptr{shared_from_this()};
+  asio::post(strand_, [this_ptr, handler] { this_ptr->DoReceive(handler); });
+}
+
+void Connection::DoReceive(ReceiveHandler handler) {
+  if (!received_.empty()) {
+    Message data{std::move(received_.front())};
+    received_.pop_front();
+    handler(std::error_code(), std::move(data));
+  } else if (receive_closed_) {
+    handler(asio::error::eof, Message());
+  } else if (pending_receive_) {
+    handler(asio::error::already_started, Message());
+  } else {
+    pending_receive_ = std::move(handler);
+  }
+}
+
+void Connection::HandleReceived(Message data) {
+  if (!pending_receive_)
+    return received_.push_back(std::move(data));
+  ReceiveHandler handler;
+  handler.swap(pending_receive_);
+  handler(std::error_code(), std::move(data));
+}
+
+void Connection::HandleReceiveClosed() {
+  receive_closed_ = true;
+  if (!pending_receive_)
+    return;
+  ReceiveHandler handler;
+  handler.swap(pending_receive_);
+  handler(asio::error::eof, Message());
+}
+
+void Connection::SetPooledMessageHandler(PooledMessageReceivedFunctor on_message_received) {
+  on_pooled_message_received_ = std::move(on_message_received);
+}
+
+void Connection::SetSendQueueLimits(SendQueueLimits limits, SendQueueDrainedFunctor on_drained) {
+  if ((limits.high_water_bytes != 0 && limits.low_water_bytes > limits.high_water_bytes) ||
+      (limits.high_water_messages != 0 &&
+       limits.low_water_messages > limits.high_water_messages)) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  std::lock_guard<std::mutex> lock{send_limits_mutex_};
+  send_limits_ = limits;
+  on_send_queue_drained_ = std::move(on_drained);
+}
+
+void Connection::SetMemoryBudget(std::shared_ptr<MemoryBudget::Account> account) {
+  std::lock_guard<std::mutex> lock{send_limits_mutex_};
+  memory_account_ = std::move(account);
+}
+
+size_t Connection::queued_bytes() const {
+  std::lock_guard<std::mutex> lock{send_limits_mutex_};
+  return queued_bytes_;
+}
+
+size_t Connection::queued_messages() const {
+  std::lock_guard<std::mutex> lock{send_limits_mutex_};
+  return queued_messages_;
+}
+
+void Connection::SetFragmentHandler(FragmentReceivedFunctor on_fragment_received) {
+  on_fragment_received_ = std::move(on_fragment_received);
+}
+
+void Connection::SetEncryption(const EncryptionKey& send_key, const EncryptionKey& receive_key) {
+  if (send_key == receive_key) {
+    LOG(kError) << "Each direction of an encrypted connection needs its own key.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  send_key_ = send_key;
+  receive_key_ = receive_key;
+  encrypted_ = true;
+}
+
+void Connection::SetCompression(CompressionOptions options) {
+  for (const auto codec : options.codecs) {
+    if (codec == crypto::CompressionCodec::kGzip) {
+      LOG(kError) << "Gzip can't be used to compress a connection.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    }
+  }
+  if (options.zstd_level < 1 || options.zstd_level > 19 || options.lz4_level < 0 ||
+      options.lz4_level > 12) {
+    LOG(kError) << "Compression level out of range.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  options.codecs.erase(std::remove_if(std::begin(options.codecs), std::end(options.codecs),
+                                      [](crypto::CompressionCodec codec) {
+                                        return !StreamCodecAvailable(codec);
+                                      }),
+                       std::end(options.codecs));
+  if (options.codecs.empty())
+    LOG(kWarning) << "None of the requested codecs is available, so frames won't be compressed.";
+  compression_options_ = std::move(options);
+  compressing_ = true;
+}
+
+void Connection::SetIdleTimeout(std::shared_ptr<TimerWheel> wheel,
+                                std::chrono::steady_clock::duration timeout) {
+  if (!wheel || timeout <= std::chrono::steady_clock::duration::zero())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  idle_wheel_ = std::move(wheel);
+  idle_timeout_ = timeout;
+}
+
+void Connection::AddRateLimiter(std::shared_ptr<RateLimiter> limiter) {
+  if (!limiter)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  rate_limiters_.push_back(std::move(limiter));
+}
+
+void Connection::SetMaxMessageSize(size_t max_message_size) {
+  if (max_message_size == 0 || max_message_size > MaxFrameSize())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  max_message_size_ = max_message_size;
+}
+
+bool Connection::DoQueue(SendingMessage message) {
+  {
+    std::lock_guard<std::mutex> lock{send_limits_mutex_};
+    if ((send_limits_.high_water_bytes != 0 &&
+         queued_bytes_ >= send_limits_.high_water_bytes) ||
+        (send_limits_.high_water_messages != 0 &&
+         queued_messages_ >= send_limits_.high_water_messages)) {
+      send_refused_ = true;
+      return false;
+    }
+    const size_t wire_size{WireSize(message)};
+    if (memory_account_) {
+      if (memory_account_->pressure() >= MemoryBudget::Pressure::kCritical)
+        return false;
+      memory_account_->Charge(wire_size);
+    }
+    queued_bytes_ += wire_size;
+    ++queued_messages_;
+    if (stats_)
+      stats_->RecordSendQueueDepth(queued_bytes_, queued_messages_);
+  }
+  message.trace_context = trace::CurrentContext();
+  if (message.trace_context.IsValid())
+    message.queued = std::chrono::steady_clock::now();
+  // The handler must be copyable, so hold the message by pointer to avoid copying the payload.
+  std::shared_ptr<SendingMessage> queued{std::make_shared<SendingMessage>(std::move(message))};
+  ConnectionPtr this_ptr{shared_from_this()};
+  asio::post(strand_, [this_ptr, queued] {
+    if (this_ptr->send_error_) {
+      if (queued->on_sent)
+        queued->on_sent(this_ptr->send_error_);
+      return this_ptr->Dequeued(this_ptr->WireSize(*queued), 1);
+    }
+    // Frames are compressed and encrypted in the order in which they'll be written, so that the
+    // receiver's decompressor and counter stay in step.  The compression hello already has its
+    // trailer.
+    if (this_ptr->compressing_ && queued->trailer_size == 0)
+      this_ptr->CompressMessage(*queued);
+    if (this_ptr->encrypted_)
+      this_ptr->EncryptMessage(*queued);
     bool currently_sending{!this_ptr->send_queue_.empty()};
-    this_ptr->send_queue_.emplace_back(std::move(message));
+    this_ptr->send_queue_.emplace_back(std::move(*queued));
     if (!currently_sending)
       this_ptr->DoSend();
   });
+  return true;
 }
 
 void Connection::DoSend() {
-  std::array<asio::const_buffer, 2> buffers;
-  buffers[0] = asio::buffer(send_queue_.front().size_buffer);
-  buffers[1] = asio::buffer(send_queue_.front().data.data(), send_queue_.front().data.size());
+  // Gather as many of the queued messages as the limits allow into a single write.  Elements of
+  // 'send_queue_' aren't moved by 'emplace_back', so the buffers stay valid while further messages
+  // are queued.
+  assert(in_flight_count_ == 0 && !send_queue_.empty());
+  send_buffers_.clear();
+  size_t total_bytes{0};
+  for (const auto& message : send_queue_) {
+    const size_t message_bytes{message.size_buffer.size() + asio::buffer_size(message.Payload()) +
+                               message.trailer_size};
+    if (in_flight_count_ != 0 &&
+        (in_flight_count_ == MaxSendMessages() || total_bytes + message_bytes > MaxSendBytes())) {
+      break;
+    }
+    send_buffers_.emplace_back(asio::buffer(message.size_buffer));
+    send_buffers_.emplace_back(message.Payload());
+    if (message.trailer_size != 0)
+      send_buffers_.emplace_back(asio::buffer(&message.trailer, message.trailer_size));
+    total_bytes += message_bytes;
+    ++in_flight_count_;
+  }
+
   ConnectionPtr this_ptr{shared_from_this()};
-  asio::async_write(socket_, buffers,
-                    strand_.wrap([this_ptr](const std::error_code& ec, size_t bytes_transferred) {
-                      if (ec) {
-                        LOG(kError) << "Failed to send message: " << ec.message();
-                        return this_ptr->DoClose();
-                      }
-                      assert(bytes_transferred ==
-                             this_ptr->send_queue_.front().size_buffer.size() +
-                                 this_ptr->send_queue_.front().data.size());
-                      static_cast<void>(bytes_transferred);
-
-                      this_ptr->send_queue_.pop_front();
-                      if (!this_ptr->send_queue_.empty())
-                        this_ptr->DoSend();
-                    }));
-}
-
-Connection::SendingMessage Connection::EncodeData(Message data) const {
-  if (data.empty())
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::outside_of_bounds));
-  if (data.size() > MaxMessageSize())
+  const auto write_start(TscClock::now());
+  AsyncWrite(send_buffers_,
+             strand_.wrap([this_ptr, total_bytes, write_start](const std::error_code& ec,
+                                                               size_t bytes_transferred) {
+               if (ec) {
+                 LOG_RATE_LIMITED(kError, 10) << "Failed to send message: " << ec.message();
+                 this_ptr->send_error_ = ec;
+                 for (auto& message : this_ptr->send_queue_) {
+                   if (message.on_sent) {
+                     message.on_sent(ec);
+                     message.on_sent = nullptr;
+                   }
+                 }
+                 return this_ptr->DoClose(Stats::CloseReason::kWriteError);
+               }
+               assert(bytes_transferred == total_bytes);
+               static_cast<void>(bytes_transferred);
+               if (this_ptr->stats_) {
+                 this_ptr->stats_->RecordWrite(total_bytes, this_ptr->in_flight_count_,
+                                               TscClock::now() - write_start);
+               }
+               if (this_ptr->idle_wheel_)
+                 this_ptr->last_activity_ = std::chrono::steady_clock::now();
+
+               auto& send_queue(this_ptr->send_queue_);
+               for (size_t i(0); i != this_ptr->in_flight_count_; ++i) {
+                 if (send_queue[i].on_sent)
+                   send_queue[i].on_sent(std::error_code());
+               }
+               if (trace::IsEnabled()) {
+                 const auto written(std::chrono::steady_clock::now());
+                 for (size_t i(0); i != this_ptr->in_flight_count_; ++i) {
+                   const SendingMessage& sent(send_queue[i]);
+                   trace::RecordSpan("tcp::Connection::Send", sent.trace_context, sent.queued,
+                                     written);
+                 }
+               }
+               send_queue.erase(std::begin(send_queue),
+                                std::begin(send_queue) + this_ptr->in_flight_count_);
+               this_ptr->Dequeued(total_bytes, this_ptr->in_flight_count_);
+               this_ptr->in_flight_count_ = 0;
+               if (!send_queue.empty())
+                 this_ptr->DoSend();
+             }));
+}
+
+void Connection::Dequeued(size_t bytes, size_t messages) {
+  SendQueueDrainedFunctor on_drained;
+  {
+    std::lock_guard<std::mutex> lock{send_limits_mutex_};
+    queued_bytes_ -= bytes;
+    queued_messages_ -= messages;
+    if (memory_account_)
+      memory_account_->Release(bytes);
+    if (!send_refused_ || queued_bytes_ > send_limits_.low_water_bytes ||
+        queued_messages_ > send_limits_.low_water_messages) {
+      return;
+    }
+    send_refused_ = false;
+    on_drained = on_send_queue_drained_;
+  }
+  if (on_drained)
+    on_drained();
+}
+
+asio::const_buffer Connection::SendingMessage::Payload() const {
+  if (!pooled_data.empty())
+    return asio::buffer(pooled_data.data(), pooled_data.size());
+  if (!shared_data.empty())
+    return asio::buffer(shared_data.data(), shared_data.size());
+  return asio::buffer(data);
+}
+
+Connection::SendingMessage Connection::EncodeHeader(size_t data_size,
+                                                    unsigned char frame_type) const {
+  if (data_size > max_message_size_)
+    BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::ipc_message_too_large));
+  // The header gives the size on the wire, assuming the frame isn't compressed.
+  data_size += FrameOverhead();
+  if (data_size > MaxFrameSize())
     BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::ipc_message_too_large));
 
   SendingMessage message;
-  for (int i = 0; i != 4; ++i)
-    message.size_buffer[i] = static_cast<char>(data.size() >> (8 * (3 - i)));
-  message.data = std::move(data);
-
+  WriteHeader(data_size, frame_type, message.size_buffer);
   return message;
 }
 
+size_t Connection::WireSize(const SendingMessage& message) const {
+  return message.size_buffer.size() + asio::buffer_size(message.Payload()) + FrameOverhead();
+}
+
+size_t Connection::FrameOverhead() const {
+  return (encrypted_ ? EncryptionOverhead() : 0) + (compressing_ ? 1 : 0);
+}
+
+void Connection::EncryptMessage(SendingMessage& message) {
+  const asio::const_buffer payload(message.Payload());
+  const byte* plaintext(static_cast<const byte*>(payload.data()));
+  const size_t size(asio::buffer_size(payload) + message.trailer_size);
+  PooledBuffer ciphertext(BufferPool::Get(size + EncryptionOverhead()));
+  if (message.trailer_size != 0) {
+    // The trailer is encrypted with the payload, so the two are joined and encrypted in place.
+    std::copy(plaintext, plaintext + asio::buffer_size(payload), ciphertext.data());
+    ciphertext.data()[size - 1] = message.trailer;
+    plaintext = ciphertext.data();
+    message.trailer_size = 0;
+  }
+  const Nonce nonce(MakeNonce(send_counter_++));
+  crypto::SymmEncrypt(plaintext, size, send_key_.data(), nonce.data(), message.size_buffer.data(),
+                      message.size_buffer.size(), ciphertext.data());
+  message.data = Message();
+  message.shared_data = SharedBuffer();
+  message.pooled_data = std::move(ciphertext);
+}
+
+bool Connection::DecryptReceivedMessage() {
+  ReceivingMessage& received(receiving_message_);
+  byte* const body(received.pooled ? received.pooled_buffer.data()
+                                   : received.data_buffer.data());
+  const size_t size(received.pooled ? received.pooled_buffer.size()
+                                    : received.data_buffer.size());
+  const Nonce nonce(MakeNonce(receive_counter_++));
+  try {
+    crypto::SymmDecrypt(body, size, receive_key_.data(), nonce.data(),
+                        received.size_buffer.data(), received.size_buffer.size(), body);
+  } catch (const maidsafe_error&) {
+    LOG(kError) << "Received message failed verification.";
+    return false;
+  }
+  if (received.pooled)
+    received.pooled_buffer.Truncate(size - EncryptionOverhead());
+  else
+    received.data_buffer.resize(size - EncryptionOverhead());
+  return true;
+}
+
+void Connection::SendCompressionHello() {
+  Message codecs;
+  for (const auto codec : {crypto::CompressionCodec::kZstd, crypto::CompressionCodec::kLz4}) {
+    if (StreamCodecAvailable(codec))
+      codecs.push_back(static_cast<byte>(codec));
+  }
+  SendingMessage message(EncodeHeader(codecs.size(), kWholeMessage));
+  message.data = std::move(codecs);
+  message.trailer = kFrameCompressionHello;
+  message.trailer_size = 1;
+  DoQueue(std::move(message));
+}
+
+void Connection::CompressMessage(SendingMessage& message) {
+  const asio::const_buffer payload(message.Payload());
+  const byte* const input(static_cast<const byte*>(payload.data()));
+  const size_t size(asio::buffer_size(payload));
+  PooledBuffer compressed;
+  if (compressor_ && size != 0 && size >= compression_options_.min_frame_size) {
+    if (compression_backoff_ != 0) {
+      --compression_backoff_;
+    } else {
+      const bool new_stream(compressor_->at_stream_start());
+      compressed = BufferPool::Get(compressor_->Bound(size) + kCompressedTrailerSize);
+      const size_t compressed_size(compressor_->Compress(input, size, compressed.data()));
+      if (compressed_size + kCompressedTrailerSize < size + 1) {
+        byte* const trailer(compressed.data() + compressed_size);
+        for (int i(0); i != 4; ++i)
+          trailer[i] = static_cast<byte>(size >> (8 * (3 - i)));
+        trailer[4] = static_cast<byte>(kFrameCompressed |
+                                       static_cast<byte>(compressor_->codec()) |
+                                       (new_stream ? kFrameNewStream : 0));
+        compressed.Truncate(compressed_size + kCompressedTrailerSize);
+      } else {
+        // The peer never sees this output, so both ends start a new stream.
+        compressor_->Reset();
+        compression_backoff_ = kIncompressibleBackoff;
+        compressed = PooledBuffer();
+      }
+    }
+  }
+
+  if (compressed.empty()) {
+    message.trailer = kFrameUncompressed;
+    message.trailer_size = 1;
+    if (stats_)
+      stats_->RecordCompression(size, size + 1);
+    return;
+  }
+  const size_t compressed_size(compressed.size());
+  if (stats_)
+    stats_->RecordCompression(size, compressed_size);
+  WriteHeader(compressed_size + (encrypted_ ? EncryptionOverhead() : 0),
+              static_cast<unsigned char>(message.size_buffer[0] >> 6), message.size_buffer);
+  message.data = Message();
+  message.shared_data = SharedBuffer();
+  message.pooled_data = std::move(compressed);
+  // The message was queued at its uncompressed size.
+  Dequeued(size + 1 - compressed_size, 0);
+}
+
+bool Connection::DecompressReceivedMessage(bool& is_hello) {
+  ReceivingMessage& received(receiving_message_);
+  const byte* const body(received.pooled ? received.pooled_buffer.data()
+                                         : received.data_buffer.data());
+  const size_t size(received.pooled ? received.pooled_buffer.size()
+                                    : received.data_buffer.size());
+  // ReadSize has checked that there's at least the marker.
+  const byte marker(body[size - 1]);
+  if (marker == kFrameUncompressed) {
+    if (received.pooled)
+      received.pooled_buffer.Truncate(size - 1);
+    else
+      received.data_buffer.resize(size - 1);
+    return true;
+  }
+
+  if (marker == kFrameCompressionHello) {
+    if (received.frame_type != kWholeMessage) {
+      LOG(kError) << "Received a fragmented compression hello.";
+      return false;
+    }
+    is_hello = true;
+    compressor_.reset();
+    for (const auto codec : compression_options_.codecs) {
+      if (std::find(body, body + size - 1, static_cast<byte>(codec)) != body + size - 1) {
+        compressor_.reset(new detail::StreamCompressor(
+            codec, codec == crypto::CompressionCodec::kZstd ? compression_options_.zstd_level
+                                                            : compression_options_.lz4_level));
+        break;
+      }
+    }
+    return true;
+  }
+
+  const crypto::CompressionCodec codec(static_cast<crypto::CompressionCodec>(marker & 0x0F));
+  if ((marker & 0x70) != kFrameCompressed || size < kCompressedTrailerSize ||
+      !StreamCodecAvailable(codec)) {
+    LOG(kError) << "Received a frame with an invalid compression marker.";
+    return false;
+  }
+  size_t original_size(0);
+  for (size_t i(size - kCompressedTrailerSize); i != size - 1; ++i)
+    original_size = (original_size << 8) | body[i];
+  if (original_size == 0 || original_size > max_message_size_) {
+    LOG(kError) << "Received compressed frame of invalid size " << original_size;
+    return false;
+  }
+  if (marker & kFrameNewStream) {
+    if (decompressor_ && decompressor_->codec() == codec)
+      decompressor_->Reset();
+    else
+      decompressor_.reset(new detail::StreamDecompressor(codec));
+  } else if (!decompressor_ || decompressor_->codec() != codec) {
+    LOG(kError) << "Received a compressed frame without the start of its stream.";
+    return false;
+  }
+
+  const size_t compressed_size(size - kCompressedTrailerSize);
+  if (received.pooled) {
+    PooledBuffer original(BufferPool::Get(original_size));
+    if (!decompressor_->Decompress(body, compressed_size, original.data(), original_size))
+      return false;
+    received.pooled_buffer = std::move(original);
+  } else {
+    Message original(original_size);
+    if (!decompressor_->Decompress(body, compressed_size, original.data(), original_size))
+      return false;
+    received.data_buffer = std::move(original);
+  }
+  return true;
+}
+
+void Connection::ArmIdleTimer(std::chrono::steady_clock::duration delay) {
+  if (!idle_wheel_)
+    return;
+  if (last_activity_ == std::chrono::steady_clock::time_point())
+    last_activity_ = std::chrono::steady_clock::now();
+  // The timer mustn't keep the connection alive.
+  std::weak_ptr<Connection> weak_this{shared_from_this()};
+  idle_timer_ = idle_wheel_->Schedule(delay, [weak_this] {
+    ConnectionPtr this_ptr{weak_this.lock()};
+    if (this_ptr)
+      asio::post(this_ptr->strand_, [this_ptr] { this_ptr->CheckIdle(); });
+  });
+}
+
+void Connection::CheckIdle() {
+  // If the connection has closed in the meantime, DoClose does nothing, and the timer stops once
+  // the timeout has passed since the last activity.
+  const auto idle(std::chrono::steady_clock::now() - last_activity_);
+  if (idle >= idle_timeout_)
+    return DoClose(Stats::CloseReason::kIdleTimeout);
+  ArmIdleTimer(idle_timeout_ - idle);
+}
+
+void Connection::ReadNext(size_t frame_bytes) {
+  std::chrono::steady_clock::duration wait{std::chrono::steady_clock::duration::zero()};
+  for (const auto& limiter : rate_limiters_)
+    wait = std::max(wait, limiter->Consume(frame_bytes, 1));
+  if (wait == std::chrono::steady_clock::duration::zero())
+    return ReadSize();
+
+  if (stats_)
+    stats_->RecordThrottle();
+  ConnectionPtr this_ptr{shared_from_this()};
+  read_timer_.expires_after(wait);
+  read_timer_.async_wait(strand_.wrap([this_ptr](const std::error_code& ec) {
+    if (!ec)
+      this_ptr->ReadSize();
+  }));
+}
+
 }  // namespace tcp
 
 }  // namespace maidsafe
@@ -18,14 +18,20 @@
 
 #include "maidsafe/common/tcp/listener.h"
 
+#include <algorithm>
 #include <condition_variable>
+#include <cstdio>
 #include <limits>
+#include <utility>
 
+#include "asio/detail/socket_option.hpp"
+#include "asio/error.hpp"
 #include "asio/post.hpp"
 #include "asio/wrap.hpp"
 
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/make_unique.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/tcp/connection.h"
 
@@ -33,59 +39,124 @@ namespace maidsafe {
 
 namespace tcp {
 
-Listener::Listener(asio::io_service::strand& strand, NewConnectionFunctor on_new_connection)
-    : strand_(strand),
-      stop_listening_flag_(),
+namespace {
+
+#if defined(SO_REUSEPORT) && !defined(MAIDSAFE_WIN32)
+using ReusePort = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+const bool kReusePortSupported(true);
+#else
+const bool kReusePortSupported(false);
+#endif
+
+}  // unnamed namespace
+
+Listener::Listener(const std::vector<asio::io_service::strand*>& strands,
+                   NewConnectionFunctor on_new_connection, std::shared_ptr<Stats> stats)
+    : stop_listening_flag_(),
       on_new_connection_(on_new_connection),
-      acceptor_(strand.context()) {}
+      acceptors_(),
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+      local_acceptor_(),
+      local_path_(),
+#endif
+      stats_(std::move(stats)),
+      rate_limiter_(),
+      accept_mutex_(),
+      accepted_(),
+      pending_accept_(),
+      accept_stopped_(false) {
+  if (strands.empty() || std::find(std::begin(strands), std::end(strands), nullptr) !=
+                             std::end(strands)) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  if (strands.size() > 1 && !kReusePortSupported)
+    LOG(kWarning) << "SO_REUSEPORT isn't supported; using a single acceptor.";
+  for (auto strand : strands) {
+    acceptors_.emplace_back(maidsafe::make_unique<Acceptor>(*strand));
+    if (!kReusePortSupported)
+      break;
+  }
+}
 
 ListenerPtr Listener::MakeShared(asio::io_service::strand& strand,
-                                 NewConnectionFunctor on_new_connection, Port desired_port) {
-  ListenerPtr listener{new Listener{strand, on_new_connection}};
+                                 NewConnectionFunctor on_new_connection, Port desired_port,
+                                 std::shared_ptr<Stats> stats) {
+  return MakeShared(std::vector<asio::io_service::strand*>{&strand}, on_new_connection,
+                    desired_port, std::move(stats));
+}
+
+ListenerPtr Listener::MakeShared(const std::vector<asio::io_service::strand*>& strands,
+                                 NewConnectionFunctor on_new_connection, Port desired_port,
+                                 std::shared_ptr<Stats> stats) {
+  ListenerPtr listener{new Listener{strands, on_new_connection, std::move(stats)}};
   listener->StartListening(desired_port);
   return listener;
 }
 
-Port Listener::ListeningPort() const { return acceptor_.local_endpoint().port(); }
+Port Listener::ListeningPort() const {
+  return acceptors_.front()->acceptor.local_endpoint().port();
+}
 
 void Listener::StartListening(Port desired_port) {
+  Acceptor& first(*acceptors_.front());
   unsigned attempts{0};
   while (attempts <= kMaxRangeAboveDefaultPort &&
-         desired_port + attempts <= std::numeric_limits<Port>::max() && !acceptor_.is_open()) {
+         desired_port + attempts <= std::numeric_limits<Port>::max() && !first.acceptor.is_open()) {
     try {
-      DoStartListening(static_cast<Port>(desired_port + attempts));
+      DoStartListening(first, static_cast<Port>(desired_port + attempts));
     } catch (const std::exception& e) {
       LOG(kWarning) << "Failed to start listening on port " << desired_port + attempts << ": "
                     << boost::diagnostic_information(e);
       ++attempts;
     }
   }
-  if (!acceptor_.is_open()) {
+  if (!first.acceptor.is_open()) {
     LOG(kError) << "Failed to start listening on any port in the range [" << desired_port << ", "
                 << desired_port + attempts << "]";
     BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::failed_to_listen));
   }
+
+  // The remaining acceptors share the first one's port.
+  const asio::ip::tcp::endpoint endpoint{first.acceptor.local_endpoint()};
+  for (size_t i(1); i < acceptors_.size(); ++i) {
+    try {
+      Open(*acceptors_[i], endpoint);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to add acceptor on port " << endpoint.port() << ": "
+                  << boost::diagnostic_information(e);
+      for (const auto& acceptor : acceptors_) {
+        std::error_code ec;
+        acceptor->acceptor.close(ec);
+      }
+      BOOST_THROW_EXCEPTION(MakeError(VaultManagerErrors::failed_to_listen));
+    }
+  }
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  StartLocalListening(endpoint.port());
+#endif
 }
 
-void Listener::DoStartListening(Port port) {
+void Listener::DoStartListening(Acceptor& acceptor, Port port) {
   // Try IPv6 first.
-  asio::ip::tcp::endpoint endpoint{asio::ip::address_v6::loopback(), port};
-  on_scope_exit cleanup_on_error([&] {
-    std::error_code ec;
-    acceptor_.close(ec);
-  });
-
   try {
-    acceptor_.open(endpoint.protocol());
+    Open(acceptor, asio::ip::tcp::endpoint{asio::ip::address_v6::loopback(), port});
   } catch (const std::system_error& error) {
     if (error.code() == std::make_error_code(std::errc::address_family_not_supported)) {
       // Try IPv4 now.
-      endpoint = asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), port};
-      acceptor_.open(endpoint.protocol());
+      Open(acceptor, asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), port});
     } else {
       throw;
     }
   }
+}
+
+void Listener::Open(Acceptor& acceptor, const asio::ip::tcp::endpoint& endpoint) {
+  on_scope_exit cleanup_on_error([&] {
+    std::error_code ec;
+    acceptor.acceptor.close(ec);
+  });
+
+  acceptor.acceptor.open(endpoint.protocol());
 
 // Below option is interpreted differently by Windows and shouldn't be used.  On, Windows, this
 // will allow two processes to listen on the same port.  On a POSIX-compliant OS, this option
@@ -96,54 +167,194 @@ void Listener::DoStartListening(Port port) {
 // http://www.unixguide.net/network/socketfaq/4.5.shtml
 // http://old.nabble.com/Port-allocation-problem-on-windows-(incl.-patch)-td28241079.html
 #ifndef MAIDSAFE_WIN32
-  acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+  acceptor.acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
 #endif
-  acceptor_.bind(endpoint);
-  acceptor_.listen(asio::socket_base::max_connections);
+#if defined(SO_REUSEPORT) && !defined(MAIDSAFE_WIN32)
+  // Only needed (and only set) when sharing the port between several acceptors.
+  if (acceptors_.size() > 1)
+    acceptor.acceptor.set_option(ReusePort(true));
+#endif
+  acceptor.acceptor.bind(endpoint);
+  acceptor.acceptor.listen(asio::socket_base::max_connections);
+  StartAccepting(acceptor);
+
+  cleanup_on_error.Release();
+}
 
+void Listener::StartAccepting(Acceptor& acceptor) {
   // The connection object is kept alive in the acceptor handler until HandleAccept() is called.
-  ConnectionPtr connection{Connection::MakeShared(strand_)};
+  ConnectionPtr connection{Connection::MakeShared(acceptor.strand)};
   ListenerPtr this_ptr{shared_from_this()};
-  acceptor_.async_accept(connection->Socket(), strand_.wrap([this_ptr, connection](
-                                                   const std::error_code& error) {
-                                                 this_ptr->HandleAccept(connection, error);
-                                               }));
-
-  cleanup_on_error.Release();
+  Acceptor* acceptor_ptr{&acceptor};
+  acceptor.acceptor.async_accept(
+      connection->Socket(),
+      acceptor.strand.wrap([this_ptr, acceptor_ptr, connection](const std::error_code& error) {
+        this_ptr->HandleAccept(*acceptor_ptr, connection, error);
+      }));
 }
 
-void Listener::HandleAccept(ConnectionPtr accepted_connection, const std::error_code& ec) {
-  if (!acceptor_.is_open() || strand_.context().stopped())
+void Listener::HandleAccept(Acceptor& acceptor, ConnectionPtr accepted_connection,
+                            const std::error_code& ec) {
+  if (!acceptor.acceptor.is_open() || acceptor.strand.context().stopped())
     return;
 
-  if (ec)
+  if (stats_)
+    stats_->RecordAccept(ec);
+  if (ec) {
     LOG(kWarning) << "Error while accepting connection: " << ec.message();
-  else
-    on_new_connection_(accepted_connection);
+  } else {
+    Configure(*accepted_connection);
+    DeliverConnection(accepted_connection);
+  }
 
-  // The connection object is kept alive in the acceptor handler until HandleAccept() is called.
-  ConnectionPtr connection{ Connection::MakeShared(strand_) };
+  StartAccepting(acceptor);
+}
+
+void Listener::SetRateLimiter(std::shared_ptr<RateLimiter> limiter) {
+  std::atomic_store(&rate_limiter_, std::move(limiter));
+}
+
+void Listener::Configure(Connection& accepted_connection) {
+  accepted_connection.SetStats(stats_);
+  std::shared_ptr<RateLimiter> limiter{std::atomic_load(&rate_limiter_)};
+  if (limiter)
+    accepted_connection.AddRateLimiter(std::move(limiter));
+}
+
+bool Listener::AcceptsLocalConnections() const {
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  return local_acceptor_ && local_acceptor_->is_open();
+#else
+  return false;
+#endif
+}
+
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+void Listener::StartLocalListening(Port port) {
+  // Local connections are an optimisation, so failing to accept them isn't an error.
+  try {
+    local_path_ = Connection::LocalEndpointPath(port);
+    // A socket file left by a listener which didn't stop cleanly would make the bind fail.  No live
+    // listener can be using it, since this one holds the TCP port.
+    if (!local_path_.empty() && local_path_[0] != '\0')
+      std::remove(local_path_.c_str());
+    const asio::local::stream_protocol::endpoint endpoint{local_path_};
+    local_acceptor_ = maidsafe::make_unique<asio::local::stream_protocol::acceptor>(
+        acceptors_.front()->strand.context());
+    local_acceptor_->open(endpoint.protocol());
+    local_acceptor_->bind(endpoint);
+    local_acceptor_->listen(asio::socket_base::max_connections);
+    StartLocalAccepting();
+  } catch (const std::exception& e) {
+    LOG(kWarning) << "Not accepting local connections on port " << port << ": "
+                  << boost::diagnostic_information(e);
+    local_acceptor_.reset();
+  }
+}
+
+void Listener::StartLocalAccepting() {
+  asio::io_service::strand& strand(acceptors_.front()->strand);
+  ConnectionPtr connection{Connection::MakeShared(strand)};
   ListenerPtr this_ptr{shared_from_this()};
-  acceptor_.async_accept(connection->Socket(), strand_.wrap([this_ptr, connection](
-                                                   const std::error_code& error) {
-                                                 this_ptr->HandleAccept(connection, error);
-                                               }));
+  local_acceptor_->async_accept(
+      connection->LocalSocket(),
+      strand.wrap([this_ptr, connection](const std::error_code& error) {
+        this_ptr->HandleLocalAccept(connection, error);
+      }));
 }
 
-void Listener::StopListening() {
-  asio::post(strand_.context().get_executor(), [this] { DoStopListening(); });
+void Listener::HandleLocalAccept(ConnectionPtr accepted_connection, const std::error_code& ec) {
+  if (!local_acceptor_->is_open() || acceptors_.front()->strand.context().stopped())
+    return;
+
+  if (stats_)
+    stats_->RecordAccept(ec);
+  if (ec) {
+    LOG(kWarning) << "Error while accepting local connection: " << ec.message();
+  } else {
+    Configure(*accepted_connection);
+    DeliverConnection(accepted_connection);
+  }
+
+  StartLocalAccepting();
 }
 
-void Listener::DoStopListening() {
+void Listener::DoStopLocalListening() {
+  std::error_code ec;
+  if (local_acceptor_->is_open())
+    local_acceptor_->close(ec);
+  if (ec.value() != 0)
+    LOG(kError) << "Local acceptor close error: " << ec.message();
+  if (!local_path_.empty() && local_path_[0] != '\0')
+    std::remove(local_path_.c_str());
+}
+#endif
+
+void Listener::Accept(AcceptHandler handler) {
+  if (on_new_connection_)
+    return handler(asio::error::operation_not_supported, nullptr);
+  std::unique_lock<std::mutex> lock{accept_mutex_};
+  if (!accepted_.empty()) {
+    ConnectionPtr connection{std::move(accepted_.front())};
+    accepted_.pop_front();
+    lock.unlock();
+    handler(std::error_code(), std::move(connection));
+  } else if (accept_stopped_) {
+    lock.unlock();
+    handler(asio::error::operation_aborted, nullptr);
+  } else if (pending_accept_) {
+    lock.unlock();
+    handler(asio::error::already_started, nullptr);
+  } else {
+    pending_accept_ = std::move(handler);
+  }
+}
+
+void Listener::DeliverConnection(ConnectionPtr connection) {
+  if (on_new_connection_)
+    return on_new_connection_(std::move(connection));
+  AcceptHandler handler;
+  {
+    std::lock_guard<std::mutex> lock{accept_mutex_};
+    if (!pending_accept_)
+      return accepted_.push_back(std::move(connection));
+    handler.swap(pending_accept_);
+  }
+  handler(std::error_code(), std::move(connection));
+}
+
+void Listener::StopListening() {
   std::call_once(stop_listening_flag_, [this] {
-    std::error_code ec;
-    if (acceptor_.is_open())
-      acceptor_.close(ec);
-    if (ec.value() != 0)
-      LOG(kError) << "Acceptor close error: " << ec.message();
+    AcceptHandler handler;
+    {
+      std::lock_guard<std::mutex> lock{accept_mutex_};
+      accept_stopped_ = true;
+      handler.swap(pending_accept_);
+    }
+    if (handler)
+      handler(asio::error::operation_aborted, nullptr);
+    for (const auto& acceptor : acceptors_) {
+      Acceptor* acceptor_ptr{acceptor.get()};
+      asio::post(acceptor->strand.context().get_executor(),
+                 [this, acceptor_ptr] { DoStopListening(*acceptor_ptr); });
+    }
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+    if (local_acceptor_) {
+      asio::post(acceptors_.front()->strand.context().get_executor(),
+                 [this] { DoStopLocalListening(); });
+    }
+#endif
   });
 }
 
+void Listener::DoStopListening(Acceptor& acceptor) {
+  std::error_code ec;
+  if (acceptor.acceptor.is_open())
+    acceptor.acceptor.close(ec);
+  if (ec.value() != 0)
+    LOG(kError) << "Acceptor close error: " << ec.message();
+}
+
 }  // namespace tcp
 
 }  // namespace maidsafe
@@ -0,0 +1,68 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/rate_limiter.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace tcp {
+
+RateLimiter::Bucket::Bucket(uint64_t rate_in, uint64_t burst_in)
+    : rate(static_cast<double>(rate_in)),
+      burst(static_cast<double>(burst_in == 0 ? rate_in : burst_in)),
+      tokens(burst) {}
+
+double RateLimiter::Bucket::Take(uint64_t amount, double elapsed) {
+  if (rate <= 0.0)
+    return 0.0;
+  tokens = std::min(burst, tokens + rate * elapsed) - static_cast<double>(amount);
+  return tokens < 0.0 ? -tokens / rate : 0.0;
+}
+
+RateLimiter::RateLimiter(Limits limits)
+    : limits_(limits),
+      mutex_(),
+      last_refill_(Clock::now()),
+      bytes_(limits.bytes_per_second, limits.burst_bytes),
+      messages_(limits.messages_per_second, limits.burst_messages) {
+  if (limits.bytes_per_second == 0 && limits.messages_per_second == 0) {
+    LOG(kError) << "A rate limiter needs a byte or message rate.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+}
+
+RateLimiter::Clock::duration RateLimiter::Consume(uint64_t bytes, uint64_t messages,
+                                                  Clock::time_point now) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  double elapsed(0.0);
+  if (now > last_refill_) {
+    elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    last_refill_ = now;
+  }
+  const double wait(std::max(bytes_.Take(bytes, elapsed), messages_.Take(messages, elapsed)));
+  return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(wait));
+}
+
+}  // namespace tcp
+
+}  // namespace maidsafe
@@ -0,0 +1,79 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/stats.h"
+
+#include <algorithm>
+
+namespace maidsafe {
+
+namespace tcp {
+
+void Stats::RecordReceived(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  snapshot_.bytes_in += bytes;
+  ++snapshot_.messages_in;
+}
+
+void Stats::RecordWrite(uint64_t bytes, uint64_t messages,
+                        std::chrono::steady_clock::duration latency) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  snapshot_.bytes_out += bytes;
+  snapshot_.messages_out += messages;
+  snapshot_.write_latency.Record(latency);
+}
+
+void Stats::RecordSendQueueDepth(uint64_t bytes, uint64_t messages) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  snapshot_.send_queue_bytes_high_water = std::max(snapshot_.send_queue_bytes_high_water, bytes);
+  snapshot_.send_queue_messages_high_water =
+      std::max(snapshot_.send_queue_messages_high_water, messages);
+}
+
+void Stats::RecordClose(CloseReason reason) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++snapshot_.closes[static_cast<size_t>(reason)];
+}
+
+void Stats::RecordAccept(const std::error_code& ec) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (ec)
+    ++snapshot_.accept_errors;
+  else
+    ++snapshot_.accepts;
+}
+
+void Stats::RecordCompression(uint64_t original_bytes, uint64_t compressed_bytes) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  snapshot_.compression_bytes_in += original_bytes;
+  snapshot_.compression_bytes_out += compressed_bytes;
+}
+
+void Stats::RecordThrottle() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++snapshot_.throttles;
+}
+
+Stats::Snapshot Stats::snapshot() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return snapshot_;
+}
+
+}  // namespace tcp
+
+}  // namespace maidsafe
@@ -0,0 +1,302 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/stream_compression.h"
+
+#include <cstring>
+
+#ifdef MAIDSAFE_COMMON_LZ4
+#include "lz4frame.h"
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+#include "zstd.h"
+#endif
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+#ifdef MAIDSAFE_COMMON_ZSTD
+// Limits the history each end of a zstd stream holds to 1 MiB, whatever the compression level.
+const int kZstdWindowLog = 20;
+#endif
+
+void ThrowUnavailable(crypto::CompressionCodec codec) {
+  LOG(kError) << "Compression codec " << static_cast<int>(codec)
+              << " is not available for streaming.";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+#ifdef MAIDSAFE_COMMON_LZ4
+// Linked blocks let each block refer back to the previous 64 KiB of the stream.
+LZ4F_preferences_t Lz4Preferences(int compression_level) {
+  LZ4F_preferences_t preferences;
+  std::memset(&preferences, 0, sizeof(preferences));
+  preferences.compressionLevel = compression_level;
+  preferences.autoFlush = 1;
+  preferences.frameInfo.blockMode = LZ4F_blockLinked;
+  preferences.frameInfo.blockSizeID = LZ4F_max64KB;
+  return preferences;
+}
+#endif
+
+}  // unnamed namespace
+
+StreamCompressor::StreamCompressor(crypto::CompressionCodec codec, int compression_level)
+    : codec_(codec),
+      compression_level_(compression_level),
+      context_(nullptr),
+      at_stream_start_(true) {
+  switch (codec_) {
+#ifdef MAIDSAFE_COMMON_LZ4
+    case crypto::CompressionCodec::kLz4: {
+      LZ4F_cctx* context(nullptr);
+      if (LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION)))
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+      context_ = context;
+      break;
+    }
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+    case crypto::CompressionCodec::kZstd: {
+      ZSTD_CCtx* context(ZSTD_createCCtx());
+      if (!context)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+      ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, compression_level_);
+      ZSTD_CCtx_setParameter(context, ZSTD_c_windowLog, kZstdWindowLog);
+      context_ = context;
+      break;
+    }
+#endif
+    default:
+      ThrowUnavailable(codec_);
+  }
+}
+
+StreamCompressor::~StreamCompressor() {
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4)
+    LZ4F_freeCompressionContext(static_cast<LZ4F_cctx*>(context_));
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd)
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(context_));
+#endif
+}
+
+size_t StreamCompressor::Bound(size_t size) const {
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4) {
+    const LZ4F_preferences_t preferences(Lz4Preferences(compression_level_));
+    return LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(size, &preferences);
+  }
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  return ZSTD_compressBound(size);
+#else
+  return size;
+#endif
+}
+
+size_t StreamCompressor::Compress(const byte* input, size_t size, byte* output) {
+  const size_t capacity(Bound(size));
+  size_t written(0);
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4) {
+    LZ4F_cctx* context(static_cast<LZ4F_cctx*>(context_));
+    const LZ4F_preferences_t preferences(Lz4Preferences(compression_level_));
+    size_t code(0);
+    if (at_stream_start_) {
+      code = LZ4F_compressBegin(context, output, capacity, &preferences);
+      if (!LZ4F_isError(code))
+        written = code;
+    }
+    if (!LZ4F_isError(code)) {
+      code = LZ4F_compressUpdate(context, output + written, capacity - written, input, size,
+                                 nullptr);
+    }
+    if (!LZ4F_isError(code)) {
+      written += code;
+      code = LZ4F_flush(context, output + written, capacity - written, nullptr);
+    }
+    if (LZ4F_isError(code)) {
+      LOG(kError) << "Failed compressing: " << LZ4F_getErrorName(code);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+    }
+    written += code;
+  }
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd) {
+    ZSTD_inBuffer in{input, size, 0};
+    ZSTD_outBuffer out{output, capacity, 0};
+    size_t remaining(0);
+    do {
+      remaining = ZSTD_compressStream2(static_cast<ZSTD_CCtx*>(context_), &out, &in, ZSTD_e_flush);
+      if (ZSTD_isError(remaining)) {
+        LOG(kError) << "Failed compressing: " << ZSTD_getErrorName(remaining);
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+      }
+      if (remaining != 0 && out.pos == out.size) {
+        LOG(kError) << "Failed compressing: output exceeds bound";
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::compression_error));
+      }
+    } while (remaining != 0);
+    written = out.pos;
+  }
+#endif
+  static_cast<void>(input);
+  static_cast<void>(output);
+  static_cast<void>(capacity);
+  at_stream_start_ = false;
+  return written;
+}
+
+void StreamCompressor::Reset() {
+  // An LZ4 stream is restarted by the next LZ4F_compressBegin.
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd)
+    ZSTD_CCtx_reset(static_cast<ZSTD_CCtx*>(context_), ZSTD_reset_session_only);
+#endif
+  at_stream_start_ = true;
+}
+
+StreamDecompressor::StreamDecompressor(crypto::CompressionCodec codec)
+    : codec_(codec), context_(nullptr) {
+  switch (codec_) {
+#ifdef MAIDSAFE_COMMON_LZ4
+    case crypto::CompressionCodec::kLz4: {
+      LZ4F_dctx* context(nullptr);
+      if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)))
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+      context_ = context;
+      break;
+    }
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+    case crypto::CompressionCodec::kZstd: {
+      ZSTD_DCtx* context(ZSTD_createDCtx());
+      if (!context)
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uncompression_error));
+      ZSTD_DCtx_setParameter(context, ZSTD_d_windowLogMax, kZstdWindowLog);
+      context_ = context;
+      break;
+    }
+#endif
+    default:
+      ThrowUnavailable(codec_);
+  }
+}
+
+StreamDecompressor::~StreamDecompressor() {
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4)
+    LZ4F_freeDecompressionContext(static_cast<LZ4F_dctx*>(context_));
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd)
+    ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(context_));
+#endif
+}
+
+bool StreamDecompressor::Decompress(const byte* input, size_t size, byte* output,
+                                    size_t output_size) {
+  // Both decoders keep their own copy of the history which later frames may refer to, so 'output'
+  // needn't outlive the call.
+  size_t read(0), written(0);
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4) {
+    while (read != size) {
+      size_t output_chunk(output_size - written), input_chunk(size - read);
+      const size_t code(LZ4F_decompress(static_cast<LZ4F_dctx*>(context_), output + written,
+                                        &output_chunk, input + read, &input_chunk, nullptr));
+      if (LZ4F_isError(code)) {
+        LOG(kError) << "Failed uncompressing: " << LZ4F_getErrorName(code);
+        return false;
+      }
+      if (input_chunk == 0 && output_chunk == 0)
+        break;
+      read += input_chunk;
+      written += output_chunk;
+    }
+    // Any output still held by the decoder means the frame is larger than stated.
+    byte excess(0);
+    size_t excess_size(1), no_input(0);
+    if (written == output_size &&
+        !LZ4F_isError(LZ4F_decompress(static_cast<LZ4F_dctx*>(context_), &excess, &excess_size,
+                                      input, &no_input, nullptr)) &&
+        excess_size != 0) {
+      ++written;
+    }
+  }
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd) {
+    ZSTD_inBuffer in{input, size, 0};
+    ZSTD_outBuffer out{output, output_size, 0};
+    while (in.pos != in.size) {
+      const size_t previous_in(in.pos), previous_out(out.pos);
+      const size_t code(ZSTD_decompressStream(static_cast<ZSTD_DCtx*>(context_), &out, &in));
+      if (ZSTD_isError(code)) {
+        LOG(kError) << "Failed uncompressing: " << ZSTD_getErrorName(code);
+        return false;
+      }
+      if (in.pos == previous_in && out.pos == previous_out)
+        break;
+    }
+    read = in.pos;
+    written = out.pos;
+    byte excess(0);
+    ZSTD_inBuffer no_input{input, 0, 0};
+    ZSTD_outBuffer excess_out{&excess, 1, 0};
+    if (written == output_size &&
+        !ZSTD_isError(ZSTD_decompressStream(static_cast<ZSTD_DCtx*>(context_), &excess_out,
+                                            &no_input)) &&
+        excess_out.pos != 0) {
+      ++written;
+    }
+  }
+#endif
+  static_cast<void>(input);
+  static_cast<void>(output);
+  if (read != size || written != output_size) {
+    LOG(kError) << "Failed uncompressing: frame doesn't match its stated size";
+    return false;
+  }
+  return true;
+}
+
+void StreamDecompressor::Reset() {
+#ifdef MAIDSAFE_COMMON_LZ4
+  if (codec_ == crypto::CompressionCodec::kLz4)
+    LZ4F_resetDecompressionContext(static_cast<LZ4F_dctx*>(context_));
+#endif
+#ifdef MAIDSAFE_COMMON_ZSTD
+  if (codec_ == crypto::CompressionCodec::kZstd)
+    ZSTD_DCtx_reset(static_cast<ZSTD_DCtx*>(context_), ZSTD_reset_session_only);
+#endif
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
@@ -0,0 +1,86 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_TCP_STREAM_COMPRESSION_H_
+#define MAIDSAFE_COMMON_TCP_STREAM_COMPRESSION_H_
+
+#include <cstddef>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// Compresses the frames sent in one direction of a connection as a single LZ4 or zstd stream, so
+// that each frame can refer back to those before it.  Each frame's output is flushed, so it can be
+// decompressed as soon as it arrives.  Only kLz4 and kZstd are supported, and only if the library
+// was built with them.
+class StreamCompressor {
+ public:
+  StreamCompressor(crypto::CompressionCodec codec, int compression_level);
+  ~StreamCompressor();
+  StreamCompressor(const StreamCompressor&) = delete;
+  StreamCompressor(StreamCompressor&&) = delete;
+  StreamCompressor& operator=(StreamCompressor) = delete;
+
+  // The largest output of compressing 'size' bytes.
+  size_t Bound(size_t size) const;
+  // Compresses 'size' bytes into 'output', which must hold 'Bound(size)' bytes, and returns the
+  // number written.  Throws on failure.
+  size_t Compress(const byte* input, size_t size, byte* output);
+  // Abandons the stream, e.g. once a frame has proved incompressible and is to be sent as it is.
+  // The next frame starts a new stream, which the decompressor must also be reset for.
+  void Reset();
+  // True until a frame has been compressed since construction or the last Reset.
+  bool at_stream_start() const { return at_stream_start_; }
+  crypto::CompressionCodec codec() const { return codec_; }
+
+ private:
+  const crypto::CompressionCodec codec_;
+  const int compression_level_;
+  void* context_;
+  bool at_stream_start_;
+};
+
+// The receiving counterpart of StreamCompressor.
+class StreamDecompressor {
+ public:
+  explicit StreamDecompressor(crypto::CompressionCodec codec);
+  ~StreamDecompressor();
+  StreamDecompressor(const StreamDecompressor&) = delete;
+  StreamDecompressor(StreamDecompressor&&) = delete;
+  StreamDecompressor& operator=(StreamDecompressor) = delete;
+
+  // Decompresses one frame's output of StreamCompressor::Compress into 'output'.  Returns false if
+  // the input is corrupt or doesn't decompress to exactly 'output_size' bytes.
+  bool Decompress(const byte* input, size_t size, byte* output, size_t output_size);
+  void Reset();
+  crypto::CompressionCodec codec() const { return codec_; }
+
+ private:
+  const crypto::CompressionCodec codec_;
+  void* context_;
+};
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_TCP_STREAM_COMPRESSION_H_
@@ -0,0 +1,114 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/buffer_pool.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/memory_arena.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace tcp {
+
+namespace test {
+
+TEST(BufferPoolTest, BEH_ReuseBuffers) {
+  const size_t initial_count(BufferPool::CachedCount());
+  const byte* storage(nullptr);
+  {
+    PooledBuffer buffer(BufferPool::Get(100));
+    EXPECT_EQ(100U, buffer.size());
+    EXPECT_FALSE(buffer.empty());
+    storage = buffer.data();
+  }
+  EXPECT_EQ(initial_count + 1, BufferPool::CachedCount());
+
+  // Any size in the same class reuses the cached buffer.
+  PooledBuffer buffer(BufferPool::Get(128));
+  EXPECT_EQ(storage, buffer.data());
+  EXPECT_EQ(initial_count, BufferPool::CachedCount());
+
+  PooledBuffer moved(std::move(buffer));
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(storage, moved.data());
+  moved = PooledBuffer();
+  EXPECT_EQ(initial_count + 1, BufferPool::CachedCount());
+}
+
+TEST(BufferPoolTest, BEH_LargeAndEmptyBuffers) {
+  const size_t initial_count(BufferPool::CachedCount());
+  {
+    PooledBuffer large(BufferPool::Get(BufferPool::MaxPooledSize() + 1));
+    EXPECT_EQ(BufferPool::MaxPooledSize() + 1, large.size());
+    PooledBuffer empty(BufferPool::Get(0));
+    EXPECT_TRUE(empty.empty());
+  }
+  // Only the empty one (which still has minimum-sized storage) is cached.
+  EXPECT_EQ(initial_count + 1, BufferPool::CachedCount());
+}
+
+TEST(BufferPoolTest, BEH_CacheLimit) {
+  std::vector<PooledBuffer> buffers;
+  for (int i(0); i != 10; ++i)
+    buffers.emplace_back(BufferPool::Get(BufferPool::MaxPooledSize()));
+  const size_t initial_count(BufferPool::CachedCount());
+  buffers.clear();
+  EXPECT_EQ(initial_count + 1, BufferPool::CachedCount());
+}
+
+TEST(BufferPoolTest, BEH_Copy) {
+  const Message message{1, 2, 3, 4, 5};
+  PooledBuffer copy(BufferPool::Copy(message));
+  EXPECT_TRUE(std::equal(copy.begin(), copy.end(), message.begin()));
+  EXPECT_EQ(message.size(), copy.size());
+}
+
+TEST(BufferPoolTest, BEH_Arena) {
+  auto arena(std::make_shared<MemoryArena>(8 * 1024, MemoryArena::PageSize::kDefault));
+  BufferPool::SetArena(arena);
+  EXPECT_EQ(arena, BufferPool::Arena());
+  std::vector<PooledBuffer> buffers;
+  const size_t initial_count(BufferPool::CachedCount());
+  // Drain the calling thread's cache of this class so that new storage is taken from the arena.
+  for (size_t i(0); i != initial_count + 1; ++i)
+    buffers.emplace_back(BufferPool::Get(4096));
+  for (size_t i(0); i != 3; ++i)
+    buffers.emplace_back(BufferPool::Get(4096));
+  // Once the arena is exhausted, the heap is used.
+  EXPECT_EQ(2U, static_cast<size_t>(std::count_if(
+                    std::begin(buffers), std::end(buffers),
+                    [&](const PooledBuffer& buffer) { return arena->Owns(buffer.data()); })));
+  EXPECT_EQ(arena->stats().capacity, arena->stats().in_use);
+  EXPECT_LT(0U, arena->stats().failed_allocations);
+
+  BufferPool::SetArena(nullptr);
+  EXPECT_EQ(nullptr, BufferPool::Arena());
+  // Storage dropped from the cache goes back to its arena, which buffers keep alive.
+  arena.reset();
+  buffers.clear();
+}
+
+}  // namespace test
+
+}  // namespace tcp
+
+}  // namespace maidsafe
@@ -0,0 +1,83 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tcp/rate_limiter.h"
+
+#include <chrono>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace tcp {
+
+namespace test {
+
+TEST(RateLimiterTest, BEH_InvalidLimits) {
+  EXPECT_THROW(RateLimiter{RateLimiter::Limits{}}, maidsafe_error);
+}
+
+TEST(RateLimiterTest, BEH_BytesPerSecond) {
+  RateLimiter::Limits limits;
+  limits.bytes_per_second = 1000;
+  limits.burst_bytes = 500;
+  RateLimiter limiter{limits};
+  const auto start(RateLimiter::Clock::now() + std::chrono::seconds(1));
+
+  // The burst is available straight away; going beyond it incurs a proportionate wait.
+  EXPECT_EQ(RateLimiter::Clock::duration::zero(), limiter.Consume(500, 1000, start));
+  EXPECT_EQ(std::chrono::milliseconds(200),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                limiter.Consume(200, 0, start) + std::chrono::microseconds(1)));
+  // The debt is repaid over time, and refilling is capped at the burst.
+  EXPECT_EQ(RateLimiter::Clock::duration::zero(),
+            limiter.Consume(0, 0, start + std::chrono::milliseconds(200)));
+  EXPECT_EQ(RateLimiter::Clock::duration::zero(),
+            limiter.Consume(500, 0, start + std::chrono::seconds(10)));
+  EXPECT_LT(RateLimiter::Clock::duration::zero(),
+            limiter.Consume(1, 0, start + std::chrono::seconds(10)));
+  // Time going backwards doesn't refill.
+  EXPECT_LT(RateLimiter::Clock::duration::zero(), limiter.Consume(0, 0, start));
+}
+
+TEST(RateLimiterTest, BEH_MessagesPerSecond) {
+  RateLimiter::Limits limits;
+  limits.bytes_per_second = 1000000;
+  limits.messages_per_second = 10;
+  RateLimiter limiter{limits};
+  EXPECT_EQ(10U, limiter.limits().messages_per_second);
+  const auto start(RateLimiter::Clock::now() + std::chrono::seconds(1));
+
+  // The burst defaults to one second's worth.
+  for (int i(0); i != 10; ++i)
+    EXPECT_EQ(RateLimiter::Clock::duration::zero(), limiter.Consume(1, 1, start));
+  // The longer of the two waits is returned.
+  EXPECT_EQ(std::chrono::milliseconds(100),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                limiter.Consume(1, 1, start) + std::chrono::microseconds(1)));
+  EXPECT_EQ(std::chrono::milliseconds(1000),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                limiter.Consume(2000000, 0, start) + std::chrono::microseconds(1)));
+}
+
+}  // namespace test
+
+}  // namespace tcp
+
+}  // namespace maidsafe
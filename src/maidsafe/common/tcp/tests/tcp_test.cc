@@ -19,9 +19,13 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
@@ -29,6 +33,8 @@
 #include "asio/error.hpp"
 #include "asio/io_service.hpp"
 #include "asio/ip/tcp.hpp"
+#include "asio/post.hpp"
+#include "asio/use_future.hpp"
 #include "asio/write.hpp"
 
 #include "maidsafe/common/asio_service.h"
@@ -37,8 +43,10 @@
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/config.h"
+#include "maidsafe/common/timer_wheel.h"
 #include "maidsafe/common/tcp/connection.h"
 #include "maidsafe/common/tcp/listener.h"
+#include "maidsafe/common/tcp/rate_limiter.h"
 
 
 namespace maidsafe {
@@ -186,6 +194,713 @@ TEST_F(TcpTest, BEH_Basic) {
   EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
 }
 
+TEST_F(TcpTest, BEH_ManySmallMessages) {
+  // Enough messages to need several coalesced writes, regardless of how the sends are batched.
+  const size_t kMessageCount(Connection::MaxSendMessages() * 10);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    AddRandomMessage(to_client_messages_, (i % 100) + 1);
+    AddRandomMessage(to_server_messages_, (i % 100) + 1);
+  }
+  AddRandomMessage(to_client_messages_, Connection::MaxSendBytes() + 1);
+  AddRandomMessage(to_server_messages_, Connection::MaxSendBytes() + 1);
+  InitialiseMessagesToClient();
+  InitialiseMessagesToServer();
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionAndCloser client_connection_and_closer{GenerateClientConnection(
+      listener_and_closer.first->ListeningPort(),
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Client connection closed."; })};
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Server connection closed."; });
+
+  for (size_t i(0); i < to_client_messages_.size(); ++i) {
+    server_connection->Send(to_client_messages_[i]);
+    client_connection_and_closer.first->Send(to_server_messages_[i]);
+  }
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+}
+
+TEST_F(TcpTest, BEH_DeliverViaExecutor) {
+  const size_t kMessageCount(100);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    AddRandomMessage(to_client_messages_, (i * 1000) + 1);
+    AddRandomMessage(to_server_messages_, (i * 1000) + 1);
+  }
+  InitialiseMessagesToClient();
+  InitialiseMessagesToServer();
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionAndCloser client_connection_and_closer{GenerateClientConnection(
+      listener_and_closer.first->ListeningPort(),
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Client connection closed."; })};
+
+  // Deliver directly on the connection's strand.
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Server connection closed."; },
+      [](std::function<void()> task) { task(); });
+
+  for (size_t i(0); i < kMessageCount; ++i) {
+    server_connection->Send(to_client_messages_[i]);
+    client_connection_and_closer.first->Send(to_server_messages_[i]);
+  }
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+}
+
+TEST_F(TcpTest, BEH_StreamFragments) {
+  const size_t kMaxMessageSize(1000), kFragmentCount(20);
+  Message payload;
+  for (size_t i(0); i < kFragmentCount; ++i) {
+    AddRandomMessage(to_server_messages_, kMaxMessageSize);
+    payload.insert(std::end(payload), std::begin(to_server_messages_.back()),
+                   std::end(to_server_messages_.back()));
+  }
+
+  std::mutex mutex;
+  Message streamed;
+  std::vector<Connection::Fragment> flags;
+  std::promise<void> stream_ended;
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener_and_closer.first->ListeningPort())};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  EXPECT_THROW(client_connection->SetMaxMessageSize(0), maidsafe_error);
+  EXPECT_THROW(client_connection->SetMaxMessageSize(Connection::MaxFrameSize() + 1),
+               maidsafe_error);
+  client_connection->SetMaxMessageSize(kMaxMessageSize);
+  EXPECT_EQ(kMaxMessageSize, client_connection->max_message_size());
+  client_connection->Start([](Message) {}, [] {});
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->SetMaxMessageSize(kMaxMessageSize);
+  server_connection->SetFragmentHandler([&](Message fragment, Connection::Fragment flag) {
+    std::lock_guard<std::mutex> lock{mutex};
+    streamed.insert(std::end(streamed), std::begin(fragment), std::end(fragment));
+    flags.push_back(flag);
+    if (flag == Connection::Fragment::kEnd)
+      stream_ended.set_value();
+  });
+  server_connection->Start([](Message) {}, [] {});
+
+  EXPECT_THROW(client_connection->Send(payload), maidsafe_error);
+  client_connection->SendFragment(to_server_messages_.front(), Connection::Fragment::kBegin);
+  for (size_t i(1); i < kFragmentCount; ++i)
+    client_connection->SendFragment(to_server_messages_[i], Connection::Fragment::kContinue);
+  client_connection->SendFragment(Message{}, Connection::Fragment::kEnd);
+
+  ASSERT_EQ(std::future_status::ready,
+            stream_ended.get_future().wait_for(std::chrono::seconds(10)));
+  std::lock_guard<std::mutex> lock{mutex};
+  EXPECT_EQ(payload, streamed);
+  ASSERT_EQ(kFragmentCount + 1, flags.size());
+  EXPECT_EQ(Connection::Fragment::kBegin, flags.front());
+  EXPECT_EQ(Connection::Fragment::kEnd, flags.back());
+}
+
+TEST_F(TcpTest, BEH_AsyncConnect) {
+  EXPECT_THROW(Connection::AsyncConnect(client_strand_, std::vector<asio::ip::tcp::endpoint>{},
+                                        std::chrono::seconds(1),
+                                        [](std::error_code, ConnectionPtr) {}),
+               maidsafe_error);
+
+  // A losing attempt may also have been accepted before being closed.
+  std::promise<ConnectionPtr> server_promise;
+  std::once_flag accepted_flag;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) {
+        std::call_once(accepted_flag, [&] { server_promise.set_value(std::move(connection)); });
+      },
+      Port{7777})};
+  const Port port{listener_and_closer.first->ListeningPort()};
+
+  // Nothing listens on 'port' + 1, so that attempt should fail and the next one succeed.
+  std::vector<asio::ip::tcp::endpoint> endpoints{
+      asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), static_cast<Port>(port + 1)},
+      asio::ip::tcp::endpoint{asio::ip::address_v6::loopback(), port},
+      asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), port}};
+  std::promise<std::pair<std::error_code, ConnectionPtr>> connect_promise;
+  Connection::AsyncConnect(client_strand_, endpoints, std::chrono::seconds(10),
+                           [&](std::error_code ec, ConnectionPtr connection) {
+                             connect_promise.set_value(std::make_pair(ec, connection));
+                           });
+  auto result(connect_promise.get_future().get());
+  ASSERT_FALSE(result.first) << result.first.message();
+  ASSERT_TRUE(result.second != nullptr);
+  on_scope_exit client_closer([&] { result.second->Close(); });
+
+  AddRandomMessage(to_server_messages_, 1000);
+  InitialiseMessagesToServer();
+  result.second->Start([](Message) {}, [] {});
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Server connection closed."; });
+  result.second->Send(to_server_messages_.front());
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+
+  // Every attempt fails.
+  std::promise<std::error_code> failed_promise;
+  Connection::AsyncConnect(
+      client_strand_,
+      std::vector<asio::ip::tcp::endpoint>{asio::ip::tcp::endpoint{
+          asio::ip::address_v4::loopback(), static_cast<Port>(port + 1)}},
+      std::chrono::seconds(10),
+      [&](std::error_code ec, ConnectionPtr) { failed_promise.set_value(ec); });
+  EXPECT_EQ(make_error_code(VaultManagerErrors::failed_to_connect),
+            failed_promise.get_future().get());
+}
+
+TEST_F(TcpTest, BEH_SendQueueLimits) {
+  AddRandomMessage(to_server_messages_, 1000);
+  InitialiseMessagesToServer();
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionAndCloser client_connection_and_closer{GenerateClientConnection(
+      listener_and_closer.first->ListeningPort(), [](Message) {}, [] {})};
+  ConnectionPtr client_connection{client_connection_and_closer.first};
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [&] { LOG(kVerbose) << "Server connection closed."; });
+
+  Connection::SendQueueLimits limits;
+  limits.high_water_messages = 1;
+  limits.low_water_messages = 2;
+  EXPECT_THROW(client_connection->SetSendQueueLimits(limits, nullptr), maidsafe_error);
+  limits.low_water_messages = 0;
+  std::promise<void> drained;
+  client_connection->SetSendQueueLimits(limits, [&] { drained.set_value(); });
+
+  // Hold up the client's strand so that the queue can't drain until we're ready.
+  std::promise<void> release_strand;
+  std::shared_future<void> strand_released(release_strand.get_future());
+  asio::post(client_strand_, [strand_released] { strand_released.wait(); });
+
+  EXPECT_TRUE(client_connection->Send(to_server_messages_.front()));
+  EXPECT_EQ(1U, client_connection->queued_messages());
+  EXPECT_EQ(to_server_messages_.front().size() + 4U, client_connection->queued_bytes());
+  EXPECT_FALSE(client_connection->Send(to_server_messages_.front()));
+  release_strand.set_value();
+
+  ASSERT_EQ(std::future_status::ready, drained.get_future().wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(0U, client_connection->queued_messages());
+  EXPECT_EQ(0U, client_connection->queued_bytes());
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+}
+
+TEST_F(TcpTest, BEH_Stats) {
+  const size_t kMessageCount(10), kMessageSize(1000);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    AddRandomMessage(to_client_messages_, kMessageSize);
+    AddRandomMessage(to_server_messages_, kMessageSize);
+  }
+  InitialiseMessagesToClient();
+  InitialiseMessagesToServer();
+
+  // Both ends share one Stats object, so it holds the totals for both.
+  std::shared_ptr<Stats> stats{std::make_shared<Stats>()};
+  std::promise<ConnectionPtr> server_promise;
+  std::promise<void> server_closed;
+  ListenerPtr listener{Listener::MakeShared(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777}, stats)};
+  on_scope_exit listener_closer([listener] { listener->StopListening(); });
+
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener->ListeningPort())};
+  client_connection->SetStats(stats);
+  client_connection->Start(
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [] {});
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [&] { server_closed.set_value(); });
+
+  for (size_t i(0); i < kMessageCount; ++i) {
+    server_connection->Send(to_client_messages_[i]);
+    client_connection->Send(to_server_messages_[i]);
+  }
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+  client_connection->Close();
+  ASSERT_EQ(std::future_status::ready,
+            server_closed.get_future().wait_for(std::chrono::seconds(10)));
+
+  const Stats::Snapshot snapshot{stats->snapshot()};
+  EXPECT_EQ(1U, snapshot.accepts);
+  EXPECT_EQ(0U, snapshot.accept_errors);
+  EXPECT_EQ(2 * kMessageCount, snapshot.messages_in);
+  EXPECT_EQ(2 * kMessageCount, snapshot.messages_out);
+  EXPECT_EQ(2 * kMessageCount * (kMessageSize + 4), snapshot.bytes_in);
+  EXPECT_EQ(snapshot.bytes_in, snapshot.bytes_out);
+  EXPECT_GE(snapshot.send_queue_messages_high_water, 1U);
+  EXPECT_GE(snapshot.write_latency.count, 2U);
+  EXPECT_LE(snapshot.write_latency.count, 2 * kMessageCount);
+  EXPECT_EQ(1U, snapshot.closes[static_cast<size_t>(Stats::CloseReason::kLocal)]);
+  EXPECT_EQ(1U, snapshot.closes[static_cast<size_t>(Stats::CloseReason::kPeer)]);
+}
+
+TEST_F(TcpTest, BEH_IdleTimeout) {
+  std::shared_ptr<TimerWheel> wheel{
+      TimerWheel::MakeShared(asio_service_.service(), std::chrono::milliseconds(5))};
+  std::shared_ptr<Stats> stats{std::make_shared<Stats>()};
+  std::promise<ConnectionPtr> server_promise;
+  std::promise<void> server_closed;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener_and_closer.first->ListeningPort())};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  client_connection->Start([](Message) {}, [] {});
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  EXPECT_THROW(server_connection->SetIdleTimeout(nullptr, std::chrono::seconds(1)),
+               maidsafe_error);
+  EXPECT_THROW(
+      server_connection->SetIdleTimeout(wheel, std::chrono::steady_clock::duration::zero()),
+      maidsafe_error);
+  server_connection->SetIdleTimeout(wheel, std::chrono::milliseconds(300));
+  server_connection->SetStats(stats);
+  server_connection->Start([](Message) {}, [&] { server_closed.set_value(); });
+  std::future<void> closed{server_closed.get_future()};
+
+  // Regular traffic keeps the connection open well beyond the timeout.
+  for (int i(0); i != 10; ++i) {
+    client_connection->Send(Message(10, 'a'));
+    EXPECT_EQ(std::future_status::timeout, closed.wait_for(std::chrono::milliseconds(100)));
+  }
+  EXPECT_EQ(std::future_status::ready, closed.wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(1U, stats->snapshot().closes[static_cast<size_t>(Stats::CloseReason::kIdleTimeout)]);
+  EXPECT_EQ(0U, wheel->size());
+}
+
+TEST_F(TcpTest, BEH_RateLimit) {
+  const size_t kClientCount(2), kMessageCount(10);
+  RateLimiter::Limits limits;
+  limits.messages_per_second = 40;
+  limits.burst_messages = 1;
+  std::shared_ptr<RateLimiter> limiter{std::make_shared<RateLimiter>(limits)};
+  std::shared_ptr<Stats> stats{std::make_shared<Stats>()};
+
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::vector<ConnectionPtr> server_connections;
+  size_t received_count(0);
+  ListenerPtr listener{Listener::MakeShared(server_strand_,
+                                            [&](ConnectionPtr connection) {
+                                              {
+                                                std::lock_guard<std::mutex> lock{mutex};
+                                                server_connections.push_back(connection);
+                                              }
+                                              connection->Start([&](Message) {
+                                                {
+                                                  std::lock_guard<std::mutex> lock{mutex};
+                                                  ++received_count;
+                                                }
+                                                cond_var.notify_one();
+                                              }, [] {});
+                                            },
+                                            Port{7777}, stats)};
+  on_scope_exit listener_closer([listener] { listener->StopListening(); });
+  // All accepted connections share the listener's limiter.
+  listener->SetRateLimiter(limiter);
+
+  const auto start(std::chrono::steady_clock::now());
+  std::vector<ConnectionAndCloser> client_connections_and_closers;
+  for (size_t i(0); i < kClientCount; ++i) {
+    client_connections_and_closers.emplace_back(GenerateClientConnection(
+        listener->ListeningPort(), [](Message) {}, [] {}));
+    EXPECT_THROW(client_connections_and_closers.back().first->AddRateLimiter(nullptr),
+                 maidsafe_error);
+    for (size_t j(0); j < kMessageCount; ++j)
+      client_connections_and_closers.back().first->Send(Message(100, 'a'));
+  }
+
+  std::unique_lock<std::mutex> lock{mutex};
+  EXPECT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(10), [&] {
+    return received_count == kClientCount * kMessageCount;
+  }));
+  // After the single-message burst, the remaining messages arrive at no more than 40 per second.
+  EXPECT_LE(std::chrono::milliseconds(400), std::chrono::steady_clock::now() - start);
+  EXPECT_LT(0U, stats->snapshot().throttles);
+  for (const auto& connection : server_connections)
+    connection->Close();
+}
+
+TEST_F(TcpTest, BEH_MultipleAcceptors) {
+  const size_t kAcceptorCount(4), kClientCount(20);
+  EXPECT_THROW(Listener::MakeShared(std::vector<asio::io_service::strand*>{}, [](ConnectionPtr) {},
+                                    Port{7777}),
+               maidsafe_error);
+
+  std::vector<std::unique_ptr<asio::io_service::strand>> strands;
+  std::vector<asio::io_service::strand*> strand_ptrs;
+  for (size_t i(0); i < kAcceptorCount; ++i) {
+    strands.emplace_back(maidsafe::make_unique<asio::io_service::strand>(asio_service_.service()));
+    strand_ptrs.push_back(strands.back().get());
+  }
+
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::vector<ConnectionPtr> server_connections;
+  ListenerPtr listener{Listener::MakeShared(strand_ptrs,
+                                            [&](ConnectionPtr connection) {
+                                              {
+                                                std::lock_guard<std::mutex> lock{mutex};
+                                                server_connections.push_back(connection);
+                                              }
+                                              cond_var.notify_one();
+                                            },
+                                            Port{7777})};
+  on_scope_exit listener_closer([listener] { listener->StopListening(); });
+#ifdef MAIDSAFE_WIN32
+  EXPECT_EQ(1U, listener->AcceptorCount());
+#else
+  EXPECT_EQ(kAcceptorCount, listener->AcceptorCount());
+#endif
+
+  std::vector<ConnectionAndCloser> client_connections_and_closers;
+  for (size_t i(0); i < kClientCount; ++i) {
+    client_connections_and_closers.emplace_back(GenerateClientConnection(
+        listener->ListeningPort(), [](Message) {}, [] {}));
+  }
+
+  std::unique_lock<std::mutex> lock{mutex};
+  EXPECT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(10),
+                                [&] { return server_connections.size() == kClientCount; }));
+  for (const auto& connection : server_connections)
+    connection->Close();
+}
+
+TEST_F(TcpTest, BEH_PooledMessages) {
+  const size_t kMessageCount(50);
+  for (size_t i(0); i < kMessageCount; ++i)
+    AddRandomMessage(to_server_messages_, (i * 100) + 1);
+  InitialiseMessagesToServer();
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionAndCloser client_connection_and_closer{GenerateClientConnection(
+      listener_and_closer.first->ListeningPort(), [](Message) {}, [] {})};
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->SetPooledMessageHandler([&](PooledBuffer message) {
+    messages_received_by_server_->AddMessage(Message(message.begin(), message.end()));
+  });
+  server_connection->Start(nullptr, [&] { LOG(kVerbose) << "Server connection closed."; });
+
+  EXPECT_THROW(client_connection_and_closer.first->Send(PooledBuffer()), maidsafe_error);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    if (i % 2 == 0)
+      client_connection_and_closer.first->Send(BufferPool::Copy(to_server_messages_[i]));
+    else
+      client_connection_and_closer.first->Send(to_server_messages_[i]);
+  }
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+}
+
+TEST_F(TcpTest, BEH_Encryption) {
+  const size_t kMessageCount(50);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    AddRandomMessage(to_server_messages_, (i * 100) + 1);
+    AddRandomMessage(to_client_messages_, (i * 10) + 1);
+  }
+  InitialiseMessagesToServer();
+  InitialiseMessagesToClient();
+
+  Connection::EncryptionKey client_key, server_key;
+  const std::string random(RandomString(client_key.size() * 2));
+  std::copy(random.begin(), random.begin() + client_key.size(), client_key.begin());
+  std::copy(random.begin() + client_key.size(), random.end(), server_key.begin());
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener_and_closer.first->ListeningPort())};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  EXPECT_THROW(client_connection->SetEncryption(client_key, client_key), maidsafe_error);
+  EXPECT_FALSE(client_connection->encrypted());
+  client_connection->SetEncryption(client_key, server_key);
+  EXPECT_TRUE(client_connection->encrypted());
+  client_connection->Start(
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [] {});
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  server_connection->SetEncryption(server_key, client_key);
+  server_connection->SetPooledMessageHandler([&](PooledBuffer message) {
+    messages_received_by_server_->AddMessage(Message(message.begin(), message.end()));
+  });
+  server_connection->Start(nullptr, [] {});
+
+  for (size_t i(0); i < kMessageCount; ++i) {
+    if (i % 2 == 0)
+      client_connection->Send(BufferPool::Copy(to_server_messages_[i]));
+    else
+      client_connection->Send(to_server_messages_[i]);
+    server_connection->Send(SharedBuffer(to_client_messages_[i]));
+  }
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(0U, client_connection->queued_bytes());
+
+  // A peer using the wrong key is disconnected on its first message.
+  std::promise<ConnectionPtr> second_server_promise;
+  std::promise<void> server_closed;
+  ListenerAndCloser second_listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { second_server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionPtr bad_client_connection{Connection::MakeShared(
+      client_strand_, second_listener_and_closer.first->ListeningPort())};
+  on_scope_exit bad_client_closer([bad_client_connection] { bad_client_connection->Close(); });
+  bad_client_connection->SetEncryption(server_key, client_key);
+  bad_client_connection->Start([](Message) {}, [] {});
+  server_connection = second_server_promise.get_future().get();
+  server_connection->SetEncryption(server_key, client_key);
+  server_connection->Start([](Message) { ADD_FAILURE() << "Forged message delivered."; },
+                           [&] { server_closed.set_value(); });
+  bad_client_connection->Send(to_server_messages_.front());
+  EXPECT_EQ(std::future_status::ready,
+            server_closed.get_future().wait_for(std::chrono::seconds(10)));
+}
+
+TEST_F(TcpTest, BEH_Compression) {
+  // A mix of compressible records, frames too small to compress and incompressible frames.
+  const size_t kMessageCount(60);
+  uint64_t total_size(0);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    for (auto* messages : {&to_server_messages_, &to_client_messages_}) {
+      if (i % 6 == 5) {
+        AddRandomMessage(*messages, 5000 + i);
+      } else if (i % 6 == 4) {
+        AddRandomMessage(*messages, 10);
+      } else {
+        std::string record;
+        while (record.size() < 1000 + i) {
+          record += "{\"version\":" + std::to_string(i) + ",\"id\":\"" +
+                    RandomAlphaNumericString(4) + "\"}";
+        }
+        messages->emplace_back(record.begin(), record.end());
+      }
+      total_size += messages->back().size();
+    }
+  }
+  InitialiseMessagesToServer();
+  InitialiseMessagesToClient();
+
+  Connection::EncryptionKey client_key, server_key;
+  const std::string random(RandomString(client_key.size() * 2));
+  std::copy(random.begin(), random.begin() + client_key.size(), client_key.begin());
+  std::copy(random.begin() + client_key.size(), random.end(), server_key.begin());
+  std::shared_ptr<Stats> stats{std::make_shared<Stats>()};
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener_and_closer.first->ListeningPort())};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  Connection::CompressionOptions options;
+  options.codecs.push_back(crypto::CompressionCodec::kGzip);
+  EXPECT_THROW(client_connection->SetCompression(options), maidsafe_error);
+  options = Connection::CompressionOptions();
+  options.zstd_level = 0;
+  EXPECT_THROW(client_connection->SetCompression(options), maidsafe_error);
+  EXPECT_FALSE(client_connection->compression_enabled());
+  // Compression comes before encryption, so both are exercised together.
+  client_connection->SetCompression(Connection::CompressionOptions());
+  client_connection->SetEncryption(client_key, server_key);
+  client_connection->SetStats(stats);
+  EXPECT_TRUE(client_connection->compression_enabled());
+  client_connection->Start(
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [] {});
+
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  // The server prefers LZ4, so if both codecs are available each direction uses a different one.
+  options = Connection::CompressionOptions();
+  std::reverse(options.codecs.begin(), options.codecs.end());
+  server_connection->SetCompression(options);
+  server_connection->SetEncryption(server_key, client_key);
+  server_connection->SetStats(stats);
+  server_connection->SetPooledMessageHandler([&](PooledBuffer message) {
+    messages_received_by_server_->AddMessage(Message(message.begin(), message.end()));
+  });
+  server_connection->Start(nullptr, [] {});
+
+  for (size_t i(0); i < kMessageCount; ++i) {
+    if (i % 2 == 0)
+      client_connection->Send(BufferPool::Copy(to_server_messages_[i]));
+    else
+      client_connection->Send(to_server_messages_[i]);
+    server_connection->Send(SharedBuffer(to_client_messages_[i]));
+  }
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(0U, client_connection->queued_bytes());
+  EXPECT_EQ(0U, server_connection->queued_bytes());
+
+  const Stats::Snapshot snapshot{stats->snapshot()};
+  EXPECT_EQ(total_size, snapshot.compression_bytes_in);
+  if (crypto::CompressionCodecAvailable(crypto::CompressionCodec::kZstd) ||
+      crypto::CompressionCodecAvailable(crypto::CompressionCodec::kLz4)) {
+    EXPECT_LT(snapshot.compression_bytes_out, snapshot.compression_bytes_in);
+  } else {
+    EXPECT_EQ(total_size + 2 * kMessageCount, snapshot.compression_bytes_out);
+  }
+}
+
+TEST_F(TcpTest, BEH_LocalTransport) {
+  const size_t kMessageCount(10);
+  for (size_t i(0); i < kMessageCount; ++i) {
+    AddRandomMessage(to_client_messages_, (i + 1) * 10000);
+    AddRandomMessage(to_server_messages_, (i + 1) * 10000);
+  }
+  InitialiseMessagesToClient();
+  InitialiseMessagesToServer();
+
+  std::promise<ConnectionPtr> server_promise;
+  ListenerAndCloser listener_and_closer{GenerateListener(
+      server_strand_,
+      [&](ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      Port{7777})};
+#ifdef ASIO_HAS_LOCAL_SOCKETS
+  const Connection::Transport kExpectedTransport{Connection::Transport::kLocal};
+  EXPECT_TRUE(listener_and_closer.first->AcceptsLocalConnections());
+#else
+  const Connection::Transport kExpectedTransport{Connection::Transport::kTcp};
+  EXPECT_FALSE(listener_and_closer.first->AcceptsLocalConnections());
+#endif
+
+  ConnectionPtr client_connection{Connection::MakeShared(
+      client_strand_, listener_and_closer.first->ListeningPort(), Connection::Transport::kLocal)};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  EXPECT_EQ(kExpectedTransport, client_connection->transport());
+  client_connection->Start(
+      [&](Message message) { messages_received_by_client_->AddMessage(std::move(message)); },
+      [] {});
+  ConnectionPtr server_connection{server_promise.get_future().get()};
+  EXPECT_EQ(kExpectedTransport, server_connection->transport());
+  server_connection->Start(
+      [&](Message message) { messages_received_by_server_->AddMessage(std::move(message)); },
+      [] {});
+
+  for (size_t i(0); i < kMessageCount; ++i) {
+    server_connection->Send(to_client_messages_[i]);
+    client_connection->Send(to_server_messages_[i]);
+  }
+  EXPECT_EQ(messages_received_by_client_->MessagesMatch(), Messages::Status::kSuccess);
+  EXPECT_EQ(messages_received_by_server_->MessagesMatch(), Messages::Status::kSuccess);
+
+  // A peer which only listens on TCP is still reachable when a local connection is preferred.
+  asio::ip::tcp::acceptor tcp_only_acceptor{
+      asio_service_.service(), asio::ip::tcp::endpoint{asio::ip::address_v4::loopback(), 0}};
+  ConnectionPtr fallback_connection{Connection::MakeShared(
+      client_strand_, tcp_only_acceptor.local_endpoint().port(), Connection::Transport::kLocal)};
+  EXPECT_EQ(Connection::Transport::kTcp, fallback_connection->transport());
+  fallback_connection->Close();
+}
+
+// Returns the error with which an operation completed via 'asio::use_future' failed.
+template <typename T>
+std::error_code ErrorOf(std::future<T> result) {
+  try {
+    result.get();
+  } catch (const std::system_error& error) {
+    return error.code();
+  }
+  return std::error_code();
+}
+
+TEST_F(TcpTest, BEH_CompletionTokens) {
+  const size_t kMessageCount(10);
+  for (size_t i(0); i < kMessageCount; ++i)
+    AddRandomMessage(to_server_messages_, (i + 1) * 1000);
+
+  ListenerAndCloser listener_and_closer{GenerateListener(server_strand_, nullptr, Port{7777})};
+  const ListenerPtr& listener(listener_and_closer.first);
+  std::future<ConnectionPtr> accepted(listener->AsyncAccept(asio::use_future));
+  ConnectionPtr client_connection{
+      Connection::MakeShared(client_strand_, listener->ListeningPort())};
+  on_scope_exit client_closer([client_connection] { client_connection->Close(); });
+  ConnectionPtr server_connection{accepted.get()};
+  ASSERT_TRUE(server_connection != nullptr);
+  on_scope_exit server_closer([server_connection] { server_connection->Close(); });
+
+  // Messages arriving before they're asked for are queued, and all are received in order.
+  std::future<Message> first_received(server_connection->AsyncReceive(asio::use_future));
+  for (const auto& message : to_server_messages_)
+    client_connection->AsyncSend(message, asio::use_future).get();
+  EXPECT_EQ(to_server_messages_.front(), first_received.get());
+  for (size_t i(1); i < kMessageCount; ++i)
+    EXPECT_EQ(to_server_messages_[i], server_connection->AsyncReceive(asio::use_future).get());
+
+  // A plain callback is also a completion token.
+  std::promise<std::error_code> sent;
+  client_connection->AsyncSend(to_server_messages_.front(),
+                               [&sent](std::error_code ec) { sent.set_value(ec); });
+  EXPECT_FALSE(sent.get_future().get());
+  EXPECT_EQ(to_server_messages_.front(), server_connection->AsyncReceive(asio::use_future).get());
+
+  // Only one receive may be outstanding, and closing the connection completes it.
+  std::future<Message> pending(server_connection->AsyncReceive(asio::use_future));
+  EXPECT_EQ(make_error_code(asio::error::already_started),
+            ErrorOf(server_connection->AsyncReceive(asio::use_future)));
+  client_connection->Close();
+  EXPECT_EQ(make_error_code(asio::error::eof), ErrorOf(std::move(pending)));
+  EXPECT_EQ(make_error_code(asio::error::eof),
+            ErrorOf(server_connection->AsyncReceive(asio::use_future)));
+
+  // Stopping the listener completes an outstanding accept.
+  std::future<ConnectionPtr> stopped(listener->AsyncAccept(asio::use_future));
+  listener->StopListening();
+  EXPECT_EQ(make_error_code(asio::error::operation_aborted), ErrorOf(std::move(stopped)));
+
+  // A listener with a NewConnectionFunctor doesn't queue connections.
+  ListenerAndCloser functor_listener{
+      GenerateListener(server_strand_, [](ConnectionPtr) {}, Port{7777})};
+  EXPECT_EQ(make_error_code(asio::error::operation_not_supported),
+            ErrorOf(functor_listener.first->AsyncAccept(asio::use_future)));
+}
+
 TEST_F(TcpTest, BEH_UnavailablePort) {
   AddRandomMessage(to_client_messages_, 1000);
   AddRandomMessage(to_server_messages_, 1000);
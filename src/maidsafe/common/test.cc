@@ -21,18 +21,23 @@
 #ifndef MAIDSAFE_WIN32
 #include <sys/resource.h>
 #endif
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <future>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 #include "boost/filesystem/operations.hpp"
 #include "boost/program_options.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/make_unique.h"
+#include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/utils.h"
 
 namespace fs = boost::filesystem;
@@ -148,6 +153,77 @@ void RunInParallel(int thread_count, std::function<void()> functor) {
     future.get();
 }
 
+std::uint64_t ParallelRunResult::TotalOperations() const {
+  std::uint64_t total(0);
+  for (const auto& thread : threads)
+    total += thread.operations;
+  return total;
+}
+
+double ParallelRunResult::OperationsPerSecond() const {
+  const double seconds(std::chrono::duration<double>(wall_time).count());
+  return seconds > 0.0 ? static_cast<double>(TotalOperations()) / seconds : 0.0;
+}
+
+void ParallelRunResult::Report(const std::string& name) const {
+  using std::chrono::duration;
+  for (std::size_t i(0); i != threads.size(); ++i) {
+    const double seconds(duration<double>(threads[i].duration).count());
+    TLOG(kDefaultColour) << name << " thread " << i << (threads[i].pinned ? " (pinned)" : "")
+                         << ": " << threads[i].operations << " ops in " << seconds * 1e3
+                         << " ms ("
+                         << (seconds > 0.0 ? static_cast<double>(threads[i].operations) / seconds
+                                           : 0.0)
+                         << " ops/s)\n";
+  }
+  TLOG(kCyan) << name << ": " << threads.size() << " threads, " << TotalOperations() << " ops in "
+              << duration<double, std::milli>(wall_time).count() << " ms ("
+              << OperationsPerSecond() << " ops/s)\n";
+}
+
+ParallelRunResult RunInParallelTimed(int thread_count, std::function<std::uint64_t(int)> functor,
+                                     bool pin_threads) {
+  typedef std::chrono::steady_clock Clock;
+  ParallelRunResult result;
+  result.threads.resize(std::max(thread_count, 0));
+  std::atomic<int> ready_count(0);
+  std::atomic<bool> start(false);
+  std::vector<Clock::time_point> finish_times(result.threads.size());
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < thread_count; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i] {
+      ParallelRunResult::ThreadResult& thread_result(result.threads[i]);
+      thread_result.pinned =
+          pin_threads &&
+          detail::PinCurrentThreadToCpu(static_cast<unsigned>(i) %
+                                        std::max(std::thread::hardware_concurrency(), 1U));
+      ++ready_count;
+      // Spin rather than block so that every thread is released as close to together as possible.
+      while (!start.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      const Clock::time_point thread_start(Clock::now());
+      thread_result.operations = 0;
+      on_scope_exit record_finish([&] {
+        finish_times[i] = Clock::now();
+        thread_result.duration = finish_times[i] - thread_start;
+      });
+      thread_result.operations = functor(i);
+    }));
+  }
+  while (ready_count.load() != thread_count)
+    std::this_thread::yield();
+  const Clock::time_point start_time(Clock::now());
+  start.store(true, std::memory_order_release);
+  for (auto& future : futures)
+    future.wait();
+  result.wall_time = Clock::duration::zero();
+  for (const auto& finish_time : finish_times)
+    result.wall_time = std::max(result.wall_time, finish_time - start_time);
+  for (auto& future : futures)
+    future.get();
+  return result;
+}
+
 uint16_t GetRandomPort() {
   static std::set<uint16_t> already_used_ports;
   if (already_used_ports.size() == 10000) {
@@ -0,0 +1,50 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/active.h"
+
+#include <future>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(ActiveTest, BEH_RunsInOrder) {
+  const int kFunctorCount(10000);
+  std::vector<int> results;
+  {
+    Active active;
+    std::promise<void> release;
+    auto blocked(release.get_future());
+    // Hold up the worker so that the remaining functors are drained as one batch.
+    active.Send([&] { blocked.wait(); });
+    for (int i(0); i != kFunctorCount; ++i)
+      active.Send([&results, i] { results.push_back(i); });
+    release.set_value();
+  }
+  ASSERT_EQ(static_cast<size_t>(kFunctorCount), results.size());
+  for (int i(0); i != kFunctorCount; ++i)
+    EXPECT_EQ(i, results[i]);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
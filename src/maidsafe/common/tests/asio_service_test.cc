@@ -18,9 +18,14 @@
 
 #include "maidsafe/common/asio_service.h"
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <future>
 #include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "boost/date_time/posix_time/posix_time.hpp"
 
@@ -74,6 +79,136 @@ TYPED_TEST(AsioServiceTest, BEH_StartAndStop) {
   EXPECT_FALSE(done);
 }
 
+TYPED_TEST(AsioServiceTest, BEH_Stats) {
+  IoService<TypeParam> asio_service(2);
+  asio_service.SetSlowHandlerThreshold(std::chrono::milliseconds(5));
+  const int kHandlerCount(10);
+  std::promise<void> done;
+  std::atomic<int> run_count(0);
+  for (int i(0); i != kHandlerCount; ++i) {
+    asio_service.Post([&, i] {
+      if (i == 0)
+        Sleep(std::chrono::milliseconds(20));
+      if (++run_count == kHandlerCount)
+        done.set_value();
+    }, i == 0 ? "slow" : "fast");
+  }
+  done.get_future().get();
+  asio_service.Stop();
+
+  const auto stats(asio_service.stats());
+  ASSERT_EQ(2U, stats.handlers_per_thread.size());
+  EXPECT_EQ(static_cast<uint64_t>(kHandlerCount),
+            stats.handlers_per_thread[0] + stats.handlers_per_thread[1]);
+  EXPECT_EQ(static_cast<uint64_t>(kHandlerCount), stats.queue_delay.count);
+  EXPECT_EQ(static_cast<uint64_t>(kHandlerCount), stats.run_time.count);
+  EXPECT_EQ(1U, stats.slow_handlers);
+  EXPECT_EQ("slow", stats.longest_handler_tag);
+  EXPECT_GE(stats.longest_handler, std::chrono::milliseconds(20));
+  EXPECT_GE(stats.busy_time, stats.longest_handler);
+  EXPECT_GT(stats.IdleRatio(), 0.0);
+  EXPECT_LT(stats.IdleRatio(), 1.0);
+}
+
+TYPED_TEST(AsioServiceTest, BEH_Resize) {
+  IoService<TypeParam> asio_service(1);
+  EXPECT_THROW(asio_service.Resize(0), maidsafe_error);
+
+  // Check that 'count' handlers can all be running at once.
+  auto run_concurrently([&](int count) {
+    std::mutex mutex;
+    std::condition_variable cond_var;
+    int running(0);
+    std::atomic<int> finished(0);
+    for (int i(0); i != count; ++i) {
+      asio_service.Post([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++running;
+        cond_var.notify_all();
+        EXPECT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(5),
+                                      [&] { return running == count; }));
+        ++finished;
+      });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(5), [&] { return running == count; }));
+    lock.unlock();
+    while (finished != count)
+      std::this_thread::yield();
+  });
+
+  asio_service.Resize(4);
+  EXPECT_EQ(4U, asio_service.ThreadCount());
+  run_concurrently(4);
+
+  asio_service.Resize(2);
+  EXPECT_EQ(2U, asio_service.ThreadCount());
+  run_concurrently(2);
+  asio_service.Resize(3);
+  EXPECT_EQ(3U, asio_service.ThreadCount());
+  run_concurrently(3);
+
+  asio_service.Stop();
+  EXPECT_THROW(asio_service.Resize(2), maidsafe_error);
+  const auto stats(asio_service.stats());
+  EXPECT_GE(stats.handlers_per_thread.size(), 4U);
+  EXPECT_EQ(9U, stats.run_time.count);
+  EXPECT_GE(stats.thread_time, stats.busy_time);
+}
+
+TYPED_TEST(AsioServiceTest, BEH_ServicePool) {
+  EXPECT_THROW(IoServicePool<TypeParam>(0), maidsafe_error);
+
+  const size_t kServiceCount(4);
+  IoServicePool<TypeParam> pool(kServiceCount, true);
+  EXPECT_EQ(kServiceCount, pool.size());
+  EXPECT_EQ(&pool.service(1), &pool.ServiceFor(kServiceCount + 1));
+  EXPECT_THROW(pool.service(kServiceCount), std::out_of_range);
+
+  // Each service runs on its own single thread.
+  std::vector<std::promise<std::thread::id>> thread_ids(2 * kServiceCount);
+  std::vector<TypeParam*> services;
+  for (auto& thread_id : thread_ids) {
+    services.push_back(&pool.next());
+    services.back()->post([&thread_id] { thread_id.set_value(std::this_thread::get_id()); });
+  }
+  std::vector<std::thread::id> ids;
+  for (auto& thread_id : thread_ids)
+    ids.push_back(thread_id.get_future().get());
+  for (size_t i(0); i != kServiceCount; ++i) {
+    EXPECT_EQ(services[i], services[i + kServiceCount]);
+    EXPECT_EQ(ids[i], ids[i + kServiceCount]);
+    for (size_t j(i + 1); j != kServiceCount; ++j)
+      EXPECT_NE(ids[i], ids[j]);
+  }
+  EXPECT_NO_THROW(pool.Stop());
+
+  // Pinned services are spread over the NUMA nodes in order (unless pinning isn't permitted).
+  const std::vector<unsigned> cpus(numa::CpusByNode());
+  for (size_t i(0); i != kServiceCount; ++i) {
+    const unsigned node(pool.NumaNode(i));
+    EXPECT_TRUE(node == numa::NodeOfCpu(cpus[i % cpus.size()]) || node == numa::kAnyNode);
+  }
+  IoServicePool<TypeParam> unpinned(1);
+  EXPECT_EQ(numa::kAnyNode, unpinned.NumaNode(0));
+}
+
+TYPED_TEST(AsioServiceTest, BEH_NumaNode) {
+  EXPECT_THROW(IoService<TypeParam>(1, numa::Topology().back().id + 1), maidsafe_error);
+  EXPECT_EQ(numa::kAnyNode, IoService<TypeParam>(1).NumaNode());
+
+  // Every thread, including those added by Resize, runs on the given node.
+  const unsigned node(numa::Topology().back().id);
+  IoService<TypeParam> asio_service(2, node);
+  EXPECT_EQ(node, asio_service.NumaNode());
+  asio_service.Resize(4);
+  std::vector<std::promise<unsigned>> nodes(16);
+  for (auto& running_node : nodes)
+    asio_service.service().post([&running_node] { running_node.set_value(numa::CurrentNode()); });
+  for (auto& running_node : nodes)
+    EXPECT_EQ(node, running_node.get_future().get());
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
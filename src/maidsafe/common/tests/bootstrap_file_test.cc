@@ -0,0 +1,110 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/bootstrap_file.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+std::vector<asio::ip::udp::endpoint> TestEndpoints() {
+  return std::vector<asio::ip::udp::endpoint>{
+      asio::ip::udp::endpoint(asio::ip::make_address("192.168.12.45"), 64435),
+      asio::ip::udp::endpoint(asio::ip::make_address("10.168.12.45"), 5483),
+      asio::ip::udp::endpoint(asio::ip::make_address("2001:db8::1"), 5483),
+      asio::ip::udp::endpoint(asio::ip::make_address("10.168.12.45"), 5484),
+      asio::ip::udp::endpoint(asio::ip::make_address("192.168.12.45"), 64435)};
+}
+
+}  // unnamed namespace
+
+TEST(BootstrapFileTest, BEH_SerialiseAndView) {
+  const std::vector<asio::ip::udp::endpoint> endpoints(TestEndpoints());
+  const std::vector<byte> serialised(SerialiseCompactBootstrap(endpoints));
+  ASSERT_TRUE(IsCompactBootstrap(serialised.data(), serialised.size()));
+  EXPECT_EQ(16U + 4U * 18U, serialised.size());
+
+  const CompactBootstrapFile view(serialised.data(), serialised.size());
+  ASSERT_EQ(4U, view.size());
+  // Duplicates are removed and IPv4 addresses are ordered before IPv6 ones.
+  EXPECT_EQ(endpoints[1], view[0]);
+  EXPECT_EQ(endpoints[3], view[1]);
+  EXPECT_EQ(endpoints[0], view[2]);
+  EXPECT_EQ(endpoints[2], view[3]);
+  EXPECT_TRUE(view[0].address().is_v4());
+  EXPECT_TRUE(view[3].address().is_v6());
+
+  for (const auto& endpoint : endpoints)
+    EXPECT_TRUE(view.Contains(endpoint));
+  EXPECT_FALSE(view.Contains(
+      asio::ip::udp::endpoint(asio::ip::make_address("10.168.12.45"), 5485)));
+  EXPECT_FALSE(view.Contains(asio::ip::udp::endpoint(asio::ip::make_address("::1"), 5483)));
+
+  std::vector<asio::ip::udp::endpoint> round_tripped(view.Endpoints());
+  EXPECT_EQ(view.size(), round_tripped.size());
+  EXPECT_EQ(serialised, SerialiseCompactBootstrap(round_tripped));
+
+  const std::vector<byte> empty(SerialiseCompactBootstrap({}));
+  EXPECT_TRUE(CompactBootstrapFile(empty.data(), empty.size()).empty());
+}
+
+TEST(BootstrapFileTest, BEH_InvalidData) {
+  std::vector<byte> serialised(SerialiseCompactBootstrap(TestEndpoints()));
+  EXPECT_THROW(CompactBootstrapFile(serialised.data(), 15), common_error);
+  EXPECT_THROW(CompactBootstrapFile(serialised.data(), serialised.size() - 1), common_error);
+  EXPECT_THROW(CompactBootstrapFile(serialised.data(), serialised.size() - 18), common_error);
+
+  std::vector<byte> bad_version(serialised);
+  ++bad_version[8];
+  EXPECT_THROW(CompactBootstrapFile(bad_version.data(), bad_version.size()), common_error);
+
+  std::vector<byte> bad_magic(serialised);
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(IsCompactBootstrap(bad_magic.data(), bad_magic.size()));
+  EXPECT_THROW(CompactBootstrapFile(bad_magic.data(), bad_magic.size()), common_error);
+}
+
+TEST(BootstrapFileTest, BEH_MapFile) {
+  const TestPath test_path(CreateTestPath("MaidSafe_Test_BootstrapFile"));
+  const boost::filesystem::path file(*test_path / "bootstrap.dat");
+  EXPECT_THROW(CompactBootstrapFile{file}, common_error);
+
+  const std::vector<byte> serialised(SerialiseCompactBootstrap(TestEndpoints()));
+  ASSERT_TRUE(WriteFile(file, serialised));
+  CompactBootstrapFile mapped(file);
+  EXPECT_EQ(4U, mapped.size());
+  const CompactBootstrapFile moved(std::move(mapped));
+  EXPECT_EQ(0U, mapped.size());
+  EXPECT_EQ(4U, moved.size());
+  EXPECT_TRUE(moved.Contains(TestEndpoints().front()));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -74,6 +74,22 @@ std::string BoundedStringTest<std::string>::RandomData(std::size_t size) const {
   return RandomString(size);
 }
 
+template <>
+SmallString<8> BoundedStringTest<SmallString<8>>::RandomData(std::uint32_t min,
+                                                             std::uint32_t max) const {
+  return RandomBytes(min, max);
+}
+
+template <>
+SmallString<8> BoundedStringTest<SmallString<8>>::RandomData(std::size_t size) const {
+  return RandomBytes(size);
+}
+
+template <>
+std::string BoundedStringTest<SmallString<8>>::ToString(const SmallString<8>& input) const {
+  return std::string(input.begin(), input.end());
+}
+
 template <>
 std::string BoundedStringTest<std::vector<byte>>::ToString(const std::vector<byte>& input) const {
   return convert::ToString(input);
@@ -86,7 +102,7 @@ std::string BoundedStringTest<std::string>::ToString(const std::string& input) c
 
 
 
-using TestTypes = testing::Types<std::vector<byte>, std::string>;
+using TestTypes = testing::Types<std::vector<byte>, std::string, SmallString<8>>;
 TYPED_TEST_CASE(BoundedStringTest, TestTypes);
 
 TYPED_TEST(BoundedStringTest, BEH_DefaultConstructor) {
@@ -137,6 +153,24 @@ TYPED_TEST(BoundedStringTest, BEH_StringConstructor) {
   EXPECT_EQ(random, this->ToString(e.string()));
 }
 
+TYPED_TEST(BoundedStringTest, BEH_TryMake) {
+  auto too_small(TestFixture::TwoThree::TryMake(this->RandomData(1)));
+  ASSERT_FALSE(too_small);
+  EXPECT_EQ(make_error_code(CommonErrors::outside_of_bounds), too_small.error().code());
+  EXPECT_FALSE(TestFixture::TwoThree::TryMake(this->RandomData(4)));
+
+  const auto random(this->RandomData(2));
+  const auto valid(TestFixture::TwoThree::TryMake(random));
+  ASSERT_TRUE(valid);
+  EXPECT_EQ(random, valid->string());
+
+  EXPECT_FALSE(TestFixture::OneMax::TryMake(std::string()));
+  const std::string random_string(RandomString(3));
+  const auto from_string(TestFixture::TwoThree::TryMake(random_string));
+  ASSERT_TRUE(from_string);
+  EXPECT_EQ(random_string, this->ToString(from_string->string()));
+}
+
 TYPED_TEST(BoundedStringTest, BEH_Swap) {
   // Swap with initialised
   auto random1(this->RandomData(1));
@@ -277,6 +311,32 @@ TYPED_TEST(BoundedStringTest, BEH_Serialization) {
   EXPECT_EQ(b.string(), d.string());
 }
 
+TYPED_TEST(BoundedStringTest, BEH_BinaryArchiveFormat) {
+  // A fixed-size instance is written as its characters alone.
+  const typename TestFixture::TwoTwo fixed(this->RandomData(2));
+  const SerialisedData serialised_fixed(Serialise(fixed));
+  EXPECT_EQ(2U * sizeof(typename TestFixture::TwoTwo::value_type), serialised_fixed.size());
+  EXPECT_EQ(serialised_fixed.size(), SerialisedSize(fixed));
+  EXPECT_EQ(fixed, Parse<typename TestFixture::TwoTwo>(serialised_fixed));
+  EXPECT_THROW(Parse<typename TestFixture::TwoTwo>(serialised_fixed.data(), 1), common_error);
+
+  // A variable-size instance is written as its String would be.
+  const typename TestFixture::TwoFour variable(this->RandomData(4));
+  const SerialisedData serialised_variable(Serialise(variable));
+  EXPECT_EQ(Serialise(variable.string()), serialised_variable);
+  EXPECT_EQ(serialised_variable.size(), SerialisedSize(variable));
+  EXPECT_EQ(variable, Parse<typename TestFixture::TwoFour>(serialised_variable));
+  EXPECT_THROW(Parse<typename TestFixture::TwoThree>(serialised_variable), common_error);
+  EXPECT_THROW(Parse<typename TestFixture::TwoFour>(serialised_variable.data(),
+                                                    serialised_variable.size() - 1),
+               common_error);
+
+  // A size prefix claiming more than the input holds is rejected before allocating.
+  SerialisedData huge_size(Serialise(cereal::size_type(-1)));
+  huge_size.push_back(0);
+  EXPECT_THROW(Parse<typename TestFixture::TwoMax>(huge_size), common_error);
+}
+
 TYPED_TEST(BoundedStringTest, BEH_StreamOperator) {
   std::stringstream ss;
   typename TestFixture::OneMax a(this->RandomData(1, 1000));
@@ -288,6 +348,49 @@ TYPED_TEST(BoundedStringTest, BEH_StreamOperator) {
   EXPECT_EQ(ss.str(), "Invalid string");
 }
 
+TEST(SmallStringTest, BEH_InlineAndHeapStorage) {
+  const std::vector<byte> short_bytes(RandomBytes(8));
+  const std::vector<byte> long_bytes(RandomBytes(9));
+  SmallString<8> small(short_bytes);
+  SmallString<8> large(long_bytes);
+  EXPECT_TRUE(small.is_inline());
+  EXPECT_FALSE(large.is_inline());
+  EXPECT_EQ(short_bytes, small);
+  EXPECT_EQ(long_bytes, large);
+  EXPECT_TRUE(SmallString<8>().empty());
+
+  // Copying and moving in either direction between inline and heap storage.
+  SmallString<8> copy(small);
+  EXPECT_EQ(small, copy);
+  copy = large;
+  EXPECT_EQ(large, copy);
+  EXPECT_FALSE(copy.is_inline());
+  copy = small;
+  EXPECT_EQ(small, copy);
+  EXPECT_TRUE(copy.is_inline());
+  SmallString<8> moved(std::move(large));
+  EXPECT_EQ(long_bytes, moved);
+  EXPECT_TRUE(large.empty());
+  moved = std::move(small);
+  EXPECT_EQ(short_bytes, moved);
+  EXPECT_TRUE(moved.is_inline());
+
+  // Ordered and serialised as std::vector<byte> would be.
+  const std::vector<byte> lhs{1, 2}, rhs{1, 2, 0};
+  EXPECT_TRUE(SmallString<8>(lhs) < SmallString<8>(rhs));
+  EXPECT_EQ(Serialise(long_bytes), Serialise(SmallString<8>(long_bytes)));
+  EXPECT_EQ(long_bytes, Parse<SmallString<8>>(Serialise(long_bytes)));
+}
+
+TEST(SmallStringTest, BEH_ConvertToAndFromNonEmptyString) {
+  const NonEmptyString non_empty(RandomBytes(1, 100));
+  const SmallNonEmptyString small(non_empty);
+  EXPECT_EQ(non_empty.string(), small.string());
+  EXPECT_EQ(non_empty, NonEmptyString(small));
+  EXPECT_EQ(Serialise(non_empty), Serialise(small));
+  EXPECT_EQ(hex::Encode(non_empty), hex::Encode(small));
+}
+
 }  // namespace test
 
 }  // namespace detail
@@ -0,0 +1,57 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/chacha20.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "maidsafe/common/encode.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace test {
+
+TEST(ChaCha20Test, BEH_Keystream) {
+  // The block function test vector from RFC 7539 section 2.3.2.
+  std::array<byte, kChaCha20KeySize> key;
+  for (size_t i(0); i != key.size(); ++i)
+    key[i] = static_cast<byte>(i);
+  const std::array<byte, kChaCha20NonceSize> nonce{{0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0}};
+  std::vector<byte> keystream(kChaCha20BlockSize * 3);
+  ChaCha20Keystream(key.data(), nonce.data(), 1, 3, keystream.data());
+  EXPECT_EQ(
+      "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+      "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e",
+      hex::Encode(std::vector<byte>(keystream.begin(), keystream.begin() + kChaCha20BlockSize)));
+
+  // Generating the later blocks on their own gives the same output.
+  std::vector<byte> tail(kChaCha20BlockSize * 2);
+  ChaCha20Keystream(key.data(), nonce.data(), 2, 2, tail.data());
+  EXPECT_TRUE(std::equal(tail.begin(), tail.end(), keystream.begin() + kChaCha20BlockSize));
+}
+
+}  // namespace test
+
+}  // namespace detail
+
+}  // namespace maidsafe
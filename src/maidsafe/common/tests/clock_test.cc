@@ -17,6 +17,9 @@
     use of the MaidSafe Software.                                                                 */
 
 #include "maidsafe/common/clock.h"
+
+#include <thread>
+
 #include "maidsafe/common/test.h"
 
 namespace maidsafe {
@@ -33,5 +36,44 @@ TEST(ClockTest, BEH_TimePointConversion) {
   EXPECT_EQ(result, 43);
 }
 
+TEST(ClockTest, BEH_CoarseClocks) {
+  // The first call starts the refreshing thread.
+  const auto system_start(CoarseSystemClock::now());
+  const auto steady_start(CoarseSteadyClock::now());
+  EXPECT_LE(system_start, std::chrono::system_clock::now());
+  EXPECT_LE(steady_start, std::chrono::steady_clock::now());
+
+  const std::chrono::milliseconds interval(50);
+  std::this_thread::sleep_for(interval);
+  const auto steady_end(CoarseSteadyClock::now());
+  EXPECT_GT(steady_end, steady_start);
+  EXPECT_LE(steady_end, std::chrono::steady_clock::now());
+  // Allow for the refreshing thread being starved on a busy machine.
+  EXPECT_LE(std::chrono::steady_clock::now() - steady_end, std::chrono::seconds(1));
+  EXPECT_GT(CoarseSystemClock::now(), system_start);
+}
+
+TEST(ClockTest, BEH_TscClock) {
+  static_assert(TscClock::is_steady, "TscClock should be steady");
+  const auto tsc_start(TscClock::now());
+  const auto steady_start(std::chrono::steady_clock::now());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto tsc_elapsed(TscClock::now() - tsc_start);
+  const auto steady_elapsed(std::chrono::steady_clock::now() - steady_start);
+
+  // Whether or not the timestamp counter is usable here, the two clocks should agree closely.
+  EXPECT_GT(tsc_elapsed, TscClock::duration::zero());
+  const auto difference(tsc_elapsed > steady_elapsed ? tsc_elapsed - steady_elapsed
+                                                     : steady_elapsed - tsc_elapsed);
+  EXPECT_LT(difference, std::chrono::milliseconds(5));
+
+  auto previous(TscClock::now());
+  for (int i(0); i != 1000; ++i) {
+    const auto now(TscClock::now());
+    EXPECT_LE(previous, now);
+    previous = now;
+  }
+}
+
 }  // namespace test
 }  // namespace maidsafe
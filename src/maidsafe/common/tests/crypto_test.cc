@@ -19,9 +19,15 @@
 #include "maidsafe/common/crypto.h"
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
+#include <future>
+#include <numeric>
 #include <random>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "boost/lexical_cast.hpp"
 #include "boost/filesystem/path.hpp"
@@ -202,6 +208,109 @@ TYPED_TEST(ShaTest, BEH_All) {
   EXPECT_THROW(Hash<SHA256>(Identity()), common_error);
 }
 
+template <typename HashType>
+void CheckHasher(const std::vector<byte>& input) {
+  const auto expected(Hash<HashType>(input));
+  Hasher<HashType> hasher;
+  // Feed the input in random-sized chunks, including empty ones.
+  size_t position(0);
+  while (position != input.size()) {
+    const size_t size(std::min<size_t>(RandomUint32() % 200, input.size() - position));
+    hasher.Update(input.data() + position, size);
+    position += size;
+  }
+  EXPECT_EQ(expected, hasher.Final());
+
+  // Final resets the hasher, and the caller-buffer overload gives the same digest.
+  hasher.Update(input);
+  std::array<byte, Hasher<HashType>::kDigestSize> digest;
+  hasher.Final(digest.data());
+  EXPECT_TRUE(std::equal(digest.begin(), digest.end(), expected.string().begin()));
+}
+
+TEST(CryptoTest, BEH_FastRandomNumberGenerator) {
+  CryptoPP::RandomNumberGenerator& random(fast_random_number_generator());
+  EXPECT_EQ(&random, &fast_random_number_generator());
+  // Requests within, across and far beyond the size of the internal buffer.
+  std::vector<std::vector<byte>> blocks;
+  for (const size_t size : {16, 17, 100, 4096, 5000, 1 << 20}) {
+    std::vector<byte> block(size);
+    random.GenerateBlock(block.data(), block.size());
+    blocks.push_back(block);
+  }
+  for (size_t i(0); i != blocks.size(); ++i) {
+    for (size_t j(i + 1); j != blocks.size(); ++j)
+      EXPECT_FALSE(std::equal(blocks[i].begin(), blocks[i].begin() + 16, blocks[j].begin()));
+  }
+  std::array<size_t, 256> counts{};
+  for (const byte value : blocks.back())
+    ++counts[value];
+  for (const size_t count : counts) {
+    EXPECT_GT(count, 3700U);
+    EXPECT_LT(count, 4500U);
+  }
+
+  // Each thread gets its own generator.
+  std::vector<byte> own(32), other(32);
+  random.GenerateBlock(own.data(), own.size());
+  std::async(std::launch::async, [&] {
+    EXPECT_NE(&random, &fast_random_number_generator());
+    fast_random_number_generator().GenerateBlock(other.data(), other.size());
+  }).get();
+  EXPECT_NE(own, other);
+}
+
+TEST(CryptoTest, BEH_Hasher) {
+  for (int i(0); i != 10; ++i) {
+    const std::vector<byte> input(RandomBytes(1, 5000));
+    CheckHasher<SHA1>(input);
+    CheckHasher<SHA256>(input);
+    CheckHasher<SHA384>(input);
+    CheckHasher<SHA512>(input);
+  }
+  // "abc" in several pieces.
+  Hasher<SHA256> hasher;
+  hasher.Update(std::string("a"));
+  hasher.Update(std::string("bc"));
+  EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+            hex::Encode(hasher.Final()));
+}
+
+TEST(CryptoTest, BEH_HashMany) {
+  EXPECT_TRUE(HashMany<SHA512>(std::vector<std::string>()).empty());
+  // Small inputs, then enough input to be split across threads.
+  for (const size_t input_size : {64, 2048}) {
+    std::vector<std::vector<byte>> byte_inputs;
+    std::vector<std::string> string_inputs;
+    for (int i(0); i != 1000; ++i) {
+      byte_inputs.push_back(RandomBytes(input_size));
+      string_inputs.push_back(RandomString(input_size));
+    }
+    const std::vector<Identity> byte_hashes(HashMany<SHA512>(byte_inputs));
+    const auto string_hashes(HashMany<SHA256>(string_inputs));
+    ASSERT_EQ(byte_inputs.size(), byte_hashes.size());
+    ASSERT_EQ(string_inputs.size(), string_hashes.size());
+    for (size_t i(0); i != byte_inputs.size(); ++i) {
+      EXPECT_EQ(Hash<SHA512>(byte_inputs[i]), byte_hashes[i]);
+      EXPECT_EQ(Hash<SHA256>(string_inputs[i]), string_hashes[i]);
+    }
+  }
+}
+
+TEST(CryptoTest, BEH_HashResultTypes) {
+  // SHA512 digests of byte strings are Identities; other digests keep the input's String type,
+  // except that a FixedString input gives a std::vector.
+  EXPECT_TRUE((std::is_same<Identity, HashResult<SHA512, std::vector<byte>>>::value));
+  EXPECT_TRUE(
+      (std::is_same<Identity, HashResult<SHA512, detail::FixedString<identity_size>>>::value));
+  EXPECT_TRUE((std::is_same<detail::BoundedString<64, 64, std::string>,
+                            HashResult<SHA512, std::string>>::value));
+  EXPECT_TRUE((std::is_same<detail::BoundedString<32, 32>,
+                            HashResult<SHA256, std::vector<byte>>>::value));
+  EXPECT_TRUE((std::is_same<detail::BoundedString<32, 32>,
+                            HashResult<SHA256, detail::FixedString<identity_size>>>::value));
+}
+
 std::vector<byte> CorruptData(std::vector<byte> input) {
   // Replace a single char of input to a different random char.
   ++input[RandomUint32() % input.size()];
@@ -238,6 +347,43 @@ TEST(CryptoTest, BEH_SymmEncrypt) {
   EXPECT_THROW(SymmDecrypt(kEncrypted, AES256KeyAndIV()), common_error);
 }
 
+TEST(CryptoTest, BEH_SymmEncryptBuffer) {
+  const AES256KeyAndIV kKeyAndIV(RandomBytes(AES256_KeySize + AES256_IVSize));
+  const PlainText kUnencrypted(RandomBytes(1, 1000));
+  const CipherText kEncrypted(SymmEncrypt(kUnencrypted, kKeyAndIV));
+  ASSERT_EQ(kUnencrypted.size() + AES256_TagSize, kEncrypted->size());
+
+  // Separate buffers must match the string API
+  std::vector<byte> buffer(kEncrypted->size(), 0);
+  SymmEncrypt(kUnencrypted.data(), kUnencrypted.size(), kKeyAndIV, buffer.data());
+  EXPECT_EQ(kEncrypted->string(), buffer);
+  std::vector<byte> decrypted(kUnencrypted.size(), 0);
+  SymmDecrypt(buffer.data(), buffer.size(), kKeyAndIV, decrypted.data());
+  EXPECT_EQ(kUnencrypted.string(), decrypted);
+
+  // In place, repeatedly with the same key and then with a different key
+  for (int i(0); i != 3; ++i) {
+    const AES256KeyAndIV key_and_iv(i == 2 ? AES256KeyAndIV(RandomBytes(
+                                                 AES256_KeySize + AES256_IVSize))
+                                           : kKeyAndIV);
+    buffer.assign(kUnencrypted.begin(), kUnencrypted.end());
+    buffer.resize(kUnencrypted.size() + AES256_TagSize);
+    SymmEncrypt(buffer.data(), kUnencrypted.size(), key_and_iv, buffer.data());
+    EXPECT_EQ(SymmEncrypt(kUnencrypted, key_and_iv)->string(), buffer);
+    SymmDecrypt(buffer.data(), buffer.size(), key_and_iv, buffer.data());
+    EXPECT_TRUE(std::equal(kUnencrypted.begin(), kUnencrypted.end(), buffer.begin()));
+  }
+
+  // Tampering, truncation and uninitialised keys
+  buffer.assign(kEncrypted->begin(), kEncrypted->end());
+  ++buffer[RandomUint32() % buffer.size()];
+  EXPECT_THROW(SymmDecrypt(buffer.data(), buffer.size(), kKeyAndIV, decrypted.data()),
+               common_error);
+  EXPECT_THROW(SymmDecrypt(buffer.data(), AES256_TagSize - 1, kKeyAndIV, decrypted.data()),
+               common_error);
+  EXPECT_THROW(SymmEncrypt(buffer.data(), 1, AES256KeyAndIV(), decrypted.data()), common_error);
+}
+
 TEST(CryptoTest, BEH_Compress) {
   EXPECT_THROW(Compress(UncompressedText(), 1), common_error);
   EXPECT_THROW(Uncompress(CompressedText()), common_error);
@@ -275,6 +421,92 @@ TEST(CryptoTest, BEH_Compress) {
   EXPECT_THROW(Uncompress(CompressedText(kTestData)), common_error);
 }
 
+TEST(CryptoTest, BEH_CompressionCodecs) {
+  std::vector<byte> data(RandomBytes(5000));
+  data.resize(20000, 'A');
+  const UncompressedText kTestData(data);
+  const CompressedText kGzipped(Compress(kTestData, 6));
+  EXPECT_TRUE(CompressionCodecAvailable(CompressionCodec::kGzip));
+  EXPECT_EQ(kGzipped, Compress(kTestData, CompressionCodec::kGzip, 6));
+
+  const std::vector<std::pair<CompressionCodec, std::pair<int, int>>> kCodecs{
+      {CompressionCodec::kGzip, {0, 9}},
+      {CompressionCodec::kLz4, {0, 12}},
+      {CompressionCodec::kZstd, {1, 19}}};
+  for (const auto& codec : kCodecs) {
+    SCOPED_TRACE(static_cast<int>(codec.first));
+    const int min_level(codec.second.first), max_level(codec.second.second);
+    if (!CompressionCodecAvailable(codec.first)) {
+      EXPECT_THROW(Compress(kTestData, codec.first, min_level), common_error);
+      continue;
+    }
+    for (const int level : {min_level, (min_level + max_level) / 2, max_level}) {
+      const CompressedText compressed(Compress(kTestData, codec.first, level));
+      EXPECT_GT(kTestData.size(), compressed->size());
+      EXPECT_EQ(kTestData, Uncompress(compressed));
+    }
+    EXPECT_THROW(Compress(kTestData, codec.first, min_level - 1), common_error);
+    EXPECT_THROW(Compress(kTestData, codec.first, max_level + 1), common_error);
+    EXPECT_THROW(Compress(UncompressedText(), codec.first, min_level), common_error);
+    // Truncated data
+    const CompressedText compressed(Compress(kTestData, codec.first, min_level));
+    const std::vector<byte> truncated(compressed->begin(),
+                                      compressed->begin() + compressed->size() / 2);
+    EXPECT_THROW(Uncompress(CompressedText(NonEmptyString(truncated))), common_error);
+  }
+
+  // Dictionary compression
+  const CompressionDictionary kDictionary(NonEmptyString(std::vector<byte>(data.begin(),
+                                                                           data.begin() + 5000)));
+  if (!CompressionCodecAvailable(CompressionCodec::kZstd)) {
+    EXPECT_THROW(Compress(kTestData, kDictionary, 1), common_error);
+    EXPECT_THROW(Uncompress(kGzipped, kDictionary), common_error);
+    return;
+  }
+  const CompressedText with_dictionary(Compress(kTestData, kDictionary, 3));
+  EXPECT_GT(Compress(kTestData, CompressionCodec::kZstd, 3)->size(), with_dictionary->size());
+  EXPECT_EQ(kTestData, Uncompress(with_dictionary, kDictionary));
+  EXPECT_THROW(Uncompress(with_dictionary), common_error);
+  EXPECT_THROW(Uncompress(kGzipped, kDictionary), common_error);
+}
+
+TEST(CryptoTest, BEH_CompressionDictionaryTraining) {
+  // Small records sharing most of their structure
+  auto make_record = [] {
+    return NonEmptyString("{\"type\":\"structured_data_versions\",\"max_versions\":100,"
+                          "\"max_branches\":10,\"version\":{\"index\":" +
+                          std::to_string(RandomUint32() % 1000) + ",\"id\":\"" +
+                          RandomAlphaNumericString(16) + "\"}}");
+  };
+  std::vector<NonEmptyString> samples;
+  for (int i(0); i != 1000; ++i)
+    samples.push_back(make_record());
+
+  if (!CompressionCodecAvailable(CompressionCodec::kZstd)) {
+    EXPECT_THROW(TrainCompressionDictionary(samples), common_error);
+    EXPECT_THROW(Compress(samples.front(), 1u, 3), common_error);
+    return;
+  }
+  const CompressionDictionary dictionary(TrainCompressionDictionary(samples, 4096));
+  EXPECT_GE(4096U, dictionary->size());
+  const uint32_t dictionary_id(GetCompressionDictionaryId(dictionary));
+  EXPECT_NE(0U, dictionary_id);
+  EXPECT_THROW(Compress(samples.front(), dictionary_id, 3), common_error);
+  EXPECT_EQ(dictionary_id, RegisterCompressionDictionary(dictionary));
+  EXPECT_EQ(dictionary_id, RegisterCompressionDictionary(dictionary));
+  EXPECT_THROW(RegisterCompressionDictionary(CompressionDictionary(samples.front())),
+               common_error);
+
+  const UncompressedText record(make_record());
+  const CompressedText compressed(Compress(record, dictionary_id, 3));
+  EXPECT_GT(Compress(record, CompressionCodec::kZstd, 3)->size(), compressed->size());
+  EXPECT_EQ(record, Uncompress(compressed));
+  EXPECT_EQ(record, Uncompress(compressed, dictionary));
+  EXPECT_THROW(Compress(record, dictionary_id, 0), common_error);
+
+  EXPECT_THROW(TrainCompressionDictionary(std::vector<NonEmptyString>(1, record)), common_error);
+}
+
 TEST(CryptoTest, BEH_GzipSHA512Deterministic) {
   // if the algorithm changes this test will start failing as it is a bit of a sledgehammer approach
   std::string test_data = "11111111111111122222222222222222222333333333333";
@@ -466,6 +698,89 @@ TEST_F(InformationDispersalTest, FUNC_MultipleValues) {
   } while (data_size_ < 2 * 1024 * 1024);
 }
 
+TEST_F(InformationDispersalTest, BEH_ShareRecoveryContext) {
+  using Scheme = ShareRecoveryContext::Scheme;
+  std::mt19937 rng(RandomUint32());
+  for (const auto& args : std::vector<std::pair<int32_t, int32_t>>{{2, 3}, {3, 3}, {29, 32}}) {
+    SCOPED_TRACE(std::to_string(args.first) + " of " + std::to_string(args.second));
+    std::vector<uint32_t> indices(args.second);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), rng);
+    indices.resize(args.first);
+    const ShareRecoveryContext info_context(Scheme::kInformationDispersal, indices);
+    const ShareRecoveryContext secret_context(Scheme::kSecretSharing, indices);
+
+    // Many values recovered against the same contexts
+    for (const size_t data_size : {1, 2, 3, 4, 5, 100, 1001, 64 * 1024 + 3}) {
+      random_data_ = PlainText(RandomBytes(data_size));
+      dispersed_data_parts_ = InfoDisperse(args.first, args.second, random_data_);
+      secret_data_parts_ = SecretShareData(args.first, args.second, random_data_);
+      DataParts dispersed_parts, secret_parts;
+      for (const uint32_t index : indices) {
+        dispersed_parts.push_back(dispersed_data_parts_[index]);
+        secret_parts.push_back(secret_data_parts_[index]);
+      }
+      std::shuffle(secret_parts.begin(), secret_parts.end(), rng);
+      EXPECT_EQ(random_data_, info_context.Recover(dispersed_parts));
+      EXPECT_EQ(InfoRetrieve(dispersed_parts), info_context.Recover(dispersed_parts));
+      EXPECT_EQ(random_data_, secret_context.Recover(secret_parts));
+      // More shares than the threshold can be used for secret recovery
+      const ShareRecoveryContext all_shares_context(
+          Scheme::kSecretSharing, ShareRecoveryContext::ShareIndices(secret_data_parts_));
+      EXPECT_EQ(random_data_, all_shares_context.Recover(secret_data_parts_));
+    }
+
+    // Shares from a different set of holders
+    DataParts parts(dispersed_data_parts_.begin(), dispersed_data_parts_.begin() + args.first);
+    if (ShareRecoveryContext::ShareIndices(parts) != info_context.share_indices()) {
+      EXPECT_THROW(info_context.Recover(parts), common_error);
+    }
+    parts.pop_back();
+    EXPECT_THROW(info_context.Recover(parts), common_error);
+  }
+  EXPECT_THROW((ShareRecoveryContext(Scheme::kSecretSharing, {1})), common_error);
+  EXPECT_THROW((ShareRecoveryContext(Scheme::kSecretSharing, {1, 2, 1})), common_error);
+}
+
+TEST_F(InformationDispersalTest, BEH_ErasureCode) {
+  std::mt19937 rng(RandomUint32());
+  for (const size_t data_size : {1, 2, 1000, 1024 * 1024 + 3}) {
+    random_data_ = PlainText(RandomBytes(data_size));
+    const int32_t random_threshold(static_cast<int32_t>(RandomUint32() % 100) + 2);
+    for (const auto& args : std::vector<std::pair<int32_t, int32_t>>{
+             {2, 3}, {3, 3}, {29, 32}, {2, 256}, {random_threshold, 102}}) {
+      SCOPED_TRACE(std::to_string(data_size) + " bytes, " + std::to_string(args.first) + " of " +
+                   std::to_string(args.second));
+      dispersed_data_parts_ = ErasureDisperse(args.first, args.second, random_data_);
+      ASSERT_EQ(static_cast<size_t>(args.second), dispersed_data_parts_.size());
+      // Data shares only, a random mix, and parity shares as far as possible
+      DataParts parts(dispersed_data_parts_.begin(), dispersed_data_parts_.begin() + args.first);
+      EXPECT_EQ(random_data_, ErasureRetrieve(parts));
+      parts = dispersed_data_parts_;
+      std::shuffle(parts.begin(), parts.end(), rng);
+      parts.resize(args.first);
+      EXPECT_EQ(random_data_, ErasureRetrieve(parts));
+      parts.assign(dispersed_data_parts_.rbegin(), dispersed_data_parts_.rbegin() + args.first);
+      EXPECT_EQ(random_data_, ErasureRetrieve(parts));
+      // Duplicates and surplus shares are ignored, but too few distinct shares is an error
+      parts.push_back(parts.front());
+      EXPECT_EQ(random_data_, ErasureRetrieve(parts));
+      EXPECT_EQ(random_data_, ErasureRetrieve(dispersed_data_parts_));
+      parts.resize(args.first - 1);
+      parts.push_back(parts.front());
+      EXPECT_THROW(ErasureRetrieve(parts), common_error);
+    }
+  }
+  EXPECT_THROW(ErasureDisperse(1, 3, random_data_), common_error);
+  EXPECT_THROW(ErasureDisperse(4, 3, random_data_), common_error);
+  EXPECT_THROW(ErasureDisperse(2, 257, random_data_), common_error);
+  EXPECT_THROW(ErasureRetrieve(DataParts()), common_error);
+  // Shares from different dispersals can't be mixed
+  const DataParts other(ErasureDisperse(2, 3, PlainText(RandomBytes(1000))));
+  dispersed_data_parts_ = ErasureDisperse(2, 3, PlainText(RandomBytes(1001)));
+  EXPECT_THROW(ErasureRetrieve(DataParts{dispersed_data_parts_[0], other[1]}), common_error);
+}
+
 }  // namespace test
 
 }  // namespace crypto
@@ -18,17 +18,31 @@
 
 #include "maidsafe/common/data_buffer.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
 #include <utility>
 #include <vector>
 
+#include "asio/use_future.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/hot_key_tracker.h"
 #include "maidsafe/common/data_types/data.h"
 
 namespace fs = boost::filesystem;
@@ -257,12 +271,660 @@ TEST_F(DataBufferTest, BEH_SuccessfulStore) {
   EXPECT_EQ(recovered, value2);
 }
 
+TEST_F(DataBufferTest, BEH_TryGetAndTryDelete) {
+  NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(max_memory_usage_)));
+  auto key(GenerateKeyFromValue(value));
+
+  auto missing(data_buffer_->TryGet(key));
+  ASSERT_FALSE(missing);
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), missing.error().code());
+  EXPECT_FALSE(data_buffer_->TryDelete(key));
+
+  ASSERT_NO_THROW(data_buffer_->Store(key, value));
+  auto found(data_buffer_->TryGet(key));
+  ASSERT_TRUE(found);
+  EXPECT_EQ(value, *found);
+  EXPECT_TRUE(data_buffer_->TryDelete(key));
+  EXPECT_FALSE(data_buffer_->TryGet(key));
+  EXPECT_FALSE(data_buffer_->TryDelete(key));
+  EXPECT_EQ(2U, data_buffer_->stats().misses);
+}
+
 TEST_F(DataBufferTest, BEH_UnsuccessfulStore) {
   NonEmptyString value(std::string(static_cast<std::uint32_t>(max_disk_usage_ + 1), 'a'));
   auto key(GenerateKeyFromValue(value));
   ASSERT_THROW(data_buffer_->Store(key, value), common_error);
 }
 
+TEST_F(DataBufferTest, BEH_ParallelFlush) {
+  DataBuffer::Options options;
+  options.flush_worker_count = 0;
+  EXPECT_THROW(DataBuffer(MemoryUsage(1), DiskUsage(1), pop_functor_, options), common_error);
+  options.flush_worker_count = 4;
+  options.flush_batch_size = 0;
+  EXPECT_THROW(DataBuffer(MemoryUsage(1), DiskUsage(1), pop_functor_, options), common_error);
+  options.flush_batch_size = 8;
+  options.sync_on_flush = true;
+
+  const size_t num_entries(100), num_memory_entries(10);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(num_memory_entries * OneKB),
+                                    DiskUsage(num_entries * OneKB), pop_functor_, options));
+  KeyValueVector key_value_pairs;
+  for (size_t i(0); i < num_entries; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    auto key(GenerateKeyFromValue(value));
+    ASSERT_NO_THROW(data_buffer_->Store(key, value));
+    key_value_pairs.emplace_back(key, value);
+  }
+  for (const auto& key_value : key_value_pairs) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value.first));
+    EXPECT_EQ(key_value.second, recovered);
+  }
+
+  // Memory can only hold 'num_memory_entries' values, so the rest must have been flushed.
+  const auto stats(data_buffer_->flush_stats());
+  EXPECT_GE(stats.values_flushed, num_entries - num_memory_entries);
+  EXPECT_GE(stats.bytes_flushed, (num_entries - num_memory_entries) * OneKB);
+  EXPECT_LE(stats.batches_flushed, stats.values_flushed);
+  EXPECT_GT(stats.BytesPerSecond(), 0.0);
+
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_NO_THROW(data_buffer_->Delete(key_value.first));
+}
+
+TEST_F(DataBufferTest, BEH_ManyBufferedValues) {
+  // Large enough that linear lookups in the indices would make this test very slow.
+  const size_t num_entries(20000), value_size(16);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(num_entries * value_size),
+                                    DiskUsage(2 * num_entries * value_size), pop_functor_));
+  KeyValueVector key_value_pairs;
+  for (size_t i(0); i < num_entries; ++i) {
+    key_value_pairs.emplace_back(GenerateRandomKey(),
+                                 NonEmptyString(RandomAlphaNumericBytes(value_size)));
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first,
+                                        key_value_pairs.back().second));
+  }
+  for (const auto& key_value : key_value_pairs) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value.first));
+    ASSERT_EQ(key_value.second, recovered);
+  }
+
+  // Delete the first half by predicate and the rest individually.
+  std::set<KeyType> first_half;
+  for (size_t i(0); i < num_entries / 2; ++i)
+    first_half.insert(key_value_pairs[i].first);
+  ASSERT_NO_THROW(data_buffer_->Delete(
+      [&](const KeyType& key) { return first_half.count(key) == 1; }));
+  for (size_t i(0); i < num_entries; ++i) {
+    if (i < num_entries / 2)
+      EXPECT_THROW(data_buffer_->Get(key_value_pairs[i].first), common_error);
+    else
+      EXPECT_NO_THROW(data_buffer_->Delete(key_value_pairs[i].first));
+  }
+}
+
+TEST_F(DataBufferTest, BEH_SegmentedLog) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  fs::path data_buffer_path(*test_path / "data_buffer");
+  auto file_count([&data_buffer_path]() -> size_t {
+    return static_cast<size_t>(std::distance(fs::directory_iterator(data_buffer_path),
+                                             fs::directory_iterator()));
+  });
+
+  DataBuffer::Options options;
+  options.disk_layout = DataBuffer::DiskLayout::kSegmentedLog;
+  options.segment_size = 0;
+  EXPECT_THROW(DataBuffer(MemoryUsage(1), DiskUsage(1), pop_functor_, data_buffer_path, false,
+                          options),
+               common_error);
+  options.segment_size = 8 * OneKB;
+  options.compaction_threshold = 1.0;
+  EXPECT_THROW(DataBuffer(MemoryUsage(1), DiskUsage(1), pop_functor_, data_buffer_path, false,
+                          options),
+               common_error);
+  options.compaction_threshold = 0.5;
+  options.flush_worker_count = 2;
+  options.sync_on_flush = true;
+
+  const size_t num_entries(64), num_memory_entries(1);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(num_memory_entries * OneKB),
+                                    DiskUsage(num_entries * OneKB), pop_functor_,
+                                    data_buffer_path, false, options));
+  KeyValueVector key_value_pairs;
+  for (size_t i(0); i < num_entries; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB - 100)));
+    auto key(GenerateKeyFromValue(value));
+    ASSERT_NO_THROW(data_buffer_->Store(key, value));
+    key_value_pairs.emplace_back(key, value);
+  }
+  // Values are appended to 8KB segments rather than each having a file.
+  EXPECT_LE(file_count(), num_entries / 8 + 1);
+  for (const auto& key_value : key_value_pairs) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value.first));
+    EXPECT_EQ(key_value.second, recovered);
+  }
+
+  // Deleting most values should cause the full segments to be compacted in the background.
+  const auto file_count_before_deletes(file_count());
+  for (size_t i(0); i < num_entries; ++i) {
+    if (i % 4 != 0)
+      ASSERT_NO_THROW(data_buffer_->Delete(key_value_pairs[i].first));
+  }
+  for (int i(0); i < 100 && file_count() >= file_count_before_deletes; ++i)
+    Sleep(std::chrono::milliseconds(10));
+  EXPECT_LT(file_count(), file_count_before_deletes);
+  for (size_t i(0); i < num_entries; i += 4) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value_pairs[i].first));
+    EXPECT_EQ(key_value_pairs[i].second, recovered);
+  }
+}
+
+TEST_F(DataBufferTest, BEH_GetView) {
+  EXPECT_TRUE(DataBuffer::ValueView().empty());
+  for (auto layout : {DataBuffer::DiskLayout::kFilePerKey, DataBuffer::DiskLayout::kSegmentedLog}) {
+    maidsafe::test::TestPath test_path(
+        maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+    DataBuffer::Options options;
+    options.disk_layout = layout;
+    data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(8 * OneKB), pop_functor_,
+                                      *test_path / "data_buffer", false, options));
+    auto view_of([](const DataBuffer::ValueView& view) {
+      return NonEmptyString(std::vector<byte>(view.begin(), view.end()));
+    });
+
+    // Too large for memory, so is mapped from disk.
+    NonEmptyString disk_value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(2 * OneKB)));
+    auto disk_key(GenerateKeyFromValue(disk_value));
+    ASSERT_NO_THROW(data_buffer_->Store(disk_key, disk_value));
+    DataBuffer::ValueView disk_view;
+    ASSERT_NO_THROW(disk_view = data_buffer_->GetView(disk_key));
+    EXPECT_EQ(disk_value, view_of(disk_view));
+
+    NonEmptyString memory_value(RandomAlphaNumericBytes(100));
+    auto memory_key(GenerateKeyFromValue(memory_value));
+    ASSERT_NO_THROW(data_buffer_->Store(memory_key, memory_value));
+    DataBuffer::ValueView memory_view;
+    ASSERT_NO_THROW(memory_view = data_buffer_->GetView(memory_key));
+    EXPECT_EQ(memory_value, view_of(memory_view));
+
+    // The views outlive the values.
+    ASSERT_NO_THROW(data_buffer_->Delete(disk_key));
+    ASSERT_NO_THROW(data_buffer_->Delete(memory_key));
+    EXPECT_THROW(data_buffer_->GetView(disk_key), common_error);
+    EXPECT_EQ(disk_value, view_of(disk_view));
+    EXPECT_EQ(memory_value, view_of(memory_view));
+    data_buffer_.reset();
+  }
+}
+
+TEST_F(DataBufferTest, BEH_StoreShared) {
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(8 * OneKB), pop_functor_));
+  // A value stored from a SharedBuffer is held in memory without being copied.
+  const SharedBuffer value(NonEmptyString(RandomAlphaNumericBytes(100)));
+  const auto key(GenerateRandomKey());
+  ASSERT_NO_THROW(data_buffer_->Store(key, value));
+  DataBuffer::ValueView view;
+  ASSERT_NO_THROW(view = data_buffer_->GetView(key));
+  EXPECT_EQ(value.data(), view.data());
+  EXPECT_EQ(value.ToNonEmptyString(), data_buffer_->Get(key));
+
+  // A slice is copied once, and values too large for memory go straight to disk.
+  const SharedBuffer large(RandomAlphaNumericBytes(static_cast<std::uint32_t>(2 * OneKB)));
+  for (const SharedBuffer& stored : {value.Slice(1), large}) {
+    const auto stored_key(GenerateRandomKey());
+    ASSERT_NO_THROW(data_buffer_->Store(stored_key, stored));
+    EXPECT_EQ(stored.ToNonEmptyString(), data_buffer_->Get(stored_key));
+  }
+}
+
+TEST_F(DataBufferTest, BEH_AsyncStoreAndGet) {
+  const size_t num_entries(4), num_memory_entries(1), num_disk_entries(4);
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  KeyValueVector key_value_pairs(PopulateDataBuffer(num_entries, num_memory_entries,
+                                                    num_disk_entries, test_path, pop_functor_));
+  DataBuffer::Executor executor([](std::function<void()> functor) { functor(); });
+
+  // The disk is full and there's no pop functor, so at most the first of these can be stored
+  // without waiting for a Delete (if the memory is only holding values already on disk).
+  KeyValueVector waiting;
+  std::vector<std::promise<std::error_code>> stored(2);
+  for (auto& promise : stored) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    auto key(GenerateKeyFromValue(value));
+    data_buffer_->AsyncStore(key, value, executor,
+                             [&promise](std::error_code error) { promise.set_value(error); });
+    waiting.emplace_back(key, value);
+  }
+  auto first_stored(stored[0].get_future()), second_stored(stored[1].get_future());
+  EXPECT_EQ(std::future_status::timeout, second_stored.wait_for(std::chrono::milliseconds(100)));
+
+  for (size_t i(0); i < waiting.size(); ++i)
+    ASSERT_NO_THROW(data_buffer_->Delete(key_value_pairs[i].first));
+  EXPECT_FALSE(first_stored.get());
+  EXPECT_FALSE(second_stored.get());
+
+  for (const auto& key_value : waiting) {
+    std::promise<std::pair<std::error_code, NonEmptyString>> got;
+    data_buffer_->AsyncGet(key_value.first, executor,
+                           [&got](std::error_code error, NonEmptyString value) {
+      got.set_value(std::make_pair(error, std::move(value)));
+    });
+    auto result(got.get_future().get());
+    EXPECT_FALSE(result.first);
+    EXPECT_EQ(key_value.second, result.second);
+  }
+
+  std::promise<std::error_code> missing;
+  data_buffer_->AsyncGet(GenerateRandomKey(), executor,
+                         [&missing](std::error_code error, NonEmptyString) {
+    missing.set_value(error);
+  });
+  EXPECT_EQ(make_error_code(CommonErrors::no_such_element), missing.get_future().get());
+}
+
+TEST_F(DataBufferTest, BEH_AsyncGetWithCompletionToken) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  // Values both in memory and only on disk.
+  KeyValueVector key_value_pairs(PopulateDataBuffer(4, 1, 4, test_path, pop_functor_));
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, data_buffer_->AsyncGet(key_value.first, asio::use_future).get());
+
+  std::future<NonEmptyString> missing(
+      data_buffer_->AsyncGet(GenerateRandomKey(), asio::use_future));
+  try {
+    missing.get();
+    ADD_FAILURE() << "Expected a missing value to fail.";
+  } catch (const std::system_error& error) {
+    EXPECT_EQ(make_error_code(CommonErrors::no_such_element), error.code());
+  }
+}
+
+TEST_F(DataBufferTest, BEH_Recovery) {
+  for (auto layout : {DataBuffer::DiskLayout::kFilePerKey, DataBuffer::DiskLayout::kSegmentedLog}) {
+    maidsafe::test::TestPath test_path(
+        maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+    fs::path data_buffer_path(*test_path / "data_buffer");
+    DataBuffer::Options options;
+    options.disk_layout = layout;
+    options.sync_on_flush = true;
+    options.recover_disk_buffer = true;
+    std::mutex mutex;
+    std::condition_variable cond_var;
+    std::vector<KeyType> popped;
+    PopFunctor pop_functor([&](const KeyType& key, const NonEmptyString&) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        popped.push_back(key);
+      }
+      cond_var.notify_one();
+    });
+    const size_t num_entries(8);
+    auto make_data_buffer([&] {
+      data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(num_entries * OneKB),
+                                        pop_functor, data_buffer_path, false, options));
+    });
+
+    make_data_buffer();
+    KeyValueVector key_value_pairs;
+    for (size_t i(0); i < num_entries; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+      ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+    }
+    // Only values which have been written to disk can be recovered.
+    for (int i(0); i < 100 && data_buffer_->flush_stats().values_flushed < num_entries; ++i)
+      Sleep(std::chrono::milliseconds(10));
+    ASSERT_EQ(num_entries, data_buffer_->flush_stats().values_flushed);
+    ASSERT_NO_THROW(data_buffer_->Delete(key_value_pairs[1].first));
+    data_buffer_.reset();
+
+    if (layout == DataBuffer::DiskLayout::kSegmentedLog) {
+      // Simulate a record torn by a crash at the end of the newest segment.
+      fs::path newest;
+      for (fs::directory_iterator itr(data_buffer_path), end; itr != end; ++itr) {
+        if (newest.empty() || fs::last_write_time(itr->path()) >= fs::last_write_time(newest))
+          newest = itr->path();
+      }
+      std::ofstream segment_out(newest.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+      segment_out << std::string(100, 'x');
+    }
+
+    make_data_buffer();
+    for (size_t i(0); i < num_entries; ++i) {
+      if (i == 1) {
+        EXPECT_THROW(data_buffer_->Get(key_value_pairs[i].first), common_error);
+        continue;
+      }
+      NonEmptyString recovered;
+      ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value_pairs[i].first));
+      EXPECT_EQ(key_value_pairs[i].second, recovered);
+    }
+
+    // The recovered values take up all but one value's worth of disk space, so storing two more
+    // values requires a single value (the oldest) to be popped.
+    for (int i(0); i < 2; ++i) {
+      NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+      ASSERT_NO_THROW(data_buffer_->Store(GenerateKeyFromValue(value), value));
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ASSERT_TRUE(cond_var.wait_for(lock, std::chrono::seconds(2),
+                                    [&] { return !popped.empty(); }));
+      EXPECT_EQ(1U, popped.size());
+      EXPECT_NE(key_value_pairs[1].first, popped.front());
+      if (layout == DataBuffer::DiskLayout::kSegmentedLog)
+        EXPECT_EQ(key_value_pairs[0].first, popped.front());
+    }
+    data_buffer_.reset();
+  }
+}
+
+TEST_F(DataBufferTest, BEH_CompressOnDisk) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  DataBuffer::Options options;
+  options.compress_on_disk = true;
+  options.compression_level = crypto::kMaxCompressionLevel + 1;
+  EXPECT_THROW(DataBuffer(MemoryUsage(1), DiskUsage(1), pop_functor_, *test_path, false, options),
+               common_error);
+  options.compression_level = 1;
+
+  // Without compression, the disk could only hold two of these values.
+  const size_t num_entries(8);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(4 * OneKB), pop_functor_,
+                                    *test_path, false, options));
+  KeyValueVector key_value_pairs;
+  for (size_t i(0); i < num_entries; ++i) {
+    NonEmptyString value(std::vector<byte>(2 * OneKB, static_cast<byte>('a' + i)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+  }
+  // Incompressible, so stored as is.
+  NonEmptyString random_value(RandomBytes(static_cast<std::uint32_t>(2 * OneKB)));
+  key_value_pairs.emplace_back(GenerateKeyFromValue(random_value), random_value);
+  ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, random_value));
+  const auto random_file(maidsafe::detail::GetFileName(key_value_pairs.back().first));
+  EXPECT_EQ(2 * OneKB + 1, fs::file_size(*test_path / random_file));
+
+  for (const auto& key_value : key_value_pairs) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = data_buffer_->Get(key_value.first));
+    EXPECT_EQ(key_value.second, recovered);
+    DataBuffer::ValueView view;
+    ASSERT_NO_THROW(view = data_buffer_->GetView(key_value.first));
+    EXPECT_EQ(key_value.second, NonEmptyString(std::vector<byte>(view.begin(), view.end())));
+  }
+}
+
+TEST_F(DataBufferTest, BEH_Stats) {
+  DataBuffer::LatencyHistogram histogram;
+  EXPECT_EQ(std::chrono::microseconds(0), histogram.Quantile(0.5));
+  histogram.Record(std::chrono::nanoseconds(500));
+  histogram.Record(std::chrono::microseconds(3));
+  histogram.Record(std::chrono::microseconds(100));
+  histogram.Record(std::chrono::hours(1000000));
+  EXPECT_EQ(4U, histogram.count);
+  EXPECT_EQ(1U, histogram.buckets[0]);
+  EXPECT_EQ(1U, histogram.buckets[2]);
+  EXPECT_EQ(1U, histogram.buckets[7]);
+  EXPECT_EQ(1U, histogram.buckets[DataBuffer::LatencyHistogram::kBucketCount - 1]);
+  EXPECT_EQ(std::chrono::microseconds(1), histogram.Quantile(0.0));
+  EXPECT_EQ(std::chrono::microseconds(4), histogram.Quantile(0.5));
+  EXPECT_EQ(std::chrono::microseconds(128), histogram.Quantile(0.75));
+
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  std::atomic<int> pop_count(0);
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(2 * OneKB),
+                                    [&](const KeyType&, const NonEmptyString&) { ++pop_count; },
+                                    *test_path, false));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i < 3; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+  }
+  // Storing the third value on disk pops the first.
+  for (int i(0); i < 100 && pop_count == 0; ++i)
+    Sleep(std::chrono::milliseconds(10));
+  ASSERT_EQ(1, pop_count);
+  EXPECT_THROW(data_buffer_->Get(key_value_pairs[0].first), common_error);
+  EXPECT_NO_THROW(data_buffer_->Get(key_value_pairs[1].first));
+  EXPECT_NO_THROW(data_buffer_->Get(key_value_pairs[2].first));
+
+  const auto stats(data_buffer_->stats());
+  EXPECT_EQ(1U, stats.memory_hits);
+  EXPECT_EQ(1U, stats.disk_hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, stats.HitRate());
+  EXPECT_EQ(2U, stats.memory_wait.count);
+  EXPECT_EQ(1U, stats.disk_wait.count);
+  EXPECT_EQ(1U, stats.pops);
+  EXPECT_EQ(1U, stats.pop_latency.count);
+  EXPECT_EQ(3U, stats.flush.values_flushed);
+  EXPECT_EQ(OneKB, stats.memory_usage);
+  EXPECT_EQ(1U, stats.memory_values);
+  EXPECT_EQ(2 * OneKB, stats.disk_usage);
+  EXPECT_EQ(2U, stats.disk_values);
+}
+
+TEST_F(DataBufferTest, BEH_LookupObserver) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  HotKeyTracker<KeyType> tracker(4);
+  DataBuffer::Options options;
+  options.lookup_observer = tracker.Observer();
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), DiskUsage(8 * OneKB), pop_functor_,
+                                    *test_path, false, options));
+  NonEmptyString hot_value(RandomAlphaNumericBytes(100)), warm_value(RandomAlphaNumericBytes(100));
+  const KeyType hot_key(GenerateKeyFromValue(hot_value));
+  const KeyType warm_key(GenerateKeyFromValue(warm_value));
+  const KeyType missing_key(GenerateRandomKey());
+  ASSERT_NO_THROW(data_buffer_->Store(hot_key, hot_value));
+  ASSERT_NO_THROW(data_buffer_->Store(warm_key, warm_value));
+
+  for (int i(0); i < 3; ++i)
+    EXPECT_EQ(hot_value, data_buffer_->Get(hot_key));
+  EXPECT_NO_THROW(data_buffer_->GetView(hot_key));
+  EXPECT_EQ(warm_value, data_buffer_->AsyncGet(warm_key, asio::use_future).get());
+  EXPECT_TRUE(data_buffer_->TryGet(warm_key));
+  EXPECT_FALSE(data_buffer_->TryGet(missing_key));
+
+  const auto hot_keys(tracker.Snapshot());
+  ASSERT_EQ(3U, hot_keys.size());
+  EXPECT_EQ(hot_key, hot_keys[0].key);
+  EXPECT_EQ(4U, hot_keys[0].count);
+  EXPECT_EQ(warm_key, hot_keys[1].key);
+  EXPECT_EQ(2U, hot_keys[1].count);
+  EXPECT_EQ(missing_key, hot_keys[2].key);
+  EXPECT_EQ(1U, hot_keys[2].count);
+  EXPECT_GE(tracker.Estimate(hot_key), 4U);
+}
+
+TEST_F(DataBufferTest, BEH_PriorityAndPinning) {
+  std::mutex mutex;
+  std::condition_variable cond_var;
+  std::vector<KeyType> popped;
+  PopFunctor pop_functor([&](const KeyType& key, const NonEmptyString&) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      popped.push_back(key);
+    }
+    cond_var.notify_one();
+  });
+  auto wait_for_pops([&](size_t count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cond_var.wait_for(lock, std::chrono::seconds(5),
+                             [&] { return popped.size() == count; });
+  });
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(4 * OneKB), pop_functor,
+                                    *test_path / "data_buffer"));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 7; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+  }
+  const KeyType& pinned(key_value_pairs[0].first);
+  const KeyType& high(key_value_pairs[1].first);
+  const KeyType& low(key_value_pairs[2].first);
+  const KeyType& normal(key_value_pairs[3].first);
+
+  // Policies can be set before the values are stored.
+  data_buffer_->Pin(pinned);
+  data_buffer_->SetPriority(high, DataBuffer::Priority::kHigh);
+  data_buffer_->SetPriority(low, DataBuffer::Priority::kLow);
+  for (size_t i(0); i != 6; ++i)
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs[i].first, key_value_pairs[i].second));
+
+  // The disk store fills with the first four values, then pops the low priority value, then the
+  // oldest of normal priority.
+  ASSERT_TRUE(wait_for_pops(2));
+  EXPECT_EQ(low, popped[0]);
+  EXPECT_EQ(normal, popped[1]);
+  // The pinned value has stayed in memory throughout.
+  const auto memory_hits(data_buffer_->stats().memory_hits);
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(pinned));
+  EXPECT_EQ(memory_hits + 1, data_buffer_->stats().memory_hits);
+  EXPECT_EQ(key_value_pairs[1].second, data_buffer_->Get(high));
+
+  // Once unpinned, it can be evicted and popped like any other value.
+  data_buffer_->Unpin(pinned);
+  data_buffer_->SetPriority(pinned, DataBuffer::Priority::kLow);
+  ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs[6].first, key_value_pairs[6].second));
+  ASSERT_TRUE(wait_for_pops(3));
+  EXPECT_EQ(pinned, popped[2]);
+  EXPECT_THROW(data_buffer_->Get(pinned), common_error);
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_EvictFromMemory) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(4 * OneKB), DiskUsage(8 * OneKB), nullptr,
+                                    *test_path / "data_buffer"));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 4; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+  }
+  data_buffer_->Pin(key_value_pairs[0].first);
+  for (const auto& key_value : key_value_pairs)
+    ASSERT_NO_THROW(data_buffer_->Store(key_value.first, key_value.second));
+  // Values only become evictable once copied to disk, which happens in the background.
+  auto evict_until([&](uint64_t memory_usage) {
+    uint64_t released(0);
+    for (int i(0); i < 100 && data_buffer_->stats().memory_usage > memory_usage; ++i) {
+      released += data_buffer_->EvictFromMemory(data_buffer_->stats().memory_usage - memory_usage);
+      Sleep(std::chrono::milliseconds(10));
+    }
+    return released;
+  });
+
+  // Values are evicted oldest first, skipping the pinned one, and remain readable from disk.
+  EXPECT_EQ(2 * OneKB, evict_until(2 * OneKB));
+  const auto disk_hits(data_buffer_->stats().disk_hits);
+  EXPECT_EQ(key_value_pairs[1].second, data_buffer_->Get(key_value_pairs[1].first));
+  EXPECT_EQ(key_value_pairs[2].second, data_buffer_->Get(key_value_pairs[2].first));
+  EXPECT_EQ(disk_hits + 2, data_buffer_->stats().disk_hits);
+
+  EXPECT_EQ(OneKB, evict_until(OneKB));
+  EXPECT_EQ(OneKB, data_buffer_->stats().memory_usage);
+  EXPECT_EQ(0U, data_buffer_->EvictFromMemory(OneKB));
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(key_value_pairs[0].first));
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_ClockEviction) {
+  DataBuffer::Options options;
+  options.eviction_policy = DataBuffer::EvictionPolicy::kClock;
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(2 * OneKB), DiskUsage(10 * OneKB), pop_functor_,
+                                    *test_path / "data_buffer", false, options));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 5; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(static_cast<std::uint32_t>(OneKB)));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+  }
+  for (size_t i(0); i != 4; ++i)
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs[i].first, key_value_pairs[i].second));
+  for (int i(0); i < 100 && data_buffer_->flush_stats().values_flushed < 4; ++i)
+    Sleep(std::chrono::milliseconds(10));
+  ASSERT_EQ(4U, data_buffer_->flush_stats().values_flushed);
+  // Memory now holds the third and fourth values.  Make space for one more.
+  data_buffer_->Delete(key_value_pairs[3].first);
+
+  // The first value is promoted back into memory on its second read from disk.
+  const KeyType& hot(key_value_pairs[0].first);
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(hot));
+  EXPECT_EQ(0U, data_buffer_->stats().promotions);
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(hot));
+  auto stats(data_buffer_->stats());
+  EXPECT_EQ(1U, stats.promotions);
+  EXPECT_EQ(2U, stats.memory_values);
+  EXPECT_EQ(2U, stats.disk_hits);
+
+  // Reading the third value gives it a second chance, so storing another value evicts the newer,
+  // unread, promoted one instead.
+  EXPECT_EQ(key_value_pairs[2].second, data_buffer_->Get(key_value_pairs[2].first));
+  ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs[4].first, key_value_pairs[4].second));
+  EXPECT_EQ(key_value_pairs[2].second, data_buffer_->Get(key_value_pairs[2].first));
+  stats = data_buffer_->stats();
+  EXPECT_EQ(2U, stats.memory_hits);
+  EXPECT_EQ(2U, stats.disk_hits);
+  EXPECT_EQ(key_value_pairs[0].second, data_buffer_->Get(hot));
+  EXPECT_EQ(3U, data_buffer_->stats().disk_hits);
+
+  // Deleting a promoted value removes both copies.
+  EXPECT_EQ(key_value_pairs[1].second, data_buffer_->Get(key_value_pairs[1].first));
+  data_buffer_->Delete(key_value_pairs[4].first);
+  EXPECT_EQ(key_value_pairs[1].second, data_buffer_->Get(key_value_pairs[1].first));
+  EXPECT_EQ(2U, data_buffer_->stats().promotions);
+  data_buffer_->Delete(key_value_pairs[1].first);
+  EXPECT_THROW(data_buffer_->Get(key_value_pairs[1].first), common_error);
+  data_buffer_.reset();
+}
+
+TEST_F(DataBufferTest, BEH_MultipleDirectories) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
+  std::vector<DataBuffer::DiskDirectory> directories;
+  directories.emplace_back(*test_path / "a", DiskUsage(20 * OneKB));
+  directories.emplace_back(*test_path / "b", DiskUsage(20 * OneKB));
+  directories.emplace_back(*test_path / "c", DiskUsage(40 * OneKB));
+  data_buffer_.reset(new DataBuffer(MemoryUsage(OneKB), directories, pop_functor_));
+  KeyValueVector key_value_pairs;
+  for (int i(0); i != 40; ++i) {
+    NonEmptyString value(RandomAlphaNumericBytes(256));
+    key_value_pairs.emplace_back(GenerateKeyFromValue(value), value);
+    ASSERT_NO_THROW(data_buffer_->Store(key_value_pairs.back().first, value));
+  }
+  for (int i(0); i < 200 && data_buffer_->flush_stats().values_flushed < 40; ++i)
+    Sleep(std::chrono::milliseconds(10));
+  ASSERT_EQ(40U, data_buffer_->flush_stats().values_flushed);
+  EXPECT_EQ(40U * 256, data_buffer_->stats().disk_usage);
+
+  // Each directory holds a share of the values, and all of them can be read back.
+  for (const auto& directory : directories) {
+    uint64_t usage(0);
+    for (fs::directory_iterator itr(directory.path), end; itr != end; ++itr)
+      usage += fs::file_size(itr->path());
+    EXPECT_LT(0U, usage) << directory.path;
+    EXPECT_GE(directory.max_usage.data, usage) << directory.path;
+  }
+  for (const auto& key_value : key_value_pairs)
+    EXPECT_EQ(key_value.second, data_buffer_->Get(key_value.first));
+  data_buffer_.reset();
+
+  EXPECT_THROW(DataBuffer(MemoryUsage(OneKB), std::vector<DataBuffer::DiskDirectory>(),
+                          pop_functor_),
+               common_error);
+  EXPECT_THROW(DataBuffer(MemoryUsage(30 * OneKB), directories, pop_functor_), common_error);
+  DataBuffer::Options options;
+  options.disk_layout = DataBuffer::DiskLayout::kSegmentedLog;
+  EXPECT_THROW(DataBuffer(MemoryUsage(OneKB), directories, pop_functor_, false, options),
+               common_error);
+}
+
 TEST_F(DataBufferTest, BEH_DeleteOnDiskBufferOverfill) {
   const size_t num_entries(4), num_memory_entries(1), num_disk_entries(4);
   maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DataBuffer"));
@@ -0,0 +1,86 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/ecdsa.h"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+
+namespace maidsafe {
+
+namespace ecdsa {
+
+namespace test {
+
+class EcdsaTest : public testing::Test {
+ protected:
+  EcdsaTest() : keys_(GenerateKeyPair()) {}
+  Keys keys_;
+};
+
+TEST_F(EcdsaTest, BEH_SignValidate) {
+  maidsafe::test::RunInParallel(5, [&] {
+    Keys keys(GenerateKeyPair());
+    const PlainText data(RandomBytes(1, 1024 * 1024));
+    const Signature signature(Sign(data, keys.private_key));
+    EXPECT_TRUE(CheckSignature(data, signature, keys.public_key));
+    EXPECT_FALSE(CheckSignature(data, signature, keys_.public_key));
+
+    const PlainText other_data(RandomBytes(1, 1024));
+    EXPECT_FALSE(CheckSignature(other_data, signature, keys.public_key));
+    const Signature bad_signature(RandomBytes(Keys::kSignatureByteSize));
+    EXPECT_FALSE(CheckSignature(data, bad_signature, keys.public_key));
+  });
+}
+
+TEST_F(EcdsaTest, BEH_EncodeKeys) {
+  const EncodedPrivateKey encoded_private_key(EncodeKey(keys_.private_key));
+  const EncodedPublicKey encoded_public_key(EncodeKey(keys_.public_key));
+  const PrivateKey private_key(DecodeKey(encoded_private_key));
+  const PublicKey public_key(DecodeKey(encoded_public_key));
+  EXPECT_TRUE(MatchingKeys(keys_.private_key, private_key));
+  EXPECT_TRUE(MatchingKeys(keys_.public_key, public_key));
+  EXPECT_EQ(encoded_private_key, EncodeKey(private_key));
+  EXPECT_EQ(encoded_public_key, EncodeKey(public_key));
+
+  const PlainText data(RandomBytes(1, 1024));
+  EXPECT_TRUE(CheckSignature(data, Sign(data, private_key), keys_.public_key));
+  EXPECT_TRUE(CheckSignature(data, Sign(data, keys_.private_key), public_key));
+
+  const Keys other_keys(GenerateKeyPair());
+  EXPECT_FALSE(MatchingKeys(keys_.private_key, other_keys.private_key));
+  EXPECT_FALSE(MatchingKeys(keys_.public_key, other_keys.public_key));
+
+  EXPECT_THROW(DecodeKey(EncodedPrivateKey(RandomString(100))), asymm_error);
+  EXPECT_THROW(DecodeKey(EncodedPublicKey(RandomString(100))), asymm_error);
+}
+
+TEST_F(EcdsaTest, BEH_Serialise) {
+  Keys parsed;
+  Parse(Serialise(keys_), parsed);
+  EXPECT_TRUE(MatchingKeys(keys_.private_key, parsed.private_key));
+  EXPECT_TRUE(MatchingKeys(keys_.public_key, parsed.public_key));
+}
+
+}  // namespace test
+
+}  // namespace ecdsa
+
+}  // namespace maidsafe
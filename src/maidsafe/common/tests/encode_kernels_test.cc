@@ -0,0 +1,85 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/encode_kernels.h"
+
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace test {
+
+TEST(EncodeKernelsTest, BEH_KernelsAgree) {
+  const std::vector<EncodeKernels> kernels(SupportedEncodeKernels());
+  ASSERT_FALSE(kernels.empty());
+  EXPECT_STREQ(kernels.back().name, SelectedEncodeKernels().name);
+  const EncodeKernels& reference(kernels.front());
+
+  for (const auto& kernel : kernels) {
+    SCOPED_TRACE(kernel.name);
+    // Cover sizes either side of each kernel's block sizes.
+    for (std::size_t size(0); size != 200; ++size) {
+      const std::vector<byte> original(RandomBytes(size));
+
+      std::string expected(2 * size, 0), encoded(2 * size, 0);
+      reference.hex_encode(original.data(), size, &expected[0]);
+      EXPECT_EQ(&encoded[0] + encoded.size(),
+                kernel.hex_encode(original.data(), size, &encoded[0]));
+      EXPECT_EQ(expected, encoded);
+      std::vector<byte> decoded(size, 0);
+      EXPECT_TRUE(kernel.hex_decode(encoded.data(), encoded.size(), decoded.data()));
+      EXPECT_EQ(original, decoded);
+      if (size != 0) {
+        encoded[RandomUint32() % encoded.size()] = 'g';
+        EXPECT_FALSE(kernel.hex_decode(encoded.data(), encoded.size(), decoded.data()));
+      }
+
+      expected.assign(((size + 2) / 3) * 4, 0);
+      encoded.assign(expected.size(), 0);
+      reference.base64_encode(original.data(), size, &expected[0]);
+      EXPECT_EQ(&encoded[0] + encoded.size(),
+                kernel.base64_encode(original.data(), size, &encoded[0]));
+      EXPECT_EQ(expected, encoded);
+      decoded.assign((encoded.size() / 4) * 3, 0);
+      std::size_t decoded_size(0);
+      EXPECT_TRUE(
+          kernel.base64_decode(encoded.data(), encoded.size(), decoded.data(), decoded_size));
+      decoded.resize(decoded_size);
+      EXPECT_EQ(original, decoded);
+      if (size != 0) {
+        decoded.resize((encoded.size() / 4) * 3);
+        encoded[RandomUint32() % (encoded.size() - 2)] = '-';
+        EXPECT_FALSE(
+            kernel.base64_decode(encoded.data(), encoded.size(), decoded.data(), decoded_size));
+      }
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace detail
+
+}  // namespace maidsafe
@@ -18,6 +18,8 @@
 
 #include "maidsafe/common/encode.h"
 
+#include <algorithm>
+
 #include "maidsafe/common/bounded_string.h"
 #include "maidsafe/common/convert.h"
 #include "maidsafe/common/test.h"
@@ -220,6 +222,97 @@ TYPED_TEST(EncodeTest, BEH_Base64Substr) {
   EXPECT_EQ(14U, base64::Substr(this->ToTestType(RandomString(32, 100))).size());
 }
 
+TEST(EncodeToTest, BEH_Hex) {
+  // Cover sizes either side of the 16-byte blocks encoded by the SIMD path.
+  for (std::size_t size(0); size != 70; ++size) {
+    const std::vector<byte> original(RandomBytes(size));
+    std::string expected;
+    for (byte value : original) {
+      expected += "0123456789abcdef"[value >> 4];
+      expected += "0123456789abcdef"[value & 0x0f];
+    }
+    std::string encoded(hex::EncodedSize(size), 0);
+    EXPECT_EQ(&encoded[0] + encoded.size(),
+              hex::EncodeTo(original.data(), size, &encoded[0]));
+    EXPECT_EQ(expected, encoded);
+    std::vector<byte> decoded(size, 0);
+    EXPECT_TRUE(hex::DecodeTo(encoded.data(), encoded.size(), decoded.data()));
+    EXPECT_EQ(original, decoded);
+  }
+
+  byte decoded[4];
+  EXPECT_TRUE(hex::DecodeTo("0aBcDeF9", 8, decoded));
+  EXPECT_EQ(0x0a, decoded[0]);
+  EXPECT_EQ(0xbc, decoded[1]);
+  EXPECT_EQ(0xde, decoded[2]);
+  EXPECT_EQ(0xf9, decoded[3]);
+  EXPECT_FALSE(hex::DecodeTo("abc", 3, decoded));
+  EXPECT_FALSE(hex::DecodeTo("0g", 2, decoded));
+  EXPECT_FALSE(hex::DecodeTo("\xff" "0", 2, decoded));
+  EXPECT_THROW(hex::DecodeToBytes("0g"), common_error);
+  EXPECT_THROW(hex::DecodeToString("zz"), common_error);
+}
+
+TEST(EncodeToTest, BEH_Base64) {
+  for (std::size_t size(0); size != 20; ++size) {
+    const std::vector<byte> original(RandomBytes(size));
+    std::string encoded(base64::EncodedSize(size), 0);
+    EXPECT_EQ(&encoded[0] + encoded.size(),
+              base64::EncodeTo(original.data(), size, &encoded[0]));
+    EXPECT_EQ(base64::Encode(original), encoded);
+    std::vector<byte> decoded(base64::MaxDecodedSize(encoded.size()), 0);
+    std::size_t decoded_size(0);
+    EXPECT_TRUE(base64::DecodeTo(encoded.data(), encoded.size(), decoded.data(), decoded_size));
+    decoded.resize(decoded_size);
+    EXPECT_EQ(original, decoded);
+  }
+
+  byte decoded[6];
+  std::size_t decoded_size(0);
+  EXPECT_FALSE(base64::DecodeTo("Zm9", 3, decoded, decoded_size));
+  EXPECT_FALSE(base64::DecodeTo("Zm-v", 4, decoded, decoded_size));
+  EXPECT_FALSE(base64::DecodeTo("Z===", 4, decoded, decoded_size));
+  EXPECT_FALSE(base64::DecodeTo("Zg==Zg==", 8, decoded, decoded_size));
+  EXPECT_THROW(base64::DecodeToBytes("Zm-v"), common_error);
+}
+
+TEST(EncodeToTest, BEH_Base64Streaming) {
+  for (std::size_t size(0); size != 100; ++size) {
+    const std::vector<byte> original(RandomBytes(size));
+    const std::string expected(base64::Encode(original));
+
+    // Feed each in randomly-sized chunks, including empty ones.
+    base64::Encoder encoder;
+    std::string encoded;
+    for (std::size_t i(0), chunk(0); i != size; i += chunk) {
+      chunk = std::min<std::size_t>(RandomUint32() % 8, size - i);
+      encoder.Update(original.data() + i, chunk, encoded);
+    }
+    encoder.Finalise(encoded);
+    EXPECT_EQ(expected, encoded);
+
+    base64::Decoder decoder;
+    std::string decoded;
+    for (std::size_t i(0), chunk(0); i != encoded.size(); i += chunk) {
+      chunk = std::min<std::size_t>(RandomUint32() % 10, encoded.size() - i);
+      EXPECT_TRUE(decoder.Update(encoded.data() + i, chunk, decoded));
+    }
+    EXPECT_TRUE(decoder.Finalise());
+    EXPECT_EQ(std::string(original.begin(), original.end()), decoded);
+  }
+
+  base64::Decoder decoder;
+  std::string decoded;
+  EXPECT_TRUE(decoder.Update("Zm9", 3, decoded));
+  EXPECT_FALSE(decoder.Finalise());
+  EXPECT_TRUE(decoder.Update("Zg", 2, decoded));
+  EXPECT_TRUE(decoder.Update("==", 2, decoded));
+  EXPECT_EQ("f", decoded);
+  EXPECT_FALSE(decoder.Update("Zg==", 4, decoded));
+  EXPECT_TRUE(decoder.Finalise());
+  EXPECT_FALSE(decoder.Update("Zm-v", 4, decoded));
+}
+
 }  // namespace test
 
 }  // namespace maidsafe
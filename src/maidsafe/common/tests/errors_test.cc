@@ -18,6 +18,9 @@
 
 #include "maidsafe/common/error.h"
 
+#include <string>
+#include <system_error>
+
 #include "boost/throw_exception.hpp"
 
 #include "maidsafe/common/log.h"
@@ -106,6 +109,20 @@ TEST(ErrorsTest, BEH_ErrorCodesThrownAsBoostExceptions) {
   }
 }
 
+TEST(ErrorsTest, BEH_WhatMatchesSystemError) {
+  const common_error error(MakeError(CommonErrors::no_such_element));
+  const common_error copy(error);
+  EXPECT_EQ(error.code(), copy.code());
+  EXPECT_EQ(std::string(std::system_error(error.code()).what()), std::string(error.what()));
+  EXPECT_EQ(std::string(error.what()), std::string(copy.what()));
+  // The formatted message is kept, so repeated calls return the same string.
+  EXPECT_EQ(error.what(), error.what());
+
+  const common_error with_context(make_error_code(CommonErrors::db_busy), "Context");
+  EXPECT_EQ(std::string(std::system_error(with_context.code(), "Context").what()),
+            std::string(with_context.what()));
+}
+
 TEST(ErrorsTest, BEH_SerialisingAndParsingErrors) {
   common_error hashing_error{MakeError(CommonErrors::hashing_error)};
   SerialisedData serialised{Serialise(hashing_error)};
@@ -0,0 +1,148 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/file_io_service.h"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+std::error_code Wait(std::future<std::error_code> result) { return result.get(); }
+
+std::future<std::error_code> Write(FileIoService& file_io, const fs::path& file_path,
+                                   std::vector<byte> content,
+                                   WriteFileOptions::Durability durability =
+                                       WriteFileOptions::Durability::kNone) {
+  std::shared_ptr<std::promise<std::error_code>> promise{
+      std::make_shared<std::promise<std::error_code>>()};
+  file_io.WriteFile(file_path, std::move(content),
+                    [promise](std::error_code ec) { promise->set_value(ec); }, durability);
+  return promise->get_future();
+}
+
+std::future<std::pair<std::error_code, std::vector<byte>>> Read(FileIoService& file_io,
+                                                                const fs::path& file_path) {
+  using Result = std::pair<std::error_code, std::vector<byte>>;
+  std::shared_ptr<std::promise<Result>> promise{std::make_shared<std::promise<Result>>()};
+  file_io.ReadFile(file_path, [promise](std::error_code ec, std::vector<byte> content) {
+    promise->set_value(std::make_pair(ec, std::move(content)));
+  });
+  return promise->get_future();
+}
+
+std::future<std::error_code> Remove(FileIoService& file_io, const fs::path& file_path) {
+  std::shared_ptr<std::promise<std::error_code>> promise{
+      std::make_shared<std::promise<std::error_code>>()};
+  file_io.RemoveFile(file_path, [promise](std::error_code ec) { promise->set_value(ec); });
+  return promise->get_future();
+}
+
+}  // unnamed namespace
+
+class FileIoServiceTest : public testing::TestWithParam<FileIoService::Backend> {
+ protected:
+  FileIoServiceTest() : asio_service_(2), test_path_(CreateTestPath("MaidSafe_TestFileIo")) {}
+  ~FileIoServiceTest() { asio_service_.Stop(); }
+
+  AsioService asio_service_;
+  TestPath test_path_;
+};
+
+TEST_P(FileIoServiceTest, BEH_WriteReadAndRemove) {
+  EXPECT_THROW(FileIoService(asio_service_, 0, GetParam()), maidsafe_error);
+  // Fewer slots than operations, so some are queued behind others.
+  FileIoService file_io(asio_service_, 4, GetParam());
+#ifndef MAIDSAFE_LINUX
+  EXPECT_EQ(FileIoService::Backend::kThreadPool, file_io.backend());
+#endif
+  if (GetParam() == FileIoService::Backend::kThreadPool) {
+    EXPECT_EQ(FileIoService::Backend::kThreadPool, file_io.backend());
+  }
+
+  const size_t kFileCount(20);
+  std::vector<std::vector<byte>> contents;
+  std::vector<std::future<std::error_code>> writes;
+  for (size_t i(0); i != kFileCount; ++i) {
+    contents.push_back(RandomBytes(i * i * 997));
+    writes.push_back(Write(file_io, *test_path_ / std::to_string(i), contents.back(),
+                           (i % 2) ? WriteFileOptions::Durability::kData
+                                   : WriteFileOptions::Durability::kNone));
+  }
+  for (auto& write : writes)
+    EXPECT_FALSE(Wait(std::move(write)));
+
+  std::vector<std::future<std::pair<std::error_code, std::vector<byte>>>> reads;
+  for (size_t i(0); i != kFileCount; ++i)
+    reads.push_back(Read(file_io, *test_path_ / std::to_string(i)));
+  for (size_t i(0); i != kFileCount; ++i) {
+    const auto result(reads[i].get());
+    EXPECT_FALSE(result.first);
+    EXPECT_EQ(contents[i], result.second);
+  }
+
+  // Overwriting truncates the old contents.
+  const fs::path file_path(*test_path_ / std::to_string(kFileCount - 1));
+  EXPECT_FALSE(Wait(Write(file_io, file_path, RandomBytes(10))));
+  EXPECT_EQ(10U, fs::file_size(file_path));
+
+  EXPECT_FALSE(Wait(Remove(file_io, file_path)));
+  EXPECT_FALSE(fs::exists(file_path));
+  EXPECT_TRUE(!!Wait(Remove(file_io, file_path)));
+  const auto missing(Read(file_io, file_path).get());
+  EXPECT_TRUE(!!missing.first);
+  EXPECT_TRUE(missing.second.empty());
+  EXPECT_TRUE(!!Wait(Write(file_io, *test_path_ / "missing" / "file", RandomBytes(10))));
+}
+
+TEST_P(FileIoServiceTest, BEH_DestructionCompletesOutstandingOperations) {
+  const size_t kFileCount(50);
+  std::vector<std::future<std::error_code>> writes;
+  {
+    FileIoService file_io(asio_service_, 8, GetParam());
+    for (size_t i(0); i != kFileCount; ++i)
+      writes.push_back(Write(file_io, *test_path_ / std::to_string(i), RandomBytes(4096)));
+  }
+  for (auto& write : writes)
+    EXPECT_FALSE(Wait(std::move(write)));
+  for (size_t i(0); i != kFileCount; ++i)
+    EXPECT_EQ(4096U, fs::file_size(*test_path_ / std::to_string(i)));
+}
+
+INSTANTIATE_TEST_CASE_P(Backends, FileIoServiceTest,
+                        testing::Values(FileIoService::Backend::kIoUring,
+                                        FileIoService::Backend::kThreadPool));
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,68 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/gf256_kernels.h"
+
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace test {
+
+TEST(Gf256KernelsTest, BEH_Arithmetic) {
+  EXPECT_EQ(0, Gf256Multiply(0, 0x53));
+  EXPECT_EQ(0x53, Gf256Multiply(1, 0x53));
+  EXPECT_EQ(0x1d, Gf256Multiply(2, 0x80));
+  for (int value(1); value != 256; ++value)
+    EXPECT_EQ(1, Gf256Multiply(static_cast<byte>(value), Gf256Inverse(static_cast<byte>(value))));
+  EXPECT_THROW(Gf256Inverse(0), common_error);
+}
+
+TEST(Gf256KernelsTest, BEH_KernelsAgree) {
+  const std::vector<Gf256Kernels> kernels(SupportedGf256Kernels());
+  ASSERT_FALSE(kernels.empty());
+  EXPECT_STREQ(kernels.back().name, SelectedGf256Kernels().name);
+  const Gf256Kernels& reference(kernels.front());
+
+  for (const auto& kernel : kernels) {
+    SCOPED_TRACE(kernel.name);
+    // Cover sizes either side of each kernel's block sizes.
+    for (std::size_t size(0); size != 100; ++size) {
+      const std::vector<byte> input(RandomBytes(size));
+      const std::vector<byte> original(RandomBytes(size));
+      for (const int coefficient : {0, 1, 2, static_cast<int>(RandomUint32() % 256)}) {
+        std::vector<byte> expected(original), output(original);
+        reference.multiply_add(static_cast<byte>(coefficient), input.data(), size,
+                               expected.data());
+        kernel.multiply_add(static_cast<byte>(coefficient), input.data(), size, output.data());
+        EXPECT_EQ(expected, output);
+      }
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace detail
+
+}  // namespace maidsafe
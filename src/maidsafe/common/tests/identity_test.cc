@@ -22,6 +22,7 @@
 #include <bitset>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "maidsafe/common/encode.h"
@@ -225,6 +226,15 @@ TEST_F(IdentityTest, BEH_CloserToTarget) {
   EXPECT_THROW(CloserToTarget(invalid_id_, id1_, target), common_error);
   EXPECT_THROW(CloserToTarget(id1_, invalid_id_, target), common_error);
   EXPECT_THROW(CloserToTarget(id1_, id2_, invalid_id_), common_error);
+
+  auto result(TryCloserToTarget(id1_, id2_, target));
+  ASSERT_TRUE(result);
+  EXPECT_EQ(CloserToTarget(id1_, id2_, target), *result);
+  result = TryCloserToTarget(invalid_id_, id1_, target);
+  ASSERT_FALSE(result);
+  EXPECT_EQ(make_error_code(CommonErrors::invalid_identity), result.error().code());
+  EXPECT_FALSE(TryCloserToTarget(id1_, invalid_id_, target));
+  EXPECT_FALSE(TryCloserToTarget(id1_, id2_, invalid_id_));
 }
 
 TEST_F(IdentityTest, BEH_CommonLeadingBits) {
@@ -246,6 +256,47 @@ TEST_F(IdentityTest, BEH_CommonLeadingBits) {
   EXPECT_THROW(CommonLeadingBits(id1_, invalid_id_), common_error);
 }
 
+TEST_F(IdentityTest, BEH_EncodeTo) {
+  const Identity id(MakeIdentity());
+  const Identity uninitialised;
+
+  char binary_output[binary::kEncodedIdentitySize];
+  EXPECT_FALSE(binary::EncodeTo(uninitialised, binary_output));
+  ASSERT_TRUE(binary::EncodeTo(id, binary_output));
+  EXPECT_EQ(binary::Encode(id), std::string(binary_output, binary::kEncodedIdentitySize));
+
+  char hex_output[hex::kEncodedIdentitySize];
+  EXPECT_FALSE(hex::EncodeTo(uninitialised, hex_output));
+  ASSERT_TRUE(hex::EncodeTo(id, hex_output));
+  EXPECT_EQ(hex::Encode(id.string()), std::string(hex_output, hex::kEncodedIdentitySize));
+
+  char base64_output[base64::kEncodedIdentitySize];
+  EXPECT_FALSE(base64::EncodeTo(uninitialised, base64_output));
+  ASSERT_TRUE(base64::EncodeTo(id, base64_output));
+  EXPECT_EQ(base64::Encode(id.string()),
+            std::string(base64_output, base64::kEncodedIdentitySize));
+
+  Identity decoded;
+  EXPECT_TRUE(binary::DecodeTo(binary_output, binary::kEncodedIdentitySize, decoded));
+  EXPECT_EQ(id, decoded);
+  decoded = Identity();
+  EXPECT_TRUE(hex::DecodeTo(hex_output, hex::kEncodedIdentitySize, decoded));
+  EXPECT_EQ(id, decoded);
+  decoded = Identity();
+  EXPECT_TRUE(base64::DecodeTo(base64_output, base64::kEncodedIdentitySize, decoded));
+  EXPECT_EQ(id, decoded);
+
+  // Invalid input leaves 'decoded' unchanged.
+  binary_output[0] = '2';
+  hex_output[0] = 'g';
+  base64_output[0] = '-';
+  EXPECT_FALSE(binary::DecodeTo(binary_output, binary::kEncodedIdentitySize, decoded));
+  EXPECT_FALSE(hex::DecodeTo(hex_output, hex::kEncodedIdentitySize, decoded));
+  EXPECT_FALSE(hex::DecodeTo(hex_output + 2, hex::kEncodedIdentitySize - 2, decoded));
+  EXPECT_FALSE(base64::DecodeTo(base64_output, base64::kEncodedIdentitySize, decoded));
+  EXPECT_EQ(id, decoded);
+}
+
 TEST_F(IdentityTest, BEH_Serialisation) {
   // Valid Serialisation
   SerialisedData serialised(Serialise(id1_));
@@ -259,6 +310,81 @@ TEST_F(IdentityTest, BEH_Serialisation) {
 
   serialised.pop_back();
   EXPECT_THROW(Parse<Identity>(serialised), common_error);
+
+  auto try_parsed(TryParse<Identity>(Serialise(id1_)));
+  ASSERT_TRUE(try_parsed);
+  EXPECT_EQ(id1_, *try_parsed);
+  try_parsed = TryParse<Identity>(serialised);
+  ASSERT_FALSE(try_parsed);
+  EXPECT_EQ(make_error_code(CommonErrors::parsing_error), try_parsed.error().code());
+}
+
+TEST_F(IdentityTest, BEH_ClosestIdentities) {
+  const Identity target(MakeIdentity());
+  auto closer([&target](const Identity& lhs, const Identity& rhs) {
+    return CloserToTarget(lhs, rhs, target);
+  });
+  std::vector<Identity> ids;
+  EXPECT_TRUE(ClosestIdentities(std::begin(ids), std::end(ids), target, 4).empty());
+  for (int i(0); i != 100; ++i)
+    ids.push_back(MakeIdentity());
+  ids.push_back(ids.front());
+  ids.push_back(target);
+
+  for (std::size_t count : {std::size_t(0), std::size_t(1), std::size_t(8), ids.size() + 1}) {
+    std::vector<Identity> expected(ids);
+    std::sort(std::begin(expected), std::end(expected), closer);
+    expected.resize(std::min(count, ids.size()));
+    for (bool parallel : {false, true}) {
+      const auto closest(
+          ClosestIdentities(std::begin(ids), std::end(ids), target, count, parallel));
+      ASSERT_EQ(expected.size(), closest.size());
+      for (std::size_t i(0); i != expected.size(); ++i)
+        EXPECT_EQ(expected[i], *closest[i]);
+    }
+  }
+
+  // Large enough to be split across threads, and using a projection onto the ID.
+  std::vector<std::pair<Identity, int>> nodes;
+  for (int i(0); i != 40000; ++i)
+    nodes.emplace_back(MakeIdentity(), i);
+  const std::size_t count(16);
+  std::vector<std::pair<Identity, int>> expected(count);
+  std::partial_sort_copy(std::begin(nodes), std::end(nodes), std::begin(expected),
+                         std::end(expected),
+                         [&](const std::pair<Identity, int>& lhs,
+                             const std::pair<Identity, int>& rhs) {
+                           return closer(lhs.first, rhs.first);
+                         });
+  const auto closest(ClosestIdentities(
+      std::begin(nodes), std::end(nodes), target, count,
+      [](const std::pair<Identity, int>& node) -> const Identity& { return node.first; }, true));
+  ASSERT_EQ(count, closest.size());
+  for (std::size_t i(0); i != count; ++i)
+    EXPECT_EQ(expected[i].second, closest[i]->second);
+
+  ids.push_back(invalid_id_);
+  EXPECT_THROW(ClosestIdentities(std::begin(ids), std::end(ids), target, 4), common_error);
+  EXPECT_THROW(ClosestIdentities(std::begin(ids), std::end(ids), invalid_id_, 4), common_error);
+}
+
+TEST_F(IdentityTest, BEH_InlineStorage) {
+  EXPECT_FALSE(Identity().IsInitialised());
+  EXPECT_THROW(Identity(std::vector<byte>(identity_size - 1, 0)), common_error);
+  EXPECT_THROW(Identity(std::vector<byte>(identity_size + 1, 0)), common_error);
+  EXPECT_THROW(Identity(std::vector<byte>()), common_error);
+
+  // Ordering should match that of the equivalent byte vectors.
+  const std::vector<byte> bytes1(id1_.string().begin(), id1_.string().end());
+  const std::vector<byte> bytes2(id2_.string().begin(), id2_.string().end());
+  EXPECT_EQ(bytes1 < bytes2, id1_ < id2_);
+  EXPECT_EQ(bytes1, id1_.string());
+  EXPECT_EQ(id1_, Identity(bytes1));
+
+  // With the binary archives, the serialised form is just the raw bytes, with no size prefix.
+  EXPECT_EQ(bytes1, Serialise(id1_));
+  EXPECT_EQ(identity_size, SerialisedSize(id1_));
+  EXPECT_EQ(id1_, Parse<Identity>(bytes1));
 }
 
 }  // namespace test
@@ -18,9 +18,13 @@
 
 #include "maidsafe/common/ipc.h"
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef MAIDSAFE_BSD
 extern "C" char** environ;
@@ -36,6 +40,7 @@ extern "C" char** environ;
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/crypto.h"
 #include "maidsafe/common/encode.h"
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/on_scope_exit.h"
 #include "maidsafe/common/process.h"
 #include "maidsafe/common/test.h"
@@ -85,6 +90,41 @@ TEST(IpcTest, BEH_IpcDelete) {
   EXPECT_NO_THROW(RemoveSharedMemory("test"));
 }
 
+TEST(IpcTest, BEH_IpcBinaryAndLargeItems) {
+  const std::string kTestName(RandomString(8));
+  on_scope_exit cleanup([&] { RemoveSharedMemory(kTestName); });
+
+  // Items may contain nulls and be far larger than the old fixed 64kB segment.
+  std::vector<std::string> items;
+  items.push_back(std::string("a\0b\0", 4));
+  items.push_back(std::string());
+  items.push_back(RandomString(1024 * 1024));
+  items.push_back(std::string(300, '\xff'));
+  ASSERT_NO_THROW(CreateSharedMemory(kTestName, items));
+  EXPECT_EQ(items, ReadSharedMemory(kTestName, static_cast<int>(items.size())));
+  EXPECT_THROW(ReadSharedMemory(kTestName, static_cast<int>(items.size()) + 1), maidsafe_error);
+
+  {
+    SharedMemoryView view(kTestName);
+    ASSERT_EQ(items.size(), view.size());
+    for (std::size_t i(0); i < items.size(); ++i)
+      EXPECT_EQ(items[i], view.Item(i).to_string());
+    EXPECT_THROW(view.Item(items.size()), maidsafe_error);
+  }
+
+  // Byte vectors are stored the same way.
+  std::vector<std::vector<byte>> byte_items;
+  byte_items.push_back(RandomBytes(100000));
+  byte_items.push_back(std::vector<byte>(10, 0));
+  ASSERT_NO_THROW(CreateSharedMemory(kTestName, byte_items));
+  SharedMemoryView view(kTestName);
+  ASSERT_EQ(byte_items.size(), view.size());
+  for (std::size_t i(0); i < byte_items.size(); ++i) {
+    const boost::string_ref item(view.Item(i));
+    EXPECT_EQ(byte_items[i], std::vector<byte>(item.begin(), item.end()));
+  }
+}
+
 TEST(IpcTest, FUNC_IpcFunctionsThreaded) {
   const std::string kTestName(RandomString(8));
   // Add scoped cleanup mechanism.
@@ -190,6 +230,112 @@ TEST(IpcTest, FUNC_IpcFunctionsUsingBoostProcess) {
   RemoveSharedMemory(kTestName);
 }
 
+TEST(IpcTest, BEH_ChannelLimits) {
+  const std::string kTestName(RandomString(8));
+  EXPECT_THROW(ChannelSender{kTestName}, maidsafe_error);
+
+  ChannelReceiver receiver(kTestName, 100, ChannelProducers::kSingle);
+  EXPECT_EQ(4096U, receiver.capacity());
+  std::vector<byte> message;
+  EXPECT_FALSE(receiver.TryReceive(message));
+  EXPECT_FALSE(receiver.Receive(message, std::chrono::milliseconds(10)));
+
+  ChannelSender sender(kTestName);
+  EXPECT_THROW(ChannelSender{kTestName}, maidsafe_error);
+  EXPECT_THROW(sender.TrySend(std::vector<byte>(sender.max_message_size() + 1)), maidsafe_error);
+
+  // Fill the channel, then check sending fails until a message has been received.
+  const std::vector<byte> kMessage(RandomBytes(1000));
+  int sent(0);
+  while (sender.TrySend(kMessage))
+    ++sent;
+  EXPECT_EQ(4, sent);
+  EXPECT_FALSE(sender.Send(kMessage, std::chrono::milliseconds(10)));
+  ASSERT_TRUE(receiver.TryReceive(message));
+  EXPECT_EQ(kMessage, message);
+  EXPECT_TRUE(sender.TrySend(kMessage));
+
+  // An empty message is still a message.
+  while (receiver.TryReceive(message)) {
+  }
+  EXPECT_TRUE(sender.TrySend(nullptr, 0));
+  ASSERT_TRUE(receiver.TryReceive(message));
+  EXPECT_TRUE(message.empty());
+}
+
+TEST(IpcTest, BEH_ChannelSingleProducer) {
+  const std::string kTestName(RandomString(8));
+  ChannelReceiver receiver(kTestName, 4096, ChannelProducers::kSingle);
+  const int kMessageCount(2000);
+  std::vector<std::vector<byte>> messages;
+  for (int i(0); i < kMessageCount; ++i)
+    messages.push_back(RandomBytes(RandomUint32() % 700));
+
+  // The sender maps the channel separately, as it would in another process, and wraps around the
+  // buffer many times.
+  std::thread sender_thread([&] {
+    ChannelSender sender(kTestName);
+    for (const auto& message : messages)
+      ASSERT_TRUE(sender.Send(message, std::chrono::seconds(10)));
+  });
+
+  int received(0);
+  std::size_t mismatches(0);
+  while (received < kMessageCount) {
+    const bool result(receiver.Receive(
+        [&](const byte* data, std::size_t size) {
+          if (std::vector<byte>(data, data + size) != messages[received])
+            ++mismatches;
+        },
+        std::chrono::seconds(10)));
+    ASSERT_TRUE(result);
+    ++received;
+  }
+  sender_thread.join();
+  EXPECT_EQ(0U, mismatches);
+}
+
+TEST(IpcTest, FUNC_ChannelMultipleProducers) {
+  const std::string kTestName(RandomString(8));
+  ChannelReceiver receiver(kTestName, 8192, ChannelProducers::kMultiple);
+  const std::uint32_t kProducerCount(4), kMessagesPerProducer(20000);
+
+  // Each message holds its producer's index and sequence number, followed by a length which varies
+  // with the sequence number.
+  std::vector<std::thread> producers;
+  for (std::uint32_t producer(0); producer < kProducerCount; ++producer) {
+    producers.emplace_back([&, producer] {
+      ChannelSender sender(kTestName);
+      for (std::uint32_t sequence(0); sequence < kMessagesPerProducer; ++sequence) {
+        std::vector<byte> message(8 + (sequence % 97), static_cast<byte>(sequence));
+        std::memcpy(&message[0], &producer, 4);
+        std::memcpy(&message[4], &sequence, 4);
+        ASSERT_TRUE(sender.Send(message, std::chrono::seconds(10)));
+      }
+    });
+  }
+
+  std::vector<std::uint32_t> next_sequence(kProducerCount, 0);
+  std::size_t errors(0);
+  std::vector<byte> message;
+  for (std::uint32_t i(0); i < kProducerCount * kMessagesPerProducer; ++i) {
+    ASSERT_TRUE(receiver.Receive(message, std::chrono::seconds(10)));
+    std::uint32_t producer(0), sequence(0);
+    ASSERT_GE(message.size(), 8U);
+    std::memcpy(&producer, &message[0], 4);
+    std::memcpy(&sequence, &message[4], 4);
+    ASSERT_LT(producer, kProducerCount);
+    if (sequence != next_sequence[producer]++ || message.size() != 8 + (sequence % 97) ||
+        (message.size() > 8 && message.back() != static_cast<byte>(sequence))) {
+      ++errors;
+    }
+  }
+  for (auto& producer : producers)
+    producer.join();
+  EXPECT_EQ(0U, errors);
+  EXPECT_FALSE(receiver.TryReceive(message));
+}
+
 }  // namespace test
 
 }  // namespace ipc
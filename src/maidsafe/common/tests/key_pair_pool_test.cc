@@ -0,0 +1,80 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/key_pair_pool.h"
+
+#include <chrono>
+#include <thread>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace rsa {
+
+namespace test {
+
+namespace {
+
+// Waits up to a minute for 'pool' to fill its reserve.
+bool WaitUntilFull(const KeyPairPool& pool) {
+  const auto deadline(std::chrono::steady_clock::now() + std::chrono::minutes(1));
+  while (pool.size() != pool.reserve()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+}  // unnamed namespace
+
+TEST(KeyPairPoolTest, BEH_Construct) {
+  EXPECT_THROW(KeyPairPool(0), maidsafe_error);
+  EXPECT_THROW(KeyPairPool(1, 0), maidsafe_error);
+  KeyPairPool pool(3, 2);
+  EXPECT_EQ(3U, pool.reserve());
+  EXPECT_LE(pool.size(), 3U);
+}
+
+TEST(KeyPairPoolTest, BEH_GetAndRefill) {
+  KeyPairPool pool(2);
+  ASSERT_TRUE(WaitUntilFull(pool));
+
+  const PlainText data(RandomBytes(1, 100));
+  const Keys first(pool.Get());
+  const Keys second(pool.Get());
+  EXPECT_EQ(2U, pool.hit_count());
+  EXPECT_FALSE(MatchingKeys(first.public_key, second.public_key));
+  for (const Keys* keys : {&first, &second})
+    EXPECT_TRUE(CheckSignature(data, Sign(data, keys->private_key), keys->public_key));
+
+  // The pool refills in the background, and Get still works while it's empty.
+  const Keys third(pool.Get());
+  EXPECT_TRUE(CheckSignature(data, Sign(data, third.private_key), third.public_key));
+  EXPECT_EQ(3U, pool.hit_count() + pool.miss_count());
+  EXPECT_TRUE(WaitUntilFull(pool));
+}
+
+}  // namespace test
+
+}  // namespace rsa
+
+}  // namespace maidsafe
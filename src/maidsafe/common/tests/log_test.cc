@@ -0,0 +1,404 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/log.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asio/io_service.hpp"
+#include "asio/ip/tcp.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/make_unique.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+enum class Fruit { kApple = 7 };
+
+std::ostream& operator<<(std::ostream& stream, Fruit fruit) {
+  return stream << "fruit " << static_cast<int>(fruit);
+}
+
+#if USE_LOGGING
+struct Nested {};
+
+// Logs while being formatted by an outer LOG statement.
+std::ostream& operator<<(std::ostream& stream, const Nested&) {
+  LOG(kInfo) << "inner message " << 42;
+  return stream << "nested value";
+}
+#endif
+
+}  // unnamed namespace
+
+// Enables every level of the "common" project's LOG statements (which include those in this file)
+// and redirects its logfile to a test folder, restoring the original logging setup afterwards.
+class LogOutputTest : public testing::Test {
+ protected:
+  LogOutputTest()
+      : logging_(log::Logging::Instance()),
+        test_path_(CreateTestPath("MaidSafe_TestLog")),
+        logfile_path_(*test_path_ / "common.log"),
+        original_filter_(),
+        original_path_(),
+        original_async_(false),
+        original_no_log_to_console_(false),
+        inserted_logfile_(false),
+        reopen_original_(false),
+        original_max_file_size_(0),
+        original_max_rotated_files_(0),
+        original_rotation_enabled_(false),
+        original_rotation_count_(0) {}
+
+  void SetUp() override {
+    WaitForBackgroundThread();
+    original_filter_ = logging_.filter_;
+    original_async_ = logging_.async_;
+    original_no_log_to_console_ = logging_.no_log_to_console_;
+    original_max_file_size_ = logging_.max_file_size_;
+    original_max_rotated_files_ = logging_.max_rotated_files_;
+    original_rotation_enabled_ = logging_.rotation_enabled_;
+    logging_.filter_["common"] = log::kVerbose;
+    logging_.async_ = true;
+    logging_.no_log_to_console_ = true;
+    ++log::detail::CallSite::g_filter_generation;
+    auto& log_file(logging_.project_logfile_streams_["common"]);
+    if (!log_file) {
+      log_file = maidsafe::make_unique<log::Logging::LogFile>();
+      inserted_logfile_ = true;
+    }
+    std::lock_guard<std::mutex> lock(log_file->mutex);
+    reopen_original_ = log_file->stream.is_open();
+    log_file->stream.close();
+    log_file->stream.clear();
+    original_path_ = log_file->path;
+    original_rotation_count_ = log_file->rotation_count;
+    log_file->path = logfile_path_;
+    log_file->rotation_count = 0;
+  }
+
+  void TearDown() override {
+    WaitForBackgroundThread();
+    logging_.max_file_size_ = original_max_file_size_;
+    logging_.max_rotated_files_ = original_max_rotated_files_;
+    logging_.rotation_enabled_ = original_rotation_enabled_;
+    WaitForCompressor();
+    logging_.compressed_logfiles_.erase(logfile_path_);
+    {
+      auto& log_file(logging_.project_logfile_streams_["common"]);
+      std::lock_guard<std::mutex> lock(log_file->mutex);
+      log_file->stream.close();
+      log_file->stream.clear();
+      log_file->path = original_path_;
+      log_file->rotation_count = original_rotation_count_;
+      if (reopen_original_)
+        log_file->stream.open(original_path_.c_str(), std::ios_base::app);
+    }
+    if (inserted_logfile_)
+      logging_.project_logfile_streams_.erase("common");
+    logging_.filter_ = original_filter_;
+    logging_.async_ = original_async_;
+    logging_.no_log_to_console_ = original_no_log_to_console_;
+    ++log::detail::CallSite::g_filter_generation;
+  }
+
+  // Changes the "common" project's filter level, as an 'Initialise' call would.
+  void SetCommonLevel(int level) {
+    logging_.filter_["common"] = level;
+    ++log::detail::CallSite::g_filter_generation;
+  }
+
+  // Rotates logfiles once they reach 'max_file_size' bytes, keeping at most 'max_rotated_files'
+  // compressed ones.
+  void SetRotation(uint64_t max_file_size, unsigned max_rotated_files) {
+    logging_.max_file_size_ = max_file_size;
+    logging_.max_rotated_files_ = max_rotated_files;
+    logging_.rotation_enabled_ = true;
+  }
+
+  // Returns once any rotated logfiles have been compressed.
+  void WaitForCompressor() {
+    if (!logging_.compressor_)
+      return;
+    std::promise<void> done;
+    logging_.compressor_->Send([&done] { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  // A Logging instance separate from the one used by LOG, which the test must destroy.
+  log::Logging* CreateLogging() const { return new log::Logging; }
+  void DestroyLogging(log::Logging* logging) const { delete logging; }
+
+  // Records are only written to project logfiles in text mode.
+  bool TextMode() const { return !logging_.Binary(); }
+
+  // Returns once the background thread has written everything sent to it so far.
+  void WaitForBackgroundThread() {
+    std::promise<void> done;
+    logging_.Send([&done] { done.set_value(); });
+    done.get_future().wait();
+  }
+
+  // Stops the background thread from writing anything until the returned promise is set.
+  std::promise<void> HoldBackgroundThread() {
+    std::promise<void> release;
+    std::shared_future<void> released(release.get_future());
+    logging_.Send([released] { released.wait(); });
+    return release;
+  }
+
+  // Returns the lines of the redirected logfile which contain 'text'.
+  std::vector<std::string> LinesContaining(const std::string& text) const {
+    std::vector<std::string> lines;
+    std::ifstream logfile(logfile_path_.c_str());
+    std::string line;
+    while (std::getline(logfile, line)) {
+      if (line.find(text) != std::string::npos)
+        lines.push_back(line);
+    }
+    return lines;
+  }
+
+  log::Logging& logging_;
+  const TestPath test_path_;
+  const boost::filesystem::path logfile_path_;
+
+ private:
+  log::FilterMap original_filter_;
+  boost::filesystem::path original_path_;
+  bool original_async_, original_no_log_to_console_, inserted_logfile_, reopen_original_;
+  uint64_t original_max_file_size_;
+  unsigned original_max_rotated_files_;
+  bool original_rotation_enabled_;
+  unsigned original_rotation_count_;
+};
+
+TEST(LogTest, BEH_EncodeArguments) {
+  using maidsafe::log::detail::OstreamBinder;
+  const std::string text("text");
+  const char* const c_string("c_string");
+  const uint64_t big(18446744073709551615ULL);
+  std::string encoded;
+  (OstreamBinder<void, void>() << "literal " << text << ' ' << c_string << ' ' << -42 << ' '
+                               << big << ' ' << 1.5 << ' ' << true << ' ' << Fruit::kApple)
+      .Encode(encoded);
+  EXPECT_EQ("literal text c_string -42 18446744073709551615 1.5 1 fruit 7",
+            maidsafe::log::detail::DecodeArguments(encoded));
+
+  encoded.push_back(static_cast<char>(99));
+  EXPECT_THROW(maidsafe::log::detail::DecodeArguments(encoded), maidsafe_error);
+}
+
+TEST(LogTest, BEH_RateLimiter) {
+  maidsafe::log::detail::RateLimiter limiter(2);
+  EXPECT_TRUE(limiter.Admit(5).admitted);
+  EXPECT_TRUE(limiter.Admit(5).admitted);
+  for (int i(0); i != 7; ++i)
+    EXPECT_FALSE(limiter.Admit(5).admitted);
+  // A second read before the current one started counts towards the current one.
+  EXPECT_FALSE(limiter.Admit(4).admitted);
+  auto admission(limiter.Admit(7));
+  EXPECT_TRUE(admission.admitted);
+  EXPECT_EQ(8U, admission.suppressed);
+  admission = limiter.Admit(7);
+  EXPECT_TRUE(admission.admitted);
+  EXPECT_EQ(0U, admission.suppressed);
+  EXPECT_FALSE(limiter.Admit(7).admitted);
+}
+
+TEST(LogTest, BEH_Sampler) {
+  maidsafe::log::detail::Sampler sampler(3);
+  auto admission(sampler.Admit());
+  EXPECT_TRUE(admission.admitted);
+  EXPECT_EQ(0U, admission.suppressed);
+  EXPECT_FALSE(sampler.Admit().admitted);
+  EXPECT_FALSE(sampler.Admit().admitted);
+  admission = sampler.Admit();
+  EXPECT_TRUE(admission.admitted);
+  EXPECT_EQ(2U, admission.suppressed);
+
+  // Suppressed messages' arguments aren't evaluated (at most two of each loop's messages are
+  // written, or none if this project isn't being logged).
+  int evaluated(0);
+  for (int i(0); i != 10; ++i)
+    LOG_EVERY_N(kAlways, 5) << "Sampled " << ++evaluated;
+  for (int i(0); i != 10; ++i)
+    LOG_RATE_LIMITED(kAlways, 1) << "Rate limited " << ++evaluated;
+  EXPECT_GE(4, evaluated);
+}
+
+TEST(LogTest, BEH_DecodeInvalidLog) {
+  std::istringstream input("not a binary log");
+  std::ostringstream output;
+  EXPECT_THROW(maidsafe::log::DecodeBinaryLog(input, output), maidsafe_error);
+}
+
+#if USE_LOGGING
+TEST_F(LogOutputTest, BEH_NestedLog) {
+  if (!TextMode())
+    return;
+  LOG(kInfo) << "outer message " << Nested() << " end";
+  WaitForBackgroundThread();
+  // The nested statement is written first, and neither message is mixed into the other.
+  const auto lines(LinesContaining(" message "));
+  ASSERT_EQ(2U, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("] inner message 42"));
+  EXPECT_NE(std::string::npos, lines[1].find("] outer message nested value end"));
+}
+
+TEST_F(LogOutputTest, BEH_FullThreadBufferDrainsInOrder) {
+  if (!TextMode())
+    return;
+  // While the background thread is held up, this thread's buffer fills and it has to write its
+  // backlog itself.
+  auto release(HoldBackgroundThread());
+  const int kCount(3000);  // Several times the capacity of the per-thread buffer.
+  for (int i(0); i != kCount; ++i)
+    LOG(kInfo) << "overflow " << i;
+  EXPECT_FALSE(LinesContaining("] overflow ").empty());
+  release.set_value();
+  WaitForBackgroundThread();
+
+  const auto lines(LinesContaining("] overflow "));
+  ASSERT_EQ(static_cast<size_t>(kCount), lines.size());
+  for (size_t i(0); i != lines.size(); ++i) {
+    const std::string expected("] overflow " + std::to_string(i));
+    ASSERT_EQ(lines[i].size() - expected.size(), lines[i].rfind(expected)) << lines[i];
+  }
+}
+
+TEST_F(LogOutputTest, BEH_ExitedThreadsRecordsWritten) {
+  if (!TextMode())
+    return;
+  // The thread's records are still buffered when it exits.
+  auto release(HoldBackgroundThread());
+  std::thread([] {
+    for (int i(0); i != 10; ++i)
+      LOG(kInfo) << "exiting thread " << i;
+  }).join();
+  EXPECT_TRUE(LinesContaining("] exiting thread ").empty());
+  release.set_value();
+  WaitForBackgroundThread();
+
+  const auto lines(LinesContaining("] exiting thread "));
+  ASSERT_EQ(10U, lines.size());
+  for (size_t i(0); i != lines.size(); ++i)
+    EXPECT_NE(std::string::npos, lines[i].find("] exiting thread " + std::to_string(i)));
+}
+
+TEST_F(LogOutputTest, BEH_CallSiteFollowsFilter) {
+  // A single call site, so its level is cached after the first call.
+  int evaluated(0);
+  auto log_info([&evaluated] { LOG(kInfo) << "call site " << ++evaluated; });
+  log_info();
+  EXPECT_EQ(1, evaluated);
+
+  // The cached level is re-evaluated once the filter changes, and the arguments of a disabled
+  // statement aren't evaluated.
+  SetCommonLevel(log::kWarning);
+  log_info();
+  EXPECT_EQ(1, evaluated);
+
+  SetCommonLevel(log::kVerbose);
+  log_info();
+  EXPECT_EQ(2, evaluated);
+
+  WaitForBackgroundThread();
+  if (!TextMode())
+    return;
+  const auto lines(LinesContaining("] call site "));
+  ASSERT_EQ(2U, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("] call site 1"));
+  EXPECT_NE(std::string::npos, lines[1].find("] call site 2"));
+}
+#endif
+
+TEST_F(LogOutputTest, BEH_Rotation) {
+  namespace fs = boost::filesystem;
+  const auto rotated([this](int index, bool compressed) {
+    fs::path path(logfile_path_);
+    path += "." + std::to_string(index) + (compressed ? ".gz" : "");
+    return path;
+  });
+  // The '--log_max_file_size' option is in MB, so the limit is set directly here.
+  SetRotation(100, 2);
+  const std::string line(std::string(60, 'x') + '\n');
+  // Every second line takes the logfile past the limit.
+  for (int i(0); i != 10; ++i)
+    logging_.WriteToProjectLogfile("common", line);
+  WaitForCompressor();
+  for (int i(1); i != 6; ++i) {
+    EXPECT_FALSE(fs::exists(rotated(i, false))) << i;
+    EXPECT_EQ(i > 3, fs::exists(rotated(i, true))) << i;
+  }
+  EXPECT_EQ(0U, fs::file_size(logfile_path_));
+
+  // If the logfile can't be renamed, it's appended to rather than truncated.
+  fs::create_directories(rotated(6, false) / "blocker");
+  for (int i(0); i != 3; ++i)
+    logging_.WriteToProjectLogfile("common", line);
+  WaitForCompressor();
+  EXPECT_EQ(3 * line.size(), fs::file_size(logfile_path_));
+  EXPECT_FALSE(fs::exists(rotated(6, true)));
+}
+
+TEST_F(LogOutputTest, BEH_VisualiserServerUnreachable) {
+  // Find a local port with nothing listening on it.
+  uint16_t port(0);
+  {
+    asio::io_service io_service;
+    asio::ip::tcp::acceptor acceptor(
+        io_service, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    port = acceptor.local_endpoint().port();
+  }
+  log::Logging* const logging(CreateLogging());
+  // With no shipper yet, messages past the queue limit are dropped.
+  const uint64_t kMaxQueued(10000), kExtra(10);  // As kVisualiserMaxQueued in log.cc.
+  for (uint64_t i(0); i != kMaxQueued + kExtra; ++i)
+    logging->WriteToVisualiserServer("message " + std::to_string(i));
+  EXPECT_EQ(kExtra, logging->VlogDroppedCount());
+
+  // The queued messages are dropped when they can't be sent.
+  logging->InitialiseVlog("prefix", "session", "127.0.0.1", port, "/");
+  const auto give_up(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+  while (logging->VlogDroppedCount() != kMaxQueued + kExtra &&
+         std::chrono::steady_clock::now() < give_up) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(kMaxQueued + kExtra, logging->VlogDroppedCount());
+  DestroyLogging(logging);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
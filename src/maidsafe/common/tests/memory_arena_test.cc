@@ -0,0 +1,120 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/memory_arena.h"
+
+#include <cstring>
+#include <future>
+#include <set>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(MemoryArenaTest, BEH_AllocateAndReuse) {
+  EXPECT_THROW(MemoryArena(0), common_error);
+  for (const auto page_size : {MemoryArena::PageSize::kDefault,
+                               MemoryArena::PageSize::kTransparentHuge,
+                               MemoryArena::PageSize::kExplicitHuge}) {
+    MemoryArena arena(1024 * 1024, page_size);
+    auto stats(arena.stats());
+    EXPECT_LE(1024U * 1024, stats.capacity);
+    EXPECT_EQ(stats.capacity, stats.available);
+    EXPECT_EQ(0U, stats.in_use);
+
+    void* const first(arena.Allocate(100));
+    void* const second(arena.Allocate(100));
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_TRUE(arena.Owns(first));
+    EXPECT_FALSE(arena.Owns(&stats));
+    EXPECT_EQ(128, static_cast<char*>(second) - static_cast<char*>(first));
+    std::memset(first, 1, 100);
+    stats = arena.stats();
+    EXPECT_EQ(256U, stats.in_use);
+    EXPECT_EQ(2U, stats.allocations);
+
+    // A freed block is reused by its own size class only.
+    arena.Deallocate(first, 100);
+    void* const larger(arena.Allocate(129));
+    EXPECT_NE(first, larger);
+    EXPECT_EQ(first, arena.Allocate(MemoryArena::BlockSize(100)));
+    stats = arena.stats();
+    EXPECT_EQ(512U, stats.in_use);
+    EXPECT_EQ(stats.capacity - 512, stats.available);
+    arena.Deallocate(nullptr, 100);
+
+    EXPECT_EQ(nullptr, arena.Allocate(0));
+    EXPECT_EQ(nullptr, arena.Allocate(stats.capacity + 1));
+    EXPECT_EQ(512U, arena.stats().in_use);
+  }
+}
+
+TEST(MemoryArenaTest, BEH_Exhaustion) {
+  MemoryArena arena(64 * 1024, MemoryArena::PageSize::kDefault);
+  const size_t capacity(arena.stats().capacity);
+  std::vector<void*> blocks;
+  while (void* const block = arena.Allocate(1024))
+    blocks.push_back(block);
+  EXPECT_EQ(capacity / 1024, blocks.size());
+  auto stats(arena.stats());
+  EXPECT_EQ(capacity, stats.in_use);
+  EXPECT_EQ(0U, stats.available);
+  EXPECT_EQ(1U, stats.failed_allocations);
+
+  arena.Deallocate(blocks.back(), 1024);
+  EXPECT_EQ(nullptr, arena.Allocate(64));
+  EXPECT_EQ(blocks.back(), arena.Allocate(1024));
+  for (auto block : blocks)
+    arena.Deallocate(block, 1024);
+  stats = arena.stats();
+  EXPECT_EQ(0U, stats.in_use);
+  EXPECT_EQ(capacity, stats.peak_in_use);
+}
+
+TEST(MemoryArenaTest, BEH_Concurrency) {
+  MemoryArena arena(4 * 1024 * 1024, MemoryArena::PageSize::kDefault);
+  std::vector<std::future<std::vector<void*>>> results;
+  for (int i(0); i != 4; ++i) {
+    results.emplace_back(std::async(std::launch::async, [&arena] {
+      std::vector<void*> blocks;
+      for (int j(0); j != 1000; ++j) {
+        void* const block(arena.Allocate(256));
+        if (j % 2 == 0)
+          arena.Deallocate(block, 256);
+        else
+          blocks.push_back(block);
+      }
+      return blocks;
+    }));
+  }
+  std::set<void*> distinct;
+  for (auto& result : results) {
+    for (auto block : result.get())
+      EXPECT_TRUE(distinct.insert(block).second);
+  }
+  EXPECT_EQ(2000U, distinct.size());
+  EXPECT_EQ(2000U * 256, arena.stats().in_use);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,184 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+#include "maidsafe/common/memory_budget.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+MemoryBudget::Options ManualOptions() {
+  MemoryBudget::Options options;
+  options.poll_interval = std::chrono::steady_clock::duration::zero();
+  return options;
+}
+
+}  // unnamed namespace
+
+TEST(MemoryBudgetTest, BEH_ChargeAndRelease) {
+  MemoryBudget budget(1000, ManualOptions());
+  auto first(budget.Register("first", 0, nullptr));
+  auto second(budget.Register("second", 0, nullptr));
+  EXPECT_EQ(MemoryBudget::Pressure::kNone, budget.pressure());
+
+  first->Charge(400);
+  second->Charge(300);
+  EXPECT_EQ(400U, first->usage());
+  EXPECT_EQ(700U, budget.usage());
+  EXPECT_EQ(MemoryBudget::Pressure::kModerate, budget.pressure());
+  second->Charge(150);
+  EXPECT_EQ(MemoryBudget::Pressure::kHigh, second->pressure());
+  first->Charge(100);
+  EXPECT_EQ(MemoryBudget::Pressure::kCritical, budget.pressure());
+
+  first->Release(500);
+  EXPECT_EQ(0U, first->usage());
+  EXPECT_EQ(450U, budget.usage());
+  EXPECT_EQ(MemoryBudget::Pressure::kNone, budget.pressure());
+
+  // Destroying an account removes its usage.
+  second.reset();
+  EXPECT_EQ(0U, budget.usage());
+  auto stats(budget.stats());
+  ASSERT_EQ(1U, stats.accounts.size());
+  EXPECT_EQ("first", stats.accounts.front().first);
+
+  // An unlimited budget is never under pressure.
+  budget.SetLimit(0);
+  first->Charge(1000000);
+  EXPECT_EQ(MemoryBudget::Pressure::kNone, budget.pressure());
+  first->Release(1000000);
+}
+
+TEST(MemoryBudgetTest, BEH_Rebalance) {
+  MemoryBudget budget(1000, ManualOptions());
+  std::vector<std::string> shrunk;
+  std::shared_ptr<MemoryBudget::Account> cache, buffer, queue;
+  auto shrinker([&](std::shared_ptr<MemoryBudget::Account>& account, const std::string& name) {
+    return [&, name](uint64_t bytes, MemoryBudget::Pressure pressure) -> uint64_t {
+      EXPECT_GE(pressure, MemoryBudget::Pressure::kHigh);
+      shrunk.push_back(name);
+      const uint64_t released(std::min(bytes, account->usage()));
+      account->Release(released);
+      return released;
+    };
+  });
+  buffer = budget.Register("buffer", 2, shrinker(buffer, "buffer"));
+  cache = budget.Register("cache", 1, shrinker(cache, "cache"));
+  queue = budget.Register("queue", 3, nullptr);
+
+  // Nothing is shrunk below kHigh.
+  cache->Charge(300);
+  buffer->Charge(400);
+  queue->Charge(100);
+  EXPECT_EQ(0U, budget.Rebalance());
+  EXPECT_TRUE(shrunk.empty());
+
+  // The lowest priority account is shrunk first, and only as far as the kModerate threshold.
+  buffer->Charge(100);
+  EXPECT_EQ(MemoryBudget::Pressure::kHigh, budget.pressure());
+  EXPECT_EQ(200U, budget.Rebalance());
+  EXPECT_EQ(std::vector<std::string>{"cache"}, shrunk);
+  EXPECT_EQ(100U, cache->usage());
+  EXPECT_EQ(700U, budget.usage());
+
+  // Once an account is empty, the next is asked for the remainder.
+  shrunk.clear();
+  queue->Charge(250);
+  EXPECT_EQ(MemoryBudget::Pressure::kCritical, budget.pressure());
+  EXPECT_EQ(250U, budget.Rebalance());
+  EXPECT_EQ((std::vector<std::string>{"cache", "buffer"}), shrunk);
+  EXPECT_EQ(0U, cache->usage());
+  EXPECT_EQ(350U, buffer->usage());
+  EXPECT_EQ(MemoryBudget::Pressure::kModerate, budget.pressure());
+
+  auto stats(budget.stats());
+  EXPECT_EQ(3U, stats.shrinks);
+  EXPECT_EQ(450U, stats.released);
+  EXPECT_EQ(3U, stats.accounts.size());
+}
+
+TEST(MemoryBudgetTest, BEH_UsageFunctor) {
+  MemoryBudget budget(1000, ManualOptions());
+  uint64_t reported(100);
+  auto polled(budget.Register("polled", 0,
+                              [&](uint64_t bytes, MemoryBudget::Pressure) -> uint64_t {
+                                reported -= bytes;
+                                return bytes;
+                              },
+                              [&] { return reported; }));
+  EXPECT_EQ(100U, polled->usage());
+  EXPECT_EQ(100U, budget.usage());
+
+  // Usage is only updated when polled, and shrinking is reflected by the next poll.
+  reported = 900;
+  EXPECT_EQ(100U, budget.usage());
+  EXPECT_EQ(200U, budget.Rebalance());
+  EXPECT_EQ(700U, reported);
+  EXPECT_EQ(700U, budget.usage());
+  reported = 50;
+  EXPECT_EQ(0U, budget.Rebalance());
+  EXPECT_EQ(50U, budget.usage());
+}
+
+TEST(MemoryBudgetTest, BEH_BackgroundRebalance) {
+  MemoryBudget::Options options;
+  options.poll_interval = std::chrono::seconds(10);
+  MemoryBudget budget(1000, options);
+  std::shared_ptr<MemoryBudget::Account> account;
+  account = budget.Register("account", 0, [&](uint64_t bytes, MemoryBudget::Pressure) {
+    account->Release(bytes);
+    return bytes;
+  });
+
+  // A charge which crosses into kHigh wakes the background thread without waiting for a poll.
+  account->Charge(900);
+  for (int i(0); i < 100 && budget.usage() != 700; ++i)
+    Sleep(std::chrono::milliseconds(10));
+  EXPECT_EQ(700U, budget.usage());
+  EXPECT_EQ(1U, budget.stats().shrinks);
+}
+
+TEST(MemoryBudgetTest, BEH_InvalidOptions) {
+  MemoryBudget::Options options(ManualOptions());
+  options.moderate = 0.0;
+  EXPECT_THROW(MemoryBudget(1000, options), maidsafe_error);
+  options = ManualOptions();
+  options.high = options.moderate;
+  EXPECT_THROW(MemoryBudget(1000, options), maidsafe_error);
+  options = ManualOptions();
+  options.critical = 1.5;
+  EXPECT_THROW(MemoryBudget(1000, options), maidsafe_error);
+  options = ManualOptions();
+  options.poll_interval = -std::chrono::milliseconds(1);
+  EXPECT_THROW(MemoryBudget(1000, options), maidsafe_error);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,157 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/metrics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace metrics {
+
+namespace test {
+
+TEST(MetricsTest, BEH_HistogramBuckets) {
+  // Every bucket's bounds are contiguous with its neighbours', and each value maps to the bucket
+  // whose bounds contain it.
+  EXPECT_EQ(0U, Histogram::BucketLowerBound(0));
+  for (size_t i(0); i + 1 != Histogram::kBucketCount; ++i) {
+    ASSERT_EQ(Histogram::BucketUpperBound(i) + 1, Histogram::BucketLowerBound(i + 1));
+    ASSERT_EQ(i, Histogram::BucketIndex(Histogram::BucketLowerBound(i)));
+    ASSERT_EQ(i, Histogram::BucketIndex(Histogram::BucketUpperBound(i)));
+  }
+  EXPECT_EQ(Histogram::kBucketCount - 1,
+            Histogram::BucketIndex(std::numeric_limits<uint64_t>::max()));
+  // Bucket widths are within 12.5% of their lower bounds.
+  for (size_t i(Histogram::kSubBucketCount); i != Histogram::kBucketCount; ++i) {
+    const uint64_t lower(Histogram::BucketLowerBound(i));
+    EXPECT_LE(Histogram::BucketUpperBound(i) - lower, lower / 8);
+  }
+}
+
+TEST(MetricsTest, BEH_HistogramSnapshot) {
+  Histogram histogram;
+  for (uint64_t value(1); value <= 1000; ++value)
+    histogram.Record(value);
+  const HistogramSnapshot snapshot(histogram.Snapshot());
+  EXPECT_EQ(1000U, snapshot.count);
+  EXPECT_EQ(500500U, snapshot.sum);
+  EXPECT_EQ(1000U, snapshot.max);
+  EXPECT_DOUBLE_EQ(500.5, snapshot.Mean());
+  // Quantiles are bucket upper bounds, so are close to (and not below) the exact values.
+  EXPECT_GE(snapshot.Quantile(0.5), 500U);
+  EXPECT_LE(snapshot.Quantile(0.5), 500U + 500U / 8);
+  EXPECT_GE(snapshot.Quantile(0.99), 990U);
+  EXPECT_EQ(1000U, snapshot.Quantile(1.0));
+  EXPECT_EQ(0U, HistogramSnapshot().Quantile(0.5));
+}
+
+TEST(MetricsTest, BEH_ParallelUpdates) {
+  Registry registry;
+  Counter& counter(registry.GetCounter("operations_total", "Operations."));
+  Gauge& gauge(registry.GetGauge("in_flight", "Operations in flight."));
+  Histogram& histogram(registry.GetHistogram("size_bytes", "Sizes."));
+  const int kThreadCount(8), kIterations(10000);
+  maidsafe::test::RunInParallel(kThreadCount - 1, [&] {
+    for (int i(0); i != kIterations; ++i) {
+      counter.Increment();
+      gauge.Add(1);
+      histogram.Record(static_cast<uint64_t>(i));
+      gauge.Add(-1);
+    }
+  });
+  EXPECT_EQ(static_cast<uint64_t>(kThreadCount * kIterations), counter.Value());
+  EXPECT_EQ(0, gauge.Value());
+  EXPECT_EQ(static_cast<uint64_t>(kThreadCount * kIterations), histogram.Snapshot().count);
+}
+
+TEST(MetricsTest, BEH_Registration) {
+  Registry registry;
+  Counter& counter(registry.GetCounter("requests_total", "Requests.", {{"type", "get"}}));
+  EXPECT_EQ(&counter, &registry.GetCounter("requests_total", "Requests.", {{"type", "get"}}));
+  EXPECT_NE(&counter, &registry.GetCounter("requests_total", "Requests.", {{"type", "put"}}));
+  EXPECT_THROW(registry.GetGauge("requests_total", "Requests."), maidsafe_error);
+  EXPECT_THROW(registry.GetCounter("1requests", ""), maidsafe_error);
+  EXPECT_THROW(registry.GetCounter("requests-total", ""), maidsafe_error);
+  EXPECT_THROW(registry.GetCounter("requests", "", {{"bad:label", "x"}}), maidsafe_error);
+  EXPECT_THROW(registry.GetCounter("requests", "", {{"__reserved", "x"}}), maidsafe_error);
+  EXPECT_THROW(registry.GetHistogram("latency", "", {{"le", "1"}}), maidsafe_error);
+  EXPECT_NO_THROW(registry.GetGauge("subsystem:usage", ""));
+  EXPECT_EQ(&Registry::Global(), &Registry::Global());
+}
+
+TEST(MetricsTest, BEH_Exporters) {
+  Registry registry;
+  registry.GetCounter("requests_total", "Requests by type.", {{"type", "put"}}).Increment(2);
+  registry.GetCounter("requests_total", "Requests by type.", {{"type", "get"}}).Increment(3);
+  registry.GetGauge("usage_bytes", "Usage with a \\ and\na newline.", {{"path", "a\"b"}}).Set(-4);
+  Histogram& histogram(registry.GetHistogram("latency_us", "Latency."));
+  histogram.Record(1);
+  histogram.Record(1);
+  histogram.Record(100);
+
+  const Snapshot snapshot(registry.TakeSnapshot());
+  ASSERT_EQ(4U, snapshot.size());
+  EXPECT_EQ("latency_us", snapshot[0].name);
+  EXPECT_EQ("get", snapshot[1].labels.front().second);
+  EXPECT_EQ("put", snapshot[2].labels.front().second);
+
+  const std::string expected(
+      "# HELP latency_us Latency.\n"
+      "# TYPE latency_us histogram\n"
+      "latency_us_bucket{le=\"1\"} 2\n"
+      "latency_us_bucket{le=\"103\"} 3\n"
+      "latency_us_bucket{le=\"+Inf\"} 3\n"
+      "latency_us_sum 102\n"
+      "latency_us_count 3\n"
+      "# HELP requests_total Requests by type.\n"
+      "# TYPE requests_total counter\n"
+      "requests_total{type=\"get\"} 3\n"
+      "requests_total{type=\"put\"} 2\n"
+      "# HELP usage_bytes Usage with a \\\\ and\\na newline.\n"
+      "# TYPE usage_bytes gauge\n"
+      "usage_bytes{path=\"a\\\"b\"} -4\n");
+  EXPECT_EQ(expected, ToPrometheusText(snapshot));
+
+  const std::string text(ToText(snapshot));
+  EXPECT_NE(std::string::npos,
+            text.find("latency_us count=3 mean=34 p50=1 p90=100 p99=100 max=100")) << text;
+  EXPECT_NE(std::string::npos, text.find("requests_total{type=\"get\"} 3")) << text;
+}
+
+TEST(MetricsTest, BEH_LogExporter) {
+  Registry registry;
+  registry.GetCounter("exported_total", "").Increment();
+  EXPECT_THROW(static_cast<void>(LogExporter(registry, std::chrono::milliseconds(0))),
+               maidsafe_error);
+  LogExporter exporter(registry, std::chrono::milliseconds(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+}  // namespace test
+
+}  // namespace metrics
+
+}  // namespace maidsafe
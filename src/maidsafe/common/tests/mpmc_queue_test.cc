@@ -0,0 +1,119 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/mpmc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(MpmcQueueTest, BEH_Construct) {
+  EXPECT_THROW(MpmcQueue<int>(0), maidsafe_error);
+  MpmcQueue<int> queue(5);
+  EXPECT_EQ(8U, queue.Capacity());
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(0U, queue.Size());
+}
+
+TEST(MpmcQueueTest, BEH_PushAndPop) {
+  MpmcQueue<std::unique_ptr<int>> queue(4);
+  std::unique_ptr<int> element;
+  EXPECT_FALSE(queue.TryPop(element));
+
+  for (int i(0); i != 4; ++i) {
+    element.reset(new int(i));
+    EXPECT_TRUE(queue.TryPush(element));
+    EXPECT_FALSE(element);
+  }
+  EXPECT_EQ(4U, queue.Size());
+  element.reset(new int(4));
+  EXPECT_FALSE(queue.TryPush(element));
+  ASSERT_TRUE(element);
+  EXPECT_EQ(4, *element);
+
+  for (int i(0); i != 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(element));
+    EXPECT_EQ(i, *element);
+  }
+  EXPECT_TRUE(queue.Empty());
+
+  // Wrap around the ring, leaving elements queued for the destructor to release.
+  for (int i(0); i != 3; ++i)
+    queue.Push(std::unique_ptr<int>(new int(i)));
+}
+
+TEST(MpmcQueueTest, BEH_Batches) {
+  MpmcQueue<int> queue(8);
+  std::vector<int> input(10);
+  std::iota(std::begin(input), std::end(input), 0);
+  EXPECT_EQ(8U, queue.PushN(std::begin(input), std::end(input)));
+  EXPECT_EQ(0U, queue.PushN(std::begin(input) + 8, std::end(input)));
+
+  std::vector<int> output;
+  EXPECT_EQ(5U, queue.TryPopN(std::back_inserter(output), 5));
+  EXPECT_EQ(2U, queue.PushN(std::begin(input) + 8, std::end(input)));
+  EXPECT_EQ(5U, queue.TryPopN(std::back_inserter(output), 100));
+  EXPECT_EQ(input, output);
+  EXPECT_EQ(0U, queue.TryPopN(std::back_inserter(output), 100));
+}
+
+TEST(MpmcQueueTest, BEH_ProducersAndConsumers) {
+  const int kThreadCount(4), kElementsPerThread(20000);
+  MpmcQueue<int> queue(64);
+  std::atomic<int64_t> total(0);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&] {
+      for (int j(0); j != kElementsPerThread; ++j) {
+        if (j % 2 == 0) {
+          queue.Push(j);
+        } else {
+          std::vector<int> batch(1, j);
+          while (queue.PushN(std::begin(batch), std::end(batch)) == 0)
+            std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      int element(0);
+      for (int j(0); j != kElementsPerThread; ++j) {
+        queue.WaitAndPop(element);
+        total += element;
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_TRUE(queue.Empty());
+  const int64_t expected(static_cast<int64_t>(kElementsPerThread - 1) * kElementsPerThread / 2);
+  EXPECT_EQ(expected * kThreadCount, total);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,76 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/numa.h"
+
+#include <algorithm>
+#include <future>
+#include <set>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace numa {
+
+namespace test {
+
+TEST(NumaTest, BEH_Topology) {
+  const std::vector<Node>& nodes(Topology());
+  ASSERT_FALSE(nodes.empty());
+  EXPECT_EQ(nodes.size(), NodeCount());
+  std::set<unsigned> ids, cpus;
+  for (const auto& node : nodes) {
+    EXPECT_TRUE(ids.insert(node.id).second);
+    EXPECT_FALSE(node.cpus.empty());
+    EXPECT_TRUE(std::is_sorted(std::begin(node.cpus), std::end(node.cpus)));
+    for (const auto cpu : node.cpus) {
+      EXPECT_TRUE(cpus.insert(cpu).second) << "CPU " << cpu << " is in more than one node.";
+      EXPECT_EQ(node.id, NodeOfCpu(cpu));
+    }
+  }
+  EXPECT_TRUE(std::is_sorted(std::begin(ids), std::end(ids)));
+
+  const std::vector<unsigned> by_node(CpusByNode());
+  EXPECT_EQ(cpus.size(), by_node.size());
+  EXPECT_EQ(nodes.front().cpus.front(), by_node.front());
+  EXPECT_EQ(1U, ids.count(CurrentNode()));
+}
+
+TEST(NumaTest, BEH_BindThread) {
+  EXPECT_FALSE(BindCurrentThreadToNode(kAnyNode));
+  // Bind a separate thread, so as not to restrict the test's own.
+  for (const auto& node : Topology()) {
+    const unsigned id(node.id);
+    auto bound(std::async(std::launch::async, [id] {
+      return BindCurrentThreadToNode(id) ? CurrentNode() : kAnyNode;
+    }));
+#if defined(__linux__) || defined(MAIDSAFE_WIN32)
+    EXPECT_EQ(id, bound.get());
+#else
+    bound.get();
+#endif
+  }
+}
+
+}  // namespace test
+
+}  // namespace numa
+
+}  // namespace maidsafe
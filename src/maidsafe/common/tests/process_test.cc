@@ -0,0 +1,93 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/process.h"
+
+#include <chrono>
+#include <future>
+#include <system_error>
+
+#ifndef MAIDSAFE_WIN32
+#include <sys/wait.h>
+#endif
+
+#include "asio/error.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace process {
+
+namespace test {
+
+TEST(ProcessTest, BEH_ExitWatcherCancel) {
+  AsioService asio_service(1);
+  std::promise<std::error_code> exited;
+#ifdef MAIDSAFE_WIN32
+  const ProcessInfo this_process(OpenProcess(SYNCHRONIZE | PROCESS_QUERY_INFORMATION, FALSE,
+                                             static_cast<DWORD>(GetProcessId())));
+#else
+  const ProcessInfo this_process(static_cast<ProcessInfo>(GetProcessId()));
+#endif
+  {
+    ExitWatcher watcher(asio_service.service(), this_process,
+                        [&](std::error_code ec) { exited.set_value(ec); });
+    auto result(exited.get_future());
+    EXPECT_EQ(std::future_status::timeout, result.wait_for(std::chrono::milliseconds(50)));
+    watcher.Cancel();
+    EXPECT_EQ(make_error_code(asio::error::operation_aborted), result.get());
+  }
+  asio_service.Stop();
+}
+
+#ifndef MAIDSAFE_WIN32
+TEST(ProcessTest, BEH_ExitWatcher) {
+  AsioService asio_service(1);
+  const pid_t child(fork());
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    usleep(200000);
+    _exit(0);
+  }
+
+  std::promise<std::error_code> exited;
+  ExitWatcher watcher(asio_service.service(), child,
+                      [&](std::error_code ec) { exited.set_value(ec); });
+  auto result(exited.get_future());
+  EXPECT_EQ(std::future_status::timeout, result.wait_for(std::chrono::milliseconds(50)));
+  ASSERT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(10)));
+  EXPECT_FALSE(result.get());
+  int status(0);
+  EXPECT_EQ(child, waitpid(child, &status, 0));
+
+  // A process which has already exited is reported straight away.
+  std::promise<std::error_code> already_exited;
+  ExitWatcher late_watcher(asio_service.service(), child,
+                           [&](std::error_code ec) { already_exited.set_value(ec); });
+  EXPECT_FALSE(already_exited.get_future().get());
+  asio_service.Stop();
+}
+#endif
+
+}  // namespace test
+
+}  // namespace process
+
+}  // namespace maidsafe
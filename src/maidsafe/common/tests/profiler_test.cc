@@ -0,0 +1,249 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace profile {
+
+namespace test {
+
+namespace {
+
+const CallSite kOuter(__FILE__, __LINE__, "Outer");
+const CallSite kInner(__FILE__, __LINE__, "Inner");
+const CallSite kTraced(__FILE__, __LINE__, "Traced");
+const CallSite kTracedChild(__FILE__, __LINE__, "TracedChild");
+const CallSite kCounted(__FILE__, __LINE__, "Counted");
+const CallSite kAllocating(__FILE__, __LINE__, "Allocating");
+
+const CallTreeNode* FindChild(const CallTreeNode& node, const CallSite& call_site) {
+  auto itr(std::find_if(std::begin(node.children), std::end(node.children),
+                        [&](const CallTreeNode& child) { return child.call_site == &call_site; }));
+  return itr == std::end(node.children) ? nullptr : &*itr;
+}
+
+uint64_t Spin(int iterations) {
+  volatile uint64_t sum(0);
+  for (int i(0); i != iterations; ++i)
+    sum += i;
+  return sum;
+}
+
+}  // unnamed namespace
+
+TEST(ProfilerTest, BEH_CallTree) {
+  const unsigned kThreadCount(4), kIterations(100);
+  std::vector<std::thread> threads;
+  for (unsigned i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&] {
+      for (unsigned j(0); j != kIterations; ++j) {
+        ProfileEntry outer(kOuter);
+        {
+          ProfileEntry inner(kInner);
+          std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+        ProfileEntry inner_again(kInner);
+      }
+      // Unattributed to any parent.
+      ProfileEntry inner(kInner);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  const CallTreeNode call_tree(Profiler::Instance().CallTree());
+  const CallTreeNode* const outer(FindChild(call_tree, kOuter));
+  ASSERT_NE(nullptr, outer);
+  EXPECT_EQ(kThreadCount * kIterations, outer->stats.histogram.count);
+  const CallTreeNode* const inner_in_outer(FindChild(*outer, kInner));
+  ASSERT_NE(nullptr, inner_in_outer);
+  EXPECT_EQ(2 * kThreadCount * kIterations, inner_in_outer->stats.histogram.count);
+  EXPECT_TRUE(inner_in_outer->children.empty());
+  const CallTreeNode* const inner_at_root(FindChild(call_tree, kInner));
+  ASSERT_NE(nullptr, inner_at_root);
+  EXPECT_EQ(kThreadCount, inner_at_root->stats.histogram.count);
+
+  EXPECT_LE(outer->stats.min, outer->stats.histogram.max);
+  EXPECT_GE(outer->stats.min, inner_in_outer->stats.min);
+  EXPECT_GE(outer->stats.histogram.total, inner_in_outer->stats.histogram.total);
+  EXPECT_GE(outer->stats.histogram.Quantile(0.99), outer->stats.histogram.Quantile(0.5));
+
+  const auto totals(Profiler::Instance().Totals());
+  ASSERT_EQ(1U, totals.count(&kInner));
+  EXPECT_EQ(kThreadCount * (2 * kIterations + 1), totals.at(&kInner).histogram.count);
+  EXPECT_NE(std::string::npos, Profiler::Instance().Report().find("Inner"));
+}
+
+TEST(ProfilerTest, BEH_ChromeTraceAndFoldedStacks) {
+  auto count_events([](const std::string& trace, const std::string& name) {
+    size_t count(0);
+    for (auto position(trace.find(name + "\""));
+         position != std::string::npos; position = trace.find(name + "\"", position + 1)) {
+      ++count;
+    }
+    return count;
+  });
+  EXPECT_THROW(Profiler::Instance().StartRecording(0), common_error);
+
+  Profiler::Instance().StartRecording();
+  EXPECT_TRUE(Profiler::Instance().Recording());
+  for (int i(0); i != 10; ++i) {
+    ProfileEntry traced(kTraced);
+    ProfileEntry traced_child(kTracedChild);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::ostringstream trace;
+  Profiler::Instance().WriteChromeTrace(trace, true);
+  EXPECT_EQ(0U, trace.str().find("{\"traceEvents\":["));
+  EXPECT_EQ(10U, count_events(trace.str(), "] Traced"));
+  EXPECT_EQ(10U, count_events(trace.str(), "] TracedChild"));
+  EXPECT_NE(std::string::npos, trace.str().find("\"ph\":\"X\""));
+
+  // Cleared by the previous call.
+  trace.str("");
+  Profiler::Instance().WriteChromeTrace(trace);
+  EXPECT_EQ(0U, count_events(trace.str(), "] Traced"));
+
+  Profiler::Instance().StartRecording(5);
+  for (int i(0); i != 10; ++i)
+    ProfileEntry traced(kTraced);
+  Profiler::Instance().StopRecording();
+  EXPECT_FALSE(Profiler::Instance().Recording());
+  for (int i(0); i != 10; ++i)
+    ProfileEntry traced(kTraced);
+  trace.str("");
+  Profiler::Instance().WriteChromeTrace(trace, true);
+  EXPECT_EQ(2U, count_events(trace.str(), "] Traced"));
+
+  std::ostringstream folded;
+  Profiler::Instance().WriteFoldedStacks(folded);
+  EXPECT_NE(std::string::npos, folded.str().find("] Traced;"));
+  EXPECT_NE(std::string::npos, folded.str().find("] TracedChild "));
+}
+
+TEST(ProfilerTest, BEH_HardwareCounters) {
+  if (!Profiler::Instance().EnableHardwareCounters(true)) {
+    LOG(kWarning) << "Hardware counters unavailable.";
+    EXPECT_FALSE(Profiler::Instance().HardwareCountersEnabled());
+    return;
+  }
+  EXPECT_TRUE(Profiler::Instance().HardwareCountersEnabled());
+  volatile uint64_t sum(0);
+  for (int i(0); i != 10; ++i) {
+    ProfileEntry counted(kCounted);
+    for (int j(0); j != 10000; ++j)
+      sum += j;
+  }
+  EXPECT_TRUE(Profiler::Instance().EnableHardwareCounters(false));
+  {
+    ProfileEntry uncounted(kCounted);
+  }
+
+  const auto totals(Profiler::Instance().Totals());
+  ASSERT_EQ(1U, totals.count(&kCounted));
+  const ProfileStats& stats(totals.at(&kCounted));
+  EXPECT_EQ(11U, stats.histogram.count);
+  EXPECT_EQ(10U, stats.counted_calls);
+  EXPECT_GT(stats.counters.instructions, 10U * 10000U);
+  EXPECT_GT(stats.counters.cycles, 0U);
+  EXPECT_NE(std::string::npos, Profiler::Instance().Report().find("Instructions per cycle"));
+}
+
+TEST(ProfilerTest, BEH_AllocationTracking) {
+  if (!Profiler::Instance().EnableAllocationTracking(true)) {
+    LOG(kWarning) << "Allocation tracking unavailable.";
+    EXPECT_FALSE(Profiler::Instance().AllocationTrackingEnabled());
+    return;
+  }
+  EXPECT_TRUE(Profiler::Instance().AllocationTrackingEnabled());
+  for (int i(0); i != 10; ++i) {
+    ProfileEntry allocating(kAllocating);
+    std::unique_ptr<std::vector<char>> allocation(new std::vector<char>(1000));
+  }
+  EXPECT_TRUE(Profiler::Instance().EnableAllocationTracking(false));
+  {
+    ProfileEntry untracked(kAllocating);
+    std::unique_ptr<int> allocation(new int(0));
+  }
+
+  const auto totals(Profiler::Instance().Totals());
+  ASSERT_EQ(1U, totals.count(&kAllocating));
+  const ProfileStats& stats(totals.at(&kAllocating));
+  EXPECT_EQ(11U, stats.histogram.count);
+  EXPECT_EQ(10U, stats.tracked_calls);
+  EXPECT_EQ(20U, stats.allocations);
+  EXPECT_EQ(10U * (sizeof(std::vector<char>) + 1000U), stats.allocated_bytes);
+  EXPECT_NE(std::string::npos, Profiler::Instance().Report().find("Allocations per call"));
+}
+
+TEST(ProfilerTest, BEH_Sampling) {
+  EXPECT_THROW(Profiler::Instance().StartSampling(0), common_error);
+  EXPECT_THROW(Profiler::Instance().StartSampling(1001), common_error);
+  SampledThread sampled_thread;
+  if (!Profiler::Instance().StartSampling(1000)) {
+    LOG(kWarning) << "Sampling unavailable.";
+    EXPECT_FALSE(Profiler::Instance().Sampling());
+    return;
+  }
+  EXPECT_TRUE(Profiler::Instance().Sampling());
+  // Threads registered after sampling starts are sampled too.
+  std::thread other_thread([] {
+    SampledThread other_sampled_thread;
+    Spin(50000000);
+  });
+  const auto start(std::chrono::steady_clock::now());
+  while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300))
+    Spin(100000);
+  other_thread.join();
+  Profiler::Instance().StopSampling();
+  EXPECT_FALSE(Profiler::Instance().Sampling());
+
+  const auto stacks(Profiler::Instance().SampledStacks());
+  uint64_t samples(0);
+  for (const auto& stack : stacks) {
+    EXPECT_FALSE(stack.first.empty());
+    samples += stack.second;
+  }
+  EXPECT_GT(samples, 0U);
+
+  std::ostringstream folded;
+  Profiler::Instance().WriteSampledStacks(folded, true);
+  const std::string lines(folded.str());
+  EXPECT_EQ(stacks.size(),
+            static_cast<size_t>(std::count(std::begin(lines), std::end(lines), '\n')));
+  EXPECT_TRUE(Profiler::Instance().SampledStacks().empty());
+}
+
+}  // namespace test
+
+}  // namespace profile
+
+}  // namespace maidsafe
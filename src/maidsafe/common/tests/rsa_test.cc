@@ -18,6 +18,13 @@
 
 #include "maidsafe/common/rsa.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "boost/filesystem/path.hpp"
 
 #include "maidsafe/common/error.h"
@@ -56,6 +63,83 @@ TEST_F(RsaTest, BEH_EncryptDecrypt) {
   });
 }
 
+TEST_F(RsaTest, FUNC_EncryptScalesWithThreads) {
+  const unsigned thread_count(std::min(4U, std::thread::hardware_concurrency()));
+  if (thread_count < 2) {
+    LOG(kWarning) << "Skipping test as it needs at least 2 cores.";
+    return;
+  }
+  const int encrypts_per_thread(200);
+  const PlainText data(RandomBytes(32));
+  auto elapsed([&](unsigned threads) {
+    const auto start(std::chrono::steady_clock::now());
+    std::vector<std::future<void>> futures;
+    for (unsigned i(0); i != threads; ++i) {
+      futures.push_back(std::async(std::launch::async, [&] {
+        for (int j(0); j != encrypts_per_thread; ++j)
+          Encrypt(data, keys_.public_key);
+      }));
+    }
+    for (auto& future : futures)
+      future.get();
+    return std::chrono::steady_clock::now() - start;
+  });
+
+  // With no shared lock, running the same per-thread workload on 'thread_count' threads should
+  // take little longer than running it on one, whereas serialised encryption would take
+  // 'thread_count' times as long.  Allow generous slack for busy test machines.
+  const auto single(elapsed(1));
+  const auto parallel(elapsed(thread_count));
+  EXPECT_LT(parallel, single * 2)
+      << "1 thread: " << std::chrono::duration_cast<std::chrono::milliseconds>(single).count()
+      << "ms, " << thread_count << " threads: "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(parallel).count() << "ms";
+}
+
+TEST_F(RsaTest, BEH_SessionEncryptDecrypt) {
+  SessionEncryptor::Options options;
+  options.max_messages_per_key = 3;
+  SessionEncryptor encryptor(options);
+  std::vector<PlainText> messages;
+  std::vector<CipherText> encrypted;
+  for (int i(0); i != 5; ++i) {
+    messages.emplace_back(RandomBytes(1, 1024));
+    encrypted.push_back(encryptor.Encrypt(messages.back(), keys_.public_key));
+  }
+
+  // Messages can be decrypted in any order, and only the first three share a session key.
+  SessionDecryptor decryptor(keys_.private_key);
+  for (int i(4); i >= 0; --i)
+    EXPECT_EQ(messages[i], decryptor.Decrypt(encrypted[i]));
+  auto session_key([](const CipherText& data) {
+    std::string encrypted_key, nonce, ciphertext;
+    Parse(data.string(), encrypted_key, nonce, ciphertext);
+    return encrypted_key;
+  });
+  EXPECT_EQ(session_key(encrypted[0]), session_key(encrypted[2]));
+  EXPECT_NE(session_key(encrypted[2]), session_key(encrypted[3]));
+  EXPECT_NE(encrypted[0], encryptor.Encrypt(messages[0], keys_.public_key));
+
+  maidsafe::test::RunInParallel(5, [&] {
+    const PlainText data(RandomBytes(1, 1024));
+    EXPECT_EQ(data, decryptor.Decrypt(encryptor.Encrypt(data, keys_.public_key)));
+  });
+
+  // Other keys and altered data are rejected.
+  const Keys other_keys(GenerateKeyPair());
+  EXPECT_THROW(SessionDecryptor(other_keys.private_key).Decrypt(encrypted[0]), asymm_error);
+  std::string altered(encrypted[0].string());
+  altered[altered.size() - 1] ^= 1;
+  EXPECT_THROW(decryptor.Decrypt(CipherText(altered)), common_error);
+  EXPECT_THROW(decryptor.Decrypt(CipherText(std::string("not encrypted"))), asymm_error);
+  EXPECT_THROW(encryptor.Encrypt(messages[0], PublicKey()), asymm_error);
+
+  options.capacity = 0;
+  EXPECT_THROW(SessionEncryptor{options}, common_error);
+  EXPECT_THROW(SessionDecryptor(keys_.private_key, 0), common_error);
+  EXPECT_THROW(SessionDecryptor{PrivateKey()}, asymm_error);
+}
+
 TEST_F(RsaTest, BEH_SignValidate) {
   maidsafe::test::RunInParallel(5, [&] {
     Keys keys(GenerateKeyPair());
@@ -73,6 +157,71 @@ TEST_F(RsaTest, BEH_SignValidate) {
   });
 }
 
+TEST_F(RsaTest, BEH_SignWithReassignedKey) {
+  // Signers and verifiers are cached by key value, so reusing a key object for a different key
+  // mustn't pick up the previous key's context.
+  const PlainText data(RandomBytes(1, 100));
+  Keys keys(keys_);
+  const Signature signature(Sign(data, keys.private_key));
+  EXPECT_TRUE(CheckSignature(data, signature, keys.public_key));
+
+  keys = GenerateKeyPair();
+  const Signature other_signature(Sign(data, keys.private_key));
+  EXPECT_FALSE(CheckSignature(data, signature, keys.public_key));
+  EXPECT_TRUE(CheckSignature(data, other_signature, keys.public_key));
+  EXPECT_FALSE(CheckSignature(data, other_signature, keys_.public_key));
+  EXPECT_TRUE(CheckSignature(data, signature, keys_.public_key));
+}
+
+TEST_F(RsaTest, BEH_CheckSignatures) {
+  EXPECT_TRUE(CheckSignatures(std::vector<SignatureCheck>()).empty());
+
+  const Keys other_keys(GenerateKeyPair());
+  std::vector<PlainText> data;
+  std::vector<Signature> signatures;
+  for (int i(0); i != 100; ++i) {
+    data.emplace_back(RandomBytes(1, 100));
+    const PrivateKey& private_key(i % 3 == 0 ? other_keys.private_key : keys_.private_key);
+    signatures.push_back(Sign(data.back(), private_key));
+  }
+  // Corrupt some signatures and mismatch some keys.
+  std::vector<SignatureCheck> checks;
+  std::vector<bool> expected;
+  std::vector<Signature> bad_signatures;
+  bad_signatures.reserve(100);
+  for (int i(0); i != 100; ++i) {
+    const PublicKey& public_key(i % 3 == 0 ? other_keys.public_key : keys_.public_key);
+    if (i % 7 == 0) {
+      std::string corrupted(signatures[i].string());
+      corrupted.back() ^= 1;
+      bad_signatures.emplace_back(corrupted);
+      checks.emplace_back(data[i], bad_signatures.back(), public_key);
+      expected.push_back(false);
+    } else if (i % 11 == 0) {
+      checks.emplace_back(data[i], signatures[i],
+                          i % 3 == 0 ? keys_.public_key : other_keys.public_key);
+      expected.push_back(false);
+    } else {
+      checks.emplace_back(data[i], signatures[i], public_key);
+      expected.push_back(true);
+    }
+  }
+  // An invalid key or uninitialised data fails only its own item.
+  const PublicKey invalid_key;
+  const PlainText uninitialised_data;
+  checks.emplace_back(data[1], signatures[1], invalid_key);
+  expected.push_back(false);
+  checks.emplace_back(uninitialised_data, signatures[1], keys_.public_key);
+  expected.push_back(false);
+
+  const std::vector<bool> results(CheckSignatures(checks));
+  EXPECT_EQ(expected, results);
+  for (std::size_t i(0); i != 100; ++i) {
+    EXPECT_EQ(CheckSignature(*checks[i].data, *checks[i].signature, *checks[i].public_key),
+              results[i]);
+  }
+}
+
 TEST_F(RsaTest, FUNC_SignFileValidate) {
   Keys keys(GenerateKeyPair());
   maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestRSA"));
@@ -94,6 +243,53 @@ TEST_F(RsaTest, FUNC_SignFileValidate) {
   EXPECT_FALSE(CheckFileSignature(test_file.string(), bad_signature, keys.public_key));
 }
 
+TEST_F(RsaTest, BEH_SignFileMatchesSign) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestRSA"));
+  const boost::filesystem::path test_file(*test_path / RandomAlphaNumericString(5));
+  const std::vector<byte> contents(RandomBytes(100 * 1024, 200 * 1024));
+  ASSERT_TRUE(WriteFile(test_file, contents));
+
+  // Signatures over the mapped file and over the same data in memory are interchangeable.
+  const PlainText data(contents);
+  EXPECT_TRUE(CheckSignature(data, SignFile(test_file, keys_.private_key), keys_.public_key));
+  EXPECT_TRUE(CheckFileSignature(test_file, Sign(data, keys_.private_key), keys_.public_key));
+
+  std::vector<byte> modified(contents);
+  ++modified[RandomUint32() % modified.size()];
+  ASSERT_TRUE(WriteFile(test_file, modified));
+  EXPECT_FALSE(CheckFileSignature(test_file, Sign(data, keys_.private_key), keys_.public_key));
+
+  const boost::filesystem::path empty_file(*test_path / RandomAlphaNumericString(6));
+  ASSERT_TRUE(WriteFile(empty_file, std::vector<byte>()));
+  EXPECT_TRUE(CheckFileSignature(empty_file, SignFile(empty_file, keys_.private_key),
+                                 keys_.public_key));
+  EXPECT_FALSE(CheckFileSignature(test_file, SignFile(empty_file, keys_.private_key),
+                                  keys_.public_key));
+}
+
+TEST_F(RsaTest, BEH_SignatureVerifier) {
+  const std::vector<byte> contents(RandomBytes(10 * 1024, 20 * 1024));
+  const PlainText data(contents);
+  const Signature signature(Sign(data, keys_.private_key));
+
+  // The result doesn't depend on how the data is split between calls to Update.
+  for (const std::size_t piece_size : {std::size_t(1), std::size_t(1000), contents.size()}) {
+    SignatureVerifier verifier(signature, keys_.public_key);
+    for (std::size_t offset(0); offset < contents.size(); offset += piece_size)
+      verifier.Update(&contents[offset], std::min(piece_size, contents.size() - offset));
+    EXPECT_TRUE(verifier.Verify());
+    EXPECT_THROW(verifier.Verify(), common_error);
+    EXPECT_THROW(verifier.Update(contents.data(), 1), common_error);
+  }
+
+  SignatureVerifier truncated(signature, keys_.public_key);
+  truncated.Update(contents.data(), contents.size() - 1);
+  EXPECT_FALSE(truncated.Verify());
+
+  EXPECT_THROW(SignatureVerifier(Signature(), keys_.public_key), common_error);
+  EXPECT_THROW(SignatureVerifier(signature, PublicKey()), asymm_error);
+}
+
 TEST_F(RsaTest, BEH_EncodeKeys) {
   Keys keys(GenerateKeyPair());
   EncodedPrivateKey encoded_private_key(EncodeKey(keys.private_key));
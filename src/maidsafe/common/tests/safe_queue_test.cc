@@ -0,0 +1,132 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/safe_queue.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/containers/arena.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(SafeQueueTest, BEH_PushAndPop) {
+  SafeQueue<int> queue;
+  int element(0);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_FALSE(queue.TryPop(element));
+  queue.Push(1);
+  queue.Push(2);
+  EXPECT_EQ(2U, queue.Size());
+  EXPECT_TRUE(queue.TryPop(element));
+  EXPECT_EQ(1, element);
+  queue.WaitAndPop(element);
+  EXPECT_EQ(2, element);
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(BoundedSafeQueueTest, BEH_Capacity) {
+  BoundedSafeQueue<std::unique_ptr<int>> queue(2);
+  EXPECT_EQ(2U, queue.Capacity());
+  EXPECT_TRUE(queue.Push(std::unique_ptr<int>(new int(0))));
+  std::unique_ptr<int> element(new int(1));
+  EXPECT_TRUE(queue.TryPush(element));
+  EXPECT_FALSE(element);
+
+  element.reset(new int(2));
+  EXPECT_FALSE(queue.TryPush(element));
+  EXPECT_FALSE(queue.PushFor(element, std::chrono::milliseconds(10)));
+  ASSERT_TRUE(element);
+  EXPECT_EQ(2U, queue.Size());
+
+  std::unique_ptr<int> popped;
+  EXPECT_TRUE(queue.TryPop(popped));
+  EXPECT_EQ(0, *popped);
+  EXPECT_TRUE(queue.PushFor(element, std::chrono::milliseconds(10)));
+  EXPECT_TRUE(queue.WaitAndPopFor(popped, std::chrono::milliseconds(10)));
+  EXPECT_EQ(1, *popped);
+  EXPECT_TRUE(queue.WaitAndPop(popped));
+  EXPECT_EQ(2, *popped);
+  EXPECT_FALSE(queue.WaitAndPopFor(popped, std::chrono::milliseconds(10)));
+}
+
+TEST(BoundedSafeQueueTest, BEH_Backpressure) {
+  const int kElementCount(1000);
+  BoundedSafeQueue<int> queue(4);
+  std::thread producer([&] {
+    for (int i(0); i != kElementCount; ++i)
+      EXPECT_TRUE(queue.Push(i));
+    queue.Close();
+  });
+  int element(0), expected(0);
+  while (queue.WaitAndPop(element)) {
+    EXPECT_EQ(expected++, element);
+    EXPECT_LE(queue.Size(), queue.Capacity());
+  }
+  producer.join();
+  EXPECT_EQ(kElementCount, expected);
+}
+
+TEST(BoundedSafeQueueTest, BEH_Close) {
+  BoundedSafeQueue<int> queue(1);
+  EXPECT_TRUE(queue.Push(0));
+
+  // Close wakes both a blocked producer and, once drained, blocked consumers.
+  std::thread producer([&] { EXPECT_FALSE(queue.Push(1)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.Close();
+  producer.join();
+  EXPECT_TRUE(queue.Closed());
+
+  int element(1);
+  EXPECT_TRUE(queue.WaitAndPop(element));
+  EXPECT_EQ(0, element);
+  EXPECT_FALSE(queue.WaitAndPop(element));
+  EXPECT_FALSE(queue.Push(2));
+  EXPECT_FALSE(queue.TryPush(element));
+}
+
+TEST(SafeQueueTest, BEH_ArenaAllocator) {
+  MonotonicArena arena;
+  SafeQueue<int, ArenaAllocator<int, MonotonicArena>> queue{
+      ArenaAllocator<int, MonotonicArena>(arena)};
+  BoundedSafeQueue<int, ArenaAllocator<int, MonotonicArena>> bounded_queue(
+      4, ArenaAllocator<int, MonotonicArena>(arena));
+  int element(0);
+  for (int i(0); i < 1000; ++i) {
+    queue.Push(i);
+    EXPECT_TRUE(bounded_queue.TryPush(i));
+    EXPECT_TRUE(bounded_queue.TryPop(element));
+    EXPECT_EQ(i, element);
+  }
+  EXPECT_NE(0U, arena.bytes_reserved());
+  for (int i(0); i < 1000; ++i) {
+    EXPECT_TRUE(queue.TryPop(element));
+    EXPECT_EQ(i, element);
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,137 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/set_reconciliation.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+std::set<Identity> Decoded(const std::vector<Identity>& keys) {
+  return std::set<Identity>(keys.begin(), keys.end());
+}
+
+}  // unnamed namespace
+
+TEST(SetReconciliationTest, BEH_AddAndRemove) {
+  KeySetSketch sketch(16);
+  EXPECT_EQ(16U, sketch.CellsPerPartition());
+  EXPECT_EQ(0, sketch.KeyCount());
+  std::vector<Identity> keys;
+  for (int i(0); i != 10; ++i) {
+    keys.push_back(MakeIdentity());
+    sketch.Add(keys.back());
+  }
+  EXPECT_EQ(10, sketch.KeyCount());
+
+  // A sketch on its own decodes to the keys it holds.
+  auto decoded(sketch.Decode());
+  ASSERT_TRUE(decoded.valid());
+  EXPECT_EQ(Decoded(keys), Decoded(decoded->local_only));
+  EXPECT_TRUE(decoded->remote_only.empty());
+
+  for (const auto& key : keys)
+    sketch.Remove(key);
+  EXPECT_EQ(0, sketch.KeyCount());
+  decoded = sketch.Decode();
+  ASSERT_TRUE(decoded.valid());
+  EXPECT_TRUE(decoded->local_only.empty());
+  EXPECT_TRUE(decoded->remote_only.empty());
+}
+
+TEST(SetReconciliationTest, BEH_Difference) {
+  KeySetSketch local(1024), remote(1024);
+  for (int i(0); i != 1000; ++i) {
+    const Identity key(MakeIdentity());
+    local.Add(key);
+    remote.Add(key);
+  }
+  std::set<Identity> local_only, remote_only;
+  for (int i(0); i != 20; ++i) {
+    local_only.insert(MakeIdentity());
+    remote_only.insert(MakeIdentity());
+  }
+  for (const auto& key : local_only)
+    local.Add(key);
+  for (const auto& key : remote_only)
+    remote.Add(key);
+
+  // Folding to a size suited to the difference keeps the same keys.
+  for (const std::size_t cells : {1024U, 256U}) {
+    KeySetSketch difference(local.Fold(cells));
+    difference -= remote.Fold(cells);
+    EXPECT_EQ(0, difference.KeyCount());
+    const auto decoded(difference.Decode());
+    ASSERT_TRUE(decoded.valid()) << cells;
+    EXPECT_EQ(local_only, Decoded(decoded->local_only));
+    EXPECT_EQ(remote_only, Decoded(decoded->remote_only));
+  }
+
+  // Too small a sketch fails to decode rather than returning a partial difference.
+  KeySetSketch difference(local.Fold(4));
+  difference -= remote.Fold(4);
+  const auto decoded(difference.Decode());
+  ASSERT_FALSE(decoded.valid());
+  EXPECT_EQ(make_error_code(CommonErrors::cannot_exceed_limit), decoded.error().code());
+}
+
+TEST(SetReconciliationTest, BEH_SerialiseAndParse) {
+  KeySetSketch sketch(8);
+  std::set<Identity> keys;
+  for (int i(0); i != 5; ++i)
+    keys.insert(MakeIdentity());
+  for (const auto& key : keys)
+    sketch.Add(key);
+
+  const KeySetSketch parsed(Parse<KeySetSketch>(Serialise(sketch)));
+  EXPECT_EQ(8U, parsed.CellsPerPartition());
+  EXPECT_EQ(5, parsed.KeyCount());
+  const auto decoded(parsed.Decode());
+  ASSERT_TRUE(decoded.valid());
+  EXPECT_EQ(keys, Decoded(decoded->local_only));
+
+  // A sketch whose partitions aren't a power of two is rejected.
+  SerialisedData invalid(Serialise(std::int64_t{0}, std::vector<std::int32_t>(9),
+                                   std::vector<std::array<byte, identity_size>>(9),
+                                   std::vector<std::uint64_t>(9)));
+  EXPECT_THROW(Parse<KeySetSketch>(invalid), common_error);
+}
+
+TEST(SetReconciliationTest, BEH_InvalidArguments) {
+  EXPECT_THROW(KeySetSketch(0), common_error);
+  EXPECT_THROW(KeySetSketch(24), common_error);
+  KeySetSketch sketch(16);
+  EXPECT_THROW(sketch.Add(Identity()), common_error);
+  EXPECT_THROW(sketch.Fold(32), common_error);
+  EXPECT_THROW(sketch.Fold(3), common_error);
+  EXPECT_THROW(sketch -= KeySetSketch(8), common_error);
+  EXPECT_EQ(0, sketch.KeyCount());
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
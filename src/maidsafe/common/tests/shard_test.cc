@@ -0,0 +1,144 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/shard.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace shard {
+
+namespace test {
+
+std::vector<Identity> MakeIdentities(size_t count) {
+  std::vector<Identity> ids;
+  ids.reserve(count);
+  for (size_t i(0); i < count; ++i)
+    ids.push_back(MakeIdentity());
+  return ids;
+}
+
+TEST(ShardTest, BEH_KeyBits) {
+  std::vector<byte> bytes(identity_size, 0xff);
+  for (byte i(0); i < 8; ++i)
+    bytes[i] = i;
+  const Identity id(bytes);
+  EXPECT_EQ(0x0001020304050607ULL, KeyBits(id));
+  EXPECT_THROW(KeyBits(Identity()), common_error);
+
+  const Data::NameAndTypeId key(id, DataTypeId(1)), other_type(id, DataTypeId(2));
+  EXPECT_EQ(KeyBits(key), KeyBits(Data::NameAndTypeId(id, DataTypeId(1))));
+  EXPECT_NE(KeyBits(key), KeyBits(other_type));
+}
+
+TEST(ShardTest, BEH_JumpShard) {
+  EXPECT_THROW(JumpShard(0, 0), common_error);
+  EXPECT_EQ(0U, JumpShard(123456789, 1));
+
+  const auto ids(MakeIdentities(10000));
+  const std::uint32_t shard_count(10);
+  std::vector<int> counts(shard_count, 0);
+  for (const auto& id : ids) {
+    const auto shard(JumpShard(id, shard_count));
+    ASSERT_LT(shard, shard_count);
+    EXPECT_EQ(shard, JumpShard(id, shard_count));
+    ++counts[shard];
+  }
+  for (const int count : counts) {
+    EXPECT_GT(count, 800);
+    EXPECT_LT(count, 1200);
+  }
+
+  // Growing by one shard only moves keys to the new shard, and only about 1 / 11 of them.
+  int moved(0);
+  for (const auto& id : ids) {
+    const auto before(JumpShard(id, shard_count)), after(JumpShard(id, shard_count + 1));
+    if (before != after) {
+      EXPECT_EQ(shard_count, after);
+      ++moved;
+    }
+  }
+  EXPECT_GT(moved, 700);
+  EXPECT_LT(moved, 1100);
+}
+
+TEST(ShardTest, BEH_Rendezvous) {
+  RendezvousShards shards;
+  EXPECT_THROW(shards.Select(MakeIdentity()), common_error);
+  for (std::uint64_t id(0); id < 4; ++id)
+    shards.Add(id * 1000);
+  EXPECT_THROW(shards.Add(0), common_error);
+  EXPECT_THROW(shards.Add(5000, 0.0), common_error);
+  EXPECT_EQ(4U, shards.size());
+
+  const auto ids(MakeIdentities(10000));
+  std::vector<std::uint64_t> before;
+  std::map<std::uint64_t, int> counts;
+  for (const auto& id : ids) {
+    before.push_back(shards.Select(id));
+    ++counts[before.back()];
+    const auto replicas(shards.SelectN(id, 3));
+    ASSERT_EQ(3U, replicas.size());
+    EXPECT_EQ(before.back(), replicas[0]);
+    EXPECT_NE(replicas[0], replicas[1]);
+    EXPECT_NE(replicas[1], replicas[2]);
+  }
+  for (const auto& count : counts) {
+    EXPECT_GT(count.second, 2000);
+    EXPECT_LT(count.second, 3000);
+  }
+
+  // Removing a shard only moves the keys it held.
+  EXPECT_FALSE(shards.Remove(1));
+  EXPECT_TRUE(shards.Remove(2000));
+  for (size_t i(0); i < ids.size(); ++i) {
+    const auto after(shards.Select(ids[i]));
+    if (before[i] != 2000) {
+      EXPECT_EQ(before[i], after);
+    } else {
+      EXPECT_NE(2000U, after);
+    }
+  }
+
+  // A shard of weight 3 receives about half the keys alongside three of weight 1.
+  shards.Add(9000, 3.0);
+  int heavy(0);
+  for (size_t i(0); i < ids.size(); ++i) {
+    const auto after(shards.Select(ids[i]));
+    if (after == 9000) {
+      ++heavy;
+    } else if (before[i] != 2000) {
+      EXPECT_EQ(before[i], after);
+    }
+  }
+  EXPECT_GT(heavy, 4500);
+  EXPECT_LT(heavy, 5500);
+}
+
+}  // namespace test
+
+}  // namespace shard
+
+}  // namespace maidsafe
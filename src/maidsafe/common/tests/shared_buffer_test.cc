@@ -0,0 +1,86 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/shared_buffer.h"
+
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(SharedBufferTest, BEH_ConstructAndShare) {
+  EXPECT_TRUE(SharedBuffer().empty());
+  EXPECT_EQ(nullptr, SharedBuffer().SharedString().get());
+  EXPECT_THROW(SharedBuffer().ToNonEmptyString(), common_error);
+  EXPECT_THROW(SharedBuffer(std::shared_ptr<const NonEmptyString>()), common_error);
+  EXPECT_THROW(SharedBuffer(NonEmptyString()), common_error);
+
+  // Constructing from a vector or string moves rather than copies it.
+  std::vector<byte> bytes(RandomBytes(100));
+  const byte* const bytes_data(bytes.data());
+  const SharedBuffer from_bytes(std::move(bytes));
+  EXPECT_EQ(bytes_data, from_bytes.data());
+  EXPECT_EQ(100U, from_bytes.size());
+  EXPECT_EQ(nullptr, from_bytes.SharedString().get());
+
+  const auto string(std::make_shared<const NonEmptyString>(RandomBytes(100)));
+  const SharedBuffer from_string(string);
+  EXPECT_EQ(string->data(), from_string.data());
+  EXPECT_EQ(string, from_string.SharedString());
+  EXPECT_EQ(string, from_string.ToSharedString());
+  EXPECT_EQ(*string, from_string.ToNonEmptyString());
+
+  // Copies share storage and keep it alive.
+  SharedBuffer copy;
+  {
+    const SharedBuffer original(NonEmptyString(RandomBytes(10)));
+    copy = original;
+    EXPECT_EQ(original.data(), copy.data());
+    EXPECT_EQ(original, copy);
+  }
+  EXPECT_EQ(10U, copy.size());
+  EXPECT_NE(copy, from_string);
+}
+
+TEST(SharedBufferTest, BEH_Slice) {
+  const NonEmptyString value(RandomBytes(100));
+  const SharedBuffer buffer(value);
+  const SharedBuffer slice(buffer.Slice(10, 20));
+  EXPECT_EQ(buffer.data() + 10, slice.data());
+  EXPECT_EQ(std::vector<byte>(value.string().begin() + 10, value.string().begin() + 30),
+            std::vector<byte>(slice.begin(), slice.end()));
+  EXPECT_EQ(nullptr, slice.SharedString().get());
+  EXPECT_NE(nullptr, buffer.Slice(0).SharedString().get());
+  EXPECT_EQ(90U, buffer.Slice(10).size());
+  EXPECT_TRUE(buffer.Slice(100).empty());
+  EXPECT_EQ(buffer.data() + 15, slice.Slice(5, 5).data());
+
+  EXPECT_THROW(buffer.Slice(101), common_error);
+  EXPECT_THROW(buffer.Slice(50, 51), common_error);
+  EXPECT_THROW(slice.Slice(0, 21), common_error);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -18,9 +18,18 @@
 
 #include "maidsafe/common/sqlite3_wrapper.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "asio/use_future.hpp"
 #include "boost/filesystem/operations.hpp"
 
 #include "maidsafe/common/test.h"
@@ -134,5 +143,552 @@ TEST(Sqlite3WrapperTest, FUNC_WriteRead) {
   }
 }
 
+TEST(Sqlite3WrapperTest, FUNC_StatementCache) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+
+  sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate, 2);
+  {
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+    statement.Step();
+  }
+  EXPECT_EQ(0U, database.StatementCacheHits());
+  EXPECT_EQ(1U, database.StatementCacheMisses());
+  EXPECT_EQ(1U, database.StatementCacheSize());
+
+  // Only the first of these needs to be prepared.
+  const std::string insert_query("INSERT OR REPLACE INTO TEST_ME (TEST_DATA) VALUES (?)");
+  std::vector<std::string> test_data;
+  for (int i(0); i != 10; ++i) {
+    test_data.push_back(RandomString(8));
+    sqlite::Statement insert{database, insert_query};
+    insert.BindText(1, test_data.back());
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+  }
+  EXPECT_EQ(9U, database.StatementCacheHits());
+  EXPECT_EQ(2U, database.StatementCacheMisses());
+  EXPECT_EQ(2U, database.StatementCacheSize());
+
+  // A cached statement is handed out reset, with its previous bindings cleared.
+  const std::string find_query("SELECT * FROM TEST_ME WHERE TEST_DATA=?");
+  for (const auto& element : test_data) {
+    sqlite::Statement find{database, find_query};
+    find.BindText(1, element);
+    ASSERT_EQ(sqlite::StepResult::kSqliteRow, find.Step());
+    EXPECT_EQ(element, find.ColumnText(0));
+  }
+  {
+    sqlite::Statement find{database, find_query};
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, find.Step());
+  }
+  EXPECT_EQ(19U, database.StatementCacheHits());
+  EXPECT_EQ(3U, database.StatementCacheMisses());
+  // The capacity is respected.
+  EXPECT_EQ(2U, database.StatementCacheSize());
+
+  // Concurrent statements with the same query each need their own.
+  {
+    sqlite::Statement first{database, insert_query}, second{database, insert_query};
+    EXPECT_EQ(20U, database.StatementCacheHits());
+    EXPECT_EQ(4U, database.StatementCacheMisses());
+  }
+  EXPECT_EQ(2U, database.StatementCacheSize());
+
+  // A capacity of 0 disables the cache.
+  sqlite::Database uncached(test_db, sqlite::Mode::kReadWrite, 0);
+  for (int i(0); i != 2; ++i) {
+    sqlite::Statement find{uncached, find_query};
+    find.BindText(1, test_data.front());
+    EXPECT_EQ(sqlite::StepResult::kSqliteRow, find.Step());
+  }
+  EXPECT_EQ(0U, uncached.StatementCacheHits());
+  EXPECT_EQ(2U, uncached.StatementCacheMisses());
+  EXPECT_EQ(0U, uncached.StatementCacheSize());
+}
+
+TEST(Sqlite3WrapperTest, FUNC_BlobViews) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+
+  sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate);
+  {
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "KEY TEXT  PRIMARY KEY NOT NULL, VALUE BLOB);");
+    statement.Step();
+  }
+
+  const std::string insert_query("INSERT OR REPLACE INTO TEST_ME (KEY, VALUE) VALUES (?, ?)");
+  const SerialisedData large(RandomBytes(1 << 20, (1 << 20) + 1));
+  const SerialisedData small(RandomBytes(10, 20));
+  const SerialisedData empty;
+  {
+    sqlite::Statement insert{database, insert_query};
+    insert.BindText(1, "large");
+    insert.BindBlobStatic(2, large);
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+    insert.Reset();
+    insert.BindText(1, "small");
+    insert.BindBlobView(2, sqlite::BlobView{small.data(), small.size()});
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+    insert.Reset();
+    insert.BindText(1, "empty");
+    insert.BindBlobStatic(2, empty);
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+  }
+
+  sqlite::Statement find{database, "SELECT VALUE FROM TEST_ME WHERE KEY=?"};
+  for (const auto& key_and_value : {std::make_pair("large", &large),
+                                    std::make_pair("small", &small),
+                                    std::make_pair("empty", &empty)}) {
+    find.BindText(1, key_and_value.first);
+    ASSERT_EQ(sqlite::StepResult::kSqliteRow, find.Step());
+    const sqlite::BlobView view(find.ColumnBlobView(0));
+    EXPECT_EQ(*key_and_value.second, SerialisedData(view.data, view.data + view.size));
+    EXPECT_EQ(*key_and_value.second, find.ColumnBlob(0));
+    find.Reset();
+  }
+}
+
+TEST(Sqlite3WrapperTest, FUNC_ConcurrentTransactions) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  {
+    sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate);
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+    statement.Step();
+  }
+
+  // Writers on separate connections to the same file queue rather than failing with SQLITE_BUSY.
+  const int kTransactionCount(50);
+  std::atomic<int> committed_count(0);
+  RunInParallel(4, [&] {
+    sqlite::Database database(test_db, sqlite::Mode::kReadWrite);
+    for (int i(0); i != kTransactionCount; ++i) {
+      sqlite::Transaction transaction(database);
+      sqlite::Statement insert{database, "INSERT INTO TEST_ME (TEST_DATA) VALUES (?)"};
+      insert.BindText(1, RandomString(32));
+      EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+      transaction.Commit();
+      ++committed_count;
+    }
+  });
+  EXPECT_EQ(4 * kTransactionCount, committed_count);
+
+  sqlite::Database database(test_db, sqlite::Mode::kReadOnly);
+  sqlite::Statement count{database, "SELECT COUNT(*) FROM TEST_ME"};
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+  EXPECT_EQ(std::to_string(4 * kTransactionCount), count.ColumnText(0));
+
+  // An uncommitted transaction is rolled back.
+  {
+    sqlite::Database writer(test_db, sqlite::Mode::kReadWrite);
+    sqlite::Transaction transaction(writer);
+    sqlite::Statement insert{writer, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('rolled back')"};
+    EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+  }
+  count.Reset();
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+  EXPECT_EQ(std::to_string(4 * kTransactionCount), count.ColumnText(0));
+}
+
+TEST(Sqlite3WrapperTest, FUNC_GroupCommitWriter) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  const int kMutationCount(200);
+  std::mutex mutex;
+  std::vector<std::future<void>> results;
+  {
+    sqlite::GroupCommitWriter writer(test_db, sqlite::Mode::kReadWriteCreate,
+                                     std::chrono::milliseconds(20), 64);
+    writer.Enqueue([](sqlite::Database& database) {
+      sqlite::Statement statement(database,
+                                  "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                  "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+      statement.Step();
+    }).get();
+
+    std::atomic<int> index(0);
+    RunInParallel(4, [&] {
+      for (int i(0); i < kMutationCount / 4; ++i) {
+        const std::string value(std::to_string(index++));
+        auto result(writer.Enqueue([value](sqlite::Database& database) {
+          sqlite::Statement insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES (?)");
+          insert.BindText(1, value);
+          insert.Step();
+        }));
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+      }
+    });
+
+    // A failing mutation only affects its own future; the rest of its batch is still committed.
+    auto duplicate(writer.Enqueue([](sqlite::Database& database) {
+      sqlite::Statement insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('partial')");
+      insert.Step();
+      sqlite::Statement duplicate_insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('0')");
+      duplicate_insert.Step();
+    }));
+    auto last(writer.Enqueue([](sqlite::Database& database) {
+      sqlite::Statement insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('last')");
+      insert.Step();
+    }));
+    EXPECT_THROW(duplicate.get(), maidsafe_error);
+    // Enqueued but not yet committed when 'writer' is destroyed.
+    results.push_back(writer.Enqueue([](sqlite::Database& database) {
+      sqlite::Statement insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('flushed')");
+      insert.Step();
+    }));
+    EXPECT_NO_THROW(last.get());
+  }
+  for (auto& result : results)
+    EXPECT_NO_THROW(result.get());
+
+  sqlite::Database database(test_db, sqlite::Mode::kReadOnly);
+  sqlite::Statement count{database, "SELECT COUNT(*) FROM TEST_ME"};
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+  EXPECT_EQ(std::to_string(kMutationCount + 2), count.ColumnText(0));
+  sqlite::Statement partial{database, "SELECT COUNT(*) FROM TEST_ME WHERE TEST_DATA = 'partial'"};
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, partial.Step());
+  EXPECT_EQ("0", partial.ColumnText(0));
+}
+
+TEST(Sqlite3WrapperTest, FUNC_ConnectionPool) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  sqlite::ConnectionPool pool(test_db, 3);
+  EXPECT_EQ(3U, pool.ReaderCount());
+  {
+    sqlite::Transaction transaction(pool.Writer());
+    sqlite::Statement create(pool.Writer(),
+                             "CREATE TABLE IF NOT EXISTS TEST_ME("
+                             "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+    create.Step();
+    for (int i(0); i < 100; ++i) {
+      sqlite::Statement insert(pool.Writer(), "INSERT INTO TEST_ME (TEST_DATA) VALUES (?)");
+      insert.BindText(1, std::to_string(i));
+      insert.Step();
+    }
+    transaction.Commit();
+  }
+
+  auto count_rows([](sqlite::Database& reader) {
+    sqlite::Statement count{reader, "SELECT COUNT(*) FROM TEST_ME"};
+    EXPECT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+    return count.ColumnText(0);
+  });
+
+  // Readers proceed while the writer holds an uncommitted transaction, and don't see its changes.
+  {
+    sqlite::Transaction transaction(pool.Writer());
+    sqlite::Statement insert(pool.Writer(), "INSERT INTO TEST_ME (TEST_DATA) VALUES ('pending')");
+    insert.Step();
+    std::atomic<int> read_count(0);
+    RunInParallel(6, [&] {
+      for (int i(0); i < 20; ++i) {
+        EXPECT_EQ("100", pool.Read(count_rows));
+        ++read_count;
+      }
+    });
+    EXPECT_EQ(6 * 20, read_count);
+    transaction.Commit();
+  }
+  EXPECT_EQ("101", pool.Read(count_rows));
+
+  // Pooled connections are read-only.
+  pool.Read([](sqlite::Database& reader) {
+    sqlite::Statement insert(reader, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('read-only')");
+    EXPECT_THROW(insert.Step(), maidsafe_error);
+  });
+  EXPECT_EQ("101", pool.Read(count_rows));
+}
+
+TEST(Sqlite3WrapperTest, FUNC_QueryExecutor) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  std::unique_ptr<sqlite::QueryExecutor> executor(new sqlite::QueryExecutor(test_db, 2));
+  auto inline_executor([](std::function<void()> functor) { functor(); });
+
+  std::promise<std::error_code> created;
+  executor->Write([](sqlite::Database& writer) {
+    sqlite::Statement create(writer,
+                             "CREATE TABLE IF NOT EXISTS TEST_ME("
+                             "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+    create.Step();
+  }, inline_executor, [&](std::error_code error) { created.set_value(error); });
+  EXPECT_FALSE(created.get_future().get());
+
+  // Writes complete in order, each committed separately, and the handler is run via the executor.
+  std::vector<std::future<std::error_code>> inserted;
+  std::atomic<int> executed(0);
+  auto counting_executor([&](std::function<void()> functor) {
+    ++executed;
+    functor();
+  });
+  for (int i(0); i < 10; ++i) {
+    auto promise(std::make_shared<std::promise<std::error_code>>());
+    inserted.push_back(promise->get_future());
+    executor->Write([i](sqlite::Database& writer) {
+      sqlite::Statement insert(writer, "INSERT INTO TEST_ME (TEST_DATA) VALUES (?)");
+      insert.BindText(1, std::to_string(i));
+      insert.Step();
+    }, counting_executor, [promise](std::error_code error) { promise->set_value(error); });
+  }
+  for (auto& result : inserted)
+    EXPECT_FALSE(result.get());
+  EXPECT_EQ(10, executed);
+
+  auto count_rows([](sqlite::Database& reader) {
+    sqlite::Statement count{reader, "SELECT COUNT(*) FROM TEST_ME"};
+    EXPECT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+    return count.ColumnText(0);
+  });
+  std::promise<std::string> counted;
+  executor->Read(count_rows, inline_executor, [&](std::error_code error, std::string count) {
+    EXPECT_FALSE(error);
+    counted.set_value(count);
+  });
+  EXPECT_EQ("10", counted.get_future().get());
+
+  // A query which throws has its changes rolled back, and its handler receives the error and a
+  // default-constructed result.
+  std::promise<std::pair<std::error_code, int>> failed;
+  executor->Write([](sqlite::Database& writer) -> int {
+    sqlite::Statement insert(writer, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('rolled back')");
+    insert.Step();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }, inline_executor, [&](std::error_code error, int result) {
+    failed.set_value(std::make_pair(error, result));
+  });
+  const auto failure(failed.get_future().get());
+  EXPECT_EQ(make_error_code(CommonErrors::invalid_argument), failure.first);
+  EXPECT_EQ(0, failure.second);
+
+  // Completion tokens are supported, e.g. futures.
+  EXPECT_EQ("10", executor->AsyncRead(count_rows, asio::use_future).get());
+  std::future<void> written(executor->AsyncWrite([](sqlite::Database& writer) {
+    sqlite::Statement insert(writer, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('future')");
+    insert.Step();
+  }, asio::use_future));
+  EXPECT_NO_THROW(written.get());
+  std::future<std::string> read_only(executor->AsyncRead([](sqlite::Database& reader) {
+    sqlite::Statement insert(reader, "INSERT INTO TEST_ME (TEST_DATA) VALUES ('read-only')");
+    insert.Step();
+    return std::string("unreachable");
+  }, asio::use_future));
+  EXPECT_THROW(read_only.get(), std::system_error);
+
+  // Queries queued before destruction are still run.
+  std::atomic<int> completed(0);
+  for (int i(0); i < 20; ++i) {
+    executor->Read(count_rows, inline_executor, [&](std::error_code error, std::string count) {
+      EXPECT_FALSE(error);
+      EXPECT_EQ("11", count);
+      ++completed;
+    });
+  }
+  executor.reset();
+  EXPECT_EQ(20, completed);
+}
+
+TEST(Sqlite3WrapperTest, FUNC_Checkpointer) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  fs::path test_wal(*test_path / "test_db-file-wal");
+  sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate);
+  {
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "TEST_DATA TEXT  PRIMARY KEY NOT NULL);");
+    statement.Step();
+  }
+  const auto wait_for([](std::function<bool()> predicate) {
+    const auto deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+    while (!predicate() && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return predicate();
+  });
+
+  // Commits are counted in the WAL, and left there until checkpointed.
+  const auto insert_rows([&](int first, int count) {
+    for (int i(first); i < first + count; ++i) {
+      sqlite::Transaction transaction(database);
+      sqlite::Statement insert(database, "INSERT INTO TEST_ME (TEST_DATA) VALUES (?)");
+      insert.BindText(1, RandomAlphaNumericString(1000) + std::to_string(i));
+      insert.Step();
+      transaction.Commit();
+    }
+  });
+  insert_rows(0, 20);
+  EXPECT_GE(database.GetWalMetrics().wal_frames, 20);
+  EXPECT_EQ(0, database.GetWalMetrics().checkpointed_frames);
+
+  sqlite::Checkpointer checkpointer(test_db, 10, std::chrono::milliseconds(10),
+                                    std::chrono::milliseconds(500));
+  // The checkpointer starts with a passive checkpoint of whatever is already in the WAL.
+  EXPECT_TRUE(wait_for([&] { return checkpointer.Metrics().passive_checkpoints == 1; }));
+  EXPECT_EQ(checkpointer.Metrics().wal_frames, checkpointer.Metrics().checkpointed_frames);
+
+  // While commits keep coming, the WAL is checkpointed passively once the threshold is reached.
+  int row(20);
+  EXPECT_TRUE(wait_for([&] {
+    insert_rows(row++, 1);
+    return checkpointer.Metrics().passive_checkpoints == 2;
+  }));
+  EXPECT_GT(row, 21);
+  EXPECT_EQ(0U, checkpointer.Metrics().truncate_checkpoints);
+
+  // Once idle, the WAL is truncated.
+  EXPECT_TRUE(wait_for([&] { return checkpointer.Metrics().truncate_checkpoints != 0; }));
+  EXPECT_EQ(0, database.GetWalMetrics().wal_frames);
+  EXPECT_EQ(0U, fs::file_size(test_wal));
+
+  sqlite::Statement count{database, "SELECT COUNT(*) FROM TEST_ME"};
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+  EXPECT_EQ(std::to_string(row), count.ColumnText(0));
+}
+
+TEST(Sqlite3WrapperTest, FUNC_Options) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  const auto pragma([](sqlite::Database& database, const std::string& name) {
+    sqlite::Statement statement(database, "PRAGMA " + name);
+    EXPECT_EQ(sqlite::StepResult::kSqliteRow, statement.Step());
+    return statement.ColumnText(0);
+  });
+
+  {
+    // The defaults are unchanged from before Options existed.
+    sqlite::Database database(*test_path / "default", sqlite::Mode::kReadWriteCreate);
+    EXPECT_EQ("wal", pragma(database, "journal_mode"));
+    EXPECT_EQ("0", pragma(database, "synchronous"));
+    EXPECT_EQ("250", pragma(database, "busy_timeout"));
+  }
+  {
+    sqlite::Options options(sqlite::Options::Durable());
+    options.page_size = 8192;
+    sqlite::Database database(*test_path / "durable", sqlite::Mode::kReadWriteCreate, options);
+    sqlite::Statement create(database, "CREATE TABLE TEST_ME(TEST_DATA TEXT);");
+    create.Step();
+    EXPECT_EQ("wal", pragma(database, "journal_mode"));
+    EXPECT_EQ("2", pragma(database, "synchronous"));
+    EXPECT_EQ("8192", pragma(database, "page_size"));
+    EXPECT_EQ("5000", pragma(database, "busy_timeout"));
+  }
+  {
+    sqlite::Database database(*test_path / "balanced", sqlite::Mode::kReadWriteCreate,
+                              sqlite::Options::Balanced());
+    EXPECT_EQ("1", pragma(database, "synchronous"));
+    EXPECT_EQ(std::to_string(-16 * 1024), pragma(database, "cache_size"));
+  }
+  {
+    sqlite::Database database(*test_path / "throughput", sqlite::Mode::kReadWriteCreate,
+                              sqlite::Options::Throughput());
+    EXPECT_EQ("0", pragma(database, "synchronous"));
+    EXPECT_EQ(std::to_string(-64 * 1024), pragma(database, "cache_size"));
+    EXPECT_EQ("2", pragma(database, "temp_store"));
+  }
+}
+
+TEST(Sqlite3WrapperTest, FUNC_BulkInsert) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate);
+  {
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "KEY TEXT  PRIMARY KEY NOT NULL, VALUE BLOB NOT NULL);");
+    statement.Step();
+  }
+
+  // More rows than fit in one statement, and not a multiple of the rows per statement.
+  const std::size_t kRowCount(3 * sqlite::kMaxBulkInsertRows + 7);
+  std::vector<std::pair<std::string, SerialisedData>> rows;
+  for (std::size_t i(0); i != kRowCount; ++i)
+    rows.emplace_back(std::to_string(i), RandomBytes(1, 100));
+  const auto bind_row([&](sqlite::Statement& statement, std::size_t row, int first_index) {
+    statement.BindText(first_index, rows[row].first);
+    statement.BindBlob(first_index + 1, rows[row].second);
+  });
+  {
+    sqlite::Transaction transaction(database);
+    sqlite::BulkInsert(database, "INSERT INTO TEST_ME (KEY, VALUE)", 2, kRowCount, bind_row);
+    sqlite::BulkInsert(database, "INSERT INTO TEST_ME (KEY, VALUE)", 2, 0, bind_row);
+    EXPECT_THROW(sqlite::BulkInsert(database, "INSERT INTO TEST_ME", 0, 1, bind_row),
+                 maidsafe_error);
+    transaction.Commit();
+  }
+
+  sqlite::Statement count{database, "SELECT COUNT(*) FROM TEST_ME"};
+  ASSERT_EQ(sqlite::StepResult::kSqliteRow, count.Step());
+  EXPECT_EQ(std::to_string(kRowCount), count.ColumnText(0));
+  sqlite::Statement find{database, "SELECT VALUE FROM TEST_ME WHERE KEY=?"};
+  for (const auto& row : rows) {
+    find.BindText(1, row.first);
+    ASSERT_EQ(sqlite::StepResult::kSqliteRow, find.Step());
+    EXPECT_EQ(row.second, find.ColumnBlob(0));
+    find.Reset();
+  }
+}
+
+TEST(Sqlite3WrapperTest, FUNC_TypedColumns) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  fs::path test_db(*test_path / "test_db-file");
+  sqlite::Database database(test_db, sqlite::Mode::kReadWriteCreate);
+  {
+    sqlite::Statement statement(database,
+                                "CREATE TABLE IF NOT EXISTS TEST_ME("
+                                "TIMESTAMP INTEGER NOT NULL, RATIO REAL NOT NULL, "
+                                "NAME TEXT NOT NULL, DATA BLOB NOT NULL);");
+    statement.Step();
+  }
+
+  const std::vector<std::int64_t> timestamps{-1, 0, 1, 1LL << 40,
+                                             std::numeric_limits<std::int64_t>::max(),
+                                             std::numeric_limits<std::int64_t>::min()};
+  std::vector<SerialisedData> blobs;
+  {
+    sqlite::Statement insert(database, "INSERT INTO TEST_ME VALUES (?, ?, ?, ?)");
+    for (std::size_t i(0); i != timestamps.size(); ++i) {
+      blobs.push_back(RandomBytes(1, 100));
+      insert.BindInt64(1, timestamps[i]);
+      insert.BindDouble(2, static_cast<double>(i) / 4);
+      insert.BindText(3, std::to_string(i));
+      insert.BindBlob(4, blobs.back());
+      EXPECT_EQ(sqlite::StepResult::kSqliteDone, insert.Step());
+      insert.Reset();
+    }
+  }
+
+  sqlite::Statement select(database, "SELECT * FROM TEST_ME ORDER BY RATIO");
+  std::size_t i(0);
+  for (const auto& row : select.Rows<std::int64_t, double, std::string, SerialisedData>()) {
+    ASSERT_LT(i, timestamps.size());
+    EXPECT_EQ(timestamps[i], std::get<0>(row));
+    EXPECT_EQ(static_cast<double>(i) / 4, std::get<1>(row));
+    EXPECT_EQ(std::to_string(i), std::get<2>(row));
+    EXPECT_EQ(blobs[i], std::get<3>(row));
+    ++i;
+  }
+  EXPECT_EQ(timestamps.size(), i);
+
+  // Only the requested leading columns are read, and a reset statement can be iterated again.
+  select.Reset();
+  i = 0;
+  for (const auto& row : select.Rows<std::int64_t>()) {
+    EXPECT_EQ(timestamps[i], std::get<0>(row));
+    ++i;
+  }
+  EXPECT_EQ(timestamps.size(), i);
+
+  sqlite::Statement none(database, "SELECT TIMESTAMP FROM TEST_ME WHERE TIMESTAMP > ?");
+  none.BindInt64(1, std::numeric_limits<std::int64_t>::max());
+  auto rows(none.Rows<std::int64_t>());
+  EXPECT_TRUE(rows.begin() == rows.end());
+}
+
 }  // namespace test
 }  // namespace maidsafe
@@ -0,0 +1,50 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/startup_timer.h"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(StartupTimerTest, BEH_RecordsOnlyWhenEnabled) {
+  const std::size_t recorded_before(StartupTimer::Recorded().size());
+  {
+    StartupTimer startup_timer("startup timer test");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const StartupTimer::Timings timings(StartupTimer::Recorded());
+  if (!StartupTimer::Enabled()) {
+    EXPECT_EQ(recorded_before, timings.size());
+    return;
+  }
+  ASSERT_EQ(recorded_before + 1, timings.size());
+  EXPECT_EQ(std::string("startup timer test"), timings.back().first);
+  EXPECT_GE(timings.back().second, std::chrono::milliseconds(2));
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
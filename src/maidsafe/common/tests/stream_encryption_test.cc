@@ -0,0 +1,147 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/stream_encryption.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+namespace test {
+
+namespace {
+
+const std::size_t kSegmentSize(kStreamSegmentSize);
+const std::size_t kCiphertextSegmentSize(kStreamCiphertextSegmentSize);
+
+AES256KeyAndIV RandomKeyAndIV() {
+  return AES256KeyAndIV(RandomBytes(AES256_KeySize + AES256_IVSize));
+}
+
+std::string Encrypt(const std::string& plaintext, const AES256KeyAndIV& key_and_iv) {
+  std::istringstream input(plaintext);
+  std::ostringstream output;
+  StreamEncrypt(input, output, key_and_iv);
+  return output.str();
+}
+
+std::string Decrypt(const std::string& ciphertext, const AES256KeyAndIV& key_and_iv) {
+  std::istringstream input(ciphertext);
+  std::ostringstream output;
+  StreamDecrypt(input, output, key_and_iv);
+  return output.str();
+}
+
+}  // unnamed namespace
+
+TEST(StreamEncryptionTest, BEH_RoundTrip) {
+  const AES256KeyAndIV key_and_iv(RandomKeyAndIV());
+  // Cover empty input, partial and exact final segments, and more than one batch of segments.
+  const std::size_t batch_size(Concurrency() * kStreamSegmentsPerThread);
+  for (const std::size_t size : {std::size_t(0), std::size_t(1), kSegmentSize - 1, kSegmentSize,
+                                 3 * kSegmentSize + 100, (batch_size + 1) * kSegmentSize}) {
+    SCOPED_TRACE(size);
+    const std::string plaintext(RandomString(size));
+    const std::string ciphertext(Encrypt(plaintext, key_and_iv));
+    const std::uint64_t segment_count(size == 0 ? 1 : (size + kSegmentSize - 1) / kSegmentSize);
+    EXPECT_EQ(size + segment_count * AES256_TagSize, ciphertext.size());
+    EXPECT_EQ(segment_count, StreamSegmentCount(ciphertext.size()));
+    EXPECT_EQ(plaintext, Decrypt(ciphertext, key_and_iv));
+    EXPECT_THROW(Decrypt(ciphertext, RandomKeyAndIV()), common_error);
+  }
+  // A single segment is the same as a SymmEncrypt with the last-segment flag set.
+  const std::string plaintext(RandomString(100));
+  std::vector<byte> segment_key_and_iv(key_and_iv.begin(), key_and_iv.end());
+  std::fill(segment_key_and_iv.end() - 5, segment_key_and_iv.end(), 0);
+  segment_key_and_iv.back() = 1;
+  const CipherText expected(SymmEncrypt(PlainText(plaintext),
+                                        AES256KeyAndIV(std::move(segment_key_and_iv))));
+  EXPECT_EQ(std::string(expected->begin(), expected->end()), Encrypt(plaintext, key_and_iv));
+}
+
+TEST(StreamEncryptionTest, BEH_RandomAccess) {
+  const AES256KeyAndIV key_and_iv(RandomKeyAndIV());
+  const std::string plaintext(RandomString(5 * kSegmentSize + 10));
+  std::istringstream ciphertext(Encrypt(plaintext, key_and_iv));
+  for (std::uint64_t index(0); index != 6; ++index) {
+    const std::vector<byte> segment(StreamDecryptSegment(ciphertext, index, key_and_iv));
+    EXPECT_EQ(plaintext.substr(index * kSegmentSize, kSegmentSize),
+              std::string(segment.begin(), segment.end()));
+  }
+  EXPECT_THROW(StreamDecryptSegment(ciphertext, 6, key_and_iv), common_error);
+  EXPECT_THROW(StreamDecryptSegment(ciphertext, 0, AES256KeyAndIV()), common_error);
+}
+
+TEST(StreamEncryptionTest, BEH_Tampering) {
+  const AES256KeyAndIV key_and_iv(RandomKeyAndIV());
+  const std::string ciphertext(Encrypt(RandomString(3 * kSegmentSize + 10), key_and_iv));
+
+  // Modified byte
+  std::string tampered(ciphertext);
+  ++tampered[RandomUint32() % tampered.size()];
+  EXPECT_THROW(Decrypt(tampered, key_and_iv), common_error);
+
+  // Truncated at a segment boundary, so all remaining segments are intact
+  EXPECT_THROW(Decrypt(ciphertext.substr(0, 2 * kCiphertextSegmentSize), key_and_iv),
+               common_error);
+
+  // Reordered segments
+  tampered = ciphertext.substr(kCiphertextSegmentSize, kCiphertextSegmentSize) +
+             ciphertext.substr(0, kCiphertextSegmentSize) +
+             ciphertext.substr(2 * kCiphertextSegmentSize);
+  EXPECT_THROW(Decrypt(tampered, key_and_iv), common_error);
+
+  // Duplicated segment
+  tampered = ciphertext.substr(0, kCiphertextSegmentSize) + ciphertext;
+  EXPECT_THROW(Decrypt(tampered, key_and_iv), common_error);
+
+  EXPECT_THROW(Decrypt(std::string(), key_and_iv), common_error);
+  EXPECT_THROW(StreamSegmentCount(0), common_error);
+  EXPECT_THROW(StreamSegmentCount(kCiphertextSegmentSize + 1), common_error);
+}
+
+TEST(StreamEncryptionTest, BEH_Files) {
+  const TestPath test_path(CreateTestPath("MaidSafe_TestStreamEncryption"));
+  const boost::filesystem::path plain_path(*test_path / "plain");
+  const boost::filesystem::path cipher_path(*test_path / "cipher");
+  const boost::filesystem::path decrypted_path(*test_path / "decrypted");
+  const AES256KeyAndIV key_and_iv(RandomKeyAndIV());
+  const std::vector<byte> content(RandomBytes(2 * kSegmentSize + 1));
+  ASSERT_TRUE(WriteFile(plain_path, content));
+
+  StreamEncryptFile(plain_path, cipher_path, key_and_iv);
+  EXPECT_EQ(content.size() + 3 * AES256_TagSize, boost::filesystem::file_size(cipher_path));
+  StreamDecryptFile(cipher_path, decrypted_path, key_and_iv);
+  EXPECT_EQ(content, *ReadFile(decrypted_path));
+  EXPECT_THROW(StreamEncryptFile(*test_path / "missing", cipher_path, key_and_iv), common_error);
+}
+
+}  // namespace test
+
+}  // namespace crypto
+
+}  // namespace maidsafe
@@ -151,8 +151,13 @@ TYPED_TEST(TaggedValueTest, BEH_Serialisation) {
   using TestValue = TaggedValue<TypeParam, TestTag>;
   const TestValue tagged_value(this->RandomValue());
   auto serialised(Serialise(tagged_value));
+  EXPECT_EQ(Serialise(tagged_value.data), serialised);
+  EXPECT_EQ(sizeof(TypeParam), SerialisedSize(tagged_value));
   TestValue parsed(Parse<TestValue>(serialised));
   EXPECT_TRUE(tagged_value == parsed);
+
+  serialised.pop_back();
+  EXPECT_FALSE(TryParse<TestValue>(serialised));
 }
 
 }  // namespace test
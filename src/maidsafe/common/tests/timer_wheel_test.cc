@@ -0,0 +1,198 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/timer_wheel.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace test {
+
+namespace {
+
+// A wheel whose service never runs, so that it only advances when the test says.  Ticks are long
+// enough that the time taken to schedule a timer never crosses a tick boundary.
+struct ManualWheel {
+  ManualWheel()
+      : service(),
+        wheel(TimerWheel::MakeShared(service, std::chrono::seconds(1))),
+        start(std::chrono::steady_clock::now()) {}
+  std::chrono::steady_clock::time_point At(int64_t ticks) const {
+    return start + std::chrono::seconds(ticks);
+  }
+  asio::io_service service;
+  std::shared_ptr<TimerWheel> wheel;
+  const std::chrono::steady_clock::time_point start;
+};
+
+}  // unnamed namespace
+
+TEST(TimerWheelTest, BEH_ScheduleAndCancel) {
+  asio::io_service service;
+  EXPECT_THROW(TimerWheel::MakeShared(service, std::chrono::steady_clock::duration::zero()),
+               maidsafe_error);
+  ManualWheel manual;
+  TimerWheel& wheel(*manual.wheel);
+  EXPECT_THROW(wheel.Schedule(std::chrono::seconds(1), nullptr), maidsafe_error);
+
+  std::vector<int> fired;
+  const TimerWheel::TimerId first(wheel.Schedule(std::chrono::seconds(5), [&] {
+    fired.push_back(1);
+  }));
+  const TimerWheel::TimerId second(wheel.Schedule(std::chrono::seconds(5), [&] {
+    fired.push_back(2);
+  }));
+  const TimerWheel::TimerId third(wheel.Schedule(std::chrono::seconds(10), [&] {
+    fired.push_back(3);
+  }));
+  EXPECT_NE(0U, first);
+  EXPECT_EQ(3U, wheel.size());
+
+  // Timers never fire early.
+  EXPECT_EQ(0U, wheel.Advance(manual.At(4)));
+  EXPECT_TRUE(fired.empty());
+  EXPECT_TRUE(wheel.Cancel(second));
+  EXPECT_FALSE(wheel.Cancel(second));
+  EXPECT_EQ(1U, wheel.Advance(manual.At(6)));
+  ASSERT_EQ(1U, fired.size());
+  EXPECT_EQ(1, fired.front());
+  EXPECT_FALSE(wheel.Cancel(first));
+
+  // Moving the third timer later.
+  EXPECT_TRUE(wheel.Reschedule(third, std::chrono::seconds(100)));
+  EXPECT_EQ(0U, wheel.Advance(manual.At(50)));
+  EXPECT_EQ(1U, wheel.size());
+  EXPECT_EQ(1U, wheel.Advance(manual.At(102)));
+  EXPECT_EQ(3, fired.back());
+  EXPECT_FALSE(wheel.Reschedule(third, std::chrono::seconds(1)));
+  EXPECT_EQ(0U, wheel.size());
+
+  // Ids of finished timers don't match the timers which reuse their slots.
+  const TimerWheel::TimerId reused(wheel.Schedule(std::chrono::seconds(1), [&] {
+    fired.push_back(4);
+  }));
+  EXPECT_NE(first, reused);
+  EXPECT_NE(second, reused);
+  EXPECT_FALSE(wheel.Cancel(first));
+  EXPECT_FALSE(wheel.Cancel(second));
+  EXPECT_EQ(1U, wheel.size());
+}
+
+TEST(TimerWheelTest, BEH_CallbacksCanUseWheel) {
+  ManualWheel manual;
+  TimerWheel& wheel(*manual.wheel);
+  int chained(0);
+  TimerWheel::TimerId victim(0);
+  wheel.Schedule(std::chrono::seconds(1), [&] {
+    ++chained;
+    wheel.Schedule(std::chrono::seconds(1), [&] { ++chained; });
+    EXPECT_TRUE(wheel.Cancel(victim));
+  });
+  victim = wheel.Schedule(std::chrono::seconds(30),
+                          [&] { ADD_FAILURE() << "Cancelled timer ran"; });
+  EXPECT_EQ(1U, wheel.Advance(manual.At(3)));
+  EXPECT_EQ(1, chained);
+  EXPECT_EQ(1U, wheel.size());
+  EXPECT_EQ(1U, wheel.Advance(manual.At(6)));
+  EXPECT_EQ(2, chained);
+  EXPECT_EQ(0U, wheel.Advance(manual.At(60)));
+}
+
+TEST(TimerWheelTest, BEH_LongDelays) {
+  // Delays span every level, and some exceed the wheel's range so have to be parked and re-sorted.
+  ManualWheel manual;
+  TimerWheel& wheel(*manual.wheel);
+  const int64_t kRange(int64_t(1) << 24);
+  const int kTimerCount(2000);
+  const int64_t kStep(997);
+  std::vector<int64_t> delays;
+  std::vector<int64_t> fired_at(kTimerCount, -1);
+  int64_t now(0);
+  for (int i(0); i != kTimerCount; ++i) {
+    int64_t delay(static_cast<int64_t>(RandomUint32() % 4096));
+    if (i % 4 == 1)
+      delay = static_cast<int64_t>(RandomUint32() % (1 << 20));
+    else if (i % 4 == 2)
+      delay = static_cast<int64_t>(RandomUint32() % kRange);
+    else if (i % 4 == 3)
+      delay = kRange + static_cast<int64_t>(RandomUint32() % (2 * kRange));
+    delays.push_back(delay);
+    wheel.Schedule(std::chrono::seconds(delay), [&fired_at, &now, i] { fired_at[i] = now; });
+  }
+
+  while (wheel.size() != 0) {
+    now += kStep;
+    wheel.Advance(manual.At(now));
+    ASSERT_LT(now, 4 * kRange);
+  }
+  for (int i(0); i != kTimerCount; ++i) {
+    // Each fires at the first step after it's due (or the one after, if scheduling the timer took
+    // it past a tick boundary).
+    ASSERT_GE(fired_at[i], delays[i]) << "Timer " << i;
+    ASSERT_LE(fired_at[i], delays[i] + kStep + 1) << "Timer " << i;
+  }
+}
+
+TEST(TimerWheelTest, BEH_DrivenByService) {
+  AsioService asio_service(1);
+  std::shared_ptr<TimerWheel> wheel(
+      TimerWheel::MakeShared(asio_service.service(), std::chrono::milliseconds(1)));
+  const int kTimerCount(200);
+  std::atomic<int> remaining(kTimerCount);
+  std::atomic<int> early(0);
+  std::promise<void> done;
+  for (int i(0); i != kTimerCount; ++i) {
+    const auto delay(std::chrono::milliseconds(1 + (i % 50)));
+    const auto due(std::chrono::steady_clock::now() + delay);
+    wheel->Schedule(delay, [&, due] {
+      if (std::chrono::steady_clock::now() < due)
+        ++early;
+      if (--remaining == 0)
+        done.set_value();
+    });
+  }
+  ASSERT_EQ(std::future_status::ready, done.get_future().wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(0, early);
+  EXPECT_EQ(0U, wheel->size());
+
+  // An idle wheel starts ticking again when a timer is added, and destroying the wheel abandons
+  // its timers.
+  std::promise<void> restarted;
+  wheel->Schedule(std::chrono::milliseconds(5), [&] { restarted.set_value(); });
+  EXPECT_EQ(std::future_status::ready,
+            restarted.get_future().wait_for(std::chrono::seconds(10)));
+  wheel->Schedule(std::chrono::hours(1), [] { ADD_FAILURE() << "Abandoned timer ran"; });
+  wheel.reset();
+  asio_service.Stop();
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
@@ -0,0 +1,146 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/trace.h"
+
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/active.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace trace {
+
+namespace test {
+
+class TraceTest : public testing::Test {
+ protected:
+  TraceTest() {
+    SetCapacity(1024);
+    Enable();
+  }
+  ~TraceTest() { Enable(false); }
+};
+
+TEST_F(TraceTest, BEH_NestedSpans) {
+  EXPECT_FALSE(CurrentContext().IsValid());
+  SpanContext outer_context, inner_context;
+  {
+    Span outer("outer");
+    outer_context = outer.Context();
+    EXPECT_EQ(outer_context.span_id, CurrentContext().span_id);
+    {
+      Span inner("inner");
+      inner_context = inner.Context();
+      EXPECT_EQ(inner_context.span_id, CurrentContext().span_id);
+    }
+    EXPECT_EQ(outer_context.span_id, CurrentContext().span_id);
+  }
+  EXPECT_FALSE(CurrentContext().IsValid());
+  EXPECT_EQ(outer_context.trace_id, inner_context.trace_id);
+  EXPECT_NE(outer_context.span_id, inner_context.span_id);
+
+  const std::vector<SpanRecord> spans(RecordedSpans());
+  ASSERT_EQ(2U, spans.size());
+  // Spans are recorded as they end, so the inner one comes first.
+  EXPECT_EQ(std::string("inner"), spans[0].name);
+  EXPECT_EQ(outer_context.span_id, spans[0].parent_span_id);
+  EXPECT_EQ(std::string("outer"), spans[1].name);
+  EXPECT_EQ(0U, spans[1].parent_span_id);
+  EXPECT_LE(spans[1].start, spans[0].start);
+  EXPECT_GE(spans[1].duration, spans[0].duration);
+}
+
+TEST_F(TraceTest, BEH_Disabled) {
+  Enable(false);
+  {
+    Span span("ignored");
+    EXPECT_FALSE(span.Context().IsValid());
+    EXPECT_FALSE(CurrentContext().IsValid());
+  }
+  RecordSpan("ignored", SpanContext(1, 2), std::chrono::steady_clock::now(),
+             std::chrono::steady_clock::now());
+  EXPECT_TRUE(RecordedSpans().empty());
+}
+
+TEST_F(TraceTest, BEH_Propagation) {
+  SpanContext root_context;
+  {
+    Span root("root");
+    root_context = root.Context();
+    // Via BindContext to a new thread.
+    auto bound(BindContext([] {
+      Span child("bound child");
+      return CurrentContext();
+    }));
+    std::async(std::launch::async, bound).get();
+    // Via Active::Send.
+    Active active;
+    std::promise<SpanContext> sent_context;
+    active.Send([&] { sent_context.set_value(CurrentContext()); });
+    EXPECT_EQ(root_context.span_id, sent_context.get_future().get().span_id);
+  }
+  // A functor sent without a context runs without one.
+  {
+    Active active;
+    std::promise<bool> valid;
+    active.Send([&] { valid.set_value(CurrentContext().IsValid()); });
+    EXPECT_FALSE(valid.get_future().get());
+  }
+
+  const std::vector<SpanRecord> spans(RecordedSpans());
+  ASSERT_EQ(2U, spans.size());
+  EXPECT_EQ(std::string("bound child"), spans[0].name);
+  EXPECT_EQ(root_context.trace_id, spans[0].trace_id);
+  EXPECT_EQ(root_context.span_id, spans[0].parent_span_id);
+  EXPECT_NE(spans[0].thread, spans[1].thread);
+}
+
+TEST_F(TraceTest, BEH_RingBufferWrapsAndExports) {
+  SetCapacity(8);
+  const SpanContext parent(1, 2);
+  const auto start(std::chrono::steady_clock::now());
+  for (int i(0); i != 20; ++i)
+    RecordSpan("recorded", parent, start, start + std::chrono::microseconds(i));
+  const std::vector<SpanRecord> spans(RecordedSpans());
+  ASSERT_EQ(8U, spans.size());
+  // The oldest spans have been overwritten.
+  for (size_t i(0); i != spans.size(); ++i)
+    EXPECT_EQ((12 + static_cast<int64_t>(i)) * 1000, spans[i].duration);
+
+  std::ostringstream output;
+  WriteChromeTrace(std::vector<SpanRecord>(spans.begin(), spans.begin() + 1), output);
+  const std::string json(output.str());
+  EXPECT_EQ(0U, json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n{\"name\":\"recorded\""))
+      << json;
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\"")) << json;
+  EXPECT_NE(std::string::npos, json.find("\"dur\":12.000")) << json;
+  EXPECT_NE(std::string::npos, json.find("\"trace_id\":\"1\",\"span_id\":\"")) << json;
+  EXPECT_NE(std::string::npos, json.find("\"parent_span_id\":\"2\"}}\n]}\n")) << json;
+}
+
+}  // namespace test
+
+}  // namespace trace
+
+}  // namespace maidsafe
@@ -0,0 +1,99 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tree_hash.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+namespace test {
+
+namespace {
+
+const size_t kLeafSize(TreeSHA512::kLeafSize);
+
+std::string Leaf(const std::string& input) { return Hash<SHA512>('\0' + input).string(); }
+
+std::string Parent(const std::string& left, const std::string& right) {
+  return Hash<SHA512>('\1' + left + right).string();
+}
+
+std::string Incremental(const std::string& input) {
+  Hasher<TreeSHA512> hasher;
+  size_t position(0);
+  while (position != input.size()) {
+    const size_t size(std::min<size_t>(RandomUint32() % (2 * kLeafSize), input.size() - position));
+    hasher.Update(reinterpret_cast<const byte*>(input.data()) + position, size);
+    position += size;
+  }
+  const auto digest(hasher.Final());
+  return std::string(digest.string().begin(), digest.string().end());
+}
+
+}  // unnamed namespace
+
+TEST(TreeHashTest, BEH_TreeShape) {
+  EXPECT_EQ(Leaf(""), Hash<TreeSHA512>(std::string()).string());
+  std::string input(RandomString(kLeafSize));
+  EXPECT_EQ(Leaf(input), Hash<TreeSHA512>(input).string());
+
+  // Build 5 leaves; the tree is ((L0 L1) (L2 L3)) L4.
+  std::vector<std::string> leaves;
+  for (int i(0); i != 4; ++i)
+    leaves.push_back(RandomString(kLeafSize));
+  leaves.push_back(RandomString(1 + RandomUint32() % kLeafSize));
+  input.clear();
+  for (const auto& leaf : leaves)
+    input += leaf;
+
+  EXPECT_EQ(Parent(Leaf(leaves[0]), Leaf(leaves[1])),
+            Hash<TreeSHA512>(input.substr(0, 2 * kLeafSize)).string());
+  EXPECT_EQ(Parent(Parent(Leaf(leaves[0]), Leaf(leaves[1])), Leaf(leaves[2])),
+            Hash<TreeSHA512>(input.substr(0, 3 * kLeafSize)).string());
+  const std::string left(
+      Parent(Parent(Leaf(leaves[0]), Leaf(leaves[1])), Parent(Leaf(leaves[2]), Leaf(leaves[3]))));
+  EXPECT_EQ(left, Hash<TreeSHA512>(input.substr(0, 4 * kLeafSize)).string());
+  EXPECT_EQ(Parent(left, Leaf(leaves[4])), Hash<TreeSHA512>(input).string());
+}
+
+TEST(TreeHashTest, BEH_IncrementalMatchesOneShot) {
+  for (const size_t size : {size_t(0), size_t(1), kLeafSize - 1, kLeafSize, kLeafSize + 1,
+                            3 * kLeafSize, 7 * kLeafSize + 13, 33 * kLeafSize}) {
+    SCOPED_TRACE(size);
+    const std::string input(RandomString(size));
+    const std::string one_shot(Hash<TreeSHA512>(input).string());
+    EXPECT_EQ(one_shot, Incremental(input));
+    // The digest of a byte string is an Identity, as for Hash<SHA512>.
+    const Identity id(Hash<TreeSHA512>(std::vector<byte>(input.begin(), input.end())));
+    EXPECT_EQ(one_shot, std::string(id.string().begin(), id.string().end()));
+  }
+}
+
+}  // namespace test
+
+}  // namespace crypto
+
+}  // namespace maidsafe
@@ -19,9 +19,11 @@
 #include "maidsafe/common/utils.h"
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <cstdlib>
 #include <cwchar>
+#include <iterator>
 #include <set>
 #include <thread>
 #include <vector>
@@ -269,6 +271,38 @@ TEST(UtilsTest, BEH_RandomStringSingleThread) {
   }
 }
 
+TEST(UtilsTest, BEH_FillRandomBytes) {
+  const byte kSentinel(0xa5);
+  for (size_t size(0); size != 20; ++size) {
+    std::vector<byte> buffer(size + 1, kSentinel);
+    FillRandomBytes(buffer.data(), size);
+    EXPECT_EQ(kSentinel, buffer.back());
+    buffer.assign(size + 1, kSentinel);
+    FillRandomAlphaNumericBytes(buffer.data(), size);
+    EXPECT_EQ(kSentinel, buffer.back());
+    for (size_t i(0); i != size; ++i)
+      EXPECT_NE(0, isalnum(buffer[i])) << static_cast<int>(buffer[i]);
+  }
+
+  // Large fills use every alphanumeric character.
+  std::vector<byte> large(RandomAlphaNumericBytes(100000));
+  std::sort(large.begin(), large.end());
+  large.erase(std::unique(large.begin(), large.end()), large.end());
+  EXPECT_EQ(62U, large.size());
+
+  // Reseeding the shared generator reseeds each thread's generator.
+  const uint32_t seed(detail::random_number_generator_seed());
+  detail::set_random_number_generator_seed(seed);
+  const std::string first(RandomString(64));
+  const std::string first_alpha_numeric(RandomAlphaNumericString(1001));
+  detail::set_random_number_generator_seed(seed);
+  EXPECT_EQ(first, RandomString(64));
+  EXPECT_EQ(first_alpha_numeric, RandomAlphaNumericString(1001));
+  std::string other_thread;
+  std::thread([&] { other_thread = RandomString(64); }).join();
+  EXPECT_NE(first, other_thread);
+}
+
 std::string WstringToStringOldMethod(const std::wstring& input) {
   const std::locale kLocale("");
   std::string string_buffer(input.size(), 0);
@@ -322,11 +356,45 @@ TEST(UtilsTest, BEH_StringToWstring) {
 #endif
 }
 
+TEST(UtilsTest, BEH_XorInto) {
+  // Sizes either side of the SIMD and word widths, and one large enough to be split across threads.
+  for (const std::size_t size : {0, 1, 7, 8, 15, 16, 17, 100, 5 * 1024 * 1024 + 3}) {
+    const std::vector<byte> lhs(RandomBytes(size)), rhs(RandomBytes(size));
+    std::vector<byte> expected(size);
+    for (std::size_t i(0); i != size; ++i)
+      expected[i] = lhs[i] ^ rhs[i];
+
+    std::vector<byte> result(lhs);
+    XorInto(result, rhs);
+    EXPECT_EQ(expected, result);
+    result = lhs;
+    XorInto(result, rhs, true);
+    EXPECT_EQ(expected, result);
+    EXPECT_EQ(expected, lhs ^ rhs);
+    XorInto(result, rhs, true);
+    EXPECT_EQ(lhs, result);
+  }
+
+  std::string text(RandomString(33));
+  const std::string original(text);
+  XorInto(text, original);
+  EXPECT_EQ(std::string(33, '\0'), text);
+  EXPECT_THROW(XorInto(text, RandomString(32)), common_error);
+  EXPECT_THROW(RandomString(3) ^ RandomString(4), common_error);
+}
+
 TEST(UtilsTest, BEH_TimeFunctions) {
   uint64_t ms_since_epoch(GetTimeStamp());
   auto now(bptime::microsec_clock::universal_time());
   auto from_timestamp(TimeStampToPtime(ms_since_epoch));
   EXPECT_LE((now - from_timestamp), bptime::milliseconds(2));
+
+  // The coarse timestamp can lag by a little over kCoarseClockResolution, or more if the thread
+  // refreshing it is starved, so only check it's in the right region.
+  const uint64_t coarse_before(GetCoarseTimeStamp());
+  const uint64_t precise(GetTimeStamp());
+  EXPECT_LE(coarse_before, precise + 1);
+  EXPECT_LE(precise, coarse_before + 1000);
 }
 
 TEST(UtilsTest, FUNC_RandomNumberGen) {
@@ -385,6 +453,45 @@ TEST(UtilsTest, BEH_ReadFileandWriteFile) {
   EXPECT_EQ(file_content, *read_result3);
 }
 
+TEST(UtilsTest, BEH_MapFileAndWriteFileOptions) {
+  TestPath test_path(CreateTestPath("MaidSafe_TestUtils"));
+  const fs::path file_path(*test_path / "file.dat");
+  EXPECT_FALSE(MapFile(file_path));
+
+  // Every combination of options writes the same contents, including sizes which aren't multiples
+  // of the direct I/O block size.
+  for (const size_t size : {size_t(0), size_t(1), size_t(4097), size_t(3 * 1024 * 1024 + 5)}) {
+    const std::vector<byte> content(RandomBytes(size));
+    for (int combination(0); combination < 16; ++combination) {
+      WriteFileOptions options;
+      options.durability = (combination & 1) ? WriteFileOptions::Durability::kData
+                                             : WriteFileOptions::Durability::kNone;
+      options.atomic_replace = (combination & 2) != 0;
+      options.preallocate = (combination & 4) != 0;
+      options.direct_io = (combination & 8) != 0;
+      ASSERT_TRUE(WriteFile(file_path, content, options));
+      ASSERT_EQ(size, fs::file_size(file_path));
+      boost::expected<MappedFile, common_error> mapped(MapFile(file_path));
+      ASSERT_TRUE(!!mapped);
+      EXPECT_EQ(content, std::vector<byte>(mapped->begin(), mapped->end()));
+    }
+  }
+  // No temporary files are left behind, even by failed writes.
+  WriteFileOptions atomic;
+  atomic.atomic_replace = true;
+  EXPECT_FALSE(WriteFile(*test_path / "missing" / "file.dat", RandomBytes(10), atomic));
+  EXPECT_EQ(1, std::distance(fs::directory_iterator(*test_path), fs::directory_iterator()));
+
+  MappedFile moved;
+  {
+    boost::expected<MappedFile, common_error> mapped(MapFile(file_path));
+    ASSERT_TRUE(!!mapped);
+    moved = std::move(*mapped);
+    EXPECT_TRUE(mapped->empty());
+  }
+  EXPECT_EQ(3 * 1024 * 1024 + 5U, moved.size());
+}
+
 TEST(UtilsTest, BEH_Sleep) {
   bptime::ptime first_time(bptime::microsec_clock::universal_time());
   bptime::ptime second_time(bptime::microsec_clock::universal_time());
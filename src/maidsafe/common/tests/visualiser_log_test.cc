@@ -55,24 +55,27 @@ class VisualiserLogTest : public ::testing::Test {
   }
 
   void DebugPrint(const log::VisualiserLogMessage& vlog) {
-    LOG(kVerbose) << "\tts:                   \"" << vlog.kTimestamp_ << '\"';
-    LOG(kVerbose) << "\tvault_id:             \"" << vlog.kVaultId_ << '\"';
-    LOG(kVerbose) << "\tsession_id:           \"" << vlog.kSessionId_ << '\"';
-    LOG(kVerbose) << "\tpersona_id:           \"" << vlog.kPersonaId_.value << '\"';
-    LOG(kVerbose) << "\taction_id:            \"" << vlog.kActionId_.value << '\"';
-    if (vlog.kValue1_.size() == crypto::SHA512::DIGESTSIZE)
-      LOG(kVerbose) << "\tvalue1 (hex encoded): \"" << hex::Encode(vlog.kValue1_) << '\"';
-    else
-      LOG(kVerbose) << "\tvalue1 (unencoded):   \"" << vlog.kValue1_ << '\"';
-    LOG(kVerbose) << "\tvalue2 (hex encoded): \"" << hex::Encode(vlog.kValue2_) << "\"\n";
+    const auto& record(vlog.record_);
+    LOG(kVerbose) << "\tts:                   \"" << log::detail::GetUTCTime(record.timestamp)
+                  << '\"';
+    LOG(kVerbose) << "\tvault_id:             \"" << *record.vault_id << '\"';
+    LOG(kVerbose) << "\tsession_id:           \"" << *record.session_id << '\"';
+    if (record.persona_id.IsInitialised())
+      LOG(kVerbose) << "\tpersona_id:           \"" << record.persona_id.Value() << '\"';
+    LOG(kVerbose) << "\taction_id:            \"" << record.action_id.Value() << '\"';
+    LOG(kVerbose) << "\tvalue1:               \"" << record.value1.ToString(false) << '\"';
+    LOG(kVerbose) << "\tvalue2:               \"" << record.value2.ToString(false) << "\"\n";
   }
 
   std::unique_ptr<on_scope_exit> GetScopedSessionIdInvalidator() {
-    const std::string kOriginalSessionId{log::Logging::Instance().VlogSessionId()};
-    auto scoped_invalidator(maidsafe::make_unique<on_scope_exit>([kOriginalSessionId] {
-      log::Logging::Instance().visualiser_.session_id = kOriginalSessionId;
+    auto original_session_id(log::Logging::Instance().SharedVlogSessionId());
+    auto scoped_invalidator(maidsafe::make_unique<on_scope_exit>([original_session_id] {
+      log::Logging::Instance().visualiser_.session_id = original_session_id;
     }));
-    log::Logging::Instance().visualiser_.session_id[0] = '6';
+    std::string invalid_session_id(*original_session_id);
+    invalid_session_id[0] = '6';
+    log::Logging::Instance().visualiser_.session_id =
+        std::make_shared<const std::string>(invalid_session_id);
     return std::move(scoped_invalidator);
   }
 
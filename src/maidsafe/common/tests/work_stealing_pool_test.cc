@@ -0,0 +1,94 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace test {
+
+TEST(WorkStealingPoolTest, BEH_Construct) {
+  EXPECT_THROW(WorkStealingPool(0), maidsafe_error);
+  WorkStealingPool default_pool;
+  EXPECT_GE(default_pool.ThreadCount(), 1U);
+  WorkStealingPool pool(3);
+  EXPECT_EQ(3U, pool.ThreadCount());
+}
+
+TEST(WorkStealingPoolTest, BEH_DrainOnDestruction) {
+  const int kFunctorCount(1000);
+  std::atomic<int> run_count(0);
+  {
+    WorkStealingPool pool(4);
+    for (int i(0); i != kFunctorCount; ++i)
+      pool.Send([&] { ++run_count; });
+  }
+  EXPECT_EQ(kFunctorCount, run_count);
+}
+
+TEST(WorkStealingPoolTest, BEH_Submit) {
+  WorkStealingPool pool(2);
+  auto result(pool.Submit([] { return 42; }));
+  EXPECT_EQ(42, result.get());
+  auto failure(pool.Submit([]() -> int { throw std::runtime_error("failed"); }));
+  EXPECT_THROW(failure.get(), std::runtime_error);
+  auto nothing(pool.Submit([] {}));
+  EXPECT_NO_THROW(nothing.get());
+}
+
+TEST(WorkStealingPoolTest, BEH_Stealing) {
+  const size_t kThreadCount(4);
+  WorkStealingPool pool(kThreadCount);
+  // A single functor sends all the others from a worker thread, so they all start on that worker's
+  // deque and can only run elsewhere by being stolen.
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  std::vector<std::future<void>> results;
+  std::promise<void> sent;
+  pool.Send([&] {
+    for (int i(0); i != 100; ++i) {
+      results.emplace_back(pool.Submit([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mutex);
+        thread_ids.insert(std::this_thread::get_id());
+      }));
+    }
+    sent.set_value();
+  });
+  sent.get_future().get();
+  for (auto& result : results)
+    result.get();
+  EXPECT_GT(thread_ids.size(), 1U);
+  EXPECT_GT(pool.steal_count(), 0U);
+}
+
+}  // namespace test
+
+}  // namespace maidsafe
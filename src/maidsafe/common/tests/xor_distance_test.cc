@@ -0,0 +1,72 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/xor_distance.h"
+
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace test {
+
+TEST(XorDistanceTest, BEH_KernelsAgree) {
+  const std::vector<XorDistanceKernels> kernels(SupportedXorDistanceKernels());
+  ASSERT_LE(2U, kernels.size());
+  EXPECT_STREQ(kernels.back().name, SelectedXorDistanceKernels().name);
+  const XorDistanceKernels& reference(kernels.front());
+
+  // Include IDs which differ from 'base' only in each single bit, and an ID equal to 'base'.
+  const Identity base(MakeIdentity());
+  std::vector<std::vector<byte>> ids(1, std::vector<byte>(base.string().begin(),
+                                                          base.string().end()));
+  for (std::size_t bit(0); bit != identity_size * 8; ++bit) {
+    ids.push_back(ids.front());
+    ids.back()[bit / 8] ^= static_cast<byte>(0x80 >> (bit % 8));
+  }
+  ids.push_back(ids.front());
+  for (int i(0); i != 20; ++i)
+    ids.push_back(RandomBytes(identity_size));
+
+  for (const auto& kernel : kernels) {
+    SCOPED_TRACE(kernel.name);
+    for (const auto& id1 : ids) {
+      EXPECT_EQ(reference.common_leading_bits(id1.data(), ids.front().data()),
+                kernel.common_leading_bits(id1.data(), ids.front().data()));
+      for (const auto& id2 : ids) {
+        EXPECT_EQ(reference.common_leading_bits(id1.data(), id2.data()),
+                  kernel.common_leading_bits(id1.data(), id2.data()));
+        EXPECT_EQ(reference.closer_to_target(id1.data(), id2.data(), base.data()),
+                  kernel.closer_to_target(id1.data(), id2.data(), base.data()));
+        EXPECT_EQ(reference.closer_to_target(id1.data(), id2.data(), ids.back().data()),
+                  kernel.closer_to_target(id1.data(), id2.data(), ids.back().data()));
+      }
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace detail
+
+}  // namespace maidsafe
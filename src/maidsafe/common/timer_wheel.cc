@@ -0,0 +1,271 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/timer_wheel.h"
+
+#include <utility>
+
+#include "asio/error.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace {
+
+const unsigned kSlotBits = 6;
+const uint64_t kSlotMask = (1U << kSlotBits) - 1;
+const unsigned kLevels = 4;
+// Timers due further ahead than this are parked in the top level until they come within range.
+const uint64_t kRange = uint64_t(1) << (kSlotBits * kLevels);
+
+}  // unnamed namespace
+
+const uint32_t TimerWheel::kNone;
+
+std::shared_ptr<TimerWheel> TimerWheel::MakeShared(asio::io_service& service,
+                                                   std::chrono::steady_clock::duration tick) {
+  if (tick <= std::chrono::steady_clock::duration::zero()) {
+    LOG(kError) << "Timer wheel tick must be positive.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+  return std::shared_ptr<TimerWheel>{new TimerWheel{service, tick}};
+}
+
+TimerWheel::TimerWheel(asio::io_service& service, std::chrono::steady_clock::duration tick)
+    : tick_(tick),
+      origin_(std::chrono::steady_clock::now()),
+      mutex_(),
+      nodes_(),
+      free_list_(kNone),
+      slots_(),
+      current_tick_(0),
+      size_(0),
+      timer_(service),
+      timer_running_(false),
+      armed_tick_(0) {
+  static_assert(64 == (1U << kSlotBits) && 4 == kLevels, "Slot array size is out of step.");
+  slots_.fill(kNone);
+}
+
+TimerWheel::~TimerWheel() {}
+
+TimerWheel::TimerId TimerWheel::Schedule(std::chrono::steady_clock::duration delay,
+                                         Callback callback) {
+  if (!callback)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  std::lock_guard<std::mutex> lock{mutex_};
+  uint32_t index(free_list_);
+  if (index == kNone) {
+    if (nodes_.size() == kNone)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+    index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+  } else {
+    free_list_ = nodes_[index].next;
+  }
+  Node& node(nodes_[index]);
+  node.callback = std::move(callback);
+  node.expiry = ExpiryTick(delay);
+  InsertLocked(index);
+  ++size_;
+  StartTimerLocked();
+  return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::Reschedule(TimerId id, std::chrono::steady_clock::duration delay) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  const uint32_t index(FindLocked(id));
+  if (index == kNone)
+    return false;
+  UnlinkLocked(index);
+  nodes_[index].expiry = ExpiryTick(delay);
+  InsertLocked(index);
+  StartTimerLocked();
+  return true;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+  Callback callback;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const uint32_t index(FindLocked(id));
+    if (index == kNone)
+      return false;
+    UnlinkLocked(index);
+    // The callback is destroyed outside the lock, in case it holds the last reference to an object
+    // which uses this wheel.
+    callback = std::move(nodes_[index].callback);
+    ReleaseLocked(index);
+    --size_;
+  }
+  return true;
+}
+
+size_t TimerWheel::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return size_;
+}
+
+size_t TimerWheel::Advance(std::chrono::steady_clock::time_point now) {
+  std::vector<Callback> due;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const uint64_t target(TickAt(now));
+    while (size_ != 0 && current_tick_ <= target) {
+      // Entering a new span of a level brings that span's timers down from the level above.
+      const uint64_t tick(current_tick_);
+      for (unsigned level(1); level != kLevels; ++level) {
+        if (((tick >> (kSlotBits * (level - 1))) & kSlotMask) != 0)
+          break;
+        CascadeLocked(static_cast<uint32_t>((level << kSlotBits) |
+                                            ((tick >> (kSlotBits * level)) & kSlotMask)));
+      }
+      uint32_t& head(slots_[tick & kSlotMask]);
+      while (head != kNone) {
+        const uint32_t index(head);
+        UnlinkLocked(index);
+        due.emplace_back(std::move(nodes_[index].callback));
+        ReleaseLocked(index);
+        --size_;
+      }
+      ++current_tick_;
+    }
+    // With nothing pending, the intervening ticks needn't be stepped through.
+    if (size_ == 0 && current_tick_ <= target)
+      current_tick_ = target + 1;
+    StartTimerLocked();
+  }
+  for (auto& callback : due)
+    callback();
+  return due.size();
+}
+
+uint64_t TimerWheel::TickAt(std::chrono::steady_clock::time_point time) const {
+  if (time <= origin_)
+    return 0;
+  return static_cast<uint64_t>((time - origin_) / tick_);
+}
+
+uint64_t TimerWheel::ExpiryTick(std::chrono::steady_clock::duration delay) const {
+  // Rounded up, so the timer never fires early.
+  const std::chrono::steady_clock::duration due(std::chrono::steady_clock::now() + delay - origin_);
+  if (due <= std::chrono::steady_clock::duration::zero())
+    return current_tick_;
+  const uint64_t expiry(
+      static_cast<uint64_t>((due + tick_ - std::chrono::steady_clock::duration(1)) / tick_));
+  return expiry < current_tick_ ? current_tick_ : expiry;
+}
+
+uint32_t TimerWheel::FindLocked(TimerId id) const {
+  const uint32_t index(static_cast<uint32_t>(id));
+  if (index >= nodes_.size())
+    return kNone;
+  const Node& node(nodes_[index]);
+  if (node.generation != static_cast<uint32_t>(id >> 32) || node.slot == kNone)
+    return kNone;
+  return index;
+}
+
+void TimerWheel::InsertLocked(uint32_t index) {
+  Node& node(nodes_[index]);
+  const uint64_t delta(node.expiry - current_tick_);
+  uint32_t slot(0);
+  if (delta >= kRange) {
+    const uint64_t parked(current_tick_ + kRange - 1);
+    slot = static_cast<uint32_t>(((kLevels - 1) << kSlotBits) |
+                                 ((parked >> (kSlotBits * (kLevels - 1))) & kSlotMask));
+  } else {
+    unsigned level(0);
+    while (delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+      ++level;
+    slot = static_cast<uint32_t>((level << kSlotBits) |
+                                 ((node.expiry >> (kSlotBits * level)) & kSlotMask));
+  }
+  node.slot = slot;
+  node.previous = kNone;
+  node.next = slots_[slot];
+  if (node.next != kNone)
+    nodes_[node.next].previous = index;
+  slots_[slot] = index;
+}
+
+void TimerWheel::UnlinkLocked(uint32_t index) {
+  Node& node(nodes_[index]);
+  if (node.previous == kNone)
+    slots_[node.slot] = node.next;
+  else
+    nodes_[node.previous].next = node.next;
+  if (node.next != kNone)
+    nodes_[node.next].previous = node.previous;
+  node.previous = node.next = node.slot = kNone;
+}
+
+void TimerWheel::ReleaseLocked(uint32_t index) {
+  Node& node(nodes_[index]);
+  ++node.generation;
+  if (node.generation == 0)
+    node.generation = 1;
+  node.next = free_list_;
+  free_list_ = index;
+}
+
+void TimerWheel::CascadeLocked(uint32_t slot) {
+  uint32_t index(slots_[slot]);
+  slots_[slot] = kNone;
+  while (index != kNone) {
+    const uint32_t next(nodes_[index].next);
+    InsertLocked(index);
+    index = next;
+  }
+}
+
+void TimerWheel::StartTimerLocked() {
+  if (size_ == 0)
+    return;
+  // Wake at the next tick with a timer due, or failing that at the next cascade, so that a wheel
+  // holding only distant timers doesn't wake every tick.
+  uint64_t wake(current_tick_);
+  const uint64_t cascade((current_tick_ | kSlotMask) + 1);
+  while (wake != cascade && slots_[wake & kSlotMask] == kNone)
+    ++wake;
+  if (timer_running_ && armed_tick_ <= wake)
+    return;
+  timer_running_ = true;
+  armed_tick_ = wake;
+  timer_.expires_at(origin_ + tick_ * wake);
+  std::weak_ptr<TimerWheel> weak_this(shared_from_this());
+  timer_.async_wait([weak_this](const std::error_code& ec) {
+    if (ec == asio::error::operation_aborted)
+      return;
+    std::shared_ptr<TimerWheel> this_ptr(weak_this.lock());
+    if (this_ptr)
+      this_ptr->OnTimer();
+  });
+}
+
+void TimerWheel::OnTimer() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    timer_running_ = false;
+  }
+  Advance(std::chrono::steady_clock::now());
+}
+
+}  // namespace maidsafe
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <future>
 #include <numeric>
 #include <string>
 
@@ -40,11 +41,16 @@ namespace tools {
 
 const std::string kDefaultConfigFilename{"address_space_tool.conf"};
 
-int Test::Accumulate(std::vector<Node>::const_iterator first,
-                     std::vector<Node>::const_iterator last, const Identity& target, int& highest,
-                     int& lowest) const {
-  return std::accumulate(first, last, 0, [&](int running_total, const Node& node) -> int {
-    int common_leading_bits{maidsafe::CommonLeadingBits(node.id, target)};
+Test::Test(Config config)
+    : config_(std::move(config)),
+      nodes_(),
+      pool_(config_.threads != 0 ? config_.threads : Concurrency()) {}
+
+int Test::Accumulate(Neighbourhood::const_iterator first, Neighbourhood::const_iterator last,
+                     const Identity& target, int& highest, int& lowest) const {
+  return std::accumulate(first, last, 0, [&](int running_total, const Neighbourhood::value_type&
+                                                                     node) -> int {
+    int common_leading_bits{maidsafe::CommonLeadingBits(node->first, target)};
     if (common_leading_bits > highest)
       highest = common_leading_bits;
     if (common_leading_bits < lowest)
@@ -66,83 +72,84 @@ int Test::CommonLeadingBits(int highest, int lowest, int sum, int count) const {
   }
 }
 
-int Test::GroupCommonLeadingBits(size_t group_size) const {
-  if (config_.algorithm == CommonLeadingBitsAlgorithm::kClosest)
-    return maidsafe::CommonLeadingBits(all_nodes_[0].id, all_nodes_[1].id);
-  if (all_nodes_.size() == 1)
+int Test::GroupCommonLeadingBits(const Neighbourhood& neighbourhood, size_t group_size) const {
+  if (group_size == 1)
     return 0;
+  if (config_.algorithm == CommonLeadingBitsAlgorithm::kClosest)
+    return maidsafe::CommonLeadingBits(neighbourhood[0]->first, neighbourhood[1]->first);
 
   int sum{0}, count{0}, highest{0}, lowest{512};
-  auto itr(std::begin(all_nodes_));
-  const auto end_itr(std::begin(all_nodes_) + group_size);
+  auto itr(std::begin(neighbourhood));
+  const auto end_itr(std::begin(neighbourhood) + group_size);
   while (itr != end_itr - 1) {
-    sum += Accumulate(itr + 1, end_itr, itr->id, highest, lowest);
+    sum += Accumulate(itr + 1, end_itr, (*itr)->first, highest, lowest);
     ++itr;
     count += static_cast<int>(std::distance(itr, end_itr));
   }
   return CommonLeadingBits(highest, lowest, sum, count);
 }
 
-int Test::CandidateCommonLeadingBits(const Identity& candidate_node, size_t group_size) const {
+int Test::CandidateCommonLeadingBits(const Identity& candidate_node,
+                                     const Neighbourhood& neighbourhood, size_t group_size) const {
   if (config_.algorithm == CommonLeadingBitsAlgorithm::kClosest)
-    return maidsafe::CommonLeadingBits(all_nodes_[0].id, candidate_node);
+    return maidsafe::CommonLeadingBits(neighbourhood[0]->first, candidate_node);
 
   int highest{0}, lowest{512};
-  const auto end_itr(std::begin(all_nodes_) + group_size);
-  int sum{Accumulate(std::begin(all_nodes_), end_itr, candidate_node, highest, lowest)};
-  int count{static_cast<int>(std::distance(std::begin(all_nodes_), end_itr))};
-  return CommonLeadingBits(highest, lowest, sum, count);
+  const auto end_itr(std::begin(neighbourhood) + group_size);
+  int sum{Accumulate(std::begin(neighbourhood), end_itr, candidate_node, highest, lowest)};
+  return CommonLeadingBits(highest, lowest, sum, static_cast<int>(group_size));
 }
 
-void Test::UpdateRank(size_t group_size) {
-  std::for_each(std::begin(all_nodes_), std::begin(all_nodes_) + group_size, [](Node& node) {
-    node.rank = std::min(node.rank + (RandomInt32() % 20) + 10, 100);
-  });
+void Test::UpdateRank(const Neighbourhood& neighbourhood, size_t group_size) {
+  std::for_each(std::begin(neighbourhood), std::begin(neighbourhood) + group_size,
+                [](Neighbourhood::value_type node) {
+                  node->second.rank = std::min(node->second.rank + (RandomInt32() % 20) + 10, 100);
+                });
 }
 
-std::pair<int, int> Test::RankValues(size_t group_size) const {
+std::pair<int, int> Test::RankValues(const Neighbourhood& neighbourhood, size_t group_size) const {
   int close(0);
   int proximity(0);
 
-  std::for_each(std::begin(all_nodes_), std::begin(all_nodes_) + group_size,
-                [&close](const Node& node) { close += node.rank; });
-  std::for_each(std::begin(all_nodes_), std::begin(all_nodes_) + (group_size * 4),
-                [&proximity](const Node& node) { proximity += node.rank; });
+  std::for_each(std::begin(neighbourhood), std::begin(neighbourhood) + group_size,
+                [&close](Neighbourhood::value_type node) { close += node->second.rank; });
+  std::for_each(std::begin(neighbourhood), std::begin(neighbourhood) + (group_size * 4),
+                [&proximity](Neighbourhood::value_type node) { proximity += node->second.rank; });
   return {static_cast<int>(close / group_size), static_cast<int>(proximity / (group_size * 4))};
 }
 
-bool Test::RankAllowed(size_t group_size) const {
-  auto rank(RankValues(group_size));
+bool Test::RankAllowed(const Neighbourhood& neighbourhood, size_t group_size) const {
+  auto rank(RankValues(neighbourhood, group_size));
   return rank.first > rank.second;
 }
 
 void Test::DoAddNode(const Identity& node_id, bool good, int attempts) {
-  all_nodes_.emplace_back(node_id, good);
+  nodes_.Insert(node_id, NodeStatus(good));
   LOG(kInfo) << "Added a " << (good ? "good" : "bad") << " node after " << attempts
-             << " attempt(s) in a network of size " << all_nodes_.size() << '.';
+             << " attempt(s) in a network of size " << nodes_.size() << '.';
   total_attempts_ += attempts;
   good ? ++good_count_ : ++bad_count_;
 }
 
 void Test::AddNode(bool good) {
-  size_t group_size{std::min(static_cast<size_t>(config_.group_size), all_nodes_.size())};
+  size_t group_size{std::min(static_cast<size_t>(config_.group_size), nodes_.size())};
   int attempts{0};
   for (;;) {
     ++attempts;
     Identity node_id(MakeIdentity());
-    std::partial_sort(std::begin(all_nodes_), std::begin(all_nodes_) + group_size,
-                      std::end(all_nodes_), [&node_id](const Node& lhs, const Node& rhs) {
-      return CloserToTarget(lhs.id, rhs.id, node_id);
-    });
-    UpdateRank(group_size);
-    if (all_nodes_.size() > (config_.group_size * 4) && !RankAllowed(group_size))
+    // Only the candidate's neighbourhood is needed, so this is O(log n) rather than a scan of the
+    // whole network.
+    const Neighbourhood neighbourhood(nodes_.Closest(node_id, group_size * 4));
+    UpdateRank(neighbourhood, group_size);
+    if (nodes_.size() > (config_.group_size * 4) && !RankAllowed(neighbourhood, group_size))
       continue;
 
     if (config_.algorithm == CommonLeadingBitsAlgorithm::kNone)
       return DoAddNode(node_id, good, attempts);
 
-    int group_common_leading_bits{GroupCommonLeadingBits(group_size)};
-    int candidate_common_leading_bits{CandidateCommonLeadingBits(node_id, group_size)};
+    int group_common_leading_bits{GroupCommonLeadingBits(neighbourhood, group_size)};
+    int candidate_common_leading_bits{
+        CandidateCommonLeadingBits(node_id, neighbourhood, group_size)};
     if (candidate_common_leading_bits <
         static_cast<int>(group_common_leading_bits + config_.leeway))
       return DoAddNode(node_id, good, attempts);
@@ -150,8 +157,7 @@ void Test::AddNode(bool good) {
 }
 
 void Test::InitialiseNetwork() {
-  all_nodes_.clear();
-  all_nodes_.reserve(config_.initial_good_count);
+  nodes_.clear();
   // Add first node
   DoAddNode(MakeIdentity(), true, 1);
   // Add others
@@ -161,7 +167,7 @@ void Test::InitialiseNetwork() {
   output += std::to_string(config_.initial_good_count) + " good nodes";
   if (config_.algorithm != CommonLeadingBitsAlgorithm::kNone) {
     output += ", averaging ";
-    output += std::to_string(static_cast<double>(total_attempts_) / all_nodes_.size());
+    output += std::to_string(static_cast<double>(total_attempts_) / nodes_.size());
     output += " attempt(s) each.";
   } else {
     output += '.';
@@ -187,13 +193,32 @@ std::vector<Identity> Test::GetUniformlyDistributedTargetPoints() const {
   return steps;
 }
 
+template <typename Functor>
+void Test::ForEachChunk(size_t count, Functor functor) const {
+  const size_t chunk_count(ChunkCount(count));
+  std::vector<std::future<void>> results;
+  results.reserve(chunk_count);
+  for (size_t chunk(0); chunk < chunk_count; ++chunk) {
+    const size_t begin(count * chunk / chunk_count), end(count * (chunk + 1) / chunk_count);
+    results.emplace_back(pool_.Submit([=] { functor(chunk, begin, end); }));
+  }
+  for (auto& result : results)
+    result.get();
+}
+
+size_t Test::ChunkCount(size_t count) const {
+  // Use several chunks per thread so that work stealing can even out the load.
+  const size_t kChunksPerThread(4);
+  return std::min(count, pool_.ThreadCount() * kChunksPerThread);
+}
+
 BadGroup Test::GetBadGroup(const Identity& target_id) const {
-  std::vector<Node> bad_group{config_.group_size};
+  std::vector<Node> bad_group;
   // Get close group
-  std::partial_sort_copy(std::begin(all_nodes_), std::end(all_nodes_), std::begin(bad_group),
-                         std::end(bad_group), [&target_id](const Node& lhs, const Node& rhs) {
-    return CloserToTarget(lhs.id, rhs.id, target_id);
-  });
+  for (const auto* entry : nodes_.Closest(target_id, config_.group_size)) {
+    bad_group.emplace_back(entry->first, entry->second.good);
+    bad_group.back().rank = entry->second.rank;
+  }
   auto is_bad([](const Node& node) { return !node.good; });
   // Count bad nodes in close group and return the group if majority are bad
   if (static_cast<size_t>(std::count_if(std::begin(bad_group), std::end(bad_group), is_bad)) >=
@@ -214,9 +239,13 @@ std::vector<BadGroup> Test::InjectBadGroups(const std::vector<Identity>& steps)
 
     bad_groups.clear();
     AddNode(false);
-    // Iterate through evenly-spread target IDs
-    for (const auto& target_id : steps) {
-      auto new_bad_group(GetBadGroup(target_id));
+    // Check the evenly-spread target IDs in parallel, then merge the results in order
+    std::vector<BadGroup> candidates(steps.size());
+    ForEachChunk(steps.size(), [&](size_t /*chunk*/, size_t begin, size_t end) {
+      for (size_t i(begin); i < end; ++i)
+        candidates[i] = GetBadGroup(steps[i]);
+    });
+    for (auto& new_bad_group : candidates) {
       if (!new_bad_group.second.empty()) {
         // Only add if none of the bad nodes are already in a bad group
         bool should_add(true);
@@ -240,10 +269,10 @@ std::vector<BadGroup> Test::InjectBadGroups(const std::vector<Identity>& steps)
   if (config_.algorithm != CommonLeadingBitsAlgorithm::kNone) {
     TLOG(kRed) << ", averaging "
                << static_cast<double>(total_attempts_) /
-                      (all_nodes_.size() - config_.initial_good_count) << " attempt(s) each";
+                      (nodes_.size() - config_.initial_good_count) << " attempt(s) each";
   }
-  TLOG(kRed) << ".  Network population = " << all_nodes_.size()
-             << "  Attack = " << static_cast<double>(bad_count_) * 100 / all_nodes_.size()
+  TLOG(kRed) << ".  Network population = " << nodes_.size()
+             << "  Attack = " << static_cast<double>(bad_count_) * 100 / nodes_.size()
              << "%.\n";
   return bad_groups;
 }
@@ -260,30 +289,43 @@ void Test::ReportBadGroups(const std::vector<BadGroup>& bad_groups) const {
   }
 }
 
+std::vector<BadGroup> Test::GetLinkedBadGroups(Identity target_id) const {
+  std::vector<BadGroup> bad_groups;
+  for (size_t i(0); i < config_.bad_group_count; ++i) {
+    if (i > 0)  // Hash previous target to get new linked one
+      target_id = Identity(crypto::Hash<crypto::SHA512>(target_id.string()).string());
+    auto bad_group(GetBadGroup(target_id));
+    if (bad_group.second.empty())  // Not a bad group - start a new attempt
+      break;
+    bad_groups.emplace_back(std::move(bad_group));
+  }
+  return bad_groups;
+}
+
 void Test::CheckLinkedAddresses() const {
   if (!config_.total_random_attempts)
     return;
 
   LOG(kSuccess) << "Checking linked random addresses...";
-  size_t attempts(0), compromised_attempts(0);
-  std::vector<BadGroup> bad_groups;
-  while (attempts < config_.total_random_attempts) {
-    bad_groups.clear();
-    ++attempts;
-    Identity target_id(MakeIdentity());
-    for (size_t i(0); i < config_.bad_group_count; ++i) {
-      if (i > 0)  // Hash previous target to get new linked one
-        target_id = Identity(crypto::Hash<crypto::SHA512>(target_id.string()).string());
-      auto bad_group(GetBadGroup(target_id));
-      if (bad_group.second.empty())  // Not a bad group - start a new attempt
-        break;
-      bad_groups.emplace_back(std::move(bad_group));
+  // Each chunk of attempts records its compromised chains along with their attempt numbers, so
+  // that they can be reported in order once all chunks have finished.
+  using Chains = std::vector<std::pair<size_t, std::vector<BadGroup>>>;
+  std::vector<Chains> chains_per_chunk(ChunkCount(config_.total_random_attempts));
+  ForEachChunk(config_.total_random_attempts, [&](size_t chunk, size_t begin, size_t end) {
+    for (size_t attempt(begin); attempt < end; ++attempt) {
+      auto bad_groups(GetLinkedBadGroups(MakeIdentity()));
+      if (bad_groups.size() == config_.bad_group_count)
+        chains_per_chunk[chunk].emplace_back(attempt + 1, std::move(bad_groups));
     }
-    if (bad_groups.size() == config_.bad_group_count) {
+  });
+
+  size_t compromised_attempts(0);
+  for (const auto& chains : chains_per_chunk) {
+    for (const auto& chain : chains) {
       ++compromised_attempts;
-      LOG(kError) << "Got bad group chain of " << config_.bad_group_count << " after " << attempts
-                  << " linked random ID attempts.";
-      ReportBadGroups(bad_groups);
+      LOG(kError) << "Got bad group chain of " << config_.bad_group_count << " after "
+                  << chain.first << " linked random ID attempts.";
+      ReportBadGroups(chain.second);
     }
   }
   std::string output{
@@ -42,6 +42,8 @@
 
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/identity.h"
+#include "maidsafe/common/work_stealing_pool.h"
+#include "maidsafe/common/containers/xor_trie.h"
 
 namespace maidsafe {
 
@@ -90,13 +92,15 @@ struct Config {
   std::size_t good_added_per_bad{0};           // No. of good nodes added every time a bad node is
                                                // added
   CommonLeadingBitsAlgorithm algorithm{CommonLeadingBitsAlgorithm::kLowest};  // Described above
+  std::size_t threads{0};                      // Worker threads used to check target addresses
+                                               // (0 means one per hardware thread)
 
   template <typename Archive>
   void save(Archive& archive) const {
     archive(CEREAL_NVP(iterations), CEREAL_NVP(initial_good_count), CEREAL_NVP(initial_factor),
             CEREAL_NVP(group_size), CEREAL_NVP(majority_size), CEREAL_NVP(bad_group_count),
             CEREAL_NVP(total_random_attempts), CEREAL_NVP(leeway), CEREAL_NVP(good_added_per_bad),
-            CEREAL_NVP(algorithm));
+            CEREAL_NVP(algorithm), CEREAL_NVP(threads));
   }
 
   template <typename Archive, typename NameValuePair>
@@ -119,6 +123,7 @@ struct Config {
     load_optional_element(archive, CEREAL_NVP(leeway));
     load_optional_element(archive, CEREAL_NVP(good_added_per_bad));
     load_optional_element(archive, CEREAL_NVP(algorithm));
+    load_optional_element(archive, CEREAL_NVP(threads));
   }
 };
 
@@ -155,6 +160,7 @@ std::basic_ostream<Elem, Traits>& operator<<(std::basic_ostream<Elem, Traits>& o
       ostream << "INVALID VALUE";
   }
   ostream << '\n';
+  ostream << "\tthreads:               " << config.threads << '\n';
   return ostream;
 }
 
@@ -187,33 +193,45 @@ std::basic_ostream<Elem, Traits>& operator<<(std::basic_ostream<Elem, Traits>& o
   return ostream;
 }
 
+// The state of a node held in the simulated network, keyed by its ID.
+struct NodeStatus {
+  explicit NodeStatus(bool good_in) : good(good_in), rank(0) {}
+  bool good;
+  int rank;
+};
+
 typedef std::pair<Identity, std::vector<Node>> BadGroup;
 
 
 
 class Test {
  public:
-  explicit Test(Config config) : config_(std::move(config)), all_nodes_() {}
+  explicit Test(Config config);
   void Run();
 
  private:
-  int Accumulate(std::vector<Node>::const_iterator first, std::vector<Node>::const_iterator last,
+  // The entries closest to some target, ordered from closest.
+  typedef std::vector<XorTrie<NodeStatus>::value_type*> Neighbourhood;
+
+  int Accumulate(Neighbourhood::const_iterator first, Neighbourhood::const_iterator last,
                  const Identity& target, int& highest, int& lowest) const;
 
   int CommonLeadingBits(int highest, int lowest, int sum, int count) const;
 
-  // Requires first 'group_size' entries of 'g_all_nodes' to be sorted by closeness to target.
-  int GroupCommonLeadingBits(size_t group_size) const;
+  // Requires 'neighbourhood' to hold at least 'group_size' entries, the first 'group_size' of
+  // which form the close group.
+  int GroupCommonLeadingBits(const Neighbourhood& neighbourhood, size_t group_size) const;
 
-  // Requires first 'group_size' entries of 'g_all_nodes' to be sorted by closeness to
-  // 'candidate_node'.
-  int CandidateCommonLeadingBits(const Identity& candidate_node, size_t group_size) const;
+  // As above, where 'neighbourhood' is that of 'candidate_node'.
+  int CandidateCommonLeadingBits(const Identity& candidate_node,
+                                 const Neighbourhood& neighbourhood, size_t group_size) const;
 
-  void UpdateRank(size_t group_size);
+  void UpdateRank(const Neighbourhood& neighbourhood, size_t group_size);
 
-  std::pair<int, int> RankValues(size_t group_size) const;
+  // Returns the mean ranks of the close group and of the (4 * 'group_size') nearest nodes.
+  std::pair<int, int> RankValues(const Neighbourhood& neighbourhood, size_t group_size) const;
 
-  bool RankAllowed(size_t group_size) const;
+  bool RankAllowed(const Neighbourhood& neighbourhood, size_t group_size) const;
 
   void AddNode(bool good);
 
@@ -224,10 +242,22 @@ class Test {
   // Constructs a series of NodeIds spread evenly across address space
   std::vector<Identity> GetUniformlyDistributedTargetPoints() const;
 
+  // Splits [0, count) into contiguous chunks and runs 'functor(chunk_index, begin, end)' for each
+  // on 'pool_', returning once all have completed.
+  template <typename Functor>
+  void ForEachChunk(size_t count, Functor functor) const;
+
+  size_t ChunkCount(size_t count) const;
+
   // Returns group if >= g_config.majority_size are bad, else returns empty vector.  Returned group
-  // is default-sorted (i.e. not sorted close to target_id).
+  // is default-sorted (i.e. not sorted close to target_id).  Only reads 'nodes_', so can be called
+  // concurrently from the workers of 'pool_'.
   BadGroup GetBadGroup(const Identity& target_id) const;
 
+  // Returns the chain of bad groups managing 'target_id' and the addresses linked to it by
+  // successive hashing, stopping at the first which isn't bad or after 'g_config.bad_group_count'.
+  std::vector<BadGroup> GetLinkedBadGroups(Identity target_id) const;
+
   // Add bad nodes until we have 'g_config.bad_group_count' entirely separate bad close groups
   std::vector<BadGroup> InjectBadGroups(const std::vector<Identity>& steps);
 
@@ -236,10 +266,11 @@ class Test {
   void CheckLinkedAddresses() const;
 
   Config config_;
-  std::vector<Node> all_nodes_;
+  XorTrie<NodeStatus> nodes_;
   size_t total_attempts_{0};
   size_t good_count_{0};
   size_t bad_count_{0};
+  mutable WorkStealingPool pool_;
 };
 
 }  // namespace tools
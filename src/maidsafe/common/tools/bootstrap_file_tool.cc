@@ -25,10 +25,13 @@
 #include <limits>
 #include <string>
 
+#include "asio/ip/address.hpp"
+#include "asio/ip/udp.hpp"
 #include "boost/asio/ip/udp.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/bootstrap_file.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
@@ -76,13 +79,14 @@ class Choice : private MessagePolicy, private InputPolicy, private HandlePolicy
 };
 
 // Message Policies
-template <bool loading_file>
+template <bool loading_file, bool compact = false>
 class MessagePolicyGetPath {
  protected:
   virtual ~MessagePolicyGetPath() {}
   static void PrintCommandPreamble(int index) {
     TLOG(kDefaultColour) << "Enter " << index
-                         << (loading_file ? " to load an existing" : " to save to a")
+                         << (loading_file ? " to load an existing"
+                                          : (compact ? " to save to a compact" : " to save to a"))
                          << " bootstrap file\n";
   }
   void PrintMessage() const { TLOG(kDefaultColour) << "Enter path to bootstrap file >> "; }
@@ -288,6 +292,10 @@ class HandlePolicyLoadBootstrapFile {
     }
     try {
       maidsafe::NonEmptyString contents(maidsafe::ReadFile(bootstrap_file).value());
+      if (maidsafe::IsCompactBootstrap(contents.data(), contents.size())) {
+        LoadCompact(bootstrap_file, contents);
+        return;
+      }
       maidsafe::detail::BootstrapCereal parsed_endpoints;
 
       try {
@@ -313,12 +321,51 @@ class HandlePolicyLoadBootstrapFile {
     }
     TLOG(kGreen) << "\nLoaded " << bootstrap_file << "\n\n";
   }
+
+ private:
+  void LoadCompact(const fs::path& bootstrap_file, const maidsafe::NonEmptyString& contents) const {
+    std::vector<asio::ip::udp::endpoint> endpoints;
+    try {
+      endpoints = maidsafe::CompactBootstrapFile(contents.data(), contents.size()).Endpoints();
+    } catch (...) {
+      TLOG(kRed) << '\n' << bootstrap_file << " doesn't parse.\n\n";
+      return;
+    }
+    if (endpoints.empty()) {
+      TLOG(kRed) << '\n' << bootstrap_file << " doesn't contain any endpoints.\n\n";
+      return;
+    }
+    g_bootstrap_endpoints.clear();
+    for (const auto& endpoint : endpoints) {
+      g_bootstrap_endpoints.push_back(boost::asio::ip::udp::endpoint(
+          boost::asio::ip::address::from_string(endpoint.address().to_string()), endpoint.port()));
+    }
+    g_out_of_date = false;
+    TLOG(kGreen) << "\nLoaded compact " << bootstrap_file << "\n\n";
+  }
 };
 
+// The compact format is sorted, so doesn't preserve the order of the loaded endpoints.
+template <bool compact>
 class HandlePolicySaveBootstrapFile {
  protected:
   virtual ~HandlePolicySaveBootstrapFile() {}
   void HandleInput(const fs::path& bootstrap_file) const {
+#ifdef MAIDSAFE_WIN32
+#pragma warning(push)
+#pragma warning(disable : 4127)
+#endif
+    if (compact) {
+      std::vector<asio::ip::udp::endpoint> endpoints;
+      for (const auto& endpoint : g_bootstrap_endpoints) {
+        endpoints.emplace_back(asio::ip::make_address(endpoint.address().to_string()),
+                               endpoint.port());
+      }
+      return Write(bootstrap_file, maidsafe::SerialiseCompactBootstrap(endpoints));
+    }
+#ifdef MAIDSAFE_WIN32
+#pragma warning(pop)
+#endif
     maidsafe::detail::BootstrapCereal serialised_endpoints;
     for (auto endpoint : g_bootstrap_endpoints) {
       serialised_endpoints.bootstrap_contacts_.emplace_back();
@@ -328,7 +375,11 @@ class HandlePolicySaveBootstrapFile {
       serialised_endpoint->ip_ = endpoint.address().to_string();
       serialised_endpoint->port_ = endpoint.port();
     }
-    maidsafe::SerialisedData contents{maidsafe::Serialise(serialised_endpoints)};
+    Write(bootstrap_file, maidsafe::Serialise(serialised_endpoints));
+  }
+
+ private:
+  void Write(const fs::path& bootstrap_file, const maidsafe::SerialisedData& contents) const {
     if (maidsafe::WriteFile(bootstrap_file, contents)) {
       g_out_of_date = false;
       TLOG(kGreen) << "\nSaved " << bootstrap_file << "\n\n";
@@ -412,10 +463,12 @@ typedef Choice<3, MessagePolicyAppendEndpoint, InputPolicyGetEndpoint, HandlePol
 typedef Choice<4, MessagePolicyRemoveEndpoint, InputPolicyGetEndpoint, HandlePolicyRemoveEndpoint>
     RemoveEndpointChoice;
 typedef Choice<5, MessagePolicyGetPath<false>, InputPolicyGetPath<false>,
-               HandlePolicySaveBootstrapFile> SaveBootstrapChoice;
-typedef Choice<6, MessagePolicyViewEndpoints, InputPolicyNull, HandlePolicyViewEndpoints>
+               HandlePolicySaveBootstrapFile<false>> SaveBootstrapChoice;
+typedef Choice<6, MessagePolicyGetPath<false, true>, InputPolicyGetPath<false>,
+               HandlePolicySaveBootstrapFile<true>> SaveCompactBootstrapChoice;
+typedef Choice<7, MessagePolicyViewEndpoints, InputPolicyNull, HandlePolicyViewEndpoints>
     ViewEndpointsChoice;
-typedef Choice<7, MessagePolicyExit, InputPolicyNull, HandlePolicyExit> ExitChoice;
+typedef Choice<8, MessagePolicyExit, InputPolicyNull, HandlePolicyExit> ExitChoice;
 
 // Helpers and main
 void PrintCommands() {
@@ -425,6 +478,7 @@ void PrintCommands() {
   AppendEndpointChoice::PrintCommandPreamble();
   RemoveEndpointChoice::PrintCommandPreamble();
   SaveBootstrapChoice::PrintCommandPreamble();
+  SaveCompactBootstrapChoice::PrintCommandPreamble();
   ViewEndpointsChoice::PrintCommandPreamble();
   ExitChoice::PrintCommandPreamble();
 }
@@ -440,10 +494,10 @@ int GetChoice() {
     } catch (const std::exception&) {
     }
 
-    if (choice > 0 && choice < 8)
+    if (choice > 0 && choice < 9)
       break;
 
-    TLOG(kDefaultColour) << "\nEnter a single digit in the range [1,7] ";
+    TLOG(kDefaultColour) << "\nEnter a single digit in the range [1,8] ";
   }
   return choice;
 }
@@ -470,6 +524,10 @@ void HandleChoice(int choice) {
       SaveBootstrapChoice choice;
       return choice.Execute();
     }
+    case SaveCompactBootstrapChoice::index: {
+      SaveCompactBootstrapChoice choice;
+      return choice.Execute();
+    }
     case ViewEndpointsChoice::index: {
       ViewEndpointsChoice choice;
       return choice.Execute();
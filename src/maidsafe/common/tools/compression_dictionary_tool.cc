@@ -0,0 +1,62 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Trains a zstd compression dictionary from sample files and writes it to a file which can be
+// shipped with an application and passed to crypto::RegisterCompressionDictionary at startup.
+// Each regular file directly inside the samples directory is one sample record.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/utils.h"
+
+namespace fs = boost::filesystem;
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || argc > 4) {
+    std::cout << "Usage: " << argv[0] << " <samples directory> <output file> [<max size>]\n"
+              << "The default maximum dictionary size is 16384 bytes.\n";
+    return -1;
+  }
+  try {
+    std::vector<maidsafe::NonEmptyString> samples;
+    for (fs::directory_iterator itr(argv[1]); itr != fs::directory_iterator(); ++itr) {
+      if (!fs::is_regular_file(itr->status()) || fs::file_size(itr->path()) == 0)
+        continue;
+      samples.emplace_back(maidsafe::ReadFile(itr->path()).value());
+    }
+    const std::size_t max_size(argc == 4 ? std::stoul(argv[3]) : 16 * 1024);
+    const auto dictionary(maidsafe::crypto::TrainCompressionDictionary(samples, max_size));
+    if (!maidsafe::WriteFile(argv[2], dictionary->string())) {
+      std::cout << "Failed to write " << argv[2] << '\n';
+      return -2;
+    }
+    std::cout << "Trained dictionary " << maidsafe::crypto::GetCompressionDictionaryId(dictionary)
+              << " (" << dictionary->size() << " bytes) from " << samples.size() << " samples.\n";
+  } catch (const std::exception& e) {
+    std::cout << "Training failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
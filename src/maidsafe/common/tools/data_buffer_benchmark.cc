@@ -0,0 +1,403 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Runs mixes of Store, Get and Delete calls against a DataBuffer from several threads, and writes
+// the results as JSON to stdout or to the given file in the same layout as identity_benchmark.
+//
+// Each workload is a mix given as "store:get:delete" weights, run for a fixed time on a new
+// DataBuffer against a shared space of keys.  Values are drawn from a fixed, uniform or exponential
+// size distribution.  There is one result per operation type per workload, with extra fields
+// "items_per_second" and latency percentiles "p50", "p90", "p99" and "max" in microseconds, and one
+// aggregate result per workload with the total throughput, the time Store spent waiting for space
+// in memory ("memory_wait_ms") and on disk ("disk_wait_ms"), and the number of values popped.
+//
+// Without a pop functor, a Store may block until a Delete makes space on disk.  Any still blocked
+// when a workload's time is up are released by raising the disk limit.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/program_options.hpp"
+
+#include "maidsafe/common/data_buffer.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+enum Operation { kStore = 0, kGet = 1, kDelete = 2, kOperationCount = 3 };
+const std::array<const char*, kOperationCount> kOperationNames{{"Store", "Get", "Delete"}};
+
+struct Workload {
+  std::string name;
+  std::array<unsigned, kOperationCount> weights;
+};
+
+struct Config {
+  int threads;
+  std::chrono::milliseconds duration;
+  std::size_t key_count, value_size;
+  std::string distribution;
+  std::uint64_t memory_limit, disk_limit;
+  bool pop;
+  bool segmented_log;
+  std::vector<Workload> workloads;
+};
+
+struct Result {
+  std::string name;
+  std::uint64_t operations;
+  double seconds, mean, p50, p90, p99, max;
+  // Only set for the aggregate result of a workload.
+  bool aggregate;
+  double memory_wait_ms, disk_wait_ms;
+  std::uint64_t pops;
+};
+
+// Parses "store:get:delete" weights, e.g. "50:40:10".
+Workload ParseWorkload(const std::string& mix) {
+  Workload workload{mix, {{0, 0, 0}}};
+  std::size_t position(0);
+  for (int i(0); i != kOperationCount; ++i) {
+    const std::size_t end(mix.find(':', position));
+    if ((end == std::string::npos) != (i == kOperationCount - 1))
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+    workload.weights[i] =
+        static_cast<unsigned>(std::stoul(mix.substr(position, end - position)));
+    position = end + 1;
+  }
+  if (workload.weights[kStore] + workload.weights[kGet] + workload.weights[kDelete] == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  return workload;
+}
+
+// Draws value sizes from the configured distribution, with the given mean, limited to at least 1
+// and at most 16 times the mean.
+class ValueSizes {
+ public:
+  ValueSizes(const std::string& distribution, std::size_t mean, std::uint32_t seed)
+      : distribution_(distribution), mean_(mean), engine_(seed) {
+    if (distribution_ != "fixed" && distribution_ != "uniform" && distribution_ != "exponential")
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  }
+
+  std::size_t Next() {
+    double size(static_cast<double>(mean_));
+    if (distribution_ == "uniform")
+      size = std::uniform_real_distribution<double>(1.0, 2.0 * mean_)(engine_);
+    else if (distribution_ == "exponential")
+      size = std::exponential_distribution<double>(1.0 / mean_)(engine_);
+    return std::min(std::max<std::size_t>(static_cast<std::size_t>(size), 1), mean_ * 16);
+  }
+
+ private:
+  const std::string distribution_;
+  const std::size_t mean_;
+  std::mt19937 engine_;
+};
+
+// Nearest-rank percentile of 'sorted', in microseconds.
+double Percentile(const std::vector<Clock::duration>& sorted, double fraction) {
+  if (sorted.empty())
+    return 0.0;
+  const auto rank(static_cast<std::size_t>(std::ceil(fraction * sorted.size())));
+  const Clock::duration latency(sorted[std::max<std::size_t>(rank, 1) - 1]);
+  return std::chrono::duration<double, std::micro>(latency).count();
+}
+
+typedef std::array<std::vector<Clock::duration>, kOperationCount> Latencies;
+
+// Runs one thread's share of 'workload' until 'stop' is set.
+Latencies RunThread(const Config& config, const Workload& workload, int thread_index,
+                    const std::vector<Data::NameAndTypeId>& keys, DataBuffer& buffer,
+                    const std::atomic<bool>& stop) {
+  // Seeded by thread index so that each run issues the same sequence of operations.
+  std::mt19937 engine(static_cast<std::uint32_t>(thread_index));
+  ValueSizes value_sizes(config.distribution, config.value_size,
+                         static_cast<std::uint32_t>(thread_index) + 1000);
+  const std::string random_bytes(RandomString(config.value_size * 16));
+  std::vector<NonEmptyString> values;
+  for (int i(0); i != 64; ++i)
+    values.emplace_back(random_bytes.substr(0, value_sizes.Next()));
+
+  std::discrete_distribution<int> operations(workload.weights.begin(), workload.weights.end());
+  std::uniform_int_distribution<std::size_t> key_index(0, keys.size() - 1);
+  Latencies latencies;
+  std::size_t value_index(0);
+  while (!stop.load(std::memory_order_relaxed)) {
+    const int operation(operations(engine));
+    const Data::NameAndTypeId& key(keys[key_index(engine)]);
+    const Clock::time_point start(Clock::now());
+    switch (operation) {
+      case kStore:
+        buffer.Store(key, values[value_index++ % values.size()]);
+        break;
+      case kGet:
+        static_cast<void>(buffer.TryGet(key));
+        break;
+      default:
+        buffer.TryDelete(key);
+        break;
+    }
+    latencies[operation].push_back(Clock::now() - start);
+  }
+  return latencies;
+}
+
+std::vector<Result> RunWorkload(const Config& config, const Workload& workload,
+                                const std::vector<Data::NameAndTypeId>& keys,
+                                const fs::path& disk_path) {
+  DataBuffer::PopFunctor pop_functor;
+  if (config.pop)
+    pop_functor = [](const DataBuffer::KeyType&, const NonEmptyString&) {};
+  DataBuffer::Options options;
+  if (config.segmented_log)
+    options.disk_layout = DataBuffer::DiskLayout::kSegmentedLog;
+  DataBuffer buffer(MemoryUsage(config.memory_limit), DiskUsage(config.disk_limit), pop_functor,
+                    disk_path, true, options);
+
+  std::atomic<bool> stop(false);
+  std::vector<std::future<Latencies>> futures;
+  const Clock::time_point start(Clock::now());
+  for (int i(0); i < config.threads; ++i) {
+    futures.push_back(std::async(std::launch::async, [&, i] {
+      return RunThread(config, workload, i, keys, buffer, stop);
+    }));
+  }
+  std::this_thread::sleep_for(config.duration);
+  stop = true;
+  const Clock::time_point stop_time(Clock::now());
+  // Release any stores blocked waiting for space.
+  for (auto& future : futures) {
+    if (future.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
+      LOG(kWarning) << "Releasing blocked stores by raising the disk limit.";
+      buffer.SetMaxDiskUsage(DiskUsage(std::numeric_limits<std::uint64_t>::max()));
+      break;
+    }
+  }
+  Latencies latencies;
+  for (auto& future : futures) {
+    Latencies thread_latencies(future.get());
+    for (int i(0); i != kOperationCount; ++i) {
+      latencies[i].insert(latencies[i].end(), thread_latencies[i].begin(),
+                          thread_latencies[i].end());
+    }
+  }
+  const double seconds(std::chrono::duration<double>(stop_time - start).count());
+  const DataBuffer::Stats stats(buffer.stats());
+
+  std::vector<Result> results;
+  std::uint64_t total(0);
+  for (int i(0); i != kOperationCount; ++i) {
+    if (workload.weights[i] == 0)
+      continue;
+    std::vector<Clock::duration>& sorted(latencies[i]);
+    std::sort(sorted.begin(), sorted.end());
+    Clock::duration sum(Clock::duration::zero());
+    for (const auto& latency : sorted)
+      sum += latency;
+    total += sorted.size();
+    results.push_back(Result{
+        "DataBuffer/" + workload.name + "/" + kOperationNames[i], sorted.size(), seconds,
+        sorted.empty() ? 0.0 : std::chrono::duration<double, std::nano>(sum).count() /
+                                   sorted.size(),
+        Percentile(sorted, 0.5), Percentile(sorted, 0.9), Percentile(sorted, 0.99),
+        Percentile(sorted, 1.0), false, 0.0, 0.0, 0});
+  }
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  results.push_back(Result{"DataBuffer/" + workload.name, total, seconds,
+                           total == 0 ? 0.0 : seconds * 1e9 * config.threads / total, 0.0, 0.0,
+                           0.0, 0.0, true,
+                           Milliseconds(stats.memory_wait.total).count(),
+                           Milliseconds(stats.disk_wait.total).count(),
+                           stats.pops});
+  TLOG(kCyan) << results.back().name << ": " << total / seconds << " ops/s, "
+              << results.back().memory_wait_ms << " ms waiting for memory, "
+              << results.back().disk_wait_ms << " ms waiting for disk, " << stats.pops
+              << " popped\n";
+  return results;
+}
+
+std::vector<Result> RunAll(const Config& config) {
+  std::vector<Data::NameAndTypeId> keys;
+  keys.reserve(config.key_count);
+  for (std::size_t i(0); i != config.key_count; ++i)
+    keys.emplace_back(MakeIdentity(), DataTypeId{static_cast<std::uint32_t>(i % 8)});
+  const fs::path root(fs::temp_directory_path() / fs::unique_path("DataBufferBenchmark-%%%%-%%%%"));
+  std::vector<Result> results;
+  for (const auto& workload : config.workloads) {
+    const auto workload_results(RunWorkload(config, workload, keys, root / "disk_buffer"));
+    results.insert(results.end(), workload_results.begin(), workload_results.end());
+  }
+  boost::system::error_code error;
+  fs::remove_all(root, error);
+  return results;
+}
+
+void WriteJson(const Config& config, const std::vector<Result>& results, std::ostream& output) {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+         << "    \"threads\": " << config.threads << ",\n"
+         << "    \"duration_ms\": " << config.duration.count() << ",\n"
+         << "    \"keys\": " << config.key_count << ",\n"
+         << "    \"value_size\": " << config.value_size << ",\n"
+         << "    \"distribution\": \"" << config.distribution << "\",\n"
+         << "    \"memory_limit\": " << config.memory_limit << ",\n"
+         << "    \"disk_limit\": " << config.disk_limit << ",\n"
+         << "    \"pop\": " << (config.pop ? "true" : "false") << ",\n"
+         << "    \"disk_layout\": \"" << (config.segmented_log ? "segmented" : "file") << "\",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.operations << ",\n"
+           << "      \"real_time\": " << result.mean << ",\n"
+           << "      \"cpu_time\": " << result.mean << ",\n"
+           << "      \"time_unit\": \"ns\",\n"
+           << "      \"items_per_second\": "
+           << (result.seconds > 0 ? result.operations / result.seconds : 0.0) << ",\n";
+    if (result.aggregate) {
+      output << "      \"memory_wait_ms\": " << result.memory_wait_ms << ",\n"
+             << "      \"disk_wait_ms\": " << result.disk_wait_ms << ",\n"
+             << "      \"pops\": " << result.pops << "\n";
+    } else {
+      output << "      \"p50\": " << result.p50 << ",\n"
+             << "      \"p90\": " << result.p90 << ",\n"
+             << "      \"p99\": " << result.p99 << ",\n"
+             << "      \"max\": " << result.max << "\n";
+    }
+    output << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+}  // unnamed namespace
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  maidsafe::benchmark::Config config;
+  int duration_ms(0);
+  std::vector<std::string> mixes;
+  std::string layout, output_path;
+  po::options_description options("Options");
+  options.add_options()("help,h", "Show this help.")(
+      "threads", po::value<int>(&config.threads)->default_value(4), "Client threads.")(
+      "duration", po::value<int>(&duration_ms)->default_value(3000),
+      "Milliseconds to run each workload for.")(
+      "mix", po::value<std::vector<std::string>>(&mixes)->multitoken(),
+      "Workloads as store:get:delete weights (default 100:0:0 50:40:10 10:90:0).")(
+      "keys", po::value<std::size_t>(&config.key_count)->default_value(10000),
+      "Number of distinct keys.")(
+      "value-size", po::value<std::size_t>(&config.value_size)->default_value(4096),
+      "Mean value size in bytes.")(
+      "distribution", po::value<std::string>(&config.distribution)->default_value("fixed"),
+      "Value size distribution: fixed, uniform or exponential.")(
+      "memory", po::value<std::uint64_t>(&config.memory_limit)->default_value(8 << 20),
+      "Maximum memory usage in bytes.")(
+      "disk", po::value<std::uint64_t>(&config.disk_limit)->default_value(32 << 20),
+      "Maximum disk usage in bytes.")(
+      "pop", po::bool_switch(&config.pop), "Pop the oldest values when the disk is full.")(
+      "layout", po::value<std::string>(&layout)->default_value("file"),
+      "Disk layout: file (one file per value) or segmented.")(
+      "output", po::value<std::string>(&output_path), "JSON results file (default stdout).");
+  po::positional_options_description positional;
+  positional.add("output", 1);
+  try {
+    po::variables_map variables;
+    po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(),
+              variables);
+    po::notify(variables);
+    if (mixes.empty())
+      mixes = {"100:0:0", "50:40:10", "10:90:0"};
+    for (const auto& mix : mixes)
+      config.workloads.push_back(maidsafe::benchmark::ParseWorkload(mix));
+    // Validates the distribution name.
+    maidsafe::benchmark::ValueSizes(config.distribution, config.value_size, 0);
+    if (variables.count("help") || config.threads < 1 || duration_ms < 1 ||
+        config.key_count == 0 || config.value_size == 0 ||
+        config.memory_limit > config.disk_limit || (layout != "file" && layout != "segmented")) {
+      std::cout << "Usage: " << argv[0] << " [options] [<output file>]\n" << options << '\n';
+      return -1;
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Invalid arguments: " << boost::diagnostic_information(e) << "\n\n"
+              << options << '\n';
+    return -1;
+  }
+  config.duration = std::chrono::milliseconds(duration_ms);
+  config.segmented_log = (layout == "segmented");
+
+  try {
+    const auto results(maidsafe::benchmark::RunAll(config));
+    if (!output_path.empty()) {
+      std::ofstream output(output_path, std::ios_base::trunc);
+      if (!output) {
+        std::cout << "Failed to open " << output_path << '\n';
+        return -2;
+      }
+      maidsafe::benchmark::WriteJson(config, results, output);
+    } else {
+      maidsafe::benchmark::WriteJson(config, results, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
@@ -18,7 +18,10 @@
 
 #include "maidsafe/client_manager/download_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <future>
 #include <istream>
 #include <iterator>
 #include <ostream>
@@ -49,18 +52,30 @@ namespace maidsafe {
 
 namespace client_manager {
 
-DownloadManager::DownloadManager(std::string location, std::string site, std::string protocol)
+namespace {
+
+// Attempts per file before giving up on it until the next call to Update.  Each attempt resumes
+// from where the previous one stopped.
+const int kMaxDownloadAttempts(3);
+const std::size_t kVerifyBlockSize(64 * 1024);
+// Subdirectory of the local path holding files fetched via DownloadCachedFile.
+const char kCacheDirectory[] = "cache";
+const char kValidatorsExtension[] = ".validators";
+
+}  // unnamed namespace
+
+DownloadManager::DownloadManager(std::string location, std::string site, std::string protocol,
+                                 unsigned max_concurrent_downloads)
     : location_(std::move(location)),
       site_(std::move(site)),
       protocol_(std::move(protocol)),
       latest_local_version_(kApplicationVersion()),
       latest_remote_version_("0.0.000"),
       maidsafe_public_key_(detail::kMaidSafePublicKey()),
-      io_service_(),
-      resolver_(io_service_),
       query_(site_, protocol_),
       local_path_(GetSystemAppSupportDir()),
       latest_remote_path_(),
+      max_concurrent_downloads_(std::max(max_concurrent_downloads, 1U)),
       initialised_(false) {
   if (InitialiseLocalPath())
     initialised_ = InitialisePublicKey();
@@ -117,7 +132,7 @@ std::string DownloadManager::GetBootstrapInfo() {
     LOG(kError) << "DownloadManager is not initialised.";
     return "";
   }
-  std::string bootstrap_content(GetAndVerifyFile(detail::kGlobalBootstrapFilename));
+  std::string bootstrap_content(GetAndVerifyFile(detail::kGlobalBootstrapFilename, true));
   if (bootstrap_content.empty())
     LOG(kError) << "Failed to download bootstrap file.";
   return bootstrap_content;
@@ -153,7 +168,7 @@ int DownloadManager::Update(std::vector<fs::path>& updated_files) {
 }
 
 int DownloadManager::GetAndCheckLatestRemoteVersion() {
-  latest_remote_version_ = GetAndVerifyFile(detail::kVersionFilename);
+  latest_remote_version_ = GetAndVerifyFile(detail::kVersionFilename, true);
   if (latest_remote_version_.empty()) {
     LOG(kError) << "Failed to download version file.";
     latest_remote_version_ = "0.0.000";
@@ -205,26 +220,42 @@ bool DownloadManager::GetManifest(std::vector<std::string>& files_in_manifest) {
 
 void DownloadManager::GetNewFiles(const std::vector<std::string>& files_in_manifest,
                                   std::vector<fs::path>& updated_files) {
-  for (const auto& file : files_in_manifest) {  // NOLINT (Fraser)
-    std::string content(GetAndVerifyFile(latest_remote_path_ / file));
-    if (content.empty())
-      continue;
-
-    fs::path new_file_path(local_path_ / latest_remote_version_ / file);
-    if (!WriteFile(new_file_path, content)) {
-      LOG(kError) << "Failed to write downloaded file to " << new_file_path;
-      continue;
+  // Each worker takes the next file not yet started until all have been attempted.
+  std::vector<char> succeeded(files_in_manifest.size(), 0);
+  std::atomic<std::size_t> next_index(0);
+  auto download([&] {
+    for (std::size_t i(next_index++); i < files_in_manifest.size(); i = next_index++) {
+      succeeded[i] = GetAndVerifyFileToDisk(latest_remote_path_ / files_in_manifest[i],
+                                            local_path_ / latest_remote_version_ /
+                                                files_in_manifest[i]);
     }
-
+  });
+  const std::size_t worker_count(
+      std::min<std::size_t>(max_concurrent_downloads_, files_in_manifest.size()));
+  std::vector<std::future<void>> workers;
+  for (std::size_t i(1); i < worker_count; ++i)
+    workers.push_back(std::async(std::launch::async, download));
+  download();
+  for (auto& worker : workers)
+    worker.get();
+
+  // Reported in manifest order, regardless of the order in which downloads finished.
+  for (std::size_t i(0); i != files_in_manifest.size(); ++i) {
+    if (!succeeded[i])
+      continue;
+    fs::path new_file_path(local_path_ / latest_remote_version_ / files_in_manifest[i]);
     LOG(kInfo) << "Updated file: " << new_file_path;
     updated_files.push_back(new_file_path);
   }
 }
 
-std::string DownloadManager::GetAndVerifyFile(const fs::path& remote_path) {
+std::string DownloadManager::GetAndVerifyFile(const fs::path& remote_path, bool use_cache) {
   try {
-    asymm::Signature signature(DownloadFile(remote_path.string() + detail::kSignatureExtension));
-    asymm::PlainText contents(DownloadFile(remote_path));
+    const fs::path signature_path(remote_path.string() + detail::kSignatureExtension);
+    asymm::Signature signature(use_cache ? DownloadCachedFile(signature_path)
+                                         : DownloadFile(signature_path));
+    asymm::PlainText contents(use_cache ? DownloadCachedFile(remote_path)
+                                        : DownloadFile(remote_path));
     if (!asymm::CheckSignature(contents, signature, maidsafe_public_key_)) {
       LOG(kError) << "Signature of " << remote_path << " is invalid.";
       return "";
@@ -236,34 +267,151 @@ std::string DownloadManager::GetAndVerifyFile(const fs::path& remote_path) {
   }
 }
 
-bool DownloadManager::PrepareDownload(const fs::path& remote_path, asio::streambuf& response_buffer,
-                                      std::istream& response_stream, ip::tcp::socket& socket) {
+bool DownloadManager::GetAndVerifyFileToDisk(const fs::path& remote_path,
+                                             const fs::path& local_path) {
+  const fs::path partial_path(local_path.string() + ".part");
+  try {
+    asymm::Signature signature(DownloadFile(remote_path.string() + detail::kSignatureExtension));
+    for (int attempt(0); attempt != kMaxDownloadAttempts; ++attempt) {
+      asymm::SignatureVerifier verifier(signature, maidsafe_public_key_);
+      if (!ResumeDownload(remote_path, partial_path, verifier))
+        continue;
+      if (!verifier.Verify()) {
+        LOG(kError) << "Signature of " << remote_path << " is invalid.";
+        boost::system::error_code error_code;
+        fs::remove(partial_path, error_code);
+        return false;
+      }
+      fs::rename(partial_path, local_path);
+      return true;
+    }
+    LOG(kError) << "Giving up on " << remote_path << " after " << kMaxDownloadAttempts
+                << " attempts.";
+  } catch (const std::exception& e) {
+    LOG(kError) << "Error getting and verifying " << remote_path << ": " << e.what();
+  }
+  return false;
+}
+
+bool DownloadManager::ResumeDownload(const fs::path& remote_path, const fs::path& partial_path,
+                                     asymm::SignatureVerifier& verifier) {
+  boost::system::error_code error_code;
+  std::uint64_t offset(0);
+  if (fs::exists(partial_path, error_code)) {
+    offset = fs::file_size(partial_path, error_code);
+    if (error_code)
+      offset = 0;
+  }
+
+  asio::io_service io_service;
+  ip::tcp::socket socket(io_service);
+  asio::streambuf response_buffer;
+  std::istream response_stream(&response_buffer);
+  const unsigned status_code(
+      PrepareDownload(remote_path, response_buffer, response_stream, socket, offset));
+  if (status_code != 200 && status_code != 206) {
+    // The server may have rejected the range because the partial file is stale; start afresh next
+    // time.
+    if (status_code != 0 && offset != 0)
+      fs::remove(partial_path, error_code);
+    return false;
+  }
+  if (status_code == 200)
+    offset = 0;  // the server ignored the range and is sending the whole file
+
+  try {
+    // The signature covers the whole file, so the part already on disk is verified first.
+    if (offset != 0) {
+      fs::ifstream existing(partial_path, std::ios::binary);
+      std::vector<char> block(kVerifyBlockSize);
+      for (std::uint64_t remaining(offset); remaining != 0;) {
+        const std::size_t size(
+            static_cast<std::size_t>(std::min<std::uint64_t>(block.size(), remaining)));
+        if (!existing.read(block.data(), size))
+          return false;
+        verifier.Update(reinterpret_cast<const byte*>(block.data()), size);
+        remaining -= size;
+      }
+    }
+
+    fs::ofstream output(partial_path, std::ios::binary | (offset == 0 ? std::ios::trunc
+                                                                       : std::ios::app));
+    if (!output) {
+      LOG(kError) << "Failed to open " << partial_path << " for writing.";
+      return false;
+    }
+    auto consume_received([&] {
+      const char* data(asio::buffer_cast<const char*>(response_buffer.data()));
+      const std::size_t size(response_buffer.size());
+      output.write(data, size);
+      verifier.Update(reinterpret_cast<const byte*>(data), size);
+      response_buffer.consume(size);
+    });
+
+    // Part of the body may already have been read along with the header.
+    consume_received();
+    while (asio::read(socket, response_buffer, asio::transfer_at_least(1), error_code)) {
+      consume_received();
+      boost::this_thread::interruption_point();
+    }
+    consume_received();
+    if (error_code != asio::error::eof) {
+      LOG(kWarning) << "Error downloading " << site_ << "/" << location_ << "/" << remote_path
+                    << ": " << error_code.message();
+      return false;
+    }
+    output.close();
+    if (!output) {
+      LOG(kError) << "Failed to write downloaded file to " << partial_path;
+      return false;
+    }
+  } catch (const std::exception& e) {
+    LOG(kError) << "Error downloading " << site_ << "/" << location_ << "/" << remote_path << ": "
+                << e.what();
+    return false;
+  }
+  return true;
+}
+
+unsigned DownloadManager::PrepareDownload(const fs::path& remote_path,
+                                          asio::streambuf& response_buffer,
+                                          std::istream& response_stream, ip::tcp::socket& socket,
+                                          std::uint64_t offset, CacheValidators* validators) {
   try {
     asio::streambuf request_buffer;
     std::ostream request_stream(&request_buffer);
-    asio::connect(socket, resolver_.resolve(query_));
+    ip::tcp::resolver resolver(socket.get_io_service());
+    asio::connect(socket, resolver.resolve(query_));
     // Form the request. Use "Connection: close" header so that the server will close the socket
     // after transmitting the response; allowing us to treat all data up until the EOF as content.
     request_stream << "GET /" << location_ << "/" << remote_path.generic_string() << " HTTP/1.0\r\n"
-                   << "Host: " << site_ << "\r\nAccept: */*\r\n"
-                   << "Connection: close\r\n\r\n";
+                   << "Host: " << site_ << "\r\nAccept: */*\r\n";
+    if (offset != 0)
+      request_stream << "Range: bytes=" << offset << "-\r\n";
+    if (validators && !validators->etag.empty())
+      request_stream << "If-None-Match: " << validators->etag << "\r\n";
+    if (validators && !validators->last_modified.empty())
+      request_stream << "If-Modified-Since: " << validators->last_modified << "\r\n";
+    request_stream << "Connection: close\r\n\r\n";
     // Send the request.
     asio::write(socket, request_buffer);
-    // Read the response status line. The response streambuf will automatically grow to accommodate
-    // the entire line. The growth may be limited by passing a maximum size to response_buffer ctor.
-    asio::read_until(socket, response_buffer, "\r\n");
+    // Read the response header. The response streambuf will automatically grow to accommodate it.
+    // The growth may be limited by passing a maximum size to response_buffer ctor.
+    asio::read_until(socket, response_buffer, "\r\n\r\n");
     // Check that response is OK.  Consumes entire header.
-    if (!CheckResponse(remote_path, response_stream))
-      return false;
+    return CheckResponse(remote_path, response_stream, offset != 0, validators);
   } catch (const std::exception& e) {
     LOG(kError) << "Error preparing downloading of " << site_ << "/" << location_ << "/"
                 << remote_path << "  : " << e.what();
-    return false;
+    return 0;
   }
-  return true;
 }
 
-bool DownloadManager::CheckResponse(const fs::path& remote_path, std::istream& response_stream) {
+unsigned DownloadManager::CheckResponse(const fs::path& remote_path, std::istream& response_stream,
+                                        bool range_requested, CacheValidators* validators) {
+  const bool conditional(validators && !validators->empty());
+  if (validators)
+    *validators = CacheValidators();
   std::string http_version;
   response_stream >> http_version;
   unsigned int status_code;
@@ -274,23 +422,91 @@ bool DownloadManager::CheckResponse(const fs::path& remote_path, std::istream& r
     if (header == "\r")
       break;
     status_message += header;
+    const std::size_t colon(header.find(':'));
+    if (!validators || colon == std::string::npos)
+      continue;
+    const std::string name(header.substr(0, colon));
+    if (boost::iequals(name, "ETag"))
+      validators->etag = boost::trim_copy(header.substr(colon + 1));
+    else if (boost::iequals(name, "Last-Modified"))
+      validators->last_modified = boost::trim_copy(header.substr(colon + 1));
   }
 
-  if (!response_stream || http_version.substr(0, 5) != "HTTP/" || status_code != 200) {
+  if (!response_stream || http_version.substr(0, 5) != "HTTP/") {
     LOG(kError) << "Error downloading " << site_ << "/" << location_ << "/" << remote_path
                 << ".  Response header:\n" + status_message;
-    return false;
+    return 0;
   }
-  return true;
+  if (status_code != 200 && !(range_requested && status_code == 206) &&
+      !(conditional && status_code == 304)) {
+    LOG(kError) << "Error downloading " << site_ << "/" << location_ << "/" << remote_path
+                << ".  Response header:\n" + status_message;
+  }
+  return status_code;
 }
 
 std::string DownloadManager::DownloadFile(const fs::path& remote_path) {
-  ip::tcp::socket socket(io_service_);
+  asio::io_service io_service;
+  ip::tcp::socket socket(io_service);
   asio::streambuf response_buffer;
   std::istream response_stream(&response_buffer);
-  if (!PrepareDownload(remote_path, response_buffer, response_stream, socket))
+  if (PrepareDownload(remote_path, response_buffer, response_stream, socket) != 200)
     return "";
+  return ReadToEnd(remote_path, socket, response_buffer);
+}
+
+std::string DownloadManager::DownloadCachedFile(const fs::path& remote_path) {
+  const fs::path cache_path(local_path_ / kCacheDirectory / remote_path);
+  const fs::path validators_path(cache_path.string() + kValidatorsExtension);
+  CacheValidators validators;
+  std::string cached_content;
+  {
+    fs::ifstream validators_stream(validators_path);
+    auto cached(ReadFile(cache_path));
+    if (std::getline(validators_stream, validators.etag) &&
+        std::getline(validators_stream, validators.last_modified) && cached) {
+      cached_content.assign(cached->begin(), cached->end());
+    } else {
+      validators = CacheValidators();
+    }
+  }
+
+  asio::io_service io_service;
+  ip::tcp::socket socket(io_service);
+  asio::streambuf response_buffer;
+  std::istream response_stream(&response_buffer);
+  const unsigned status_code(
+      PrepareDownload(remote_path, response_buffer, response_stream, socket, 0, &validators));
+  if (status_code == 304) {
+    LOG(kVerbose) << remote_path << " is unchanged; using cached copy.";
+    return cached_content;
+  }
+  if (status_code != 200)
+    return "";
+
+  std::string content(ReadToEnd(remote_path, socket, response_buffer));
+  if (content.empty() || validators.empty())
+    return content;
+
+  // Other processes may be reading the cache concurrently, so each file is replaced atomically.
+  // The validators are written last, so that they are never paired with older content.
+  boost::system::error_code error_code;
+  fs::create_directories(cache_path.parent_path(), error_code);
+  fs::remove(validators_path, error_code);
+  WriteFileOptions options;
+  options.atomic_replace = true;
+  const std::string validators_content(validators.etag + '\n' + validators.last_modified + '\n');
+  if (!WriteFile(cache_path, std::vector<byte>(content.begin(), content.end()), options) ||
+      !WriteFile(validators_path,
+                 std::vector<byte>(validators_content.begin(), validators_content.end()),
+                 options)) {
+    LOG(kWarning) << "Failed to cache " << remote_path << " at " << cache_path;
+  }
+  return content;
+}
 
+std::string DownloadManager::ReadToEnd(const fs::path& remote_path, ip::tcp::socket& socket,
+                                       asio::streambuf& response_buffer) {
   try {
     // Read until EOF, puts whole file in memory, so this should be of manageable size.
     boost::system::error_code error_code;
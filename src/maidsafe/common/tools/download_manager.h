@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_COMMON_TOOLS_DOWNLOAD_MANAGER_H_
 #define MAIDSAFE_COMMON_TOOLS_DOWNLOAD_MANAGER_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -41,9 +42,11 @@ class DownloadManagerTest;
 
 class DownloadManager {
  public:
+  // Files listed in the manifest are downloaded up to 'max_concurrent_downloads' at a time.
   DownloadManager(std::string location = detail::kDownloadManagerLocation,
                   std::string site = detail::kDownloadManagerSite,
-                  std::string protocol = detail::kDownloadManagerProtocol);
+                  std::string protocol = detail::kDownloadManagerProtocol,
+                  unsigned max_concurrent_downloads = 4);
   ~DownloadManager();
   // Retrieves the latest bootstrap file from the server.
   std::string GetBootstrapInfo();
@@ -55,25 +58,56 @@ class DownloadManager {
   friend class test::DownloadManagerTest;
 
  private:
+  // The validators from a response's ETag and Last-Modified headers, sent back as If-None-Match and
+  // If-Modified-Since to make a later request for the same file conditional.
+  struct CacheValidators {
+    bool empty() const { return etag.empty() && last_modified.empty(); }
+    std::string etag, last_modified;
+  };
+
   bool InitialiseLocalPath();
   bool InitialisePublicKey();
   int GetAndCheckLatestRemoteVersion();
   bool GetManifest(std::vector<std::string>& files_in_manifest);
   void GetNewFiles(const std::vector<std::string>& files_in_manifest,
                    std::vector<boost::filesystem::path>& updated_files);
-  std::string GetAndVerifyFile(const boost::filesystem::path& remote_path);
-  bool PrepareDownload(const boost::filesystem::path& remote_path,
-                       boost::asio::streambuf& response_buffer, std::istream& response_stream,
-                       boost::asio::ip::tcp::socket& socket);
-  bool CheckResponse(const boost::filesystem::path& remote_path, std::istream& response_stream);
+  // If 'use_cache' is true, the file and its signature are fetched via DownloadCachedFile.
+  std::string GetAndVerifyFile(const boost::filesystem::path& remote_path, bool use_cache = false);
+  // Downloads 'remote_path' to 'local_path', checking its signature as the data arrives.  Content
+  // is first written to a ".part" file alongside 'local_path'; if a download is interrupted, later
+  // attempts (including those by a later call) resume from the end of that file.
+  bool GetAndVerifyFileToDisk(const boost::filesystem::path& remote_path,
+                              const boost::filesystem::path& local_path);
+  // Appends the remainder of 'remote_path' to 'partial_path', passing all of the file's content
+  // (including any already in 'partial_path') to 'verifier'.  Returns true once the whole file has
+  // been received.
+  bool ResumeDownload(const boost::filesystem::path& remote_path,
+                      const boost::filesystem::path& partial_path,
+                      asymm::SignatureVerifier& verifier);
+  // Connects, requests 'remote_path' (from 'offset' onwards if non-zero) and consumes the response
+  // header.  If 'validators' is non-null and not empty, the request is made conditional on them,
+  // and they are replaced by those in the response.  Returns the HTTP status code, or 0 on failure.
+  unsigned PrepareDownload(const boost::filesystem::path& remote_path,
+                           boost::asio::streambuf& response_buffer, std::istream& response_stream,
+                           boost::asio::ip::tcp::socket& socket, std::uint64_t offset = 0,
+                           CacheValidators* validators = nullptr);
+  unsigned CheckResponse(const boost::filesystem::path& remote_path, std::istream& response_stream,
+                         bool range_requested, CacheValidators* validators);
   std::string DownloadFile(const boost::filesystem::path& remote_path);
+  // As DownloadFile, but keeps a copy of the file under 'local_path_' and re-downloads it only if
+  // the server reports that it has changed since.
+  std::string DownloadCachedFile(const boost::filesystem::path& remote_path);
+  // Reads the rest of the response body.  Returns an empty string on failure.
+  std::string ReadToEnd(const boost::filesystem::path& remote_path,
+                        boost::asio::ip::tcp::socket& socket,
+                        boost::asio::streambuf& response_buffer);
 
   std::string location_, site_, protocol_, latest_local_version_, latest_remote_version_;
   asymm::PublicKey maidsafe_public_key_;
-  boost::asio::io_service io_service_;
-  boost::asio::ip::tcp::resolver resolver_;
+  // Each download uses its own io_service and resolver, so that several can run concurrently.
   boost::asio::ip::tcp::resolver::query query_;
   boost::filesystem::path local_path_, latest_remote_path_;
+  const unsigned max_concurrent_downloads_;
   bool initialised_;
 };
 
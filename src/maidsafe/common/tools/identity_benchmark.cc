@@ -0,0 +1,246 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Times the core Identity operations (and hashing of Data::NameAndTypeId keys) over batches of
+// random IDs and writes the results as JSON to stdout or to the given file.  The output follows
+// Google Benchmark's JSON layout ("context" plus a "benchmarks" array with per-item times in
+// nanoseconds), so that results from different releases can be compared with that project's tools.
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/encode.h"
+#include "maidsafe/common/hash.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/data.h"
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Each benchmark is repeated until it has run for at least this long.
+const std::chrono::milliseconds kMinimumDuration(200);
+const std::vector<std::size_t> kBatchSizes{16, 1024, 65536};
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations;
+  double real_time;
+  double cpu_time;
+};
+
+// Written to by every benchmarked operation so the compiler can't discard the work.
+volatile std::uint64_t g_sink(0);
+
+std::vector<Identity> MakeIdentities(std::size_t count) {
+  std::vector<Identity> ids;
+  ids.reserve(count);
+  for (std::size_t i(0); i != count; ++i)
+    ids.push_back(MakeIdentity());
+  return ids;
+}
+
+// Calls 'functor' (which processes 'batch_size' items per call) repeatedly for kMinimumDuration and
+// returns the mean wall and CPU times per item in nanoseconds.
+template <typename Functor>
+Result Measure(const std::string& name, std::size_t batch_size, Functor functor) {
+  functor();  // warm up
+  std::uint64_t calls(0);
+  const std::clock_t cpu_start(std::clock());
+  const Clock::time_point start(Clock::now());
+  Clock::time_point now(start);
+  while (now - start < kMinimumDuration) {
+    functor();
+    ++calls;
+    now = Clock::now();
+  }
+  const double cpu_nanoseconds(static_cast<double>(std::clock() - cpu_start) * 1e9 /
+                               CLOCKS_PER_SEC);
+  const double real_nanoseconds(static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()));
+  const std::uint64_t iterations(calls * batch_size);
+  return Result{name + '/' + std::to_string(batch_size), iterations,
+                real_nanoseconds / iterations, cpu_nanoseconds / iterations};
+}
+
+std::vector<Data::NameAndTypeId> MakeKeys(const std::vector<Identity>& ids) {
+  std::vector<Data::NameAndTypeId> keys;
+  keys.reserve(ids.size());
+  for (std::size_t i(0); i != ids.size(); ++i)
+    keys.emplace_back(ids[i], DataTypeId{static_cast<std::uint32_t>(i % 8)});
+  return keys;
+}
+
+std::vector<Result> RunAll() {
+  const std::array<byte, SipHash13::kKeySize> seed{{}};
+  std::vector<Result> results;
+  for (const std::size_t batch_size : kBatchSizes) {
+    const std::vector<Identity> ids(MakeIdentities(batch_size));
+    const std::vector<Identity> others(MakeIdentities(batch_size));
+    const std::vector<Data::NameAndTypeId> keys(MakeKeys(ids));
+    const Identity target(MakeIdentity());
+
+    results.push_back(Measure("CloserToTarget", batch_size, [&] {
+      std::uint64_t count(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        count += CloserToTarget(ids[i], others[i], target) ? 1 : 0;
+      g_sink = g_sink + count;
+    }));
+
+    results.push_back(Measure("CommonLeadingBits", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        total += static_cast<std::uint64_t>(CommonLeadingBits(ids[i], target));
+      g_sink = g_sink + total;
+    }));
+
+    results.push_back(Measure("MakeIdentity", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        total += MakeIdentity().data()[0];
+      g_sink = g_sink + total;
+    }));
+
+    results.push_back(Measure("HexEncode", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        total += static_cast<unsigned char>(hex::Encode(ids[i])[0]);
+      g_sink = g_sink + total;
+    }));
+
+    results.push_back(Measure("IdentityCopy", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i) {
+        const Identity copy(ids[i]);
+        total += copy.data()[0];
+      }
+      g_sink = g_sink + total;
+    }));
+
+    results.push_back(Measure("IdentityEqual", batch_size, [&] {
+      std::uint64_t count(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        count += (ids[i] == others[i]) ? 1 : 0;
+      g_sink = g_sink + count;
+    }));
+
+    results.push_back(Measure("IdentityLess", batch_size, [&] {
+      std::uint64_t count(0);
+      for (std::size_t i(0); i != batch_size; ++i)
+        count += (ids[i] < others[i]) ? 1 : 0;
+      g_sink = g_sink + count;
+    }));
+
+    results.push_back(Measure("NameAndTypeIdHash", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i) {
+        SipHash13 hash(seed);
+        hash(keys[i]);
+        total += hash.Finalize();
+      }
+      g_sink = g_sink + total;
+    }));
+
+    // Baseline for the above: visits the name one byte at a time, as hashing via a per-element
+    // serialise function would.  Both produce the same hash value.
+    results.push_back(Measure("NameAndTypeIdHashElementwise", batch_size, [&] {
+      std::uint64_t total(0);
+      for (std::size_t i(0); i != batch_size; ++i) {
+        SipHash13 hash(seed);
+        for (const byte element : keys[i].name.string())
+          hash(element);
+        hash(keys[i].name.size(), keys[i].type_id);
+        total += hash.Finalize();
+      }
+      g_sink = g_sink + total;
+    }));
+  }
+  return results;
+}
+
+void WriteJson(const std::vector<Result>& results, std::ostream& output) {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.iterations << ",\n"
+           << "      \"real_time\": " << result.real_time << ",\n"
+           << "      \"cpu_time\": " << result.cpu_time << ",\n"
+           << "      \"time_unit\": \"ns\"\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+}  // unnamed namespace
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::cout << "Usage: " << argv[0] << " [<output file>]\n"
+              << "Writes JSON results to stdout if no output file is given.\n";
+    return -1;
+  }
+  try {
+    const auto results(maidsafe::benchmark::RunAll());
+    if (argc == 2) {
+      std::ofstream output(argv[1], std::ios_base::trunc);
+      if (!output) {
+        std::cout << "Failed to open " << argv[1] << '\n';
+        return -2;
+      }
+      maidsafe::benchmark::WriteJson(results, output);
+    } else {
+      maidsafe::benchmark::WriteJson(results, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
@@ -0,0 +1,50 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <fstream>
+#include <iostream>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/log.h"
+
+// Decodes a binary combined logfile (as written when running with --log_binary) to text.
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cout << "Usage: " << argv[0] << " <binary logfile> [<output file>]\n"
+              << "Writes to stdout if no output file is given.\n";
+    return -1;
+  }
+  try {
+    std::ifstream input(argv[1], std::ios_base::binary);
+    if (!input) {
+      std::cout << "Failed to open " << argv[1] << '\n';
+      return -2;
+    }
+    if (argc == 3) {
+      std::ofstream output(argv[2], std::ios_base::trunc);
+      maidsafe::log::DecodeBinaryLog(input, output);
+    } else {
+      maidsafe::log::DecodeBinaryLog(input, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Failed to decode " << argv[1] << ": " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
@@ -17,19 +17,104 @@
     use of the MaidSafe Software.                                                                 */
 
 #include <chrono>
+#include <fstream>
+#include <iostream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/cli.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/menu.h"
 
 #include "maidsafe/common/menu_item.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/common/tools/hot_path_benchmark.h"
 #include "maidsafe/common/tools/sqlite3_wrapper_benchmark.h"
 
+namespace {
+
+// A benchmark whose time per operation has grown by more than this fraction of its baseline time is
+// reported as a regression.
+const double kRegressionThreshold(0.1);
+
+// Runs the hot path benchmarks, writes their results to 'output' and compares them with 'baseline'
+// unless either is empty.  Returns the number of regressions against the baseline.
+std::size_t RunHotPathBenchmarks(maidsafe::benchmark::HotPathBenchmark::Parameters parameters,
+                                 const boost::filesystem::path& output,
+                                 const boost::filesystem::path& baseline) {
+  maidsafe::benchmark::HotPathBenchmark hot_path_benchmark(std::move(parameters));
+  hot_path_benchmark.Run();
+  if (!output.empty()) {
+    std::ofstream output_stream(output.string(), std::ios_base::trunc);
+    if (!output_stream)
+      BOOST_THROW_EXCEPTION(maidsafe::MakeError(maidsafe::CommonErrors::filesystem_io_error));
+    hot_path_benchmark.WriteJson(output_stream);
+    TLOG(kGreen) << "Wrote results to " << output << '\n';
+  }
+  if (baseline.empty())
+    return 0;
+  return maidsafe::benchmark::ReportComparisons(
+      hot_path_benchmark.CompareWith(baseline, kRegressionThreshold));
+}
+
+// Runs 'functor' from a menu item, reporting rather than propagating any exception, and waits for
+// the user before the menu is redrawn so that the results stay visible.
+template <typename Functor>
+void RunFromMenu(Functor functor) {
+  try {
+    functor();
+  } catch (const std::exception& e) {
+    TLOG(kRed) << "Failed: " << boost::diagnostic_information(e) << '\n';
+  }
+  TLOG(kDefaultColour) << "Press enter to continue.\n";
+  std::string input;
+  std::getline(std::cin, input);
+}
+
+// Prompts for a path, where "-" means none.
+boost::filesystem::path GetOptionalPath(const std::string& display_message) {
+  const std::string path(maidsafe::CLI().Get<std::string>(display_message + " (- for none)"));
+  return path == "-" ? boost::filesystem::path() : boost::filesystem::path(path);
+}
+
+void RunInteractiveHotPathBenchmarks(maidsafe::benchmark::HotPathBenchmark::Parameters parameters) {
+  const boost::filesystem::path output(GetOptionalPath("Enter path for the JSON results"));
+  const boost::filesystem::path baseline(GetOptionalPath("Enter path of a baseline JSON file"));
+  RunHotPathBenchmarks(std::move(parameters), output, baseline);
+}
+
+}  // unnamed namespace
+
 int main(int argc, char* argv[]) {
-  maidsafe::log::Logging::Instance().Initialise(argc, argv);
+  auto unuseds(maidsafe::log::Logging::Instance().Initialise(argc, argv));
+  std::vector<std::string> unused_options;
+  for (const auto& unused : unuseds)
+    unused_options.emplace_back(&unused[0]);
+
+  // Non-interactive use, e.g. to gate an upgrade on performance:
+  //   qa_tool --benchmark <output JSON file> [<baseline JSON file>]
+  // returns non-zero if any benchmark has regressed against the baseline.
+  if (unused_options.size() > 1 && unused_options[1] == "--benchmark") {
+    if (unused_options.size() < 3 || unused_options.size() > 4) {
+      TLOG(kYellow) << "Usage: " << unused_options[0]
+                    << " --benchmark <output JSON file> [<baseline JSON file>]\n";
+      return -1;
+    }
+    try {
+      const boost::filesystem::path baseline(unused_options.size() == 4 ? unused_options[3] : "");
+      return RunHotPathBenchmarks(maidsafe::benchmark::HotPathBenchmark::Parameters(),
+                                  unused_options[2], baseline) == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+      TLOG(kRed) << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+      return -2;
+    }
+  }
 
   maidsafe::Menu menu{"Main menu"};
 
@@ -39,24 +124,36 @@ int main(int argc, char* argv[]) {
   maidsafe::MenuItem* qa_dev_item{qa_item->AddChildItem("Developer's Menu (core dev help)")};
 
   maidsafe::MenuItem* qa_dev_test_item{qa_dev_item->AddChildItem("Test Suite")};
-  qa_dev_test_item->AddChildItem("Test 1", [] {
-    TLOG(kGreen) << "Running dev test 1.\n";
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+  qa_dev_test_item->AddChildItem("Smoke test (brief pass over every hot path)", [] {
+    TLOG(kGreen) << "Running hot path smoke test.\n";
+    maidsafe::benchmark::HotPathBenchmark::Parameters parameters;
+    parameters.minimum_duration = std::chrono::milliseconds(10);
+    parameters.repetitions = 1;
+    parameters.include_sqlite = false;
+    RunFromMenu([&] { RunHotPathBenchmarks(parameters, "", ""); });
   });
-  qa_dev_test_item->AddChildItem("Test 2", [] {
-    TLOG(kGreen) << "Running dev test 2.\n";
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+  qa_dev_test_item->AddChildItem("Stress test (long runs with large values)", [] {
+    TLOG(kGreen) << "Running hot path stress test.\n";
+    maidsafe::benchmark::HotPathBenchmark::Parameters parameters;
+    parameters.minimum_duration = std::chrono::seconds(5);
+    parameters.repetitions = 3;
+    parameters.value_size = 256 * 1024;
+    RunFromMenu([&] { RunInteractiveHotPathBenchmarks(parameters); });
   });
 
   maidsafe::MenuItem* qa_dev_bench_item{qa_dev_item->AddChildItem("Benchmark Suite")};
+  qa_dev_bench_item->AddChildItem("Hot path benchmarks (JSON export and baseline diffing)", [] {
+    TLOG(kGreen) << "Running hot path benchmarks\n";
+    RunFromMenu([] {
+      RunInteractiveHotPathBenchmarks(maidsafe::benchmark::HotPathBenchmark::Parameters());
+    });
+  });
   qa_dev_bench_item->AddChildItem("sqlite_wrapper benchmark", [] {
     TLOG(kGreen) << "Running sqlite_wrapper benchmark test\n";
-    maidsafe::benchmark::Sqlite3WrapperBenchmark sqlite_wrapper_benchmark_test;
-    sqlite_wrapper_benchmark_test.Run();
-  });
-  qa_dev_bench_item->AddChildItem("Benchmark 2", [] {
-    TLOG(kGreen) << "Running benchmark 2.\n";
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    RunFromMenu([] {
+      maidsafe::benchmark::Sqlite3WrapperBenchmark sqlite_wrapper_benchmark_test;
+      sqlite_wrapper_benchmark_test.Run();
+    });
   });
 
   // Builders
@@ -0,0 +1,340 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Benchmarks serialisation, and writes the results as JSON to stdout or to the given file in the
+// same layout as identity_benchmark, with two extra fields per result: "allocations" (heap
+// allocations per item) and "bytes_per_second" (serialised bytes processed per second).
+//
+// Two groups are run:
+//  * Saving and loading contiguous arithmetic containers via maidsafe's bulk overloads on
+//    BinaryOutputArchive / BinaryInputArchive against Cereal's generic overloads for the same
+//    types.
+//  * Saving and loading representative types via each of the public entry points: Serialise/Parse
+//    on a buffer ("Buffer"), Serialise/Parse on vectorstreams ("VectorStream"),
+//    ConvertToString/ConvertFromString ("String"), and ConvertToStream/ConvertFromStream on a new
+//    std::stringstream per item using Cereal's own binary archives ("StringStream").
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/flyweight.hpp"
+#include "cereal/types/array.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/data_types/immutable_data.h"
+#include "maidsafe/common/data_types/structured_data_versions.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/common/serialisation/types/boost_flyweight.h"
+
+// Counts every heap allocation made by this process, so that the benchmarks can report allocations
+// per item.
+std::atomic<std::uint64_t> g_allocation_count(0);
+
+void* operator new(std::size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* const memory = std::malloc(size == 0 ? 1 : size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* memory) MAIDSAFE_NOEXCEPT { std::free(memory); }
+
+void operator delete[](void* memory) MAIDSAFE_NOEXCEPT { std::free(memory); }
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Each benchmark is repeated until it has run for at least this long.
+const std::chrono::milliseconds kMinimumDuration(200);
+const std::size_t kBatchSize(1024);
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations;
+  double real_time;
+  double cpu_time;
+  double allocations;
+  double bytes_per_second;
+};
+
+// Written to by every benchmarked operation so the compiler can't discard the work.
+volatile std::uint64_t g_sink(0);
+
+// Calls 'functor' (which processes kBatchSize items of 'item_size' serialised bytes per call)
+// repeatedly for kMinimumDuration and returns the mean wall and CPU times per item in nanoseconds.
+template <typename Functor>
+Result Measure(const std::string& name, std::size_t item_size, Functor functor) {
+  functor();  // warm up
+  std::uint64_t calls(0);
+  const std::uint64_t allocations_start(g_allocation_count.load());
+  const std::clock_t cpu_start(std::clock());
+  const Clock::time_point start(Clock::now());
+  Clock::time_point now(start);
+  while (now - start < kMinimumDuration) {
+    functor();
+    ++calls;
+    now = Clock::now();
+  }
+  const double cpu_nanoseconds(static_cast<double>(std::clock() - cpu_start) * 1e9 /
+                               CLOCKS_PER_SEC);
+  const double real_nanoseconds(static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()));
+  const std::uint64_t allocations(g_allocation_count.load() - allocations_start);
+  const std::uint64_t iterations(calls * kBatchSize);
+  return Result{name,
+                iterations,
+                real_nanoseconds / iterations,
+                cpu_nanoseconds / iterations,
+                static_cast<double>(allocations) / iterations,
+                static_cast<double>(item_size) * iterations * 1e9 / real_nanoseconds};
+}
+
+// Adds "<name>/Save" and "<name>/Load" results for both the bulk overloads ("Bulk") and Cereal's
+// own generic ones ("Cereal"), called explicitly via qualified lookup.
+template <typename Container>
+void MeasureContainer(const std::string& name, const Container& container,
+                      std::vector<Result>& results) {
+  SerialisedData buffer;
+  SerialiseInto(buffer, container);
+  const std::size_t size(buffer.size());
+  results.push_back(Measure("Bulk" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      SerialiseInto(buffer, container);
+      g_sink = g_sink + buffer.size();
+    }
+  }));
+  results.push_back(Measure("Cereal" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      buffer.clear();
+      BinaryOutputArchive archive(buffer);
+      cereal::save(archive, container);
+      g_sink = g_sink + buffer.size();
+    }
+  }));
+
+  SerialiseInto(buffer, container);
+  Container parsed;
+  results.push_back(Measure("Bulk" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      Parse(buffer.data(), buffer.size(), parsed);
+      g_sink = g_sink + parsed[0];
+    }
+  }));
+  results.push_back(Measure("Cereal" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      BinaryInputArchive archive(buffer.data(), buffer.size());
+      cereal::load(archive, parsed);
+      g_sink = g_sink + parsed[0];
+    }
+  }));
+}
+
+// Adds "<Pair>/<name>/Save" and "<Pair>/<name>/Load" results for each of the entry point pairs
+// described at the top of this file.
+template <typename Type>
+void MeasureType(const std::string& name, const Type& value, std::vector<Result>& results) {
+  const SerialisedData serialised(Serialise(value));
+  const std::size_t size(serialised.size());
+
+  results.push_back(Measure("Buffer/" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      g_sink = g_sink + Serialise(value).size();
+  }));
+  results.push_back(Measure("VectorStream/" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      OutputVectorStream stream;
+      g_sink = g_sink + Serialise(stream, value).size();
+    }
+  }));
+  results.push_back(Measure("String/" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      g_sink = g_sink + ConvertToString(value).size();
+  }));
+  results.push_back(Measure("StringStream/" + name + "/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      std::stringstream stream;
+      ConvertToStream(stream, value);
+      g_sink = g_sink + stream.str().size();
+    }
+  }));
+
+  const std::string serialised_string(serialised.begin(), serialised.end());
+  Type parsed;
+  results.push_back(Measure("Buffer/" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      Parse(serialised, parsed);
+  }));
+  results.push_back(Measure("VectorStream/" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      InputVectorStream stream{serialised};
+      Parse(stream, parsed);
+    }
+  }));
+  results.push_back(Measure("String/" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      ConvertFromString(serialised_string, parsed);
+  }));
+  results.push_back(Measure("StringStream/" + name + "/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      std::stringstream stream{serialised_string};
+      ConvertFromStream(stream, parsed);
+    }
+  }));
+}
+
+// StructuredDataVersions isn't default-constructible or copyable, so can only be exercised via its
+// own Serialise function and parsing constructor.
+void MeasureStructuredDataVersions(std::vector<Result>& results) {
+  StructuredDataVersions versions(100, 1);
+  StructuredDataVersions::VersionName parent;
+  for (StructuredDataVersions::VersionName::Index index(0); index != 100; ++index) {
+    const StructuredDataVersions::VersionName child(index, MakeIdentity());
+    versions.Put(parent, child);
+    parent = child;
+  }
+  const StructuredDataVersions::serialised_type serialised(versions.Serialise());
+  const std::size_t size(serialised->string().size());
+  results.push_back(Measure("Native/StructuredDataVersions/Save", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      g_sink = g_sink + versions.Serialise()->string().size();
+  }));
+  results.push_back(Measure("Native/StructuredDataVersions/Load", size, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      const StructuredDataVersions parsed(serialised);
+      g_sink = g_sink + parsed.max_versions();
+    }
+  }));
+}
+
+std::vector<Result> RunAll() {
+  std::vector<Result> results;
+  for (const std::size_t size : {std::size_t(64), std::size_t(4096)}) {
+    MeasureContainer("VectorByte/" + std::to_string(size), RandomBytes(size), results);
+    std::vector<std::uint64_t> numbers(size / sizeof(std::uint64_t));
+    for (auto& number : numbers)
+      number = RandomUint32();
+    MeasureContainer("VectorUint64/" + std::to_string(size), numbers, results);
+  }
+  std::array<byte, 64> array;
+  FillRandomBytes(array.data(), array.size());
+  MeasureContainer("ArrayByte/64", array, results);
+
+  for (const std::size_t size : {std::size_t(64), std::size_t(4096)}) {
+    MeasureType("ImmutableData/" + std::to_string(size),
+                ImmutableData(NonEmptyString(RandomBytes(size))), results);
+  }
+
+  std::vector<StructuredDataVersions::VersionName> version_names;
+  for (StructuredDataVersions::VersionName::Index index(0); index != 100; ++index)
+    version_names.emplace_back(index, MakeIdentity());
+  MeasureType("VersionNames/100", version_names, results);
+  MeasureStructuredDataVersions(results);
+
+  MeasureType("RsaKeys", rsa::GenerateKeyPair(), results);
+
+  // 100 flyweights sharing 10 distinct values.
+  std::vector<boost::flyweight<std::string>> flyweights;
+  for (int i(0); i != 100; ++i)
+    flyweights.emplace_back("value " + std::to_string(i % 10));
+  MeasureType("FlyweightStrings/100", flyweights, results);
+  return results;
+}
+
+void WriteJson(const std::vector<Result>& results, std::ostream& output) {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.iterations << ",\n"
+           << "      \"real_time\": " << result.real_time << ",\n"
+           << "      \"cpu_time\": " << result.cpu_time << ",\n"
+           << "      \"time_unit\": \"ns\",\n"
+           << "      \"allocations\": " << result.allocations << ",\n"
+           << "      \"bytes_per_second\": " << result.bytes_per_second << "\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+}  // unnamed namespace
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::cout << "Usage: " << argv[0] << " [<output file>]\n"
+              << "Writes JSON results to stdout if no output file is given.\n";
+    return -1;
+  }
+  try {
+    const auto results(maidsafe::benchmark::RunAll());
+    if (argc == 2) {
+      std::ofstream output(argv[1], std::ios_base::trunc);
+      if (!output) {
+        std::cout << "Failed to open " << argv[1] << '\n';
+        return -2;
+      }
+      maidsafe::benchmark::WriteJson(results, output);
+    } else {
+      maidsafe::benchmark::WriteJson(results, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
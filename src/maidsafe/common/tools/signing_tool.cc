@@ -23,13 +23,18 @@
 #include <termios.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <istream>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include "boost/exception/diagnostic_information.hpp"
 #include "boost/filesystem.hpp"
 
 #include "maidsafe/common/crypto.h"
@@ -48,6 +53,10 @@ static bool group_signed_in;
 
 using Bytes = std::vector<unsigned char>;
 
+// The names DownloadManager expects for a release's file list and for each file's signature.
+const char kManifestFilename[] = "manifest";
+const char kSignatureExtension[] = ".sig";
+
 template <class T>
 T Get(std::string display_message, bool echo_input = true);
 
@@ -82,8 +91,9 @@ Bytes GetPasswd(bool repeat = true) {
     if (repeat)
       passwd2 = Get<std::string>("please Re-Enter same passwd \n", false);
   } while ((passwd != passwd2) && (repeat));
-  return maidsafe::crypto::Hash<maidsafe::crypto::SHA512>(Bytes(passwd.begin(), passwd.end()))
-      .string();
+  const auto hash(
+      maidsafe::crypto::Hash<maidsafe::crypto::SHA512>(Bytes(passwd.begin(), passwd.end())));
+  return Bytes(hash.string().begin(), hash.string().end());
 }
 
 std::vector<std::string> TokeniseLine(std::string line) {
@@ -173,7 +183,7 @@ void SignFile() {
   }
 
   maidsafe::asymm::Signature signature(maidsafe::asymm::SignFile(file, Keys.private_key));
-  fs::path sigfile(filename + ".sig");
+  fs::path sigfile(filename + kSignatureExtension);
   if (!maidsafe::WriteFile(sigfile, signature.string()))
     std::cout << "error writing file\n";
   else
@@ -185,7 +195,7 @@ void ValidateSignature() {
       "please enter filename to validate \n We will read the "
       "filename.sig as signature file\n");
   fs::path file(filename);
-  fs::path sigfile(filename + ".sig");
+  fs::path sigfile(filename + kSignatureExtension);
 
   auto signature(maidsafe::ReadFile(sigfile));
   if (!signature) {
@@ -437,7 +447,123 @@ T Get(std::string display_message, bool echo_input) {
 #pragma warning(pop)
 #endif
 
-int main() {
+// Reads the file list from 'target' if it's a manifest (one path per line, relative to the
+// manifest's directory), or writes one listing the regular files in 'target' if it's a directory.
+// Returns the paths of the listed files followed by that of the manifest, or an empty vector.
+std::vector<fs::path> GetBatchFiles(const fs::path& target) {
+  std::vector<std::string> names;
+  fs::path manifest(target);
+  boost::system::error_code error_code;
+  if (fs::is_directory(target, error_code)) {
+    manifest = target / kManifestFilename;
+    for (fs::directory_iterator itr(target, error_code), end; !error_code && itr != end;
+         itr.increment(error_code)) {
+      const std::string name(itr->path().filename().string());
+      if (fs::is_regular_file(itr->status()) && name != kManifestFilename &&
+          itr->path().extension() != kSignatureExtension) {
+        names.push_back(name);
+      }
+    }
+    if (error_code) {
+      std::cout << "error listing " << target << ": " << error_code.message() << '\n';
+      return std::vector<fs::path>();
+    }
+    std::sort(names.begin(), names.end());
+    std::string contents;
+    for (const auto& name : names)
+      contents += name + '\n';
+    if (names.empty() || !maidsafe::WriteFile(manifest, Bytes(contents.begin(), contents.end()))) {
+      std::cout << "error writing " << manifest << '\n';
+      return std::vector<fs::path>();
+    }
+  } else {
+    auto contents(maidsafe::ReadFile(manifest));
+    if (!contents) {
+      std::cout << "error reading " << manifest << '\n';
+      return std::vector<fs::path>();
+    }
+    std::istringstream lines(std::string(contents->begin(), contents->end()));
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (!line.empty())
+        names.push_back(line);
+    }
+  }
+
+  std::vector<fs::path> files;
+  for (const auto& name : names)
+    files.push_back(manifest.parent_path() / name);
+  files.push_back(manifest);
+  return files;
+}
+
+// Signs each file listed by GetBatchFiles, and the manifest itself, writing each signature to
+// "<file>.sig".  This is the layout which DownloadManager fetches and verifies.  The key is loaded
+// once, and the files (which SignFile maps rather than reads) are signed on all cores.
+int SignBatch(const fs::path& private_key_file, const fs::path& target) {
+  auto encoded_key(maidsafe::ReadFile(private_key_file));
+  if (!encoded_key) {
+    std::cout << "error reading " << private_key_file << '\n';
+    return -2;
+  }
+  const maidsafe::asymm::PrivateKey private_key(
+      maidsafe::asymm::DecodeKey(maidsafe::asymm::EncodedPrivateKey(*encoded_key)));
+  if (!maidsafe::asymm::ValidateKey(private_key)) {
+    std::cout << "private key invalid, aborting!!\n";
+    return -3;
+  }
+
+  const std::vector<fs::path> files(GetBatchFiles(target));
+  if (files.empty())
+    return -4;
+
+  std::vector<std::string> errors(files.size());
+  std::atomic<std::size_t> next_index(0);
+  auto sign([&] {
+    for (std::size_t i(next_index++); i < files.size(); i = next_index++) {
+      try {
+        const maidsafe::asymm::Signature signature(
+            maidsafe::asymm::SignFile(files[i], private_key));
+        if (!maidsafe::WriteFile(fs::path(files[i].string() + kSignatureExtension),
+                                 signature.string())) {
+          errors[i] = "error writing signature";
+        }
+      } catch (const std::exception& e) {
+        errors[i] = boost::diagnostic_information(e);
+      }
+    }
+  });
+  std::vector<std::future<void>> workers;
+  const std::size_t thread_count(std::min<std::size_t>(maidsafe::Concurrency(), files.size()));
+  for (std::size_t i(1); i < thread_count; ++i)
+    workers.push_back(std::async(std::launch::async, sign));
+  sign();
+  for (auto& worker : workers)
+    worker.get();
+
+  int failures(0);
+  for (std::size_t i(0); i != files.size(); ++i) {
+    if (errors[i].empty()) {
+      std::cout << "signed " << files[i].string() << '\n';
+    } else {
+      std::cout << "FAILED " << files[i].string() << ": " << errors[i] << '\n';
+      ++failures;
+    }
+  }
+  return failures == 0 ? 0 : -5;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    if (argc != 4 || std::string(argv[1]) != "--sign") {
+      std::cout << "Usage: " << argv[0] << " [--sign <private key file> <directory or manifest>]\n"
+                << "Runs interactively if no arguments are given.\n";
+      return -1;
+    }
+    return SignBatch(argv[2], argv[3]);
+  }
   for (;;) {
     Echo(true);
     std::cout << "_________________________________________________________________\n";
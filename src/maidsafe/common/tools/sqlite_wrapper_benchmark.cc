@@ -16,13 +16,81 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/program_options.hpp"
+
 #include "maidsafe/common/log.h"
 
 #include "maidsafe/common/tools/sqlite3_wrapper_benchmark.h"
 
+namespace po = boost::program_options;
+
 int main(int argc, char* argv[]) {
-  maidsafe::log::Logging::Instance().Initialise(argc, argv);
-  TLOG(kGreen) << "Running sqlite_wrapper benchmark test\n";
-  maidsafe::benchmark::Sqlite3WrapperBenchmark sqlite_wrapper_benchmark_test;
-  sqlite_wrapper_benchmark_test.Run();
+  auto unuseds(maidsafe::log::Logging::Instance().Initialise(argc, argv));
+  std::vector<std::string> unused_options;
+  for (const auto& unused : unuseds)
+    unused_options.emplace_back(&unused[0]);
+  // skip the first arg which is the path to this tool
+  unused_options.erase(std::begin(unused_options));
+
+  maidsafe::benchmark::Sqlite3WrapperBenchmark::Parameters parameters;
+  std::string json_output;
+  po::options_description options("SQLite wrapper benchmark options");
+  options.add_options()("help,h", "Show this help.")(
+      "rows", po::value<std::size_t>(&parameters.row_count)->default_value(parameters.row_count),
+      "Rows inserted by each scenario.")(
+      "value_size",
+      po::value<std::size_t>(&parameters.value_size)->default_value(parameters.value_size),
+      "Size of each key-value scenario value.")(
+      "blob_size",
+      po::value<std::size_t>(&parameters.blob_size)->default_value(parameters.blob_size),
+      "Size of each blob in the large blob scenario.")(
+      "readers",
+      po::value<int>(&parameters.reader_threads)->default_value(parameters.reader_threads),
+      "Reader threads in the mixed read/write scenario.")(
+      "writers",
+      po::value<int>(&parameters.writer_threads)->default_value(parameters.writer_threads),
+      "Writer threads in the concurrent scenarios (0 for each scenario's default).")(
+      "profile", po::value<std::string>(&parameters.profile)->default_value(parameters.profile),
+      "Connection settings: default, throughput, balanced or durable.")(
+      "json", po::value<std::string>(&json_output),
+      "Also write results as JSON to this file, or to stdout if \"-\".");
+
+  try {
+    po::variables_map variables_map;
+    po::store(po::command_line_parser(unused_options).options(options).run(), variables_map);
+    po::notify(variables_map);
+    if (variables_map.count("help")) {
+      std::cout << options << '\n';
+      return 0;
+    }
+  } catch (const std::exception& e) {
+    std::cout << e.what() << "\n\n" << options << '\n';
+    return -1;
+  }
+
+  try {
+    TLOG(kGreen) << "Running sqlite_wrapper benchmark test\n";
+    maidsafe::benchmark::Sqlite3WrapperBenchmark sqlite_wrapper_benchmark_test(parameters);
+    sqlite_wrapper_benchmark_test.Run();
+    if (json_output == "-") {
+      sqlite_wrapper_benchmark_test.WriteJson(std::cout);
+    } else if (!json_output.empty()) {
+      std::ofstream output(json_output, std::ios_base::trunc);
+      if (!output) {
+        TLOG(kRed) << "Failed to open " << json_output << '\n';
+        return -2;
+      }
+      sqlite_wrapper_benchmark_test.WriteJson(output);
+    }
+  } catch (const std::exception& e) {
+    TLOG(kRed) << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
 }
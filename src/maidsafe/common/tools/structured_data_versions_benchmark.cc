@@ -0,0 +1,351 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Benchmarks StructuredDataVersions at scale, and writes the results as JSON to stdout or to the
+// given file in the same layout as identity_benchmark, with two extra fields per result:
+// "bytes_per_version" (heap memory held per version once the tree is built; only set for "Put")
+// and "max_threads" (the most threads seen in the process while the benchmark ran, including the
+// main thread, so anything above 1 means the operation spawned threads).
+//
+// Trees of 1k to 1M versions are built in each of the following shapes:
+//  * "Chain": a single branch.
+//  * "Tree4": each version has up to 4 children, so most versions are "tips of trees".
+//  * "Tree4Orphans": as "Tree4", but every 10th version is put last, so its children arrive as
+//    orphans and are un-orphaned at the end.
+//  * "ChainChurn": a single branch with 'max_versions' a quarter of the versions put, so the root
+//    is replaced by three quarters of the Puts.
+//
+// Times are per version put, returned, serialised, applied or deleted.  Since a single call can
+// take seconds at the larger sizes, there's no warm-up call.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/config.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/data_types/structured_data_versions.h"
+
+// Tracks the heap memory held by this process, so that the benchmarks can report memory per
+// version.  Each allocation is prefixed by its size.
+std::atomic<std::int64_t> g_live_bytes(0);
+
+namespace {
+
+const std::size_t kAllocationHeader(alignof(std::max_align_t));
+
+}  // unnamed namespace
+
+void* operator new(std::size_t size) {
+  if (void* const memory = std::malloc(size + kAllocationHeader)) {
+    *static_cast<std::size_t*>(memory) = size;
+    g_live_bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+    return static_cast<char*>(memory) + kAllocationHeader;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* memory) MAIDSAFE_NOEXCEPT {
+  if (!memory)
+    return;
+  void* const allocation(static_cast<char*>(memory) - kAllocationHeader);
+  g_live_bytes.fetch_sub(static_cast<std::int64_t>(*static_cast<std::size_t*>(allocation)),
+                         std::memory_order_relaxed);
+  std::free(allocation);
+}
+
+void operator delete[](void* memory) MAIDSAFE_NOEXCEPT { operator delete(memory); }
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* memory, std::size_t) MAIDSAFE_NOEXCEPT { operator delete(memory); }
+
+void operator delete[](void* memory, std::size_t) MAIDSAFE_NOEXCEPT { operator delete(memory); }
+#endif
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+using VersionName = StructuredDataVersions::VersionName;
+
+// Each benchmark is repeated until it has run for at least this long.
+const std::chrono::milliseconds kMinimumDuration(200);
+const std::vector<std::size_t> kVersionCounts{1000, 10000, 100000, 1000000};
+// The number of branches retrieved by the "GetBranch" benchmark.
+const std::size_t kGetBranchCount(1024);
+const std::size_t kNoParent(static_cast<std::size_t>(-1));
+
+struct Scenario {
+  std::string name;
+  std::size_t branching_factor;
+  std::size_t orphan_period;  // Every nth version is put last.  0 for none.
+  bool churn;
+};
+
+const std::vector<Scenario> kScenarios{
+    {"Chain", 1, 0, false}, {"Tree4", 4, 0, false}, {"Tree4Orphans", 4, 10, false},
+    {"ChainChurn", 1, 0, true}};
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations;
+  double real_time;
+  double cpu_time;
+  double bytes_per_version;
+  std::size_t max_threads;
+};
+
+// Written to by every benchmarked operation so the compiler can't discard the work.
+volatile std::uint64_t g_sink(0);
+
+// Returns the number of threads in this process, or 0 where that can't be determined.
+std::size_t ThreadCount() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 8, "Threads:") == 0)
+      return static_cast<std::size_t>(std::stoul(line.substr(8)));
+  }
+  return 0;
+}
+
+// Polls the process's thread count every millisecond until stopped.
+class ThreadSampler {
+ public:
+  ThreadSampler()
+      : done_(false), max_threads_(0), sampler_([this] {
+          do {
+            max_threads_ = std::max(max_threads_, ThreadCount());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          } while (!done_);
+        }) {}
+
+  ~ThreadSampler() {
+    if (sampler_.joinable())
+      Stop();
+  }
+
+  // Returns the most threads seen, excluding the sampler's own.
+  std::size_t Stop() {
+    done_ = true;
+    sampler_.join();
+    return max_threads_ == 0 ? 0 : max_threads_ - 1;
+  }
+
+ private:
+  std::atomic<bool> done_;
+  std::size_t max_threads_;
+  std::thread sampler_;
+};
+
+// Calls 'setup' then 'functor' (which processes 'item_count' items per call) repeatedly until
+// 'functor' has run for at least kMinimumDuration, and returns the mean wall and CPU times per item
+// in nanoseconds.  'setup' isn't timed.
+template <typename Setup, typename Functor>
+Result Measure(const std::string& name, std::size_t item_count, Setup setup, Functor functor) {
+  ThreadSampler sampler;
+  std::uint64_t calls(0);
+  std::clock_t cpu_ticks(0);
+  Clock::duration elapsed(0);
+  do {
+    setup();
+    const std::clock_t cpu_start(std::clock());
+    const Clock::time_point start(Clock::now());
+    functor();
+    elapsed += Clock::now() - start;
+    cpu_ticks += std::clock() - cpu_start;
+    ++calls;
+  } while (elapsed < kMinimumDuration);
+  const double cpu_nanoseconds(static_cast<double>(cpu_ticks) * 1e9 / CLOCKS_PER_SEC);
+  const double real_nanoseconds(static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  const std::uint64_t iterations(calls * std::max(item_count, std::size_t(1)));
+  return Result{name, iterations, real_nanoseconds / iterations, cpu_nanoseconds / iterations, 0.0,
+                sampler.Stop()};
+}
+
+// Holds the versions of a scenario along with the order in which they're put, as pairs of indices
+// into 'names' of <parent, child>.
+struct Puts {
+  std::vector<VersionName> names;
+  std::vector<std::pair<std::size_t, std::size_t>> order;
+};
+
+Puts MakePuts(const Scenario& scenario, std::size_t version_count) {
+  Puts puts;
+  puts.names.reserve(version_count);
+  puts.order.reserve(version_count);
+  puts.names.emplace_back(0, MakeIdentity());
+  puts.order.emplace_back(kNoParent, 0);
+  std::vector<std::pair<std::size_t, std::size_t>> deferred;
+  for (std::size_t child(1); child != version_count; ++child) {
+    const std::size_t parent((child - 1) / scenario.branching_factor);
+    puts.names.emplace_back(puts.names[parent].index + 1, MakeIdentity());
+    if (scenario.orphan_period != 0 && child % scenario.orphan_period == 0)
+      deferred.emplace_back(parent, child);
+    else
+      puts.order.emplace_back(parent, child);
+  }
+  puts.order.insert(std::end(puts.order), std::begin(deferred), std::end(deferred));
+  return puts;
+}
+
+void PutAll(const Puts& puts, StructuredDataVersions& versions) {
+  for (const auto& put : puts.order) {
+    versions.Put(put.first == kNoParent ? VersionName() : puts.names[put.first],
+                 puts.names[put.second]);
+  }
+}
+
+void MeasureScenario(const Scenario& scenario, std::size_t version_count,
+                     std::vector<Result>& results) {
+  const std::string prefix(scenario.name + '/' + std::to_string(version_count) + '/');
+  const Puts puts(MakePuts(scenario, version_count));
+  const auto max_versions(static_cast<std::uint32_t>(scenario.churn ? version_count / 4
+                                                                    : version_count));
+  const auto max_branches(static_cast<std::uint32_t>(version_count));
+  const std::size_t held_count(std::min(version_count, std::size_t(max_versions)));
+  const auto noop([] {});
+  std::unique_ptr<StructuredDataVersions> versions;
+
+  results.push_back(Measure(
+      prefix + "Put", version_count,
+      [&] { versions.reset(new StructuredDataVersions(max_versions, max_branches)); },
+      [&] { PutAll(puts, *versions); }));
+
+  versions.reset();
+  const std::int64_t live_bytes_before(g_live_bytes.load());
+  versions.reset(new StructuredDataVersions(max_versions, max_branches));
+  PutAll(puts, *versions);
+  results.back().bytes_per_version =
+      static_cast<double>(g_live_bytes.load() - live_bytes_before) / held_count;
+  const StructuredDataVersions& built(*versions);
+
+  results.push_back(Measure(prefix + "Get", built.Get().size(), noop,
+                            [&] { g_sink = g_sink + built.Get().size(); }));
+
+  const std::vector<VersionName> tips(built.Get(kGetBranchCount));
+  std::size_t branch_versions(0);
+  for (const auto& tip : tips)
+    branch_versions += built.GetBranch(tip).size();
+  results.push_back(Measure(prefix + "GetBranch", branch_versions, noop, [&] {
+    for (const auto& tip : tips)
+      g_sink = g_sink + built.GetBranch(tip).size();
+  }));
+
+  results.push_back(Measure(prefix + "Serialise", held_count, noop,
+                            [&] { g_sink = g_sink + built.Serialise()->string().size(); }));
+
+  const StructuredDataVersions::serialised_type serialised(built.Serialise());
+  std::unique_ptr<StructuredDataVersions> target;
+  const auto parse([&] { target.reset(new StructuredDataVersions(serialised)); });
+  results.push_back(Measure(prefix + "ApplySerialised", held_count, parse,
+                            [&] { target->ApplySerialised(serialised); }));
+
+  results.push_back(Measure(prefix + "DeleteBranchUntilFork", held_count, parse, [&] {
+    for (auto tip(target->Get(1)); !tip.empty(); tip = target->Get(1))
+      target->DeleteBranchUntilFork(tip.front());
+  }));
+}
+
+std::vector<Result> RunAll() {
+  std::vector<Result> results;
+  for (const auto& scenario : kScenarios) {
+    for (const std::size_t version_count : kVersionCounts)
+      MeasureScenario(scenario, version_count, results);
+  }
+  return results;
+}
+
+void WriteJson(const std::vector<Result>& results, std::ostream& output) {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.iterations << ",\n"
+           << "      \"real_time\": " << result.real_time << ",\n"
+           << "      \"cpu_time\": " << result.cpu_time << ",\n"
+           << "      \"time_unit\": \"ns\",\n"
+           << "      \"bytes_per_version\": " << result.bytes_per_version << ",\n"
+           << "      \"max_threads\": " << result.max_threads << "\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+}  // unnamed namespace
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::cout << "Usage: " << argv[0] << " [<output file>]\n"
+              << "Writes JSON results to stdout if no output file is given.\n";
+    return -1;
+  }
+  try {
+    const auto results(maidsafe::benchmark::RunAll());
+    if (argc == 2) {
+      std::ofstream output(argv[1], std::ios_base::trunc);
+      if (!output) {
+        std::cout << "Failed to open " << argv[1] << '\n';
+        return -2;
+      }
+      maidsafe::benchmark::WriteJson(results, output);
+    } else {
+      maidsafe::benchmark::WriteJson(results, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
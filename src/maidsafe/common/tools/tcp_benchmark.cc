@@ -0,0 +1,372 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+// Measures tcp::Connection loopback throughput and latency, and writes the results as JSON to
+// stdout or to the given file in the same layout as identity_benchmark, with extra fields per
+// result: "messages_per_second" (round trips completed per second across all connections),
+// "bytes_per_second" (payload bytes carried in both directions per second) and RTT percentiles
+// "p50", "p90", "p99" and "max" in microseconds.
+//
+// A Listener and the given number of client Connections are run on one AsioService.  The server
+// side echoes every message back, and each client keeps 'depth' messages in flight, sending the
+// next as each echo arrives, for the given duration per message size.  A depth of 1 gives pure
+// round-trip latency; larger depths measure throughput with coalesced sends.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/exception/diagnostic_information.hpp"
+#include "boost/program_options.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/shared_buffer.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/tcp/connection.h"
+#include "maidsafe/common/tcp/listener.h"
+
+namespace po = boost::program_options;
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Config {
+  int threads, connections, depth;
+  std::chrono::milliseconds duration;
+  std::vector<std::size_t> message_sizes;
+};
+
+struct Result {
+  std::string name;
+  std::uint64_t round_trips;
+  double seconds, messages_per_second, bytes_per_second, p50, p90, p99, max;
+};
+
+// One client connection's state.  Guarded by 'mutex' since sends are made both from the main thread
+// (to fill the pipeline) and from the connection's receive handler.
+struct Client {
+  tcp::ConnectionPtr connection;
+  std::mutex mutex;
+  std::deque<Clock::time_point> send_times;
+  std::vector<Clock::duration> round_trip_times;
+};
+
+// Nearest-rank percentile of 'sorted', in microseconds.
+double Percentile(const std::vector<Clock::duration>& sorted, double fraction) {
+  if (sorted.empty())
+    return 0.0;
+  const auto rank(static_cast<std::size_t>(std::ceil(fraction * sorted.size())));
+  const Clock::duration latency(sorted[std::max<std::size_t>(rank, 1) - 1]);
+  return std::chrono::duration<double, std::micro>(latency).count();
+}
+
+class LoopbackBenchmark {
+ public:
+  explicit LoopbackBenchmark(const Config& config)
+      : config_(config),
+        asio_service_(config.threads),
+        server_strand_(asio_service_.service()),
+        client_strands_(),
+        mutex_(),
+        condition_(),
+        servers_(),
+        clients_(),
+        listener_(),
+        stop_time_(Clock::time_point::max()),
+        outstanding_(0),
+        message_() {}
+
+  ~LoopbackBenchmark() {
+    for (const auto& client : clients_)
+      client->connection->Close();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& server : servers_)
+        server->Close();
+    }
+    if (listener_)
+      listener_->StopListening();
+    asio_service_.Stop();
+  }
+
+  void Connect() {
+    listener_ = tcp::Listener::MakeShared(
+        server_strand_, [this](tcp::ConnectionPtr connection) { OnNewConnection(connection); },
+        tcp::Port{7777});
+    for (int i(0); i < config_.connections; ++i) {
+      client_strands_.emplace_back(new asio::io_service::strand(asio_service_.service()));
+      std::shared_ptr<Client> client(std::make_shared<Client>());
+      Client* const raw_client(client.get());
+      client->connection =
+          tcp::Connection::MakeShared(*client_strands_.back(), listener_->ListeningPort());
+      client->connection->SetMaxMessageSize(MaxSize());
+      client->connection->Start([this, raw_client](tcp::Message) { OnEcho(*raw_client); }, [] {});
+      clients_.push_back(std::move(client));
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!condition_.wait_for(lock, std::chrono::seconds(10), [&] {
+          return servers_.size() == clients_.size();
+        })) {
+      LOG(kError) << "Timed out waiting for connections to be accepted.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+    }
+  }
+
+  Result Run(std::size_t message_size) {
+    message_ = SharedBuffer(RandomBytes(message_size));
+    for (const auto& client : clients_)
+      client->round_trip_times.clear();
+    const Clock::time_point start(Clock::now());
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_time_ = start + config_.duration;
+      outstanding_ = static_cast<std::uint64_t>(config_.connections) * config_.depth;
+    }
+    for (const auto& client : clients_) {
+      std::lock_guard<std::mutex> lock(client->mutex);
+      for (int i(0); i < config_.depth; ++i) {
+        if (!SendLocked(*client))
+          BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!condition_.wait_for(lock, config_.duration + std::chrono::seconds(30),
+                             [&] { return outstanding_ == 0; })) {
+      LOG(kError) << "Timed out waiting for echoes.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+    }
+    const double seconds(std::chrono::duration<double>(Clock::now() - start).count());
+    lock.unlock();
+
+    std::vector<Clock::duration> round_trip_times;
+    for (const auto& client : clients_) {
+      std::lock_guard<std::mutex> client_lock(client->mutex);
+      round_trip_times.insert(round_trip_times.end(), client->round_trip_times.begin(),
+                              client->round_trip_times.end());
+    }
+    std::sort(round_trip_times.begin(), round_trip_times.end());
+    const std::uint64_t round_trips(round_trip_times.size());
+    return Result{"Loopback/" + std::to_string(message_size) + "/connections:" +
+                      std::to_string(config_.connections) + "/depth:" +
+                      std::to_string(config_.depth),
+                  round_trips,
+                  seconds,
+                  round_trips / seconds,
+                  2.0 * round_trips * message_size / seconds,
+                  Percentile(round_trip_times, 0.5),
+                  Percentile(round_trip_times, 0.9),
+                  Percentile(round_trip_times, 0.99),
+                  Percentile(round_trip_times, 1.0)};
+  }
+
+ private:
+  std::size_t MaxSize() const {
+    return std::max(*std::max_element(config_.message_sizes.begin(), config_.message_sizes.end()),
+                    tcp::Connection::MaxMessageSize());
+  }
+
+  void OnNewConnection(tcp::ConnectionPtr connection) {
+    tcp::Connection* const raw_connection(connection.get());
+    connection->SetMaxMessageSize(MaxSize());
+    connection->Start(
+        [raw_connection](tcp::Message message) { raw_connection->Send(std::move(message)); },
+        [] {});
+    std::lock_guard<std::mutex> lock(mutex_);
+    servers_.push_back(std::move(connection));
+    condition_.notify_all();
+  }
+
+  bool SendLocked(Client& client) {
+    client.send_times.push_back(Clock::now());
+    if (client.connection->Send(message_))
+      return true;
+    LOG(kError) << "Failed to send message.";
+    client.send_times.pop_back();
+    return false;
+  }
+
+  void OnEcho(Client& client) {
+    const Clock::time_point now(Clock::now());
+    {
+      std::lock_guard<std::mutex> lock(client.mutex);
+      if (client.send_times.empty())
+        return;
+      client.round_trip_times.push_back(now - client.send_times.front());
+      client.send_times.pop_front();
+      // 'stop_time_' is only written while no messages are in flight.
+      if (now < stop_time_ && SendLocked(client))
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--outstanding_ == 0)
+      condition_.notify_all();
+  }
+
+  const Config config_;
+  AsioService asio_service_;
+  asio::io_service::strand server_strand_;
+  std::vector<std::unique_ptr<asio::io_service::strand>> client_strands_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<tcp::ConnectionPtr> servers_;
+  std::vector<std::shared_ptr<Client>> clients_;
+  tcp::ListenerPtr listener_;
+  Clock::time_point stop_time_;
+  std::uint64_t outstanding_;
+  SharedBuffer message_;
+};
+
+std::vector<Result> RunAll(const Config& config) {
+  LoopbackBenchmark benchmark(config);
+  benchmark.Connect();
+  std::vector<Result> results;
+  for (const std::size_t message_size : config.message_sizes) {
+    results.push_back(benchmark.Run(message_size));
+    const Result& result(results.back());
+    TLOG(kCyan) << result.name << ": " << result.messages_per_second << " msgs/s, "
+                << result.bytes_per_second / (1024 * 1024) << " MB/s, RTT p50 " << result.p50
+                << " us, p99 " << result.p99 << " us\n";
+  }
+  return results;
+}
+
+void WriteJson(const Config& config, const std::vector<Result>& results, std::ostream& output) {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+         << "    \"threads\": " << config.threads << ",\n"
+         << "    \"connections\": " << config.connections << ",\n"
+         << "    \"depth\": " << config.depth << ",\n"
+         << "    \"duration_ms\": " << config.duration.count() << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    const double per_round_trip(result.round_trips == 0 ? 0.0 : result.seconds * 1e9 /
+                                                                    result.round_trips);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.round_trips << ",\n"
+           << "      \"real_time\": " << per_round_trip << ",\n"
+           << "      \"cpu_time\": " << per_round_trip << ",\n"
+           << "      \"time_unit\": \"ns\",\n"
+           << "      \"messages_per_second\": " << result.messages_per_second << ",\n"
+           << "      \"bytes_per_second\": " << result.bytes_per_second << ",\n"
+           << "      \"p50\": " << result.p50 << ",\n"
+           << "      \"p90\": " << result.p90 << ",\n"
+           << "      \"p99\": " << result.p99 << ",\n"
+           << "      \"max\": " << result.max << "\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+}  // unnamed namespace
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
+
+int main(int argc, char* argv[]) {
+  maidsafe::benchmark::Config config;
+  int duration_ms(0);
+  std::string output_path;
+  po::options_description options("Options");
+  options.add_options()("help,h", "Show this help.")(
+      "threads", po::value<int>(&config.threads)->default_value(2),
+      "Threads running the AsioService.")(
+      "connections", po::value<int>(&config.connections)->default_value(4),
+      "Client connections to the listener.")(
+      "depth", po::value<int>(&config.depth)->default_value(8),
+      "Messages each client keeps in flight.")(
+      "duration", po::value<int>(&duration_ms)->default_value(2000),
+      "Milliseconds to run each message size for.")(
+      "sizes", po::value<std::vector<std::size_t>>(&config.message_sizes)->multitoken(),
+      "Message sizes in bytes (default 64 1024 65536 and MaxMessageSize()).")(
+      "output", po::value<std::string>(&output_path), "JSON results file (default stdout).");
+  po::positional_options_description positional;
+  positional.add("output", 1);
+  try {
+    po::variables_map variables;
+    po::store(po::command_line_parser(argc, argv).options(options).positional(positional).run(),
+              variables);
+    po::notify(variables);
+    if (variables.count("help") || config.threads < 1 || config.connections < 1 ||
+        config.depth < 1 || duration_ms < 1) {
+      std::cout << "Usage: " << argv[0] << " [options] [<output file>]\n" << options << '\n';
+      return -1;
+    }
+  } catch (const std::exception& e) {
+    std::cout << e.what() << "\n\n" << options << '\n';
+    return -1;
+  }
+  config.duration = std::chrono::milliseconds(duration_ms);
+  if (config.message_sizes.empty()) {
+    config.message_sizes = {64, 1024, 64 * 1024, maidsafe::tcp::Connection::MaxMessageSize()};
+  }
+  if (std::count(config.message_sizes.begin(), config.message_sizes.end(), 0U) != 0) {
+    std::cout << "Message sizes must be non-zero.\n";
+    return -1;
+  }
+
+  try {
+    const auto results(maidsafe::benchmark::RunAll(config));
+    if (!output_path.empty()) {
+      std::ofstream output(output_path, std::ios_base::trunc);
+      if (!output) {
+        std::cout << "Failed to open " << output_path << '\n';
+        return -2;
+      }
+      maidsafe::benchmark::WriteJson(config, results, output);
+    } else {
+      maidsafe::benchmark::WriteJson(config, results, std::cout);
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Benchmark failed: " << boost::diagnostic_information(e) << '\n';
+    return -3;
+  }
+  return 0;
+}
@@ -0,0 +1,436 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tools/hot_path_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "boost/property_tree/json_parser.hpp"
+#include "boost/property_tree/ptree.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/data_buffer.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/common/containers/lru_cache.h"
+#include "maidsafe/common/data_types/data.h"
+#include "maidsafe/common/serialisation/serialisation.h"
+#include "maidsafe/common/tcp/connection.h"
+#include "maidsafe/common/tcp/listener.h"
+#include "maidsafe/common/tools/sqlite3_wrapper_benchmark.h"
+
+namespace maidsafe {
+
+namespace benchmark {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Written to by every benchmarked operation so the compiler can't discard the work.
+volatile std::uint64_t g_sink(0);
+
+double NanosecondsPerUnit(const std::string& time_unit) {
+  if (time_unit == "ns")
+    return 1.0;
+  if (time_unit == "us")
+    return 1e3;
+  if (time_unit == "ms")
+    return 1e6;
+  if (time_unit == "s")
+    return 1e9;
+  LOG(kError) << "Unknown time unit \"" << time_unit << "\"";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+}
+
+std::vector<Data::NameAndTypeId> MakeKeys(std::size_t count) {
+  std::vector<Data::NameAndTypeId> keys;
+  keys.reserve(count);
+  for (std::size_t i(0); i != count; ++i)
+    keys.emplace_back(MakeIdentity(), DataTypeId{static_cast<std::uint32_t>(i % 8)});
+  return keys;
+}
+
+}  // unnamed namespace
+
+HotPathBenchmark::Parameters::Parameters()
+    : minimum_duration(200), repetitions(5), value_size(1024), include_sqlite(true) {}
+
+HotPathBenchmark::HotPathBenchmark() : HotPathBenchmark(Parameters()) {}
+
+HotPathBenchmark::HotPathBenchmark(Parameters parameters_in)
+    : parameters(std::move(parameters_in)), results() {
+  if (parameters.repetitions < 1 || parameters.value_size == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+void HotPathBenchmark::Run() {
+  results.clear();
+  LruCacheAddAndGet();
+  DataBufferStoreAndGet();
+  TcpLoopback();
+  CryptoHashAndSymmEncrypt();
+  RsaSignAndCheck();
+  SerialiseAndParse();
+  if (parameters.include_sqlite)
+    Sqlite();
+}
+
+// Calls 'functor' (which processes 'batch_size' items per call) repeatedly for the minimum
+// duration, once per repetition, and records the repetition with the median wall time per item.
+template <typename Functor>
+void HotPathBenchmark::Measure(const std::string& name, std::size_t batch_size, Functor functor) {
+  functor();  // warm up
+  std::vector<Result> repetitions;
+  for (int repetition(0); repetition != parameters.repetitions; ++repetition) {
+    std::uint64_t calls(0);
+    const std::clock_t cpu_start(std::clock());
+    const Clock::time_point start(Clock::now());
+    Clock::time_point now(start);
+    while (now - start < parameters.minimum_duration) {
+      functor();
+      ++calls;
+      now = Clock::now();
+    }
+    const double cpu_nanoseconds(static_cast<double>(std::clock() - cpu_start) * 1e9 /
+                                 CLOCKS_PER_SEC);
+    const double real_nanoseconds(static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count()));
+    const std::uint64_t iterations(calls * batch_size);
+    repetitions.push_back(Result{name, iterations, real_nanoseconds / iterations,
+                                 cpu_nanoseconds / iterations});
+  }
+  auto median(std::begin(repetitions) + repetitions.size() / 2);
+  std::nth_element(std::begin(repetitions), median, std::end(repetitions),
+                   [](const Result& lhs, const Result& rhs) {
+                     return lhs.real_time < rhs.real_time;
+                   });
+  TLOG(kCyan) << name << ": " << median->real_time << " ns/op (" << median->iterations
+              << " iterations)\n";
+  results.push_back(*median);
+}
+
+void HotPathBenchmark::LruCacheAddAndGet() {
+  // Twice as many keys as the cache's capacity, so that adding them all evicts on every add.
+  const std::size_t kCapacity(1024);
+  std::vector<std::string> keys;
+  for (std::size_t i(0); i != kCapacity * 2; ++i)
+    keys.push_back(RandomAlphaNumericString(64));
+  const std::string value(RandomString(parameters.value_size));
+  LruCache<std::string, std::string> cache(kCapacity, std::chrono::steady_clock::duration::zero());
+
+  Measure("LruCache/AddEvicting", keys.size(), [&] {
+    for (const auto& key : keys)
+      cache.Add(key, value);
+  });
+
+  Measure("LruCache/GetHit", kCapacity, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(kCapacity); i != keys.size(); ++i)
+      total += cache.Get(keys[i]) ? 1 : 0;
+    g_sink = g_sink + total;
+  });
+
+  Measure("LruCache/GetMiss", kCapacity, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kCapacity; ++i)
+      total += cache.Get(keys[i]) ? 1 : 0;
+    g_sink = g_sink + total;
+  });
+}
+
+void HotPathBenchmark::DataBufferStoreAndGet() {
+  const std::size_t kBatchSize(256);
+  const std::vector<Data::NameAndTypeId> keys(MakeKeys(kBatchSize));
+  const NonEmptyString value(RandomString(parameters.value_size));
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
+  // Memory alone can hold a whole batch, so these time the memory store and the hand-off to the
+  // background workers rather than the disk itself.
+  DataBuffer buffer(MemoryUsage(kBatchSize * parameters.value_size * 2),
+                    DiskUsage(kBatchSize * parameters.value_size * 8), nullptr,
+                    *test_path / "data_buffer");
+
+  Measure("DataBuffer/StoreAndDelete", kBatchSize, [&] {
+    for (const auto& key : keys)
+      buffer.Store(key, value);
+    for (const auto& key : keys)
+      buffer.Delete(key);
+  });
+
+  for (const auto& key : keys)
+    buffer.Store(key, value);
+  Measure("DataBuffer/Get", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (const auto& key : keys)
+      total += buffer.Get(key).string().size();
+    g_sink = g_sink + total;
+  });
+}
+
+void HotPathBenchmark::TcpLoopback() {
+  const std::size_t kBatchSize(256);
+  AsioService asio_service(2);
+  asio::io_service::strand client_strand(asio_service.service());
+  asio::io_service::strand server_strand(asio_service.service());
+  std::mutex mutex;
+  std::condition_variable received_condition;
+  std::uint64_t received(0);
+
+  std::promise<tcp::ConnectionPtr> server_promise;
+  tcp::ListenerPtr listener{tcp::Listener::MakeShared(
+      server_strand,
+      [&](tcp::ConnectionPtr connection) { server_promise.set_value(std::move(connection)); },
+      tcp::Port{7777})};
+  tcp::ConnectionPtr client{tcp::Connection::MakeShared(client_strand, listener->ListeningPort())};
+  client->Start([](tcp::Message) {}, [] {});
+  tcp::ConnectionPtr server{server_promise.get_future().get()};
+  server->Start(
+      [&](tcp::Message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++received % kBatchSize == 0)
+          received_condition.notify_one();
+      },
+      [] {});
+
+  const tcp::Message message(RandomBytes(parameters.value_size));
+  std::uint64_t sent(0);
+  Measure("TcpConnection/LoopbackSend", kBatchSize, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      client->Send(message);
+    sent += kBatchSize;
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!received_condition.wait_for(lock, std::chrono::seconds(10),
+                                     [&] { return received == sent; })) {
+      LOG(kError) << "Timed out waiting for loopback messages.";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+    }
+  });
+
+  client->Close();
+  server->Close();
+  listener->StopListening();
+  asio_service.Stop();
+}
+
+void HotPathBenchmark::CryptoHashAndSymmEncrypt() {
+  const std::size_t kBatchSize(64);
+  const crypto::PlainText plain_text(RandomString(parameters.value_size));
+  const crypto::AES256KeyAndIV key_and_iv(
+      RandomBytes(crypto::AES256_KeySize + crypto::AES256_IVSize));
+  const crypto::CipherText cipher_text(crypto::SymmEncrypt(plain_text, key_and_iv));
+
+  Measure("Crypto/HashSHA512", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += crypto::Hash<crypto::SHA512>(plain_text).string()[0];
+    g_sink = g_sink + total;
+  });
+
+  Measure("Crypto/SymmEncrypt", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += crypto::SymmEncrypt(plain_text, key_and_iv)->string().size();
+    g_sink = g_sink + total;
+  });
+
+  std::vector<byte> buffer(parameters.value_size + crypto::AES256_TagSize);
+  Measure("Crypto/SymmEncryptInPlace", kBatchSize, [&] {
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      crypto::SymmEncrypt(buffer.data(), parameters.value_size, key_and_iv, buffer.data());
+    g_sink = g_sink + buffer[0];
+  });
+
+  Measure("Crypto/SymmDecrypt", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += crypto::SymmDecrypt(cipher_text, key_and_iv).string().size();
+    g_sink = g_sink + total;
+  });
+}
+
+void HotPathBenchmark::RsaSignAndCheck() {
+  const std::size_t kBatchSize(4);
+  const rsa::Keys keys(rsa::GenerateKeyPair());
+  const rsa::PlainText plain_text(RandomString(parameters.value_size));
+  const rsa::Signature signature(rsa::Sign(plain_text, keys.private_key));
+
+  Measure("Rsa/Sign", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += rsa::Sign(plain_text, keys.private_key).string()[0];
+    g_sink = g_sink + total;
+  });
+
+  Measure("Rsa/CheckSignature", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += rsa::CheckSignature(plain_text, signature, keys.public_key) ? 1 : 0;
+    g_sink = g_sink + total;
+  });
+}
+
+void HotPathBenchmark::SerialiseAndParse() {
+  const std::size_t kBatchSize(64);
+  std::map<std::string, std::string> map;
+  for (int i(0); i != 16; ++i)
+    map[RandomAlphaNumericString(32)] = RandomString(parameters.value_size / 16 + 1);
+  const std::vector<std::string> strings(16, RandomString(parameters.value_size / 16 + 1));
+  const SerialisedData serialised(Serialise(map, strings));
+
+  Measure("Serialisation/Serialise", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i)
+      total += Serialise(map, strings).size();
+    g_sink = g_sink + total;
+  });
+
+  SerialisedData buffer;
+  Measure("Serialisation/SerialiseInto", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      SerialiseInto(buffer, map, strings);
+      total += buffer.size();
+    }
+    g_sink = g_sink + total;
+  });
+
+  Measure("Serialisation/Parse", kBatchSize, [&] {
+    std::uint64_t total(0);
+    for (std::size_t i(0); i != kBatchSize; ++i) {
+      InputVectorStream binary_input_stream(serialised);
+      total += Parse<std::map<std::string, std::string>>(binary_input_stream).size();
+      total += Parse<std::vector<std::string>>(binary_input_stream).size();
+    }
+    g_sink = g_sink + total;
+  });
+}
+
+void HotPathBenchmark::Sqlite() {
+  // A reduced run: enough rows to reach steady state, few enough to keep the suite quick.
+  Sqlite3WrapperBenchmark::Parameters sqlite_parameters;
+  sqlite_parameters.row_count = 1000;
+  sqlite_parameters.value_size = parameters.value_size;
+  sqlite_parameters.blob_size = 64 * 1024;
+  Sqlite3WrapperBenchmark sqlite_benchmark(sqlite_parameters);
+  sqlite_benchmark.Run();
+  // The sqlite scenarios are each run once and don't measure CPU time, so their wall time is
+  // reported for both.
+  for (const auto& result : sqlite_benchmark.GetResults()) {
+    const std::size_t operations(std::max<std::size_t>(result.operations, 1));
+    const double real_time(result.seconds * 1e9 / operations);
+    results.push_back(Result{"Sqlite/" + result.name, operations, real_time, real_time});
+  }
+}
+
+void HotPathBenchmark::WriteJson(std::ostream& output) const {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+         << "    \"minimum_duration_ms\": " << parameters.minimum_duration.count() << ",\n"
+         << "    \"repetitions\": " << parameters.repetitions << ",\n"
+         << "    \"value_size\": " << parameters.value_size << ",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.iterations << ",\n"
+           << "      \"real_time\": " << result.real_time << ",\n"
+           << "      \"cpu_time\": " << result.cpu_time << ",\n"
+           << "      \"time_unit\": \"ns\"\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+std::vector<HotPathBenchmark::Comparison> HotPathBenchmark::CompareWith(
+    const boost::filesystem::path& baseline, double threshold) const {
+  std::map<std::string, double> baseline_times;
+  try {
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(baseline.string(), tree);
+    for (const auto& child : tree.get_child("benchmarks")) {
+      const boost::property_tree::ptree& benchmark(child.second);
+      baseline_times[benchmark.get<std::string>("name")] =
+          benchmark.get<double>("real_time") *
+          NanosecondsPerUnit(benchmark.get<std::string>("time_unit", "ns"));
+    }
+  } catch (const boost::property_tree::ptree_error& error) {
+    LOG(kError) << "Failed to read baseline " << baseline << ": " << error.what();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+
+  std::vector<Comparison> comparisons;
+  for (const auto& result : results) {
+    const auto itr(baseline_times.find(result.name));
+    if (itr == baseline_times.end() || itr->second <= 0.0)
+      continue;
+    const double change((result.real_time - itr->second) / itr->second);
+    comparisons.push_back(
+        Comparison{result.name, itr->second, result.real_time, change, change > threshold});
+  }
+  return comparisons;
+}
+
+std::size_t ReportComparisons(const std::vector<HotPathBenchmark::Comparison>& comparisons) {
+  std::size_t regressions(0);
+  for (const auto& comparison : comparisons) {
+    if (comparison.regression) {
+      TLOG(kRed) << comparison.name << ": " << comparison.baseline_time << " -> "
+                 << comparison.current_time << " ns/op (+" << comparison.change * 100.0
+                 << "%)  REGRESSION\n";
+    } else {
+      TLOG(kDefaultColour) << comparison.name << ": " << comparison.baseline_time << " -> "
+                           << comparison.current_time << " ns/op ("
+                           << (comparison.change > 0.0 ? "+" : "") << comparison.change * 100.0
+                           << "%)\n";
+    }
+    if (comparison.regression)
+      ++regressions;
+  }
+  if (regressions == 0)
+    TLOG(kGreen) << comparisons.size() << " benchmarks compared, none regressed.\n";
+  else
+    TLOG(kRed) << comparisons.size() << " benchmarks compared, " << regressions << " regressed.\n";
+  return regressions;
+}
+
+}  // namespace benchmark
+
+}  // namespace maidsafe
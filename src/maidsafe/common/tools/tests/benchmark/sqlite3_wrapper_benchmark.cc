@@ -18,24 +18,109 @@
 
 #include "maidsafe/common/tools/sqlite3_wrapper_benchmark.h"
 
-// #include "boost/filesystem/operations.hpp"
-
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/test.h"
 
 namespace maidsafe {
 
 namespace benchmark {
 
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Collects latency samples from any number of threads.
+class LatencyRecorder {
+ public:
+  template <typename Functor>
+  void Time(Functor functor) {
+    const Clock::time_point start(Clock::now());
+    functor();
+    const Clock::duration elapsed(Clock::now() - start);
+    std::lock_guard<std::mutex> lock(mutex);
+    latencies.push_back(elapsed);
+  }
+
+  std::vector<Clock::duration> Take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::move(latencies);
+  }
+
+ private:
+  std::mutex mutex;
+  std::vector<Clock::duration> latencies;
+};
+
+// Runs 'functor' on 'thread_count' threads at once, and waits for them all to finish.
+void RunConcurrently(int thread_count, const std::function<void()>& functor) {
+  std::vector<std::future<void>> futures;
+  for (int i(0); i < thread_count; ++i)
+    futures.push_back(std::async(std::launch::async, functor));
+  for (auto& future : futures)
+    future.get();
+}
+
+// Nearest-rank percentile of 'sorted', in microseconds.
+double Percentile(const std::vector<Clock::duration>& sorted, double fraction) {
+  if (sorted.empty())
+    return 0.0;
+  const auto rank(static_cast<std::size_t>(std::ceil(fraction * sorted.size())));
+  const Clock::duration latency(sorted[std::max<std::size_t>(rank, 1) - 1]);
+  return std::chrono::duration<double, std::micro>(latency).count();
+}
+
+sqlite::Options OptionsForProfile(const std::string& profile) {
+  if (profile == "default")
+    return sqlite::Options();
+  if (profile == "throughput")
+    return sqlite::Options::Throughput();
+  if (profile == "balanced")
+    return sqlite::Options::Balanced();
+  if (profile == "durable")
+    return sqlite::Options::Durable();
+  TLOG(kRed) << "Unknown profile \"" << profile << "\"\n";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+}
+
+}  // unnamed namespace
+
+Sqlite3WrapperBenchmark::Parameters::Parameters()
+    : row_count(10000),
+      value_size(512),
+      blob_size(1024 * 1024),
+      reader_threads(4),
+      writer_threads(0),
+      profile("default") {}
+
 Sqlite3WrapperBenchmark::Sqlite3WrapperBenchmark()
-    : database_path(), ticking_clock(), ten_thousand_strings() {}
+    : Sqlite3WrapperBenchmark(Parameters()) {}
+
+Sqlite3WrapperBenchmark::Sqlite3WrapperBenchmark(Parameters parameters_in)
+    : parameters(std::move(parameters_in)),
+      options(OptionsForProfile(parameters.profile)),
+      database_path(),
+      all_endpoint_strings(),
+      key_value_pairs(),
+      results() {}
 
 void Sqlite3WrapperBenchmark::Run() {
   maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_TestUtils"));
   database_path = boost::filesystem::path(*test_path / "sqlite_wrapper_benchmark");
-  for (int i(0); i < 10000; ++i)
-    ten_thousand_strings.push_back(RandomAlphaNumericString(20));
+  results.clear();
+  all_endpoint_strings.clear();
+  for (std::size_t i(0); i < parameters.row_count; ++i)
+    all_endpoint_strings.push_back(RandomAlphaNumericString(20));
 
   EndpointStringsSingleTransaction();
+  EndpointStringsBulkInsert();
   EndpointStringsIndividualTransaction();
   EndpointStringsConcurrentInsertions();
   EndpointStringsConcurrentDeletes();
@@ -44,135 +129,248 @@ void Sqlite3WrapperBenchmark::Run() {
   //                             and value length to be around 20
   // Datamanager use Db which have key length to be around 64, but the value is vector
   //             of IDs, miniumn to be 4, makes the value length to be at least 256
-  for (int i(0); i < 10000; ++i)
-    key_value_pairs[RandomAlphaNumericString(130)] = RandomAlphaNumericString(512);
+  key_value_pairs.clear();
+  while (key_value_pairs.size() < parameters.row_count) {
+    key_value_pairs[RandomAlphaNumericString(130)] =
+        RandomAlphaNumericString(parameters.value_size);
+  }
 
   KeyValueIndividualTransaction();
+  KeyValueBulkInsert();
   // When SQLite bing used for personas, each persona can has its own table or even database.
   // So the concurrent situation depending on the program configuration only,
   // the chance of high number of concurrency is low, so only tested with 4 threads.
   KeyValueConcurrentInsertions();
+  KeyValueGroupCommitInsertions();
   KeyValueConcurrentUpdates();
+  KeyValueMixedReadWrite();
+  LargeBlobs();
+}
+
+void Sqlite3WrapperBenchmark::WriteJson(std::ostream& output) const {
+  char date[32];
+  const std::time_t now(std::time(nullptr));
+  std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+  output << "{\n  \"context\": {\n"
+         << "    \"date\": \"" << date << "\",\n"
+         << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+         << "    \"row_count\": " << parameters.row_count << ",\n"
+         << "    \"value_size\": " << parameters.value_size << ",\n"
+         << "    \"blob_size\": " << parameters.blob_size << ",\n"
+         << "    \"reader_threads\": " << parameters.reader_threads << ",\n"
+         << "    \"writer_threads\": " << parameters.writer_threads << ",\n"
+         << "    \"profile\": \"" << parameters.profile << "\",\n"
+#ifdef NDEBUG
+         << "    \"library_build_type\": \"release\"\n"
+#else
+         << "    \"library_build_type\": \"debug\"\n"
+#endif
+         << "  },\n  \"benchmarks\": [";
+  for (std::size_t i(0); i != results.size(); ++i) {
+    const Result& result(results[i]);
+    const double operations(static_cast<double>(std::max<std::size_t>(result.operations, 1)));
+    output << (i == 0 ? "\n" : ",\n") << "    {\n"
+           << "      \"name\": \"" << result.name << "\",\n"
+           << "      \"iterations\": " << result.operations << ",\n"
+           << "      \"real_time\": " << result.seconds * 1e6 / operations << ",\n"
+           << "      \"time_unit\": \"us\",\n"
+           << "      \"items_per_second\": "
+           << (result.seconds > 0 ? operations / result.seconds : 0.0) << ",\n"
+           << "      \"samples\": " << result.samples << ",\n"
+           << "      \"p50\": " << result.p50 << ",\n"
+           << "      \"p90\": " << result.p90 << ",\n"
+           << "      \"p99\": " << result.p99 << ",\n"
+           << "      \"max\": " << result.max << "\n"
+           << "    }";
+  }
+  output << "\n  ]\n}\n";
+}
+
+int Sqlite3WrapperBenchmark::WriterThreads(int scenario_default) const {
+  return parameters.writer_threads > 0 ? parameters.writer_threads : scenario_default;
+}
+
+void Sqlite3WrapperBenchmark::Report(const std::string& name, std::size_t operations,
+                                     Clock::duration elapsed, Latencies latencies) {
+  std::sort(std::begin(latencies), std::end(latencies));
+  Result result{name,
+                operations,
+                latencies.size(),
+                std::chrono::duration<double>(elapsed).count(),
+                Percentile(latencies, 0.5),
+                Percentile(latencies, 0.9),
+                Percentile(latencies, 0.99),
+                Percentile(latencies, 1.0)};
+  TLOG(kGreen) << name << " completed " << operations << " operations in " << result.seconds
+               << " seconds; latency (us) p50 " << result.p50 << ", p90 " << result.p90
+               << ", p99 " << result.p99 << ", max " << result.max << '\n';
+  results.push_back(std::move(result));
 }
 
 void Sqlite3WrapperBenchmark::EndpointStringsSingleTransaction() {
-  TLOG(kGreen) << "\nInserting 10k endpoint strings within one transaction\n";
+  TLOG(kGreen) << "\nInserting " << all_endpoint_strings.size()
+               << " endpoint strings within one transaction\n";
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
   {
-    ticking_clock.restart();
-    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
     std::string query(
         "CREATE TABLE IF NOT EXISTS EndpointStringsSingleTransaction ("
         "ENDPOINT TEXT  PRIMARY KEY NOT NULL);");
     PrepareTable(database, query);
-    sqlite::Transaction transaction{database};
-    AddRemoveEndpointStrings(
-        database, ten_thousand_strings,
-        "INSERT OR REPLACE INTO EndpointStringsSingleTransaction (ENDPOINT) VALUES (?)");
-    transaction.Commit();
+    recorder.Time([&] {
+      sqlite::Transaction transaction{database};
+      AddRemoveEndpointStrings(
+          database, all_endpoint_strings,
+          "INSERT OR REPLACE INTO EndpointStringsSingleTransaction (ENDPOINT) VALUES (?)");
+      transaction.Commit();
+    });
   }
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
-  CheckEndpointStringsTestResult(ten_thousand_strings,
+  Report("EndpointStringsSingleTransaction", all_endpoint_strings.size(), Clock::now() - start,
+         recorder.Take());
+  CheckEndpointStringsTestResult(all_endpoint_strings,
                                  "SELECT * from EndpointStringsSingleTransaction");
 }
 
-void Sqlite3WrapperBenchmark::EndpointStringsIndividualTransaction() {
-  TLOG(kGreen) << "\nInserting 10k endpoint strings, individual transaction for each\n";
+void Sqlite3WrapperBenchmark::EndpointStringsBulkInsert() {
+  TLOG(kGreen) << "\nInserting " << all_endpoint_strings.size()
+               << " endpoint strings within one transaction, using multi-row statements\n";
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
   {
-    ticking_clock.restart();
-    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
     std::string query(
-        "CREATE TABLE IF NOT EXISTS EndpointStringsIndividualTransaction ("
+        "CREATE TABLE IF NOT EXISTS EndpointStringsBulkInsert ("
         "ENDPOINT TEXT  PRIMARY KEY NOT NULL);");
     PrepareTable(database, query);
-    for (const auto& endpoint_string : ten_thousand_strings) {
+    recorder.Time([&] {
       sqlite::Transaction transaction{database};
-      std::vector<std::string> endpoint_string_vector(1, endpoint_string);
-      AddRemoveEndpointStrings(
-          database, endpoint_string_vector,
-          "INSERT OR REPLACE INTO EndpointStringsIndividualTransaction (ENDPOINT) VALUES (?)");
+      BulkInsertEndpointStrings(database, all_endpoint_strings,
+                                "INSERT OR REPLACE INTO EndpointStringsBulkInsert (ENDPOINT)");
       transaction.Commit();
+    });
+  }
+  Report("EndpointStringsBulkInsert", all_endpoint_strings.size(), Clock::now() - start,
+         recorder.Take());
+  CheckEndpointStringsTestResult(all_endpoint_strings, "SELECT * from EndpointStringsBulkInsert");
+}
+
+void Sqlite3WrapperBenchmark::EndpointStringsIndividualTransaction() {
+  TLOG(kGreen) << "\nInserting " << all_endpoint_strings.size()
+               << " endpoint strings, individual transaction for each\n";
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
+  {
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
+    std::string query(
+        "CREATE TABLE IF NOT EXISTS EndpointStringsIndividualTransaction ("
+        "ENDPOINT TEXT  PRIMARY KEY NOT NULL);");
+    PrepareTable(database, query);
+    for (const auto& endpoint_string : all_endpoint_strings) {
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        std::vector<std::string> endpoint_string_vector(1, endpoint_string);
+        AddRemoveEndpointStrings(
+            database, endpoint_string_vector,
+            "INSERT OR REPLACE INTO EndpointStringsIndividualTransaction (ENDPOINT) VALUES (?)");
+        transaction.Commit();
+      });
     }
   }
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
-  CheckEndpointStringsTestResult(ten_thousand_strings,
+  Report("EndpointStringsIndividualTransaction", all_endpoint_strings.size(), Clock::now() - start,
+         recorder.Take());
+  CheckEndpointStringsTestResult(all_endpoint_strings,
                                  "SELECT * from EndpointStringsIndividualTransaction");
 }
 
 void Sqlite3WrapperBenchmark::EndpointStringsConcurrentInsertions() {
-  TLOG(kGreen) << "\nInserting 10k endpoint strings with 20 concurrent threads,"
-               << " and individual transaction for each string\n";
-
-  ticking_clock.restart();
-  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+  const int thread_count(WriterThreads(20));
+  TLOG(kGreen) << "\nInserting " << all_endpoint_strings.size() << " endpoint strings with "
+               << thread_count << " concurrent threads, and individual transaction for each"
+               << " string\n";
+
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
+  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
   std::string query(
       "CREATE TABLE IF NOT EXISTS EndpointStringsConcurrentInsertions ("
       "ENDPOINT TEXT  PRIMARY KEY NOT NULL);");
   PrepareTable(database, query);
 
   std::mutex mutex;
-  size_t thread_count(20), index(0);
-  maidsafe::test::RunInParallel(static_cast<int>(thread_count - 1), [&] {
-    for (size_t i(0); i < (ten_thousand_strings.size() / thread_count); ++i) {
+  size_t index(0);
+  RunConcurrently(thread_count, [&] {
+    for (;;) {
       std::vector<std::string> endpoint_string_vector;
       {
         std::lock_guard<std::mutex> lock{mutex};
-        endpoint_string_vector.push_back(ten_thousand_strings.at(index));
+        if (index == all_endpoint_strings.size())
+          return;
+        endpoint_string_vector.push_back(all_endpoint_strings.at(index));
         ++index;
       }
-      sqlite::Transaction transaction{database};
-      AddRemoveEndpointStrings(
-          database, endpoint_string_vector,
-          "INSERT OR REPLACE INTO EndpointStringsConcurrentInsertions (ENDPOINT) VALUES (?)");
-      transaction.Commit();
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        AddRemoveEndpointStrings(
+            database, endpoint_string_vector,
+            "INSERT OR REPLACE INTO EndpointStringsConcurrentInsertions (ENDPOINT) VALUES (?)");
+        transaction.Commit();
+      });
     }
   });
   LOG(kVerbose) << "index : " << index;
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
-  CheckEndpointStringsTestResult(ten_thousand_strings,
+  Report("EndpointStringsConcurrentInsertions", all_endpoint_strings.size(), Clock::now() - start,
+         recorder.Take());
+  CheckEndpointStringsTestResult(all_endpoint_strings,
                                  "SELECT * from EndpointStringsConcurrentInsertions", false);
 }
 
 void Sqlite3WrapperBenchmark::EndpointStringsConcurrentDeletes() {
-  TLOG(kGreen) << "\nConcurrent Deletion (20 threads) from the database"
-               << " containing 10k endpoint strings\n";
-  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+  const int thread_count(WriterThreads(20));
+  TLOG(kGreen) << "\nConcurrent Deletion (" << thread_count << " threads) from the database"
+               << " containing " << all_endpoint_strings.size() << " endpoint strings\n";
+  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
   std::string query(
       "CREATE TABLE IF NOT EXISTS EndpointStringsConcurrentDeletes ("
       "ENDPOINT TEXT  PRIMARY KEY NOT NULL);");
   PrepareTable(database, query);
   {
-    // populate the database with 10k entries
+    // populate the database
     sqlite::Transaction transaction{database};
-    AddRemoveEndpointStrings(
-        database, ten_thousand_strings,
-        "INSERT OR REPLACE INTO EndpointStringsConcurrentDeletes (ENDPOINT) VALUES (?)");
+    BulkInsertEndpointStrings(database, all_endpoint_strings,
+                              "INSERT OR REPLACE INTO EndpointStringsConcurrentDeletes (ENDPOINT)");
     transaction.Commit();
   }
 
-  ticking_clock.restart();
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
   std::mutex mutex;
-  size_t thread_count(20), index(0);
-  maidsafe::test::RunInParallel(static_cast<int>(thread_count - 1), [&] {
-    for (size_t i(0); i < (ten_thousand_strings.size() / thread_count); ++i) {
+  size_t index(0);
+  RunConcurrently(thread_count, [&] {
+    for (;;) {
       std::vector<std::string> endpoint_string_vector;
       {
         std::lock_guard<std::mutex> lock{mutex};
+        if (index == all_endpoint_strings.size())
+          return;
         LOG(kVerbose) << index;
-        endpoint_string_vector.push_back(ten_thousand_strings.at(index));
+        endpoint_string_vector.push_back(all_endpoint_strings.at(index));
         ++index;
       }
-      sqlite::Transaction transaction{database};
-      AddRemoveEndpointStrings(database, endpoint_string_vector,
-                               "DELETE From EndpointStringsConcurrentDeletes WHERE ENDPOINT=?");
-      transaction.Commit();
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        AddRemoveEndpointStrings(database, endpoint_string_vector,
+                                 "DELETE From EndpointStringsConcurrentDeletes WHERE ENDPOINT=?");
+        transaction.Commit();
+      });
     }
   });
   LOG(kVerbose) << "index : " << index;
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
+  Report("EndpointStringsConcurrentDeletes", all_endpoint_strings.size(), Clock::now() - start,
+         recorder.Take());
   CheckEndpointStringsTestResult(std::vector<std::string>(),
                                  "SELECT * from EndpointStringsConcurrentDeletes");
 }
-
 void Sqlite3WrapperBenchmark::CheckEndpointStringsTestResult(
     const std::vector<std::string>& expected_result, std::string query, bool check_order,
     bool check_content, bool check_size) {
@@ -186,7 +384,7 @@ void Sqlite3WrapperBenchmark::CheckEndpointStringsTestResult(
   if (check_content) {
     if (check_order) {
       for (size_t i(0); i < std::min(result.size(), expected_result.size()); ++i)
-        if (result.at(i) != ten_thousand_strings.at(i)) {
+        if (result.at(i) != all_endpoint_strings.at(i)) {
           TLOG(kRed) << "entry stored with dis-order\n";
           break;
         }
@@ -228,9 +426,18 @@ void Sqlite3WrapperBenchmark::AddRemoveEndpointStrings(
   }
 }
 
+void Sqlite3WrapperBenchmark::BulkInsertEndpointStrings(
+    sqlite::Database& database, const std::vector<std::string>& endpoint_strings,
+    std::string insert_into) {
+  sqlite::BulkInsert(database, insert_into, 1, endpoint_strings.size(),
+                     [&](sqlite::Statement& statement, std::size_t row, int first_index) {
+                       statement.BindText(first_index, endpoint_strings[row]);
+                     });
+}
+
 void Sqlite3WrapperBenchmark::ReadEndpointStrings(std::vector<std::string>& result,
                                                   std::string query) {
-  sqlite::Database database{database_path, sqlite::Mode::kReadOnly};
+  sqlite::Database database{database_path, sqlite::Mode::kReadOnly, options};
   sqlite::Statement statement{database, query};
   for (;;)
     if (statement.Step() == sqlite::StepResult::kSqliteRow)
@@ -239,102 +446,298 @@ void Sqlite3WrapperBenchmark::ReadEndpointStrings(std::vector<std::string>& resu
       break;
 }
 
+
 void Sqlite3WrapperBenchmark::KeyValueIndividualTransaction() {
-  TLOG(kGreen) << "\nInserting 10k key_value_pairs, individual transaction for each\n";
+  TLOG(kGreen) << "\nInserting " << key_value_pairs.size()
+               << " key_value_pairs, individual transaction for each\n";
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
   {
-    ticking_clock.restart();
-    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
     std::string query(
         "CREATE TABLE IF NOT EXISTS KeyValueIndividualTransaction ("
         "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
     PrepareTable(database, query);
     for (const auto& key_value_pair : key_value_pairs) {
-      sqlite::Transaction transaction{database};
-      InsertKeyValuePair(
-          database, key_value_pair,
-          "INSERT OR REPLACE INTO KeyValueIndividualTransaction (KEY, VALUE) VALUES (?, ?)");
-      transaction.Commit();
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        InsertKeyValuePair(
+            database, key_value_pair,
+            "INSERT OR REPLACE INTO KeyValueIndividualTransaction (KEY, VALUE) VALUES (?, ?)");
+        transaction.Commit();
+      });
     }
   }
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
+  Report("KeyValueIndividualTransaction", key_value_pairs.size(), Clock::now() - start,
+         recorder.Take());
   CheckKeyValueTestResult(key_value_pairs, "SELECT * from KeyValueIndividualTransaction");
 }
 
-void Sqlite3WrapperBenchmark::KeyValueConcurrentInsertions() {
-  TLOG(kGreen) << "\nInserting 10k key_value pairs with 4 concurrent threads,"
-               << " and individual transaction for each string\n";
+void Sqlite3WrapperBenchmark::KeyValueBulkInsert() {
+  TLOG(kGreen) << "\nInserting " << key_value_pairs.size()
+               << " key_value pairs within one transaction, using multi-row statements\n";
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
+  {
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
+    std::string query(
+        "CREATE TABLE IF NOT EXISTS KeyValueBulkInsert ("
+        "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
+    PrepareTable(database, query);
+    recorder.Time([&] {
+      sqlite::Transaction transaction{database};
+      BulkInsertKeyValuePairs(database, "INSERT OR REPLACE INTO KeyValueBulkInsert (KEY, VALUE)");
+      transaction.Commit();
+    });
+  }
+  Report("KeyValueBulkInsert", key_value_pairs.size(), Clock::now() - start, recorder.Take());
+  CheckKeyValueTestResult(key_value_pairs, "SELECT * from KeyValueBulkInsert");
+}
 
-  ticking_clock.restart();
-  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+void Sqlite3WrapperBenchmark::KeyValueConcurrentInsertions() {
+  const int thread_count(WriterThreads(4));
+  TLOG(kGreen) << "\nInserting " << key_value_pairs.size() << " key_value pairs with "
+               << thread_count << " concurrent threads, and individual transaction for each"
+               << " string\n";
+
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
+  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
   std::string query(
       "CREATE TABLE IF NOT EXISTS KeyValueConcurrentInsertions ("
       "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
   PrepareTable(database, query);
 
   std::mutex mutex;
-  size_t thread_count(4), index(0);
-  maidsafe::test::RunInParallel(static_cast<int>(thread_count - 1), [&] {
-    for (size_t i(0); i < (key_value_pairs.size() / thread_count); ++i) {
-      auto itr(key_value_pairs.begin());
+  auto next(key_value_pairs.begin());
+  RunConcurrently(thread_count, [&] {
+    for (;;) {
+      auto itr(key_value_pairs.end());
       {
         std::lock_guard<std::mutex> lock{mutex};
-        LOG(kVerbose) << index;
-        std::advance(itr, index);
-        ++index;
+        if (next == key_value_pairs.end())
+          return;
+        itr = next++;
       }
-      sqlite::Transaction transaction{database};
-      InsertKeyValuePair(
-          database, *itr,
-          "INSERT OR REPLACE INTO KeyValueConcurrentInsertions (KEY, VALUE) VALUES (?, ?)");
-      transaction.Commit();
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        InsertKeyValuePair(
+            database, *itr,
+            "INSERT OR REPLACE INTO KeyValueConcurrentInsertions (KEY, VALUE) VALUES (?, ?)");
+        transaction.Commit();
+      });
     }
   });
-  LOG(kVerbose) << "index : " << index;
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
+  Report("KeyValueConcurrentInsertions", key_value_pairs.size(), Clock::now() - start,
+         recorder.Take());
   CheckKeyValueTestResult(key_value_pairs, "SELECT * from KeyValueConcurrentInsertions");
 }
 
+void Sqlite3WrapperBenchmark::KeyValueGroupCommitInsertions() {
+  const int thread_count(WriterThreads(4));
+  TLOG(kGreen) << "\nInserting " << key_value_pairs.size() << " key_value pairs with "
+               << thread_count << " concurrent threads, via a group-commit writer\n";
+
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
+  {
+    sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
+    std::string query(
+        "CREATE TABLE IF NOT EXISTS KeyValueGroupCommitInsertions ("
+        "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
+    PrepareTable(database, query);
+  }
+
+  sqlite::GroupCommitWriter writer(database_path, sqlite::Mode::kReadWrite,
+                                   sqlite::GroupCommitWriter::kDefaultMaxDelay,
+                                   sqlite::GroupCommitWriter::kDefaultMaxBatchSize, options);
+  std::mutex mutex;
+  auto next(key_value_pairs.begin());
+  RunConcurrently(thread_count, [&] {
+    for (;;) {
+      auto itr(key_value_pairs.end());
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (next == key_value_pairs.end())
+          return;
+        itr = next++;
+      }
+      // Each caller waits for its own insertion to be committed, as it would with a transaction.
+      recorder.Time([&] {
+        writer.Enqueue([this, itr](sqlite::Database& database) {
+          InsertKeyValuePair(
+              database, *itr,
+              "INSERT OR REPLACE INTO KeyValueGroupCommitInsertions (KEY, VALUE) VALUES (?, ?)");
+        }).get();
+      });
+    }
+  });
+  Report("KeyValueGroupCommitInsertions", key_value_pairs.size(), Clock::now() - start,
+         recorder.Take());
+  CheckKeyValueTestResult(key_value_pairs, "SELECT * from KeyValueGroupCommitInsertions");
+}
+
 void Sqlite3WrapperBenchmark::KeyValueConcurrentUpdates() {
-  TLOG(kGreen) << "\nUpdating 10k times with 4 concurrent threads,"
-               << " inside a database containing 10k key_vaule pairs\n";
+  const int thread_count(WriterThreads(4));
+  TLOG(kGreen) << "\nUpdating " << key_value_pairs.size() << " times with " << thread_count
+               << " concurrent threads, inside a database containing " << key_value_pairs.size()
+               << " key_vaule pairs\n";
 
-  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate);
+  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
   std::string query(
       "CREATE TABLE IF NOT EXISTS KeyValueConcurrentUpdates ("
       "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
   PrepareTable(database, query);
-  for (const auto& key_value_pair : key_value_pairs) {
+  {
     sqlite::Transaction transaction{database};
-    InsertKeyValuePair(
-        database, key_value_pair,
-        "INSERT OR REPLACE INTO KeyValueConcurrentUpdates (KEY, VALUE) VALUES (?, ?)");
+    BulkInsertKeyValuePairs(database,
+                            "INSERT OR REPLACE INTO KeyValueConcurrentUpdates (KEY, VALUE)");
     transaction.Commit();
   }
 
-  ticking_clock.restart();
+  LatencyRecorder recorder;
+  const Clock::time_point start(Clock::now());
   std::mutex mutex;
-  size_t thread_count(4), index(0);
-  maidsafe::test::RunInParallel(static_cast<int>(thread_count - 1), [&] {
-    for (size_t i(0); i < (key_value_pairs.size() / thread_count); ++i) {
-      auto itr(key_value_pairs.begin());
+  size_t index(0);
+  RunConcurrently(thread_count, [&] {
+    for (;;) {
+      std::pair<std::string, std::string> key_value_pair;
       {
         std::lock_guard<std::mutex> lock{mutex};
+        if (index == key_value_pairs.size())
+          return;
         LOG(kVerbose) << index;
-        std::advance(itr, RandomInt32() % key_value_pairs.size());
-        key_value_pairs[itr->first] = RandomAlphaNumericString(512);
+        auto itr(key_value_pairs.begin());
+        std::advance(itr, RandomUint32() % key_value_pairs.size());
+        itr->second = RandomAlphaNumericString(parameters.value_size);
+        key_value_pair = *itr;
         ++index;
       }
-      sqlite::Transaction transaction{database};
-      UpdateKeyValuePair(database, *itr,
-                         "UPDATE KeyValueConcurrentUpdates SET VALUE=? WHERE KEY=?");
-      transaction.Commit();
+      recorder.Time([&] {
+        sqlite::Transaction transaction{database};
+        UpdateKeyValuePair(database, key_value_pair,
+                           "UPDATE KeyValueConcurrentUpdates SET VALUE=? WHERE KEY=?");
+        transaction.Commit();
+      });
     }
   });
   LOG(kVerbose) << "index : " << index;
-  TLOG(kGreen) << "test completed in " << ticking_clock.elapsed() << " seconds\n";
+  Report("KeyValueConcurrentUpdates", key_value_pairs.size(), Clock::now() - start,
+         recorder.Take());
+  // Concurrent updates of the same key may reach the database in a different order than they were
+  // made to 'key_value_pairs', so mismatched values are possible here.
   CheckKeyValueTestResult(key_value_pairs, "SELECT * from KeyValueConcurrentUpdates");
 }
 
+void Sqlite3WrapperBenchmark::KeyValueMixedReadWrite() {
+  const int writer_count(WriterThreads(4));
+  TLOG(kGreen) << "\nUpdating " << key_value_pairs.size() << " times with " << writer_count
+               << " writer threads while " << parameters.reader_threads << " reader threads"
+               << " look up random keys, using a connection pool\n";
+
+  sqlite::ConnectionPool pool(database_path, static_cast<std::size_t>(parameters.reader_threads),
+                              sqlite::Mode::kReadWriteCreate, options);
+  PrepareTable(pool.Writer(),
+               "CREATE TABLE IF NOT EXISTS KeyValueMixedReadWrite ("
+               "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
+  {
+    sqlite::Transaction transaction{pool.Writer()};
+    BulkInsertKeyValuePairs(pool.Writer(),
+                            "INSERT OR REPLACE INTO KeyValueMixedReadWrite (KEY, VALUE)");
+    transaction.Commit();
+  }
+  std::vector<const std::string*> keys;
+  keys.reserve(key_value_pairs.size());
+  for (const auto& key_value_pair : key_value_pairs)
+    keys.push_back(&key_value_pair.first);
+
+  LatencyRecorder read_recorder, write_recorder;
+  std::atomic<bool> writing(true);
+  std::atomic<std::size_t> read_count(0), missing_count(0), write_index(0);
+  const Clock::time_point start(Clock::now());
+  std::vector<std::future<void>> readers;
+  for (int i(0); i < parameters.reader_threads; ++i) {
+    readers.push_back(std::async(std::launch::async, [&] {
+      while (writing) {
+        const std::string& key(*keys[RandomUint32() % keys.size()]);
+        read_recorder.Time([&] {
+          pool.Read([&](sqlite::Database& database) {
+            sqlite::Statement statement{database,
+                                        "SELECT VALUE FROM KeyValueMixedReadWrite WHERE KEY=?"};
+            statement.BindText(1, key);
+            if (statement.Step() != sqlite::StepResult::kSqliteRow)
+              ++missing_count;
+          });
+        });
+        ++read_count;
+      }
+    }));
+  }
+  RunConcurrently(writer_count, [&] {
+    while (write_index++ < keys.size()) {
+      const std::pair<std::string, std::string> key_value_pair(
+          *keys[RandomUint32() % keys.size()], RandomAlphaNumericString(parameters.value_size));
+      write_recorder.Time([&] {
+        sqlite::Transaction transaction{pool.Writer()};
+        UpdateKeyValuePair(pool.Writer(), key_value_pair,
+                           "UPDATE KeyValueMixedReadWrite SET VALUE=? WHERE KEY=?");
+        transaction.Commit();
+      });
+    }
+  });
+  writing = false;
+  for (auto& reader : readers)
+    reader.get();
+  const Clock::duration elapsed(Clock::now() - start);
+  Report("KeyValueMixedReadWrite/Write", key_value_pairs.size(), elapsed, write_recorder.Take());
+  Report("KeyValueMixedReadWrite/Read", read_count, elapsed, read_recorder.Take());
+  if (missing_count != 0)
+    TLOG(kRed) << missing_count << " lookups failed to find their key\n";
+}
+
+void Sqlite3WrapperBenchmark::LargeBlobs() {
+  const std::size_t blob_count(std::max<std::size_t>(parameters.row_count / 100, 10));
+  TLOG(kGreen) << "\nInserting then reading " << blob_count << " blobs of "
+               << parameters.blob_size << " bytes, individual transaction for each\n";
+
+  sqlite::Database database(database_path, sqlite::Mode::kReadWriteCreate, options);
+  PrepareTable(database,
+               "CREATE TABLE IF NOT EXISTS LargeBlobs ("
+               "KEY TEXT  PRIMARY KEY NOT NULL, VALUE BLOB NOT NULL);");
+  const SerialisedData blob(RandomBytes(parameters.blob_size));
+
+  LatencyRecorder recorder;
+  Clock::time_point start(Clock::now());
+  for (std::size_t i(0); i != blob_count; ++i) {
+    recorder.Time([&] {
+      sqlite::Transaction transaction{database};
+      sqlite::Statement statement{database,
+                                  "INSERT OR REPLACE INTO LargeBlobs (KEY, VALUE) VALUES (?, ?)"};
+      statement.BindText(1, std::to_string(i));
+      statement.BindBlobStatic(2, blob);
+      statement.Step();
+      transaction.Commit();
+    });
+  }
+  Report("LargeBlobs/Write", blob_count, Clock::now() - start, recorder.Take());
+
+  std::size_t mismatch_count(0);
+  start = Clock::now();
+  for (std::size_t i(0); i != blob_count; ++i) {
+    recorder.Time([&] {
+      sqlite::Statement statement{database, "SELECT VALUE FROM LargeBlobs WHERE KEY=?"};
+      statement.BindText(1, std::to_string(i));
+      if (statement.Step() != sqlite::StepResult::kSqliteRow ||
+          statement.ColumnBlobView(0).size != blob.size()) {
+        ++mismatch_count;
+      }
+    });
+  }
+  Report("LargeBlobs/Read", blob_count, Clock::now() - start, recorder.Take());
+  if (mismatch_count != 0)
+    TLOG(kRed) << mismatch_count << " blobs were missing or the wrong size\n";
+}
+
 void Sqlite3WrapperBenchmark::InsertKeyValuePair(sqlite::Database& database,
                                                  std::pair<std::string, std::string> key_value_pair,
                                                  std::string query) {
@@ -345,9 +748,22 @@ void Sqlite3WrapperBenchmark::InsertKeyValuePair(sqlite::Database& database,
   statement.Reset();
 }
 
+void Sqlite3WrapperBenchmark::BulkInsertKeyValuePairs(sqlite::Database& database,
+                                                      std::string insert_into) {
+  std::vector<const std::pair<const std::string, std::string>*> rows;
+  rows.reserve(key_value_pairs.size());
+  for (const auto& key_value_pair : key_value_pairs)
+    rows.push_back(&key_value_pair);
+  sqlite::BulkInsert(database, insert_into, 2, rows.size(),
+                     [&](sqlite::Statement& statement, std::size_t row, int first_index) {
+                       statement.BindText(first_index, rows[row]->first);
+                       statement.BindText(first_index + 1, rows[row]->second);
+                     });
+}
+
 void Sqlite3WrapperBenchmark::ReadKeyValuePairs(std::map<std::string, std::string>& result,
                                                 std::string query) {
-  sqlite::Database database{database_path, sqlite::Mode::kReadOnly};
+  sqlite::Database database{database_path, sqlite::Mode::kReadOnly, options};
   sqlite::Statement statement{database, query};
   for (;;)
     if (statement.Step() == sqlite::StepResult::kSqliteRow)
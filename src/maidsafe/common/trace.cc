@@ -0,0 +1,244 @@
+/*  Copyright 2015 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+
+namespace maidsafe {
+
+namespace trace {
+
+namespace {
+
+#ifdef _MSC_VER
+#define MAIDSAFE_TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define MAIDSAFE_TRACE_THREAD_LOCAL __thread
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t kDefaultCapacity = 65536;
+
+// The current context of each thread, and its index (plus one, so 0 means not yet assigned).
+MAIDSAFE_TRACE_THREAD_LOCAL uint64_t g_current_trace_id(0);
+MAIDSAFE_TRACE_THREAD_LOCAL uint64_t g_current_span_id(0);
+MAIDSAFE_TRACE_THREAD_LOCAL uint32_t g_thread_index(0);
+
+// A ring buffer slot, written and read as a seqlock: 'sequence' is 0 while the slot is being
+// written, and otherwise one more than the position of the span it holds.  The fields are atomics
+// (accessed with relaxed ordering) only so that concurrent reads and writes are well defined.
+struct Slot {
+  Slot()
+      : sequence(0), name(nullptr), trace_id(0), span_id(0), parent_span_id(0), start(0),
+        duration(0), thread(0) {}
+  std::atomic<uint64_t> sequence;
+  std::atomic<const char*> name;
+  std::atomic<uint64_t> trace_id, span_id, parent_span_id;
+  std::atomic<int64_t> start, duration;
+  std::atomic<uint32_t> thread;
+};
+
+struct RingBuffer {
+  explicit RingBuffer(size_t capacity_in) : capacity(capacity_in), slots(new Slot[capacity]) {}
+  const size_t capacity;
+  const std::unique_ptr<Slot[]> slots;
+};
+
+std::atomic<bool> g_enabled(false);
+std::mutex g_buffer_mutex;
+size_t g_capacity(kDefaultCapacity);
+std::unique_ptr<RingBuffer> g_buffer_owner;
+std::atomic<RingBuffer*> g_buffer(nullptr);
+std::atomic<uint64_t> g_next_position(0);
+std::atomic<uint32_t> g_next_thread_index(0);
+const Clock::time_point g_epoch(Clock::now());
+
+uint64_t NewId() {
+  // IDs are a mixed (splitmix64) counter from a random start, so they're unique within the process
+  // and unlikely to collide with those of other processes.
+  static std::atomic<uint64_t> counter(((static_cast<uint64_t>(std::random_device()()) << 32) |
+                                        std::random_device()()));
+  uint64_t id(counter.fetch_add(0x9e3779b97f4a7c15ULL, std::memory_order_relaxed));
+  id = (id ^ (id >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  id = (id ^ (id >> 27)) * 0x94d049bb133111ebULL;
+  id ^= id >> 31;
+  return id == 0 ? 1 : id;
+}
+
+uint32_t ThisThreadIndex() {
+  if (g_thread_index == 0)
+    g_thread_index = ++g_next_thread_index;
+  return g_thread_index - 1;
+}
+
+int64_t SinceEpoch(Clock::time_point time_point) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time_point - g_epoch).count();
+}
+
+void Record(const char* name, uint64_t trace_id, uint64_t span_id, uint64_t parent_span_id,
+            Clock::time_point start, Clock::time_point end) {
+  RingBuffer* const buffer(g_buffer.load(std::memory_order_acquire));
+  if (!buffer)
+    return;
+  const uint64_t position(g_next_position.fetch_add(1, std::memory_order_relaxed));
+  Slot& slot(buffer->slots[position % buffer->capacity]);
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.trace_id.store(trace_id, std::memory_order_relaxed);
+  slot.span_id.store(span_id, std::memory_order_relaxed);
+  slot.parent_span_id.store(parent_span_id, std::memory_order_relaxed);
+  slot.start.store(SinceEpoch(start), std::memory_order_relaxed);
+  slot.duration.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+                      std::memory_order_relaxed);
+  slot.thread.store(ThisThreadIndex(), std::memory_order_relaxed);
+  slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+void SetCurrent(SpanContext context) {
+  g_current_trace_id = context.trace_id;
+  g_current_span_id = context.span_id;
+}
+
+void WriteEscaped(const char* text, std::ostream& output) {
+  for (; *text; ++text) {
+    if (*text == '"' || *text == '\\')
+      output << '\\';
+    output << *text;
+  }
+}
+
+}  // unnamed namespace
+
+void Enable(bool enable) {
+  if (enable) {
+    std::lock_guard<std::mutex> lock(g_buffer_mutex);
+    if (!g_buffer_owner) {
+      g_buffer_owner.reset(new RingBuffer(g_capacity));
+      g_buffer.store(g_buffer_owner.get(), std::memory_order_release);
+    }
+  }
+  g_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool IsEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void SetCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(g_buffer_mutex);
+  g_capacity = std::max<size_t>(capacity, 1);
+  if (g_buffer_owner) {
+    g_buffer_owner.reset(new RingBuffer(g_capacity));
+    g_buffer.store(g_buffer_owner.get(), std::memory_order_release);
+  }
+  g_next_position.store(0, std::memory_order_relaxed);
+}
+
+SpanContext CurrentContext() { return SpanContext(g_current_trace_id, g_current_span_id); }
+
+ScopedContext::ScopedContext(SpanContext context) : previous_(CurrentContext()) {
+  SetCurrent(context);
+}
+
+ScopedContext::~ScopedContext() { SetCurrent(previous_); }
+
+Span::Span(const char* name)
+    : name_(name), context_(), previous_(), parent_span_id_(0), start_() {
+  if (!IsEnabled())
+    return;
+  previous_ = CurrentContext();
+  parent_span_id_ = previous_.span_id;
+  context_ = SpanContext(previous_.IsValid() ? previous_.trace_id : NewId(), NewId());
+  SetCurrent(context_);
+  start_ = Clock::now();
+}
+
+Span::~Span() {
+  if (!context_.IsValid())
+    return;
+  const Clock::time_point end(Clock::now());
+  SetCurrent(previous_);
+  if (IsEnabled())
+    Record(name_, context_.trace_id, context_.span_id, parent_span_id_, start_, end);
+}
+
+void RecordSpan(const char* name, SpanContext parent, Clock::time_point start,
+                Clock::time_point end) {
+  if (parent.IsValid() && IsEnabled())
+    Record(name, parent.trace_id, NewId(), parent.span_id, start, end);
+}
+
+std::vector<SpanRecord> RecordedSpans() {
+  std::vector<std::pair<uint64_t, SpanRecord>> sequenced;
+  RingBuffer* const buffer(g_buffer.load(std::memory_order_acquire));
+  if (buffer) {
+    for (size_t i(0); i != buffer->capacity; ++i) {
+      const Slot& slot(buffer->slots[i]);
+      const uint64_t sequence(slot.sequence.load(std::memory_order_acquire));
+      if (sequence == 0)
+        continue;
+      SpanRecord record;
+      record.name = slot.name.load(std::memory_order_relaxed);
+      record.trace_id = slot.trace_id.load(std::memory_order_relaxed);
+      record.span_id = slot.span_id.load(std::memory_order_relaxed);
+      record.parent_span_id = slot.parent_span_id.load(std::memory_order_relaxed);
+      record.start = slot.start.load(std::memory_order_relaxed);
+      record.duration = slot.duration.load(std::memory_order_relaxed);
+      record.thread = slot.thread.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // Skip the slot if it was overwritten while being read.
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+        sequenced.emplace_back(sequence, record);
+    }
+  }
+  std::sort(sequenced.begin(), sequenced.end(),
+            [](const std::pair<uint64_t, SpanRecord>& lhs,
+               const std::pair<uint64_t, SpanRecord>& rhs) { return lhs.first < rhs.first; });
+  std::vector<SpanRecord> spans;
+  spans.reserve(sequenced.size());
+  for (const auto& entry : sequenced)
+    spans.push_back(entry.second);
+  return spans;
+}
+
+void WriteChromeTrace(const std::vector<SpanRecord>& spans, std::ostream& output) {
+  const std::ios_base::fmtflags flags(output.flags());
+  output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (size_t i(0); i != spans.size(); ++i) {
+    const SpanRecord& span(spans[i]);
+    output << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+    WriteEscaped(span.name ? span.name : "", output);
+    output << std::dec << std::fixed << std::setprecision(3)
+           << "\",\"cat\":\"maidsafe\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.thread
+           << ",\"ts\":" << span.start / 1000.0 << ",\"dur\":" << span.duration / 1000.0
+           << ",\"args\":{\"trace_id\":\"" << std::hex << span.trace_id << "\",\"span_id\":\""
+           << span.span_id << "\",\"parent_span_id\":\"" << span.parent_span_id << "\"}}";
+  }
+  output << "\n]}\n";
+  output.flags(flags);
+}
+
+}  // namespace trace
+
+}  // namespace maidsafe
@@ -0,0 +1,148 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/tree_hash.h"
+
+#include <algorithm>
+#include <future>
+
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace crypto {
+
+namespace {
+
+const byte kLeafPrefix(0);
+const byte kParentPrefix(1);
+
+void HashLeaf(const byte* input, size_t length, byte* digest) {
+  CryptoPP::SHA512 hash;
+  hash.Update(&kLeafPrefix, 1);
+  hash.Update(input, length);
+  hash.Final(digest);
+}
+
+}  // unnamed namespace
+
+TreeSHA512::TreeSHA512() : leaf_(), leaf_size_(0), leaf_count_(0), subtrees_() { StartLeaf(); }
+
+void TreeSHA512::Update(const byte* input, size_t length) {
+  while (length != 0) {
+    // Only close a full leaf once more input arrives, since the last leaf is treated differently.
+    if (leaf_size_ == kLeafSize) {
+      Node leaf_hash;
+      leaf_.Final(leaf_hash.data());
+      AddLeaf(leaf_hash);
+      StartLeaf();
+    }
+    const size_t size(std::min<size_t>(length, kLeafSize - leaf_size_));
+    leaf_.Update(input, size);
+    leaf_size_ += size;
+    input += size;
+    length -= size;
+  }
+}
+
+void TreeSHA512::TruncatedFinal(byte* digest, size_t digest_size) {
+  ThrowIfInvalidTruncatedSize(digest_size);
+  Node leaf_hash;
+  leaf_.Final(leaf_hash.data());
+  const Node root(Root(leaf_hash));
+  std::copy_n(root.begin(), digest_size, digest);
+  Reset();
+}
+
+void TreeSHA512::CalculateDigest(byte* digest, const byte* input, size_t length) {
+  const size_t leaf_count(std::max<size_t>(1, (length + kLeafSize - 1) / kLeafSize));
+  // Fall back to the incremental path if Update has already been called, or if there's too little
+  // input to be worth splitting.
+  if (leaf_count_ != 0 || leaf_size_ != 0 || leaf_count < 4)
+    return HashTransformation::CalculateDigest(digest, input, length);
+
+  std::vector<Node> leaf_hashes(leaf_count);
+  auto hash_leaves([&](size_t begin, size_t end) {
+    for (size_t i(begin); i != end; ++i) {
+      const size_t offset(i * kLeafSize);
+      HashLeaf(input + offset, std::min<size_t>(kLeafSize, length - offset),
+               leaf_hashes[i].data());
+    }
+  });
+  const size_t thread_count(std::min<size_t>(Concurrency(), leaf_count / 2));
+  const size_t chunk_size((leaf_count + thread_count - 1) / thread_count);
+  std::vector<std::future<void>> chunks;
+  for (size_t begin(chunk_size); begin < leaf_count; begin += chunk_size) {
+    chunks.push_back(std::async(std::launch::async, hash_leaves, begin,
+                                std::min(leaf_count, begin + chunk_size)));
+  }
+  hash_leaves(0, std::min(leaf_count, chunk_size));
+  for (auto& chunk : chunks)
+    chunk.get();
+
+  for (size_t i(0); i != leaf_count - 1; ++i)
+    AddLeaf(leaf_hashes[i]);
+  const Node root(Root(leaf_hashes.back()));
+  std::copy(root.begin(), root.end(), digest);
+  Reset();
+}
+
+void TreeSHA512::StartLeaf() {
+  leaf_.Update(&kLeafPrefix, 1);
+  leaf_size_ = 0;
+}
+
+void TreeSHA512::AddLeaf(Node leaf_hash) {
+  // After adding leaf number 'count', the subtrees ending at it which are complete (i.e. have a
+  // power-of-two number of leaves) are those indicated by the trailing zero bits of 'count'.
+  std::uint64_t count(++leaf_count_);
+  while ((count & 1) == 0) {
+    CryptoPP::SHA512 parent;
+    parent.Update(&kParentPrefix, 1);
+    parent.Update(subtrees_.back().data(), DIGESTSIZE);
+    parent.Update(leaf_hash.data(), DIGESTSIZE);
+    parent.Final(leaf_hash.data());
+    subtrees_.pop_back();
+    count >>= 1;
+  }
+  subtrees_.push_back(leaf_hash);
+}
+
+TreeSHA512::Node TreeSHA512::Root(Node last_leaf_hash) {
+  Node node(last_leaf_hash);
+  while (!subtrees_.empty()) {
+    CryptoPP::SHA512 parent;
+    parent.Update(&kParentPrefix, 1);
+    parent.Update(subtrees_.back().data(), DIGESTSIZE);
+    parent.Update(node.data(), DIGESTSIZE);
+    parent.Final(node.data());
+    subtrees_.pop_back();
+  }
+  return node;
+}
+
+void TreeSHA512::Reset() {
+  leaf_.Restart();
+  leaf_count_ = 0;
+  subtrees_.clear();
+  StartLeaf();
+}
+
+}  // namespace crypto
+
+}  // namespace maidsafe
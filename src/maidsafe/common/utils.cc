@@ -21,9 +21,13 @@
 #include <ctype.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <ctime>
 #include <cwchar>
 #include <fstream>
+#include <future>
 #include <limits>
 #include <locale>  // NOLINT
 #include <set>
@@ -38,13 +42,30 @@
 #include "sys/param.h"
 #endif
 
+#ifndef MAIDSAFE_WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#endif
+
 #ifdef _MSC_VER
 #include "windows.h"  // NOLINT - Viv
+#define MAIDSAFE_UTILS_THREAD_LOCAL __declspec(thread)
+#else
+#define MAIDSAFE_UTILS_THREAD_LOCAL __thread
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
 #endif
 
 #include "boost/config.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/format.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 #include "boost/token_functions.hpp"
 #include "boost/variant/apply_visitor.hpp"
 
@@ -52,8 +73,10 @@
 #include "cryptopp/base64.h"
 #include "cryptopp/hex.h"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/config.h"
 #include "maidsafe/common/log.h"
+#include "maidsafe/common/on_scope_exit.h"
 
 namespace fs = boost::filesystem;
 namespace bptime = boost::posix_time;
@@ -63,6 +86,15 @@ namespace maidsafe {
 
 namespace {
 
+// The number of milliseconds from 1970-01-01 (assumed to be the system_clock's epoch) to
+// kMaidSafeEpoch.
+const std::chrono::milliseconds kMaidSafeEpochOffset(946684800000LL);
+
+uint64_t MillisecondsSinceMaidSafeEpoch(std::chrono::system_clock::time_point time) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   time.time_since_epoch() - kMaidSafeEpochOffset).count());
+}
+
 struct BinaryUnit;
 struct DecimalUnit;
 
@@ -143,13 +175,25 @@ uint32_t& rng_seed() {
   return seed;
 }
 
-template <typename IntType>
-IntType RandomInt() {
-  static std::uniform_int_distribution<IntType> distribution(std::numeric_limits<IntType>::min(),
-                                                             std::numeric_limits<IntType>::max());
-  std::lock_guard<std::mutex> lock(detail::random_number_generator_mutex());
-  return distribution(detail::random_number_generator());
-}
+// Incremented on every reseed of the shared generator, so that each thread's generator knows to
+// reseed itself from it.  Starts at 1 so that the zero-initialised per-thread state is stale.
+std::atomic<uint32_t> g_seed_generation(1);
+MAIDSAFE_UTILS_THREAD_LOCAL small_prng::RandomContext g_thread_random_context;
+MAIDSAFE_UTILS_THREAD_LOCAL uint32_t g_thread_seed_generation(0);
+
+// Bulk fills run this many small_prng generators side by side.  Their state is held as one array
+// per member so that a step of all lanes is the same arithmetic on adjacent values, which the
+// compiler can keep in a single vector register.
+const int kRandomLaneCount(4);
+
+struct RandomLanes {
+  uint32_t a[kRandomLaneCount], b[kRandomLaneCount], c[kRandomLaneCount], d[kRandomLaneCount];
+};
+
+MAIDSAFE_UTILS_THREAD_LOCAL RandomLanes g_thread_random_lanes;
+MAIDSAFE_UTILS_THREAD_LOCAL uint32_t g_thread_lanes_seed_generation(0);
+
+const char kAlphaNumerics[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
 
 }  // unnamed namespace
 
@@ -165,6 +209,20 @@ std::mutex& random_number_generator_mutex() {
   return random_number_generator_mutex;
 }
 
+small_prng::RandomContext& thread_random_context() {
+  const uint32_t generation(g_seed_generation.load(std::memory_order_acquire));
+  if (g_thread_seed_generation != generation) {
+    uint32_t seed(0);
+    {
+      std::lock_guard<std::mutex> lock(random_number_generator_mutex());
+      seed = static_cast<uint32_t>(random_number_generator()());
+    }
+    small_prng::Initialise(&g_thread_random_context, seed);
+    g_thread_seed_generation = generation;
+  }
+  return g_thread_random_context;
+}
+
 #ifdef TESTING
 
 uint32_t random_number_generator_seed() { return rng_seed(); }
@@ -173,19 +231,27 @@ void set_random_number_generator_seed(uint32_t seed) {
   std::lock_guard<std::mutex> lock(random_number_generator_mutex());
   rng_seed() = seed;
   random_number_generator().seed(seed);
+  g_seed_generation.fetch_add(1, std::memory_order_release);
 }
 
 #endif
 
 fs::path GetFileName(const Data::NameAndTypeId& name_and_type_id) {
-  return (hex::Encode(name_and_type_id.name) + '_' + std::to_string(name_and_type_id.type_id.data));
+  std::string file_name(hex::kEncodedIdentitySize, 0);
+  if (!hex::EncodeTo(name_and_type_id.name, &file_name[0]))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
+  file_name += '_';
+  file_name += std::to_string(name_and_type_id.type_id.data);
+  return file_name;
 }
 
 Data::NameAndTypeId GetDataNameAndTypeId(const boost::filesystem::path& file_name) {
   std::string file_name_str(file_name.string());
   size_t index(file_name_str.rfind('_'));
   auto type_id(static_cast<DataTypeId>(std::stoul(file_name_str.substr(index + 1))));
-  Identity name(hex::DecodeToBytes(file_name_str.substr(0, index)));
+  Identity name;
+  if (index == std::string::npos || !hex::DecodeTo(file_name_str.data(), index, name))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_identity));
   return Data::NameAndTypeId(std::move(name), type_id);
 }
 
@@ -250,9 +316,99 @@ std::string BytesToDecimalSiUnits(uint64_t num) { return BytesToSiUnits<DecimalU
 
 std::string BytesToBinarySiUnits(uint64_t num) { return BytesToSiUnits<BinaryUnit>(num); }
 
-int32_t RandomInt32() { return RandomInt<int32_t>(); }
+namespace {
+
+// Returns the calling thread's bulk generator lanes, seeding them from thread_random_context()
+// whenever that has been (re)seeded since they last were.
+RandomLanes& ThreadRandomLanes() {
+  small_prng::RandomContext& context(detail::thread_random_context());
+  if (g_thread_lanes_seed_generation != g_thread_seed_generation) {
+    for (int i(0); i != kRandomLaneCount; ++i) {
+      small_prng::RandomContext lane;
+      small_prng::Initialise(&lane, small_prng::RandomValue(&context));
+      g_thread_random_lanes.a[i] = lane.a;
+      g_thread_random_lanes.b[i] = lane.b;
+      g_thread_random_lanes.c[i] = lane.c;
+      g_thread_random_lanes.d[i] = lane.d;
+    }
+    g_thread_lanes_seed_generation = g_thread_seed_generation;
+  }
+  return g_thread_random_lanes;
+}
+
+inline uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+// Advances every lane by one small_prng::RandomValue step, writing each lane's output to 'values'.
+inline void NextRandomValues(RandomLanes& lanes, uint32_t (&values)[kRandomLaneCount]) {
+  for (int i(0); i != kRandomLaneCount; ++i) {
+    const uint32_t e(lanes.a[i] - RotateLeft(lanes.b[i], 27));
+    lanes.a[i] = lanes.b[i] ^ RotateLeft(lanes.c[i], 17);
+    lanes.b[i] = lanes.c[i] + lanes.d[i];
+    lanes.c[i] = lanes.d[i] + e;
+    lanes.d[i] = e + lanes.a[i];
+    values[i] = lanes.d[i];
+  }
+}
+
+// Maps a random value onto kAlphaNumerics using the high 32 bits of 'value * 62', which needs no
+// rejection loop.  The resulting bias between characters is below one part in 2^26.
+inline byte AlphaNumericFromRandom(uint32_t value) {
+  return static_cast<byte>(
+      kAlphaNumerics[(static_cast<uint64_t>(value) * (sizeof(kAlphaNumerics) - 1)) >> 32]);
+}
+
+}  // unnamed namespace
+
+int32_t RandomInt32() {
+  const uint32_t value(RandomUint32());
+  int32_t result;
+  std::memcpy(&result, &value, sizeof(result));
+  return result;
+}
 
-uint32_t RandomUint32() { return RandomInt<uint32_t>(); }
+uint32_t RandomUint32() { return small_prng::RandomValue(&detail::thread_random_context()); }
+
+void FillRandomBytes(byte* output, size_t size) {
+  const size_t kBlockSize(sizeof(uint32_t) * kRandomLaneCount);
+  if (size >= kBlockSize) {
+    // Work on a local copy of the lanes, since 'output' could otherwise alias them.
+    RandomLanes lanes(ThreadRandomLanes());
+    uint32_t values[kRandomLaneCount];
+    for (; size >= kBlockSize; size -= kBlockSize, output += kBlockSize) {
+      NextRandomValues(lanes, values);
+      std::memcpy(output, values, kBlockSize);
+    }
+    g_thread_random_lanes = lanes;
+  }
+  small_prng::RandomContext& context(detail::thread_random_context());
+  for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t), output += sizeof(uint32_t)) {
+    const uint32_t value(small_prng::RandomValue(&context));
+    std::memcpy(output, &value, sizeof(value));
+  }
+  if (size != 0) {
+    const uint32_t value(small_prng::RandomValue(&context));
+    std::memcpy(output, &value, size);
+  }
+}
+
+void FillRandomAlphaNumericBytes(byte* output, size_t size) {
+  if (size >= static_cast<size_t>(kRandomLaneCount)) {
+    RandomLanes lanes(ThreadRandomLanes());
+    uint32_t values[kRandomLaneCount];
+    for (; size >= static_cast<size_t>(kRandomLaneCount);
+         size -= kRandomLaneCount, output += kRandomLaneCount) {
+      NextRandomValues(lanes, values);
+      for (int i(0); i != kRandomLaneCount; ++i)
+        output[i] = AlphaNumericFromRandom(values[i]);
+    }
+    g_thread_random_lanes = lanes;
+  }
+  small_prng::RandomContext& context(detail::thread_random_context());
+  for (byte* const end(output + size); output != end; ++output)
+    *output = AlphaNumericFromRandom(small_prng::RandomValue(&context));
+}
 
 std::string RandomString(size_t size) { return GetRandomString<std::string>(size); }
 
@@ -293,7 +449,11 @@ std::wstring StringToWstring(const std::string& input) {
 #endif
 
 uint64_t GetTimeStamp() {
-  return (bptime::microsec_clock::universal_time() - kMaidSafeEpoch).total_milliseconds();
+  return MillisecondsSinceMaidSafeEpoch(std::chrono::system_clock::now());
+}
+
+uint64_t GetCoarseTimeStamp() {
+  return MillisecondsSinceMaidSafeEpoch(CoarseSystemClock::now());
 }
 
 boost::posix_time::ptime TimeStampToPtime(uint64_t timestamp) {
@@ -315,8 +475,11 @@ boost::expected<std::vector<byte>, common_error> ReadFile(const fs::path& file_p
 
     std::ifstream file_in(file_path.c_str(), std::ios::in | std::ios::binary);
     file_in.read(reinterpret_cast<char*>(&file_content[0]), file_size);
-    file_in.close();
-    return file_content;
+    if (file_in.gcount() == static_cast<std::streamsize>(file_size))
+      return file_content;
+    LOG(kError) << "Failed to read file " << file_path << ": read " << file_in.gcount() << " of "
+                << file_size << " bytes";
+    return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
   }
   catch (const std::exception& e) {
     LOG(kError) << "Failed to read file " << file_path << ": " << e.what();
@@ -324,6 +487,173 @@ boost::expected<std::vector<byte>, common_error> ReadFile(const fs::path& file_p
   return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
 }
 
+struct MappedFile::Mapping {
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedFile::MappedFile() : mapping_(), data_(nullptr), size_(0) {}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : mapping_(std::move(other.mapping_)), data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  mapping_ = std::move(other.mapping_);
+  data_ = other.data_;
+  size_ = other.size_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+  return *this;
+}
+
+MappedFile::~MappedFile() {}
+
+boost::expected<MappedFile, common_error> MapFile(const fs::path& file_path) {
+  namespace bi = boost::interprocess;
+  try {
+    const uintmax_t file_size(fs::file_size(file_path));
+    if (file_size > std::numeric_limits<size_t>::max()) {
+      LOG(kError) << "Failed to map file " << file_path << ": File size " << file_size
+                  << " too large (over " << std::numeric_limits<size_t>::max() << ")";
+      return boost::make_unexpected(MakeError(CommonErrors::file_too_large));
+    }
+    MappedFile mapped_file;
+    // A zero-length mapping isn't allowed.
+    if (file_size == 0)
+      return boost::expected<MappedFile, common_error>(std::move(mapped_file));
+
+    mapped_file.mapping_.reset(new MappedFile::Mapping);
+    mapped_file.mapping_->file = bi::file_mapping(file_path.string().c_str(), bi::read_only);
+    mapped_file.mapping_->region = bi::mapped_region(mapped_file.mapping_->file, bi::read_only, 0,
+                                                     static_cast<size_t>(file_size));
+    mapped_file.mapping_->region.advise(bi::mapped_region::advice_sequential);
+    mapped_file.data_ = static_cast<const byte*>(mapped_file.mapping_->region.get_address());
+    mapped_file.size_ = mapped_file.mapping_->region.get_size();
+    return boost::expected<MappedFile, common_error>(std::move(mapped_file));
+  } catch (const std::exception& e) {
+    LOG(kError) << "Failed to map file " << file_path << ": " << e.what();
+  }
+  return boost::make_unexpected(MakeError(CommonErrors::filesystem_io_error));
+}
+
+#ifndef MAIDSAFE_WIN32
+namespace {
+
+#ifdef O_DIRECT
+const int kDirectIoFlag(O_DIRECT);
+#else
+const int kDirectIoFlag(0);
+#endif
+const size_t kDirectIoAlignment(4096);
+const size_t kDirectIoChunkSize(1024 * 1024);
+
+bool WriteAll(int file_descriptor, const byte* data, size_t size) {
+  while (size != 0) {
+    const ssize_t written(write(file_descriptor, data, size));
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+// O_DIRECT needs the buffer, offset and length of each write aligned, so the content is copied
+// through an aligned buffer in whole blocks and the file is then truncated to its real size.
+bool WriteAllDirect(int file_descriptor, const std::vector<byte>& content) {
+  void* buffer(nullptr);
+  if (posix_memalign(&buffer, kDirectIoAlignment, kDirectIoChunkSize) != 0)
+    return false;
+  on_scope_exit free_buffer([buffer] { std::free(buffer); });
+  for (size_t offset(0); offset < content.size(); offset += kDirectIoChunkSize) {
+    const size_t chunk_size(std::min(kDirectIoChunkSize, content.size() - offset));
+    const size_t padded_size((chunk_size + kDirectIoAlignment - 1) & ~(kDirectIoAlignment - 1));
+    std::memcpy(buffer, content.data() + offset, chunk_size);
+    std::memset(static_cast<byte*>(buffer) + chunk_size, 0, padded_size - chunk_size);
+    if (!WriteAll(file_descriptor, static_cast<const byte*>(buffer), padded_size))
+      return false;
+  }
+  return ftruncate(file_descriptor, static_cast<off_t>(content.size())) == 0;
+}
+
+int OpenForWriting(const fs::path& file_path, bool direct_io) {
+  const int flags(O_WRONLY | O_CREAT | O_TRUNC);
+  if (direct_io && kDirectIoFlag != 0) {
+    const int file_descriptor(open(file_path.c_str(), flags | kDirectIoFlag, 0666));
+    if (file_descriptor >= 0 || errno != EINVAL)
+      return file_descriptor;
+    LOG(kVerbose) << "O_DIRECT not supported for " << file_path << "; using buffered writes.";
+  }
+  return open(file_path.c_str(), flags, 0666);
+}
+
+bool SyncFile(int file_descriptor) {
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+  return fdatasync(file_descriptor) == 0;
+#elif defined(MAIDSAFE_APPLE)
+  // fsync doesn't flush the drive's own cache on OS X.
+  return fcntl(file_descriptor, F_FULLFSYNC) != -1 || fsync(file_descriptor) == 0;
+#else
+  return fsync(file_descriptor) == 0;
+#endif
+}
+
+// Makes a completed rename durable.
+void SyncDirectory(const fs::path& directory) {
+  const int file_descriptor(open(directory.empty() ? "." : directory.c_str(), O_RDONLY));
+  if (file_descriptor < 0)
+    return;
+  fsync(file_descriptor);
+  close(file_descriptor);
+}
+
+bool WriteFileContents(const fs::path& file_path, const std::vector<byte>& content,
+                       const WriteFileOptions& options) {
+  const int file_descriptor(OpenForWriting(file_path, options.direct_io));
+  if (file_descriptor < 0) {
+    LOG(kError) << "Failed to open " << file_path << ": " << std::strerror(errno);
+    return false;
+  }
+  on_scope_exit close_file([file_descriptor] { close(file_descriptor); });
+
+  if (options.preallocate && !content.empty()) {
+#if defined(MAIDSAFE_LINUX) && !defined(MAIDSAFE_BSD)
+    const int result(posix_fallocate(file_descriptor, 0, static_cast<off_t>(content.size())));
+    // Not all filesystems support preallocation, but a full disk is worth reporting.
+    if (result == ENOSPC) {
+      LOG(kError) << "Not enough space to write " << content.size() << " bytes to " << file_path;
+      return false;
+    }
+#endif
+  }
+
+  const bool direct(kDirectIoFlag != 0 && (fcntl(file_descriptor, F_GETFL) & kDirectIoFlag) != 0);
+  if (!(direct ? WriteAllDirect(file_descriptor, content)
+               : WriteAll(file_descriptor, content.data(), content.size()))) {
+    LOG(kError) << "Failed to write " << file_path << ": " << std::strerror(errno);
+    return false;
+  }
+  if (options.durability == WriteFileOptions::Durability::kData && !SyncFile(file_descriptor)) {
+    LOG(kError) << "Failed to sync " << file_path << ": " << std::strerror(errno);
+    return false;
+  }
+  close_file.Release();
+  if (close(file_descriptor) != 0) {
+    LOG(kError) << "Failed to close " << file_path << ": " << std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+}  // unnamed namespace
+#endif
+
 bool WriteFile(const boost::filesystem::path& file_path, const std::vector<byte>& content) {
   try {
     if (!file_path.has_filename()) {
@@ -345,6 +675,50 @@ bool WriteFile(const boost::filesystem::path& file_path, const std::vector<byte>
   return true;
 }
 
+bool WriteFile(const boost::filesystem::path& file_path, const std::vector<byte>& content,
+               const WriteFileOptions& options) {
+  if (!file_path.has_filename()) {
+    LOG(kError) << "Failed to write: file_path " << file_path << " has no filename";
+    return false;
+  }
+  const fs::path target_path(
+      options.atomic_replace
+          ? file_path.parent_path() /
+                (file_path.filename().string() + '.' + RandomAlphaNumericString(8) + ".tmp")
+          : file_path);
+  // Only the temporary file is removed on failure; a failed normal write leaves whatever it wrote.
+  on_scope_exit remove_temporary([&] {
+    boost::system::error_code ignored_ec;
+    if (options.atomic_replace)
+      fs::remove(target_path, ignored_ec);
+  });
+
+#ifdef MAIDSAFE_WIN32
+  // The low-level options aren't implemented for Windows; the contents are written normally.
+  if (!WriteFile(target_path, content))
+    return false;
+#else
+  if (!WriteFileContents(target_path, content, options))
+    return false;
+#endif
+
+  if (options.atomic_replace) {
+    boost::system::error_code ec;
+    fs::rename(target_path, file_path, ec);
+    if (ec) {
+      LOG(kError) << "Failed to rename " << target_path << " to " << file_path << ": "
+                  << ec.message();
+      return false;
+    }
+#ifndef MAIDSAFE_WIN32
+    if (options.durability == WriteFileOptions::Durability::kData)
+      SyncDirectory(file_path.parent_path());
+#endif
+  }
+  remove_temporary.Release();
+  return true;
+}
+
 fs::path GetPathFromProgramOptions(const std::string& option_name,
                                    const po::variables_map& variables_map, bool is_dir,
                                    bool create_new_if_absent) {
@@ -400,6 +774,49 @@ fs::path GetPathFromProgramOptions(const std::string& option_name,
 
 unsigned int Concurrency() { return std::max(std::thread::hardware_concurrency(), 2U); }
 
+void XorInto(byte* destination, const byte* source, std::size_t size, bool parallel) {
+  // XOR is limited by memory bandwidth rather than by the CPU, so only large inputs gain from
+  // extra threads.
+  const std::size_t kMinSizePerThread(1 << 21);
+  const std::size_t thread_count(
+      parallel ? std::max<std::size_t>(1, std::min<std::size_t>(Concurrency(),
+                                                                size / kMinSizePerThread))
+               : 1);
+  if (thread_count > 1) {
+    // Chunks are whole multiples of 64 bytes so that threads don't share cache lines.
+    const std::size_t chunk_size(((size + thread_count - 1) / thread_count + 63) &
+                                 ~std::size_t(63));
+    std::vector<std::future<void>> chunks;
+    for (std::size_t begin(chunk_size); begin < size; begin += chunk_size) {
+      chunks.push_back(std::async(std::launch::async, [=] {
+        XorInto(destination + begin, source + begin, std::min(chunk_size, size - begin));
+      }));
+    }
+    XorInto(destination, source, std::min(chunk_size, size));
+    for (auto& chunk : chunks)
+      chunk.get();
+    return;
+  }
+
+  std::size_t i(0);
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  for (; i + 16 <= size; i += 16) {
+    const __m128i lhs(_mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i)));
+    const __m128i rhs(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_xor_si128(lhs, rhs));
+  }
+#endif
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t lhs, rhs;
+    std::memcpy(&lhs, destination + i, 8);
+    std::memcpy(&rhs, source + i, 8);
+    lhs ^= rhs;
+    std::memcpy(destination + i, &lhs, 8);
+  }
+  for (; i < size; ++i)
+    destination[i] ^= source[i];
+}
+
 
 
 }  // namespace maidsafe
@@ -21,6 +21,7 @@
 #include "cereal/cereal.hpp"
 #include "cereal/archives/json.hpp"
 
+#include "maidsafe/common/clock.h"
 #include "maidsafe/common/encode.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
@@ -60,20 +61,25 @@ std::string UrlEncode(const std::string& value) {
   return encoded;
 }
 
-std::string EncodeIdentityOrInt(const std::string& value, bool debug_format) {
-  // If the value is 64 chars, assume it's an Identity.
-  if (value.size() == crypto::SHA512::DIGESTSIZE)
-    return debug_format ? hex::Substr(value) : hex::Encode(value);
-  return value;
-}
-
 }  // unnamed namespace
 
 VisualiserLogMessage::~VisualiserLogMessage() {
-  if (kSessionId_.empty())
+  if (!record_.session_id || record_.session_id->empty())
     return;
-  SendToServer();
-  WriteToFile();
+  try {
+    std::shared_ptr<const Record> record(std::make_shared<Record>(std::move(record_)));
+    auto functor([record] {
+      try {
+        Logging::Instance().WriteToVisualiserServer(record->GetPostRequestBody());
+        Logging::Instance().WriteToVisualiserLogfile(record->GetLogfileEntry());
+      } catch (const std::exception& e) {
+        LOG(kError) << "Error writing VLOG: " << boost::diagnostic_information(e);
+      }
+    });
+    Logging::Instance().Async() ? Logging::Instance().Send(functor) : functor();
+  } catch (const std::exception& e) {
+    LOG(kError) << "Error writing VLOG: " << boost::diagnostic_information(e);
+  }
 }
 
 void VisualiserLogMessage::SendVaultStoppedMessage(const std::string& vault_debug_id,
@@ -82,52 +88,63 @@ void VisualiserLogMessage::SendVaultStoppedMessage(const std::string& vault_debu
     std::string message{"ts=" + UrlEncode(detail::GetUTCTime()) + "&vaultId=" + vault_debug_id +
                         "&sessionId=" + session_id + "&actionId=18&valueOne=" +
                         std::to_string(exit_code)};
-    auto post_functor([message] { Logging::Instance().WriteToVisualiserServer(message); });
-    Logging::Instance().Send(post_functor);
+    Logging::Instance().WriteToVisualiserServer(message);
   } catch (const std::exception& e) {
     LOG(kError) << "Error writing VLOG to file: " << boost::diagnostic_information(e);
   }
 }
 
-std::string VisualiserLogMessage::GetPostRequestBody() const {
+std::string VisualiserLogMessage::Value::ToString(bool debug_format) const {
+  switch (type) {
+    case Type::kIdentity:
+      return debug_format ? hex::Substr(identity.string()) : hex::Encode(identity.string());
+    case Type::kSigned:
+      return std::to_string(static_cast<int64_t>(integer));
+    case Type::kUnsigned:
+      return std::to_string(integer);
+    case Type::kString:
+      return text;
+    default:
+      return std::string();
+  }
+}
+
+VisualiserLogMessage::Record::Record(Enum persona_id_in, Enum action_id_in, Value value1_in,
+                                     Value value2_in)
+    : timestamp(CoarseSystemClock::now()),
+      vault_id(Logging::Instance().SharedVlogPrefix()),
+      session_id(Logging::Instance().SharedVlogSessionId()),
+      persona_id(persona_id_in),
+      action_id(action_id_in),
+      value1(std::move(value1_in)),
+      value2(std::move(value2_in)) {}
+
+std::string VisualiserLogMessage::Record::GetPostRequestBody() const {
   std::stringstream stringstream;
   {
     cereal::JSONOutputArchive archive{stringstream};
-    archive(cereal::make_nvp("ts", kTimestamp_), cereal::make_nvp("vaultId", kVaultId_),
-            cereal::make_nvp("sessionId", kSessionId_),
-            cereal::make_nvp("valueOne", EncodeIdentityOrInt(kValue1_, false)),
-            cereal::make_nvp("actionId", kActionId_.value));
-
-    if (!kValue2_.empty())
-      archive(cereal::make_nvp("valueTwo", EncodeIdentityOrInt(kValue2_, false)));
-    if (!kPersonaId_.name.empty())
-      archive(cereal::make_nvp("personaId", kPersonaId_.value));
+    archive(cereal::make_nvp("ts", detail::GetUTCTime(timestamp)),
+            cereal::make_nvp("vaultId", *vault_id), cereal::make_nvp("sessionId", *session_id),
+            cereal::make_nvp("valueOne", value1.ToString(false)),
+            cereal::make_nvp("actionId", action_id.Value()));
+
+    if (!value2.Empty())
+      archive(cereal::make_nvp("valueTwo", value2.ToString(false)));
+    if (persona_id.IsInitialised())
+      archive(cereal::make_nvp("personaId", persona_id.Value()));
   }
   return stringstream.str();
 }
 
-void VisualiserLogMessage::SendToServer() const {
-  try {
-    std::string message{GetPostRequestBody()};
-    auto post_functor([message] { Logging::Instance().WriteToVisualiserServer(message); });
-    Logging::Instance().Send(post_functor);
-  } catch (const std::exception& e) {
-    LOG(kError) << "Error writing VLOG to file: " << boost::diagnostic_information(e);
-  }
-}
-
-void VisualiserLogMessage::WriteToFile() const {
-  try {
-    std::string log_entry{kTimestamp_ + ',' + kVaultId_ + ',' + kSessionId_ + ',' +
-                          (kPersonaId_.name.empty() ? "" : kPersonaId_.name + ',') +
-                          kActionId_.name + ',' + EncodeIdentityOrInt(kValue1_, true) +
-                          (kValue2_.empty() ? "" : "," + EncodeIdentityOrInt(kValue2_, true)) +
-                          '\n'};
-    auto print_functor([log_entry] { Logging::Instance().WriteToVisualiserLogfile(log_entry); });
-    Logging::Instance().Async() ? Logging::Instance().Send(print_functor) : print_functor();
-  } catch (const std::exception& e) {
-    LOG(kError) << "Error writing VLOG to file: " << boost::diagnostic_information(e);
-  }
+std::string VisualiserLogMessage::Record::GetLogfileEntry() const {
+  std::string log_entry{detail::GetUTCTime(timestamp) + ',' + *vault_id + ',' + *session_id + ','};
+  if (persona_id.IsInitialised())
+    log_entry += persona_id.Name() + ',';
+  log_entry += action_id.Name() + ',' + value1.ToString(true);
+  if (!value2.Empty())
+    log_entry += ',' + value2.ToString(true);
+  log_entry += '\n';
+  return log_entry;
 }
 
 }  // namespace log
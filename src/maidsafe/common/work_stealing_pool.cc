@@ -0,0 +1,140 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/work_stealing_pool.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "boost/thread/tss.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/make_unique.h"
+
+namespace maidsafe {
+
+namespace {
+
+struct CurrentWorker {
+  CurrentWorker(const WorkStealingPool* pool_in, size_t index_in)
+      : pool(pool_in), index(index_in) {}
+  const WorkStealingPool* pool;
+  size_t index;
+};
+
+// Set by each worker thread, so that functors it sends are queued on its own queue.
+boost::thread_specific_ptr<CurrentWorker> g_current_worker;
+
+}  // unnamed namespace
+
+WorkStealingPool::WorkStealingPool()
+    : WorkStealingPool(std::max(1U, std::thread::hardware_concurrency())) {}
+
+WorkStealingPool::WorkStealingPool(size_t thread_count)
+    : workers_(),
+      next_worker_(0),
+      pending_(0),
+      sleeping_(0),
+      steal_count_(0),
+      running_(true),
+      mutex_(),
+      condition_(),
+      threads_() {
+  if (thread_count == 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_argument));
+  for (size_t i(0); i != thread_count; ++i)
+    workers_.emplace_back(maidsafe::make_unique<Worker>());
+  for (size_t i(0); i != thread_count; ++i)
+    threads_.emplace_back([this, i] { Run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+void WorkStealingPool::Send(Functor functor) {
+  if (!running_)
+    return;
+  size_t index(0);
+  if (g_current_worker.get() && g_current_worker->pool == this)
+    index = g_current_worker->index;
+  else
+    index = next_worker_++ % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    // Incremented before the functor becomes visible so that 'pending_' never under-counts.
+    ++pending_;
+    workers_[index]->functors.push_back(std::move(functor));
+  }
+  // Only take the shared mutex if a worker might be waiting on it.  Since a worker increments
+  // 'sleeping_' before checking 'pending_', at least one side is guaranteed to see the other.
+  if (sleeping_ != 0) {
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    condition_.notify_one();
+  }
+}
+
+void WorkStealingPool::Run(size_t index) {
+  g_current_worker.reset(new CurrentWorker(this, index));
+  for (;;) {
+    Functor functor;
+    if (TryPop(index, functor)) {
+      functor();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++sleeping_;
+    condition_.wait(lock, [this] { return pending_ != 0 || !running_; });
+    --sleeping_;
+    if (!running_ && pending_ == 0)
+      return;
+  }
+}
+
+bool WorkStealingPool::TryPop(size_t index, Functor& functor) {
+  {
+    Worker& own(*workers_[index]);
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.functors.empty()) {
+      functor = std::move(own.functors.back());
+      own.functors.pop_back();
+      --pending_;
+      return true;
+    }
+  }
+  for (size_t i(1); i != workers_.size(); ++i) {
+    Worker& victim(*workers_[(index + i) % workers_.size()]);
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.functors.empty()) {
+      functor = std::move(victim.functors.front());
+      victim.functors.pop_front();
+      --pending_;
+      ++steal_count_;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace maidsafe
@@ -0,0 +1,283 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/common/xor_distance.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#define MAIDSAFE_XOR_DISTANCE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define MAIDSAFE_XOR_DISTANCE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MAIDSAFE_XOR_DISTANCE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(MAIDSAFE_XOR_DISTANCE_AVX2) && !defined(_MSC_VER)
+#define MAIDSAFE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MAIDSAFE_TARGET_AVX2
+#endif
+
+#include "maidsafe/common/cpu_features.h"
+#include "maidsafe/common/identity.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+namespace {
+
+static_assert(identity_size % 32 == 0, "The kernels require IDs to be a multiple of 32 bytes");
+
+// 'word' must be non-zero.
+int CountLeadingZeros(uint64_t word) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;  // NOLINT
+  _BitScanReverse64(&index, word);
+  return 63 - static_cast<int>(index);
+#elif defined(_MSC_VER)
+  unsigned long index;  // NOLINT
+  if (_BitScanReverse(&index, static_cast<unsigned long>(word >> 32)))  // NOLINT
+    return 31 - static_cast<int>(index);
+  _BitScanReverse(&index, static_cast<unsigned long>(word));  // NOLINT
+  return 63 - static_cast<int>(index);
+#else
+  return __builtin_clzll(word);
+#endif
+}
+
+// Number of leading bits common to the bytes at 'index' in each ID.
+int CommonLeadingBitsAt(const byte* id1, const byte* id2, std::size_t index) {
+  const unsigned difference(id1[index] ^ id2[index]);
+  return static_cast<int>(8 * index) + (difference ? CountLeadingZeros(difference) - 56 : 8);
+}
+
+// Loads eight bytes as a big-endian integer, so that comparing two such integers is equivalent to
+// comparing the bytes lexicographically.
+uint64_t LoadBigEndian(const byte* input) {
+  uint64_t word;
+  std::memcpy(&word, input, sizeof(word));
+#if defined(_MSC_VER)
+  return _byteswap_uint64(word);
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return word;
+#else
+  return __builtin_bswap64(word);
+#endif
+}
+
+
+
+bool CloserToTargetBytewise(const byte* id1, const byte* id2, const byte* target_id) {
+  for (std::size_t i(0); i != identity_size; ++i) {
+    const byte result1(id1[i] ^ target_id[i]), result2(id2[i] ^ target_id[i]);
+    if (result1 != result2)
+      return result1 < result2;
+  }
+  return false;
+}
+
+int CommonLeadingBitsBytewise(const byte* id1, const byte* id2) {
+  for (std::size_t i(0); i != identity_size; ++i) {
+    if (id1[i] != id2[i])
+      return CommonLeadingBitsAt(id1, id2, i);
+  }
+  return 8 * identity_size;
+}
+
+
+
+bool CloserToTargetWordwise(const byte* id1, const byte* id2, const byte* target_id) {
+  for (std::size_t i(0); i != identity_size; i += 8) {
+    const uint64_t target(LoadBigEndian(target_id + i));
+    const uint64_t result1(LoadBigEndian(id1 + i) ^ target);
+    const uint64_t result2(LoadBigEndian(id2 + i) ^ target);
+    if (result1 != result2)
+      return result1 < result2;
+  }
+  return false;
+}
+
+int CommonLeadingBitsWordwise(const byte* id1, const byte* id2) {
+  for (std::size_t i(0); i != identity_size; i += 8) {
+    const uint64_t difference(LoadBigEndian(id1 + i) ^ LoadBigEndian(id2 + i));
+    if (difference)
+      return static_cast<int>(8 * i) + CountLeadingZeros(difference);
+  }
+  return 8 * identity_size;
+}
+
+
+
+// The vectorised kernels find the first byte at which 'id1' and 'id2' differ (which is also the
+// first byte at which their XOR distances to any target differ) and then compare just that byte.
+
+#if defined(MAIDSAFE_XOR_DISTANCE_SSE2) || defined(MAIDSAFE_XOR_DISTANCE_NEON)
+// 'word' must be non-zero.
+int CountTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;  // NOLINT
+  _BitScanForward64(&index, word);
+  return static_cast<int>(index);
+#elif defined(_MSC_VER)
+  unsigned long index;  // NOLINT
+  if (_BitScanForward(&index, static_cast<unsigned long>(word)))  // NOLINT
+    return static_cast<int>(index);
+  _BitScanForward(&index, static_cast<unsigned long>(word >> 32));  // NOLINT
+  return 32 + static_cast<int>(index);
+#else
+  return __builtin_ctzll(word);
+#endif
+}
+
+// Compares the XOR distances to 'target_id' of the bytes at 'index', where 'index' is the first
+// byte at which 'id1' and 'id2' differ, or 'identity_size' if they're equal.
+bool CloserToTargetAt(const byte* id1, const byte* id2, const byte* target_id, std::size_t index) {
+  if (index == identity_size)
+    return false;
+  return (id1[index] ^ target_id[index]) < (id2[index] ^ target_id[index]);
+}
+#endif
+
+#ifdef MAIDSAFE_XOR_DISTANCE_SSE2
+// Returns the index of the first differing byte, or 'identity_size' if the IDs are equal.
+std::size_t FirstDifferenceSse2(const byte* id1, const byte* id2) {
+  for (std::size_t i(0); i != identity_size; i += 16) {
+    const __m128i block1(_mm_loadu_si128(reinterpret_cast<const __m128i*>(id1 + i)));
+    const __m128i block2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(id2 + i)));
+    const unsigned equal(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block1, block2))));
+    if (equal != 0xFFFFU)
+      return i + CountTrailingZeros(~equal & 0xFFFFU);
+  }
+  return identity_size;
+}
+
+bool CloserToTargetSse2(const byte* id1, const byte* id2, const byte* target_id) {
+  const std::size_t index(FirstDifferenceSse2(id1, id2));
+  return CloserToTargetAt(id1, id2, target_id, index);
+}
+
+int CommonLeadingBitsSse2(const byte* id1, const byte* id2) {
+  const std::size_t index(FirstDifferenceSse2(id1, id2));
+  return index == identity_size ? 8 * identity_size : CommonLeadingBitsAt(id1, id2, index);
+}
+#endif
+
+#ifdef MAIDSAFE_XOR_DISTANCE_AVX2
+MAIDSAFE_TARGET_AVX2 std::size_t FirstDifferenceAvx2(const byte* id1, const byte* id2) {
+  for (std::size_t i(0); i != identity_size; i += 32) {
+    const __m256i block1(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(id1 + i)));
+    const __m256i block2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(id2 + i)));
+    const uint32_t equal(
+        static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, block2))));
+    if (equal != 0xFFFFFFFFU)
+      return i + CountTrailingZeros(~equal);
+  }
+  return identity_size;
+}
+
+MAIDSAFE_TARGET_AVX2 bool CloserToTargetAvx2(const byte* id1, const byte* id2,
+                                             const byte* target_id) {
+  const std::size_t index(FirstDifferenceAvx2(id1, id2));
+  return CloserToTargetAt(id1, id2, target_id, index);
+}
+
+MAIDSAFE_TARGET_AVX2 int CommonLeadingBitsAvx2(const byte* id1, const byte* id2) {
+  const std::size_t index(FirstDifferenceAvx2(id1, id2));
+  return index == identity_size ? 8 * identity_size : CommonLeadingBitsAt(id1, id2, index);
+}
+#endif
+}
+#endif
+
+#ifdef MAIDSAFE_XOR_DISTANCE_NEON
+std::size_t FirstDifferenceNeon(const byte* id1, const byte* id2) {
+  for (std::size_t i(0); i != identity_size; i += 16) {
+    const uint8x16_t equal(vceqq_u8(vld1q_u8(id1 + i), vld1q_u8(id2 + i)));
+    // Narrow each byte of the comparison to a nibble, giving a 64-bit mask.
+    const uint64_t mask(vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0));
+    if (mask != ~uint64_t(0))
+      return i + CountTrailingZeros(~mask) / 4;
+  }
+  return identity_size;
+}
+
+bool CloserToTargetNeon(const byte* id1, const byte* id2, const byte* target_id) {
+  const std::size_t index(FirstDifferenceNeon(id1, id2));
+  return CloserToTargetAt(id1, id2, target_id, index);
+}
+
+int CommonLeadingBitsNeon(const byte* id1, const byte* id2) {
+  const std::size_t index(FirstDifferenceNeon(id1, id2));
+  return index == identity_size ? 8 * identity_size : CommonLeadingBitsAt(id1, id2, index);
+}
+#endif
+
+}  // unnamed namespace
+
+XorDistance GetXorDistance(const byte* id, const byte* target_id) {
+  XorDistance distance;
+  for (std::size_t i(0); i != distance.size(); ++i)
+    distance[i] = LoadBigEndian(id + (8 * i)) ^ LoadBigEndian(target_id + (8 * i));
+  return distance;
+}
+
+uint64_t GetLeadingXorDistance(const byte* id, const byte* target_id) {
+  return LoadBigEndian(id) ^ LoadBigEndian(target_id);
+}
+
+std::vector<XorDistanceKernels> SupportedXorDistanceKernels() {
+  std::vector<XorDistanceKernels> kernels;
+  kernels.push_back({"bytewise", &CloserToTargetBytewise, &CommonLeadingBitsBytewise});
+  kernels.push_back({"wordwise", &CloserToTargetWordwise, &CommonLeadingBitsWordwise});
+#ifdef MAIDSAFE_XOR_DISTANCE_SSE2
+  kernels.push_back({"SSE2", &CloserToTargetSse2, &CommonLeadingBitsSse2});
+#endif
+#ifdef MAIDSAFE_XOR_DISTANCE_AVX2
+  if (CpuSupportsAvx2())
+    kernels.push_back({"AVX2", &CloserToTargetAvx2, &CommonLeadingBitsAvx2});
+#endif
+#ifdef MAIDSAFE_XOR_DISTANCE_NEON
+  kernels.push_back({"NEON", &CloserToTargetNeon, &CommonLeadingBitsNeon});
+#endif
+  return kernels;
+}
+
+const XorDistanceKernels& SelectedXorDistanceKernels() {
+  static const XorDistanceKernels selected_kernels(SupportedXorDistanceKernels().back());
+  return selected_kernels;
+}
+
+}  // namespace detail
+
+}  // namespace maidsafe
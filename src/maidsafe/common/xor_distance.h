@@ -0,0 +1,55 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_COMMON_XOR_DISTANCE_H_
+#define MAIDSAFE_COMMON_XOR_DISTANCE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "maidsafe/common/identity.h"
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace detail {
+
+// A set of implementations of CloserToTarget and CommonLeadingBits which operate on the raw bytes
+// of initialised IDs (i.e. each arg points to 'identity_size' bytes).
+struct XorDistanceKernels {
+  const char* name;
+  bool (*closer_to_target)(const byte* id1, const byte* id2, const byte* target_id);
+  int (*common_leading_bits)(const byte* id1, const byte* id2);
+};
+
+XorDistance GetXorDistance(const byte* id, const byte* target_id);
+
+// As for GetXorDistance, but returns just the leading word of the distance.
+uint64_t GetLeadingXorDistance(const byte* id, const byte* target_id);
+
+// Returns every set of kernels which is supported by the CPU, ordered from slowest to fastest.
+std::vector<XorDistanceKernels> SupportedXorDistanceKernels();
+
+// Returns the fastest supported set, chosen once on first use.
+const XorDistanceKernels& SelectedXorDistanceKernels();
+
+}  // namespace detail
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_COMMON_XOR_DISTANCE_H_